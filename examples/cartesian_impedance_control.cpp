@@ -1,12 +1,9 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
-#include <array>
-#include <cmath>
 #include <functional>
 #include <iostream>
 
-#include <Eigen/Dense>
-
+#include <franka/cartesian_impedance_controller.h>
 #include <franka/duration.h>
 #include <franka/exception.h>
 #include <franka/model.h>
@@ -33,15 +30,6 @@ int main(int argc, char** argv) {
   // Compliance parameters
   const double translational_stiffness{150.0};
   const double rotational_stiffness{10.0};
-  Eigen::MatrixXd stiffness(6, 6), damping(6, 6);
-  stiffness.setZero();
-  stiffness.topLeftCorner(3, 3) << translational_stiffness * Eigen::MatrixXd::Identity(3, 3);
-  stiffness.bottomRightCorner(3, 3) << rotational_stiffness * Eigen::MatrixXd::Identity(3, 3);
-  damping.setZero();
-  damping.topLeftCorner(3, 3) << 2.0 * sqrt(translational_stiffness) *
-                                     Eigen::MatrixXd::Identity(3, 3);
-  damping.bottomRightCorner(3, 3) << 2.0 * sqrt(rotational_stiffness) *
-                                         Eigen::MatrixXd::Identity(3, 3);
 
   try {
     // connect to robot
@@ -50,12 +38,9 @@ int main(int argc, char** argv) {
     // load the kinematics and dynamics model
     franka::Model model = robot.loadModel();
 
-    franka::RobotState initial_state = robot.readOnce();
-
-    // equilibrium point is the initial position
-    Eigen::Affine3d initial_transform(Eigen::Matrix4d::Map(initial_state.O_T_EE.data()));
-    Eigen::Vector3d position_d(initial_transform.translation());
-    Eigen::Quaterniond orientation_d(initial_transform.rotation());
+    // equilibrium point is the initial position, damping ratio is 1
+    franka::CartesianImpedanceController controller(translational_stiffness, rotational_stiffness);
+    controller.reset(robot.readOnce());
 
     // set collision behavior
     robot.setCollisionBehavior({{100.0, 100.0, 100.0, 100.0, 100.0, 100.0, 100.0}},
@@ -67,46 +52,7 @@ int main(int argc, char** argv) {
     std::function<franka::Torques(const franka::RobotState&, franka::Duration)>
         impedance_control_callback = [&](const franka::RobotState& robot_state,
                                          franka::Duration /*duration*/) -> franka::Torques {
-      // get state variables
-      std::array<double, 7> coriolis_array = model.coriolis(robot_state);
-      std::array<double, 42> jacobian_array =
-          model.zeroJacobian(franka::Frame::kEndEffector, robot_state);
-
-      // convert to Eigen
-      Eigen::Map<const Eigen::Matrix<double, 7, 1>> coriolis(coriolis_array.data());
-      Eigen::Map<const Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
-      Eigen::Map<const Eigen::Matrix<double, 7, 1>> q(robot_state.q.data());
-      Eigen::Map<const Eigen::Matrix<double, 7, 1>> dq(robot_state.dq.data());
-      Eigen::Affine3d transform(Eigen::Matrix4d::Map(robot_state.O_T_EE.data()));
-      Eigen::Vector3d position(transform.translation());
-      Eigen::Quaterniond orientation(transform.rotation());
-
-      // compute error to desired equilibrium pose
-      // position error
-      Eigen::Matrix<double, 6, 1> error;
-      error.head(3) << position - position_d;
-
-      // orientation error
-      // "difference" quaternion
-      if (orientation_d.coeffs().dot(orientation.coeffs()) < 0.0) {
-        orientation.coeffs() << -orientation.coeffs();
-      }
-      // "difference" quaternion
-      Eigen::Quaterniond error_quaternion(orientation.inverse() * orientation_d);
-      error.tail(3) << error_quaternion.x(), error_quaternion.y(), error_quaternion.z();
-      // Transform to base frame
-      error.tail(3) << -transform.rotation() * error.tail(3);
-
-      // compute control
-      Eigen::VectorXd tau_task(7), tau_d(7);
-
-      // Spring damper system with damping ratio=1
-      tau_task << jacobian.transpose() * (-stiffness * error - damping * (jacobian * dq));
-      tau_d << tau_task + coriolis;
-
-      std::array<double, 7> tau_d_array{};
-      Eigen::VectorXd::Map(&tau_d_array[0], 7) = tau_d;
-      return tau_d_array;
+      return controller.update(robot_state, model);
     };
 
     // start real-time control loop
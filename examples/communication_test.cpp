@@ -1,120 +1,358 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/utsname.h>
+#endif
+
+#include <franka/control_statistics.h>
+#include <franka/control_tools.h>
 #include <franka/duration.h>
 #include <franka/exception.h>
+#include <franka/joint_trajectory.h>
 #include <franka/robot.h>
 
 #include "examples_common.h"
 
 /**
  * @example communication_test.cpp
- * An example indicating the network performance.
+ * A closed-loop latency benchmark of the network and the control PC.
+ *
+ * Sends zero torques for 10 seconds in each of several modes: with franka::RobotState callbacks,
+ * with franka::RobotStateView callbacks, and with RobotState callbacks on a pinned CPU with locked
+ * memory. For every mode, the percentiles of the state inter-arrival jitter seen by the callback,
+ * of the library's per-stage timings and of the round trip time are reported, together with the
+ * CPU, scheduler and IRQ affinity setup. The report is printed as JSON and optionally written to a
+ * file, so that workstation and NIC combinations can be compared before deployment.
  *
  * @warning Before executing this example, make sure there is enough space in front of the robot.
  */
 
+namespace {
+
+constexpr uint64_t kTestDurationMs = 10000;
+
+// Durations with a resolution of one microsecond, recorded without allocating.
+class Histogram {
+ public:
+  void record(double microseconds) noexcept {
+    size_t bin = std::min(static_cast<size_t>(std::max(microseconds, 0.0)), kBins);
+    bins_[bin]++;
+    max_ = std::max(max_, microseconds);
+    count_++;
+  }
+
+  // Smallest bin upper bound below which at least the given fraction of all samples lie.
+  double percentile(double fraction) const noexcept {
+    uint64_t threshold = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_)));
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < kBins; i++) {
+      accumulated += bins_[i];
+      if (accumulated >= threshold) {
+        return std::min(static_cast<double>(i + 1), max_);
+      }
+    }
+    return max_;
+  }
+
+  friend std::ostream& operator<<(std::ostream& ostream, const Histogram& histogram) {
+    ostream << "{\"p50\": " << histogram.percentile(0.5)
+            << ", \"p99\": " << histogram.percentile(0.99)
+            << ", \"p999\": " << histogram.percentile(0.999) << ", \"max\": " << histogram.max_
+            << ", \"count\": " << histogram.count_ << "}";
+    return ostream;
+  }
+
+ private:
+  static constexpr size_t kBins = 10000;
+  std::array<uint64_t, kBins + 1> bins_{};
+  double max_{0.0};
+  uint64_t count_{0};
+};
+
+struct Mode {
+  std::string name;
+  bool view;
+  franka::RealtimeOptions realtime_options;
+};
+
+struct ModeResult {
+  std::string name;
+  std::string scheduler;
+  int priority{0};
+  uint64_t cpu_migrations{0};
+  double mean_success_rate{0.0};
+  Histogram jitter;
+  franka::ControlStatistics control_statistics;
+  franka::CommunicationStatistics communication_statistics;
+};
+
+std::string quoted(const std::string& value) {
+  std::ostringstream stream;
+  stream << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) >= 0x20) {
+      stream << c;
+    }
+  }
+  stream << '"';
+  return stream.str();
+}
+
+std::string firstLine(const std::string& path, const std::string& prefix = "") {
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.compare(0, prefix.size(), prefix) == 0) {
+      return line.substr(prefix.size());
+    }
+  }
+  return "";
+}
+
+// Writes the kernel, CPU and interrupt setup of this machine as JSON members.
+void writeSystemReport(std::ostream& report, const std::string& interface) {
+  std::string kernel;
+  int cpus = static_cast<int>(std::thread::hardware_concurrency());
+  std::string process_affinity;
+#ifdef __linux__
+  utsname name{};
+  if (uname(&name) == 0) {
+    kernel = std::string(name.release) + " " + name.version;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        process_affinity += (process_affinity.empty() ? "" : ",") + std::to_string(cpu);
+      }
+    }
+  }
+#endif
+  std::string cpu_model = firstLine("/proc/cpuinfo", "model name\t: ");
+  std::string governor = firstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+
+  report << "\"kernel\": " << quoted(kernel)
+         << ", \"realtime_kernel\": " << (franka::hasRealtimeKernel() ? "true" : "false")
+         << ", \"kernel_command_line\": " << quoted(firstLine("/proc/cmdline"))
+         << ", \"cpu_model\": " << quoted(cpu_model) << ", \"cpus\": " << cpus
+         << ", \"cpu_governor\": " << quoted(governor)
+         << ", \"process_affinity\": " << quoted(process_affinity)
+         << ", \"interface\": " << quoted(interface) << ", \"interface_irqs\": [";
+
+  // IRQs of the network interface, with the CPUs that are allowed to handle them.
+  std::ifstream interrupts("/proc/interrupts");
+  std::string line;
+  bool first = true;
+  while (!interface.empty() && std::getline(interrupts, line)) {
+    if (line.find(interface) == std::string::npos) {
+      continue;
+    }
+    std::string irq = line.substr(0, line.find(':'));
+    irq.erase(0, irq.find_first_not_of(' '));
+    std::string affinity = firstLine("/proc/irq/" + irq + "/smp_affinity_list");
+    report << (first ? "" : ", ") << "{\"irq\": " << quoted(irq)
+           << ", \"affinity\": " << quoted(affinity) << "}";
+    first = false;
+  }
+  report << "]";
+}
+
+// Captures the scheduling of the control loop thread and the jitter of incoming states.
+class CycleMonitor {
+ public:
+  explicit CycleMonitor(ModeResult* result) : result_(result) {}
+
+  void update(franka::Duration period, double success_rate) noexcept {
+    auto now = std::chrono::steady_clock::now();
+    if (period.toMSec() == 0) {
+      captureScheduler();
+    } else {
+      double interval = std::chrono::duration<double, std::micro>(now - last_call_).count();
+      result_->jitter.record(std::abs(interval - static_cast<double>(period.toMSec()) * 1e3));
+      cycles_++;
+      result_->mean_success_rate +=
+          (success_rate - result_->mean_success_rate) / static_cast<double>(cycles_);
+    }
+    last_call_ = now;
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (last_cpu_ >= 0 && cpu != last_cpu_) {
+      result_->cpu_migrations++;
+    }
+    last_cpu_ = cpu;
+#endif
+  }
+
+ private:
+  void captureScheduler() noexcept {
+#ifdef __linux__
+    int policy = 0;
+    sched_param parameters{};
+    if (pthread_getschedparam(pthread_self(), &policy, &parameters) == 0) {
+      result_->scheduler = policy == SCHED_FIFO ? "SCHED_FIFO"
+                           : policy == SCHED_RR ? "SCHED_RR"
+                                                : "SCHED_OTHER";
+      result_->priority = parameters.sched_priority;
+    }
+#endif
+  }
+
+  ModeResult* result_;
+  std::chrono::steady_clock::time_point last_call_{};
+  int last_cpu_{-1};
+  uint64_t cycles_{0};
+};
+
+void runMode(const std::string& address, const Mode& mode, ModeResult* result) {
+  franka::Robot robot(address, franka::RealtimeConfig::kEnforce, mode.realtime_options);
+  setDefaultBehavior(robot);
+  robot.setCollisionBehavior(
+      {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
+      {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
+      {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}},
+      {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}});
+  robot.setControlStatisticsEnabled(true);
+  robot.setCommunicationStatisticsEnabled(true);
+
+  CycleMonitor monitor(result);
+  uint64_t time = 0;
+  franka::Torques zero_torques{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
+  // Sends zero torques - if EE is configured correctly, robot should not move.
+  auto step = [&](franka::Duration period, double success_rate) -> franka::Torques {
+    monitor.update(period, success_rate);
+    time += period.toMSec();
+    // Simulates the work of a controller.
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    if (time >= kTestDurationMs) {
+      return franka::MotionFinished(zero_torques);
+    }
+    return zero_torques;
+  };
+
+  std::cout << "Running mode " << mode.name << "..." << std::endl;
+  if (mode.view) {
+    robot.control(
+        [&](const franka::RobotStateView& robot_state, franka::Duration period) {
+          return step(period, robot_state.control_command_success_rate());
+        },
+        false, franka::kMaxCutoffFrequency);
+  } else {
+    robot.control(
+        [&](const franka::RobotState& robot_state, franka::Duration period) {
+          return step(period, robot_state.control_command_success_rate);
+        },
+        false, franka::kMaxCutoffFrequency);
+  }
+  result->control_statistics = robot.controlStatistics();
+  result->communication_statistics = robot.communicationStatistics();
+}
+
+}  // anonymous namespace
+
 int main(int argc, char** argv) {
-  if (argc != 2) {
-    std::cerr << "Usage: " << argv[0] << " <robot-hostname>" << std::endl;
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: " << argv[0] << " <robot-hostname> [<report-file>] [<network-interface>]"
+              << std::endl;
     return -1;
   }
+  std::string report_file = argc > 2 ? argv[2] : "";
+  std::string interface = argc > 3 ? argv[3] : "";
 
-  uint64_t counter = 0;
-  double avg_success_rate = 0.0;
-  double min_success_rate = 1.0;
-  double max_success_rate = 0.0;
-  uint64_t time = 0;
-  std::cout.precision(2);
-  std::cout << std::fixed;
+  franka::RealtimeOptions pinned;
+  pinned.lock_memory = true;
+  int cpus = static_cast<int>(std::thread::hardware_concurrency());
+  if (cpus > 1) {
+    pinned.cpu_affinity = {cpus - 1};
+  }
+  std::vector<Mode> modes{{"state", false, {}}, {"view", true, {}}, {"pinned", false, pinned}};
+  std::vector<std::unique_ptr<ModeResult>> results;
 
   try {
-    franka::Robot robot(argv[1]);
-    setDefaultBehavior(robot);
-
-    // First move the robot to a suitable joint configuration
-    std::array<double, 7> q_goal = {{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
-    MotionGenerator motion_generator(0.5, q_goal);
-    std::cout << "WARNING: This example will move the robot! "
-              << "Please make sure to have the user stop button at hand!" << std::endl
-              << "Press Enter to continue..." << std::endl;
-    std::cin.ignore();
-    robot.control(motion_generator);
-    std::cout << "Finished moving to initial joint configuration." << std::endl << std::endl;
-    std::cout << "Starting communication test." << std::endl;
+    {
+      franka::Robot robot(argv[1]);
+      setDefaultBehavior(robot);
 
-    robot.setCollisionBehavior(
-        {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
-        {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}}, {{20.0, 20.0, 18.0, 18.0, 16.0, 14.0, 12.0}},
-        {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}},
-        {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}}, {{20.0, 20.0, 20.0, 25.0, 25.0, 25.0}});
+      // First move the robot to a suitable joint configuration
+      std::array<double, 7> q_goal = {{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+      franka::JointMotionGenerator motion_generator(0.5, q_goal);
+      std::cout << "WARNING: This example will move the robot! "
+                << "Please make sure to have the user stop button at hand!" << std::endl
+                << "Press Enter to continue..." << std::endl;
+      std::cin.ignore();
+      robot.control(motion_generator);
+      std::cout << "Finished moving to initial joint configuration." << std::endl << std::endl;
+    }
 
-    franka::Torques zero_torques{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
-    robot.control(
-        [&time, &counter, &avg_success_rate, &min_success_rate, &max_success_rate, zero_torques](
-            const franka::RobotState& robot_state, franka::Duration period) -> franka::Torques {
-          time += period.toMSec();
-          if (time == 0.0) {
-            return zero_torques;
-          }
-          counter++;
-
-          if (counter % 100 == 0) {
-            std::cout << "#" << counter
-                      << " Current success rate: " << robot_state.control_command_success_rate
-                      << std::endl;
-          }
-          std::this_thread::sleep_for(std::chrono::microseconds(100));
-
-          avg_success_rate += robot_state.control_command_success_rate;
-          if (robot_state.control_command_success_rate > max_success_rate) {
-            max_success_rate = robot_state.control_command_success_rate;
-          }
-          if (robot_state.control_command_success_rate < min_success_rate) {
-            min_success_rate = robot_state.control_command_success_rate;
-          }
-
-          if (time >= 10000) {
-            std::cout << std::endl << "Finished test, shutting down example" << std::endl;
-            return franka::MotionFinished(zero_torques);
-          }
-
-          // Sending zero torques - if EE is configured correctly, robot should not move
-          return zero_torques;
-        },
-        false, 1000);
+    std::cout << "Starting communication test." << std::endl;
+    for (const Mode& mode : modes) {
+      results.push_back(std::make_unique<ModeResult>());
+      results.back()->name = mode.name;
+      runMode(argv[1], mode, results.back().get());
+    }
   } catch (const franka::Exception& e) {
     std::cout << e.what() << std::endl;
     return -1;
   }
 
-  avg_success_rate = avg_success_rate / counter;
+  std::ostringstream report;
+  report << "{\"system\": {";
+  writeSystemReport(report, interface);
+  report << "}, \"modes\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const ModeResult& result = *results[i];
+    report << (i == 0 ? "" : ", ") << "{\"name\": " << quoted(result.name)
+           << ", \"scheduler\": " << quoted(result.scheduler)
+           << ", \"priority\": " << result.priority
+           << ", \"cpu_migrations\": " << result.cpu_migrations
+           << ", \"mean_success_rate\": " << result.mean_success_rate
+           << ", \"inter_arrival_jitter\": " << result.jitter
+           << ", \"control_statistics\": " << result.control_statistics
+           << ", \"communication_statistics\": " << result.communication_statistics << "}";
+  }
+  report << "]}";
 
-  std::cout << std::endl
-            << std::endl
-            << "#######################################################" << std::endl;
-  uint64_t lost_robot_states = time - counter;
-  if (lost_robot_states > 0) {
-    std::cout << "The control loop did not get executed " << lost_robot_states << " times in the"
-              << std::endl
-              << "last " << time << " milliseconds! (lost " << lost_robot_states << " robot states)"
-              << std::endl
-              << std::endl;
+  std::cout << std::endl << report.str() << std::endl;
+  if (!report_file.empty()) {
+    std::ofstream(report_file) << report.str() << std::endl;
+    std::cout << "Report written to " << report_file << std::endl;
   }
 
-  std::cout << "Control command success rate of " << counter << " samples: " << std::endl;
-  std::cout << "Max: " << max_success_rate << std::endl;
-  std::cout << "Avg: " << avg_success_rate << std::endl;
-  std::cout << "Min: " << min_success_rate << std::endl;
+  std::cout << std::endl << "#######################################################" << std::endl;
+  std::cout.precision(2);
+  std::cout << std::fixed;
+  double mean_success_rate = 1.0;
+  for (const auto& result : results) {
+    const franka::CommunicationStatistics& communication = result->communication_statistics;
+    const franka::LatencyStatistics& cycle = result->control_statistics.cycle;
+    std::cout << result->name << ": lost " << communication.lost_states << " of "
+              << communication.received_states + communication.lost_states
+              << " robot states, average success rate " << result->mean_success_rate
+              << ", cycle p99.9 " << cycle.p999 << " us, max " << cycle.max << " us" << std::endl;
+    mean_success_rate = std::min(mean_success_rate, result->mean_success_rate);
+  }
 
-  if (avg_success_rate < 0.90) {
+  if (mean_success_rate < 0.90) {
     std::cout << std::endl
               << "WARNING: THIS SETUP IS PROBABLY NOT SUFFICIENT FOR FCI!" << std::endl;
     std::cout << "PLEASE TRY OUT A DIFFERENT PC / NIC" << std::endl;
-  } else if (avg_success_rate < 0.95) {
+  } else if (mean_success_rate < 0.95) {
     std::cout << std::endl << "WARNING: MANY PACKETS GOT LOST!" << std::endl;
     std::cout << "PLEASE INSPECT YOUR SETUP AND FOLLOW ADVICE ON" << std::endl
               << "https://frankaemika.github.io/docs/troubleshooting.html" << std::endl;
@@ -1,23 +1,54 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
 
 #include <franka/exception.h>
 #include <franka/robot.h>
+#include <franka/state_broadcast.h>
 
 /**
  * @example echo_robot_state.cpp
  * An example showing how to continuously read the robot state.
+ *
+ * If a shared memory name such as `/franka_state` is given after the robot hostname, the state is
+ * additionally broadcast to other processes. A second instance started with `--subscribe` and the
+ * same name then prints the broadcast states without connecting to the robot.
  */
 
 int main(int argc, char** argv) {
-  if (argc != 2) {
-    std::cerr << "Usage: " << argv[0] << " <robot-hostname>" << std::endl;
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <robot-hostname> [<broadcast-name>]" << std::endl
+              << "       " << argv[0] << " --subscribe <broadcast-name>" << std::endl;
     return -1;
   }
 
   try {
+    if (std::string(argv[1]) == "--subscribe") {
+      if (argc != 3) {
+        std::cerr << "Missing broadcast name." << std::endl;
+        return -1;
+      }
+      franka::StateSubscriber subscriber(argv[2]);
+      franka::PublishedState state;
+      for (size_t count = 0; count < 100; count++) {
+        // Waits for the next state, so that no state is printed twice.
+        if (!subscriber.readNext(&state, std::chrono::seconds(1))) {
+          std::cerr << "No state broadcast within one second." << std::endl;
+          return -1;
+        }
+        std::cout << state.robot_state << std::endl;
+      }
+      std::cout << "Done. Lost states: " << subscriber.lostStates() << std::endl;
+      return 0;
+    }
+
     franka::Robot robot(argv[1]);
+    if (argc == 3) {
+      robot.setStateBroadcaster(std::make_shared<franka::StateBroadcaster>(argv[2]));
+    }
 
     size_t count = 0;
     robot.read([&count](const franka::RobotState& robot_state) {
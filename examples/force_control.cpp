@@ -7,6 +7,7 @@
 
 #include <franka/duration.h>
 #include <franka/exception.h>
+#include <franka/force_controller.h>
 #include <franka/model.h>
 #include <franka/robot.h>
 
@@ -49,15 +50,15 @@ int main(int argc, char** argv) {
 
     franka::RobotState initial_state = robot.readOnce();
 
-    Eigen::VectorXd initial_tau_ext(7), tau_error_integral(7);
-    // Bias torque sensor
-    std::array<double, 7> gravity_array = model.gravity(initial_state);
-    Eigen::Map<Eigen::Matrix<double, 7, 1>> initial_tau_measured(initial_state.tau_J.data());
-    Eigen::Map<Eigen::Matrix<double, 7, 1>> initial_gravity(gravity_array.data());
-    initial_tau_ext = initial_tau_measured - initial_gravity;
-
-    // init integrator
-    tau_error_integral.setZero();
+    // Measure the wrench through the external torques and remove their initial bias
+    franka::ForceControllerParameters parameters;
+    parameters.selection = {{false, false, true, false, false, false}};
+    parameters.proportional_gain.fill(k_p);
+    parameters.integral_gain.fill(k_i);
+    parameters.measurement = franka::ForceMeasurement::kExternalTorques;
+    franka::ForceController force_controller(parameters);
+    force_controller.calibrateBias(
+        initial_state, model.zeroJacobian(franka::Frame::kStiffness, initial_state));
 
     // define callback for the torque control loop
     Eigen::Vector3d initial_position;
@@ -78,29 +79,14 @@ int main(int argc, char** argv) {
         throw std::runtime_error("Aborting; too far away from starting pose!");
       }
 
-      // get state variables
-      std::array<double, 42> jacobian_array =
-          model.zeroJacobian(franka::Frame::kEndEffector, robot_state);
-
-      Eigen::Map<const Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
-      Eigen::Map<const Eigen::Matrix<double, 7, 1>> tau_measured(robot_state.tau_J.data());
-      Eigen::Map<const Eigen::Matrix<double, 7, 1>> gravity(gravity_array.data());
-
-      Eigen::VectorXd tau_d(7), desired_force_torque(6), tau_cmd(7), tau_ext(7);
-      desired_force_torque.setZero();
-      desired_force_torque(2) = desired_mass * -9.81;
-      tau_ext << tau_measured - gravity - initial_tau_ext;
-      tau_d << jacobian.transpose() * desired_force_torque;
-      tau_error_integral += period.toSec() * (tau_d - tau_ext);
       // FF + PI control
-      tau_cmd << tau_d + k_p * (tau_d - tau_ext) + k_i * tau_error_integral;
+      force_controller.setTarget({{0.0, 0.0, desired_mass * -9.81, 0.0, 0.0, 0.0}});
+      std::array<double, 7> tau_d = force_controller.update(robot_state, model);
 
       // Smoothly update the mass to reach the desired target value
       desired_mass = filter_gain * target_mass + (1 - filter_gain) * desired_mass;
 
-      std::array<double, 7> tau_d_array{};
-      Eigen::VectorXd::Map(&tau_d_array[0], 7) = tau_cmd;
-      return tau_d_array;
+      return tau_d;
     };
     std::cout << "WARNING: Make sure sure that no endeffector is mounted and that the robot's last "
                  "joint is "
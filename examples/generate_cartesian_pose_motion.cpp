@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include <franka/exception.h>
+#include <franka/joint_trajectory.h>
 #include <franka/robot.h>
 
 #include "examples_common.h"
@@ -26,7 +27,7 @@ int main(int argc, char** argv) {
 
     // First move the robot to a suitable joint configuration
     std::array<double, 7> q_goal = {{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
-    MotionGenerator motion_generator(0.5, q_goal);
+    franka::JointMotionGenerator motion_generator(0.5, q_goal);
     std::cout << "WARNING: This example will move the robot! "
               << "Please make sure to have the user stop button at hand!" << std::endl
               << "Press Enter to continue..." << std::endl;
@@ -6,14 +6,16 @@
 #include <functional>
 #include <iostream>
 #include <iterator>
-#include <mutex>
+#include <memory>
 #include <thread>
 
 #include <franka/duration.h>
 #include <franka/exception.h>
+#include <franka/joint_impedance_controller.h>
+#include <franka/joint_trajectory.h>
 #include <franka/model.h>
-#include <franka/rate_limiting.h>
 #include <franka/robot.h>
+#include <franka/state_publisher.h>
 
 #include "examples_common.h"
 
@@ -32,8 +34,9 @@ std::ostream& operator<<(std::ostream& ostream, const std::array<T, N>& array) {
  * @example joint_impedance_control.cpp
  * An example showing a joint impedance type control that executes a Cartesian motion in the shape
  * of a circle. The example illustrates how to use the internal inverse kinematics to map a
- * Cartesian trajectory to joint space. The joint space target is tracked by an impedance control
- * that additionally compensates coriolis terms using the libfranka model library. This example
+ * Cartesian trajectory to joint space. The joint space target is tracked by a
+ * franka::JointImpedanceController that additionally compensates coriolis terms using the
+ * libfranka model library. This example
  * also serves to compare commanded vs. measured torques. The results are printed from a separate
  * thread to avoid blocking print functions in the real-time loop.
  */
@@ -56,46 +59,46 @@ int main(int argc, char** argv) {
   double angle = 0.0;
   double time = 0.0;
 
-  // Initialize data fields for the print thread.
-  struct {
-    std::mutex mutex;
-    bool has_data;
-    std::array<double, 7> tau_d_last;
-    franka::RobotState robot_state;
-    std::array<double, 7> gravity;
-  } print_data{};
+  // The controller publishes the state and its torques of every control cycle for the print
+  // thread.
+  auto publisher = std::make_shared<franka::StatePublisher>();
   std::atomic_bool running{true};
 
   // Start print thread.
-  std::thread print_thread([print_rate, &print_data, &running]() {
+  std::thread print_thread([print_rate, &publisher, &running]() {
+    uint64_t printed_states = 0;
     while (running) {
       // Sleep to achieve the desired print rate.
       std::this_thread::sleep_for(
           std::chrono::milliseconds(static_cast<int>((1.0 / print_rate * 1000.0))));
 
-      // Try to lock data to avoid read write collisions.
-      if (print_data.mutex.try_lock()) {
-        if (print_data.has_data) {
-          std::array<double, 7> tau_error{};
-          double error_rms(0.0);
-          std::array<double, 7> tau_d_actual{};
-          for (size_t i = 0; i < 7; ++i) {
-            tau_d_actual[i] = print_data.tau_d_last[i] + print_data.gravity[i];
-            tau_error[i] = tau_d_actual[i] - print_data.robot_state.tau_J[i];
-            error_rms += std::pow(tau_error[i], 2.0) / tau_error.size();
-          }
-          error_rms = std::sqrt(error_rms);
-
-          // Print data to console
-          std::cout << "tau_error [Nm]: " << tau_error << std::endl
-                    << "tau_commanded [Nm]: " << tau_d_actual << std::endl
-                    << "tau_measured [Nm]: " << print_data.robot_state.tau_J << std::endl
-                    << "root mean square of tau_error [Nm]: " << error_rms << std::endl
-                    << "-----------------------" << std::endl;
-          print_data.has_data = false;
-        }
-        print_data.mutex.unlock();
+      // Reading never blocks the control loop, and skips printing if there is nothing new.
+      franka::PublishedState data;
+      if (publisher->publishedStates() == printed_states || !publisher->read(&data)) {
+        continue;
       }
+      printed_states = data.sequence + 1;
+
+      // The gravity torques come from the same model evaluation as the torque command.
+      const franka::ControllerTorques& torques = data.controller_torques;
+      std::array<double, 7> tau_error{};
+      double error_rms(0.0);
+      std::array<double, 7> tau_d_actual{};
+      for (size_t i = 0; i < 7; ++i) {
+        tau_d_actual[i] = torques.tau_d_limited[i] + torques.gravity[i];
+        tau_error[i] = tau_d_actual[i] - data.robot_state.tau_J[i];
+        error_rms += std::pow(tau_error[i], 2.0) / tau_error.size();
+      }
+      error_rms = std::sqrt(error_rms);
+
+      // Print data to console
+      std::cout << "tau_error [Nm]: " << tau_error << std::endl
+                << "tau_commanded [Nm]: " << tau_d_actual << std::endl
+                << "tau_controller_before_rate_limiting [Nm]: " << torques.tau_d_commanded
+                << std::endl
+                << "tau_measured [Nm]: " << data.robot_state.tau_J << std::endl
+                << "root mean square of tau_error [Nm]: " << error_rms << std::endl
+                << "-----------------------" << std::endl;
     }
   });
 
@@ -106,7 +109,7 @@ int main(int argc, char** argv) {
 
     // First move the robot to a suitable joint configuration
     std::array<double, 7> q_goal = {{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
-    MotionGenerator motion_generator(0.5, q_goal);
+    franka::JointMotionGenerator motion_generator(0.5, q_goal);
     std::cout << "WARNING: This example will move the robot! "
               << "Please make sure to have the user stop button at hand!" << std::endl
               << "Press Enter to continue..." << std::endl;
@@ -176,41 +179,18 @@ int main(int argc, char** argv) {
     const std::array<double, 7> k_gains = {{600.0, 600.0, 600.0, 600.0, 250.0, 150.0, 50.0}};
     // Damping
     const std::array<double, 7> d_gains = {{50.0, 50.0, 50.0, 50.0, 30.0, 25.0, 15.0}};
+    franka::JointImpedanceController controller(k_gains, d_gains);
+    controller.setStatePublisher(publisher);
 
     // Define callback for the joint torque control loop.
     std::function<franka::Torques(const franka::RobotState&, franka::Duration)>
         impedance_control_callback =
-            [&print_data, &model, k_gains, d_gains](
-                const franka::RobotState& state, franka::Duration /*period*/) -> franka::Torques {
-      // Read current coriolis terms from model.
-      std::array<double, 7> coriolis = model.coriolis(state);
-
-      // Compute torque command from joint impedance control law.
+            [&model, &controller](const franka::RobotState& state,
+                                  franka::Duration /*period*/) -> franka::Torques {
+      // Compute the rate limited torque command from the joint impedance control law.
       // Note: The answer to our Cartesian pose inverse kinematics is always in state.q_d with one
       // time step delay.
-      std::array<double, 7> tau_d_calculated;
-      for (size_t i = 0; i < 7; i++) {
-        tau_d_calculated[i] =
-            k_gains[i] * (state.q_d[i] - state.q[i]) - d_gains[i] * state.dq[i] + coriolis[i];
-      }
-
-      // The following line is only necessary for printing the rate limited torque. As we activated
-      // rate limiting for the control loop (activated by default), the torque would anyway be
-      // adjusted!
-      std::array<double, 7> tau_d_rate_limited =
-          franka::limitRate(franka::kMaxTorqueRate, tau_d_calculated, state.tau_J_d);
-
-      // Update data to print.
-      if (print_data.mutex.try_lock()) {
-        print_data.has_data = true;
-        print_data.robot_state = state;
-        print_data.tau_d_last = tau_d_rate_limited;
-        print_data.gravity = model.gravity(state);
-        print_data.mutex.unlock();
-      }
-
-      // Send torque command.
-      return tau_d_rate_limited;
+      return controller.update(state, model);
     };
 
     // Start real-time control loop.
@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include <franka/exception.h>
+#include <franka/joint_trajectory.h>
 #include <franka/robot.h>
 
 #include "examples_common.h"
@@ -42,7 +43,7 @@ int main(int argc, char** argv) {
         {{20.0, 20.0, 20.0, 20.0, 20.0, 20.0}}, {{20.0, 20.0, 20.0, 20.0, 20.0, 20.0}},
         {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0}}, {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0}});
 
-    MotionGenerator motion_generator(speed_factor, q_goal);
+    franka::JointMotionGenerator motion_generator(speed_factor, q_goal);
     std::cout << "WARNING: This example will move the robot! "
               << "Please make sure to have the user stop button at hand!" << std::endl
               << "Press Enter to continue..." << std::endl;
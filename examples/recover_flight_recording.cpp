@@ -0,0 +1,38 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/flight_recorder.h>
+#include <franka/log.h>
+
+/**
+ * @example recover_flight_recording.cpp
+ * A tool that recovers the last robot states and commands from the file of a
+ * franka::FlightRecorder, e.g. after the controller process crashed, and writes them as CSV.
+ */
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <flight-recording> <output-csv>" << std::endl;
+    return -1;
+  }
+
+  try {
+    std::vector<franka::Record> records = franka::readFlightRecording(argv[1]);
+    std::ofstream output(argv[2]);
+    output << franka::logToCSV(records, franka::LogFields::kAll);
+    if (!output) {
+      std::cerr << "Unable to write " << argv[2] << std::endl;
+      return -1;
+    }
+    std::cout << "Recovered " << records.size() << " samples." << std::endl;
+  } catch (franka::Exception const& e) {
+    std::cout << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file allocation_tracking.h
+ * Contains functions to check control loops for heap allocations.
+ *
+ * Allocation tracking is only available if libfranka was built with the `TRACK_ALLOCATIONS` CMake
+ * option. In that case, `operator new` (and `malloc` on glibc) are replaced by counting versions,
+ * and every heap allocation made by a control loop thread while a control loop is running is
+ * recorded, including allocations made in user callbacks.
+ */
+
+namespace franka {
+
+/**
+ * Heap allocations recorded while control loops were running.
+ */
+struct AllocationStatistics {
+  /**
+   * Number of recorded control loop cycles.
+   */
+  uint64_t cycles{};
+  /**
+   * Number of cycles during which at least one allocation was made.
+   */
+  uint64_t cycles_with_allocations{};
+  /**
+   * Total number of allocations.
+   */
+  uint64_t allocations{};
+  /**
+   * Largest number of allocations made during a single cycle.
+   */
+  uint64_t max_allocations_per_cycle{};
+  /**
+   * Symbolized stack trace of the first recorded allocation, innermost frame first. Empty if no
+   * allocation has been recorded.
+   */
+  std::vector<std::string> first_allocation_stack{};
+};
+
+/**
+ * Checks whether libfranka was built with allocation tracking.
+ *
+ * @return True if allocations are tracked, false otherwise.
+ */
+bool allocationTrackingEnabled() noexcept;
+
+/**
+ * Returns the allocations recorded since the last call to resetAllocationStatistics().
+ *
+ * This function allocates and should not be called from a control loop.
+ *
+ * @return Recorded allocations. Always empty if allocation tracking is not enabled.
+ */
+AllocationStatistics allocationStatistics();
+
+/**
+ * Clears all recorded allocations, including the stack trace of the first allocation.
+ */
+void resetAllocationStatistics() noexcept;
+
+}  // namespace franka
@@ -0,0 +1,171 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * @file butterworth_filter.h
+ * Contains the franka::ButterworthFilter type.
+ */
+
+namespace franka {
+
+/**
+ * Coefficients of a second-order section in transposed direct form II, normalized to
+ * \f$a_0 = 1\f$.
+ */
+struct BiquadCoefficients {
+  /**
+   * Numerator coefficients.
+   */
+  double b0, b1, b2;
+  /**
+   * Denominator coefficients.
+   */
+  double a1, a2;
+};
+
+/**
+ * Designs one second-order section of a digital Butterworth low-pass filter with the bilinear
+ * transform, prewarped to the given cutoff frequency.
+ *
+ * @param[in] order Even filter order.
+ * @param[in] section Index of the section, smaller than order / 2.
+ * @param[in] sample_time Sample time constant
+ * @param[in] cutoff_frequency Cutoff frequency of the low-pass filter
+ *
+ * @throw std::invalid_argument if order is zero or odd, or section is out of range.
+ * @throw std::invalid_argument if sample_time is zero, negative, infinite or NaN.
+ * @throw std::invalid_argument if cutoff_frequency is zero, negative, not below the Nyquist
+ * frequency, infinite or NaN.
+ *
+ * @return Coefficients of the section.
+ */
+BiquadCoefficients butterworthSection(size_t order,
+                                      size_t section,
+                                      double sample_time,
+                                      double cutoff_frequency);
+
+/**
+ * Butterworth low-pass filter for N channels, implemented as a cascade of second-order sections.
+ *
+ * Coefficients are designed once at construction. The filter state is stored per section as an
+ * array over all channels, so every section filters all channels in one vectorizable loop. A
+ * second-order filter rolls off with -40 dB/decade, a fourth-order filter with -80 dB/decade.
+ *
+ * The filter is stateful and has to be called once per sample time step. On the first call after
+ * construction or reset(), the state is initialized so that the filter starts in steady state at
+ * the given input.
+ *
+ * @tparam N Number of channels.
+ * @tparam Order Even filter order.
+ */
+template <size_t N, size_t Order = 2>
+class ButterworthFilter {
+  static_assert(Order > 0 && Order % 2 == 0, "ButterworthFilter: Order must be even.");
+
+ public:
+  /**
+   * Number of second-order sections.
+   */
+  static constexpr size_t kSections = Order / 2;
+
+  /**
+   * Creates a new filter.
+   *
+   * @param[in] sample_time Sample time constant
+   * @param[in] cutoff_frequency Cutoff frequency of the low-pass filter
+   *
+   * @throw std::invalid_argument if sample_time is zero, negative, infinite or NaN.
+   * @throw std::invalid_argument if cutoff_frequency is zero, negative, not below the Nyquist
+   * frequency, infinite or NaN.
+   */
+  ButterworthFilter(double sample_time, double cutoff_frequency) {
+    for (size_t section = 0; section < kSections; section++) {
+      coefficients_[section] = butterworthSection(Order, section, sample_time, cutoff_frequency);
+    }
+  }
+
+  /**
+   * Filters one sample of all channels.
+   *
+   * @param[in] input Current values of the signal to be filtered
+   *
+   * @throw std::invalid_argument if an element of input is infinite or NaN. The filter state is
+   * not changed in this case.
+   *
+   * @return Filtered values.
+   */
+  std::array<double, N> filter(const std::array<double, N>& input) {
+    bool finite = true;
+    for (size_t i = 0; i < N; i++) {
+      finite &= std::isfinite(input[i]);
+    }
+    if (!finite) {
+      throw std::invalid_argument(
+          "Butterworth filter: input value of the signal to be filtered is infinite or NaN.");
+    }
+    if (!initialized_) {
+      reset(input);
+    }
+
+    std::array<double, N> output = input;
+    for (size_t section = 0; section < kSections; section++) {
+      const BiquadCoefficients& c = coefficients_[section];
+      std::array<double, N>& z1 = z1_[section];
+      std::array<double, N>& z2 = z2_[section];
+      for (size_t i = 0; i < N; i++) {
+        double x = output[i];
+        double y = c.b0 * x + z1[i];
+        z1[i] = c.b1 * x - c.a1 * y + z2[i];
+        z2[i] = c.b2 * x - c.a2 * y;
+        output[i] = y;
+      }
+    }
+    return output;
+  }
+
+  /**
+   * Sets the state to the steady state for a constant input.
+   *
+   * @param[in] value Constant input, which is also the steady-state output.
+   */
+  void reset(const std::array<double, N>& value) noexcept {
+    // Every section has unity gain at zero frequency, so input and output are equal.
+    for (size_t section = 0; section < kSections; section++) {
+      const BiquadCoefficients& c = coefficients_[section];
+      for (size_t i = 0; i < N; i++) {
+        z1_[section][i] = (1 - c.b0) * value[i];
+        z2_[section][i] = (c.b2 - c.a2) * value[i];
+      }
+    }
+    initialized_ = true;
+  }
+
+  /**
+   * Clears the state, so that it is initialized again on the next call to filter().
+   */
+  void reset() noexcept { initialized_ = false; }
+
+  /**
+   * @param[in] section Index of the section, smaller than kSections.
+   *
+   * @return Coefficients of the given section.
+   */
+  const BiquadCoefficients& coefficients(size_t section) const { return coefficients_[section]; }
+
+ private:
+  std::array<BiquadCoefficients, kSections> coefficients_;
+  std::array<std::array<double, N>, kSections> z1_{};
+  std::array<std::array<double, N>, kSections> z2_{};
+  bool initialized_{false};
+};
+
+template <size_t N, size_t Order>
+constexpr size_t ButterworthFilter<N, Order>::kSections;
+
+}  // namespace franka
@@ -0,0 +1,139 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <bitset>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file cached_model.h
+ * Contains the franka::CachedModel type.
+ */
+
+namespace franka {
+
+/**
+ * Memoizes the results of a franka::Model for the current robot state.
+ *
+ * All results are kept until a robot state with different joint positions, joint velocities,
+ * end effector or stiffness frame, or load is passed. Repeated queries for the same robot state,
+ * e.g. from different places of one control callback, then only cost a comparison instead of a
+ * model evaluation.
+ *
+ * The wrapped model must outlive the CachedModel. A CachedModel is not thread-safe.
+ */
+class CachedModel {
+ public:
+  /**
+   * Creates a cache for the given model.
+   *
+   * @param[in] model Model to evaluate on cache misses.
+   */
+  explicit CachedModel(const Model& model) noexcept;
+
+  /**
+   * @see Model::pose(Frame, const franka::RobotState&) const
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] robot_state State from which the pose should be calculated.
+   *
+   * @return Vectorized 4x4 pose matrix, column-major.
+   */
+  const std::array<double, 16>& pose(Frame frame, const franka::RobotState& robot_state);
+
+  /**
+   * @see Model::bodyJacobian(Frame, const franka::RobotState&) const
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] robot_state State from which the Jacobian should be calculated.
+   *
+   * @return Vectorized 6x7 Jacobian, column-major.
+   */
+  const std::array<double, 42>& bodyJacobian(Frame frame, const franka::RobotState& robot_state);
+
+  /**
+   * @see Model::zeroJacobian(Frame, const franka::RobotState&) const
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] robot_state State from which the Jacobian should be calculated.
+   *
+   * @return Vectorized 6x7 Jacobian, column-major.
+   */
+  const std::array<double, 42>& zeroJacobian(Frame frame, const franka::RobotState& robot_state);
+
+  /**
+   * @see Model::mass(const franka::RobotState&) const
+   *
+   * @param[in] robot_state State from which the mass matrix should be calculated.
+   *
+   * @return Vectorized 7x7 mass matrix, column-major.
+   */
+  const std::array<double, 49>& mass(const franka::RobotState& robot_state) noexcept;
+
+  /**
+   * @see Model::coriolis(const franka::RobotState&) const
+   *
+   * @param[in] robot_state State from which the Coriolis force vector should be calculated.
+   *
+   * @return Coriolis force vector.
+   */
+  const std::array<double, 7>& coriolis(const franka::RobotState& robot_state) noexcept;
+
+  /**
+   * @see Model::gravity(const franka::RobotState&, const std::array<double, 3>&) const
+   *
+   * @param[in] robot_state State from which the gravity vector should be calculated.
+   * @param[in] gravity_earth Earth's gravity vector. Unit: \f$\frac{m}{s^2}\f$.
+   *
+   * @return Gravity vector.
+   */
+  const std::array<double, 7>& gravity(const franka::RobotState& robot_state,
+                                       const std::array<double, 3>& gravity_earth) noexcept;
+
+  /**
+   * @see Model::gravity(const franka::RobotState&) const
+   *
+   * @param[in] robot_state State from which the gravity vector should be calculated.
+   *
+   * @return Gravity vector.
+   */
+  const std::array<double, 7>& gravity(const franka::RobotState& robot_state) noexcept;
+
+  /**
+   * Discards all memoized results.
+   */
+  void invalidate() noexcept;
+
+ private:
+  void update(const franka::RobotState& robot_state) noexcept;
+
+  const Model& model_;  // NOLINT(readability-identifier-naming)
+
+  std::array<double, 7> q_{};
+  std::array<double, 7> dq_{};
+  EndEffectorFrames frames_;
+  std::array<double, 9> I_total_{};  // NOLINT(readability-identifier-naming)
+  double m_total_{};
+  std::array<double, 3> F_x_Ctotal_{};  // NOLINT(readability-identifier-naming)
+  bool key_valid_{false};
+
+  FramePoses poses_{};
+  FrameJacobians body_jacobians_{};
+  FrameJacobians zero_jacobians_{};
+  std::bitset<kFrameCount> poses_valid_;
+  std::bitset<kFrameCount> body_jacobians_valid_;
+  std::bitset<kFrameCount> zero_jacobians_valid_;
+
+  std::array<double, 49> mass_{};
+  bool mass_valid_{false};
+  std::array<double, 7> coriolis_{};
+  bool coriolis_valid_{false};
+  std::array<double, 7> gravity_{};
+  std::array<double, 3> gravity_earth_{};
+  bool gravity_valid_{false};
+};
+
+}  // namespace franka
@@ -0,0 +1,83 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @file callback_deadline.h
+ * Contains types for running control loop callbacks with a deadline, see
+ * Robot::setCallbackDeadline.
+ */
+
+namespace franka {
+
+/**
+ * Command that is sent instead of the callback output when a callback misses its deadline.
+ */
+enum class DeadlineFallback {
+  /**
+   * Repeats the last command: the last desired torque in torque control loops, and the last
+   * commanded joint position, joint velocity, Cartesian pose or Cartesian velocity in motion
+   * generator loops. With rate limiting, held positions are approached with a limited deceleration.
+   */
+  kHoldLastCommand,
+  /**
+   * Scales the last desired torque by CallbackDeadline::torque_decay in every missed cycle, so that
+   * the commanded torque decays towards gravity compensation only. Motion generator loops hold the
+   * last command instead.
+   */
+  kDecayTorque
+};
+
+/**
+ * Deadline of control loop callbacks.
+ */
+struct CallbackDeadline {
+  /**
+   * Time the callback may take, from being called with a robot state until it returns. Must be
+   * less than one control cycle. Unit: \f$[\mu s]\f$
+   */
+  std::chrono::microseconds budget{600};
+  /**
+   * Command to send in cycles in which the callback misses its deadline.
+   */
+  DeadlineFallback fallback{DeadlineFallback::kHoldLastCommand};
+  /**
+   * Factor applied to the last desired torque in every missed cycle with
+   * DeadlineFallback::kDecayTorque. Must be within \f$[0, 1]\f$.
+   */
+  double torque_decay{0.95};
+  /**
+   * Number of consecutive missed cycles after which the control loop is aborted with a
+   * ControlException.
+   */
+  uint64_t max_consecutive_misses{50};
+};
+
+/**
+ * Deadline statistics of the control loops executed since the statistics were last reset.
+ */
+struct DeadlineStatistics {
+  /**
+   * Number of cycles executed with a deadline.
+   */
+  uint64_t cycles{};
+  /**
+   * Number of cycles in which the fallback command was sent, because the callback missed its
+   * deadline or was still busy with an earlier robot state.
+   */
+  uint64_t misses{};
+  /**
+   * Number of robot states that were not passed to the callback, because it was still busy with an
+   * earlier robot state.
+   */
+  uint64_t skipped_states{};
+  /**
+   * Largest number of consecutive missed cycles.
+   */
+  uint64_t max_consecutive_misses{};
+};
+
+}  // namespace franka
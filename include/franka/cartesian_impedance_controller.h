@@ -0,0 +1,165 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file cartesian_impedance_controller.h
+ * Contains the franka::CartesianImpedanceController type.
+ */
+
+namespace franka {
+
+/**
+ * Cartesian impedance controller rendering a spring-damper system between the end effector and an
+ * equilibrium pose, without inertia shaping.
+ *
+ * The commanded torques are \f$\tau_d = J^T (-K e - D J \dot{q}) + c\f$, where \f$e\f$ is the
+ * pose error of RobotState::O_T_EE to the equilibrium pose in base frame, \f$K\f$ and \f$D\f$
+ * are diagonal stiffness and damping matrices, \f$J\f$ is the zero Jacobian of the end effector
+ * and \f$c\f$ the Coriolis vector.
+ *
+ * The equilibrium pose, stiffness and damping follow the values set with setTarget(),
+ * setStiffness() and setDamping() through a first-order low-pass filter that advances once per
+ * call to update(), so that changing them while the controller runs does not cause torque steps.
+ * The filter assumes one call per franka::kDeltaT.
+ *
+ * All quantities are fixed-size and the model is evaluated with a single call to
+ * Model::dynamics(), so update() does not allocate and can be called in every control cycle:
+ * @code{.cpp}
+ * franka::CartesianImpedanceController controller;
+ * controller.reset(robot.readOnce());
+ * robot.control([&](const franka::RobotState& robot_state, franka::Duration) -> franka::Torques {
+ *   return controller.update(robot_state, model);
+ * });
+ * @endcode
+ */
+class CartesianImpedanceController {
+ public:
+  /**
+   * Creates a controller with critically damped translational and rotational stiffness.
+   *
+   * @param[in] translational_stiffness Stiffness along the base frame axes.
+   * Unit: \f$[\frac{N}{m}]\f$.
+   * @param[in] rotational_stiffness Stiffness about the base frame axes.
+   * Unit: \f$[\frac{Nm}{rad}]\f$.
+   * @param[in] cutoff_frequency Cutoff frequency of the filter for equilibrium pose, stiffness
+   * and damping. Unit: \f$[Hz]\f$.
+   *
+   * @throw std::invalid_argument if a stiffness is negative, or a value is infinite or NaN, or
+   * cutoff_frequency is not positive.
+   */
+  CartesianImpedanceController(double translational_stiffness = 150.0,
+                               double rotational_stiffness = 10.0,
+                               double cutoff_frequency = 1.0);
+
+  /**
+   * Sets the equilibrium pose and its target to the current end effector pose
+   * RobotState::O_T_EE, and stiffness and damping to their targets without filtering.
+   *
+   * If update() is called before reset(), the equilibrium pose starts at the end effector pose of
+   * the first robot state and moves towards the target, if one has been set.
+   *
+   * @param[in] robot_state Current robot state.
+   */
+  void reset(const RobotState& robot_state) noexcept;
+
+  /**
+   * Sets the target of the equilibrium pose.
+   *
+   * @param[in] O_T_EE_d Target end effector pose in base frame, column-major.
+   *
+   * @throw std::invalid_argument if a value is infinite or NaN.
+   */
+  void setTarget(const std::array<double, 16>& O_T_EE_d);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Sets the target stiffness and a critical damping of \f$2 \sqrt{K}\f$ for it.
+   *
+   * @param[in] stiffness Diagonal of \f$K\f$, translation first.
+   * Unit: \f$[\frac{N}{m},\frac{N}{m},\frac{N}{m},\frac{Nm}{rad},\frac{Nm}{rad},\frac{Nm}{rad}]\f$.
+   *
+   * @throw std::invalid_argument if a value is negative, infinite or NaN.
+   */
+  void setStiffness(const std::array<double, 6>& stiffness);
+
+  /**
+   * Sets the target damping. Has to be called after setStiffness() to override the critical
+   * damping.
+   *
+   * @param[in] damping Diagonal of \f$D\f$, translation first.
+   * Unit: \f$[\frac{N \cdot s}{m},\frac{N \cdot s}{m},\frac{N \cdot s}{m},
+   * \frac{Nm \cdot s}{rad},\frac{Nm \cdot s}{rad},\frac{Nm \cdot s}{rad}]\f$.
+   *
+   * @throw std::invalid_argument if a value is negative, infinite or NaN.
+   */
+  void setDamping(const std::array<double, 6>& damping);
+
+  /**
+   * Computes the torque command for the given robot state.
+   *
+   * Evaluates the model once with Model::dynamics() for the end effector frame. The result is
+   * available with dynamics() afterwards, e.g. to add a null space task.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] model Robot model.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> update(const RobotState& robot_state, const Model& model);
+
+  /**
+   * Computes the torque command for the given robot state and precomputed dynamics.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] dynamics Dynamics for the end effector frame, of which only
+   * DynamicsBundle::zero_jacobian and DynamicsBundle::coriolis are used.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> update(const RobotState& robot_state,
+                               const DynamicsBundle& dynamics) noexcept;
+
+  /**
+   * @return Dynamics computed by the last call to update() with a model.
+   */
+  const DynamicsBundle& dynamics() const noexcept;
+
+  /**
+   * @return Current equilibrium pose in base frame, column-major.
+   */
+  std::array<double, 16> equilibriumPose() const noexcept;
+
+  /**
+   * @return Current diagonal of the stiffness matrix, translation first.
+   */
+  const std::array<double, 6>& stiffness() const noexcept;
+
+  /**
+   * @return Current diagonal of the damping matrix, translation first.
+   */
+  const std::array<double, 6>& damping() const noexcept;
+
+ private:
+  double gain_;
+  bool initialized_{false};
+
+  std::array<double, 3> position_{};
+  std::array<double, 4> orientation_{{0, 0, 0, 1}};
+  std::array<double, 6> stiffness_{};
+  std::array<double, 6> damping_{};
+
+  std::array<double, 3> target_position_{};
+  std::array<double, 4> target_orientation_{{0, 0, 0, 1}};
+  std::array<double, 6> target_stiffness_{};
+  std::array<double, 6> target_damping_{};
+  bool has_target_{false};
+
+  DynamicsBundle dynamics_{};
+};
+
+}  // namespace franka
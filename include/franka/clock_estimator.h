@@ -0,0 +1,137 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <franka/duration.h>
+
+/**
+ * @file clock_estimator.h
+ * Contains the franka::ClockEstimator and franka::ClockEstimate types.
+ */
+
+namespace franka {
+
+/**
+ * Relation between the robot clock and the monotonic host clock.
+ *
+ * A state taken at robot time \f$t\f$ was taken at host time
+ * \f$\mathrm{offset} + (1 + \mathrm{drift}) \cdot t\f$, and was received about latency later.
+ *
+ * @see ClockEstimator
+ */
+struct ClockEstimate {
+  /**
+   * Host time at robot time zero, as time since the epoch of std::chrono::steady_clock.
+   * Unit: \f$[s]\f$
+   */
+  double offset{};
+
+  /**
+   * Relative rate difference of the host clock, e.g. \f$10^{-5}\f$ if the host clock advances
+   * 10 µs per second more than the robot clock.
+   */
+  double drift{};
+
+  /**
+   * Mean one-way latency from taking a state on the robot to receiving it on the host.
+   * Unit: \f$[s]\f$
+   */
+  double latency{};
+
+  /**
+   * Number of received states the estimate is based on.
+   */
+  uint64_t samples{};
+};
+
+/**
+ * Estimates the host time of robot states from their robot time and host receive time.
+ *
+ * RobotState::time is counted by the robot and has no relation to the host clock. To align robot
+ * states with other sensors, e.g. camera frames or haptic device samples, the estimator fits a line
+ * through the host receive times over the robot times of all states, weighting recent states more.
+ * The slope of the line gives the drift between both clocks. Since network and scheduling delays
+ * only ever make states arrive later, the line is then shifted down to the states that arrived
+ * fastest.
+ *
+ * The minimum transport latency itself cannot be observed from states sent in one direction only.
+ * It is given to the constructor, e.g. from half the round trip time reported by
+ * CommunicationStatistics, and defaults to zero. The estimated host times are earlier than the
+ * fastest receive times by this latency.
+ *
+ * Updating the estimate takes constant time and does not allocate.
+ */
+class ClockEstimator {
+ public:
+  /**
+   * Creates a new estimator.
+   *
+   * @param[in] smoothing Weight of the newest state in the fit. The default averages over about
+   * ten seconds at 1 kHz.
+   * @param[in] transport_latency Minimum one-way latency from the robot to the host.
+   * Unit: \f$[s]\f$
+   *
+   * @throw std::invalid_argument if smoothing is not in \f$(0, 1]\f$ or transport_latency is
+   * negative or not finite.
+   */
+  explicit ClockEstimator(double smoothing = 1e-4, double transport_latency = 0.0);
+
+  /**
+   * Updates the estimate with a received state.
+   *
+   * @param[in] robot_time Robot time of the state, see RobotState::time.
+   * @param[in] receive_time Host time at which the state was received.
+   */
+  void update(Duration robot_time, std::chrono::steady_clock::time_point receive_time) noexcept;
+
+  /**
+   * Clears all measurements, e.g. after the robot was restarted.
+   */
+  void reset() noexcept;
+
+  /**
+   * @return True if enough states were received to estimate the drift.
+   */
+  bool valid() const noexcept;
+
+  /**
+   * Converts a robot time to the host clock.
+   *
+   * @param[in] robot_time Robot time, see RobotState::time.
+   *
+   * @return Estimated host time at the given robot time, or a default-constructed time point if no
+   * state was received yet.
+   */
+  std::chrono::steady_clock::time_point hostTime(Duration robot_time) const noexcept;
+
+  /**
+   * @return Current estimate.
+   */
+  ClockEstimate estimate() const noexcept;
+
+ private:
+  // Robot time relative to the first state. Unit: [s]
+  double relativeRobotTime(Duration robot_time) const noexcept;
+  // Estimated host time at the given relative robot time, relative to the first state. Unit: [s]
+  double relativeHostTime(double robot_time) const noexcept;
+
+  double smoothing_;
+  double transport_latency_;
+  uint64_t samples_{0};
+
+  // Times are relative to the first state to keep their precision. Unit: [s]
+  uint64_t robot_origin_{0};
+  std::chrono::steady_clock::time_point host_origin_{};
+  double mean_robot_time_{0};
+  double mean_host_time_{0};
+  double robot_time_variance_{0};
+  double covariance_{0};
+  // Receive delay relative to the fitted line, of the fastest and of all recent states.
+  double minimum_delay_{0};
+  double mean_delay_{0};
+};
+
+}  // namespace franka
@@ -0,0 +1,498 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <franka/control_tools.h>
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/lowpass_filter.h>
+#include <franka/passivity_controller.h>
+#include <franka/rate_limiting.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file command_pipeline.h
+ * Contains the franka::CommandPipeline type and the stages it can be composed of.
+ */
+
+namespace franka {
+
+/**
+ * Stages for a franka::CommandPipeline.
+ *
+ * A stage is any object with call operators of the form
+ * `void operator()(Command* command, const RobotState& robot_state, Duration time_step)` for the
+ * command types it supports, i.e. franka::Torques, franka::JointPositions,
+ * franka::JointVelocities, franka::CartesianPose or franka::CartesianVelocities. A pipeline skips
+ * stages that do not support the processed command type at compile time.
+ */
+namespace pipeline {
+
+/**
+ * Applies the first order low-pass filter of the control loop, using the last commanded values
+ * from the robot state as previous values.
+ */
+class Lowpass {
+ public:
+  /**
+   * Creates a new filter stage.
+   *
+   * @param[in] cutoff_frequency Cutoff frequency of the low-pass filter. Unit: \f$[Hz]\f$
+   *
+   * @throw std::invalid_argument if cutoff_frequency is zero, negative, infinite or NaN.
+   */
+  explicit Lowpass(double cutoff_frequency = kDefaultCutoffFrequency)
+      : joint_filter_(kDeltaT, cutoff_frequency),
+        cartesian_filter_(kDeltaT, cutoff_frequency),
+        elbow_filter_(kDeltaT, cutoff_frequency),
+        pose_filter_(kDeltaT, cutoff_frequency) {}
+
+  /** Filters torque commands. */
+  void operator()(Torques* command, const RobotState& robot_state, Duration /* time_step */) {
+    command->tau_J = joint_filter_.filter(command->tau_J, robot_state.tau_J_d);
+  }
+
+  /** Filters joint position commands. */
+  void operator()(JointPositions* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) {
+    command->q = joint_filter_.filter(command->q, robot_state.q_d);
+  }
+
+  /** Filters joint velocity commands. */
+  void operator()(JointVelocities* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) {
+    command->dq = joint_filter_.filter(command->dq, robot_state.dq_d);
+  }
+
+  /** Filters Cartesian pose commands and their elbow. */
+  void operator()(CartesianPose* command, const RobotState& robot_state, Duration /* time_step */) {
+    command->O_T_EE = pose_filter_.filter(command->O_T_EE, robot_state.O_T_EE_c);
+    filterElbow(command->hasElbow(), &command->elbow, robot_state);
+  }
+
+  /** Filters Cartesian velocity commands and their elbow. */
+  void operator()(CartesianVelocities* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) {
+    command->O_dP_EE = cartesian_filter_.filter(command->O_dP_EE, robot_state.O_dP_EE_c);
+    filterElbow(command->hasElbow(), &command->elbow, robot_state);
+  }
+
+ private:
+  void filterElbow(bool has_elbow, std::array<double, 2>* elbow, const RobotState& robot_state) {
+    if (has_elbow) {
+      (*elbow)[0] = elbow_filter_.filter({{(*elbow)[0]}}, {{robot_state.elbow_c[0]}})[0];
+    }
+  }
+
+  LowpassFilter<7> joint_filter_;
+  LowpassFilter<6> cartesian_filter_;
+  LowpassFilter<1> elbow_filter_;
+  CartesianPoseLowpassFilter pose_filter_;
+};
+
+/**
+ * Limits the rate of commands with the limits of the control loop, using the last commanded
+ * values and their derivatives from the robot state.
+ */
+class RateLimit {
+ public:
+  /** Limits the torque rate with franka::kMaxTorqueRate. */
+  void operator()(Torques* command, const RobotState& robot_state, Duration /* time_step */) const {
+    command->tau_J = limitRate(kMaxTorqueRate, command->tau_J, robot_state.tau_J_d);
+  }
+
+  /** Limits joint velocity, acceleration and jerk of joint position commands. */
+  void operator()(JointPositions* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) const {
+    command->q = limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, command->q,
+                           robot_state.q_d, robot_state.dq_d, robot_state.ddq_d);
+  }
+
+  /** Limits joint velocity, acceleration and jerk of joint velocity commands. */
+  void operator()(JointVelocities* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) const {
+    command->dq = limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, command->dq,
+                            robot_state.dq_d, robot_state.ddq_d);
+  }
+
+  /** Limits Cartesian velocity, acceleration and jerk of Cartesian pose commands. */
+  void operator()(CartesianPose* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) const {
+    command->O_T_EE = limitRate(kMaxTranslationalVelocity, kMaxTranslationalAcceleration,
+                                kMaxTranslationalJerk, kMaxRotationalVelocity,
+                                kMaxRotationalAcceleration, kMaxRotationalJerk, command->O_T_EE,
+                                robot_state.O_T_EE_c, robot_state.O_dP_EE_c,
+                                robot_state.O_ddP_EE_c);
+    limitElbow(command->hasElbow(), &command->elbow, robot_state);
+  }
+
+  /** Limits Cartesian velocity, acceleration and jerk of Cartesian velocity commands. */
+  void operator()(CartesianVelocities* command,
+                  const RobotState& robot_state,
+                  Duration /* time_step */) const {
+    command->O_dP_EE = limitRate(kMaxTranslationalVelocity, kMaxTranslationalAcceleration,
+                                 kMaxTranslationalJerk, kMaxRotationalVelocity,
+                                 kMaxRotationalAcceleration, kMaxRotationalJerk, command->O_dP_EE,
+                                 robot_state.O_dP_EE_c, robot_state.O_ddP_EE_c);
+    limitElbow(command->hasElbow(), &command->elbow, robot_state);
+  }
+
+ private:
+  static void limitElbow(bool has_elbow,
+                         std::array<double, 2>* elbow,
+                         const RobotState& robot_state) {
+    if (has_elbow) {
+      (*elbow)[0] = limitRate(kMaxElbowVelocity, kMaxElbowAcceleration, kMaxElbowJerk, (*elbow)[0],
+                              robot_state.elbow_c[0], robot_state.delbow_c[0],
+                              robot_state.ddelbow_c[0]);
+    }
+  }
+};
+
+/**
+ * Makes torque commands passive with a franka::PassivityController.
+ */
+class Passivity {
+ public:
+  /**
+   * Creates a new passivity stage.
+   *
+   * @param[in] parameters Parameters of the passivity controller.
+   *
+   * @throw std::invalid_argument if the parameters are invalid.
+   */
+  explicit Passivity(const PassivityControllerParameters& parameters = {})
+      : controller_(parameters) {}
+
+  /** Injects damping into torque commands that would generate energy. */
+  void operator()(Torques* command, const RobotState& robot_state, Duration time_step) {
+    command->tau_J =
+        controller_.control(command->tau_J, robot_state.tau_J_d, robot_state.dq, time_step);
+  }
+
+  /**
+   * @return Passivity controller of this stage, e.g. to read its statistics.
+   */
+  PassivityController& controller() noexcept { return controller_; }
+
+ private:
+  PassivityController controller_;
+};
+
+/**
+ * Saturates every element of joint-level commands, e.g. to enforce torque or joint limits that are
+ * stricter than the ones of the robot.
+ */
+class Clamp {
+ public:
+  /**
+   * Creates a new clamping stage.
+   *
+   * @param[in] min Lower bound of every element, in the unit of the command.
+   * @param[in] max Upper bound of every element, in the unit of the command.
+   *
+   * @throw std::invalid_argument if a lower bound is larger than its upper bound, or a bound is
+   * NaN.
+   */
+  Clamp(const std::array<double, 7>& min, const std::array<double, 7>& max) : min_(min), max_(max) {
+    for (size_t i = 0; i < 7; i++) {
+      if (!(min[i] <= max[i])) {
+        throw std::invalid_argument("libfranka: Clamp bounds are invalid.");
+      }
+    }
+  }
+
+  /** Saturates torque commands. */
+  void operator()(Torques* command, const RobotState& /* robot_state */, Duration) const {
+    clamp(&command->tau_J);
+  }
+
+  /** Saturates joint position commands. */
+  void operator()(JointPositions* command, const RobotState& /* robot_state */, Duration) const {
+    clamp(&command->q);
+  }
+
+  /** Saturates joint velocity commands. */
+  void operator()(JointVelocities* command, const RobotState& /* robot_state */, Duration) const {
+    clamp(&command->dq);
+  }
+
+ private:
+  void clamp(std::array<double, 7>* values) const noexcept {
+    for (size_t i = 0; i < 7; i++) {
+      (*values)[i] = std::min(std::max((*values)[i], min_[i]), max_[i]);
+    }
+  }
+
+  std::array<double, 7> min_;
+  std::array<double, 7> max_;
+};
+
+/**
+ * Checks that commands are finite, that Cartesian poses are homogeneous transformations and that
+ * elbow commands are valid.
+ */
+class CheckFinite {
+ public:
+  /**
+   * Checks torque commands.
+   *
+   * @throw std::invalid_argument if a command value is infinite or NaN.
+   */
+  void operator()(Torques* command, const RobotState& /* robot_state */, Duration) const {
+    check(command->tau_J);
+  }
+
+  /**
+   * Checks joint position commands.
+   *
+   * @throw std::invalid_argument if a command value is infinite or NaN.
+   */
+  void operator()(JointPositions* command, const RobotState& /* robot_state */, Duration) const {
+    check(command->q);
+  }
+
+  /**
+   * Checks joint velocity commands.
+   *
+   * @throw std::invalid_argument if a command value is infinite or NaN.
+   */
+  void operator()(JointVelocities* command, const RobotState& /* robot_state */, Duration) const {
+    check(command->dq);
+  }
+
+  /**
+   * Checks Cartesian pose commands.
+   *
+   * @throw std::invalid_argument if the pose is not a homogeneous transformation or the elbow is
+   * invalid.
+   */
+  void operator()(CartesianPose* command, const RobotState& /* robot_state */, Duration) const {
+    check(command->O_T_EE);
+    if (!isHomogeneousTransformation(command->O_T_EE)) {
+      throw std::invalid_argument(
+          "libfranka: Attempt to set invalid transformation in motion generator. Has to be column "
+          "major!");
+    }
+    checkElbow(command->hasElbow(), command->elbow);
+  }
+
+  /**
+   * Checks Cartesian velocity commands.
+   *
+   * @throw std::invalid_argument if a command value is infinite or NaN or the elbow is invalid.
+   */
+  void operator()(CartesianVelocities* command,
+                  const RobotState& /* robot_state */,
+                  Duration) const {
+    check(command->O_dP_EE);
+    checkElbow(command->hasElbow(), command->elbow);
+  }
+
+ private:
+  template <size_t N>
+  static void check(const std::array<double, N>& values) {
+    bool finite = true;
+    for (size_t i = 0; i < N; i++) {
+      finite &= static_cast<bool>(std::isfinite(values[i]));
+    }
+    if (!finite) {
+      throw std::invalid_argument("Commanding value is infinite or NaN.");
+    }
+  }
+
+  static void checkElbow(bool has_elbow, const std::array<double, 2>& elbow) {
+    if (has_elbow) {
+      check(elbow);
+      if (!isValidElbow(elbow)) {
+        throw std::invalid_argument(
+            "Invalid elbow configuration given! Only +1 or -1 are allowed for the sign of the 4th "
+            "joint.");
+      }
+    }
+  }
+};
+
+/**
+ * Runs a user-provided callable as stage.
+ *
+ * The callable is only called for the command types it accepts.
+ *
+ * @tparam Function Callable with the signature
+ * `void(Command*, const franka::RobotState&, franka::Duration)`.
+ */
+template <typename Function>
+class Custom {
+ public:
+  /**
+   * Creates a new custom stage.
+   *
+   * @param[in] function Callable to run.
+   */
+  explicit Custom(Function function) : function_(std::move(function)) {}
+
+  /** Runs the callable. */
+  template <typename Command>
+  auto operator()(Command* command, const RobotState& robot_state, Duration time_step)
+      -> decltype(std::declval<Function&>()(command, robot_state, time_step), void()) {
+    function_(command, robot_state, time_step);
+  }
+
+ private:
+  Function function_;
+};
+
+/**
+ * Creates a custom stage from a callable.
+ *
+ * @param[in] function Callable to run.
+ *
+ * @return Custom stage.
+ */
+template <typename Function>
+Custom<std::decay_t<Function>> custom(Function&& function) {
+  return Custom<std::decay_t<Function>>(std::forward<Function>(function));
+}
+
+}  // namespace pipeline
+
+/// @cond DO_NOT_DOCUMENT
+namespace detail {
+
+template <typename Stage, typename Command>
+inline auto applyStage(Stage& stage,
+                       Command* command,
+                       const RobotState& robot_state,
+                       Duration time_step,
+                       int /* preferred */) -> decltype(stage(command, robot_state, time_step)) {
+  return stage(command, robot_state, time_step);
+}
+
+template <typename Stage, typename Command>
+inline void applyStage(Stage& /* stage */,
+                       Command* /* command */,
+                       const RobotState& /* robot_state */,
+                       Duration /* time_step */,
+                       long /* fallback */) {}
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * Processes commands of a control loop callback with a sequence of stages that is fixed at compile
+ * time.
+ *
+ * Stages run in the given order, and every call is resolved and inlined at compile time. Stages
+ * that do not support a command type are skipped without any runtime cost, so the same pipeline
+ * can process torques and all four motion generator types. See franka::pipeline for the available
+ * stages.
+ *
+ * To replace the built-in filtering and rate limiting of a control loop, wrap the callback and
+ * disable the built-in processing:
+ * @code{.cpp}
+ * auto pipeline = franka::makeCommandPipeline(franka::pipeline::Lowpass(30.0),
+ *                                             franka::pipeline::RateLimit(),
+ *                                             franka::pipeline::CheckFinite());
+ * robot.control(pipeline.wrap(callback), false, franka::kMaxCutoffFrequency);
+ * @endcode
+ *
+ * @tparam Stages Types of the stages.
+ */
+template <typename... Stages>
+class CommandPipeline {
+ public:
+  /**
+   * Creates a new pipeline.
+   *
+   * @param[in] stages Stages to run, in order.
+   */
+  explicit CommandPipeline(Stages... stages) : stages_(std::move(stages)...) {}
+
+  /**
+   * Runs all stages that support the command type on a command.
+   *
+   * @param[in] command Command returned by a callback.
+   * @param[in] robot_state Robot state the callback was called with.
+   * @param[in] time_step Time step the callback was called with.
+   *
+   * @return Processed command.
+   *
+   * @throw Any exception thrown by a stage.
+   */
+  template <typename Command>
+  Command operator()(Command command, const RobotState& robot_state, Duration time_step) {
+    process(&command, robot_state, time_step, std::index_sequence_for<Stages...>());
+    return command;
+  }
+
+  /**
+   * Creates a callback that runs this pipeline on the commands of the given callback.
+   *
+   * The pipeline and the callback are referenced, so both must outlive the returned callback.
+   *
+   * @param[in] callback Callback with the signature `Command(const franka::RobotState&,
+   * franka::Duration)`.
+   *
+   * @return Callback with the same signature.
+   */
+  template <typename Callback>
+  auto wrap(Callback& callback) {
+    return [this, &callback](const RobotState& robot_state, Duration time_step) {
+      return (*this)(callback(robot_state, time_step), robot_state, time_step);
+    };
+  }
+
+  /**
+   * @tparam I Index of the stage.
+   *
+   * @return The stage at the given index.
+   */
+  template <size_t I>
+  std::tuple_element_t<I, std::tuple<Stages...>>& stage() noexcept {
+    return std::get<I>(stages_);
+  }
+
+ private:
+  template <typename Command, size_t... I>
+  void process(Command* command,
+               const RobotState& robot_state,
+               Duration time_step,
+               std::index_sequence<I...> /* indices */) {
+    // Braced initializer lists are evaluated in order.
+    using Expand = int[];
+    static_cast<void>(
+        Expand{0, (detail::applyStage(std::get<I>(stages_), command, robot_state, time_step, 0),
+                   0)...});
+  }
+
+  std::tuple<Stages...> stages_;
+};
+
+/**
+ * Creates a command pipeline from the given stages.
+ *
+ * @param[in] stages Stages to run, in order.
+ *
+ * @return Command pipeline.
+ */
+template <typename... Stages>
+CommandPipeline<std::decay_t<Stages>...> makeCommandPipeline(Stages&&... stages) {
+  return CommandPipeline<std::decay_t<Stages>...>(std::forward<Stages>(stages)...);
+}
+
+}  // namespace franka
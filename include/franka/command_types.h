@@ -3,7 +3,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string>
 
 /**
  * @file command_types.h
@@ -39,4 +42,191 @@ struct VirtualWallCuboid {
   bool active;
 };
 
+/**
+ * Result of a command sent with Robot::execute(const CommandBatch&).
+ */
+struct CommandResult {
+  /**
+   * Name of the command, e.g. "SetCollisionBehavior".
+   */
+  std::string command;
+
+  /**
+   * True if the Control accepted the command.
+   */
+  bool success;
+
+  /**
+   * Error message if the Control rejected the command or answered unexpectedly, empty otherwise.
+   */
+  std::string error;
+};
+
+/**
+ * Configuration commands that are sent to the robot together.
+ *
+ * Every configuration setter of franka::Robot waits for the response to its command before it
+ * returns, so a sequence of setters costs one network round trip each. Robot::execute() instead
+ * sends all commands of a batch at once and then collects the responses, which costs about one
+ * round trip in total:
+ *
+ * @code{.cpp}
+ * franka::CommandBatch batch;
+ * batch.setCollisionBehavior(lower_torques, upper_torques, lower_forces, upper_forces)
+ *     .setJointImpedance({{3000, 3000, 3000, 2500, 2500, 2000, 2000}})
+ *     .setCartesianImpedance({{3000, 3000, 3000, 300, 300, 300}});
+ * for (const franka::CommandResult& result : robot.execute(batch)) {
+ *   if (!result.success) {
+ *     std::cerr << result.error << std::endl;
+ *   }
+ * }
+ * @endcode
+ *
+ * The Control processes the commands in the order in which they were added. A rejected command
+ * does not affect the other commands of the batch. The parameters of the setters are documented
+ * at the corresponding setters of franka::Robot. A batch can be executed any number of times.
+ */
+class CommandBatch {
+ public:
+  /**
+   * Creates an empty batch.
+   */
+  CommandBatch();
+
+  /**
+   * Moves the commands of a batch into a new one.
+   *
+   * @param[in] other Batch to move from. Empty afterwards.
+   */
+  CommandBatch(CommandBatch&& other);
+
+  /**
+   * Moves the commands of a batch into this one.
+   *
+   * @param[in] other Batch to move from. Empty afterwards.
+   *
+   * @return This batch.
+   */
+  CommandBatch& operator=(CommandBatch&& other) noexcept;
+
+  /**
+   * Frees the commands.
+   */
+  ~CommandBatch() noexcept;
+
+  /**
+   * Adds a SetCollisionBehavior command with separate thresholds for acceleration and constant
+   * velocity phases.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setCollisionBehavior
+   */
+  CommandBatch& setCollisionBehavior(
+      const std::array<double, 7>& lower_torque_thresholds_acceleration,
+      const std::array<double, 7>& upper_torque_thresholds_acceleration,
+      const std::array<double, 7>& lower_torque_thresholds_nominal,
+      const std::array<double, 7>& upper_torque_thresholds_nominal,
+      const std::array<double, 6>& lower_force_thresholds_acceleration,
+      const std::array<double, 6>& upper_force_thresholds_acceleration,
+      const std::array<double, 6>& lower_force_thresholds_nominal,
+      const std::array<double, 6>& upper_force_thresholds_nominal);
+
+  /**
+   * Adds a SetCollisionBehavior command with common thresholds for acceleration and constant
+   * velocity phases.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setCollisionBehavior
+   */
+  CommandBatch& setCollisionBehavior(const std::array<double, 7>& lower_torque_thresholds,
+                                     const std::array<double, 7>& upper_torque_thresholds,
+                                     const std::array<double, 6>& lower_force_thresholds,
+                                     const std::array<double, 6>& upper_force_thresholds);
+
+  /**
+   * Adds a SetJointImpedance command.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setJointImpedance
+   */
+  CommandBatch& setJointImpedance(
+      const std::array<double, 7>& K_theta);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Adds a SetCartesianImpedance command.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setCartesianImpedance
+   */
+  CommandBatch& setCartesianImpedance(
+      const std::array<double, 6>& K_x);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Adds a SetGuidingMode command.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setGuidingMode
+   */
+  CommandBatch& setGuidingMode(const std::array<bool, 6>& guiding_mode, bool elbow);
+
+  /**
+   * Adds a SetEEToK command.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setK
+   */
+  CommandBatch& setK(
+      const std::array<double, 16>& EE_T_K);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Adds a SetNEToEE command.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setEE
+   */
+  CommandBatch& setEE(
+      const std::array<double, 16>& NE_T_EE);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Adds a SetLoad command.
+   *
+   * @return This batch.
+   *
+   * @see Robot::setLoad
+   */
+  CommandBatch& setLoad(
+      double load_mass,
+      const std::array<double, 3>& F_x_Cload,  // NOLINT(readability-identifier-naming)
+      const std::array<double, 9>& load_inertia);
+
+  /**
+   * @return Number of commands in the batch.
+   */
+  size_t size() const noexcept;
+
+  /**
+   * Removes all commands.
+   */
+  void clear() noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  CommandBatch(const CommandBatch&) = delete;
+  CommandBatch& operator=(const CommandBatch&) = delete;
+
+  class Impl;
+  /// @endcond
+
+ private:
+  friend class Robot;
+
+  std::unique_ptr<Impl> impl_;
+};
+
 }  // namespace franka
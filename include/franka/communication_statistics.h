@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+#include <franka/control_statistics.h>
+
+/**
+ * @file communication_statistics.h
+ * Contains types for the statistics of the communication with the robot.
+ */
+
+namespace franka {
+
+/**
+ * Statistics of the robot states received in control and read loops since the statistics were
+ * last reset.
+ *
+ * Robot states are sent once per millisecond and numbered consecutively. States that are missing
+ * between two consecutive states of a loop, either lost on the network or skipped because the loop
+ * was too slow, are counted as lost.
+ *
+ * @see Robot::setCommunicationStatisticsEnabled
+ * @see Robot::communicationStatistics
+ */
+struct CommunicationStatistics {
+  /**
+   * Number of received robot states.
+   */
+  uint64_t received_states{};
+  /**
+   * Number of lost robot states.
+   */
+  uint64_t lost_states{};
+  /**
+   * Number of states lost in a row right before the latest received state.
+   */
+  uint64_t lost_in_a_row{};
+  /**
+   * Largest number of states lost in a row.
+   */
+  uint64_t max_lost_in_a_row{};
+  /**
+   * RobotState::control_command_success_rate of the latest received state.
+   */
+  double control_command_success_rate{};
+  /**
+   * Lowest RobotState::control_command_success_rate received while a motion was running, or 1 if
+   * no motion was running.
+   */
+  double min_control_command_success_rate{1.0};
+  /**
+   * Time from sending a robot command until the next robot state has been received, in
+   * microseconds.
+   */
+  LatencyStatistics round_trip{};
+};
+
+/**
+ * Callback for degraded communication, called with the statistics at the time of the event.
+ *
+ * @see Robot::setCommunicationStatisticsCallback
+ */
+using CommunicationStatisticsCallback = std::function<void(const CommunicationStatistics&)>;
+
+/**
+ * Streams the communication statistics as JSON object.
+ *
+ * @param[in] ostream Ostream instance
+ * @param[in] statistics CommunicationStatistics instance to stream
+ *
+ * @return Ostream instance
+ */
+std::ostream& operator<<(std::ostream& ostream, const CommunicationStatistics& statistics);
+
+}  // namespace franka
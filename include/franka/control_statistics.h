@@ -0,0 +1,123 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @file control_statistics.h
+ * Contains types for the timing statistics of control loops.
+ */
+
+namespace franka {
+
+/**
+ * Timing statistics of one stage of the control loop.
+ *
+ * All durations are given in microseconds.
+ */
+struct LatencyStatistics {
+  /**
+   * Shortest measured duration.
+   */
+  double min{};
+  /**
+   * Mean of all measured durations.
+   */
+  double mean{};
+  /**
+   * Median of the measured durations, with a resolution of one microsecond.
+   */
+  double p50{};
+  /**
+   * 99th percentile of the measured durations, with a resolution of one microsecond.
+   */
+  double p99{};
+  /**
+   * 99.9th percentile of the measured durations, with a resolution of one microsecond.
+   */
+  double p999{};
+  /**
+   * Longest measured duration.
+   */
+  double max{};
+  /**
+   * Number of measurements.
+   */
+  uint64_t count{};
+};
+
+/**
+ * Timing statistics of the control loops executed since the statistics were last reset.
+ *
+ * @see Robot::setControlStatisticsEnabled
+ * @see Robot::controlStatistics
+ */
+struct ControlStatistics {
+  /**
+   * Time spent waiting for and receiving a robot state.
+   */
+  LatencyStatistics receive_state{};
+  /**
+   * Time spent in the motion generator callback.
+   */
+  LatencyStatistics motion_callback{};
+  /**
+   * Time spent in the control callback.
+   */
+  LatencyStatistics control_callback{};
+  /**
+   * Time spent filtering, rate limiting and checking motion generator commands.
+   */
+  LatencyStatistics motion_command_processing{};
+  /**
+   * Time spent filtering, rate limiting and checking control commands.
+   */
+  LatencyStatistics control_command_processing{};
+  /**
+   * Time spent sending the robot command.
+   */
+  LatencyStatistics send_command{};
+  /**
+   * Time from receiving a robot state until the corresponding command has been sent.
+   */
+  LatencyStatistics cycle{};
+  /**
+   * Time from the kernel receiving a robot state until the library has read it from the socket,
+   * which includes the wake-up latency of the control thread. Only measured on platforms that
+   * report kernel receive timestamps.
+   */
+  LatencyStatistics receive_wakeup{};
+  /**
+   * Time from the kernel receiving a robot state until the corresponding command has been sent.
+   * Only measured on platforms that report kernel receive timestamps.
+   */
+  LatencyStatistics network_cycle{};
+  /**
+   * Number of cycles in which the command was sent more than 1 ms after the state was received.
+   */
+  uint64_t deadline_misses{};
+};
+
+/**
+ * Streams the latency statistics as JSON object.
+ *
+ * @param[in] ostream Ostream instance
+ * @param[in] statistics LatencyStatistics instance to stream
+ *
+ * @return Ostream instance
+ */
+std::ostream& operator<<(std::ostream& ostream, const LatencyStatistics& statistics);
+
+/**
+ * Streams the control statistics as JSON object.
+ *
+ * @param[in] ostream Ostream instance
+ * @param[in] statistics ControlStatistics instance to stream
+ *
+ * @return Ostream instance
+ */
+std::ostream& operator<<(std::ostream& ostream, const ControlStatistics& statistics);
+
+}  // namespace franka
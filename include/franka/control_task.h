@@ -0,0 +1,480 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "franka/control_task.h requires a compiler with C++20 coroutine support."
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file control_task.h
+ * Contains the C++20 coroutine interface for control loops: franka::ControlTask,
+ * franka::ControlPhase and franka::ControlArena.
+ *
+ * The library itself is built with C++14. This header is optional and can only be included from
+ * code compiled with C++20.
+ */
+
+namespace franka {
+
+/**
+ * Preallocated memory for the frames of franka::ControlTask and franka::ControlPhase coroutines.
+ *
+ * Frames are allocated in a stack-like fashion. A frame that is freed while it is the top of the
+ * stack returns its memory immediately; this is the case for phases, which always finish before the
+ * task or phase that awaits them. Other freed memory is reused after reset().
+ */
+class ControlArena {
+ public:
+  /**
+   * Alignment of all allocations.
+   */
+  static constexpr size_t kAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+  /**
+   * Allocates the memory of the arena.
+   *
+   * @param[in] capacity Size of the arena. Unit: \f$[bytes]\f$.
+   */
+  explicit ControlArena(size_t capacity)
+      : buffer_(std::make_unique<std::byte[]>(capacity)), capacity_(capacity) {}
+
+  /// @cond DO_NOT_DOCUMENT
+  ControlArena(const ControlArena&) = delete;
+  ControlArena& operator=(const ControlArena&) = delete;
+  /// @endcond
+
+  /**
+   * Allocates memory from the arena. Does not allocate from the heap.
+   *
+   * @param[in] size Number of bytes.
+   *
+   * @return Memory aligned to kAlignment.
+   *
+   * @throw std::bad_alloc if the arena is exhausted.
+   */
+  void* allocate(size_t size) {
+    size = roundUp(size);
+    if (size > capacity_ - used_) {
+      throw std::bad_alloc();
+    }
+    void* memory = buffer_.get() + used_;
+    used_ += size;
+    return memory;
+  }
+
+  /**
+   * Frees memory allocated with allocate().
+   *
+   * @param[in] memory Memory returned by allocate().
+   * @param[in] size Size passed to allocate().
+   */
+  void deallocate(void* memory, size_t size) noexcept {
+    size = roundUp(size);
+    if (static_cast<std::byte*>(memory) + size == buffer_.get() + used_) {
+      used_ -= size;
+    }
+  }
+
+  /**
+   * Frees all memory. No frame allocated from the arena may be alive anymore.
+   */
+  void reset() noexcept { used_ = 0; }
+
+  /**
+   * @return Number of bytes in use.
+   */
+  size_t used() const noexcept { return used_; }
+
+  /**
+   * @return Size of the arena.
+   */
+  size_t capacity() const noexcept { return capacity_; }
+
+ private:
+  static size_t roundUp(size_t size) noexcept {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  std::unique_ptr<std::byte[]> buffer_;
+  size_t capacity_;
+  size_t used_ = 0;
+};
+
+/**
+ * Tag to get the current robot state in a franka::ControlTask or franka::ControlPhase without
+ * waiting for the next cycle:
+ *
+ * @code{.cpp}
+ * const franka::RobotState& robot_state = co_await franka::kCurrentRobotState;
+ * @endcode
+ */
+struct CurrentRobotState {};
+
+/**
+ * Instance of franka::CurrentRobotState.
+ */
+inline constexpr CurrentRobotState kCurrentRobotState{};
+
+template <typename T>
+class ControlPhase;
+
+/// @cond DO_NOT_DOCUMENT
+namespace detail {
+
+// Arena of the task that is currently resumed on this thread. Phases started by the task allocate
+// their frames from it.
+inline thread_local ControlArena* current_control_arena = nullptr;
+
+struct alignas(ControlArena::kAlignment) ControlFrameHeader {
+  ControlArena* arena;
+};
+
+inline void* allocateControlFrame(size_t size, ControlArena* arena) {
+  size_t total_size = size + sizeof(ControlFrameHeader);
+  void* memory = arena != nullptr ? arena->allocate(total_size) : ::operator new(total_size);
+  return new (memory) ControlFrameHeader{arena} + 1;
+}
+
+inline void deallocateControlFrame(void* frame, size_t size) noexcept {
+  ControlFrameHeader* header = static_cast<ControlFrameHeader*>(frame) - 1;
+  size_t total_size = size + sizeof(ControlFrameHeader);
+  if (header->arena != nullptr) {
+    header->arena->deallocate(header, total_size);
+  } else {
+    ::operator delete(header, total_size);
+  }
+}
+
+// State shared by a task and all phases it awaits.
+template <typename T>
+struct ControlContext {
+  const RobotState* robot_state = nullptr;
+  std::optional<T> command;
+  // Innermost coroutine, which is resumed in the next cycle.
+  std::coroutine_handle<> current;
+};
+
+template <typename T>
+class ControlPromiseBase {
+ public:
+  ControlPromiseBase() noexcept : arena_(current_control_arena) {}
+
+  template <typename... Args>
+  explicit ControlPromiseBase(ControlArena& arena, Args&... /* args */) noexcept
+      : arena_(&arena) {}
+
+  static void* operator new(size_t size) {
+    return allocateControlFrame(size, current_control_arena);
+  }
+
+  template <typename... Args>
+  static void* operator new(size_t size, ControlArena& arena, Args&... /* args */) {
+    return allocateControlFrame(size, &arena);
+  }
+
+  static void operator delete(void* frame, size_t size) noexcept {
+    deallocateControlFrame(frame, size);
+  }
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  // Stores the command for the current cycle and resumes with the robot state of the next cycle.
+  auto yield_value(T command) noexcept {
+    context_->command = std::move(command);
+    struct Awaiter : std::suspend_always {
+      const RobotState& await_resume() const noexcept { return *context->robot_state; }
+      ControlContext<T>* context;
+    };
+    return Awaiter{{}, context_};
+  }
+
+  auto await_transform(CurrentRobotState /* tag */) noexcept {
+    struct Awaiter : std::suspend_never {
+      const RobotState& await_resume() const noexcept { return *context->robot_state; }
+      ControlContext<T>* context;
+    };
+    return Awaiter{{}, context_};
+  }
+
+  auto await_transform(ControlPhase<T>&& phase) noexcept {
+    phase.handle_.promise().start(context_);
+    return typename ControlPhase<T>::Awaiter{std::move(phase)};
+  }
+
+  ControlArena* arena() const noexcept { return arena_; }
+
+  ControlContext<T>* context() const noexcept { return context_; }
+
+ protected:
+  ControlArena* arena_;
+  ControlContext<T>* context_ = nullptr;
+};
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * Part of a franka::ControlTask, written as a coroutine that can be awaited by a task or by
+ * another phase.
+ *
+ * A phase yields commands like a task, and returns to the awaiting coroutine in the same cycle when
+ * it finishes:
+ *
+ * @code{.cpp}
+ * franka::ControlPhase<franka::Torques> hold(const std::array<double, 7>& q_d, int cycles) {
+ *   const franka::RobotState* robot_state = &co_await franka::kCurrentRobotState;
+ *   for (int i = 0; i < cycles; i++) {
+ *     robot_state = &(co_yield impedanceTorques(*robot_state, q_d));
+ *   }
+ * }
+ * @endcode
+ *
+ * Phases started while a task is running allocate their frames from the arena of the task.
+ *
+ * @tparam T Command type, see franka::ControlTask.
+ */
+template <typename T>
+class ControlPhase {
+ public:
+  /// @cond DO_NOT_DOCUMENT
+  class promise_type : public detail::ControlPromiseBase<T> {
+   public:
+    using detail::ControlPromiseBase<T>::ControlPromiseBase;
+
+    ControlPhase get_return_object() noexcept {
+      return ControlPhase(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    // Continues the awaiting coroutine in the same cycle.
+    auto final_suspend() noexcept {
+      struct Awaiter : std::suspend_always {
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+          promise_type& promise = handle.promise();
+          promise.context()->current = promise.parent_;
+          return promise.parent_;
+        }
+      };
+      return Awaiter{};
+    }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    void start(detail::ControlContext<T>* context) noexcept { this->context_ = context; }
+
+   private:
+    friend class ControlPhase;
+
+    std::coroutine_handle<> parent_;
+    std::exception_ptr exception_;
+  };
+  /// @endcond
+
+  /**
+   * Moves a phase.
+   *
+   * @param[in] other Phase to move from.
+   */
+  ControlPhase(ControlPhase&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  /**
+   * Destroys the coroutine of the phase.
+   */
+  ~ControlPhase() noexcept {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  /// @cond DO_NOT_DOCUMENT
+  ControlPhase(const ControlPhase&) = delete;
+  ControlPhase& operator=(const ControlPhase&) = delete;
+  ControlPhase& operator=(ControlPhase&&) = delete;
+  /// @endcond
+
+ private:
+  friend class detail::ControlPromiseBase<T>;
+
+  explicit ControlPhase(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+  // Starts the phase in the same cycle and resumes the awaiting coroutine once it has finished.
+  struct Awaiter {
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept {
+      promise_type& promise = phase.handle_.promise();
+      promise.parent_ = parent;
+      promise.context()->current = phase.handle_;
+      return phase.handle_;
+    }
+
+    void await_resume() const {
+      if (phase.handle_.promise().exception_) {
+        std::rethrow_exception(phase.handle_.promise().exception_);
+      }
+    }
+
+    ControlPhase phase;
+  };
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * Control or motion generator callback written as a coroutine.
+ *
+ * Tasks with several phases, e.g. approach, contact, exploration and retract, otherwise need
+ * either several calls to Robot::control(), which stop the robot in between, or a hand-written
+ * state machine in the callback. A task instead describes the phases sequentially, while all of
+ * them run in a single control loop:
+ *
+ * @code{.cpp}
+ * franka::ControlTask<franka::Torques> task(franka::ControlArena&, const franka::Model& model) {
+ *   const franka::RobotState* robot_state = &co_await franka::kCurrentRobotState;
+ *   while (!inContact(*robot_state)) {
+ *     robot_state = &(co_yield approachTorques(*robot_state, model));
+ *   }
+ *   co_await hold(robot_state->q, 1000);  // franka::ControlPhase
+ *   co_return franka::Torques({0, 0, 0, 0, 0, 0, 0});
+ * }
+ *
+ * franka::ControlArena arena(64 * 1024);
+ * franka::ControlTask<franka::Torques> control_task = task(arena, model);
+ * robot.control(control_task);
+ * @endcode
+ *
+ * Every `co_yield` hands a command to the control loop and resumes with the robot state of the
+ * next cycle. The returned reference is valid until the next `co_yield`. The value of `co_return`
+ * is the last command, with franka::Finishable::motion_finished set. Time can be measured with
+ * RobotState::time.
+ *
+ * The control loop calls the task once per cycle. Resuming a coroutine neither allocates nor
+ * starts a thread. If the task function takes a franka::ControlArena as its first parameter, the
+ * frames of the task and of all phases it starts are allocated from the arena instead of the heap.
+ *
+ * A task can be used by only one control loop, and only once.
+ *
+ * @tparam T Command type: franka::Torques, franka::JointPositions, franka::JointVelocities,
+ * franka::CartesianPose or franka::CartesianVelocities.
+ */
+template <typename T>
+class ControlTask {
+ public:
+  /// @cond DO_NOT_DOCUMENT
+  class promise_type : public detail::ControlPromiseBase<T> {
+   public:
+    using detail::ControlPromiseBase<T>::ControlPromiseBase;
+
+    ControlTask get_return_object() noexcept {
+      this->context_ = &state_;
+      return ControlTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    void return_value(T command) noexcept { state_.command = MotionFinished(std::move(command)); }
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+   private:
+    friend class ControlTask;
+
+    detail::ControlContext<T> state_;
+    std::exception_ptr exception_;
+  };
+  /// @endcond
+
+  /**
+   * Moves a task.
+   *
+   * @param[in] other Task to move from.
+   */
+  ControlTask(ControlTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  /**
+   * Destroys the coroutine of the task and of all phases it awaits.
+   */
+  ~ControlTask() noexcept {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  /// @cond DO_NOT_DOCUMENT
+  ControlTask(const ControlTask&) = delete;
+  ControlTask& operator=(const ControlTask&) = delete;
+  ControlTask& operator=(ControlTask&&) = delete;
+  /// @endcond
+
+  /**
+   * Runs the task until it yields the command for the given robot state. Called by the control
+   * loop.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] period Time since the previous cycle. Not used.
+   *
+   * @return Command for the current cycle.
+   *
+   * @throw std::logic_error if the task has already finished or has been moved from.
+   * @throw Any exception thrown by the task or its phases.
+   */
+  T operator()(const RobotState& robot_state, Duration /* period */) {
+    if (!handle_ || handle_.done()) {
+      throw std::logic_error("libfranka: Control task has already finished.");
+    }
+    promise_type& promise = handle_.promise();
+    detail::ControlContext<T>& context = promise.state_;
+    if (!context.current) {
+      context.current = handle_;
+    }
+    context.robot_state = &robot_state;
+
+    ArenaScope arena_scope(promise.arena());
+    context.current.resume();
+    if (promise.exception_) {
+      std::rethrow_exception(std::exchange(promise.exception_, nullptr));
+    }
+    if (!context.command) {
+      throw std::logic_error("libfranka: Control task finished without a command.");
+    }
+    return *context.command;
+  }
+
+  /**
+   * @return True if the task has returned its last command.
+   */
+  bool done() const noexcept { return !handle_ || handle_.done(); }
+
+ private:
+  // Makes phases started by the task allocate from the arena of the task.
+  class ArenaScope {
+   public:
+    explicit ArenaScope(ControlArena* arena) noexcept
+        : previous_(std::exchange(detail::current_control_arena, arena)) {}
+    ~ArenaScope() noexcept { detail::current_control_arena = previous_; }
+
+   private:
+    ControlArena* previous_;
+  };
+
+  explicit ControlTask(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+}  // namespace franka
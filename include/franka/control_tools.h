@@ -5,6 +5,9 @@
 #include <array>
 #include <cmath>
 #include <string>
+#include <vector>
+
+#include <franka/control_types.h>
 
 /**
  * @file control_tools.h
@@ -24,6 +27,25 @@ inline bool isValidElbow(const std::array<double, 2>& elbow) noexcept {
   return elbow[1] == -1.0 || elbow[1] == 1.0;
 }
 
+/**
+ * Determines whether the sum of the given values is finite.
+ *
+ * Infinite and NaN values propagate into the sum, so this is a check for finite values that needs
+ * only a single branch. Finite values whose sum overflows are rejected as well.
+ *
+ * @param[in] values Values to check.
+ *
+ * @return True if the sum of values is finite, otherwise false.
+ */
+template <size_t N>
+inline bool hasFiniteSum(const std::array<double, N>& values) noexcept {
+  double sum = 0.0;
+  for (double value : values) {
+    sum += value;
+  }
+  return std::isfinite(sum);
+}
+
 /**
  * Determines whether the given array represents a valid homogeneous transformation matrix.
  *
@@ -64,6 +86,19 @@ inline bool isHomogeneousTransformation(const std::array<double, 16>& transform)
  */
 bool hasRealtimeKernel();
 
+/**
+ * Lists the CPUs that are isolated from the scheduler, e.g. with the `isolcpus` kernel parameter.
+ *
+ * Threads only run on isolated CPUs if they are pinned to them, so they are suited for control loop
+ * threads and their helpers, see RealtimeOptions::cpu_affinity.
+ *
+ * On Linux, this reads `/sys/devices/system/cpu/isolated`.
+ * On Windows, this always returns an empty list.
+ *
+ * @return Isolated CPUs in ascending order, or an empty list if there are none.
+ */
+std::vector<int> isolatedCpus();
+
 /**
  * Sets the current thread to the highest possible scheduler priority.
  *
@@ -74,4 +109,43 @@ bool hasRealtimeKernel();
  */
 bool setCurrentThreadToHighestSchedulerPriority(std::string* error_message);
 
+/**
+ * Reports which of the requested franka::RealtimeOptions have been applied successfully.
+ *
+ * Measures that were not requested are reported as not applied.
+ */
+struct RealtimeOptionsResult {
+  /**
+   * True if the current thread has been pinned to the requested CPUs.
+   */
+  bool cpu_affinity_set{false};
+  /**
+   * True if the process memory has been locked.
+   */
+  bool memory_locked{false};
+  /**
+   * True if the requested amount of stack has been prefaulted.
+   */
+  bool stack_prefaulted{false};
+  /**
+   * True if the requested amount of heap has been prefaulted.
+   */
+  bool heap_prefaulted{false};
+};
+
+/**
+ * Applies the given realtime options to the current thread and process.
+ *
+ * All requested measures are attempted, even if one of them fails.
+ *
+ * @param[in] options Measures to apply.
+ * @param[out] result If given, reports which measures have been applied.
+ * @param[out] error_message Contains an error message for every measure that failed.
+ *
+ * @return True if all requested measures have been applied, false otherwise.
+ */
+bool applyRealtimeOptions(const RealtimeOptions& options,
+                          RealtimeOptionsResult* result,
+                          std::string* error_message);
+
 }  // namespace franka
@@ -4,7 +4,9 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <initializer_list>
+#include <vector>
 
 /**
  * @file control_types.h
@@ -25,6 +27,54 @@ enum class ControllerMode { kJointImpedance, kCartesianImpedance };
  */
 enum class RealtimeConfig { kEnforce, kIgnore };
 
+/**
+ * Used to decide how thoroughly a control loop validates the commands it sends.
+ *
+ * With ValidationPolicy::kFull, every element of a command is checked to be finite, homogeneous
+ * transformations and elbow configurations are checked for validity, and the command filters check
+ * their inputs. With ValidationPolicy::kChecksum, the control loop only checks that the sum of each
+ * sent command is finite. Infinite and NaN values propagate through filtering, rate limiting and
+ * the sum, so such commands are still rejected before they are sent; invalid transformations and
+ * elbow configurations are left to the robot to reject.
+ *
+ * @see Robot::setValidationPolicy
+ */
+enum class ValidationPolicy { kFull, kChecksum };
+
+/**
+ * Additional realtime measures applied to the control loop thread before a control loop starts.
+ *
+ * If RealtimeConfig::kEnforce is used, a failure to apply any of the requested measures results in
+ * a RealtimeException.
+ *
+ * @see Robot::Robot
+ * @see applyRealtimeOptions
+ */
+struct RealtimeOptions {
+  /**
+   * CPUs the control loop thread is pinned to. If empty, the affinity is not changed.
+   */
+  std::vector<int> cpu_affinity{};
+  /**
+   * Lock all current and future pages of the process into memory using `mlockall`.
+   */
+  bool lock_memory{false};
+  /**
+   * Number of bytes of stack to touch before the control loop starts, so that later page faults
+   * on the stack are avoided. Must fit into the stack of the control thread, leaving 64 KiB
+   * untouched; larger sizes are not prefaulted and reported as a failure. Requires glibc. 0
+   * disables stack prefaulting.
+   */
+  size_t prefault_stack_size{0};
+  /**
+   * Number of bytes of heap to allocate and touch before the control loop starts. On glibc, the
+   * memory is kept by the allocator after it is freed: the first heap prefault disables trimming
+   * the heap and serving large allocations with mmap for the rest of the process, including its
+   * other threads. 0 disables heap prefaulting.
+   */
+  size_t prefault_heap_size{0};
+};
+
 /**
  * Helper type for control and motion generation loops.
  *
@@ -0,0 +1,395 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file controller_plugin.h
+ * Contains the franka::PluginController type to load controllers from shared libraries and to
+ * replace them while the control loop is running, and the C interface implemented by such
+ * controller plugins.
+ */
+
+/**
+ * Version of the FrankaControllerPlugin interface. Plugins built for another version are rejected.
+ */
+#define FRANKA_CONTROLLER_PLUGIN_API_VERSION 1
+
+/**
+ * Name of the entry point of a controller plugin, see FrankaControllerPluginEntry.
+ */
+#define FRANKA_CONTROLLER_PLUGIN_ENTRY "franka_controller_plugin"
+
+#if defined(_WIN32)
+#define FRANKA_CONTROLLER_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define FRANKA_CONTROLLER_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+extern "C" {
+
+/**
+ * Functions of a controller plugin.
+ *
+ * The robot state is passed as a pointer to a franka::RobotState, so a plugin must be built
+ * against the same `libfranka` headers as the application loading it; the state size is checked
+ * when the plugin is loaded. Functions must not throw.
+ */
+struct FrankaControllerPlugin {
+  /**
+   * Must be FRANKA_CONTROLLER_PLUGIN_API_VERSION.
+   */
+  uint32_t api_version;
+  /**
+   * Must be `sizeof(franka::RobotState)`.
+   */
+  uint32_t robot_state_size;
+  /**
+   * Number of output values: 7 for franka::Torques, franka::JointPositions and
+   * franka::JointVelocities, 16 for franka::CartesianPose and 6 for franka::CartesianVelocities.
+   */
+  uint32_t output_size;
+  /**
+   * Creates a controller from a parameter string. Called when the plugin is loaded, outside of the
+   * control loop. Returns null on error.
+   */
+  void* (*create)(const char* parameters);
+  /**
+   * Destroys a controller created by create(). Called outside of the control loop.
+   */
+  void (*destroy)(void* controller);
+  /**
+   * Called in the first cycle of a controller with a `const franka::RobotState*`, before update().
+   * Returns a negative value on error.
+   */
+  int (*start)(void* controller, const void* robot_state);
+  /**
+   * Computes the output values of one cycle from a `const franka::RobotState*` and the time since
+   * the previous cycle in \f$[ms]\f$. Returns 1 to finish the motion, 0 to continue and a negative
+   * value on error.
+   */
+  int (*update)(void* controller, const void* robot_state, uint64_t period, double* output);
+};
+
+/**
+ * Entry point exported by a controller plugin under the name FRANKA_CONTROLLER_PLUGIN_ENTRY. The
+ * returned functions must stay valid until the plugin is unloaded.
+ */
+typedef const FrankaControllerPlugin* (*FrankaControllerPluginEntry)();
+
+}  // extern "C"
+
+/**
+ * Exports a C++ controller class as controller plugin.
+ *
+ * The class is constructed from the parameter string and provides
+ * `void start(const franka::RobotState&)` and
+ * `Output update(const franka::RobotState&, franka::Duration)`. Exceptions are reported to the
+ * loading application as franka::PluginException.
+ *
+ * The functions exported to the application have internal linkage, and plugins are loaded with
+ * local symbol binding, so a rebuilt and reloaded plugin never runs code of the library it
+ * replaces.
+ *
+ * @code{.cpp}
+ * class Wall {
+ *  public:
+ *   explicit Wall(const std::string& parameters);
+ *   void start(const franka::RobotState& robot_state);
+ *   franka::Torques update(const franka::RobotState& robot_state, franka::Duration period);
+ * };
+ * FRANKA_CONTROLLER_PLUGIN(Wall, franka::Torques)
+ * @endcode
+ */
+#define FRANKA_CONTROLLER_PLUGIN(Controller, Output)                                         \
+  namespace {                                                                                \
+  struct FrankaControllerPluginTag {};                                                       \
+  }                                                                                          \
+  extern "C" FRANKA_CONTROLLER_PLUGIN_EXPORT const FrankaControllerPlugin*                   \
+  franka_controller_plugin() { /* NOLINT(readability-identifier-naming) */                   \
+    return ::franka::detail::ControllerPluginAdapter<Controller, Output,                     \
+                                                     FrankaControllerPluginTag>::plugin();   \
+  }
+
+namespace franka {
+
+namespace detail {
+
+template <typename T>
+struct PluginOutput;
+
+template <>
+struct PluginOutput<Torques> {
+  static const std::array<double, 7>& values(const Torques& output) { return output.tau_J; }
+};
+
+template <>
+struct PluginOutput<JointPositions> {
+  static const std::array<double, 7>& values(const JointPositions& output) { return output.q; }
+};
+
+template <>
+struct PluginOutput<JointVelocities> {
+  static const std::array<double, 7>& values(const JointVelocities& output) { return output.dq; }
+};
+
+template <>
+struct PluginOutput<CartesianPose> {
+  static const std::array<double, 16>& values(const CartesianPose& output) {
+    return output.O_T_EE;
+  }
+};
+
+template <>
+struct PluginOutput<CartesianVelocities> {
+  static const std::array<double, 6>& values(const CartesianVelocities& output) {
+    return output.O_dP_EE;
+  }
+};
+
+template <typename T>
+constexpr size_t pluginOutputSize() {
+  return std::tuple_size<
+      typename std::decay<decltype(PluginOutput<T>::values(std::declval<T>()))>::type>::value;
+}
+
+// The tag is local to the plugin library, which gives the functions and the table internal linkage.
+template <typename Controller, typename T, typename Tag = void>
+struct ControllerPluginAdapter {
+  static void* create(const char* parameters) noexcept try {
+    return new Controller(std::string(parameters));
+  } catch (...) {
+    return nullptr;
+  }
+
+  static void destroy(void* controller) noexcept { delete static_cast<Controller*>(controller); }
+
+  static int start(void* controller, const void* robot_state) noexcept try {
+    static_cast<Controller*>(controller)->start(*static_cast<const RobotState*>(robot_state));
+    return 0;
+  } catch (...) {
+    return -1;
+  }
+
+  static int update(void* controller,
+                    const void* robot_state,
+                    uint64_t period,
+                    double* output) noexcept try {
+    T command = static_cast<Controller*>(controller)->update(
+        *static_cast<const RobotState*>(robot_state), Duration(period));
+    const auto& values = PluginOutput<T>::values(command);
+    std::copy(values.begin(), values.end(), output);
+    return command.motion_finished ? 1 : 0;
+  } catch (...) {
+    return -1;
+  }
+
+  static const FrankaControllerPlugin* plugin() noexcept {
+    static const FrankaControllerPlugin kPlugin{
+        FRANKA_CONTROLLER_PLUGIN_API_VERSION, static_cast<uint32_t>(sizeof(RobotState)),
+        static_cast<uint32_t>(pluginOutputSize<T>()), &create, &destroy, &start, &update};
+    return &kPlugin;
+  }
+};
+
+}  // namespace detail
+
+/**
+ * Controller loaded from a controller plugin.
+ *
+ * The shared library is copied to a temporary file before it is loaded, so that a rebuilt plugin
+ * at the same path is loaded as new library instead of returning the already loaded one.
+ */
+class ControllerPlugin {
+ public:
+  /**
+   * Loads a plugin and creates its controller.
+   *
+   * @param[in] path Path of the shared library.
+   * @param[in] parameters Parameter string passed to the controller.
+   * @param[in] output_size Expected number of output values.
+   *
+   * @throw PluginException if the library cannot be loaded, does not export the entry point, was
+   * built for another interface version, robot state or output, or cannot create the controller.
+   */
+  ControllerPlugin(const std::string& path, const std::string& parameters, size_t output_size);
+
+  /**
+   * Destroys the controller and unloads the plugin.
+   */
+  ~ControllerPlugin() noexcept;
+
+  ControllerPlugin(const ControllerPlugin&) = delete;
+  ControllerPlugin& operator=(const ControllerPlugin&) = delete;
+
+  /**
+   * @return Path the plugin was loaded from.
+   */
+  const std::string& path() const noexcept;
+
+  /**
+   * Calls the start function of the controller.
+   *
+   * @param[in] robot_state Current state of the robot.
+   *
+   * @throw PluginException if the controller reports an error.
+   */
+  void start(const RobotState& robot_state);
+
+  /**
+   * Computes the output values of one cycle.
+   *
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] period Time since the previous cycle.
+   * @param[out] output Storage for the output values.
+   *
+   * @return True if the controller finished the motion.
+   *
+   * @throw PluginException if the controller reports an error.
+   */
+  bool update(const RobotState& robot_state, Duration period, double* output);
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Callback that runs a controller plugin and replaces it with another one while the control loop
+ * is running, e.g. to tune a haptic renderer on a live cell without restarting the process and
+ * homing the robot again.
+ *
+ * @code{.cpp}
+ * franka::PluginController<franka::Torques> controller("./libwall.so", "stiffness=2000");
+ * std::thread tuning([&] {
+ *   waitForRebuild();
+ *   controller.load("./libwall.so", "stiffness=2500");
+ * });
+ * robot.control(controller);
+ * @endcode
+ *
+ * load() loads the library and creates the controller on the calling thread, so the control loop
+ * thread does not block on file access or allocations. The new controller takes over at the
+ * beginning of the next cycle and its start function is called in that cycle with the current
+ * robot state, as with franka::ControllerSwitch. The replaced controller is destroyed and its
+ * library unloaded by the next call to load() or by the destructor.
+ *
+ * The start function of the active controller is also called in the first cycle of every control
+ * loop. The callback is passed to Robot::control() by reference and may only be used by one
+ * control loop at a time.
+ *
+ * @tparam T Output type: franka::Torques, franka::JointPositions, franka::JointVelocities,
+ * franka::CartesianPose or franka::CartesianVelocities.
+ */
+template <typename T>
+class PluginController {
+ public:
+  /**
+   * Loads the initial controller.
+   *
+   * @param[in] path Path of the plugin library.
+   * @param[in] parameters Parameter string passed to the controller.
+   *
+   * @throw PluginException if the plugin cannot be loaded.
+   */
+  explicit PluginController(const std::string& path, const std::string& parameters = "")
+      : active_(new ControllerPlugin(path, parameters, detail::pluginOutputSize<T>())) {}
+
+  /**
+   * Destroys all loaded controllers. Must not be called while a control loop uses the callback.
+   */
+  ~PluginController() noexcept {
+    delete pending_.load();
+    delete retired_.load();
+    delete active_;
+  }
+
+  PluginController(const PluginController&) = delete;
+  PluginController& operator=(const PluginController&) = delete;
+
+  /**
+   * Loads a controller that replaces the active one in the next cycle. Blocks while loading, but
+   * not the control loop. A controller that has been loaded before, but has not taken over yet, is
+   * discarded.
+   *
+   * @param[in] path Path of the plugin library.
+   * @param[in] parameters Parameter string passed to the controller.
+   *
+   * @throw PluginException if the plugin cannot be loaded. The active controller keeps running.
+   */
+  void load(const std::string& path, const std::string& parameters = "") {
+    std::unique_ptr<ControllerPlugin> plugin(
+        new ControllerPlugin(path, parameters, detail::pluginOutputSize<T>()));
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    delete retired_.exchange(nullptr, std::memory_order_acq_rel);
+    delete pending_.exchange(plugin.release(), std::memory_order_acq_rel);
+  }
+
+  /**
+   * @return True if a loaded controller has not taken over yet.
+   */
+  bool swapPending() const noexcept { return pending_.load(std::memory_order_acquire) != nullptr; }
+
+  /**
+   * @return Number of times a loaded controller has taken over.
+   */
+  uint64_t swaps() const noexcept { return swaps_.load(std::memory_order_acquire); }
+
+  /**
+   * Computes the output of the active controller. Called by the control loop.
+   *
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] period Time since the previous cycle.
+   *
+   * @return Output of the active controller.
+   *
+   * @throw PluginException if the controller reports an error.
+   */
+  T operator()(const RobotState& robot_state, Duration period) {
+    // The replaced controller is handed over to load() for destruction, so a swap waits until the
+    // previous one has been collected.
+    if (retired_.load(std::memory_order_acquire) == nullptr) {
+      ControllerPlugin* next = pending_.exchange(nullptr, std::memory_order_acq_rel);
+      if (next != nullptr) {
+        retired_.store(active_, std::memory_order_release);
+        active_ = next;
+        started_ = false;
+        swaps_.fetch_add(1, std::memory_order_release);
+      }
+    }
+    if (!started_ || period == Duration()) {
+      active_->start(robot_state);
+      started_ = true;
+    }
+    std::array<double, detail::pluginOutputSize<T>()> values;
+    bool finished = active_->update(robot_state, period, values.data());
+    T output(values);
+    output.motion_finished = finished;
+    return output;
+  }
+
+ private:
+  ControllerPlugin* active_;
+  bool started_{false};
+  std::atomic<ControllerPlugin*> pending_{nullptr};
+  std::atomic<ControllerPlugin*> retired_{nullptr};
+  std::atomic<uint64_t> swaps_{0};
+  std::mutex load_mutex_;
+};
+
+}  // namespace franka
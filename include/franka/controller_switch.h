@@ -0,0 +1,159 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file controller_switch.h
+ * Contains the franka::ControllerSwitch type.
+ */
+
+namespace franka {
+
+/**
+ * Callback that forwards every cycle to one of several registered callbacks and switches between
+ * them while the control loop is running.
+ *
+ * Every call to Robot::control() starts a new motion on the robot and waits for the robot to stop
+ * when the motion finishes, so chaining controllers with repeated calls pauses the robot in
+ * between. A switch instead runs all controllers in a single control loop:
+ *
+ * @code{.cpp}
+ * franka::ControllerSwitch<franka::Torques> controllers;
+ * size_t free_space = controllers.add(impedance_callback);
+ * size_t contact = controllers.add(force_callback, [&](const franka::RobotState&) {
+ *   force_controller.resetIntegrator();
+ * });
+ * std::thread supervisor([&] {
+ *   waitForContact();
+ *   controllers.select(contact);
+ * });
+ * robot.control(controllers);
+ * @endcode
+ *
+ * select() may be called from any thread, including from within a callback. The switch takes
+ * effect at the beginning of the next cycle, so the previous controller computes the command of
+ * the current cycle and the next one takes over in the following cycle; no cycle is lost. The
+ * commands of both controllers are still subject to the rate limiting and filtering of the
+ * control loop, which smooths the transition.
+ *
+ * An optional activation callback is called in the first cycle of a controller with the same
+ * robot state, e.g. to take over the current pose as equilibrium. The first registered controller
+ * is active by default, and the activation callback of the selected controller is called again in
+ * the first cycle of every control loop.
+ *
+ * The output type is the same for all controllers, so a switch either holds torque controllers or
+ * motion generators of one type. The switch is passed to Robot::control() by reference and may
+ * only be used by one control loop at a time. Controllers have to be added before it is used.
+ *
+ * @tparam T Output type: franka::Torques, franka::JointPositions, franka::JointVelocities,
+ * franka::CartesianPose or franka::CartesianVelocities.
+ */
+template <typename T>
+class ControllerSwitch {
+ public:
+  /**
+   * Computes the output of a controller for one cycle.
+   */
+  using Callback = std::function<T(const RobotState&, Duration)>;
+
+  /**
+   * Called once in the first cycle of a controller, before its Callback.
+   */
+  using ActivationCallback = std::function<void(const RobotState&)>;
+
+  /**
+   * Registers a controller. Must not be called while the switch is used by a control loop.
+   *
+   * @param[in] callback Controller callback.
+   * @param[in] activation_callback Optional callback called when the controller becomes active.
+   *
+   * @return Index of the controller, which is passed to select().
+   *
+   * @throw std::invalid_argument if callback is empty.
+   */
+  size_t add(Callback callback, ActivationCallback activation_callback = {}) {
+    if (!callback) {
+      throw std::invalid_argument("libfranka: Invalid controller callback given.");
+    }
+    controllers_.push_back({std::move(callback), std::move(activation_callback)});
+    return controllers_.size() - 1;
+  }
+
+  /**
+   * Requests a switch to the given controller, starting with the next cycle. Does not block and
+   * does not allocate.
+   *
+   * @param[in] index Index returned by add().
+   *
+   * @throw std::invalid_argument if no controller with the given index has been added.
+   */
+  void select(size_t index) {
+    if (index >= controllers_.size()) {
+      throw std::invalid_argument("libfranka: Invalid controller index given.");
+    }
+    selected_.store(index, std::memory_order_release);
+  }
+
+  /**
+   * @return Index of the controller that computes the next command.
+   */
+  size_t selected() const noexcept { return selected_.load(std::memory_order_acquire); }
+
+  /**
+   * @return Index of the controller that computed the last command.
+   */
+  size_t active() const noexcept { return active_.load(std::memory_order_acquire); }
+
+  /**
+   * @return Number of registered controllers.
+   */
+  size_t size() const noexcept { return controllers_.size(); }
+
+  /**
+   * Computes the output of the selected controller. Called by the control loop.
+   *
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] period Time since the previous cycle.
+   *
+   * @return Output of the selected controller.
+   *
+   * @throw std::invalid_argument if no controller has been added.
+   */
+  T operator()(const RobotState& robot_state, Duration period) {
+    if (controllers_.empty()) {
+      throw std::invalid_argument("libfranka: No controller added to the controller switch.");
+    }
+    size_t index = selected_.load(std::memory_order_acquire);
+    Controller& controller = controllers_[index];
+    if (index != active_.load(std::memory_order_relaxed) || period == Duration()) {
+      if (controller.activation_callback) {
+        controller.activation_callback(robot_state);
+      }
+      active_.store(index, std::memory_order_release);
+    }
+    return controller.callback(robot_state, period);
+  }
+
+ private:
+  struct Controller {
+    Callback callback;
+    ActivationCallback activation_callback;
+  };
+
+  std::vector<Controller> controllers_;
+  std::atomic<size_t> selected_{0};
+  std::atomic<size_t> active_{0};
+};
+
+}  // namespace franka
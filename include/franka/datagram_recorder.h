@@ -0,0 +1,121 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @file datagram_recorder.h
+ * Contains the franka::DatagramRecorder type.
+ */
+
+namespace franka {
+
+class DatagramRecorder;
+
+/**
+ * Type of a datagram recorded by franka::DatagramRecorder.
+ */
+enum class DatagramType : uint32_t {
+  /** Robot state received from the robot. */
+  kRobotState = 0,
+  /** Robot command sent to the robot. */
+  kRobotCommand = 1
+};
+
+/// @cond DO_NOT_DOCUMENT
+bool recordRawDatagram(DatagramRecorder& recorder,
+                       DatagramType type,
+                       const uint8_t* data,
+                       size_t size,
+                       std::chrono::system_clock::time_point time) noexcept;
+/// @endcond
+
+/**
+ * Records the raw state and command datagrams exchanged with a robot to a binary file from a
+ * background thread.
+ *
+ * Unlike franka::StreamingRecorder, which records one converted sample per control cycle, the
+ * recorder captures every datagram as it passes the network layer, including states that are
+ * received outside of control loops or dropped as outdated. A recording can be played back with
+ * franka::DatagramReplay.
+ *
+ * Datagrams are handed over through a wait-free single-producer queue. If the writer cannot keep
+ * up and the queue is full, datagrams are dropped instead of blocking the control thread. Pass the
+ * recorder to Robot::setDatagramRecorder() to start recording.
+ *
+ * The file consists of a header followed by variable-size records. All values are stored in the
+ * byte order of the recording machine:
+ *
+ * Offset | Type       | Content
+ * ------ | ---------- | ------------------------------------------------------------------------
+ * 0      | `char[8]`  | Magic `FRANKUDP`
+ * 8      | `uint32_t` | Format version (kFormatVersion)
+ * 12     | `uint32_t` | Version of the robot protocol
+ * 16     | `uint32_t` | Size of a robot state datagram in bytes
+ * 20     | `uint32_t` | Size of a robot command datagram in bytes
+ *
+ * Each record consists of the franka::DatagramType (`uint32_t`), the size of the datagram in
+ * bytes (`uint32_t`), the time at which the datagram was received or sent in nanoseconds since the
+ * epoch of the system clock (`int64_t`), and the datagram itself. Received states carry the
+ * receive timestamp of the kernel where available. An incomplete trailing record should be
+ * ignored.
+ */
+class DatagramRecorder {
+ public:
+  /**
+   * Version of the file format written by this class.
+   */
+  static constexpr uint32_t kFormatVersion = 1;
+
+  /**
+   * Opens the given file and starts the writer thread.
+   *
+   * @param[in] path File to write. Existing files are overwritten.
+   * @param[in] queue_capacity Number of datagrams that can be queued before datagrams are dropped.
+   *
+   * @throw Exception if the file cannot be opened.
+   */
+  explicit DatagramRecorder(const std::string& path, size_t queue_capacity = 8192);
+
+  /**
+   * Writes all queued datagrams and closes the file.
+   */
+  ~DatagramRecorder() noexcept;
+
+  DatagramRecorder(const DatagramRecorder&) = delete;
+  DatagramRecorder& operator=(const DatagramRecorder&) = delete;
+
+  /**
+   * Writes all queued datagrams, stops the writer thread and closes the file. Datagrams recorded
+   * afterwards are dropped.
+   */
+  void stop() noexcept;
+
+  /**
+   * @return Number of datagrams written to the file so far.
+   */
+  uint64_t writtenDatagrams() const noexcept;
+
+  /**
+   * @return Number of datagrams dropped because the queue was full or the recorder was stopped.
+   */
+  uint64_t droppedDatagrams() const noexcept;
+
+ private:
+  class Impl;
+
+  friend bool recordRawDatagram(DatagramRecorder& recorder,
+                                DatagramType type,
+                                const uint8_t* data,
+                                size_t size,
+                                std::chrono::system_clock::time_point time) noexcept;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
@@ -0,0 +1,102 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @file datagram_replay.h
+ * Contains the franka::DatagramReplay type.
+ */
+
+namespace franka {
+
+class Network;
+
+/**
+ * Speed at which franka::DatagramReplay plays back a recording.
+ */
+enum class ReplaySpeed {
+  /** Robot states become available with the timing in which they were recorded. */
+  kRealTime,
+  /**
+   * The next robot state becomes available as soon as the robot sends a command or waits for a
+   * state, so that the session is played back as fast as the controller runs.
+   */
+  kMaximum
+};
+
+/**
+ * Plays back a recording of franka::DatagramRecorder to a franka::Robot, so that a session can be
+ * reproduced offline without a robot.
+ *
+ * A franka::Robot constructed with Robot(DatagramReplay&, RealtimeConfig, size_t) receives the
+ * recorded robot states in their original order, with their original receive timestamps, and
+ * sends its commands into the replay. Each sent command is compared to the command recorded for
+ * the same robot state; divergentCommands() counts the differences. Running the same controller
+ * against the same recording therefore always yields the same result, which allows bisecting
+ * controller regressions.
+ *
+ * Motions are started as requested, and finish when the recorded robot states show that the
+ * recorded motion finished. Settings are acknowledged, but have no effect. Since the recorded
+ * states do not react to the commands, a controller that deviates from the recorded one sees the
+ * states of the recorded session, not the consequences of its own commands. Once all states have
+ * been played back, receiving further states throws NetworkException.
+ *
+ * The replay must outlive all franka::Robot instances connected to it. Only one robot can be
+ * connected at a time.
+ */
+class DatagramReplay {
+ public:
+  /**
+   * Opens a recording.
+   *
+   * @param[in] path Path of a file written by franka::DatagramRecorder.
+   * @param[in] speed Speed of the playback.
+   *
+   * @throw Exception if the file cannot be read or is not a datagram recording.
+   * @throw ProtocolException if the recording was made with an incompatible robot protocol.
+   * @throw NetworkException if the command server cannot be started.
+   */
+  explicit DatagramReplay(const std::string& path, ReplaySpeed speed = ReplaySpeed::kMaximum);
+
+  /**
+   * Stops the replay and closes the recording.
+   */
+  ~DatagramReplay() noexcept;
+
+  /**
+   * @return Number of robot states in the recording.
+   */
+  uint64_t recordedStates() const noexcept;
+
+  /**
+   * @return Number of robot states played back so far.
+   */
+  uint64_t replayedStates() const noexcept;
+
+  /**
+   * @return Number of sent commands that differ from the recorded command for the same robot
+   * state, or for which no command was recorded.
+   */
+  uint64_t divergentCommands() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  DatagramReplay(const DatagramReplay&) = delete;
+  DatagramReplay& operator=(const DatagramReplay&) = delete;
+
+  class Impl;
+  /// @endcond
+
+ private:
+  friend class Robot;
+
+  // Connects to the replay, as a robot connects to the command port of a real robot.
+  std::unique_ptr<Network> connect();
+
+  std::shared_ptr<Impl> impl_;
+};
+
+}  // namespace franka
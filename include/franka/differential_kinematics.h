@@ -0,0 +1,168 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cmath>
+
+#include <franka/control_types.h>
+#include <franka/model.h>
+#include <franka/rate_limiting.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file differential_kinematics.h
+ * Contains the franka::DifferentialKinematics type to convert Cartesian velocities to joint
+ * velocities.
+ */
+
+namespace franka {
+
+/**
+ * Parameters of franka::DifferentialKinematics.
+ */
+struct DifferentialKinematicsOptions {
+  /**
+   * Manipulability below which the damping starts to increase. The Panda reaches about 0.08 in its
+   * ready pose.
+   */
+  double manipulability_threshold{0.03};
+  /**
+   * Damping factor \f$\lambda\f$ at zero manipulability.
+   */
+  double max_damping{0.1};
+  /**
+   * Joint positions that the null space motion pulls the arm towards. Unit: \f$[rad]\f$
+   */
+  std::array<double, 7> posture{{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+  /**
+   * Gain of the null space motion towards #posture. Zero disables it. Unit: \f$[\frac{1}{s}]\f$
+   */
+  double posture_gain{0.5};
+  /**
+   * Distance from a joint position limit within which the null space motion pushes the joint away
+   * from the limit. Unit: \f$[rad]\f$
+   */
+  double joint_limit_margin{0.2};
+  /**
+   * Gain of the null space motion away from the joint position limits. Zero disables it.
+   * Unit: \f$[\frac{1}{s}]\f$
+   */
+  double joint_limit_gain{5};
+  /**
+   * Lower joint position limits. Unit: \f$[rad]\f$
+   */
+  std::array<double, 7> min_joint_position{kMinJointPosition};
+  /**
+   * Upper joint position limits. Unit: \f$[rad]\f$
+   */
+  std::array<double, 7> max_joint_position{kMaxJointPosition};
+  /**
+   * Joint velocity limits. A command exceeding them is scaled down as a whole, so that the
+   * direction of the Cartesian motion is kept. Unit: \f$[\frac{rad}{s}]\f$
+   */
+  std::array<double, 7> max_joint_velocity{kMaxJointVelocity};
+};
+
+/**
+ * Differential inverse kinematics, converting desired end effector velocities to joint velocities
+ * with damped least squares.
+ *
+ * For the 6x7 zero Jacobian \f$J\f$ and the desired velocity \f$\dot{x}\f$, the joint velocities
+ * are
+ * \f[
+ * \dot{q} = J^T (J J^T + \lambda^2 I)^{-1} \dot{x} + (I - J^T (J J^T + \lambda^2 I)^{-1} J)
+ * \dot{q}_0.
+ * \f]
+ * The damping \f$\lambda\f$ adapts to the manipulability \f$w = \sqrt{\det(J J^T)}\f$: it is zero
+ * above DifferentialKinematicsOptions::manipulability_threshold \f$w_0\f$, so the Cartesian
+ * velocity is tracked exactly, and grows to DifferentialKinematicsOptions::max_damping
+ * \f$\lambda_{max}\f$ towards a singularity, with
+ * \f$\lambda^2 = \lambda_{max}^2 (1 - (w/w_0)^2)\f$. Near a singularity, the velocity is thereby
+ * traded for bounded joint velocities instead of the large ones of the exact pseudoinverse.
+ *
+ * The secondary joint velocities \f$\dot{q}_0\f$ pull the arm towards a posture and push joints
+ * that are close to their position limits away from them. They are projected into the null space
+ * of the Jacobian, so they do not disturb the end effector motion. Finally, the joint velocities
+ * are scaled down as a whole if they exceed the velocity limits.
+ *
+ * All matrices are fixed-size, so a computation takes a few microseconds, does not allocate memory
+ * and can run in every Robot::control callback:
+ *
+ * @code{.cpp}
+ * franka::DifferentialKinematics kinematics;
+ * robot.control([&](const franka::RobotState& robot_state, franka::Duration) {
+ *   return kinematics.compute(model, robot_state, operatorVelocity());
+ * });
+ * @endcode
+ */
+class DifferentialKinematics {
+ public:
+  /**
+   * Creates a solver.
+   *
+   * @param[in] options Damping and null space parameters.
+   *
+   * @throw std::invalid_argument if a threshold, damping, gain, margin or velocity limit is
+   * negative, the manipulability threshold is zero with a damping larger than zero, or a lower
+   * position limit is larger than its upper limit.
+   */
+  explicit DifferentialKinematics(
+      const DifferentialKinematicsOptions& options = DifferentialKinematicsOptions());
+
+  /**
+   * Computes joint velocities from a Jacobian.
+   *
+   * @param[in] zero_jacobian Vectorized 6x7 Jacobian of the controlled frame in base frame,
+   * column-major.
+   * @param[in] q Current joint positions. Unit: \f$[rad]\f$
+   * @param[in] O_dP_EE Desired velocity of the controlled frame in base frame, translational and
+   * rotational. Unit: \f$[\frac{m}{s}, \frac{rad}{s}]\f$
+   *
+   * @return Joint velocities.
+   */
+  JointVelocities compute(
+      const std::array<double, 42>& zero_jacobian,
+      const std::array<double, 7>& q,
+      const std::array<double, 6>& O_dP_EE)  // NOLINT(readability-identifier-naming)
+      noexcept;
+
+  /**
+   * Computes joint velocities for the end effector, using Model::zeroJacobian.
+   *
+   * @param[in] model Model of the robot.
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] O_dP_EE Desired end effector velocity in base frame, translational and rotational.
+   * Unit: \f$[\frac{m}{s}, \frac{rad}{s}]\f$
+   *
+   * @return Joint velocities.
+   */
+  JointVelocities compute(
+      const Model& model,
+      const RobotState& robot_state,
+      const std::array<double, 6>& O_dP_EE);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return Manipulability \f$w\f$ of the last computation.
+   */
+  double manipulability() const noexcept;
+
+  /**
+   * @return Damping factor \f$\lambda\f$ of the last computation.
+   */
+  double damping() const noexcept;
+
+  /**
+   * @return Factor by which the last joint velocities were scaled down to respect the velocity
+   * limits, 1 if they were within the limits.
+   */
+  double velocityScaling() const noexcept;
+
+ private:
+  DifferentialKinematicsOptions options_;
+  double manipulability_{0};
+  double damping_{0};
+  double velocity_scaling_{1};
+};
+
+}  // namespace franka
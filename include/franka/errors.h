@@ -3,7 +3,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
+#include <string>
 
 /**
  * @file errors.h
@@ -18,8 +21,18 @@ namespace franka {
 struct Errors {
  private:
   std::array<bool, 41> errors_{};
+  // Packed copy of errors_, bit i is set if flag i is set. Kept next to the array because the
+  // public flag references need addressable bools.
+  uint64_t bits_{0};
+
+  static size_t lowestBit(uint64_t bits) noexcept;
 
  public:
+  /**
+   * Number of error flags.
+   */
+  static constexpr size_t kCount = 41;
+
   /**
    * Creates an empty Errors instance.
    */
@@ -48,6 +61,15 @@ struct Errors {
    */
   Errors(const std::array<bool, 41>& errors);
 
+  /**
+   * Creates a new Errors instance from a bitmask as returned by bits().
+   *
+   * Bits above kCount are ignored.
+   *
+   * @param[in] bits Bitmask of error flags.
+   */
+  explicit Errors(uint64_t bits);
+
   /**
    * Check if any error flag is set to true.
    *
@@ -55,6 +77,51 @@ struct Errors {
    */
   explicit operator bool() const noexcept;
 
+  /**
+   * Check if any error flag is set to true.
+   *
+   * @return True if any errors are set.
+   */
+  bool any() const noexcept { return bits_ != 0; }
+
+  /**
+   * Returns all error flags as a bitmask. Bit i corresponds to the error with code i, i.e.\ the
+   * order of the flags in this struct.
+   *
+   * @return Bitmask of error flags.
+   */
+  uint64_t bits() const noexcept { return bits_; }
+
+  /**
+   * Returns the flags which differ between this and another Errors instance.
+   *
+   * @param[in] other Other Errors instance.
+   *
+   * @return Bitmask of flags set in exactly one of both instances, zero if they are equal.
+   */
+  uint64_t changed(const Errors& other) const noexcept { return bits_ ^ other.bits_; }
+
+  /**
+   * Calls the given function with the index of every set error flag, in ascending order.
+   *
+   * @param[in] function Callable taking the flag index as `size_t`.
+   */
+  template <typename Function>
+  void forEach(Function function) const {
+    for (uint64_t bits = bits_; bits != 0; bits &= bits - 1) {
+      function(lowestBit(bits));
+    }
+  }
+
+  /**
+   * Returns the name of the error flag with the given index, as used by operator std::string().
+   *
+   * @param[in] index Flag index, smaller than kCount.
+   *
+   * @return Name of the error flag.
+   */
+  static const char* name(size_t index);
+
   /**
    * Creates a string with names of active errors:
    * "[active_error_name2, active_error_name_2, ... active_error_name_n]"
@@ -255,4 +322,28 @@ struct Errors {
  */
 std::ostream& operator<<(std::ostream& ostream, const Errors& errors);
 
+/**
+ * Compares the error flags of two Errors instances.
+ *
+ * @param[in] lhs Left-hand side.
+ * @param[in] rhs Right-hand side.
+ *
+ * @return True if the same flags are set.
+ */
+inline bool operator==(const Errors& lhs, const Errors& rhs) noexcept {
+  return lhs.bits() == rhs.bits();
+}
+
+/**
+ * Compares the error flags of two Errors instances.
+ *
+ * @param[in] lhs Left-hand side.
+ * @param[in] rhs Right-hand side.
+ *
+ * @return True if different flags are set.
+ */
+inline bool operator!=(const Errors& lhs, const Errors& rhs) noexcept {
+  return !(lhs == rhs);
+}
+
 }  // namespace franka
@@ -0,0 +1,117 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <franka/control_types.h>
+
+/**
+ * @file event_loop.h
+ * Contains the franka::EventLoop type.
+ */
+
+namespace franka {
+
+class Gripper;
+class NetworkEventLoop;
+class Robot;
+class VacuumGripper;
+
+/**
+ * Waits on the command connections of all devices of a cell in a single thread.
+ *
+ * Without an event loop, every blocking command of a Robot, Gripper or VacuumGripper polls its own
+ * socket in short intervals until the response has arrived. Attached devices instead sleep until
+ * the event loop reports new data on their connection. On Linux, the loop uses `epoll`; on other
+ * platforms, attached devices keep polling their own sockets.
+ *
+ * The realtime configuration given to the event loop is applied to its thread, which is the only
+ * thread that waits on the command connections.
+ *
+ * State reception over UDP is not affected: the control loop of a Robot keeps receiving its states
+ * directly in the calling thread.
+ *
+ * @code{.cpp}
+ * franka::EventLoop event_loop(franka::RealtimeConfig::kIgnore);
+ * franka::Robot robot("172.16.0.2");
+ * franka::Gripper gripper("172.16.0.2");
+ * event_loop.attach(robot);
+ * event_loop.attach(gripper);
+ * @endcode
+ */
+class EventLoop {
+ public:
+  /**
+   * Starts the event loop thread.
+   *
+   * @param[in] realtime_config If set to kEnforce, an exception will be thrown if realtime
+   * priority or the realtime options cannot be applied to the event loop thread. If set to kIgnore,
+   * failures are ignored.
+   * @param[in] realtime_options Additional realtime measures for the event loop thread.
+   *
+   * @throw NetworkException if the event loop cannot be created.
+   * @throw RealtimeException if realtime priority or options cannot be applied with kEnforce.
+   */
+  explicit EventLoop(RealtimeConfig realtime_config = RealtimeConfig::kEnforce,
+                     const RealtimeOptions& realtime_options = {});
+
+  /**
+   * Stops the event loop. Attached devices wait on their own connections again afterwards.
+   */
+  ~EventLoop() noexcept;
+
+  /**
+   * Attaches the command connection of a robot.
+   *
+   * @param[in] robot Robot to attach. May be destroyed before the event loop.
+   *
+   * @throw InvalidOperationException if the robot is attached to another event loop.
+   * @throw NetworkException if the connection cannot be attached.
+   * @throw std::invalid_argument if the robot has been moved from.
+   */
+  void attach(Robot& robot);
+
+  /**
+   * Attaches the command connection of a gripper.
+   *
+   * @param[in] gripper Gripper to attach. May be destroyed before the event loop.
+   *
+   * @throw InvalidOperationException if the gripper is attached to another event loop.
+   * @throw NetworkException if the connection cannot be attached.
+   * @throw std::invalid_argument if the gripper has been moved from.
+   */
+  void attach(Gripper& gripper);
+
+  /**
+   * Attaches the command connection of a vacuum gripper.
+   *
+   * @param[in] vacuum_gripper Vacuum gripper to attach. May be destroyed before the event loop.
+   *
+   * @throw InvalidOperationException if the vacuum gripper is attached to another event loop.
+   * @throw NetworkException if the connection cannot be attached.
+   * @throw std::invalid_argument if the vacuum gripper has been moved from.
+   */
+  void attach(VacuumGripper& vacuum_gripper);
+
+  /**
+   * @return Number of attached connections that have not been destroyed yet.
+   */
+  size_t size() const;
+
+  /**
+   * @return True if the event loop is running. False on platforms without `epoll` support.
+   */
+  bool running() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+  /// @endcond
+
+ private:
+  std::shared_ptr<NetworkEventLoop> impl_;
+};
+
+}  // namespace franka
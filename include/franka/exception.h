@@ -2,8 +2,12 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <franka/log.h>
 
@@ -28,6 +32,13 @@ struct ModelException : public Exception {
   using Exception::Exception;
 };
 
+/**
+ * PluginException is thrown if a controller plugin cannot be loaded or reports an error.
+ */
+struct PluginException : public Exception {
+  using Exception::Exception;
+};
+
 /**
  * NetworkException is thrown if a connection to the robot cannot be established, or when a timeout
  * occurs.
@@ -64,6 +75,121 @@ struct IncompatibleVersionException : public Exception {
   const uint16_t library_version;
 };
 
+/// @cond DO_NOT_DOCUMENT
+namespace detail {
+
+/**
+ * Raw log contents that are converted to records when they are first read.
+ */
+class LogSource {
+ public:
+  virtual ~LogSource() = default;
+
+  /**
+   * @return Number of records, without converting them.
+   */
+  virtual size_t size() const noexcept = 0;
+
+  /**
+   * Converts the contents on the first call. Thread-safe.
+   *
+   * @return Records, oldest first.
+   */
+  const std::vector<Record>& records() const;
+
+ protected:
+  virtual void convert(std::vector<Record>* records) const = 0;
+
+ private:
+  mutable std::once_flag converted_;
+  mutable std::vector<Record> records_;
+};
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * Log of the states and commands held by a ControlException.
+ *
+ * The log keeps the raw contents of the robot's log and converts them to records only when they
+ * are first read, so that creating and copying the exception stays cheap for large log sizes.
+ * Copies share the same immutable contents. The log can be used like a
+ * `const std::vector<Record>&`, and converts to one implicitly.
+ */
+class ExceptionLog {
+ public:
+  /**
+   * Creates an empty log.
+   */
+  ExceptionLog() noexcept = default;
+
+  /**
+   * Creates a log from already converted records.
+   *
+   * @param[in] records Records, oldest first.
+   */
+  ExceptionLog(std::vector<Record> records);  // NOLINT(google-explicit-constructor)
+
+  /**
+   * Creates a log that converts the given contents on first access.
+   *
+   * @param[in] source Raw log contents.
+   */
+  explicit ExceptionLog(std::shared_ptr<const detail::LogSource> source) noexcept;
+
+  /**
+   * @return Records, oldest first. Converted on the first call.
+   */
+  const std::vector<Record>& records() const;
+
+  /**
+   * @return Records, oldest first. Converted on the first call.
+   */
+  operator const std::vector<Record>&() const {  // NOLINT(google-explicit-constructor)
+    return records();
+  }
+
+  /**
+   * @return Number of records. Does not convert them.
+   */
+  size_t size() const noexcept;
+
+  /**
+   * @return True if the log has no records. Does not convert them.
+   */
+  bool empty() const noexcept { return size() == 0; }
+
+  /**
+   * @param[in] index Index of the record, 0 being the oldest.
+   *
+   * @return Record at the given index.
+   */
+  const Record& operator[](size_t index) const { return records()[index]; }
+
+  /**
+   * @return Oldest record.
+   */
+  const Record& front() const { return records().front(); }
+
+  /**
+   * @return Latest record.
+   */
+  const Record& back() const { return records().back(); }
+
+  /**
+   * @return Iterator to the oldest record.
+   */
+  std::vector<Record>::const_iterator begin() const { return records().begin(); }
+
+  /**
+   * @return Iterator past the latest record.
+   */
+  std::vector<Record>::const_iterator end() const { return records().end(); }
+
+ private:
+  std::shared_ptr<const detail::LogSource> source_;
+};
+
 /**
  * ControlException is thrown if an error occurs during motion generation or torque control.
  * The exception holds a vector with the last received robot states. The number of recorded
@@ -75,14 +201,15 @@ struct ControlException : public Exception {
    * Creates the exception with an explanatory string and a Log object.
    *
    * @param[in] what Explanatory string.
-   * @param[in] log Vector of last received states and commands.
+   * @param[in] log Last received states and commands.
    */
-  explicit ControlException(const std::string& what, std::vector<franka::Record> log = {}) noexcept;
+  explicit ControlException(const std::string& what, ExceptionLog log = {}) noexcept;
 
   /**
-   * Vector of states and commands logged just before the exception occurred.
+   * States and commands logged just before the exception occurred. Converted to records when they
+   * are first read.
    */
-  const std::vector<franka::Record> log;
+  const ExceptionLog log;
 };
 
 /**
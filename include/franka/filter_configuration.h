@@ -0,0 +1,58 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/lowpass_filter.h>
+
+/**
+ * @file filter_configuration.h
+ * Contains the franka::FilterConfiguration type.
+ */
+
+namespace franka {
+
+/**
+ * Cutoff frequencies of the first order low-pass filters that control loops apply on the user
+ * commanded signals.
+ *
+ * Every command channel has its own cutoff frequencies, and joint-level channels have one per
+ * joint. A cutoff frequency of franka::kMaxCutoffFrequency or higher disables filtering of the
+ * channel or joint. Channels in which all elements are disabled skip filtering entirely.
+ *
+ * A single cutoff frequency converts implicitly to a configuration that uses it for all channels.
+ */
+struct FilterConfiguration {
+  /**
+   * Creates a configuration with the same cutoff frequency for all channels.
+   *
+   * @param[in] cutoff_frequency Cutoff frequency for all channels. Unit: \f$[Hz]\f$
+   */
+  FilterConfiguration(double cutoff_frequency = kDefaultCutoffFrequency)
+      : torques{{cutoff_frequency, cutoff_frequency, cutoff_frequency, cutoff_frequency,
+                 cutoff_frequency, cutoff_frequency, cutoff_frequency}},
+        joints{{cutoff_frequency, cutoff_frequency, cutoff_frequency, cutoff_frequency,
+                cutoff_frequency, cutoff_frequency, cutoff_frequency}},
+        cartesian(cutoff_frequency),
+        elbow(cutoff_frequency) {}
+
+  /**
+   * Cutoff frequencies for joint-level torque commands. Unit: \f$[Hz]\f$
+   */
+  std::array<double, 7> torques;
+  /**
+   * Cutoff frequencies for joint position and joint velocity commands. Unit: \f$[Hz]\f$
+   */
+  std::array<double, 7> joints;
+  /**
+   * Cutoff frequency for Cartesian pose and Cartesian velocity commands. Unit: \f$[Hz]\f$
+   */
+  double cartesian;
+  /**
+   * Cutoff frequency for elbow commands. Unit: \f$[Hz]\f$
+   */
+  double elbow;
+};
+
+}  // namespace franka
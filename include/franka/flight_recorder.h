@@ -0,0 +1,144 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <franka/log.h>
+
+/**
+ * @file flight_recorder.h
+ * Contains the franka::FlightRecorder type.
+ */
+
+/// @cond DO_NOT_DOCUMENT
+namespace research_interface {
+namespace robot {
+struct RobotState;
+struct RobotCommand;
+}  // namespace robot
+}  // namespace research_interface
+/// @endcond
+
+namespace franka {
+
+class FlightRecorder;
+
+/// @cond DO_NOT_DOCUMENT
+void recordRawFlightSample(FlightRecorder& recorder,
+                           const research_interface::robot::RobotState& robot_state,
+                           const research_interface::robot::RobotCommand& robot_command) noexcept;
+/// @endcond
+
+/**
+ * Keeps the last robot states and commands in a ring inside a memory-mapped file, so that they
+ * survive a crash of the process.
+ *
+ * The log of franka::ControlException only exists in process memory and is lost if the process
+ * is killed or crashes in user code. The flight recorder instead writes each sample directly into
+ * shared file pages and then advances a commit counter in the file header. Since the pages belong
+ * to the kernel's page cache, they are written back to disk even if the process dies, e.g. through
+ * a segmentation fault or `SIGKILL`. Data can still be lost if the whole machine fails before the
+ * pages are written back.
+ *
+ * Recording costs one copy of the raw state and command per cycle, as logging the full state with
+ * the regular log does; no system calls are made. Pass the recorder to Robot::setFlightRecorder()
+ * to start recording, and read a recording, also of a crashed process, with
+ * franka::readFlightRecording().
+ *
+ * The file starts with a 64 byte header, followed by `capacity` slots. All values are stored in
+ * the byte order of the recording machine:
+ *
+ * Offset | Type       | Content
+ * ------ | ---------- | ------------------------------------------------------------------------
+ * 0      | `char[8]`  | Magic `FRANKFLT`
+ * 8      | `uint32_t` | Format version (kFormatVersion)
+ * 12     | `uint32_t` | Version of the robot protocol
+ * 16     | `uint32_t` | Size of a robot state datagram in bytes
+ * 20     | `uint32_t` | Size of a robot command datagram in bytes
+ * 24     | `uint64_t` | Number of slots
+ * 32     | `uint64_t` | Number of committed samples
+ *
+ * Each slot contains the raw robot state followed by the raw robot command sent in reply to the
+ * previous state, padded to a multiple of 8 bytes. Sample n is stored in slot n modulo the number
+ * of slots. Since the slot after the last committed sample may be partially overwritten, at most
+ * `capacity - 1` samples can be recovered.
+ *
+ * Only supported on Linux.
+ */
+class FlightRecorder {
+ public:
+  /**
+   * Version of the file format written by this class.
+   */
+  static constexpr uint32_t kFormatVersion = 1;
+
+  /**
+   * Creates the recording file and maps it into memory.
+   *
+   * All pages of the file are allocated and touched here, so that recording does not fault them in
+   * from the control loop.
+   *
+   * @param[in] path File to write. Existing files are overwritten.
+   * @param[in] capacity Number of slots. With one sample per millisecond, 10000 slots keep the last
+   * 10 seconds.
+   *
+   * @throw Exception if the file cannot be created or mapped, if capacity is smaller than 2, or if
+   * memory-mapped recording is not supported on this platform.
+   */
+  explicit FlightRecorder(const std::string& path, size_t capacity = 10000);
+
+  /**
+   * Unmaps the file. The file is kept.
+   */
+  ~FlightRecorder() noexcept;
+
+  /**
+   * @return Number of slots of the ring.
+   */
+  size_t capacity() const noexcept;
+
+  /**
+   * @return Number of samples recorded so far, including overwritten ones.
+   */
+  uint64_t committedSamples() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+  /// @endcond
+
+ private:
+  friend void recordRawFlightSample(FlightRecorder& recorder,
+                                    const research_interface::robot::RobotState& robot_state,
+                                    const research_interface::robot::RobotCommand& robot_command)
+      noexcept;
+
+  char* data_{nullptr};
+  size_t size_{0};
+  size_t capacity_;
+  size_t slot_size_{0};
+  std::atomic<uint64_t>* committed_{nullptr};
+};
+
+/**
+ * Reads the samples of a recording written by franka::FlightRecorder, oldest first.
+ *
+ * Intended for recordings of stopped or crashed processes; samples that are overwritten while
+ * reading a recording in use may be inconsistent. Samples are converted as for the log of
+ * franka::ControlException, with all state fields and commands.
+ *
+ * @param[in] path Path of the recording.
+ *
+ * @return Recovered samples.
+ *
+ * @throw Exception if the file cannot be read or is not a flight recording.
+ * @throw ProtocolException if the recording was made with an incompatible robot protocol.
+ */
+std::vector<Record> readFlightRecording(const std::string& path);
+
+}  // namespace franka
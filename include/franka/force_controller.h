@@ -0,0 +1,171 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file force_controller.h
+ * Contains the franka::ForceController type.
+ */
+
+namespace franka {
+
+/**
+ * Source of the wrench measurement of a franka::ForceController.
+ */
+enum class ForceMeasurement {
+  /**
+   * Uses RobotState::O_F_ext_hat_K.
+   */
+  kExternalWrench,
+  /**
+   * Maps RobotState::tau_ext_hat_filtered to a wrench with the least-squares solution of
+   * \f$J^T F = \tau_{ext}\f$.
+   */
+  kExternalTorques
+};
+
+/**
+ * Parameters of the franka::ForceController. Wrenches are ordered as forces along and torques
+ * about the x, y and z axes of the base frame.
+ */
+struct ForceControllerParameters {
+  /**
+   * Axes on which the wrench is controlled. The controller commands no wrench on the other axes.
+   */
+  std::array<bool, 6> selection{{true, true, true, true, true, true}};
+  /**
+   * Proportional gain on the wrench error. Unit: \f$[1]\f$
+   */
+  std::array<double, 6> proportional_gain{{1, 1, 1, 1, 1, 1}};
+  /**
+   * Integral gain on the wrench error. Unit: \f$[\frac{1}{s}]\f$
+   */
+  std::array<double, 6> integral_gain{{2, 2, 2, 2, 2, 2}};
+  /**
+   * Largest wrench the integral term may contribute. The integrator stops accumulating at this
+   * limit, so that it does not wind up while the end effector is not in contact.
+   * Unit: \f$[N,N,N,Nm,Nm,Nm]\f$
+   */
+  std::array<double, 6> max_integral_wrench{{10, 10, 10, 2, 2, 2}};
+  /**
+   * Source of the wrench measurement.
+   */
+  ForceMeasurement measurement{ForceMeasurement::kExternalWrench};
+};
+
+/**
+ * Explicit PI force controller with feed-forward in the base frame.
+ *
+ * The controller commands the joint torques \f$\tau_d = J^T F_c\f$ with
+ * \f$F_c = F_d + K_P (F_d - F) + K_I \int (F_d - F) dt\f$ on the selected axes, where \f$F_d\f$
+ * is the wrench the end effector should exert on its environment and \f$F\f$ the measured one,
+ * i.e. the negated external wrench acting on the robot after removing the bias. The torques do not
+ * include gravity or any motion control; add e.g. Coriolis compensation and damping as needed.
+ *
+ * The integral term of every axis is clamped to ForceControllerParameters::max_integral_wrench.
+ * The integrator advances by franka::kDeltaT per call to update().
+ *
+ * The bias of the measurement, e.g. from an imprecisely identified load, is estimated with
+ * calibrateBias() while the end effector is not in contact. All state is fixed-size; update() does
+ * not allocate and takes a few microseconds.
+ */
+class ForceController {
+ public:
+  /**
+   * Creates a controller with a zero target wrench and bias.
+   *
+   * @param[in] parameters Controller parameters.
+   *
+   * @throw std::invalid_argument if a gain or limit is negative, infinite or NaN.
+   */
+  explicit ForceController(const ForceControllerParameters& parameters = {});
+
+  /**
+   * Sets the wrench the end effector should exert on its environment.
+   *
+   * @param[in] wrench Target wrench in base frame. Unit: \f$[N,N,N,Nm,Nm,Nm]\f$.
+   *
+   * @throw std::invalid_argument if a value is infinite or NaN.
+   */
+  void setTarget(const std::array<double, 6>& wrench);
+
+  /**
+   * Adds a sample to the bias estimate, which is the mean of all samples since the last call to
+   * resetBias(). Call it for a number of cycles while the end effector is not in contact.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] zero_jacobian Zero Jacobian of the stiffness frame, column-major. Only used with
+   * ForceMeasurement::kExternalTorques.
+   */
+  void calibrateBias(const RobotState& robot_state,
+                     const std::array<double, 42>& zero_jacobian) noexcept;
+
+  /**
+   * Clears the bias estimate.
+   */
+  void resetBias() noexcept;
+
+  /**
+   * Clears the integral term, e.g. when the contact is lost on purpose.
+   */
+  void resetIntegrator() noexcept;
+
+  /**
+   * Computes the torque command for the given robot state.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] model Robot model, used to compute the Jacobian of the stiffness frame.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> update(const RobotState& robot_state, const Model& model);
+
+  /**
+   * Computes the torque command for the given robot state and Jacobian.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] zero_jacobian Zero Jacobian of the stiffness frame, column-major.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> update(const RobotState& robot_state,
+                               const std::array<double, 42>& zero_jacobian) noexcept;
+
+  /**
+   * @return Measured wrench exerted by the end effector of the last call to update(), after
+   * removing the bias. Unit: \f$[N,N,N,Nm,Nm,Nm]\f$.
+   */
+  const std::array<double, 6>& measuredWrench() const noexcept;
+
+  /**
+   * @return Commanded wrench \f$F_c\f$ of the last call to update(). Unit: \f$[N,N,N,Nm,Nm,Nm]\f$.
+   */
+  const std::array<double, 6>& commandedWrench() const noexcept;
+
+  /**
+   * @return Current bias estimate of the external wrench acting on the robot.
+   * Unit: \f$[N,N,N,Nm,Nm,Nm]\f$.
+   */
+  const std::array<double, 6>& bias() const noexcept;
+
+ private:
+  const std::array<double, 6>& externalWrench(const RobotState& robot_state,
+                                              const std::array<double, 42>& zero_jacobian) noexcept;
+
+  ForceControllerParameters parameters_;
+  std::array<double, 6> target_{};
+  std::array<double, 6> integral_{};
+  std::array<double, 6> bias_{};
+  uint64_t bias_samples_{0};
+  std::array<double, 6> external_wrench_{};
+  std::array<double, 6> measured_wrench_{};
+  std::array<double, 6> commanded_wrench_{};
+};
+
+}  // namespace franka
@@ -2,7 +2,10 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -15,14 +18,24 @@
 
 namespace franka {
 
+class AsyncCommandExecutor;
 class Network;
 
 /**
  * Maintains a network connection to the gripper, provides the current gripper state,
  * and allows the execution of commands.
  *
+ * Commands are available in a blocking and an asynchronous variant. The asynchronous variants
+ * return as soon as the command has been sent. Their results are delivered through a `std::future`
+ * by one I/O thread per Gripper, which is started with the first asynchronous command. This
+ * allows, for example, to stop a running grasp or to move the robot while the gripper is moving.
+ *
+ * The gripper state can either be waited for with readOnce(), or be kept up to date by a background
+ * receiver after subscribe(), so that latestState() returns it without blocking.
+ *
  * @note
- * The members of this class are threadsafe.
+ * The members of this class are threadsafe, except for the restrictions noted at subscribe(),
+ * unsubscribe() and latestState().
  */
 class Gripper {
  public:
@@ -31,15 +44,24 @@ class Gripper {
    */
   using ServerVersion = uint16_t;
 
+  /**
+   * Callback for the gripper states received after subscribe().
+   */
+  using StateCallback = std::function<void(const GripperState&)>;
+
   /**
    * Establishes a connection with a gripper connected to a robot.
    *
    * @param[in] franka_address IP/hostname of the robot the gripper is connected to.
+   * @param[in] motion_timeout Time homing(), grasp() and move() wait for the gripper to finish, in
+   * addition to the network timeout. By default, they wait without a deadline, since a motion can
+   * take arbitrarily long, e.g. while grasping slowly.
    *
    * @throw NetworkException if the connection is unsuccessful.
    * @throw IncompatibleVersionException if this version of `libfranka` is not supported.
    */
-  explicit Gripper(const std::string& franka_address);
+  explicit Gripper(const std::string& franka_address,
+                   std::chrono::milliseconds motion_timeout = std::chrono::milliseconds::max());
 
   /**
    * Move-constructs a new Gripper instance.
@@ -71,7 +93,8 @@ class Gripper {
    * @return True if command was successful, false otherwise.
    *
    * @throw CommandException if an error occurred.
-   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw NetworkException if the connection is lost, or if the gripper has not finished within
+   * the motion timeout given to the constructor.
    *
    * @see GripperState for the maximum grasping width.
    */
@@ -94,7 +117,8 @@ class Gripper {
    * @return True if an object has been grasped, false otherwise.
    *
    * @throw CommandException if an error occurred.
-   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw NetworkException if the connection is lost, or if the gripper has not finished within
+   * the motion timeout given to the constructor.
    */
   bool grasp(double width,
              double speed,
@@ -111,7 +135,8 @@ class Gripper {
    * @return True if command was successful, false otherwise.
    *
    * @throw CommandException if an error occurred.
-   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw NetworkException if the connection is lost, or if the gripper has not finished within
+   * the motion timeout given to the constructor.
    */
   bool move(double width, double speed) const;
 
@@ -125,9 +150,70 @@ class Gripper {
    */
   bool stop() const;
 
+  /**
+   * Starts a homing of the gripper without waiting for it to finish.
+   *
+   * @return Future for the result of homing(). Its `get()` throws the exceptions of homing().
+   *
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see homing()
+   */
+  std::future<bool> homingAsync() const;
+
+  /**
+   * Starts grasping an object without waiting for it to finish.
+   *
+   * @param[in] width Size of the object to grasp in \f$[m]\f$.
+   * @param[in] speed Closing speed in \f$[\frac{m}{s}]\f$.
+   * @param[in] force Grasping force in \f$[N]\f$.
+   * @param[in] epsilon_inner Maximum tolerated deviation when the actual grasped width is smaller
+   * than the commanded grasp width.
+   * @param[in] epsilon_outer Maximum tolerated deviation when the actual grasped width is larger
+   * than the commanded grasp width.
+   *
+   * @return Future for the result of grasp(). Its `get()` throws the exceptions of grasp().
+   *
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see grasp()
+   */
+  std::future<bool> graspAsync(double width,
+                               double speed,
+                               double force,
+                               double epsilon_inner = 0.005,
+                               double epsilon_outer = 0.005) const;
+
+  /**
+   * Starts moving the gripper fingers to a specified width without waiting for it to finish.
+   *
+   * @param[in] width Intended opening width in \f$[m]\f$.
+   * @param[in] speed Closing speed in \f$[\frac{m}{s}]\f$.
+   *
+   * @return Future for the result of move(). Its `get()` throws the exceptions of move().
+   *
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see move()
+   */
+  std::future<bool> moveAsync(double width, double speed) const;
+
+  /**
+   * Stops a currently running gripper move or grasp without waiting for the confirmation.
+   *
+   * @return Future for the result of stop(). Its `get()` throws the exceptions of stop().
+   *
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see stop()
+   */
+  std::future<bool> stopAsync() const;
+
   /**
    * Waits for a gripper state update and returns it.
    *
+   * While subscribed, waits for the next state received by the background receiver instead.
+   *
    * @return Current gripper state.
    *
    * @throw NetworkException if the connection is lost, e.g. after a timeout.
@@ -135,6 +221,41 @@ class Gripper {
    */
   GripperState readOnce() const;
 
+  /**
+   * Starts receiving gripper states in a background thread.
+   *
+   * Returns after the first state has been received, so that latestState() is valid afterwards.
+   * Must not be called while latestState() or readOnce() is running on another thread.
+   *
+   * @param[in] callback Called from the background thread with every new state. Must return
+   * quickly. May be empty.
+   *
+   * @throw InvalidOperationException if already subscribed.
+   * @throw NetworkException if no state is received, e.g. after a timeout.
+   */
+  void subscribe(StateCallback callback = {});
+
+  /**
+   * Stops receiving gripper states in the background. Does nothing if not subscribed.
+   *
+   * Must not be called while latestState() or readOnce() is running on another thread.
+   */
+  void unsubscribe() noexcept;
+
+  /**
+   * Returns the latest gripper state received since subscribe() without blocking.
+   *
+   * Makes no system calls and is therefore suitable for realtime loops. May only be called from
+   * one thread at a time.
+   *
+   * @return Latest gripper state.
+   *
+   * @throw InvalidOperationException if not subscribed.
+   * @throw NetworkException if the background receiver has lost the connection, or the exception
+   * thrown by the state callback.
+   */
+  GripperState latestState() const;
+
   /**
    * Returns the software version reported by the connected server.
    *
@@ -148,9 +269,19 @@ class Gripper {
   /// @endcond
 
  private:
+  friend class EventLoop;
+
+  class Subscription;
+
   std::unique_ptr<Network> network_;
 
   uint16_t ri_version_;
+  std::chrono::milliseconds motion_timeout_;
+
+  // Declared after network_, so that the background threads are stopped before the connection is
+  // closed.
+  std::unique_ptr<AsyncCommandExecutor> async_commands_;
+  std::unique_ptr<Subscription> subscription_;
 };
 
 }  // namespace franka
@@ -0,0 +1,201 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+
+#include <franka/duration.h>
+#include <franka/haptic_scene.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file haptic_coupling.h
+ * Contains the franka::haptics::MultiRateCoupling type to couple slow scene simulations to the
+ * 1 kHz control loop.
+ */
+
+namespace franka {
+namespace haptics {
+
+/**
+ * Contact plane of a franka::haptics::LocalModel. The half-space behind the plane is solid.
+ */
+struct ContactPlane {
+  /**
+   * Point on the plane in base frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> point{};
+  /**
+   * Unit normal of the plane in base frame, pointing out of the solid.
+   */
+  std::array<double, 3> normal{{0, 0, 1}};
+  /**
+   * Contact properties.
+   */
+  Material material{};
+};
+
+/**
+ * Local intermediate representation of a virtual environment around the end effector.
+ *
+ * A scene simulation running at a low rate approximates the environment near the end effector by
+ * a few contact planes, e.g. the tangent planes of the closest surfaces, and a feed-forward
+ * wrench, e.g. for simulated inertia or tool weight. The control loop renders this model at 1 kHz
+ * until the next one is published. The model has a fixed size so it can be handed over without
+ * allocating.
+ */
+struct LocalModel {
+  /**
+   * Maximum number of contact planes.
+   */
+  static constexpr size_t kMaxPlanes = 8;
+
+  /**
+   * Contact planes. Only the first plane_count are used.
+   */
+  std::array<ContactPlane, kMaxPlanes> planes{};
+  /**
+   * Number of used contact planes.
+   */
+  size_t plane_count{};
+  /**
+   * Wrench added to the contact wrench, in base frame and about the end effector origin.
+   * Forces in \f$[N]\f$, torques in \f$[Nm]\f$.
+   */
+  std::array<double, 6> O_F_feedforward{};  // NOLINT(readability-identifier-naming)
+  /**
+   * RobotState::time of the robot state the model was computed from. Set by
+   * franka::haptics::MultiRateCoupling.
+   */
+  Duration time{};
+
+  /**
+   * Adds a contact plane.
+   *
+   * @param[in] point Point on the plane in base frame. Unit: \f$[m]\f$
+   * @param[in] normal Normal of the plane in base frame. Does not need to be normalized.
+   * @param[in] material Contact properties.
+   *
+   * @return False if the model is full or the normal is zero.
+   */
+  bool addPlane(const std::array<double, 3>& point,
+                const std::array<double, 3>& normal,
+                const Material& material = {}) noexcept;
+};
+
+/**
+ * Renders a local model for a point probe.
+ *
+ * @param[in] model Local model.
+ * @param[in] O_T_EE End effector pose in base frame, column-major.
+ * @param[in] velocity Translational end effector velocity in base frame, used for contact
+ * damping. Unit: \f$[\frac{m}{s}]\f$
+ * @param[in] probe_offset Position of the probe in end effector frame. Unit: \f$[m]\f$
+ *
+ * @return Contact wrench including LocalModel::O_F_feedforward.
+ */
+SceneWrench renderLocalModel(
+    const LocalModel& model,
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity = {},
+    const std::array<double, 3>& probe_offset = {}) noexcept;
+
+/**
+ * Couples a slow scene simulation to the 1 kHz control loop.
+ *
+ * A background thread calls the update function at a fixed rate, typically 100 to 300 Hz, with the
+ * latest robot state handed over by render(). The update function runs the heavy simulation and
+ * fills in a franka::haptics::LocalModel, which is then handed back to the control loop. render()
+ * is meant to be called in every Robot::control callback: it publishes the robot state, picks up
+ * the latest local model and renders it. Both handoffs are wait-free, so a slow simulation never
+ * delays the control loop; it only makes the rendered model older.
+ *
+ * The simulation is timed by the control loop: each update receives the robot time elapsed since
+ * the previous update, taken from RobotState::time, and is skipped while no new robot state
+ * arrives, e.g. between control loops.
+ *
+ * The background thread runs with normal scheduling priority, so it does not compete with the
+ * control loop thread. If the update function throws, the thread stops and render() only returns
+ * the contact-free wrench from then on.
+ */
+class MultiRateCoupling {
+ public:
+  /**
+   * Updates the local model.
+   *
+   * The first parameter is the latest robot state, the second one the robot time since the last
+   * update, which is zero for the first update. The third parameter is the model to fill in; it
+   * contains the previous model.
+   */
+  using UpdateFunction = std::function<void(const RobotState&, Duration, LocalModel*)>;
+
+  /**
+   * Starts the simulation thread.
+   *
+   * @param[in] update Function that updates the local model.
+   * @param[in] update_rate Rate at which update is called. Unit: \f$[Hz]\f$
+   * @param[in] probe_offset Position of the rendered probe in end effector frame.
+   * Unit: \f$[m]\f$
+   *
+   * @throw std::invalid_argument if update is empty or update_rate is not in (0, 1000].
+   */
+  explicit MultiRateCoupling(UpdateFunction update,
+                             double update_rate = 200,
+                             const std::array<double, 3>& probe_offset = {});
+
+  /**
+   * Stops the simulation thread.
+   */
+  ~MultiRateCoupling() noexcept;
+
+  MultiRateCoupling(const MultiRateCoupling&) = delete;
+  MultiRateCoupling& operator=(const MultiRateCoupling&) = delete;
+
+  /**
+   * Publishes the robot state to the simulation and renders the latest local model. Does not block
+   * and does not allocate. May only be called by one thread at a time.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench.
+   */
+  SceneWrench render(const RobotState& robot_state,
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * @return Local model used by the last call to render(). May only be called by the thread that
+   * calls render().
+   */
+  const LocalModel& model() const noexcept;
+
+  /**
+   * @return Robot time between the local model used by the last call to render() and the robot
+   * state passed to it. May only be called by the thread that calls render().
+   */
+  Duration modelAge() const noexcept;
+
+  /**
+   * @return Number of completed updates.
+   */
+  uint64_t updates() const noexcept;
+
+  /**
+   * @return Exception thrown by the update function, or nullptr if there was none.
+   */
+  std::exception_ptr error() const;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace haptics
+}  // namespace franka
@@ -0,0 +1,252 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <franka/haptic_scene.h>
+#include <franka/model.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file haptic_distance_field.h
+ * Contains the franka::haptics::DistanceField and franka::haptics::DistanceFieldRenderer types to
+ * render precomputed signed distance fields, e.g. of fixtures or anatomy.
+ */
+
+namespace franka {
+namespace haptics {
+
+/**
+ * Immutable signed distance field sampled on a regular voxel grid.
+ *
+ * Distances are negative inside the solid. Every voxel also stores the gradient of the distance,
+ * computed by central differences when the field is created, so that a lookup only has to
+ * interpolate the eight voxels around the queried point. A lookup therefore takes constant time,
+ * independent of the complexity of the sampled geometry.
+ *
+ * The field is stored in a single buffer laid out like the binary format written by save(). load()
+ * memory-maps such a file and uses it in place. Copies share the buffer, so swapping fields is
+ * cheap.
+ *
+ * The binary format uses native byte order and consists of
+ *  - a 64 byte header: the magic string "FRKSDF" with two terminating zeros, format version, byte
+ *    order mark 0x01020304, number of voxels along x, y and z, padding, the grid origin and the
+ *    voxel size as `double`,
+ *  - voxels of 16 bytes each, x varying fastest: distance followed by the gradient as `float`.
+ */
+class DistanceField {
+ public:
+  /**
+   * Creates a distance field from sampled distances and computes its gradients.
+   *
+   * @param[in] dimensions Number of voxels along x, y and z, each at least 2.
+   * @param[in] origin Position of the first voxel in field frame. Unit: \f$[m]\f$
+   * @param[in] voxel_size Distance between neighboring voxels. Unit: \f$[m]\f$
+   * @param[in] distances Signed distance at every voxel, x varying fastest. Unit: \f$[m]\f$
+   *
+   * @throw std::invalid_argument if the number of distances does not match the dimensions, a
+   * dimension is smaller than 2, voxel_size is not positive, or a value is infinite or NaN.
+   */
+  DistanceField(const std::array<uint32_t, 3>& dimensions,
+                const std::array<double, 3>& origin,
+                double voxel_size,
+                const std::vector<float>& distances);
+
+  /**
+   * Memory-maps a distance field written by save().
+   *
+   * @param[in] path Path of the distance field file.
+   *
+   * @return Loaded distance field.
+   *
+   * @throw Exception if the file cannot be mapped or is not a valid distance field file.
+   */
+  static DistanceField load(const std::string& path);
+
+  /**
+   * Writes the distance field in the binary format.
+   *
+   * @param[in] path Path of the distance field file.
+   *
+   * @throw Exception if the file cannot be written.
+   */
+  void save(const std::string& path) const;
+
+  /**
+   * @return Number of voxels along x, y and z.
+   */
+  std::array<uint32_t, 3> dimensions() const noexcept;
+
+  /**
+   * @return Position of the first voxel in field frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> origin() const noexcept;
+
+  /**
+   * @return Distance between neighboring voxels. Unit: \f$[m]\f$
+   */
+  double voxelSize() const noexcept;
+
+  /**
+   * Interpolates distance and gradient trilinearly. Outside of the grid, the distance grows with
+   * the distance to the grid bounds and the gradient of the closest point on the bounds is used.
+   * Does not allocate memory.
+   *
+   * @param[in] point Point in field frame. Unit: \f$[m]\f$
+   * @param[out] gradient If not nullptr, gradient of the distance in field frame.
+   *
+   * @return Signed distance. Unit: \f$[m]\f$
+   */
+  double distance(const std::array<double, 3>& point,
+                  std::array<double, 3>* gradient = nullptr) const noexcept;
+
+ private:
+  struct Storage;
+
+  explicit DistanceField(std::shared_ptr<const Storage> storage);
+
+  void parse();
+
+  std::shared_ptr<const Storage> storage_;
+  std::array<uint32_t, 3> dimensions_{};
+  std::array<double, 3> origin_{};
+  double voxel_size_{};
+  const float* voxels_{};
+};
+
+/**
+ * Point on the robot that is rendered against a distance field.
+ */
+struct ProbePoint {
+  /**
+   * Frame the point is attached to.
+   */
+  Frame frame{Frame::kEndEffector};
+  /**
+   * Position of the point in that frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> position{};
+  /**
+   * Radius of the probe sphere around the point. Unit: \f$[m]\f$
+   */
+  double radius{};
+};
+
+/**
+ * Result of a franka::haptics::DistanceFieldRenderer query.
+ */
+struct ProbeTorques {
+  /**
+   * Joint torques of all contact forces. Unit: \f$[Nm]\f$
+   */
+  std::array<double, 7> tau_J{};  // NOLINT(readability-identifier-naming)
+  /**
+   * Number of probes in contact with the solid.
+   */
+  size_t contacts{};
+  /**
+   * Largest penetration depth of a probe into the solid. Unit: \f$[m]\f$
+   */
+  double max_penetration{};
+};
+
+/**
+ * Renders penalty forces of a distance field for a set of probe spheres on the robot.
+ *
+ * Every probe that penetrates the solid is pushed out along the distance gradient by a
+ * spring-damper force, using the franka::haptics::Material of the renderer. The forces are mapped
+ * to joint torques with the Jacobians of the frames the probes are attached to, so probes can be
+ * placed all along the tool and the links. The cost per cycle is constant per probe and rendering
+ * does not allocate memory, so it can be used in Robot::control torque callbacks.
+ */
+class DistanceFieldRenderer {
+ public:
+  /**
+   * Creates a renderer.
+   *
+   * @param[in] field Distance field to render.
+   * @param[in] probes Probe spheres on the robot.
+   * @param[in] material Contact properties of the solid.
+   * @param[in] O_T_F Pose of the field frame in base frame, column-major.
+   *
+   * @throw std::invalid_argument if O_T_F is not a homogeneous transformation, or a value is
+   * negative, infinite or NaN.
+   */
+  DistanceFieldRenderer(
+      DistanceField field,
+      std::vector<ProbePoint> probes,
+      const Material& material = {},
+      const std::array<double, 16>& O_T_F =  // NOLINT(readability-identifier-naming)
+      {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}});
+
+  /**
+   * Computes the contact torques for the given robot state, using Model::poseAll for the frame
+   * poses and Jacobians.
+   *
+   * @param[in] model Robot model.
+   * @param[in] robot_state Robot state.
+   *
+   * @return Contact torques.
+   */
+  ProbeTorques render(const Model& model, const RobotState& robot_state) noexcept;
+
+  /**
+   * Computes the contact torques for given frame poses and Jacobians.
+   *
+   * @param[in] poses Poses of all frames in base frame, e.g. from Model::poseAll.
+   * @param[in] zero_jacobians Zero Jacobians of all frames, e.g. from Model::poseAll.
+   * @param[in] dq Joint velocities, used for contact damping. Unit: \f$[\frac{rad}{s}]\f$
+   *
+   * @return Contact torques.
+   */
+  ProbeTorques render(const FramePoses& poses,
+                      const FrameJacobians& zero_jacobians,
+                      const std::array<double, 7>& dq) const noexcept;
+
+  /**
+   * Replaces the rendered distance field, e.g. between two motions. Does not touch the memory of
+   * the previous field in the control loop, but releases it in the calling thread if this was the
+   * last copy.
+   *
+   * @param[in] field New distance field.
+   */
+  void setField(DistanceField field) noexcept;
+
+  /**
+   * Moves the distance field.
+   *
+   * @param[in] O_T_F Pose of the field frame in base frame, column-major.
+   *
+   * @throw std::invalid_argument if O_T_F is not a homogeneous transformation.
+   */
+  void setFieldPose(const std::array<double, 16>& O_T_F);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return Rendered distance field.
+   */
+  const DistanceField& field() const noexcept;
+
+  /**
+   * @return Probe spheres on the robot.
+   */
+  const std::vector<ProbePoint>& probes() const noexcept;
+
+ private:
+  DistanceField field_;
+  std::vector<ProbePoint> probes_;
+  Material material_;
+  std::array<double, 9> rotation_;
+  std::array<double, 3> translation_;
+
+  FramePoses poses_;
+  FrameJacobians zero_jacobians_;
+};
+
+}  // namespace haptics
+}  // namespace franka
@@ -0,0 +1,220 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <franka/haptic_scene.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file haptic_mesh.h
+ * Contains the franka::haptics::TriangleMesh and franka::haptics::MeshRenderer types to render
+ * triangle meshes, e.g. CAD parts.
+ */
+
+namespace franka {
+namespace haptics {
+
+/**
+ * Immutable triangle mesh with a bounding volume hierarchy of its triangles.
+ *
+ * Triangles are one-sided: their front faces, from which the vertices appear in counter-clockwise
+ * order, point out of the solid.
+ *
+ * The mesh is stored in a single buffer laid out like the preprocessed binary format written by
+ * save(). load() memory-maps such a file and uses it in place, so even large meshes are available
+ * right after startup without parsing or rebuilding the hierarchy. Copies share the buffer.
+ *
+ * The binary format uses native byte order and consists of
+ *  - a 32 byte header: the magic string "FRKMESH" with a terminating zero, format version,
+ *    byte order mark 0x01020304, number of vertices, triangles and hierarchy nodes, and padding,
+ *  - `double` vertex coordinates, three per vertex,
+ *  - `uint32_t` vertex indices, three per triangle, padded to a multiple of 8 bytes,
+ *  - hierarchy nodes of 56 bytes each: minimum and maximum corner of the bounds as `double`,
+ *    followed by two `uint32_t` describing the children or triangles of the node.
+ */
+class TriangleMesh {
+ public:
+  /**
+   * Creates a mesh and builds its bounding volume hierarchy. Triangles may be reordered.
+   *
+   * @param[in] vertices Vertex positions. Unit: \f$[m]\f$
+   * @param[in] triangles Vertex indices of every triangle.
+   *
+   * @throw std::invalid_argument if there are no triangles, an index is out of range or a vertex
+   * is infinite or NaN.
+   */
+  TriangleMesh(const std::vector<std::array<double, 3>>& vertices,
+               const std::vector<std::array<uint32_t, 3>>& triangles);
+
+  /**
+   * Memory-maps a mesh written by save().
+   *
+   * @param[in] path Path of the mesh file.
+   *
+   * @return Loaded mesh.
+   *
+   * @throw Exception if the file cannot be mapped or is not a valid mesh file.
+   */
+  static TriangleMesh load(const std::string& path);
+
+  /**
+   * Writes the mesh in the preprocessed binary format.
+   *
+   * @param[in] path Path of the mesh file.
+   *
+   * @throw Exception if the file cannot be written.
+   */
+  void save(const std::string& path) const;
+
+  /**
+   * @return Number of vertices.
+   */
+  size_t vertexCount() const noexcept;
+
+  /**
+   * @return Number of triangles.
+   */
+  size_t triangleCount() const noexcept;
+
+  /**
+   * @param[in] index Index of the vertex, smaller than vertexCount().
+   *
+   * @return Position of the vertex. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> vertex(size_t index) const noexcept;
+
+  /**
+   * @param[in] index Index of the triangle, smaller than triangleCount().
+   *
+   * @return Vertex indices of the triangle.
+   */
+  std::array<uint32_t, 3> triangle(size_t index) const noexcept;
+
+ private:
+  friend class MeshRenderer;
+
+  struct Node;
+  struct Storage;
+
+  explicit TriangleMesh(std::shared_ptr<const Storage> storage);
+
+  void parse();
+
+  std::shared_ptr<const Storage> storage_;
+  uint32_t vertex_count_{};
+  uint32_t triangle_count_{};
+  uint32_t node_count_{};
+  const double* vertices_{};
+  const uint32_t* triangles_{};
+  const Node* nodes_{};
+};
+
+/**
+ * Renders a triangle mesh with the god-object algorithm.
+ *
+ * The end effector is represented by a point probe. A proxy ("god object") follows the probe
+ * without passing through the mesh: every cycle it moves towards the probe, stops at the first
+ * front face in its way and slides along up to three such constraint faces. The contact force is
+ * a spring-damper between proxy and probe, using the franka::haptics::Material of the renderer.
+ *
+ * The proxy only moves by the short distance the probe travelled since the last cycle, so only the
+ * hierarchy nodes along that path are visited, and the faces that constrained the proxy in the
+ * last cycle are tested first to cut the search short. The cost per cycle therefore stays nearly
+ * constant regardless of the mesh size. Rendering does not allocate memory, so it can be used in
+ * Robot::control torque callbacks; the returned wrench can be added to the one of a
+ * franka::haptics::Scene.
+ */
+class MeshRenderer {
+ public:
+  /**
+   * Creates a renderer.
+   *
+   * @param[in] mesh Mesh to render.
+   * @param[in] material Contact properties of the mesh.
+   * @param[in] O_T_M Pose of the mesh in base frame, column-major.
+   * @param[in] probe_offset Position of the probe in end effector frame. Unit: \f$[m]\f$
+   *
+   * @throw std::invalid_argument if O_T_M is not a homogeneous transformation, or a value is
+   * negative, infinite or NaN.
+   */
+  explicit MeshRenderer(
+      TriangleMesh mesh,
+      const Material& material = {},
+      const std::array<double, 16>& O_T_M =  // NOLINT(readability-identifier-naming)
+      {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}},
+      const std::array<double, 3>& probe_offset = {});
+
+  /**
+   * Moves the proxy towards the probe and computes the contact wrench.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench. SceneWrench::contacts is the number of constraint faces.
+   */
+  SceneWrench render(const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * Moves the proxy towards the probe and computes the contact wrench for the end effector pose
+   * RobotState::O_T_EE.
+   *
+   * @param[in] robot_state Robot state.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench.
+   */
+  SceneWrench render(const RobotState& robot_state,
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * Places the proxy at the probe in the next call to render(). The probe has to be outside of
+   * the mesh at that time.
+   */
+  void reset() noexcept;
+
+  /**
+   * Moves the mesh. Call reset() if this moves the mesh onto the probe.
+   *
+   * @param[in] O_T_M Pose of the mesh in base frame, column-major.
+   *
+   * @throw std::invalid_argument if O_T_M is not a homogeneous transformation.
+   */
+  void setMeshPose(const std::array<double, 16>& O_T_M);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return Position of the proxy in base frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> proxy() const noexcept;
+
+  /**
+   * @return Rendered mesh.
+   */
+  const TriangleMesh& mesh() const noexcept;
+
+ private:
+  static constexpr size_t kMaxConstraints = 3;
+
+  TriangleMesh mesh_;
+  Material material_;
+  std::array<double, 9> rotation_;
+  std::array<double, 3> translation_;
+  std::array<double, 3> probe_offset_;
+
+  bool initialized_{false};
+  std::array<double, 3> proxy_{};
+  std::array<uint32_t, kMaxConstraints> constraints_{};
+  size_t constraint_count_{};
+};
+
+}  // namespace haptics
+}  // namespace franka
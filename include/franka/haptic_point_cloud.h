@@ -0,0 +1,123 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <franka/haptic_scene.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file haptic_point_cloud.h
+ * Contains the franka::haptics::PointCloudRenderer type to render streamed point clouds, e.g. of
+ * depth cameras.
+ */
+
+namespace franka {
+namespace haptics {
+
+/**
+ * Renders streamed point clouds for a spherical probe.
+ *
+ * Every new point cloud passed to update() is indexed by a background thread in a spatial hash
+ * of voxels with an edge length of half the probe radius, each holding the centroid of its
+ * points. Finished indices are handed to the control thread with the same wait-free triple
+ * buffering as franka::haptics::MultiRateCoupling, and the buffers of old indices are reused, so
+ * indexing never blocks render() and does not allocate once the buffers have grown to the cloud
+ * size. Clouds that arrive while an index is being built replace each other, so only the latest
+ * one is indexed next.
+ *
+ * render() only looks up the at most 125 voxels overlapping the probe, so a query takes bounded
+ * time and does not allocate memory, regardless of the cloud size and density. The centroids
+ * inside the probe push it out with a spring-damper force. Where they locally form a surface, the
+ * contact normal is the normal of a weighted plane fit and the penetration is measured to that
+ * plane, so the force does not depend on how densely the surface is sampled.
+ */
+class PointCloudRenderer {
+ public:
+  /**
+   * Starts the indexing thread.
+   *
+   * @param[in] probe_radius Radius of the probe sphere. Unit: \f$[m]\f$
+   * @param[in] material Contact properties of the point cloud.
+   * @param[in] probe_offset Position of the probe center in end effector frame. Unit: \f$[m]\f$
+   *
+   * @throw std::invalid_argument if probe_radius is not positive, or a value is negative, infinite
+   * or NaN.
+   */
+  explicit PointCloudRenderer(double probe_radius = 0.01,
+                              const Material& material = {},
+                              const std::array<double, 3>& probe_offset = {});
+
+  /**
+   * Stops the indexing thread.
+   */
+  ~PointCloudRenderer() noexcept;
+
+  PointCloudRenderer(const PointCloudRenderer&) = delete;
+  PointCloudRenderer& operator=(const PointCloudRenderer&) = delete;
+
+  /**
+   * Replaces the point cloud. Copies the points and returns without waiting for them to be
+   * indexed. Can be called from any thread, but not from the control thread. Infinite and NaN
+   * points, e.g. invalid depth pixels, are skipped.
+   *
+   * @param[in] points Points in camera frame. Unit: \f$[m]\f$
+   * @param[in] O_T_C Pose of the camera frame in base frame, column-major.
+   *
+   * @throw std::invalid_argument if O_T_C is not a homogeneous transformation.
+   */
+  void update(const std::vector<std::array<double, 3>>& points,
+              const std::array<double, 16>& O_T_C =  // NOLINT(readability-identifier-naming)
+              {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}});
+
+  /**
+   * Picks up the latest index and computes the contact wrench. Does not block and does not
+   * allocate. May only be called by one thread at a time.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench. SceneWrench::contacts is the number of voxel centroids inside the
+   * probe.
+   */
+  SceneWrench render(const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * Picks up the latest index and computes the contact wrench for the end effector pose
+   * RobotState::O_T_EE.
+   *
+   * @param[in] robot_state Robot state.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench.
+   */
+  SceneWrench render(const RobotState& robot_state,
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * @return Number of occupied voxels of the index used by the last call to render(). May only be
+   * called by the thread that calls render().
+   */
+  size_t pointCount() const noexcept;
+
+  /**
+   * @return Number of point clouds indexed so far.
+   */
+  uint64_t builds() const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace haptics
+}  // namespace franka
@@ -0,0 +1,169 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <franka/control_types.h>
+#include <franka/haptic_scene.h>
+
+/**
+ * @file haptic_query_pool.h
+ * Contains the franka::haptics::QueryPool type to run many franka::haptics::Scene queries in
+ * parallel within a control cycle.
+ */
+
+namespace franka {
+namespace haptics {
+
+/**
+ * One query of a batch run by a franka::haptics::QueryPool.
+ */
+struct ProbeQuery {
+  /**
+   * Scene to query. Several queries of a batch may use the same scene, e.g. one per probe point of
+   * a tool, or different scenes, e.g. one per arm.
+   */
+  const Scene* scene{nullptr};
+  /**
+   * End effector pose in base frame, column-major. See Scene::query().
+   */
+  std::array<double, 16> O_T_EE{  // NOLINT(readability-identifier-naming)
+      {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  /**
+   * Translational end effector velocity in base frame. Unit: \f$[\frac{m}{s}]\f$
+   */
+  std::array<double, 3> velocity{};
+};
+
+/**
+ * Configures the worker threads of a franka::haptics::QueryPool.
+ */
+struct QueryPoolOptions {
+  /**
+   * CPUs to start one worker thread on, each pinned to its CPU. Spare isolated CPUs, e.g. those
+   * returned by isolatedCpus() except the one of the control loop thread, give the lowest
+   * latency. If empty, all queries run on the calling thread.
+   */
+  std::vector<int> cpus{};
+  /**
+   * Whether the worker threads must run with realtime priority. With RealtimeConfig::kEnforce,
+   * the constructor throws if a worker cannot be pinned or prioritized.
+   */
+  RealtimeConfig realtime_config{RealtimeConfig::kEnforce};
+  /**
+   * Time that run() waits for queries taken by workers once the calling thread has no queries
+   * left. Queries that are not finished by then are computed again by the calling thread.
+   */
+  std::chrono::microseconds join_timeout{std::chrono::microseconds(200)};
+  /**
+   * Time that idle workers poll for the next batch before they go to sleep. Polling avoids the
+   * wake-up latency of sleeping threads, so it should be longer than a control cycle.
+   */
+  std::chrono::microseconds spin_duration{std::chrono::milliseconds(2)};
+};
+
+/**
+ * Statistics of a franka::haptics::QueryPool.
+ */
+struct QueryPoolStatistics {
+  /**
+   * Number of batches run with the help of the workers.
+   */
+  uint64_t batches{};
+  /**
+   * Number of queries run by the workers.
+   */
+  uint64_t worker_queries{};
+  /**
+   * Number of batches in which the join timeout expired.
+   */
+  uint64_t late_joins{};
+  /**
+   * Number of queries that the calling thread computed again because a worker was late.
+   */
+  uint64_t recomputed_queries{};
+  /**
+   * Number of batches run on the calling thread alone, because a worker was still busy with a
+   * late query of an earlier batch.
+   */
+  uint64_t serial_batches{};
+};
+
+/**
+ * Runs batches of franka::haptics::Scene queries on a small pool of pinned worker threads, e.g.
+ * for tools with many probe points or several arms.
+ *
+ * The calling thread, usually the control loop thread, takes part in every batch. The queries are
+ * split into one contiguous range per thread. Every thread takes queries from its own range and,
+ * once that is empty, steals queries from the ranges of the others, so a worker that is preempted
+ * or slow does not hold up the batch. The calling thread then waits at most
+ * QueryPoolOptions::join_timeout for queries still running on workers and computes late ones
+ * itself, so run() always returns complete results within a bounded time.
+ *
+ * Workers write into storage of the pool, from which run() copies the finished results. A worker
+ * that is still busy with a late query makes the next batches run on the calling thread, until it
+ * has finished.
+ *
+ * run() does not allocate and does not take locks, except to wake workers that went to sleep.
+ * Scene queries are const, so scenes can be shared by the workers, but must not be modified while
+ * a batch runs.
+ */
+class QueryPool {
+ public:
+  /**
+   * Maximum number of queries run in parallel. Larger batches are run in chunks of this size.
+   */
+  static constexpr size_t kMaxQueries = 256;
+
+  /**
+   * Starts the worker threads.
+   *
+   * @param[in] options Worker configuration.
+   *
+   * @throw std::invalid_argument if a CPU is negative, listed twice or a time is negative.
+   * @throw RealtimeException if QueryPoolOptions::realtime_config is RealtimeConfig::kEnforce and
+   * a worker cannot be pinned to its CPU or run with realtime priority.
+   */
+  explicit QueryPool(const QueryPoolOptions& options = QueryPoolOptions());
+
+  /**
+   * Stops the worker threads.
+   */
+  ~QueryPool() noexcept;
+
+  QueryPool(const QueryPool&) = delete;
+  QueryPool& operator=(const QueryPool&) = delete;
+
+  /**
+   * Runs a batch of queries. Must only be called by one thread at a time.
+   *
+   * @param[in] queries Queries to run. Queries without a scene result in an empty wrench.
+   * @param[in] count Number of queries.
+   * @param[out] results Storage for count results, in the order of the queries.
+   */
+  void run(const ProbeQuery* queries, size_t count, SceneWrench* results) noexcept;
+
+  /**
+   * @return Number of worker threads.
+   */
+  size_t workers() const noexcept;
+
+  /**
+   * @return Statistics since the pool was created.
+   */
+  QueryPoolStatistics statistics() const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace haptics
+}  // namespace franka
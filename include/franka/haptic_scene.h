@@ -0,0 +1,344 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <franka/robot_state.h>
+
+/**
+ * @file haptic_scene.h
+ * Contains the franka::haptics::Scene type to render virtual environments made of geometric
+ * primitives.
+ */
+
+namespace franka {
+
+/**
+ * Haptic rendering of virtual environments.
+ */
+namespace haptics {
+
+/**
+ * Contact properties of a primitive.
+ */
+struct Material {
+  /**
+   * Contact stiffness. Unit: \f$[\frac{N}{m}]\f$
+   */
+  double stiffness{2000};
+  /**
+   * Contact damping along the contact normal. Unit: \f$[\frac{N \cdot s}{m}]\f$
+   */
+  double damping{10};
+};
+
+/**
+ * Result of a franka::haptics::Scene query.
+ */
+struct SceneWrench {
+  /**
+   * Wrench acting on the end effector, expressed in base frame and about the end effector origin.
+   * Forces in \f$[N]\f$, torques in \f$[Nm]\f$. Can be mapped to joint torques with
+   * wrenchToJointTorques().
+   */
+  std::array<double, 6> O_F{};  // NOLINT(readability-identifier-naming)
+  /**
+   * Number of primitives in contact with the probe.
+   */
+  size_t contacts{};
+  /**
+   * Largest penetration depth of the probe into a primitive. Unit: \f$[m]\f$
+   */
+  double max_penetration{};
+};
+
+/**
+ * Contact between the probe and a primitive of a franka::haptics::Scene.
+ */
+struct Contact {
+  /**
+   * Point on the probe surface that touches the primitive, in base frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> point{};
+  /**
+   * Outward surface normal of the primitive, in base frame.
+   */
+  std::array<double, 3> normal{};
+  /**
+   * Penetration depth of the probe into the primitive. Unit: \f$[m]\f$
+   */
+  double penetration{};
+  /**
+   * Magnitude of the rendered normal force. Unit: \f$[N]\f$
+   */
+  double normal_force{};
+  /**
+   * Contact properties of the primitive.
+   */
+  Material material{};
+  /**
+   * Index of the primitive in the scene.
+   */
+  size_t primitive{};
+};
+
+/**
+ * Contacts found by a franka::haptics::Scene query, stored without allocating.
+ */
+struct ContactSet {
+  /**
+   * Maximum number of stored contacts. Further contacts are rendered, but not stored.
+   */
+  static constexpr size_t kMaxContacts = 8;
+
+  /**
+   * Stored contacts, ordered as found.
+   */
+  std::array<Contact, kMaxContacts> contacts{};
+  /**
+   * Number of stored contacts.
+   */
+  size_t size{};
+};
+
+/**
+ * Virtual environment made of planes, spheres, boxes, capsules and cylinders.
+ *
+ * The end effector is represented by a spherical probe. Every primitive the probe penetrates
+ * pushes it out along the surface normal with a spring-damper force given by the
+ * franka::haptics::Material of the primitive.
+ *
+ * Primitives are stored by type in contiguous arrays. All primitives except planes are indexed by
+ * a bounding volume hierarchy that is rebuilt whenever a primitive is added, so queries only test
+ * primitives near the probe. Queries do not allocate memory and their run time is bounded by the
+ * number of primitives, which allows rendering dozens of primitives at 1 kHz.
+ */
+class Scene {
+ public:
+  /**
+   * Creates an empty scene.
+   *
+   * @param[in] probe_radius Radius of the probe sphere. Unit: \f$[m]\f$
+   * @param[in] probe_offset Position of the probe center in end effector frame. Unit: \f$[m]\f$
+   *
+   * @throw std::invalid_argument if probe_radius is negative, or a value is infinite or NaN.
+   */
+  explicit Scene(double probe_radius = 0.01, const std::array<double, 3>& probe_offset = {});
+
+  /**
+   * Adds a plane. The half-space behind the plane is solid.
+   *
+   * @param[in] point Point on the plane. Unit: \f$[m]\f$
+   * @param[in] normal Normal of the plane, pointing out of the solid. Does not need to be
+   * normalized.
+   * @param[in] material Contact properties.
+   *
+   * @return Index of the primitive in the scene.
+   *
+   * @throw std::invalid_argument if the normal is zero or a value is infinite or NaN.
+   */
+  size_t addPlane(const std::array<double, 3>& point,
+                  const std::array<double, 3>& normal,
+                  const Material& material = {});
+
+  /**
+   * Adds a sphere.
+   *
+   * @param[in] center Center of the sphere. Unit: \f$[m]\f$
+   * @param[in] radius Radius of the sphere. Unit: \f$[m]\f$
+   * @param[in] material Contact properties.
+   *
+   * @return Index of the primitive in the scene.
+   *
+   * @throw std::invalid_argument if the radius is not positive or a value is infinite or NaN.
+   */
+  size_t addSphere(const std::array<double, 3>& center,
+                   double radius,
+                   const Material& material = {});
+
+  /**
+   * Adds a box.
+   *
+   * @param[in] pose Pose of the box center as column-major homogeneous transformation matrix.
+   * @param[in] half_extents Half of the edge lengths along the box axes. Unit: \f$[m]\f$
+   * @param[in] material Contact properties.
+   *
+   * @return Index of the primitive in the scene.
+   *
+   * @throw std::invalid_argument if the pose is not a homogeneous transformation or an extent is
+   * not positive.
+   */
+  size_t addBox(const std::array<double, 16>& pose,
+                const std::array<double, 3>& half_extents,
+                const Material& material = {});
+
+  /**
+   * Adds a capsule, i.e. all points within a distance of a line segment.
+   *
+   * @param[in] start Start of the segment. Unit: \f$[m]\f$
+   * @param[in] end End of the segment. Unit: \f$[m]\f$
+   * @param[in] radius Radius of the capsule. Unit: \f$[m]\f$
+   * @param[in] material Contact properties.
+   *
+   * @return Index of the primitive in the scene.
+   *
+   * @throw std::invalid_argument if the radius is not positive or a value is infinite or NaN.
+   */
+  size_t addCapsule(const std::array<double, 3>& start,
+                    const std::array<double, 3>& end,
+                    double radius,
+                    const Material& material = {});
+
+  /**
+   * Adds a cylinder with flat caps.
+   *
+   * @param[in] start Center of the first cap. Unit: \f$[m]\f$
+   * @param[in] end Center of the second cap. Unit: \f$[m]\f$
+   * @param[in] radius Radius of the cylinder. Unit: \f$[m]\f$
+   * @param[in] material Contact properties.
+   *
+   * @return Index of the primitive in the scene.
+   *
+   * @throw std::invalid_argument if the radius is not positive, start and end are equal or a
+   * value is infinite or NaN.
+   */
+  size_t addCylinder(const std::array<double, 3>& start,
+                     const std::array<double, 3>& end,
+                     double radius,
+                     const Material& material = {});
+
+  /**
+   * Removes all primitives.
+   */
+  void clear() noexcept;
+
+  /**
+   * @return Number of primitives in the scene.
+   */
+  size_t size() const noexcept;
+
+  /**
+   * Computes the contact wrench for an end effector pose.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench.
+   */
+  SceneWrench query(const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                    const std::array<double, 3>& velocity = {}) const noexcept;
+
+  /**
+   * Computes the contact wrench for the end effector pose RobotState::O_T_EE.
+   *
+   * @param[in] robot_state Robot state.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench.
+   */
+  SceneWrench query(const RobotState& robot_state,
+                    const std::array<double, 3>& velocity = {}) const noexcept;
+
+  /**
+   * Computes the contact wrench for an end effector pose and reports the individual contacts,
+   * e.g. to render surface properties with a franka::haptics::SurfaceRenderer.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] velocity Translational end effector velocity in base frame, used for contact
+   * damping. Unit: \f$[\frac{m}{s}]\f$
+   * @param[out] contacts Contacts of the probe with the primitives.
+   *
+   * @return Contact wrench.
+   */
+  SceneWrench query(const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                    const std::array<double, 3>& velocity,
+                    ContactSet* contacts) const noexcept;
+
+ private:
+  enum class Type : uint8_t { kSphere, kBox, kCapsule, kCylinder };
+
+  struct Plane {
+    std::array<double, 3> point;
+    std::array<double, 3> normal;
+    Material material;
+    uint32_t id;
+  };
+
+  struct Sphere {
+    std::array<double, 3> center;
+    double radius;
+    Material material;
+  };
+
+  struct Box {
+    std::array<double, 9> rotation;
+    std::array<double, 3> translation;
+    std::array<double, 3> half_extents;
+    Material material;
+  };
+
+  // Capsules and cylinders share the same parameters.
+  struct Segment {
+    std::array<double, 3> start;
+    std::array<double, 3> end;
+    double radius;
+    Material material;
+  };
+
+  struct Bounds {
+    std::array<double, 3> min;
+    std::array<double, 3> max;
+  };
+
+  struct Reference {
+    Type type;
+    uint32_t index;
+    uint32_t id;
+    Bounds bounds;
+  };
+
+  // Inner nodes have count == 0, their left child directly follows them and their right child is
+  // at first. Leaves reference the primitives [first, first + count) of references_.
+  struct Node {
+    Bounds bounds;
+    uint32_t first;
+    uint32_t count;
+  };
+
+  void add(Type type, size_t index, const Bounds& bounds);
+  void rebuild();
+  uint32_t build(uint32_t first, uint32_t count, uint32_t depth);
+
+  double probe_radius_;
+  std::array<double, 3> probe_offset_;
+
+  std::vector<Plane> planes_;
+  std::vector<Sphere> spheres_;
+  std::vector<Box> boxes_;
+  std::vector<Segment> capsules_;
+  std::vector<Segment> cylinders_;
+
+  std::vector<Reference> references_;
+  std::vector<Node> nodes_;
+};
+
+/**
+ * Maps a wrench to joint torques with \f$\tau = J^T F\f$.
+ *
+ * @param[in] zero_jacobian Zero Jacobian of the end effector, column-major, e.g. from
+ * Model::zeroJacobian.
+ * @param[in] wrench Wrench in base frame.
+ *
+ * @return Joint torques. Unit: \f$[Nm]\f$
+ */
+std::array<double, 7> wrenchToJointTorques(const std::array<double, 42>& zero_jacobian,
+                                           const std::array<double, 6>& wrench) noexcept;
+
+}  // namespace haptics
+}  // namespace franka
@@ -0,0 +1,256 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <franka/haptic_scene.h>
+
+/**
+ * @file haptic_surface.h
+ * Contains the franka::haptics::SurfaceTexture and franka::haptics::SurfaceRenderer types to render
+ * surface textures and friction on top of the contacts of a franka::haptics::Scene.
+ */
+
+namespace franka {
+namespace haptics {
+
+/**
+ * Periodic height map of a surface, precomputed into a small lookup table.
+ *
+ * The height function is evaluated once on a square grid of `resolution` x `resolution` texels
+ * covering one period of the texture. Every texel also stores the gradient of the height, computed
+ * by central differences, so a lookup only interpolates four neighboring texels. With the default
+ * resolution of 32, the table takes 12 KiB and stays in the L1 cache of the control loop thread,
+ * no matter how expensive the height function is. Copies share the table.
+ */
+class SurfaceTexture {
+ public:
+  /**
+   * Function returning the height of the surface at texture coordinates (u, v). Unit: \f$[m]\f$
+   * It has to be periodic in both coordinates with the period of the texture.
+   */
+  using HeightFunction = std::function<double(double u, double v)>;
+
+  /**
+   * Precomputes a texture from a height function.
+   *
+   * @param[in] height Height function, periodic with `period` in both coordinates.
+   * @param[in] period Edge length of one tile of the texture. Unit: \f$[m]\f$
+   * @param[in] resolution Number of texels along each edge of a tile. Must be a power of two
+   * between 4 and 256.
+   *
+   * @throw std::invalid_argument if height is empty, period is not positive, the resolution is
+   * invalid, or the height function returns infinite or NaN values.
+   */
+  SurfaceTexture(const HeightFunction& height, double period, size_t resolution = 32);
+
+  /**
+   * Creates a grating of parallel sinusoidal ridges along v.
+   *
+   * @param[in] wavelength Distance between two ridges. Unit: \f$[m]\f$
+   * @param[in] amplitude Height of the ridges above the mean surface. Unit: \f$[m]\f$
+   * @param[in] resolution Number of texels per wavelength.
+   *
+   * @return Grating texture.
+   *
+   * @throw std::invalid_argument if wavelength is not positive or the resolution is invalid.
+   */
+  static SurfaceTexture grating(double wavelength, double amplitude, size_t resolution = 32);
+
+  /**
+   * Creates a rough surface from smoothly interpolated random heights.
+   *
+   * @param[in] wavelength Typical distance between two bumps. Unit: \f$[m]\f$
+   * @param[in] amplitude Largest height above the mean surface. Unit: \f$[m]\f$
+   * @param[in] seed Seed of the random heights.
+   * @param[in] resolution Number of texels along each edge of a tile of four wavelengths.
+   *
+   * @return Noise texture.
+   *
+   * @throw std::invalid_argument if wavelength is not positive or the resolution is invalid.
+   */
+  static SurfaceTexture noise(double wavelength,
+                              double amplitude,
+                              uint32_t seed = 0,
+                              size_t resolution = 32);
+
+  /**
+   * Looks up the height at texture coordinates (u, v). Does not allocate.
+   *
+   * @param[in] u First texture coordinate. Unit: \f$[m]\f$
+   * @param[in] v Second texture coordinate. Unit: \f$[m]\f$
+   * @param[out] gradient If not null, receives the gradient of the height along u and v.
+   *
+   * @return Interpolated height. Unit: \f$[m]\f$
+   */
+  double height(double u, double v, std::array<double, 2>* gradient = nullptr) const noexcept;
+
+  /**
+   * @return Edge length of one tile of the texture. Unit: \f$[m]\f$
+   */
+  double period() const noexcept;
+
+  /**
+   * @return Number of texels along each edge of a tile.
+   */
+  size_t resolution() const noexcept;
+
+ private:
+  std::shared_ptr<const std::vector<float>> texels_;
+  double period_;
+  size_t resolution_;
+};
+
+/**
+ * Surface properties rendered by a franka::haptics::SurfaceRenderer in addition to the contact
+ * force of a franka::haptics::Material.
+ */
+struct SurfaceMaterial {
+  /**
+   * Height map of the surface, or null for a smooth surface.
+   */
+  std::shared_ptr<const SurfaceTexture> texture;
+  /**
+   * Static friction coefficient. The contact sticks until the tangential force exceeds
+   * static_friction times the normal force.
+   */
+  double static_friction{0.5};
+  /**
+   * Kinetic friction coefficient, at most static_friction. Determines the friction force while
+   * sliding.
+   */
+  double kinetic_friction{0.4};
+  /**
+   * Stiffness of the tangential spring that holds a sticking contact. Unit: \f$[\frac{N}{m}]\f$
+   */
+  double tangential_stiffness{2000};
+  /**
+   * Damping of a sticking contact along the surface. Unit: \f$[\frac{N \cdot s}{m}]\f$
+   */
+  double tangential_damping{5};
+};
+
+/**
+ * Friction state of a contact.
+ */
+enum class FrictionState {
+  /** The probe does not touch the primitive. */
+  kNone,
+  /** The contact is held by the tangential spring. */
+  kStick,
+  /** The contact slides with kinetic friction. */
+  kSlip
+};
+
+/**
+ * Renders surface textures and stick-slip friction for the contacts reported by a
+ * franka::haptics::Scene.
+ *
+ * Every textured contact looks up the height h and its gradient at the contact point and displaces
+ * the surface by h. The normal force then changes by the contact stiffness times h, and the surface
+ * normal tilts against the gradient, which pushes the probe off the bumps sideways. Texture
+ * coordinates are the contact point projected onto a tangent basis of the surface normal, which
+ * suits flat faces best.
+ *
+ * Friction uses a state machine per contact. A sticking contact anchors the probe on the surface
+ * with a tangential spring-damper. Once the spring force leaves the static friction cone, the
+ * contact slips: the anchor is dragged along so that the spring force stays on the kinetic
+ * friction cone. The contact sticks again as soon as the spring force falls back inside it.
+ *
+ * Surface materials are assigned to primitives by their scene index. Per tick and contact, the
+ * renderer costs one table lookup for the material and one texture lookup; it never allocates.
+ */
+class SurfaceRenderer {
+ public:
+  /**
+   * Creates a renderer without materials.
+   */
+  SurfaceRenderer() = default;
+
+  /**
+   * Adds a surface material.
+   *
+   * @param[in] material Surface material.
+   *
+   * @return Index of the material.
+   *
+   * @throw std::invalid_argument if a parameter is negative, infinite or NaN, or kinetic_friction
+   * exceeds static_friction.
+   */
+  size_t addMaterial(const SurfaceMaterial& material);
+
+  /**
+   * Assigns a surface material to a primitive of the scene.
+   *
+   * @param[in] primitive Index of the primitive in the scene.
+   * @param[in] material Index returned by addMaterial().
+   *
+   * @throw std::invalid_argument if the material does not exist.
+   */
+  void assign(size_t primitive, size_t material);
+
+  /**
+   * Queries the scene and renders surface properties for all contacts.
+   *
+   * @param[in] scene Scene to query.
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] velocity Translational end effector velocity in base frame, used for damping.
+   * Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench including texture and friction forces.
+   */
+  SceneWrench render(const Scene& scene,
+                     const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * Adds texture and friction forces to the output of Scene::query.
+   *
+   * @param[in] wrench Contact wrench returned by the scene.
+   * @param[in] contacts Contacts reported by the scene.
+   * @param[in] O_T_EE End effector pose the scene was queried with.
+   * @param[in] velocity Translational end effector velocity in base frame, used for damping.
+   * Unit: \f$[\frac{m}{s}]\f$
+   *
+   * @return Contact wrench including texture and friction forces.
+   */
+  SceneWrench render(const SceneWrench& wrench,
+                     const ContactSet& contacts,
+                     const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                     const std::array<double, 3>& velocity = {}) noexcept;
+
+  /**
+   * @param[in] primitive Index of the primitive in the scene.
+   *
+   * @return Friction state of the contact with the primitive in the last render() call.
+   */
+  FrictionState frictionState(size_t primitive) const noexcept;
+
+  /**
+   * Releases all sticking contacts.
+   */
+  void reset() noexcept;
+
+ private:
+  static constexpr uint32_t kNoMaterial = 0xFFFFFFFF;
+
+  struct Friction {
+    size_t primitive;
+    FrictionState state;
+    std::array<double, 3> anchor;
+  };
+
+  std::vector<SurfaceMaterial> materials_;
+  std::vector<uint32_t> assignments_;
+  std::array<Friction, ContactSet::kMaxContacts> friction_{};
+  size_t friction_count_{0};
+};
+
+}  // namespace haptics
+}  // namespace franka
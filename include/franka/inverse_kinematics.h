@@ -0,0 +1,129 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <franka/rate_limiting.h>
+
+/**
+ * @file inverse_kinematics.h
+ * Contains the franka::InverseKinematics type for closed-form inverse kinematics of a Panda robot.
+ */
+
+namespace franka {
+
+/**
+ * Joint positions that reach a pose, as computed by franka::InverseKinematics.
+ */
+struct InverseKinematicsSolutions {
+  /**
+   * Largest number of solutions for one pose and one position of the last joint.
+   */
+  static constexpr size_t kMaxSolutions = 8;
+
+  /**
+   * Solutions, of which the first #size are valid, ordered by their distance to the reference
+   * joint positions. Unit: \f$[rad]\f$
+   */
+  std::array<std::array<double, 7>, kMaxSolutions> q{};
+
+  /**
+   * Number of solutions. Zero if the pose cannot be reached.
+   */
+  size_t size{0};
+};
+
+/**
+ * Closed-form inverse kinematics of a Panda robot.
+ *
+ * The arm has seven joints, so a pose is reached by a one-dimensional family of joint positions.
+ * The redundancy is resolved by giving the position of the last joint, for which the remaining six
+ * joints follow in closed form: the wrist center is determined by the pose and the last joint,
+ * the elbow joint by the distance from the shoulder to the wrist center, and the other joints by
+ * the orientations of the resulting links. Up to eight solutions exist, from the two shoulder,
+ * elbow and wrist configurations. Solutions outside of the joint position limits are discarded.
+ *
+ * A query takes constant time, a few microseconds, and does not allocate memory, so it can run in
+ * every Robot::control callback.
+ */
+class InverseKinematics {
+ public:
+  /**
+   * Creates a solver.
+   *
+   * @param[in] F_T_EE End effector pose in flange frame, column-major, e.g. RobotState::F_T_EE.
+   * @param[in] min_joint_position Lower joint position limits. Unit: \f$[rad]\f$
+   * @param[in] max_joint_position Upper joint position limits. Unit: \f$[rad]\f$
+   *
+   * @throw std::invalid_argument if F_T_EE is not a homogeneous transformation, or a lower limit is
+   * larger than its upper limit.
+   */
+  explicit InverseKinematics(
+      const std::array<double, 16>& F_T_EE =  // NOLINT(readability-identifier-naming)
+      {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}},
+      const std::array<double, 7>& min_joint_position = kMinJointPosition,
+      const std::array<double, 7>& max_joint_position = kMaxJointPosition);
+
+  /**
+   * Computes all joint positions that reach the given end effector pose.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] q7 Position of the last joint. Unit: \f$[rad]\f$
+   * @param[in] q_reference Joint positions the solutions are ordered by. The first joint is taken
+   * from here if the shoulder is singular, i.e. the upper arm points straight up or down.
+   * Unit: \f$[rad]\f$
+   *
+   * @return Solutions within the joint position limits.
+   */
+  InverseKinematicsSolutions solve(
+      const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+      double q7,
+      const std::array<double, 7>& q_reference) const noexcept;
+
+  /**
+   * Computes the joint positions closest to the current ones that reach the given end effector
+   * pose, e.g. to follow a Cartesian pose with a joint position motion generator. Pass
+   * `q_current[6]` as q7 to keep the last joint in place.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] q7 Position of the last joint. Unit: \f$[rad]\f$
+   * @param[in] q_current Current joint positions. Unit: \f$[rad]\f$
+   * @param[out] q Closest solution. Unchanged if the pose cannot be reached. Unit: \f$[rad]\f$
+   *
+   * @return True if a solution was found.
+   */
+  bool solveClosest(const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                    double q7,
+                    const std::array<double, 7>& q_current,
+                    std::array<double, 7>* q) const noexcept;
+
+  /**
+   * Computes all solutions for many poses, e.g. to convert a Cartesian trajectory offline. The
+   * poses are split into contiguous chunks, which are solved concurrently.
+   *
+   * @param[in] O_T_EE End effector poses in base frame, column-major.
+   * @param[in] q7 Position of the last joint for each pose. Unit: \f$[rad]\f$
+   * @param[in] q_reference Joint positions the solutions of all poses are ordered by.
+   * Unit: \f$[rad]\f$
+   * @param[in] thread_count Number of threads to use. If 0, one thread per hardware thread is used.
+   *
+   * @return Solutions for each pose.
+   *
+   * @throw std::invalid_argument if O_T_EE and q7 differ in size.
+   */
+  std::vector<InverseKinematicsSolutions> solveBatch(
+      const std::vector<std::array<double, 16>>& O_T_EE,  // NOLINT(readability-identifier-naming)
+      const std::vector<double>& q7,
+      const std::array<double, 7>& q_reference,
+      size_t thread_count = 0) const;
+
+ private:
+  std::array<double, 16> EE_T_F_;  // NOLINT(readability-identifier-naming)
+  std::array<double, 7> min_joint_position_;
+  std::array<double, 7> max_joint_position_;
+};
+
+}  // namespace franka
@@ -0,0 +1,138 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+#include <franka/state_publisher.h>
+
+/**
+ * @file joint_impedance_controller.h
+ * Contains the franka::JointImpedanceController type.
+ */
+
+namespace franka {
+
+/**
+ * Joint impedance controller tracking desired joint positions with Coriolis compensation.
+ *
+ * The commanded torques are \f$\tau_d = K (q_d - q) - D \dot{q} + c\f$, where \f$K\f$ and \f$D\f$
+ * are diagonal stiffness and damping matrices and \f$c\f$ is the Coriolis vector. If rate limiting
+ * is enabled, the torques are limited to franka::kMaxTorqueRate relative to RobotState::tau_J_d,
+ * as the control loop does, so that the returned torques are the ones the control loop sends
+ * unless its low-pass filter is active.
+ *
+ * The model is evaluated with a single call to Model::dynamics() per cycle. Its results, including
+ * gravity, are available with dynamics(), so that no other model function has to be called for the
+ * same robot state. With a franka::StatePublisher set, every call to update() publishes the robot
+ * state together with the commanded and the rate limited torques and the gravity torques in
+ * PublishedState::controller_torques, e.g. for a thread that compares commanded and measured
+ * torques. update() does not allocate.
+ */
+class JointImpedanceController {
+ public:
+  /**
+   * Creates a controller.
+   *
+   * @param[in] stiffness Diagonal of \f$K\f$. Unit: \f$[\frac{Nm}{rad}]\f$.
+   * @param[in] damping Diagonal of \f$D\f$. Unit: \f$[\frac{Nm \cdot s}{rad}]\f$.
+   * @param[in] limit_rate True if the torques should be rate limited.
+   *
+   * @throw std::invalid_argument if a gain is negative, infinite or NaN.
+   */
+  JointImpedanceController(const std::array<double, 7>& stiffness,
+                           const std::array<double, 7>& damping,
+                           bool limit_rate = true);
+
+  /**
+   * Sets the gains.
+   *
+   * @param[in] stiffness Diagonal of \f$K\f$. Unit: \f$[\frac{Nm}{rad}]\f$.
+   * @param[in] damping Diagonal of \f$D\f$. Unit: \f$[\frac{Nm \cdot s}{rad}]\f$.
+   *
+   * @throw std::invalid_argument if a gain is negative, infinite or NaN.
+   */
+  void setGains(const std::array<double, 7>& stiffness, const std::array<double, 7>& damping);
+
+  /**
+   * Sets a publisher for the torques of every cycle, or nullptr to stop publishing.
+   *
+   * The publisher should not also be passed to Robot::setStatePublisher(), as readers could then
+   * not tell the samples of the robot and of the controller apart.
+   *
+   * @param[in] publisher Publisher, or nullptr.
+   */
+  void setStatePublisher(std::shared_ptr<StatePublisher> publisher) noexcept;
+
+  /**
+   * Computes the torque command tracking the desired joint positions RobotState::q_d, e.g. of a
+   * motion generator running in the same control loop.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] model Robot model.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   *
+   * @throw std::invalid_argument if rate limiting is enabled and the computed torques are infinite
+   * or NaN.
+   */
+  std::array<double, 7> update(const RobotState& robot_state, const Model& model);
+
+  /**
+   * Computes the torque command tracking the given joint positions.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] model Robot model.
+   * @param[in] q_d Desired joint positions. Unit: \f$[rad]\f$.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   *
+   * @throw std::invalid_argument if rate limiting is enabled and the computed torques are infinite
+   * or NaN.
+   */
+  std::array<double, 7> update(const RobotState& robot_state,
+                               const Model& model,
+                               const std::array<double, 7>& q_d);
+
+  /**
+   * Computes the torque command tracking the given joint positions with precomputed dynamics.
+   *
+   * @param[in] robot_state Current robot state.
+   * @param[in] dynamics Dynamics at the robot state, of which DynamicsBundle::coriolis and
+   * DynamicsBundle::gravity are used.
+   * @param[in] q_d Desired joint positions. Unit: \f$[rad]\f$.
+   *
+   * @return Joint torques to command, without gravity. Unit: \f$[Nm]\f$.
+   *
+   * @throw std::invalid_argument if rate limiting is enabled and the computed torques are infinite
+   * or NaN.
+   */
+  std::array<double, 7> update(const RobotState& robot_state,
+                               const DynamicsBundle& dynamics,
+                               const std::array<double, 7>& q_d);
+
+  /**
+   * @return Dynamics computed by the last call to update() with a model.
+   */
+  const DynamicsBundle& dynamics() const noexcept;
+
+  /**
+   * @return Torques of the last call to update().
+   */
+  const ControllerTorques& torques() const noexcept;
+
+ private:
+  std::array<double, 7> stiffness_;
+  std::array<double, 7> damping_;
+  bool limit_rate_;
+  std::shared_ptr<StatePublisher> publisher_;
+  RobotCommand published_command_;
+
+  ControllerTorques torques_{};
+  DynamicsBundle dynamics_{};
+};
+
+}  // namespace franka
@@ -0,0 +1,118 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file joint_state_estimator.h
+ * Contains the franka::JointStateEstimator type.
+ */
+
+namespace franka {
+
+/**
+ * Noise parameters of the franka::JointStateEstimator.
+ *
+ * Larger measurement variances or a smaller jerk noise give smoother estimates with more lag.
+ */
+struct JointStateEstimatorParameters {
+  /**
+   * Spectral density of the white jerk that drives the motion model.
+   * Unit: \f$[\frac{rad^2}{s^5}]\f$
+   */
+  double jerk_noise{1e3};
+  /**
+   * Variance of the measured joint position. Unit: \f$[rad^2]\f$
+   */
+  double position_noise{1e-10};
+  /**
+   * Variance of the measured joint velocity. Unit: \f$[\frac{rad^2}{s^2}]\f$
+   */
+  double velocity_noise{1e-4};
+};
+
+/**
+ * Estimates joint velocities and accelerations from measured joint positions and velocities.
+ *
+ * Every joint is tracked by a Kalman filter with a constant acceleration model, which handles
+ * varying time steps, e.g. after lost packets. The state of all joints is stored as fixed-size
+ * arrays, so an update does not allocate and takes well below a microsecond.
+ */
+class JointStateEstimator {
+ public:
+  /**
+   * Creates a new estimator.
+   *
+   * @param[in] parameters Noise parameters.
+   *
+   * @throw std::invalid_argument if a parameter is zero, negative, infinite or NaN.
+   */
+  explicit JointStateEstimator(const JointStateEstimatorParameters& parameters = {});
+
+  /**
+   * Updates the estimate with a new measurement.
+   *
+   * The first update after construction or reset() initializes the estimate with the measurement
+   * and zero acceleration. An update with a time step of zero does the same.
+   *
+   * @param[in] q Measured joint positions. Unit: \f$[rad]\f$
+   * @param[in] dq Measured joint velocities. Unit: \f$[\frac{rad}{s}]\f$
+   * @param[in] time_step Time since the last update. Unit: \f$[s]\f$
+   */
+  void update(const std::array<double, 7>& q,
+              const std::array<double, 7>& dq,
+              double time_step) noexcept;
+
+  /**
+   * Updates the estimate from RobotState::q and RobotState::dq, and writes the estimated velocity
+   * and acceleration to RobotState::dq and RobotState::ddq_hat.
+   *
+   * @param[in,out] robot_state Robot state to update from and to write to.
+   * @param[in] time_step Time since the last update.
+   */
+  void update(RobotState* robot_state, Duration time_step) noexcept;
+
+  /**
+   * Clears the estimate, so that the next update initializes it again.
+   */
+  void reset() noexcept;
+
+  /**
+   * @return Estimated joint positions. Unit: \f$[rad]\f$
+   */
+  const std::array<double, 7>& q() const noexcept;
+
+  /**
+   * @return Estimated joint velocities. Unit: \f$[\frac{rad}{s}]\f$
+   */
+  const std::array<double, 7>& dq() const noexcept;
+
+  /**
+   * @return Estimated joint accelerations. Unit: \f$[\frac{rad}{s^2}]\f$
+   */
+  const std::array<double, 7>& ddq() const noexcept;
+
+ private:
+  void initialize(const std::array<double, 7>& q, const std::array<double, 7>& dq) noexcept;
+
+  JointStateEstimatorParameters parameters_;
+  bool initialized_{false};
+
+  std::array<double, 7> q_{};
+  std::array<double, 7> dq_{};
+  std::array<double, 7> ddq_{};
+
+  // Upper triangle of the symmetric 3x3 covariance matrix of every joint.
+  std::array<double, 7> p00_{};
+  std::array<double, 7> p01_{};
+  std::array<double, 7> p02_{};
+  std::array<double, 7> p11_{};
+  std::array<double, 7> p12_{};
+  std::array<double, 7> p22_{};
+};
+
+}  // namespace franka
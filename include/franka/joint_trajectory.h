@@ -0,0 +1,185 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file joint_trajectory.h
+ * Contains the franka::JointTrajectory and franka::JointMotionGenerator types.
+ */
+
+namespace franka {
+
+/**
+ * Per-joint limits of a franka::JointTrajectory.
+ */
+struct JointTrajectoryLimits {
+  /**
+   * Scales franka::kMaxJointVelocity and franka::kMaxJointAcceleration.
+   *
+   * @param[in] speed_factor Factor in range (0, 1].
+   *
+   * @return Scaled limits.
+   *
+   * @throw std::invalid_argument if speed_factor is not in range (0, 1].
+   */
+  static JointTrajectoryLimits fromSpeedFactor(double speed_factor);
+
+  /**
+   * Maximum joint velocity. Unit: \f$[\frac{rad}{s}]\f$.
+   */
+  std::array<double, 7> max_velocity{};
+  /**
+   * Maximum joint acceleration at the start of the motion. Unit: \f$[\frac{rad}{s^2}]\f$.
+   */
+  std::array<double, 7> max_acceleration{};
+  /**
+   * Maximum joint deceleration at the end of the motion. Unit: \f$[\frac{rad}{s^2}]\f$.
+   */
+  std::array<double, 7> max_deceleration{};
+};
+
+/**
+ * Time-synchronized point-to-point joint trajectory, in which all joints start and stop at the same
+ * time.
+ *
+ * Each joint accelerates with a polynomial profile, moves with constant velocity and decelerates
+ * with a polynomial profile, so that velocity and acceleration are continuous. The slowest joint
+ * determines the duration; all other joints are slowed down to finish at the same time. Adapted
+ * from: Wisama Khalil and Etienne Dombre. 2002. Modeling, Identification and Control of Robots
+ * (Kogan Page Science Paper edition).
+ *
+ * The profile is computed once at construction. Evaluating it at any time does not allocate and
+ * takes constant time, without branching per joint.
+ */
+class JointTrajectory {
+ public:
+  /**
+   * Computes the synchronized profile.
+   *
+   * @param[in] q_start Start joint positions. Unit: \f$[rad]\f$.
+   * @param[in] q_goal Goal joint positions. Unit: \f$[rad]\f$.
+   * @param[in] limits Velocity and acceleration limits.
+   *
+   * @throw std::invalid_argument if a limit is not positive.
+   */
+  JointTrajectory(const std::array<double, 7>& q_start,
+                  const std::array<double, 7>& q_goal,
+                  const JointTrajectoryLimits& limits);
+
+  /**
+   * @return Duration of the trajectory. Unit: \f$[s]\f$.
+   */
+  double duration() const noexcept;
+
+  /**
+   * @param[in] t Time since the start of the trajectory. Unit: \f$[s]\f$.
+   *
+   * @return Joint positions at time t. Before the start, the start positions; after the end, the
+   * goal positions. Unit: \f$[rad]\f$.
+   */
+  std::array<double, 7> position(double t) const noexcept;
+
+  /**
+   * @param[in] t Time since the start of the trajectory. Unit: \f$[s]\f$.
+   *
+   * @return Joint velocities at time t, zero outside of the trajectory. Unit:
+   * \f$[\frac{rad}{s}]\f$.
+   */
+  std::array<double, 7> velocity(double t) const noexcept;
+
+  /**
+   * @return Velocity of each joint between the acceleration and deceleration phases, zero for
+   * joints that do not move. Unit: \f$[\frac{rad}{s}]\f$.
+   */
+  std::array<double, 7> cruiseVelocity() const noexcept;
+
+  /**
+   * @return Duration of the acceleration phase of each joint, zero for joints that do not move.
+   * Unit: \f$[s]\f$.
+   */
+  std::array<double, 7> accelerationTime() const noexcept;
+
+  /**
+   * @return Duration of the deceleration phase of each joint, zero for joints that do not move.
+   * Unit: \f$[s]\f$.
+   */
+  std::array<double, 7> decelerationTime() const noexcept;
+
+ private:
+  std::array<double, 7> q_start_;
+  std::array<double, 7> delta_q_{};
+  // Signed synchronized maximum velocity per joint.
+  std::array<double, 7> velocity_{};
+  // Ends of the acceleration, constant velocity and deceleration phases.
+  std::array<double, 7> t_1_{};
+  std::array<double, 7> t_2_{};
+  std::array<double, 7> t_f_{};
+  // Position offset at t_1, and duration of the deceleration phase.
+  std::array<double, 7> q_1_{};
+  std::array<double, 7> delta_t_2_{};
+  double duration_{0.0};
+};
+
+/**
+ * Motion generator callback that moves the robot to a goal joint configuration with a
+ * franka::JointTrajectory.
+ *
+ * Unless a precomputed trajectory is given, the trajectory starts at the desired joint positions
+ * of the first robot state, i.e. of the callback with a zero period. Pass the generator to
+ * Robot::control, e.g. `robot.control(franka::JointMotionGenerator(0.5, q_goal))`.
+ */
+class JointMotionGenerator {
+ public:
+  /**
+   * Creates a generator that uses franka::JointTrajectoryLimits::fromSpeedFactor.
+   *
+   * @param[in] speed_factor Factor in range (0, 1].
+   * @param[in] q_goal Goal joint positions. Unit: \f$[rad]\f$.
+   *
+   * @throw std::invalid_argument if speed_factor is not in range (0, 1].
+   */
+  JointMotionGenerator(double speed_factor, const std::array<double, 7>& q_goal);
+
+  /**
+   * Creates a generator with the given limits.
+   *
+   * @param[in] limits Velocity and acceleration limits.
+   * @param[in] q_goal Goal joint positions. Unit: \f$[rad]\f$.
+   *
+   * @throw std::invalid_argument if a limit is not positive.
+   */
+  JointMotionGenerator(const JointTrajectoryLimits& limits, const std::array<double, 7>& q_goal);
+
+  /**
+   * Creates a generator that follows a precomputed trajectory, which must start at the desired
+   * joint positions of the robot when the motion starts.
+   *
+   * @param[in] trajectory Trajectory to follow.
+   */
+  explicit JointMotionGenerator(const JointTrajectory& trajectory);
+
+  /**
+   * Computes the joint positions for the current cycle.
+   *
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] period Time since the previous cycle.
+   *
+   * @return Joint positions, with motion_finished set once the goal has been reached.
+   */
+  JointPositions operator()(const RobotState& robot_state, Duration period);
+
+ private:
+  JointTrajectoryLimits limits_;
+  std::array<double, 7> q_goal_{};
+  JointTrajectory trajectory_;
+  bool start_from_state_{true};
+  double time_{0.0};
+};
+
+}  // namespace franka
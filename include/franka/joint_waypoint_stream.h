@@ -0,0 +1,129 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/joint_trajectory.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file joint_waypoint_stream.h
+ * Contains the franka::JointWaypointStream type.
+ */
+
+namespace franka {
+
+/**
+ * Motion generator callback that moves the robot through joint waypoints streamed in while the
+ * motion is running.
+ *
+ * Chaining motions with repeated calls to Robot::control() stops the robot between the motions
+ * and starts a new motion each time. Instead, a planning thread can push waypoints into the stream
+ * while a single motion executes them:
+ *
+ * @code{.cpp}
+ * franka::JointWaypointStream stream(franka::JointTrajectoryLimits::fromSpeedFactor(0.5));
+ * std::thread planner([&stream] {
+ *   for (const std::array<double, 7>& q : waypoints) {
+ *     while (!stream.push(q)) {
+ *       std::this_thread::sleep_for(std::chrono::milliseconds(10));
+ *     }
+ *   }
+ *   stream.finish();
+ * });
+ * robot.control(stream);
+ * planner.join();
+ * @endcode
+ *
+ * Waypoints are handed over through a wait-free single-producer single-consumer queue, so the
+ * control loop neither blocks nor allocates. The robot moves from waypoint to waypoint with
+ * franka::JointTrajectory segments. The next segment starts while the previous one decelerates,
+ * and the two are superimposed. The overlap is chosen per pair of segments so that the velocity
+ * and acceleration limits of both still hold. If no waypoint is queued when a segment ends, the
+ * robot stops at its waypoint and waits for the next one.
+ *
+ * The motion starts at the desired joint positions of the first robot state and finishes once
+ * finish() has been called and all waypoints have been reached. Only one thread may push
+ * waypoints, and the stream may only be used by one control loop at a time. It is passed to
+ * Robot::control() by reference.
+ */
+class JointWaypointStream {
+ public:
+  /**
+   * Creates an empty stream.
+   *
+   * @param[in] limits Default limits for the segments to each waypoint.
+   * @param[in] queue_capacity Number of waypoints that can be queued. Rounded up to the next power
+   * of two.
+   *
+   * @throw std::invalid_argument if a limit is not positive.
+   */
+  explicit JointWaypointStream(const JointTrajectoryLimits& limits, size_t queue_capacity = 256);
+
+  /**
+   * Frees the queue.
+   */
+  ~JointWaypointStream() noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  JointWaypointStream(const JointWaypointStream&) = delete;
+  JointWaypointStream& operator=(const JointWaypointStream&) = delete;
+  /// @endcond
+
+  /**
+   * Queues a waypoint with the default limits. Does not block and does not allocate.
+   *
+   * @param[in] q Joint positions of the waypoint. Unit: \f$[rad]\f$.
+   *
+   * @return False if the queue is full.
+   */
+  bool push(const std::array<double, 7>& q) noexcept;
+
+  /**
+   * Queues a waypoint with the given limits for the segment leading to it. Does not block and does
+   * not allocate.
+   *
+   * @param[in] q Joint positions of the waypoint. Unit: \f$[rad]\f$.
+   * @param[in] limits Limits for the segment to this waypoint.
+   *
+   * @return False if the queue is full.
+   *
+   * @throw std::invalid_argument if a limit is not positive.
+   */
+  bool push(const std::array<double, 7>& q, const JointTrajectoryLimits& limits);
+
+  /**
+   * Lets the motion finish once all queued waypoints have been reached. Waypoints must not be
+   * pushed afterwards.
+   */
+  void finish() noexcept;
+
+  /**
+   * @return Number of waypoints reached so far.
+   */
+  uint64_t reachedWaypoints() const noexcept;
+
+  /**
+   * Computes the joint positions for the current cycle. Called by the control loop.
+   *
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] period Time since the previous cycle.
+   *
+   * @return Joint positions, with motion_finished set once all waypoints have been reached after
+   * finish() was called.
+   */
+  JointPositions operator()(const RobotState& robot_state, Duration period) noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
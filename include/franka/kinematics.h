@@ -0,0 +1,274 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include <franka/model.h>
+#include <franka/rate_limiting.h>
+
+/**
+ * @file kinematics.h
+ * Contains the franka::Kinematics type, a built-in implementation of the kinematics of the model
+ * library.
+ */
+
+namespace franka {
+
+/**
+ * Kinematic parameters of a Panda robot, in the modified Denavit-Hartenberg convention.
+ *
+ * Parameter types of franka::Kinematics provide the same constexpr functions. The twist of each
+ * joint is given by its cosine and sine, so that they are exact constants.
+ */
+struct PandaKinematicParameters {
+  /**
+   * @param[in] joint Joint index, starting at 0.
+   *
+   * @return Link length along the x axis of the previous frame. Unit: \f$[m]\f$
+   */
+  static constexpr double a(size_t joint) noexcept {
+    const double values[7] = {0, 0, 0, 0.0825, -0.0825, 0, 0.088};
+    return values[joint];
+  }
+
+  /**
+   * @param[in] joint Joint index, starting at 0.
+   *
+   * @return Link offset along the joint axis. Unit: \f$[m]\f$
+   */
+  static constexpr double d(size_t joint) noexcept {
+    const double values[7] = {0.333, 0, 0.316, 0, 0.384, 0, 0};
+    return values[joint];
+  }
+
+  /**
+   * @param[in] joint Joint index, starting at 0.
+   *
+   * @return Cosine of the twist about the x axis of the previous frame.
+   */
+  static constexpr double cosAlpha(size_t joint) noexcept {
+    const double values[7] = {1, 0, 0, 0, 0, 0, 0};
+    return values[joint];
+  }
+
+  /**
+   * @param[in] joint Joint index, starting at 0.
+   *
+   * @return Sine of the twist about the x axis of the previous frame.
+   */
+  static constexpr double sinAlpha(size_t joint) noexcept {
+    const double values[7] = {0, -1, 1, 1, -1, 1, 1};
+    return values[joint];
+  }
+
+  /**
+   * @return Offset of the flange along the last joint axis. Unit: \f$[m]\f$
+   */
+  static constexpr double flange() noexcept { return 0.107; }
+};
+
+/// @cond DO_NOT_DOCUMENT
+namespace detail {
+
+// Multiplies two column-major homogeneous transformations.
+inline void multiplyTransforms(const double* lhs, const double* rhs, double* output) noexcept {
+  for (size_t column = 0; column < 4; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      output[4 * column + row] = lhs[row] * rhs[4 * column] + lhs[4 + row] * rhs[4 * column + 1] +
+                                 lhs[8 + row] * rhs[4 * column + 2] +
+                                 lhs[12 + row] * rhs[4 * column + 3];
+    }
+    output[4 * column + 3] = rhs[4 * column + 3];
+  }
+}
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * Computes the poses and zero Jacobians of all frames with kinematic parameters fixed at compile
+ * time, as an alternative to the model library for Model::pose, Model::zeroJacobian and
+ * Model::poseAll.
+ *
+ * The model library is loaded at runtime, so its functions cannot be inlined into a controller.
+ * This implementation is header-only and free of calls across library boundaries, so the compiler
+ * can inline it and fold the constant parameters. As the parameters are fixed at compile time,
+ * call matches() when starting up to check that they describe the connected robot, and fall back
+ * to the Model otherwise.
+ *
+ * Poses and Jacobians use the same layout and frames as the Model.
+ *
+ * @tparam Parameters Kinematic parameters, see franka::PandaKinematicParameters.
+ */
+template <typename Parameters>
+class Kinematics {
+ public:
+  /**
+   * Computes the poses and, optionally, the zero Jacobians of all frames.
+   *
+   * @param[in] q Joint position. Unit: \f$[rad]\f$
+   * @param[in] frames End effector and stiffness frames, with precomputed F_T_K.
+   * @param[out] poses Vectorized 4x4 pose matrices, column-major, indexed by franka::Frame.
+   * @param[out] zero_jacobians If not nullptr, vectorized 6x7 Jacobians, column-major, indexed by
+   * franka::Frame.
+   */
+  static void poseAll(const std::array<double, 7>& q,
+                      const EndEffectorFrames& frames,
+                      FramePoses* poses,
+                      FrameJacobians* zero_jacobians = nullptr) noexcept {
+    FramePoses& output = *poses;
+    std::array<double, 16> transform{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+    for (size_t joint = 0; joint < 7; joint++) {
+      const double cos_q = std::cos(q[joint]);
+      const double sin_q = std::sin(q[joint]);
+      const double cos_alpha = Parameters::cosAlpha(joint);
+      const double sin_alpha = Parameters::sinAlpha(joint);
+      const double d = Parameters::d(joint);
+      const std::array<double, 16> local{{cos_q, cos_alpha * sin_q, sin_alpha * sin_q, 0,  //
+                                          -sin_q, cos_alpha * cos_q, sin_alpha * cos_q, 0,  //
+                                          0, -sin_alpha, cos_alpha, 0,                      //
+                                          Parameters::a(joint), -sin_alpha * d, cos_alpha * d,
+                                          1}};
+      detail::multiplyTransforms(transform.data(), local.data(), output[joint].data());
+      transform = output[joint];
+    }
+
+    std::array<double, 16>& flange = output[frameIndex(Frame::kFlange)];
+    flange = transform;
+    for (size_t row = 0; row < 3; row++) {
+      flange[12 + row] += Parameters::flange() * transform[8 + row];
+    }
+    detail::multiplyTransforms(flange.data(), frames.F_T_EE().data(),
+                               output[frameIndex(Frame::kEndEffector)].data());
+    detail::multiplyTransforms(flange.data(), frames.F_T_K().data(),
+                               output[frameIndex(Frame::kStiffness)].data());
+
+    if (zero_jacobians != nullptr) {
+      for (size_t frame = 0; frame < kFrameCount; frame++) {
+        jacobian(output, frame, &(*zero_jacobians)[frame]);
+      }
+    }
+  }
+
+  /**
+   * Computes the pose of a frame.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] q Joint position. Unit: \f$[rad]\f$
+   * @param[in] frames End effector and stiffness frames.
+   *
+   * @return Vectorized 4x4 pose matrix, column-major.
+   */
+  static std::array<double, 16> pose(Frame frame,
+                                     const std::array<double, 7>& q,
+                                     const EndEffectorFrames& frames = {}) noexcept {
+    FramePoses poses;
+    poseAll(q, frames, &poses);
+    return poses[frameIndex(frame)];
+  }
+
+  /**
+   * Computes the 6x7 Jacobian of a frame relative to the base frame.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] q Joint position. Unit: \f$[rad]\f$
+   * @param[in] frames End effector and stiffness frames.
+   *
+   * @return Vectorized 6x7 Jacobian, column-major.
+   */
+  static std::array<double, 42> zeroJacobian(Frame frame,
+                                             const std::array<double, 7>& q,
+                                             const EndEffectorFrames& frames = {}) noexcept {
+    FramePoses poses;
+    poseAll(q, frames, &poses);
+    std::array<double, 42> output;
+    jacobian(poses, frameIndex(frame), &output);
+    return output;
+  }
+
+  /**
+   * Checks the kinematic parameters against the model library of the connected robot, by comparing
+   * the poses and zero Jacobians of all frames for several joint positions within the limits.
+   *
+   * @param[in] model Model of the connected robot.
+   * @param[in] frames End effector and stiffness frames to check.
+   * @param[in] tolerance Largest permitted difference of any element.
+   *
+   * @return True if all poses and Jacobians match.
+   */
+  static bool matches(const Model& model,
+                      const EndEffectorFrames& frames = {},
+                      double tolerance = 1e-6) noexcept {
+    constexpr size_t kSamples = 16;
+    FramePoses expected_poses;
+    FrameJacobians expected_jacobians;
+    FramePoses poses;
+    FrameJacobians jacobians;
+    for (size_t sample = 0; sample < kSamples; sample++) {
+      // Spread the samples over the joint ranges with the golden ratio.
+      std::array<double, 7> q;
+      for (size_t joint = 0; joint < q.size(); joint++) {
+        double fraction = std::fmod(0.6180339887 * (7 * sample + joint + 1), 1.0);
+        q[joint] = kMinJointPosition[joint] +
+                   fraction * (kMaxJointPosition[joint] - kMinJointPosition[joint]);
+      }
+      model.poseAll(q, frames, &expected_poses, &expected_jacobians);
+      poseAll(q, frames, &poses, &jacobians);
+      for (size_t frame = 0; frame < kFrameCount; frame++) {
+        if (!near(poses[frame], expected_poses[frame], tolerance) ||
+            !near(jacobians[frame], expected_jacobians[frame], tolerance)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  static constexpr size_t frameIndex(Frame frame) noexcept { return static_cast<size_t>(frame); }
+
+  // Fills the Jacobian of a frame from the joint axes and origins, which are the z axes and
+  // translations of the joint frames.
+  static void jacobian(const FramePoses& poses,
+                       size_t frame,
+                       std::array<double, 42>* output) noexcept {
+    const std::array<double, 16>& target = poses[frame];
+    output->fill(0);
+    for (size_t joint = 0; joint <= std::min<size_t>(frame, 6); joint++) {
+      const std::array<double, 16>& axis_frame = poses[joint];
+      const double* axis = &axis_frame[8];
+      const double offset[3] = {target[12] - axis_frame[12], target[13] - axis_frame[13],
+                                target[14] - axis_frame[14]};
+      double* column = &(*output)[6 * joint];
+      column[0] = axis[1] * offset[2] - axis[2] * offset[1];
+      column[1] = axis[2] * offset[0] - axis[0] * offset[2];
+      column[2] = axis[0] * offset[1] - axis[1] * offset[0];
+      column[3] = axis[0];
+      column[4] = axis[1];
+      column[5] = axis[2];
+    }
+  }
+
+  template <size_t N>
+  static bool near(const std::array<double, N>& actual,
+                   const std::array<double, N>& expected,
+                   double tolerance) noexcept {
+    for (size_t i = 0; i < N; i++) {
+      if (!(std::abs(actual[i] - expected[i]) <= tolerance)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * Built-in kinematics of a Panda robot.
+ */
+using PandaKinematics = Kinematics<PandaKinematicParameters>;
+
+}  // namespace franka
@@ -0,0 +1,96 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @file limiting_statistics.h
+ * Contains types for the statistics of command rate limiting in control loops.
+ */
+
+namespace franka {
+
+/**
+ * Statistics of one rate limiting stage of the control loop.
+ *
+ * Elements correspond to the joints for joint-level commands. For Cartesian commands, the first
+ * three elements are the translational and the next three the rotational components. Elbow
+ * commands only use the first element. Unused elements stay zero.
+ */
+struct LimitingStageStatistics {
+  /**
+   * Number of commands processed by this stage.
+   */
+  uint64_t cycles{};
+  /**
+   * Number of commands in which the stage changed the given element by more than
+   * LimitingStatistics::kCorrectionThreshold.
+   */
+  std::array<uint64_t, 7> count{};
+  /**
+   * Largest absolute change of the given element, in the unit of the command.
+   *
+   * For Cartesian poses, translational changes are given in \f$[m]\f$ and rotational changes as the
+   * components of \f$\sin(\theta) \cdot \mathbf{n}\f$ for a rotation of \f$\theta\f$ around the
+   * axis \f$\mathbf{n}\f$, which is close to the rotation angle in \f$[rad]\f$ for small changes.
+   */
+  std::array<double, 7> max_correction{};
+};
+
+/**
+ * Rate limiting statistics of the control loops executed since the statistics were last reset.
+ *
+ * Only stages that are active in a control loop, i.e. with `limit_rate` set to true, are
+ * recorded.
+ *
+ * @see Robot::setLimitingStatisticsEnabled
+ * @see Robot::limitingStatistics
+ */
+struct LimitingStatistics {
+  /**
+   * Changes that are smaller than this are caused by rounding and are not counted.
+   */
+  static constexpr double kCorrectionThreshold = 1e-9;
+
+  /**
+   * Torque rate limiting with franka::kMaxTorqueRate.
+   */
+  LimitingStageStatistics torque_rate{};
+  /**
+   * Velocity, acceleration and jerk limiting of joint position and joint velocity commands.
+   */
+  LimitingStageStatistics joint_motion{};
+  /**
+   * Velocity, acceleration and jerk limiting of Cartesian pose and Cartesian velocity commands.
+   */
+  LimitingStageStatistics cartesian_motion{};
+  /**
+   * Velocity, acceleration and jerk limiting of elbow commands.
+   */
+  LimitingStageStatistics elbow{};
+};
+
+/**
+ * Streams the statistics of a rate limiting stage as JSON object.
+ *
+ * @param[in] ostream Ostream instance
+ * @param[in] statistics LimitingStageStatistics instance to stream
+ *
+ * @return Ostream instance
+ */
+std::ostream& operator<<(std::ostream& ostream, const LimitingStageStatistics& statistics);
+
+/**
+ * Streams the rate limiting statistics as JSON object.
+ *
+ * @param[in] ostream Ostream instance
+ * @param[in] statistics LimitingStatistics instance to stream
+ *
+ * @return Ostream instance
+ */
+std::ostream& operator<<(std::ostream& ostream, const LimitingStatistics& statistics);
+
+}  // namespace franka
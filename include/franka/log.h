@@ -2,6 +2,9 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include <franka/control_types.h>
@@ -14,6 +17,104 @@
 
 namespace franka {
 
+/**
+ * Selects which fields are kept in the log of a franka::Robot.
+ *
+ * The time and control command success rate are always logged. Values can be combined with `|`.
+ * Fields that are not logged keep their default value in the franka::Record provided by the
+ * ControlException.
+ */
+enum class LogFields : uint32_t {
+  kNone = 0,
+  kQ = 1 << 0,                  ///< RobotState::q
+  kQD = 1 << 1,                 ///< RobotState::q_d
+  kDq = 1 << 2,                 ///< RobotState::dq
+  kDqD = 1 << 3,                ///< RobotState::dq_d
+  kTauJ = 1 << 4,               ///< RobotState::tau_J
+  kTauExtHatFiltered = 1 << 5,  ///< RobotState::tau_ext_hat_filtered
+  kMotionCommand = 1 << 6,      ///< Joint and Cartesian values of RobotCommand
+  kControlCommand = 1 << 7,     ///< RobotCommand::torques
+  kFullState = 1 << 8,          ///< All fields of RobotState
+  /**
+   * Fields written by logToCSV() by default.
+   */
+  kCSV = kQ | kQD | kDq | kDqD | kTauJ | kTauExtHatFiltered | kMotionCommand | kControlCommand,
+  /**
+   * All fields.
+   */
+  kAll = kCSV | kFullState,
+};
+
+/**
+ * Combines two sets of log fields.
+ *
+ * @param[in] lhs First set.
+ * @param[in] rhs Second set.
+ *
+ * @return Union of both sets.
+ */
+constexpr LogFields operator|(LogFields lhs, LogFields rhs) noexcept {
+  return static_cast<LogFields>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
+/**
+ * Checks whether all given fields are contained in a set of log fields.
+ *
+ * @param[in] fields Set of log fields.
+ * @param[in] query Fields to look for.
+ *
+ * @return True if all fields of query are contained in fields.
+ */
+constexpr bool hasLogFields(LogFields fields, LogFields query) noexcept {
+  return (static_cast<uint32_t>(fields) & static_cast<uint32_t>(query)) ==
+         static_cast<uint32_t>(query);
+}
+
+/**
+ * Configures the compressed log of a franka::Robot, which allows keeping minutes of history.
+ *
+ * Logged values are quantized with a fixed resolution per field. Every `keyframe_interval` samples,
+ * a keyframe stores the quantized values as they are. The samples in between only store the
+ * difference to a prediction from the previous samples, in one byte per value for the usual
+ * changes between two control cycles. Larger changes are stored in a shared overflow buffer with
+ * room for one value per sample. If it overflows, the oldest samples are dropped from the log.
+ *
+ * Compression is lossy: read values differ by at most half the resolution from the logged
+ * ones. Non-finite values are read as 0. The control command success rate is stored in single
+ * precision. LogFields::kFullState cannot be compressed.
+ */
+struct LogCompression {
+  /**
+   * Enables the compressed log.
+   */
+  bool enabled{false};
+  /**
+   * Number of samples from one keyframe to the next. Reading a single sample decodes up to that
+   * many samples.
+   */
+  size_t keyframe_interval{256};
+  /**
+   * Resolution of RobotState::q, RobotState::q_d and the commanded joint positions.
+   * Unit: \f$[rad]\f$.
+   */
+  double joint_position_resolution{1e-6};
+  /**
+   * Resolution of RobotState::dq, RobotState::dq_d and the commanded joint velocities.
+   * Unit: \f$[\frac{rad}{s}]\f$.
+   */
+  double joint_velocity_resolution{1e-4};
+  /**
+   * Resolution of RobotState::tau_J, RobotState::tau_ext_hat_filtered and the commanded torques.
+   * Unit: \f$[Nm]\f$.
+   */
+  double torque_resolution{1e-3};
+  /**
+   * Resolution of the commanded Cartesian poses and velocities. Unit: \f$[m]\f$ and
+   * \f$[\frac{m}{s}]\f$, or \f$[1]\f$ and \f$[\frac{rad}{s}]\f$ for rotations.
+   */
+  double cartesian_resolution{1e-6};
+};
+
 /**
  * Command sent to the robot. Structure used only for logging purposes.
  */
@@ -67,4 +168,59 @@ struct Record {
  * @return a string in CSV format, or empty string.
  */
 std::string logToCSV(const std::vector<Record>& log);
+
+/**
+ * Writes the selected fields of the log to a string in CSV format. If the string is not empty, the
+ * first row contains the header with names of columns. The following lines contain rows of values
+ * separated by commas.
+ *
+ * Array fields are split into one column per element, e.g. `state.q[0]`. The time is written in
+ * milliseconds, RobotState::robot_mode as its numeric value and franka::Errors as a bitmask, in
+ * which bit `i` corresponds to the `i`-th flag. Floating-point values are written with the
+ * shortest representation that parses back to the same value. The time and the control command
+ * success rate are always written.
+ *
+ * If the log is empty, the function returns an empty string.
+ *
+ * @param[in] log Log provided by the ControlException.
+ * @param[in] fields Fields to write. Should not contain more fields than were logged.
+ *
+ * @return a string in CSV format, or empty string.
+ */
+std::string logToCSV(const std::vector<Record>& log, LogFields fields);
+
+/**
+ * Writes the selected fields of the log in the binary format of franka::StreamingRecorder.
+ *
+ * The result contains the self-describing header, followed by one record per entry of the log. It
+ * can be written to a file as-is and read by the same tools as recordings of
+ * franka::StreamingRecorder. Field names and values match the columns of
+ * logToCSV(const std::vector<Record>&, LogFields), except that array fields are stored as one
+ * field.
+ *
+ * @param[in] log Log provided by the ControlException.
+ * @param[in] fields Fields to write. Should not contain more fields than were logged.
+ *
+ * @return Header and records, or an empty vector if the log is empty.
+ */
+std::vector<char> logToBinary(const std::vector<Record>& log, LogFields fields = LogFields::kAll);
+
+/**
+ * Writes the selected fields of the log to an Arrow IPC file, for columnar analysis tools.
+ *
+ * The file contains one non-nullable column per value of
+ * logToCSV(const std::vector<Record>&, LogFields), with the same names, typed as `uint64` or
+ * `double`. Columns are uncompressed and 64-byte aligned, so that they can be memory-mapped
+ * without parsing. See also recordingToArrow().
+ *
+ * @param[in] log Log provided by the ControlException.
+ * @param[in] path File to write. Existing files are overwritten.
+ * @param[in] fields Fields to write. Should not contain more fields than were logged.
+ *
+ * @throw Exception if the file cannot be written.
+ */
+void logToArrow(const std::vector<Record>& log,
+                const std::string& path,
+                LogFields fields = LogFields::kAll);
+
 }  // namespace franka
@@ -4,10 +4,12 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <stdexcept>
 
 /**
  * @file lowpass_filter.h
- * Contains functions for filtering signals with a low-pass filter.
+ * Contains functions and types for filtering signals with a low-pass filter.
  */
 
 namespace franka {
@@ -57,4 +59,189 @@ std::array<double, 16> cartesianLowpassFilter(double sample_time,
                                               std::array<double, 16> y,
                                               std::array<double, 16> y_last,
                                               double cutoff_frequency);
+
+/**
+ * Cheaper variant of cartesianLowpassFilter() for streams of small per-cycle rotations.
+ *
+ * Instead of slerp, the rotation is filtered by linearly interpolating the unit quaternions of
+ * both inputs and renormalizing the result (nlerp). Instead of a polar decomposition, a single
+ * Newton iteration orthonormalizes the rotation matrices before they are converted to quaternions.
+ * The quaternion of the last output is kept across cycles and reused if y_last equals the previous
+ * output, which is the case when the filtered command is sent unchanged.
+ *
+ * For a rotation angle \f$\varphi \leq 1\f$ rad between y_last and y, the filtered orientation
+ * deviates from the one computed by cartesianLowpassFilter() by less than \f$\varphi^3/200\f$
+ * rad. At 1 kHz and the maximum rotational velocity of 2.5 rad/s, this is below \f$10^{-10}\f$
+ * rad. The translation is filtered exactly as in cartesianLowpassFilter().
+ */
+class CartesianPoseLowpassFilter {
+ public:
+  /**
+   * Creates a new filter.
+   *
+   * @param[in] sample_time Sample time constant
+   * @param[in] cutoff_frequency Cutoff frequency of the low-pass filter
+   *
+   * @throw std::invalid_argument if cutoff_frequency is zero, negative, infinite or NaN.
+   * @throw std::invalid_argument if sample_time is negative, infinite or NaN.
+   */
+  CartesianPoseLowpassFilter(double sample_time, double cutoff_frequency);
+
+  /**
+   * Filters a Cartesian transformation matrix.
+   *
+   * @param[in] y Current Cartesian transformation matrix to be filtered
+   * @param[in] y_last Cartesian transformation matrix from the previous time step
+   *
+   * @throw std::invalid_argument if elements of y or y_last are infinite or NaN.
+   *
+   * @return Filtered Cartesian transformation matrix.
+   */
+  std::array<double, 16> filter(const std::array<double, 16>& y,
+                                const std::array<double, 16>& y_last);
+
+  /**
+   * Filters a Cartesian transformation matrix without checking the inputs.
+   *
+   * Infinite or NaN inputs lead to infinite or NaN outputs, so the result must be checked before it
+   * is used, e.g. with hasFiniteSum().
+   *
+   * @param[in] y Current Cartesian transformation matrix to be filtered
+   * @param[in] y_last Cartesian transformation matrix from the previous time step
+   *
+   * @return Filtered Cartesian transformation matrix.
+   */
+  std::array<double, 16> filterUnchecked(const std::array<double, 16>& y,
+                                         const std::array<double, 16>& y_last) noexcept;
+
+ private:
+  double gain_;
+  bool has_last_output_{false};
+  std::array<double, 16> last_output_{};
+  std::array<double, 4> last_orientation_{};
+};
+
+/**
+ * First-order low-pass filter for N channels with a fixed sample time and cutoff frequency.
+ *
+ * Equivalent to calling lowpassFilter() for every channel, but the arguments are validated and the
+ * gains are computed only once at construction.
+ *
+ * @tparam N Number of channels.
+ */
+template <size_t N>
+class LowpassFilter {
+ public:
+  /**
+   * Creates a new filter with the same cutoff frequency for all channels.
+   *
+   * @param[in] sample_time Sample time constant
+   * @param[in] cutoff_frequency Cutoff frequency of the low-pass filter
+   *
+   * @throw std::invalid_argument if cutoff_frequency is zero, negative, infinite or NaN.
+   * @throw std::invalid_argument if sample_time is negative, infinite or NaN.
+   */
+  LowpassFilter(double sample_time, double cutoff_frequency) {
+    checkSampleTime(sample_time);
+    gain_.fill(computeGain(sample_time, cutoff_frequency));
+    for (size_t i = 0; i < N; i++) {
+      last_gain_[i] = 1 - gain_[i];
+    }
+  }
+
+  /**
+   * Creates a new filter with a cutoff frequency per channel.
+   *
+   * Channels with a cutoff frequency of franka::kMaxCutoffFrequency or higher are passed through
+   * unchanged.
+   *
+   * @param[in] sample_time Sample time constant
+   * @param[in] cutoff_frequencies Cutoff frequency of the low-pass filter for every channel
+   *
+   * @throw std::invalid_argument if a cutoff frequency is zero, negative, infinite or NaN.
+   * @throw std::invalid_argument if sample_time is negative, infinite or NaN.
+   */
+  LowpassFilter(double sample_time, const std::array<double, N>& cutoff_frequencies) {
+    checkSampleTime(sample_time);
+    for (size_t i = 0; i < N; i++) {
+      gain_[i] = computeGain(sample_time, cutoff_frequencies[i]);
+      if (cutoff_frequencies[i] >= kMaxCutoffFrequency) {
+        gain_[i] = 1;
+      }
+      last_gain_[i] = 1 - gain_[i];
+    }
+  }
+
+  /**
+   * Filters all channels.
+   *
+   * @param[in] y Current values of the signal to be filtered
+   * @param[in] y_last Values of the signal to be filtered in the previous time step
+   *
+   * @throw std::invalid_argument if an element of y or y_last is infinite or NaN.
+   *
+   * @return Filtered values.
+   */
+  std::array<double, N> filter(const std::array<double, N>& y,
+                               const std::array<double, N>& y_last) const {
+    std::array<double, N> filtered;
+    bool finite = true;
+    for (size_t i = 0; i < N; i++) {
+      finite &= std::isfinite(y[i]) & std::isfinite(y_last[i]);
+      filtered[i] = gain_[i] * y[i] + last_gain_[i] * y_last[i];
+    }
+    if (!finite) {
+      throw std::invalid_argument(
+          "lowpass-filter: current or past input value of the signal to be filtered is infinite or "
+          "NaN.");
+    }
+    return filtered;
+  }
+
+  /**
+   * Filters all channels without checking the inputs.
+   *
+   * Infinite or NaN inputs lead to infinite or NaN outputs, so the result must be checked before it
+   * is used, e.g. with hasFiniteSum().
+   *
+   * @param[in] y Current values of the signal to be filtered
+   * @param[in] y_last Values of the signal to be filtered in the previous time step
+   *
+   * @return Filtered values.
+   */
+  std::array<double, N> filterUnchecked(const std::array<double, N>& y,
+                                        const std::array<double, N>& y_last) const noexcept {
+    std::array<double, N> filtered;
+    for (size_t i = 0; i < N; i++) {
+      filtered[i] = gain_[i] * y[i] + last_gain_[i] * y_last[i];
+    }
+    return filtered;
+  }
+
+  /**
+   * @param[in] channel Index of the channel.
+   *
+   * @return Weight of the current value of the given channel, between 0 and 1.
+   */
+  double gain(size_t channel = 0) const noexcept { return gain_[channel]; }
+
+ private:
+  static void checkSampleTime(double sample_time) {
+    if (sample_time < 0 || !std::isfinite(sample_time)) {
+      throw std::invalid_argument("lowpass-filter: sample_time is negative, infinite or NaN.");
+    }
+  }
+
+  static double computeGain(double sample_time, double cutoff_frequency) {
+    if (cutoff_frequency <= 0 || !std::isfinite(cutoff_frequency)) {
+      throw std::invalid_argument(
+          "lowpass-filter: cutoff_frequency is zero, negative, infinite or NaN.");
+    }
+    return sample_time / (sample_time + (1.0 / (2.0 * M_PI * cutoff_frequency)));
+  }
+
+  std::array<double, N> gain_;
+  std::array<double, N> last_gain_;
+};
+
 }  // namespace franka
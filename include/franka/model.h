@@ -3,7 +3,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 
 #include <franka/robot.h>
 #include <franka/robot_state.h>
@@ -42,6 +45,189 @@ enum class Frame {
  */
 Frame operator++(Frame& frame, int /* dummy */) noexcept;
 
+/**
+ * Number of frames enumerated by franka::Frame.
+ */
+constexpr size_t kFrameCount = static_cast<size_t>(Frame::kStiffness) + 1;
+
+/**
+ * Vectorized 4x4 pose matrices of all frames, indexed by franka::Frame.
+ */
+using FramePoses = std::array<std::array<double, 16>, kFrameCount>;
+
+/**
+ * Vectorized 6x7 Jacobians of all frames, indexed by franka::Frame.
+ */
+using FrameJacobians = std::array<std::array<double, 42>, kFrameCount>;
+
+/**
+ * Dynamics of the robot at one robot state, as computed by Model::dynamics.
+ *
+ * All matrices are vectorized in column-major format. The struct is cache line aligned, so that it
+ * can be kept as a caller-owned buffer inside a control loop.
+ */
+struct alignas(64) DynamicsBundle {
+  /**
+   * 7x7 mass matrix \f$M\f$. Unit: \f$[kg \times m^2]\f$.
+   */
+  std::array<double, 49> mass;
+
+  /**
+   * Coriolis force vector \f$c = C \times dq\f$. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> coriolis;
+
+  /**
+   * Gravity vector for the gravity given by RobotState::O_ddP_O. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> gravity;
+
+  /**
+   * 6x7 Jacobian \f$J\f$ of the requested frame relative to the base frame.
+   */
+  std::array<double, 42> zero_jacobian;
+
+  /**
+   * 6x6 operational space inertia matrix \f$\Lambda = (J M^{-1} J^T)^{-1}\f$.
+   *
+   * Only written if the operational space quantities were requested.
+   */
+  std::array<double, 36> lambda;
+
+  /**
+   * 7x6 dynamically consistent pseudoinverse \f$\bar{J} = M^{-1} J^T \Lambda\f$ of the Jacobian.
+   *
+   * Only written if the operational space quantities were requested.
+   */
+  std::array<double, 42> jacobian_pseudoinverse;
+};
+
+/**
+ * End effector frame and stiffness frame, together with the composed transformation F_T_K.
+ *
+ * Querying the stiffness frame with the F_T_EE/EE_T_K overloads of Model composes both
+ * transformations on every call. Keeping an EndEffectorFrames instance alive across control
+ * cycles and updating it with set() only recomputes F_T_K when the transformations actually change,
+ * e.g. after Robot::setEE or Robot::setK.
+ */
+class EndEffectorFrames {
+ public:
+  /**
+   * Creates identity end effector and stiffness frames.
+   */
+  EndEffectorFrames() noexcept;
+
+  /**
+   * Creates and composes the given end effector and stiffness frames.
+   *
+   * @param[in] F_T_EE End effector in flange frame.
+   * @param[in] EE_T_K Stiffness frame K in the end effector frame.
+   */
+  EndEffectorFrames(
+      const std::array<double, 16>& F_T_EE,   // NOLINT(readability-identifier-naming)
+      const std::array<double, 16>& EE_T_K);  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Updates the frames from the given robot state.
+   *
+   * @param[in] robot_state State containing F_T_EE and EE_T_K.
+   *
+   * @return True if F_T_K had to be recomputed.
+   */
+  bool set(const franka::RobotState& robot_state) noexcept;
+
+  /**
+   * Updates the frames, recomputing F_T_K only if one of them differs from the stored value.
+   *
+   * @param[in] F_T_EE End effector in flange frame.
+   * @param[in] EE_T_K Stiffness frame K in the end effector frame.
+   *
+   * @return True if F_T_K had to be recomputed.
+   */
+  bool set(const std::array<double, 16>& F_T_EE,            // NOLINT(readability-identifier-naming)
+           const std::array<double, 16>& EE_T_K) noexcept;  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return End effector in flange frame.
+   */
+  const std::array<double, 16>& F_T_EE() const noexcept;  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return Stiffness frame K in the end effector frame.
+   */
+  const std::array<double, 16>& EE_T_K() const noexcept;  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return Stiffness frame K in flange frame.
+   */
+  const std::array<double, 16>& F_T_K() const noexcept;  // NOLINT(readability-identifier-naming)
+
+ private:
+  std::array<double, 16> F_T_EE_;  // NOLINT(readability-identifier-naming)
+  std::array<double, 16> EE_T_K_;  // NOLINT(readability-identifier-naming)
+  std::array<double, 16> F_T_K_;   // NOLINT(readability-identifier-naming)
+};
+
+/**
+ * Inputs and structure-of-arrays output buffers for Model::evaluateBatch.
+ *
+ * Element k of sample i of a quantity is stored at index `k * size + i`, i.e. each element of a
+ * quantity is contiguous over all samples. For example, joint 3 of sample i is stored at
+ * `q[2 * size + i]`. Outputs set to nullptr are not computed.
+ */
+struct ModelBatch {
+  /**
+   * Number of samples.
+   */
+  size_t size{0};
+
+  /**
+   * Joint positions, 7 x #size.
+   */
+  const double* q{nullptr};
+
+  /**
+   * Frame of #poses and #zero_jacobians.
+   */
+  Frame frame{Frame::kEndEffector};
+
+  /**
+   * End effector and stiffness frames used for all samples.
+   */
+  EndEffectorFrames frames;
+
+  /**
+   * Weight of the attached total load including end effector. Unit: \f$[kg]\f$.
+   */
+  double m_total{0};
+
+  /**
+   * Translation from flange to center of mass of the attached total load. Unit: \f$[m]\f$.
+   */
+  std::array<double, 3> F_x_Ctotal{};  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Earth's gravity vector. Unit: \f$\frac{m}{s^2}\f$.
+   */
+  std::array<double, 3> gravity_earth{{0., 0., -9.81}};
+
+  /**
+   * Output: vectorized 4x4 pose matrices of #frame, column-major, 16 x #size.
+   */
+  double* poses{nullptr};
+
+  /**
+   * Output: vectorized 6x7 Jacobians of #frame relative to the base frame, column-major,
+   * 42 x #size.
+   */
+  double* zero_jacobians{nullptr};
+
+  /**
+   * Output: gravity vectors, 7 x #size. Unit: \f$[Nm]\f$.
+   */
+  double* gravity{nullptr};
+};
+
 class ModelLibrary;
 class Network;
 
@@ -63,6 +249,31 @@ class Model {
    */
   explicit Model(franka::Network& network);
 
+  /**
+   * Creates a new Model instance, using a model library cache directory.
+   *
+   * This constructor is for internal use only.
+   *
+   * @see Robot::loadModel(const std::string&)
+   *
+   * @param[in] network For internal use.
+   * @param[in] cache_directory For internal use.
+   * @param[in] server_version For internal use.
+   *
+   * @throw ModelException if the model library cannot be loaded.
+   */
+  Model(franka::Network& network, const std::string& cache_directory, uint16_t server_version);
+
+  /**
+   * Creates a new Model instance from a model library file, e.g. one that has been downloaded into
+   * the cache directory of Robot::loadModel(const std::string&).
+   *
+   * @param[in] library_path Path of the model library.
+   *
+   * @throw ModelException if the model library cannot be loaded.
+   */
+  explicit Model(const std::string& library_path);
+
   /**
    * Move-constructs a new Model instance.
    *
@@ -115,6 +326,103 @@ class Model {
       const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
       const;
 
+  /**
+   * Gets the 4x4 pose matrix for the given frame in base frame.
+   *
+   * The pose is represented as a 4x4 matrix in column-major format.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] q Joint position.
+   * @param[in] frames End effector and stiffness frames, with precomputed F_T_K.
+   *
+   * @return Vectorized 4x4 pose matrix, column-major.
+   */
+  std::array<double, 16> pose(Frame frame,
+                              const std::array<double, 7>& q,
+                              const EndEffectorFrames& frames) const;
+
+  /**
+   * Gets the 4x4 pose matrices of all frames in base frame, and optionally the Jacobians of all
+   * frames relative to the base frame.
+   *
+   * Equivalent to calling pose() (and zeroJacobian()) for every franka::Frame, but computes the
+   * stiffness frame transformation only once and writes directly into the given buffers.
+   *
+   * @param[in] robot_state State from which the poses should be calculated.
+   * @param[out] poses Vectorized 4x4 pose matrices, column-major, indexed by franka::Frame.
+   * @param[out] zero_jacobians If not nullptr, vectorized 6x7 Jacobians, column-major, indexed by
+   * franka::Frame.
+   */
+  void poseAll(const franka::RobotState& robot_state,
+               FramePoses* poses,
+               FrameJacobians* zero_jacobians = nullptr) const noexcept;
+
+  /**
+   * Gets the 4x4 pose matrices of all frames in base frame, and optionally the Jacobians of all
+   * frames relative to the base frame.
+   *
+   * @param[in] q Joint position.
+   * @param[in] F_T_EE End effector in flange frame.
+   * @param[in] EE_T_K Stiffness frame K in the end effector frame.
+   * @param[out] poses Vectorized 4x4 pose matrices, column-major, indexed by franka::Frame.
+   * @param[out] zero_jacobians If not nullptr, vectorized 6x7 Jacobians, column-major, indexed by
+   * franka::Frame.
+   */
+  void poseAll(const std::array<double, 7>& q,
+               const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+               const std::array<double, 16>& EE_T_K,  // NOLINT(readability-identifier-naming)
+               FramePoses* poses,
+               FrameJacobians* zero_jacobians = nullptr) const noexcept;
+
+  /**
+   * Gets the 4x4 pose matrices of all frames in base frame, and optionally the Jacobians of all
+   * frames relative to the base frame.
+   *
+   * @param[in] q Joint position.
+   * @param[in] frames End effector and stiffness frames, with precomputed F_T_K.
+   * @param[out] poses Vectorized 4x4 pose matrices, column-major, indexed by franka::Frame.
+   * @param[out] zero_jacobians If not nullptr, vectorized 6x7 Jacobians, column-major, indexed by
+   * franka::Frame.
+   */
+  void poseAll(const std::array<double, 7>& q,
+               const EndEffectorFrames& frames,
+               FramePoses* poses,
+               FrameJacobians* zero_jacobians = nullptr) const noexcept;
+
+  /**
+   * Gets the 6x7 Jacobians of all frames relative to the base frame.
+   *
+   * @param[in] robot_state State from which the Jacobians should be calculated.
+   * @param[out] zero_jacobians Vectorized 6x7 Jacobians, column-major, indexed by franka::Frame.
+   */
+  void zeroJacobianAll(const franka::RobotState& robot_state,
+                       FrameJacobians* zero_jacobians) const noexcept;
+
+  /**
+   * Gets the 6x7 Jacobians of all frames relative to the base frame.
+   *
+   * @param[in] q Joint position.
+   * @param[in] F_T_EE End effector in flange frame.
+   * @param[in] EE_T_K Stiffness frame K in the end effector frame.
+   * @param[out] zero_jacobians Vectorized 6x7 Jacobians, column-major, indexed by franka::Frame.
+   */
+  void zeroJacobianAll(
+      const std::array<double, 7>& q,
+      const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+      const std::array<double, 16>& EE_T_K,  // NOLINT(readability-identifier-naming)
+      FrameJacobians* zero_jacobians) const noexcept;
+
+  /**
+   * Gets the 6x7 Jacobians of all frames relative to the base frame.
+   *
+   * @param[in] q Joint position.
+   * @param[in] frames End effector and stiffness frames, with precomputed F_T_K.
+   * @param[out] zero_jacobians Vectorized 6x7 Jacobians, column-major, indexed by franka::Frame.
+   */
+  void zeroJacobianAll(const std::array<double, 7>& q,
+                       const EndEffectorFrames& frames,
+                       FrameJacobians* zero_jacobians) const noexcept;
+
   /**
    * Gets the 6x7 Jacobian for the given frame, relative to that frame.
    *
@@ -146,6 +454,21 @@ class Model {
       const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
       const;
 
+  /**
+   * Gets the 6x7 Jacobian for the given frame, relative to that frame.
+   *
+   * The Jacobian is represented as a 6x7 matrix in column-major format.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] q Joint position.
+   * @param[in] frames End effector and stiffness frames, with precomputed F_T_K.
+   *
+   * @return Vectorized 6x7 Jacobian, column-major.
+   */
+  std::array<double, 42> bodyJacobian(Frame frame,
+                                     const std::array<double, 7>& q,
+                                     const EndEffectorFrames& frames) const;
+
   /**
    * Gets the 6x7 Jacobian for the given joint relative to the base frame.
    *
@@ -177,6 +500,59 @@ class Model {
       const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
       const;
 
+  /**
+   * Gets the 6x7 Jacobian for the given joint relative to the base frame.
+   *
+   * The Jacobian is represented as a 6x7 matrix in column-major format.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] q Joint position.
+   * @param[in] frames End effector and stiffness frames, with precomputed F_T_K.
+   *
+   * @return Vectorized 6x7 Jacobian, column-major.
+   */
+  std::array<double, 42> zeroJacobian(Frame frame,
+                                     const std::array<double, 7>& q,
+                                     const EndEffectorFrames& frames) const;
+
+  /**
+   * Gets the time derivative of the 6x7 Jacobian for the given frame relative to the base frame.
+   *
+   * The derivative is computed analytically from the joint frame poses, so it costs a single
+   * kinematics evaluation. Multiplying it with the joint velocity yields the velocity-dependent
+   * part \f$\dot{J} \dot{q}\f$ of the Cartesian acceleration.
+   *
+   * The derivative is represented as a 6x7 matrix in column-major format.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] robot_state State from which the derivative should be calculated.
+   *
+   * @return Vectorized 6x7 Jacobian derivative, column-major.
+   */
+  std::array<double, 42> zeroJacobianDerivative(Frame frame,
+                                                const franka::RobotState& robot_state) const;
+
+  /**
+   * Gets the time derivative of the 6x7 Jacobian for the given frame relative to the base frame.
+   *
+   * The derivative is represented as a 6x7 matrix in column-major format.
+   *
+   * @param[in] frame The desired frame.
+   * @param[in] q Joint position.
+   * @param[in] dq Joint velocity.
+   * @param[in] F_T_EE End effector in flange frame.
+   * @param[in] EE_T_K Stiffness frame K in the end effector frame.
+   *
+   * @return Vectorized 6x7 Jacobian derivative, column-major.
+   */
+  std::array<double, 42> zeroJacobianDerivative(
+      Frame frame,
+      const std::array<double, 7>& q,
+      const std::array<double, 7>& dq,
+      const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+      const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
+      const;
+
   /**
    * Calculates the 7x7 mass matrix. Unit: \f$[kg \times m^2]\f$.
    *
@@ -278,6 +654,45 @@ class Model {
    */
   std::array<double, 7> gravity(const franka::RobotState& robot_state) const noexcept;
 
+  /**
+   * Calculates mass matrix, Coriolis and gravity vectors and the Jacobian of the given frame
+   * relative to the base frame in one call.
+   *
+   * Equivalent to calling mass(), coriolis(), gravity() and zeroJacobian() with the same robot
+   * state, but writes the results directly into the given buffer. If requested, the operational
+   * space inertia matrix and the dynamically consistent Jacobian pseudoinverse are computed as
+   * well, factorizing the mass matrix only once. No memory is allocated.
+   *
+   * @param[in] robot_state State from which the dynamics should be calculated.
+   * @param[out] dynamics Buffer to write the results to.
+   * @param[in] frame Frame of DynamicsBundle::zero_jacobian.
+   * @param[in] operational_space If true, also computes DynamicsBundle::lambda and
+   * DynamicsBundle::jacobian_pseudoinverse.
+   *
+   * @return False if the operational space quantities were requested, but could not be computed
+   * because \f$J M^{-1} J^T\f$ is not positive definite, e.g. in a singular configuration. The
+   * other quantities are valid in any case.
+   *
+   * @throw std::invalid_argument if the given frame is invalid.
+   */
+  bool dynamics(const franka::RobotState& robot_state,
+                DynamicsBundle* dynamics,
+                Frame frame = Frame::kEndEffector,
+                bool operational_space = false) const;
+
+  /**
+   * Evaluates poses, Jacobians and gravity vectors for many joint configurations.
+   *
+   * Meant for offline computations like trajectory validation or workspace maps. The samples are
+   * split into contiguous chunks, which are evaluated concurrently.
+   *
+   * @param[in] batch Inputs and output buffers.
+   * @param[in] thread_count Number of threads to use. If 0, one thread per hardware thread is used.
+   *
+   * @throw std::invalid_argument if ModelBatch::frame is invalid.
+   */
+  void evaluateBatch(const ModelBatch& batch, size_t thread_count = 0) const;
+
   /// @cond DO_NOT_DOCUMENT
   Model(const Model&) = delete;
   Model& operator=(const Model&) = delete;
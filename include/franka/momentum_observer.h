@@ -0,0 +1,143 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/duration.h>
+#include <franka/model.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file momentum_observer.h
+ * Contains the franka::MomentumObserver type.
+ */
+
+namespace franka {
+
+/**
+ * Parameters of the franka::MomentumObserver.
+ */
+struct MomentumObserverParameters {
+  /**
+   * Bandwidth of the filtered external torque and wrench estimates. Infinity disables filtering.
+   * Unit: \f$[Hz]\f$
+   */
+  double cutoff_frequency{100};
+  /**
+   * Damping of the least squares solution that maps external joint torques to a wrench. Keeps the
+   * wrench bounded near singularities. Unit: \f$[m]\f$
+   */
+  double wrench_damping{1e-2};
+};
+
+/**
+ * Estimates external joint torques and the external wrench on the stiffness frame with a
+ * generalized momentum observer.
+ *
+ * The observer compares the measured joint torques RobotState::tau_J with the change of the
+ * generalized momentum \f$p = M \dot{q}\f$ predicted by the rigid body model. Its residual
+ * follows the external torques through a first-order lag with the configured bandwidth, so
+ * contacts show up within a few cycles instead of after the robot's own heavy filtering. The
+ * observer is discretized with backward Euler and stays stable for any bandwidth; the unfiltered
+ * residual is available as well.
+ *
+ * The signs follow RobotState::tau_ext_hat_filtered and RobotState::O_F_ext_hat_K: torques and
+ * forces applied by the robot to the environment are positive.
+ *
+ * All state is kept in fixed-size arrays, so updates do not allocate. The model is evaluated
+ * once per update and the result is available through dynamics(), so controllers can reuse it
+ * in the same cycle.
+ *
+ * @see Robot::setMomentumObserver for running the observer inside control loops.
+ */
+class MomentumObserver {
+ public:
+  /**
+   * Creates a new observer.
+   *
+   * @param[in] parameters Observer parameters.
+   *
+   * @throw std::invalid_argument if a parameter is zero, negative or NaN.
+   */
+  explicit MomentumObserver(const MomentumObserverParameters& parameters = {});
+
+  /**
+   * Evaluates the dynamics of the given state with Model::dynamics for the stiffness frame,
+   * updates the estimates and writes the filtered estimates to RobotState::tau_ext_hat_filtered,
+   * RobotState::O_F_ext_hat_K and RobotState::K_F_ext_hat_K.
+   *
+   * @param[in] model Robot model.
+   * @param[in,out] robot_state Robot state to update from and to write to.
+   * @param[in] time_step Time since the last update.
+   */
+  void update(const Model& model, RobotState* robot_state, Duration time_step);
+
+  /**
+   * Updates the estimates from precomputed dynamics.
+   *
+   * The first update after construction or reset() assumes zero joint accelerations. An update
+   * with a time step of zero does the same.
+   *
+   * @param[in] robot_state Robot state to update from.
+   * @param[in] dynamics Dynamics at the given state. DynamicsBundle::zero_jacobian must belong to
+   * the stiffness frame.
+   * @param[in] time_step Time since the last update. Unit: \f$[s]\f$
+   */
+  void update(const RobotState& robot_state,
+              const DynamicsBundle& dynamics,
+              double time_step) noexcept;
+
+  /**
+   * Clears the estimates, so that the next update initializes the observer again.
+   */
+  void reset() noexcept;
+
+  /**
+   * @return Unfiltered external joint torques. Unit: \f$[Nm]\f$
+   */
+  const std::array<double, 7>& tau_ext() const noexcept;
+
+  /**
+   * @return External joint torques, filtered with the configured bandwidth. Unit: \f$[Nm]\f$
+   */
+  const std::array<double, 7>& tau_ext_filtered() const noexcept;
+
+  /**
+   * @return Unfiltered external wrench on the stiffness frame, expressed in base frame.
+   * Unit: \f$[N,N,N,Nm,Nm,Nm]\f$
+   */
+  const std::array<double, 6>& O_F_ext() const noexcept;  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return External wrench on the stiffness frame, expressed in base frame and filtered with the
+   * configured bandwidth. Unit: \f$[N,N,N,Nm,Nm,Nm]\f$
+   */
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  const std::array<double, 6>& O_F_ext_filtered() const noexcept;
+
+  /**
+   * @return Dynamics evaluated by the last update(const Model&, RobotState*, Duration).
+   */
+  const DynamicsBundle& dynamics() const noexcept;
+
+ private:
+  void solveWrench(const std::array<double, 42>& jacobian,
+                   const std::array<double, 7>& tau,
+                   std::array<double, 6>* wrench) const noexcept;
+
+  MomentumObserverParameters parameters_;
+  bool initialized_{false};
+
+  std::array<double, 7> previous_dq_{};
+  std::array<double, 49> previous_mass_{};
+
+  std::array<double, 7> tau_ext_{};
+  std::array<double, 7> tau_ext_filtered_{};
+  std::array<double, 6> O_F_ext_{};           // NOLINT(readability-identifier-naming)
+  std::array<double, 6> O_F_ext_filtered_{};  // NOLINT(readability-identifier-naming)
+
+  DynamicsBundle dynamics_{};
+};
+
+}  // namespace franka
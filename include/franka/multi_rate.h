@@ -0,0 +1,45 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @file multi_rate.h
+ * Contains options for control loops with a slow callback, see Robot::control.
+ */
+
+namespace franka {
+
+/**
+ * Determines how the output of a slow callback is passed to the control callback between two
+ * slow updates.
+ */
+enum class MultiRateHold {
+  /**
+   * Passes the latest output unchanged until the next one arrives.
+   */
+  kZeroOrderHold,
+  /**
+   * Interpolates linearly from the previous to the latest output over one slow period. The output
+   * is continuous, but lags by one more slow period.
+   */
+  kLinearInterpolation
+};
+
+/**
+ * Options for control loops with a slow callback.
+ */
+struct MultiRateOptions {
+  /**
+   * Number of control cycles per slow update. The slow callback is started with the robot state of
+   * every divisor-th control cycle.
+   */
+  size_t divisor{5};
+  /**
+   * Hold of the slow output between slow updates.
+   */
+  MultiRateHold hold{MultiRateHold::kZeroOrderHold};
+};
+
+}  // namespace franka
@@ -0,0 +1,173 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <franka/control_statistics.h>
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/filter_configuration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file multi_robot_control.h
+ * Contains the franka::MultiRobotControl type to control several robots from one thread.
+ */
+
+namespace franka {
+
+class Robot;
+
+/**
+ * State of one robot in a cycle of a franka::MultiRobotControl loop.
+ */
+struct MultiRobotState {
+  /**
+   * Latest state of the robot.
+   */
+  RobotState robot_state{};
+  /**
+   * Time since the previous state of the robot, zero if no new state arrived in this cycle.
+   */
+  Duration time_step{};
+  /**
+   * True if a new state of the robot arrived in this cycle. Torques returned for a robot without a
+   * new state are not sent.
+   */
+  bool updated{false};
+  /**
+   * Arrival time of the state after the first state of the cycle. Unit: \f$[\mu s]\f$
+   */
+  double arrival_offset{};
+};
+
+/**
+ * Timing statistics of one robot in franka::MultiRobotControl loops.
+ */
+struct MultiRobotStatistics {
+  /**
+   * Stage timings of the robot, recorded if enabled with Robot::setControlStatisticsEnabled.
+   */
+  ControlStatistics control{};
+  /**
+   * Arrival time of the robot's states after the first state of their cycle.
+   */
+  LatencyStatistics arrival_offset{};
+  /**
+   * Number of cycles in which no new state of the robot arrived within the alignment window.
+   */
+  uint64_t missed_states{};
+};
+
+/**
+ * Drives joint-level torque control loops of several robots from one realtime thread.
+ *
+ * Every cycle waits on the UDP sockets of all robots at once. After the first state of a cycle has
+ * arrived, the loop waits at most for the alignment window for the states of the other robots,
+ * then calls the control callback once with the latest states of all robots. The torque commands
+ * are filtered, made passive and rate limited per robot as in Robot::control, and sent to all
+ * robots with a new state back to back, before any robot is waited on again.
+ *
+ * The motions of all robots are started together and finished together: as soon as one of the
+ * returned commands is marked with franka::MotionFinished, all motions are finished.
+ *
+ * @code{.cpp}
+ * franka::Robot left("172.16.0.2");
+ * franka::Robot right("172.16.1.2");
+ * franka::MultiRobotControl control({&left, &right});
+ * control.control([](const std::vector<franka::MultiRobotState>& states,
+ *                    std::vector<franka::Torques>* torques) {
+ *   // Fill (*torques)[i] for states[i].
+ * });
+ * @endcode
+ */
+class MultiRobotControl {
+ public:
+  /**
+   * Callback receiving the states of all robots and writing their torque commands.
+   *
+   * The torque vector has one zero-initialized entry per robot, in the order of the robots.
+   */
+  using ControlCallback = std::function<void(const std::vector<MultiRobotState>& states,
+                                             std::vector<Torques>* torques)>;
+
+  /**
+   * Default time to wait for the states of the other robots after the first state of a cycle.
+   */
+  static constexpr std::chrono::microseconds kDefaultAlignmentWindow{500};
+
+  /**
+   * Creates a multi-robot control loop.
+   *
+   * @param[in] robots Robots to control. They must outlive this instance.
+   * @param[in] alignment_window Time to wait for the states of the other robots after the first
+   * state of a cycle has arrived.
+   *
+   * @throw std::invalid_argument if no robot is given, a robot is given twice or is null, or the
+   * alignment window is not shorter than one control cycle.
+   */
+  explicit MultiRobotControl(const std::vector<Robot*>& robots,
+                             std::chrono::microseconds alignment_window = kDefaultAlignmentWindow);
+
+  /**
+   * Starts the joint-level torque control loops of all robots.
+   *
+   * Sets realtime priority for the current thread. Cannot be executed while another control or
+   * read operation is running on one of the robots.
+   *
+   * @param[in] control_callback Callback providing the torque commands of all robots.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * @param[in] filter_configuration Cutoff frequencies of the low-pass filters applied on the
+   * commanded torques of every robot. See franka::FilterConfiguration.
+   *
+   * @throw ControlException if an error related to torque control occurred on one of the robots.
+   * All motions are canceled in this case.
+   * @throw InvalidOperationException if a conflicting operation is already running.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw RealtimeException if realtime priority cannot be set for the current thread.
+   * @throw std::invalid_argument if the callback is empty or torque commands are NaN or infinity.
+   */
+  void control(const ControlCallback& control_callback,
+               bool limit_rate = true,
+               const FilterConfiguration& filter_configuration = {});
+
+  /**
+   * @return Number of controlled robots.
+   */
+  size_t size() const noexcept;
+
+  /**
+   * Returns the timing statistics recorded since creation or the last reset.
+   *
+   * @return Statistics per robot, in the order of the robots.
+   *
+   * @throw InvalidOperationException if the control loop is running.
+   */
+  std::vector<MultiRobotStatistics> statistics();
+
+  /**
+   * Clears the arrival statistics and the stage timings of all robots.
+   *
+   * @throw InvalidOperationException if the control loop is running.
+   */
+  void resetStatistics();
+
+  /// @cond DO_NOT_DOCUMENT
+  ~MultiRobotControl() noexcept;
+  MultiRobotControl(const MultiRobotControl&) = delete;
+  MultiRobotControl& operator=(const MultiRobotControl&) = delete;
+  /// @endcond
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
@@ -0,0 +1,104 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/rate_limiting.h>
+
+/**
+ * @file online_trajectory_generator.h
+ * Contains the franka::OnlineTrajectoryGenerator type.
+ */
+
+namespace franka {
+
+/**
+ * Generates jerk-limited joint motions towards targets that may change in every cycle.
+ *
+ * Unlike limitRate(), which clips each command to the limits of the next step only, the generator
+ * plans ahead: in every cycle it computes the time-optimal jerk-limited motion from the current
+ * state to rest at the target and commands the state of that motion after one time step. The
+ * target is reached without overshoot and may change in every cycle. Joints move independently of
+ * each other; their motions are not synchronized to arrive at the same time.
+ *
+ * Between calls, the generator keeps the continuous position, velocity and acceleration of its
+ * trajectory. The finite differences of the generated commands, which the robot checks against its
+ * limits, then stay within the limits as well. The trajectory is restarted from the given desired
+ * values of the robot state whenever they differ from the last generated command, e.g. at the start
+ * of a motion or after lost commands.
+ *
+ * A step takes about ten microseconds for all joints and does not allocate.
+ *
+ * @see Robot::setOnlineTrajectoryGeneration()
+ */
+class OnlineTrajectoryGenerator {
+ public:
+  /**
+   * Creates a generator.
+   *
+   * @param[in] max_velocity Per-joint maximum velocity. Unit: \f$[\frac{rad}{s}]\f$.
+   * @param[in] max_acceleration Per-joint maximum acceleration. Unit: \f$[\frac{rad}{s^2}]\f$.
+   * @param[in] max_jerk Per-joint maximum jerk. Unit: \f$[\frac{rad}{s^3}]\f$.
+   * @param[in] delta_t Time between two commands. Unit: \f$[s]\f$.
+   *
+   * @throw std::invalid_argument if a limit or the time step is not positive and finite.
+   */
+  OnlineTrajectoryGenerator(const std::array<double, 7>& max_velocity = kMaxJointVelocity,
+                            const std::array<double, 7>& max_acceleration = kMaxJointAcceleration,
+                            const std::array<double, 7>& max_jerk = kMaxJointJerk,
+                            double delta_t = kDeltaT);
+
+  /**
+   * Computes the next joint position command towards a target position.
+   *
+   * @param[in] target_position Joint positions to move to. Unit: \f$[rad]\f$.
+   * @param[in] last_commanded_position Commanded joint positions of the previous time step.
+   * @param[in] last_commanded_velocity Commanded joint velocities of the previous time step.
+   * @param[in] last_commanded_acceleration Commanded joint accelerations of the previous time
+   * step.
+   *
+   * @return Joint positions to command in this time step.
+   */
+  std::array<double, 7> nextPosition(
+      const std::array<double, 7>& target_position,
+      const std::array<double, 7>& last_commanded_position,
+      const std::array<double, 7>& last_commanded_velocity,
+      const std::array<double, 7>& last_commanded_acceleration) noexcept;
+
+  /**
+   * Computes the next joint velocity command towards a target velocity.
+   *
+   * Targets beyond the velocity limits are clipped to them.
+   *
+   * @param[in] target_velocity Joint velocities to reach. Unit: \f$[\frac{rad}{s}]\f$.
+   * @param[in] last_commanded_velocity Commanded joint velocities of the previous time step.
+   * @param[in] last_commanded_acceleration Commanded joint accelerations of the previous time
+   * step.
+   *
+   * @return Joint velocities to command in this time step.
+   */
+  std::array<double, 7> nextVelocity(
+      const std::array<double, 7>& target_velocity,
+      const std::array<double, 7>& last_commanded_velocity,
+      const std::array<double, 7>& last_commanded_acceleration) noexcept;
+
+  /**
+   * Restarts the trajectory from the given desired values in the next step.
+   */
+  void reset() noexcept;
+
+ private:
+  std::array<double, 7> max_velocity_;
+  std::array<double, 7> max_acceleration_;
+  std::array<double, 7> max_jerk_;
+  double delta_t_;
+
+  bool has_state_{false};
+  std::array<double, 7> position_{};
+  std::array<double, 7> velocity_{};
+  std::array<double, 7> acceleration_{};
+  std::array<double, 7> last_command_{};
+};
+
+}  // namespace franka
@@ -0,0 +1,96 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/model.h>
+
+/**
+ * @file operational_space.h
+ * Contains the franka::OperationalSpace type.
+ */
+
+namespace franka {
+
+/**
+ * Operational space quantities derived from the mass matrix and a Jacobian.
+ *
+ * update() factorizes the 7x7 mass matrix \f$M\f$ once with a Cholesky decomposition and derives
+ * all quantities from that factorization, in the same way as Model::dynamics(). All matrices are
+ * fixed-size and vectorized in column-major format, so no memory is allocated and the type can be
+ * used inside a control loop.
+ */
+class OperationalSpace {
+ public:
+  /**
+   * Derives all quantities from the given mass matrix and Jacobian.
+   *
+   * @param[in] mass Vectorized 7x7 mass matrix, column-major.
+   * @param[in] zero_jacobian Vectorized 6x7 Jacobian, column-major.
+   *
+   * @return False if the mass matrix or \f$J M^{-1} J^T\f$ is not positive definite, e.g. in a
+   * singular configuration. In that case, the previous values are kept.
+   */
+  bool update(const std::array<double, 49>& mass,
+              const std::array<double, 42>& zero_jacobian) noexcept;
+
+  /**
+   * Derives all quantities from DynamicsBundle::mass and DynamicsBundle::zero_jacobian.
+   *
+   * @param[in] dynamics Dynamics as computed by Model::dynamics.
+   *
+   * @return False if the mass matrix or \f$J M^{-1} J^T\f$ is not positive definite.
+   */
+  bool update(const DynamicsBundle& dynamics) noexcept;
+
+  /**
+   * @return Vectorized 7x7 inverse mass matrix \f$M^{-1}\f$, column-major.
+   */
+  const std::array<double, 49>& massInverse() const noexcept;
+
+  /**
+   * @return Vectorized 6x6 operational space inertia matrix \f$\Lambda = (J M^{-1} J^T)^{-1}\f$,
+   * column-major.
+   */
+  const std::array<double, 36>& lambda() const noexcept;
+
+  /**
+   * @return Vectorized 7x6 dynamically consistent pseudoinverse
+   * \f$\bar{J} = M^{-1} J^T \Lambda\f$, column-major.
+   */
+  const std::array<double, 42>& jacobianPseudoinverse() const noexcept;
+
+  /**
+   * @return Vectorized 7x7 null space projector for joint torques \f$N = I - J^T \bar{J}^T\f$,
+   * column-major.
+   */
+  const std::array<double, 49>& nullspaceProjector() const noexcept;
+
+  /**
+   * Projects the given joint torques into the null space of the Jacobian.
+   *
+   * @param[in] tau Joint torques. Unit: \f$[Nm]\f$.
+   *
+   * @return \f$N \tau\f$. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> projectToNullspace(const std::array<double, 7>& tau) const noexcept;
+
+  /**
+   * Maps the given Cartesian wrench to joint torques, \f$J^T F\f$.
+   *
+   * @param[in] wrench Cartesian wrench. Unit: \f$[N,N,N,Nm,Nm,Nm]\f$.
+   *
+   * @return Joint torques. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> jacobianTransposeTimes(const std::array<double, 6>& wrench) const noexcept;
+
+ private:
+  std::array<double, 42> zero_jacobian_{};
+  std::array<double, 49> mass_inverse_{};
+  std::array<double, 36> lambda_{};
+  std::array<double, 42> jacobian_pseudoinverse_{};
+  std::array<double, 49> nullspace_projector_{};
+};
+
+}  // namespace franka
@@ -0,0 +1,125 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include <franka/duration.h>
+
+/**
+ * @file passivity_controller.h
+ * Contains the franka::PassivityController type.
+ */
+
+namespace franka {
+
+/**
+ * Parameters of the franka::PassivityController.
+ */
+struct PassivityControllerParameters {
+  /**
+   * Largest damping the controller injects into a joint. Unit: \f$[\frac{Nm \cdot s}{rad}]\f$
+   */
+  std::array<double, 7> max_damping{{10, 10, 10, 10, 10, 10, 10}};
+  /**
+   * Joint velocity below which no damping is injected, so that measurement noise at standstill
+   * does not cause large damping torques. Unit: \f$[\frac{rad}{s}]\f$
+   */
+  double min_velocity{1e-3};
+};
+
+/**
+ * Energy telemetry of the franka::PassivityController.
+ */
+struct PassivityStatistics {
+  /**
+   * Number of processed commands.
+   */
+  uint64_t cycles{};
+  /**
+   * Energy absorbed by the torque controller of every joint in the current control loop,
+   * including the energy dissipated by the passivity controller. Unit: \f$[J]\f$
+   */
+  std::array<double, 7> observed_energy{};
+  /**
+   * Total energy dissipated by the injected damping of every joint. Unit: \f$[J]\f$
+   */
+  std::array<double, 7> dissipated_energy{};
+  /**
+   * Number of commands in which damping was injected into the given joint.
+   */
+  std::array<uint64_t, 7> active_cycles{};
+};
+
+/**
+ * Time-domain passivity observer and controller for torque commands.
+ *
+ * For every joint, the observer integrates the energy \f$E = -\sum \tau_{J,d} \dot{q} \Delta t\f$
+ * that the commanded torque has absorbed from the robot. A passive controller, e.g. a virtual
+ * environment, never returns more energy than it absorbed, so \f$E \geq 0\f$. Before a new torque
+ * \f$\tau\f$ is commanded, the controller predicts the energy after the next cycle. If it would
+ * become negative, a damping torque \f$-\alpha \dot{q}\f$ is added with the smallest \f$\alpha\f$
+ * that keeps the energy at zero, bounded by PassivityControllerParameters::max_damping.
+ *
+ * All state is stored in fixed-size arrays, so the controller does not allocate.
+ */
+class PassivityController {
+ public:
+  /**
+   * Creates a new passivity controller.
+   *
+   * @param[in] parameters Controller parameters.
+   *
+   * @throw std::invalid_argument if a parameter is negative, infinite or NaN.
+   */
+  explicit PassivityController(const PassivityControllerParameters& parameters = {});
+
+  /**
+   * Observes the energy of the last cycle and makes a torque command passive.
+   *
+   * @param[in] tau Torque command to make passive. Unit: \f$[Nm]\f$
+   * @param[in] tau_J_d Torque that was commanded during the last cycle. Unit: \f$[Nm]\f$
+   * @param[in] dq Measured joint velocities. Unit: \f$[\frac{rad}{s}]\f$
+   * @param[in] time_step Time since the last command.
+   *
+   * @return Torque command including the injected damping. Unit: \f$[Nm]\f$
+   */
+  std::array<double, 7> control(const std::array<double, 7>& tau,
+                                const std::array<double, 7>& tau_J_d,
+                                const std::array<double, 7>& dq,
+                                Duration time_step) noexcept;
+
+  /**
+   * Clears the observed energy, e.g. when a new control loop starts. The dissipated energy and
+   * active cycles are kept.
+   */
+  void reset() noexcept;
+
+  /**
+   * Clears all statistics, including the observed energy.
+   */
+  void resetStatistics() noexcept;
+
+  /**
+   * @return Energy telemetry since construction or the last resetStatistics().
+   */
+  const PassivityStatistics& statistics() const noexcept;
+
+ private:
+  PassivityControllerParameters parameters_;
+  PassivityStatistics statistics_;
+};
+
+/**
+ * Streams the passivity statistics as JSON object.
+ *
+ * @param[in] ostream Ostream instance
+ * @param[in] statistics PassivityStatistics instance to stream
+ *
+ * @return Ostream instance
+ */
+std::ostream& operator<<(std::ostream& ostream, const PassivityStatistics& statistics);
+
+}  // namespace franka
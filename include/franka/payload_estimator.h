@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <franka/model.h>
+#include <franka/robot.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file payload_estimator.h
+ * Contains the franka::PayloadEstimator type.
+ */
+
+namespace franka {
+
+/**
+ * Parameters of the franka::PayloadEstimator.
+ */
+struct PayloadEstimatorParameters {
+  /**
+   * Forgetting factor of the recursive least squares update, applied once per update. Values
+   * closer to one average over more samples, smaller values follow a changed load faster.
+   */
+  double forgetting_factor{0.9995};
+  /**
+   * Variance of the parameters at initialization and the upper bound of their variance while the
+   * robot does not excite them. Unit: \f$[kg^2]\f$ and \f$[kg^2 \times m^2]\f$
+   */
+  double initial_variance{1e2};
+  /**
+   * Samples with a joint velocity above this limit are not used, because the estimator neglects
+   * inertial torques. Unit: \f$[\frac{rad}{s}]\f$
+   */
+  double max_joint_velocity{0.1};
+  /**
+   * Below this mass, the estimated center of mass is reported as zero. Unit: \f$[kg]\f$
+   */
+  double min_mass{0.05};
+};
+
+/**
+ * Identifies the mass and center of mass of the load attached to the end effector while the robot
+ * is in use.
+ *
+ * The estimator compares the measured joint torques with the gravity torques of the robot and its
+ * configured end effector. The remainder is linear in the mass \f$m\f$ and the first moment
+ * \f$m \times {}^Fx_{C_\text{load}}\f$ of the load, the same parameterization in which
+ * combined loads add up, and is tracked with a recursive least squares filter with forgetting.
+ *
+ * The filter state consists of fixed-size arrays, so an update does not allocate and only costs a
+ * few hundred floating point operations on top of the model calls. It can stay enabled inside the
+ * control loop. The result can be applied with apply() between motions.
+ */
+class PayloadEstimator {
+ public:
+  /**
+   * Creates a new estimator.
+   *
+   * @param[in] parameters Estimator parameters.
+   *
+   * @throw std::invalid_argument if a parameter is out of range, infinite or NaN.
+   */
+  explicit PayloadEstimator(const PayloadEstimatorParameters& parameters = {});
+
+  /**
+   * Updates the estimate from the joint torques caused by the load.
+   *
+   * @param[in] tau_load Measured joint torques minus the gravity torques of robot and end
+   * effector. Unit: \f$[Nm]\f$
+   * @param[in] O_T_F Pose of the flange in base frame, column-major.
+   * @param[in] O_J_F Zero Jacobian of the flange, column-major.
+   * @param[in] gravity_earth Earth's gravity vector in base frame. Unit: \f$\frac{m}{s^2}\f$
+   */
+  void update(const std::array<double, 7>& tau_load,
+              const std::array<double, 16>& O_T_F,  // NOLINT(readability-identifier-naming)
+              const std::array<double, 42>& O_J_F,  // NOLINT(readability-identifier-naming)
+              const std::array<double, 3>& gravity_earth) noexcept;
+
+  /**
+   * Updates the estimate from RobotState::tau_J, using the end effector parameters and
+   * RobotState::O_ddP_O of the given state.
+   *
+   * Samples in which a joint moves faster than PayloadEstimatorParameters::max_joint_velocity are
+   * skipped.
+   *
+   * @param[in] model Robot model.
+   * @param[in] robot_state Robot state to update from.
+   *
+   * @return True if the sample was used.
+   */
+  bool update(const Model& model, const RobotState& robot_state);
+
+  /**
+   * Sets the load of the robot to the current estimate.
+   *
+   * Must not be called while a motion is running.
+   *
+   * @param[in] robot Robot to configure.
+   * @param[in] load_inertia Inertia matrix of the load, column-major, which is not identified.
+   * Unit: \f$[kg \times m^2]\f$
+   *
+   * @throw CommandException if the Control reports an error.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   */
+  void apply(Robot& robot, const std::array<double, 9>& load_inertia = {}) const;
+
+  /**
+   * Discards the estimate and starts again with the initial variance.
+   */
+  void reset() noexcept;
+
+  /**
+   * @return Estimated mass of the load, not smaller than zero. Unit: \f$[kg]\f$
+   */
+  double mass() const noexcept;
+
+  /**
+   * @return Estimated center of mass of the load in flange frame, zero below
+   * PayloadEstimatorParameters::min_mass. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> F_x_Cload() const noexcept;  // NOLINT(readability-identifier-naming)
+
+  /**
+   * @return Variance of the estimated mass. Unit: \f$[kg^2]\f$
+   */
+  double massVariance() const noexcept;
+
+  /**
+   * @return Number of samples used since construction or the last reset().
+   */
+  size_t sampleCount() const noexcept;
+
+ private:
+  PayloadEstimatorParameters parameters_;
+
+  // Mass and first moment of mass in flange frame.
+  std::array<double, 4> theta_{};
+  // Symmetric 4x4 covariance matrix of theta_, column-major.
+  std::array<double, 16> covariance_{};
+  size_t sample_count_{0};
+};
+
+}  // namespace franka
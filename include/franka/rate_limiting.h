@@ -101,6 +101,16 @@ constexpr double kMaxElbowAcceleration = 10.0000 - kLimitEps;
  */
 constexpr double kMaxElbowVelocity =
     2.1750 - kLimitEps - kTolNumberPacketsLost * kDeltaT * kMaxElbowAcceleration;
+/**
+ * Lower joint position limits
+ */
+constexpr std::array<double, 7> kMinJointPosition{
+    {-2.8973, -1.7628, -2.8973, -3.0718, -2.8973, -0.0175, -2.8973}};
+/**
+ * Upper joint position limits
+ */
+constexpr std::array<double, 7> kMaxJointPosition{
+    {2.8973, 1.7628, 2.8973, -0.0698, 2.8973, 3.7525, 2.8973}};
 
 /**
  * Limits the rate of an input vector of per-joint commands considering the maximum allowed
@@ -6,12 +6,35 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <franka/butterworth_filter.h>
+#include <franka/callback_deadline.h>
+#include <franka/clock_estimator.h>
 #include <franka/command_types.h>
+#include <franka/communication_statistics.h>
+#include <franka/control_statistics.h>
 #include <franka/control_types.h>
+#include <franka/datagram_recorder.h>
+#include <franka/datagram_replay.h>
 #include <franka/duration.h>
+#include <franka/filter_configuration.h>
+#include <franka/flight_recorder.h>
+#include <franka/joint_state_estimator.h>
+#include <franka/limiting_statistics.h>
+#include <franka/log.h>
 #include <franka/lowpass_filter.h>
+#include <franka/multi_rate.h>
+#include <franka/passivity_controller.h>
 #include <franka/robot_state.h>
+#include <franka/robot_state_view.h>
+#include <franka/shared_memory_metrics.h>
+#include <franka/simulated_robot.h>
+#include <franka/state_broadcast.h>
+#include <franka/state_publisher.h>
+#include <franka/streaming_recorder.h>
 
 /**
  * @file robot.h
@@ -21,6 +44,64 @@
 namespace franka {
 
 class Model;
+class MomentumObserver;
+struct RobotStartup;
+struct StartupOptions;
+
+/// @cond DO_NOT_DOCUMENT
+namespace detail {
+
+template <typename Callback, typename = void>
+struct CallbackOutput {
+  using type = void;
+};
+
+template <typename Callback>
+struct CallbackOutput<Callback,
+                      decltype(void(std::declval<std::decay_t<Callback>&>()(
+                          std::declval<const RobotState&>(),
+                          std::declval<franka::Duration>())))> {
+  using type = std::decay_t<decltype(std::declval<std::decay_t<Callback>&>()(
+      std::declval<const RobotState&>(),
+      std::declval<franka::Duration>()))>;
+};
+
+template <typename T>
+struct IsStdFunction : std::false_type {};
+
+template <typename T>
+struct IsStdFunction<std::function<T>> : std::true_type {};
+
+template <typename T>
+struct IsMotionGeneratorOutput
+    : std::integral_constant<bool,
+                             std::is_same<T, JointPositions>::value ||
+                                 std::is_same<T, JointVelocities>::value ||
+                                 std::is_same<T, CartesianPose>::value ||
+                                 std::is_same<T, CartesianVelocities>::value> {};
+
+template <typename Callback>
+using IsTorqueCallback = std::integral_constant<
+    bool,
+    !IsStdFunction<std::decay_t<Callback>>::value &&
+        std::is_same<typename CallbackOutput<Callback>::type, Torques>::value>;
+
+template <typename Callback>
+using IsMotionGeneratorCallback = std::integral_constant<
+    bool,
+    !IsStdFunction<std::decay_t<Callback>>::value &&
+        IsMotionGeneratorOutput<typename CallbackOutput<Callback>::type>::value>;
+
+// Callables passed as lvalues are copied, like by the std::function overloads, so that every
+// control loop starts from the state the caller passed. Rvalues live until the control loop has
+// finished and are referenced.
+template <typename Callback>
+using CallbackStorage = std::conditional_t<std::is_lvalue_reference<Callback>::value,
+                                           std::decay_t<Callback>,
+                                           Callback&&>;
+
+}  // namespace detail
+/// @endcond
 
 /**
  * Maintains a network connection to the robot, provides the current robot state, gives access to
@@ -85,6 +166,77 @@ class Robot {
                  RealtimeConfig realtime_config = RealtimeConfig::kEnforce,
                  size_t log_size = 50);
 
+  /**
+   * Establishes a connection with the robot and applies additional realtime measures (CPU
+   * pinning, memory locking, prefaulting) to the control loop thread.
+   *
+   * @param[in] franka_address IP/hostname of the robot.
+   * @param[in] realtime_config if set to Enforce, an exception will be thrown if realtime priority
+   * or any of the given realtime_options cannot be applied when a control loop is started.
+   * Setting realtime_config to Ignore disables this behavior.
+   * @param[in] realtime_options Realtime measures applied before a control loop is started.
+   * @param[in] log_size sets how many last states should be kept for logging purposes.
+   * The log is provided when a ControlException is thrown.
+   * @param[in] log_fields selects the fields kept in the log. Logging fewer fields reduces the
+   * memory used per logged state, which allows a larger log_size.
+   * @param[in] log_compression if enabled, the log is kept compressed, which reduces the memory
+   * used per logged state further, at the cost of a bounded loss of precision.
+   *
+   * @throw NetworkException if the connection is unsuccessful.
+   * @throw IncompatibleVersionException if this version of `libfranka` is not supported.
+   * @throw std::invalid_argument if log_compression is enabled with invalid parameters.
+   *
+   * @see RealtimeOptions
+   * @see LogFields
+   * @see LogCompression
+   */
+  Robot(const std::string& franka_address,
+        RealtimeConfig realtime_config,
+        const RealtimeOptions& realtime_options,
+        size_t log_size = 50,
+        LogFields log_fields = LogFields::kAll,
+        const LogCompression& log_compression = LogCompression());
+
+  /**
+   * Establishes a connection with a simulated robot.
+   *
+   * The simulation must outlive the Robot instance.
+   *
+   * @param[in] simulation Simulation to connect to.
+   * @param[in] realtime_config if set to Enforce, an exception will be thrown if realtime priority
+   * cannot be set when required. Simulations usually run on machines without realtime kernel, so
+   * realtime priority is not required by default.
+   * @param[in] log_size sets how many last states should be kept for logging purposes.
+   * The log is provided when a ControlException is thrown.
+   *
+   * @throw NetworkException if the connection is unsuccessful.
+   *
+   * @see SimulatedRobot
+   */
+  explicit Robot(SimulatedRobot& simulation,
+                 RealtimeConfig realtime_config = RealtimeConfig::kIgnore,
+                 size_t log_size = 50);
+
+  /**
+   * Establishes a connection with the replay of a recorded session.
+   *
+   * The replay must outlive the Robot instance.
+   *
+   * @param[in] replay Replay to connect to.
+   * @param[in] realtime_config if set to Enforce, an exception will be thrown if realtime priority
+   * cannot be set when required. Replays usually run on machines without realtime kernel, so
+   * realtime priority is not required by default.
+   * @param[in] log_size sets how many last states should be kept for logging purposes.
+   * The log is provided when a ControlException is thrown.
+   *
+   * @throw NetworkException if the connection is unsuccessful.
+   *
+   * @see DatagramReplay
+   */
+  explicit Robot(DatagramReplay& replay,
+                 RealtimeConfig realtime_config = RealtimeConfig::kIgnore,
+                 size_t log_size = 50);
+
   /**
    * Move-constructs a new Robot instance.
    *
@@ -158,8 +310,9 @@ class Robot {
    * See @ref callback-docs "here" for more details.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to torque control or motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -171,7 +324,111 @@ class Robot {
    */
   void control(std::function<Torques(const RobotState&, franka::Duration)> control_callback,
                bool limit_rate = true,
-               double cutoff_frequency = kDefaultCutoffFrequency);
+               const FilterConfiguration& filter_configuration = {});
+
+  /**
+   * Starts a control loop for sending joint-level torque commands, passing a
+   * franka::RobotStateView to the callback.
+   *
+   * In contrast to the franka::RobotState overload, the received robot state is not converted in
+   * every control cycle. Prefer this overload for controllers that only read a few fields of the
+   * robot state. The callback always runs on the calling thread, without the deadline set by
+   * setCallbackDeadline().
+   *
+   * Sets realtime priority for the current thread.
+   * Cannot be executed while another control or motion generator loop is active.
+   *
+   * @param[in] control_callback Callback function providing joint-level torque commands. The
+   * given view is only valid for the duration of the callback.
+   * See @ref callback-docs "here" for more details.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * This could distort your motion!
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
+   *
+   * @throw ControlException if an error related to torque control or motion generation occurred.
+   * @throw InvalidOperationException if a conflicting operation is already running.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw RealtimeException if realtime priority cannot be set for the current thread.
+   * @throw std::invalid_argument if joint-level torque commands are NaN or infinity.
+   *
+   * @see Robot::Robot to change behavior if realtime priority cannot be set.
+   */
+  void control(std::function<Torques(const RobotStateView&, franka::Duration)> control_callback,
+               bool limit_rate = true,
+               const FilterConfiguration& filter_configuration = {});
+
+  /**
+   * Starts a control loop for sending joint-level torque commands, which are filtered with the
+   * given Butterworth filter instead of the first-order low-pass filter.
+   *
+   * Sets realtime priority for the current thread.
+   * Cannot be executed while another control or motion generator loop is active.
+   *
+   * @param[in] control_callback Callback function providing joint-level torque commands.
+   * See @ref callback-docs "here" for more details.
+   * @param[in] torque_filter Filter for the commanded torques, designed for a sample time of
+   * 1 ms. The control loop uses its own copy, which starts from the first commanded torques.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * This could distort your motion!
+   *
+   * @throw ControlException if an error related to torque control or motion generation occurred.
+   * @throw InvalidOperationException if a conflicting operation is already running.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw RealtimeException if realtime priority cannot be set for the current thread.
+   * @throw std::invalid_argument if joint-level torque commands are NaN or infinity.
+   *
+   * @see Robot::Robot to change behavior if realtime priority cannot be set.
+   */
+  void control(std::function<Torques(const RobotState&, franka::Duration)> control_callback,
+               const ButterworthFilter<7>& torque_filter,
+               bool limit_rate = true);
+
+  /**
+   * Starts a control loop for sending joint-level torque commands, with an additional slow callback
+   * for expensive computations such as model predictive control or scene updates.
+   *
+   * The slow callback is called with the current robot state before the motion starts, and then
+   * with the robot state of every MultiRateOptions::divisor-th control cycle on a helper thread.
+   * Its output is passed to the control callback in every cycle, held or interpolated according to
+   * MultiRateOptions::hold. The control callback never waits for the slow callback: if the slow
+   * callback takes longer than its period, it continues with the newest robot state and the
+   * control callback keeps receiving the last output.
+   *
+   * Sets realtime priority for the current thread. The helper thread keeps the default priority.
+   * Cannot be executed while another control or motion generator loop is active.
+   *
+   * @param[in] slow_callback Callback function computing the slow output from the robot state and
+   * the time since its last call. All outputs must have the size of the first one.
+   * @param[in] control_callback Callback function providing joint-level torque commands from the
+   * robot state and the current slow output.
+   * See @ref callback-docs "here" for more details.
+   * @param[in] options Divisor and hold of the slow callback.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * This could distort your motion!
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
+   *
+   * @throw ControlException if an error related to torque control or motion generation occurred.
+   * @throw InvalidOperationException if a conflicting operation is already running.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw RealtimeException if realtime priority cannot be set for the current thread.
+   * @throw std::invalid_argument if joint-level torque commands are NaN or infinity, a callback is
+   * empty, the divisor is zero or the slow output changes in size.
+   *
+   * Exceptions thrown by the slow callback are rethrown by the control loop in the next cycle.
+   *
+   * @see Robot::Robot to change behavior if realtime priority cannot be set.
+   */
+  void control(
+      std::function<std::vector<double>(const RobotState&, franka::Duration)> slow_callback,
+      std::function<Torques(const RobotState&, const std::vector<double>&, franka::Duration)>
+          control_callback,
+      const MultiRateOptions& options = {},
+      bool limit_rate = true,
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for sending joint-level torque commands and joint positions.
@@ -185,8 +442,9 @@ class Robot {
    * callback-docs "here" for more details.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to torque control or motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -201,7 +459,7 @@ class Robot {
       std::function<Torques(const RobotState&, franka::Duration)> control_callback,
       std::function<JointPositions(const RobotState&, franka::Duration)> motion_generator_callback,
       bool limit_rate = true,
-      double cutoff_frequency = kDefaultCutoffFrequency);
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for sending joint-level torque commands and joint velocities.
@@ -215,8 +473,9 @@ class Robot {
    * callback-docs "here" for more details.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to torque control or motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -231,7 +490,7 @@ class Robot {
       std::function<Torques(const RobotState&, franka::Duration)> control_callback,
       std::function<JointVelocities(const RobotState&, franka::Duration)> motion_generator_callback,
       bool limit_rate = true,
-      double cutoff_frequency = kDefaultCutoffFrequency);
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for sending joint-level torque commands and Cartesian poses.
@@ -245,8 +504,9 @@ class Robot {
    * callback-docs "here" for more details.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to torque control or motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -261,7 +521,7 @@ class Robot {
       std::function<Torques(const RobotState&, franka::Duration)> control_callback,
       std::function<CartesianPose(const RobotState&, franka::Duration)> motion_generator_callback,
       bool limit_rate = true,
-      double cutoff_frequency = kDefaultCutoffFrequency);
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for sending joint-level torque commands and Cartesian velocities.
@@ -275,8 +535,9 @@ class Robot {
    * callback-docs "here" for more details.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to torque control or motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -291,7 +552,7 @@ class Robot {
                std::function<CartesianVelocities(const RobotState&, franka::Duration)>
                    motion_generator_callback,
                bool limit_rate = true,
-               double cutoff_frequency = kDefaultCutoffFrequency);
+               const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for a joint position motion generator with a given controller mode.
@@ -304,8 +565,9 @@ class Robot {
    * @param[in] controller_mode Controller to use to execute the motion.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -319,7 +581,7 @@ class Robot {
       std::function<JointPositions(const RobotState&, franka::Duration)> motion_generator_callback,
       ControllerMode controller_mode = ControllerMode::kJointImpedance,
       bool limit_rate = true,
-      double cutoff_frequency = kDefaultCutoffFrequency);
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for a joint velocity motion generator with a given controller mode.
@@ -332,8 +594,9 @@ class Robot {
    * @param[in] controller_mode Controller to use to execute the motion.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -347,7 +610,7 @@ class Robot {
       std::function<JointVelocities(const RobotState&, franka::Duration)> motion_generator_callback,
       ControllerMode controller_mode = ControllerMode::kJointImpedance,
       bool limit_rate = true,
-      double cutoff_frequency = kDefaultCutoffFrequency);
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for a Cartesian pose motion generator with a given controller mode.
@@ -360,8 +623,9 @@ class Robot {
    * @param[in] controller_mode Controller to use to execute the motion.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -375,7 +639,7 @@ class Robot {
       std::function<CartesianPose(const RobotState&, franka::Duration)> motion_generator_callback,
       ControllerMode controller_mode = ControllerMode::kJointImpedance,
       bool limit_rate = true,
-      double cutoff_frequency = kDefaultCutoffFrequency);
+      const FilterConfiguration& filter_configuration = {});
 
   /**
    * Starts a control loop for a Cartesian velocity motion generator with a given controller mode.
@@ -388,8 +652,9 @@ class Robot {
    * @param[in] controller_mode Controller to use to execute the motion.
    * @param[in] limit_rate True if rate limiting should be activated. True by default.
    * This could distort your motion!
-   * @param[in] cutoff_frequency Cutoff frequency for a first order low-pass filter applied on
-   * the user commanded signal. Set to franka::kMaxCutoffFrequency to disable.
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
    *
    * @throw ControlException if an error related to motion generation occurred.
    * @throw InvalidOperationException if a conflicting operation is already running.
@@ -403,7 +668,109 @@ class Robot {
                    motion_generator_callback,
                ControllerMode controller_mode = ControllerMode::kJointImpedance,
                bool limit_rate = true,
-               double cutoff_frequency = kDefaultCutoffFrequency);
+               const FilterConfiguration& filter_configuration = {});
+
+  /**
+   * Starts a control loop for sending joint-level torque commands from an arbitrary callable.
+   *
+   * In contrast to the std::function overloads, the callable is never copied to the heap, and the
+   * body of the callable is compiled together with the calling code. A callable passed as lvalue
+   * is copied onto the stack, so that every control loop starts from the state the caller passed,
+   * as with the std::function overloads. A temporary callable is referenced instead.
+   *
+   * @param[in] control_callback Callable with the signature
+   * `franka::Torques(const franka::RobotState&, franka::Duration)`.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * This could distort your motion!
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
+   *
+   * @throw ControlException, InvalidOperationException, NetworkException, RealtimeException,
+   * std::invalid_argument, see the std::function overload.
+   */
+  template <typename ControlCallback,
+            typename = std::enable_if_t<detail::IsTorqueCallback<ControlCallback>::value>>
+  void control(ControlCallback&& control_callback,
+               bool limit_rate = true,
+               const FilterConfiguration& filter_configuration = {}) {
+    detail::CallbackStorage<ControlCallback> callback(
+        std::forward<ControlCallback>(control_callback));
+    control(std::function<Torques(const RobotState&, franka::Duration)>(std::ref(callback)),
+            limit_rate, filter_configuration);
+  }
+
+  /**
+   * Starts a control loop for sending joint-level torque commands and motion generator commands
+   * from arbitrary callables.
+   *
+   * The callables are stored like by the single callable overload: lvalues are copied onto the
+   * stack, temporaries are referenced.
+   *
+   * @param[in] control_callback Callable with the signature
+   * `franka::Torques(const franka::RobotState&, franka::Duration)`.
+   * @param[in] motion_generator_callback Callable returning franka::JointPositions,
+   * franka::JointVelocities, franka::CartesianPose or franka::CartesianVelocities.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * This could distort your motion!
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
+   *
+   * @throw ControlException, InvalidOperationException, NetworkException, RealtimeException,
+   * std::invalid_argument, see the std::function overloads.
+   */
+  template <typename ControlCallback,
+            typename MotionGeneratorCallback,
+            typename = std::enable_if_t<
+                detail::IsTorqueCallback<ControlCallback>::value &&
+                detail::IsMotionGeneratorCallback<MotionGeneratorCallback>::value>>
+  void control(ControlCallback&& control_callback,
+               MotionGeneratorCallback&& motion_generator_callback,
+               bool limit_rate = true,
+               const FilterConfiguration& filter_configuration = {}) {
+    using Output = typename detail::CallbackOutput<MotionGeneratorCallback>::type;
+    detail::CallbackStorage<ControlCallback> callback(
+        std::forward<ControlCallback>(control_callback));
+    detail::CallbackStorage<MotionGeneratorCallback> motion_generator(
+        std::forward<MotionGeneratorCallback>(motion_generator_callback));
+    control(std::function<Torques(const RobotState&, franka::Duration)>(std::ref(callback)),
+            std::function<Output(const RobotState&, franka::Duration)>(std::ref(motion_generator)),
+            limit_rate, filter_configuration);
+  }
+
+  /**
+   * Starts a control loop for a motion generator given as arbitrary callable, with a given
+   * controller mode.
+   *
+   * The callable is stored like by the torque control overload: an lvalue is copied onto the
+   * stack, a temporary is referenced.
+   *
+   * @param[in] motion_generator_callback Callable returning franka::JointPositions,
+   * franka::JointVelocities, franka::CartesianPose or franka::CartesianVelocities.
+   * @param[in] controller_mode Controller to use to execute the motion.
+   * @param[in] limit_rate True if rate limiting should be activated. True by default.
+   * This could distort your motion!
+   * @param[in] filter_configuration Cutoff frequencies of the first order low-pass filters applied
+   * on the user commanded signal, either per command channel or as a single frequency. Set to
+   * franka::kMaxCutoffFrequency to disable. See franka::FilterConfiguration.
+   *
+   * @throw ControlException, InvalidOperationException, NetworkException, RealtimeException,
+   * std::invalid_argument, see the std::function overloads.
+   */
+  template <typename MotionGeneratorCallback,
+            typename = std::enable_if_t<
+                detail::IsMotionGeneratorCallback<MotionGeneratorCallback>::value>>
+  void control(MotionGeneratorCallback&& motion_generator_callback,
+               ControllerMode controller_mode = ControllerMode::kJointImpedance,
+               bool limit_rate = true,
+               const FilterConfiguration& filter_configuration = {}) {
+    using Output = typename detail::CallbackOutput<MotionGeneratorCallback>::type;
+    detail::CallbackStorage<MotionGeneratorCallback> motion_generator(
+        std::forward<MotionGeneratorCallback>(motion_generator_callback));
+    control(std::function<Output(const RobotState&, franka::Duration)>(std::ref(motion_generator)),
+            controller_mode, limit_rate, filter_configuration);
+  }
 
   /**
    * @}
@@ -688,6 +1055,21 @@ class Robot {
    */
   void stop();
 
+  /**
+   * Sends all configuration commands of a batch at once, then waits for their responses.
+   *
+   * This takes about as long as a single configuration setter, instead of one network round trip
+   * per command.
+   *
+   * @param[in] batch Commands to send.
+   *
+   * @return Result of every command, in the order in which the commands were added to the batch.
+   * Commands rejected by the Control are reported in their results instead of being thrown.
+   *
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   */
+  std::vector<CommandResult> execute(const CommandBatch& batch);
+
   /**
    * @}
    */
@@ -702,6 +1084,47 @@ class Robot {
    */
   Model loadModel();
 
+  /**
+   * Loads the model library, using the given directory as a persistent cache.
+   *
+   * The library is only downloaded from the robot if the cache does not yet contain a library for
+   * the connected server version, architecture and operating system. Downloaded libraries are
+   * stored under the hash of their contents, so the directory can be shared by several processes
+   * and robots. If the library cannot be written to the directory, it is loaded from a temporary
+   * file as in loadModel().
+   *
+   * @note Clear the cache directory after a robot system update that does not change
+   * serverVersion().
+   *
+   * @param[in] cache_directory Directory to store model libraries in. Created if it does not
+   * exist.
+   *
+   * @return Model instance.
+   *
+   * @throw ModelException if the model library cannot be loaded.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   */
+  Model loadModel(const std::string& cache_directory);
+
+  /**
+   * Replaces the connection to the robot with a new one, e.g. after a network drop.
+   *
+   * All settings of this instance, like the log, statistics, estimators, recorders and publishers,
+   * are kept, and so are models loaded before, which do not depend on the connection. This makes
+   * recovering from a lost connection much faster than constructing a new Robot and loading the
+   * model again. The previous connection is closed once the new one has been established. A
+   * franka::EventLoop the previous connection was attached to has to attach this robot again.
+   *
+   * @note Load the model again if serverVersion() changed, e.g. after a robot system update.
+   *
+   * @param[in] franka_address IP/hostname of the robot.
+   *
+   * @throw NetworkException if the connection is unsuccessful.
+   * @throw IncompatibleVersionException if this version of `libfranka` is not supported.
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void reconnect(const std::string& franka_address);
+
   /**
    * Returns the software version reported by the connected server.
    *
@@ -709,6 +1132,400 @@ class Robot {
    */
   ServerVersion serverVersion() const noexcept;
 
+  /**
+   * Copies the most recent entries of the log into the given storage, oldest first, without
+   * removing them from the log.
+   *
+   * Unlike most other members, this can be called while a control loop is running in another
+   * thread, e.g. to inspect the recent history periodically from a monitoring thread. It neither
+   * blocks the control loop nor allocates memory, and does not affect the log provided by a
+   * ControlException. The log is cleared whenever a motion starts. Fields that are not logged keep
+   * their default value.
+   *
+   * @param[out] records Storage for at least count records.
+   * @param[in] count Maximum number of records to copy.
+   *
+   * @return Number of copied records, at most count and at most the log size given at
+   * construction.
+   */
+  size_t logSnapshot(Record* records, size_t count) const noexcept;
+
+  /**
+   * Enables or disables recording of control loop timings.
+   *
+   * Recording is disabled by default. While enabled, the duration of each stage of every control
+   * cycle is recorded into fixed-size histograms, which does not allocate memory.
+   *
+   * @param[in] enabled True to record timings.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see controlStatistics()
+   */
+  void setControlStatisticsEnabled(bool enabled);
+
+  /**
+   * Returns the timing statistics recorded since recording was enabled or last reset.
+   *
+   * @return Timing statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see setControlStatisticsEnabled()
+   */
+  ControlStatistics controlStatistics();
+
+  /**
+   * Clears all recorded timing statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void resetControlStatistics();
+
+  /**
+   * Enables or disables recording of rate limiting statistics.
+   *
+   * Recording is disabled by default. While enabled, control loops with `limit_rate` set to true
+   * count for every rate limiting stage and element how often the command was changed, and by how
+   * much at most. Recording does not allocate memory.
+   *
+   * @param[in] enabled True to record rate limiting statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see limitingStatistics()
+   */
+  void setLimitingStatisticsEnabled(bool enabled);
+
+  /**
+   * Returns the rate limiting statistics recorded since recording was enabled or last reset.
+   *
+   * @return Rate limiting statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see setLimitingStatisticsEnabled()
+   */
+  LimitingStatistics limitingStatistics();
+
+  /**
+   * Clears all recorded rate limiting statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void resetLimitingStatistics();
+
+  /**
+   * Enables or disables recording of communication statistics.
+   *
+   * Recording is disabled by default. While enabled, control and read loops count lost robot
+   * states, track the command success rate reported by the robot and record the round-trip delay
+   * from sending a command until the next state has been received. Recording does not allocate
+   * memory.
+   *
+   * @param[in] enabled True to record communication statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see communicationStatistics()
+   * @see setCommunicationStatisticsCallback()
+   */
+  void setCommunicationStatisticsEnabled(bool enabled);
+
+  /**
+   * Returns the communication statistics recorded since recording was enabled or last reset.
+   *
+   * @return Communication statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see setCommunicationStatisticsEnabled()
+   */
+  CommunicationStatistics communicationStatistics();
+
+  /**
+   * Clears all recorded communication statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void resetCommunicationStatistics();
+
+  /**
+   * Returns the estimated relation between the robot clock and the monotonic host clock.
+   *
+   * The estimate is updated with every received robot state and is used to set
+   * RobotState::host_time. The minimum transport latency is assumed to be zero, so host times are
+   * those at which the fastest states would have been received.
+   *
+   * @return Clock estimate.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see franka::ClockEstimator
+   */
+  ClockEstimate clockEstimate();
+
+  /**
+   * Sets a callback for degraded communication while communication statistics are recorded.
+   *
+   * The callback is called from the thread running the control or read loop for every received
+   * robot state that follows lost states, and whenever the command success rate of a running
+   * motion drops below the given threshold. It should return quickly, e.g. by only notifying
+   * another thread. Exceptions thrown by the callback abort the loop.
+   *
+   * @param[in] callback Callback, or an empty function to remove it.
+   * @param[in] success_rate_threshold Command success rate between 0 and 1 below which the callback
+   * is called.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   * @throw std::invalid_argument if the threshold is not between 0 and 1.
+   *
+   * @see setCommunicationStatisticsEnabled()
+   */
+  void setCommunicationStatisticsCallback(CommunicationStatisticsCallback callback,
+                                          double success_rate_threshold = 0.95);
+
+  /**
+   * Enables or disables joint state estimation in control loops.
+   *
+   * Estimation is disabled by default. While enabled, a franka::JointStateEstimator runs on every
+   * received robot state before the callbacks are called. It replaces RobotState::dq with the
+   * estimated joint velocity and sets RobotState::ddq_hat to the estimated joint acceleration.
+   * Callbacks that take a franka::RobotStateView receive the unmodified state.
+   *
+   * @param[in] enabled True to estimate joint states.
+   * @param[in] parameters Noise parameters of the estimator.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   * @throw std::invalid_argument if enabled is true and the parameters are invalid.
+   */
+  void setJointStateEstimation(bool enabled, const JointStateEstimatorParameters& parameters = {});
+
+  /**
+   * Enables or disables joint state prediction in control loops.
+   *
+   * Prediction is disabled by default. While enabled, every received robot state is extrapolated
+   * with franka::predictJointState() before the callbacks are called, after joint state
+   * estimation if that is enabled as well. The horizon covers the states lost since the previous
+   * received state plus the transport delay predicted by a franka::TransportDelayEstimator.
+   * RobotState::q, RobotState::dq and RobotState::ddq_hat then hold the predicted values.
+   * Callbacks that take a franka::RobotStateView receive the unmodified state.
+   *
+   * @param[in] model Model to predict with, or nullptr to disable prediction. The model must stay
+   * valid until prediction is disabled or the Robot is destroyed.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setStatePrediction(const Model* model);
+
+  /**
+   * Sets or removes the momentum observer for control loops.
+   *
+   * No observer is set by default. While set, the franka::MomentumObserver is reset at the start of
+   * every control loop and updated on every received robot state before the callbacks are called,
+   * after joint state estimation and before joint state prediction. It evaluates the dynamics once
+   * per cycle and replaces RobotState::tau_ext_hat_filtered, RobotState::O_F_ext_hat_K and
+   * RobotState::K_F_ext_hat_K with its filtered estimates. The unfiltered estimates and the
+   * evaluated dynamics can be read from the observer inside the callback. Callbacks that take a
+   * franka::RobotStateView receive the unmodified state.
+   *
+   * @param[in] observer Observer to update, or nullptr to remove it.
+   * @param[in] model Model to evaluate the dynamics with, or nullptr to remove the observer.
+   * Observer and model must stay valid until the observer is removed or the Robot is destroyed.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setMomentumObserver(MomentumObserver* observer, const Model* model);
+
+  /**
+   * Enables or disables the passivity controller for torque commands.
+   *
+   * The controller is disabled by default. While enabled, a franka::PassivityController observes
+   * the energy exchanged through the commanded torques of torque control loops and injects
+   * damping whenever a command would make the observed energy negative. It runs after the torque
+   * filters and before torque rate limiting. Enabling the controller clears its statistics.
+   *
+   * @param[in] enabled True to make torque commands passive.
+   * @param[in] parameters Parameters of the passivity controller.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   * @throw std::invalid_argument if enabled is true and the parameters are invalid.
+   *
+   * @see passivityStatistics()
+   */
+  void setPassivityControl(bool enabled, const PassivityControllerParameters& parameters = {});
+
+  /**
+   * Returns the energy telemetry of the passivity controller.
+   *
+   * @return Passivity statistics since the controller was enabled or its statistics were reset.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see setPassivityControl()
+   */
+  PassivityStatistics passivityStatistics();
+
+  /**
+   * Clears the energy telemetry of the passivity controller.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void resetPassivityStatistics();
+
+  /**
+   * Enables or disables online trajectory generation for rate limited joint motions.
+   *
+   * Online trajectory generation is disabled by default. While enabled, joint position and joint
+   * velocity motion generators that run with rate limiting treat their commands as targets: a
+   * franka::OnlineTrajectoryGenerator moves towards them with a time-optimal motion within the
+   * joint velocity, acceleration and jerk limits, instead of limitRate() clipping each command.
+   * Large steps in the commands, e.g. from a teleoperation device, then no longer overshoot.
+   * Commands of other motion generators and of control loops without rate limiting are not
+   * affected.
+   *
+   * @param[in] enabled True to generate rate limited joint motions online.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setOnlineTrajectoryGeneration(bool enabled);
+
+  /**
+   * Enables or disables the deadline of control loop callbacks.
+   *
+   * Callbacks run without a deadline by default, and a callback that overruns its cycle makes the
+   * robot miss commands until a communication_constraints_violation reflex stops the motion. With
+   * a deadline, the control callback of torque control loops, or the motion generator callback of
+   * other control loops, runs on a worker thread with the same priority as the control loop. If it
+   * has not returned within CallbackDeadline::budget, the control loop sends the fallback command
+   * given by CallbackDeadline::fallback for this cycle, and discards the late output. Robot states
+   * arriving while the callback is still busy are skipped, and the time step passed with the next
+   * robot state includes them. Fallback commands are filtered and rate limited like the
+   * callback's.
+   *
+   * In control loops with both a control and a motion generator callback, only the control callback
+   * runs with the deadline; the motion generator callback runs on the control thread before it.
+   * Callbacks that take a franka::RobotStateView always run without a deadline, as the view is
+   * only valid on the control thread, and their cycles are not counted in deadlineStatistics().
+   *
+   * Enabling the deadline clears its statistics.
+   *
+   * @param[in] enabled True to run callbacks with a deadline.
+   * @param[in] deadline Budget and fallback of the callbacks.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   * @throw std::invalid_argument if enabled is true and the deadline is invalid.
+   *
+   * @see deadlineStatistics()
+   */
+  void setCallbackDeadline(bool enabled, const CallbackDeadline& deadline = {});
+
+  /**
+   * Returns how often callbacks missed their deadline.
+   *
+   * @return Deadline statistics since the deadline was enabled or its statistics were reset.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   *
+   * @see setCallbackDeadline()
+   */
+  DeadlineStatistics deadlineStatistics();
+
+  /**
+   * Clears the deadline statistics.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void resetDeadlineStatistics();
+
+  /**
+   * Sets how thoroughly control loops validate the commands they send.
+   *
+   * ValidationPolicy::kFull is the default: every element of every command is checked, and so are
+   * the inputs of the command filters. Control and motion generator callbacks that are already
+   * known to produce valid commands can use ValidationPolicy::kChecksum to skip these per-element
+   * checks in every cycle. The final command is then still rejected if any of its values is
+   * infinite or NaN.
+   *
+   * @param[in] policy Validation policy for subsequent control loops.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setValidationPolicy(ValidationPolicy policy);
+
+  /**
+   * Sets a recorder that receives the robot state and sent command of every control cycle.
+   *
+   * Samples are handed to the recorder without blocking the control loop; see
+   * franka::StreamingRecorder.
+   *
+   * @param[in] recorder Recorder to use, or nullptr to stop recording.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setStreamingRecorder(std::shared_ptr<StreamingRecorder> recorder);
+
+  /**
+   * Sets a recorder that receives every raw state and command datagram exchanged with the robot.
+   *
+   * Datagrams are handed to the recorder without blocking the control loop; see
+   * franka::DatagramRecorder. The recording can be played back with franka::DatagramReplay.
+   *
+   * @param[in] recorder Recorder to use, or nullptr to stop recording.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setDatagramRecorder(std::shared_ptr<DatagramRecorder> recorder);
+
+  /**
+   * Sets a publisher that receives the robot state and sent command of every control cycle.
+   *
+   * Other threads can read the latest sample from the publisher without blocking the control
+   * loop; see franka::StatePublisher.
+   *
+   * @param[in] publisher Publisher to use, or nullptr to stop publishing.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setStatePublisher(std::shared_ptr<StatePublisher> publisher);
+
+  /**
+   * Sets a shared memory segment to which the control thread publishes its metrics in every cycle.
+   *
+   * Metrics are updated independently of setControlStatisticsEnabled(),
+   * setLimitingStatisticsEnabled() and setCommunicationStatisticsEnabled(), and are read by
+   * external monitors; see franka::SharedMemoryMetrics.
+   *
+   * @param[in] metrics Metrics to update, or nullptr to stop updating.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setSharedMemoryMetrics(std::shared_ptr<SharedMemoryMetrics> metrics);
+
+  /**
+   * Sets a flight recorder that keeps the robot state and sent command of every control cycle in a
+   * memory-mapped file, so that they can be recovered after a crash of the process.
+   *
+   * See franka::FlightRecorder and franka::readFlightRecording().
+   *
+   * @param[in] recorder Recorder to use, or nullptr to stop recording.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setFlightRecorder(std::shared_ptr<FlightRecorder> recorder);
+
+  /**
+   * Sets a broadcaster that shares the robot state and sent command of every control cycle with
+   * other processes on the same machine, e.g. a GUI or a data recorder.
+   *
+   * See franka::StateBroadcaster and franka::StateSubscriber.
+   *
+   * @param[in] broadcaster Broadcaster to use, or nullptr to stop broadcasting.
+   *
+   * @throw InvalidOperationException if a control or read operation is running.
+   */
+  void setStateBroadcaster(std::shared_ptr<StateBroadcaster> broadcaster);
+
   /// @cond DO_NOT_DOCUMENT
   Robot(const Robot&) = delete;
   Robot& operator=(const Robot&) = delete;
@@ -717,6 +1534,19 @@ class Robot {
   class Impl;
 
  private:
+  friend class EventLoop;
+  friend class MultiRobotControl;
+  friend RobotStartup startRobot(const std::string& franka_address,
+                                 const CommandBatch& configuration,
+                                 const StartupOptions& options);
+  friend RobotStartup startRobot(const std::string& franka_address,
+                                 Model&& model,
+                                 const CommandBatch& configuration,
+                                 const StartupOptions& options);
+
+  // Creates a Robot instance from a connected implementation, for startRobot().
+  explicit Robot(std::unique_ptr<Impl> impl) noexcept;
+
   std::unique_ptr<Impl> impl_;
   std::mutex control_mutex_;
 };
@@ -0,0 +1,108 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <franka/command_types.h>
+#include <franka/control_types.h>
+#include <franka/model.h>
+#include <franka/robot.h>
+
+/**
+ * @file robot_startup.h
+ * Contains functions to connect to a robot, load its model and configure it concurrently.
+ */
+
+namespace franka {
+
+/**
+ * Options for startRobot().
+ */
+struct StartupOptions {
+  /**
+   * See Robot::Robot.
+   */
+  RealtimeConfig realtime_config{RealtimeConfig::kEnforce};
+  /**
+   * See Robot::Robot.
+   */
+  RealtimeOptions realtime_options{};
+  /**
+   * See Robot::Robot.
+   */
+  size_t log_size{50};
+  /**
+   * Directory to cache the model library in, see Robot::loadModel(const std::string&). If empty,
+   * the model library is downloaded as in Robot::loadModel().
+   */
+  std::string model_cache_directory{};
+};
+
+/**
+ * Connected and configured robot, returned by startRobot().
+ */
+struct RobotStartup {
+  /**
+   * Connected robot.
+   */
+  Robot robot;
+  /**
+   * Model of the robot.
+   */
+  Model model;
+  /**
+   * Results of the configuration commands, see Robot::execute().
+   */
+  std::vector<CommandResult> configuration;
+};
+
+/**
+ * Connects to a robot, loads its model and executes a batch of configuration commands.
+ *
+ * Equivalent to constructing a Robot, calling Robot::loadModel() and Robot::execute(), but the
+ * model library is looked up in the cache or downloaded on a separate thread while the
+ * configuration commands are sent and answered, so that their round trips overlap with the
+ * download instead of following it.
+ *
+ * @param[in] franka_address IP/hostname of the robot.
+ * @param[in] configuration Configuration commands, e.g. collision behavior and impedances.
+ * @param[in] options Connection and model options.
+ *
+ * @return Robot, model and configuration results.
+ *
+ * @throw NetworkException if the connection is lost or unsuccessful.
+ * @throw IncompatibleVersionException if this version of `libfranka` is not supported.
+ * @throw ModelException if the model library cannot be loaded.
+ */
+RobotStartup startRobot(const std::string& franka_address,
+                        const CommandBatch& configuration = CommandBatch(),
+                        const StartupOptions& options = StartupOptions());
+
+/**
+ * Connects to a robot and executes a batch of configuration commands, reusing a model that has
+ * been loaded before, e.g. when restarting a cell after a network drop.
+ *
+ * As the model does not depend on the connection, this skips loading the model library
+ * altogether. StartupOptions::model_cache_directory is ignored.
+ *
+ * @note Load the model again if the server version changed, e.g. after a robot system update.
+ *
+ * @param[in] franka_address IP/hostname of the robot.
+ * @param[in] model Model to reuse. Moved into the result.
+ * @param[in] configuration Configuration commands, e.g. collision behavior and impedances.
+ * @param[in] options Connection options.
+ *
+ * @return Robot, model and configuration results.
+ *
+ * @throw NetworkException if the connection is lost or unsuccessful.
+ * @throw IncompatibleVersionException if this version of `libfranka` is not supported.
+ */
+RobotStartup startRobot(const std::string& franka_address,
+                        Model&& model,
+                        const CommandBatch& configuration = CommandBatch(),
+                        const StartupOptions& options = StartupOptions());
+
+}  // namespace franka
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <ostream>
 
 #include <franka/duration.h>
@@ -256,6 +257,16 @@ struct RobotState {
    */
   std::array<double, 7> ddq_d{};
 
+  /**
+   * \f$\hat{\ddot{q}}\f$
+   * Estimated joint acceleration. Unit: \f$[\frac{rad}{s^2}]\f$
+   *
+   * Only set in control loops while joint state estimation is enabled, zero otherwise.
+   *
+   * @see Robot::setJointStateEstimation
+   */
+  std::array<double, 7> ddq_hat{};
+
   /**
    * Indicates which contact level is activated in which joint. After contact disappears, value
    * turns to zero.
@@ -399,6 +410,16 @@ struct RobotState {
    * instead.
    */
   Duration time{};
+
+  /**
+   * Time at which the state was taken, as estimated on the monotonic host clock.
+   *
+   * Can be used to align robot states with data from other devices that is timestamped with
+   * std::chrono::steady_clock. Default-constructed if the state was not received from a robot.
+   *
+   * @see Robot::clockEstimate
+   */
+  std::chrono::steady_clock::time_point host_time{};
 };
 
 /**
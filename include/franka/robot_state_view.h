@@ -0,0 +1,158 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/duration.h>
+#include <franka/errors.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file robot_state_view.h
+ * Contains the franka::RobotStateView type.
+ */
+
+/// @cond DO_NOT_DOCUMENT
+namespace research_interface {
+namespace robot {
+struct RobotState;
+}  // namespace robot
+}  // namespace research_interface
+/// @endcond
+
+namespace franka {
+
+/**
+ * Read-only view on the robot state packet as it was received from the robot.
+ *
+ * In contrast to franka::RobotState, no fields are copied when a view is created. Measured and
+ * desired values are read directly from the received packet, while derived values (e.g. the
+ * combined load) are only computed when they are requested.
+ *
+ * A view is only valid until the next robot state is received, i.e. for the duration of one
+ * control callback invocation. Use toRobotState() to keep a copy.
+ *
+ * @see RobotState for a description of the individual fields.
+ */
+class RobotStateView {
+ public:
+  /**
+   * Creates a view on the given robot state packet.
+   *
+   * This constructor is for internal use only.
+   *
+   * @param[in] robot_state For internal use.
+   */
+  explicit RobotStateView(const research_interface::robot::RobotState& robot_state) noexcept;
+
+  /**
+   * Converts the viewed packet into a franka::RobotState.
+   *
+   * @return Full copy of the robot state.
+   */
+  RobotState toRobotState() const noexcept;
+
+  /// @see RobotState::O_T_EE
+  const std::array<double, 16>& O_T_EE() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::O_T_EE_d
+  const std::array<double, 16>& O_T_EE_d() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::F_T_EE
+  const std::array<double, 16>& F_T_EE() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::F_T_NE
+  const std::array<double, 16>& F_T_NE() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::NE_T_EE
+  const std::array<double, 16>& NE_T_EE() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::EE_T_K
+  const std::array<double, 16>& EE_T_K() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::m_ee
+  double m_ee() const noexcept;
+  /// @see RobotState::I_ee
+  const std::array<double, 9>& I_ee() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::F_x_Cee
+  const std::array<double, 3>& F_x_Cee() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::m_load
+  double m_load() const noexcept;
+  /// @see RobotState::I_load
+  const std::array<double, 9>& I_load() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::F_x_Cload
+  const std::array<double, 3>& F_x_Cload() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::m_total
+  double m_total() const noexcept;
+  /// @see RobotState::I_total. Computed on every call.
+  std::array<double, 9> I_total() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::F_x_Ctotal. Computed on every call.
+  std::array<double, 3> F_x_Ctotal() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::elbow
+  const std::array<double, 2>& elbow() const noexcept;
+  /// @see RobotState::elbow_d
+  const std::array<double, 2>& elbow_d() const noexcept;
+  /// @see RobotState::elbow_c
+  const std::array<double, 2>& elbow_c() const noexcept;
+  /// @see RobotState::delbow_c
+  const std::array<double, 2>& delbow_c() const noexcept;
+  /// @see RobotState::ddelbow_c
+  const std::array<double, 2>& ddelbow_c() const noexcept;
+  /// @see RobotState::tau_J
+  const std::array<double, 7>& tau_J() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::tau_J_d
+  const std::array<double, 7>& tau_J_d() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::dtau_J
+  const std::array<double, 7>& dtau_J() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::q
+  const std::array<double, 7>& q() const noexcept;
+  /// @see RobotState::q_d
+  const std::array<double, 7>& q_d() const noexcept;
+  /// @see RobotState::dq
+  const std::array<double, 7>& dq() const noexcept;
+  /// @see RobotState::dq_d
+  const std::array<double, 7>& dq_d() const noexcept;
+  /// @see RobotState::ddq_d
+  const std::array<double, 7>& ddq_d() const noexcept;
+  /// @see RobotState::joint_contact
+  const std::array<double, 7>& joint_contact() const noexcept;
+  /// @see RobotState::cartesian_contact
+  const std::array<double, 6>& cartesian_contact() const noexcept;
+  /// @see RobotState::joint_collision
+  const std::array<double, 7>& joint_collision() const noexcept;
+  /// @see RobotState::cartesian_collision
+  const std::array<double, 6>& cartesian_collision() const noexcept;
+  /// @see RobotState::tau_ext_hat_filtered
+  const std::array<double, 7>& tau_ext_hat_filtered() const noexcept;
+  /// @see RobotState::O_F_ext_hat_K
+  const std::array<double, 6>& O_F_ext_hat_K() const  // NOLINT(readability-identifier-naming)
+      noexcept;
+  /// @see RobotState::K_F_ext_hat_K
+  const std::array<double, 6>& K_F_ext_hat_K() const  // NOLINT(readability-identifier-naming)
+      noexcept;
+  /// @see RobotState::O_dP_EE_d
+  const std::array<double, 6>& O_dP_EE_d() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::O_ddP_O
+  const std::array<double, 3>& O_ddP_O() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::O_T_EE_c
+  const std::array<double, 16>& O_T_EE_c() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::O_dP_EE_c
+  const std::array<double, 6>& O_dP_EE_c() const noexcept;  // NOLINT(readability-identifier-naming)
+  /// @see RobotState::O_ddP_EE_c
+  const std::array<double, 6>& O_ddP_EE_c() const  // NOLINT(readability-identifier-naming)
+      noexcept;
+  /// @see RobotState::theta
+  const std::array<double, 7>& theta() const noexcept;
+  /// @see RobotState::dtheta
+  const std::array<double, 7>& dtheta() const noexcept;
+  /// @see RobotState::current_errors. Constructed on every call.
+  Errors current_errors() const noexcept;
+  /// @see RobotState::last_motion_errors. Constructed on every call.
+  Errors last_motion_errors() const noexcept;
+  /// @see RobotState::control_command_success_rate
+  double control_command_success_rate() const noexcept;
+  /// @see RobotState::robot_mode
+  RobotMode robot_mode() const noexcept;
+  /// @see RobotState::time
+  Duration time() const noexcept;
+
+ private:
+  const research_interface::robot::RobotState* robot_state_;
+};
+
+}  // namespace franka
@@ -0,0 +1,200 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <franka/model.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file self_collision.h
+ * Contains the franka::SelfCollisionChecker type to keep the links of the robot apart from each
+ * other and from obstacles.
+ */
+
+namespace franka {
+
+/**
+ * Capsule, i.e. a line segment swept by a sphere, that approximates part of a link or an obstacle.
+ */
+struct Capsule {
+  /**
+   * Frame the capsule is attached to. Ignored for obstacles, which are given in base frame.
+   */
+  Frame frame{Frame::kFlange};
+  /**
+   * Start of the segment in that frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> start{};
+  /**
+   * End of the segment in that frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> end{};
+  /**
+   * Radius of the capsule. Unit: \f$[m]\f$
+   */
+  double radius{};
+};
+
+/**
+ * Parameters of the franka::SelfCollisionChecker.
+ */
+struct SelfCollisionParameters {
+  /**
+   * Distance between two capsules below which they repel each other. Unit: \f$[m]\f$
+   */
+  double activation_distance{0.05};
+  /**
+   * Repulsive force per distance below the activation distance. Unit: \f$[\frac{N}{m}]\f$
+   */
+  double stiffness{1000.0};
+  /**
+   * Repulsive force per approach velocity below the activation distance.
+   * Unit: \f$[\frac{Ns}{m}]\f$
+   */
+  double damping{20.0};
+};
+
+/**
+ * Result of a franka::SelfCollisionChecker query.
+ */
+struct SelfCollisionResult {
+  /**
+   * Joint torques of all repulsive forces. Unit: \f$[Nm]\f$
+   */
+  std::array<double, 7> tau_J{};  // NOLINT(readability-identifier-naming)
+  /**
+   * Smallest distance between two checked capsules, negative if they overlap, or infinity if no
+   * pair is checked. Unit: \f$[m]\f$
+   */
+  double min_distance{};
+  /**
+   * Index of the link capsule with the smallest distance.
+   */
+  size_t nearest_link{};
+  /**
+   * Index of the capsule nearest to #nearest_link, into the obstacles if #nearest_is_obstacle is
+   * set and into the link capsules otherwise.
+   */
+  size_t nearest_other{};
+  /**
+   * True if the smallest distance is to an obstacle.
+   */
+  bool nearest_is_obstacle{};
+  /**
+   * Number of capsule pairs closer than the activation distance.
+   */
+  size_t active_pairs{};
+};
+
+/**
+ * Computes distances between capsules on the links of the robot, and to capsule obstacles in the
+ * workspace, and maps repulsive forces to joint torques.
+ *
+ * Capsules on the same link or on neighboring links are not checked against each other, as they
+ * touch at the joint anyway. Frame::kFlange, Frame::kEndEffector and Frame::kStiffness belong to
+ * the same link as Frame::kJoint7. Every other pair of link capsules and every pair of a link
+ * capsule and an obstacle is checked in each query.
+ *
+ * The distances of all pairs are computed at once by a segment-to-segment kernel that works on
+ * structure-of-arrays buffers and is vectorized by Eigen. Repulsive forces act along the line
+ * between the closest points of a pair and are mapped through the Jacobians of both capsule
+ * frames, i.e. the torques follow the gradient of the distance. A query takes a few microseconds
+ * for the default capsules and does not allocate memory, so it can run in every Robot::control
+ * torque callback.
+ */
+class SelfCollisionChecker {
+ public:
+  /**
+   * Coarse capsule approximation of the links and the hand of a Panda robot.
+   *
+   * @return Link capsules.
+   */
+  static std::vector<Capsule> defaultCapsules();
+
+  /**
+   * Creates a checker.
+   *
+   * @param[in] capsules Capsules on the links of the robot.
+   * @param[in] obstacles Capsules in base frame.
+   * @param[in] parameters Repulsion parameters.
+   *
+   * @throw std::invalid_argument if a frame is invalid, or a value is negative, infinite or NaN.
+   */
+  explicit SelfCollisionChecker(std::vector<Capsule> capsules = defaultCapsules(),
+                                std::vector<Capsule> obstacles = {},
+                                const SelfCollisionParameters& parameters = {});
+
+  /**
+   * Computes distances and repulsive torques for the given robot state, using Model::poseAll for
+   * the frame poses and Jacobians.
+   *
+   * @param[in] model Robot model.
+   * @param[in] robot_state Robot state.
+   *
+   * @return Distances and repulsive torques.
+   */
+  SelfCollisionResult check(const Model& model, const RobotState& robot_state) noexcept;
+
+  /**
+   * Computes distances and repulsive torques for given frame poses and Jacobians.
+   *
+   * @param[in] poses Poses of all frames in base frame, e.g. from Model::poseAll.
+   * @param[in] zero_jacobians Zero Jacobians of all frames, e.g. from Model::poseAll.
+   * @param[in] dq Joint velocities, used for damping. Unit: \f$[\frac{rad}{s}]\f$
+   *
+   * @return Distances and repulsive torques.
+   */
+  SelfCollisionResult check(const FramePoses& poses,
+                            const FrameJacobians& zero_jacobians,
+                            const std::array<double, 7>& dq) noexcept;
+
+  /**
+   * Replaces the obstacles. Allocates.
+   *
+   * @param[in] obstacles Capsules in base frame.
+   *
+   * @throw std::invalid_argument if a value is negative, infinite or NaN.
+   */
+  void setObstacles(std::vector<Capsule> obstacles);
+
+  /**
+   * @return Capsules on the links of the robot.
+   */
+  const std::vector<Capsule>& capsules() const noexcept;
+
+  /**
+   * @return Capsules in base frame.
+   */
+  const std::vector<Capsule>& obstacles() const noexcept;
+
+  /**
+   * @return Number of capsule pairs checked per query.
+   */
+  size_t pairCount() const noexcept;
+
+ private:
+  void buildPairs();
+
+  std::vector<Capsule> capsules_;
+  std::vector<Capsule> obstacles_;
+  SelfCollisionParameters parameters_;
+
+  // Indices of the capsules of each pair. The second index refers to the obstacles if it is at
+  // least capsules_.size().
+  std::vector<std::array<size_t, 2>> pairs_;
+
+  // Structure-of-arrays buffer of the distance kernel, one row per pair and column-major, so that
+  // every column is contiguous. The columns are defined in the source file.
+  std::vector<double> pair_buffer_;
+  // Capsule endpoints in base frame, start followed by end.
+  std::vector<std::array<double, 6>> segments_;
+
+  FramePoses poses_;
+  FrameJacobians zero_jacobians_;
+};
+
+}  // namespace franka
@@ -0,0 +1,214 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file shared_memory_metrics.h
+ * Contains the franka::SharedMemoryMetrics type and the layout of its shared memory segment.
+ */
+
+namespace franka {
+
+/**
+ * Number of buckets of a franka::MetricsHistogram, including the overflow bucket.
+ */
+constexpr size_t kMetricsBuckets = 17;
+
+/**
+ * Number of control loop stages in franka::MetricsSegment::stages.
+ */
+constexpr size_t kMetricsStages = 9;
+
+/**
+ * Number of rate limiting stages in franka::MetricsSegment::limiting.
+ */
+constexpr size_t kMetricsLimitingStages = 4;
+
+/**
+ * Inclusive upper bounds of the histogram buckets in \f$[\mu s]\f$. The last bucket counts all
+ * longer durations.
+ */
+constexpr std::array<uint64_t, kMetricsBuckets - 1> kMetricsBucketBounds{
+    {25, 50, 100, 200, 300, 400, 500, 600, 700, 800, 900, 1000, 1250, 1500, 2000, 5000}};
+
+/**
+ * Latency histogram of one control loop stage.
+ *
+ * Bucket counts are not cumulative.
+ */
+struct MetricsHistogram {
+  /**
+   * Number of durations per bucket, see franka::kMetricsBucketBounds.
+   */
+  std::array<std::atomic<uint64_t>, kMetricsBuckets> buckets;
+  /**
+   * Number of recorded durations.
+   */
+  std::atomic<uint64_t> count;
+  /**
+   * Sum of all recorded durations in \f$[ns]\f$.
+   */
+  std::atomic<uint64_t> sum_ns;
+};
+
+/**
+ * Saturation counters of one rate limiting stage.
+ */
+struct MetricsLimitingStage {
+  /**
+   * Number of commands processed by this stage.
+   */
+  std::atomic<uint64_t> cycles;
+  /**
+   * Number of commands that were changed by this stage, i.e. in which the limits were reached.
+   */
+  std::atomic<uint64_t> limited_cycles;
+};
+
+/**
+ * Layout of the shared memory segment written by franka::SharedMemoryMetrics.
+ *
+ * All fields are 64-bit unsigned integers in the byte order of the writing machine, so that the
+ * segment can also be read by processes that are not written in C++. All counters only increase
+ * while the segment exists; readers derive rates from consecutive reads.
+ *
+ * The control thread is the only writer. It updates each field with a single atomic store and
+ * increments #sequence after each received robot state, so a reader sees each field either before
+ * or after an update, but fields can belong to different control cycles.
+ */
+struct MetricsSegment {
+  /**
+   * Value of #magic once the segment has been initialized ("frankamt").
+   */
+  static constexpr uint64_t kMagic = 0x6672616e6b616d74ULL;
+  /**
+   * Version of the segment layout described here.
+   */
+  static constexpr uint64_t kVersion = 1;
+
+  /**
+   * franka::MetricsSegment::kMagic once the segment has been initialized, 0 before.
+   */
+  std::atomic<uint64_t> magic;
+  /**
+   * Layout version, see franka::MetricsSegment::kVersion.
+   */
+  uint64_t version;
+  /**
+   * Size of the segment in bytes.
+   */
+  uint64_t size;
+  /**
+   * Number of robot states processed by the control thread. Stops increasing if the control
+   * thread does not communicate with the robot.
+   */
+  std::atomic<uint64_t> sequence;
+  /**
+   * Message ID of the latest robot state.
+   */
+  std::atomic<uint64_t> message_id;
+  /**
+   * franka::RobotMode of the latest robot state, as integer.
+   */
+  std::atomic<uint64_t> robot_mode;
+  /**
+   * Number of robot states that were sent by the robot but never received, detected from gaps in
+   * the message IDs.
+   */
+  std::atomic<uint64_t> lost_states;
+  /**
+   * Control command success rate of the latest robot state, in parts per million.
+   */
+  std::atomic<uint64_t> success_rate_ppm;
+  /**
+   * Number of cycles in which the command was sent more than 1 ms after the state was received.
+   */
+  std::atomic<uint64_t> deadline_misses;
+  /**
+   * Copy of franka::kMetricsBucketBounds for readers that cannot include this header.
+   */
+  std::array<uint64_t, kMetricsBuckets - 1> bucket_bounds_us;
+  /**
+   * Latency histograms of the control loop stages, in the order of the members of
+   * franka::ControlStatistics: receive_state, motion_callback, control_callback,
+   * motion_command_processing, control_command_processing, send_command, cycle, receive_wakeup and
+   * network_cycle.
+   */
+  std::array<MetricsHistogram, kMetricsStages> stages;
+  /**
+   * Saturation of the rate limiting stages, in the order of the members of
+   * franka::LimitingStatistics: torque_rate, joint_motion, cartesian_motion and elbow.
+   */
+  std::array<MetricsLimitingStage, kMetricsLimitingStages> limiting;
+};
+
+/// @cond DO_NOT_DOCUMENT
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "MetricsSegment: Atomic counters must have the layout of plain integers.");
+static_assert(sizeof(MetricsSegment) ==
+                  (9 + kMetricsBuckets - 1 + kMetricsStages * (kMetricsBuckets + 2) +
+                   kMetricsLimitingStages * 2) *
+                      sizeof(uint64_t),
+              "MetricsSegment: Unexpected padding.");
+/// @endcond
+
+/**
+ * Publishes control loop metrics in a POSIX shared memory segment, so that external monitors,
+ * e.g. a Prometheus exporter, can observe a running controller without any interaction with the
+ * control thread.
+ *
+ * Once passed to Robot::setSharedMemoryMetrics(), the control thread updates the segment in every
+ * cycle with relaxed atomic stores, independently of whether the statistics of the robot are
+ * enabled. Monitors map the segment read-only, e.g. with
+ * `shm_open(name, O_RDONLY, 0)` and `mmap(..., PROT_READ, MAP_SHARED, ...)`, check
+ * franka::MetricsSegment::magic and franka::MetricsSegment::version, and poll the counters at
+ * their own rate. See franka::MetricsSegment for the layout.
+ *
+ * Only supported on Linux.
+ */
+class SharedMemoryMetrics {
+ public:
+  /**
+   * Creates and initializes the shared memory segment.
+   *
+   * @param[in] name Name of the segment, e.g. `/franka_metrics`. Must not exist yet.
+   *
+   * @throw NetworkException if the segment cannot be created, or if shared memory is not supported
+   * on this platform.
+   */
+  explicit SharedMemoryMetrics(const std::string& name);
+
+  /**
+   * Removes the shared memory segment. Monitors that have mapped it keep their mapping.
+   */
+  ~SharedMemoryMetrics() noexcept;
+
+  /**
+   * @return Name of the segment.
+   */
+  const std::string& name() const noexcept;
+
+  /**
+   * @return Segment written by this instance.
+   */
+  const MetricsSegment& segment() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  SharedMemoryMetrics(const SharedMemoryMetrics&) = delete;
+  SharedMemoryMetrics& operator=(const SharedMemoryMetrics&) = delete;
+
+  MetricsSegment& segment() noexcept;
+  /// @endcond
+
+ private:
+  std::string name_;
+  MetricsSegment* segment_{nullptr};
+};
+
+}  // namespace franka
@@ -0,0 +1,150 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <franka/robot_state.h>
+
+/**
+ * @file simulated_robot.h
+ * Contains the franka::SimulatedRobot type.
+ */
+
+namespace franka {
+
+class Network;
+
+/**
+ * Parameters of a franka::SimulatedRobot.
+ */
+struct SimulationParameters {
+  /**
+   * Initial joint positions. Unit: \f$[rad]\f$.
+   */
+  std::array<double, 7> q_start{{0, -0.785398163, 0, -2.35619449, 0, 1.57079632679, 0.785398163}};
+
+  /**
+   * Viscous joint friction that the robot does not compensate in torque control. Unit:
+   * \f$[\frac{Nms}{rad}]\f$.
+   */
+  std::array<double, 7> joint_damping{};
+
+  /**
+   * Nominal end effector frame in flange frame.
+   */
+  std::array<double, 16> F_T_NE{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+
+  /**
+   * Configured mass of the end effector. Unit: \f$[kg]\f$.
+   */
+  double m_ee{0};
+
+  /**
+   * Configured center of mass of the end effector in flange frame. Unit: \f$[m]\f$.
+   */
+  std::array<double, 3> F_x_Cee{};  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Configured rotational inertia matrix of the end effector load with respect to center of mass,
+   * column-major. Unit: \f$[kg \times m^2]\f$.
+   */
+  std::array<double, 9> I_ee{};  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Gravity vector in base frame. Unit: \f$[\frac{m}{s^2}]\f$.
+   */
+  std::array<double, 3> gravity_earth{{0., 0., -9.81}};
+};
+
+/**
+ * Simulates a robot in-process, so that controllers can be tested without hardware and faster
+ * than real time.
+ *
+ * The simulation serves the same protocol as a robot: a franka::Robot constructed with
+ * Robot(SimulatedRobot&, RealtimeConfig, size_t) sends commands over a TCP connection on the
+ * loopback interface, while states and control commands are exchanged in memory. Every robot
+ * state is produced on demand, by stepping the simulation by one millisecond whenever the robot
+ * sends a control command or waits for a state. The control loop therefore runs as fast as the
+ * CPU allows, and a run is deterministic for a given controller.
+ *
+ * The arm is simulated with the dynamics of the given model library:
+ * - With an external controller, the commanded torques, the external torques and the joint
+ *   damping accelerate the arm through mass matrix and Coriolis forces. Like on the robot, gravity
+ *   is compensated.
+ * - With the internal joint or Cartesian impedance controller, the arm follows the commanded
+ *   motion exactly. Cartesian motions are converted into joint motions with the inverse of the
+ *   zero Jacobian.
+ *
+ * Collision detection, reflexes, joint limits and the gripper are not simulated. Setter commands,
+ * e.g. Robot::setCollisionBehavior(), are accepted; end effector frames and loads are applied.
+ *
+ * The simulation must outlive all franka::Robot instances connected to it. Only one robot can be
+ * connected at a time.
+ */
+class SimulatedRobot {
+ public:
+  /**
+   * Starts a simulation.
+   *
+   * @param[in] model_library_path Path of the model library used for the dynamics of the arm, e.g.
+   * a library downloaded by Robot::loadModel(const std::string&). It is also served to connected
+   * robots, so that Robot::loadModel() works as usual.
+   * @param[in] parameters Parameters of the simulation.
+   *
+   * @throw ModelException if the model library cannot be loaded.
+   * @throw NetworkException if the command server cannot be started.
+   */
+  explicit SimulatedRobot(const std::string& model_library_path,
+                          const SimulationParameters& parameters = SimulationParameters());
+
+  /**
+   * Stops the simulation.
+   */
+  ~SimulatedRobot() noexcept;
+
+  /**
+   * Returns the current state of the simulated arm.
+   *
+   * Can be called from any thread.
+   *
+   * @return Current robot state.
+   */
+  RobotState readOnce() const;
+
+  /**
+   * Sets the external torques acting on the joints, e.g. to simulate a human pushing the arm in
+   * a haptic scenario. They are applied until changed, and reported in
+   * RobotState::tau_ext_hat_filtered.
+   *
+   * Can be called from any thread, including from a control callback.
+   *
+   * @param[in] tau_ext External torques. Unit: \f$[Nm]\f$.
+   */
+  void setExternalTorque(const std::array<double, 7>& tau_ext) noexcept;
+
+  /**
+   * @return Number of simulated milliseconds.
+   */
+  uint64_t steps() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  SimulatedRobot(const SimulatedRobot&) = delete;
+  SimulatedRobot& operator=(const SimulatedRobot&) = delete;
+
+  class Impl;
+  /// @endcond
+
+ private:
+  friend class Robot;
+
+  // Connects to the simulation, as a robot connects to the command port of a real robot.
+  std::unique_ptr<Network> connect();
+
+  std::shared_ptr<Impl> impl_;
+};
+
+}  // namespace franka
@@ -0,0 +1,169 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <franka/control_types.h>
+
+/**
+ * @file spline_trajectory.h
+ * Contains the franka::SplineTrajectory and franka::CartesianSplineTrajectory types.
+ */
+
+namespace franka {
+
+/**
+ * Degree of the polynomials of a franka::SplineTrajectory.
+ */
+enum class SplineType {
+  /**
+   * Cubic polynomials with continuous velocity and acceleration.
+   */
+  kCubic,
+  /**
+   * Quintic polynomials with continuous velocity, acceleration, jerk and snap.
+   */
+  kQuintic
+};
+
+/**
+ * Interpolating spline through timed 7-dimensional points, e.g. joint positions.
+ *
+ * The spline passes through all points and starts and ends at rest: velocity and, for quintic
+ * splines, acceleration are zero at the first and last point. Fitting solves a sparse linear
+ * system over all points and is meant to be done before the control loop.
+ *
+ * The polynomial coefficients of all segments are stored in one contiguous table, with the
+ * coefficients of all dimensions of a segment next to each other. Evaluation looks up the segment
+ * with a binary search and evaluates the polynomials of all dimensions at once with vector
+ * instructions; it does not allocate. Copies share the table.
+ *
+ * Use jointPositions() to follow the spline in a joint position motion generator:
+ * @code{.cpp}
+ * franka::SplineTrajectory spline(times, waypoints);
+ * double time = 0.0;
+ * robot.control([&](const franka::RobotState&, franka::Duration period) {
+ *   time += period.toSec();
+ *   return spline.jointPositions(time);
+ * });
+ * @endcode
+ */
+class SplineTrajectory {
+ public:
+  /**
+   * Fits a spline through the given points.
+   *
+   * @param[in] times Time of each point since the start of the trajectory, starting at zero and
+   * strictly increasing. Unit: \f$[s]\f$.
+   * @param[in] points Points to pass through.
+   * @param[in] type Degree of the polynomials.
+   *
+   * @throw std::invalid_argument if there are fewer than two points, the numbers of times and
+   * points differ, the times are invalid or a value is infinite or NaN.
+   */
+  SplineTrajectory(const std::vector<double>& times,
+                   const std::vector<std::array<double, 7>>& points,
+                   SplineType type = SplineType::kQuintic);
+
+  /**
+   * @return Degree of the polynomials.
+   */
+  SplineType type() const noexcept;
+
+  /**
+   * @return Number of polynomial segments, i.e. one less than the number of points.
+   */
+  size_t segmentCount() const noexcept;
+
+  /**
+   * @return Time of the last point. Unit: \f$[s]\f$.
+   */
+  double duration() const noexcept;
+
+  /**
+   * Evaluates the spline. Times outside of the trajectory are clamped to it.
+   *
+   * @param[in] t Time since the start of the trajectory. Unit: \f$[s]\f$.
+   * @param[out] position Position at time t.
+   * @param[out] velocity Velocity at time t, if not null.
+   * @param[out] acceleration Acceleration at time t, if not null.
+   */
+  void evaluate(double t,
+                std::array<double, 7>* position,
+                std::array<double, 7>* velocity = nullptr,
+                std::array<double, 7>* acceleration = nullptr) const noexcept;
+
+  /**
+   * Evaluates the spline as joint positions.
+   *
+   * @param[in] t Time since the start of the trajectory. Unit: \f$[s]\f$.
+   *
+   * @return Joint positions at time t, with motion_finished set at the end of the trajectory.
+   */
+  JointPositions jointPositions(double t) const noexcept;
+
+ private:
+  struct Storage;
+
+  std::shared_ptr<const Storage> storage_;
+};
+
+/**
+ * Interpolating spline through timed end effector poses.
+ *
+ * Positions and orientations, as unit quaternions, are interpolated by a franka::SplineTrajectory;
+ * the interpolated quaternions are normalized. Orientations of consecutive poses should differ by
+ * less than half a turn, otherwise the shorter rotation between them is taken.
+ */
+class CartesianSplineTrajectory {
+ public:
+  /**
+   * Fits a spline through the given poses.
+   *
+   * @param[in] times Time of each pose since the start of the trajectory, starting at zero and
+   * strictly increasing. Unit: \f$[s]\f$.
+   * @param[in] poses Homogeneous transformation matrices to pass through, column major.
+   * @param[in] type Degree of the polynomials.
+   *
+   * @throw std::invalid_argument if there are fewer than two poses, the numbers of times and poses
+   * differ, the times are invalid or a pose is not a valid homogeneous transformation.
+   */
+  CartesianSplineTrajectory(const std::vector<double>& times,
+                            const std::vector<std::array<double, 16>>& poses,
+                            SplineType type = SplineType::kQuintic);
+
+  /**
+   * @return Time of the last pose. Unit: \f$[s]\f$.
+   */
+  double duration() const noexcept;
+
+  /**
+   * Evaluates the spline. Times outside of the trajectory are clamped to it.
+   *
+   * @param[in] t Time since the start of the trajectory. Unit: \f$[s]\f$.
+   * @param[out] pose Homogeneous transformation matrix at time t, column major.
+   * @param[out] twist Linear and angular velocity at time t in base frame, if not null.
+   * Unit: \f$[\frac{m}{s},\frac{rad}{s}]\f$.
+   */
+  void evaluate(double t,
+                std::array<double, 16>* pose,
+                std::array<double, 6>* twist = nullptr) const noexcept;
+
+  /**
+   * Evaluates the spline as Cartesian pose.
+   *
+   * @param[in] t Time since the start of the trajectory. Unit: \f$[s]\f$.
+   *
+   * @return Pose at time t, with motion_finished set at the end of the trajectory.
+   */
+  CartesianPose cartesianPose(double t) const noexcept;
+
+ private:
+  SplineTrajectory spline_;
+};
+
+}  // namespace franka
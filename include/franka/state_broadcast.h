@@ -0,0 +1,180 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <franka/state_publisher.h>
+
+/**
+ * @file state_broadcast.h
+ * Contains the franka::StateBroadcaster and franka::StateSubscriber types.
+ */
+
+/// @cond DO_NOT_DOCUMENT
+namespace research_interface {
+namespace robot {
+struct RobotState;
+struct RobotCommand;
+}  // namespace robot
+}  // namespace research_interface
+/// @endcond
+
+namespace franka {
+
+class StateBroadcaster;
+struct BroadcastSegment;
+
+/// @cond DO_NOT_DOCUMENT
+void broadcastRawState(StateBroadcaster& broadcaster,
+                       const research_interface::robot::RobotState& robot_state,
+                       const research_interface::robot::RobotCommand& robot_command,
+                       std::chrono::steady_clock::time_point host_time) noexcept;
+/// @endcond
+
+/**
+ * Broadcasts the robot state and command of every control cycle to other processes on the same
+ * machine through a POSIX shared memory segment.
+ *
+ * Only one process can be connected to the robot. Once the broadcaster is passed to
+ * Robot::setStateBroadcaster(), this process writes every received robot state into a ring in
+ * shared memory, and any number of other processes, e.g. a GUI, a data recorder and a planner,
+ * read it with franka::StateSubscriber. Writing takes one copy of the received state and command,
+ * does not allocate and never waits for subscribers. Subscribers never write to the segment, so
+ * they cannot delay the control loop either.
+ *
+ * Only supported on Linux.
+ */
+class StateBroadcaster {
+ public:
+  /**
+   * Number of states kept in the ring. A subscriber that falls further behind loses states.
+   */
+  static constexpr uint64_t kCapacity = 64;
+
+  /**
+   * Creates and initializes the shared memory segment.
+   *
+   * @param[in] name Name of the segment, e.g. `/franka_state`. Must not exist yet.
+   *
+   * @throw NetworkException if the segment cannot be created, or if shared memory is not supported
+   * on this platform.
+   */
+  explicit StateBroadcaster(const std::string& name);
+
+  /**
+   * Removes the shared memory segment. Subscribers that have mapped it keep their mapping, but do
+   * not receive any new states.
+   */
+  ~StateBroadcaster() noexcept;
+
+  /**
+   * @return Name of the segment.
+   */
+  const std::string& name() const noexcept;
+
+  /**
+   * @return Number of broadcast states.
+   */
+  uint64_t publishedStates() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  StateBroadcaster(const StateBroadcaster&) = delete;
+  StateBroadcaster& operator=(const StateBroadcaster&) = delete;
+  /// @endcond
+
+ private:
+  friend void broadcastRawState(StateBroadcaster& broadcaster,
+                                const research_interface::robot::RobotState& robot_state,
+                                const research_interface::robot::RobotCommand& robot_command,
+                                std::chrono::steady_clock::time_point host_time) noexcept;
+
+  std::string name_;
+  BroadcastSegment* segment_{nullptr};
+};
+
+/**
+ * Reads the states broadcast by a franka::StateBroadcaster in another process.
+ *
+ * Each state is copied out of the shared memory ring under a per-slot sequence counter, so a read
+ * either returns a consistent sample or retries, but never blocks the broadcasting process. The
+ * samples are converted to franka::PublishedState in the subscribing process; RobotState::host_time
+ * is the time estimated by the broadcasting process. Samples of subscribers do not contain
+ * controller torques.
+ *
+ * A subscriber is meant to be used by a single thread.
+ */
+class StateSubscriber {
+ public:
+  /**
+   * Maps the shared memory segment of a broadcaster read-only.
+   *
+   * @param[in] name Name of the segment, see StateBroadcaster::StateBroadcaster().
+   *
+   * @throw NetworkException if the segment does not exist, was written by an incompatible version
+   * of libfranka, or if shared memory is not supported on this platform.
+   */
+  explicit StateSubscriber(const std::string& name);
+
+  /**
+   * Unmaps the shared memory segment.
+   */
+  ~StateSubscriber() noexcept;
+
+  /**
+   * Copies the latest state, e.g. for a GUI that only needs to show the current state.
+   *
+   * Skips all states that were not read yet, so that readNext() continues after the returned state.
+   *
+   * @param[out] state Latest state. Unchanged if nothing was broadcast yet.
+   * @param[in] timeout Maximum time to wait while the broadcaster writes the latest state.
+   *
+   * @return False if nothing was broadcast yet, or if the latest state was not completely written
+   * within the timeout, e.g. because the broadcasting process died while writing it.
+   */
+  bool readLatest(PublishedState* state,
+                  std::chrono::microseconds timeout = std::chrono::milliseconds(100));
+
+  /**
+   * Copies the state following the last read one, e.g. for a recorder that needs every state.
+   *
+   * The first call returns the first state broadcast after the subscriber was created. If the
+   * subscriber fell more than StateBroadcaster::kCapacity states behind, the oldest states that
+   * are still available are returned next and the skipped ones are counted by lostStates().
+   * Waits by polling the segment every few microseconds.
+   *
+   * @param[out] state Next state. Unchanged if none was broadcast within the timeout.
+   * @param[in] timeout Maximum time to wait for the next state.
+   *
+   * @return False if no state was broadcast, or completely written, within the timeout.
+   */
+  bool readNext(PublishedState* state,
+                std::chrono::microseconds timeout = std::chrono::milliseconds(100));
+
+  /**
+   * Cheap check for new states, e.g. to skip readLatest() if nothing changed.
+   *
+   * @return Number of states broadcast so far.
+   */
+  uint64_t publishedStates() const noexcept;
+
+  /**
+   * @return Number of states that readNext() skipped because the subscriber fell behind.
+   */
+  uint64_t lostStates() const noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  StateSubscriber(const StateSubscriber&) = delete;
+  StateSubscriber& operator=(const StateSubscriber&) = delete;
+  /// @endcond
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
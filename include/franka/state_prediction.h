@@ -0,0 +1,131 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file state_prediction.h
+ * Contains the franka::TransportDelayEstimator type and functions to predict joint states over
+ * lost packets and transport delays.
+ */
+
+namespace franka {
+
+class Model;
+
+/**
+ * Estimates the transport delay of control commands from lost robot states and
+ * RobotState::control_command_success_rate.
+ *
+ * Every received state is compared with the previous one. Each millisecond of robot time in
+ * between that was not received counts as a lost state. Assuming that packets are lost
+ * independently with probability \f$p\f$, the next command is applied after an expected additional
+ * delay of \f$\Delta t \frac{p}{1 - p}\f$, where \f$\Delta t\f$ is one control cycle.
+ */
+class TransportDelayEstimator {
+ public:
+  /**
+   * Maximum packet loss probability used for the delay prediction.
+   */
+  static constexpr double kMaxLossProbability = 0.9;  // NOLINT(readability-identifier-naming)
+
+  /**
+   * Creates a new estimator.
+   *
+   * @param[in] smoothing Weight of the newest sample in the moving average of the lost state ratio.
+   *
+   * @throw std::invalid_argument if smoothing is not in \f$(0, 1]\f$.
+   */
+  explicit TransportDelayEstimator(double smoothing = 0.01);
+
+  /**
+   * Updates the estimate with a received robot state.
+   *
+   * @param[in] robot_state Received robot state.
+   * @param[in] time_step Robot time since the last received state. A time step of zero
+   * starts a new measurement, as on the first cycle of a control loop.
+   */
+  void update(const RobotState& robot_state, Duration time_step) noexcept;
+
+  /**
+   * Clears all measurements.
+   */
+  void reset() noexcept;
+
+  /**
+   * @return Number of states that were not received since construction or the last reset().
+   */
+  uint64_t lostStates() const noexcept;
+
+  /**
+   * @return Number of states that were not received between the last two received states.
+   */
+  uint64_t lastGap() const noexcept;
+
+  /**
+   * @return Moving average of the ratio of lost states. Range: \f$[0, 1)\f$.
+   */
+  double lostStateRatio() const noexcept;
+
+  /**
+   * @return Packet loss probability used for the delay prediction, which is the larger of the
+   * lost state ratio and \f$1 - \f$ RobotState::control_command_success_rate.
+   * Range: \f$[0, \f$ kMaxLossProbability \f$]\f$.
+   */
+  double lossProbability() const noexcept;
+
+  /**
+   * @return Expected additional delay until the next command is applied. Unit: \f$[s]\f$
+   */
+  double predictedDelay() const noexcept;
+
+ private:
+  double smoothing_;
+  uint64_t lost_states_{0};
+  uint64_t last_gap_{0};
+  double lost_state_ratio_{0};
+  double command_loss_{0};
+};
+
+/**
+ * Extrapolates RobotState::q and RobotState::dq over a time horizon.
+ *
+ * The joint acceleration \f$\ddot{q} = M^{-1}(q) (\tau_{J,d} - c(q, \dot{q}))\f$ follows from the
+ * last commanded torque RobotState::tau_J_d, assuming that gravity is compensated by the robot
+ * and that no external forces act. Positions and velocities are integrated with a constant
+ * acceleration over the horizon, which also sets RobotState::ddq_hat.
+ *
+ * @param[in] mass Mass matrix at the given state, column-major.
+ * @param[in] coriolis Coriolis force vector at the given state. Unit: \f$[Nm]\f$
+ * @param[in] horizon Time to predict. Unit: \f$[s]\f$
+ * @param[in,out] robot_state State to extrapolate.
+ *
+ * @return True if the state was extrapolated, false if the mass matrix is not positive definite
+ * or the horizon is not positive. The state is left unchanged in that case.
+ */
+bool predictJointState(const std::array<double, 49>& mass,
+                       const std::array<double, 7>& coriolis,
+                       double horizon,
+                       RobotState* robot_state) noexcept;
+
+/**
+ * Extrapolates RobotState::q and RobotState::dq over a time horizon, using the dynamics of the
+ * given model.
+ *
+ * @param[in] model Robot model.
+ * @param[in] horizon Time to predict. Unit: \f$[s]\f$
+ * @param[in,out] robot_state State to extrapolate.
+ *
+ * @return True if the state was extrapolated.
+ *
+ * @see predictJointState(const std::array<double, 49>&, const std::array<double, 7>&, double,
+ * RobotState*)
+ */
+bool predictJointState(const Model& model, double horizon, RobotState* robot_state) noexcept;
+
+}  // namespace franka
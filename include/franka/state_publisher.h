@@ -0,0 +1,153 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include <franka/log.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file state_publisher.h
+ * Contains the franka::StatePublisher type.
+ */
+
+/// @cond DO_NOT_DOCUMENT
+namespace research_interface {
+namespace robot {
+struct RobotState;
+struct RobotCommand;
+}  // namespace robot
+}  // namespace research_interface
+/// @endcond
+
+namespace franka {
+
+class StatePublisher;
+
+/// @cond DO_NOT_DOCUMENT
+void publishRawState(StatePublisher& publisher,
+                     const research_interface::robot::RobotState& robot_state,
+                     const research_interface::robot::RobotCommand& robot_command) noexcept;
+/// @endcond
+
+/**
+ * Torques of a controller component, e.g. franka::JointImpedanceController, published together
+ * with the robot state it was computed from.
+ */
+struct ControllerTorques {
+  /**
+   * Torques computed by the controller, before rate limiting. Without gravity. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> tau_d_commanded{};
+  /**
+   * Torques returned by the controller after rate limiting. Without gravity. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> tau_d_limited{};
+  /**
+   * Gravity torques at the robot state. Unit: \f$[Nm]\f$.
+   */
+  std::array<double, 7> gravity{};
+};
+
+/**
+ * Sample published by a franka::StatePublisher.
+ */
+struct PublishedState {
+  /**
+   * Robot state of timestamp n+1.
+   */
+  RobotState robot_state;
+  /**
+   * Robot command of timestamp n, after rate limiting (if activated).
+   */
+  RobotCommand command;
+  /**
+   * Torques of the controller component that published the sample. Zero for samples published by
+   * the robot.
+   */
+  ControllerTorques controller_torques;
+  /**
+   * Number of samples published before this one.
+   */
+  uint64_t sequence{};
+};
+
+/**
+ * Shares the latest robot state and command of the control loop with other threads.
+ *
+ * One thread, usually the control loop thread, publishes samples; any number of other threads, e.g.
+ * GUI, logging or planning threads, read the latest one. Publishing is wait-free and never
+ * allocates: the publisher writes into one of a few slots that no reader currently uses and then
+ * marks it as latest. Readers only mark the latest slot while copying it, so they never block the
+ * publisher and always get a consistent sample, never a mix of two cycles. If all slots are in use
+ * by readers, a sample is dropped instead of waiting.
+ *
+ * Samples can either be published manually with publish(), or automatically for every control
+ * cycle by passing the publisher to Robot::setStatePublisher(). This replaces sharing a
+ * `RobotState` through a mutex, which either drops samples on `try_lock` or risks priority
+ * inversion.
+ */
+class StatePublisher {
+ public:
+  /**
+   * Creates a publisher without samples.
+   */
+  StatePublisher();
+
+  /**
+   * Destroys the publisher. No thread may read or publish anymore.
+   */
+  ~StatePublisher() noexcept;
+
+  StatePublisher(const StatePublisher&) = delete;
+  StatePublisher& operator=(const StatePublisher&) = delete;
+
+  /**
+   * Publishes a sample. Does not block and does not allocate. Only one thread may publish.
+   *
+   * @param[in] robot_state Robot state to publish.
+   * @param[in] command Command that was sent together with the robot state.
+   * @param[in] controller_torques Torques of the controller component that computed the command.
+   *
+   * @return False if the sample was dropped because readers use all slots.
+   */
+  bool publish(const RobotState& robot_state,
+               const RobotCommand& command = {},
+               const ControllerTorques& controller_torques = {}) noexcept;
+
+  /**
+   * Copies the latest sample. Never blocks the publishing thread. Can be called by any number of
+   * threads concurrently.
+   *
+   * @param[out] state Latest sample. Unchanged if nothing was published yet.
+   *
+   * @return False if nothing was published yet.
+   */
+  bool read(PublishedState* state) const noexcept;
+
+  /**
+   * Cheap check for new samples, e.g. to skip read() if nothing changed.
+   *
+   * @return Number of published samples.
+   */
+  uint64_t publishedStates() const noexcept;
+
+  /**
+   * @return Number of samples dropped because readers used all slots.
+   */
+  uint64_t droppedStates() const noexcept;
+
+ private:
+  class Impl;
+
+  friend void publishRawState(StatePublisher& publisher,
+                              const research_interface::robot::RobotState& robot_state,
+                              const research_interface::robot::RobotCommand& robot_command) noexcept;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
@@ -0,0 +1,112 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <franka/state_publisher.h>
+
+/**
+ * @file state_stream.h
+ * Contains the franka::StateStream type.
+ */
+
+namespace franka {
+
+class Robot;
+
+/**
+ * Receives robot states in a background thread while no motion is running, and hands them to
+ * several subscribers at individual rates.
+ *
+ * Robot::read() blocks the calling thread for the whole read loop, so every consumer of robot
+ * states outside of a control loop, e.g. a GUI, a logger and a planner, would need its own
+ * blocking thread and would still conflict with the others. A stream instead runs a single read
+ * loop and publishes every n-th state into a franka::StatePublisher per subscriber. Consumers poll
+ * their publisher whenever it suits them; reading never blocks the stream, and publishing never
+ * blocks or allocates.
+ *
+ * @code{.cpp}
+ * auto log = std::make_shared<franka::StatePublisher>();
+ * auto gui = std::make_shared<franka::StatePublisher>();
+ * franka::StateStream stream(robot);
+ * stream.subscribe(log);      // 1 kHz
+ * stream.subscribe(gui, 16);  // about 60 Hz
+ * stream.start();
+ * // ...
+ * stream.stop();
+ * robot.control(...);
+ * @endcode
+ *
+ * While the stream is running, it occupies the robot like Robot::read(), so Robot::control(),
+ * Robot::read() and Robot::readOnce() throw an InvalidOperationException until stop() is called.
+ */
+class StateStream {
+ public:
+  /**
+   * Creates a stopped stream without subscribers.
+   *
+   * @param[in] robot Robot to read from. Must outlive the stream.
+   */
+  explicit StateStream(Robot& robot);
+
+  /**
+   * Stops the stream. Errors of the read loop are discarded.
+   */
+  ~StateStream() noexcept;
+
+  /// @cond DO_NOT_DOCUMENT
+  StateStream(const StateStream&) = delete;
+  StateStream& operator=(const StateStream&) = delete;
+  /// @endcond
+
+  /**
+   * Adds a subscriber.
+   *
+   * The first state received after start() is published, and afterwards the first state that is
+   * at least decimation robot cycles newer than the last published one. Lost states therefore do
+   * not change the rate of a subscriber.
+   *
+   * @param[in] publisher Publisher to publish the states into.
+   * @param[in] decimation Publish every decimation-th state, e.g. 1 for 1 kHz or 100 for 10 Hz.
+   *
+   * @throw InvalidOperationException if the stream is running.
+   * @throw std::invalid_argument if publisher is nullptr or decimation is zero.
+   */
+  void subscribe(std::shared_ptr<StatePublisher> publisher, uint32_t decimation = 1);
+
+  /**
+   * Starts the read loop in a background thread and waits until the first state has been
+   * received.
+   *
+   * @throw InvalidOperationException if the stream is already running, or if a control or read
+   * operation of the robot is running.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   */
+  void start();
+
+  /**
+   * Stops the read loop after the next received state and waits for the thread to finish.
+   *
+   * @throw NetworkException if the read loop stopped early because the connection was lost.
+   */
+  void stop();
+
+  /**
+   * @return True if the read loop is running.
+   */
+  bool running() const noexcept;
+
+  /**
+   * @return Number of states received since the stream was created.
+   */
+  uint64_t receivedStates() const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
@@ -0,0 +1,141 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <franka/log.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file streaming_recorder.h
+ * Contains the franka::StreamingRecorder type.
+ */
+
+/// @cond DO_NOT_DOCUMENT
+namespace research_interface {
+namespace robot {
+struct RobotState;
+struct RobotCommand;
+}  // namespace robot
+}  // namespace research_interface
+/// @endcond
+
+namespace franka {
+
+class StreamingRecorder;
+
+/// @cond DO_NOT_DOCUMENT
+bool recordRawSample(StreamingRecorder& recorder,
+                     const research_interface::robot::RobotState& robot_state,
+                     const research_interface::robot::RobotCommand& robot_command) noexcept;
+/// @endcond
+
+/**
+ * Records robot states and commands to a binary file from a background thread.
+ *
+ * The control thread hands samples over through a wait-free single-producer queue; a separate
+ * thread with normal scheduling priority writes them to disk. If the writer cannot keep up and the
+ * queue is full, samples are dropped instead of blocking the control thread.
+ *
+ * Samples can either be recorded manually with record(), or automatically for every control cycle
+ * by passing the recorder to Robot::setStreamingRecorder(). Only one thread may record samples.
+ *
+ * The file consists of a header followed by fixed-size records, so it can be memory-mapped
+ * directly. All values are stored in the byte order of the recording machine:
+ *
+ * Offset          | Type                     | Content
+ * --------------- | ------------------------ | -------------------------------------------------
+ * 0               | `char[8]`                | Magic `FRANKREC`
+ * 8               | `uint32_t`               | Format version (kFormatVersion)
+ * 12              | `uint32_t`               | Header size in bytes, i.e. offset of first record
+ * 16              | `uint32_t`               | Size of one record in bytes
+ * 20              | `uint32_t`               | Number of field descriptors
+ * 24              | 64 bytes per descriptor  | Field descriptors
+ *
+ * Each field descriptor contains a zero-terminated name (`char[48]`), the element type (`uint32_t`,
+ * 0 for `uint64_t`, 1 for `double`), the byte offset of the field inside a record (`uint32_t`), the
+ * number of elements (`uint32_t`) and four reserved bytes. The number of records follows from the
+ * file size; an incomplete trailing record should be ignored.
+ */
+class StreamingRecorder {
+ public:
+  /**
+   * Version of the file format written by this class.
+   */
+  static constexpr uint32_t kFormatVersion = 1;
+
+  /**
+   * Opens the given file and starts the writer thread.
+   *
+   * @param[in] path File to write. Existing files are overwritten.
+   * @param[in] queue_capacity Number of samples that can be queued before samples are dropped.
+   *
+   * @throw Exception if the file cannot be opened.
+   */
+  explicit StreamingRecorder(const std::string& path, size_t queue_capacity = 4096);
+
+  /**
+   * Writes all queued samples and closes the file.
+   */
+  ~StreamingRecorder() noexcept;
+
+  StreamingRecorder(const StreamingRecorder&) = delete;
+  StreamingRecorder& operator=(const StreamingRecorder&) = delete;
+
+  /**
+   * Queues a sample for writing. Does not block and does not allocate.
+   *
+   * @param[in] robot_state Robot state to record.
+   * @param[in] command Command that was sent together with the robot state.
+   *
+   * @return False if the sample was dropped because the queue is full.
+   */
+  bool record(const RobotState& robot_state, const RobotCommand& command) noexcept;
+
+  /**
+   * Writes all queued samples, stops the writer thread and closes the file. Samples recorded
+   * afterwards are dropped. Samples recorded concurrently from another thread are either written
+   * or counted as dropped.
+   */
+  void stop() noexcept;
+
+  /**
+   * @return Number of samples written to the file so far.
+   */
+  uint64_t writtenSamples() const noexcept;
+
+  /**
+   * @return Number of samples dropped because the queue was full or the recorder was stopped.
+   */
+  uint64_t droppedSamples() const noexcept;
+
+ private:
+  class Impl;
+
+  friend bool recordRawSample(StreamingRecorder& recorder,
+                              const research_interface::robot::RobotState& robot_state,
+                              const research_interface::robot::RobotCommand& robot_command) noexcept;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Converts a recording of franka::StreamingRecorder, or the output of logToBinary(), to an Arrow
+ * IPC file.
+ *
+ * The Arrow file contains one non-nullable column per element of each recorded field, e.g.
+ * `q[0]` to `q[6]`, typed as `uint64` or `double`. Its record batches are uncompressed and
+ * 64-byte aligned, so that columnar analysis tools such as pyarrow, pandas or polars can
+ * memory-map the columns without parsing.
+ *
+ * @param[in] recording_path Recording to convert. Must not be written to concurrently.
+ * @param[in] arrow_path File to write. Existing files are overwritten.
+ *
+ * @throw Exception if the recording cannot be read, or the Arrow file cannot be written.
+ */
+void recordingToArrow(const std::string& recording_path, const std::string& arrow_path);
+
+}  // namespace franka
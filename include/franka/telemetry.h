@@ -0,0 +1,352 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <franka/robot_state.h>
+
+/**
+ * @file telemetry.h
+ * Contains types for streaming robot states to a remote station in a compact encoding.
+ */
+
+namespace franka {
+
+class StatePublisher;
+
+/**
+ * Selects which fields of the robot state are sent as telemetry.
+ *
+ * RobotState::time is always sent. Values can be combined with `|`.
+ */
+enum class TelemetryFields : uint32_t {
+  kNone = 0,
+  kQ = 1 << 0,                  ///< RobotState::q
+  kQD = 1 << 1,                 ///< RobotState::q_d
+  kDq = 1 << 2,                 ///< RobotState::dq
+  kTauJ = 1 << 3,               ///< RobotState::tau_J
+  kTauExtHatFiltered = 1 << 4,  ///< RobotState::tau_ext_hat_filtered
+  kOTEE = 1 << 5,               ///< RobotState::O_T_EE
+  kOFExtHatK = 1 << 6,          ///< RobotState::O_F_ext_hat_K
+  kRobotMode = 1 << 7,          ///< RobotState::robot_mode
+  /**
+   * Fields for visualizing the robot and its contact forces.
+   */
+  kVisualization = kQ | kOTEE | kOFExtHatK | kRobotMode,
+  /**
+   * All fields.
+   */
+  kAll = kQ | kQD | kDq | kTauJ | kTauExtHatFiltered | kOTEE | kOFExtHatK | kRobotMode,
+};
+
+/**
+ * Combines two sets of telemetry fields.
+ *
+ * @param[in] lhs First set.
+ * @param[in] rhs Second set.
+ *
+ * @return Union of both sets.
+ */
+constexpr TelemetryFields operator|(TelemetryFields lhs, TelemetryFields rhs) noexcept {
+  return static_cast<TelemetryFields>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
+/**
+ * Checks whether all given fields are contained in a set of telemetry fields.
+ *
+ * @param[in] fields Set of telemetry fields.
+ * @param[in] query Fields to look for.
+ *
+ * @return True if all fields of query are contained in fields.
+ */
+constexpr bool hasTelemetryFields(TelemetryFields fields, TelemetryFields query) noexcept {
+  return (static_cast<uint32_t>(fields) & static_cast<uint32_t>(query)) ==
+         static_cast<uint32_t>(query);
+}
+
+/**
+ * Encoding parameters of the telemetry sender. The receiver takes them from the packets.
+ */
+struct TelemetryOptions {
+  /**
+   * Fields to send.
+   */
+  TelemetryFields fields{TelemetryFields::kVisualization};
+  /**
+   * Resolution of joint positions. Unit: \f$[rad]\f$.
+   */
+  double joint_position_resolution{1e-5};
+  /**
+   * Resolution of joint velocities. Unit: \f$[\frac{rad}{s}]\f$.
+   */
+  double joint_velocity_resolution{1e-4};
+  /**
+   * Resolution of joint torques. Unit: \f$[Nm]\f$.
+   */
+  double torque_resolution{1e-3};
+  /**
+   * Resolution of the elements of RobotState::O_T_EE. Unit: \f$[m]\f$ and \f$[1]\f$.
+   */
+  double pose_resolution{1e-5};
+  /**
+   * Resolution of RobotState::O_F_ext_hat_K. Unit: \f$[N]\f$ and \f$[Nm]\f$.
+   */
+  double wrench_resolution{1e-2};
+};
+
+/**
+ * Encodes robot states into compact, versioned telemetry packets.
+ *
+ * The selected fields are quantized with the resolutions of TelemetryOptions. A keyframe packet
+ * contains the quantized values and the encoding parameters. Once the decoder has acknowledged a
+ * packet, later packets only contain the differences to the acknowledged one, as variable-length
+ * integers of mostly one or two bytes per value. As every packet only depends on an acknowledged
+ * one, lost packets do not prevent decoding later ones. If no packet is acknowledged for
+ * kHistorySize packets, e.g. because the decoder was restarted, keyframes are sent again.
+ * Encoding does not allocate.
+ *
+ * Every encoder starts a new session, so that a decoder resynchronizes with a restarted encoder.
+ *
+ * See franka::TelemetryDecoder, and franka::TelemetrySender for sending the states of a control
+ * loop.
+ */
+class TelemetryEncoder {
+ public:
+  /**
+   * Version of the packet format. Packets of other versions are rejected.
+   */
+  static constexpr uint8_t kVersion = 1;
+
+  /**
+   * Upper bound for the size of a packet, including acknowledgements.
+   */
+  static constexpr size_t kMaxPacketSize = 1024;
+
+  /**
+   * Number of sent packets that remain valid references for acknowledgements.
+   */
+  static constexpr uint32_t kHistorySize = 64;
+
+  /**
+   * Creates an encoder that starts a new session with a keyframe.
+   *
+   * @param[in] options Encoding parameters.
+   *
+   * @throw std::invalid_argument if a resolution is not positive and finite.
+   */
+  explicit TelemetryEncoder(const TelemetryOptions& options = TelemetryOptions());
+  ~TelemetryEncoder() noexcept;
+
+  TelemetryEncoder(const TelemetryEncoder&) = delete;
+  TelemetryEncoder& operator=(const TelemetryEncoder&) = delete;
+
+  /**
+   * Encodes a robot state.
+   *
+   * @param[in] robot_state Robot state to encode.
+   * @param[out] packet Buffer of at least kMaxPacketSize bytes.
+   *
+   * @return Size of the packet.
+   */
+  size_t encode(const RobotState& robot_state, uint8_t* packet) noexcept;
+
+  /**
+   * Processes an acknowledgement of TelemetryDecoder::acknowledgement(), so that later packets are
+   * encoded against the acknowledged one. Acknowledgements of packets older than the current
+   * reference or than kHistorySize packets are ignored.
+   *
+   * @param[in] packet Acknowledgement.
+   * @param[in] size Size of the acknowledgement.
+   *
+   * @return True if packet is a valid acknowledgement of this encoder's session.
+   */
+  bool acknowledge(const uint8_t* packet, size_t size) noexcept;
+
+  /**
+   * Encodes the next packet as a keyframe.
+   */
+  void reset() noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Decodes packets of a franka::TelemetryEncoder.
+ *
+ * Keeps the last TelemetryEncoder::kHistorySize decoded packets as references. Decoding does not
+ * allocate.
+ */
+class TelemetryDecoder {
+ public:
+  /**
+   * Creates a decoder that waits for a keyframe.
+   */
+  TelemetryDecoder();
+  ~TelemetryDecoder() noexcept;
+
+  TelemetryDecoder(const TelemetryDecoder&) = delete;
+  TelemetryDecoder& operator=(const TelemetryDecoder&) = delete;
+
+  /**
+   * Decodes a packet.
+   *
+   * Fails for packets that are malformed, of another version, not newer than the last decoded
+   * packet of the session, or encoded against a packet that this decoder did not decode. A keyframe
+   * of another session starts decoding that session.
+   *
+   * @param[in] packet Packet to decode.
+   * @param[in] size Size of the packet.
+   * @param[out] robot_state Receives the fields contained in the packet. Other fields are
+   * unchanged.
+   *
+   * @return True if the packet was decoded.
+   */
+  bool decode(const uint8_t* packet, size_t size, RobotState* robot_state) noexcept;
+
+  /**
+   * Writes an acknowledgement of the last decoded packet, to be passed to
+   * TelemetryEncoder::acknowledge().
+   *
+   * @param[out] packet Buffer of at least TelemetryEncoder::kMaxPacketSize bytes.
+   *
+   * @return Size of the acknowledgement, or 0 if no packet was decoded yet.
+   */
+  size_t acknowledgement(uint8_t* packet) const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Statistics of a franka::TelemetrySender.
+ */
+struct TelemetryStatistics {
+  /**
+   * Number of sent packets.
+   */
+  uint64_t sent{};
+  /**
+   * Number of sent keyframes.
+   */
+  uint64_t keyframes{};
+  /**
+   * Number of sent bytes.
+   */
+  uint64_t bytes{};
+  /**
+   * Number of packets that could not be sent.
+   */
+  uint64_t send_errors{};
+  /**
+   * Number of received acknowledgements.
+   */
+  uint64_t acknowledgements{};
+};
+
+/**
+ * Sends the samples of a franka::StatePublisher as telemetry over UDP.
+ *
+ * Pass the publisher to Robot::setStatePublisher() to send the states of the control loop. A
+ * background thread reads the latest sample at a fixed period and sends it if it is new, so the
+ * control loop does not do any encoding or network I/O. Acknowledgements of a
+ * franka::TelemetryReceiver are received on the same socket.
+ */
+class TelemetrySender {
+ public:
+  /**
+   * Opens a socket on an ephemeral port and starts the sending thread.
+   *
+   * @param[in] publisher Publisher to read from.
+   * @param[in] remote_address IP or hostname of the receiver.
+   * @param[in] remote_port UDP port of the receiver.
+   * @param[in] period Time between two reads of the publisher.
+   * @param[in] options Encoding parameters.
+   *
+   * @throw NetworkException if the socket cannot be opened or the address is invalid.
+   * @throw std::invalid_argument if publisher is nullptr, period is not positive, or the options
+   * are invalid.
+   */
+  TelemetrySender(std::shared_ptr<StatePublisher> publisher,
+                  const std::string& remote_address,
+                  uint16_t remote_port,
+                  std::chrono::microseconds period = std::chrono::milliseconds(10),
+                  const TelemetryOptions& options = TelemetryOptions());
+
+  /**
+   * Stops the sending thread.
+   */
+  ~TelemetrySender() noexcept;
+
+  TelemetrySender(const TelemetrySender&) = delete;
+  TelemetrySender& operator=(const TelemetrySender&) = delete;
+
+  /**
+   * @return Statistics since the sender was created.
+   */
+  TelemetryStatistics statistics() const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Receives telemetry of a franka::TelemetrySender and acknowledges the decoded packets.
+ *
+ * A receiver is meant to be used by a single thread.
+ */
+class TelemetryReceiver {
+ public:
+  /**
+   * Opens a socket.
+   *
+   * @param[in] local_port UDP port to receive on, or 0 for an ephemeral port.
+   *
+   * @throw NetworkException if the socket cannot be opened.
+   */
+  explicit TelemetryReceiver(uint16_t local_port);
+  ~TelemetryReceiver() noexcept;
+
+  TelemetryReceiver(const TelemetryReceiver&) = delete;
+  TelemetryReceiver& operator=(const TelemetryReceiver&) = delete;
+
+  /**
+   * Waits for the next packet that can be decoded and acknowledges it to its sender.
+   *
+   * @param[out] robot_state Receives the fields contained in the packet. Other fields are
+   * unchanged.
+   * @param[in] timeout Maximum time to wait.
+   *
+   * @return False if no packet could be decoded within the timeout.
+   */
+  bool receive(RobotState* robot_state,
+               std::chrono::microseconds timeout = std::chrono::milliseconds(100)) noexcept;
+
+  /**
+   * @return Port the receiver is bound to.
+   */
+  uint16_t localPort() const noexcept;
+
+  /**
+   * @return Number of received packets that could not be decoded.
+   */
+  uint64_t invalidPackets() const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
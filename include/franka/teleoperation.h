@@ -0,0 +1,255 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @file teleoperation.h
+ * Contains types for bilateral teleoperation between two libfranka hosts.
+ */
+
+namespace franka {
+
+/**
+ * Sample exchanged between the control loops of a teleoperation leader and follower.
+ */
+struct TeleoperationSample {
+  /**
+   * Measured end effector pose in base frame, column major.
+   */
+  std::array<double, 16> O_T_EE{  // NOLINT(readability-identifier-naming)
+      {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  /**
+   * End effector twist in base frame.
+   */
+  std::array<double, 6> O_dP_EE{};  // NOLINT(readability-identifier-naming)
+  /**
+   * Wrench in base frame, e.g. the measured external wrench on the follower or the commanded
+   * feedback on the leader.
+   */
+  std::array<double, 6> O_F{};  // NOLINT(readability-identifier-naming)
+  /**
+   * Wave variables for delay compensation, see franka::WaveVariables. Zero if unused.
+   */
+  std::array<double, 6> wave{};
+};
+
+/**
+ * Statistics of a franka::TeleoperationChannel.
+ *
+ * Delays are measured on the local clock only: every packet echoes the send time of the last packet
+ * received from the other side together with how long that packet was held before the echo, so the
+ * clocks of both hosts need not be synchronized.
+ */
+struct TeleoperationStatistics {
+  /**
+   * Number of packets sent.
+   */
+  uint64_t sent{};
+  /**
+   * Number of packets that could not be sent.
+   */
+  uint64_t send_errors{};
+  /**
+   * Number of valid packets received.
+   */
+  uint64_t received{};
+  /**
+   * Number of received datagrams that were not valid teleoperation packets.
+   */
+  uint64_t invalid{};
+  /**
+   * Number of samples that never arrived before their playout time.
+   */
+  uint64_t lost{};
+  /**
+   * Number of samples that arrived after their playout time.
+   */
+  uint64_t late{};
+  /**
+   * Number of cycles in which the last remote sample had to be held.
+   */
+  uint64_t underruns{};
+  /**
+   * Number of samples skipped because the jitter buffer fell too far behind.
+   */
+  uint64_t skipped{};
+  /**
+   * Number of samples between the playout position and the newest received sample.
+   */
+  uint32_t buffered{};
+  /**
+   * Smoothed network round trip time in [s].
+   */
+  double round_trip_time{};
+  /**
+   * Estimated one-way network delay in [s], i.e. half the round trip time.
+   */
+  double one_way_delay{};
+  /**
+   * Smoothed interarrival jitter in [s].
+   */
+  double jitter{};
+  /**
+   * Time in [s] the last played out sample spent in the jitter buffer.
+   */
+  double playout_delay{};
+  /**
+   * Estimated total delay in [s] from the remote loop to the sample handed to the local loop, i.e.
+   * one_way_delay + playout_delay.
+   */
+  double total_delay{};
+};
+
+/**
+ * Low-latency UDP channel that exchanges one franka::TeleoperationSample per control cycle with a
+ * channel on another host.
+ *
+ * Every call to exchange() sends a compact, sequence-numbered packet with the local sample and
+ * plays out the remote sample that is due. Received packets are kept in a jitter buffer, which
+ * reorders them and delays playout by a configurable number of cycles to absorb network jitter.
+ * The socket is non-blocking and nothing is allocated after construction, so exchange() can be
+ * called from the realtime control loop. Network errors are counted instead of thrown.
+ *
+ * The channel only transports samples. To keep a bilateral loop stable under time delay, encode
+ * the exchanged quantities with franka::WaveVariables, or guard the commanded torques with a
+ * franka::PassivityController.
+ */
+class TeleoperationChannel {
+ public:
+  /**
+   * Largest supported jitter buffer depth.
+   */
+  static constexpr uint32_t kMaxJitterBufferDepth = 16;
+
+  /**
+   * Opens a channel.
+   *
+   * @param[in] local_port UDP port to receive on, or 0 to pick a free port.
+   * @param[in] remote_address Host name or IP address of the other channel.
+   * @param[in] remote_port UDP port of the other channel.
+   * @param[in] jitter_buffer_depth Number of cycles by which playout is delayed to absorb jitter.
+   *
+   * @throw NetworkException if the socket cannot be opened or the remote address is invalid.
+   * @throw std::invalid_argument if jitter_buffer_depth exceeds kMaxJitterBufferDepth.
+   */
+  TeleoperationChannel(uint16_t local_port,
+                       const std::string& remote_address,
+                       uint16_t remote_port,
+                       uint32_t jitter_buffer_depth = 2);
+
+  /**
+   * Closes the channel.
+   */
+  ~TeleoperationChannel() noexcept;
+
+  TeleoperationChannel(const TeleoperationChannel&) = delete;
+  TeleoperationChannel& operator=(const TeleoperationChannel&) = delete;
+
+  /**
+   * Changes the address packets are sent to. Must not be called concurrently with exchange().
+   *
+   * @param[in] remote_address Host name or IP address of the other channel.
+   * @param[in] remote_port UDP port of the other channel.
+   *
+   * @throw NetworkException if the remote address is invalid.
+   */
+  void setRemote(const std::string& remote_address, uint16_t remote_port);
+
+  /**
+   * Sends the local sample and plays out the remote sample for this cycle. Never blocks.
+   *
+   * Poses and wrenches are transmitted in single precision, except for the position.
+   *
+   * @param[in] local Sample of the local control loop.
+   * @param[out] remote Remote sample that is due. If none is due, the last one is held; before the
+   * first one arrives, a default sample is returned.
+   *
+   * @return True if a new remote sample was played out.
+   */
+  bool exchange(const TeleoperationSample& local, TeleoperationSample* remote) noexcept;
+
+  /**
+   * Must not be called concurrently with exchange().
+   *
+   * @return Statistics of the channel.
+   */
+  TeleoperationStatistics statistics() const noexcept;
+
+  /**
+   * @return UDP port the channel receives on.
+   */
+  uint16_t localPort() const noexcept;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Wave variable transformation for passive bilateral teleoperation under constant or varying time
+ * delay.
+ *
+ * Instead of velocities and forces, leader and follower exchange the wave variables
+ * \f$u = (b \dot{x} + F) / \sqrt{2b}\f$ and \f$v = (b \dot{x} - F) / \sqrt{2b}\f$ with the wave
+ * impedance \f$b\f$. The power flowing through the channel is \f$(u^2 - v^2) / 2\f$, so the
+ * communication stays passive for any delay. A large impedance makes the leader feel heavy and
+ * damped, a small one makes the coupling soft.
+ *
+ * The leader sends u and receives v, the follower receives u and sends v, both as
+ * TeleoperationSample::wave. Linear and angular components use separate impedances.
+ */
+class WaveVariables {
+ public:
+  /**
+   * Creates a wave transformation.
+   *
+   * @param[in] translational_impedance Wave impedance for forces and linear velocities in [Ns/m].
+   * @param[in] rotational_impedance Wave impedance for torques and angular velocities in [Nms/rad].
+   *
+   * @throw std::invalid_argument if an impedance is not positive.
+   */
+  WaveVariables(double translational_impedance, double rotational_impedance);
+
+  /**
+   * Leader side: computes the feedback wrench and the wave to send.
+   *
+   * @param[in] velocity Measured leader twist.
+   * @param[in] received_wave Wave v received from the follower.
+   * @param[out] wrench Feedback wrench to apply to the leader.
+   * @param[out] wave Wave u to send to the follower.
+   */
+  void leader(const std::array<double, 6>& velocity,
+              const std::array<double, 6>& received_wave,
+              std::array<double, 6>* wrench,
+              std::array<double, 6>* wave) const noexcept;
+
+  /**
+   * Follower side: computes the desired velocity and the wave to send.
+   *
+   * @param[in] wrench Measured wrench the environment exerts through the follower.
+   * @param[in] received_wave Wave u received from the leader.
+   * @param[out] velocity Desired follower twist.
+   * @param[out] wave Wave v to send to the leader.
+   */
+  void follower(const std::array<double, 6>& wrench,
+                const std::array<double, 6>& received_wave,
+                std::array<double, 6>* velocity,
+                std::array<double, 6>* wave) const noexcept;
+
+  /**
+   * @return Wave impedance of each component.
+   */
+  const std::array<double, 6>& impedance() const noexcept;
+
+ private:
+  std::array<double, 6> impedance_;
+};
+
+}  // namespace franka
@@ -0,0 +1,153 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <franka/control_types.h>
+#include <franka/rate_limiting.h>
+
+/**
+ * @file trajectory_validation.h
+ * Contains functions to check whole trajectories against the limits of the robot before executing
+ * them.
+ */
+
+namespace franka {
+
+/**
+ * Options for franka::validateTrajectory.
+ */
+struct TrajectoryValidationOptions {
+  /**
+   * Lower joint position limits, also used for the elbow of Cartesian trajectories.
+   * Unit: \f$[rad]\f$
+   */
+  std::array<double, 7> min_joint_position{kMinJointPosition};
+  /**
+   * Upper joint position limits, also used for the elbow of Cartesian trajectories.
+   * Unit: \f$[rad]\f$
+   */
+  std::array<double, 7> max_joint_position{kMaxJointPosition};
+  /**
+   * If true, the robot is assumed to be at rest before the first sample, as when a motion is
+   * started with Robot::control. Otherwise, derivatives that would need samples before the first
+   * one are not checked.
+   */
+  bool start_at_rest{true};
+  /**
+   * Number of threads to use. If 0, one thread per hardware thread is used.
+   */
+  size_t thread_count{0};
+};
+
+/**
+ * Sample of a trajectory that violates a limit.
+ */
+struct TrajectoryViolation {
+  /**
+   * Index of the sample.
+   */
+  size_t index{};
+  /**
+   * True if a value of the sample is infinite or NaN.
+   */
+  bool not_finite{};
+  /**
+   * True if a pose of the sample is not a homogeneous transformation.
+   */
+  bool invalid_pose{};
+  /**
+   * True if a joint or the elbow is outside of its position limits.
+   */
+  bool position_limit{};
+  /**
+   * True if a velocity exceeds its limit, or the torque rate for torque trajectories.
+   */
+  bool velocity{};
+  /**
+   * True if an acceleration exceeds its limit, or the bound up to which limitRate lets it grow
+   * before the velocity limit is reached.
+   */
+  bool acceleration{};
+  /**
+   * True if a jerk exceeds its limit.
+   */
+  bool jerk{};
+};
+
+/**
+ * Checks a joint position trajectory sampled every #kDeltaT against #kMaxJointVelocity,
+ * #kMaxJointAcceleration, #kMaxJointJerk and the joint position limits.
+ *
+ * Velocities, accelerations and jerks are obtained by finite differences, as in limitRate. A
+ * sample is reported if limitRate would change it, with the limits it violates. The trajectory is
+ * split into contiguous chunks, which are checked concurrently.
+ *
+ * @param[in] trajectory Commanded joint positions.
+ * @param[in] options Validation options.
+ *
+ * @return Violating samples, ordered by index. Empty if the trajectory can be executed without
+ * rate limiting.
+ */
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<JointPositions>& trajectory,
+    const TrajectoryValidationOptions& options = {});
+
+/**
+ * Checks a joint velocity trajectory sampled every #kDeltaT against #kMaxJointVelocity,
+ * #kMaxJointAcceleration and #kMaxJointJerk. Joint positions are not checked.
+ *
+ * @param[in] trajectory Commanded joint velocities.
+ * @param[in] options Validation options.
+ *
+ * @return Violating samples, ordered by index.
+ */
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<JointVelocities>& trajectory,
+    const TrajectoryValidationOptions& options = {});
+
+/**
+ * Checks a Cartesian pose trajectory sampled every #kDeltaT against the translational, rotational
+ * and, if given, elbow limits, with the rotational limits scaled by
+ * #kFactorCartesianRotationPoseInterface as in limitRate.
+ *
+ * The elbow position is checked against the limits of the third joint.
+ *
+ * @param[in] trajectory Commanded Cartesian poses.
+ * @param[in] options Validation options.
+ *
+ * @return Violating samples, ordered by index.
+ */
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<CartesianPose>& trajectory,
+    const TrajectoryValidationOptions& options = {});
+
+/**
+ * Checks a Cartesian velocity trajectory sampled every #kDeltaT against the translational,
+ * rotational and, if given, elbow limits.
+ *
+ * @param[in] trajectory Commanded Cartesian velocities.
+ * @param[in] options Validation options.
+ *
+ * @return Violating samples, ordered by index.
+ */
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<CartesianVelocities>& trajectory,
+    const TrajectoryValidationOptions& options = {});
+
+/**
+ * Checks a torque trajectory sampled every #kDeltaT against #kMaxTorqueRate.
+ *
+ * @param[in] trajectory Commanded joint torques.
+ * @param[in] options Validation options.
+ *
+ * @return Violating samples, ordered by index.
+ */
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<Torques>& trajectory,
+    const TrajectoryValidationOptions& options = {});
+
+}  // namespace franka
@@ -4,6 +4,8 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -16,14 +18,24 @@
 
 namespace franka {
 
+class AsyncCommandExecutor;
 class Network;
 
 /**
  * Maintains a network connection to the vacuum gripper, provides the current vacuum gripper state,
  * and allows the execution of commands.
  *
+ * Commands are available in a blocking and an asynchronous variant. The asynchronous variants
+ * return as soon as the command has been sent, so that e.g. the vacuum can be started while the
+ * robot is still approaching the part. Their results are delivered through a `std::future` by one
+ * I/O thread per VacuumGripper, which is started with the first asynchronous command.
+ *
+ * The vacuum gripper state can either be waited for with readOnce(), or be kept up to date by a
+ * background receiver after subscribe(), so that latestState() returns it without blocking.
+ *
  * @note
- * The members of this class are threadsafe.
+ * The members of this class are threadsafe, except for the restrictions noted at subscribe(),
+ * unsubscribe() and latestState().
  */
 class VacuumGripper {
  public:
@@ -37,6 +49,11 @@ class VacuumGripper {
    */
   enum class ProductionSetupProfile { kP0, kP1, kP2, kP3 };
 
+  /**
+   * Callback for the vacuum gripper states received after subscribe().
+   */
+  using StateCallback = std::function<void(const VacuumGripperState&)>;
+
   /**
    * Establishes a connection with a vacuum gripper connected to a robot.
    *
@@ -106,9 +123,53 @@ class VacuumGripper {
    */
   bool stop() const;
 
+  /**
+   * Starts vacuuming an object without waiting for it to finish.
+   *
+   * @param[in] vacuum Setpoint for control mode. Unit: \f$[10*mbar]\f$.
+   * @param[in] timeout Vacuum timeout. Unit: \f$[ms]\f$.
+   * @param[in] profile Production setup profile P0 to P3. Default: P0.
+   *
+   * @return Future for the result of vacuum(). Its `get()` throws the exceptions of vacuum().
+   *
+   * @throw CommandException if the profile is invalid.
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see vacuum()
+   */
+  std::future<bool> vacuumAsync(uint8_t vacuum,
+                                std::chrono::milliseconds timeout,
+                                ProductionSetupProfile profile = ProductionSetupProfile::kP0) const;
+
+  /**
+   * Starts dropping the grasped object off without waiting for it to finish.
+   *
+   * @param[in] timeout Dropoff timeout. Unit: \f$[ms]\f$.
+   *
+   * @return Future for the result of dropOff(). Its `get()` throws the exceptions of dropOff().
+   *
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see dropOff()
+   */
+  std::future<bool> dropOffAsync(std::chrono::milliseconds timeout) const;
+
+  /**
+   * Stops a currently running vacuum or drop off operation without waiting for the confirmation.
+   *
+   * @return Future for the result of stop(). Its `get()` throws the exceptions of stop().
+   *
+   * @throw NetworkException if the command cannot be sent.
+   *
+   * @see stop()
+   */
+  std::future<bool> stopAsync() const;
+
   /**
    * Waits for a vacuum gripper state update and returns it.
    *
+   * While subscribed, waits for the next state received by the background receiver instead.
+   *
    * @return Current vacuum gripper state.
    *
    * @throw NetworkException if the connection is lost, e.g. after a timeout.
@@ -116,6 +177,41 @@ class VacuumGripper {
    */
   VacuumGripperState readOnce() const;
 
+  /**
+   * Starts receiving vacuum gripper states in a background thread.
+   *
+   * Returns after the first state has been received, so that latestState() is valid afterwards.
+   * Must not be called while latestState() or readOnce() is running on another thread.
+   *
+   * @param[in] callback Called from the background thread with every new state. Must return
+   * quickly. May be empty.
+   *
+   * @throw InvalidOperationException if already subscribed.
+   * @throw NetworkException if no state is received, e.g. after a timeout.
+   */
+  void subscribe(StateCallback callback = {});
+
+  /**
+   * Stops receiving vacuum gripper states in the background. Does nothing if not subscribed.
+   *
+   * Must not be called while latestState() or readOnce() is running on another thread.
+   */
+  void unsubscribe() noexcept;
+
+  /**
+   * Returns the latest vacuum gripper state received since subscribe() without blocking.
+   *
+   * Makes no system calls and is therefore suitable for realtime loops. May only be called from
+   * one thread at a time.
+   *
+   * @return Latest vacuum gripper state.
+   *
+   * @throw InvalidOperationException if not subscribed.
+   * @throw NetworkException if the background receiver has lost the connection, or the exception
+   * thrown by the state callback.
+   */
+  VacuumGripperState latestState() const;
+
   /**
    * Returns the software version reported by the connected server.
    *
@@ -129,9 +225,18 @@ class VacuumGripper {
   /// @endcond
 
  private:
+  friend class EventLoop;
+
+  class Subscription;
+
   std::unique_ptr<Network> network_;
 
   uint16_t ri_version_;
+
+  // Declared after network_, so that the background threads are stopped before the connection is
+  // closed.
+  std::unique_ptr<AsyncCommandExecutor> async_commands_;
+  std::unique_ptr<Subscription> subscription_;
 };
 
 }  // namespace franka
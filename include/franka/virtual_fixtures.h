@@ -0,0 +1,388 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <franka/haptic_scene.h>
+#include <franka/robot_state.h>
+
+/**
+ * @file virtual_fixtures.h
+ * Contains the franka::fixtures::FixtureSet type and the virtual fixtures it can be composed of.
+ */
+
+namespace franka {
+
+/**
+ * Guidance and forbidden-region virtual fixtures for the end effector.
+ *
+ * A fixture is any object with a call operator of the form
+ * `void operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept`
+ * that adds its wrench, in base frame and about the end effector origin, to the given one.
+ * Fixtures are combined with a franka::fixtures::FixtureSet.
+ */
+namespace fixtures {
+
+/**
+ * End effector pose and velocity, computed once per control cycle and shared by all fixtures.
+ */
+struct FixtureState {
+  /**
+   * End effector position in base frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> position{};
+  /**
+   * End effector orientation in base frame, as column-major 3x3 rotation matrix.
+   */
+  std::array<double, 9> rotation{{1, 0, 0, 0, 1, 0, 0, 0, 1}};
+  /**
+   * Translational end effector velocity in base frame. Unit: \f$[\frac{m}{s}]\f$
+   */
+  std::array<double, 3> linear_velocity{};
+  /**
+   * Rotational end effector velocity in base frame. Unit: \f$[\frac{rad}{s}]\f$
+   */
+  std::array<double, 3> angular_velocity{};
+};
+
+/**
+ * Creates a fixture state from an end effector pose and velocity.
+ *
+ * @param[in] O_T_EE End effector pose in base frame, column-major.
+ * @param[in] O_dP_EE End effector twist in base frame, translation first.
+ *
+ * @return Fixture state.
+ */
+FixtureState fixtureState(
+    const std::array<double, 16>& O_T_EE,                 // NOLINT(readability-identifier-naming)
+    const std::array<double, 6>& O_dP_EE = {}) noexcept;  // NOLINT(readability-identifier-naming)
+
+/**
+ * Creates a fixture state from a robot state, using RobotState::O_T_EE and the measured joint
+ * velocities to compute the end effector twist.
+ *
+ * @param[in] robot_state Robot state.
+ * @param[in] zero_jacobian Zero Jacobian of the end effector, column-major, e.g. from
+ * Model::zeroJacobian.
+ *
+ * @return Fixture state.
+ */
+FixtureState fixtureState(const RobotState& robot_state,
+                          const std::array<double, 42>& zero_jacobian) noexcept;
+
+/**
+ * Plane fixture, either keeping the end effector in front of a plane or guiding it onto the plane.
+ */
+class Plane {
+ public:
+  /**
+   * Behavior of a plane fixture.
+   */
+  enum class Mode {
+    /** The half-space behind the plane is forbidden. */
+    kForbidden,
+    /** The end effector is pulled onto the plane from both sides. */
+    kGuidance
+  };
+
+  /**
+   * Creates a plane fixture.
+   *
+   * @param[in] point Point on the plane in base frame. Unit: \f$[m]\f$
+   * @param[in] normal Normal of the plane in base frame, pointing to the allowed side. Does not
+   * need to be normalized.
+   * @param[in] stiffness Stiffness along the normal. Unit: \f$[\frac{N}{m}]\f$
+   * @param[in] damping Damping along the normal. Unit: \f$[\frac{N \cdot s}{m}]\f$
+   * @param[in] mode Behavior of the fixture.
+   *
+   * @throw std::invalid_argument if the normal is zero, or a value is negative, infinite or NaN.
+   */
+  Plane(const std::array<double, 3>& point,
+        const std::array<double, 3>& normal,
+        double stiffness,
+        double damping = 0,
+        Mode mode = Mode::kForbidden);
+
+  /**
+   * Adds the wrench of the fixture.
+   *
+   * @param[in] state End effector state.
+   * @param[in,out] wrench Wrench in base frame, about the end effector origin.
+   */
+  void operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept;
+
+ private:
+  std::array<double, 3> point_;
+  std::array<double, 3> normal_;
+  double stiffness_;
+  double damping_;
+  Mode mode_;
+};
+
+/**
+ * Forbidden-region fixture keeping the end effector inside a cone, e.g. to funnel it towards an
+ * insertion point at the apex.
+ */
+class Cone {
+ public:
+  /**
+   * Creates a cone fixture.
+   *
+   * @param[in] apex Apex of the cone in base frame. Unit: \f$[m]\f$
+   * @param[in] axis Axis of the cone in base frame, pointing from the apex into the cone. Does not
+   * need to be normalized.
+   * @param[in] half_angle Angle between axis and cone surface, in (0, pi/2). Unit: \f$[rad]\f$
+   * @param[in] stiffness Stiffness towards the cone surface. Unit: \f$[\frac{N}{m}]\f$
+   * @param[in] damping Damping towards the cone surface. Unit: \f$[\frac{N \cdot s}{m}]\f$
+   *
+   * @throw std::invalid_argument if the axis is zero, half_angle is out of range, or a value is
+   * negative, infinite or NaN.
+   */
+  Cone(const std::array<double, 3>& apex,
+       const std::array<double, 3>& axis,
+       double half_angle,
+       double stiffness,
+       double damping = 0);
+
+  /**
+   * Adds the wrench of the fixture.
+   *
+   * @param[in] state End effector state.
+   * @param[in,out] wrench Wrench in base frame, about the end effector origin.
+   */
+  void operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept;
+
+ private:
+  std::array<double, 3> apex_;
+  std::array<double, 3> axis_;
+  double sin_half_angle_;
+  double cos_half_angle_;
+  double stiffness_;
+  double damping_;
+};
+
+/**
+ * Guidance fixture keeping the end effector inside a tube around a path, e.g. along a planned
+ * cut.
+ *
+ * The center line is a Catmull-Rom spline through the given control points, sampled into a
+ * polyline when the fixture is created. Each evaluation tests every polyline segment, so its cost
+ * is fixed by the number of samples.
+ */
+class Tube {
+ public:
+  /**
+   * Creates a tube fixture.
+   *
+   * @param[in] control_points Points the center line passes through, in base frame, at least
+   * two. Unit: \f$[m]\f$
+   * @param[in] radius Radius of the tube. Unit: \f$[m]\f$
+   * @param[in] stiffness Stiffness towards the center line outside of the tube.
+   * Unit: \f$[\frac{N}{m}]\f$
+   * @param[in] damping Damping towards the center line outside of the tube.
+   * Unit: \f$[\frac{N \cdot s}{m}]\f$
+   * @param[in] samples_per_segment Number of polyline segments between two control points.
+   *
+   * @throw std::invalid_argument if there are less than two control points, samples_per_segment
+   * is zero, or a value is negative, infinite or NaN.
+   */
+  Tube(const std::vector<std::array<double, 3>>& control_points,
+       double radius,
+       double stiffness,
+       double damping = 0,
+       size_t samples_per_segment = 16);
+
+  /**
+   * Adds the wrench of the fixture.
+   *
+   * @param[in] state End effector state.
+   * @param[in,out] wrench Wrench in base frame, about the end effector origin.
+   */
+  void operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept;
+
+  /**
+   * @return Sampled center line in base frame. Unit: \f$[m]\f$
+   */
+  const std::vector<std::array<double, 3>>& centerLine() const noexcept;
+
+ private:
+  std::vector<std::array<double, 3>> samples_;
+  double radius_;
+  double stiffness_;
+  double damping_;
+};
+
+/**
+ * Guidance fixture locking the end effector orientation, optionally leaving the rotation about
+ * one axis free.
+ */
+class OrientationLock {
+ public:
+  /**
+   * Creates an orientation lock.
+   *
+   * @param[in] rotation Target orientation in base frame, as column-major 3x3 rotation matrix.
+   * @param[in] stiffness Rotational stiffness. Unit: \f$[\frac{Nm}{rad}]\f$
+   * @param[in] damping Rotational damping. Unit: \f$[\frac{Nm \cdot s}{rad}]\f$
+   * @param[in] free_axis Axis in base frame about which the end effector may rotate freely, or
+   * zero to lock all rotations. Does not need to be normalized.
+   *
+   * @throw std::invalid_argument if rotation is not a rotation matrix, or a value is negative,
+   * infinite or NaN.
+   */
+  OrientationLock(const std::array<double, 9>& rotation,
+                  double stiffness,
+                  double damping = 0,
+                  const std::array<double, 3>& free_axis = {});
+
+  /**
+   * Adds the wrench of the fixture.
+   *
+   * @param[in] state End effector state.
+   * @param[in,out] wrench Wrench in base frame, about the end effector origin.
+   */
+  void operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept;
+
+ private:
+  std::array<double, 9> rotation_;
+  double stiffness_;
+  double damping_;
+  std::array<double, 3> free_axis_;
+};
+
+/**
+ * Guidance fixture pulling the end effector towards a target position with different stiffness
+ * and damping along the axes of a target frame, e.g. stiff sideways and compliant along a tool
+ * axis.
+ */
+class AnisotropicSpring {
+ public:
+  /**
+   * Creates an anisotropic spring.
+   *
+   * @param[in] O_T_target Target frame in base frame, column-major.
+   * @param[in] stiffness Stiffness along the x, y and z axes of the target frame.
+   * Unit: \f$[\frac{N}{m}]\f$
+   * @param[in] damping Damping along the x, y and z axes of the target frame.
+   * Unit: \f$[\frac{N \cdot s}{m}]\f$
+   *
+   * @throw std::invalid_argument if O_T_target is not a homogeneous transformation, or a value is
+   * negative, infinite or NaN.
+   */
+  AnisotropicSpring(
+      const std::array<double, 16>& O_T_target,  // NOLINT(readability-identifier-naming)
+      const std::array<double, 3>& stiffness,
+      const std::array<double, 3>& damping = {});
+
+  /**
+   * Adds the wrench of the fixture.
+   *
+   * @param[in] state End effector state.
+   * @param[in,out] wrench Wrench in base frame, about the end effector origin.
+   */
+  void operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept;
+
+ private:
+  std::array<double, 9> rotation_;
+  std::array<double, 3> position_;
+  std::array<double, 3> stiffness_;
+  std::array<double, 3> damping_;
+};
+
+/**
+ * Combination of virtual fixtures that is fixed at compile time.
+ *
+ * All fixtures are evaluated in a single pass over the same franka::fixtures::FixtureState, and
+ * every call is resolved and inlined at compile time. Evaluating a set does not allocate memory,
+ * so it can be used in Robot::control torque callbacks:
+ * @code{.cpp}
+ * auto fixtures = franka::fixtures::makeFixtureSet(
+ *     franka::fixtures::Plane({{0, 0, 0.1}}, {{0, 0, 1}}, 2000, 20),
+ *     franka::fixtures::OrientationLock(rotation, 50, 2, {{0, 0, 1}}));
+ * robot.control([&](const franka::RobotState& state, franka::Duration) -> franka::Torques {
+ *   std::array<double, 42> jacobian = model.zeroJacobian(franka::Frame::kEndEffector, state);
+ *   return fixtures.torques(franka::fixtures::fixtureState(state, jacobian), jacobian);
+ * });
+ * @endcode
+ *
+ * @tparam Fixtures Types of the fixtures.
+ */
+template <typename... Fixtures>
+class FixtureSet {
+ public:
+  /**
+   * Creates a new fixture set.
+   *
+   * @param[in] fixtures Fixtures to combine.
+   */
+  explicit FixtureSet(Fixtures... fixtures) : fixtures_(std::move(fixtures)...) {}
+
+  /**
+   * Evaluates all fixtures.
+   *
+   * @param[in] state End effector state.
+   *
+   * @return Sum of the wrenches of all fixtures, in base frame and about the end effector origin.
+   */
+  std::array<double, 6> wrench(const FixtureState& state) const noexcept {
+    std::array<double, 6> O_F{};  // NOLINT(readability-identifier-naming)
+    evaluate(state, &O_F, std::index_sequence_for<Fixtures...>());
+    return O_F;
+  }
+
+  /**
+   * Evaluates all fixtures and maps their wrench to joint torques.
+   *
+   * @param[in] state End effector state.
+   * @param[in] zero_jacobian Zero Jacobian of the end effector, column-major, e.g. from
+   * Model::zeroJacobian.
+   *
+   * @return Joint torques. Unit: \f$[Nm]\f$
+   */
+  std::array<double, 7> torques(const FixtureState& state,
+                                const std::array<double, 42>& zero_jacobian) const noexcept {
+    return haptics::wrenchToJointTorques(zero_jacobian, wrench(state));
+  }
+
+  /**
+   * @tparam I Index of the fixture.
+   *
+   * @return The fixture at the given index, e.g. to move it between control loops.
+   */
+  template <size_t I>
+  std::tuple_element_t<I, std::tuple<Fixtures...>>& fixture() noexcept {
+    return std::get<I>(fixtures_);
+  }
+
+ private:
+  template <size_t... I>
+  void evaluate(const FixtureState& state,
+                std::array<double, 6>* O_F,  // NOLINT(readability-identifier-naming)
+                std::index_sequence<I...> /* indices */) const noexcept {
+    using Expand = int[];
+    static_cast<void>(Expand{0, (std::get<I>(fixtures_)(state, O_F), 0)...});
+  }
+
+  std::tuple<Fixtures...> fixtures_;
+};
+
+/**
+ * Creates a fixture set from the given fixtures.
+ *
+ * @param[in] fixtures Fixtures to combine.
+ *
+ * @return Fixture set.
+ */
+template <typename... Fixtures>
+FixtureSet<std::decay_t<Fixtures>...> makeFixtureSet(Fixtures&&... fixtures) {
+  return FixtureSet<std::decay_t<Fixtures>...>(std::forward<Fixtures>(fixtures)...);
+}
+
+}  // namespace fixtures
+}  // namespace franka
@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <franka/command_types.h>
+
+/**
+ * @file virtual_walls.h
+ * Contains the franka::VirtualWalls type to query virtual walls from the control loop.
+ */
+
+namespace franka {
+
+class Robot;
+
+/**
+ * Distance of a point to the boundary of one or more virtual walls.
+ */
+struct VirtualWallDistance {
+  /**
+   * Signed distance to the nearest face. Positive inside the cuboid, i.e. in the permitted
+   * workspace, negative outside. Infinity if no active wall is known. Unit: \f$[m]\f$
+   */
+  double distance;
+  /**
+   * Unit vector in base frame that points away from the nearest face into the cuboid, i.e. the
+   * direction of a repulsive force. Zero if no active wall is known.
+   */
+  std::array<double, 3> normal;
+  /**
+   * VirtualWallCuboid::id of the nearest wall, or -1 if no active wall is known.
+   */
+  int32_t id;
+};
+
+/**
+ * Computes the distance of a point to the boundary of a virtual wall.
+ *
+ * VirtualWallCuboid::p_frame is interpreted as the pose of the cuboid center and
+ * VirtualWallCuboid::object_world_size as its edge lengths along the axes of that frame.
+ * The active flag is ignored.
+ *
+ * @param[in] wall Virtual wall.
+ * @param[in] point Point in base frame. Unit: \f$[m]\f$
+ *
+ * @return Distance to the faces of the wall.
+ */
+VirtualWallDistance virtualWallDistance(const VirtualWallCuboid& wall,
+                                        const std::array<double, 3>& point) noexcept;
+
+/**
+ * Cached set of the Cartesian virtual walls of the robot.
+ *
+ * Robot::getVirtualWall is a blocking network request per wall. A VirtualWalls instance fetches
+ * the walls once with refresh() and keeps their geometry locally, so that the control loop can
+ * query the distance of the end effector to the walls in every cycle, e.g. to render soft
+ * boundaries before the robot's reflex triggers.
+ *
+ * refresh() and set() may be called from another thread while the control loop calls
+ * distance(): the new walls are handed over wait-free and picked up by the next query. They may
+ * not be called concurrently with each other, and distance() and walls() may only be called by one
+ * thread at a time. Queries do not allocate.
+ */
+class VirtualWalls {
+ public:
+  /**
+   * Largest number of cached walls.
+   */
+  static constexpr size_t kMaxWalls = 16;
+
+  /**
+   * Creates an empty set.
+   */
+  VirtualWalls();
+
+  /**
+   * Creates a set and fetches the given walls.
+   *
+   * @param[in] robot Robot to fetch the walls from.
+   * @param[in] ids IDs of the walls.
+   *
+   * @throw CommandException if the Control reports an error.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw std::invalid_argument if more than kMaxWalls IDs are given.
+   */
+  VirtualWalls(Robot& robot, const std::vector<int32_t>& ids);
+
+  ~VirtualWalls() noexcept;
+
+  VirtualWalls(const VirtualWalls&) = delete;
+  VirtualWalls& operator=(const VirtualWalls&) = delete;
+
+  /**
+   * Fetches the given walls from the robot with Robot::getVirtualWall and replaces the cached
+   * set. Blocks until all walls are received; the cached set is unchanged if a request fails.
+   *
+   * @param[in] robot Robot to fetch the walls from.
+   * @param[in] ids IDs of the walls.
+   *
+   * @throw CommandException if the Control reports an error.
+   * @throw NetworkException if the connection is lost, e.g. after a timeout.
+   * @throw std::invalid_argument if more than kMaxWalls IDs are given.
+   */
+  void refresh(Robot& robot, const std::vector<int32_t>& ids);
+
+  /**
+   * Replaces the cached set with the given walls.
+   *
+   * @param[in] walls Virtual walls.
+   *
+   * @throw std::invalid_argument if more than kMaxWalls walls are given.
+   */
+  void set(const std::vector<VirtualWallCuboid>& walls);
+
+  /**
+   * Computes the distance of a point on the end effector to the nearest face of all active walls.
+   *
+   * @param[in] O_T_EE End effector pose in base frame, column-major.
+   * @param[in] offset Position of the point in end effector frame. Unit: \f$[m]\f$
+   *
+   * @return Distance to the nearest wall.
+   */
+  VirtualWallDistance distance(
+      const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+      const std::array<double, 3>& offset = {}) noexcept;
+
+  /**
+   * Returns the cached walls, including inactive ones. Allocates.
+   *
+   * @return Cached walls.
+   */
+  std::vector<VirtualWallCuboid> walls();
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace franka
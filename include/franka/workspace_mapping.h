@@ -0,0 +1,172 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+#include <franka/control_types.h>
+
+/**
+ * @file workspace_mapping.h
+ * Contains the franka::WorkspaceMapping type to map a haptic input device onto the robot.
+ */
+
+namespace franka {
+
+/**
+ * Parameters of the franka::WorkspaceMapping.
+ */
+struct WorkspaceMappingParameters {
+  /**
+   * Orientation of the device base frame D relative to the robot base frame O, as a homogeneous
+   * transformation in column-major format. Only the rotation is used.
+   */
+  std::array<double, 16> O_T_D{  // NOLINT(readability-identifier-naming)
+      {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  /**
+   * Robot displacement per device displacement.
+   */
+  double position_scale{1.0};
+  /**
+   * Robot rotation angle per device rotation angle.
+   */
+  double rotation_scale{1.0};
+  /**
+   * Center of the device workspace in device frame. Unit: \f$[m]\f$
+   */
+  std::array<double, 3> device_center{};
+  /**
+   * Distance from the device workspace center beyond which rate control moves the mapped
+   * workspace. Unit: \f$[m]\f$
+   */
+  double rate_zone_radius{0.05};
+  /**
+   * Robot velocity per device distance beyond the rate zone radius. Zero disables rate control.
+   * Unit: \f$[\frac{1}{s}]\f$
+   */
+  double rate_gain{0.0};
+  /**
+   * Largest translational velocity of the target pose. Unit: \f$[\frac{m}{s}]\f$
+   */
+  double max_velocity{1.0};
+  /**
+   * Largest rotational velocity of the target pose. Unit: \f$[\frac{rad}{s}]\f$
+   */
+  double max_angular_velocity{2.0};
+  /**
+   * Device force per robot force for force feedback.
+   */
+  double force_scale{1.0};
+  /**
+   * Device torque per robot torque for force feedback.
+   */
+  double torque_scale{1.0};
+  /**
+   * Largest force fed back to the device. Unit: \f$[N]\f$
+   */
+  double max_device_force{5.0};
+  /**
+   * Stiffness of the coupling wrench. Units: \f$[\frac{N}{m}]\f$ and \f$[\frac{Nm}{rad}]\f$
+   */
+  std::array<double, 2> coupling_stiffness{{1000.0, 30.0}};
+  /**
+   * Damping of the coupling wrench. Units: \f$[\frac{Ns}{m}]\f$ and \f$[\frac{Nms}{rad}]\f$
+   */
+  std::array<double, 2> coupling_damping{{63.0, 11.0}};
+};
+
+/**
+ * Maps the pose of a haptic input device onto a target pose of the robot end effector, and robot
+ * wrenches back onto device forces.
+ *
+ * While the clutch is engaged, device motion relative to the pose at engagement is rotated into
+ * the robot base frame, scaled and applied to the target pose at engagement. Releasing the clutch
+ * freezes the target, so the operator can reposition the device (indexing). Engaging it again
+ * anchors the mapping at the current device and target poses, so the target continues without a
+ * jump and the control loop keeps running. Near the border of the device workspace, rate control
+ * additionally drifts the mapped workspace in the direction the device is pushed.
+ *
+ * All state consists of fixed-size arrays, so update() can be called from the control loop
+ * without allocating.
+ */
+class WorkspaceMapping {
+ public:
+  /**
+   * Creates a new mapping.
+   *
+   * @param[in] parameters Mapping parameters.
+   *
+   * @throw std::invalid_argument if a parameter is out of range, not finite, or O_T_D is not a
+   * homogeneous transformation.
+   */
+  explicit WorkspaceMapping(const WorkspaceMappingParameters& parameters = {});
+
+  /**
+   * Sets the target pose to the given robot pose and releases the clutch.
+   *
+   * Must be called with the current end effector pose before the first update(), e.g. from the
+   * first control callback.
+   *
+   * @param[in] O_T_EE Current end effector pose in base frame, column-major.
+   */
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  void reset(const std::array<double, 16>& O_T_EE) noexcept;
+
+  /**
+   * Maps the current device pose onto a new target pose.
+   *
+   * @param[in] device_pose Pose of the device handle in device frame, column-major.
+   * @param[in] clutch True while the clutch is engaged.
+   * @param[in] time_step Time since the last update. Unit: \f$[s]\f$
+   *
+   * @return Target end effector pose in base frame.
+   */
+  CartesianPose update(const std::array<double, 16>& device_pose,
+                       bool clutch,
+                       double time_step) noexcept;
+
+  /**
+   * Maps a wrench on the robot onto the force feedback for the device.
+   *
+   * @param[in] O_F Wrench in robot base frame, e.g. RobotState::O_F_ext_hat_K or a rendered
+   * contact wrench. Unit: \f$[N,N,N,Nm,Nm,Nm]\f$
+   *
+   * @return Scaled and saturated wrench in device frame, or zero while the clutch is released.
+   */
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  std::array<double, 6> deviceWrench(const std::array<double, 6>& O_F) const noexcept;
+
+  /**
+   * Computes a spring-damper wrench that pulls the end effector towards the target pose, for
+   * robots controlled by torque instead of pose.
+   *
+   * @param[in] O_T_EE Measured end effector pose in base frame, column-major.
+   * @param[in] O_dP_EE Measured end effector twist in base frame.
+   *
+   * @return Wrench in base frame. Unit: \f$[N,N,N,Nm,Nm,Nm]\f$
+   */
+  std::array<double, 6> couplingWrench(
+      const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+      const std::array<double, 6>& O_dP_EE)  // NOLINT(readability-identifier-naming)
+      const noexcept;
+
+  /**
+   * @return Current target end effector pose in base frame, column-major.
+   */
+  const std::array<double, 16>& target() const noexcept;
+
+  /**
+   * @return True while the clutch is engaged.
+   */
+  bool engaged() const noexcept;
+
+ private:
+  WorkspaceMappingParameters parameters_;
+  bool engaged_{false};
+
+  std::array<double, 16> target_{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  std::array<double, 16> device_anchor_{};
+  std::array<double, 16> robot_anchor_{};
+};
+
+}  // namespace franka
@@ -0,0 +1,229 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "allocation_tracker.h"
+
+#ifdef LIBFRANKA_TRACK_ALLOCATIONS
+
+#include <execinfo.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+constexpr int kMaxStackDepth = 32;
+
+struct ThreadTrackingState {
+  bool active;
+  bool capturing;
+  uint64_t cycle_allocations;
+};
+
+// Initial-exec TLS is accessed without calling into the allocator.
+thread_local ThreadTrackingState tracking_state __attribute__((tls_model("initial-exec"))) = {
+    false, false, 0};
+
+std::atomic<uint64_t> cycles{0};
+std::atomic<uint64_t> cycles_with_allocations{0};
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> max_allocations_per_cycle{0};
+
+std::atomic<bool> stack_claimed{false};
+std::atomic<int> stack_depth{0};
+void* stack_frames[kMaxStackDepth];
+
+void recordAllocation() noexcept {
+  ThreadTrackingState& state = tracking_state;
+  if (!state.active || state.capturing) {
+    return;
+  }
+  state.cycle_allocations++;
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (!stack_claimed.exchange(true, std::memory_order_acq_rel)) {
+    state.capturing = true;
+    stack_depth.store(backtrace(stack_frames, kMaxStackDepth), std::memory_order_release);
+    state.capturing = false;
+  }
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(size_t size);                  // NOLINT(readability-identifier-naming)
+void* __libc_calloc(size_t count, size_t size);    // NOLINT(readability-identifier-naming)
+void* __libc_realloc(void* pointer, size_t size);  // NOLINT(readability-identifier-naming)
+}
+
+inline void* rawAllocate(size_t size) noexcept {
+  return __libc_malloc(size);
+}
+#else
+inline void* rawAllocate(size_t size) noexcept {
+  return std::malloc(size);
+}
+#endif
+
+void* trackedAllocate(size_t size) noexcept {
+  recordAllocation();
+  return rawAllocate(size == 0 ? 1 : size);
+}
+
+}  // anonymous namespace
+
+#ifdef __GLIBC__
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+  recordAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+  recordAllocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+  recordAllocation();
+  return __libc_realloc(pointer, size);
+}
+
+}  // extern "C"
+#endif
+
+void* operator new(size_t size) {
+  void* pointer = trackedAllocate(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void* operator new[](size_t size) {
+  void* pointer = trackedAllocate(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return trackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return trackedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+namespace franka {
+
+AllocationTrackingScope::AllocationTrackingScope() noexcept {
+  if (!stack_claimed.load(std::memory_order_acquire)) {
+    // The first call to backtrace() loads the unwinder, which allocates.
+    void* frame;
+    backtrace(&frame, 1);
+  }
+  tracking_state.cycle_allocations = 0;
+  tracking_state.active = true;
+}
+
+AllocationTrackingScope::~AllocationTrackingScope() noexcept {
+  tracking_state.active = false;
+}
+
+void AllocationTrackingScope::endCycle() noexcept {
+  uint64_t cycle_allocations = tracking_state.cycle_allocations;
+  tracking_state.cycle_allocations = 0;
+
+  cycles.fetch_add(1, std::memory_order_relaxed);
+  if (cycle_allocations > 0) {
+    cycles_with_allocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = max_allocations_per_cycle.load(std::memory_order_relaxed);
+    while (cycle_allocations > max &&
+           !max_allocations_per_cycle.compare_exchange_weak(max, cycle_allocations,
+                                                            std::memory_order_relaxed)) {
+    }
+  }
+}
+
+uint64_t AllocationTrackingScope::cycleAllocations() const noexcept {
+  return tracking_state.cycle_allocations;
+}
+
+bool allocationTrackingEnabled() noexcept {
+  return true;
+}
+
+AllocationStatistics allocationStatistics() {
+  AllocationStatistics statistics;
+  statistics.cycles = cycles.load(std::memory_order_relaxed);
+  statistics.cycles_with_allocations = cycles_with_allocations.load(std::memory_order_relaxed);
+  statistics.allocations = allocations.load(std::memory_order_relaxed);
+  statistics.max_allocations_per_cycle = max_allocations_per_cycle.load(std::memory_order_relaxed);
+
+  int depth = stack_depth.load(std::memory_order_acquire);
+  if (depth > 0) {
+    char** symbols = backtrace_symbols(stack_frames, depth);
+    if (symbols != nullptr) {
+      statistics.first_allocation_stack.assign(symbols, symbols + depth);
+      std::free(symbols);  // NOLINT(cppcoreguidelines-no-malloc)
+    }
+  }
+  return statistics;
+}
+
+void resetAllocationStatistics() noexcept {
+  cycles = 0;
+  cycles_with_allocations = 0;
+  allocations = 0;
+  max_allocations_per_cycle = 0;
+  stack_depth = 0;
+  stack_claimed = false;
+}
+
+}  // namespace franka
+
+#else  // LIBFRANKA_TRACK_ALLOCATIONS
+
+namespace franka {
+
+AllocationTrackingScope::AllocationTrackingScope() noexcept = default;
+
+AllocationTrackingScope::~AllocationTrackingScope() noexcept = default;
+
+void AllocationTrackingScope::endCycle() noexcept {}
+
+uint64_t AllocationTrackingScope::cycleAllocations() const noexcept {
+  return 0;
+}
+
+bool allocationTrackingEnabled() noexcept {
+  return false;
+}
+
+AllocationStatistics allocationStatistics() {
+  return AllocationStatistics();
+}
+
+void resetAllocationStatistics() noexcept {}
+
+}  // namespace franka
+
+#endif  // LIBFRANKA_TRACK_ALLOCATIONS
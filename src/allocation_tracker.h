@@ -0,0 +1,37 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+
+#include <franka/allocation_tracking.h>
+
+namespace franka {
+
+/**
+ * Records heap allocations of the current thread while it is alive.
+ *
+ * Allocations are accumulated per cycle; endCycle() folds the current cycle into the global
+ * franka::AllocationStatistics. Scopes may not be nested. Without the `TRACK_ALLOCATIONS` build
+ * option, this class does nothing.
+ */
+class AllocationTrackingScope {
+ public:
+  AllocationTrackingScope() noexcept;
+  ~AllocationTrackingScope() noexcept;
+
+  AllocationTrackingScope(const AllocationTrackingScope&) = delete;
+  AllocationTrackingScope& operator=(const AllocationTrackingScope&) = delete;
+
+  /**
+   * Finishes the current cycle and starts a new one.
+   */
+  void endCycle() noexcept;
+
+  /**
+   * @return Number of allocations made in the current cycle.
+   */
+  uint64_t cycleAllocations() const noexcept;
+};
+
+}  // namespace franka
@@ -0,0 +1,303 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "arrow_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+#include <franka/exception.h>
+
+namespace franka {
+
+namespace {
+
+constexpr char kArrowMagic[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+constexpr uint32_t kContinuationMarker = 0xFFFFFFFF;
+constexpr size_t kBodyAlignment = 64;
+
+// Values from the Arrow flatbuffer schemas Schema.fbs, Message.fbs and File.fbs.
+constexpr uint16_t kMetadataVersionV5 = 4;
+constexpr uint8_t kMessageHeaderSchema = 1;
+constexpr uint8_t kMessageHeaderRecordBatch = 3;
+constexpr uint8_t kTypeInt = 2;
+constexpr uint8_t kTypeFloatingPoint = 3;
+constexpr uint16_t kPrecisionDouble = 2;
+constexpr uint16_t kEndiannessLittle = 0;
+
+size_t alignUp(size_t size, size_t alignment) noexcept {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// Scalar or offset field of a flatbuffer table. Offsets are written with size 4 and patched once
+// their target has been added.
+struct TableField {
+  uint16_t slot;
+  uint8_t size;
+  uint64_t value;
+};
+
+struct Table {
+  size_t position;
+  // Positions of the fields, in the order in which they were given.
+  std::vector<size_t> fields;
+};
+
+// Minimal flatbuffer builder that appends objects front to back. Children are always added after
+// their parent, so that all offsets point forwards as required. Vtables are placed directly before
+// their table.
+class FlatBuffer {
+ public:
+  FlatBuffer() : data_(sizeof(uint32_t), 0) {}
+
+  void setRoot(size_t table) { patchOffset(0, table); }
+
+  Table addTable(std::initializer_list<TableField> fields) {
+    uint16_t slots = 0;
+    size_t alignment = sizeof(int32_t);
+    for (const TableField& field : fields) {
+      slots = std::max<uint16_t>(slots, field.slot + 1);
+      alignment = std::max<size_t>(alignment, field.size);
+    }
+    pad(sizeof(uint16_t));
+    size_t vtable = data_.size();
+    size_t vtable_size = sizeof(uint16_t) * (2 + slots);
+    data_.resize(vtable + vtable_size, 0);
+    pad(alignment);
+
+    Table table{data_.size(), {}};
+    append<int32_t>(static_cast<int32_t>(table.position - vtable));
+    for (const TableField& field : fields) {
+      pad(field.size);
+      size_t position = data_.size();
+      data_.resize(position + field.size, 0);
+      write(position, field.size, field.value);
+      write(vtable + sizeof(uint16_t) * (2 + field.slot), sizeof(uint16_t),
+            position - table.position);
+      table.fields.push_back(position);
+    }
+    write(vtable, sizeof(uint16_t), vtable_size);
+    write(vtable + sizeof(uint16_t), sizeof(uint16_t), data_.size() - table.position);
+    return table;
+  }
+
+  // Returns the position of the first element.
+  size_t addVector(size_t count, size_t element_size, size_t element_alignment) {
+    size_t alignment = std::max(sizeof(uint32_t), element_alignment);
+    while ((data_.size() + sizeof(uint32_t)) % alignment != 0) {
+      data_.push_back(0);
+    }
+    append<uint32_t>(static_cast<uint32_t>(count));
+    size_t elements = data_.size();
+    data_.resize(elements + count * element_size, 0);
+    return elements;
+  }
+
+  size_t addString(const std::string& string) {
+    pad(sizeof(uint32_t));
+    size_t position = data_.size();
+    append<uint32_t>(static_cast<uint32_t>(string.size()));
+    data_.insert(data_.end(), string.begin(), string.end());
+    data_.push_back(0);
+    return position;
+  }
+
+  void patchOffset(size_t field, size_t target) {
+    write(field, sizeof(uint32_t), target - field);
+  }
+
+  template <typename T>
+  void put(size_t position, T value) {
+    std::memcpy(&data_[position], &value, sizeof(value));
+  }
+
+  // Returns the buffer, padded to 8 bytes.
+  std::vector<char> finish() {
+    pad(sizeof(uint64_t));
+    return data_;
+  }
+
+ private:
+  void pad(size_t alignment) { data_.resize(alignUp(data_.size(), alignment), 0); }
+
+  template <typename T>
+  void append(T value) {
+    data_.resize(data_.size() + sizeof(value));
+    put(data_.size() - sizeof(value), value);
+  }
+
+  void write(size_t position, size_t size, uint64_t value) {
+    switch (size) {
+      case 1:
+        put(position, static_cast<uint8_t>(value));
+        break;
+      case 2:
+        put(position, static_cast<uint16_t>(value));
+        break;
+      case 4:
+        put(position, static_cast<uint32_t>(value));
+        break;
+      default:
+        put(position, value);
+        break;
+    }
+  }
+
+  std::vector<char> data_;
+};
+
+// Adds a Schema table with one non-nullable field per column.
+template <typename TColumn>
+size_t addSchema(FlatBuffer& buffer, const std::vector<TColumn>& columns) {
+  Table schema = buffer.addTable({{0, 2, kEndiannessLittle}, {1, 4, 0}});
+  size_t fields = buffer.addVector(columns.size(), sizeof(uint32_t), sizeof(uint32_t));
+  buffer.patchOffset(schema.fields[1], fields - sizeof(uint32_t));
+
+  for (size_t i = 0; i < columns.size(); i++) {
+    bool is_double = columns[i].type == FieldType::kDouble;
+    // Field: name, nullable, type_type, type, children.
+    Table field = buffer.addTable({{0, 4, 0},
+                                   {1, 1, 0},
+                                   {2, 1, is_double ? kTypeFloatingPoint : kTypeInt},
+                                   {3, 4, 0},
+                                   {5, 4, 0}});
+    buffer.patchOffset(fields + i * sizeof(uint32_t), field.position);
+    buffer.patchOffset(field.fields[0], buffer.addString(columns[i].name));
+    // FloatingPoint: precision. Int: bitWidth, is_signed.
+    Table type = is_double ? buffer.addTable({{0, 2, kPrecisionDouble}})
+                           : buffer.addTable({{0, 4, 64}, {1, 1, 0}});
+    buffer.patchOffset(field.fields[3], type.position);
+    buffer.patchOffset(field.fields[4], buffer.addVector(0, sizeof(uint32_t), sizeof(uint32_t)) -
+                                            sizeof(uint32_t));
+  }
+  return schema.position;
+}
+
+}  // anonymous namespace
+
+constexpr size_t ArrowWriter::kMaxBatchRecords;
+
+ArrowWriter::ArrowWriter(std::ostream& stream, const FieldInfo* fields, size_t field_count)
+    : stream_(stream), column_buffer_(kMaxBatchRecords) {
+  for (size_t i = 0; i < field_count; i++) {
+    for (uint32_t element = 0; element < fields[i].count; element++) {
+      std::string name = fields[i].name;
+      if (fields[i].count > 1) {
+        name += "[" + std::to_string(element) + "]";
+      }
+      columns_.push_back(
+          {name, fields[i].type,
+           fields[i].offset + element * static_cast<uint32_t>(sizeof(uint64_t))});
+    }
+  }
+
+  stream_.write(kArrowMagic, sizeof(kArrowMagic));
+  position_ += sizeof(kArrowMagic);
+
+  // Message: version, header_type, header, bodyLength.
+  FlatBuffer message;
+  Table table =
+      message.addTable({{0, 2, kMetadataVersionV5}, {1, 1, kMessageHeaderSchema}, {2, 4, 0}});
+  message.setRoot(table.position);
+  message.patchOffset(table.fields[2], addSchema(message, columns_));
+  writeMessage(message.finish());
+}
+
+void ArrowWriter::writeBatch(const char* records, size_t record_size, size_t record_count) {
+  for (size_t first = 0; first < record_count; first += kMaxBatchRecords) {
+    size_t rows = std::min(kMaxBatchRecords, record_count - first);
+    size_t column_size = alignUp(rows * sizeof(uint64_t), kBodyAlignment);
+
+    FlatBuffer message;
+    Table table = message.addTable({{0, 2, kMetadataVersionV5},
+                                    {1, 1, kMessageHeaderRecordBatch},
+                                    {2, 4, 0},
+                                    {3, 8, column_size * columns_.size()}});
+    message.setRoot(table.position);
+    // RecordBatch: length, nodes, buffers.
+    Table batch = message.addTable({{0, 8, rows}, {1, 4, 0}, {2, 4, 0}});
+    message.patchOffset(table.fields[2], batch.position);
+
+    // FieldNode: length, null_count.
+    size_t nodes = message.addVector(columns_.size(), 2 * sizeof(int64_t), sizeof(int64_t));
+    message.patchOffset(batch.fields[1], nodes - sizeof(uint32_t));
+    for (size_t i = 0; i < columns_.size(); i++) {
+      message.put<int64_t>(nodes + i * 2 * sizeof(int64_t), static_cast<int64_t>(rows));
+    }
+
+    // Buffer: offset, length. Each column has an empty validity buffer and a data buffer.
+    size_t buffers = message.addVector(2 * columns_.size(), 2 * sizeof(int64_t), sizeof(int64_t));
+    message.patchOffset(batch.fields[2], buffers - sizeof(uint32_t));
+    for (size_t i = 0; i < columns_.size(); i++) {
+      size_t data_buffer = buffers + (2 * i + 1) * 2 * sizeof(int64_t);
+      message.put<int64_t>(data_buffer - 2 * sizeof(int64_t),
+                           static_cast<int64_t>(i * column_size));
+      message.put<int64_t>(data_buffer, static_cast<int64_t>(i * column_size));
+      message.put<int64_t>(data_buffer + sizeof(int64_t),
+                           static_cast<int64_t>(rows * sizeof(uint64_t)));
+    }
+
+    Block block{static_cast<int64_t>(position_), 0, 0,
+                static_cast<int64_t>(column_size * columns_.size())};
+    writeMessage(message.finish());
+    block.metadata_length = static_cast<int32_t>(position_ - static_cast<uint64_t>(block.offset));
+    record_batches_.push_back(block);
+
+    const char* batch_records = records + first * record_size;
+    for (const Column& column : columns_) {
+      for (size_t row = 0; row < rows; row++) {
+        std::memcpy(&column_buffer_[row], batch_records + row * record_size + column.offset,
+                    sizeof(uint64_t));
+      }
+      stream_.write(reinterpret_cast<const char*>(column_buffer_.data()),
+                    static_cast<std::streamsize>(rows * sizeof(uint64_t)));
+      position_ += rows * sizeof(uint64_t);
+      writePadding(column_size - rows * sizeof(uint64_t));
+    }
+  }
+}
+
+void ArrowWriter::finish() {
+  // End-of-stream marker.
+  const uint32_t end_of_stream[] = {kContinuationMarker, 0};
+  stream_.write(reinterpret_cast<const char*>(end_of_stream), sizeof(end_of_stream));
+  position_ += sizeof(end_of_stream);
+
+  // Footer: version, schema, dictionaries, recordBatches.
+  FlatBuffer footer;
+  Table table = footer.addTable({{0, 2, kMetadataVersionV5}, {1, 4, 0}, {2, 4, 0}, {3, 4, 0}});
+  footer.setRoot(table.position);
+  footer.patchOffset(table.fields[1], addSchema(footer, columns_));
+  footer.patchOffset(table.fields[2], footer.addVector(0, sizeof(Block), sizeof(int64_t)) -
+                                          sizeof(uint32_t));
+  size_t blocks = footer.addVector(record_batches_.size(), sizeof(Block), sizeof(int64_t));
+  footer.patchOffset(table.fields[3], blocks - sizeof(uint32_t));
+  for (size_t i = 0; i < record_batches_.size(); i++) {
+    footer.put(blocks + i * sizeof(Block), record_batches_[i]);
+  }
+
+  std::vector<char> data = footer.finish();
+  auto footer_size = static_cast<int32_t>(data.size());
+  stream_.write(data.data(), static_cast<std::streamsize>(data.size()));
+  stream_.write(reinterpret_cast<const char*>(&footer_size), sizeof(footer_size));
+  stream_.write(kArrowMagic, 6);
+  stream_.flush();
+  if (!stream_) {
+    throw Exception("libfranka: Unable to write Arrow file");
+  }
+}
+
+void ArrowWriter::writeMessage(const std::vector<char>& metadata) {
+  const uint32_t prefix[] = {kContinuationMarker, static_cast<uint32_t>(metadata.size())};
+  stream_.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+  stream_.write(metadata.data(), static_cast<std::streamsize>(metadata.size()));
+  position_ += sizeof(prefix) + metadata.size();
+}
+
+void ArrowWriter::writePadding(size_t size) {
+  static constexpr char kZeros[kBodyAlignment] = {};
+  stream_.write(kZeros, static_cast<std::streamsize>(size));
+  position_ += size;
+}
+
+}  // namespace franka
@@ -0,0 +1,58 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "record_format.h"
+
+namespace franka {
+
+// Writes records in the layout of the record format as an uncompressed Arrow IPC file, with one
+// non-nullable column per field element, so that the result can be memory-mapped by columnar
+// analysis tools. Array fields are split into columns named like `q[0]`.
+//
+// See https://arrow.apache.org/docs/format/Columnar.html#ipc-file-format
+class ArrowWriter {
+ public:
+  // Maximum number of records passed to writeBatch() at once. Larger inputs are split.
+  static constexpr size_t kMaxBatchRecords = 65536;
+
+  // Writes the file magic and the schema for the given record fields.
+  ArrowWriter(std::ostream& stream, const FieldInfo* fields, size_t field_count);
+
+  // Writes the given records as record batches.
+  void writeBatch(const char* records, size_t record_size, size_t record_count);
+
+  // Writes the footer. Throws Exception if writing to the stream failed.
+  void finish();
+
+ private:
+  struct Column {
+    std::string name;
+    FieldType type;
+    uint32_t offset;
+  };
+
+  struct Block {
+    int64_t offset;
+    int32_t metadata_length;
+    int32_t padding;
+    int64_t body_length;
+  };
+
+  void writeMessage(const std::vector<char>& metadata);
+  void writePadding(size_t size);
+
+  std::ostream& stream_;
+  std::vector<Column> columns_;
+  std::vector<Block> record_batches_;
+  std::vector<uint64_t> column_buffer_;
+  uint64_t position_{0};
+};
+
+}  // namespace franka
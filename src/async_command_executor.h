@@ -0,0 +1,167 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <franka/exception.h>
+
+#include "network.h"
+#include "platform.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <pthread.h>
+#endif
+
+namespace franka {
+
+// Upper bound for the time the I/O thread of an AsyncCommandExecutor sleeps on the socket. Only
+// matters if a response has already been read from the socket by a blocking command on another
+// thread.
+constexpr std::chrono::milliseconds kAsyncCommandPollTimeout{10};
+
+/**
+ * Sends commands without waiting for their responses and completes them from a single I/O thread.
+ *
+ * The thread is started with the first command and sleeps on the TCP socket while commands are
+ * pending, so any number of commands can be in flight without a thread or a spin loop each.
+ */
+class AsyncCommandExecutor {
+ public:
+  /**
+   * @param[in] network Device connection. Must outlive the executor.
+   */
+  explicit AsyncCommandExecutor(Network& network) : network_(network) {}
+
+  /**
+   * Stops the I/O thread. Commands that are still pending fail with a NetworkException.
+   */
+  ~AsyncCommandExecutor() noexcept {
+    {
+      std::lock_guard<std::mutex> _(mutex_);
+      running_ = false;
+    }
+    condition_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    fail(std::make_exception_ptr(
+        NetworkException("libfranka: Connection closed before the command finished.")));
+  }
+
+  /**
+   * Sends a T::Request.
+   *
+   * @param[in] handle_response Converts the T::Response into the result of the command, or throws.
+   * @param[in] args Arguments of the T::Request.
+   *
+   * @return Future for the result of handle_response.
+   *
+   * @throw NetworkException if the request cannot be sent.
+   */
+  template <typename T, typename... TArgs>
+  std::future<bool> execute(bool (*handle_response)(const typename T::Response&),
+                            TArgs&&... args) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> future = promise->get_future();
+
+    std::lock_guard<std::mutex> _(mutex_);
+    uint32_t command_id = network_.tcpSendRequest<T>(std::forward<TArgs>(args)...);
+    Network& network = network_;
+    pending_.push_back(PendingCommand{
+        promise, [&network, command_id, handle_response, promise]() {
+          return network.tcpReceiveResponse<T>(
+              command_id, [&](const typename T::Response& response) {
+                try {
+                  promise->set_value(handle_response(response));
+                } catch (...) {
+                  promise->set_exception(std::current_exception());
+                }
+              });
+        }});
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&AsyncCommandExecutor::run, this);
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+  AsyncCommandExecutor(const AsyncCommandExecutor&) = delete;
+  AsyncCommandExecutor& operator=(const AsyncCommandExecutor&) = delete;
+
+ private:
+  struct PendingCommand {
+    std::shared_ptr<std::promise<bool>> promise;
+    // Completes the promise and returns true if the response has been received.
+    std::function<bool()> complete;
+  };
+
+  void run() noexcept {
+#ifdef LIBFRANKA_LINUX
+    // Do not inherit a realtime policy from the thread that sent the first command.
+    sched_param parameters{};
+    parameters.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &parameters);
+#endif
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+      if (!running_) {
+        return;
+      }
+
+      try {
+        size_t pending = pending_.size();
+        for (size_t i = 0; i < pending_.size();) {
+          if (pending_[i].complete()) {
+            pending_.erase(pending_.begin() + i);
+          } else {
+            i++;
+          }
+        }
+        if (pending_.empty() || pending_.size() < pending) {
+          continue;
+        }
+
+        lock.unlock();
+        bool readable = network_.tcpWaitForData(kAsyncCommandPollTimeout);
+        if (readable) {
+          network_.tcpThrowIfConnectionClosed();
+        }
+        lock.lock();
+      } catch (...) {
+        if (!lock.owns_lock()) {
+          lock.lock();
+        }
+        fail(std::current_exception());
+      }
+    }
+  }
+
+  // Must be called with mutex_ held or after the I/O thread has been joined.
+  void fail(std::exception_ptr error) noexcept {
+    for (PendingCommand& command : pending_) {
+      command.promise->set_exception(error);
+    }
+    pending_.clear();
+  }
+
+  Network& network_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<PendingCommand> pending_;
+  std::thread thread_;
+  bool running_{true};
+};
+
+}  // namespace franka
@@ -0,0 +1,40 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/butterworth_filter.h>
+
+namespace franka {
+
+BiquadCoefficients butterworthSection(size_t order,
+                                      size_t section,
+                                      double sample_time,
+                                      double cutoff_frequency) {
+  if (order == 0 || order % 2 != 0 || section >= order / 2) {
+    throw std::invalid_argument("Butterworth filter: order is odd or section is out of range.");
+  }
+  if (sample_time <= 0 || !std::isfinite(sample_time)) {
+    throw std::invalid_argument(
+        "Butterworth filter: sample_time is zero, negative, infinite or NaN.");
+  }
+  if (cutoff_frequency <= 0 || !std::isfinite(cutoff_frequency) ||
+      cutoff_frequency >= 0.5 / sample_time) {
+    throw std::invalid_argument(
+        "Butterworth filter: cutoff_frequency is zero, negative, not below the Nyquist frequency, "
+        "infinite or NaN.");
+  }
+
+  // Analog poles of the section lie at angle theta from the negative real axis.
+  double theta = M_PI * (2.0 * section + 1.0) / (2.0 * order);
+  double k = std::tan(M_PI * cutoff_frequency * sample_time);
+  double k_over_q = 2.0 * std::cos(theta) * k;
+  double norm = 1.0 / (1.0 + k_over_q + k * k);
+
+  BiquadCoefficients coefficients{};
+  coefficients.b0 = k * k * norm;
+  coefficients.b1 = 2.0 * coefficients.b0;
+  coefficients.b2 = coefficients.b0;
+  coefficients.a1 = 2.0 * (k * k - 1.0) * norm;
+  coefficients.a2 = (1.0 - k_over_q + k * k) * norm;
+  return coefficients;
+}
+
+}  // namespace franka
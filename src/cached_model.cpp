@@ -0,0 +1,118 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/cached_model.h>
+
+#include <stdexcept>
+
+namespace franka {
+
+namespace {
+
+size_t frameIndex(Frame frame) {
+  size_t index = static_cast<size_t>(frame);
+  if (index >= kFrameCount) {
+    throw std::invalid_argument("Invalid frame given.");
+  }
+  return index;
+}
+
+}  // anonymous namespace
+
+CachedModel::CachedModel(const Model& model) noexcept : model_(model) {}
+
+void CachedModel::update(const franka::RobotState& robot_state) noexcept {
+  if (key_valid_ && q_ == robot_state.q && dq_ == robot_state.dq &&
+      frames_.F_T_EE() == robot_state.F_T_EE && frames_.EE_T_K() == robot_state.EE_T_K &&
+      m_total_ == robot_state.m_total && F_x_Ctotal_ == robot_state.F_x_Ctotal &&
+      I_total_ == robot_state.I_total) {
+    return;
+  }
+
+  invalidate();
+  q_ = robot_state.q;
+  dq_ = robot_state.dq;
+  frames_.set(robot_state);
+  m_total_ = robot_state.m_total;
+  F_x_Ctotal_ = robot_state.F_x_Ctotal;
+  I_total_ = robot_state.I_total;
+  key_valid_ = true;
+}
+
+void CachedModel::invalidate() noexcept {
+  key_valid_ = false;
+  poses_valid_.reset();
+  body_jacobians_valid_.reset();
+  zero_jacobians_valid_.reset();
+  mass_valid_ = false;
+  coriolis_valid_ = false;
+  gravity_valid_ = false;
+}
+
+const std::array<double, 16>& CachedModel::pose(Frame frame,
+                                                const franka::RobotState& robot_state) {
+  size_t index = frameIndex(frame);
+  update(robot_state);
+  if (!poses_valid_[index]) {
+    poses_[index] = model_.pose(frame, q_, frames_);
+    poses_valid_[index] = true;
+  }
+  return poses_[index];
+}
+
+const std::array<double, 42>& CachedModel::bodyJacobian(Frame frame,
+                                                        const franka::RobotState& robot_state) {
+  size_t index = frameIndex(frame);
+  update(robot_state);
+  if (!body_jacobians_valid_[index]) {
+    body_jacobians_[index] = model_.bodyJacobian(frame, q_, frames_);
+    body_jacobians_valid_[index] = true;
+  }
+  return body_jacobians_[index];
+}
+
+const std::array<double, 42>& CachedModel::zeroJacobian(Frame frame,
+                                                        const franka::RobotState& robot_state) {
+  size_t index = frameIndex(frame);
+  update(robot_state);
+  if (!zero_jacobians_valid_[index]) {
+    zero_jacobians_[index] = model_.zeroJacobian(frame, q_, frames_);
+    zero_jacobians_valid_[index] = true;
+  }
+  return zero_jacobians_[index];
+}
+
+const std::array<double, 49>& CachedModel::mass(const franka::RobotState& robot_state) noexcept {
+  update(robot_state);
+  if (!mass_valid_) {
+    mass_ = model_.mass(robot_state);
+    mass_valid_ = true;
+  }
+  return mass_;
+}
+
+const std::array<double, 7>& CachedModel::coriolis(const franka::RobotState& robot_state) noexcept {
+  update(robot_state);
+  if (!coriolis_valid_) {
+    coriolis_ = model_.coriolis(robot_state);
+    coriolis_valid_ = true;
+  }
+  return coriolis_;
+}
+
+const std::array<double, 7>& CachedModel::gravity(
+    const franka::RobotState& robot_state,
+    const std::array<double, 3>& gravity_earth) noexcept {
+  update(robot_state);
+  if (!gravity_valid_ || gravity_earth_ != gravity_earth) {
+    gravity_ = model_.gravity(robot_state, gravity_earth);
+    gravity_earth_ = gravity_earth;
+    gravity_valid_ = true;
+  }
+  return gravity_;
+}
+
+const std::array<double, 7>& CachedModel::gravity(const franka::RobotState& robot_state) noexcept {
+  return gravity(robot_state, robot_state.O_ddP_O);
+}
+
+}  // namespace franka
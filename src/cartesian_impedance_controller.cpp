@@ -0,0 +1,173 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/cartesian_impedance_controller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/rate_limiting.h>
+
+namespace franka {
+
+namespace {
+
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+bool isNonNegative(double value) {
+  return std::isfinite(value) && value >= 0.0;
+}
+
+std::array<double, 6> criticalDamping(const std::array<double, 6>& stiffness) noexcept {
+  std::array<double, 6> damping;
+  for (size_t i = 0; i < damping.size(); i++) {
+    damping[i] = 2.0 * std::sqrt(stiffness[i]);
+  }
+  return damping;
+}
+
+void splitPose(const std::array<double, 16>& pose,
+               std::array<double, 3>* position,
+               std::array<double, 4>* orientation) noexcept {
+  Eigen::Affine3d transform(Eigen::Matrix4d::Map(pose.data()));
+  Eigen::Map<Eigen::Vector3d>(position->data()) = transform.translation();
+  Eigen::Map<Eigen::Quaterniond>(orientation->data()) =
+      Eigen::Quaterniond(transform.linear()).normalized();
+}
+
+template <size_t N>
+void filter(double gain, const std::array<double, N>& target, std::array<double, N>* value) {
+  for (size_t i = 0; i < N; i++) {
+    (*value)[i] += gain * (target[i] - (*value)[i]);
+  }
+}
+
+}  // anonymous namespace
+
+CartesianImpedanceController::CartesianImpedanceController(double translational_stiffness,
+                                                           double rotational_stiffness,
+                                                           double cutoff_frequency) {
+  if (!std::isfinite(cutoff_frequency) || cutoff_frequency <= 0.0) {
+    throw std::invalid_argument(
+        "libfranka: Cartesian impedance controller cutoff frequency must be positive.");
+  }
+  gain_ = kDeltaT / (kDeltaT + 1.0 / (2.0 * M_PI * cutoff_frequency));
+  setStiffness({{translational_stiffness, translational_stiffness, translational_stiffness,
+                 rotational_stiffness, rotational_stiffness, rotational_stiffness}});
+  stiffness_ = target_stiffness_;
+  damping_ = target_damping_;
+}
+
+void CartesianImpedanceController::reset(const RobotState& robot_state) noexcept {
+  splitPose(robot_state.O_T_EE, &position_, &orientation_);
+  target_position_ = position_;
+  target_orientation_ = orientation_;
+  stiffness_ = target_stiffness_;
+  damping_ = target_damping_;
+  has_target_ = true;
+  initialized_ = true;
+}
+
+void CartesianImpedanceController::setTarget(
+    const std::array<double, 16>& O_T_EE_d) {  // NOLINT(readability-identifier-naming)
+  if (!std::all_of(O_T_EE_d.begin(), O_T_EE_d.end(),
+                   [](double value) { return std::isfinite(value); })) {
+    throw std::invalid_argument(
+        "libfranka: Cartesian impedance controller target is infinite or NaN.");
+  }
+  splitPose(O_T_EE_d, &target_position_, &target_orientation_);
+  has_target_ = true;
+}
+
+void CartesianImpedanceController::setStiffness(const std::array<double, 6>& stiffness) {
+  if (!std::all_of(stiffness.begin(), stiffness.end(), isNonNegative)) {
+    throw std::invalid_argument(
+        "libfranka: Cartesian impedance controller stiffness is negative, infinite or NaN.");
+  }
+  target_stiffness_ = stiffness;
+  target_damping_ = criticalDamping(stiffness);
+}
+
+void CartesianImpedanceController::setDamping(const std::array<double, 6>& damping) {
+  if (!std::all_of(damping.begin(), damping.end(), isNonNegative)) {
+    throw std::invalid_argument(
+        "libfranka: Cartesian impedance controller damping is negative, infinite or NaN.");
+  }
+  target_damping_ = damping;
+}
+
+std::array<double, 7> CartesianImpedanceController::update(const RobotState& robot_state,
+                                                           const Model& model) {
+  model.dynamics(robot_state, &dynamics_, Frame::kEndEffector);
+  return update(robot_state, dynamics_);
+}
+
+std::array<double, 7> CartesianImpedanceController::update(
+    const RobotState& robot_state,
+    const DynamicsBundle& dynamics) noexcept {
+  if (!initialized_) {
+    splitPose(robot_state.O_T_EE, &position_, &orientation_);
+    if (!has_target_) {
+      target_position_ = position_;
+      target_orientation_ = orientation_;
+      has_target_ = true;
+    }
+    initialized_ = true;
+  }
+
+  filter(gain_, target_position_, &position_);
+  filter(gain_, target_stiffness_, &stiffness_);
+  filter(gain_, target_damping_, &damping_);
+  Eigen::Map<Eigen::Quaterniond> orientation_d(orientation_.data());
+  Eigen::Map<const Eigen::Quaterniond> target_orientation(target_orientation_.data());
+  orientation_d = orientation_d.slerp(gain_, target_orientation);
+
+  Eigen::Affine3d transform(Eigen::Matrix4d::Map(robot_state.O_T_EE.data()));
+  Vector6d error;
+  error.head<3>() = transform.translation() - Eigen::Map<const Eigen::Vector3d>(position_.data());
+  Eigen::Quaterniond orientation(transform.linear());
+  if (orientation_d.coeffs().dot(orientation.coeffs()) < 0.0) {
+    orientation.coeffs() = -orientation.coeffs();
+  }
+  Eigen::Quaterniond error_quaternion(orientation.inverse() * orientation_d);
+  error.tail<3>() = -transform.linear() * error_quaternion.vec();
+
+  Eigen::Map<const Matrix6x7d> jacobian(dynamics.zero_jacobian.data());
+  Eigen::Map<const Vector7d> dq(robot_state.dq.data());
+  Vector6d wrench =
+      -Eigen::Map<const Vector6d>(stiffness_.data()).cwiseProduct(error) -
+      Eigen::Map<const Vector6d>(damping_.data()).cwiseProduct(jacobian * dq);
+
+  std::array<double, 7> tau_d;
+  Eigen::Map<Vector7d>(tau_d.data()) =
+      jacobian.transpose() * wrench + Eigen::Map<const Vector7d>(dynamics.coriolis.data());
+  return tau_d;
+}
+
+const DynamicsBundle& CartesianImpedanceController::dynamics() const noexcept {
+  return dynamics_;
+}
+
+std::array<double, 16> CartesianImpedanceController::equilibriumPose() const noexcept {
+  Eigen::Affine3d transform = Eigen::Affine3d::Identity();
+  transform.translation() = Eigen::Map<const Eigen::Vector3d>(position_.data());
+  transform.linear() = Eigen::Map<const Eigen::Quaterniond>(orientation_.data()).toRotationMatrix();
+  std::array<double, 16> pose;
+  Eigen::Map<Eigen::Matrix4d>(pose.data()) = transform.matrix();
+  return pose;
+}
+
+const std::array<double, 6>& CartesianImpedanceController::stiffness() const noexcept {
+  return stiffness_;
+}
+
+const std::array<double, 6>& CartesianImpedanceController::damping() const noexcept {
+  return damping_;
+}
+
+}  // namespace franka
@@ -0,0 +1,108 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/clock_estimator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace franka {
+
+namespace {
+
+using Seconds = std::chrono::duration<double>;
+
+}  // anonymous namespace
+
+ClockEstimator::ClockEstimator(double smoothing, double transport_latency)
+    : smoothing_(smoothing), transport_latency_(transport_latency) {
+  if (!(smoothing > 0 && smoothing <= 1)) {
+    throw std::invalid_argument("libfranka: Clock estimator smoothing must be in (0, 1].");
+  }
+  if (!(transport_latency >= 0) || !std::isfinite(transport_latency)) {
+    throw std::invalid_argument(
+        "libfranka: Clock estimator transport latency is negative, infinite or NaN.");
+  }
+}
+
+void ClockEstimator::update(Duration robot_time,
+                            std::chrono::steady_clock::time_point receive_time) noexcept {
+  if (samples_ == 0) {
+    robot_origin_ = robot_time.toMSec();
+    host_origin_ = receive_time;
+  }
+  double x = relativeRobotTime(robot_time);
+  double y = Seconds(receive_time - host_origin_).count();
+  samples_++;
+
+  // Weight the first states equally, so that the fit does not depend on the very first state.
+  double weight = std::max(smoothing_, 1.0 / static_cast<double>(samples_));
+  double dx = x - mean_robot_time_;
+  double dy = y - mean_host_time_;
+  mean_robot_time_ += weight * dx;
+  mean_host_time_ += weight * dy;
+  robot_time_variance_ = (1 - weight) * (robot_time_variance_ + weight * dx * dx);
+  covariance_ = (1 - weight) * (covariance_ + weight * dx * dy);
+
+  double slope = robot_time_variance_ > 0 ? covariance_ / robot_time_variance_ : 1.0;
+  double delay = y - (mean_host_time_ + slope * (x - mean_robot_time_));
+  if (samples_ == 1 || delay < minimum_delay_) {
+    minimum_delay_ = delay;
+  } else {
+    // Rise slowly, so that the minimum follows changes of the fitted line.
+    minimum_delay_ += weight * (delay - minimum_delay_);
+  }
+  mean_delay_ += weight * (delay - mean_delay_);
+}
+
+void ClockEstimator::reset() noexcept {
+  samples_ = 0;
+  robot_origin_ = 0;
+  host_origin_ = {};
+  mean_robot_time_ = 0;
+  mean_host_time_ = 0;
+  robot_time_variance_ = 0;
+  covariance_ = 0;
+  minimum_delay_ = 0;
+  mean_delay_ = 0;
+}
+
+bool ClockEstimator::valid() const noexcept {
+  return robot_time_variance_ > 0;
+}
+
+double ClockEstimator::relativeRobotTime(Duration robot_time) const noexcept {
+  return (static_cast<double>(robot_time.toMSec()) - static_cast<double>(robot_origin_)) * 1e-3;
+}
+
+double ClockEstimator::relativeHostTime(double robot_time) const noexcept {
+  double slope = valid() ? covariance_ / robot_time_variance_ : 1.0;
+  return mean_host_time_ + slope * (robot_time - mean_robot_time_) + minimum_delay_ -
+         transport_latency_;
+}
+
+std::chrono::steady_clock::time_point ClockEstimator::hostTime(Duration robot_time) const
+    noexcept {
+  if (samples_ == 0) {
+    return {};
+  }
+  return host_origin_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            Seconds(relativeHostTime(relativeRobotTime(robot_time))));
+}
+
+ClockEstimate ClockEstimator::estimate() const noexcept {
+  ClockEstimate estimate;
+  estimate.samples = samples_;
+  if (samples_ == 0) {
+    return estimate;
+  }
+  double slope = valid() ? covariance_ / robot_time_variance_ : 1.0;
+  double robot_origin = static_cast<double>(robot_origin_) * 1e-3;
+  estimate.drift = slope - 1;
+  estimate.offset = Seconds(host_origin_.time_since_epoch()).count() +
+                    relativeHostTime(0) - slope * robot_origin;
+  estimate.latency = transport_latency_ + mean_delay_ - minimum_delay_;
+  return estimate;
+}
+
+}  // namespace franka
@@ -0,0 +1,99 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "command_batch.h"
+
+#include <memory>
+#include <utility>
+
+#include <research_interface/robot/service_types.h>
+
+namespace franka {
+
+CommandBatch::CommandBatch() : impl_(std::make_unique<Impl>()) {}
+
+CommandBatch::CommandBatch(CommandBatch&& other) : CommandBatch() {
+  std::swap(impl_, other.impl_);
+}
+
+CommandBatch& CommandBatch::operator=(CommandBatch&& other) noexcept {
+  std::swap(impl_, other.impl_);
+  other.clear();
+  return *this;
+}
+
+CommandBatch::~CommandBatch() noexcept = default;
+
+CommandBatch& CommandBatch::setCollisionBehavior(
+    const std::array<double, 7>& lower_torque_thresholds_acceleration,
+    const std::array<double, 7>& upper_torque_thresholds_acceleration,
+    const std::array<double, 7>& lower_torque_thresholds_nominal,
+    const std::array<double, 7>& upper_torque_thresholds_nominal,
+    const std::array<double, 6>& lower_force_thresholds_acceleration,
+    const std::array<double, 6>& upper_force_thresholds_acceleration,
+    const std::array<double, 6>& lower_force_thresholds_nominal,
+    const std::array<double, 6>& upper_force_thresholds_nominal) {
+  impl_->add<research_interface::robot::SetCollisionBehavior>(
+      lower_torque_thresholds_acceleration, upper_torque_thresholds_acceleration,
+      lower_torque_thresholds_nominal, upper_torque_thresholds_nominal,
+      lower_force_thresholds_acceleration, upper_force_thresholds_acceleration,
+      lower_force_thresholds_nominal, upper_force_thresholds_nominal);
+  return *this;
+}
+
+CommandBatch& CommandBatch::setCollisionBehavior(
+    const std::array<double, 7>& lower_torque_thresholds,
+    const std::array<double, 7>& upper_torque_thresholds,
+    const std::array<double, 6>& lower_force_thresholds,
+    const std::array<double, 6>& upper_force_thresholds) {
+  return setCollisionBehavior(lower_torque_thresholds, upper_torque_thresholds,
+                              lower_torque_thresholds, upper_torque_thresholds,
+                              lower_force_thresholds, upper_force_thresholds,
+                              lower_force_thresholds, upper_force_thresholds);
+}
+
+CommandBatch& CommandBatch::setJointImpedance(
+    const std::array<double, 7>& K_theta) {  // NOLINT(readability-identifier-naming)
+  impl_->add<research_interface::robot::SetJointImpedance>(K_theta);
+  return *this;
+}
+
+CommandBatch& CommandBatch::setCartesianImpedance(
+    const std::array<double, 6>& K_x) {  // NOLINT(readability-identifier-naming)
+  impl_->add<research_interface::robot::SetCartesianImpedance>(K_x);
+  return *this;
+}
+
+CommandBatch& CommandBatch::setGuidingMode(const std::array<bool, 6>& guiding_mode, bool elbow) {
+  impl_->add<research_interface::robot::SetGuidingMode>(guiding_mode, elbow);
+  return *this;
+}
+
+CommandBatch& CommandBatch::setK(
+    const std::array<double, 16>& EE_T_K) {  // NOLINT(readability-identifier-naming)
+  impl_->add<research_interface::robot::SetEEToK>(EE_T_K);
+  return *this;
+}
+
+CommandBatch& CommandBatch::setEE(
+    const std::array<double, 16>& NE_T_EE) {  // NOLINT(readability-identifier-naming)
+  impl_->add<research_interface::robot::SetNEToEE>(NE_T_EE);
+  return *this;
+}
+
+CommandBatch& CommandBatch::setLoad(
+    double load_mass,
+    const std::array<double, 3>& F_x_Cload,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 9>& load_inertia) {
+  impl_->add<research_interface::robot::SetLoad>(load_mass, F_x_Cload, load_inertia);
+  return *this;
+}
+
+size_t CommandBatch::size() const noexcept {
+  return impl_->commands.size();
+}
+
+void CommandBatch::clear() noexcept {
+  impl_->commands.clear();
+}
+
+}  // namespace franka
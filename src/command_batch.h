@@ -0,0 +1,35 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <franka/command_types.h>
+#include <research_interface/robot/service_traits.h>
+
+#include "robot_impl.h"
+
+namespace franka {
+
+class CommandBatch::Impl {
+ public:
+  struct Command {
+    const char* name;
+    std::function<uint32_t(Robot::Impl&)> send;
+    std::function<void(Robot::Impl&, uint32_t)> receive;
+  };
+
+  template <typename T, typename... TArgs>
+  void add(TArgs... args) {
+    commands.push_back(Command{
+        research_interface::robot::CommandTraits<T>::kName,
+        [args...](Robot::Impl& robot) { return robot.sendRequest<T>(args...); },
+        [](Robot::Impl& robot, uint32_t command_id) { robot.receiveResponse<T>(command_id); }});
+  }
+
+  std::vector<Command> commands;
+};
+
+}  // namespace franka
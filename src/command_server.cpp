@@ -0,0 +1,159 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "command_server.h"
+
+#include <cstring>
+
+using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+
+namespace franka {
+
+namespace {
+
+// Interval in which the server checks whether it has been stopped. Unit: [us]
+constexpr long kServerPollInterval = 100000;
+
+// Receives exactly the given number of bytes. Returns false if the connection has been closed.
+bool receiveBytes(Poco::Net::StreamSocket& socket, uint8_t* data, size_t size) {
+  size_t received = 0;
+  while (received < size) {
+    int bytes = socket.receiveBytes(data + received, static_cast<int>(size - received));
+    if (bytes <= 0) {
+      return false;
+    }
+    received += static_cast<size_t>(bytes);
+  }
+  return true;
+}
+
+template <typename T>
+bool acknowledgeRequest(CommandServer& server,
+                        const research_interface::robot::CommandHeader& header,
+                        const std::vector<uint8_t>& message) {
+  CommandServer::readRequest<T>(message);
+  server.sendResponse<T>(header.command_id, typename T::Response(T::Status::kSuccess));
+  return true;
+}
+
+}  // anonymous namespace
+
+CommandServer::CommandServer(RequestHandler request_handler, DisconnectHandler disconnect_handler)
+    : request_handler_(std::move(request_handler)),
+      disconnect_handler_(std::move(disconnect_handler)) {
+  try {
+    server_.bind({"127.0.0.1", 0}, true);
+    server_.listen();
+    port_ = server_.address().port();
+  } catch (const Poco::Exception& e) {
+    throw NetworkException("libfranka: Cannot start command server: "s + e.what());
+  }
+  server_thread_ = std::thread(&CommandServer::serve, this);
+}
+
+CommandServer::~CommandServer() noexcept {
+  running_ = false;
+  server_thread_.join();
+}
+
+uint16_t CommandServer::port() const noexcept {
+  return port_;
+}
+
+bool CommandServer::acknowledge(const research_interface::robot::CommandHeader& header,
+                                const std::vector<uint8_t>& message) {
+  namespace ri = research_interface::robot;
+
+  switch (header.command) {
+    case ri::Command::kAutomaticErrorRecovery:
+      return acknowledgeRequest<ri::AutomaticErrorRecovery>(*this, header, message);
+    case ri::Command::kSetCollisionBehavior:
+      return acknowledgeRequest<ri::SetCollisionBehavior>(*this, header, message);
+    case ri::Command::kSetJointImpedance:
+      return acknowledgeRequest<ri::SetJointImpedance>(*this, header, message);
+    case ri::Command::kSetCartesianImpedance:
+      return acknowledgeRequest<ri::SetCartesianImpedance>(*this, header, message);
+    case ri::Command::kSetGuidingMode:
+      return acknowledgeRequest<ri::SetGuidingMode>(*this, header, message);
+    case ri::Command::kSetEEToK:
+      return acknowledgeRequest<ri::SetEEToK>(*this, header, message);
+    case ri::Command::kSetNEToEE:
+      return acknowledgeRequest<ri::SetNEToEE>(*this, header, message);
+    case ri::Command::kSetLoad:
+      return acknowledgeRequest<ri::SetLoad>(*this, header, message);
+    case ri::Command::kSetFilters:
+      return acknowledgeRequest<ri::SetFilters>(*this, header, message);
+    default:
+      return false;
+  }
+}
+
+void CommandServer::serve() noexcept {
+  while (running_) {
+    try {
+      if (!server_.poll(Poco::Timespan(kServerPollInterval), Poco::Net::Socket::SELECT_READ)) {
+        continue;
+      }
+      Poco::Net::StreamSocket connection = server_.acceptConnection();
+      connection.setNoDelay(true);
+      {
+        std::lock_guard<std::mutex> _(connection_mutex_);
+        connection_ = connection;
+        connected_ = true;
+      }
+      serveConnection(connection);
+    } catch (const std::exception&) {
+      // The robot disconnected, the connection broke, or the robot sent an invalid request. Wait
+      // for the next connection.
+    }
+
+    bool disconnected = false;
+    {
+      std::lock_guard<std::mutex> _(connection_mutex_);
+      if (connected_) {
+        connected_ = false;
+        disconnected = true;
+        try {
+          connection_.close();
+        } catch (const Poco::Exception&) {
+        }
+      }
+    }
+    if (disconnected) {
+      disconnect_handler_();
+    }
+  }
+}
+
+void CommandServer::serveConnection(Poco::Net::StreamSocket& connection) {
+  namespace ri = research_interface::robot;
+
+  std::vector<uint8_t> message;
+  while (running_) {
+    if (!connection.poll(Poco::Timespan(kServerPollInterval), Poco::Net::Socket::SELECT_READ)) {
+      continue;
+    }
+    ri::CommandHeader header;
+    if (!receiveBytes(connection, reinterpret_cast<uint8_t*>(&header), sizeof(header)) ||
+        header.size < sizeof(header)) {
+      return;
+    }
+    message.resize(header.size);
+    std::memcpy(message.data(), &header, sizeof(header));
+    if (!receiveBytes(connection, message.data() + sizeof(header), header.size - sizeof(header))) {
+      return;
+    }
+
+    if (header.command == ri::Command::kConnect) {
+      auto request = readRequest<ri::Connect>(message);
+      sendResponse<ri::Connect>(
+          header.command_id,
+          ri::Connect::Response(request.version == ri::kVersion
+                                    ? ri::Connect::Status::kSuccess
+                                    : ri::Connect::Status::kIncompatibleLibraryVersion));
+    } else if (!request_handler_(header, message)) {
+      return;
+    }
+  }
+}
+
+}  // namespace franka
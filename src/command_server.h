@@ -0,0 +1,143 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/StreamSocket.h>
+
+#include <franka/exception.h>
+#include <research_interface/robot/service_types.h>
+
+namespace franka {
+
+/**
+ * Serves the TCP command protocol of a robot in-process, e.g. for a simulated or replayed robot.
+ *
+ * Listens on the loopback interface and accepts one connection at a time. Connect requests are
+ * answered by the server itself; all other requests are passed to the request handler.
+ */
+class CommandServer {
+ public:
+  /**
+   * Handles a request. Returns false if the request cannot be handled and the connection has to be
+   * closed.
+   */
+  using RequestHandler = std::function<bool(const research_interface::robot::CommandHeader& header,
+                                            const std::vector<uint8_t>& message)>;
+
+  /**
+   * Called after the connected robot disconnected. Responses are no longer sent at this point.
+   */
+  using DisconnectHandler = std::function<void()>;
+
+  /**
+   * Starts the server thread.
+   *
+   * @throw NetworkException if the server socket cannot be opened.
+   */
+  CommandServer(RequestHandler request_handler, DisconnectHandler disconnect_handler);
+
+  /**
+   * Closes the connection and stops the server thread.
+   */
+  ~CommandServer() noexcept;
+
+  CommandServer(const CommandServer&) = delete;
+  CommandServer& operator=(const CommandServer&) = delete;
+
+  /**
+   * @return Port the server listens on.
+   */
+  uint16_t port() const noexcept;
+
+  /**
+   * Sends a response to the connected robot. Does nothing if no robot is connected.
+   *
+   * Responses are sent in the order of the calls, so callers can order them with a lock of their
+   * own.
+   *
+   * @param[in] command_id ID of the answered command.
+   * @param[in] response Response to send.
+   * @param[in] data Variable-length data sent after the response.
+   */
+  template <typename T>
+  void sendResponse(uint32_t command_id,
+                    const typename T::Response& response,
+                    const std::vector<uint8_t>& data = {}) noexcept;
+
+  /**
+   * Answers requests that only change settings of the robot, or recover from errors, with success
+   * without applying them.
+   *
+   * @return False if the request is of another type and has not been answered.
+   *
+   * @throw ProtocolException if the request has an incorrect size.
+   */
+  bool acknowledge(const research_interface::robot::CommandHeader& header,
+                   const std::vector<uint8_t>& message);
+
+  /**
+   * Extracts a T::Request from a complete request message.
+   *
+   * @throw ProtocolException if the message has an incorrect size.
+   */
+  template <typename T>
+  static typename T::Request readRequest(const std::vector<uint8_t>& message);
+
+ private:
+  void serve() noexcept;
+  void serveConnection(Poco::Net::StreamSocket& connection);
+
+  const RequestHandler request_handler_;
+  const DisconnectHandler disconnect_handler_;
+
+  Poco::Net::ServerSocket server_;
+  uint16_t port_{0};
+
+  std::mutex connection_mutex_;
+  Poco::Net::StreamSocket connection_;
+  bool connected_{false};
+
+  std::atomic<bool> running_{true};
+  std::thread server_thread_;
+};
+
+template <typename T>
+void CommandServer::sendResponse(uint32_t command_id,
+                                 const typename T::Response& response,
+                                 const std::vector<uint8_t>& data) noexcept {
+  using Message = typename T::template Message<typename T::Response>;
+  std::lock_guard<std::mutex> _(connection_mutex_);
+  if (!connected_) {
+    return;
+  }
+  Message message(typename T::Header(T::kCommand, command_id,
+                                     static_cast<uint32_t>(sizeof(Message) + data.size())),
+                  response);
+  try {
+    connection_.sendBytes(&message, sizeof(message));
+    if (!data.empty()) {
+      connection_.sendBytes(data.data(), static_cast<int>(data.size()));
+    }
+  } catch (const Poco::Exception&) {
+    // The robot disconnected, which the server thread handles.
+  }
+}
+
+template <typename T>
+typename T::Request CommandServer::readRequest(const std::vector<uint8_t>& message) {
+  if (message.size() != sizeof(typename T::template Message<typename T::Request>)) {
+    throw ProtocolException("libfranka: Incorrect TCP message size.");
+  }
+  return reinterpret_cast<const typename T::template Message<typename T::Request>*>(message.data())
+      ->getInstance();
+}
+
+}  // namespace franka
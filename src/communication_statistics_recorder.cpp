@@ -0,0 +1,62 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "communication_statistics_recorder.h"
+
+#include <algorithm>
+
+namespace franka {
+
+bool CommunicationStatisticsRecorder::record(uint64_t message_id,
+                                             double control_command_success_rate,
+                                             bool moving,
+                                             double success_rate_threshold) noexcept {
+  statistics_.received_states++;
+  statistics_.control_command_success_rate = control_command_success_rate;
+
+  uint64_t lost = 0;
+  if (sequence_started_ && message_id > last_message_id_) {
+    lost = message_id - last_message_id_ - 1;
+  }
+  sequence_started_ = true;
+  last_message_id_ = message_id;
+  statistics_.lost_states += lost;
+  statistics_.lost_in_a_row = lost;
+  statistics_.max_lost_in_a_row = std::max(statistics_.max_lost_in_a_row, lost);
+
+  bool degraded = false;
+  if (moving) {
+    statistics_.min_control_command_success_rate =
+        std::min(statistics_.min_control_command_success_rate, control_command_success_rate);
+    degraded = control_command_success_rate < success_rate_threshold;
+  }
+  // Only report the drop below the threshold, not every state after it.
+  bool dropped = degraded && !degraded_;
+  degraded_ = degraded;
+  return lost > 0 || dropped;
+}
+
+CommunicationStatistics CommunicationStatisticsRecorder::statistics() const noexcept {
+  CommunicationStatistics statistics = statistics_;
+  statistics.round_trip = round_trip_.statistics();
+  return statistics;
+}
+
+void CommunicationStatisticsRecorder::reset() noexcept {
+  statistics_ = {};
+  round_trip_.reset();
+  degraded_ = false;
+}
+
+std::ostream& operator<<(std::ostream& ostream, const CommunicationStatistics& statistics) {
+  ostream << "{\"received_states\": " << statistics.received_states
+          << ", \"lost_states\": " << statistics.lost_states
+          << ", \"lost_in_a_row\": " << statistics.lost_in_a_row
+          << ", \"max_lost_in_a_row\": " << statistics.max_lost_in_a_row
+          << ", \"control_command_success_rate\": " << statistics.control_command_success_rate
+          << ", \"min_control_command_success_rate\": "
+          << statistics.min_control_command_success_rate
+          << ", \"round_trip\": " << statistics.round_trip << "}";
+  return ostream;
+}
+
+}  // namespace franka
@@ -0,0 +1,61 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <franka/communication_statistics.h>
+
+#include "control_statistics_recorder.h"
+
+namespace franka {
+
+/**
+ * Tracks lost robot states, the command success rate and the round-trip delay without allocating.
+ */
+class CommunicationStatisticsRecorder {
+ public:
+  void setEnabled(bool enabled) noexcept { enabled_ = enabled; }
+  bool enabled() const noexcept { return enabled_; }
+
+  /**
+   * Starts a new sequence of consecutive states. States missing between the last recorded state and
+   * the next one are not counted as lost.
+   */
+  void restart() noexcept { sequence_started_ = false; }
+
+  /**
+   * Records a received robot state.
+   *
+   * @param[in] message_id Message ID of the state.
+   * @param[in] control_command_success_rate Success rate reported with the state.
+   * @param[in] moving True if a motion is running, so that the success rate is meaningful.
+   * @param[in] success_rate_threshold Success rate below which communication counts as degraded.
+   *
+   * @return True if states have been lost right before this one, or if the success rate has just
+   * dropped below the threshold.
+   */
+  bool record(uint64_t message_id,
+              double control_command_success_rate,
+              bool moving,
+              double success_rate_threshold) noexcept;
+
+  /**
+   * Records the time from sending a robot command until the next state has been received.
+   */
+  void recordRoundTrip(std::chrono::nanoseconds duration) noexcept { round_trip_.record(duration); }
+
+  CommunicationStatistics statistics() const noexcept;
+  void reset() noexcept;
+
+ private:
+  bool enabled_{false};
+  bool sequence_started_{false};
+  bool degraded_{false};
+  uint64_t last_message_id_{0};
+  CommunicationStatistics statistics_{};
+  LatencyHistogram round_trip_{};
+};
+
+}  // namespace franka
@@ -0,0 +1,316 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "compressed_log_ring.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace franka {
+
+constexpr size_t CompressedLogRing::kMaxValues;
+
+namespace {
+
+// Residuals within [kMinResidual, 127] are stored directly.
+constexpr int8_t kEscape32 = -128;
+constexpr int8_t kEscape64 = -127;
+constexpr int64_t kMinResidual = -126;
+// Quantized values are clamped to the range in which doubles represent all integers.
+constexpr double kMaxQuantized = 9007199254740992.0;
+
+int64_t quantize(double value, double resolution) noexcept {
+  double scaled = std::round(value / resolution);
+  if (!std::isfinite(scaled)) {
+    return 0;
+  }
+  return static_cast<int64_t>(std::max(-kMaxQuantized, std::min(kMaxQuantized, scaled)));
+}
+
+template <size_t N>
+void gatherArray(const std::array<double, N>& array, double* values, size_t* count) noexcept {
+  std::copy(array.begin(), array.end(), values + *count);
+  *count += N;
+}
+
+template <size_t N>
+void scatterArray(const double* values, size_t* count, std::array<double, N>* array) noexcept {
+  std::copy(values + *count, values + *count + N, array->begin());
+  *count += N;
+}
+
+// The order of the values must match the resolutions set up by the constructor.
+void gather(LogFields fields,
+            const research_interface::robot::RobotState& state,
+            const research_interface::robot::RobotCommand& command,
+            double* values) noexcept {
+  size_t count = 0;
+  if (hasLogFields(fields, LogFields::kQ)) {
+    gatherArray(state.q, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kQD)) {
+    gatherArray(state.q_d, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kDq)) {
+    gatherArray(state.dq, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kDqD)) {
+    gatherArray(state.dq_d, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kTauJ)) {
+    gatherArray(state.tau_J, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kTauExtHatFiltered)) {
+    gatherArray(state.tau_ext_hat_filtered, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kMotionCommand)) {
+    gatherArray(command.motion.q_c, values, &count);
+    gatherArray(command.motion.dq_c, values, &count);
+    gatherArray(command.motion.O_T_EE_c, values, &count);
+    gatherArray(command.motion.O_dP_EE_c, values, &count);
+  }
+  if (hasLogFields(fields, LogFields::kControlCommand)) {
+    gatherArray(command.control.tau_J_d, values, &count);
+  }
+}
+
+void scatter(LogFields fields, const double* values, Record* record) noexcept {
+  size_t count = 0;
+  if (hasLogFields(fields, LogFields::kQ)) {
+    scatterArray(values, &count, &record->state.q);
+  }
+  if (hasLogFields(fields, LogFields::kQD)) {
+    scatterArray(values, &count, &record->state.q_d);
+  }
+  if (hasLogFields(fields, LogFields::kDq)) {
+    scatterArray(values, &count, &record->state.dq);
+  }
+  if (hasLogFields(fields, LogFields::kDqD)) {
+    scatterArray(values, &count, &record->state.dq_d);
+  }
+  if (hasLogFields(fields, LogFields::kTauJ)) {
+    scatterArray(values, &count, &record->state.tau_J);
+  }
+  if (hasLogFields(fields, LogFields::kTauExtHatFiltered)) {
+    scatterArray(values, &count, &record->state.tau_ext_hat_filtered);
+  }
+  if (hasLogFields(fields, LogFields::kMotionCommand)) {
+    scatterArray(values, &count, &record->command.joint_positions.q);
+    scatterArray(values, &count, &record->command.joint_velocities.dq);
+    scatterArray(values, &count, &record->command.cartesian_pose.O_T_EE);
+    scatterArray(values, &count, &record->command.cartesian_velocities.O_dP_EE);
+  }
+  if (hasLogFields(fields, LogFields::kControlCommand)) {
+    scatterArray(values, &count, &record->command.torques.tau_J);
+  }
+}
+
+}  // anonymous namespace
+
+CompressedLogRing::CompressedLogRing(size_t log_size,
+                                     LogFields fields,
+                                     const LogCompression& compression)
+    : log_size_(log_size), interval_(compression.keyframe_interval), fields_(fields) {
+  if (hasLogFields(fields, LogFields::kFullState)) {
+    throw std::invalid_argument("libfranka: LogFields::kFullState cannot be compressed.");
+  }
+  if (compression.keyframe_interval == 0) {
+    throw std::invalid_argument("libfranka: Keyframe interval of the log must be positive.");
+  }
+  for (double resolution :
+       {compression.joint_position_resolution, compression.joint_velocity_resolution,
+        compression.torque_resolution, compression.cartesian_resolution}) {
+    if (!std::isfinite(resolution) || resolution <= 0) {
+      throw std::invalid_argument("libfranka: Log resolutions must be positive and finite.");
+    }
+  }
+
+  auto append = [this](size_t count, double resolution, bool linear) {
+    std::fill_n(resolutions_.begin() + value_count_, count, resolution);
+    std::fill_n(linear_.begin() + value_count_, count, linear);
+    value_count_ += count;
+  };
+  if (hasLogFields(fields, LogFields::kQ)) {
+    append(7, compression.joint_position_resolution, true);
+  }
+  if (hasLogFields(fields, LogFields::kQD)) {
+    append(7, compression.joint_position_resolution, true);
+  }
+  if (hasLogFields(fields, LogFields::kDq)) {
+    append(7, compression.joint_velocity_resolution, false);
+  }
+  if (hasLogFields(fields, LogFields::kDqD)) {
+    append(7, compression.joint_velocity_resolution, true);
+  }
+  if (hasLogFields(fields, LogFields::kTauJ)) {
+    append(7, compression.torque_resolution, false);
+  }
+  if (hasLogFields(fields, LogFields::kTauExtHatFiltered)) {
+    append(7, compression.torque_resolution, false);
+  }
+  if (hasLogFields(fields, LogFields::kMotionCommand)) {
+    append(7, compression.joint_position_resolution, true);
+    append(7, compression.joint_velocity_resolution, true);
+    append(16, compression.cartesian_resolution, true);
+    append(6, compression.cartesian_resolution, true);
+  }
+  if (hasLogFields(fields, LogFields::kControlCommand)) {
+    append(7, compression.torque_resolution, false);
+  }
+
+  if (log_size == 0) {
+    return;
+  }
+  // One more block than needed, so that log_size samples remain while the newest block fills.
+  block_count_ = (log_size + interval_ - 1) / interval_ + 1;
+  blocks_.resize(block_count_);
+  keyframes_.resize(block_count_ * value_count_);
+  residuals_.resize(block_count_ * interval_ * value_count_);
+  message_id_residuals_.resize(block_count_ * interval_);
+  success_rates_.resize(block_count_ * interval_);
+  escapes_.resize(std::max(log_size, interval_));
+}
+
+void CompressedLogRing::push(const research_interface::robot::RobotState& state,
+                             const research_interface::robot::RobotCommand& command) noexcept {
+  if (block_count_ == 0) {
+    return;
+  }
+
+  const size_t block = (written_ / interval_) % block_count_;
+  const size_t position = written_ % interval_;
+  const size_t sample = block * interval_ + position;
+
+  std::array<double, kMaxValues> values;
+  gather(fields_, state, command, values.data());
+  if (position == 0) {
+    blocks_[block] = {state.message_id, escapes_written_};
+    int64_t* keyframe = &keyframes_[block * value_count_];
+    for (size_t i = 0; i < value_count_; i++) {
+      keyframe[i] = quantize(values[i], resolutions_[i]);
+      last_values_[i] = keyframe[i];
+      last_deltas_[i] = 0;
+    }
+    message_id_residuals_[sample] = 0;
+  } else {
+    message_id_residuals_[sample] =
+        encodeResidual(static_cast<int64_t>(state.message_id - last_message_id_ - 1));
+    int8_t* residuals = &residuals_[sample * value_count_];
+    for (size_t i = 0; i < value_count_; i++) {
+      int64_t value = quantize(values[i], resolutions_[i]);
+      int64_t prediction = last_values_[i] + (linear_[i] ? last_deltas_[i] : 0);
+      residuals[i] = encodeResidual(value - prediction);
+      last_deltas_[i] = value - last_values_[i];
+      last_values_[i] = value;
+    }
+  }
+  last_message_id_ = state.message_id;
+  success_rates_[sample] = static_cast<float>(state.control_command_success_rate);
+  written_++;
+}
+
+void CompressedLogRing::clear() noexcept {
+  written_ = 0;
+  escapes_written_ = 0;
+}
+
+size_t CompressedLogRing::size() const noexcept {
+  return static_cast<size_t>(std::min<uint64_t>(written_ - firstDecodable(), log_size_));
+}
+
+size_t CompressedLogRing::read(Record* records, size_t count) const noexcept {
+  const size_t size = std::min(count, this->size());
+  if (size == 0) {
+    return 0;
+  }
+  const uint64_t begin = written_ - size;
+
+  std::array<int64_t, kMaxValues> values;
+  std::array<int64_t, kMaxValues> deltas;
+  std::array<double, kMaxValues> scaled;
+  uint64_t message_id = 0;
+  uint64_t escape_index = 0;
+  for (uint64_t i = begin - begin % interval_; i < written_; i++) {
+    const size_t block = (i / interval_) % block_count_;
+    const size_t position = i % interval_;
+    const size_t sample = block * interval_ + position;
+    if (position == 0) {
+      const int64_t* keyframe = &keyframes_[block * value_count_];
+      std::copy(keyframe, keyframe + value_count_, values.begin());
+      deltas.fill(0);
+      message_id = blocks_[block].message_id;
+      escape_index = blocks_[block].escape_begin;
+    } else {
+      message_id += 1 + static_cast<uint64_t>(
+                            decodeResidual(message_id_residuals_[sample], &escape_index));
+      const int8_t* residuals = &residuals_[sample * value_count_];
+      for (size_t j = 0; j < value_count_; j++) {
+        int64_t prediction = values[j] + (linear_[j] ? deltas[j] : 0);
+        int64_t value = prediction + decodeResidual(residuals[j], &escape_index);
+        deltas[j] = value - values[j];
+        values[j] = value;
+      }
+    }
+
+    if (i >= begin) {
+      for (size_t j = 0; j < value_count_; j++) {
+        scaled[j] = static_cast<double>(values[j]) * resolutions_[j];
+      }
+      Record* record = &records[i - begin];
+      *record = Record();
+      record->state.time = Duration(message_id);
+      record->state.control_command_success_rate = success_rates_[sample];
+      scatter(fields_, scaled.data(), record);
+    }
+  }
+  return size;
+}
+
+size_t CompressedLogRing::capacityBytes() const noexcept {
+  return blocks_.size() * sizeof(Block) + keyframes_.size() * sizeof(int64_t) +
+         residuals_.size() * sizeof(int8_t) + message_id_residuals_.size() * sizeof(int8_t) +
+         success_rates_.size() * sizeof(float) + escapes_.size() * sizeof(uint32_t);
+}
+
+int8_t CompressedLogRing::encodeResidual(int64_t residual) noexcept {
+  if (residual >= kMinResidual && residual <= 127) {
+    return static_cast<int8_t>(residual);
+  }
+  if (residual >= INT32_MIN && residual <= INT32_MAX) {
+    escapes_[escapes_written_++ % escapes_.size()] = static_cast<uint32_t>(residual);
+    return kEscape32;
+  }
+  const auto bits = static_cast<uint64_t>(residual);
+  escapes_[escapes_written_++ % escapes_.size()] = static_cast<uint32_t>(bits >> 32);
+  escapes_[escapes_written_++ % escapes_.size()] = static_cast<uint32_t>(bits);
+  return kEscape64;
+}
+
+int64_t CompressedLogRing::decodeResidual(int8_t code, uint64_t* escape_index) const noexcept {
+  if (code == kEscape32) {
+    return static_cast<int32_t>(escapes_[(*escape_index)++ % escapes_.size()]);
+  }
+  if (code == kEscape64) {
+    uint64_t high = escapes_[(*escape_index)++ % escapes_.size()];
+    uint64_t low = escapes_[(*escape_index)++ % escapes_.size()];
+    return static_cast<int64_t>(high << 32 | low);
+  }
+  return code;
+}
+
+uint64_t CompressedLogRing::firstDecodable() const noexcept {
+  if (written_ == 0) {
+    return 0;
+  }
+  const uint64_t newest_block = (written_ - 1) / interval_;
+  uint64_t block = newest_block + 1 >= block_count_ ? newest_block + 1 - block_count_ : 0;
+  // Blocks start with increasing overflow positions, so only the oldest ones can be incomplete.
+  for (; block <= newest_block; block++) {
+    if (escapes_written_ - blocks_[block % block_count_].escape_begin <= escapes_.size()) {
+      return block * interval_;
+    }
+  }
+  return written_;
+}
+
+}  // namespace franka
@@ -0,0 +1,114 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <franka/log.h>
+#include <research_interface/robot/rbk_types.h>
+
+namespace franka {
+
+/**
+ * Ring of logged samples, stored as keyframes and quantized prediction residuals, see
+ * LogCompression.
+ *
+ * The ring is organized in blocks of LogCompression::keyframe_interval samples. The first sample
+ * of a block is stored as a keyframe, the others as one residual byte per value. Residuals that do
+ * not fit into a byte are marked by an escape code and stored in a shared overflow ring. Blocks
+ * whose overflow values have been overwritten can no longer be decoded and are dropped. The time is
+ * stored like a value predicted to advance by one millisecond.
+ *
+ * Positions and commanded motions are predicted linearly from the last two samples. Measured
+ * velocities and torques, and commanded torques, which follow their noise, are predicted by the
+ * last sample, as a linear prediction would amplify the noise.
+ *
+ * push() only writes into arrays allocated by the constructor, with a cost bounded by the number
+ * of logged values.
+ */
+class CompressedLogRing {
+ public:
+  /// Maximum number of values of a sample.
+  static constexpr size_t kMaxValues = 85;
+
+  /**
+   * Creates an empty ring that cannot hold any sample.
+   */
+  CompressedLogRing() = default;
+
+  /**
+   * Allocates a ring that holds at least the last log_size samples.
+   *
+   * @throw std::invalid_argument if the compression parameters are invalid or fields contains
+   * LogFields::kFullState.
+   */
+  CompressedLogRing(size_t log_size, LogFields fields, const LogCompression& compression);
+
+  void push(const research_interface::robot::RobotState& state,
+            const research_interface::robot::RobotCommand& command) noexcept;
+
+  void clear() noexcept;
+
+  /**
+   * @return Number of samples that can be read.
+   */
+  size_t size() const noexcept;
+
+  /**
+   * Decodes the last samples into the given storage, oldest first.
+   *
+   * @param[out] records Storage for at least count records.
+   * @param[in] count Maximum number of samples to decode.
+   *
+   * @return Number of decoded samples.
+   */
+  size_t read(Record* records, size_t count) const noexcept;
+
+  /**
+   * @return Number of bytes allocated for the samples.
+   */
+  size_t capacityBytes() const noexcept;
+
+ private:
+  struct Block {
+    uint64_t message_id;
+    uint64_t escape_begin;
+  };
+
+  // Returns the residual, or an escape code after writing it to the overflow ring.
+  int8_t encodeResidual(int64_t residual) noexcept;
+  int64_t decodeResidual(int8_t code, uint64_t* escape_index) const noexcept;
+  // Oldest sample of which all overflow values are still available.
+  uint64_t firstDecodable() const noexcept;
+
+  size_t log_size_{0};
+  size_t interval_{1};
+  size_t block_count_{0};
+  size_t value_count_{0};
+  LogFields fields_{LogFields::kNone};
+  std::array<double, kMaxValues> resolutions_{};
+  std::array<bool, kMaxValues> linear_{};
+
+  std::vector<Block> blocks_;
+  // block_count_ * value_count_ quantized keyframe values.
+  std::vector<int64_t> keyframes_;
+  // block_count_ * interval_ * value_count_ residuals.
+  std::vector<int8_t> residuals_;
+  // block_count_ * interval_ residuals of the message ID.
+  std::vector<int8_t> message_id_residuals_;
+  std::vector<float> success_rates_;
+  std::vector<uint32_t> escapes_;
+
+  // Total number of pushed samples and written overflow values since the last clear().
+  uint64_t written_{0};
+  uint64_t escapes_written_{0};
+  // Encoder state: quantized values and differences of the last sample.
+  uint64_t last_message_id_{0};
+  std::array<int64_t, kMaxValues> last_values_{};
+  std::array<int64_t, kMaxValues> last_deltas_{};
+};
+
+}  // namespace franka
@@ -7,6 +7,7 @@
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <string>
 
 #include <franka/control_tools.h>
 #include <franka/control_types.h>
@@ -14,7 +15,9 @@
 #include <franka/lowpass_filter.h>
 #include <franka/rate_limiting.h>
 
+#include "allocation_tracker.h"
 #include "motion_generator_traits.h"
+#include "tracing.h"
 
 // `using std::string_literals::operator""s` produces a GCC warning that cannot be disabled, so we
 // have to use `using namespace ...`.
@@ -26,30 +29,164 @@ namespace franka {
 namespace {
 
 template <typename T, size_t N>
-inline void checkFinite(const std::array<T, N>& array) {
-  if (!std::all_of(array.begin(), array.end(), [](double d) { return std::isfinite(d); })) {
+inline void checkFinite(ValidationPolicy policy, const std::array<T, N>& array) {
+  bool finite = policy == ValidationPolicy::kChecksum
+                    ? hasFiniteSum(array)
+                    : std::all_of(array.begin(), array.end(),
+                                  [](double d) { return std::isfinite(d); });
+  if (!finite) {
     throw std::invalid_argument("Commanding value is infinite or NaN.");
   }
 }
 
-inline void checkElbow(const std::array<double, 2>& elbow) {
-  checkFinite(elbow);
-  if (!isValidElbow(elbow)) {
+inline void checkElbow(ValidationPolicy policy, const std::array<double, 2>& elbow) {
+  checkFinite(policy, elbow);
+  if (policy == ValidationPolicy::kFull && !isValidElbow(elbow)) {
     throw std::invalid_argument(
         "Invalid elbow configuration given! Only +1 or -1 are allowed for the sign of the 4th "
         "joint.");
   }
 }
 
-inline void checkMatrix(const std::array<double, 16>& transform) {
-  checkFinite(transform);
-  if (!isHomogeneousTransformation(transform)) {
+inline void checkMatrix(ValidationPolicy policy, const std::array<double, 16>& transform) {
+  checkFinite(policy, transform);
+  if (policy == ValidationPolicy::kFull && !isHomogeneousTransformation(transform)) {
     throw std::invalid_argument(
         "libfranka: Attempt to set invalid transformation in motion generator. Has to be column "
         "major!");
   }
 }
 
+// With ValidationPolicy::kChecksum, invalid inputs propagate to the checked command instead.
+template <typename Filter, size_t N>
+inline std::array<double, N> filterCommand(ValidationPolicy policy,
+                                           Filter& filter,
+                                           const std::array<double, N>& y,
+                                           const std::array<double, N>& y_last) {
+  return policy == ValidationPolicy::kChecksum ? filter.filterUnchecked(y, y_last)
+                                               : filter.filter(y, y_last);
+}
+
+inline void setRealtimePriority(RealtimeConfig realtime_config,
+                                const RealtimeOptions& realtime_options) {
+  bool throw_on_error = realtime_config == RealtimeConfig::kEnforce;
+  std::string error_message;
+  if (!setCurrentThreadToHighestSchedulerPriority(&error_message) && throw_on_error) {
+    throw RealtimeException(error_message);
+  }
+  if (throw_on_error && !hasRealtimeKernel()) {
+    throw RealtimeException("libfranka: Running kernel does not have realtime capabilities.");
+  }
+  error_message.clear();
+  if (!applyRealtimeOptions(realtime_options, nullptr, &error_message) && throw_on_error) {
+    throw RealtimeException(error_message);
+  }
+}
+
+// Filters are only applied below kMaxCutoffFrequency, so clamp to a valid frequency otherwise.
+inline double commandFilterCutoff(double cutoff_frequency) {
+  return cutoff_frequency < kMaxCutoffFrequency ? cutoff_frequency : kMaxCutoffFrequency;
+}
+
+inline std::array<double, 7> commandFilterCutoff(const std::array<double, 7>& cutoff_frequencies) {
+  std::array<double, 7> clamped;
+  std::transform(cutoff_frequencies.begin(), cutoff_frequencies.end(), clamped.begin(),
+                 [](double cutoff_frequency) { return commandFilterCutoff(cutoff_frequency); });
+  return clamped;
+}
+
+inline bool isFiltered(double cutoff_frequency) {
+  return cutoff_frequency < kMaxCutoffFrequency;
+}
+
+inline bool isFiltered(const std::array<double, 7>& cutoff_frequencies) {
+  return std::any_of(cutoff_frequencies.begin(), cutoff_frequencies.end(),
+                     [](double cutoff_frequency) { return isFiltered(cutoff_frequency); });
+}
+
+template <typename T>
+inline void recordLimiting(LimitingStatisticsRecorder* recorder,
+                           LimitingStatisticsRecorder::Stage stage,
+                           const T& commanded,
+                           const T& limited) {
+  if (recorder != nullptr) {
+    recorder->record(stage, commanded, limited);
+  }
+}
+
+inline std::unique_ptr<JointStateEstimator> makeJointStateEstimator(const RobotControl& robot) {
+  const JointStateEstimatorParameters* parameters = robot.jointStateEstimatorParameters();
+  if (parameters == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<JointStateEstimator>(*parameters);
+}
+
+inline MomentumObserver* startMomentumObserver(RobotControl& robot) {
+  MomentumObserver* observer = robot.momentumObserver();
+  if (observer != nullptr) {
+    observer->reset();
+  }
+  return observer;
+}
+
+inline PassivityController* startPassivityControl(RobotControl& robot) {
+  PassivityController* controller = robot.passivityController();
+  if (controller != nullptr) {
+    controller->reset();
+  }
+  return controller;
+}
+
+inline std::unique_ptr<OnlineTrajectoryGenerator> makeOnlineTrajectoryGenerator(
+    const RobotControl& robot,
+    bool limit_rate) {
+  if (!limit_rate || !robot.onlineTrajectoryGeneration()) {
+    return nullptr;
+  }
+  return std::make_unique<OnlineTrajectoryGenerator>();
+}
+
+// Command that holds the last motion generator command, for cycles in which the motion generator
+// callback misses its deadline. The elbow is only held if it was commanded.
+template <typename T>
+T holdMotion(const RobotState& robot_state, bool elbow);
+
+template <>
+JointPositions holdMotion<JointPositions>(const RobotState& robot_state, bool) {
+  return JointPositions(robot_state.q_d);
+}
+
+template <>
+JointVelocities holdMotion<JointVelocities>(const RobotState& robot_state, bool) {
+  return JointVelocities(robot_state.dq_d);
+}
+
+template <>
+CartesianPose holdMotion<CartesianPose>(const RobotState& robot_state, bool elbow) {
+  return elbow ? CartesianPose(robot_state.O_T_EE_c, robot_state.elbow_c)
+               : CartesianPose(robot_state.O_T_EE_c);
+}
+
+template <>
+CartesianVelocities holdMotion<CartesianVelocities>(const RobotState& robot_state, bool elbow) {
+  return elbow ? CartesianVelocities(robot_state.O_dP_EE_c, robot_state.elbow_c)
+               : CartesianVelocities(robot_state.O_dP_EE_c);
+}
+
+// Copies the fields the command filters and rate limiters read from the previous state.
+inline void copyCommandFeedback(const RobotStateView& robot_state, RobotState* feedback) {
+  feedback->q_d = robot_state.q_d();
+  feedback->dq_d = robot_state.dq_d();
+  feedback->ddq_d = robot_state.ddq_d();
+  feedback->O_T_EE_c = robot_state.O_T_EE_c();
+  feedback->O_dP_EE_c = robot_state.O_dP_EE_c();
+  feedback->O_ddP_EE_c = robot_state.O_ddP_EE_c();
+  feedback->elbow_c = robot_state.elbow_c();
+  feedback->delbow_c = robot_state.delbow_c();
+  feedback->ddelbow_c = robot_state.ddelbow_c();
+}
+
 }  // anonymous namespace
 
 template <typename T>
@@ -60,19 +197,42 @@ ControlLoop<T>::ControlLoop(RobotControl& robot,
                             MotionGeneratorCallback motion_callback,
                             ControlCallback control_callback,
                             bool limit_rate,
-                            double cutoff_frequency)
+                            const FilterConfiguration& filter_configuration)
     : robot_(robot),
       motion_callback_(std::move(motion_callback)),
       control_callback_(std::move(control_callback)),
       limit_rate_(limit_rate),
-      cutoff_frequency_(cutoff_frequency) {
-  bool throw_on_error = robot_.realtimeConfig() == RealtimeConfig::kEnforce;
-  std::string error_message;
-  if (!setCurrentThreadToHighestSchedulerPriority(&error_message) && throw_on_error) {
-    throw RealtimeException(error_message);
-  }
-  if (throw_on_error && !hasRealtimeKernel()) {
-    throw RealtimeException("libfranka: Running kernel does not have realtime capabilities.");
+      validation_policy_(robot_.validationPolicy()),
+      filter_torques_(isFiltered(filter_configuration.torques)),
+      filter_joints_(isFiltered(filter_configuration.joints)),
+      filter_cartesian_(isFiltered(filter_configuration.cartesian)),
+      filter_elbow_(isFiltered(filter_configuration.elbow)),
+      torque_filter_(kDeltaT, commandFilterCutoff(filter_configuration.torques)),
+      joint_filter_(kDeltaT, commandFilterCutoff(filter_configuration.joints)),
+      cartesian_filter_(kDeltaT, commandFilterCutoff(filter_configuration.cartesian)),
+      elbow_filter_(kDeltaT, commandFilterCutoff(filter_configuration.elbow)),
+      pose_filter_(kDeltaT, commandFilterCutoff(filter_configuration.cartesian)),
+      statistics_(robot_.controlStatisticsRecorder()),
+      limiting_statistics_(robot_.limitingStatisticsRecorder()),
+      joint_state_estimator_(makeJointStateEstimator(robot_)),
+      state_prediction_model_(robot_.statePredictionModel()),
+      momentum_observer_(startMomentumObserver(robot_)),
+      momentum_observer_model_(robot_.momentumObserverModel()),
+      passivity_controller_(startPassivityControl(robot_)),
+      trajectory_generator_(makeOnlineTrajectoryGenerator(robot_, limit_rate_)),
+      deadline_(robot_.callbackDeadline()),
+      deadline_statistics_(deadline_ != nullptr ? robot_.deadlineStatistics() : nullptr) {
+  setRealtimePriority(robot_.realtimeConfig(), robot_.realtimeOptions());
+  if (deadline_ != nullptr) {
+    // In combined loops, the budget covers the control callback only, and the motion callback
+    // runs on the control thread.
+    if (control_callback_) {
+      control_deadline_worker_ =
+          std::make_unique<DeadlineWorker<Torques>>(control_callback_, deadline_->budget);
+    } else if (motion_callback_) {
+      motion_deadline_worker_ =
+          std::make_unique<DeadlineWorker<T>>(motion_callback_, deadline_->budget);
+    }
   }
 }
 
@@ -81,12 +241,12 @@ ControlLoop<T>::ControlLoop(RobotControl& robot,
                             ControlCallback control_callback,
                             MotionGeneratorCallback motion_callback,
                             bool limit_rate,
-                            double cutoff_frequency)
+                            const FilterConfiguration& filter_configuration)
     : ControlLoop(robot,
                   std::move(motion_callback),
                   std::move(control_callback),
                   limit_rate,
-                  cutoff_frequency) {
+                  filter_configuration) {
   if (!control_callback_) {
     throw std::invalid_argument("libfranka: Invalid control callback given.");
   }
@@ -104,8 +264,8 @@ ControlLoop<T>::ControlLoop(RobotControl& robot,
                             ControllerMode controller_mode,
                             MotionGeneratorCallback motion_callback,
                             bool limit_rate,
-                            double cutoff_frequency)
-    : ControlLoop(robot, std::move(motion_callback), {}, limit_rate, cutoff_frequency) {
+                            const FilterConfiguration& filter_configuration)
+    : ControlLoop(robot, std::move(motion_callback), {}, limit_rate, filter_configuration) {
   if (!motion_callback_) {
     throw std::invalid_argument("libfranka: Invalid motion callback given.");
   }
@@ -124,28 +284,95 @@ ControlLoop<T>::ControlLoop(RobotControl& robot,
                                  kDefaultDeviation, kDefaultDeviation);
 }
 
+template <typename T>
+ControlLoop<T>::ControlLoop(RobotControl& robot,
+                            ControlViewCallback control_callback,
+                            MotionGeneratorViewCallback motion_callback,
+                            bool limit_rate,
+                            const FilterConfiguration& filter_configuration)
+    : robot_(robot),
+      motion_view_callback_(std::move(motion_callback)),
+      control_view_callback_(std::move(control_callback)),
+      limit_rate_(limit_rate),
+      validation_policy_(robot_.validationPolicy()),
+      filter_torques_(isFiltered(filter_configuration.torques)),
+      filter_joints_(isFiltered(filter_configuration.joints)),
+      filter_cartesian_(isFiltered(filter_configuration.cartesian)),
+      filter_elbow_(isFiltered(filter_configuration.elbow)),
+      torque_filter_(kDeltaT, commandFilterCutoff(filter_configuration.torques)),
+      joint_filter_(kDeltaT, commandFilterCutoff(filter_configuration.joints)),
+      cartesian_filter_(kDeltaT, commandFilterCutoff(filter_configuration.cartesian)),
+      elbow_filter_(kDeltaT, commandFilterCutoff(filter_configuration.elbow)),
+      pose_filter_(kDeltaT, commandFilterCutoff(filter_configuration.cartesian)),
+      statistics_(robot_.controlStatisticsRecorder()),
+      limiting_statistics_(robot_.limitingStatisticsRecorder()),
+      joint_state_estimator_(makeJointStateEstimator(robot_)),
+      state_prediction_model_(robot_.statePredictionModel()),
+      momentum_observer_(startMomentumObserver(robot_)),
+      momentum_observer_model_(robot_.momentumObserverModel()),
+      passivity_controller_(startPassivityControl(robot_)),
+      trajectory_generator_(makeOnlineTrajectoryGenerator(robot_, limit_rate_)) {
+  // No deadline workers: a view is only valid on the control thread, so view callbacks always
+  // run without the callback deadline, as documented in Robot::setCallbackDeadline().
+  if (!control_view_callback_) {
+    throw std::invalid_argument("libfranka: Invalid control callback given.");
+  }
+  if (!motion_view_callback_) {
+    throw std::invalid_argument("libfranka: Invalid motion callback given.");
+  }
+  setRealtimePriority(robot_.realtimeConfig(), robot_.realtimeOptions());
+
+  motion_id_ = robot.startMotion(
+      research_interface::robot::Move::ControllerMode::kExternalController,
+      MotionGeneratorTraits<T>::kMotionGeneratorMode, kDefaultDeviation, kDefaultDeviation);
+}
+
+template <typename T>
+void ControlLoop<T>::setTorqueFilter(const ButterworthFilter<7>& filter) {
+  torque_butterworth_filter_ = std::make_unique<ButterworthFilter<7>>(filter);
+  torque_butterworth_filter_->reset();
+}
+
 template <typename T>
 void ControlLoop<T>::operator()() try {
+  if (motion_view_callback_) {
+    loopWithView();
+    return;
+  }
+
   RobotState robot_state = robot_.update(nullptr, nullptr);
   robot_.throwOnMotionError(robot_state, motion_id_);
+  estimateJointState(&robot_state, Duration());
 
   Duration previous_time = robot_state.time;
 
   research_interface::robot::MotionGeneratorCommand motion_command{};
   if (control_callback_) {
     research_interface::robot::ControllerCommand control_command{};
-    while (spinMotion(robot_state, robot_state.time - previous_time, &motion_command) &&
-           spinControl(robot_state, robot_state.time - previous_time, &control_command)) {
-      previous_time = robot_state.time;
-      robot_state = robot_.update(&motion_command, &control_command);
-      robot_.throwOnMotionError(robot_state, motion_id_);
+    {
+      AllocationTrackingScope allocation_tracking;
+      while (spinMotion(robot_state, robot_state.time - previous_time, &motion_command) &&
+             spinControl(robot_state, robot_state.time - previous_time, &control_command)) {
+        previous_time = robot_state.time;
+        robot_state = robot_.update(&motion_command, &control_command);
+        Tracing::counter("ControlLoop::cycle", static_cast<int64_t>(robot_state.time.toMSec()));
+        robot_.throwOnMotionError(robot_state, motion_id_);
+        estimateJointState(&robot_state, robot_state.time - previous_time);
+        allocation_tracking.endCycle();
+      }
     }
     robot_.finishMotion(motion_id_, &motion_command, &control_command);
   } else {
-    while (spinMotion(robot_state, robot_state.time - previous_time, &motion_command)) {
-      previous_time = robot_state.time;
-      robot_state = robot_.update(&motion_command, nullptr);
-      robot_.throwOnMotionError(robot_state, motion_id_);
+    {
+      AllocationTrackingScope allocation_tracking;
+      while (spinMotion(robot_state, robot_state.time - previous_time, &motion_command)) {
+        previous_time = robot_state.time;
+        robot_state = robot_.update(&motion_command, nullptr);
+        Tracing::counter("ControlLoop::cycle", static_cast<int64_t>(robot_state.time.toMSec()));
+        robot_.throwOnMotionError(robot_state, motion_id_);
+        estimateJointState(&robot_state, robot_state.time - previous_time);
+        allocation_tracking.endCycle();
+      }
     }
     robot_.finishMotion(motion_id_, &motion_command, nullptr);
   }
@@ -158,50 +385,212 @@ void ControlLoop<T>::operator()() try {
 }
 
 template <typename T>
-bool ControlLoop<T>::spinControl(const RobotState& robot_state,
-                                 franka::Duration time_step,
-                                 research_interface::robot::ControllerCommand* command) {
-  Torques control_output = control_callback_(robot_state, time_step);
-  if (cutoff_frequency_ < kMaxCutoffFrequency) {
-    for (size_t i = 0; i < 7; i++) {
-      control_output.tau_J[i] = lowpassFilter(kDeltaT, control_output.tau_J[i],
-                                              robot_state.tau_J_d[i], cutoff_frequency_);
+void ControlLoop<T>::loopWithView() {
+  RobotStateView robot_state = robot_.updateView(nullptr, nullptr);
+  robot_.throwOnMotionError(robot_state, motion_id_);
+
+  Duration previous_time = robot_state.time();
+
+  research_interface::robot::MotionGeneratorCommand motion_command{};
+  research_interface::robot::ControllerCommand control_command{};
+  {
+    AllocationTrackingScope allocation_tracking;
+    while (spinMotion(robot_state, robot_state.time() - previous_time, &motion_command) &&
+           spinControl(robot_state, robot_state.time() - previous_time, &control_command)) {
+      previous_time = robot_state.time();
+      robot_state = robot_.updateView(&motion_command, &control_command);
+      Tracing::counter("ControlLoop::cycle", static_cast<int64_t>(robot_state.time().toMSec()));
+      robot_.throwOnMotionError(robot_state, motion_id_);
+      allocation_tracking.endCycle();
     }
   }
-  if (limit_rate_) {
-    control_output.tau_J = limitRate(kMaxTorqueRate, control_output.tau_J, robot_state.tau_J_d);
+  robot_.finishMotion(motion_id_, &motion_command, &control_command);
+}
+
+template <typename T>
+void ControlLoop<T>::estimateJointState(RobotState* robot_state, Duration time_step) noexcept {
+  if (joint_state_estimator_) {
+    joint_state_estimator_->update(robot_state, time_step);
+  }
+  if (momentum_observer_ != nullptr) {
+    momentum_observer_->update(*momentum_observer_model_, robot_state, time_step);
+  }
+  if (state_prediction_model_ != nullptr) {
+    transport_delay_.update(*robot_state, time_step);
+    double horizon = static_cast<double>(transport_delay_.lastGap()) * kDeltaT +
+                     transport_delay_.predictedDelay();
+    predictJointState(*state_prediction_model_, horizon, robot_state);
   }
-  command->tau_J_d = control_output.tau_J;
-  checkFinite(command->tau_J_d);
-  return !control_output.motion_finished;
+}
+
+template <typename T>
+bool ControlLoop<T>::spinControl(const RobotState& robot_state,
+                                 franka::Duration time_step,
+                                 research_interface::robot::ControllerCommand* command) {
+  ScopedStageTimer callback_timer(statistics_, ControlStatisticsRecorder::Stage::kControlCallback);
+  TraceScope callback_trace("ControlLoop::controlCallback");
+  Torques control_output = control_deadline_worker_
+                               ? callControlWithDeadline(robot_state, time_step)
+                               : control_callback_(robot_state, time_step);
+  callback_trace.stop();
+  callback_timer.stop();
+
+  ScopedStageTimer processing_timer(statistics_,
+                                    ControlStatisticsRecorder::Stage::kControlCommandProcessing);
+  return convertControl(control_output, robot_state.tau_J_d, robot_state.dq, time_step, command);
+}
+
+template <typename T>
+bool ControlLoop<T>::spinControl(const RobotStateView& robot_state,
+                                 franka::Duration time_step,
+                                 research_interface::robot::ControllerCommand* command) {
+  ScopedStageTimer callback_timer(statistics_, ControlStatisticsRecorder::Stage::kControlCallback);
+  TraceScope callback_trace("ControlLoop::controlCallback");
+  Torques control_output = control_view_callback_(robot_state, time_step);
+  callback_trace.stop();
+  callback_timer.stop();
+
+  ScopedStageTimer processing_timer(statistics_,
+                                    ControlStatisticsRecorder::Stage::kControlCommandProcessing);
+  return convertControl(control_output, robot_state.tau_J_d(), robot_state.dq(), time_step,
+                        command);
 }
 
 template <typename T>
 bool ControlLoop<T>::spinMotion(const RobotState& robot_state,
                                 franka::Duration time_step,
                                 research_interface::robot::MotionGeneratorCommand* command) {
-  T motion_output = motion_callback_(robot_state, time_step);
+  ScopedStageTimer callback_timer(statistics_, ControlStatisticsRecorder::Stage::kMotionCallback);
+  TraceScope callback_trace("ControlLoop::motionCallback");
+  T motion_output = motion_deadline_worker_
+                        ? callMotionWithDeadline(robot_state, time_step, *command)
+                        : motion_callback_(robot_state, time_step);
+  callback_trace.stop();
+  callback_timer.stop();
+
+  ScopedStageTimer processing_timer(statistics_,
+                                    ControlStatisticsRecorder::Stage::kMotionCommandProcessing);
   convertMotion(motion_output, robot_state, command);
   return !motion_output.motion_finished;
 }
 
+template <typename T>
+bool ControlLoop<T>::spinMotion(const RobotStateView& robot_state,
+                                franka::Duration time_step,
+                                research_interface::robot::MotionGeneratorCommand* command) {
+  ScopedStageTimer callback_timer(statistics_, ControlStatisticsRecorder::Stage::kMotionCallback);
+  TraceScope callback_trace("ControlLoop::motionCallback");
+  T motion_output = motion_view_callback_(robot_state, time_step);
+  callback_trace.stop();
+  callback_timer.stop();
+
+  ScopedStageTimer processing_timer(statistics_,
+                                    ControlStatisticsRecorder::Stage::kMotionCommandProcessing);
+  copyCommandFeedback(robot_state, &command_feedback_);
+  convertMotion(motion_output, command_feedback_, command);
+  return !motion_output.motion_finished;
+}
+
+template <typename T>
+Torques ControlLoop<T>::callControlWithDeadline(const RobotState& robot_state,
+                                                Duration time_step) {
+  Torques control_output(robot_state.tau_J_d);
+  DeadlineResult result = control_deadline_worker_->call(robot_state, time_step, &control_output);
+  if (result != DeadlineResult::kOnTime && deadline_->fallback == DeadlineFallback::kDecayTorque) {
+    // Commanded torques exclude gravity, so decaying them leaves only gravity compensation.
+    for (double& tau : control_output.tau_J) {
+      tau *= deadline_->torque_decay;
+    }
+  }
+  recordDeadline(result);
+  return control_output;
+}
+
+template <typename T>
+T ControlLoop<T>::callMotionWithDeadline(
+    const RobotState& robot_state,
+    Duration time_step,
+    const research_interface::robot::MotionGeneratorCommand& command) {
+  T motion_output = holdMotion<T>(robot_state, command.valid_elbow);
+  recordDeadline(motion_deadline_worker_->call(robot_state, time_step, &motion_output));
+  return motion_output;
+}
+
+template <typename T>
+void ControlLoop<T>::recordDeadline(DeadlineResult result) {
+  deadline_statistics_->cycles++;
+  if (result == DeadlineResult::kOnTime) {
+    consecutive_deadline_misses_ = 0;
+    return;
+  }
+
+  consecutive_deadline_misses_++;
+  deadline_statistics_->misses++;
+  if (result == DeadlineResult::kBusy) {
+    deadline_statistics_->skipped_states++;
+  }
+  deadline_statistics_->max_consecutive_misses =
+      std::max(deadline_statistics_->max_consecutive_misses, consecutive_deadline_misses_);
+  Tracing::counter("ControlLoop::deadlineMisses",
+                   static_cast<int64_t>(consecutive_deadline_misses_));
+  if (consecutive_deadline_misses_ >= deadline_->max_consecutive_misses) {
+    throw ControlException("libfranka: Callback missed its deadline in "s +
+                           std::to_string(consecutive_deadline_misses_) + " consecutive cycles.");
+  }
+}
+
+template <typename T>
+bool ControlLoop<T>::convertControl(Torques control_output,
+                                    const std::array<double, 7>& tau_J_d,
+                                    const std::array<double, 7>& dq,
+                                    Duration time_step,
+                                    research_interface::robot::ControllerCommand* command) {
+  if (torque_butterworth_filter_) {
+    control_output.tau_J = torque_butterworth_filter_->filter(control_output.tau_J);
+  } else if (filter_torques_) {
+    control_output.tau_J =
+        filterCommand(validation_policy_, torque_filter_, control_output.tau_J, tau_J_d);
+  }
+  if (passivity_controller_ != nullptr) {
+    control_output.tau_J =
+        passivity_controller_->control(control_output.tau_J, tau_J_d, dq, time_step);
+  }
+  if (limit_rate_) {
+    std::array<double, 7> limited = limitRate(kMaxTorqueRate, control_output.tau_J, tau_J_d);
+    recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kTorqueRate,
+                   control_output.tau_J, limited);
+    control_output.tau_J = limited;
+  }
+  command->tau_J_d = control_output.tau_J;
+  checkFinite(validation_policy_, command->tau_J_d);
+  return !control_output.motion_finished;
+}
+
 template <>
 void ControlLoop<JointPositions>::convertMotion(
     const JointPositions& motion,
     const RobotState& robot_state,
     research_interface::robot::MotionGeneratorCommand* command) {
   command->q_c = motion.q;
-  if (cutoff_frequency_ < kMaxCutoffFrequency) {
-    for (size_t i = 0; i < 7; i++) {
-      command->q_c[i] =
-          lowpassFilter(kDeltaT, command->q_c[i], robot_state.q_d[i], cutoff_frequency_);
-    }
+  if (filter_joints_) {
+    command->q_c = filterCommand(validation_policy_, joint_filter_, command->q_c, robot_state.q_d);
   }
-  if (limit_rate_) {
-    command->q_c = limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, command->q_c,
-                             robot_state.q_d, robot_state.dq_d, robot_state.ddq_d);
+  if (trajectory_generator_) {
+    checkFinite(validation_policy_, command->q_c);
+    std::array<double, 7> generated = trajectory_generator_->nextPosition(
+        command->q_c, robot_state.q_d, robot_state.dq_d, robot_state.ddq_d);
+    recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kJointMotion,
+                   command->q_c, generated);
+    command->q_c = generated;
+  } else if (limit_rate_) {
+    std::array<double, 7> limited =
+        limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, command->q_c,
+                  robot_state.q_d, robot_state.dq_d, robot_state.ddq_d);
+    recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kJointMotion,
+                   command->q_c, limited);
+    command->q_c = limited;
   }
-  checkFinite(command->q_c);
+  checkFinite(validation_policy_, command->q_c);
 }
 
 template <>
@@ -210,17 +599,26 @@ void ControlLoop<JointVelocities>::convertMotion(
     const RobotState& robot_state,
     research_interface::robot::MotionGeneratorCommand* command) {
   command->dq_c = motion.dq;
-  if (cutoff_frequency_ < kMaxCutoffFrequency) {
-    for (size_t i = 0; i < 7; i++) {
-      command->dq_c[i] =
-          lowpassFilter(kDeltaT, command->dq_c[i], robot_state.dq_d[i], cutoff_frequency_);
-    }
+  if (filter_joints_) {
+    command->dq_c =
+        filterCommand(validation_policy_, joint_filter_, command->dq_c, robot_state.dq_d);
   }
-  if (limit_rate_) {
-    command->dq_c = limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk,
-                              command->dq_c, robot_state.dq_d, robot_state.ddq_d);
+  if (trajectory_generator_) {
+    checkFinite(validation_policy_, command->dq_c);
+    std::array<double, 7> generated =
+        trajectory_generator_->nextVelocity(command->dq_c, robot_state.dq_d, robot_state.ddq_d);
+    recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kJointMotion,
+                   command->dq_c, generated);
+    command->dq_c = generated;
+  } else if (limit_rate_) {
+    std::array<double, 7> limited =
+        limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, command->dq_c,
+                  robot_state.dq_d, robot_state.ddq_d);
+    recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kJointMotion,
+                   command->dq_c, limited);
+    command->dq_c = limited;
   }
-  checkFinite(command->dq_c);
+  checkFinite(validation_policy_, command->dq_c);
 }
 
 template <>
@@ -229,32 +627,40 @@ void ControlLoop<CartesianPose>::convertMotion(
     const RobotState& robot_state,
     research_interface::robot::MotionGeneratorCommand* command) {
   command->O_T_EE_c = motion.O_T_EE;
-  if (cutoff_frequency_ < kMaxCutoffFrequency) {
-    command->O_T_EE_c =
-        cartesianLowpassFilter(kDeltaT, command->O_T_EE_c, robot_state.O_T_EE_c, cutoff_frequency_);
+  if (filter_cartesian_) {
+    command->O_T_EE_c = filterCommand(validation_policy_, pose_filter_, command->O_T_EE_c,
+                                       robot_state.O_T_EE_c);
   }
 
   if (limit_rate_) {
-    command->O_T_EE_c = limitRate(
+    std::array<double, 16> limited = limitRate(
         kMaxTranslationalVelocity, kMaxTranslationalAcceleration, kMaxTranslationalJerk,
         kMaxRotationalVelocity, kMaxRotationalAcceleration, kMaxRotationalJerk, command->O_T_EE_c,
         robot_state.O_T_EE_c, robot_state.O_dP_EE_c, robot_state.O_ddP_EE_c);
+    if (limiting_statistics_ != nullptr) {
+      limiting_statistics_->recordPose(command->O_T_EE_c, limited);
+    }
+    command->O_T_EE_c = limited;
   }
-  checkMatrix(command->O_T_EE_c);
+  checkMatrix(validation_policy_, command->O_T_EE_c);
 
   if (motion.hasElbow()) {
     command->valid_elbow = true;
     command->elbow_c = motion.elbow;
-    if (cutoff_frequency_ < kMaxCutoffFrequency) {
-      command->elbow_c[0] =
-          lowpassFilter(kDeltaT, command->elbow_c[0], robot_state.elbow_c[0], cutoff_frequency_);
+    if (filter_elbow_) {
+      command->elbow_c[0] = filterCommand(validation_policy_, elbow_filter_,
+                                          std::array<double, 1>{{command->elbow_c[0]}},
+                                          std::array<double, 1>{{robot_state.elbow_c[0]}})[0];
     }
     if (limit_rate_) {
-      command->elbow_c[0] =
+      double limited =
           limitRate(kMaxElbowVelocity, kMaxElbowAcceleration, kMaxElbowJerk, command->elbow_c[0],
                     robot_state.elbow_c[0], robot_state.delbow_c[0], robot_state.ddelbow_c[0]);
+      recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kElbow,
+                     command->elbow_c[0], limited);
+      command->elbow_c[0] = limited;
     }
-    checkElbow(command->elbow_c);
+    checkElbow(validation_policy_, command->elbow_c);
   } else {
     command->valid_elbow = false;
     command->elbow_c = {};
@@ -267,33 +673,38 @@ void ControlLoop<CartesianVelocities>::convertMotion(
     const RobotState& robot_state,
     research_interface::robot::MotionGeneratorCommand* command) {
   command->O_dP_EE_c = motion.O_dP_EE;
-  if (cutoff_frequency_ < kMaxCutoffFrequency) {
-    for (size_t i = 0; i < 6; i++) {
-      command->O_dP_EE_c[i] = lowpassFilter(kDeltaT, command->O_dP_EE_c[i],
-                                            robot_state.O_dP_EE_c[i], cutoff_frequency_);
-    }
+  if (filter_cartesian_) {
+    command->O_dP_EE_c = filterCommand(validation_policy_, cartesian_filter_, command->O_dP_EE_c,
+                                        robot_state.O_dP_EE_c);
   }
   if (limit_rate_) {
-    command->O_dP_EE_c =
+    std::array<double, 6> limited =
         limitRate(kMaxTranslationalVelocity, kMaxTranslationalAcceleration, kMaxTranslationalJerk,
                   kMaxRotationalVelocity, kMaxRotationalAcceleration, kMaxRotationalJerk,
                   command->O_dP_EE_c, robot_state.O_dP_EE_c, robot_state.O_ddP_EE_c);
+    recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kCartesianMotion,
+                   command->O_dP_EE_c, limited);
+    command->O_dP_EE_c = limited;
   }
-  checkFinite(command->O_dP_EE_c);
+  checkFinite(validation_policy_, command->O_dP_EE_c);
 
   if (motion.hasElbow()) {
     command->valid_elbow = true;
     command->elbow_c = motion.elbow;
-    if (cutoff_frequency_ < kMaxCutoffFrequency) {
-      command->elbow_c[0] =
-          lowpassFilter(kDeltaT, command->elbow_c[0], robot_state.elbow_c[0], cutoff_frequency_);
+    if (filter_elbow_) {
+      command->elbow_c[0] = filterCommand(validation_policy_, elbow_filter_,
+                                          std::array<double, 1>{{command->elbow_c[0]}},
+                                          std::array<double, 1>{{robot_state.elbow_c[0]}})[0];
     }
     if (limit_rate_) {
-      command->elbow_c[0] =
+      double limited =
           limitRate(kMaxElbowVelocity, kMaxElbowAcceleration, kMaxElbowJerk, command->elbow_c[0],
                     robot_state.elbow_c[0], robot_state.delbow_c[0], robot_state.ddelbow_c[0]);
+      recordLimiting(limiting_statistics_, LimitingStatisticsRecorder::Stage::kElbow,
+                     command->elbow_c[0], limited);
+      command->elbow_c[0] = limited;
     }
-    checkElbow(command->elbow_c);
+    checkElbow(validation_policy_, command->elbow_c);
   } else {
     command->valid_elbow = false;
     command->elbow_c = {};
@@ -4,12 +4,24 @@
 
 #include <cmath>
 #include <functional>
+#include <memory>
 
+#include <franka/butterworth_filter.h>
+#include <franka/callback_deadline.h>
 #include <franka/control_types.h>
 #include <franka/duration.h>
+#include <franka/filter_configuration.h>
+#include <franka/joint_state_estimator.h>
+#include <franka/lowpass_filter.h>
+#include <franka/momentum_observer.h>
+#include <franka/online_trajectory_generator.h>
+#include <franka/passivity_controller.h>
 #include <franka/robot_state.h>
+#include <franka/robot_state_view.h>
+#include <franka/state_prediction.h>
 #include <research_interface/robot/rbk_types.h>
 
+#include "deadline_worker.h"
 #include "robot_control.h"
 
 namespace franka {
@@ -22,26 +34,42 @@ class ControlLoop {
 
   using ControlCallback = std::function<Torques(const RobotState&, franka::Duration)>;
   using MotionGeneratorCallback = std::function<T(const RobotState&, franka::Duration)>;
+  using ControlViewCallback = std::function<Torques(const RobotStateView&, franka::Duration)>;
+  using MotionGeneratorViewCallback = std::function<T(const RobotStateView&, franka::Duration)>;
 
   ControlLoop(RobotControl& robot,
               ControlCallback control_callback,
               MotionGeneratorCallback motion_callback,
               bool limit_rate,
-              double cutoff_frequency);
+              const FilterConfiguration& filter_configuration);
   ControlLoop(RobotControl& robot,
               ControllerMode controller_mode,
               MotionGeneratorCallback motion_callback,
               bool limit_rate,
-              double cutoff_frequency);
+              const FilterConfiguration& filter_configuration);
+  ControlLoop(RobotControl& robot,
+              ControlViewCallback control_callback,
+              MotionGeneratorViewCallback motion_callback,
+              bool limit_rate,
+              const FilterConfiguration& filter_configuration);
 
   void operator()();
 
+  /**
+   * Filters torque commands with the given filter instead of the first-order low-pass filter.
+   *
+   * The loop keeps its own copy of the filter, which starts from the first commanded torques.
+   *
+   * @param[in] filter Torque command filter.
+   */
+  void setTorqueFilter(const ButterworthFilter<7>& filter);
+
  protected:
   ControlLoop(RobotControl& robot,
               MotionGeneratorCallback motion_callback,
               ControlCallback control_callback,
               bool limit_rate,
-              double cutoff_frequency);
+              const FilterConfiguration& filter_configuration);
 
   bool spinControl(const RobotState& robot_state,
                    franka::Duration time_step,
@@ -49,15 +77,69 @@ class ControlLoop {
   bool spinMotion(const RobotState& robot_state,
                   franka::Duration time_step,
                   research_interface::robot::MotionGeneratorCommand* command);
+  bool spinControl(const RobotStateView& robot_state,
+                   franka::Duration time_step,
+                   research_interface::robot::ControllerCommand* command);
+  bool spinMotion(const RobotStateView& robot_state,
+                  franka::Duration time_step,
+                  research_interface::robot::MotionGeneratorCommand* command);
+
+  // Calls the callbacks on their deadline workers, and returns the fallback command if they miss
+  // their deadline.
+  Torques callControlWithDeadline(const RobotState& robot_state, Duration time_step);
+  T callMotionWithDeadline(const RobotState& robot_state,
+                           Duration time_step,
+                           const research_interface::robot::MotionGeneratorCommand& command);
+  void recordDeadline(DeadlineResult result);
+
+  // Runs the optional joint state estimation and prediction on a received state.
+  void estimateJointState(RobotState* robot_state, Duration time_step) noexcept;
+  bool convertControl(Torques control_output,
+                      const std::array<double, 7>& tau_J_d,
+                      const std::array<double, 7>& dq,
+                      Duration time_step,
+                      research_interface::robot::ControllerCommand* command);
 
  private:
   RobotControl& robot_;
-  const MotionGeneratorCallback motion_callback_;  // NOLINT(readability-identifier-naming)
-  const ControlCallback control_callback_;         // NOLINT(readability-identifier-naming)
-  const bool limit_rate_;                          // NOLINT(readability-identifier-naming)
-  const double cutoff_frequency_;                  // NOLINT(readability-identifier-naming)
+  const MotionGeneratorCallback motion_callback_;           // NOLINT(readability-identifier-naming)
+  const ControlCallback control_callback_;                  // NOLINT(readability-identifier-naming)
+  const MotionGeneratorViewCallback motion_view_callback_;  // NOLINT(readability-identifier-naming)
+  const ControlViewCallback control_view_callback_;         // NOLINT(readability-identifier-naming)
+  const bool limit_rate_;                                   // NOLINT(readability-identifier-naming)
+  const ValidationPolicy validation_policy_;                // NOLINT(readability-identifier-naming)
+  const bool filter_torques_;                               // NOLINT(readability-identifier-naming)
+  const bool filter_joints_;                                // NOLINT(readability-identifier-naming)
+  const bool filter_cartesian_;                             // NOLINT(readability-identifier-naming)
+  const bool filter_elbow_;                                 // NOLINT(readability-identifier-naming)
+  const LowpassFilter<7> torque_filter_;                    // NOLINT(readability-identifier-naming)
+  const LowpassFilter<7> joint_filter_;                     // NOLINT(readability-identifier-naming)
+  const LowpassFilter<6> cartesian_filter_;                 // NOLINT(readability-identifier-naming)
+  const LowpassFilter<1> elbow_filter_;                     // NOLINT(readability-identifier-naming)
+  CartesianPoseLowpassFilter pose_filter_;
+  std::unique_ptr<ButterworthFilter<7>> torque_butterworth_filter_;
   uint32_t motion_id_ = 0;
+  ControlStatisticsRecorder* statistics_ = nullptr;
+  LimitingStatisticsRecorder* limiting_statistics_ = nullptr;
+  std::unique_ptr<JointStateEstimator> joint_state_estimator_;
+  const Model* state_prediction_model_ = nullptr;
+  MomentumObserver* momentum_observer_ = nullptr;
+  const Model* momentum_observer_model_ = nullptr;
+  TransportDelayEstimator transport_delay_;
+  PassivityController* passivity_controller_ = nullptr;
+  std::unique_ptr<OnlineTrajectoryGenerator> trajectory_generator_;
+  const CallbackDeadline* deadline_ = nullptr;
+  DeadlineStatistics* deadline_statistics_ = nullptr;
+  uint64_t consecutive_deadline_misses_ = 0;
+  // Declared after the callbacks, so that the workers stop before the callbacks are destroyed.
+  std::unique_ptr<DeadlineWorker<Torques>> control_deadline_worker_;
+  std::unique_ptr<DeadlineWorker<T>> motion_deadline_worker_;
+
+  // Holds the fields of the last received state that are needed for filtering and rate limiting
+  // when running with view callbacks.
+  RobotState command_feedback_{};
 
+  void loopWithView();
   void convertMotion(const T& motion,
                      const RobotState& robot_state,
                      research_interface::robot::MotionGeneratorCommand* command);
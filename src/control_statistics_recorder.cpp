@@ -0,0 +1,136 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "control_statistics_recorder.h"
+
+#include <algorithm>
+
+#include "metrics_writer.h"
+
+namespace franka {
+
+constexpr size_t LatencyHistogram::kBins;
+constexpr std::chrono::microseconds ControlStatisticsRecorder::kDeadline;
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) noexcept {
+  int64_t duration_ns = std::max<int64_t>(duration.count(), 0);
+  size_t bin = std::min(static_cast<size_t>(duration_ns / 1000), kBins);
+  bins_[bin]++;
+
+  if (count_ == 0) {
+    min_ns_ = duration_ns;
+    max_ns_ = duration_ns;
+  } else {
+    min_ns_ = std::min(min_ns_, duration_ns);
+    max_ns_ = std::max(max_ns_, duration_ns);
+  }
+  sum_ns_ += duration_ns;
+  count_++;
+}
+
+LatencyStatistics LatencyHistogram::statistics() const noexcept {
+  LatencyStatistics statistics;
+  if (count_ == 0) {
+    return statistics;
+  }
+
+  statistics.count = count_;
+  statistics.min = min_ns_ / 1e3;
+  statistics.max = max_ns_ / 1e3;
+  statistics.mean = static_cast<double>(sum_ns_) / static_cast<double>(count_) / 1e3;
+
+  statistics.p50 = percentile(500, statistics.max);
+  statistics.p99 = percentile(990, statistics.max);
+  statistics.p999 = percentile(999, statistics.max);
+  return statistics;
+}
+
+double LatencyHistogram::percentile(uint64_t per_mille, double max) const noexcept {
+  // Smallest bin upper bound below which at least the given share of all samples lie.
+  uint64_t threshold = (count_ * per_mille + 999) / 1000;
+  uint64_t accumulated = 0;
+  for (size_t i = 0; i < kBins; i++) {
+    accumulated += bins_[i];
+    if (accumulated >= threshold) {
+      return std::min(static_cast<double>(i + 1), max);
+    }
+  }
+  return max;
+}
+
+void LatencyHistogram::reset() noexcept {
+  bins_.fill(0);
+  count_ = 0;
+  sum_ns_ = 0;
+  min_ns_ = 0;
+  max_ns_ = 0;
+}
+
+void ControlStatisticsRecorder::record(Stage stage, Clock::duration duration) noexcept {
+  if (collects()) {
+    histograms_[static_cast<size_t>(stage)].record(duration);
+  }
+  if (metrics_ != nullptr) {
+    recordMetricsLatency(*metrics_, static_cast<size_t>(stage), duration);
+  }
+}
+
+void ControlStatisticsRecorder::recordCycle(Clock::duration duration) noexcept {
+  record(Stage::kCycle, duration);
+  if (duration <= kDeadline) {
+    return;
+  }
+  if (collects()) {
+    deadline_misses_++;
+  }
+  if (metrics_ != nullptr) {
+    incrementMetric(metrics_->deadline_misses);
+  }
+}
+
+ControlStatistics ControlStatisticsRecorder::statistics() const noexcept {
+  auto get = [this](Stage stage) { return histograms_[static_cast<size_t>(stage)].statistics(); };
+
+  ControlStatistics statistics;
+  statistics.receive_state = get(Stage::kReceiveState);
+  statistics.motion_callback = get(Stage::kMotionCallback);
+  statistics.control_callback = get(Stage::kControlCallback);
+  statistics.motion_command_processing = get(Stage::kMotionCommandProcessing);
+  statistics.control_command_processing = get(Stage::kControlCommandProcessing);
+  statistics.send_command = get(Stage::kSendCommand);
+  statistics.cycle = get(Stage::kCycle);
+  statistics.receive_wakeup = get(Stage::kReceiveWakeup);
+  statistics.network_cycle = get(Stage::kNetworkCycle);
+  statistics.deadline_misses = deadline_misses_;
+  return statistics;
+}
+
+void ControlStatisticsRecorder::reset() noexcept {
+  for (LatencyHistogram& histogram : histograms_) {
+    histogram.reset();
+  }
+  deadline_misses_ = 0;
+}
+
+std::ostream& operator<<(std::ostream& ostream, const LatencyStatistics& statistics) {
+  ostream << "{\"min\": " << statistics.min << ", \"mean\": " << statistics.mean
+          << ", \"p50\": " << statistics.p50 << ", \"p99\": " << statistics.p99
+          << ", \"p999\": " << statistics.p999 << ", \"max\": " << statistics.max
+          << ", \"count\": " << statistics.count << "}";
+  return ostream;
+}
+
+std::ostream& operator<<(std::ostream& ostream, const ControlStatistics& statistics) {
+  ostream << "{\"receive_state\": " << statistics.receive_state
+          << ", \"motion_callback\": " << statistics.motion_callback
+          << ", \"control_callback\": " << statistics.control_callback
+          << ", \"motion_command_processing\": " << statistics.motion_command_processing
+          << ", \"control_command_processing\": " << statistics.control_command_processing
+          << ", \"send_command\": " << statistics.send_command
+          << ", \"cycle\": " << statistics.cycle
+          << ", \"receive_wakeup\": " << statistics.receive_wakeup
+          << ", \"network_cycle\": " << statistics.network_cycle
+          << ", \"deadline_misses\": " << statistics.deadline_misses << "}";
+  return ostream;
+}
+
+}  // namespace franka
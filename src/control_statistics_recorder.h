@@ -0,0 +1,126 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <franka/control_statistics.h>
+#include <franka/shared_memory_metrics.h>
+
+namespace franka {
+
+/**
+ * Fixed-size latency histogram with a resolution of one microsecond.
+ *
+ * Durations longer than the histogram range still contribute to min, mean and max.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kBins = 4096;
+
+  void record(std::chrono::nanoseconds duration) noexcept;
+  LatencyStatistics statistics() const noexcept;
+  void reset() noexcept;
+
+ private:
+  // Percentile in microseconds, or max if it lies beyond the histogram range.
+  double percentile(uint64_t per_mille, double max) const noexcept;
+
+  std::array<uint32_t, kBins + 1> bins_{};
+  uint64_t count_{0};
+  int64_t sum_ns_{0};
+  int64_t min_ns_{0};
+  int64_t max_ns_{0};
+};
+
+/**
+ * Collects per-stage timings of the control loop without allocating.
+ *
+ * Timings are also forwarded to a metrics segment if one is set, even if the recorder itself is
+ * disabled.
+ */
+class ControlStatisticsRecorder {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Stage : size_t {
+    kReceiveState,
+    kMotionCallback,
+    kControlCallback,
+    kMotionCommandProcessing,
+    kControlCommandProcessing,
+    kSendCommand,
+    kCycle,
+    kReceiveWakeup,
+    kNetworkCycle,
+    kCount
+  };
+
+  static constexpr std::chrono::microseconds kDeadline{1000};
+
+  void setEnabled(bool enabled) noexcept { enabled_ = enabled; }
+  bool enabled() const noexcept { return enabled_; }
+
+  void setMetrics(MetricsSegment* metrics) noexcept { metrics_ = metrics; }
+
+  /**
+   * @return True if timings need to be measured, i.e. if enabled or a metrics segment is set.
+   */
+  bool active() const noexcept { return enabled_ || metrics_ != nullptr; }
+
+  void record(Stage stage, Clock::duration duration) noexcept;
+  void recordCycle(Clock::duration duration) noexcept;
+
+  ControlStatistics statistics() const noexcept;
+  void reset() noexcept;
+
+ private:
+  // A disabled recorder is only used if it forwards to a metrics segment, in which case it must
+  // not collect statistics itself.
+  bool collects() const noexcept { return enabled_ || metrics_ == nullptr; }
+
+  static_assert(static_cast<size_t>(Stage::kCount) == kMetricsStages,
+                "ControlStatisticsRecorder: Stages do not match the metrics segment.");
+
+  bool enabled_{false};
+  MetricsSegment* metrics_{nullptr};
+  std::array<LatencyHistogram, static_cast<size_t>(Stage::kCount)> histograms_{};
+  uint64_t deadline_misses_{0};
+};
+
+/**
+ * Records the time until stop() is called or the timer goes out of scope into the given stage.
+ *
+ * Does nothing if no recorder is given.
+ */
+class ScopedStageTimer {
+ public:
+  ScopedStageTimer(ControlStatisticsRecorder* recorder,
+                   ControlStatisticsRecorder::Stage stage) noexcept
+      : recorder_(recorder), stage_(stage) {
+    if (recorder_ != nullptr) {
+      start_ = ControlStatisticsRecorder::Clock::now();
+    }
+  }
+  ~ScopedStageTimer() { stop(); }
+
+  ScopedStageTimer(const ScopedStageTimer&) = delete;
+  ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+  void stop() noexcept {
+    if (recorder_ != nullptr) {
+      recorder_->record(stage_, ControlStatisticsRecorder::Clock::now() - start_);
+      recorder_ = nullptr;
+    }
+  }
+
+ private:
+  ControlStatisticsRecorder* recorder_;
+  const ControlStatisticsRecorder::Stage stage_;  // NOLINT(readability-identifier-naming)
+  ControlStatisticsRecorder::Clock::time_point start_{};
+};
+
+}  // namespace franka
@@ -2,17 +2,29 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka/control_tools.h>
 
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "platform.h"
 
 #ifdef LIBFRANKA_WINDOWS
 #include <Windows.h>
 #else
+#include <alloca.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
 #endif
 
 // `using std::string_literals::operator""s` produces a GCC warning that cannot be disabled, so we
@@ -33,6 +45,35 @@ bool hasRealtimeKernel() {
 #endif
 }
 
+std::vector<int> isolatedCpus() {
+  std::vector<int> cpus;
+#ifndef LIBFRANKA_WINDOWS
+  // The list has the format of cpulist, e.g. "2-3,6".
+  std::ifstream isolated("/sys/devices/system/cpu/isolated", std::ios_base::in);
+  std::string list;
+  std::getline(isolated, list);
+  std::istringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    int first;
+    int last;
+    char separator;
+    std::istringstream range_stream(range);
+    if (!(range_stream >> first)) {
+      continue;
+    }
+    last = first;
+    if (range_stream >> separator >> last && separator != '-') {
+      continue;
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+#endif
+  return cpus;
+}
+
 bool setCurrentThreadToHighestSchedulerPriority(std::string* error_message) {
 #ifdef LIBFRANKA_WINDOWS
   auto get_last_windows_error = []() -> std::string {
@@ -83,4 +124,157 @@ bool setCurrentThreadToHighestSchedulerPriority(std::string* error_message) {
 #endif
 }
 
+namespace {
+
+#ifndef LIBFRANKA_WINDOWS
+size_t pageSize() {
+  long page_size = sysconf(_SC_PAGESIZE);
+  return page_size > 0 ? static_cast<size_t>(page_size) : 4096;
+}
+
+// Stack left untouched below the prefaulted part, for the frames of callees and signal handlers.
+constexpr size_t kStackReserve = 64 * 1024;
+
+// Returns the number of bytes of stack below the current frame, or 0 if it is unknown.
+size_t availableStack() {
+#ifdef __GLIBC__
+  pthread_attr_t attributes;
+  if (pthread_getattr_np(pthread_self(), &attributes) != 0) {
+    return 0;
+  }
+  void* stack_address = nullptr;
+  size_t stack_size = 0;
+  int error = pthread_attr_getstack(&attributes, &stack_address, &stack_size);
+  pthread_attr_destroy(&attributes);
+  if (error != 0) {
+    return 0;
+  }
+  volatile uint8_t marker = 0;
+  auto current = reinterpret_cast<uintptr_t>(&marker);
+  auto lowest = reinterpret_cast<uintptr_t>(stack_address);
+  return current > lowest ? current - lowest : 0;
+#else
+  return 0;
+#endif
+}
+
+// Not inlined, so that the stack is released again when returning.
+__attribute__((noinline)) bool prefaultStack(size_t size) {
+  size_t available = availableStack();
+  if (available < kStackReserve || size > available - kStackReserve) {
+    return false;
+  }
+  volatile uint8_t* stack = static_cast<volatile uint8_t*>(alloca(size));
+  const size_t page_size = pageSize();
+  for (size_t i = 0; i < size; i += page_size) {
+    stack[i] = 0;
+  }
+  return true;
+}
+
+bool prefaultHeap(size_t size) {
+#ifdef __GLIBC__
+  // Keep freed memory inside the process instead of returning it to the system. This changes the
+  // allocator of the whole process for good, so it is only done once.
+  static const bool kMallocConfigured = []() {
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    return true;
+  }();
+  static_cast<void>(kMallocConfigured);
+#endif
+  auto* heap = static_cast<volatile uint8_t*>(std::malloc(size));
+  if (heap == nullptr) {
+    return false;
+  }
+  const size_t page_size = pageSize();
+  for (size_t i = 0; i < size; i += page_size) {
+    heap[i] = 0;
+  }
+  std::free(const_cast<uint8_t*>(heap));
+  return true;
+}
+#endif
+
+void appendError(std::string* error_message, const std::string& error) {
+  if (error_message == nullptr) {
+    return;
+  }
+  if (!error_message->empty()) {
+    *error_message += " ";
+  }
+  *error_message += error;
+}
+
+}  // anonymous namespace
+
+bool applyRealtimeOptions(const RealtimeOptions& options,
+                          RealtimeOptionsResult* result,
+                          std::string* error_message) {
+  RealtimeOptionsResult applied;
+  bool success = true;
+
+#ifdef LIBFRANKA_WINDOWS
+  if (!options.cpu_affinity.empty() || options.lock_memory || options.prefault_stack_size > 0 ||
+      options.prefault_heap_size > 0) {
+    appendError(error_message, "libfranka: realtime options are not supported on Windows.");
+    success = false;
+  }
+#else
+  if (!options.cpu_affinity.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    bool valid = true;
+    for (int cpu : options.cpu_affinity) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        valid = false;
+        break;
+      }
+      CPU_SET(cpu, &cpu_set);
+    }
+    int error = valid ? pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) : EINVAL;
+    if (error == 0) {
+      applied.cpu_affinity_set = true;
+    } else {
+      appendError(error_message, "libfranka: unable to set CPU affinity: "s + std::strerror(error));
+      success = false;
+    }
+  }
+
+  if (options.lock_memory) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+      applied.memory_locked = true;
+    } else {
+      appendError(error_message, "libfranka: unable to lock memory: "s + std::strerror(errno));
+      success = false;
+    }
+  }
+
+  if (options.prefault_stack_size > 0) {
+    if (prefaultStack(options.prefault_stack_size)) {
+      applied.stack_prefaulted = true;
+    } else {
+      appendError(error_message,
+                  "libfranka: unable to prefault stack, the requested size exceeds the stack of "
+                  "the current thread.");
+      success = false;
+    }
+  }
+
+  if (options.prefault_heap_size > 0) {
+    if (prefaultHeap(options.prefault_heap_size)) {
+      applied.heap_prefaulted = true;
+    } else {
+      appendError(error_message, "libfranka: unable to prefault heap memory.");
+      success = false;
+    }
+  }
+#endif
+
+  if (result != nullptr) {
+    *result = applied;
+  }
+  return success;
+}
+
 }  // namespace franka
@@ -0,0 +1,120 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/controller_plugin.h>
+
+#include <memory>
+#include <string>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/SharedLibrary.h>
+#include <Poco/TemporaryFile.h>
+
+#include <franka/exception.h>
+
+#include "library_loader.h"
+
+using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+
+namespace franka {
+
+class ControllerPlugin::Impl {
+ public:
+  Impl(const std::string& path, const std::string& parameters, size_t output_size)
+      : path_(path), library_(copyLibrary(path, library_file_)) {
+    FrankaControllerPluginEntry entry;
+    try {
+      entry = reinterpret_cast<FrankaControllerPluginEntry>(
+          library_->getSymbol(FRANKA_CONTROLLER_PLUGIN_ENTRY));
+    } catch (const ModelException& e) {
+      throw PluginException(e.what());
+    }
+
+    plugin_ = entry();
+    if (plugin_ == nullptr || plugin_->api_version != FRANKA_CONTROLLER_PLUGIN_API_VERSION) {
+      throw PluginException("libfranka: Controller plugin "s + path +
+                            " was built for another plugin interface version.");
+    }
+    if (plugin_->robot_state_size != sizeof(RobotState)) {
+      throw PluginException("libfranka: Controller plugin "s + path +
+                            " was built for another robot state.");
+    }
+    if (plugin_->output_size != output_size) {
+      throw PluginException("libfranka: Controller plugin "s + path + " has " +
+                            std::to_string(plugin_->output_size) + " outputs instead of " +
+                            std::to_string(output_size) + ".");
+    }
+    if (plugin_->create == nullptr || plugin_->destroy == nullptr || plugin_->update == nullptr) {
+      throw PluginException("libfranka: Controller plugin "s + path + " is incomplete.");
+    }
+
+    controller_ = plugin_->create(parameters.c_str());
+    if (controller_ == nullptr) {
+      throw PluginException("libfranka: Controller plugin "s + path +
+                            " cannot create a controller with parameters \"" + parameters + "\".");
+    }
+  }
+
+  ~Impl() noexcept { plugin_->destroy(controller_); }
+
+  const std::string& path() const noexcept { return path_; }
+
+  void start(const RobotState& robot_state) {
+    if (plugin_->start != nullptr && plugin_->start(controller_, &robot_state) < 0) {
+      throw PluginException("libfranka: Controller plugin "s + path_ + " failed to start.");
+    }
+  }
+
+  bool update(const RobotState& robot_state, Duration period, double* output) {
+    int result = plugin_->update(controller_, &robot_state, period.toMSec(), output);
+    if (result < 0) {
+      throw PluginException("libfranka: Controller plugin "s + path_ + " reports an error.");
+    }
+    return result > 0;
+  }
+
+ private:
+  // Shared libraries are identified by their path, so a library that is loaded again from the
+  // same path would not pick up a rebuilt file.
+  static std::unique_ptr<LibraryLoader> copyLibrary(const std::string& path,
+                                                    Poco::TemporaryFile& library_file) try {
+    Poco::File(path).copyTo(library_file.path());
+    // With global symbols, a reloaded plugin would bind to the definitions of the first one,
+    // e.g. of inline member functions and templates, and keep running the old controller.
+    return std::make_unique<LibraryLoader>(library_file.path(), "controller plugin",
+                                           Poco::SharedLibrary::SHLIB_LOCAL);
+  } catch (const ModelException& e) {
+    throw PluginException(e.what());
+  } catch (const Poco::Exception& e) {
+    throw PluginException("libfranka: Cannot copy controller plugin "s + path + ": " +
+                          e.displayText());
+  }
+
+  const std::string path_;
+  // Declared before the loader, so that the library is unloaded before its file is deleted.
+  Poco::TemporaryFile library_file_;
+  std::unique_ptr<LibraryLoader> library_;
+  const FrankaControllerPlugin* plugin_{nullptr};
+  void* controller_{nullptr};
+};
+
+ControllerPlugin::ControllerPlugin(const std::string& path,
+                                   const std::string& parameters,
+                                   size_t output_size)
+    : impl_(new Impl(path, parameters, output_size)) {}
+
+ControllerPlugin::~ControllerPlugin() noexcept = default;
+
+const std::string& ControllerPlugin::path() const noexcept {
+  return impl_->path();
+}
+
+void ControllerPlugin::start(const RobotState& robot_state) {
+  impl_->start(robot_state);
+}
+
+bool ControllerPlugin::update(const RobotState& robot_state, Duration period, double* output) {
+  return impl_->update(robot_state, period, output);
+}
+
+}  // namespace franka
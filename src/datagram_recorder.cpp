@@ -0,0 +1,161 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/datagram_recorder.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <franka/exception.h>
+#include <research_interface/robot/rbk_types.h>
+#include <research_interface/robot/service_types.h>
+
+#include "datagram_recording.h"
+#include "platform.h"
+#include "spsc_queue.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <pthread.h>
+#endif
+
+namespace franka {
+
+namespace {
+
+constexpr auto kWriterPollInterval = std::chrono::milliseconds(1);
+
+constexpr size_t kMaxDatagramSize =
+    std::max(sizeof(research_interface::robot::RobotState),
+             sizeof(research_interface::robot::RobotCommand));
+
+struct Datagram {
+  DatagramRecordHeader header;
+  std::array<uint8_t, kMaxDatagramSize> data;
+};
+
+}  // anonymous namespace
+
+class DatagramRecorder::Impl {
+ public:
+  Impl(const std::string& path, size_t queue_capacity)
+      : queue_(queue_capacity), file_(path, std::ios::binary | std::ios::trunc) {
+    if (!file_) {
+      throw Exception("libfranka: Unable to open recording file " + path);
+    }
+    DatagramRecordingHeader header{};
+    std::memcpy(header.magic, kDatagramRecordingMagic, sizeof(kDatagramRecordingMagic));
+    header.version = DatagramRecorder::kFormatVersion;
+    header.protocol_version = research_interface::robot::kVersion;
+    header.state_size = sizeof(research_interface::robot::RobotState);
+    header.command_size = sizeof(research_interface::robot::RobotCommand);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writer_ = std::thread(&Impl::write, this);
+  }
+
+  ~Impl() noexcept { stop(); }
+
+  bool push(DatagramType type,
+            const uint8_t* data,
+            size_t size,
+            std::chrono::system_clock::time_point time) noexcept {
+    if (size > kMaxDatagramSize || !running_.load(std::memory_order_relaxed)) {
+      dropped_datagrams_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    datagram_.header.type = static_cast<uint32_t>(type);
+    datagram_.header.size = static_cast<uint32_t>(size);
+    datagram_.header.time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    std::memcpy(datagram_.data.data(), data, size);
+    if (!queue_.push(datagram_)) {
+      dropped_datagrams_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  void stop() noexcept {
+    if (running_.exchange(false)) {
+      writer_.join();
+      file_.close();
+    }
+  }
+
+  uint64_t writtenDatagrams() const noexcept {
+    return written_datagrams_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t droppedDatagrams() const noexcept {
+    return dropped_datagrams_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void write() noexcept {
+#ifdef LIBFRANKA_LINUX
+    // Do not inherit a realtime policy from the thread that created the recorder.
+    sched_param parameters{};
+    parameters.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &parameters);
+#endif
+    Datagram datagram;
+    while (true) {
+      bool running = running_.load();
+      size_t written = 0;
+      while (queue_.pop(&datagram)) {
+        file_.write(reinterpret_cast<const char*>(&datagram),
+                    static_cast<std::streamsize>(sizeof(datagram.header) + datagram.header.size));
+        written++;
+      }
+      written_datagrams_.fetch_add(written, std::memory_order_relaxed);
+      if (!running) {
+        break;
+      }
+      if (written == 0) {
+        file_.flush();
+        std::this_thread::sleep_for(kWriterPollInterval);
+      }
+    }
+    file_.flush();
+  }
+
+  SpscQueue<Datagram> queue_;
+  // Staging buffer of the producer, so that datagrams are not assembled on the stack.
+  Datagram datagram_;
+  std::ofstream file_;
+  std::thread writer_;
+  std::atomic<bool> running_{true};
+  std::atomic<uint64_t> written_datagrams_{0};
+  std::atomic<uint64_t> dropped_datagrams_{0};
+};
+
+constexpr uint32_t DatagramRecorder::kFormatVersion;
+
+DatagramRecorder::DatagramRecorder(const std::string& path, size_t queue_capacity)
+    : impl_(new Impl(path, queue_capacity)) {}
+
+DatagramRecorder::~DatagramRecorder() noexcept = default;
+
+void DatagramRecorder::stop() noexcept {
+  impl_->stop();
+}
+
+uint64_t DatagramRecorder::writtenDatagrams() const noexcept {
+  return impl_->writtenDatagrams();
+}
+
+uint64_t DatagramRecorder::droppedDatagrams() const noexcept {
+  return impl_->droppedDatagrams();
+}
+
+bool recordRawDatagram(DatagramRecorder& recorder,
+                       DatagramType type,
+                       const uint8_t* data,
+                       size_t size,
+                       std::chrono::system_clock::time_point time) noexcept {
+  return recorder.impl_->push(type, data, size, time);
+}
+
+}  // namespace franka
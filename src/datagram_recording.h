@@ -0,0 +1,29 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstdint>
+
+namespace franka {
+
+// File format shared by DatagramRecorder and DatagramReplay. See datagram_recorder.h.
+
+constexpr char kDatagramRecordingMagic[8] = {'F', 'R', 'A', 'N', 'K', 'U', 'D', 'P'};
+
+struct DatagramRecordingHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t protocol_version;
+  uint32_t state_size;
+  uint32_t command_size;
+};
+static_assert(sizeof(DatagramRecordingHeader) == 24, "Unexpected header size");
+
+struct DatagramRecordHeader {
+  uint32_t type;
+  uint32_t size;
+  int64_t time;
+};
+static_assert(sizeof(DatagramRecordHeader) == 16, "Unexpected record header size");
+
+}  // namespace franka
@@ -0,0 +1,403 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/datagram_replay.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <franka/datagram_recorder.h>
+#include <franka/exception.h>
+#include <research_interface/robot/rbk_types.h>
+#include <research_interface/robot/service_types.h>
+
+#include "command_server.h"
+#include "datagram_recording.h"
+#include "datagram_transport.h"
+#include "memory_mapped_file.h"
+#include "network.h"
+
+namespace franka {
+
+class DatagramReplay::Impl {
+ public:
+  Impl(const std::string& path, ReplaySpeed speed);
+
+  uint16_t port() const noexcept;
+  uint64_t recordedStates() const noexcept;
+  uint64_t replayedStates() const noexcept;
+  uint64_t divergentCommands() const noexcept;
+
+  // Datagram side of the replay, used from the thread of the connected robot.
+
+  // Returns true if the next state is due.
+  bool available() const noexcept;
+  // Waits until the next state is due, at most for the given timeout. At maximum speed, makes the
+  // next state due right away. Returns false if the timeout expired or the recording is exhausted.
+  bool wait(std::chrono::microseconds timeout);
+  // Takes the next state if it is due. Returns false otherwise.
+  bool pop(research_interface::robot::RobotState* robot_state,
+           std::chrono::system_clock::time_point* receive_time) noexcept;
+  // Compares a sent command to the recorded one. At maximum speed, makes the next state due.
+  void compare(const research_interface::robot::RobotCommand& robot_command) noexcept;
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+ private:
+  struct Record {
+    size_t offset;
+    int64_t time;
+  };
+
+  bool handleRequest(const research_interface::robot::CommandHeader& header,
+                     const std::vector<uint8_t>& message);
+  void handleDisconnect() noexcept;
+
+  // Returns the time at which the next state is due in real time. Must be called with mutex_ held.
+  std::chrono::steady_clock::time_point dueTimeUnsafe() const noexcept;
+  // Returns true if a next state exists and is due. Must be called with mutex_ held.
+  bool dueUnsafe() const noexcept;
+  // Answers a started motion once the recorded states show that it finished. Must be called with
+  // mutex_ held.
+  void trackMotionUnsafe(research_interface::robot::RobotMode robot_mode) noexcept;
+
+  const MemoryMappedFile file_;
+  const ReplaySpeed speed_;
+  std::vector<Record> states_;
+  std::vector<Record> commands_;
+
+  mutable std::mutex mutex_;
+  size_t next_state_{0};
+  size_t next_command_{0};
+  uint64_t divergent_commands_{0};
+  std::chrono::steady_clock::time_point start_time_{};
+  // At maximum speed, states are released one at a time whenever the robot sends a command or
+  // waits for a state, like the simulation produces them.
+  bool state_released_{false};
+
+  bool motion_running_{false};
+  bool motion_seen_{false};
+  uint32_t move_command_id_{0};
+
+  // Declared last, so that the server thread stops before the state it accesses is destroyed.
+  std::unique_ptr<CommandServer> server_;
+};
+
+namespace {
+
+// Exchanges states and commands with a replay in memory.
+class ReplayTransport : public DatagramTransport {
+ public:
+  explicit ReplayTransport(std::shared_ptr<DatagramReplay::Impl> replay)
+      : replay_(std::move(replay)) {}
+
+  uint16_t port() const noexcept override { return 0; }
+
+  bool available(size_t /* size */) override { return replay_->available(); }
+
+  void receive(uint8_t* buffer,
+               size_t size,
+               std::chrono::system_clock::time_point* receive_time) override {
+    checkSize(size, sizeof(research_interface::robot::RobotState));
+    research_interface::robot::RobotState robot_state;
+    while (!replay_->pop(&robot_state, receive_time)) {
+      if (!replay_->wait(kWaitSlice)) {
+        if (replay_->replayedStates() == replay_->recordedStates()) {
+          throw NetworkException("libfranka replay: End of recording reached.");
+        }
+      }
+    }
+    std::memcpy(buffer, &robot_state, sizeof(robot_state));
+  }
+
+  size_t receiveBatch(uint8_t* buffer,
+                      size_t message_size,
+                      size_t max_messages,
+                      std::chrono::system_clock::time_point* receive_times) override {
+    checkSize(message_size, sizeof(research_interface::robot::RobotState));
+    size_t received = 0;
+    research_interface::robot::RobotState robot_state;
+    while (received < max_messages && replay_->pop(&robot_state, &receive_times[received])) {
+      std::memcpy(buffer + received * message_size, &robot_state, sizeof(robot_state));
+      received++;
+    }
+    return received;
+  }
+
+  void send(const uint8_t* data, size_t size) override {
+    checkSize(size, sizeof(research_interface::robot::RobotCommand));
+    research_interface::robot::RobotCommand robot_command;
+    std::memcpy(&robot_command, data, sizeof(robot_command));
+    replay_->compare(robot_command);
+  }
+
+  bool wait(std::chrono::microseconds timeout) override { return replay_->wait(timeout); }
+
+  int descriptor() const noexcept override { return -1; }
+
+ private:
+  static constexpr std::chrono::milliseconds kWaitSlice{100};
+
+  static void checkSize(size_t size, size_t expected_size) {
+    if (size != expected_size) {
+      throw ProtocolException("libfranka: incorrect object size");
+    }
+  }
+
+  std::shared_ptr<DatagramReplay::Impl> replay_;
+};
+
+constexpr std::chrono::milliseconds ReplayTransport::kWaitSlice;
+
+}  // anonymous namespace
+
+DatagramReplay::Impl::Impl(const std::string& path, ReplaySpeed speed)
+    : file_(path), speed_(speed) {
+  DatagramRecordingHeader header;
+  if (file_.size() < sizeof(header)) {
+    throw Exception("libfranka replay: " + path + " is not a datagram recording.");
+  }
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (std::memcmp(header.magic, kDatagramRecordingMagic, sizeof(kDatagramRecordingMagic)) != 0 ||
+      header.version != DatagramRecorder::kFormatVersion) {
+    throw Exception("libfranka replay: " + path + " is not a datagram recording.");
+  }
+  if (header.protocol_version != research_interface::robot::kVersion ||
+      header.state_size != sizeof(research_interface::robot::RobotState) ||
+      header.command_size != sizeof(research_interface::robot::RobotCommand)) {
+    throw ProtocolException("libfranka replay: " + path +
+                            " was recorded with an incompatible robot protocol.");
+  }
+
+  // Index the records, ignoring an incomplete trailing record.
+  size_t offset = sizeof(header);
+  DatagramRecordHeader record;
+  while (offset + sizeof(record) <= file_.size()) {
+    std::memcpy(&record, file_.data() + offset, sizeof(record));
+    size_t data_offset = offset + sizeof(record);
+    if (data_offset + record.size > file_.size()) {
+      break;
+    }
+    if (record.type == static_cast<uint32_t>(DatagramType::kRobotState) &&
+        record.size == header.state_size) {
+      states_.push_back({data_offset, record.time});
+    } else if (record.type == static_cast<uint32_t>(DatagramType::kRobotCommand) &&
+               record.size == header.command_size) {
+      commands_.push_back({data_offset, record.time});
+    }
+    offset = data_offset + record.size;
+  }
+
+  server_ = std::make_unique<CommandServer>(
+      [this](const research_interface::robot::CommandHeader& header,
+             const std::vector<uint8_t>& message) { return handleRequest(header, message); },
+      [this]() { handleDisconnect(); });
+}
+
+uint16_t DatagramReplay::Impl::port() const noexcept {
+  return server_->port();
+}
+
+uint64_t DatagramReplay::Impl::recordedStates() const noexcept {
+  return states_.size();
+}
+
+uint64_t DatagramReplay::Impl::replayedStates() const noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  return next_state_;
+}
+
+uint64_t DatagramReplay::Impl::divergentCommands() const noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  return divergent_commands_;
+}
+
+std::chrono::steady_clock::time_point DatagramReplay::Impl::dueTimeUnsafe() const noexcept {
+  if (next_state_ == 0) {
+    return {};
+  }
+  return start_time_ + std::chrono::nanoseconds(states_[next_state_].time - states_[0].time);
+}
+
+bool DatagramReplay::Impl::dueUnsafe() const noexcept {
+  if (next_state_ == states_.size()) {
+    return false;
+  }
+  if (speed_ == ReplaySpeed::kMaximum) {
+    return state_released_;
+  }
+  return dueTimeUnsafe() <= std::chrono::steady_clock::now();
+}
+
+bool DatagramReplay::Impl::available() const noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  return dueUnsafe();
+}
+
+bool DatagramReplay::Impl::wait(std::chrono::microseconds timeout) {
+  std::chrono::steady_clock::time_point due_time;
+  {
+    std::lock_guard<std::mutex> _(mutex_);
+    if (next_state_ == states_.size()) {
+      return false;
+    }
+    if (speed_ == ReplaySpeed::kMaximum) {
+      state_released_ = true;
+      return true;
+    }
+    due_time = dueTimeUnsafe();
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (due_time <= now) {
+    return true;
+  }
+  std::this_thread::sleep_until(std::min<std::chrono::steady_clock::time_point>(
+      due_time, now + timeout));
+  return due_time <= std::chrono::steady_clock::now();
+}
+
+bool DatagramReplay::Impl::pop(research_interface::robot::RobotState* robot_state,
+                               std::chrono::system_clock::time_point* receive_time) noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  if (!dueUnsafe()) {
+    return false;
+  }
+  const Record& record = states_[next_state_];
+  std::memcpy(robot_state, file_.data() + record.offset, sizeof(*robot_state));
+  *receive_time = std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::nanoseconds(record.time)));
+  if (next_state_ == 0) {
+    start_time_ = std::chrono::steady_clock::now();
+  }
+  next_state_++;
+  state_released_ = false;
+  trackMotionUnsafe(robot_state->robot_mode);
+  return true;
+}
+
+void DatagramReplay::Impl::compare(
+    const research_interface::robot::RobotCommand& robot_command) noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  state_released_ = true;
+  // Commands are recorded in the order of their message IDs, so skip the ones without a
+  // counterpart in this run.
+  research_interface::robot::RobotCommand recorded_command;
+  while (next_command_ < commands_.size()) {
+    std::memcpy(&recorded_command, file_.data() + commands_[next_command_].offset,
+                sizeof(recorded_command));
+    if (recorded_command.message_id >= robot_command.message_id) {
+      break;
+    }
+    next_command_++;
+  }
+  if (next_command_ == commands_.size() ||
+      recorded_command.message_id != robot_command.message_id ||
+      std::memcmp(&recorded_command, &robot_command, sizeof(robot_command)) != 0) {
+    divergent_commands_++;
+    return;
+  }
+  next_command_++;
+}
+
+void DatagramReplay::Impl::trackMotionUnsafe(
+    research_interface::robot::RobotMode robot_mode) noexcept {
+  namespace ri = research_interface::robot;
+
+  if (!motion_running_) {
+    return;
+  }
+  if (robot_mode == ri::RobotMode::kMove) {
+    motion_seen_ = true;
+    return;
+  }
+  if (!motion_seen_) {
+    return;
+  }
+
+  ri::Move::Status status = ri::Move::Status::kAborted;
+  if (robot_mode == ri::RobotMode::kIdle) {
+    status = ri::Move::Status::kSuccess;
+  } else if (robot_mode == ri::RobotMode::kReflex) {
+    status = ri::Move::Status::kReflexAborted;
+  }
+  motion_running_ = false;
+  server_->sendResponse<ri::Move>(move_command_id_, ri::Move::Response(status));
+}
+
+bool DatagramReplay::Impl::handleRequest(const research_interface::robot::CommandHeader& header,
+                                         const std::vector<uint8_t>& message) {
+  namespace ri = research_interface::robot;
+
+  switch (header.command) {
+    case ri::Command::kMove: {
+      CommandServer::readRequest<ri::Move>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      ri::Move::Status status = ri::Move::Status::kCommandNotPossibleRejected;
+      if (!motion_running_) {
+        motion_running_ = true;
+        motion_seen_ = false;
+        move_command_id_ = header.command_id;
+        status = ri::Move::Status::kMotionStarted;
+      }
+      // Respond under the lock, so that the response cannot overtake the one of a finished motion.
+      server_->sendResponse<ri::Move>(header.command_id, ri::Move::Response(status));
+      return true;
+    }
+    case ri::Command::kStopMove: {
+      CommandServer::readRequest<ri::StopMove>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      if (motion_running_) {
+        motion_running_ = false;
+        server_->sendResponse<ri::Move>(move_command_id_,
+                                        ri::Move::Response(ri::Move::Status::kPreempted));
+      }
+      server_->sendResponse<ri::StopMove>(header.command_id,
+                                          ri::StopMove::Response(ri::StopMove::Status::kSuccess));
+      return true;
+    }
+    case ri::Command::kLoadModelLibrary:
+      // The model library is not part of the recording.
+      CommandServer::readRequest<ri::LoadModelLibrary>(message);
+      server_->sendResponse<ri::LoadModelLibrary>(
+          header.command_id, ri::LoadModelLibrary::Response(ri::LoadModelLibrary::Status::kError));
+      return true;
+    default:
+      // Virtual walls are not recorded.
+      return server_->acknowledge(header, message);
+  }
+}
+
+void DatagramReplay::Impl::handleDisconnect() noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  motion_running_ = false;
+}
+
+DatagramReplay::DatagramReplay(const std::string& path, ReplaySpeed speed)
+    : impl_(std::make_shared<Impl>(path, speed)) {}
+
+// Has to be declared here, as the Impl type is incomplete in the header.
+DatagramReplay::~DatagramReplay() noexcept = default;
+
+uint64_t DatagramReplay::recordedStates() const noexcept {
+  return impl_->recordedStates();
+}
+
+uint64_t DatagramReplay::replayedStates() const noexcept {
+  return impl_->replayedStates();
+}
+
+uint64_t DatagramReplay::divergentCommands() const noexcept {
+  return impl_->divergentCommands();
+}
+
+std::unique_ptr<Network> DatagramReplay::connect() {
+  return std::make_unique<Network>("127.0.0.1", impl_->port(),
+                                   std::make_unique<ReplayTransport>(impl_));
+}
+
+}  // namespace franka
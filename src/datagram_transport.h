@@ -0,0 +1,95 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace franka {
+
+/**
+ * Carries the fixed-size state and command datagrams of a device connection.
+ *
+ * franka::Network serializes all calls, so implementations do not need to be thread-safe. Like UDP,
+ * a transport may drop datagrams, but must never deliver partial ones.
+ */
+class DatagramTransport {
+ public:
+  virtual ~DatagramTransport() = default;
+
+  /**
+   * @return Port announced to the device when connecting, or 0 if the device does not send its
+   * datagrams over UDP.
+   */
+  virtual uint16_t port() const noexcept = 0;
+
+  /**
+   * @param[in] size Size of the expected datagram.
+   *
+   * @return True if a datagram of at least the given size is queued.
+   *
+   * @throw NetworkException if the transport failed.
+   */
+  virtual bool available(size_t size) = 0;
+
+  /**
+   * Blocks until a datagram has been received, at most for the receive timeout of the transport.
+   *
+   * @param[out] buffer Written with the datagram.
+   * @param[in] size Expected size of the datagram.
+   * @param[out] receive_time Written with the time at which the datagram arrived, or the epoch if
+   * the transport does not report it.
+   *
+   * @throw NetworkException if the timeout expired or the transport failed.
+   * @throw ProtocolException if the datagram does not have the expected size.
+   */
+  virtual void receive(uint8_t* buffer,
+                       size_t size,
+                       std::chrono::system_clock::time_point* receive_time) = 0;
+
+  /**
+   * Receives queued datagrams without blocking.
+   *
+   * @param[out] buffer Written with the received datagrams, one after the other.
+   * @param[in] message_size Expected size of each datagram.
+   * @param[in] max_messages Maximum number of datagrams to receive.
+   * @param[out] receive_times Written with the arrival time of each received datagram, or the
+   * epoch if the transport does not report it.
+   *
+   * @return Number of received datagrams.
+   *
+   * @throw NetworkException if the transport failed.
+   * @throw ProtocolException if a datagram does not have the expected size.
+   */
+  virtual size_t receiveBatch(uint8_t* buffer,
+                              size_t message_size,
+                              size_t max_messages,
+                              std::chrono::system_clock::time_point* receive_times) = 0;
+
+  /**
+   * Sends a datagram to the device.
+   *
+   * @throw NetworkException if the datagram could not be sent.
+   */
+  virtual void send(const uint8_t* data, size_t size) = 0;
+
+  /**
+   * Blocks until a datagram is queued.
+   *
+   * @param[in] timeout Maximum time to wait.
+   *
+   * @return True if a datagram is queued, false if the timeout expired.
+   *
+   * @throw NetworkException if waiting failed.
+   */
+  virtual bool wait(std::chrono::microseconds timeout) = 0;
+
+  /**
+   * @return Descriptor that becomes readable whenever a datagram is queued, or -1 if the transport
+   * can only be waited on with wait().
+   */
+  virtual int descriptor() const noexcept = 0;
+};
+
+}  // namespace franka
@@ -0,0 +1,160 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <franka/control_tools.h>
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+namespace franka {
+
+/**
+ * Outcome of DeadlineWorker::call().
+ */
+enum class DeadlineResult {
+  /// The callback returned within the budget and the output was set.
+  kOnTime,
+  /// The callback was called, but missed the budget.
+  kLate,
+  /// The callback was still busy with an earlier robot state and was not called.
+  kBusy
+};
+
+/**
+ * Runs a control loop callback on a worker thread and waits for its output for at most a fixed
+ * budget.
+ *
+ * If the callback misses the budget, call() returns without an output and the callback keeps
+ * running; its late output is discarded. Until it returns, further calls return immediately and
+ * their robot states are skipped. The next robot state passed to the callback then carries the
+ * time step since the last robot state it received.
+ */
+template <typename Output>
+class DeadlineWorker {
+ public:
+  using Callback = std::function<Output(const RobotState&, Duration)>;
+
+  /**
+   * Starts the worker thread.
+   *
+   * @param[in] callback Callback to run. Must outlive the worker.
+   * @param[in] budget Time to wait for the callback in every call.
+   */
+  DeadlineWorker(const Callback& callback, std::chrono::microseconds budget)
+      : callback_(callback), budget_(budget) {
+    thread_ = std::thread(&DeadlineWorker::run, this);
+  }
+
+  ~DeadlineWorker() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    request_condition_.notify_one();
+    thread_.join();
+  }
+
+  DeadlineWorker(const DeadlineWorker&) = delete;
+  DeadlineWorker& operator=(const DeadlineWorker&) = delete;
+
+  /**
+   * Passes a robot state to the callback and waits for its output.
+   *
+   * @param[in] robot_state Robot state to pass.
+   * @param[in] time_step Time since the previous robot state.
+   * @param[out] output Output of the callback. Only set if kOnTime is returned.
+   *
+   * @return Whether the callback returned in time.
+   *
+   * @throw Any exception thrown by the callback, including by calls that missed the budget.
+   */
+  DeadlineResult call(const RobotState& robot_state, Duration time_step, Output* output) {
+    auto deadline = std::chrono::steady_clock::now() + budget_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    rethrowError();
+    skipped_time_ += time_step;
+    if (busy_) {
+      return DeadlineResult::kBusy;
+    }
+
+    robot_state_ = robot_state;
+    time_step_ = skipped_time_;
+    skipped_time_ = Duration();
+    output_ = output;
+    busy_ = true;
+    request_condition_.notify_one();
+    if (!response_condition_.wait_until(lock, deadline, [this]() { return !busy_; })) {
+      output_ = nullptr;
+      return DeadlineResult::kLate;
+    }
+    rethrowError();
+    return DeadlineResult::kOnTime;
+  }
+
+ private:
+  void rethrowError() {
+    if (error_) {
+      std::exception_ptr error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  void run() noexcept {
+    // The callback replaces the control thread's own call, so it needs the same priority. If that
+    // is not permitted, the control thread has already reported it.
+    std::string error_message;
+    setCurrentThreadToHighestSchedulerPriority(&error_message);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      request_condition_.wait(lock, [this]() { return stop_ || busy_; });
+      if (stop_) {
+        return;
+      }
+
+      // The control thread does not touch the robot state while busy_ is set.
+      lock.unlock();
+      try {
+        Output output = callback_(robot_state_, time_step_);
+        lock.lock();
+        if (output_ != nullptr) {
+          *output_ = output;
+        }
+      } catch (...) {
+        if (!lock.owns_lock()) {
+          lock.lock();
+        }
+        error_ = std::current_exception();
+      }
+      output_ = nullptr;
+      busy_ = false;
+      response_condition_.notify_one();
+    }
+  }
+
+  const Callback& callback_;
+  const std::chrono::microseconds budget_;
+
+  std::mutex mutex_;
+  std::condition_variable request_condition_;
+  std::condition_variable response_condition_;
+  bool stop_{false};
+  bool busy_{false};
+  RobotState robot_state_{};
+  Duration time_step_;
+  Duration skipped_time_;
+  Output* output_{nullptr};
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+}  // namespace franka
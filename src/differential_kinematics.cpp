@@ -0,0 +1,111 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/differential_kinematics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+namespace franka {
+
+namespace {
+
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Matrix7d = Eigen::Matrix<double, 7, 7>;
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+}  // anonymous namespace
+
+DifferentialKinematics::DifferentialKinematics(const DifferentialKinematicsOptions& options)
+    : options_(options) {
+  if (!(options.manipulability_threshold >= 0) || !(options.max_damping >= 0) ||
+      (options.manipulability_threshold == 0 && options.max_damping > 0) ||
+      !(options.posture_gain >= 0) || !(options.joint_limit_margin >= 0) ||
+      !(options.joint_limit_gain >= 0)) {
+    throw std::invalid_argument("libfranka: Invalid parameters for differential kinematics.");
+  }
+  for (size_t i = 0; i < 7; i++) {
+    if (!(options.min_joint_position[i] <= options.max_joint_position[i]) ||
+        !(options.max_joint_velocity[i] >= 0)) {
+      throw std::invalid_argument("libfranka: Invalid joint limits for differential kinematics.");
+    }
+  }
+}
+
+JointVelocities DifferentialKinematics::compute(
+    const std::array<double, 42>& zero_jacobian,
+    const std::array<double, 7>& q,
+    const std::array<double, 6>& O_dP_EE) noexcept {  // NOLINT(readability-identifier-naming)
+  Eigen::Map<const Matrix6x7d> jacobian(zero_jacobian.data());
+  Matrix6d jacobian_jacobian_transpose = jacobian * jacobian.transpose();
+
+  // det(J J^T) is the product of the pivots of its LDLT decomposition.
+  Eigen::LDLT<Matrix6d> ldlt(jacobian_jacobian_transpose);
+  manipulability_ = std::sqrt(std::max(ldlt.vectorD().prod(), 0.0));
+
+  double damping_squared = 0;
+  if (manipulability_ < options_.manipulability_threshold) {
+    double ratio = manipulability_ / options_.manipulability_threshold;
+    damping_squared = options_.max_damping * options_.max_damping * (1 - ratio * ratio);
+    ldlt.compute(jacobian_jacobian_transpose + damping_squared * Matrix6d::Identity());
+  }
+  damping_ = std::sqrt(damping_squared);
+
+  Vector7d secondary = Vector7d::Zero();
+  for (size_t i = 0; i < 7; i++) {
+    secondary[i] = options_.posture_gain * (options_.posture[i] - q[i]);
+    double lower = options_.min_joint_position[i] + options_.joint_limit_margin - q[i];
+    double upper = q[i] - (options_.max_joint_position[i] - options_.joint_limit_margin);
+    if (lower > 0) {
+      secondary[i] += options_.joint_limit_gain * lower;
+    } else if (upper > 0) {
+      secondary[i] -= options_.joint_limit_gain * upper;
+    }
+  }
+
+  // J^T (J J^T + lambda^2 I)^-1 (x_dot - J q0_dot) + q0_dot is the task velocity plus the
+  // secondary velocity projected into the null space, with a single solve.
+  Vector6d task_error = Eigen::Map<const Vector6d>(O_dP_EE.data()) - jacobian * secondary;
+  Vector7d dq = jacobian.transpose() * ldlt.solve(task_error) + secondary;
+
+  velocity_scaling_ = 1;
+  for (size_t i = 0; i < 7; i++) {
+    if (std::abs(dq[i]) * velocity_scaling_ > options_.max_joint_velocity[i]) {
+      velocity_scaling_ = options_.max_joint_velocity[i] / std::abs(dq[i]);
+    }
+  }
+  if (!std::isfinite(velocity_scaling_) || !dq.allFinite()) {
+    velocity_scaling_ = 0;
+    dq.setZero();
+  }
+
+  std::array<double, 7> output;
+  Eigen::Map<Vector7d>(output.data()) = velocity_scaling_ * dq;
+  return JointVelocities(output);
+}
+
+JointVelocities DifferentialKinematics::compute(
+    const Model& model,
+    const RobotState& robot_state,
+    const std::array<double, 6>& O_dP_EE) {  // NOLINT(readability-identifier-naming)
+  return compute(model.zeroJacobian(Frame::kEndEffector, robot_state), robot_state.q, O_dP_EE);
+}
+
+double DifferentialKinematics::manipulability() const noexcept {
+  return manipulability_;
+}
+
+double DifferentialKinematics::damping() const noexcept {
+  return damping_;
+}
+
+double DifferentialKinematics::velocityScaling() const noexcept {
+  return velocity_scaling_;
+}
+
+}  // namespace franka
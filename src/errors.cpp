@@ -2,9 +2,9 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka/errors.h>
 
-#include <algorithm>
-#include <iterator>
 #include <sstream>
+#include <string>
+#include <utility>
 
 #include <research_interface/robot/error.h>
 
@@ -12,17 +12,45 @@ using Error = research_interface::robot::Error;
 
 namespace franka {
 
+namespace {
+
+constexpr uint64_t kAllBits = (uint64_t{1} << Errors::kCount) - 1;
+
+uint64_t packBits(const std::array<bool, Errors::kCount>& errors) noexcept {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < errors.size(); i++) {
+    bits |= static_cast<uint64_t>(errors[i]) << i;
+  }
+  return bits;
+}
+
+std::array<bool, Errors::kCount> unpackBits(uint64_t bits) noexcept {
+  std::array<bool, Errors::kCount> errors{};
+  for (size_t i = 0; i < errors.size(); i++) {
+    errors[i] = ((bits >> i) & 1) != 0;
+  }
+  return errors;
+}
+
+}  // anonymous namespace
+
+constexpr size_t Errors::kCount;
+
 Errors::Errors() : Errors(std::array<bool, 41>{}) {}
 
 Errors::Errors(const Errors& other) : Errors(other.errors_) {}
 
+Errors::Errors(uint64_t bits) : Errors(unpackBits(bits & kAllBits)) {}
+
 Errors& Errors::operator=(Errors other) {
   std::swap(errors_, other.errors_);
+  std::swap(bits_, other.bits_);
   return *this;
 }
 
 Errors::Errors(const std::array<bool, 41>& errors)  // NOLINT(modernize-pass-by-value)
     : errors_(errors),
+      bits_(packBits(errors_)),
       joint_position_limits_violation(
           errors_[static_cast<size_t>(Error::kJointPositionLimitsViolation)]),
       cartesian_position_limits_violation(
@@ -100,20 +128,35 @@ Errors::Errors(const std::array<bool, 41>& errors)  // NOLINT(modernize-pass-by-
       base_acceleration_invalid_reading(
           errors_[static_cast<size_t>(Error::kBaseAccelerationInvalidReading)]) {}
 
+size_t Errors::lowestBit(uint64_t bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<size_t>(__builtin_ctzll(bits));
+#else
+  size_t index = 0;
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+
+const char* Errors::name(size_t index) {
+  return getErrorName(static_cast<Error>(index));
+}
+
 Errors::operator bool() const noexcept {
-  return std::any_of(errors_.cbegin(), errors_.cend(), [](bool x) { return x; });
+  return bits_ != 0;
 }
 
 Errors::operator std::string() const {
   std::string error_string = "[";
 
-  for (size_t i = 0; i < errors_.size(); i++) {
-    if (errors_[i]) {
-      error_string += "\"";
-      error_string += getErrorName(static_cast<Error>(i));
-      error_string += "\", ";
-    }
-  }
+  forEach([&error_string](size_t index) {
+    error_string += "\"";
+    error_string += name(index);
+    error_string += "\", ";
+  });
 
   if (error_string.size() > 1) {
     error_string.erase(error_string.end() - 2, error_string.end());
@@ -0,0 +1,55 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/event_loop.h>
+
+#include <stdexcept>
+
+#include <franka/gripper.h>
+#include <franka/robot.h>
+#include <franka/vacuum_gripper.h>
+
+#include "network.h"
+#include "network_event_loop.h"
+#include "robot_impl.h"
+
+namespace franka {
+
+EventLoop::EventLoop(RealtimeConfig realtime_config, const RealtimeOptions& realtime_options)
+    : impl_(std::make_shared<NetworkEventLoop>(realtime_config, realtime_options)) {}
+
+EventLoop::~EventLoop() noexcept {
+  // Attached connections keep a reference to the loop, so it has to be stopped explicitly.
+  impl_->stop();
+}
+
+void EventLoop::attach(Robot& robot) {
+  if (!robot.impl_) {
+    throw std::invalid_argument("libfranka: Cannot attach a moved-from robot to an event loop.");
+  }
+  robot.impl_->network().setEventLoop(impl_);
+}
+
+void EventLoop::attach(Gripper& gripper) {
+  if (!gripper.network_) {
+    throw std::invalid_argument("libfranka: Cannot attach a moved-from gripper to an event loop.");
+  }
+  gripper.network_->setEventLoop(impl_);
+}
+
+void EventLoop::attach(VacuumGripper& vacuum_gripper) {
+  if (!vacuum_gripper.network_) {
+    throw std::invalid_argument(
+        "libfranka: Cannot attach a moved-from vacuum gripper to an event loop.");
+  }
+  vacuum_gripper.network_->setEventLoop(impl_);
+}
+
+size_t EventLoop::size() const {
+  return impl_->size();
+}
+
+bool EventLoop::running() const noexcept {
+  return impl_->running();
+}
+
+}  // namespace franka
@@ -12,8 +12,51 @@ using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
 
 namespace franka {
 
-ControlException::ControlException(const std::string& what,
-                                   std::vector<franka::Record> log) noexcept
+namespace detail {
+
+const std::vector<Record>& LogSource::records() const {
+  std::call_once(converted_, [this]() { convert(&records_); });
+  return records_;
+}
+
+}  // namespace detail
+
+namespace {
+
+// Records that are already converted. They are moved on the only call to convert().
+class RecordLogSource : public detail::LogSource {
+ public:
+  explicit RecordLogSource(std::vector<Record> records)
+      : size_(records.size()), records_(std::move(records)) {}
+
+  size_t size() const noexcept override { return size_; }
+
+ protected:
+  void convert(std::vector<Record>* records) const override { *records = std::move(records_); }
+
+ private:
+  const size_t size_;  // NOLINT(readability-identifier-naming)
+  mutable std::vector<Record> records_;
+};
+
+}  // anonymous namespace
+
+ExceptionLog::ExceptionLog(std::vector<Record> records)
+    : source_(records.empty() ? nullptr : std::make_shared<RecordLogSource>(std::move(records))) {}
+
+ExceptionLog::ExceptionLog(std::shared_ptr<const detail::LogSource> source) noexcept
+    : source_(std::move(source)) {}
+
+const std::vector<Record>& ExceptionLog::records() const {
+  static const std::vector<Record> kEmpty;
+  return source_ ? source_->records() : kEmpty;
+}
+
+size_t ExceptionLog::size() const noexcept {
+  return source_ ? source_->size() : 0;
+}
+
+ControlException::ControlException(const std::string& what, ExceptionLog log) noexcept
     : Exception(what), log(std::move(log)) {}
 
 IncompatibleVersionException::IncompatibleVersionException(uint16_t server_version,
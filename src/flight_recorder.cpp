@@ -0,0 +1,166 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/flight_recorder.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <franka/exception.h>
+#include <research_interface/robot/rbk_types.h>
+#include <research_interface/robot/service_types.h>
+
+#include "memory_mapped_file.h"
+#include "platform.h"
+#include "robot_state_conversion.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace franka {
+
+constexpr uint32_t FlightRecorder::kFormatVersion;
+
+namespace {
+
+constexpr char kFlightRecordingMagic[8] = {'F', 'R', 'A', 'N', 'K', 'F', 'L', 'T'};
+
+struct FlightRecordingHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t protocol_version;
+  uint32_t state_size;
+  uint32_t command_size;
+  uint64_t capacity;
+  // Written through an std::atomic<uint64_t> by the recorder.
+  uint64_t committed;
+  char reserved[24];
+};
+static_assert(sizeof(FlightRecordingHeader) == 64, "Unexpected header size");
+
+constexpr size_t kCommittedOffset = 32;
+
+constexpr size_t slotSize() noexcept {
+  return (sizeof(research_interface::robot::RobotState) +
+          sizeof(research_interface::robot::RobotCommand) + 7) /
+         8 * 8;
+}
+
+}  // anonymous namespace
+
+FlightRecorder::FlightRecorder(const std::string& path, size_t capacity)
+    : capacity_(capacity), slot_size_(slotSize()) {
+  if (capacity < 2) {
+    throw Exception("libfranka flight recorder: Capacity must be at least 2.");
+  }
+#ifdef LIBFRANKA_LINUX
+  size_ = sizeof(FlightRecordingHeader) + capacity * slot_size_;
+  int file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (file < 0) {
+    throw Exception("libfranka flight recorder: Unable to open " + path + ": " +
+                    std::strerror(errno));
+  }
+  // Allocate all blocks up front, so that the control loop does not wait for the file system.
+  int error = posix_fallocate(file, 0, static_cast<off_t>(size_));
+  if (error != 0) {
+    close(file);
+    throw Exception("libfranka flight recorder: Unable to allocate " + path + ": " +
+                    std::strerror(error));
+  }
+  void* address = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  close(file);
+  if (address == MAP_FAILED) {
+    throw Exception("libfranka flight recorder: Unable to map " + path + ": " +
+                    std::strerror(errno));
+  }
+  data_ = static_cast<char*>(address);
+  // Touch all pages, so that recording does not cause page faults.
+  std::memset(data_, 0, size_);
+
+  FlightRecordingHeader header{};
+  std::memcpy(header.magic, kFlightRecordingMagic, sizeof(header.magic));
+  header.version = kFormatVersion;
+  header.protocol_version = research_interface::robot::kVersion;
+  header.state_size = sizeof(research_interface::robot::RobotState);
+  header.command_size = sizeof(research_interface::robot::RobotCommand);
+  header.capacity = capacity;
+  std::memcpy(data_, &header, sizeof(header));
+  committed_ = new (data_ + kCommittedOffset) std::atomic<uint64_t>(0);
+#else
+  static_cast<void>(path);
+  throw Exception("libfranka flight recorder: Not supported on this platform.");
+#endif
+}
+
+FlightRecorder::~FlightRecorder() noexcept {
+#ifdef LIBFRANKA_LINUX
+  munmap(data_, size_);
+#endif
+}
+
+size_t FlightRecorder::capacity() const noexcept {
+  return capacity_;
+}
+
+uint64_t FlightRecorder::committedSamples() const noexcept {
+  return committed_->load(std::memory_order_relaxed);
+}
+
+void recordRawFlightSample(FlightRecorder& recorder,
+                           const research_interface::robot::RobotState& robot_state,
+                           const research_interface::robot::RobotCommand& robot_command) noexcept {
+  // The control thread is the only writer, so no read-modify-write is needed.
+  uint64_t committed = recorder.committed_->load(std::memory_order_relaxed);
+  char* slot = recorder.data_ + sizeof(FlightRecordingHeader) +
+               (committed % recorder.capacity_) * recorder.slot_size_;
+  std::memcpy(slot, &robot_state, sizeof(robot_state));
+  std::memcpy(slot + sizeof(robot_state), &robot_command, sizeof(robot_command));
+  recorder.committed_->store(committed + 1, std::memory_order_release);
+}
+
+std::vector<Record> readFlightRecording(const std::string& path) {
+  MemoryMappedFile file(path);
+  FlightRecordingHeader header;
+  if (file.size() < sizeof(header)) {
+    throw Exception("libfranka flight recorder: " + path + " is not a flight recording.");
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kFlightRecordingMagic, sizeof(kFlightRecordingMagic)) != 0 ||
+      header.version != FlightRecorder::kFormatVersion || header.capacity < 2 ||
+      file.size() < sizeof(header) + header.capacity * slotSize()) {
+    throw Exception("libfranka flight recorder: " + path + " is not a flight recording.");
+  }
+  if (header.protocol_version != research_interface::robot::kVersion ||
+      header.state_size != sizeof(research_interface::robot::RobotState) ||
+      header.command_size != sizeof(research_interface::robot::RobotCommand)) {
+    throw ProtocolException("libfranka flight recorder: " + path +
+                            " was recorded with an incompatible robot protocol.");
+  }
+
+  // The slot following the last committed sample may have been written partially.
+  uint64_t count = std::min<uint64_t>(header.committed, header.capacity - 1);
+  std::vector<Record> records(count);
+  research_interface::robot::RobotState robot_state;
+  research_interface::robot::RobotCommand robot_command;
+  for (uint64_t i = 0; i < count; i++) {
+    const char* slot = file.data() + sizeof(header) +
+                       ((header.committed - count + i) % header.capacity) * slotSize();
+    std::memcpy(&robot_state, slot, sizeof(robot_state));
+    std::memcpy(&robot_command, slot + sizeof(robot_state), sizeof(robot_command));
+
+    Record& record = records[i];
+    record.state = convertRobotState(robot_state);
+    record.command.joint_positions = robot_command.motion.q_c;
+    record.command.joint_velocities = robot_command.motion.dq_c;
+    record.command.cartesian_pose.O_T_EE = robot_command.motion.O_T_EE_c;
+    record.command.cartesian_velocities.O_dP_EE = robot_command.motion.O_dP_EE_c;
+    record.command.torques.tau_J = robot_command.control.tau_J_d;
+  }
+  return records;
+}
+
+}  // namespace franka
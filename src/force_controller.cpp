@@ -0,0 +1,128 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/force_controller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+#include <franka/rate_limiting.h>
+
+namespace franka {
+
+namespace {
+
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+bool isNonNegative(double value) {
+  return std::isfinite(value) && value >= 0.0;
+}
+
+}  // anonymous namespace
+
+ForceController::ForceController(const ForceControllerParameters& parameters)
+    : parameters_(parameters) {
+  auto valid = [](const std::array<double, 6>& values) {
+    return std::all_of(values.begin(), values.end(), isNonNegative);
+  };
+  if (!valid(parameters.proportional_gain) || !valid(parameters.integral_gain) ||
+      !valid(parameters.max_integral_wrench)) {
+    throw std::invalid_argument(
+        "libfranka: Force controller gains and limits must not be negative, infinite or NaN.");
+  }
+}
+
+void ForceController::setTarget(const std::array<double, 6>& wrench) {
+  if (!std::all_of(wrench.begin(), wrench.end(),
+                   [](double value) { return std::isfinite(value); })) {
+    throw std::invalid_argument("libfranka: Force controller target is infinite or NaN.");
+  }
+  target_ = wrench;
+}
+
+void ForceController::calibrateBias(const RobotState& robot_state,
+                                    const std::array<double, 42>& zero_jacobian) noexcept {
+  const std::array<double, 6>& sample = externalWrench(robot_state, zero_jacobian);
+  bias_samples_++;
+  for (size_t i = 0; i < bias_.size(); i++) {
+    bias_[i] += (sample[i] - bias_[i]) / static_cast<double>(bias_samples_);
+  }
+}
+
+void ForceController::resetBias() noexcept {
+  bias_ = {};
+  bias_samples_ = 0;
+}
+
+void ForceController::resetIntegrator() noexcept {
+  integral_ = {};
+}
+
+std::array<double, 7> ForceController::update(const RobotState& robot_state, const Model& model) {
+  return update(robot_state, model.zeroJacobian(Frame::kStiffness, robot_state));
+}
+
+std::array<double, 7> ForceController::update(
+    const RobotState& robot_state,
+    const std::array<double, 42>& zero_jacobian) noexcept {
+  const std::array<double, 6>& external_wrench = externalWrench(robot_state, zero_jacobian);
+  for (size_t i = 0; i < 6; i++) {
+    measured_wrench_[i] = bias_[i] - external_wrench[i];
+    if (!parameters_.selection[i]) {
+      integral_[i] = 0.0;
+      commanded_wrench_[i] = 0.0;
+      continue;
+    }
+    double error = target_[i] - measured_wrench_[i];
+    double max_integral = parameters_.max_integral_wrench[i];
+    integral_[i] = std::max(
+        -max_integral,
+        std::min(integral_[i] + parameters_.integral_gain[i] * error * kDeltaT, max_integral));
+    commanded_wrench_[i] = target_[i] + parameters_.proportional_gain[i] * error + integral_[i];
+  }
+
+  std::array<double, 7> tau_d;
+  Eigen::Map<Vector7d>(tau_d.data()) =
+      Eigen::Map<const Matrix6x7d>(zero_jacobian.data()).transpose() *
+      Eigen::Map<const Vector6d>(commanded_wrench_.data());
+  return tau_d;
+}
+
+const std::array<double, 6>& ForceController::measuredWrench() const noexcept {
+  return measured_wrench_;
+}
+
+const std::array<double, 6>& ForceController::commandedWrench() const noexcept {
+  return commanded_wrench_;
+}
+
+const std::array<double, 6>& ForceController::bias() const noexcept {
+  return bias_;
+}
+
+const std::array<double, 6>& ForceController::externalWrench(
+    const RobotState& robot_state,
+    const std::array<double, 42>& zero_jacobian) noexcept {
+  if (parameters_.measurement == ForceMeasurement::kExternalWrench) {
+    external_wrench_ = robot_state.O_F_ext_hat_K;
+    return external_wrench_;
+  }
+
+  // Least-squares solution of J^T F = tau_ext. In a singular configuration, the previous
+  // measurement is kept.
+  Eigen::Map<const Matrix6x7d> jacobian(zero_jacobian.data());
+  Eigen::LDLT<Matrix6d> ldlt(jacobian * jacobian.transpose());
+  if (ldlt.info() == Eigen::Success && ldlt.vectorD().minCoeff() > 0) {
+    Eigen::Map<Vector6d>(external_wrench_.data()) =
+        ldlt.solve(jacobian * Eigen::Map<const Vector7d>(robot_state.tau_ext_hat_filtered.data()));
+  }
+  return external_wrench_;
+}
+
+}  // namespace franka
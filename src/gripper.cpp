@@ -7,17 +7,16 @@
 #include <franka/exception.h>
 #include <research_interface/gripper/types.h>
 
+#include "async_command_executor.h"
 #include "network.h"
+#include "state_subscription.h"
 
 namespace franka {
 
 namespace {
 
-template <typename T, typename... TArgs>
-bool executeCommand(Network& network, TArgs&&... args) {
-  uint32_t command_id = network.tcpSendRequest<T>(std::forward<TArgs>(args)...);
-  typename T::Response response = network.tcpBlockingReceiveResponse<T>(command_id);
-
+template <typename T>
+bool handleCommandResponse(const typename T::Response& response) {
   switch (response.status) {
     case T::Status::kSuccess:
       return true;
@@ -32,6 +31,23 @@ bool executeCommand(Network& network, TArgs&&... args) {
   }
 }
 
+template <typename T, typename... TArgs>
+bool executeCommand(Network& network, TArgs&&... args) {
+  uint32_t command_id = network.tcpSendRequest<T>(std::forward<TArgs>(args)...);
+  return handleCommandResponse<T>(network.tcpBlockingReceiveResponse<T>(command_id));
+}
+
+// Waits for the response to a gripper motion, which may take up to the given motion timeout in
+// addition to the TCP timeout of the network.
+template <typename T, typename... TArgs>
+bool executeMotionCommand(Network& network,
+                          std::chrono::milliseconds motion_timeout,
+                          TArgs&&... args) {
+  uint32_t command_id = network.tcpSendRequest<T>(std::forward<TArgs>(args)...);
+  return handleCommandResponse<T>(
+      network.tcpBlockingReceiveResponse<T>(command_id, nullptr, motion_timeout));
+}
+
 GripperState convertGripperState(
     const research_interface::gripper::GripperState& gripper_state) noexcept {
   GripperState converted;
@@ -45,23 +61,40 @@ GripperState convertGripperState(
 
 }  // anonymous namespace
 
-Gripper::Gripper(const std::string& franka_address)
+class Gripper::Subscription
+    : public StateSubscription<research_interface::gripper::GripperState, GripperState> {
+ public:
+  using StateSubscription::StateSubscription;
+};
+
+Gripper::Gripper(const std::string& franka_address, std::chrono::milliseconds motion_timeout)
     : network_{
-          std::make_unique<Network>(franka_address, research_interface::gripper::kCommandPort)} {
+          std::make_unique<Network>(franka_address, research_interface::gripper::kCommandPort)},
+      motion_timeout_{motion_timeout} {
   connect<research_interface::gripper::Connect, research_interface::gripper::kVersion>(
       *network_, &ri_version_);
+  async_commands_ = std::make_unique<AsyncCommandExecutor>(*network_);
 }
 
 Gripper::~Gripper() noexcept = default;
 Gripper::Gripper(Gripper&&) noexcept = default;
-Gripper& Gripper::operator=(Gripper&&) noexcept = default;
+
+Gripper& Gripper::operator=(Gripper&& gripper) noexcept {
+  // Stop the background threads before the connection they use is closed.
+  subscription_ = std::move(gripper.subscription_);
+  async_commands_ = std::move(gripper.async_commands_);
+  network_ = std::move(gripper.network_);
+  ri_version_ = gripper.ri_version_;
+  motion_timeout_ = gripper.motion_timeout_;
+  return *this;
+}
 
 Gripper::ServerVersion Gripper::serverVersion() const noexcept {
   return ri_version_;
 }
 
 bool Gripper::homing() const {
-  return executeCommand<research_interface::gripper::Homing>(*network_);
+  return executeMotionCommand<research_interface::gripper::Homing>(*network_, motion_timeout_);
 }
 
 bool Gripper::grasp(double width,
@@ -70,19 +103,49 @@ bool Gripper::grasp(double width,
                     double epsilon_inner,
                     double epsilon_outer) const {
   research_interface::gripper::Grasp::GraspEpsilon epsilon(epsilon_inner, epsilon_outer);
-  return executeCommand<research_interface::gripper::Grasp>(*network_, width, epsilon, speed,
-                                                            force);
+  return executeMotionCommand<research_interface::gripper::Grasp>(*network_, motion_timeout_, width,
+                                                                  epsilon, speed, force);
 }
 
 bool Gripper::move(double width, double speed) const {
-  return executeCommand<research_interface::gripper::Move>(*network_, width, speed);
+  return executeMotionCommand<research_interface::gripper::Move>(*network_, motion_timeout_, width,
+                                                                 speed);
 }
 
 bool Gripper::stop() const {
   return executeCommand<research_interface::gripper::Stop>(*network_);
 }
 
+std::future<bool> Gripper::homingAsync() const {
+  return async_commands_->execute<research_interface::gripper::Homing>(
+      &handleCommandResponse<research_interface::gripper::Homing>);
+}
+
+std::future<bool> Gripper::graspAsync(double width,
+                                      double speed,
+                                      double force,
+                                      double epsilon_inner,
+                                      double epsilon_outer) const {
+  research_interface::gripper::Grasp::GraspEpsilon epsilon(epsilon_inner, epsilon_outer);
+  return async_commands_->execute<research_interface::gripper::Grasp>(
+      &handleCommandResponse<research_interface::gripper::Grasp>, width, epsilon, speed, force);
+}
+
+std::future<bool> Gripper::moveAsync(double width, double speed) const {
+  return async_commands_->execute<research_interface::gripper::Move>(
+      &handleCommandResponse<research_interface::gripper::Move>, width, speed);
+}
+
+std::future<bool> Gripper::stopAsync() const {
+  return async_commands_->execute<research_interface::gripper::Stop>(
+      &handleCommandResponse<research_interface::gripper::Stop>);
+}
+
 GripperState Gripper::readOnce() const {
+  if (subscription_) {
+    return subscription_->next();
+  }
+
   research_interface::gripper::GripperState gripper_state;
   // Delete old data from the UDP buffer.
   while (network_->udpReceive<decltype(gripper_state)>(&gripper_state)) {
@@ -92,4 +155,25 @@ GripperState Gripper::readOnce() const {
   return convertGripperState(gripper_state);
 }
 
+void Gripper::subscribe(StateCallback callback) {
+  if (subscription_) {
+    throw InvalidOperationException("libfranka gripper: Already subscribed to the gripper state.");
+  }
+  auto subscription =
+      std::make_unique<Subscription>(*network_, &convertGripperState, std::move(callback));
+  subscription->next();
+  subscription_ = std::move(subscription);
+}
+
+void Gripper::unsubscribe() noexcept {
+  subscription_.reset();
+}
+
+GripperState Gripper::latestState() const {
+  if (!subscription_) {
+    throw InvalidOperationException("libfranka gripper: Not subscribed to the gripper state.");
+  }
+  return subscription_->latest();
+}
+
 }  // namespace franka
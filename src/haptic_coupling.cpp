@@ -0,0 +1,221 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_coupling.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "platform.h"
+#include "triple_buffer.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <pthread.h>
+#endif
+
+namespace franka {
+namespace haptics {
+
+constexpr size_t LocalModel::kMaxPlanes;
+
+bool LocalModel::addPlane(const std::array<double, 3>& point,
+                          const std::array<double, 3>& normal,
+                          const Material& material) noexcept {
+  double length = Eigen::Map<const Eigen::Vector3d>(normal.data()).norm();
+  if (plane_count >= kMaxPlanes || !(length > 0) || !std::isfinite(length)) {
+    return false;
+  }
+  ContactPlane& plane = planes[plane_count++];
+  plane.point = point;
+  for (size_t i = 0; i < 3; i++) {
+    plane.normal[i] = normal[i] / length;
+  }
+  plane.material = material;
+  return true;
+}
+
+SceneWrench renderLocalModel(
+    const LocalModel& model,
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity,
+    const std::array<double, 3>& probe_offset) noexcept {
+  using Eigen::Vector3d;
+  Eigen::Map<const Eigen::Matrix4d> transform(O_T_EE.data());
+  Vector3d origin = transform.topRightCorner<3, 1>();
+  Vector3d probe =
+      transform.topLeftCorner<3, 3>() * Eigen::Map<const Vector3d>(probe_offset.data()) + origin;
+  Eigen::Map<const Vector3d> probe_velocity(velocity.data());
+
+  SceneWrench result;
+  Vector3d force = Eigen::Map<const Vector3d>(&model.O_F_feedforward[0]);
+  Vector3d torque = Eigen::Map<const Vector3d>(&model.O_F_feedforward[3]);
+  for (size_t i = 0; i < std::min(model.plane_count, LocalModel::kMaxPlanes); i++) {
+    const ContactPlane& plane = model.planes[i];
+    Eigen::Map<const Vector3d> normal(plane.normal.data());
+    double penetration = -normal.dot(probe - Eigen::Map<const Vector3d>(plane.point.data()));
+    if (!(penetration > 0)) {
+      continue;
+    }
+    double normal_force = plane.material.stiffness * penetration -
+                          plane.material.damping * probe_velocity.dot(normal);
+    Vector3d contact_force = std::max(normal_force, 0.0) * normal;
+    force += contact_force;
+    torque += (probe - origin).cross(contact_force);
+    result.contacts++;
+    result.max_penetration = std::max(result.max_penetration, penetration);
+  }
+  Eigen::Map<Vector3d>(&result.O_F[0]) = force;
+  Eigen::Map<Vector3d>(&result.O_F[3]) = torque;
+  return result;
+}
+
+class MultiRateCoupling::Impl {
+ public:
+  Impl(UpdateFunction update, double update_rate, const std::array<double, 3>& probe_offset)
+      : update_(std::move(update)),
+        period_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / update_rate))),
+        probe_offset_(probe_offset) {
+    thread_ = std::thread(&Impl::run, this);
+  }
+
+  ~Impl() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    condition_.notify_one();
+    thread_.join();
+  }
+
+  SceneWrench render(const RobotState& robot_state,
+                     const std::array<double, 3>& velocity) noexcept {
+    states_.write(robot_state);
+    models_.acquire();
+    const LocalModel& model = models_.front();
+    age_ = model.time <= robot_state.time ? robot_state.time - model.time : Duration();
+    if (failed_.load(std::memory_order_acquire)) {
+      return {};
+    }
+    return renderLocalModel(model, robot_state.O_T_EE, velocity, probe_offset_);
+  }
+
+  const LocalModel& model() const noexcept { return models_.front(); }
+
+  Duration modelAge() const noexcept { return age_; }
+
+  uint64_t updates() const noexcept { return updates_.load(std::memory_order_relaxed); }
+
+  std::exception_ptr error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+  }
+
+ private:
+  void run() noexcept {
+#ifdef LIBFRANKA_LINUX
+    // Do not inherit a realtime policy from the thread that created the coupling.
+    sched_param parameters{};
+    parameters.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &parameters);
+#endif
+    LocalModel model;
+    bool first_update = true;
+    Duration last_time;
+    auto next_update = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+      lock.unlock();
+      if (states_.acquire()) {
+        const RobotState& robot_state = states_.front();
+        Duration elapsed = first_update || robot_state.time < last_time
+                               ? Duration()
+                               : robot_state.time - last_time;
+        try {
+          update_(robot_state, elapsed, &model);
+        } catch (...) {
+          models_.write(LocalModel());
+          failed_.store(true, std::memory_order_release);
+          lock.lock();
+          error_ = std::current_exception();
+          return;
+        }
+        model.plane_count = std::min(model.plane_count, LocalModel::kMaxPlanes);
+        model.time = robot_state.time;
+        models_.write(model);
+        last_time = robot_state.time;
+        first_update = false;
+        updates_.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      // Skip missed updates instead of catching up.
+      next_update = std::max(next_update + period_, std::chrono::steady_clock::now());
+      lock.lock();
+      condition_.wait_until(lock, next_update, [this]() { return !running_; });
+    }
+  }
+
+  UpdateFunction update_;
+  const std::chrono::steady_clock::duration period_;
+  const std::array<double, 3> probe_offset_;
+
+  TripleBuffer<RobotState> states_;
+  TripleBuffer<LocalModel> models_;
+  Duration age_;
+
+  std::atomic<bool> failed_{false};
+  std::atomic<uint64_t> updates_{0};
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  bool running_{true};
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+MultiRateCoupling::MultiRateCoupling(UpdateFunction update,
+                                     double update_rate,
+                                     const std::array<double, 3>& probe_offset) {
+  if (!update) {
+    throw std::invalid_argument("libfranka: Multi-rate coupling needs an update function.");
+  }
+  if (!(update_rate > 0) || update_rate > 1000) {
+    throw std::invalid_argument("libfranka: Multi-rate coupling update rate must be in (0, 1000].");
+  }
+  impl_.reset(new Impl(std::move(update), update_rate, probe_offset));
+}
+
+MultiRateCoupling::~MultiRateCoupling() noexcept = default;
+
+SceneWrench MultiRateCoupling::render(const RobotState& robot_state,
+                                      const std::array<double, 3>& velocity) noexcept {
+  return impl_->render(robot_state, velocity);
+}
+
+const LocalModel& MultiRateCoupling::model() const noexcept {
+  return impl_->model();
+}
+
+Duration MultiRateCoupling::modelAge() const noexcept {
+  return impl_->modelAge();
+}
+
+uint64_t MultiRateCoupling::updates() const noexcept {
+  return impl_->updates();
+}
+
+std::exception_ptr MultiRateCoupling::error() const {
+  return impl_->error();
+}
+
+}  // namespace haptics
+}  // namespace franka
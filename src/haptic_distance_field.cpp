@@ -0,0 +1,346 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_distance_field.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+#include <franka/exception.h>
+
+#include "memory_mapped_file.h"
+
+namespace franka {
+namespace haptics {
+
+struct DistanceField::Storage {
+  // Owned buffer of fields that were created in memory, 8-byte aligned for the header.
+  std::vector<uint64_t> buffer;
+  std::unique_ptr<MemoryMappedFile> file;
+  const char* data{};
+  size_t size{};
+};
+
+namespace {
+
+constexpr char kMagic[8] = "FRKSDF";
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+// Distance followed by the three gradient components.
+constexpr size_t kVoxelChannels = 4;
+
+using Vector3d = Eigen::Vector3d;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t dimensions[3];
+  uint32_t reserved;
+  double origin[3];
+  double voxel_size;
+};
+
+static_assert(sizeof(FileHeader) == 64, "Unexpected distance field file header size.");
+
+constexpr size_t kVoxelSize = kVoxelChannels * sizeof(float);
+
+// Returns 0 if the grid does not fit into memory.
+size_t voxelCount(const std::array<uint32_t, 3>& dimensions) {
+  const size_t limit = (std::numeric_limits<size_t>::max() - sizeof(FileHeader)) / kVoxelSize;
+  size_t count = 1;
+  for (uint32_t dimension : dimensions) {
+    if (dimension != 0 && count > limit / dimension) {
+      return 0;
+    }
+    count *= dimension;
+  }
+  return count;
+}
+
+void checkPose(const std::array<double, 16>& pose) {
+  if (!std::all_of(pose.begin(), pose.end(), [](double d) { return std::isfinite(d); }) ||
+      !isHomogeneousTransformation(pose)) {
+    throw std::invalid_argument(
+        "libfranka: Distance field pose is not a homogeneous transformation.");
+  }
+}
+
+}  // anonymous namespace
+
+DistanceField::DistanceField(const std::array<uint32_t, 3>& dimensions,
+                             const std::array<double, 3>& origin,
+                             double voxel_size,
+                             const std::vector<float>& distances) {
+  if (std::any_of(dimensions.begin(), dimensions.end(), [](uint32_t d) { return d < 2; })) {
+    throw std::invalid_argument("libfranka: Distance field needs at least 2 voxels per axis.");
+  }
+  size_t count = voxelCount(dimensions);
+  if (count == 0) {
+    throw std::invalid_argument("libfranka: Distance field is too large.");
+  }
+  if (distances.size() != count) {
+    throw std::invalid_argument(
+        "libfranka: Number of distance field values does not match the dimensions.");
+  }
+  if (!(voxel_size > 0) || !std::isfinite(voxel_size) ||
+      !std::all_of(origin.begin(), origin.end(), [](double d) { return std::isfinite(d); }) ||
+      !std::all_of(distances.begin(), distances.end(), [](float d) { return std::isfinite(d); })) {
+    throw std::invalid_argument("libfranka: Distance field value is infinite, NaN or negative.");
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrderMark;
+  std::copy(dimensions.begin(), dimensions.end(), header.dimensions);
+  std::copy(origin.begin(), origin.end(), header.origin);
+  header.voxel_size = voxel_size;
+
+  auto storage = std::make_shared<Storage>();
+  storage->size = sizeof(FileHeader) + count * kVoxelSize;
+  storage->buffer.resize(storage->size / sizeof(uint64_t));
+  char* data = reinterpret_cast<char*>(storage->buffer.data());
+  storage->data = data;
+  std::memcpy(data, &header, sizeof(header));
+
+  // Central differences inside the grid, one-sided differences at its bounds.
+  float* voxels = reinterpret_cast<float*>(data + sizeof(FileHeader));
+  const std::array<size_t, 3> strides{{1, dimensions[0], size_t{dimensions[0]} * dimensions[1]}};
+  std::array<uint32_t, 3> index{};
+  for (index[2] = 0; index[2] < dimensions[2]; index[2]++) {
+    for (index[1] = 0; index[1] < dimensions[1]; index[1]++) {
+      for (index[0] = 0; index[0] < dimensions[0]; index[0]++) {
+        size_t voxel = index[0] + strides[1] * index[1] + strides[2] * index[2];
+        float* output = voxels + kVoxelChannels * voxel;
+        output[0] = distances[voxel];
+        for (size_t axis = 0; axis < 3; axis++) {
+          size_t previous = index[axis] > 0 ? voxel - strides[axis] : voxel;
+          size_t next = index[axis] + 1 < dimensions[axis] ? voxel + strides[axis] : voxel;
+          double steps = (next - previous) / strides[axis];
+          output[axis + 1] = static_cast<float>(
+              (static_cast<double>(distances[next]) - distances[previous]) / (steps * voxel_size));
+        }
+      }
+    }
+  }
+
+  storage_ = std::move(storage);
+  parse();
+}
+
+DistanceField::DistanceField(std::shared_ptr<const Storage> storage)
+    : storage_(std::move(storage)) {
+  parse();
+}
+
+void DistanceField::parse() {
+  const char* data = storage_->data;
+  size_t size = storage_->size;
+
+  FileHeader header{};
+  if (size < sizeof(header)) {
+    throw Exception("libfranka: Distance field file is too short.");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw Exception("libfranka: Not a distance field file.");
+  }
+  if (header.version != kVersion || header.byte_order != kByteOrderMark) {
+    throw Exception("libfranka: Unsupported distance field file version or byte order.");
+  }
+  std::copy(header.dimensions, header.dimensions + 3, dimensions_.begin());
+  size_t count = voxelCount(dimensions_);
+  if (std::any_of(dimensions_.begin(), dimensions_.end(), [](uint32_t d) { return d < 2; }) ||
+      count == 0 || size != sizeof(FileHeader) + count * kVoxelSize) {
+    throw Exception("libfranka: Distance field file has an invalid size.");
+  }
+  std::copy(header.origin, header.origin + 3, origin_.begin());
+  voxel_size_ = header.voxel_size;
+  voxels_ = reinterpret_cast<const float*>(data + sizeof(FileHeader));
+
+  // Validate everything a lookup relies on, so that corrupt files cannot produce invalid forces.
+  if (!(voxel_size_ > 0) || !std::isfinite(voxel_size_) ||
+      !std::all_of(origin_.begin(), origin_.end(), [](double d) { return std::isfinite(d); }) ||
+      !std::all_of(voxels_, voxels_ + kVoxelChannels * count,
+                   [](float d) { return std::isfinite(d); })) {
+    throw Exception("libfranka: Distance field file has an infinite or NaN value.");
+  }
+}
+
+DistanceField DistanceField::load(const std::string& path) {
+  auto storage = std::make_shared<Storage>();
+  storage->file.reset(new MemoryMappedFile(path));
+  storage->data = storage->file->data();
+  storage->size = storage->file->size();
+
+  try {
+    return DistanceField(std::move(storage));
+  } catch (const Exception& exception) {
+    throw Exception(exception.what() + std::string(" (") + path + ")");
+  }
+}
+
+void DistanceField::save(const std::string& path) const {
+  std::ofstream stream(path.c_str(), std::ios_base::out | std::ios_base::binary);
+  stream.write(storage_->data, static_cast<std::streamsize>(storage_->size));
+  if (!stream) {
+    throw Exception("libfranka: Unable to write distance field file " + path);
+  }
+}
+
+std::array<uint32_t, 3> DistanceField::dimensions() const noexcept {
+  return dimensions_;
+}
+
+std::array<double, 3> DistanceField::origin() const noexcept {
+  return origin_;
+}
+
+double DistanceField::voxelSize() const noexcept {
+  return voxel_size_;
+}
+
+double DistanceField::distance(const std::array<double, 3>& point,
+                               std::array<double, 3>* gradient) const noexcept {
+  std::array<uint32_t, 3> cell{};
+  std::array<double, 3> fraction{};
+  double outside_squared = 0;
+  for (size_t axis = 0; axis < 3; axis++) {
+    double local = (point[axis] - origin_[axis]) / voxel_size_;
+    // Written so that NaN is clamped to 0 and the cell index stays valid.
+    double clamped = std::min(std::max(0.0, local), dimensions_[axis] - 1.0);
+    double outside = (local - clamped) * voxel_size_;
+    outside_squared += outside * outside;
+    cell[axis] = std::min(static_cast<uint32_t>(clamped), dimensions_[axis] - 2);
+    fraction[axis] = clamped - cell[axis];
+  }
+
+  const size_t stride_y = dimensions_[0];
+  const size_t stride_z = stride_y * dimensions_[1];
+  std::array<double, kVoxelChannels> value{};
+  for (size_t corner = 0; corner < 8; corner++) {
+    std::array<size_t, 3> offset{{corner & 1, (corner >> 1) & 1, (corner >> 2) & 1}};
+    double weight = 1;
+    for (size_t axis = 0; axis < 3; axis++) {
+      weight *= offset[axis] != 0 ? fraction[axis] : 1 - fraction[axis];
+    }
+    const float* voxel = voxels_ + kVoxelChannels * ((cell[0] + offset[0]) +
+                                                     stride_y * (cell[1] + offset[1]) +
+                                                     stride_z * (cell[2] + offset[2]));
+    for (size_t channel = 0; channel < kVoxelChannels; channel++) {
+      value[channel] += weight * voxel[channel];
+    }
+  }
+
+  if (gradient != nullptr) {
+    std::copy(value.begin() + 1, value.end(), gradient->begin());
+  }
+  return value[0] + std::sqrt(outside_squared);
+}
+
+DistanceFieldRenderer::DistanceFieldRenderer(
+    DistanceField field,
+    std::vector<ProbePoint> probes,
+    const Material& material,
+    const std::array<double, 16>& O_T_F)  // NOLINT(readability-identifier-naming)
+    : field_(std::move(field)), probes_(std::move(probes)), material_(material) {
+  if (!(material.stiffness >= 0) || !std::isfinite(material.stiffness) ||
+      !(material.damping >= 0) || !std::isfinite(material.damping)) {
+    throw std::invalid_argument("libfranka: Haptic material parameters must be non-negative.");
+  }
+  for (const ProbePoint& probe : probes_) {
+    if (static_cast<size_t>(probe.frame) >= kFrameCount || !(probe.radius >= 0) ||
+        !std::isfinite(probe.radius) ||
+        !std::all_of(probe.position.begin(), probe.position.end(),
+                     [](double d) { return std::isfinite(d); })) {
+      throw std::invalid_argument("libfranka: Distance field probe is invalid.");
+    }
+  }
+  setFieldPose(O_T_F);
+}
+
+ProbeTorques DistanceFieldRenderer::render(const Model& model,
+                                           const RobotState& robot_state) noexcept {
+  model.poseAll(robot_state, &poses_, &zero_jacobians_);
+  return render(poses_, zero_jacobians_, robot_state.dq);
+}
+
+ProbeTorques DistanceFieldRenderer::render(const FramePoses& poses,
+                                           const FrameJacobians& zero_jacobians,
+                                           const std::array<double, 7>& dq) const noexcept {
+  using Jacobian = Eigen::Matrix<double, 6, 7>;
+  Eigen::Map<const Eigen::Matrix3d> rotation(rotation_.data());
+  Eigen::Map<const Vector3d> translation(translation_.data());
+  Eigen::Map<const Eigen::Matrix<double, 7, 1>> joint_velocities(dq.data());
+
+  ProbeTorques result;
+  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau(result.tau_J.data());
+  for (const ProbePoint& probe : probes_) {
+    size_t frame = static_cast<size_t>(probe.frame);
+    Eigen::Map<const Eigen::Matrix4d> transform(poses[frame].data());
+    // Offset of the probe from the frame origin, in base frame.
+    Vector3d lever =
+        transform.topLeftCorner<3, 3>() * Eigen::Map<const Vector3d>(probe.position.data());
+    Vector3d probe_position = lever + transform.topRightCorner<3, 1>();
+
+    std::array<double, 3> point{};
+    std::array<double, 3> gradient{};
+    Eigen::Map<Vector3d>(point.data()) = rotation.transpose() * (probe_position - translation);
+    double penetration = probe.radius - field_.distance(point, &gradient);
+    if (!(penetration > 0)) {
+      continue;
+    }
+    Vector3d normal = rotation * Eigen::Map<const Vector3d>(gradient.data());
+    double length = normal.norm();
+    if (!(length > 0)) {
+      continue;
+    }
+    normal /= length;
+
+    Eigen::Map<const Jacobian> jacobian(zero_jacobians[frame].data());
+    Vector3d velocity = jacobian.topRows<3>() * joint_velocities +
+                        (jacobian.bottomRows<3>() * joint_velocities).cross(lever);
+    double normal_force =
+        material_.stiffness * penetration - material_.damping * velocity.dot(normal);
+    Vector3d force = std::max(normal_force, 0.0) * normal;
+    tau += jacobian.topRows<3>().transpose() * force +
+           jacobian.bottomRows<3>().transpose() * lever.cross(force);
+    result.contacts++;
+    result.max_penetration = std::max(result.max_penetration, penetration);
+  }
+  return result;
+}
+
+void DistanceFieldRenderer::setField(DistanceField field) noexcept {
+  field_ = std::move(field);
+}
+
+void DistanceFieldRenderer::setFieldPose(
+    const std::array<double, 16>& O_T_F) {  // NOLINT(readability-identifier-naming)
+  checkPose(O_T_F);
+  for (size_t column = 0; column < 3; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      rotation_[3 * column + row] = O_T_F[4 * column + row];
+    }
+    translation_[column] = O_T_F[12 + column];
+  }
+}
+
+const DistanceField& DistanceFieldRenderer::field() const noexcept {
+  return field_;
+}
+
+const std::vector<ProbePoint>& DistanceFieldRenderer::probes() const noexcept {
+  return probes_;
+}
+
+}  // namespace haptics
+}  // namespace franka
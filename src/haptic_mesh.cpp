@@ -0,0 +1,569 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+#include <franka/exception.h>
+
+#include "memory_mapped_file.h"
+
+namespace franka {
+namespace haptics {
+
+struct TriangleMesh::Node {
+  std::array<double, 3> min;
+  std::array<double, 3> max;
+  // Inner nodes have count == 0, their left child directly follows them and their right child is
+  // at first. Leaves contain the triangles [first, first + count).
+  uint32_t first;
+  uint32_t count;
+};
+
+struct TriangleMesh::Storage {
+  // Owned buffer of meshes that were created in memory, 8-byte aligned for the vertices.
+  std::vector<uint64_t> buffer;
+  std::unique_ptr<MemoryMappedFile> file;
+  const char* data{};
+  size_t size{};
+};
+
+namespace {
+
+constexpr char kMagic[8] = "FRKMESH";
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Leaves with at most this many triangles are not split further.
+constexpr uint32_t kLeafSize = 4;
+// Bounds the depth of the hierarchy and thereby the traversal stack of a query.
+constexpr uint32_t kMaxDepth = 32;
+// Tolerance of the barycentric coordinates, so that rays do not slip through shared edges.
+constexpr double kEdgeTolerance = 1e-9;
+// Distance that the proxy keeps in front of the faces it touches. Unit: [m]
+constexpr double kSurfaceDistance = 1e-6;
+
+using Vector3d = Eigen::Vector3d;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t vertex_count;
+  uint32_t triangle_count;
+  uint32_t node_count;
+  uint32_t reserved;
+};
+
+struct BuildNode {
+  std::array<double, 3> min;
+  std::array<double, 3> max;
+  uint32_t first;
+  uint32_t count;
+};
+
+struct BuildTriangle {
+  std::array<double, 3> min;
+  std::array<double, 3> max;
+  std::array<uint32_t, 3> vertices;
+};
+
+static_assert(sizeof(FileHeader) == 32, "Unexpected mesh file header size.");
+static_assert(sizeof(BuildNode) == 56, "Unexpected mesh file node size.");
+
+size_t trianglesOffset(uint32_t vertex_count) {
+  return sizeof(FileHeader) + 3 * sizeof(double) * vertex_count;
+}
+
+size_t nodesOffset(uint32_t vertex_count, uint32_t triangle_count) {
+  size_t triangle_bytes = 3 * sizeof(uint32_t) * triangle_count;
+  return trianglesOffset(vertex_count) + (triangle_bytes + 7) / 8 * 8;
+}
+
+size_t fileSize(uint32_t vertex_count, uint32_t triangle_count, uint32_t node_count) {
+  return nodesOffset(vertex_count, triangle_count) + sizeof(BuildNode) * node_count;
+}
+
+uint32_t buildHierarchy(uint32_t first,
+                        uint32_t count,
+                        uint32_t depth,
+                        std::vector<BuildTriangle>* triangles,
+                        std::vector<BuildNode>* nodes) {
+  auto begin = triangles->begin() + first;
+  auto end = begin + count;
+
+  BuildNode node{begin->min, begin->max, first, count};
+  std::array<double, 3> centers_min{}, centers_max{};
+  centers_min.fill(std::numeric_limits<double>::infinity());
+  centers_max.fill(-std::numeric_limits<double>::infinity());
+  for (auto it = begin; it != end; ++it) {
+    for (size_t i = 0; i < 3; i++) {
+      node.min[i] = std::min(node.min[i], it->min[i]);
+      node.max[i] = std::max(node.max[i], it->max[i]);
+      double center = 0.5 * (it->min[i] + it->max[i]);
+      centers_min[i] = std::min(centers_min[i], center);
+      centers_max[i] = std::max(centers_max[i], center);
+    }
+  }
+
+  uint32_t index = static_cast<uint32_t>(nodes->size());
+  nodes->push_back(node);
+  if (count <= kLeafSize || depth >= kMaxDepth) {
+    return index;
+  }
+
+  // Split at the median along the axis in which the triangle centers spread most.
+  size_t axis = 0;
+  for (size_t i = 1; i < 3; i++) {
+    if (centers_max[i] - centers_min[i] > centers_max[axis] - centers_min[axis]) {
+      axis = i;
+    }
+  }
+  uint32_t half = count / 2;
+  std::nth_element(begin, begin + half, end,
+                   [axis](const BuildTriangle& a, const BuildTriangle& b) {
+                     return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+                   });
+
+  buildHierarchy(first, half, depth + 1, triangles, nodes);
+  uint32_t right = buildHierarchy(first + half, count - half, depth + 1, triangles, nodes);
+  (*nodes)[index].first = right;
+  (*nodes)[index].count = 0;
+  return index;
+}
+
+// Intersects the segment start + t * direction, t in [0, max_fraction], with the front face of a
+// triangle.
+bool intersectTriangle(const Vector3d& start,
+                       const Vector3d& direction,
+                       const Vector3d& v0,
+                       const Vector3d& v1,
+                       const Vector3d& v2,
+                       double max_fraction,
+                       double* fraction) {
+  Vector3d edge1 = v1 - v0;
+  Vector3d edge2 = v2 - v0;
+  Vector3d p = direction.cross(edge2);
+  // Positive for segments that hit the front face.
+  double determinant = edge1.dot(p);
+  if (!(determinant > 0)) {
+    return false;
+  }
+  Vector3d s = start - v0;
+  double u = s.dot(p) / determinant;
+  if (u < -kEdgeTolerance || u > 1 + kEdgeTolerance) {
+    return false;
+  }
+  Vector3d q = s.cross(edge1);
+  double v = direction.dot(q) / determinant;
+  if (v < -kEdgeTolerance || u + v > 1 + kEdgeTolerance) {
+    return false;
+  }
+  double t = edge2.dot(q) / determinant;
+  if (t < 0 || t > max_fraction) {
+    return false;
+  }
+  *fraction = t;
+  return true;
+}
+
+// Intersects the segment start + t * direction, t in [0, max_fraction], with bounds.
+bool intersectBounds(const Vector3d& start,
+                     const Vector3d& direction,
+                     const std::array<double, 3>& min,
+                     const std::array<double, 3>& max,
+                     double max_fraction) {
+  double entry = 0;
+  double exit = max_fraction;
+  for (size_t i = 0; i < 3; i++) {
+    if (direction[i] == 0) {
+      if (start[i] < min[i] || start[i] > max[i]) {
+        return false;
+      }
+      continue;
+    }
+    double t1 = (min[i] - start[i]) / direction[i];
+    double t2 = (max[i] - start[i]) / direction[i];
+    entry = std::max(entry, std::min(t1, t2));
+    exit = std::min(exit, std::max(t1, t2));
+    if (entry > exit) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void checkMaterial(const Material& material) {
+  if (!(material.stiffness >= 0) || !std::isfinite(material.stiffness) ||
+      !(material.damping >= 0) || !std::isfinite(material.damping)) {
+    throw std::invalid_argument("libfranka: Haptic material parameters must be non-negative.");
+  }
+}
+
+void checkPose(const std::array<double, 16>& pose) {
+  if (!std::all_of(pose.begin(), pose.end(), [](double d) { return std::isfinite(d); }) ||
+      !isHomogeneousTransformation(pose)) {
+    throw std::invalid_argument(
+        "libfranka: Haptic mesh pose is not a homogeneous transformation.");
+  }
+}
+
+}  // anonymous namespace
+
+TriangleMesh::TriangleMesh(const std::vector<std::array<double, 3>>& vertices,
+                           const std::vector<std::array<uint32_t, 3>>& triangles) {
+  if (triangles.empty()) {
+    throw std::invalid_argument("libfranka: Haptic mesh has no triangles.");
+  }
+  if (vertices.size() > std::numeric_limits<uint32_t>::max() ||
+      triangles.size() > std::numeric_limits<uint32_t>::max() / 2) {
+    throw std::invalid_argument("libfranka: Haptic mesh is too large.");
+  }
+  for (const auto& vertex : vertices) {
+    if (!std::all_of(vertex.begin(), vertex.end(), [](double d) { return std::isfinite(d); })) {
+      throw std::invalid_argument("libfranka: Haptic mesh vertex is infinite or NaN.");
+    }
+  }
+
+  std::vector<BuildTriangle> build_triangles;
+  build_triangles.reserve(triangles.size());
+  for (const auto& triangle : triangles) {
+    BuildTriangle build_triangle{};
+    build_triangle.vertices = triangle;
+    build_triangle.min.fill(std::numeric_limits<double>::infinity());
+    build_triangle.max.fill(-std::numeric_limits<double>::infinity());
+    for (uint32_t index : triangle) {
+      if (index >= vertices.size()) {
+        throw std::invalid_argument("libfranka: Haptic mesh vertex index is out of range.");
+      }
+      for (size_t i = 0; i < 3; i++) {
+        build_triangle.min[i] = std::min(build_triangle.min[i], vertices[index][i]);
+        build_triangle.max[i] = std::max(build_triangle.max[i], vertices[index][i]);
+      }
+    }
+    build_triangles.push_back(build_triangle);
+  }
+
+  std::vector<BuildNode> nodes;
+  nodes.reserve(2 * build_triangles.size());
+  buildHierarchy(0, static_cast<uint32_t>(build_triangles.size()), 0, &build_triangles, &nodes);
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrderMark;
+  header.vertex_count = static_cast<uint32_t>(vertices.size());
+  header.triangle_count = static_cast<uint32_t>(build_triangles.size());
+  header.node_count = static_cast<uint32_t>(nodes.size());
+
+  auto storage = std::make_shared<Storage>();
+  storage->size = fileSize(header.vertex_count, header.triangle_count, header.node_count);
+  storage->buffer.resize(storage->size / sizeof(uint64_t));
+  char* data = reinterpret_cast<char*>(storage->buffer.data());
+  storage->data = data;
+
+  std::memcpy(data, &header, sizeof(header));
+  double* vertex_data = reinterpret_cast<double*>(data + sizeof(FileHeader));
+  for (const auto& vertex : vertices) {
+    vertex_data = std::copy(vertex.begin(), vertex.end(), vertex_data);
+  }
+  uint32_t* triangle_data =
+      reinterpret_cast<uint32_t*>(data + trianglesOffset(header.vertex_count));
+  for (const auto& triangle : build_triangles) {
+    triangle_data = std::copy(triangle.vertices.begin(), triangle.vertices.end(), triangle_data);
+  }
+  std::memcpy(data + nodesOffset(header.vertex_count, header.triangle_count), nodes.data(),
+              nodes.size() * sizeof(BuildNode));
+
+  storage_ = std::move(storage);
+  parse();
+}
+
+TriangleMesh::TriangleMesh(std::shared_ptr<const Storage> storage) : storage_(std::move(storage)) {
+  parse();
+}
+
+void TriangleMesh::parse() {
+  const char* data = storage_->data;
+  size_t size = storage_->size;
+
+  FileHeader header{};
+  if (size < sizeof(header)) {
+    throw Exception("libfranka: Haptic mesh file is too short.");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw Exception("libfranka: Not a haptic mesh file.");
+  }
+  if (header.version != kVersion || header.byte_order != kByteOrderMark) {
+    throw Exception("libfranka: Unsupported haptic mesh file version or byte order.");
+  }
+  if (header.triangle_count == 0 || header.node_count == 0 ||
+      size != fileSize(header.vertex_count, header.triangle_count, header.node_count)) {
+    throw Exception("libfranka: Haptic mesh file has an invalid size.");
+  }
+
+  vertex_count_ = header.vertex_count;
+  triangle_count_ = header.triangle_count;
+  node_count_ = header.node_count;
+  vertices_ = reinterpret_cast<const double*>(data + sizeof(FileHeader));
+  triangles_ = reinterpret_cast<const uint32_t*>(data + trianglesOffset(vertex_count_));
+  nodes_ = reinterpret_cast<const Node*>(data + nodesOffset(vertex_count_, triangle_count_));
+
+  // Validate everything a query relies on, so that corrupt files cannot cause out-of-bounds reads.
+  for (size_t i = 0; i < 3 * static_cast<size_t>(triangle_count_); i++) {
+    if (triangles_[i] >= vertex_count_) {
+      throw Exception("libfranka: Haptic mesh file has an invalid vertex index.");
+    }
+  }
+  std::vector<uint32_t> depth(node_count_);
+  for (uint32_t i = 0; i < node_count_; i++) {
+    const Node& node = nodes_[i];
+    if (node.count == 0) {
+      if (i + 1 >= node_count_ || node.first <= i + 1 || node.first >= node_count_ ||
+          depth[i] >= kMaxDepth) {
+        throw Exception("libfranka: Haptic mesh file has an invalid hierarchy.");
+      }
+      depth[i + 1] = std::max(depth[i + 1], depth[i] + 1);
+      depth[node.first] = std::max(depth[node.first], depth[i] + 1);
+    } else if (static_cast<uint64_t>(node.first) + node.count > triangle_count_) {
+      throw Exception("libfranka: Haptic mesh file has an invalid hierarchy.");
+    }
+  }
+}
+
+TriangleMesh TriangleMesh::load(const std::string& path) {
+  auto storage = std::make_shared<Storage>();
+  storage->file.reset(new MemoryMappedFile(path));
+  storage->data = storage->file->data();
+  storage->size = storage->file->size();
+
+  try {
+    return TriangleMesh(std::move(storage));
+  } catch (const Exception& exception) {
+    throw Exception(exception.what() + std::string(" (") + path + ")");
+  }
+}
+
+void TriangleMesh::save(const std::string& path) const {
+  std::ofstream stream(path.c_str(), std::ios_base::out | std::ios_base::binary);
+  stream.write(storage_->data, static_cast<std::streamsize>(storage_->size));
+  if (!stream) {
+    throw Exception("libfranka: Unable to write haptic mesh file " + path);
+  }
+}
+
+size_t TriangleMesh::vertexCount() const noexcept {
+  return vertex_count_;
+}
+
+size_t TriangleMesh::triangleCount() const noexcept {
+  return triangle_count_;
+}
+
+std::array<double, 3> TriangleMesh::vertex(size_t index) const noexcept {
+  return {{vertices_[3 * index], vertices_[3 * index + 1], vertices_[3 * index + 2]}};
+}
+
+std::array<uint32_t, 3> TriangleMesh::triangle(size_t index) const noexcept {
+  return {{triangles_[3 * index], triangles_[3 * index + 1], triangles_[3 * index + 2]}};
+}
+
+MeshRenderer::MeshRenderer(
+    TriangleMesh mesh,
+    const Material& material,
+    const std::array<double, 16>& O_T_M,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& probe_offset)
+    : mesh_(std::move(mesh)), material_(material), probe_offset_(probe_offset) {
+  checkMaterial(material);
+  if (!std::all_of(probe_offset.begin(), probe_offset.end(),
+                   [](double d) { return std::isfinite(d); })) {
+    throw std::invalid_argument("libfranka: Haptic probe offset is infinite or NaN.");
+  }
+  setMeshPose(O_T_M);
+}
+
+SceneWrench MeshRenderer::render(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity) noexcept {
+  Eigen::Map<const Eigen::Matrix4d> transform(O_T_EE.data());
+  Eigen::Map<const Eigen::Matrix3d> rotation(rotation_.data());
+  Eigen::Map<const Vector3d> translation(translation_.data());
+  Eigen::Map<const Vector3d> probe_offset(probe_offset_.data());
+  Vector3d origin = transform.topRightCorner<3, 1>();
+  Vector3d probe = transform.topLeftCorner<3, 3>() * probe_offset + origin;
+
+  // The proxy is tracked in mesh frame.
+  Vector3d goal = rotation.transpose() * (probe - translation);
+  Eigen::Map<Vector3d> proxy(proxy_.data());
+  if (!initialized_) {
+    proxy = goal;
+    constraint_count_ = 0;
+    initialized_ = true;
+  }
+
+  std::array<uint32_t, kMaxConstraints> previous_constraints = constraints_;
+  size_t previous_count = constraint_count_;
+  size_t count = 0;
+
+  auto vertex = [this](uint32_t triangle, size_t corner) {
+    uint32_t index = mesh_.triangles_[3 * triangle + corner];
+    return Eigen::Map<const Vector3d>(mesh_.vertices_ + 3 * index);
+  };
+
+  // Finds the first front face between proxy and target that is not a constraint yet.
+  auto intersect = [&](const Vector3d& target, uint32_t* hit, double* hit_fraction) {
+    Vector3d direction = target - proxy;
+    double fraction = 1;
+    bool found = false;
+    auto test = [&](uint32_t triangle) {
+      if (std::find(constraints_.begin(), constraints_.begin() + count, triangle) !=
+          constraints_.begin() + count) {
+        return;
+      }
+      double t;
+      if (intersectTriangle(proxy, direction, vertex(triangle, 0), vertex(triangle, 1),
+                            vertex(triangle, 2), fraction, &t)) {
+        fraction = t;
+        *hit = triangle;
+        found = true;
+      }
+    };
+
+    // Faces touched in the last cycle are the most likely hits and tighten the search early.
+    for (size_t i = 0; i < previous_count; i++) {
+      test(previous_constraints[i]);
+    }
+
+    std::array<uint32_t, kMaxDepth + 1> stack;
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+      uint32_t index = stack[--stack_size];
+      const TriangleMesh::Node& node = mesh_.nodes_[index];
+      if (!intersectBounds(proxy, direction, node.min, node.max, fraction)) {
+        continue;
+      }
+      if (node.count == 0) {
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = index + 1;
+        continue;
+      }
+      for (uint32_t triangle = node.first; triangle < node.first + node.count; triangle++) {
+        test(triangle);
+      }
+    }
+    *hit_fraction = fraction;
+    return found;
+  };
+
+  std::array<Vector3d, kMaxConstraints> normals;
+  Vector3d target = goal;
+  for (size_t iteration = 0; iteration <= kMaxConstraints; iteration++) {
+    uint32_t hit;
+    double fraction;
+    if (!intersect(target, &hit, &fraction)) {
+      proxy = target;
+      break;
+    }
+
+    // Stop in front of the face.
+    Vector3d normal = (vertex(hit, 1) - vertex(hit, 0)).cross(vertex(hit, 2) - vertex(hit, 0));
+    normal.normalize();
+    Vector3d direction = target - proxy;
+    double approach = -direction.dot(normal);
+    proxy += std::max(fraction - kSurfaceDistance / approach, 0.0) * direction;
+
+    if (count > 0 && normals[count - 1].cross(normal).norm() < kEdgeTolerance) {
+      // Coplanar with the last constraint, e.g. a neighbouring triangle.
+      constraints_[count - 1] = hit;
+    } else {
+      constraints_[count] = hit;
+      normals[count] = normal;
+      count++;
+    }
+    if (count == kMaxConstraints) {
+      break;
+    }
+
+    // Move the target as close to the probe as the constraints allow.
+    Vector3d on_last_plane = goal - (goal - proxy).dot(normals[count - 1]) * normals[count - 1];
+    if (count == 1) {
+      target = on_last_plane;
+      continue;
+    }
+    if ((on_last_plane - proxy).dot(normals[0]) >= 0) {
+      // The first constraint does not hold the proxy anymore.
+      constraints_[0] = constraints_[1];
+      normals[0] = normals[1];
+      count = 1;
+      target = on_last_plane;
+      continue;
+    }
+    Vector3d edge = normals[0].cross(normals[1]).normalized();
+    target = proxy + (goal - proxy).dot(edge) * edge;
+  }
+  constraint_count_ = count;
+
+  SceneWrench result;
+  Vector3d spring = proxy - goal;
+  double length = spring.norm();
+  if (count == 0 || !(length > 0)) {
+    return result;
+  }
+  Vector3d direction = rotation * spring / length;
+  Eigen::Map<const Vector3d> probe_velocity(velocity.data());
+  double normal_force =
+      material_.stiffness * length - material_.damping * probe_velocity.dot(direction);
+  Vector3d force = std::max(normal_force, 0.0) * direction;
+  Eigen::Map<Vector3d>(&result.O_F[0]) = force;
+  Eigen::Map<Vector3d>(&result.O_F[3]) = (probe - origin).cross(force);
+  result.contacts = count;
+  result.max_penetration = length;
+  return result;
+}
+
+SceneWrench MeshRenderer::render(const RobotState& robot_state,
+                                 const std::array<double, 3>& velocity) noexcept {
+  return render(robot_state.O_T_EE, velocity);
+}
+
+void MeshRenderer::reset() noexcept {
+  initialized_ = false;
+  constraint_count_ = 0;
+}
+
+void MeshRenderer::setMeshPose(
+    const std::array<double, 16>& O_T_M) {  // NOLINT(readability-identifier-naming)
+  checkPose(O_T_M);
+  for (size_t column = 0; column < 3; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      rotation_[3 * column + row] = O_T_M[4 * column + row];
+    }
+    translation_[column] = O_T_M[12 + column];
+  }
+}
+
+std::array<double, 3> MeshRenderer::proxy() const noexcept {
+  std::array<double, 3> proxy{};
+  Eigen::Map<Vector3d>(proxy.data()) = Eigen::Map<const Eigen::Matrix3d>(rotation_.data()) *
+                                           Eigen::Map<const Vector3d>(proxy_.data()) +
+                                       Eigen::Map<const Vector3d>(translation_.data());
+  return proxy;
+}
+
+const TriangleMesh& MeshRenderer::mesh() const noexcept {
+  return mesh_;
+}
+
+}  // namespace haptics
+}  // namespace franka
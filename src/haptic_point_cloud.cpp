@@ -0,0 +1,363 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_point_cloud.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+
+#include "platform.h"
+#include "triple_buffer.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <pthread.h>
+#endif
+
+namespace franka {
+namespace haptics {
+
+namespace {
+
+using Vector3d = Eigen::Vector3d;
+using VoxelKey = std::array<int32_t, 3>;
+
+// Edge length of the voxels of the index, relative to the probe radius.
+constexpr int kVoxelsPerRadius = 2;
+// Centroids whose spread along their second principal axis exceeds the one along the third by
+// this factor are treated as a locally planar surface.
+constexpr double kPlanarity = 4;
+// Points farther away from the base are skipped, so that voxel coordinates cannot overflow.
+constexpr double kMaxVoxelCoordinate = 1e9;
+
+struct IndexedPoint {
+  VoxelKey key;
+  std::array<double, 3> position;
+};
+
+struct Voxel {
+  VoxelKey key;
+  bool occupied;
+  std::array<double, 3> centroid;
+};
+
+// Spatial hash of a point cloud, mapping every occupied voxel to the centroid of its points. Uses
+// open addressing with a load factor of at most 0.5.
+struct PointCloudIndex {
+  std::vector<Voxel> table;
+  uint32_t mask{};
+  size_t voxel_count{};
+  double voxel_size{1};
+
+  const Voxel* find(const VoxelKey& key) const noexcept {
+    if (table.empty()) {
+      return nullptr;
+    }
+    for (uint32_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+      const Voxel& voxel = table[slot];
+      if (!voxel.occupied) {
+        return nullptr;
+      }
+      if (voxel.key == key) {
+        return &voxel;
+      }
+    }
+  }
+
+  static uint32_t hash(const VoxelKey& key) noexcept {
+    return (static_cast<uint32_t>(key[0]) * 73856093u) ^
+           (static_cast<uint32_t>(key[1]) * 19349663u) ^
+           (static_cast<uint32_t>(key[2]) * 83492791u);
+  }
+};
+
+bool voxelKey(const Vector3d& point, double voxel_size, VoxelKey* key) noexcept {
+  for (size_t i = 0; i < 3; i++) {
+    double coordinate = std::floor(point[i] / voxel_size);
+    if (!(std::abs(coordinate) < kMaxVoxelCoordinate)) {
+      return false;
+    }
+    (*key)[i] = static_cast<int32_t>(coordinate);
+  }
+  return true;
+}
+
+// Rebuilds the index in place, reusing its buffers and the scratch buffer.
+void buildIndex(const std::vector<std::array<double, 3>>& cloud,
+                const std::array<double, 16>& O_T_C,  // NOLINT(readability-identifier-naming)
+                double voxel_size,
+                std::vector<IndexedPoint>* scratch,
+                PointCloudIndex* index) {
+  Eigen::Map<const Eigen::Matrix4d> transform(O_T_C.data());
+  scratch->clear();
+  for (const auto& point : cloud) {
+    IndexedPoint indexed{};
+    Eigen::Map<Vector3d> position(indexed.position.data());
+    position = transform.topLeftCorner<3, 3>() * Eigen::Map<const Vector3d>(point.data()) +
+               transform.topRightCorner<3, 1>();
+    if (position.allFinite() && voxelKey(position, voxel_size, &indexed.key)) {
+      scratch->push_back(indexed);
+    }
+  }
+  std::sort(scratch->begin(), scratch->end(),
+            [](const IndexedPoint& a, const IndexedPoint& b) { return a.key < b.key; });
+
+  size_t voxel_count = 0;
+  for (size_t i = 0; i < scratch->size(); i++) {
+    if (i == 0 || (*scratch)[i].key != (*scratch)[i - 1].key) {
+      voxel_count++;
+    }
+  }
+  uint32_t table_size = 2;
+  while (table_size < 2 * voxel_count) {
+    table_size *= 2;
+  }
+
+  index->voxel_size = voxel_size;
+  index->voxel_count = voxel_count;
+  index->mask = table_size - 1;
+  index->table.assign(table_size, Voxel{});
+  for (size_t begin = 0; begin < scratch->size();) {
+    Voxel voxel{(*scratch)[begin].key, true, {}};
+    Vector3d sum = Vector3d::Zero();
+    size_t end = begin;
+    for (; end < scratch->size() && (*scratch)[end].key == voxel.key; end++) {
+      sum += Eigen::Map<const Vector3d>((*scratch)[end].position.data());
+    }
+    Eigen::Map<Vector3d>(voxel.centroid.data()) = sum / static_cast<double>(end - begin);
+
+    uint32_t slot = PointCloudIndex::hash(voxel.key) & index->mask;
+    while (index->table[slot].occupied) {
+      slot = (slot + 1) & index->mask;
+    }
+    index->table[slot] = voxel;
+    begin = end;
+  }
+}
+
+}  // anonymous namespace
+
+class PointCloudRenderer::Impl {
+ public:
+  Impl(double probe_radius, const Material& material, const std::array<double, 3>& probe_offset)
+      : probe_radius_(probe_radius), material_(material), probe_offset_(probe_offset) {
+    thread_ = std::thread(&Impl::run, this);
+  }
+
+  ~Impl() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    condition_.notify_one();
+    thread_.join();
+  }
+
+  void update(const std::vector<std::array<double, 3>>& points,
+              const std::array<double, 16>& O_T_C) {  // NOLINT(readability-identifier-naming)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_points_.assign(points.begin(), points.end());
+      pending_pose_ = O_T_C;
+      has_pending_ = true;
+    }
+    condition_.notify_one();
+  }
+
+  SceneWrench render(const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+                     const std::array<double, 3>& velocity) noexcept {
+    indices_.acquire();
+    const PointCloudIndex& index = indices_.front();
+
+    Eigen::Map<const Eigen::Matrix4d> transform(O_T_EE.data());
+    Vector3d origin = transform.topRightCorner<3, 1>();
+    Vector3d probe =
+        transform.topLeftCorner<3, 3>() * Eigen::Map<const Vector3d>(probe_offset_.data()) +
+        origin;
+
+    SceneWrench result;
+    VoxelKey lower{};
+    VoxelKey upper{};
+    if (index.voxel_count == 0 ||
+        !voxelKey(probe - Vector3d::Constant(probe_radius_), index.voxel_size, &lower) ||
+        !voxelKey(probe + Vector3d::Constant(probe_radius_), index.voxel_size, &upper)) {
+      return result;
+    }
+
+    // Weighted moments of the offsets from the centroids inside the probe to the probe center. The
+    // weights fade out towards the probe surface, so that centroids entering the probe do not cause
+    // force steps.
+    double weight_sum = 0;
+    Vector3d offset_sum = Vector3d::Zero();
+    Eigen::Matrix3d offset_products = Eigen::Matrix3d::Zero();
+    VoxelKey key{};
+    for (key[0] = lower[0]; key[0] <= upper[0]; key[0]++) {
+      for (key[1] = lower[1]; key[1] <= upper[1]; key[1]++) {
+        for (key[2] = lower[2]; key[2] <= upper[2]; key[2]++) {
+          const Voxel* voxel = index.find(key);
+          if (voxel == nullptr) {
+            continue;
+          }
+          Vector3d offset = probe - Eigen::Map<const Vector3d>(voxel->centroid.data());
+          double weight = probe_radius_ - offset.norm();
+          if (!(weight > 0)) {
+            continue;
+          }
+          weight_sum += weight;
+          offset_sum += weight * offset;
+          offset_products += weight * offset * offset.transpose();
+          result.contacts++;
+        }
+      }
+    }
+    if (result.contacts == 0) {
+      return result;
+    }
+
+    // Where the centroids locally form a surface, its normal is the direction of least spread.
+    // Otherwise, e.g. for isolated points or edges, push the probe away from their mean.
+    Vector3d mean = offset_sum / weight_sum;
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+    solver.computeDirect(offset_products / weight_sum - mean * mean.transpose());
+    Vector3d normal;
+    if (result.contacts >= 3 && solver.eigenvalues()[1] > kPlanarity * solver.eigenvalues()[0]) {
+      normal = solver.eigenvectors().col(0);
+      if (normal.dot(mean) < 0) {
+        normal = -normal;
+      }
+    } else {
+      double length = mean.norm();
+      if (!(length > 0)) {
+        return result;
+      }
+      normal = mean / length;
+    }
+
+    result.max_penetration = std::max(probe_radius_ - mean.dot(normal), 0.0);
+    double normal_force =
+        material_.stiffness * result.max_penetration -
+        material_.damping * Eigen::Map<const Vector3d>(velocity.data()).dot(normal);
+    Vector3d force = std::max(normal_force, 0.0) * normal;
+    Eigen::Map<Vector3d>(&result.O_F[0]) = force;
+    Eigen::Map<Vector3d>(&result.O_F[3]) = (probe - origin).cross(force);
+    return result;
+  }
+
+  size_t pointCount() const noexcept { return indices_.front().voxel_count; }
+
+  uint64_t builds() const noexcept { return builds_.load(std::memory_order_relaxed); }
+
+ private:
+  void run() noexcept {
+#ifdef LIBFRANKA_LINUX
+    // Do not inherit a realtime policy from the thread that created the renderer.
+    sched_param parameters{};
+    parameters.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &parameters);
+#endif
+    std::vector<std::array<double, 3>> points;
+    std::array<double, 16> pose{};
+    std::vector<IndexedPoint> scratch;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_.wait(lock, [this]() { return has_pending_ || !running_; });
+      if (!running_) {
+        return;
+      }
+      points.swap(pending_points_);
+      pose = pending_pose_;
+      has_pending_ = false;
+      lock.unlock();
+
+      try {
+        buildIndex(points, pose, probe_radius_ / kVoxelsPerRadius, &scratch, &indices_.back());
+      } catch (const std::bad_alloc&) {
+        // Keep rendering the previous cloud.
+        indices_.back() = PointCloudIndex();
+        lock.lock();
+        continue;
+      }
+      indices_.publish();
+      builds_.fetch_add(1, std::memory_order_relaxed);
+      lock.lock();
+    }
+  }
+
+  const double probe_radius_;
+  const Material material_;
+  const std::array<double, 3> probe_offset_;
+
+  TripleBuffer<PointCloudIndex> indices_;
+  std::atomic<uint64_t> builds_{0};
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool running_{true};
+  bool has_pending_{false};
+  std::vector<std::array<double, 3>> pending_points_;
+  std::array<double, 16> pending_pose_{};
+  std::thread thread_;
+};
+
+PointCloudRenderer::PointCloudRenderer(double probe_radius,
+                                       const Material& material,
+                                       const std::array<double, 3>& probe_offset) {
+  if (!(probe_radius > 0) || !std::isfinite(probe_radius)) {
+    throw std::invalid_argument("libfranka: Haptic probe radius must be positive.");
+  }
+  if (!(material.stiffness >= 0) || !std::isfinite(material.stiffness) ||
+      !(material.damping >= 0) || !std::isfinite(material.damping)) {
+    throw std::invalid_argument("libfranka: Haptic material parameters must be non-negative.");
+  }
+  if (!std::all_of(probe_offset.begin(), probe_offset.end(),
+                   [](double d) { return std::isfinite(d); })) {
+    throw std::invalid_argument("libfranka: Haptic probe offset is infinite or NaN.");
+  }
+  impl_.reset(new Impl(probe_radius, material, probe_offset));
+}
+
+PointCloudRenderer::~PointCloudRenderer() noexcept = default;
+
+void PointCloudRenderer::update(
+    const std::vector<std::array<double, 3>>& points,
+    const std::array<double, 16>& O_T_C) {  // NOLINT(readability-identifier-naming)
+  if (!std::all_of(O_T_C.begin(), O_T_C.end(), [](double d) { return std::isfinite(d); }) ||
+      !isHomogeneousTransformation(O_T_C)) {
+    throw std::invalid_argument(
+        "libfranka: Point cloud pose is not a homogeneous transformation.");
+  }
+  impl_->update(points, O_T_C);
+}
+
+SceneWrench PointCloudRenderer::render(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity) noexcept {
+  return impl_->render(O_T_EE, velocity);
+}
+
+SceneWrench PointCloudRenderer::render(const RobotState& robot_state,
+                                       const std::array<double, 3>& velocity) noexcept {
+  return impl_->render(robot_state.O_T_EE, velocity);
+}
+
+size_t PointCloudRenderer::pointCount() const noexcept {
+  return impl_->pointCount();
+}
+
+uint64_t PointCloudRenderer::builds() const noexcept {
+  return impl_->builds();
+}
+
+}  // namespace haptics
+}  // namespace franka
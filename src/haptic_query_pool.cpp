@@ -0,0 +1,305 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_query_pool.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <franka/control_tools.h>
+#include <franka/exception.h>
+
+namespace franka {
+namespace haptics {
+
+constexpr size_t QueryPool::kMaxQueries;
+
+namespace {
+
+constexpr size_t kCacheLineSize = 64;
+
+// The state of a range is packed into one word, so that a claim can check the batch and take a
+// query with a single compare-and-swap: the batch generation in the upper 32 bits, the next query
+// in bits 16 to 31 and the end of the range in the lower 16 bits.
+constexpr uint64_t kNextIncrement = uint64_t{1} << 16;
+
+uint64_t packRange(uint32_t generation, uint64_t next, uint64_t end) noexcept {
+  return (uint64_t{generation} << 32) | (next << 16) | end;
+}
+
+}  // anonymous namespace
+
+class QueryPool::Impl {
+ public:
+  explicit Impl(const QueryPoolOptions& options)
+      : join_timeout_(options.join_timeout),
+        spin_duration_(options.spin_duration),
+        ranges_(options.cpus.size() + 1) {
+    for (size_t i = 0; i < options.cpus.size(); i++) {
+      if (options.cpus[i] < 0 ||
+          std::count(options.cpus.begin(), options.cpus.end(), options.cpus[i]) > 1) {
+        throw std::invalid_argument("libfranka: Query pool CPUs must be non-negative and unique.");
+      }
+    }
+    if (join_timeout_.count() < 0 || spin_duration_.count() < 0) {
+      throw std::invalid_argument("libfranka: Query pool times must not be negative.");
+    }
+
+    threads_.reserve(options.cpus.size());
+    for (size_t i = 0; i < options.cpus.size(); i++) {
+      threads_.emplace_back(&Impl::work, this, i, options.cpus[i]);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    startup_condition_.wait(lock, [&]() { return started_ == threads_.size(); });
+    if (options.realtime_config == RealtimeConfig::kEnforce && !startup_error_.empty()) {
+      std::string error = startup_error_;
+      lock.unlock();
+      stop();
+      throw RealtimeException(error);
+    }
+  }
+
+  ~Impl() noexcept { stop(); }
+
+  void run(const ProbeQuery* queries, size_t count, SceneWrench* results) noexcept {
+    for (size_t first = 0; first < count; first += kMaxQueries) {
+      runChunk(queries + first, std::min(kMaxQueries, count - first), results + first);
+    }
+  }
+
+  size_t workers() const noexcept { return threads_.size(); }
+
+  QueryPoolStatistics statistics() const noexcept {
+    QueryPoolStatistics statistics;
+    statistics.batches = batches_.load(std::memory_order_relaxed);
+    statistics.worker_queries = worker_queries_.load(std::memory_order_relaxed);
+    statistics.late_joins = late_joins_.load(std::memory_order_relaxed);
+    statistics.recomputed_queries = recomputed_queries_.load(std::memory_order_relaxed);
+    statistics.serial_batches = serial_batches_.load(std::memory_order_relaxed);
+    return statistics;
+  }
+
+ private:
+  // Keeps the ranges of different threads in different cache lines.
+  struct Range {
+    std::atomic<uint64_t> state{0};
+    char padding[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+  };
+
+  struct Slot {
+    SceneWrench result;
+    // Generation of the batch for which result was written.
+    std::atomic<uint32_t> done{0};
+  };
+
+  static SceneWrench query(const ProbeQuery& query) noexcept {
+    return query.scene != nullptr ? query.scene->query(query.O_T_EE, query.velocity)
+                                  : SceneWrench();
+  }
+
+  void runChunk(const ProbeQuery* queries, size_t count, SceneWrench* results) noexcept {
+    // A worker that is still busy with a late query could otherwise overwrite the results of this
+    // batch.
+    if (threads_.empty() || active_.load() != 0) {
+      if (!threads_.empty()) {
+        serial_batches_.fetch_add(1, std::memory_order_relaxed);
+      }
+      std::transform(queries, queries + count, results, &Impl::query);
+      return;
+    }
+
+    // All ranges of the previous batch are empty and no worker is active, so the batch can be set
+    // up without racing with a worker.
+    uint32_t generation = generation_.load(std::memory_order_relaxed) + 1;
+    if (generation == 0) {
+      // Slots that were never written are marked with generation 0.
+      generation = 1;
+    }
+    queries_ = queries;
+    const size_t participants = ranges_.size();
+    size_t next = 0;
+    for (size_t i = 0; i < participants; i++) {
+      size_t end = next + count / participants + (i < count % participants ? 1 : 0);
+      ranges_[i].state.store(packRange(generation, next, end), std::memory_order_release);
+      next = end;
+    }
+    generation_.store(generation);
+    if (sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      wake_condition_.notify_all();
+    }
+
+    processQueries(participants - 1, generation);
+
+    auto deadline = std::chrono::steady_clock::now() + join_timeout_;
+    bool late = false;
+    size_t pending = 0;
+    while (!late) {
+      pending = 0;
+      for (size_t i = 0; i < count; i++) {
+        if (slots_[i].done.load(std::memory_order_acquire) != generation) {
+          pending++;
+        }
+      }
+      late = pending > 0 && std::chrono::steady_clock::now() >= deadline;
+      if (pending == 0) {
+        break;
+      }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      if (slots_[i].done.load(std::memory_order_acquire) == generation) {
+        results[i] = slots_[i].result;
+      } else {
+        results[i] = query(queries[i]);
+      }
+    }
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    if (late) {
+      late_joins_.fetch_add(1, std::memory_order_relaxed);
+      recomputed_queries_.fetch_add(pending, std::memory_order_relaxed);
+    }
+  }
+
+  // Takes a query of the given batch, starting with the range of the given thread and then
+  // stealing from the others. Returns false if all ranges are empty or belong to another batch.
+  bool claim(size_t own_range, uint32_t generation, size_t* index) noexcept {
+    for (size_t offset = 0; offset < ranges_.size(); offset++) {
+      std::atomic<uint64_t>& state = ranges_[(own_range + offset) % ranges_.size()].state;
+      uint64_t value = state.load(std::memory_order_acquire);
+      while (static_cast<uint32_t>(value >> 32) == generation &&
+             ((value >> 16) & 0xFFFF) < (value & 0xFFFF)) {
+        if (state.compare_exchange_weak(value, value + kNextIncrement, std::memory_order_acquire)) {
+          *index = (value >> 16) & 0xFFFF;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  size_t processQueries(size_t own_range, uint32_t generation) noexcept {
+    size_t processed = 0;
+    size_t index;
+    while (claim(own_range, generation, &index)) {
+      slots_[index].result = query(queries_[index]);
+      slots_[index].done.store(generation, std::memory_order_release);
+      processed++;
+    }
+    return processed;
+  }
+
+  void work(size_t worker, int cpu) noexcept {
+    std::string error;
+    RealtimeOptions realtime_options;
+    realtime_options.cpu_affinity = {cpu};
+    applyRealtimeOptions(realtime_options, nullptr, &error);
+    std::string priority_error;
+    if (!setCurrentThreadToHighestSchedulerPriority(&priority_error)) {
+      error += error.empty() ? priority_error : " " + priority_error;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      started_++;
+      if (startup_error_.empty()) {
+        startup_error_ = error;
+      }
+    }
+    startup_condition_.notify_one();
+
+    uint32_t seen = 0;
+    while (waitForBatch(seen)) {
+      // Announce the worker before reading the generation, so that the caller does not set up the
+      // next batch while this worker may still take a query.
+      active_.fetch_add(1);
+      seen = generation_.load();
+      size_t processed = processQueries(worker, seen);
+      active_.fetch_sub(1, std::memory_order_release);
+      if (processed > 0) {
+        worker_queries_.fetch_add(processed, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Polls for a batch newer than seen for spin_duration_, then sleeps. Returns false on stop.
+  bool waitForBatch(uint32_t seen) noexcept {
+    auto spin_end = std::chrono::steady_clock::now() + spin_duration_;
+    while (std::chrono::steady_clock::now() < spin_end) {
+      if (stop_.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      if (generation_.load(std::memory_order_relaxed) != seen) {
+        return true;
+      }
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleeping_.fetch_add(1);
+    wake_condition_.wait(lock, [&]() { return stop_.load() || generation_.load() != seen; });
+    sleeping_.fetch_sub(1);
+    return !stop_.load();
+  }
+
+  void stop() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_condition_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  const std::chrono::microseconds join_timeout_;
+  const std::chrono::microseconds spin_duration_;
+
+  std::vector<Range> ranges_;
+  std::array<Slot, kMaxQueries> slots_;
+  const ProbeQuery* queries_{nullptr};
+
+  std::atomic<uint32_t> generation_{0};
+  std::atomic<uint32_t> active_{0};
+  std::atomic<uint32_t> sleeping_{0};
+  std::atomic<bool> stop_{false};
+
+  std::atomic<uint64_t> batches_{0};
+  std::atomic<uint64_t> worker_queries_{0};
+  std::atomic<uint64_t> late_joins_{0};
+  std::atomic<uint64_t> recomputed_queries_{0};
+  std::atomic<uint64_t> serial_batches_{0};
+
+  std::mutex mutex_;
+  std::condition_variable wake_condition_;
+  std::condition_variable startup_condition_;
+  size_t started_{0};
+  std::string startup_error_;
+  std::vector<std::thread> threads_;
+};
+
+QueryPool::QueryPool(const QueryPoolOptions& options) : impl_(new Impl(options)) {}
+
+QueryPool::~QueryPool() noexcept = default;
+
+void QueryPool::run(const ProbeQuery* queries, size_t count, SceneWrench* results) noexcept {
+  impl_->run(queries, count, results);
+}
+
+size_t QueryPool::workers() const noexcept {
+  return impl_->workers();
+}
+
+QueryPoolStatistics QueryPool::statistics() const noexcept {
+  return impl_->statistics();
+}
+
+}  // namespace haptics
+}  // namespace franka
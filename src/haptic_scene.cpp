@@ -0,0 +1,462 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_scene.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+
+namespace franka {
+namespace haptics {
+
+namespace {
+
+// Leaves with at most this many primitives are not split further.
+constexpr uint32_t kLeafSize = 4;
+// Bounds the depth of the hierarchy and thereby the traversal stack of a query.
+constexpr uint32_t kMaxDepth = 32;
+// Distances below this are treated as zero when computing surface normals. Unit: [m]
+constexpr double kEpsilon = 1e-12;
+
+using Vector3d = Eigen::Vector3d;
+
+// Signed distance of a point to a surface and the outward surface normal at the closest point.
+struct Distance {
+  double distance;
+  Vector3d normal;
+};
+
+Eigen::Map<const Vector3d> map(const std::array<double, 3>& array) {
+  return Eigen::Map<const Vector3d>(array.data());
+}
+
+bool isFinite(const std::array<double, 3>& array) {
+  return std::all_of(array.begin(), array.end(), [](double d) { return std::isfinite(d); });
+}
+
+void checkPoint(const std::array<double, 3>& point) {
+  if (!isFinite(point)) {
+    throw std::invalid_argument("libfranka: Haptic scene point is infinite or NaN.");
+  }
+}
+
+void checkRadius(double radius) {
+  if (!(radius > 0) || !std::isfinite(radius)) {
+    throw std::invalid_argument(
+        "libfranka: Haptic scene radius is zero, negative, infinite or NaN.");
+  }
+}
+
+void checkMaterial(const Material& material) {
+  if (!(material.stiffness >= 0) || !std::isfinite(material.stiffness) ||
+      !(material.damping >= 0) || !std::isfinite(material.damping)) {
+    throw std::invalid_argument("libfranka: Haptic material parameters must be non-negative.");
+  }
+}
+
+// Any unit vector perpendicular to the given unit vector.
+Vector3d perpendicular(const Vector3d& axis) {
+  Vector3d other = std::abs(axis.x()) < 0.9 ? Vector3d::UnitX() : Vector3d::UnitY();
+  return axis.cross(other).normalized();
+}
+
+Distance pointDistance(const Vector3d& point, const Vector3d& center, double radius) {
+  Vector3d difference = point - center;
+  double length = difference.norm();
+  Vector3d normal = length > kEpsilon ? Vector3d(difference / length) : Vector3d::UnitZ();
+  return {length - radius, normal};
+}
+
+Distance segmentDistance(const Vector3d& point,
+                         const Vector3d& start,
+                         const Vector3d& end,
+                         double radius) {
+  Vector3d segment = end - start;
+  double length_squared = segment.squaredNorm();
+  double t = length_squared > 0 ? (point - start).dot(segment) / length_squared : 0;
+  return pointDistance(point, start + std::min(std::max(t, 0.0), 1.0) * segment, radius);
+}
+
+Distance boxDistance(const Vector3d& point,
+                     const Eigen::Matrix3d& rotation,
+                     const Vector3d& translation,
+                     const Vector3d& half_extents) {
+  Vector3d local = rotation.transpose() * (point - translation);
+  Vector3d distances = local.cwiseAbs() - half_extents;
+  Vector3d signs = local.unaryExpr([](double d) { return d < 0 ? -1.0 : 1.0; });
+
+  Vector3d outside = distances.cwiseMax(0);
+  double outside_distance = outside.norm();
+  if (outside_distance > kEpsilon) {
+    return {outside_distance, rotation * signs.cwiseProduct(outside) / outside_distance};
+  }
+  Vector3d::Index axis;
+  double inside_distance = distances.maxCoeff(&axis);
+  return {inside_distance, rotation.col(axis) * signs[axis]};
+}
+
+Distance cylinderDistance(const Vector3d& point,
+                          const Vector3d& start,
+                          const Vector3d& end,
+                          double radius) {
+  Vector3d center = 0.5 * (start + end);
+  Vector3d axis = end - start;
+  double half_length = 0.5 * axis.norm();
+  axis /= 2 * half_length;
+
+  Vector3d relative = point - center;
+  double axial = relative.dot(axis);
+  Vector3d radial = relative - axial * axis;
+  double radial_length = radial.norm();
+  Vector3d radial_direction =
+      radial_length > kEpsilon ? Vector3d(radial / radial_length) : perpendicular(axis);
+  Vector3d axial_direction = axial < 0 ? Vector3d(-axis) : axis;
+
+  double radial_distance = radial_length - radius;
+  double axial_distance = std::abs(axial) - half_length;
+  if (radial_distance > 0 && axial_distance > 0) {
+    double distance = std::hypot(radial_distance, axial_distance);
+    return {distance,
+            (radial_distance * radial_direction + axial_distance * axial_direction) / distance};
+  }
+  if (radial_distance > axial_distance) {
+    return {radial_distance, radial_direction};
+  }
+  return {axial_distance, axial_direction};
+}
+
+}  // anonymous namespace
+
+constexpr size_t ContactSet::kMaxContacts;
+
+Scene::Scene(double probe_radius, const std::array<double, 3>& probe_offset)
+    : probe_radius_(probe_radius), probe_offset_(probe_offset) {
+  if (!(probe_radius >= 0) || !std::isfinite(probe_radius)) {
+    throw std::invalid_argument("libfranka: Haptic probe radius is negative, infinite or NaN.");
+  }
+  checkPoint(probe_offset);
+}
+
+size_t Scene::addPlane(const std::array<double, 3>& point,
+                       const std::array<double, 3>& normal,
+                       const Material& material) {
+  checkPoint(point);
+  checkPoint(normal);
+  checkMaterial(material);
+  double length = map(normal).norm();
+  if (!(length > 0)) {
+    throw std::invalid_argument("libfranka: Haptic scene plane normal is zero.");
+  }
+
+  Plane plane{point, {}, material, static_cast<uint32_t>(size())};
+  Eigen::Map<Vector3d>(plane.normal.data()) = map(normal) / length;
+  planes_.push_back(plane);
+  return size() - 1;
+}
+
+size_t Scene::addSphere(const std::array<double, 3>& center,
+                        double radius,
+                        const Material& material) {
+  checkPoint(center);
+  checkRadius(radius);
+  checkMaterial(material);
+
+  Bounds bounds{};
+  for (size_t i = 0; i < 3; i++) {
+    bounds.min[i] = center[i] - radius;
+    bounds.max[i] = center[i] + radius;
+  }
+  spheres_.push_back({center, radius, material});
+  add(Type::kSphere, spheres_.size() - 1, bounds);
+  return size() - 1;
+}
+
+size_t Scene::addBox(const std::array<double, 16>& pose,
+                     const std::array<double, 3>& half_extents,
+                     const Material& material) {
+  if (!isHomogeneousTransformation(pose)) {
+    throw std::invalid_argument(
+        "libfranka: Haptic scene box pose is not a homogeneous transformation.");
+  }
+  if (!std::all_of(half_extents.begin(), half_extents.end(),
+                   [](double d) { return d > 0 && std::isfinite(d); })) {
+    throw std::invalid_argument("libfranka: Haptic scene box extents must be positive.");
+  }
+  checkMaterial(material);
+
+  Box box{};
+  for (size_t column = 0; column < 3; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      box.rotation[3 * column + row] = pose[4 * column + row];
+    }
+    box.translation[column] = pose[12 + column];
+  }
+  box.half_extents = half_extents;
+  box.material = material;
+
+  Eigen::Map<const Eigen::Matrix3d> rotation(box.rotation.data());
+  Vector3d extents = rotation.cwiseAbs() * map(half_extents);
+  Bounds bounds{};
+  for (size_t i = 0; i < 3; i++) {
+    bounds.min[i] = box.translation[i] - extents[i];
+    bounds.max[i] = box.translation[i] + extents[i];
+  }
+  boxes_.push_back(box);
+  add(Type::kBox, boxes_.size() - 1, bounds);
+  return size() - 1;
+}
+
+size_t Scene::addCapsule(const std::array<double, 3>& start,
+                         const std::array<double, 3>& end,
+                         double radius,
+                         const Material& material) {
+  checkPoint(start);
+  checkPoint(end);
+  checkRadius(radius);
+  checkMaterial(material);
+
+  Bounds bounds{};
+  for (size_t i = 0; i < 3; i++) {
+    bounds.min[i] = std::min(start[i], end[i]) - radius;
+    bounds.max[i] = std::max(start[i], end[i]) + radius;
+  }
+  capsules_.push_back({start, end, radius, material});
+  add(Type::kCapsule, capsules_.size() - 1, bounds);
+  return size() - 1;
+}
+
+size_t Scene::addCylinder(const std::array<double, 3>& start,
+                          const std::array<double, 3>& end,
+                          double radius,
+                          const Material& material) {
+  checkPoint(start);
+  checkPoint(end);
+  checkRadius(radius);
+  checkMaterial(material);
+  if (!((map(end) - map(start)).norm() > 0)) {
+    throw std::invalid_argument("libfranka: Haptic scene cylinder has zero length.");
+  }
+
+  // The bounds of the capsule around the same segment also contain the cylinder.
+  Bounds bounds{};
+  for (size_t i = 0; i < 3; i++) {
+    bounds.min[i] = std::min(start[i], end[i]) - radius;
+    bounds.max[i] = std::max(start[i], end[i]) + radius;
+  }
+  cylinders_.push_back({start, end, radius, material});
+  add(Type::kCylinder, cylinders_.size() - 1, bounds);
+  return size() - 1;
+}
+
+void Scene::clear() noexcept {
+  planes_.clear();
+  spheres_.clear();
+  boxes_.clear();
+  capsules_.clear();
+  cylinders_.clear();
+  references_.clear();
+  nodes_.clear();
+}
+
+size_t Scene::size() const noexcept {
+  return planes_.size() + references_.size();
+}
+
+void Scene::add(Type type, size_t index, const Bounds& bounds) {
+  references_.push_back(
+      {type, static_cast<uint32_t>(index), static_cast<uint32_t>(size()), bounds});
+  rebuild();
+}
+
+void Scene::rebuild() {
+  nodes_.clear();
+  nodes_.reserve(2 * references_.size());
+  if (!references_.empty()) {
+    build(0, static_cast<uint32_t>(references_.size()), 0);
+  }
+}
+
+uint32_t Scene::build(uint32_t first, uint32_t count, uint32_t depth) {
+  auto begin = references_.begin() + first;
+  auto end = begin + count;
+
+  Bounds bounds = begin->bounds;
+  Bounds centers{};
+  for (size_t i = 0; i < 3; i++) {
+    centers.min[i] = std::numeric_limits<double>::infinity();
+    centers.max[i] = -std::numeric_limits<double>::infinity();
+  }
+  for (auto it = begin; it != end; ++it) {
+    for (size_t i = 0; i < 3; i++) {
+      bounds.min[i] = std::min(bounds.min[i], it->bounds.min[i]);
+      bounds.max[i] = std::max(bounds.max[i], it->bounds.max[i]);
+      double center = 0.5 * (it->bounds.min[i] + it->bounds.max[i]);
+      centers.min[i] = std::min(centers.min[i], center);
+      centers.max[i] = std::max(centers.max[i], center);
+    }
+  }
+
+  uint32_t index = static_cast<uint32_t>(nodes_.size());
+  nodes_.push_back({bounds, first, count});
+  if (count <= kLeafSize || depth >= kMaxDepth) {
+    return index;
+  }
+
+  // Split at the median along the axis in which the primitive centers spread most.
+  size_t axis = 0;
+  for (size_t i = 1; i < 3; i++) {
+    if (centers.max[i] - centers.min[i] > centers.max[axis] - centers.min[axis]) {
+      axis = i;
+    }
+  }
+  uint32_t half = count / 2;
+  std::nth_element(begin, begin + half, end, [axis](const Reference& a, const Reference& b) {
+    return a.bounds.min[axis] + a.bounds.max[axis] < b.bounds.min[axis] + b.bounds.max[axis];
+  });
+
+  build(first, half, depth + 1);
+  uint32_t right = build(first + half, count - half, depth + 1);
+  nodes_[index].first = right;
+  nodes_[index].count = 0;
+  return index;
+}
+
+SceneWrench Scene::query(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity) const noexcept {
+  return query(O_T_EE, velocity, nullptr);
+}
+
+SceneWrench Scene::query(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity,
+    ContactSet* contacts) const noexcept {
+  if (contacts != nullptr) {
+    contacts->size = 0;
+  }
+  Eigen::Map<const Eigen::Matrix4d> transform(O_T_EE.data());
+  Vector3d origin = transform.topRightCorner<3, 1>();
+  Vector3d probe = transform.topLeftCorner<3, 3>() * map(probe_offset_) + origin;
+  Vector3d probe_velocity = map(velocity);
+
+  SceneWrench result;
+  Vector3d force = Vector3d::Zero();
+  Vector3d torque = Vector3d::Zero();
+  auto addContact = [&](const Distance& distance, const Material& material, uint32_t id) {
+    double penetration = probe_radius_ - distance.distance;
+    if (!(penetration > 0)) {
+      return;
+    }
+    double normal_force =
+        material.stiffness * penetration - material.damping * probe_velocity.dot(distance.normal);
+    Vector3d contact_force = std::max(normal_force, 0.0) * distance.normal;
+    Vector3d contact_point = probe - probe_radius_ * distance.normal;
+    force += contact_force;
+    torque += (contact_point - origin).cross(contact_force);
+    result.contacts++;
+    result.max_penetration = std::max(result.max_penetration, penetration);
+
+    if (contacts != nullptr && contacts->size < ContactSet::kMaxContacts) {
+      Contact& contact = contacts->contacts[contacts->size++];
+      Eigen::Map<Vector3d>(contact.point.data()) = contact_point;
+      Eigen::Map<Vector3d>(contact.normal.data()) = distance.normal;
+      contact.penetration = penetration;
+      contact.normal_force = std::max(normal_force, 0.0);
+      contact.material = material;
+      contact.primitive = id;
+    }
+  };
+
+  for (const Plane& plane : planes_) {
+    addContact({map(plane.normal).dot(probe - map(plane.point)), map(plane.normal)},
+               plane.material, plane.id);
+  }
+
+  if (!nodes_.empty()) {
+    std::array<uint32_t, kMaxDepth + 1> stack;
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+      const Node& node = nodes_[stack[--stack_size]];
+
+      // Skip nodes whose bounds do not touch the probe sphere.
+      double distance_squared = 0;
+      for (size_t i = 0; i < 3; i++) {
+        double outside = std::max(
+            {node.bounds.min[i] - probe[i], probe[i] - node.bounds.max[i], 0.0});
+        distance_squared += outside * outside;
+      }
+      if (distance_squared > probe_radius_ * probe_radius_) {
+        continue;
+      }
+
+      if (node.count == 0) {
+        uint32_t index = static_cast<uint32_t>(&node - nodes_.data());
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = index + 1;
+        continue;
+      }
+
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        const Reference& reference = references_[i];
+        switch (reference.type) {
+          case Type::kSphere: {
+            const Sphere& sphere = spheres_[reference.index];
+            addContact(pointDistance(probe, map(sphere.center), sphere.radius), sphere.material,
+                       reference.id);
+            break;
+          }
+          case Type::kBox: {
+            const Box& box = boxes_[reference.index];
+            addContact(boxDistance(probe, Eigen::Map<const Eigen::Matrix3d>(box.rotation.data()),
+                                   map(box.translation), map(box.half_extents)),
+                       box.material, reference.id);
+            break;
+          }
+          case Type::kCapsule: {
+            const Segment& capsule = capsules_[reference.index];
+            addContact(segmentDistance(probe, map(capsule.start), map(capsule.end), capsule.radius),
+                       capsule.material, reference.id);
+            break;
+          }
+          case Type::kCylinder: {
+            const Segment& cylinder = cylinders_[reference.index];
+            addContact(
+                cylinderDistance(probe, map(cylinder.start), map(cylinder.end), cylinder.radius),
+                cylinder.material, reference.id);
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  Eigen::Map<Vector3d>(&result.O_F[0]) = force;
+  Eigen::Map<Vector3d>(&result.O_F[3]) = torque;
+  return result;
+}
+
+SceneWrench Scene::query(const RobotState& robot_state,
+                         const std::array<double, 3>& velocity) const noexcept {
+  return query(robot_state.O_T_EE, velocity);
+}
+
+std::array<double, 7> wrenchToJointTorques(const std::array<double, 42>& zero_jacobian,
+                                           const std::array<double, 6>& wrench) noexcept {
+  std::array<double, 7> tau{};
+  for (size_t joint = 0; joint < 7; joint++) {
+    for (size_t i = 0; i < 6; i++) {
+      tau[joint] += zero_jacobian[6 * joint + i] * wrench[i];
+    }
+  }
+  return tau;
+}
+
+}  // namespace haptics
+}  // namespace franka
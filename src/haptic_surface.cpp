@@ -0,0 +1,352 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/haptic_surface.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace franka {
+namespace haptics {
+
+namespace {
+
+// Every texel stores the height and its gradient along u and v.
+constexpr size_t kTexelSize = 3;
+// Number of random heights along each edge of the coarsest octave of a noise texture.
+constexpr size_t kNoiseCells = 4;
+// Relative tolerance for a slipping contact to stick again.
+constexpr double kStickTolerance = 1e-9;
+
+using Vector3d = Eigen::Vector3d;
+
+Eigen::Map<const Vector3d> map(const std::array<double, 3>& array) {
+  return Eigen::Map<const Vector3d>(array.data());
+}
+
+// Same tangent basis for every normal, so texture coordinates are stable on flat faces.
+void tangents(const Vector3d& normal, Vector3d* first, Vector3d* second) {
+  Vector3d other = std::abs(normal.x()) < 0.9 ? Vector3d::UnitX() : Vector3d::UnitY();
+  *first = normal.cross(other).normalized();
+  *second = normal.cross(*first);
+}
+
+void checkResolution(size_t resolution) {
+  if (resolution < 4 || resolution > 256 || (resolution & (resolution - 1)) != 0) {
+    throw std::invalid_argument(
+        "libfranka: Surface texture resolution must be a power of two between 4 and 256.");
+  }
+}
+
+void checkWavelength(double wavelength) {
+  if (!(wavelength > 0) || !std::isfinite(wavelength)) {
+    throw std::invalid_argument("libfranka: Surface texture wavelength must be positive.");
+  }
+}
+
+bool isValid(double value) {
+  return value >= 0 && std::isfinite(value);
+}
+
+// Periodic, smoothly interpolated grid of random heights in [-1, 1].
+class ValueNoise {
+ public:
+  ValueNoise(size_t cells, std::mt19937* generator) : cells_(cells), values_(cells * cells) {
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    for (double& value : values_) {
+      value = distribution(*generator);
+    }
+  }
+
+  // Coordinates are given in cells.
+  double operator()(double x, double y) const {
+    double cell_x = std::floor(x);
+    double cell_y = std::floor(y);
+    double fx = smoothstep(x - cell_x);
+    double fy = smoothstep(y - cell_y);
+    size_t x0 = wrap(cell_x);
+    size_t y0 = wrap(cell_y);
+    size_t x1 = (x0 + 1) % cells_;
+    size_t y1 = (y0 + 1) % cells_;
+    double bottom = value(x0, y0) + fx * (value(x1, y0) - value(x0, y0));
+    double top = value(x0, y1) + fx * (value(x1, y1) - value(x0, y1));
+    return bottom + fy * (top - bottom);
+  }
+
+ private:
+  static double smoothstep(double t) { return t * t * (3 - 2 * t); }
+
+  size_t wrap(double cell) const {
+    double cells = static_cast<double>(cells_);
+    return static_cast<size_t>(cell - cells * std::floor(cell / cells)) % cells_;
+  }
+
+  double value(size_t x, size_t y) const { return values_[y * cells_ + x]; }
+
+  size_t cells_;
+  std::vector<double> values_;
+};
+
+}  // anonymous namespace
+
+SurfaceTexture::SurfaceTexture(const HeightFunction& height, double period, size_t resolution)
+    : period_(period), resolution_(resolution) {
+  if (!height) {
+    throw std::invalid_argument("libfranka: Surface texture needs a height function.");
+  }
+  if (!(period > 0) || !std::isfinite(period)) {
+    throw std::invalid_argument("libfranka: Surface texture period must be positive.");
+  }
+  checkResolution(resolution);
+
+  double texel_size = period / static_cast<double>(resolution);
+  std::vector<double> heights(resolution * resolution);
+  for (size_t v = 0; v < resolution; v++) {
+    for (size_t u = 0; u < resolution; u++) {
+      double value = height(static_cast<double>(u) * texel_size,
+                            static_cast<double>(v) * texel_size);
+      if (!std::isfinite(value)) {
+        throw std::invalid_argument("libfranka: Surface texture height is infinite or NaN.");
+      }
+      heights[v * resolution + u] = value;
+    }
+  }
+
+  size_t mask = resolution - 1;
+  auto texels = std::make_shared<std::vector<float>>(kTexelSize * resolution * resolution);
+  for (size_t v = 0; v < resolution; v++) {
+    for (size_t u = 0; u < resolution; u++) {
+      size_t index = v * resolution + u;
+      double du = heights[v * resolution + ((u + 1) & mask)] -
+                  heights[v * resolution + ((u + mask) & mask)];
+      double dv = heights[((v + 1) & mask) * resolution + u] -
+                  heights[((v + mask) & mask) * resolution + u];
+      (*texels)[kTexelSize * index] = static_cast<float>(heights[index]);
+      (*texels)[kTexelSize * index + 1] = static_cast<float>(du / (2 * texel_size));
+      (*texels)[kTexelSize * index + 2] = static_cast<float>(dv / (2 * texel_size));
+    }
+  }
+  texels_ = std::move(texels);
+}
+
+SurfaceTexture SurfaceTexture::grating(double wavelength, double amplitude, size_t resolution) {
+  checkWavelength(wavelength);
+  return SurfaceTexture(
+      [=](double u, double /* v */) { return amplitude * std::sin(2 * M_PI * u / wavelength); },
+      wavelength, resolution);
+}
+
+SurfaceTexture SurfaceTexture::noise(double wavelength,
+                                     double amplitude,
+                                     uint32_t seed,
+                                     size_t resolution) {
+  checkWavelength(wavelength);
+  std::mt19937 generator(seed);
+  ValueNoise coarse(kNoiseCells, &generator);
+  ValueNoise fine(2 * kNoiseCells, &generator);
+
+  // The fine octave has half the weight, so the sum stays within the amplitude.
+  double cell_size = wavelength;
+  return SurfaceTexture(
+      [=](double u, double v) {
+        return amplitude / 1.5 *
+               (coarse(u / cell_size, v / cell_size) +
+                0.5 * fine(2 * u / cell_size, 2 * v / cell_size));
+      },
+      static_cast<double>(kNoiseCells) * wavelength, resolution);
+}
+
+double SurfaceTexture::height(double u, double v, std::array<double, 2>* gradient) const noexcept {
+  double scale = static_cast<double>(resolution_) / period_;
+  double x = u * scale;
+  double y = v * scale;
+  double cell_x = std::floor(x);
+  double cell_y = std::floor(y);
+  double fx = x - cell_x;
+  double fy = y - cell_y;
+
+  // Texel indices wrap around, also for negative coordinates.
+  size_t mask = resolution_ - 1;
+  size_t x0 = static_cast<size_t>(static_cast<int64_t>(cell_x)) & mask;
+  size_t y0 = static_cast<size_t>(static_cast<int64_t>(cell_y)) & mask;
+  size_t x1 = (x0 + 1) & mask;
+  size_t y1 = (y0 + 1) & mask;
+
+  const float* texels = texels_->data();
+  const float* t00 = &texels[kTexelSize * (y0 * resolution_ + x0)];
+  const float* t10 = &texels[kTexelSize * (y0 * resolution_ + x1)];
+  const float* t01 = &texels[kTexelSize * (y1 * resolution_ + x0)];
+  const float* t11 = &texels[kTexelSize * (y1 * resolution_ + x1)];
+  double w00 = (1 - fx) * (1 - fy);
+  double w10 = fx * (1 - fy);
+  double w01 = (1 - fx) * fy;
+  double w11 = fx * fy;
+  auto interpolate = [&](size_t i) {
+    return w00 * t00[i] + w10 * t10[i] + w01 * t01[i] + w11 * t11[i];
+  };
+
+  if (gradient != nullptr) {
+    (*gradient)[0] = interpolate(1);
+    (*gradient)[1] = interpolate(2);
+  }
+  return interpolate(0);
+}
+
+double SurfaceTexture::period() const noexcept {
+  return period_;
+}
+
+size_t SurfaceTexture::resolution() const noexcept {
+  return resolution_;
+}
+
+constexpr uint32_t SurfaceRenderer::kNoMaterial;
+
+size_t SurfaceRenderer::addMaterial(const SurfaceMaterial& material) {
+  if (!isValid(material.static_friction) || !isValid(material.kinetic_friction) ||
+      !isValid(material.tangential_stiffness) || !isValid(material.tangential_damping)) {
+    throw std::invalid_argument(
+        "libfranka: Surface material parameters must be non-negative and finite.");
+  }
+  if (material.kinetic_friction > material.static_friction) {
+    throw std::invalid_argument(
+        "libfranka: Kinetic friction of a surface material must not exceed static friction.");
+  }
+  materials_.push_back(material);
+  return materials_.size() - 1;
+}
+
+void SurfaceRenderer::assign(size_t primitive, size_t material) {
+  if (material >= materials_.size()) {
+    throw std::invalid_argument("libfranka: Surface material does not exist.");
+  }
+  if (primitive >= assignments_.size()) {
+    assignments_.resize(primitive + 1, kNoMaterial);
+  }
+  assignments_[primitive] = static_cast<uint32_t>(material);
+}
+
+SceneWrench SurfaceRenderer::render(
+    const Scene& scene,
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity) noexcept {
+  ContactSet contacts;
+  SceneWrench wrench = scene.query(O_T_EE, velocity, &contacts);
+  return render(wrench, contacts, O_T_EE, velocity);
+}
+
+SceneWrench SurfaceRenderer::render(
+    const SceneWrench& wrench,
+    const ContactSet& contacts,
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& velocity) noexcept {
+  Vector3d origin(O_T_EE[12], O_T_EE[13], O_T_EE[14]);
+  Vector3d probe_velocity = map(velocity);
+  SceneWrench result = wrench;
+  Eigen::Map<Vector3d> force(&result.O_F[0]);
+  Eigen::Map<Vector3d> torque(&result.O_F[3]);
+
+  std::array<Friction, ContactSet::kMaxContacts> friction;
+  size_t friction_count = 0;
+  for (size_t i = 0; i < std::min(contacts.size, ContactSet::kMaxContacts); i++) {
+    const Contact& contact = contacts.contacts[i];
+    uint32_t material_index =
+        contact.primitive < assignments_.size() ? assignments_[contact.primitive] : kNoMaterial;
+    if (material_index == kNoMaterial) {
+      continue;
+    }
+    const SurfaceMaterial& material = materials_[material_index];
+    Vector3d point = map(contact.point);
+    Vector3d normal = map(contact.normal);
+    Vector3d first;
+    Vector3d second;
+    tangents(normal, &first, &second);
+
+    // Displace the surface by the texture height and tilt the normal against its gradient.
+    double normal_force = contact.normal_force;
+    Vector3d contact_force = Vector3d::Zero();
+    if (material.texture != nullptr) {
+      std::array<double, 2> gradient;
+      double height = material.texture->height(point.dot(first), point.dot(second), &gradient);
+      double textured_force =
+          normal_force > 0 ? std::max(normal_force + contact.material.stiffness * height, 0.0)
+                           : 0.0;
+      Vector3d textured_normal =
+          (normal - gradient[0] * first - gradient[1] * second).normalized();
+      contact_force += textured_force * textured_normal - normal_force * normal;
+      normal_force = textured_force;
+    }
+
+    Friction state{contact.primitive, FrictionState::kStick, contact.point};
+    for (size_t j = 0; j < friction_count_; j++) {
+      if (friction_[j].primitive == contact.primitive) {
+        state = friction_[j];
+        break;
+      }
+    }
+    if (material.tangential_stiffness > 0) {
+      Vector3d anchor = map(state.anchor);
+      Vector3d displacement = point - anchor;
+      displacement -= displacement.dot(normal) * normal;
+      double stretch = displacement.norm();
+      double spring = material.tangential_stiffness * stretch;
+      double static_limit = material.static_friction * normal_force;
+      double kinetic_limit = material.kinetic_friction * normal_force;
+
+      if (state.state == FrictionState::kStick && spring > static_limit) {
+        state.state = FrictionState::kSlip;
+      } else if (state.state == FrictionState::kSlip &&
+                 spring <= kinetic_limit * (1 + kStickTolerance)) {
+        state.state = FrictionState::kStick;
+      }
+
+      Vector3d friction_force;
+      if (state.state == FrictionState::kSlip) {
+        // Drag the anchor along so that the spring force stays on the kinetic friction cone.
+        Vector3d direction = stretch > 0 ? Vector3d(displacement / stretch) : Vector3d::Zero();
+        displacement = direction * (kinetic_limit / material.tangential_stiffness);
+        anchor = point - displacement;
+        friction_force = -kinetic_limit * direction;
+      } else {
+        Vector3d tangential_velocity =
+            probe_velocity - probe_velocity.dot(normal) * normal;
+        friction_force = -material.tangential_stiffness * displacement -
+                         material.tangential_damping * tangential_velocity;
+        double magnitude = friction_force.norm();
+        if (magnitude > static_limit) {
+          friction_force *= static_limit / magnitude;
+        }
+      }
+      Eigen::Map<Vector3d>(state.anchor.data()) = anchor;
+      contact_force += friction_force;
+    }
+    friction[friction_count++] = state;
+
+    force += contact_force;
+    torque += (point - origin).cross(contact_force);
+  }
+
+  friction_ = friction;
+  friction_count_ = friction_count;
+  return result;
+}
+
+FrictionState SurfaceRenderer::frictionState(size_t primitive) const noexcept {
+  for (size_t i = 0; i < friction_count_; i++) {
+    if (friction_[i].primitive == primitive) {
+      return friction_[i].state;
+    }
+  }
+  return FrictionState::kNone;
+}
+
+void SurfaceRenderer::reset() noexcept {
+  friction_count_ = 0;
+}
+
+}  // namespace haptics
+}  // namespace franka
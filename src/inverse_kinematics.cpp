@@ -0,0 +1,267 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/inverse_kinematics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+
+namespace franka {
+
+namespace {
+
+// Link lengths of the modified Denavit-Hartenberg parameters of the Panda. The fifth joint has the
+// offset -kA4, the flange is kDFlange above the last joint.
+constexpr double kD1 = 0.333;
+constexpr double kD3 = 0.316;
+constexpr double kD5 = 0.384;
+constexpr double kA4 = 0.0825;
+constexpr double kA7 = 0.088;
+constexpr double kDFlange = 0.107;
+
+// Below this sine of the second joint, the upper arm is considered vertical.
+constexpr double kShoulderSingularity = 1e-9;
+// Solutions closer than this in every joint are considered equal.
+constexpr double kDuplicateTolerance = 1e-9;
+
+constexpr double kPi = 3.14159265358979323846;
+
+Eigen::Matrix3d rotationX(double angle) {
+  return Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitX()).toRotationMatrix();
+}
+
+Eigen::Matrix3d rotationZ(double angle) {
+  return Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+}
+
+double clampCosine(double value) {
+  return std::max(-1.0, std::min(1.0, value));
+}
+
+double squaredDistance(const std::array<double, 7>& a, const std::array<double, 7>& b) {
+  double result = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    result += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  return result;
+}
+
+}  // anonymous namespace
+
+constexpr size_t InverseKinematicsSolutions::kMaxSolutions;
+
+InverseKinematics::InverseKinematics(
+    const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 7>& min_joint_position,
+    const std::array<double, 7>& max_joint_position)
+    : min_joint_position_(min_joint_position), max_joint_position_(max_joint_position) {
+  if (!isHomogeneousTransformation(F_T_EE)) {
+    throw std::invalid_argument("libfranka: Invalid end effector pose for inverse kinematics.");
+  }
+  for (size_t i = 0; i < min_joint_position.size(); i++) {
+    if (!std::isfinite(min_joint_position[i]) || !std::isfinite(max_joint_position[i]) ||
+        min_joint_position[i] > max_joint_position[i]) {
+      throw std::invalid_argument("libfranka: Invalid joint limits for inverse kinematics.");
+    }
+  }
+  Eigen::Map<Eigen::Matrix4d>(EE_T_F_.data()) =
+      Eigen::Affine3d(Eigen::Matrix4d::Map(F_T_EE.data())).inverse().matrix();
+}
+
+InverseKinematicsSolutions InverseKinematics::solve(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    double q7,
+    const std::array<double, 7>& q_reference) const noexcept {
+  InverseKinematicsSolutions solutions;
+  if (!hasFiniteSum(O_T_EE) || !std::isfinite(q7) || q7 < min_joint_position_[6] ||
+      q7 > max_joint_position_[6]) {
+    return solutions;
+  }
+
+  // Moves an angle by a full turn into the limits of a joint, if possible.
+  auto fitLimits = [this](size_t joint, double* angle) {
+    if (*angle < min_joint_position_[joint]) {
+      *angle += 2 * kPi;
+    } else if (*angle > max_joint_position_[joint]) {
+      *angle -= 2 * kPi;
+    }
+    return *angle >= min_joint_position_[joint] && *angle <= max_joint_position_[joint];
+  };
+  auto add = [&solutions](const std::array<double, 7>& q) {
+    for (size_t i = 0; i < solutions.size; i++) {
+      double difference = 0;
+      for (size_t j = 0; j < q.size(); j++) {
+        difference = std::max(difference, std::abs(solutions.q[i][j] - q[j]));
+      }
+      if (difference < kDuplicateTolerance) {
+        return;
+      }
+    }
+    solutions.q[solutions.size++] = q;
+  };
+
+  Eigen::Matrix4d O_T_F =  // NOLINT(readability-identifier-naming)
+      Eigen::Matrix4d::Map(O_T_EE.data()) * Eigen::Matrix4d::Map(EE_T_F_.data());
+  Eigen::Matrix3d r7 = O_T_F.topLeftCorner<3, 3>();
+
+  // The axes of the fifth and sixth joint intersect at the wrist center, which is offset from the
+  // last joint along the x axis of the sixth frame. Its y axis is the negative last joint axis.
+  Eigen::Vector3d x6 = r7 * Eigen::Vector3d(std::cos(q7), -std::sin(q7), 0);
+  Eigen::Vector3d y6 = -r7.col(2);
+  Eigen::Matrix3d r6;
+  r6 << x6, y6, x6.cross(y6);
+  Eigen::Vector3d p6 = O_T_F.topRightCorner<3, 1>() - kDFlange * r7.col(2) - kA7 * x6;
+
+  // The shoulder, elbow and wrist center form a triangle, whose sides from the shoulder and to the
+  // wrist center are fixed by the link lengths.
+  const Eigen::Vector3d p2(0, 0, kD1);
+  Eigen::Vector3d p26 = p6 - p2;
+  const double l24 = std::hypot(kD3, kA4);
+  const double l46 = std::hypot(kD5, kA4);
+  const double l26 = p26.norm();
+  if (l26 > l24 + l46 || l26 < std::abs(l24 - l46)) {
+    return solutions;
+  }
+  const double angle_at_wrist =
+      std::acos(clampCosine((l26 * l26 + l46 * l46 - l24 * l24) / (2 * l26 * l46)));
+  const double forearm_offset_angle = std::atan2(kA4, kD5);
+
+  // The forearm axis, i.e. the fifth joint axis, encloses a known angle with the direction to the
+  // shoulder, for either orientation of the triangle. In the sixth frame the axis is
+  // (sin(q6), cos(q6), 0), which gives two sixth joint positions per orientation.
+  Eigen::Vector3d p62_6 = r6.transpose() * -p26;
+  const double p62_6_norm = std::hypot(p62_6.x(), p62_6.y());
+  const double phase = std::atan2(p62_6.y(), p62_6.x());
+  for (double orientation : {1.0, -1.0}) {
+    double projection = -l26 * std::cos(forearm_offset_angle + orientation * angle_at_wrist);
+    if (p62_6_norm < std::abs(projection)) {
+      continue;
+    }
+    double shift = std::asin(projection / p62_6_norm);
+    for (double q6 : {shift - phase, kPi - shift - phase}) {
+      q6 = std::remainder(q6, 2 * kPi);
+      if (!fitLimits(5, &q6)) {
+        continue;
+      }
+      Eigen::Vector3d z5 = r6 * Eigen::Vector3d(std::sin(q6), std::cos(q6), 0);
+      Eigen::Vector3d x5 = r6 * Eigen::Vector3d(std::cos(q6), -std::sin(q6), 0);
+
+      // The elbow lies in the plane of the forearm axis and the shoulder, offset from the axis
+      // towards or away from the shoulder.
+      Eigen::Vector3d lateral = -p26 - (-p26).dot(z5) * z5;
+      if (lateral.norm() < kShoulderSingularity) {
+        continue;
+      }
+      lateral.normalize();
+      Eigen::Vector3d p4 = p6 - kD5 * z5 + kA4 * lateral;
+      Eigen::Vector3d p4_other = p6 - kD5 * z5 - kA4 * lateral;
+      if (std::abs((p4_other - p2).norm() - l24) < std::abs((p4 - p2).norm() - l24)) {
+        p4 = p4_other;
+      }
+      Eigen::Vector3d x4 = (p4 - p6 + kD5 * z5) / kA4;
+
+      // The upper arm axis and the offset to the elbow follow from the elbow joint axis.
+      Eigen::Vector3d y3 = -x4.cross(z5);
+      Eigen::Vector3d p24 = p4 - p2;
+      Eigen::Vector3d p24_normal = y3.cross(p24);
+      Eigen::Vector3d z3 = (kD3 * p24 - kA4 * p24_normal) / (l24 * l24);
+      Eigen::Vector3d x3 = (kA4 * p24 + kD3 * p24_normal) / (l24 * l24);
+
+      // In base frame, the upper arm axis is (cos(q1) sin(q2), sin(q1) sin(q2), cos(q2)).
+      double q2_base = std::acos(clampCosine(z3.z()));
+      double q1_base = std::hypot(z3.x(), z3.y()) < kShoulderSingularity
+                           ? q_reference[0]
+                           : std::atan2(z3.y(), z3.x());
+      for (bool flipped : {false, true}) {
+        std::array<double, 7> q{};
+        q[0] = flipped ? q1_base - std::copysign(kPi, q1_base) : q1_base;
+        q[1] = flipped ? -q2_base : q2_base;
+        Eigen::Matrix3d r2 = rotationZ(q[0]) * rotationX(-kPi / 2) * rotationZ(q[1]);
+        Eigen::Vector3d x3_2 = r2.transpose() * x3;
+        q[2] = std::atan2(x3_2.z(), x3_2.x());
+        Eigen::Matrix3d r3 = r2 * rotationX(kPi / 2) * rotationZ(q[2]);
+        Eigen::Vector3d x4_3 = r3.transpose() * x4;
+        q[3] = std::atan2(x4_3.z(), x4_3.x());
+        Eigen::Matrix3d r4 = r3 * rotationX(kPi / 2) * rotationZ(q[3]);
+        Eigen::Vector3d x5_4 = r4.transpose() * x5;
+        q[4] = std::atan2(-x5_4.z(), x5_4.x());
+        q[5] = q6;
+        q[6] = q7;
+
+        bool valid = true;
+        for (size_t joint = 0; joint < 5; joint++) {
+          valid = valid && fitLimits(joint, &q[joint]);
+        }
+        if (valid) {
+          add(q);
+        }
+      }
+    }
+  }
+
+  std::sort(solutions.q.begin(), solutions.q.begin() + solutions.size,
+            [&q_reference](const std::array<double, 7>& a, const std::array<double, 7>& b) {
+              return squaredDistance(a, q_reference) < squaredDistance(b, q_reference);
+            });
+  return solutions;
+}
+
+bool InverseKinematics::solveClosest(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    double q7,
+    const std::array<double, 7>& q_current,
+    std::array<double, 7>* q) const noexcept {
+  InverseKinematicsSolutions solutions = solve(O_T_EE, q7, q_current);
+  if (solutions.size == 0) {
+    return false;
+  }
+  *q = solutions.q[0];
+  return true;
+}
+
+std::vector<InverseKinematicsSolutions> InverseKinematics::solveBatch(
+    const std::vector<std::array<double, 16>>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::vector<double>& q7,
+    const std::array<double, 7>& q_reference,
+    size_t thread_count) const {
+  if (O_T_EE.size() != q7.size()) {
+    throw std::invalid_argument("libfranka: Poses and joint positions differ in size.");
+  }
+
+  std::vector<InverseKinematicsSolutions> solutions(O_T_EE.size());
+  auto evaluate = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      solutions[i] = solve(O_T_EE[i], q7[i], q_reference);
+    }
+  };
+
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  thread_count = std::min(thread_count, solutions.size());
+  if (thread_count <= 1) {
+    evaluate(0, solutions.size());
+    return solutions;
+  }
+
+  // Every pose is solved independently, so chunks can be evaluated without synchronization.
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  size_t chunk_size = (solutions.size() + thread_count - 1) / thread_count;
+  for (size_t begin = chunk_size; begin < solutions.size(); begin += chunk_size) {
+    threads.emplace_back(evaluate, begin, std::min(begin + chunk_size, solutions.size()));
+  }
+  evaluate(0, std::min(chunk_size, solutions.size()));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return solutions;
+}
+
+}  // namespace franka
@@ -0,0 +1,193 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace franka {
+
+/**
+ * Receive-side playout buffer for sequence-numbered samples that are sent once per cycle.
+ *
+ * Samples are stored in a fixed ring indexed by their sequence number, so reordered samples are
+ * played out in order and nothing is allocated. Playout starts once `depth` samples are buffered
+ * and then removes one sample per cycle. If the next sample did not arrive yet, pop() fails and the
+ * playout position is kept, so the buffer refills by itself after a burst. Samples that are still
+ * missing while `depth` newer ones are buffered are counted as lost. If the buffer falls too far
+ * behind, e.g. after the sender's clock ran faster for a while, it skips ahead to keep the delay
+ * bounded.
+ *
+ * Sequence numbers may wrap around.
+ */
+template <typename T, size_t N = 64>
+class JitterBuffer {
+ public:
+  /**
+   * Maximum number of samples by which the buffer may exceed its depth before skipping ahead.
+   */
+  static constexpr uint32_t kMaxExcess = N / 4;
+
+  static_assert(N >= 8, "Jitter buffer needs at least 8 slots.");
+
+  /**
+   * Creates an empty buffer.
+   *
+   * @param[in] depth Number of samples to buffer before playout. Must be smaller than N / 2.
+   */
+  explicit JitterBuffer(uint32_t depth) noexcept : depth_(depth) {}
+
+  /**
+   * Stores a received sample.
+   *
+   * @param[in] sequence Sequence number of the sample.
+   * @param[in] sample Received sample.
+   * @param[in] arrival Time at which the sample was received.
+   *
+   * @return False if the sample was dropped because it arrived after its playout time or twice.
+   */
+  bool push(uint32_t sequence,
+            const T& sample,
+            std::chrono::steady_clock::time_point arrival) noexcept {
+    if (!started_) {
+      started_ = true;
+      next_ = sequence;
+      newest_ = sequence;
+    } else if (distance(sequence, next_) < 0) {
+      late_++;
+      return false;
+    }
+    Slot& slot = slots_[sequence % N];
+    if (slot.valid && slot.sequence == sequence) {
+      return false;
+    }
+    slot.valid = true;
+    slot.sequence = sequence;
+    slot.sample = sample;
+    slot.arrival = arrival;
+    if (distance(sequence, newest_) > 0) {
+      newest_ = sequence;
+    }
+    received_++;
+    return true;
+  }
+
+  /**
+   * Removes the sample that is due in this cycle.
+   *
+   * @param[out] sample Sample that is due. Unchanged if pop() fails.
+   * @param[in] now Current time, used to measure how long the sample was buffered.
+   *
+   * @return False if the buffer is still filling up or the sample did not arrive yet.
+   */
+  bool pop(T* sample, std::chrono::steady_clock::time_point now) noexcept {
+    if (!started_) {
+      return false;
+    }
+    int32_t level = distance(newest_, next_) + 1;
+    if (filling_) {
+      if (level <= static_cast<int32_t>(depth_)) {
+        return false;
+      }
+      filling_ = false;
+    }
+    if (level > static_cast<int32_t>(depth_ + kMaxExcess)) {
+      uint32_t skip = static_cast<uint32_t>(level) - depth_ - 1;
+      skipped_ += skip;
+      next_ += skip;
+      level = static_cast<int32_t>(depth_) + 1;
+    }
+    while (level > 0) {
+      Slot& slot = slots_[next_ % N];
+      if (slot.valid && slot.sequence == next_) {
+        *sample = slot.sample;
+        slot.valid = false;
+        next_++;
+        playout_delay_ = std::chrono::duration<double>(now - slot.arrival).count();
+        return true;
+      }
+      if (level <= static_cast<int32_t>(depth_)) {
+        // The sample may still arrive within the jitter it is allowed to have.
+        break;
+      }
+      lost_++;
+      next_++;
+      level--;
+    }
+    underruns_++;
+    return false;
+  }
+
+  /**
+   * @return Number of samples between the playout position and the newest sample, including
+   * samples that did not arrive yet.
+   */
+  uint32_t buffered() const noexcept {
+    return started_ ? static_cast<uint32_t>(distance(newest_, next_) + 1) : 0;
+  }
+
+  /**
+   * @return Number of samples to buffer before playout.
+   */
+  uint32_t depth() const noexcept { return depth_; }
+
+  /**
+   * @return Number of samples that were stored.
+   */
+  uint64_t received() const noexcept { return received_; }
+
+  /**
+   * @return Number of samples that never arrived before their playout time.
+   */
+  uint64_t lost() const noexcept { return lost_; }
+
+  /**
+   * @return Number of samples that arrived after their playout time.
+   */
+  uint64_t late() const noexcept { return late_; }
+
+  /**
+   * @return Number of cycles in which no sample could be played out after playout started.
+   */
+  uint64_t underruns() const noexcept { return underruns_; }
+
+  /**
+   * @return Number of samples skipped because the buffer fell too far behind.
+   */
+  uint64_t skipped() const noexcept { return skipped_; }
+
+  /**
+   * @return Time in [s] that the last played out sample spent in the buffer.
+   */
+  double playoutDelay() const noexcept { return playout_delay_; }
+
+ private:
+  struct Slot {
+    bool valid{false};
+    uint32_t sequence{0};
+    T sample{};
+    std::chrono::steady_clock::time_point arrival{};
+  };
+
+  static int32_t distance(uint32_t a, uint32_t b) noexcept { return static_cast<int32_t>(a - b); }
+
+  const uint32_t depth_;
+  std::array<Slot, N> slots_{};
+  bool started_{false};
+  bool filling_{true};
+  uint32_t next_{0};
+  uint32_t newest_{0};
+  uint64_t received_{0};
+  uint64_t lost_{0};
+  uint64_t late_{0};
+  uint64_t underruns_{0};
+  uint64_t skipped_{0};
+  double playout_delay_{0};
+};
+
+template <typename T, size_t N>
+constexpr uint32_t JitterBuffer<T, N>::kMaxExcess;
+
+}  // namespace franka
@@ -0,0 +1,84 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/joint_impedance_controller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include <franka/rate_limiting.h>
+
+namespace franka {
+
+namespace {
+
+bool isNonNegative(double value) {
+  return std::isfinite(value) && value >= 0.0;
+}
+
+}  // anonymous namespace
+
+JointImpedanceController::JointImpedanceController(const std::array<double, 7>& stiffness,
+                                                   const std::array<double, 7>& damping,
+                                                   bool limit_rate)
+    : limit_rate_(limit_rate) {
+  setGains(stiffness, damping);
+}
+
+void JointImpedanceController::setGains(const std::array<double, 7>& stiffness,
+                                        const std::array<double, 7>& damping) {
+  if (!std::all_of(stiffness.begin(), stiffness.end(), isNonNegative) ||
+      !std::all_of(damping.begin(), damping.end(), isNonNegative)) {
+    throw std::invalid_argument(
+        "libfranka: Joint impedance controller gains must not be negative, infinite or NaN.");
+  }
+  stiffness_ = stiffness;
+  damping_ = damping;
+}
+
+void JointImpedanceController::setStatePublisher(
+    std::shared_ptr<StatePublisher> publisher) noexcept {
+  publisher_ = std::move(publisher);
+}
+
+std::array<double, 7> JointImpedanceController::update(const RobotState& robot_state,
+                                                       const Model& model) {
+  return update(robot_state, model, robot_state.q_d);
+}
+
+std::array<double, 7> JointImpedanceController::update(const RobotState& robot_state,
+                                                       const Model& model,
+                                                       const std::array<double, 7>& q_d) {
+  model.dynamics(robot_state, &dynamics_);
+  return update(robot_state, dynamics_, q_d);
+}
+
+std::array<double, 7> JointImpedanceController::update(const RobotState& robot_state,
+                                                       const DynamicsBundle& dynamics,
+                                                       const std::array<double, 7>& q_d) {
+  for (size_t i = 0; i < 7; i++) {
+    torques_.tau_d_commanded[i] = stiffness_[i] * (q_d[i] - robot_state.q[i]) -
+                                  damping_[i] * robot_state.dq[i] + dynamics.coriolis[i];
+  }
+  torques_.tau_d_limited =
+      limit_rate_ ? limitRate(kMaxTorqueRate, torques_.tau_d_commanded, robot_state.tau_J_d)
+                  : torques_.tau_d_commanded;
+  torques_.gravity = dynamics.gravity;
+
+  if (publisher_) {
+    published_command_.torques.tau_J = torques_.tau_d_limited;
+    publisher_->publish(robot_state, published_command_, torques_);
+  }
+  return torques_.tau_d_limited;
+}
+
+const DynamicsBundle& JointImpedanceController::dynamics() const noexcept {
+  return dynamics_;
+}
+
+const ControllerTorques& JointImpedanceController::torques() const noexcept {
+  return torques_;
+}
+
+}  // namespace franka
@@ -0,0 +1,133 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/joint_state_estimator.h>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace franka {
+
+namespace {
+
+// Variance of the joint acceleration at initialization. Unit: [rad^2/s^4]
+constexpr double kInitialAccelerationVariance = 1e2;
+
+bool isPositiveAndFinite(double value) {
+  return value > 0 && std::isfinite(value);
+}
+
+}  // anonymous namespace
+
+JointStateEstimator::JointStateEstimator(const JointStateEstimatorParameters& parameters)
+    : parameters_(parameters) {
+  if (!isPositiveAndFinite(parameters.jerk_noise) ||
+      !isPositiveAndFinite(parameters.position_noise) ||
+      !isPositiveAndFinite(parameters.velocity_noise)) {
+    throw std::invalid_argument(
+        "libfranka: Joint state estimator noise parameters must be positive and finite.");
+  }
+}
+
+void JointStateEstimator::initialize(const std::array<double, 7>& q,
+                                     const std::array<double, 7>& dq) noexcept {
+  q_ = q;
+  dq_ = dq;
+  ddq_.fill(0);
+  p00_.fill(parameters_.position_noise);
+  p01_.fill(0);
+  p02_.fill(0);
+  p11_.fill(parameters_.velocity_noise);
+  p12_.fill(0);
+  p22_.fill(kInitialAccelerationVariance);
+  initialized_ = true;
+}
+
+void JointStateEstimator::update(const std::array<double, 7>& q,
+                                 const std::array<double, 7>& dq,
+                                 double time_step) noexcept {
+  if (!initialized_ || !(time_step > 0)) {
+    initialize(q, dq);
+    return;
+  }
+
+  const double a = time_step;
+  const double b = 0.5 * time_step * time_step;
+  const double s = parameters_.jerk_noise;
+  const double q00 = s * std::pow(time_step, 5) / 20;
+  const double q01 = s * std::pow(time_step, 4) / 8;
+  const double q02 = s * std::pow(time_step, 3) / 6;
+  const double q11 = s * std::pow(time_step, 3) / 3;
+  const double q12 = s * time_step * time_step / 2;
+  const double q22 = s * time_step;
+
+  for (size_t i = 0; i < 7; i++) {
+    // Predict with x = F x and P = F P F^T + Q, where F = [1 a b; 0 1 a; 0 0 1].
+    double x0 = q_[i] + a * dq_[i] + b * ddq_[i];
+    double x1 = dq_[i] + a * ddq_[i];
+    double x2 = ddq_[i];
+
+    double r00 = p00_[i] + a * p01_[i] + b * p02_[i];
+    double r01 = p01_[i] + a * p11_[i] + b * p12_[i];
+    double r02 = p02_[i] + a * p12_[i] + b * p22_[i];
+    double r11 = p11_[i] + a * p12_[i];
+    double r12 = p12_[i] + a * p22_[i];
+
+    double n00 = r00 + a * r01 + b * r02 + q00;
+    double n01 = r01 + a * r02 + q01;
+    double n02 = r02 + q02;
+    double n11 = r11 + a * r12 + q11;
+    double n12 = r12 + q12;
+    double n22 = p22_[i] + q22;
+
+    // Correct with the measurement z = [q dq].
+    double s00 = n00 + parameters_.position_noise;
+    double s01 = n01;
+    double s11 = n11 + parameters_.velocity_noise;
+    double det = s00 * s11 - s01 * s01;
+
+    double k00 = (n00 * s11 - n01 * s01) / det;
+    double k01 = (n01 * s00 - n00 * s01) / det;
+    double k10 = (n01 * s11 - n11 * s01) / det;
+    double k11 = (n11 * s00 - n01 * s01) / det;
+    double k20 = (n02 * s11 - n12 * s01) / det;
+    double k21 = (n12 * s00 - n02 * s01) / det;
+
+    double e0 = q[i] - x0;
+    double e1 = dq[i] - x1;
+    q_[i] = x0 + k00 * e0 + k01 * e1;
+    dq_[i] = x1 + k10 * e0 + k11 * e1;
+    ddq_[i] = x2 + k20 * e0 + k21 * e1;
+
+    // P = (I - K H) P
+    p00_[i] = n00 - k00 * n00 - k01 * n01;
+    p01_[i] = n01 - k00 * n01 - k01 * n11;
+    p02_[i] = n02 - k00 * n02 - k01 * n12;
+    p11_[i] = n11 - k10 * n01 - k11 * n11;
+    p12_[i] = n12 - k10 * n02 - k11 * n12;
+    p22_[i] = n22 - k20 * n02 - k21 * n12;
+  }
+}
+
+void JointStateEstimator::update(RobotState* robot_state, Duration time_step) noexcept {
+  update(robot_state->q, robot_state->dq, time_step.toSec());
+  robot_state->dq = dq_;
+  robot_state->ddq_hat = ddq_;
+}
+
+void JointStateEstimator::reset() noexcept {
+  initialized_ = false;
+}
+
+const std::array<double, 7>& JointStateEstimator::q() const noexcept {
+  return q_;
+}
+
+const std::array<double, 7>& JointStateEstimator::dq() const noexcept {
+  return dq_;
+}
+
+const std::array<double, 7>& JointStateEstimator::ddq() const noexcept {
+  return ddq_;
+}
+
+}  // namespace franka
@@ -0,0 +1,187 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/joint_trajectory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+#include <franka/rate_limiting.h>
+
+namespace franka {
+
+namespace {
+
+using Array7d = Eigen::Array<double, 7, 1>;
+using ArrayMap = Eigen::Map<Array7d>;
+using ConstArrayMap = Eigen::Map<const Array7d>;
+
+// Joints that move less than this are considered to be at their goal.
+constexpr double kMinimumMotion = 1e-6;
+
+}  // anonymous namespace
+
+JointTrajectoryLimits JointTrajectoryLimits::fromSpeedFactor(double speed_factor) {
+  if (!(speed_factor > 0.0 && speed_factor <= 1.0)) {
+    throw std::invalid_argument("libfranka: Speed factor must be in range (0, 1].");
+  }
+  JointTrajectoryLimits limits;
+  ArrayMap(limits.max_velocity.data()) = speed_factor * ConstArrayMap(kMaxJointVelocity.data());
+  ArrayMap(limits.max_acceleration.data()) =
+      speed_factor * ConstArrayMap(kMaxJointAcceleration.data());
+  limits.max_deceleration = limits.max_acceleration;
+  return limits;
+}
+
+JointTrajectory::JointTrajectory(const std::array<double, 7>& q_start,
+                                 const std::array<double, 7>& q_goal,
+                                 const JointTrajectoryLimits& limits)
+    : q_start_(q_start) {
+  ConstArrayMap dq_max(limits.max_velocity.data());
+  ConstArrayMap ddq_max_start(limits.max_acceleration.data());
+  ConstArrayMap ddq_max_goal(limits.max_deceleration.data());
+  if (!((dq_max > 0).all() && (ddq_max_start > 0).all() && (ddq_max_goal > 0).all())) {
+    throw std::invalid_argument("libfranka: Joint trajectory limits must be positive.");
+  }
+
+  Array7d delta_q = ConstArrayMap(q_goal.data()) - ConstArrayMap(q_start.data());
+  Eigen::Array<bool, 7, 1> moving = delta_q.abs() >= kMinimumMotion;
+  delta_q = moving.select(delta_q, 0.0);
+  ArrayMap(delta_q_.data()) = delta_q;
+  if (!moving.any()) {
+    return;
+  }
+  Array7d distance = delta_q.abs();
+
+  // Unsynchronized duration of each joint. Short motions do not reach the maximum velocity.
+  Array7d reachable_velocity = (4.0 / 3.0 * distance * ddq_max_start * ddq_max_goal /
+                                (ddq_max_start + ddq_max_goal))
+                                   .sqrt()
+                                   .min(dq_max);
+  Array7d t_f = 0.75 * reachable_velocity / ddq_max_start +
+                0.75 * reachable_velocity / ddq_max_goal + distance / reachable_velocity;
+  duration_ = moving.select(t_f, 0.0).maxCoeff();
+
+  // Velocity with which each joint finishes after exactly duration_.
+  Array7d a = 0.75 * (ddq_max_goal + ddq_max_start);
+  Array7d b = -duration_ * ddq_max_goal * ddq_max_start;
+  Array7d c = distance * ddq_max_goal * ddq_max_start;
+  Array7d discriminant = (b.square() - 4.0 * a * c).max(0.0);
+  Array7d velocity = (-b - discriminant.sqrt()) / (2.0 * a);
+
+  Array7d t_1 = 1.5 * velocity / ddq_max_start;
+  Array7d delta_t_2 = 1.5 * velocity / ddq_max_goal;
+  Array7d t_f_sync = 0.5 * t_1 + 0.5 * delta_t_2 + distance / velocity;
+  Array7d sign = delta_q.sign();
+
+  ArrayMap(velocity_.data()) = moving.select(sign * velocity, 0.0);
+  ArrayMap(t_1_.data()) = moving.select(t_1, 0.0);
+  ArrayMap(t_f_.data()) = moving.select(t_f_sync, 0.0);
+  ArrayMap(t_2_.data()) = moving.select(t_f_sync - delta_t_2, 0.0);
+  ArrayMap(delta_t_2_.data()) = moving.select(delta_t_2, 1.0);
+  ArrayMap(q_1_.data()) = moving.select(sign * velocity * 0.5 * t_1, 0.0);
+}
+
+double JointTrajectory::duration() const noexcept {
+  return duration_;
+}
+
+std::array<double, 7> JointTrajectory::position(double t) const noexcept {
+  ConstArrayMap velocity(velocity_.data());
+  ConstArrayMap t_1(t_1_.data());
+  ConstArrayMap t_2(t_2_.data());
+  ConstArrayMap t_f(t_f_.data());
+  ConstArrayMap delta_t_2(delta_t_2_.data());
+  ConstArrayMap delta_q(delta_q_.data());
+
+  // All phases are evaluated for all joints and the active one is selected, which avoids
+  // branching per joint. Unused phases of stationary joints have finite placeholder values.
+  Array7d time = Array7d::Constant(std::max(t, 0.0));
+  Array7d t_1_safe = (t_1 > 0).select(t_1, 1.0);
+  Array7d acceleration =
+      velocity * time.cube() * (1.0 / t_1_safe.square() - 0.5 * time / t_1_safe.cube());
+  Array7d cruise = ConstArrayMap(q_1_.data()) + (time - t_1) * velocity;
+  Array7d tau = time - t_2;
+  Array7d deceleration =
+      delta_q + 0.5 * velocity *
+                    ((tau - 2.0 * delta_t_2) * tau.cube() / delta_t_2.cube() + 2.0 * tau -
+                     delta_t_2);
+
+  Array7d delta = (time < t_f).select(deceleration, delta_q);
+  delta = (time < t_2).select(cruise, delta);
+  delta = (time < t_1).select(acceleration, delta);
+
+  std::array<double, 7> q;
+  ArrayMap(q.data()) = ConstArrayMap(q_start_.data()) + delta;
+  return q;
+}
+
+std::array<double, 7> JointTrajectory::velocity(double t) const noexcept {
+  ConstArrayMap velocity(velocity_.data());
+  ConstArrayMap t_1(t_1_.data());
+  ConstArrayMap t_2(t_2_.data());
+  ConstArrayMap t_f(t_f_.data());
+  ConstArrayMap delta_t_2(delta_t_2_.data());
+
+  Array7d time = Array7d::Constant(t);
+  Array7d t_1_safe = (t_1 > 0).select(t_1, 1.0);
+  Array7d acceleration =
+      velocity * time.square() * (3.0 / t_1_safe.square() - 2.0 * time / t_1_safe.cube());
+  Array7d tau = time - t_2;
+  Array7d deceleration =
+      0.5 * velocity *
+      ((4.0 * tau.cube() - 6.0 * delta_t_2 * tau.square()) / delta_t_2.cube() + 2.0);
+
+  std::array<double, 7> dq;
+  ArrayMap result(dq.data());
+  result = (time < t_f).select(deceleration, 0.0);
+  result = (time < t_2).select(velocity, result);
+  result = (time < t_1).select(acceleration, result);
+  result = (time < 0.0).select(0.0, result);
+  return dq;
+}
+
+std::array<double, 7> JointTrajectory::cruiseVelocity() const noexcept {
+  return velocity_;
+}
+
+std::array<double, 7> JointTrajectory::accelerationTime() const noexcept {
+  return t_1_;
+}
+
+std::array<double, 7> JointTrajectory::decelerationTime() const noexcept {
+  std::array<double, 7> delta_t_2;
+  ArrayMap(delta_t_2.data()) =
+      (ConstArrayMap(t_1_.data()) > 0).select(ConstArrayMap(delta_t_2_.data()), 0.0);
+  return delta_t_2;
+}
+
+JointMotionGenerator::JointMotionGenerator(double speed_factor,
+                                           const std::array<double, 7>& q_goal)
+    : JointMotionGenerator(JointTrajectoryLimits::fromSpeedFactor(speed_factor), q_goal) {}
+
+JointMotionGenerator::JointMotionGenerator(const JointTrajectoryLimits& limits,
+                                           const std::array<double, 7>& q_goal)
+    : limits_(limits), q_goal_(q_goal), trajectory_(q_goal, q_goal, limits) {}
+
+JointMotionGenerator::JointMotionGenerator(const JointTrajectory& trajectory)
+    : trajectory_(trajectory), start_from_state_(false) {}
+
+JointPositions JointMotionGenerator::operator()(const RobotState& robot_state,
+                                                Duration period) {
+  if (period.toMSec() == 0) {
+    time_ = 0.0;
+    if (start_from_state_) {
+      trajectory_ = JointTrajectory(robot_state.q_d, q_goal_, limits_);
+    }
+  }
+  time_ += period.toSec();
+
+  JointPositions output(trajectory_.position(time_));
+  output.motion_finished = time_ >= trajectory_.duration();
+  return output;
+}
+
+}  // namespace franka
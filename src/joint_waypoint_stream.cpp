@@ -0,0 +1,216 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/joint_waypoint_stream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+#include "spsc_queue.h"
+
+namespace franka {
+
+namespace {
+
+struct Waypoint {
+  std::array<double, 7> q;
+  JointTrajectoryLimits limits;
+};
+
+void checkLimits(const JointTrajectoryLimits& limits) {
+  for (size_t i = 0; i < 7; i++) {
+    if (!(limits.max_velocity[i] > 0 && limits.max_acceleration[i] > 0 &&
+          limits.max_deceleration[i] > 0)) {
+      throw std::invalid_argument("libfranka: Joint trajectory limits must be positive.");
+    }
+  }
+}
+
+// Longest time by which next may start before current ends.
+//
+// During the overlap, the joint velocities and accelerations are the sums of both segments. The
+// overlap is limited to half of each segment, so that at most two segments are active at a time.
+// Joints that move in only one of the segments are not affected. For the others:
+// - If a joint keeps its direction, the accelerations of the deceleration phase of current and of
+//   the acceleration phase of next have opposite signs. If both cruise velocities together are
+//   within the limit, the overlap must only keep the acceleration phase of current and the
+//   deceleration phase of next out of it. Otherwise, an overlap of at most half of the phases keeps
+//   the sum of the velocities below the larger cruise velocity.
+// - If a joint reverses, the velocities have opposite signs, while the accelerations add up. An
+//   overlap of at most a quarter of the phases keeps their sum within the acceleration limit.
+double blendTime(const JointTrajectory& current,
+                 const std::array<double, 7>& current_max_velocity,
+                 const JointTrajectory& next,
+                 const std::array<double, 7>& next_max_velocity) noexcept {
+  std::array<double, 7> current_velocity = current.cruiseVelocity();
+  std::array<double, 7> current_acceleration_time = current.accelerationTime();
+  std::array<double, 7> current_deceleration_time = current.decelerationTime();
+  std::array<double, 7> next_velocity = next.cruiseVelocity();
+  std::array<double, 7> next_acceleration_time = next.accelerationTime();
+  std::array<double, 7> next_deceleration_time = next.decelerationTime();
+
+  double blend_time = std::min(current.duration(), next.duration()) / 2;
+  for (size_t i = 0; i < 7; i++) {
+    if (current_velocity[i] == 0.0 || next_velocity[i] == 0.0) {
+      continue;
+    }
+    double phase_time = std::min(current_deceleration_time[i], next_acceleration_time[i]);
+    if (current_velocity[i] * next_velocity[i] < 0.0) {
+      blend_time = std::min(blend_time, phase_time / 4);
+    } else if (std::abs(current_velocity[i]) + std::abs(next_velocity[i]) >
+               std::min(current_max_velocity[i], next_max_velocity[i])) {
+      blend_time = std::min(blend_time, phase_time / 2);
+    } else {
+      blend_time = std::min({blend_time, current.duration() - current_acceleration_time[i],
+                             next.duration() - next_deceleration_time[i]});
+    }
+  }
+  return blend_time;
+}
+
+}  // anonymous namespace
+
+class JointWaypointStream::Impl {
+ public:
+  Impl(const JointTrajectoryLimits& limits, size_t queue_capacity)
+      : limits_(limits),
+        queue_(queue_capacity),
+        current_({}, {}, limits),
+        next_({}, {}, limits) {}
+
+  bool push(const std::array<double, 7>& q, const JointTrajectoryLimits& limits) noexcept {
+    return queue_.push(Waypoint{q, limits});
+  }
+
+  void finish() noexcept { finished_.store(true, std::memory_order_release); }
+
+  uint64_t reachedWaypoints() const noexcept {
+    return reached_waypoints_.load(std::memory_order_relaxed);
+  }
+
+  const JointTrajectoryLimits& limits() const noexcept { return limits_; }
+
+  JointPositions update(const RobotState& robot_state, Duration period) noexcept {
+    if (period.toMSec() == 0) {
+      time_ = 0.0;
+      has_current_ = false;
+      has_next_ = false;
+      q_end_ = robot_state.q_d;
+    }
+    time_ += period.toSec();
+
+    // Read the flag before polling the queue, so that all waypoints pushed before finish() are
+    // seen when the queue turns out to be empty.
+    bool finished = finished_.load(std::memory_order_acquire);
+    bool planned = !has_next_ && planNext();
+
+    if (has_current_ && time_ >= current_start_ + current_.duration()) {
+      reached_waypoints_.fetch_add(1, std::memory_order_relaxed);
+      has_current_ = has_next_;
+      has_next_ = false;
+      if (has_current_) {
+        current_ = next_;
+        current_start_ = next_start_;
+        current_max_velocity_ = next_max_velocity_;
+      }
+    }
+
+    JointPositions output(q_end_);
+    if (has_current_) {
+      output.q = current_.position(time_ - current_start_);
+      if (has_next_) {
+        std::array<double, 7> q_next = next_.position(time_ - next_start_);
+        for (size_t i = 0; i < 7; i++) {
+          output.q[i] += q_next[i] - current_end_[i];
+        }
+      }
+    }
+    output.motion_finished = finished && !planned && !has_current_;
+    return output;
+  }
+
+ private:
+  // Plans the segment to the next queued waypoint, if any. Waypoints that do not require a motion
+  // are reached immediately.
+  bool planNext() noexcept {
+    Waypoint waypoint;
+    if (!queue_.pop(&waypoint)) {
+      return false;
+    }
+    JointTrajectory trajectory(q_end_, waypoint.q, waypoint.limits);
+    if (trajectory.duration() == 0.0) {
+      reached_waypoints_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    std::array<double, 7> q_start = q_end_;
+    q_end_ = trajectory.position(trajectory.duration());
+    if (!has_current_) {
+      current_ = trajectory;
+      current_start_ = time_;
+      current_max_velocity_ = waypoint.limits.max_velocity;
+      has_current_ = true;
+    } else {
+      next_ = trajectory;
+      next_start_ = std::max(time_, current_start_ + current_.duration() -
+                                        blendTime(current_, current_max_velocity_, next_,
+                                                  waypoint.limits.max_velocity));
+      next_max_velocity_ = waypoint.limits.max_velocity;
+      current_end_ = q_start;
+      has_next_ = true;
+    }
+    return true;
+  }
+
+  const JointTrajectoryLimits limits_;
+  SpscQueue<Waypoint> queue_;
+  std::atomic<bool> finished_{false};
+  std::atomic<uint64_t> reached_waypoints_{0};
+
+  // State of the control loop.
+  double time_{0.0};
+  std::array<double, 7> q_end_{};
+  bool has_current_{false};
+  JointTrajectory current_;
+  double current_start_{0.0};
+  std::array<double, 7> current_max_velocity_{};
+  std::array<double, 7> current_end_{};
+  bool has_next_{false};
+  JointTrajectory next_;
+  double next_start_{0.0};
+  std::array<double, 7> next_max_velocity_{};
+};
+
+JointWaypointStream::JointWaypointStream(const JointTrajectoryLimits& limits,
+                                         size_t queue_capacity) {
+  checkLimits(limits);
+  impl_.reset(new Impl(limits, queue_capacity));
+}
+
+JointWaypointStream::~JointWaypointStream() noexcept = default;
+
+bool JointWaypointStream::push(const std::array<double, 7>& q) noexcept {
+  return impl_->push(q, impl_->limits());
+}
+
+bool JointWaypointStream::push(const std::array<double, 7>& q,
+                               const JointTrajectoryLimits& limits) {
+  checkLimits(limits);
+  return impl_->push(q, limits);
+}
+
+void JointWaypointStream::finish() noexcept {
+  impl_->finish();
+}
+
+uint64_t JointWaypointStream::reachedWaypoints() const noexcept {
+  return impl_->reachedWaypoints();
+}
+
+JointPositions JointWaypointStream::operator()(const RobotState& robot_state,
+                                               Duration period) noexcept {
+  return impl_->update(robot_state, period);
+}
+
+}  // namespace franka
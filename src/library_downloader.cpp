@@ -4,8 +4,12 @@
 
 #include <exception>
 #include <fstream>
+#include <iterator>
 #include <vector>
 
+#include <Poco/DigestEngine.h>
+#include <Poco/Path.h>
+#include <Poco/SHA1Engine.h>
 #include <Poco/SharedLibrary.h>
 
 #include <franka/exception.h>
@@ -15,49 +19,154 @@
 
 namespace franka {
 
-LibraryDownloader::LibraryDownloader(Network& network)
-    : model_library_file_{Poco::TemporaryFile::tempName() + Poco::SharedLibrary::suffix()} {
-  using research_interface::robot::LoadModelLibrary;
-  LoadModelLibrary::Architecture architecture;
-  LoadModelLibrary::System operating_system;
+namespace {
 
+using research_interface::robot::LoadModelLibrary;
+
+LoadModelLibrary::Architecture architecture() {
 #if defined(LIBFRANKA_X64)
-  architecture = LoadModelLibrary::Architecture::kX64;
+  return LoadModelLibrary::Architecture::kX64;
 #elif defined(LIBFRANKA_X86)
-  architecture = LoadModelLibrary::Architecture::kX86;
+  return LoadModelLibrary::Architecture::kX86;
 #elif defined(LIBFRANKA_ARM64)
-  architecture = LoadModelLibrary::Architecture::kARM64;
+  return LoadModelLibrary::Architecture::kARM64;
 #elif defined(LIBFRANKA_ARM)
-  architecture = LoadModelLibrary::Architecture::kARM;
+  return LoadModelLibrary::Architecture::kARM;
 #else
   throw ModelException("libfranka: Unsupported architecture!");
 #endif
+}
 
+LoadModelLibrary::System operatingSystem() {
 #if defined(LIBFRANKA_WINDOWS)
-  operating_system = LoadModelLibrary::System::kWindows;
+  return LoadModelLibrary::System::kWindows;
 #elif defined(LIBFRANKA_LINUX)
-  operating_system = LoadModelLibrary::System::kLinux;
+  return LoadModelLibrary::System::kLinux;
 #else
   throw ModelException("libfranka: Unsupported operating system!");
 #endif
+}
 
-  uint32_t command_id = network.tcpSendRequest<LoadModelLibrary>(architecture, operating_system);
-  std::vector<uint8_t> buffer;
+TcpResponseData download(Network& network) {
+  uint32_t command_id =
+      network.tcpSendRequest<LoadModelLibrary>(architecture(), operatingSystem());
+  TcpResponseData library;
   LoadModelLibrary::Response response =
-      network.tcpBlockingReceiveResponse<LoadModelLibrary>(command_id, &buffer);
+      network.tcpBlockingReceiveResponse<LoadModelLibrary>(command_id, &library);
   if (response.status != LoadModelLibrary::Status::kSuccess) {
     throw ModelException("libfranka: Server reports error when loading model library.");
   }
+  return library;
+}
 
-  try {
-    std::ofstream model_library_stream(path().c_str(), std::ios_base::out | std::ios_base::binary);
-    model_library_stream.write(reinterpret_cast<char*>(buffer.data()), buffer.size());
-  } catch (const std::exception& ex) {
+std::string cacheKey(uint16_t server_version) {
+  return "model-v" + std::to_string(server_version) + "-arch" +
+         std::to_string(static_cast<int>(architecture())) + "-os" +
+         std::to_string(static_cast<int>(operatingSystem()));
+}
+
+std::string joinPath(const std::string& directory, const std::string& file_name) {
+  Poco::Path path(directory);
+  path.makeDirectory();
+  path.setFileName(file_name);
+  return path.toString();
+}
+
+std::string hash(const void* data, size_t size) {
+  Poco::SHA1Engine engine;
+  engine.update(data, size);
+  return Poco::DigestEngine::digestToHex(engine.digest());
+}
+
+void writeFile(const std::string& path, const void* data, size_t size) {
+  std::ofstream stream(path.c_str(), std::ios_base::out | std::ios_base::binary);
+  stream.write(reinterpret_cast<const char*>(data), size);
+  if (!stream) {
     throw ModelException("libfranka: Cannot save model library.");
   }
 }
 
+// Writes to a temporary file first, so that concurrent readers never see partial contents.
+void writeFileAtomically(const std::string& directory,
+                         const std::string& path,
+                         const void* data,
+                         size_t size) {
+  Poco::File temporary_file(Poco::TemporaryFile::tempName(directory));
+  try {
+    writeFile(temporary_file.path(), data, size);
+    temporary_file.renameTo(path);
+  } catch (...) {
+    try {
+      temporary_file.remove();
+    } catch (...) {
+    }
+    throw;
+  }
+}
+
+bool hasHash(const std::string& path, const std::string& expected_hash) {
+  std::ifstream stream(path.c_str(), std::ios_base::in | std::ios_base::binary);
+  std::vector<char> contents{std::istreambuf_iterator<char>(stream),
+                             std::istreambuf_iterator<char>()};
+  return stream.is_open() && hash(contents.data(), contents.size()) == expected_hash;
+}
+
+std::string lookupCachedLibrary(const std::string& directory, const std::string& key) {
+  std::ifstream index_stream(joinPath(directory, key + ".index").c_str());
+  std::string library_hash;
+  if (!(index_stream >> library_hash)) {
+    return "";
+  }
+
+  std::string path = joinPath(directory, library_hash + Poco::SharedLibrary::suffix());
+  return hasHash(path, library_hash) ? path : "";
+}
+
+std::string storeCachedLibrary(const std::string& directory,
+                               const std::string& key,
+                               const TcpResponseData& library) {
+  Poco::File(directory).createDirectories();
+
+  std::string library_hash = hash(library.data(), library.size());
+  std::string path = joinPath(directory, library_hash + Poco::SharedLibrary::suffix());
+  // An existing file may be corrupt, e.g. the one that caused this download.
+  if (!hasHash(path, library_hash)) {
+    writeFileAtomically(directory, path, library.data(), library.size());
+  }
+  writeFileAtomically(directory, joinPath(directory, key + ".index"), library_hash.data(),
+                      library_hash.size());
+  return path;
+}
+
+}  // anonymous namespace
+
+LibraryDownloader::LibraryDownloader(Network& network) {
+  saveTemporary(download(network));
+}
+
+LibraryDownloader::LibraryDownloader(Network& network,
+                                     const std::string& cache_directory,
+                                     uint16_t server_version) {
+  std::string key = cacheKey(server_version);
+  std::string cached_path = lookupCachedLibrary(cache_directory, key);
+  if (!cached_path.empty()) {
+    model_library_file_ = Poco::File(cached_path);
+    return;
+  }
+
+  TcpResponseData library = download(network);
+  try {
+    model_library_file_ = Poco::File(storeCachedLibrary(cache_directory, key, library));
+  } catch (const std::exception&) {
+    // The cache is only an optimization, so fall back to a temporary file.
+    saveTemporary(library);
+  }
+}
+
 LibraryDownloader::~LibraryDownloader() {
+  if (!temporary_) {
+    return;
+  }
   try {
     if (model_library_file_.exists()) {
       Poco::TemporaryFile::registerForDeletion(path());
@@ -67,6 +176,13 @@ LibraryDownloader::~LibraryDownloader() {
   }
 }
 
+void LibraryDownloader::saveTemporary(const TcpResponseData& library) {
+  model_library_file_ =
+      Poco::File(Poco::TemporaryFile::tempName() + Poco::SharedLibrary::suffix());
+  temporary_ = true;
+  writeFile(path(), library.data(), library.size());
+}
+
 const std::string& LibraryDownloader::path() const noexcept {
   return model_library_file_.path();
 }
@@ -2,7 +2,9 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <Poco/TemporaryFile.h>
 
@@ -12,13 +14,34 @@ namespace franka {
 
 class LibraryDownloader {
  public:
+  /**
+   * Downloads the model library into a temporary file, which is deleted on destruction.
+   */
   LibraryDownloader(Network& network);
+
+  /**
+   * Looks up the model library in the given cache directory and only downloads it on a cache
+   * miss.
+   *
+   * Libraries are stored under the SHA-1 hash of their contents. For every server version,
+   * architecture and operating system, an index file records the hash of the library that was
+   * downloaded last. Cached libraries whose contents do not match their hash are downloaded again.
+   * If the library cannot be stored in the cache directory, a temporary file is used instead.
+   *
+   * @param[in] network Connection to the robot.
+   * @param[in] cache_directory Directory to keep downloaded libraries in. Created if necessary.
+   * @param[in] server_version Version reported by the robot, used as part of the cache key.
+   */
+  LibraryDownloader(Network& network, const std::string& cache_directory, uint16_t server_version);
   ~LibraryDownloader();
 
   const std::string& path() const noexcept;
 
  private:
+  void saveTemporary(const TcpResponseData& library);
+
   Poco::File model_library_file_;
+  bool temporary_{false};
 };
 
 };  // namespace franka
@@ -2,6 +2,8 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include "library_loader.h"
 
+#include <cctype>
+
 #include <Poco/Exception.h>
 
 #include <franka/exception.h>
@@ -10,12 +12,18 @@ using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
 
 namespace franka {
 
-LibraryLoader::LibraryLoader(const std::string& filepath) try {
-  library_.load(filepath);
+LibraryLoader::LibraryLoader(const std::string& filepath,
+                             const std::string& description,
+                             int flags) try {
+  library_.load(filepath, flags);
 } catch (const Poco::LibraryAlreadyLoadedException& e) {
-  throw ModelException("libfranka: Model library already loaded"s);
+  std::string subject = description;
+  if (!subject.empty()) {
+    subject[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(subject[0])));
+  }
+  throw ModelException("libfranka: "s + subject + " already loaded");
 } catch (const Poco::LibraryLoadException& e) {
-  throw ModelException("libfranka: Cannot load model library: "s + e.what());
+  throw ModelException("libfranka: Cannot load "s + description + ": " + e.what());
 } catch (const Poco::Exception& e) {
   throw ModelException("libfranka: Error while loading library: "s + e.what());
 }
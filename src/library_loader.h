@@ -2,16 +2,24 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <string>
+
 #include <Poco/SharedLibrary.h>
 
 namespace franka {
 
 /*
  * Wraps library loading and unloading with RAII.
+ *
+ * Errors are reported as ModelException. The description names the kind of library in their
+ * messages, e.g. "controller plugin". The flags are Poco::SharedLibrary::Flags; by default, the
+ * symbols of the library are made available globally.
  */
 class LibraryLoader {
  public:
-  LibraryLoader(const std::string& filepath);
+  LibraryLoader(const std::string& filepath,
+                const std::string& description = "model library",
+                int flags = 0);
   ~LibraryLoader();
 
   void* getSymbol(const std::string& symbol_name);
@@ -0,0 +1,112 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "limiting_statistics_recorder.h"
+
+#include <algorithm>
+
+namespace franka {
+
+constexpr double LimitingStatistics::kCorrectionThreshold;
+
+namespace {
+
+// Element (row, column) of the rotation matrix R_a * R_b^T, with both rotations taken from
+// column-major homogeneous transformations.
+double rotationDifference(const std::array<double, 16>& a,
+                          const std::array<double, 16>& b,
+                          size_t row,
+                          size_t column) noexcept {
+  double element = 0;
+  for (size_t k = 0; k < 3; k++) {
+    element += a[4 * k + row] * b[4 * k + column];
+  }
+  return element;
+}
+
+template <typename T, size_t N>
+void streamArray(std::ostream& ostream, const std::array<T, N>& array) {
+  ostream << "[";
+  for (size_t i = 0; i < N; i++) {
+    ostream << (i > 0 ? ", " : "") << array[i];
+  }
+  ostream << "]";
+}
+
+}  // anonymous namespace
+
+void LimitingStatisticsRecorder::record(Stage stage, double commanded, double limited) noexcept {
+  record<1>(stage, {{commanded}}, {{limited}});
+}
+
+void LimitingStatisticsRecorder::recordPose(const std::array<double, 16>& commanded,
+                                            const std::array<double, 16>& limited) noexcept {
+  LimitingStageStatistics statistics{};
+  for (size_t i = 0; i < 3; i++) {
+    recordCorrection(std::abs(limited[12 + i] - commanded[12 + i]), i, &statistics);
+  }
+
+  // The skew-symmetric part of R_limited * R_commanded^T is sin(angle) * axis of the rotation
+  // between both poses.
+  auto skew = [&](size_t row, size_t column) {
+    return 0.5 * (rotationDifference(limited, commanded, row, column) -
+                  rotationDifference(limited, commanded, column, row));
+  };
+  recordCorrection(std::abs(skew(2, 1)), 3, &statistics);
+  recordCorrection(std::abs(skew(0, 2)), 4, &statistics);
+  recordCorrection(std::abs(skew(1, 0)), 5, &statistics);
+  merge(Stage::kCartesianMotion, statistics);
+}
+
+void LimitingStatisticsRecorder::merge(Stage stage,
+                                       const LimitingStageStatistics& command) noexcept {
+  // A disabled recorder is only used if it forwards to a metrics segment, in which case it must
+  // not collect statistics itself.
+  if (enabled_ || metrics_ == nullptr) {
+    LimitingStageStatistics& statistics = stages_[static_cast<size_t>(stage)];
+    statistics.cycles++;
+    for (size_t i = 0; i < statistics.count.size(); i++) {
+      statistics.count[i] += command.count[i];
+      statistics.max_correction[i] =
+          std::max(statistics.max_correction[i], command.max_correction[i]);
+    }
+  }
+  if (metrics_ != nullptr) {
+    bool limited = std::any_of(command.count.begin(), command.count.end(),
+                               [](uint64_t count) { return count > 0; });
+    recordMetricsLimiting(*metrics_, static_cast<size_t>(stage), limited);
+  }
+}
+
+LimitingStatistics LimitingStatisticsRecorder::statistics() const noexcept {
+  auto get = [this](Stage stage) { return stages_[static_cast<size_t>(stage)]; };
+
+  LimitingStatistics statistics;
+  statistics.torque_rate = get(Stage::kTorqueRate);
+  statistics.joint_motion = get(Stage::kJointMotion);
+  statistics.cartesian_motion = get(Stage::kCartesianMotion);
+  statistics.elbow = get(Stage::kElbow);
+  return statistics;
+}
+
+void LimitingStatisticsRecorder::reset() noexcept {
+  stages_.fill(LimitingStageStatistics{});
+}
+
+std::ostream& operator<<(std::ostream& ostream, const LimitingStageStatistics& statistics) {
+  ostream << "{\"cycles\": " << statistics.cycles << ", \"count\": ";
+  streamArray(ostream, statistics.count);
+  ostream << ", \"max_correction\": ";
+  streamArray(ostream, statistics.max_correction);
+  ostream << "}";
+  return ostream;
+}
+
+std::ostream& operator<<(std::ostream& ostream, const LimitingStatistics& statistics) {
+  ostream << "{\"torque_rate\": " << statistics.torque_rate
+          << ", \"joint_motion\": " << statistics.joint_motion
+          << ", \"cartesian_motion\": " << statistics.cartesian_motion
+          << ", \"elbow\": " << statistics.elbow << "}";
+  return ostream;
+}
+
+}  // namespace franka
@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include <franka/limiting_statistics.h>
+#include <franka/shared_memory_metrics.h>
+
+#include "metrics_writer.h"
+
+namespace franka {
+
+/**
+ * Collects statistics of the rate limiting stages of the control loop without allocating.
+ *
+ * Whether a stage limited a command is also forwarded to a metrics segment if one is set, even if
+ * the recorder itself is disabled.
+ */
+class LimitingStatisticsRecorder {
+ public:
+  enum class Stage : size_t { kTorqueRate, kJointMotion, kCartesianMotion, kElbow, kCount };
+
+  void setEnabled(bool enabled) noexcept { enabled_ = enabled; }
+  bool enabled() const noexcept { return enabled_; }
+
+  void setMetrics(MetricsSegment* metrics) noexcept { metrics_ = metrics; }
+
+  /**
+   * @return True if commands need to be recorded, i.e. if enabled or a metrics segment is set.
+   */
+  bool active() const noexcept { return enabled_ || metrics_ != nullptr; }
+
+  template <size_t N>
+  void record(Stage stage,
+              const std::array<double, N>& commanded,
+              const std::array<double, N>& limited) noexcept {
+    static_assert(N <= 7, "LimitingStatisticsRecorder: Too many elements.");
+    LimitingStageStatistics statistics{};
+    for (size_t i = 0; i < N; i++) {
+      recordCorrection(std::abs(limited[i] - commanded[i]), i, &statistics);
+    }
+    merge(stage, statistics);
+  }
+
+  void record(Stage stage, double commanded, double limited) noexcept;
+
+  /**
+   * Records the change of a Cartesian pose by the Cartesian motion stage.
+   */
+  void recordPose(const std::array<double, 16>& commanded,
+                  const std::array<double, 16>& limited) noexcept;
+
+  LimitingStatistics statistics() const noexcept;
+  void reset() noexcept;
+
+ private:
+  // Adds the corrections of a single command to the statistics of the given stage.
+  void merge(Stage stage, const LimitingStageStatistics& command) noexcept;
+
+  static void recordCorrection(double correction,
+                               size_t index,
+                               LimitingStageStatistics* statistics) noexcept {
+    statistics->count[index] += correction > LimitingStatistics::kCorrectionThreshold ? 1 : 0;
+    statistics->max_correction[index] = std::max(statistics->max_correction[index], correction);
+  }
+
+  static_assert(static_cast<size_t>(Stage::kCount) == kMetricsLimitingStages,
+                "LimitingStatisticsRecorder: Stages do not match the metrics segment.");
+
+  bool enabled_{false};
+  MetricsSegment* metrics_{nullptr};
+  std::array<LimitingStageStatistics, static_cast<size_t>(Stage::kCount)> stages_{};
+};
+
+}  // namespace franka
@@ -77,4 +77,31 @@ std::array<double, 9> combineInertiaTensor(
   return I_total;
 }
 
-}  // namespace franka
\ No newline at end of file
+void CombinedLoadCache::update(
+    double m_ee,
+    const std::array<double, 3>& F_x_Cee,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 9>& I_ee,     // NOLINT(readability-identifier-naming)
+    double m_load,
+    const std::array<double, 3>& F_x_Cload,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 9>& I_load) {   // NOLINT(readability-identifier-naming)
+  if (valid_ && m_ee == m_ee_ && m_load == m_load_ && F_x_Cee == F_x_Cee_ &&
+      F_x_Cload == F_x_Cload_ && I_ee == I_ee_ && I_load == I_load_) {
+    return;
+  }
+
+  m_ee_ = m_ee;
+  F_x_Cee_ = F_x_Cee;
+  I_ee_ = I_ee;
+  m_load_ = m_load;
+  F_x_Cload_ = F_x_Cload;
+  I_load_ = I_load;
+
+  m_total_ = m_ee + m_load;
+  F_x_Ctotal_ = combineCenterOfMass(m_ee, F_x_Cee, m_load, F_x_Cload);
+  I_total_ =
+      combineInertiaTensor(m_ee, F_x_Cee, I_ee, m_load, F_x_Cload, I_load, m_total_, F_x_Ctotal_);
+  valid_ = true;
+  recompute_count_++;
+}
+
+}  // namespace franka
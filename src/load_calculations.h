@@ -3,6 +3,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 
 #include <Eigen/Core>
 
@@ -26,4 +27,45 @@ std::array<double, 9> combineInertiaTensor(
     double m_total,
     const std::array<double, 3>& F_x_Ctotal);  // NOLINT(readability-identifier-naming)
 
+/**
+ * Caches the combined end effector and load parameters.
+ *
+ * The combined values only change after the end effector or load have been reconfigured, so they
+ * are only recomputed if one of the inputs differs from the previous call to update().
+ */
+class CombinedLoadCache {
+ public:
+  void update(double m_ee,
+              const std::array<double, 3>& F_x_Cee,  // NOLINT(readability-identifier-naming)
+              const std::array<double, 9>& I_ee,     // NOLINT(readability-identifier-naming)
+              double m_load,
+              const std::array<double, 3>& F_x_Cload,  // NOLINT(readability-identifier-naming)
+              const std::array<double, 9>& I_load);    // NOLINT(readability-identifier-naming)
+
+  double m_total() const noexcept { return m_total_; }
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  const std::array<double, 3>& F_x_Ctotal() const noexcept { return F_x_Ctotal_; }
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  const std::array<double, 9>& I_total() const noexcept { return I_total_; }
+
+  /**
+   * @return Number of times the combined values had to be recomputed.
+   */
+  size_t recomputeCount() const noexcept { return recompute_count_; }
+
+ private:
+  bool valid_{false};
+  double m_ee_{0};
+  std::array<double, 3> F_x_Cee_{};  // NOLINT(readability-identifier-naming)
+  std::array<double, 9> I_ee_{};     // NOLINT(readability-identifier-naming)
+  double m_load_{0};
+  std::array<double, 3> F_x_Cload_{};  // NOLINT(readability-identifier-naming)
+  std::array<double, 9> I_load_{};     // NOLINT(readability-identifier-naming)
+
+  double m_total_{0};
+  std::array<double, 3> F_x_Ctotal_{};  // NOLINT(readability-identifier-naming)
+  std::array<double, 9> I_total_{};     // NOLINT(readability-identifier-naming)
+  size_t recompute_count_{0};
+};
+
 }  // namespace franka
\ No newline at end of file
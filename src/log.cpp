@@ -2,83 +2,258 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka/log.h>
 
-#include <iterator>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <tuple>
 
-using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+#include <franka/exception.h>
+
+#include "arrow_writer.h"
+#include "number_format.h"
+#include "record_format.h"
 
 namespace franka {
 
 namespace {
 
-template <typename T, size_t N>
-std::string csvName(const std::array<T, N>& /*unused*/, const std::string& name) {
-  std::ostringstream os;
-  for (size_t i = 0; i < N - 1; i++) {
-    os << name << "[" << i << "],";
+// Rough average length of a formatted double, used to estimate the size of the CSV output.
+constexpr size_t kExpectedDoubleLength = 20;
+
+// Column of the exported log. Double columns provide a pointer to count consecutive values,
+// integer columns consist of a single value.
+struct LogColumn {
+  const char* name;
+  FieldType type;
+  uint32_t count;
+  LogFields fields;
+  const double* (*doubles)(const Record&);
+  uint64_t (*integer)(const Record&);
+};
+
+#define FRANKA_LOG_ARRAY(name, member, group)                                               \
+  LogColumn {                                                                               \
+    name, FieldType::kDouble,                                                               \
+        static_cast<uint32_t>(std::tuple_size<std::decay_t<decltype(Record().member)>>::value), \
+        group, [](const Record& record) { return record.member.data(); }, nullptr           \
   }
-  os << name << "[" << N - 1 << "]";
-  return os.str();
-}
 
-template <class T, size_t N>
-std::ostream& operator<<(std::ostream& ostream /*unused*/, const std::array<T, N>& array) {
-  std::copy(array.cbegin(), array.cend() - 1, std::ostream_iterator<T>(ostream, ","));
-  std::copy(array.cend() - 1, array.cend(), std::ostream_iterator<T>(ostream));
-  return ostream;
-}
+#define FRANKA_LOG_DOUBLE(name, member, group)                                      \
+  LogColumn {                                                                       \
+    name, FieldType::kDouble, 1, group,                                             \
+        [](const Record& record) -> const double* { return &record.member; }, nullptr \
+  }
+
+#define FRANKA_LOG_INTEGER(name, value, group)                                       \
+  LogColumn {                                                                        \
+    name, FieldType::kUInt64, 1, group, nullptr,                                     \
+        [](const Record& record) -> uint64_t { return static_cast<uint64_t>(value); } \
+  }
 
-std::string csvRobotStateHeader() {
-  RobotState robot_state;
-  std::ostringstream os;
-  os << "time,success_rate," << csvName(robot_state.q, "state.q") << ","
-     << csvName(robot_state.q_d, "state.q_d") << "," << csvName(robot_state.dq, "state.dq") << ","
-     << csvName(robot_state.dq_d, "state.dq_d") << "," << csvName(robot_state.tau_J, "state.tau_J")
-     << "," << csvName(robot_state.tau_ext_hat_filtered, "state.tau_ext_hat_filtered");
-  return os.str();
+#define FRANKA_LOG_STATE(member, group) FRANKA_LOG_ARRAY("state." #member, state.member, group)
+
+// Columns in export order. Columns of LogFields::kCSV come first, so that logToCSV(log) keeps
+// its established layout.
+const LogColumn kColumns[] = {
+    FRANKA_LOG_INTEGER("time", record.state.time.toMSec(), LogFields::kNone),
+    FRANKA_LOG_DOUBLE("success_rate", state.control_command_success_rate, LogFields::kNone),
+    FRANKA_LOG_STATE(q, LogFields::kQ),
+    FRANKA_LOG_STATE(q_d, LogFields::kQD),
+    FRANKA_LOG_STATE(dq, LogFields::kDq),
+    FRANKA_LOG_STATE(dq_d, LogFields::kDqD),
+    FRANKA_LOG_STATE(tau_J, LogFields::kTauJ),
+    FRANKA_LOG_STATE(tau_ext_hat_filtered, LogFields::kTauExtHatFiltered),
+    FRANKA_LOG_INTEGER("state.robot_mode", record.state.robot_mode, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_T_EE, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_T_EE_d, LogFields::kFullState),
+    FRANKA_LOG_STATE(F_T_EE, LogFields::kFullState),
+    FRANKA_LOG_STATE(F_T_NE, LogFields::kFullState),
+    FRANKA_LOG_STATE(NE_T_EE, LogFields::kFullState),
+    FRANKA_LOG_STATE(EE_T_K, LogFields::kFullState),
+    FRANKA_LOG_DOUBLE("state.m_ee", state.m_ee, LogFields::kFullState),
+    FRANKA_LOG_STATE(I_ee, LogFields::kFullState),
+    FRANKA_LOG_STATE(F_x_Cee, LogFields::kFullState),
+    FRANKA_LOG_DOUBLE("state.m_load", state.m_load, LogFields::kFullState),
+    FRANKA_LOG_STATE(I_load, LogFields::kFullState),
+    FRANKA_LOG_STATE(F_x_Cload, LogFields::kFullState),
+    FRANKA_LOG_DOUBLE("state.m_total", state.m_total, LogFields::kFullState),
+    FRANKA_LOG_STATE(I_total, LogFields::kFullState),
+    FRANKA_LOG_STATE(F_x_Ctotal, LogFields::kFullState),
+    FRANKA_LOG_STATE(elbow, LogFields::kFullState),
+    FRANKA_LOG_STATE(elbow_d, LogFields::kFullState),
+    FRANKA_LOG_STATE(elbow_c, LogFields::kFullState),
+    FRANKA_LOG_STATE(delbow_c, LogFields::kFullState),
+    FRANKA_LOG_STATE(ddelbow_c, LogFields::kFullState),
+    FRANKA_LOG_STATE(tau_J_d, LogFields::kFullState),
+    FRANKA_LOG_STATE(dtau_J, LogFields::kFullState),
+    FRANKA_LOG_STATE(ddq_d, LogFields::kFullState),
+    FRANKA_LOG_STATE(ddq_hat, LogFields::kFullState),
+    FRANKA_LOG_STATE(joint_contact, LogFields::kFullState),
+    FRANKA_LOG_STATE(cartesian_contact, LogFields::kFullState),
+    FRANKA_LOG_STATE(joint_collision, LogFields::kFullState),
+    FRANKA_LOG_STATE(cartesian_collision, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_F_ext_hat_K, LogFields::kFullState),
+    FRANKA_LOG_STATE(K_F_ext_hat_K, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_dP_EE_d, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_ddP_O, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_T_EE_c, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_dP_EE_c, LogFields::kFullState),
+    FRANKA_LOG_STATE(O_ddP_EE_c, LogFields::kFullState),
+    FRANKA_LOG_STATE(theta, LogFields::kFullState),
+    FRANKA_LOG_STATE(dtheta, LogFields::kFullState),
+    FRANKA_LOG_INTEGER("state.current_errors", record.state.current_errors.bits(),
+                       LogFields::kFullState),
+    FRANKA_LOG_INTEGER("state.last_motion_errors", record.state.last_motion_errors.bits(),
+                       LogFields::kFullState),
+    FRANKA_LOG_ARRAY("cmd.q_d", command.joint_positions.q, LogFields::kMotionCommand),
+    FRANKA_LOG_ARRAY("cmd.dq_d", command.joint_velocities.dq, LogFields::kMotionCommand),
+    FRANKA_LOG_ARRAY("cmd.O_T_EE_d", command.cartesian_pose.O_T_EE, LogFields::kMotionCommand),
+    FRANKA_LOG_ARRAY("cmd.O_dP_EE_d",
+                     command.cartesian_velocities.O_dP_EE,
+                     LogFields::kMotionCommand),
+    FRANKA_LOG_ARRAY("cmd.tau_J_d", command.torques.tau_J, LogFields::kControlCommand),
+};
+
+#undef FRANKA_LOG_STATE
+#undef FRANKA_LOG_INTEGER
+#undef FRANKA_LOG_DOUBLE
+#undef FRANKA_LOG_ARRAY
+
+std::vector<const LogColumn*> selectColumns(LogFields fields) {
+  std::vector<const LogColumn*> columns;
+  for (const LogColumn& column : kColumns) {
+    if (hasLogFields(fields, column.fields)) {
+      columns.push_back(&column);
+    }
+  }
+  return columns;
 }
 
-std::string csvRobotCommandHeader() {
-  franka::RobotCommand command;
-  std::ostringstream os;
-  os << csvName(command.joint_positions.q, "cmd.q_d") << ","
-     << csvName(command.joint_velocities.dq, "cmd.dq_d") << ","
-     << csvName(command.cartesian_pose.O_T_EE, "cmd.O_T_EE_d") << ","
-     << csvName(command.cartesian_velocities.O_dP_EE, "cmd.O_dP_EE_d") << ","
-     << csvName(command.torques.tau_J, "cmd.tau_J_d");
-  return os.str();
+std::string csvHeader(const std::vector<const LogColumn*>& columns) {
+  std::string header;
+  for (const LogColumn* column : columns) {
+    if (column->count == 1) {
+      header.append(column->name).append(",");
+      continue;
+    }
+    for (size_t i = 0; i < column->count; i++) {
+      header.append(column->name).append("[").append(std::to_string(i)).append("],");
+    }
+  }
+  header.back() = '\n';
+  return header;
 }
 
-std::string csvLine(const franka::RobotState& robot_state) {
-  std::ostringstream os;
-  os << robot_state.time.toMSec() << "," << robot_state.control_command_success_rate << ","
-     << robot_state.q << "," << robot_state.q_d << "," << robot_state.dq << "," << robot_state.dq_d
-     << "," << robot_state.tau_J << "," << robot_state.tau_ext_hat_filtered;
-  return os.str();
+std::vector<FieldInfo> recordFields(const std::vector<const LogColumn*>& columns,
+                                    size_t* record_size) {
+  std::vector<FieldInfo> field_infos;
+  *record_size = 0;
+  for (const LogColumn* column : columns) {
+    field_infos.push_back(
+        {column->name, column->type, static_cast<uint32_t>(*record_size), column->count});
+    *record_size += column->count * sizeof(uint64_t);
+  }
+  return field_infos;
 }
 
-std::string csvLine(const franka::RobotCommand& command) {
-  std::ostringstream os;
-  os << command.joint_positions.q << "," << command.joint_velocities.dq << ","
-     << command.cartesian_pose.O_T_EE << "," << command.cartesian_velocities.O_dP_EE << ","
-     << command.torques.tau_J;
-  return os.str();
+void writeRecord(const std::vector<const LogColumn*>& columns, const Record& record, char* data) {
+  for (const LogColumn* column : columns) {
+    if (column->type == FieldType::kUInt64) {
+      uint64_t value = column->integer(record);
+      std::memcpy(data, &value, sizeof(value));
+    } else {
+      std::memcpy(data, column->doubles(record), column->count * sizeof(double));
+    }
+    data += column->count * sizeof(uint64_t);
+  }
 }
 
 }  // anonymous namespace
 
 std::string logToCSV(const std::vector<Record>& log) {
+  return logToCSV(log, LogFields::kCSV);
+}
+
+std::string logToCSV(const std::vector<Record>& log, LogFields fields) {
   if (log.empty()) {
     return "";
   }
-  std::ostringstream os;
+  std::vector<const LogColumn*> columns = selectColumns(fields);
+
+  // Each value is followed by a comma or newline.
+  size_t max_row_size = 0;
+  size_t values_per_row = 0;
+  for (const LogColumn* column : columns) {
+    size_t length = column->type == FieldType::kDouble ? kMaxDoubleLength : kMaxUInt64Length;
+    max_row_size += column->count * (length + 1);
+    values_per_row += column->count;
+  }
+
+  std::string csv = csvHeader(columns);
+  size_t size = csv.size();
+  csv.resize(size + std::max(max_row_size, log.size() * values_per_row * kExpectedDoubleLength));
+  for (const Record& record : log) {
+    if (csv.size() - size < max_row_size) {
+      csv.resize(std::max(csv.size() * 2, size + max_row_size));
+    }
+    char* begin = &csv[size];
+    char* cursor = begin;
+    for (const LogColumn* column : columns) {
+      if (column->type == FieldType::kUInt64) {
+        cursor = formatUInt64(column->integer(record), cursor);
+        *cursor++ = ',';
+        continue;
+      }
+      const double* values = column->doubles(record);
+      for (size_t i = 0; i < column->count; i++) {
+        cursor = formatDouble(values[i], cursor);
+        *cursor++ = ',';
+      }
+    }
+    cursor[-1] = '\n';
+    size += static_cast<size_t>(cursor - begin);
+  }
+  csv.resize(size);
+  return csv;
+}
+
+std::vector<char> logToBinary(const std::vector<Record>& log, LogFields fields) {
+  if (log.empty()) {
+    return {};
+  }
+  std::vector<const LogColumn*> columns = selectColumns(fields);
+  size_t record_size = 0;
+  std::vector<FieldInfo> field_infos = recordFields(columns, &record_size);
 
-  os << csvRobotStateHeader() << "," << csvRobotCommandHeader() << std::endl;
-  for (const Record& r : log) {
-    os << csvLine(r.state) << "," << csvLine(r.command) << std::endl;
+  std::vector<char> data = createRecordHeader(field_infos.data(), field_infos.size(), record_size);
+  size_t size = data.size();
+  data.resize(size + log.size() * record_size);
+  for (const Record& record : log) {
+    writeRecord(columns, record, &data[size]);
+    size += record_size;
   }
+  return data;
+}
 
-  return os.str();
+void logToArrow(const std::vector<Record>& log, const std::string& path, LogFields fields) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw Exception("libfranka: Unable to open Arrow file " + path);
+  }
+  std::vector<const LogColumn*> columns = selectColumns(fields);
+  size_t record_size = 0;
+  std::vector<FieldInfo> field_infos = recordFields(columns, &record_size);
+
+  ArrowWriter writer(file, field_infos.data(), field_infos.size());
+  std::vector<char> records(std::min(log.size(), ArrowWriter::kMaxBatchRecords) * record_size);
+  for (size_t first = 0; first < log.size(); first += ArrowWriter::kMaxBatchRecords) {
+    size_t count = std::min(ArrowWriter::kMaxBatchRecords, log.size() - first);
+    for (size_t i = 0; i < count; i++) {
+      writeRecord(columns, log[first + i], &records[i * record_size]);
+    }
+    writer.writeBatch(records.data(), record_size, count);
+  }
+  writer.finish();
 }
 
 }  // namespace franka
@@ -2,47 +2,232 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include "logger.h"
 
+#include <algorithm>
+#include <thread>
+
+#include "robot_state_conversion.h"
+
 namespace franka {
 
-Logger::Logger(size_t log_size) : log_size_(log_size) {
-  states_.resize(log_size);
-  commands_.resize(log_size);
+namespace {
+
+template <typename T>
+void reserveField(LogFields fields, LogFields field, size_t log_size, std::vector<T>* storage) {
+  if (hasLogFields(fields, field)) {
+    storage->resize(log_size);
+  }
+}
+
+}  // anonymous namespace
+
+LogRing::LogRing(size_t log_size, LogFields fields) : log_size(log_size) {
+  // The full state already holds every state field, so they get no arrays of their own.
+  if (hasLogFields(fields, LogFields::kFullState)) {
+    reserveField(fields, LogFields::kFullState, log_size, &states);
+  } else {
+    message_ids.resize(log_size);
+    success_rates.resize(log_size);
+    reserveField(fields, LogFields::kQ, log_size, &q);
+    reserveField(fields, LogFields::kQD, log_size, &q_d);
+    reserveField(fields, LogFields::kDq, log_size, &dq);
+    reserveField(fields, LogFields::kDqD, log_size, &dq_d);
+    reserveField(fields, LogFields::kTauJ, log_size, &tau_J);
+    reserveField(fields, LogFields::kTauExtHatFiltered, log_size, &tau_ext_hat_filtered);
+  }
+  reserveField(fields, LogFields::kMotionCommand, log_size, &q_c);
+  reserveField(fields, LogFields::kMotionCommand, log_size, &dq_c);
+  reserveField(fields, LogFields::kMotionCommand, log_size, &O_T_EE_c);
+  reserveField(fields, LogFields::kMotionCommand, log_size, &O_dP_EE_c);
+  reserveField(fields, LogFields::kControlCommand, log_size, &tau_J_d);
 }
 
-void Logger::log(const RobotState& state, const research_interface::robot::RobotCommand& command) {
+void LogRing::read(size_t index, Record* record) const noexcept {
+  *record = Record();
+  if (!states.empty()) {
+    record->state = convertRobotState(states[index]);
+  } else {
+    record->state.time = Duration(message_ids[index]);
+    record->state.control_command_success_rate = success_rates[index];
+    if (!q.empty()) {
+      record->state.q = q[index];
+    }
+    if (!q_d.empty()) {
+      record->state.q_d = q_d[index];
+    }
+    if (!dq.empty()) {
+      record->state.dq = dq[index];
+    }
+    if (!dq_d.empty()) {
+      record->state.dq_d = dq_d[index];
+    }
+    if (!tau_J.empty()) {
+      record->state.tau_J = tau_J[index];
+    }
+    if (!tau_ext_hat_filtered.empty()) {
+      record->state.tau_ext_hat_filtered = tau_ext_hat_filtered[index];
+    }
+  }
+
+  if (!q_c.empty()) {
+    record->command.joint_positions = q_c[index];
+    record->command.joint_velocities = dq_c[index];
+    record->command.cartesian_pose.O_T_EE = O_T_EE_c[index];
+    record->command.cartesian_velocities.O_dP_EE = O_dP_EE_c[index];
+  }
+  if (!tau_J_d.empty()) {
+    record->command.torques.tau_J = tau_J_d[index];
+  }
+}
+
+FlushedLog::FlushedLog(size_t log_size, LogFields fields, const LogCompression& compression)
+    : ring(compression.enabled ? 0 : log_size, fields),
+      compressed_ring(compression.enabled ? CompressedLogRing(log_size, fields, compression)
+                                          : CompressedLogRing()) {}
+
+size_t FlushedLog::size() const noexcept {
+  return ring.size + compressed_ring.size();
+}
+
+void FlushedLog::convert(std::vector<Record>* records) const {
+  if (compressed_ring.size() > 0) {
+    records->resize(compressed_ring.size());
+    compressed_ring.read(records->data(), records->size());
+    return;
+  }
+  records->resize(ring.size);
+  size_t oldest = ring.front + ring.log_size - ring.size;
+  for (size_t i = 0; i < ring.size; i++) {
+    ring.read((oldest + i) % ring.log_size, &(*records)[i]);
+  }
+}
+
+Logger::Logger(size_t log_size, LogFields fields, const LogCompression& compression)
+    : ring_(compression.enabled ? 0 : log_size, fields),
+      compressed_ring_(compression.enabled ? CompressedLogRing(log_size, fields, compression)
+                                           : CompressedLogRing()),
+      flush_buffer_(std::make_shared<FlushedLog>(log_size, fields, compression)),
+      log_size_(log_size),
+      fields_(fields),
+      compression_(compression) {}
+
+void Logger::log(const research_interface::robot::RobotState& state,
+                 const research_interface::robot::RobotCommand& command) {
   if (log_size_ == 0) {
     return;
   }
 
-  commands_[ring_front_] = command;
-  states_[ring_front_] = state;
+  beginWrite();
+  if (compression_.enabled) {
+    compressed_ring_.push(state, command);
+    endWrite();
+    return;
+  }
+  const size_t i = ring_.front;
+  if (!ring_.states.empty()) {
+    ring_.states[i] = state;
+  } else {
+    ring_.message_ids[i] = state.message_id;
+    ring_.success_rates[i] = state.control_command_success_rate;
+    if (!ring_.q.empty()) {
+      ring_.q[i] = state.q;
+    }
+    if (!ring_.q_d.empty()) {
+      ring_.q_d[i] = state.q_d;
+    }
+    if (!ring_.dq.empty()) {
+      ring_.dq[i] = state.dq;
+    }
+    if (!ring_.dq_d.empty()) {
+      ring_.dq_d[i] = state.dq_d;
+    }
+    if (!ring_.tau_J.empty()) {
+      ring_.tau_J[i] = state.tau_J;
+    }
+    if (!ring_.tau_ext_hat_filtered.empty()) {
+      ring_.tau_ext_hat_filtered[i] = state.tau_ext_hat_filtered;
+    }
+  }
+  if (!ring_.q_c.empty()) {
+    ring_.q_c[i] = command.motion.q_c;
+    ring_.dq_c[i] = command.motion.dq_c;
+    ring_.O_T_EE_c[i] = command.motion.O_T_EE_c;
+    ring_.O_dP_EE_c[i] = command.motion.O_dP_EE_c;
+  }
+  if (!ring_.tau_J_d.empty()) {
+    ring_.tau_J_d[i] = command.control.tau_J_d;
+  }
 
-  ring_front_ = (ring_front_ + 1) % log_size_;
-  ring_size_ = std::min(log_size_, ring_size_ + 1);
+  ring_.front = ring_.front + 1 == log_size_ ? 0 : ring_.front + 1;
+  ring_.size = std::min(log_size_, ring_.size + 1);
+  endWrite();
 }
 
-std::vector<Record> Logger::flush() {
-  std::vector<Record> log;
+ExceptionLog Logger::flush() {
+  std::shared_ptr<FlushedLog> log = std::move(flush_buffer_);
+  if (!log) {
+    log = std::make_shared<FlushedLog>(log_size_, fields_, compression_);
+  }
+  // The arrays have the same sizes, so copying them does not allocate.
+  log->ring = ring_;
+  log->compressed_ring = compressed_ring_;
 
-  for (size_t i = 0; i < ring_size_; i++) {
-    size_t wrapped_index = (ring_front_ + i) % ring_size_;
+  beginWrite();
+  ring_.front = 0;
+  ring_.size = 0;
+  compressed_ring_.clear();
+  endWrite();
+  return ExceptionLog(std::move(log));
+}
 
-    RobotCommand command;
-    command.joint_positions = commands_[wrapped_index].motion.q_c;
-    command.joint_velocities = commands_[wrapped_index].motion.dq_c;
-    command.cartesian_pose.O_T_EE = commands_[wrapped_index].motion.O_T_EE_c;
-    command.cartesian_velocities.O_dP_EE = commands_[wrapped_index].motion.O_dP_EE_c;
-    command.torques.tau_J = commands_[wrapped_index].control.tau_J_d;
+void Logger::clear() {
+  beginWrite();
+  ring_.front = 0;
+  ring_.size = 0;
+  compressed_ring_.clear();
+  endWrite();
+  if (!flush_buffer_) {
+    flush_buffer_ = std::make_shared<FlushedLog>(log_size_, fields_, compression_);
+  }
+}
 
-    Record record;
-    record.state = states_[wrapped_index];
-    record.command = command;
-    log.push_back(record);
+size_t Logger::snapshot(Record* records, size_t count) const noexcept {
+  while (true) {
+    uint64_t sequence = sequence_.load(std::memory_order_acquire);
+    if (sequence % 2 != 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (compression_.enabled) {
+      size_t size = compressed_ring_.read(records, count);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence) {
+        return size;
+      }
+      continue;
+    }
+    size_t size = std::min(count, ring_.size);
+    size_t oldest = ring_.front + log_size_ - size;
+    for (size_t i = 0; i < size; i++) {
+      ring_.read((oldest + i) % log_size_, &records[i]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) == sequence) {
+      return size;
+    }
   }
+}
+
+void Logger::beginWrite() noexcept {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void Logger::endWrite() noexcept {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
 
-  ring_front_ = 0;
-  ring_size_ = 0;
-  return log;
+LogFields Logger::fields() const noexcept {
+  return fields_;
 }
 
 }  // namespace franka
@@ -2,31 +2,135 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
-#include <deque>
-#include <string>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+#include <franka/exception.h>
 #include <franka/log.h>
 #include <franka/robot_state.h>
 #include <research_interface/robot/rbk_types.h>
 
+#include "compressed_log_ring.h"
+
 namespace franka {
 
+/**
+ * Logged fields, each in its own array, indexed by the position in the ring.
+ *
+ * Arrays of fields that are not logged are empty. With LogFields::kFullState, the state is only
+ * stored in states, and the arrays of single state fields are empty.
+ */
+struct LogRing {
+  using JointArray = std::array<double, 7>;
+
+  LogRing(size_t log_size, LogFields fields);
+
+  // Writes the entry at the given ring index into record.
+  void read(size_t index, franka::Record* record) const noexcept;
+
+  std::vector<uint64_t> message_ids;
+  std::vector<double> success_rates;
+  std::vector<JointArray> q;
+  std::vector<JointArray> q_d;
+  std::vector<JointArray> dq;
+  std::vector<JointArray> dq_d;
+  std::vector<JointArray> tau_J;  // NOLINT(readability-identifier-naming)
+  std::vector<JointArray> tau_ext_hat_filtered;
+  std::vector<JointArray> q_c;
+  std::vector<JointArray> dq_c;
+  std::vector<std::array<double, 16>> O_T_EE_c;  // NOLINT(readability-identifier-naming)
+  std::vector<std::array<double, 6>> O_dP_EE_c;  // NOLINT(readability-identifier-naming)
+  std::vector<JointArray> tau_J_d;               // NOLINT(readability-identifier-naming)
+  std::vector<research_interface::robot::RobotState> states;
+  size_t front{0};
+  size_t size{0};
+  size_t log_size;
+};
+
+/**
+ * Copy of the rings of a Logger held by a ControlException, converted to records when they are
+ * first read. Only one of the rings is allocated.
+ */
+class FlushedLog : public detail::LogSource {
+ public:
+  FlushedLog(size_t log_size, LogFields fields, const LogCompression& compression);
+
+  size_t size() const noexcept override;
+
+  LogRing ring;
+  CompressedLogRing compressed_ring;
+
+ protected:
+  void convert(std::vector<franka::Record>* records) const override;
+};
+
+/**
+ * Ring buffer of the last received robot states and sent commands.
+ *
+ * Only the fields selected at construction are kept, each in its own array, so that logging a
+ * sample only writes the selected values. If compression is enabled, the fields are kept in a
+ * CompressedLogRing instead.
+ *
+ * Writes are published through a sequence counter, so that snapshot() can be called from another
+ * thread than the one logging, without blocking it.
+ */
 class Logger {
  public:
-  explicit Logger(size_t log_size);
+  /**
+   * @throw std::invalid_argument if compression is enabled with invalid parameters.
+   */
+  explicit Logger(size_t log_size,
+                  LogFields fields = LogFields::kAll,
+                  const LogCompression& compression = LogCompression());
 
-  void log(const RobotState& state, const research_interface::robot::RobotCommand& command);
+  void log(const research_interface::robot::RobotState& state,
+           const research_interface::robot::RobotCommand& command);
 
-  std::vector<franka::Record> flush();
+  /**
+   * Returns all logged records, oldest first, and clears the log.
+   *
+   * The raw log is copied into a buffer preallocated by the constructor or clear(), and only
+   * converted to records when the returned log is read, so that flushing on the exception path
+   * neither allocates nor converts.
+   */
+  ExceptionLog flush();
+
+  /**
+   * Clears the log and preallocates the buffer for the next flush(), if necessary.
+   */
+  void clear();
+
+  /**
+   * Copies the last records into the given storage, oldest first, without clearing the log.
+   *
+   * Does not allocate. Can be called concurrently with log() from other threads; the copy is
+   * repeated if a record was logged meanwhile.
+   *
+   * @param[out] records Storage for at least count records.
+   * @param[in] count Maximum number of records to copy.
+   *
+   * @return Number of copied records.
+   */
+  size_t snapshot(franka::Record* records, size_t count) const noexcept;
+
+  LogFields fields() const noexcept;
 
  private:
-  std::vector<RobotState> states_;
-  std::vector<research_interface::robot::RobotCommand> commands_;
-  size_t ring_front_{0};
-  size_t ring_size_{0};
+  void beginWrite() noexcept;
+  void endWrite() noexcept;
+
+  LogRing ring_;
+  CompressedLogRing compressed_ring_;
+  // Odd while the log is being written.
+  std::atomic<uint64_t> sequence_{0};
+  std::shared_ptr<FlushedLog> flush_buffer_;
 
-  const size_t log_size_;  // NOLINT(readability-identifier-naming)
+  const size_t log_size_;   // NOLINT(readability-identifier-naming)
+  const LogFields fields_;  // NOLINT(readability-identifier-naming)
+  const LogCompression compression_;  // NOLINT(readability-identifier-naming)
 };
 
 }  // namespace franka
@@ -8,6 +8,19 @@
 
 namespace franka {
 
+namespace {
+
+// One Newton-Schulz step towards the closest rotation matrix, which is the same as the polar
+// decomposition used by Eigen::Transform::rotation() for nearly orthonormal matrices.
+template <typename T>
+Eigen::Quaterniond orthonormalizedOrientation(const Eigen::MatrixBase<T>& rotation) {
+  Eigen::Matrix3d orthonormalized =
+      0.5 * rotation * (3.0 * Eigen::Matrix3d::Identity() - rotation.transpose() * rotation);
+  return Eigen::Quaterniond(orthonormalized).normalized();
+}
+
+}  // anonymous namespace
+
 double lowpassFilter(double sample_time, double y, double y_last, double cutoff_frequency) {
   if (sample_time < 0 || !std::isfinite(sample_time)) {
     throw std::invalid_argument("lowpass-filter: sample_time is negative, infinite or NaN.");
@@ -60,4 +73,63 @@ std::array<double, 16> cartesianLowpassFilter(double sample_time,
 
   return filtered_values;
 }
+
+CartesianPoseLowpassFilter::CartesianPoseLowpassFilter(double sample_time,
+                                                       double cutoff_frequency) {
+  if (sample_time < 0 || !std::isfinite(sample_time)) {
+    throw std::invalid_argument(
+        "Cartesian lowpass-filter: sample_time is negative, infinite or NaN.");
+  }
+  if (cutoff_frequency <= 0 || !std::isfinite(cutoff_frequency)) {
+    throw std::invalid_argument(
+        "Cartesian lowpass-filter: cutoff_frequency is zero, negative, infinite or NaN.");
+  }
+  gain_ = sample_time / (sample_time + (1.0 / (2.0 * M_PI * cutoff_frequency)));
+}
+
+std::array<double, 16> CartesianPoseLowpassFilter::filter(const std::array<double, 16>& y,
+                                                          const std::array<double, 16>& y_last) {
+  bool finite = true;
+  for (size_t i = 0; i < y.size(); i++) {
+    finite &= std::isfinite(y[i]) & std::isfinite(y_last[i]);
+  }
+  if (!finite) {
+    throw std::invalid_argument(
+        "Cartesian lowpass-filter: current or past input value of the signal to be filtered is "
+        "infinite or NaN.");
+  }
+  return filterUnchecked(y, y_last);
+}
+
+std::array<double, 16> CartesianPoseLowpassFilter::filterUnchecked(
+    const std::array<double, 16>& y,
+    const std::array<double, 16>& y_last) noexcept {
+  Eigen::Map<const Eigen::Matrix4d> transform(y.data());
+  Eigen::Map<const Eigen::Matrix4d> transform_last(y_last.data());
+
+  Eigen::Quaterniond orientation = orthonormalizedOrientation(transform.topLeftCorner<3, 3>());
+  Eigen::Quaterniond orientation_last;
+  if (has_last_output_ && y_last == last_output_) {
+    orientation_last = Eigen::Map<const Eigen::Quaterniond>(last_orientation_.data());
+  } else {
+    orientation_last = orthonormalizedOrientation(transform_last.topLeftCorner<3, 3>());
+  }
+  if (orientation_last.dot(orientation) < 0) {
+    orientation.coeffs() = -orientation.coeffs();
+  }
+  Eigen::Quaterniond filtered_orientation(gain_ * orientation.coeffs() +
+                                          (1 - gain_) * orientation_last.coeffs());
+  filtered_orientation.normalize();
+
+  // Keep the last row of y, so that invalid transformations are still detected later.
+  Eigen::Map<Eigen::Matrix4d> filtered_transform(last_output_.data());
+  filtered_transform = transform;
+  filtered_transform.topLeftCorner<3, 3>() = filtered_orientation.toRotationMatrix();
+  filtered_transform.topRightCorner<3, 1>() = gain_ * transform.topRightCorner<3, 1>() +
+                                              (1 - gain_) * transform_last.topRightCorner<3, 1>();
+  Eigen::Map<Eigen::Quaterniond>(last_orientation_.data()) = filtered_orientation;
+  has_last_output_ = true;
+  return last_output_;
+}
+
 }  // namespace franka
\ No newline at end of file
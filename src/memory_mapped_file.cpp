@@ -0,0 +1,72 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "memory_mapped_file.h"
+
+#include <franka/exception.h>
+
+#include "platform.h"
+
+#ifdef LIBFRANKA_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace franka {
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path) {
+#ifdef LIBFRANKA_WINDOWS
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  LARGE_INTEGER file_size;
+  if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &file_size)) {
+    if (file != INVALID_HANDLE_VALUE) {
+      CloseHandle(file);
+    }
+    throw Exception("libfranka: Unable to open file " + path);
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void* data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (data == nullptr) {
+    if (mapping != nullptr) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    throw Exception("libfranka: Unable to map file " + path);
+  }
+  file_ = file;
+  mapping_ = mapping;
+  size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  struct stat file_status {};
+  if (file < 0 || fstat(file, &file_status) != 0) {
+    if (file >= 0) {
+      close(file);
+    }
+    throw Exception("libfranka: Unable to open file " + path);
+  }
+  size_ = static_cast<size_t>(file_status.st_size);
+  void* data = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+  close(file);
+  if (data == MAP_FAILED) {
+    throw Exception("libfranka: Unable to map file " + path);
+  }
+#endif
+  data_ = static_cast<const char*>(data);
+}
+
+MemoryMappedFile::~MemoryMappedFile() noexcept {
+#ifdef LIBFRANKA_WINDOWS
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_);
+  CloseHandle(file_);
+#else
+  munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+}  // namespace franka
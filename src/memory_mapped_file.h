@@ -0,0 +1,42 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace franka {
+
+/**
+ * Read-only memory mapping of a whole file, unmapped on destruction.
+ *
+ * Pages are only read from disk when they are first accessed, so large precomputed data such as
+ * haptic meshes or distance fields is available right after startup.
+ */
+class MemoryMappedFile {
+ public:
+  /**
+   * Maps the given file.
+   *
+   * @param[in] path Path of the file.
+   *
+   * @throw Exception if the file cannot be opened, is empty or cannot be mapped.
+   */
+  explicit MemoryMappedFile(const std::string& path);
+  ~MemoryMappedFile() noexcept;
+
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  const char* data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+
+ private:
+  const char* data_{};
+  size_t size_{};
+  // HANDLEs of the file and the mapping on Windows.
+  void* file_{};
+  void* mapping_{};
+};
+
+}  // namespace franka
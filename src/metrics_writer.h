@@ -0,0 +1,34 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <franka/shared_memory_metrics.h>
+
+namespace franka {
+
+// Functions to update a metrics segment from the control thread, which is its only writer. Since
+// there are no concurrent writers, counters are incremented with a load and a store instead of a
+// locked read-modify-write.
+
+inline void incrementMetric(std::atomic<uint64_t>& metric, uint64_t value = 1) noexcept {
+  metric.store(metric.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void recordMetricsLatency(MetricsSegment& segment,
+                          size_t stage,
+                          std::chrono::nanoseconds duration) noexcept;
+
+void recordMetricsLimiting(MetricsSegment& segment, size_t stage, bool limited) noexcept;
+
+// Records a received robot state and publishes the update by incrementing the sequence.
+void recordMetricsState(MetricsSegment& segment,
+                        uint64_t message_id,
+                        uint64_t robot_mode,
+                        double control_command_success_rate) noexcept;
+
+}  // namespace franka
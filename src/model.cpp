@@ -2,14 +2,20 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka/model.h>
 
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 
 #include <research_interface/robot/service_types.h>
 
 #include "model_library.h"
 #include "network.h"
+#include "operational_space_calculations.h"
 
 using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
 
@@ -21,8 +27,89 @@ Frame operator++(Frame& frame, int /* dummy */) noexcept {
   return original;
 }
 
+namespace {
+
+inline size_t frameIndex(Frame frame) noexcept {
+  return static_cast<size_t>(frame);
+}
+
+inline bool isJointFrame(Frame frame) noexcept {
+  return frame >= Frame::kJoint1 && frame <= Frame::kFlange;
+}
+
+void computeZeroJacobians(
+    const ModelLibrary& library,
+    const std::array<double, 7>& q,
+    const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 16>& F_T_K,   // NOLINT(readability-identifier-naming)
+    FrameJacobians* zero_jacobians) noexcept {
+  FrameJacobians& output = *zero_jacobians;
+  library.zero_jacobian_joint1(output[frameIndex(Frame::kJoint1)].data());
+  for (size_t i = frameIndex(Frame::kJoint2); i <= frameIndex(Frame::kFlange); i++) {
+    library.zero_jacobians[i](q.data(), output[i].data());
+  }
+  library.zero_jacobian_ee(q.data(), F_T_EE.data(), output[frameIndex(Frame::kEndEffector)].data());
+  library.zero_jacobian_ee(q.data(), F_T_K.data(), output[frameIndex(Frame::kStiffness)].data());
+}
+
+template <size_t N>
+void scatter(const std::array<double, N>& sample, size_t index, size_t size, double* output) {
+  for (size_t k = 0; k < N; k++) {
+    output[k * size + index] = sample[k];
+  }
+}
+
+}  // anonymous namespace
+
+EndEffectorFrames::EndEffectorFrames() noexcept
+    : F_T_EE_{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}},
+      EE_T_K_(F_T_EE_),
+      F_T_K_(F_T_EE_) {}
+
+EndEffectorFrames::EndEffectorFrames(
+    const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
+    : EndEffectorFrames() {
+  set(F_T_EE, EE_T_K);
+}
+
+bool EndEffectorFrames::set(const franka::RobotState& robot_state) noexcept {
+  return set(robot_state.F_T_EE, robot_state.EE_T_K);
+}
+
+bool EndEffectorFrames::set(
+    const std::array<double, 16>& F_T_EE,             // NOLINT(readability-identifier-naming)
+    const std::array<double, 16>& EE_T_K) noexcept {  // NOLINT(readability-identifier-naming)
+  if (F_T_EE == F_T_EE_ && EE_T_K == EE_T_K_) {
+    return false;
+  }
+  F_T_EE_ = F_T_EE;
+  EE_T_K_ = EE_T_K;
+  Eigen::Map<Eigen::Matrix4d>(F_T_K_.data()) =
+      Eigen::Map<const Eigen::Matrix4d>(F_T_EE_.data()) *
+      Eigen::Map<const Eigen::Matrix4d>(EE_T_K_.data());
+  return true;
+}
+
+const std::array<double, 16>& EndEffectorFrames::F_T_EE() const noexcept {
+  return F_T_EE_;
+}
+
+const std::array<double, 16>& EndEffectorFrames::EE_T_K() const noexcept {
+  return EE_T_K_;
+}
+
+const std::array<double, 16>& EndEffectorFrames::F_T_K() const noexcept {
+  return F_T_K_;
+}
+
 Model::Model(Network& network) : library_{new ModelLibrary(network)} {}
 
+Model::Model(Network& network, const std::string& cache_directory, uint16_t server_version)
+    : library_{new ModelLibrary(network, cache_directory, server_version)} {}
+
+Model::Model(const std::string& library_path) : library_{new ModelLibrary(library_path)} {}
+
 // Has to be declared here, as the ModelLibrary type is incomplete in the header
 Model::~Model() noexcept = default;
 Model::Model(Model&&) noexcept = default;
@@ -39,47 +126,82 @@ std::array<double, 16> Model::pose(
     const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
     const {
   std::array<double, 16> output;
-  switch (frame) {
-    case Frame::kJoint1:
-      library_->joint1(q.data(), output.data());
-      break;
-    case Frame::kJoint2:
-      library_->joint2(q.data(), output.data());
-      break;
-    case Frame::kJoint3:
-      library_->joint3(q.data(), output.data());
-      break;
-    case Frame::kJoint4:
-      library_->joint4(q.data(), output.data());
-      break;
-    case Frame::kJoint5:
-      library_->joint5(q.data(), output.data());
-      break;
-    case Frame::kJoint6:
-      library_->joint6(q.data(), output.data());
-      break;
-    case Frame::kJoint7:
-      library_->joint7(q.data(), output.data());
-      break;
-    case Frame::kFlange:
-      library_->flange(q.data(), output.data());
-      break;
-    case Frame::kEndEffector:
-      library_->ee(q.data(), F_T_EE.data(), output.data());
-      break;
-    case Frame::kStiffness:
-      library_->ee(
-          q.data(),
-          Eigen::Matrix4d(Eigen::Matrix4d(F_T_EE.data()) * Eigen::Matrix4d(EE_T_K.data())).data(),
-          output.data());
-      break;
-    default:
-      throw std::invalid_argument("Invalid frame given.");
+  if (isJointFrame(frame)) {
+    library_->joint_poses[frameIndex(frame)](q.data(), output.data());
+  } else if (frame == Frame::kEndEffector) {
+    library_->ee(q.data(), F_T_EE.data(), output.data());
+  } else if (frame == Frame::kStiffness) {
+    library_->ee(
+        q.data(),
+        Eigen::Matrix4d(Eigen::Matrix4d(F_T_EE.data()) * Eigen::Matrix4d(EE_T_K.data())).data(),
+        output.data());
+  } else {
+    throw std::invalid_argument("Invalid frame given.");
   }
 
   return output;
 }
 
+std::array<double, 16> Model::pose(Frame frame,
+                                   const std::array<double, 7>& q,
+                                   const EndEffectorFrames& frames) const {
+  if (frame == Frame::kStiffness) {
+    std::array<double, 16> output;
+    library_->ee(q.data(), frames.F_T_K().data(), output.data());
+    return output;
+  }
+  return pose(frame, q, frames.F_T_EE(), frames.EE_T_K());
+}
+
+void Model::poseAll(const franka::RobotState& robot_state,
+                    FramePoses* poses,
+                    FrameJacobians* zero_jacobians) const noexcept {
+  poseAll(robot_state.q, robot_state.F_T_EE, robot_state.EE_T_K, poses, zero_jacobians);
+}
+
+void Model::poseAll(const std::array<double, 7>& q,
+                    const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+                    const std::array<double, 16>& EE_T_K,  // NOLINT(readability-identifier-naming)
+                    FramePoses* poses,
+                    FrameJacobians* zero_jacobians) const noexcept {
+  poseAll(q, EndEffectorFrames(F_T_EE, EE_T_K), poses, zero_jacobians);
+}
+
+void Model::poseAll(const std::array<double, 7>& q,
+                    const EndEffectorFrames& frames,
+                    FramePoses* poses,
+                    FrameJacobians* zero_jacobians) const noexcept {
+  FramePoses& output = *poses;
+  for (size_t i = frameIndex(Frame::kJoint1); i <= frameIndex(Frame::kFlange); i++) {
+    library_->joint_poses[i](q.data(), output[i].data());
+  }
+  library_->ee(q.data(), frames.F_T_EE().data(), output[frameIndex(Frame::kEndEffector)].data());
+  library_->ee(q.data(), frames.F_T_K().data(), output[frameIndex(Frame::kStiffness)].data());
+
+  if (zero_jacobians != nullptr) {
+    computeZeroJacobians(*library_, q, frames.F_T_EE(), frames.F_T_K(), zero_jacobians);
+  }
+}
+
+void Model::zeroJacobianAll(const franka::RobotState& robot_state,
+                            FrameJacobians* zero_jacobians) const noexcept {
+  zeroJacobianAll(robot_state.q, robot_state.F_T_EE, robot_state.EE_T_K, zero_jacobians);
+}
+
+void Model::zeroJacobianAll(
+    const std::array<double, 7>& q,
+    const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 16>& EE_T_K,  // NOLINT(readability-identifier-naming)
+    FrameJacobians* zero_jacobians) const noexcept {
+  zeroJacobianAll(q, EndEffectorFrames(F_T_EE, EE_T_K), zero_jacobians);
+}
+
+void Model::zeroJacobianAll(const std::array<double, 7>& q,
+                            const EndEffectorFrames& frames,
+                            FrameJacobians* zero_jacobians) const noexcept {
+  computeZeroJacobians(*library_, q, frames.F_T_EE(), frames.F_T_K(), zero_jacobians);
+}
+
 std::array<double, 42> Model::bodyJacobian(Frame frame,
                                            const franka::RobotState& robot_state) const {
   return bodyJacobian(frame, robot_state.q, robot_state.F_T_EE, robot_state.EE_T_K);
@@ -92,47 +214,35 @@ std::array<double, 42> Model::bodyJacobian(
     const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
     const {
   std::array<double, 42> output;
-  switch (frame) {
-    case Frame::kJoint1:
-      library_->body_jacobian_joint1(output.data());
-      break;
-    case Frame::kJoint2:
-      library_->body_jacobian_joint2(q.data(), output.data());
-      break;
-    case Frame::kJoint3:
-      library_->body_jacobian_joint3(q.data(), output.data());
-      break;
-    case Frame::kJoint4:
-      library_->body_jacobian_joint4(q.data(), output.data());
-      break;
-    case Frame::kJoint5:
-      library_->body_jacobian_joint5(q.data(), output.data());
-      break;
-    case Frame::kJoint6:
-      library_->body_jacobian_joint6(q.data(), output.data());
-      break;
-    case Frame::kJoint7:
-      library_->body_jacobian_joint7(q.data(), output.data());
-      break;
-    case Frame::kFlange:
-      library_->body_jacobian_flange(q.data(), output.data());
-      break;
-    case Frame::kEndEffector:
-      library_->body_jacobian_ee(q.data(), F_T_EE.data(), output.data());
-      break;
-    case Frame::kStiffness:
-      library_->body_jacobian_ee(
-          q.data(),
-          Eigen::Matrix4d(Eigen::Matrix4d(F_T_EE.data()) * Eigen::Matrix4d(EE_T_K.data())).data(),
-          output.data());
-      break;
-    default:
-      throw std::invalid_argument("Invalid frame given.");
+  if (frame == Frame::kJoint1) {
+    library_->body_jacobian_joint1(output.data());
+  } else if (isJointFrame(frame)) {
+    library_->body_jacobians[frameIndex(frame)](q.data(), output.data());
+  } else if (frame == Frame::kEndEffector) {
+    library_->body_jacobian_ee(q.data(), F_T_EE.data(), output.data());
+  } else if (frame == Frame::kStiffness) {
+    library_->body_jacobian_ee(
+        q.data(),
+        Eigen::Matrix4d(Eigen::Matrix4d(F_T_EE.data()) * Eigen::Matrix4d(EE_T_K.data())).data(),
+        output.data());
+  } else {
+    throw std::invalid_argument("Invalid frame given.");
   }
 
   return output;
 }
 
+std::array<double, 42> Model::bodyJacobian(Frame frame,
+                                           const std::array<double, 7>& q,
+                                           const EndEffectorFrames& frames) const {
+  if (frame == Frame::kStiffness) {
+    std::array<double, 42> output;
+    library_->body_jacobian_ee(q.data(), frames.F_T_K().data(), output.data());
+    return output;
+  }
+  return bodyJacobian(frame, q, frames.F_T_EE(), frames.EE_T_K());
+}
+
 std::array<double, 42> Model::zeroJacobian(Frame frame,
                                            const franka::RobotState& robot_state) const {
   return zeroJacobian(frame, robot_state.q, robot_state.F_T_EE, robot_state.EE_T_K);
@@ -145,47 +255,90 @@ std::array<double, 42> Model::zeroJacobian(
     const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
     const {
   std::array<double, 42> output;
-  switch (frame) {
-    case Frame::kJoint1:
-      library_->zero_jacobian_joint1(output.data());
-      break;
-    case Frame::kJoint2:
-      library_->zero_jacobian_joint2(q.data(), output.data());
-      break;
-    case Frame::kJoint3:
-      library_->zero_jacobian_joint3(q.data(), output.data());
-      break;
-    case Frame::kJoint4:
-      library_->zero_jacobian_joint4(q.data(), output.data());
-      break;
-    case Frame::kJoint5:
-      library_->zero_jacobian_joint5(q.data(), output.data());
-      break;
-    case Frame::kJoint6:
-      library_->zero_jacobian_joint6(q.data(), output.data());
-      break;
-    case Frame::kJoint7:
-      library_->zero_jacobian_joint7(q.data(), output.data());
-      break;
-    case Frame::kFlange:
-      library_->zero_jacobian_flange(q.data(), output.data());
-      break;
-    case Frame::kEndEffector:
-      library_->zero_jacobian_ee(q.data(), F_T_EE.data(), output.data());
-      break;
-    case Frame::kStiffness:
-      library_->zero_jacobian_ee(
-          q.data(),
-          Eigen::Matrix4d(Eigen::Matrix4d(F_T_EE.data()) * Eigen::Matrix4d(EE_T_K.data())).data(),
-          output.data());
-      break;
-    default:
-      throw std::invalid_argument("Invalid frame given.");
+  if (frame == Frame::kJoint1) {
+    library_->zero_jacobian_joint1(output.data());
+  } else if (isJointFrame(frame)) {
+    library_->zero_jacobians[frameIndex(frame)](q.data(), output.data());
+  } else if (frame == Frame::kEndEffector) {
+    library_->zero_jacobian_ee(q.data(), F_T_EE.data(), output.data());
+  } else if (frame == Frame::kStiffness) {
+    library_->zero_jacobian_ee(
+        q.data(),
+        Eigen::Matrix4d(Eigen::Matrix4d(F_T_EE.data()) * Eigen::Matrix4d(EE_T_K.data())).data(),
+        output.data());
+  } else {
+    throw std::invalid_argument("Invalid frame given.");
   }
 
   return output;
 }
 
+std::array<double, 42> Model::zeroJacobian(Frame frame,
+                                           const std::array<double, 7>& q,
+                                           const EndEffectorFrames& frames) const {
+  if (frame == Frame::kStiffness) {
+    std::array<double, 42> output;
+    library_->zero_jacobian_ee(q.data(), frames.F_T_K().data(), output.data());
+    return output;
+  }
+  return zeroJacobian(frame, q, frames.F_T_EE(), frames.EE_T_K());
+}
+
+std::array<double, 42> Model::zeroJacobianDerivative(Frame frame,
+                                                     const franka::RobotState& robot_state) const {
+  return zeroJacobianDerivative(frame, robot_state.q, robot_state.dq, robot_state.F_T_EE,
+                                robot_state.EE_T_K);
+}
+
+std::array<double, 42> Model::zeroJacobianDerivative(
+    Frame frame,
+    const std::array<double, 7>& q,
+    const std::array<double, 7>& dq,
+    const std::array<double, 16>& F_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 16>& EE_T_K)  // NOLINT(readability-identifier-naming)
+    const {
+  std::array<double, 16> frame_pose = pose(frame, q, F_T_EE, EE_T_K);
+  // Joints up to and including the frame's own joint move the frame.
+  size_t joint_count = std::min(frameIndex(frame) + 1, q.size());
+
+  // Rotation axes z_i and positions p_i of the joints, and their time derivatives.
+  std::array<Eigen::Vector3d, 7> axes;
+  std::array<Eigen::Vector3d, 7> positions;
+  std::array<Eigen::Vector3d, 7> axis_derivatives;
+  std::array<Eigen::Vector3d, 7> position_derivatives;
+  Eigen::Vector3d angular_velocity = Eigen::Vector3d::Zero();
+  std::array<double, 16> joint_pose;
+  for (size_t i = 0; i < joint_count; i++) {
+    library_->joint_poses[i](q.data(), joint_pose.data());
+    axes[i] = Eigen::Map<const Eigen::Vector3d>(&joint_pose[8]);
+    positions[i] = Eigen::Map<const Eigen::Vector3d>(&joint_pose[12]);
+
+    // The axis of joint i is rotated by joints 1 to i - 1 only.
+    axis_derivatives[i] = angular_velocity.cross(axes[i]);
+    position_derivatives[i].setZero();
+    for (size_t k = 0; k < i; k++) {
+      position_derivatives[i] += dq[k] * axes[k].cross(positions[i] - positions[k]);
+    }
+    angular_velocity += dq[i] * axes[i];
+  }
+
+  Eigen::Vector3d frame_position = Eigen::Map<const Eigen::Vector3d>(&frame_pose[12]);
+  Eigen::Vector3d frame_velocity = Eigen::Vector3d::Zero();
+  for (size_t i = 0; i < joint_count; i++) {
+    frame_velocity += dq[i] * axes[i].cross(frame_position - positions[i]);
+  }
+
+  std::array<double, 42> output{};
+  Eigen::Map<Eigen::Matrix<double, 6, 7>> derivative(output.data());
+  for (size_t i = 0; i < joint_count; i++) {
+    derivative.col(i).head<3>() =
+        axis_derivatives[i].cross(frame_position - positions[i]) +
+        axes[i].cross(frame_velocity - position_derivatives[i]);
+    derivative.col(i).tail<3>() = axis_derivatives[i];
+  }
+  return output;
+}
+
 std::array<double, 49> franka::Model::mass(const franka::RobotState& robot_state) const noexcept {
   return mass(robot_state.q, robot_state.I_total, robot_state.m_total, robot_state.F_x_Ctotal);
 }
@@ -243,4 +396,69 @@ std::array<double, 7> franka::Model::gravity(
   return output;
 }
 
+bool Model::dynamics(const franka::RobotState& robot_state,
+                     DynamicsBundle* dynamics,
+                     Frame frame,
+                     bool operational_space) const {
+  dynamics->zero_jacobian = zeroJacobian(frame, robot_state);
+  library_->mass(robot_state.q.data(), robot_state.I_total.data(), robot_state.m_total,
+                 robot_state.F_x_Ctotal.data(), dynamics->mass.data());
+  library_->coriolis(robot_state.q.data(), robot_state.dq.data(), robot_state.I_total.data(),
+                     robot_state.m_total, robot_state.F_x_Ctotal.data(),
+                     dynamics->coriolis.data());
+  library_->gravity(robot_state.q.data(), robot_state.O_ddP_O.data(), robot_state.m_total,
+                    robot_state.F_x_Ctotal.data(), dynamics->gravity.data());
+  if (!operational_space) {
+    return true;
+  }
+  return computeOperationalSpace(dynamics->mass, dynamics->zero_jacobian, &dynamics->lambda,
+                                 &dynamics->jacobian_pseudoinverse);
+}
+
+void Model::evaluateBatch(const ModelBatch& batch, size_t thread_count) const {
+  if (frameIndex(batch.frame) >= kFrameCount) {
+    throw std::invalid_argument("Invalid frame given.");
+  }
+
+  auto evaluate = [this, &batch](size_t begin, size_t end) {
+    std::array<double, 7> q;
+    for (size_t i = begin; i < end; i++) {
+      for (size_t j = 0; j < q.size(); j++) {
+        q[j] = batch.q[j * batch.size + i];
+      }
+      if (batch.poses != nullptr) {
+        scatter(pose(batch.frame, q, batch.frames), i, batch.size, batch.poses);
+      }
+      if (batch.zero_jacobians != nullptr) {
+        scatter(zeroJacobian(batch.frame, q, batch.frames), i, batch.size, batch.zero_jacobians);
+      }
+      if (batch.gravity != nullptr) {
+        scatter(gravity(q, batch.m_total, batch.F_x_Ctotal, batch.gravity_earth), i, batch.size,
+                batch.gravity);
+      }
+    }
+  };
+
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  thread_count = std::min(thread_count, batch.size);
+  if (thread_count <= 1) {
+    evaluate(0, batch.size);
+    return;
+  }
+
+  // The model library functions are pure, so chunks can be evaluated without synchronization.
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  size_t chunk_size = (batch.size + thread_count - 1) / thread_count;
+  for (size_t begin = chunk_size; begin < batch.size; begin += chunk_size) {
+    threads.emplace_back(evaluate, begin, std::min(begin + chunk_size, batch.size));
+  }
+  evaluate(0, std::min(chunk_size, batch.size));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 }  // namespace franka
@@ -6,37 +6,56 @@
 
 namespace franka {
 
+namespace {
+
+template <typename T>
+T symbol(LibraryLoader& loader, const char* name) {
+  return reinterpret_cast<T>(loader.getSymbol(name));
+}
+
+}  // anonymous namespace
+
+constexpr size_t ModelLibrary::kJointFrameCount;
+
 ModelLibrary::ModelLibrary(franka::Network& network)
-    : loader_(LibraryDownloader(network).path()),
-      body_jacobian_joint1{reinterpret_cast<decltype(&Ji_J_J1)>(loader_.getSymbol("Ji_J_J1"))},
-      body_jacobian_joint2{reinterpret_cast<decltype(&Ji_J_J2)>(loader_.getSymbol("Ji_J_J2"))},
-      body_jacobian_joint3{reinterpret_cast<decltype(&Ji_J_J3)>(loader_.getSymbol("Ji_J_J3"))},
-      body_jacobian_joint4{reinterpret_cast<decltype(&Ji_J_J4)>(loader_.getSymbol("Ji_J_J4"))},
-      body_jacobian_joint5{reinterpret_cast<decltype(&Ji_J_J5)>(loader_.getSymbol("Ji_J_J5"))},
-      body_jacobian_joint6{reinterpret_cast<decltype(&Ji_J_J6)>(loader_.getSymbol("Ji_J_J6"))},
-      body_jacobian_joint7{reinterpret_cast<decltype(&Ji_J_J7)>(loader_.getSymbol("Ji_J_J7"))},
-      body_jacobian_flange{reinterpret_cast<decltype(&Ji_J_J8)>(loader_.getSymbol("Ji_J_J8"))},
-      body_jacobian_ee{reinterpret_cast<decltype(&Ji_J_J9)>(loader_.getSymbol("Ji_J_J9"))},
-      mass{reinterpret_cast<decltype(&M_NE)>(loader_.getSymbol("M_NE"))},
-      zero_jacobian_joint1{reinterpret_cast<decltype(&O_J_J1)>(loader_.getSymbol("O_J_J1"))},
-      zero_jacobian_joint2{reinterpret_cast<decltype(&O_J_J2)>(loader_.getSymbol("O_J_J2"))},
-      zero_jacobian_joint3{reinterpret_cast<decltype(&O_J_J3)>(loader_.getSymbol("O_J_J3"))},
-      zero_jacobian_joint4{reinterpret_cast<decltype(&O_J_J4)>(loader_.getSymbol("O_J_J4"))},
-      zero_jacobian_joint5{reinterpret_cast<decltype(&O_J_J5)>(loader_.getSymbol("O_J_J5"))},
-      zero_jacobian_joint6{reinterpret_cast<decltype(&O_J_J6)>(loader_.getSymbol("O_J_J6"))},
-      zero_jacobian_joint7{reinterpret_cast<decltype(&O_J_J7)>(loader_.getSymbol("O_J_J7"))},
-      zero_jacobian_flange{reinterpret_cast<decltype(&O_J_J8)>(loader_.getSymbol("O_J_J8"))},
-      zero_jacobian_ee{reinterpret_cast<decltype(&O_J_J9)>(loader_.getSymbol("O_J_J9"))},
-      joint1{reinterpret_cast<decltype(&O_T_J1)>(loader_.getSymbol("O_T_J1"))},
-      joint2{reinterpret_cast<decltype(&O_T_J2)>(loader_.getSymbol("O_T_J2"))},
-      joint3{reinterpret_cast<decltype(&O_T_J3)>(loader_.getSymbol("O_T_J3"))},
-      joint4{reinterpret_cast<decltype(&O_T_J4)>(loader_.getSymbol("O_T_J4"))},
-      joint5{reinterpret_cast<decltype(&O_T_J5)>(loader_.getSymbol("O_T_J5"))},
-      joint6{reinterpret_cast<decltype(&O_T_J6)>(loader_.getSymbol("O_T_J6"))},
-      joint7{reinterpret_cast<decltype(&O_T_J7)>(loader_.getSymbol("O_T_J7"))},
-      flange{reinterpret_cast<decltype(&O_T_J8)>(loader_.getSymbol("O_T_J8"))},
-      ee{reinterpret_cast<decltype(&O_T_J9)>(loader_.getSymbol("O_T_J9"))},
-      coriolis{reinterpret_cast<decltype(&c_NE)>(loader_.getSymbol("c_NE"))},
-      gravity{reinterpret_cast<decltype(&g_NE)>(loader_.getSymbol("g_NE"))} {}
+    : ModelLibrary(LibraryDownloader(network).path()) {}
+
+ModelLibrary::ModelLibrary(franka::Network& network,
+                           const std::string& cache_directory,
+                           uint16_t server_version)
+    : ModelLibrary(LibraryDownloader(network, cache_directory, server_version).path()) {}
+
+ModelLibrary::ModelLibrary(const std::string& path)
+    : loader_(path),
+      joint_poses{{symbol<PoseFunction>(loader_, "O_T_J1"),
+                   symbol<PoseFunction>(loader_, "O_T_J2"),
+                   symbol<PoseFunction>(loader_, "O_T_J3"),
+                   symbol<PoseFunction>(loader_, "O_T_J4"),
+                   symbol<PoseFunction>(loader_, "O_T_J5"),
+                   symbol<PoseFunction>(loader_, "O_T_J6"),
+                   symbol<PoseFunction>(loader_, "O_T_J7"),
+                   symbol<PoseFunction>(loader_, "O_T_J8")}},
+      ee{symbol<decltype(&O_T_J9)>(loader_, "O_T_J9")},
+      body_jacobian_joint1{symbol<decltype(&Ji_J_J1)>(loader_, "Ji_J_J1")},
+      body_jacobians{{nullptr, symbol<JacobianFunction>(loader_, "Ji_J_J2"),
+                      symbol<JacobianFunction>(loader_, "Ji_J_J3"),
+                      symbol<JacobianFunction>(loader_, "Ji_J_J4"),
+                      symbol<JacobianFunction>(loader_, "Ji_J_J5"),
+                      symbol<JacobianFunction>(loader_, "Ji_J_J6"),
+                      symbol<JacobianFunction>(loader_, "Ji_J_J7"),
+                      symbol<JacobianFunction>(loader_, "Ji_J_J8")}},
+      body_jacobian_ee{symbol<decltype(&Ji_J_J9)>(loader_, "Ji_J_J9")},
+      zero_jacobian_joint1{symbol<decltype(&O_J_J1)>(loader_, "O_J_J1")},
+      zero_jacobians{{nullptr, symbol<JacobianFunction>(loader_, "O_J_J2"),
+                      symbol<JacobianFunction>(loader_, "O_J_J3"),
+                      symbol<JacobianFunction>(loader_, "O_J_J4"),
+                      symbol<JacobianFunction>(loader_, "O_J_J5"),
+                      symbol<JacobianFunction>(loader_, "O_J_J6"),
+                      symbol<JacobianFunction>(loader_, "O_J_J7"),
+                      symbol<JacobianFunction>(loader_, "O_J_J8")}},
+      zero_jacobian_ee{symbol<decltype(&O_J_J9)>(loader_, "O_J_J9")},
+      mass{symbol<decltype(&M_NE)>(loader_, "M_NE")},
+      coriolis{symbol<decltype(&c_NE)>(loader_, "c_NE")},
+      gravity{symbol<decltype(&g_NE)>(loader_, "g_NE")} {}
 
 }  // namespace franka
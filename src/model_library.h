@@ -2,7 +2,9 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
-#include <functional>
+#include <array>
+#include <cstdint>
+#include <string>
 
 #include "libfcimodels.h"
 #include "library_loader.h"
@@ -10,48 +12,47 @@
 
 namespace franka {
 
+/**
+ * Table of the functions exported by the downloaded model library.
+ *
+ * Functions that only depend on the joint positions are grouped into arrays indexed by
+ * franka::Frame, so that callers can dispatch without branching on the frame.
+ */
 class ModelLibrary {
  public:
+  /// Signature of O_T_J1 to O_T_J8.
+  using PoseFunction = decltype(&O_T_J1);
+  /// Signature of Ji_J_J2 to Ji_J_J8 and O_J_J2 to O_J_J8.
+  using JacobianFunction = decltype(&O_J_J2);
+
+  /// Number of frames with a PoseFunction, i.e. Frame::kJoint1 to Frame::kFlange.
+  static constexpr size_t kJointFrameCount = 8;
+
   ModelLibrary(Network& network);
+  ModelLibrary(Network& network, const std::string& cache_directory, uint16_t server_version);
+  explicit ModelLibrary(const std::string& path);
 
  private:
   LibraryLoader loader_;
 
  public:
-  const std::function<decltype(Ji_J_J1)> body_jacobian_joint1;
-  const std::function<decltype(Ji_J_J2)> body_jacobian_joint2;
-  const std::function<decltype(Ji_J_J3)> body_jacobian_joint3;
-  const std::function<decltype(Ji_J_J4)> body_jacobian_joint4;
-  const std::function<decltype(Ji_J_J5)> body_jacobian_joint5;
-  const std::function<decltype(Ji_J_J6)> body_jacobian_joint6;
-  const std::function<decltype(Ji_J_J7)> body_jacobian_joint7;
-  const std::function<decltype(Ji_J_J8)> body_jacobian_flange;
-  const std::function<decltype(Ji_J_J9)> body_jacobian_ee;
-
-  const std::function<decltype(M_NE)> mass;
-
-  const std::function<decltype(O_J_J1)> zero_jacobian_joint1;
-  const std::function<decltype(O_J_J2)> zero_jacobian_joint2;
-  const std::function<decltype(O_J_J3)> zero_jacobian_joint3;
-  const std::function<decltype(O_J_J4)> zero_jacobian_joint4;
-  const std::function<decltype(O_J_J5)> zero_jacobian_joint5;
-  const std::function<decltype(O_J_J6)> zero_jacobian_joint6;
-  const std::function<decltype(O_J_J7)> zero_jacobian_joint7;
-  const std::function<decltype(O_J_J8)> zero_jacobian_flange;
-  const std::function<decltype(O_J_J9)> zero_jacobian_ee;
-
-  const std::function<decltype(O_T_J1)> joint1;
-  const std::function<decltype(O_T_J2)> joint2;
-  const std::function<decltype(O_T_J3)> joint3;
-  const std::function<decltype(O_T_J4)> joint4;
-  const std::function<decltype(O_T_J5)> joint5;
-  const std::function<decltype(O_T_J6)> joint6;
-  const std::function<decltype(O_T_J7)> joint7;
-  const std::function<decltype(O_T_J8)> flange;
-  const std::function<decltype(O_T_J9)> ee;
-
-  const std::function<decltype(c_NE)> coriolis;
-  const std::function<decltype(g_NE)> gravity;
+  /// Indexed by Frame, from Frame::kJoint1 to Frame::kFlange.
+  const std::array<PoseFunction, kJointFrameCount> joint_poses;
+  const decltype(&O_T_J9) ee;
+
+  const decltype(&Ji_J_J1) body_jacobian_joint1;
+  /// Indexed by Frame, from Frame::kJoint2 to Frame::kFlange, i.e. starting at index 1.
+  const std::array<JacobianFunction, kJointFrameCount> body_jacobians;
+  const decltype(&Ji_J_J9) body_jacobian_ee;
+
+  const decltype(&O_J_J1) zero_jacobian_joint1;
+  /// Indexed by Frame, from Frame::kJoint2 to Frame::kFlange, i.e. starting at index 1.
+  const std::array<JacobianFunction, kJointFrameCount> zero_jacobians;
+  const decltype(&O_J_J9) zero_jacobian_ee;
+
+  const decltype(&M_NE) mass;
+  const decltype(&c_NE) coriolis;
+  const decltype(&g_NE) gravity;
 };
 
 }  // namespace franka
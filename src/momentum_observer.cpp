@@ -0,0 +1,127 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/momentum_observer.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+namespace franka {
+
+namespace {
+
+using Matrix3d = Eigen::Matrix3d;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+}  // anonymous namespace
+
+MomentumObserver::MomentumObserver(const MomentumObserverParameters& parameters)
+    : parameters_(parameters) {
+  if (!(parameters.cutoff_frequency > 0) || !(parameters.wrench_damping >= 0) ||
+      !std::isfinite(parameters.wrench_damping)) {
+    throw std::invalid_argument("libfranka: Invalid momentum observer parameters.");
+  }
+}
+
+void MomentumObserver::update(const Model& model, RobotState* robot_state, Duration time_step) {
+  model.dynamics(*robot_state, &dynamics_, Frame::kStiffness);
+  update(*robot_state, dynamics_, time_step.toSec());
+
+  robot_state->tau_ext_hat_filtered = tau_ext_filtered_;
+  robot_state->O_F_ext_hat_K = O_F_ext_filtered_;
+
+  // Rotate the wrench into the stiffness frame, O_R_K = O_R_EE * EE_R_K.
+  Eigen::Map<const Eigen::Matrix4d> end_effector_pose(robot_state->O_T_EE.data());
+  Eigen::Map<const Eigen::Matrix4d> stiffness_frame(robot_state->EE_T_K.data());
+  Matrix3d rotation =
+      end_effector_pose.topLeftCorner<3, 3>() * stiffness_frame.topLeftCorner<3, 3>();
+  Eigen::Map<const Vector6d> base_wrench(O_F_ext_filtered_.data());
+  Eigen::Map<Vector6d> stiffness_wrench(robot_state->K_F_ext_hat_K.data());
+  stiffness_wrench.head<3>() = rotation.transpose() * base_wrench.head<3>();
+  stiffness_wrench.tail<3>() = rotation.transpose() * base_wrench.tail<3>();
+}
+
+void MomentumObserver::update(const RobotState& robot_state,
+                              const DynamicsBundle& dynamics,
+                              double time_step) noexcept {
+  const std::array<double, 7>& dq = robot_state.dq;
+  bool initialize = !initialized_ || !(time_step > 0);
+
+  // With M ddq + c + g = tau_J - tau_ext, the momentum p = M dq changes with
+  // dp/dt = tau_J - tau_ext - g + C^T dq. The residual r = K (p_0 - p + integral(tau_J - g +
+  // C^T dq - r)) thus follows dr/dt = K (tau_ext - r). Backward Euler turns this into a first-order
+  // lowpass of the raw residual tau_J - g + C^T dq - dp/dt. Using C^T dq = dM/dt dq - c, the
+  // finite differences of M cancel and the raw residual becomes
+  // tau_J - g - c - M_{k-1} (dq_k - dq_{k-1}) / dt.
+  for (size_t i = 0; i < 7; i++) {
+    double inertial = 0;
+    if (!initialize) {
+      for (size_t j = 0; j < 7; j++) {
+        inertial += previous_mass_[j * 7 + i] * (dq[j] - previous_dq_[j]);
+      }
+      inertial /= time_step;
+    }
+    tau_ext_[i] = robot_state.tau_J[i] - dynamics.gravity[i] - dynamics.coriolis[i] - inertial;
+  }
+  solveWrench(dynamics.zero_jacobian, tau_ext_, &O_F_ext_);
+
+  if (initialize) {
+    tau_ext_filtered_ = tau_ext_;
+    O_F_ext_filtered_ = O_F_ext_;
+    initialized_ = true;
+  } else {
+    double gain = 2 * M_PI * parameters_.cutoff_frequency * time_step;
+    double alpha = std::isinf(gain) ? 1.0 : gain / (1 + gain);
+    for (size_t i = 0; i < 7; i++) {
+      tau_ext_filtered_[i] += alpha * (tau_ext_[i] - tau_ext_filtered_[i]);
+    }
+    for (size_t i = 0; i < 6; i++) {
+      O_F_ext_filtered_[i] += alpha * (O_F_ext_[i] - O_F_ext_filtered_[i]);
+    }
+  }
+
+  previous_dq_ = dq;
+  previous_mass_ = dynamics.mass;
+}
+
+void MomentumObserver::solveWrench(const std::array<double, 42>& jacobian,
+                                   const std::array<double, 7>& tau,
+                                   std::array<double, 6>* wrench) const noexcept {
+  // tau = J^T F, solved as F = (J J^T + d^2 I)^-1 J tau.
+  Eigen::Map<const Matrix6x7d> J(jacobian.data());  // NOLINT(readability-identifier-naming)
+  Matrix6d damped = J * J.transpose();
+  damped.diagonal().array() += parameters_.wrench_damping * parameters_.wrench_damping;
+  Eigen::LDLT<Matrix6d> ldlt(damped);
+  Eigen::Map<Vector6d>(wrench->data()) = ldlt.solve(J * Eigen::Map<const Vector7d>(tau.data()));
+}
+
+void MomentumObserver::reset() noexcept {
+  initialized_ = false;
+}
+
+const std::array<double, 7>& MomentumObserver::tau_ext() const noexcept {
+  return tau_ext_;
+}
+
+const std::array<double, 7>& MomentumObserver::tau_ext_filtered() const noexcept {
+  return tau_ext_filtered_;
+}
+
+const std::array<double, 6>& MomentumObserver::O_F_ext() const noexcept {
+  return O_F_ext_;
+}
+
+const std::array<double, 6>& MomentumObserver::O_F_ext_filtered() const noexcept {
+  return O_F_ext_filtered_;
+}
+
+const DynamicsBundle& MomentumObserver::dynamics() const noexcept {
+  return dynamics_;
+}
+
+}  // namespace franka
@@ -0,0 +1,130 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "multi_rate_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace franka {
+
+namespace {
+
+// Bounds the delay of a wakeup that is lost because the control thread notifies without locking.
+constexpr std::chrono::milliseconds kWakeupPeriod{1};
+
+MultiRateScheduler::SlowCallback checkParameters(MultiRateScheduler::SlowCallback slow_callback,
+                                                 const MultiRateOptions& options) {
+  if (!slow_callback) {
+    throw std::invalid_argument("libfranka: Invalid slow callback given.");
+  }
+  if (options.divisor == 0) {
+    throw std::invalid_argument("libfranka: Slow callback divisor must be positive.");
+  }
+  return slow_callback;
+}
+
+}  // anonymous namespace
+
+MultiRateScheduler::MultiRateScheduler(SlowCallback slow_callback,
+                                       const MultiRateOptions& options,
+                                       const RobotState& initial_state)
+    : slow_callback_(checkParameters(std::move(slow_callback), options)),
+      options_(options),
+      states_(initial_state),
+      outputs_(slow_callback_(initial_state, Duration())),
+      last_request_time_(initial_state.time),
+      segment_start_(initial_state.time),
+      previous_(outputs_.front()),
+      latest_(previous_),
+      interpolated_(previous_) {
+  thread_ = std::thread(&MultiRateScheduler::run, this);
+}
+
+MultiRateScheduler::~MultiRateScheduler() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+}
+
+const std::vector<double>& MultiRateScheduler::step(const RobotState& robot_state) {
+  if (failed_.load(std::memory_order_acquire)) {
+    std::rethrow_exception(error_);
+  }
+
+  if (robot_state.time - last_request_time_ >= Duration(options_.divisor)) {
+    states_.write(robot_state);
+    last_request_time_ = robot_state.time;
+    if (pending_.exchange(true, std::memory_order_acq_rel)) {
+      skipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    condition_.notify_one();
+  }
+
+  if (options_.hold == MultiRateHold::kZeroOrderHold) {
+    if (outputs_.acquire()) {
+      latest_ = outputs_.front();
+    }
+    return latest_;
+  }
+
+  // Starts a new segment from the currently interpolated output, so that it stays continuous when
+  // an output arrives before the previous segment is finished.
+  if (outputs_.acquire()) {
+    previous_ = interpolated_;
+    latest_ = outputs_.front();
+    segment_start_ = robot_state.time;
+  }
+  double progress = std::min(static_cast<double>((robot_state.time - segment_start_).toMSec()) /
+                                 static_cast<double>(options_.divisor),
+                             1.0);
+  for (size_t i = 0; i < interpolated_.size(); i++) {
+    interpolated_[i] = previous_[i] + progress * (latest_[i] - previous_[i]);
+  }
+  return interpolated_;
+}
+
+uint64_t MultiRateScheduler::skippedUpdates() const noexcept {
+  return skipped_.load(std::memory_order_relaxed);
+}
+
+void MultiRateScheduler::run() noexcept {
+  const size_t output_size = outputs_.back().size();
+  Duration last_time = states_.front().time;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stop_ && !pending_.load(std::memory_order_acquire)) {
+        condition_.wait_for(lock, kWakeupPeriod);
+      }
+    }
+    if (stop_) {
+      return;
+    }
+    pending_.store(false, std::memory_order_release);
+    if (!states_.acquire()) {
+      continue;
+    }
+
+    const RobotState& robot_state = states_.front();
+    try {
+      std::vector<double> values = slow_callback_(robot_state, robot_state.time - last_time);
+      if (values.size() != output_size) {
+        throw std::invalid_argument("libfranka: Output of the slow callback changed in size.");
+      }
+      last_time = robot_state.time;
+      std::copy(values.begin(), values.end(), outputs_.back().begin());
+      outputs_.publish();
+    } catch (...) {
+      error_ = std::current_exception();
+      failed_.store(true, std::memory_order_release);
+      return;
+    }
+  }
+}
+
+}  // namespace franka
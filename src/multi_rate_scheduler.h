@@ -0,0 +1,92 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <franka/duration.h>
+#include <franka/multi_rate.h>
+#include <franka/robot_state.h>
+
+#include "triple_buffer.h"
+
+namespace franka {
+
+/**
+ * Runs a slow callback on a helper thread at a fraction of the control rate and hands its output
+ * to the control thread.
+ *
+ * The control thread calls step() in every cycle. Every MultiRateOptions::divisor cycles, step()
+ * passes the robot state to the helper thread, which calls the slow callback and publishes its
+ * output. Both handoffs are wait-free, and step() never waits for the slow callback: if the
+ * callback is still running when the next state is passed, the helper thread continues with the
+ * newest state and the control thread keeps the last output. The outputs must all have the size of
+ * the first one, so that step() does not allocate.
+ */
+class MultiRateScheduler {
+ public:
+  using SlowCallback = std::function<std::vector<double>(const RobotState&, Duration)>;
+
+  /**
+   * Calls the slow callback with the initial state on the calling thread and starts the helper
+   * thread.
+   *
+   * @throw std::invalid_argument if the callback is empty or the divisor is zero.
+   */
+  MultiRateScheduler(SlowCallback slow_callback,
+                     const MultiRateOptions& options,
+                     const RobotState& initial_state);
+  ~MultiRateScheduler() noexcept;
+
+  MultiRateScheduler(const MultiRateScheduler&) = delete;
+  MultiRateScheduler& operator=(const MultiRateScheduler&) = delete;
+
+  /**
+   * Schedules the slow callback if due and returns the output for this control cycle.
+   *
+   * @throw Any exception thrown by the slow callback, and std::invalid_argument if its output
+   * changed in size.
+   */
+  const std::vector<double>& step(const RobotState& robot_state);
+
+  /**
+   * @return Number of robot states passed to the helper thread that were replaced before the slow
+   * callback could start with them.
+   */
+  uint64_t skippedUpdates() const noexcept;
+
+ private:
+  void run() noexcept;
+
+  const SlowCallback slow_callback_;
+  const MultiRateOptions options_;
+
+  TripleBuffer<RobotState> states_;
+  TripleBuffer<std::vector<double>> outputs_;
+
+  // Control thread.
+  Duration last_request_time_;
+  Duration segment_start_;
+  std::vector<double> previous_;
+  std::vector<double> latest_;
+  std::vector<double> interpolated_;
+
+  // Helper thread. The mutex only guards the wakeup, the control thread never takes it.
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<bool> pending_{false};
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> failed_{false};
+  std::atomic<uint64_t> skipped_{0};
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+}  // namespace franka
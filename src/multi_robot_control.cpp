@@ -0,0 +1,440 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/multi_robot_control.h>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+#include <franka/exception.h>
+#include <franka/robot.h>
+
+#include "allocation_tracker.h"
+#include "control_loop.h"
+#include "control_statistics_recorder.h"
+#include "network.h"
+#include "robot_impl.h"
+
+namespace franka {
+
+namespace {
+
+using Clock = ControlStatisticsRecorder::Clock;
+
+// Same as the UDP receive timeout of a single robot.
+constexpr std::chrono::milliseconds kReceiveTimeout{1000};
+
+// Processes the torque commands of one robot in the same way as Robot::control.
+class RobotLoop : public ControlLoop<JointVelocities> {
+ public:
+  RobotLoop(Robot::Impl& robot, bool limit_rate, const FilterConfiguration& filter_configuration)
+      : ControlLoop(robot,
+                    [](const RobotState&, Duration) -> JointVelocities {
+                      return {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
+                    },
+                    {},
+                    limit_rate,
+                    filter_configuration) {}
+
+  using ControlLoop::convertControl;
+  using ControlLoop::estimateJointState;
+  using ControlLoop::spinMotion;
+};
+
+}  // anonymous namespace
+
+constexpr std::chrono::microseconds MultiRobotControl::kDefaultAlignmentWindow;
+
+class MultiRobotControl::Impl {
+ public:
+  struct Slot {
+    Robot::Impl* robot{nullptr};
+    std::unique_ptr<RobotLoop> loop;
+    uint32_t motion_id{0};
+    bool requested{false};
+    bool started{false};
+    bool running{false};
+    bool received{false};
+    Duration previous_time;
+    research_interface::robot::MotionGeneratorCommand motion_command{};
+    research_interface::robot::ControllerCommand control_command{};
+    LatencyHistogram arrival_offset;
+    uint64_t missed_states{0};
+  };
+
+  Impl(const std::vector<Robot*>& robots, std::chrono::microseconds alignment_window);
+
+  void control(const std::vector<Robot::Impl*>& robots,
+               const ControlCallback& control_callback,
+               bool limit_rate,
+               const FilterConfiguration& filter_configuration);
+
+  // Starts the motions of all robots together.
+  void start(const std::vector<Robot::Impl*>& robots,
+             bool limit_rate,
+             const FilterConfiguration& filter_configuration);
+  // Receives the next state of every robot that sends one within the alignment window.
+  void receive();
+  // Checks the received states for motion errors and prepares them for the callback.
+  void process(bool record);
+  // Sends motion_generation_finished until all robots have stopped.
+  void finish();
+  void cancel() noexcept;
+
+  std::vector<Robot*> robots;
+  std::chrono::microseconds alignment_window;
+  std::vector<Slot> slots;
+  std::vector<MultiRobotState> states;
+  std::vector<Torques> torques;
+  std::unique_ptr<UdpPoller> poller;
+  std::mutex mutex;
+};
+
+MultiRobotControl::Impl::Impl(const std::vector<Robot*>& robots,
+                              std::chrono::microseconds alignment_window)
+    : robots(robots),
+      alignment_window(alignment_window),
+      slots(robots.size()),
+      states(robots.size()),
+      torques(robots.size(), Torques({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0})) {}
+
+void MultiRobotControl::Impl::control(const std::vector<Robot::Impl*>& robots,
+                                      const ControlCallback& control_callback,
+                                      bool limit_rate,
+                                      const FilterConfiguration& filter_configuration) {
+  std::vector<Network*> networks;
+  for (Robot::Impl* robot : robots) {
+    networks.push_back(&robot->network());
+  }
+  poller = std::make_unique<UdpPoller>(networks);
+
+  start(robots, limit_rate, filter_configuration);
+  try {
+    receive();
+    process(false);
+
+    bool finished = false;
+    AllocationTrackingScope allocation_tracking;
+    while (!finished) {
+      for (Torques& command : torques) {
+        command = Torques({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+      }
+      Clock::time_point callback_start = Clock::now();
+      control_callback(states, &torques);
+      Clock::duration callback_duration = Clock::now() - callback_start;
+
+      for (size_t i = 0; i < slots.size(); i++) {
+        if (!states[i].updated) {
+          continue;
+        }
+        Slot& slot = slots[i];
+        const RobotState& robot_state = states[i].robot_state;
+        ControlStatisticsRecorder* statistics = slot.robot->controlStatisticsRecorder();
+        if (statistics != nullptr) {
+          statistics->record(ControlStatisticsRecorder::Stage::kControlCallback, callback_duration);
+        }
+        slot.loop->spinMotion(robot_state, states[i].time_step, &slot.motion_command);
+        ScopedStageTimer processing_timer(
+            statistics, ControlStatisticsRecorder::Stage::kControlCommandProcessing);
+        if (!slot.loop->convertControl(torques[i], robot_state.tau_J_d, robot_state.dq,
+                                       states[i].time_step, &slot.control_command)) {
+          finished = true;
+        }
+      }
+      if (finished) {
+        break;
+      }
+
+      for (size_t i = 0; i < slots.size(); i++) {
+        if (states[i].updated) {
+          slots[i].robot->sendCommand(&slots[i].motion_command, &slots[i].control_command);
+        }
+      }
+      receive();
+      process(true);
+      allocation_tracking.endCycle();
+    }
+  } catch (...) {
+    cancel();
+    throw;
+  }
+
+  finish();
+}
+
+void MultiRobotControl::Impl::start(const std::vector<Robot::Impl*>& robots,
+                                    bool limit_rate,
+                                    const FilterConfiguration& filter_configuration) {
+  for (size_t i = 0; i < slots.size(); i++) {
+    Slot& slot = slots[i];
+    slot.robot = robots[i];
+    slot.requested = false;
+    slot.started = false;
+    slot.running = false;
+    slot.received = false;
+    slot.motion_command = {};
+    slot.control_command = {};
+    slot.loop = std::make_unique<RobotLoop>(*robots[i], limit_rate, filter_configuration);
+  }
+
+  try {
+    for (Slot& slot : slots) {
+      slot.motion_id = slot.robot->requestMotion(
+          research_interface::robot::Move::ControllerMode::kExternalController,
+          research_interface::robot::Move::MotionGeneratorMode::kJointVelocity,
+          RobotLoop::kDefaultDeviation, RobotLoop::kDefaultDeviation);
+      slot.requested = true;
+    }
+
+    // Keep receiving the states of the robots whose motion has not started yet, as startMotion()
+    // does for a single robot. The Move response is only checked once a millisecond, as it does not
+    // wake up the poller.
+    Clock::time_point deadline = Clock::now() + kReceiveTimeout;
+    for (;;) {
+      bool started = true;
+      for (size_t i = 0; i < slots.size(); i++) {
+        Slot& slot = slots[i];
+        // motionStarted() consumes the Move response, so it must not be called again afterwards.
+        while (!slot.started && !(slot.started = slot.robot->motionStarted(slot.motion_id)) &&
+               slot.robot->receiveState(&states[i].robot_state)) {
+          deadline = Clock::now() + kReceiveTimeout;
+        }
+        poller->setEnabled(i, !slot.started);
+        started = started && slot.started;
+      }
+      if (started) {
+        break;
+      }
+      Clock::time_point now = Clock::now();
+      if (now >= deadline) {
+        throw NetworkException("libfranka: UDP receive: Timeout");
+      }
+      poller->wait(std::chrono::duration_cast<std::chrono::microseconds>(
+          std::min<Clock::duration>(deadline - now, std::chrono::milliseconds(1))));
+    }
+  } catch (...) {
+    cancel();
+    throw;
+  }
+  for (Slot& slot : slots) {
+    slot.running = true;
+  }
+}
+
+void MultiRobotControl::Impl::receive() {
+  for (size_t i = 0; i < slots.size(); i++) {
+    states[i].updated = false;
+    states[i].time_step = Duration();
+    states[i].arrival_offset = 0;
+    poller->setEnabled(i, true);
+  }
+
+  size_t received = 0;
+  Clock::time_point first_arrival{};
+  Clock::time_point deadline = Clock::now() + kReceiveTimeout;
+  for (;;) {
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (states[i].updated || !slots[i].robot->receiveState(&states[i].robot_state)) {
+        continue;
+      }
+      Clock::time_point arrival = Clock::now();
+      if (received++ == 0) {
+        first_arrival = arrival;
+        deadline = arrival + alignment_window;
+      }
+      states[i].updated = true;
+      states[i].arrival_offset =
+          std::chrono::duration<double, std::micro>(arrival - first_arrival).count();
+      poller->setEnabled(i, false);
+    }
+
+    Clock::time_point now = Clock::now();
+    if (received == slots.size() || (received > 0 && now >= deadline)) {
+      return;
+    }
+    if (now >= deadline) {
+      throw NetworkException("libfranka: UDP receive: Timeout");
+    }
+    poller->wait(std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+  }
+}
+
+void MultiRobotControl::Impl::process(bool record) {
+  for (size_t i = 0; i < slots.size(); i++) {
+    Slot& slot = slots[i];
+    if (!states[i].updated) {
+      if (record) {
+        slot.missed_states++;
+      }
+      continue;
+    }
+
+    RobotState& robot_state = states[i].robot_state;
+    slot.robot->throwOnMotionError(robot_state, slot.motion_id);
+    if (slot.received) {
+      states[i].time_step = robot_state.time - slot.previous_time;
+    }
+    slot.received = true;
+    slot.previous_time = robot_state.time;
+    slot.loop->estimateJointState(&robot_state, states[i].time_step);
+    if (record) {
+      slot.arrival_offset.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double, std::micro>(states[i].arrival_offset)));
+    }
+  }
+}
+
+void MultiRobotControl::Impl::finish() {
+  try {
+    for (Slot& slot : slots) {
+      slot.motion_command.motion_generation_finished = true;
+      slot.running = slot.robot->motionRunning();
+    }
+
+    // Every robot gets the finishing command once per received state, like in finishMotion().
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (slots[i].running && states[i].updated) {
+        slots[i].robot->sendCommand(&slots[i].motion_command, &slots[i].control_command);
+      }
+    }
+    while (std::any_of(slots.begin(), slots.end(), [](const Slot& slot) { return slot.running; })) {
+      receive();
+      for (size_t i = 0; i < slots.size(); i++) {
+        Slot& slot = slots[i];
+        if (!slot.running || !states[i].updated) {
+          continue;
+        }
+        slot.running = slot.robot->motionRunning();
+        if (slot.running) {
+          slot.robot->sendCommand(&slot.motion_command, &slot.control_command);
+        }
+      }
+    }
+  } catch (...) {
+    cancel();
+    throw;
+  }
+
+  std::exception_ptr error;
+  for (size_t i = 0; i < slots.size(); i++) {
+    slots[i].requested = false;
+    try {
+      slots[i].robot->completeMotion(slots[i].motion_id,
+                                     states[i].robot_state.last_motion_errors);
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+      try {
+        slots[i].robot->cancelMotion(slots[i].motion_id);
+      } catch (...) {
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void MultiRobotControl::Impl::cancel() noexcept {
+  for (Slot& slot : slots) {
+    if (!slot.requested) {
+      continue;
+    }
+    slot.requested = false;
+    slot.running = false;
+    try {
+      slot.robot->cancelMotion(slot.motion_id);
+    } catch (...) {
+    }
+  }
+}
+
+MultiRobotControl::MultiRobotControl(const std::vector<Robot*>& robots,
+                                     std::chrono::microseconds alignment_window) {
+  if (robots.empty()) {
+    throw std::invalid_argument("libfranka: Multi-robot control needs at least one robot.");
+  }
+  for (size_t i = 0; i < robots.size(); i++) {
+    if (robots[i] == nullptr) {
+      throw std::invalid_argument("libfranka: Multi-robot control robot is null.");
+    }
+    if (std::find(robots.begin(), robots.begin() + i, robots[i]) != robots.begin() + i) {
+      throw std::invalid_argument("libfranka: Multi-robot control robot is given twice.");
+    }
+  }
+  if (alignment_window.count() < 0 || alignment_window >= std::chrono::milliseconds(1)) {
+    throw std::invalid_argument(
+        "libfranka: Multi-robot control alignment window must be shorter than one cycle.");
+  }
+  impl_ = std::make_unique<Impl>(robots, alignment_window);
+}
+
+MultiRobotControl::~MultiRobotControl() noexcept = default;
+
+void MultiRobotControl::control(const ControlCallback& control_callback,
+                                bool limit_rate,
+                                const FilterConfiguration& filter_configuration) {
+  if (!control_callback) {
+    throw std::invalid_argument("libfranka: Invalid control callback given.");
+  }
+  std::unique_lock<std::mutex> lock(impl_->mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka: Cannot perform this operation while the multi-robot control loop is running.");
+  }
+
+  std::vector<std::unique_lock<std::mutex>> robot_locks;
+  std::vector<Robot::Impl*> robots;
+  for (Robot* robot : impl_->robots) {
+    robot_locks.emplace_back(robot->control_mutex_, std::try_to_lock);
+    if (!robot_locks.back().owns_lock()) {
+      throw InvalidOperationException(
+          "libfranka robot: Cannot perform this operation while another control or read operation "
+          "is running.");
+    }
+    if (!robot->impl_) {
+      throw std::invalid_argument("libfranka: Multi-robot control robot has been moved from.");
+    }
+    robots.push_back(robot->impl_.get());
+  }
+
+  impl_->control(robots, control_callback, limit_rate, filter_configuration);
+}
+
+size_t MultiRobotControl::size() const noexcept {
+  return impl_->robots.size();
+}
+
+std::vector<MultiRobotStatistics> MultiRobotControl::statistics() {
+  std::unique_lock<std::mutex> lock(impl_->mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka: Cannot perform this operation while the multi-robot control loop is running.");
+  }
+
+  std::vector<MultiRobotStatistics> statistics(impl_->slots.size());
+  for (size_t i = 0; i < impl_->slots.size(); i++) {
+    statistics[i].control = impl_->robots[i]->controlStatistics();
+    statistics[i].arrival_offset = impl_->slots[i].arrival_offset.statistics();
+    statistics[i].missed_states = impl_->slots[i].missed_states;
+  }
+  return statistics;
+}
+
+void MultiRobotControl::resetStatistics() {
+  std::unique_lock<std::mutex> lock(impl_->mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka: Cannot perform this operation while the multi-robot control loop is running.");
+  }
+
+  for (size_t i = 0; i < impl_->slots.size(); i++) {
+    impl_->robots[i]->resetControlStatistics();
+    impl_->slots[i].arrival_offset.reset();
+    impl_->slots[i].missed_states = 0;
+  }
+}
+
+}  // namespace franka
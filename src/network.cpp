@@ -2,18 +2,60 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include "network.h"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "udp_transport.h"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <time.h>
+#endif
 
 using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
 
 namespace franka {
 
+constexpr size_t Network::kUdpBatchSize;
+constexpr std::chrono::milliseconds Network::kTcpReaderWakeup;
+constexpr size_t Network::kTcpResponsePoolSize;
+constexpr size_t Network::kTcpResponseBufferSize;
+
+constexpr std::chrono::microseconds UdpPoller::kPollSlice;
+
 Network::Network(const std::string& franka_address,
                  uint16_t franka_port,
                  std::chrono::milliseconds tcp_timeout,
                  std::chrono::milliseconds udp_timeout,
-                 std::tuple<bool, int, int, int> tcp_keepalive) {
+                 std::tuple<bool, int, int, int> tcp_keepalive)
+    : Network(franka_address,
+              franka_port,
+              std::make_unique<UdpTransport>(udp_timeout),
+              tcp_timeout,
+              tcp_keepalive) {}
+
+Network::Network(const std::string& franka_address,
+                 uint16_t franka_port,
+                 std::unique_ptr<DatagramTransport> udp_transport,
+                 std::chrono::milliseconds tcp_timeout,
+                 std::tuple<bool, int, int, int> tcp_keepalive)
+    : udp_transport_(std::move(udp_transport)), tcp_timeout_(tcp_timeout) {
+  if (!udp_transport_) {
+    throw std::invalid_argument("libfranka: Invalid datagram transport given.");
+  }
+  received_responses_.reserve(kTcpResponsePoolSize);
+  tcp_buffer_pool_.reserve(kTcpResponsePoolSize);
+  for (size_t i = 0; i < kTcpResponsePoolSize; i++) {
+    tcp_buffer_pool_.emplace_back();
+    tcp_buffer_pool_.back().reserve(kTcpResponseBufferSize);
+  }
+
   try {
     Poco::Timespan poco_timeout(1000l * tcp_timeout.count());
     Poco::Net::SocketAddress address(franka_address, franka_port);
@@ -32,10 +74,6 @@ Network::Network(const std::string& franka_address,
       } catch (...) {
       }
     }
-
-    udp_socket_.bind({"0.0.0.0", 0});
-    udp_socket_.setReceiveTimeout(Poco::Timespan{1000l * udp_timeout.count()});
-    udp_port_ = udp_socket_.address().port();
   } catch (const Poco::Net::ConnectionRefusedException& e) {
     throw NetworkException(
         "libfranka: Connection to FCI refused. Please install FCI feature or enable FCI mode in Desk."s);
@@ -50,6 +88,10 @@ Network::Network(const std::string& franka_address,
 }
 
 Network::~Network() {
+  if (event_loop_) {
+    event_loop_->remove(*this);
+  }
+  releaseUdpOwnership();
   try {
     tcp_socket_.shutdown();
   } catch (...) {
@@ -57,14 +99,68 @@ Network::~Network() {
 }
 
 uint16_t Network::udpPort() const noexcept {
-  return udp_port_;
+  return udp_transport_->port();
 }
 
-void Network::tcpThrowIfConnectionClosed() try {
+std::chrono::system_clock::time_point Network::udpReceiveTime() const noexcept {
+  return udp_receive_time_;
+}
+
+void Network::acquireUdpOwnership() {
+  if (udp_owner_.load() == std::this_thread::get_id()) {
+    return;
+  }
+  udp_mutex_.lock();
+  udp_owner_.store(std::this_thread::get_id());
+}
+
+void Network::releaseUdpOwnership() noexcept {
+  if (udp_owner_.load() != std::this_thread::get_id()) {
+    return;
+  }
+  udp_owner_.store(std::thread::id());
+  udp_mutex_.unlock();
+}
+
+std::unique_lock<std::mutex> Network::udpLock() {
+  if (udp_owner_.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+    return std::unique_lock<std::mutex>(udp_mutex_, std::defer_lock);
+  }
+  return std::unique_lock<std::mutex>(udp_mutex_);
+}
+
+void Network::setDatagramRecorder(std::shared_ptr<DatagramRecorder> recorder) {
+  auto lock = udpLock();
+  udp_recorder_ = std::move(recorder);
+}
+
+std::shared_ptr<DatagramRecorder> Network::datagramRecorder() {
+  auto lock = udpLock();
+  return udp_recorder_;
+}
+
+void Network::recordDatagramUnsafe(DatagramType type,
+                                   const uint8_t* data,
+                                   size_t size,
+                                   std::chrono::system_clock::time_point time) noexcept {
+  if (!udp_recorder_) {
+    return;
+  }
+  if (time == std::chrono::system_clock::time_point()) {
+    time = std::chrono::system_clock::now();
+  }
+  recordRawDatagram(*udp_recorder_, type, data, size, time);
+}
+
+void Network::tcpThrowIfConnectionClosed() {
   std::unique_lock<std::mutex> lock(tcp_mutex_, std::try_to_lock);
   if (!lock.owns_lock()) {
     return;
   }
+  tcpThrowIfConnectionClosedUnsafe();
+}
+
+void Network::tcpThrowIfConnectionClosedUnsafe() try {
   if (tcp_socket_.poll(0, Poco::Net::Socket::SELECT_READ)) {
     std::array<uint8_t, 1> buffer;
     int rv = tcp_socket_.receiveBytes(buffer.data(), static_cast<int>(buffer.size()), MSG_PEEK);
@@ -77,4 +173,208 @@ void Network::tcpThrowIfConnectionClosed() try {
   throw NetworkException("libfranka: "s + e.what());
 }
 
+bool Network::tcpWaitForData(std::chrono::microseconds timeout) try {
+  std::unique_lock<std::mutex> lock(tcp_mutex_);
+  NetworkEventLoop* event_loop = runningEventLoopUnsafe();
+  if (event_loop == nullptr) {
+    lock.unlock();
+    return tcpWaitForSocket(timeout);
+  }
+  if (tcp_socket_.poll(0, Poco::Net::Socket::SELECT_READ | Poco::Net::Socket::SELECT_ERROR)) {
+    return true;
+  }
+  event_loop->rearm(*this);
+  return tcp_condition_.wait_for(lock, timeout) == std::cv_status::no_timeout;
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: TCP poll: "s + e.what());
+}
+
+std::vector<uint8_t> Network::acquireTcpBufferUnsafe() {
+  if (tcp_buffer_pool_.empty()) {
+    std::vector<uint8_t> buffer;
+    buffer.reserve(kTcpResponseBufferSize);
+    return buffer;
+  }
+  std::vector<uint8_t> buffer = std::move(tcp_buffer_pool_.back());
+  tcp_buffer_pool_.pop_back();
+  return buffer;
+}
+
+void Network::releaseTcpBufferUnsafe(std::vector<uint8_t>&& buffer) noexcept {
+  if (buffer.capacity() < kTcpResponseBufferSize ||
+      buffer.capacity() >= 2 * kTcpResponseBufferSize ||
+      tcp_buffer_pool_.size() >= kTcpResponsePoolSize) {
+    return;
+  }
+  buffer.clear();
+  tcp_buffer_pool_.push_back(std::move(buffer));
+}
+
+Network::TcpResponses::iterator Network::findTcpResponseUnsafe(uint32_t command_id) noexcept {
+  return std::find_if(received_responses_.begin(), received_responses_.end(),
+                      [command_id](const TcpResponses::value_type& response) {
+                        return response.first == command_id;
+                      });
+}
+
+void Network::eraseTcpResponseUnsafe(TcpResponses::iterator it) noexcept {
+  releaseTcpBufferUnsafe(std::move(it->second));
+  // Order does not matter, so move the last response into the gap instead of shifting.
+  if (it != received_responses_.end() - 1) {
+    *it = std::move(received_responses_.back());
+  }
+  received_responses_.pop_back();
+}
+
+bool Network::tcpWaitForSocket(std::chrono::steady_clock::duration timeout) try {
+  return tcp_socket_.poll(
+      std::chrono::duration_cast<std::chrono::microseconds>(timeout).count(),
+      Poco::Net::Socket::SELECT_READ | Poco::Net::Socket::SELECT_ERROR);
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: TCP poll: "s + e.what());
+}
+
+void Network::setEventLoop(std::shared_ptr<NetworkEventLoop> event_loop) {
+  {
+    std::lock_guard<std::mutex> _(tcp_mutex_);
+    if (event_loop_ == event_loop) {
+      return;
+    }
+    if (event_loop_ && event_loop) {
+      throw InvalidOperationException(
+          "libfranka: Connection is already attached to an event loop.");
+    }
+  }
+
+  // The event loop locks tcp_mutex_ while dispatching, so it must not be called with it held.
+  if (event_loop) {
+    event_loop->add(*this);
+  }
+  std::shared_ptr<NetworkEventLoop> previous;
+  {
+    std::lock_guard<std::mutex> _(tcp_mutex_);
+    previous = std::move(event_loop_);
+    event_loop_ = std::move(event_loop);
+  }
+  if (previous) {
+    previous->remove(*this);
+  }
+  tcp_condition_.notify_all();
+}
+
+int Network::tcpDescriptor() const noexcept {
+  return tcp_socket_.impl()->sockfd();
+}
+
+void Network::notifyTcpReadable() noexcept {
+  {
+    // Waiters check for data and start waiting with the lock held, so no wake-up is lost.
+    std::lock_guard<std::mutex> _(tcp_mutex_);
+  }
+  tcp_condition_.notify_all();
+}
+
+NetworkEventLoop* Network::runningEventLoopUnsafe() const noexcept {
+  return event_loop_ && event_loop_->running() ? event_loop_.get() : nullptr;
+}
+
+UdpPoller::UdpPoller(const std::vector<Network*>& networks) {
+  for (Network* network : networks) {
+    transports_.push_back(network->udp_transport_.get());
+    enabled_.push_back(true);
+#ifdef __linux__
+    pollfd descriptor{};
+    // Negative descriptors are ignored by ppoll.
+    descriptor.fd = network->udp_transport_->descriptor();
+    descriptor.events = POLLIN;
+    descriptors_.push_back(descriptor);
+#endif
+  }
+}
+
+void UdpPoller::setEnabled(size_t index, bool enabled) noexcept {
+  enabled_[index] = enabled;
+#ifdef __linux__
+  descriptors_[index].events = enabled ? POLLIN : 0;
+#endif
+}
+
+bool UdpPoller::wait(std::chrono::microseconds timeout) {
+  using namespace std::literals::chrono_literals;  // NOLINT(google-build-using-namespace)
+
+  // Transports that can only be checked with their own wait().
+  size_t waiting_transports = 0;
+  DatagramTransport* waiting_transport = nullptr;
+  bool descriptors_enabled = false;
+  for (size_t i = 0; i < transports_.size(); i++) {
+    if (!enabled_[i]) {
+      continue;
+    }
+#ifdef __linux__
+    if (descriptors_[i].fd >= 0) {
+      descriptors_enabled = true;
+      continue;
+    }
+#endif
+    waiting_transports++;
+    waiting_transport = transports_[i];
+  }
+
+  if (waiting_transports == 0) {
+#ifdef __linux__
+    return waitForDescriptors(timeout);
+#else
+    std::this_thread::sleep_for(timeout);
+    return false;
+#endif
+  }
+  if (waiting_transports == 1 && !descriptors_enabled) {
+    return waiting_transport->wait(timeout);
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    for (size_t i = 0; i < transports_.size(); i++) {
+#ifdef __linux__
+      bool waiting = enabled_[i] && descriptors_[i].fd < 0;
+#else
+      bool waiting = enabled_[i];
+#endif
+      if (waiting && transports_[i]->wait(0us)) {
+        return true;
+      }
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (remaining <= 0us) {
+      return false;
+    }
+#ifdef __linux__
+    if (descriptors_enabled) {
+      if (waitForDescriptors(std::min(remaining, kPollSlice))) {
+        return true;
+      }
+      continue;
+    }
+#endif
+    std::this_thread::yield();
+  }
+}
+
+#ifdef __linux__
+bool UdpPoller::waitForDescriptors(std::chrono::microseconds timeout) {
+  timespec duration{};
+  duration.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+  duration.tv_nsec = static_cast<long>((timeout.count() % 1000000) * 1000);
+  int ready;
+  do {
+    ready = ppoll(descriptors_.data(), descriptors_.size(), &duration, nullptr);
+  } while (ready < 0 && errno == EINTR);
+  if (ready < 0) {
+    throw NetworkException("libfranka: UDP poll: "s + std::strerror(errno));
+  }
+  return ready > 0;
+}
+#endif
+
 }  // namespace franka
@@ -2,24 +2,50 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include <Poco/Net/DatagramSocket.h>
 #include <Poco/Net/NetException.h>
 #include <Poco/Net/StreamSocket.h>
 
+#ifdef __linux__
+#include <poll.h>
+#endif
+
+#include <franka/datagram_recorder.h>
 #include <franka/exception.h>
 
+#include "datagram_transport.h"
+#include "network_event_loop.h"
+#include "tracing.h"
+
 namespace franka {
 
+/**
+ * Variable-length data of a TCP response. The data stays in the buffer of the whole response
+ * message, so that handing it over neither copies nor moves it.
+ */
+struct TcpResponseData {
+  const uint8_t* data() const noexcept { return message.data() + offset; }
+  size_t size() const noexcept { return message.size() - offset; }
+
+  std::vector<uint8_t> message;
+  size_t offset{0};
+};
+
 class Network {
  public:
   Network(const std::string& franka_address,
@@ -27,6 +53,25 @@ class Network {
           std::chrono::milliseconds tcp_timeout = std::chrono::seconds(60),
           std::chrono::milliseconds udp_timeout = std::chrono::seconds(1),
           std::tuple<bool, int, int, int> tcp_keepalive = std::make_tuple(true, 1, 3, 1));
+
+  /**
+   * Connects to the device and exchanges state and command datagrams over the given transport
+   * instead of UDP, e.g. shared memory with a simulator on the same host.
+   *
+   * @param[in] franka_address IP/hostname of the device.
+   * @param[in] franka_port TCP port of the device.
+   * @param[in] udp_transport Transport for the state and command datagrams.
+   * @param[in] tcp_timeout Timeout for TCP connecting, sending and receiving.
+   * @param[in] tcp_keepalive TCP keepalive settings.
+   *
+   * @throw NetworkException if the connection cannot be established.
+   * @throw std::invalid_argument if no transport is given.
+   */
+  Network(const std::string& franka_address,
+          uint16_t franka_port,
+          std::unique_ptr<DatagramTransport> udp_transport,
+          std::chrono::milliseconds tcp_timeout = std::chrono::seconds(60),
+          std::tuple<bool, int, int, int> tcp_keepalive = std::make_tuple(true, 1, 3, 1));
   ~Network();
 
   uint16_t udpPort() const noexcept;
@@ -37,26 +82,118 @@ class Network {
   template <typename T>
   bool udpReceive(T* data);
 
+  /**
+   * Drains all datagrams currently queued on the UDP socket without blocking and keeps the one
+   * with the highest message ID.
+   *
+   * On Linux, queued datagrams are fetched in batches with a single `recvmmsg` call each.
+   *
+   * @param[out] data Written with the most recent datagram if at least one was available.
+   *
+   * @return True if at least one datagram has been received, false otherwise.
+   */
+  template <typename T>
+  bool udpReceiveLatest(T* data);
+
   template <typename T>
   void udpSend(const T& data);
 
+  /**
+   * Returns the time at which the kernel received the datagram last returned by a UDP receive.
+   *
+   * On Linux, receive timestamps are enabled with `SO_TIMESTAMPNS`. On other platforms, or if no
+   * timestamp has been reported, the epoch is returned.
+   *
+   * Must be called from the thread that performed the receive, or with the UDP socket owned.
+   */
+  std::chrono::system_clock::time_point udpReceiveTime() const noexcept;
+
+  /**
+   * Makes the calling thread the exclusive user of the UDP socket.
+   *
+   * While the ownership is held, UDP operations from the owning thread do not lock, and UDP
+   * operations from other threads block until releaseUdpOwnership() is called. Does nothing if the
+   * calling thread already owns the socket.
+   */
+  void acquireUdpOwnership();
+
+  /**
+   * Releases the UDP socket ownership taken with acquireUdpOwnership().
+   *
+   * Does nothing if the calling thread does not own the socket.
+   */
+  void releaseUdpOwnership() noexcept;
+
+  /**
+   * Records all datagrams received and sent from now on with the given recorder.
+   *
+   * @param[in] recorder Recorder to use, or nullptr to stop recording.
+   */
+  void setDatagramRecorder(std::shared_ptr<DatagramRecorder> recorder);
+
+  /**
+   * @return Recorder set with setDatagramRecorder(), or nullptr if datagrams are not recorded.
+   */
+  std::shared_ptr<DatagramRecorder> datagramRecorder();
+
   void tcpThrowIfConnectionClosed();
 
+  /**
+   * Waits until data can be read from the TCP socket, without locking it.
+   *
+   * @param[in] timeout Maximum time to wait.
+   *
+   * @return True if data is available, false if the timeout expired.
+   */
+  bool tcpWaitForData(std::chrono::microseconds timeout);
+
+  /**
+   * Lets the given event loop wait on the TCP socket, so that blocking receives sleep until it
+   * reports new data instead of polling the socket themselves.
+   *
+   * @param[in] event_loop Event loop, or null to wait on the socket again.
+   *
+   * @throw InvalidOperationException if the connection is already attached to another event loop.
+   * @throw NetworkException if the socket cannot be registered.
+   */
+  void setEventLoop(std::shared_ptr<NetworkEventLoop> event_loop);
+
+  /**
+   * @return Native descriptor of the TCP socket.
+   */
+  int tcpDescriptor() const noexcept;
+
+  /**
+   * Wakes up all callers waiting for TCP data. Called by the event loop.
+   */
+  void notifyTcpReadable() noexcept;
+
   /**
    * Blocks until a T::Response message with the given command ID has been received.
    *
-   * Additional variable-length data for the expected response (if any) is written into the given
-   * vl_buffer. If vl_buffer is not given, this data is discarded.
+   * Additional variable-length data for the expected response (if any) is handed over in the given
+   * vl_data. If vl_data is not given, this data is discarded.
    *
    * @param[in] command_id Expected command ID of the T::Response.
-   * @param[out] vl_buffer If given, variable-length data for the expected T::Response message (if
-   * any has been received) is copied into it.
+   * @param[out] vl_data If given, takes over the buffer of the expected T::Response message if it
+   * has variable-length data.
+   * @param[in] command_timeout Time the command itself may take before it is answered, e.g. the
+   * timeout of a vacuum gripper command. It is added to the TCP timeout given to the constructor.
+   * std::chrono::milliseconds::max() waits without a deadline.
+   *
+   * Only one of several concurrent callers waits on the socket at a time. The others sleep until
+   * it has received a response.
    *
    * @return Received T::Response instance.
+   *
+   * @throw NetworkException if the connection is lost, or if no response has been received within
+   * the TCP timeout given to the constructor plus command_timeout.
    */
   template <typename T>
-  typename T::Response tcpBlockingReceiveResponse(uint32_t command_id,
-                                                  std::vector<uint8_t>* vl_buffer = nullptr);
+  typename T::Response tcpBlockingReceiveResponse(
+      uint32_t command_id,
+      TcpResponseData* vl_data = nullptr,
+      std::chrono::milliseconds command_timeout = std::chrono::milliseconds(0));
 
   /**
    * Tries to receive a T::Response message with the given command ID (non-blocking).
@@ -77,33 +214,138 @@ class Network {
   uint32_t tcpSendRequest(TArgs&&... args);
 
  private:
+  friend class UdpPoller;
+
   template <typename T>
   T udpBlockingReceiveUnsafe();
 
+  std::unique_lock<std::mutex> udpLock();
+
+  // Hands a datagram to the recorder, if any. Must be called with the UDP lock held.
+  void recordDatagramUnsafe(DatagramType type,
+                            const uint8_t* data,
+                            size_t size,
+                            std::chrono::system_clock::time_point time) noexcept;
+
+  static constexpr size_t kUdpBatchSize = 8;
+
   template <typename T>
   void tcpReadFromBuffer(std::chrono::microseconds timeout);
 
+  // Upper bound for a single wait of a blocking receive, after which it checks its deadline and
+  // whether another caller has to take over waiting on the socket.
+  static constexpr std::chrono::milliseconds kTcpReaderWakeup{100};
+
+  // Waits until the TCP socket is readable, without locking it.
+  bool tcpWaitForSocket(std::chrono::steady_clock::duration timeout);
+
+  // Returns the event loop if it is running. Must be called with tcp_mutex_ held.
+  NetworkEventLoop* runningEventLoopUnsafe() const noexcept;
+  // Requests a wake-up from the event loop and waits for it. Must be called with lock on
+  // tcp_mutex_ held. Throws if the connection has been closed.
+  template <typename T>
+  void tcpWaitForEventUnsafe(NetworkEventLoop* event_loop, std::unique_lock<std::mutex>* lock);
+  void tcpThrowIfConnectionClosedUnsafe();
+
+  // Number of preallocated TCP response buffers, and their capacity. Responses with variable-length
+  // data beyond this capacity, like the model library, get a buffer of their own.
+  static constexpr size_t kTcpResponsePoolSize = 8;
+  static constexpr size_t kTcpResponseBufferSize = 1024;
+
+  using TcpResponses = std::vector<std::pair<uint32_t, std::vector<uint8_t>>>;
+
+  // Takes a buffer from the pool, or allocates one if the pool is empty. Must be called with
+  // tcp_mutex_ held.
+  std::vector<uint8_t> acquireTcpBufferUnsafe();
+  // Returns a buffer to the pool, unless it has been moved from or grown beyond the pooled
+  // capacity. Must be called with tcp_mutex_ held.
+  void releaseTcpBufferUnsafe(std::vector<uint8_t>&& buffer) noexcept;
+  // Must be called with tcp_mutex_ held.
+  TcpResponses::iterator findTcpResponseUnsafe(uint32_t command_id) noexcept;
+  // Removes a received response and returns its buffer to the pool. Must be called with
+  // tcp_mutex_ held.
+  void eraseTcpResponseUnsafe(TcpResponses::iterator it) noexcept;
+
   Poco::Net::StreamSocket tcp_socket_;
-  Poco::Net::DatagramSocket udp_socket_;
-  Poco::Net::SocketAddress udp_server_address_;
-  uint16_t udp_port_;
+  std::unique_ptr<DatagramTransport> udp_transport_;
 
   std::mutex tcp_mutex_;
+  std::condition_variable tcp_condition_;
+  std::shared_ptr<NetworkEventLoop> event_loop_;
+  // True while a blocking receive waits on the socket without holding tcp_mutex_.
+  bool tcp_reader_active_{false};
+  std::chrono::milliseconds tcp_timeout_;
   std::mutex udp_mutex_;
+  std::atomic<std::thread::id> udp_owner_{};
+  std::chrono::system_clock::time_point udp_receive_time_{};
+  std::array<std::chrono::system_clock::time_point, kUdpBatchSize> udp_batch_receive_times_{};
+  std::shared_ptr<DatagramRecorder> udp_recorder_;
 
   uint32_t command_id_{0};
 
   std::vector<uint8_t> pending_response_{};
   size_t pending_response_offset_ = 0;
   uint32_t pending_command_id_ = 0;
-  std::unordered_map<uint32_t, std::vector<uint8_t>> received_responses_{};
+  // Received responses that have not been picked up yet. Linear search is faster than hashing for
+  // the few responses that are in flight at a time.
+  TcpResponses received_responses_{};
+  std::vector<std::vector<uint8_t>> tcp_buffer_pool_{};
+};
+
+/**
+ * Waits for datagrams on the transports of several networks at once.
+ */
+class UdpPoller {
+ public:
+  /**
+   * Creates a poller for the given networks.
+   *
+   * @param[in] networks Networks to wait on. They must outlive the poller.
+   */
+  explicit UdpPoller(const std::vector<Network*>& networks);
+
+  /**
+   * Blocks until a datagram is queued on at least one of the transports.
+   *
+   * On Linux, transports with a descriptor are waited on with a single `ppoll` call, which does
+   * not allocate memory. Transports without a descriptor are checked in intervals of kPollSlice.
+   *
+   * @param[in] timeout Maximum time to wait.
+   *
+   * @return True if a datagram is queued, false if the timeout expired.
+   *
+   * @throw NetworkException if waiting failed.
+   */
+  bool wait(std::chrono::microseconds timeout);
+
+  /**
+   * Includes or excludes the transport of a network in wait(). All transports are included by
+   * default.
+   *
+   * @param[in] index Index of the network in the list given to the constructor.
+   * @param[in] enabled True to wait on the transport.
+   */
+  void setEnabled(size_t index, bool enabled) noexcept;
+
+  /// Interval in which transports without a descriptor are checked while also waiting on
+  /// descriptors.
+  static constexpr std::chrono::microseconds kPollSlice{100};
+
+ private:
+  std::vector<DatagramTransport*> transports_;
+  std::vector<bool> enabled_;
+#ifdef __linux__
+  bool waitForDescriptors(std::chrono::microseconds timeout);
+
+  std::vector<pollfd> descriptors_;
+#endif
 };
 
 template <typename T>
 bool Network::udpReceive(T* data) {
-  std::lock_guard<std::mutex> _(udp_mutex_);
+  auto lock = udpLock();
 
-  if (udp_socket_.available() >= static_cast<int>(sizeof(T))) {
+  if (udp_transport_->available(sizeof(T))) {
     *data = udpBlockingReceiveUnsafe<T>();
     return true;
   }
@@ -112,38 +354,48 @@ bool Network::udpReceive(T* data) {
 
 template <typename T>
 T Network::udpBlockingReceive() {
-  std::lock_guard<std::mutex> _(udp_mutex_);
+  auto lock = udpLock();
   return udpBlockingReceiveUnsafe<T>();
 }
 
 template <typename T>
-T Network::udpBlockingReceiveUnsafe() try {
-  std::array<uint8_t, sizeof(T)> buffer;
+bool Network::udpReceiveLatest(T* data) {
+  auto lock = udpLock();
 
-  int bytes_received =
-      udp_socket_.receiveFrom(buffer.data(), static_cast<int>(buffer.size()), udp_server_address_);
-
-  if (bytes_received != static_cast<int>(buffer.size())) {
-    throw ProtocolException("libfranka: incorrect object size");
-  }
+  std::array<T, kUdpBatchSize> batch;
+  bool received = false;
+  size_t batch_size = 0;
+  do {
+    batch_size = udp_transport_->receiveBatch(reinterpret_cast<uint8_t*>(batch.data()), sizeof(T),
+                                              batch.size(), udp_batch_receive_times_.data());
+    for (size_t i = 0; i < batch_size; i++) {
+      recordDatagramUnsafe(DatagramType::kRobotState, reinterpret_cast<const uint8_t*>(&batch[i]),
+                           sizeof(T), udp_batch_receive_times_[i]);
+      if (!received || batch[i].message_id > data->message_id) {
+        *data = batch[i];
+        udp_receive_time_ = udp_batch_receive_times_[i];
+        received = true;
+      }
+    }
+  } while (batch_size == batch.size());
+  return received;
+}
 
+template <typename T>
+T Network::udpBlockingReceiveUnsafe() {
+  std::array<uint8_t, sizeof(T)> buffer;
+  udp_transport_->receive(buffer.data(), buffer.size(), &udp_receive_time_);
+  recordDatagramUnsafe(DatagramType::kRobotState, buffer.data(), buffer.size(), udp_receive_time_);
   return *reinterpret_cast<T*>(buffer.data());
-} catch (const Poco::Exception& e) {
-  using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
-  throw NetworkException("libfranka: UDP receive: "s + e.what());
 }
 
 template <typename T>
-void Network::udpSend(const T& data) try {
-  std::lock_guard<std::mutex> _(udp_mutex_);
-
-  int bytes_sent = udp_socket_.sendTo(&data, sizeof(data), udp_server_address_);
-  if (bytes_sent != sizeof(data)) {
-    throw NetworkException("libfranka: could not send UDP data");
-  }
-} catch (const Poco::Exception& e) {
-  using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
-  throw NetworkException("libfranka: UDP send: "s + e.what());
+void Network::udpSend(const T& data) {
+  TraceScope trace("Network::udpSend");
+  auto lock = udpLock();
+  udp_transport_->send(reinterpret_cast<const uint8_t*>(&data), sizeof(data));
+  recordDatagramUnsafe(DatagramType::kRobotCommand, reinterpret_cast<const uint8_t*>(&data),
+                       sizeof(data), {});
 }
 
 template <typename T>
@@ -155,6 +407,7 @@ void Network::tcpReadFromBuffer(std::chrono::microseconds timeout) try {
   if (!tcp_socket_.poll(timeout.count(), Poco::Net::Socket::SELECT_READ)) {
     return;
   }
+  TraceScope trace("Network::tcpReceive");
 
   int available_bytes = tcp_socket_.available();
   if (pending_response_.empty() &&
@@ -164,6 +417,7 @@ void Network::tcpReadFromBuffer(std::chrono::microseconds timeout) try {
     if (header.size < sizeof(header)) {
       throw ProtocolException("libfranka: Incorrect TCP message size.");
     }
+    pending_response_ = acquireTcpBufferUnsafe();
     pending_response_.resize(header.size);
     std::memcpy(pending_response_.data(), &header, sizeof(header));
     pending_response_offset_ = sizeof(header);
@@ -175,7 +429,9 @@ void Network::tcpReadFromBuffer(std::chrono::microseconds timeout) try {
         std::min(tcp_socket_.available(),
                  static_cast<int>(pending_response_.size() - pending_response_offset_)));
     if (pending_response_offset_ == pending_response_.size()) {
-      received_responses_.emplace(pending_command_id_, pending_response_);
+      received_responses_.emplace_back(pending_command_id_, std::move(pending_response_));
+      // Callers waiting for another response do not see the socket data that has been consumed.
+      tcp_condition_.notify_all();
       pending_response_.clear();
       pending_response_offset_ = 0;
       pending_command_id_ = 0;
@@ -186,8 +442,29 @@ void Network::tcpReadFromBuffer(std::chrono::microseconds timeout) try {
   throw NetworkException("libfranka: TCP receive: "s + e.what());
 }
 
+template <typename T>
+void Network::tcpWaitForEventUnsafe(NetworkEventLoop* event_loop,
+                                    std::unique_lock<std::mutex>* lock) try {
+  using namespace std::literals::chrono_literals;  // NOLINT(google-build-using-namespace)
+  // Data that is already available but could not be read completely, e.g. a closed connection,
+  // would wake up the caller right away again.
+  if (pending_response_.empty() && tcp_socket_.poll(0, Poco::Net::Socket::SELECT_READ)) {
+    tcpThrowIfConnectionClosedUnsafe();
+    if (tcp_socket_.available() >= static_cast<int>(sizeof(typename T::Header))) {
+      return;
+    }
+  }
+  event_loop->rearm(*this);
+  // The timeout only matters if the event loop stops without notifying.
+  tcp_condition_.wait_for(*lock, kTcpReaderWakeup);
+} catch (const Poco::Exception& e) {
+  using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+  throw NetworkException("libfranka: TCP receive: "s + e.what());
+}
+
 template <typename T, typename... TArgs>
 uint32_t Network::tcpSendRequest(TArgs&&... args) try {
+  TraceScope trace("Network::tcpSendRequest");
   std::lock_guard<std::mutex> _(tcp_mutex_);
 
   typename T::template Message<typename T::Request> message(
@@ -213,7 +490,7 @@ bool Network::tcpReceiveResponse(uint32_t command_id,
   }
 
   tcpReadFromBuffer<T>(0us);
-  decltype(received_responses_)::const_iterator it = received_responses_.find(command_id);
+  auto it = findTcpResponseUnsafe(command_id);
   if (it != received_responses_.end()) {
     auto message = reinterpret_cast<const typename T::template Message<typename T::Response>*>(
         it->second.data());
@@ -221,25 +498,64 @@ bool Network::tcpReceiveResponse(uint32_t command_id,
       throw ProtocolException("libfranka: Incorrect TCP message size.");
     }
     handler(message->getInstance());
-    received_responses_.erase(it);
+    eraseTcpResponseUnsafe(it);
     return true;
   }
   return false;
 }
 
 template <typename T>
-typename T::Response Network::tcpBlockingReceiveResponse(uint32_t command_id,
-                                                         std::vector<uint8_t>* vl_buffer) {
+typename T::Response Network::tcpBlockingReceiveResponse(
+    uint32_t command_id,
+    TcpResponseData* vl_data,
+    std::chrono::milliseconds command_timeout) {
   using namespace std::literals::chrono_literals;  // NOLINT(google-build-using-namespace)
-  std::unique_lock<std::mutex> lock(tcp_mutex_, std::defer_lock);
-  decltype(received_responses_)::const_iterator it;
-  do {
-    lock.lock();
-    tcpReadFromBuffer<T>(10ms);
-    it = received_responses_.find(command_id);
-    lock.unlock();
-    std::this_thread::yield();
-  } while (it == received_responses_.end());
+  const auto deadline = command_timeout == std::chrono::milliseconds::max()
+                            ? std::chrono::steady_clock::time_point::max()
+                            : std::chrono::steady_clock::now() + tcp_timeout_ + command_timeout;
+  std::unique_lock<std::mutex> lock(tcp_mutex_);
+  TcpResponses::iterator it;
+  while (true) {
+    NetworkEventLoop* event_loop = runningEventLoopUnsafe();
+    tcpReadFromBuffer<T>(0us);
+    it = findTcpResponseUnsafe(command_id);
+    if (it != received_responses_.end()) {
+      break;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      throw NetworkException("libfranka: TCP receive: Timeout");
+    }
+
+    if (event_loop != nullptr) {
+      tcpWaitForEventUnsafe<T>(event_loop, &lock);
+    } else if (!tcp_reader_active_) {
+      // Become the only caller that waits on the socket. The others wait for its notification.
+      tcp_reader_active_ = true;
+      lock.unlock();
+      bool readable = false;
+      try {
+        auto remaining = std::max<std::chrono::steady_clock::duration>(
+            deadline - std::chrono::steady_clock::now(), 0ms);
+        readable = tcpWaitForSocket(
+            std::min<std::chrono::steady_clock::duration>(remaining, kTcpReaderWakeup));
+      } catch (...) {
+        lock.lock();
+        tcp_reader_active_ = false;
+        tcp_condition_.notify_all();
+        throw;
+      }
+      lock.lock();
+      tcp_reader_active_ = false;
+      // Let another waiter take over the socket if this one is done after the next read.
+      tcp_condition_.notify_all();
+      if (readable && pending_response_.empty()) {
+        tcpThrowIfConnectionClosedUnsafe();
+      }
+    } else {
+      tcp_condition_.wait_until(lock, std::min(deadline, std::chrono::steady_clock::now() +
+                                                              kTcpReaderWakeup));
+    }
+  }
 
   auto message = *reinterpret_cast<const typename T::template Message<typename T::Response>*>(
       it->second.data());
@@ -247,14 +563,13 @@ typename T::Response Network::tcpBlockingReceiveResponse(uint32_t command_id,
     throw ProtocolException("libfranka: Incorrect TCP message size.");
   }
 
-  if (vl_buffer != nullptr && message.header.size != sizeof(message)) {
-    size_t data_size = message.header.size - sizeof(message);
-    std::vector<uint8_t> data_buffer(data_size);
-    std::memcpy(data_buffer.data(), &it->second[sizeof(message)], data_size);
-    *vl_buffer = data_buffer;
+  if (vl_data != nullptr && message.header.size != sizeof(message)) {
+    // Hand over the buffer instead of copying, since the data can be large.
+    vl_data->message = std::move(it->second);
+    vl_data->offset = sizeof(message);
   }
 
-  received_responses_.erase(it);
+  eraseTcpResponseUnsafe(it);
   return message.getInstance();
 }
 
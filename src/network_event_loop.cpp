@@ -0,0 +1,199 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "network_event_loop.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <string>
+#include <utility>
+
+#include <franka/control_tools.h>
+#include <franka/exception.h>
+
+#include "network.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+
+namespace franka {
+
+#ifdef __linux__
+namespace {
+
+constexpr size_t kMaxEvents = 16;
+
+void applyRealtimeConfig(RealtimeConfig realtime_config, const RealtimeOptions& realtime_options) {
+  bool throw_on_error = realtime_config == RealtimeConfig::kEnforce;
+  std::string error_message;
+  if (!setCurrentThreadToHighestSchedulerPriority(&error_message) && throw_on_error) {
+    throw RealtimeException(error_message);
+  }
+  error_message.clear();
+  if (!applyRealtimeOptions(realtime_options, nullptr, &error_message) && throw_on_error) {
+    throw RealtimeException(error_message);
+  }
+}
+
+}  // anonymous namespace
+#endif
+
+NetworkEventLoop::NetworkEventLoop(RealtimeConfig realtime_config,
+                                   const RealtimeOptions& realtime_options) {
+#ifdef __linux__
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ == -1) {
+    throw NetworkException("libfranka: Event loop: "s + std::strerror(errno));
+  }
+  wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  if (wakeup_fd_ == -1 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) == -1) {
+    std::string error = std::strerror(errno);
+    if (wakeup_fd_ != -1) {
+      close(wakeup_fd_);
+    }
+    close(epoll_fd_);
+    throw NetworkException("libfranka: Event loop: "s + error);
+  }
+
+  std::promise<void> started;
+  std::future<void> start_result = started.get_future();
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread([this, realtime_config, realtime_options,
+                         started = std::move(started)]() mutable {
+    try {
+      applyRealtimeConfig(realtime_config, realtime_options);
+    } catch (...) {
+      started.set_exception(std::current_exception());
+      return;
+    }
+    started.set_value();
+    run();
+  });
+  try {
+    start_result.get();
+  } catch (...) {
+    running_.store(false, std::memory_order_release);
+    thread_.join();
+    close(wakeup_fd_);
+    close(epoll_fd_);
+    throw;
+  }
+#else
+  static_cast<void>(realtime_config);
+  static_cast<void>(realtime_options);
+#endif
+}
+
+NetworkEventLoop::~NetworkEventLoop() noexcept {
+  stop();
+#ifdef __linux__
+  close(wakeup_fd_);
+  close(epoll_fd_);
+#endif
+}
+
+void NetworkEventLoop::add(Network& network) {
+  std::lock_guard<std::mutex> _(mutex_);
+#ifdef __linux__
+  if (running()) {
+    epoll_event event{};
+    event.events = 0;
+    event.data.ptr = &network;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, network.tcpDescriptor(), &event) == -1) {
+      throw NetworkException("libfranka: Event loop: "s + std::strerror(errno));
+    }
+  }
+#endif
+  networks_.insert(&network);
+}
+
+void NetworkEventLoop::remove(Network& network) noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  if (networks_.erase(&network) == 0) {
+    return;
+  }
+#ifdef __linux__
+  if (running()) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, network.tcpDescriptor(), nullptr);
+  }
+#endif
+}
+
+void NetworkEventLoop::rearm(Network& network) noexcept {
+#ifdef __linux__
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.ptr = &network;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, network.tcpDescriptor(), &event);
+#else
+  static_cast<void>(network);
+#endif
+}
+
+void NetworkEventLoop::stop() noexcept {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> _(mutex_);
+    running_.store(false, std::memory_order_release);
+#ifdef __linux__
+    uint64_t value = 1;
+    ssize_t written = write(wakeup_fd_, &value, sizeof(value));
+    static_cast<void>(written);
+#endif
+  }
+  thread_.join();
+
+  // Wake up all waiting callers, which then fall back to waiting on their own sockets.
+  std::lock_guard<std::mutex> _(mutex_);
+  for (Network* network : networks_) {
+#ifdef __linux__
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, network->tcpDescriptor(), nullptr);
+#endif
+    network->notifyTcpReadable();
+  }
+}
+
+size_t NetworkEventLoop::size() const {
+  std::lock_guard<std::mutex> _(mutex_);
+  return networks_.size();
+}
+
+void NetworkEventLoop::run() noexcept {
+#ifdef __linux__
+  std::array<epoll_event, kMaxEvents> events;
+  while (running()) {
+    int count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+    if (count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Waiting callers notice the stopped loop after their wait timeout and poll on their own.
+      running_.store(false, std::memory_order_release);
+      return;
+    }
+
+    std::lock_guard<std::mutex> _(mutex_);
+    for (int i = 0; i < count; i++) {
+      auto* network = static_cast<Network*>(events[i].data.ptr);
+      // Ignore the wake-up event and connections that have been removed in the meantime.
+      if (network != nullptr && networks_.count(network) != 0) {
+        network->notifyTcpReadable();
+      }
+    }
+  }
+#endif
+}
+
+}  // namespace franka
@@ -0,0 +1,86 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <franka/control_types.h>
+
+namespace franka {
+
+class Network;
+
+/**
+ * Waits on the TCP sockets of several connections in one thread and wakes up the callers that are
+ * blocked on them.
+ *
+ * On Linux, the sockets are registered with `epoll` in one-shot mode: a caller waiting for a
+ * response re-arms its socket with rearm() and sleeps until the loop reports new data. On other
+ * platforms, the loop does not start and the connections keep waiting on their own sockets.
+ */
+class NetworkEventLoop {
+ public:
+  /**
+   * Starts the loop thread and applies the realtime configuration to it.
+   *
+   * @throw NetworkException if the loop cannot be created.
+   * @throw RealtimeException if realtime priority or options cannot be applied with
+   * RealtimeConfig::kEnforce.
+   */
+  NetworkEventLoop(RealtimeConfig realtime_config, const RealtimeOptions& realtime_options);
+
+  /**
+   * Stops the loop. Must be called before the last reference is released.
+   */
+  ~NetworkEventLoop() noexcept;
+
+  /**
+   * Registers the TCP socket of a connection.
+   *
+   * @throw NetworkException if the socket cannot be registered.
+   */
+  void add(Network& network);
+
+  /**
+   * Unregisters the TCP socket of a connection. Does nothing if it is not registered.
+   */
+  void remove(Network& network) noexcept;
+
+  /**
+   * Requests a single wake-up of the given connection once its TCP socket is readable.
+   */
+  void rearm(Network& network) noexcept;
+
+  /**
+   * Stops the loop thread and detaches all connections, which then wait on their own sockets again.
+   */
+  void stop() noexcept;
+
+  /**
+   * @return True if the loop thread is running.
+   */
+  bool running() const noexcept { return running_.load(std::memory_order_acquire); }
+
+  /**
+   * @return Number of registered connections.
+   */
+  size_t size() const;
+
+  NetworkEventLoop(const NetworkEventLoop&) = delete;
+  NetworkEventLoop& operator=(const NetworkEventLoop&) = delete;
+
+ private:
+  void run() noexcept;
+
+  mutable std::mutex mutex_;
+  std::unordered_set<Network*> networks_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  int epoll_fd_{-1};
+  int wakeup_fd_{-1};
+};
+
+}  // namespace franka
@@ -0,0 +1,390 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "number_format.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace franka {
+
+namespace {
+
+// Grisu2, after F. Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// PLDI 2010.
+
+constexpr uint64_t kSignificandMask = 0x000FFFFFFFFFFFFFull;
+constexpr uint64_t kExponentMask = 0x7FF0000000000000ull;
+constexpr uint64_t kHiddenBit = 0x0010000000000000ull;
+constexpr int kSignificandSize = 52;
+constexpr int kExponentBias = 0x3FF + kSignificandSize;
+constexpr int kDenormalExponent = 1 - kExponentBias;
+constexpr int kDiyFpSize = 64;
+
+// Floating-point number with a 64-bit significand and without rounding: f * 2^e.
+struct DiyFp {
+  uint64_t f;
+  int e;
+};
+
+DiyFp fromDouble(double value) noexcept {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  int biased_exponent = static_cast<int>((bits & kExponentMask) >> kSignificandSize);
+  uint64_t significand = bits & kSignificandMask;
+  if (biased_exponent != 0) {
+    return {significand + kHiddenBit, biased_exponent - kExponentBias};
+  }
+  return {significand, kDenormalExponent};
+}
+
+DiyFp subtract(const DiyFp& lhs, const DiyFp& rhs) noexcept {
+  return {lhs.f - rhs.f, lhs.e};
+}
+
+// Multiplies and rounds to the upper 64 bits of the product.
+DiyFp multiply(const DiyFp& lhs, const DiyFp& rhs) noexcept {
+  constexpr uint64_t kMask32 = 0xFFFFFFFFull;
+  uint64_t a = lhs.f >> 32;
+  uint64_t b = lhs.f & kMask32;
+  uint64_t c = rhs.f >> 32;
+  uint64_t d = rhs.f & kMask32;
+  uint64_t ac = a * c;
+  uint64_t bc = b * c;
+  uint64_t ad = a * d;
+  uint64_t bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & kMask32) + (bc & kMask32);
+  tmp += 1ull << 31;
+  return {ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), lhs.e + rhs.e + kDiyFpSize};
+}
+
+DiyFp normalize(DiyFp value) noexcept {
+  while ((value.f & (1ull << 63)) == 0) {
+    value.f <<= 1;
+    value.e--;
+  }
+  return value;
+}
+
+DiyFp normalizeBoundary(DiyFp value) noexcept {
+  while ((value.f & (kHiddenBit << 1)) == 0) {
+    value.f <<= 1;
+    value.e--;
+  }
+  value.f <<= kDiyFpSize - kSignificandSize - 2;
+  value.e -= kDiyFpSize - kSignificandSize - 2;
+  return value;
+}
+
+// Computes the boundaries m- and m+ halfway to the neighboring doubles, with the same exponent.
+void normalizedBoundaries(const DiyFp& value, DiyFp* minus, DiyFp* plus) noexcept {
+  *plus = normalizeBoundary({(value.f << 1) + 1, value.e - 1});
+  *minus = value.f == kHiddenBit ? DiyFp{(value.f << 2) - 1, value.e - 2}
+                                 : DiyFp{(value.f << 1) - 1, value.e - 1};
+  minus->f <<= minus->e - plus->e;
+  minus->e = plus->e;
+}
+
+// Normalized powers 10^k for k = -348, -340, ..., 340.
+constexpr DiyFp kCachedPowers[] = {
+    {0xfa8fd5a0081c0288ull, -1220},
+    {0xbaaee17fa23ebf76ull, -1193},
+    {0x8b16fb203055ac76ull, -1166},
+    {0xcf42894a5dce35eaull, -1140},
+    {0x9a6bb0aa55653b2dull, -1113},
+    {0xe61acf033d1a45dfull, -1087},
+    {0xab70fe17c79ac6caull, -1060},
+    {0xff77b1fcbebcdc4full, -1034},
+    {0xbe5691ef416bd60cull, -1007},
+    {0x8dd01fad907ffc3cull, -980},
+    {0xd3515c2831559a83ull, -954},
+    {0x9d71ac8fada6c9b5ull, -927},
+    {0xea9c227723ee8bcbull, -901},
+    {0xaecc49914078536dull, -874},
+    {0x823c12795db6ce57ull, -847},
+    {0xc21094364dfb5637ull, -821},
+    {0x9096ea6f3848984full, -794},
+    {0xd77485cb25823ac7ull, -768},
+    {0xa086cfcd97bf97f4ull, -741},
+    {0xef340a98172aace5ull, -715},
+    {0xb23867fb2a35b28eull, -688},
+    {0x84c8d4dfd2c63f3bull, -661},
+    {0xc5dd44271ad3cdbaull, -635},
+    {0x936b9fcebb25c996ull, -608},
+    {0xdbac6c247d62a584ull, -582},
+    {0xa3ab66580d5fdaf6ull, -555},
+    {0xf3e2f893dec3f126ull, -529},
+    {0xb5b5ada8aaff80b8ull, -502},
+    {0x87625f056c7c4a8bull, -475},
+    {0xc9bcff6034c13053ull, -449},
+    {0x964e858c91ba2655ull, -422},
+    {0xdff9772470297ebdull, -396},
+    {0xa6dfbd9fb8e5b88full, -369},
+    {0xf8a95fcf88747d94ull, -343},
+    {0xb94470938fa89bcfull, -316},
+    {0x8a08f0f8bf0f156bull, -289},
+    {0xcdb02555653131b6ull, -263},
+    {0x993fe2c6d07b7facull, -236},
+    {0xe45c10c42a2b3b06ull, -210},
+    {0xaa242499697392d3ull, -183},
+    {0xfd87b5f28300ca0eull, -157},
+    {0xbce5086492111aebull, -130},
+    {0x8cbccc096f5088ccull, -103},
+    {0xd1b71758e219652cull, -77},
+    {0x9c40000000000000ull, -50},
+    {0xe8d4a51000000000ull, -24},
+    {0xad78ebc5ac620000ull, 3},
+    {0x813f3978f8940984ull, 30},
+    {0xc097ce7bc90715b3ull, 56},
+    {0x8f7e32ce7bea5c70ull, 83},
+    {0xd5d238a4abe98068ull, 109},
+    {0x9f4f2726179a2245ull, 136},
+    {0xed63a231d4c4fb27ull, 162},
+    {0xb0de65388cc8ada8ull, 189},
+    {0x83c7088e1aab65dbull, 216},
+    {0xc45d1df942711d9aull, 242},
+    {0x924d692ca61be758ull, 269},
+    {0xda01ee641a708deaull, 295},
+    {0xa26da3999aef774aull, 322},
+    {0xf209787bb47d6b85ull, 348},
+    {0xb454e4a179dd1877ull, 375},
+    {0x865b86925b9bc5c2ull, 402},
+    {0xc83553c5c8965d3dull, 428},
+    {0x952ab45cfa97a0b3ull, 455},
+    {0xde469fbd99a05fe3ull, 481},
+    {0xa59bc234db398c25ull, 508},
+    {0xf6c69a72a3989f5cull, 534},
+    {0xb7dcbf5354e9beceull, 561},
+    {0x88fcf317f22241e2ull, 588},
+    {0xcc20ce9bd35c78a5ull, 614},
+    {0x98165af37b2153dfull, 641},
+    {0xe2a0b5dc971f303aull, 667},
+    {0xa8d9d1535ce3b396ull, 694},
+    {0xfb9b7cd9a4a7443cull, 720},
+    {0xbb764c4ca7a44410ull, 747},
+    {0x8bab8eefb6409c1aull, 774},
+    {0xd01fef10a657842cull, 800},
+    {0x9b10a4e5e9913129ull, 827},
+    {0xe7109bfba19c0c9dull, 853},
+    {0xac2820d9623bf429ull, 880},
+    {0x80444b5e7aa7cf85ull, 907},
+    {0xbf21e44003acdd2dull, 933},
+    {0x8e679c2f5e44ff8full, 960},
+    {0xd433179d9c8cb841ull, 986},
+    {0x9e19db92b4e31ba9ull, 1013},
+    {0xeb96bf6ebadf77d9ull, 1039},
+    {0xaf87023b9bf0ee6bull, 1066}
+};
+
+constexpr int kCachedPowersMinExponent = -348;
+constexpr int kCachedPowersExponentStep = 8;
+
+// Returns a cached power c = 10^-k, whose binary exponent brings value.e into [-60, -32].
+DiyFp cachedPower(int e, int* k) noexcept {
+  // 1 / log2(10)
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int exponent = static_cast<int>(dk);
+  if (dk - exponent > 0.0) {
+    exponent++;
+  }
+  unsigned index = static_cast<unsigned>((exponent >> 3) + 1);
+  *k = -(kCachedPowersMinExponent + static_cast<int>(index) * kCachedPowersExponentStep);
+  return kCachedPowers[index];
+}
+
+constexpr uint64_t kPowersOf10[] = {1ull,
+                                    10ull,
+                                    100ull,
+                                    1000ull,
+                                    10000ull,
+                                    100000ull,
+                                    1000000ull,
+                                    10000000ull,
+                                    100000000ull,
+                                    1000000000ull,
+                                    10000000000ull,
+                                    100000000000ull,
+                                    1000000000000ull,
+                                    10000000000000ull,
+                                    100000000000000ull,
+                                    1000000000000000ull,
+                                    10000000000000000ull,
+                                    100000000000000000ull,
+                                    1000000000000000000ull,
+                                    10000000000000000000ull};
+
+int countDecimalDigits(uint32_t value) noexcept {
+  int digits = 1;
+  while (digits < 10 && value >= kPowersOf10[digits]) {
+    digits++;
+  }
+  return digits;
+}
+
+// Moves the last digit towards w while staying inside the unsafe interval.
+void roundWeed(char* buffer,
+               int length,
+               uint64_t delta,
+               uint64_t rest,
+               uint64_t ten_kappa,
+               uint64_t wp_w) noexcept {
+  while (rest < wp_w && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+    buffer[length - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+// Generates the shortest digits of Mp that stay within delta of it.
+void generateDigits(const DiyFp& w,
+                    const DiyFp& mp,
+                    uint64_t delta,
+                    char* buffer,
+                    int* length,
+                    int* k) noexcept {
+  const DiyFp one{1ull << -mp.e, mp.e};
+  const DiyFp wp_w = subtract(mp, w);
+  auto p1 = static_cast<uint32_t>(mp.f >> -one.e);
+  uint64_t p2 = mp.f & (one.f - 1);
+  int kappa = countDecimalDigits(p1);
+  *length = 0;
+
+  while (kappa > 0) {
+    uint32_t digit = p1 / static_cast<uint32_t>(kPowersOf10[kappa - 1]);
+    p1 %= static_cast<uint32_t>(kPowersOf10[kappa - 1]);
+    if (digit != 0 || *length != 0) {
+      buffer[(*length)++] = static_cast<char>('0' + digit);
+    }
+    kappa--;
+    uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+    if (rest <= delta) {
+      *k += kappa;
+      roundWeed(buffer, *length, delta, rest, kPowersOf10[kappa] << -one.e, wp_w.f);
+      return;
+    }
+  }
+
+  while (true) {
+    p2 *= 10;
+    delta *= 10;
+    auto digit = static_cast<char>(p2 >> -one.e);
+    if (digit != 0 || *length != 0) {
+      buffer[(*length)++] = static_cast<char>('0' + digit);
+    }
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *k += kappa;
+      int index = -kappa;
+      roundWeed(buffer, *length, delta, p2, one.f, index < 20 ? wp_w.f * kPowersOf10[index] : 0);
+      return;
+    }
+  }
+}
+
+// Writes the digits of a positive, finite value. The value equals digits * 10^k.
+void grisu2(double value, char* buffer, int* length, int* k) noexcept {
+  const DiyFp v = fromDouble(value);
+  DiyFp w_minus, w_plus;
+  normalizedBoundaries(v, &w_minus, &w_plus);
+
+  const DiyFp c_mk = cachedPower(w_plus.e, k);
+  const DiyFp w = multiply(normalize(v), c_mk);
+  DiyFp wp = multiply(w_plus, c_mk);
+  DiyFp wm = multiply(w_minus, c_mk);
+  wm.f++;
+  wp.f--;
+  generateDigits(w, wp, wp.f - wm.f, buffer, length, k);
+}
+
+char* writeExponent(int exponent, char* buffer) noexcept {
+  if (exponent < 0) {
+    *buffer++ = '-';
+    exponent = -exponent;
+  }
+  if (exponent >= 100) {
+    *buffer++ = static_cast<char>('0' + exponent / 100);
+    exponent %= 100;
+    *buffer++ = static_cast<char>('0' + exponent / 10);
+  } else if (exponent >= 10) {
+    *buffer++ = static_cast<char>('0' + exponent / 10);
+  }
+  *buffer++ = static_cast<char>('0' + exponent % 10);
+  return buffer;
+}
+
+// Formats digits * 10^k in fixed notation for moderate exponents, and in scientific notation
+// otherwise.
+char* prettify(char* buffer, int length, int k) noexcept {
+  const int point = length + k;  // Position of the decimal point relative to the digits.
+
+  if (length <= point && point <= 21) {
+    // 1234e5 -> 123400000
+    std::memset(buffer + length, '0', static_cast<size_t>(k));
+    return buffer + point;
+  }
+  if (0 < point && point <= 21) {
+    // 1234e-2 -> 12.34
+    std::memmove(buffer + point + 1, buffer + point, static_cast<size_t>(length - point));
+    buffer[point] = '.';
+    return buffer + length + 1;
+  }
+  if (-6 < point && point <= 0) {
+    // 1234e-6 -> 0.001234
+    const int offset = 2 - point;
+    std::memmove(buffer + offset, buffer, static_cast<size_t>(length));
+    buffer[0] = '0';
+    buffer[1] = '.';
+    std::memset(buffer + 2, '0', static_cast<size_t>(offset - 2));
+    return buffer + length + offset;
+  }
+  if (length == 1) {
+    // 1e30
+    buffer[1] = 'e';
+    return writeExponent(point - 1, buffer + 2);
+  }
+  // 1234e30 -> 1.234e33
+  std::memmove(buffer + 2, buffer + 1, static_cast<size_t>(length - 1));
+  buffer[1] = '.';
+  buffer[length + 1] = 'e';
+  return writeExponent(point - 1, buffer + length + 2);
+}
+
+}  // anonymous namespace
+
+char* formatDouble(double value, char* buffer) noexcept {
+  if (std::isnan(value)) {
+    std::memcpy(buffer, "nan", 3);
+    return buffer + 3;
+  }
+  if (std::signbit(value)) {
+    *buffer++ = '-';
+    value = -value;
+  }
+  if (std::isinf(value)) {
+    std::memcpy(buffer, "inf", 3);
+    return buffer + 3;
+  }
+  if (value == 0.0) {
+    *buffer = '0';
+    return buffer + 1;
+  }
+  int length = 0;
+  int k = 0;
+  grisu2(value, buffer, &length, &k);
+  return prettify(buffer, length, k);
+}
+
+char* formatUInt64(uint64_t value, char* buffer) noexcept {
+  char digits[kMaxUInt64Length];
+  size_t length = 0;
+  do {
+    digits[length++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (length > 0) {
+    *buffer++ = digits[--length];
+  }
+  return buffer;
+}
+
+}  // namespace franka
@@ -0,0 +1,44 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace franka {
+
+/**
+ * Maximum number of characters written by formatDouble().
+ */
+constexpr size_t kMaxDoubleLength = 25;
+
+/**
+ * Maximum number of characters written by formatUInt64().
+ */
+constexpr size_t kMaxUInt64Length = 20;
+
+/**
+ * Writes the shortest decimal representation of a double that parses back to the same value.
+ *
+ * Uses the Grisu2 algorithm, which finds the shortest representation for almost all values and a
+ * correctly round-tripping one for all others. Does not allocate and does not depend on the
+ * locale. Non-finite values are written as `nan`, `inf` and `-inf`.
+ *
+ * @param[in] value Value to write.
+ * @param[out] buffer Buffer for at least kMaxDoubleLength characters. No terminator is written.
+ *
+ * @return Pointer past the last written character.
+ */
+char* formatDouble(double value, char* buffer) noexcept;
+
+/**
+ * Writes an unsigned integer in decimal.
+ *
+ * @param[in] value Value to write.
+ * @param[out] buffer Buffer for at least kMaxUInt64Length characters. No terminator is written.
+ *
+ * @return Pointer past the last written character.
+ */
+char* formatUInt64(uint64_t value, char* buffer) noexcept;
+
+}  // namespace franka
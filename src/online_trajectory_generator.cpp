@@ -0,0 +1,198 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/online_trajectory_generator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace franka {
+
+namespace {
+
+// Enough bisection steps to resolve the peak velocity to a few nanoradians per second. The motion is
+// replanned in every cycle, so that the remaining error is corrected anyway.
+constexpr int kBisectionSteps = 32;
+
+struct Motion {
+  double position;
+  double velocity;
+  double acceleration;
+};
+
+struct Limits {
+  double velocity;
+  double acceleration;
+  double jerk;
+};
+
+struct Segment {
+  double jerk;
+  double duration;
+};
+
+// Motion after applying a constant jerk for the given time.
+inline Motion integrate(const Motion& motion, double jerk, double time) noexcept {
+  return {motion.position +
+              time * (motion.velocity + time * (motion.acceleration / 2 + time * jerk / 6)),
+          motion.velocity + time * (motion.acceleration + time * jerk / 2),
+          motion.acceleration + time * jerk};
+}
+
+// Motion at the end of the segments.
+template <size_t N>
+Motion integrate(Motion motion, const std::array<Segment, N>& segments) noexcept {
+  for (const Segment& segment : segments) {
+    motion = integrate(motion, segment.jerk, segment.duration);
+  }
+  return motion;
+}
+
+// Motion after following the segments for the given time, continuing with zero jerk after them.
+template <size_t N>
+Motion integrate(Motion motion, const std::array<Segment, N>& segments, double time) noexcept {
+  for (const Segment& segment : segments) {
+    double duration = std::min(segment.duration, time);
+    motion = integrate(motion, segment.jerk, duration);
+    time -= duration;
+  }
+  return integrate(motion, 0.0, time);
+}
+
+// Segments that bring the velocity to the target velocity and the acceleration to zero as fast as
+// possible: the acceleration is pushed towards a peak with maximum jerk, possibly held at the
+// acceleration limit and brought back to zero with maximum jerk.
+std::array<Segment, 3> changeVelocity(const Motion& motion,
+                                      double target_velocity,
+                                      const Limits& limits) noexcept {
+  // The velocity reached by only bringing the acceleration to zero decides the direction. Changes
+  // in negative direction are mirrored.
+  double resting_velocity =
+      motion.velocity + motion.acceleration * std::abs(motion.acceleration) / (2 * limits.jerk);
+  double direction = resting_velocity <= target_velocity ? 1.0 : -1.0;
+  double velocity_change = direction * (target_velocity - motion.velocity);
+  double acceleration =
+      std::max(-limits.acceleration, std::min(direction * motion.acceleration, limits.acceleration));
+
+  double peak_acceleration =
+      std::sqrt(std::max(limits.jerk * velocity_change + acceleration * acceleration / 2, 0.0));
+  double hold_time = 0.0;
+  if (peak_acceleration > limits.acceleration) {
+    peak_acceleration = limits.acceleration;
+    hold_time = (velocity_change + acceleration * acceleration / (2 * limits.jerk)) /
+                    limits.acceleration -
+                limits.acceleration / limits.jerk;
+  }
+  return {{{direction * limits.jerk, std::max((peak_acceleration - acceleration) / limits.jerk, 0.0)},
+           {0.0, hold_time},
+           {-direction * limits.jerk, peak_acceleration / limits.jerk}}};
+}
+
+// Segments of the time-optimal motion to rest at the target position: the velocity is changed to a
+// peak velocity, possibly held at the velocity limit and brought back to zero. The peak velocity is
+// found by bisection, as the distance covered grows with it.
+std::array<Segment, 7> moveToPosition(const Motion& motion,
+                                      double target_position,
+                                      const Limits& limits) noexcept {
+  auto profile = [&](double peak_velocity, double cruise_time) {
+    std::array<Segment, 3> change = changeVelocity(motion, peak_velocity, limits);
+    std::array<Segment, 3> stop = changeVelocity({0.0, peak_velocity, 0.0}, 0.0, limits);
+    return std::array<Segment, 7>{
+        {change[0], change[1], change[2], {0.0, cruise_time}, stop[0], stop[1], stop[2]}};
+  };
+
+  // Braking right away decides the direction. Motions in negative direction are mirrored.
+  double stop_position = integrate(motion, changeVelocity(motion, 0.0, limits)).position;
+  double direction = target_position >= stop_position ? 1.0 : -1.0;
+  auto overshoot = [&](double peak_speed) {
+    return direction *
+           (integrate(motion, profile(direction * peak_speed, 0.0)).position - target_position);
+  };
+
+  double max_overshoot = overshoot(limits.velocity);
+  if (max_overshoot <= 0.0) {
+    return profile(direction * limits.velocity, -max_overshoot / limits.velocity);
+  }
+  double lower = 0.0;
+  double upper = limits.velocity;
+  for (int i = 0; i < kBisectionSteps; i++) {
+    double middle = (lower + upper) / 2;
+    if (overshoot(middle) < 0.0) {
+      lower = middle;
+    } else {
+      upper = middle;
+    }
+  }
+  return profile(direction * lower, 0.0);
+}
+
+}  // anonymous namespace
+
+OnlineTrajectoryGenerator::OnlineTrajectoryGenerator(const std::array<double, 7>& max_velocity,
+                                                     const std::array<double, 7>& max_acceleration,
+                                                     const std::array<double, 7>& max_jerk,
+                                                     double delta_t)
+    : max_velocity_(max_velocity),
+      max_acceleration_(max_acceleration),
+      max_jerk_(max_jerk),
+      delta_t_(delta_t) {
+  auto valid = [](double value) { return std::isfinite(value) && value > 0.0; };
+  if (!valid(delta_t) || !std::all_of(max_velocity.begin(), max_velocity.end(), valid) ||
+      !std::all_of(max_acceleration.begin(), max_acceleration.end(), valid) ||
+      !std::all_of(max_jerk.begin(), max_jerk.end(), valid)) {
+    throw std::invalid_argument(
+        "libfranka: Online trajectory generator limits and time step must be positive.");
+  }
+}
+
+std::array<double, 7> OnlineTrajectoryGenerator::nextPosition(
+    const std::array<double, 7>& target_position,
+    const std::array<double, 7>& last_commanded_position,
+    const std::array<double, 7>& last_commanded_velocity,
+    const std::array<double, 7>& last_commanded_acceleration) noexcept {
+  if (!has_state_ || last_commanded_position != last_command_) {
+    position_ = last_commanded_position;
+    velocity_ = last_commanded_velocity;
+    acceleration_ = last_commanded_acceleration;
+    has_state_ = true;
+  }
+
+  for (size_t i = 0; i < 7; i++) {
+    Limits limits{max_velocity_[i], max_acceleration_[i], max_jerk_[i]};
+    Motion motion{position_[i], velocity_[i], acceleration_[i]};
+    motion = integrate(motion, moveToPosition(motion, target_position[i], limits), delta_t_);
+    position_[i] = motion.position;
+    velocity_[i] = motion.velocity;
+    acceleration_[i] = motion.acceleration;
+  }
+  last_command_ = position_;
+  return position_;
+}
+
+std::array<double, 7> OnlineTrajectoryGenerator::nextVelocity(
+    const std::array<double, 7>& target_velocity,
+    const std::array<double, 7>& last_commanded_velocity,
+    const std::array<double, 7>& last_commanded_acceleration) noexcept {
+  if (!has_state_ || last_commanded_velocity != last_command_) {
+    velocity_ = last_commanded_velocity;
+    acceleration_ = last_commanded_acceleration;
+    has_state_ = true;
+  }
+
+  for (size_t i = 0; i < 7; i++) {
+    Limits limits{max_velocity_[i], max_acceleration_[i], max_jerk_[i]};
+    Motion motion{0.0, velocity_[i], acceleration_[i]};
+    double target = std::max(-limits.velocity, std::min(target_velocity[i], limits.velocity));
+    motion = integrate(motion, changeVelocity(motion, target, limits), delta_t_);
+    velocity_[i] = motion.velocity;
+    acceleration_[i] = motion.acceleration;
+  }
+  last_command_ = velocity_;
+  return velocity_;
+}
+
+void OnlineTrajectoryGenerator::reset() noexcept {
+  has_state_ = false;
+}
+
+}  // namespace franka
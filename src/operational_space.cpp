@@ -0,0 +1,102 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/operational_space.h>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+#include "operational_space_calculations.h"
+
+namespace franka {
+
+namespace {
+
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Matrix7d = Eigen::Matrix<double, 7, 7>;
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Matrix7x6d = Eigen::Matrix<double, 7, 6>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+}  // anonymous namespace
+
+bool computeOperationalSpace(const std::array<double, 49>& mass,
+                             const std::array<double, 42>& zero_jacobian,
+                             std::array<double, 36>* lambda,
+                             std::array<double, 42>* jacobian_pseudoinverse,
+                             std::array<double, 49>* mass_inverse) noexcept {
+  Eigen::LLT<Matrix7d> mass_llt(Eigen::Map<const Matrix7d>(mass.data()));
+  if (mass_llt.info() != Eigen::Success) {
+    return false;
+  }
+  Eigen::Map<const Matrix6x7d> jacobian(zero_jacobian.data());
+  Matrix7x6d mass_inverse_jacobian_transpose = mass_llt.solve(jacobian.transpose());
+
+  Eigen::LLT<Matrix6d> lambda_inverse_llt(jacobian * mass_inverse_jacobian_transpose);
+  if (lambda_inverse_llt.info() != Eigen::Success) {
+    return false;
+  }
+
+  Eigen::Map<Matrix6d> lambda_matrix(lambda->data());
+  lambda_matrix = lambda_inverse_llt.solve(Matrix6d::Identity());
+  Eigen::Map<Matrix7x6d>(jacobian_pseudoinverse->data()) =
+      mass_inverse_jacobian_transpose * lambda_matrix;
+  if (mass_inverse != nullptr) {
+    Eigen::Map<Matrix7d>(mass_inverse->data()) = mass_llt.solve(Matrix7d::Identity());
+  }
+  return true;
+}
+
+bool OperationalSpace::update(const std::array<double, 49>& mass,
+                              const std::array<double, 42>& zero_jacobian) noexcept {
+  if (!computeOperationalSpace(mass, zero_jacobian, &lambda_, &jacobian_pseudoinverse_,
+                               &mass_inverse_)) {
+    return false;
+  }
+  zero_jacobian_ = zero_jacobian;
+  Eigen::Map<const Matrix6x7d> jacobian(zero_jacobian_.data());
+  Eigen::Map<const Matrix7x6d> jacobian_pseudoinverse(jacobian_pseudoinverse_.data());
+  Eigen::Map<Matrix7d>(nullspace_projector_.data()) =
+      Matrix7d::Identity() - jacobian.transpose() * jacobian_pseudoinverse.transpose();
+  return true;
+}
+
+bool OperationalSpace::update(const DynamicsBundle& dynamics) noexcept {
+  return update(dynamics.mass, dynamics.zero_jacobian);
+}
+
+const std::array<double, 49>& OperationalSpace::massInverse() const noexcept {
+  return mass_inverse_;
+}
+
+const std::array<double, 36>& OperationalSpace::lambda() const noexcept {
+  return lambda_;
+}
+
+const std::array<double, 42>& OperationalSpace::jacobianPseudoinverse() const noexcept {
+  return jacobian_pseudoinverse_;
+}
+
+const std::array<double, 49>& OperationalSpace::nullspaceProjector() const noexcept {
+  return nullspace_projector_;
+}
+
+std::array<double, 7> OperationalSpace::projectToNullspace(
+    const std::array<double, 7>& tau) const noexcept {
+  std::array<double, 7> output;
+  Eigen::Map<Vector7d>(output.data()) =
+      Eigen::Map<const Matrix7d>(nullspace_projector_.data()) *
+      Eigen::Map<const Vector7d>(tau.data());
+  return output;
+}
+
+std::array<double, 7> OperationalSpace::jacobianTransposeTimes(
+    const std::array<double, 6>& wrench) const noexcept {
+  std::array<double, 7> output;
+  Eigen::Map<Vector7d>(output.data()) =
+      Eigen::Map<const Matrix6x7d>(zero_jacobian_.data()).transpose() *
+      Eigen::Map<const Vector6d>(wrench.data());
+  return output;
+}
+
+}  // namespace franka
@@ -0,0 +1,31 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+
+namespace franka {
+
+/**
+ * Computes the operational space inertia matrix \f$\Lambda = (J M^{-1} J^T)^{-1}\f$ and the
+ * dynamically consistent Jacobian pseudoinverse \f$\bar{J} = M^{-1} J^T \Lambda\f$, factorizing
+ * the mass matrix only once. Used by Model::dynamics() and OperationalSpace.
+ *
+ * All matrices are vectorized in column-major format.
+ *
+ * @param[in] mass 7x7 mass matrix.
+ * @param[in] zero_jacobian 6x7 Jacobian.
+ * @param[out] lambda 6x6 operational space inertia matrix.
+ * @param[out] jacobian_pseudoinverse 7x6 dynamically consistent pseudoinverse.
+ * @param[out] mass_inverse If given, the 7x7 inverse mass matrix.
+ *
+ * @return False if the mass matrix or \f$J M^{-1} J^T\f$ is not positive definite. In that case,
+ * no output is written.
+ */
+bool computeOperationalSpace(const std::array<double, 49>& mass,
+                             const std::array<double, 42>& zero_jacobian,
+                             std::array<double, 36>* lambda,
+                             std::array<double, 42>* jacobian_pseudoinverse,
+                             std::array<double, 49>* mass_inverse = nullptr) noexcept;
+
+}  // namespace franka
@@ -0,0 +1,90 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/passivity_controller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <franka/rate_limiting.h>
+
+namespace franka {
+
+namespace {
+
+bool isNonNegativeAndFinite(double value) {
+  return value >= 0 && std::isfinite(value);
+}
+
+template <typename T, size_t N>
+void streamArray(std::ostream& ostream, const std::array<T, N>& array) {
+  ostream << "[";
+  for (size_t i = 0; i < N; i++) {
+    ostream << (i > 0 ? ", " : "") << array[i];
+  }
+  ostream << "]";
+}
+
+}  // anonymous namespace
+
+PassivityController::PassivityController(const PassivityControllerParameters& parameters)
+    : parameters_(parameters) {
+  if (!isNonNegativeAndFinite(parameters.min_velocity) ||
+      !std::all_of(parameters.max_damping.begin(), parameters.max_damping.end(),
+                   isNonNegativeAndFinite)) {
+    throw std::invalid_argument(
+        "libfranka: Passivity controller parameters must be non-negative and finite.");
+  }
+}
+
+std::array<double, 7> PassivityController::control(const std::array<double, 7>& tau,
+                                                   const std::array<double, 7>& tau_J_d,
+                                                   const std::array<double, 7>& dq,
+                                                   Duration time_step) noexcept {
+  const double dt = time_step.toSec();
+  statistics_.cycles++;
+
+  std::array<double, 7> output = tau;
+  for (size_t i = 0; i < 7; i++) {
+    // Observe the energy of the last cycle, during which tau_J_d was applied.
+    double energy = statistics_.observed_energy[i] - tau_J_d[i] * dq[i] * dt;
+
+    // Predict the energy after the next cycle with the new command.
+    double predicted_energy = energy - tau[i] * dq[i] * kDeltaT;
+    double dq_squared = dq[i] * dq[i];
+    if (predicted_energy < 0 && std::abs(dq[i]) > parameters_.min_velocity) {
+      double damping = std::min(-predicted_energy / (dq_squared * kDeltaT),
+                                parameters_.max_damping[i]);
+      output[i] -= damping * dq[i];
+      statistics_.dissipated_energy[i] += damping * dq_squared * kDeltaT;
+      statistics_.active_cycles[i]++;
+    }
+    statistics_.observed_energy[i] = energy;
+  }
+  return output;
+}
+
+void PassivityController::reset() noexcept {
+  statistics_.observed_energy.fill(0);
+}
+
+void PassivityController::resetStatistics() noexcept {
+  statistics_ = PassivityStatistics{};
+}
+
+const PassivityStatistics& PassivityController::statistics() const noexcept {
+  return statistics_;
+}
+
+std::ostream& operator<<(std::ostream& ostream, const PassivityStatistics& statistics) {
+  ostream << "{\"cycles\": " << statistics.cycles << ", \"observed_energy\": ";
+  streamArray(ostream, statistics.observed_energy);
+  ostream << ", \"dissipated_energy\": ";
+  streamArray(ostream, statistics.dissipated_energy);
+  ostream << ", \"active_cycles\": ";
+  streamArray(ostream, statistics.active_cycles);
+  ostream << "}";
+  return ostream;
+}
+
+}  // namespace franka
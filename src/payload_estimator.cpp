@@ -0,0 +1,139 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/payload_estimator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace franka {
+
+namespace {
+
+bool isPositiveAndFinite(double value) {
+  return value > 0 && std::isfinite(value);
+}
+
+}  // anonymous namespace
+
+PayloadEstimator::PayloadEstimator(const PayloadEstimatorParameters& parameters)
+    : parameters_(parameters) {
+  if (!(parameters.forgetting_factor > 0 && parameters.forgetting_factor <= 1) ||
+      !isPositiveAndFinite(parameters.initial_variance) ||
+      !isPositiveAndFinite(parameters.max_joint_velocity) ||
+      !(parameters.min_mass >= 0 && std::isfinite(parameters.min_mass))) {
+    throw std::invalid_argument("libfranka: Invalid payload estimator parameters.");
+  }
+  reset();
+}
+
+void PayloadEstimator::update(
+    const std::array<double, 7>& tau_load,
+    const std::array<double, 16>& O_T_F,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 42>& O_J_F,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& gravity_earth) noexcept {
+  // Forget old samples, but stop inflating the covariance while the parameters are not excited,
+  // e.g. while the robot rests in one configuration.
+  double max_variance = 0;
+  for (size_t i = 0; i < 4; i++) {
+    max_variance = std::max(max_variance, covariance_[i * 5]);
+  }
+  if (max_variance < parameters_.initial_variance) {
+    for (double& value : covariance_) {
+      value /= parameters_.forgetting_factor;
+    }
+  }
+
+  const std::array<double, 3>& g = gravity_earth;
+  for (size_t joint = 0; joint < 7; joint++) {
+    const double* jacobian = &O_J_F[joint * 6];
+
+    // The load exerts the wrench [m g; (R x) × m g] on the flange, which the joints compensate
+    // with tau = -J^T wrench. Row of the regressor in theta_ = [m, m x]:
+    // [-J_v^T g, R^T (J_w × g)].
+    std::array<double, 4> phi{};
+    phi[0] = -(jacobian[0] * g[0] + jacobian[1] * g[1] + jacobian[2] * g[2]);
+    std::array<double, 3> moment{{jacobian[4] * g[2] - jacobian[5] * g[1],
+                                  jacobian[5] * g[0] - jacobian[3] * g[2],
+                                  jacobian[3] * g[1] - jacobian[4] * g[0]}};
+    for (size_t column = 0; column < 3; column++) {
+      phi[column + 1] = O_T_F[column * 4] * moment[0] + O_T_F[column * 4 + 1] * moment[1] +
+                        O_T_F[column * 4 + 2] * moment[2];
+    }
+
+    // Scalar recursive least squares step with unit measurement variance.
+    std::array<double, 4> p_phi{};
+    double prediction = 0;
+    for (size_t row = 0; row < 4; row++) {
+      for (size_t column = 0; column < 4; column++) {
+        p_phi[row] += covariance_[column * 4 + row] * phi[column];
+      }
+      prediction += phi[row] * theta_[row];
+    }
+    double innovation_variance = 1;
+    for (size_t row = 0; row < 4; row++) {
+      innovation_variance += phi[row] * p_phi[row];
+    }
+    double error = tau_load[joint] - prediction;
+    for (size_t row = 0; row < 4; row++) {
+      double gain = p_phi[row] / innovation_variance;
+      theta_[row] += gain * error;
+      for (size_t column = 0; column < 4; column++) {
+        covariance_[column * 4 + row] -= gain * p_phi[column];
+      }
+    }
+  }
+  sample_count_++;
+}
+
+bool PayloadEstimator::update(const Model& model, const RobotState& robot_state) {
+  for (double velocity : robot_state.dq) {
+    if (!(std::abs(velocity) <= parameters_.max_joint_velocity)) {
+      return false;
+    }
+  }
+
+  std::array<double, 7> tau_load = model.gravity(robot_state.q, robot_state.m_ee,
+                                                  robot_state.F_x_Cee, robot_state.O_ddP_O);
+  for (size_t i = 0; i < tau_load.size(); i++) {
+    tau_load[i] = robot_state.tau_J[i] - tau_load[i];
+  }
+  update(tau_load, model.pose(Frame::kFlange, robot_state),
+         model.zeroJacobian(Frame::kFlange, robot_state), robot_state.O_ddP_O);
+  return true;
+}
+
+void PayloadEstimator::apply(Robot& robot, const std::array<double, 9>& load_inertia) const {
+  robot.setLoad(mass(), F_x_Cload(), load_inertia);
+}
+
+void PayloadEstimator::reset() noexcept {
+  theta_.fill(0);
+  covariance_.fill(0);
+  for (size_t i = 0; i < 4; i++) {
+    covariance_[i * 5] = parameters_.initial_variance;
+  }
+  sample_count_ = 0;
+}
+
+double PayloadEstimator::mass() const noexcept {
+  return std::max(theta_[0], 0.0);
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+std::array<double, 3> PayloadEstimator::F_x_Cload() const noexcept {
+  if (!(theta_[0] >= parameters_.min_mass) || theta_[0] == 0) {
+    return {};
+  }
+  return {{theta_[1] / theta_[0], theta_[2] / theta_[0], theta_[3] / theta_[0]}};
+}
+
+double PayloadEstimator::massVariance() const noexcept {
+  return covariance_[0];
+}
+
+size_t PayloadEstimator::sampleCount() const noexcept {
+  return sample_count_;
+}
+
+}  // namespace franka
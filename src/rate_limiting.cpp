@@ -10,6 +10,53 @@ namespace franka {
 
 namespace {
 
+template <size_t N>
+bool allFinite(const std::array<double, N>& values) noexcept {
+  // Accumulate without short-circuiting, so that the check compiles to a single branch.
+  bool finite = true;
+  for (double value : values) {
+    finite &= std::isfinite(value);
+  }
+  return finite;
+}
+
+/**
+ * Rate limits the commanded velocities of all joints at once.
+ *
+ * Evaluates the same operations in the same order as the scalar limitRate for velocities, so the
+ * results are bit-identical. The loop body is free of branches, which lets the compiler vectorize
+ * it for the target instruction set (e.g. SSE2/AVX on x86-64 or NEON on ARM).
+ */
+void limitJointVelocities(const std::array<double, 7>& max_velocity,
+                          const std::array<double, 7>& max_acceleration,
+                          const std::array<double, 7>& max_jerk,
+                          const std::array<double, 7>& commanded_velocities,
+                          const std::array<double, 7>& last_commanded_velocities,
+                          const std::array<double, 7>& last_commanded_accelerations,
+                          std::array<double, 7>* limited_velocities) noexcept {
+  for (size_t i = 0; i < 7; i++) {
+    double commanded_jerk =
+        (((commanded_velocities[i] - last_commanded_velocities[i]) / kDeltaT) -
+         last_commanded_accelerations[i]) /
+        kDeltaT;
+    double commanded_acceleration =
+        last_commanded_accelerations[i] +
+        std::max(std::min(commanded_jerk, max_jerk[i]), -max_jerk[i]) * kDeltaT;
+    double safe_max_acceleration =
+        std::min((max_jerk[i] / max_acceleration[i]) *
+                     (max_velocity[i] - last_commanded_velocities[i]),
+                 max_acceleration[i]);
+    double safe_min_acceleration =
+        std::max((max_jerk[i] / max_acceleration[i]) *
+                     (-max_velocity[i] - last_commanded_velocities[i]),
+                 -max_acceleration[i]);
+    (*limited_velocities)[i] =
+        last_commanded_velocities[i] +
+        std::max(std::min(commanded_acceleration, safe_max_acceleration), safe_min_acceleration) *
+            kDeltaT;
+  }
+}
+
 Eigen::Vector3d limitRate(double max_velocity,
                           double max_acceleration,
                           double max_jerk,
@@ -59,11 +106,10 @@ Eigen::Vector3d limitRate(double max_velocity,
 std::array<double, 7> limitRate(const std::array<double, 7>& max_derivatives,
                                 const std::array<double, 7>& commanded_values,
                                 const std::array<double, 7>& last_commanded_values) {
-  if (!std::all_of(commanded_values.begin(), commanded_values.end(),
-                   [](double d) { return std::isfinite(d); })) {
+  if (!allFinite(commanded_values)) {
     throw std::invalid_argument("Commanding value is infinite or NaN.");
   }
-  std::array<double, 7> limited_values{};
+  std::array<double, 7> limited_values;
   for (size_t i = 0; i < 7; i++) {
     double commanded_derivative = (commanded_values[i] - last_commanded_values[i]) / kDeltaT;
     limited_values[i] =
@@ -126,17 +172,13 @@ std::array<double, 7> limitRate(const std::array<double, 7>& max_velocity,
                                 const std::array<double, 7>& commanded_velocities,
                                 const std::array<double, 7>& last_commanded_velocities,
                                 const std::array<double, 7>& last_commanded_accelerations) {
-  if (!std::all_of(commanded_velocities.begin(), commanded_velocities.end(),
-                   [](double d) { return std::isfinite(d); })) {
+  if (!allFinite(commanded_velocities)) {
     throw std::invalid_argument("commanded_velocities is infinite or NaN.");
   }
-  std::array<double, 7> limited_commanded_velocities{};
-
-  for (size_t i = 0; i < 7; i++) {
-    limited_commanded_velocities[i] =
-        limitRate(max_velocity[i], max_acceleration[i], max_jerk[i], commanded_velocities[i],
-                  last_commanded_velocities[i], last_commanded_accelerations[i]);
-  }
+  std::array<double, 7> limited_commanded_velocities;
+  limitJointVelocities(max_velocity, max_acceleration, max_jerk, commanded_velocities,
+                       last_commanded_velocities, last_commanded_accelerations,
+                       &limited_commanded_velocities);
   return limited_commanded_velocities;
 }
 
@@ -147,15 +189,20 @@ std::array<double, 7> limitRate(const std::array<double, 7>& max_velocity,
                                 const std::array<double, 7>& last_commanded_positions,
                                 const std::array<double, 7>& last_commanded_velocities,
                                 const std::array<double, 7>& last_commanded_accelerations) {
-  if (!std::all_of(commanded_positions.begin(), commanded_positions.end(),
-                   [](double d) { return std::isfinite(d); })) {
+  if (!allFinite(commanded_positions)) {
     throw std::invalid_argument("commanded_positions is infinite or NaN.");
   }
-  std::array<double, 7> limited_commanded_positions{};
+  std::array<double, 7> commanded_velocities;
+  for (size_t i = 0; i < 7; i++) {
+    commanded_velocities[i] = (commanded_positions[i] - last_commanded_positions[i]) / kDeltaT;
+  }
+  std::array<double, 7> limited_commanded_positions;
+  limitJointVelocities(max_velocity, max_acceleration, max_jerk, commanded_velocities,
+                       last_commanded_velocities, last_commanded_accelerations,
+                       &limited_commanded_positions);
   for (size_t i = 0; i < 7; i++) {
-    limited_commanded_positions[i] = limitRate(
-        max_velocity[i], max_acceleration[i], max_jerk[i], commanded_positions[i],
-        last_commanded_positions[i], last_commanded_velocities[i], last_commanded_accelerations[i]);
+    limited_commanded_positions[i] =
+        last_commanded_positions[i] + limited_commanded_positions[i] * kDeltaT;
   }
   return limited_commanded_positions;
 }
@@ -0,0 +1,78 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "record_format.h"
+
+#include <cstring>
+#include <string>
+
+#include <franka/exception.h>
+
+namespace franka {
+
+namespace {
+
+constexpr size_t kHeaderAlignment = 64;
+
+}  // anonymous namespace
+
+std::vector<char> createRecordHeader(const FieldInfo* fields,
+                                     size_t field_count,
+                                     size_t record_size) {
+  size_t header_size = sizeof(RecordFormatHeader) + field_count * sizeof(FieldDescriptor);
+  header_size = (header_size + kHeaderAlignment - 1) / kHeaderAlignment * kHeaderAlignment;
+
+  std::vector<char> header(header_size, 0);
+  RecordFormatHeader prefix{};
+  std::memcpy(prefix.magic, kRecordFormatMagic, sizeof(kRecordFormatMagic));
+  prefix.version = kRecordFormatVersion;
+  prefix.header_size = static_cast<uint32_t>(header_size);
+  prefix.record_size = static_cast<uint32_t>(record_size);
+  prefix.field_count = static_cast<uint32_t>(field_count);
+  std::memcpy(header.data(), &prefix, sizeof(prefix));
+
+  for (size_t i = 0; i < field_count; i++) {
+    FieldDescriptor descriptor{};
+    std::strncpy(descriptor.name, fields[i].name, kFieldNameSize - 1);
+    descriptor.type = static_cast<uint32_t>(fields[i].type);
+    descriptor.offset = fields[i].offset;
+    descriptor.count = fields[i].count;
+    std::memcpy(header.data() + sizeof(prefix) + i * sizeof(descriptor), &descriptor,
+                sizeof(descriptor));
+  }
+  return header;
+}
+
+std::vector<FieldInfo> readRecordHeader(const char* data, size_t size, RecordFormatHeader* header) {
+  if (size < sizeof(RecordFormatHeader) ||
+      std::memcmp(data, kRecordFormatMagic, sizeof(kRecordFormatMagic)) != 0) {
+    throw Exception("libfranka: Not a recording");
+  }
+  std::memcpy(header, data, sizeof(*header));
+  if (header->version != kRecordFormatVersion) {
+    throw Exception("libfranka: Unsupported recording version " +
+                    std::to_string(header->version));
+  }
+  if (header->header_size > size || header->record_size == 0 ||
+      sizeof(RecordFormatHeader) + header->field_count * sizeof(FieldDescriptor) >
+          header->header_size) {
+    throw Exception("libfranka: Invalid recording header");
+  }
+
+  std::vector<FieldInfo> fields;
+  for (uint32_t i = 0; i < header->field_count; i++) {
+    const char* descriptor_data = data + sizeof(RecordFormatHeader) + i * sizeof(FieldDescriptor);
+    FieldDescriptor descriptor;
+    std::memcpy(&descriptor, descriptor_data, sizeof(descriptor));
+    if (std::memchr(descriptor.name, 0, kFieldNameSize) == nullptr ||
+        descriptor.type > static_cast<uint32_t>(FieldType::kDouble) ||
+        descriptor.offset + static_cast<uint64_t>(descriptor.count) * sizeof(uint64_t) >
+            header->record_size) {
+      throw Exception("libfranka: Invalid field in recording header");
+    }
+    fields.push_back({descriptor_data, static_cast<FieldType>(descriptor.type), descriptor.offset,
+                      descriptor.count});
+  }
+  return fields;
+}
+
+}  // namespace franka
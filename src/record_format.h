@@ -0,0 +1,56 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace franka {
+
+// Self-describing file format shared by StreamingRecorder and logToBinary(). See
+// streaming_recorder.h.
+
+constexpr char kRecordFormatMagic[8] = {'F', 'R', 'A', 'N', 'K', 'R', 'E', 'C'};
+constexpr uint32_t kRecordFormatVersion = 1;
+constexpr size_t kFieldNameSize = 48;
+
+enum class FieldType : uint32_t { kUInt64 = 0, kDouble = 1 };
+
+struct FieldDescriptor {
+  char name[kFieldNameSize];
+  uint32_t type;
+  uint32_t offset;
+  uint32_t count;
+  uint32_t reserved;
+};
+static_assert(sizeof(FieldDescriptor) == 64, "Unexpected field descriptor size");
+
+struct RecordFormatHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t record_size;
+  uint32_t field_count;
+};
+static_assert(sizeof(RecordFormatHeader) == 24, "Unexpected header size");
+
+// Field of a record, consisting of count elements of the given type starting at offset.
+struct FieldInfo {
+  const char* name;
+  FieldType type;
+  uint32_t offset;
+  uint32_t count;
+};
+
+// Creates the file header for records of record_size bytes with the given fields. The header is
+// padded to a multiple of 64 bytes, so that records can be memory-mapped with aligned access.
+std::vector<char> createRecordHeader(const FieldInfo* fields,
+                                     size_t field_count,
+                                     size_t record_size);
+
+// Reads the header of a file in the record format. The names of the returned fields point into
+// data. Throws Exception if data does not start with a valid header.
+std::vector<FieldInfo> readRecordHeader(const char* data, size_t size, RecordFormatHeader* header);
+
+}  // namespace franka
@@ -2,9 +2,12 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <franka/robot.h>
 
+#include <stdexcept>
 #include <utility>
 
+#include "command_batch.h"
 #include "control_loop.h"
+#include "multi_rate_scheduler.h"
 #include "network.h"
 #include "robot_impl.h"
 
@@ -16,6 +19,28 @@ Robot::Robot(const std::string& franka_address, RealtimeConfig realtime_config,
           log_size,
           realtime_config)} {}
 
+Robot::Robot(const std::string& franka_address,
+             RealtimeConfig realtime_config,
+             const RealtimeOptions& realtime_options,
+             size_t log_size,
+             LogFields log_fields,
+             const LogCompression& log_compression)
+    : impl_{new Robot::Impl(
+          std::make_unique<Network>(franka_address, research_interface::robot::kCommandPort),
+          log_size,
+          realtime_config,
+          realtime_options,
+          log_fields,
+          log_compression)} {}
+
+Robot::Robot(std::unique_ptr<Impl> impl) noexcept : impl_{std::move(impl)} {}
+
+Robot::Robot(SimulatedRobot& simulation, RealtimeConfig realtime_config, size_t log_size)
+    : impl_{new Robot::Impl(simulation.connect(), log_size, realtime_config)} {}
+
+Robot::Robot(DatagramReplay& replay, RealtimeConfig realtime_config, size_t log_size)
+    : impl_{new Robot::Impl(replay.connect(), log_size, realtime_config)} {}
+
 // Has to be declared here, as the Impl type is incomplete in the header.
 Robot::~Robot() noexcept = default;
 
@@ -38,9 +63,50 @@ Robot::ServerVersion Robot::serverVersion() const noexcept {
   return impl_->serverVersion();
 }
 
+size_t Robot::logSnapshot(Record* records, size_t count) const noexcept {
+  return impl_->logSnapshot(records, count);
+}
+
 void Robot::control(std::function<Torques(const RobotState&, franka::Duration)> control_callback,
                     bool limit_rate,
-                    double cutoff_frequency) {
+                    const FilterConfiguration& filter_configuration) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  ControlLoop<JointVelocities> loop(*impl_, std::move(control_callback),
+                                    [](const RobotState&, Duration) -> JointVelocities {
+                                      return {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
+                                    },
+                                    limit_rate, filter_configuration);
+  loop();
+}
+
+void Robot::control(
+    std::function<Torques(const RobotStateView&, franka::Duration)> control_callback,
+    bool limit_rate,
+    const FilterConfiguration& filter_configuration) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  ControlLoop<JointVelocities> loop(*impl_, std::move(control_callback),
+                                    [](const RobotStateView&, Duration) -> JointVelocities {
+                                      return {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
+                                    },
+                                    limit_rate, filter_configuration);
+  loop();
+}
+
+void Robot::control(std::function<Torques(const RobotState&, franka::Duration)> control_callback,
+                    const ButterworthFilter<7>& torque_filter,
+                    bool limit_rate) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -52,7 +118,40 @@ void Robot::control(std::function<Torques(const RobotState&, franka::Duration)>
                                     [](const RobotState&, Duration) -> JointVelocities {
                                       return {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
                                     },
-                                    limit_rate, cutoff_frequency);
+                                    limit_rate, kMaxCutoffFrequency);
+  loop.setTorqueFilter(torque_filter);
+  loop();
+}
+
+void Robot::control(
+    std::function<std::vector<double>(const RobotState&, franka::Duration)> slow_callback,
+    std::function<Torques(const RobotState&, const std::vector<double>&, franka::Duration)>
+        control_callback,
+    const MultiRateOptions& options,
+    bool limit_rate,
+    const FilterConfiguration& filter_configuration) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+  if (!control_callback) {
+    throw std::invalid_argument("libfranka: Invalid control callback given.");
+  }
+
+  // Declared before the loop, so that the helper thread is stopped after the motion is finished or
+  // canceled.
+  MultiRateScheduler scheduler(std::move(slow_callback), options, impl_->readOnce());
+  ControlLoop<JointVelocities> loop(
+      *impl_,
+      [&](const RobotState& robot_state, Duration time_step) {
+        return control_callback(robot_state, scheduler.step(robot_state), time_step);
+      },
+      [](const RobotState&, Duration) -> JointVelocities {
+        return {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
+      },
+      limit_rate, filter_configuration);
   loop();
 }
 
@@ -60,7 +159,7 @@ void Robot::control(
     std::function<Torques(const RobotState&, franka::Duration)> control_callback,
     std::function<JointPositions(const RobotState&, franka::Duration)> motion_generator_callback,
     bool limit_rate,
-    double cutoff_frequency) {
+    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -70,7 +169,7 @@ void Robot::control(
 
   ControlLoop<JointPositions> loop(*impl_, std::move(control_callback),
                                    std::move(motion_generator_callback), limit_rate,
-                                   cutoff_frequency);
+                                   filter_configuration);
   loop();
 }
 
@@ -78,7 +177,7 @@ void Robot::control(
     std::function<Torques(const RobotState&, franka::Duration)> control_callback,
     std::function<JointVelocities(const RobotState&, franka::Duration)> motion_generator_callback,
     bool limit_rate,
-    double cutoff_frequency) {
+    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -88,7 +187,7 @@ void Robot::control(
 
   ControlLoop<JointVelocities> loop(*impl_, std::move(control_callback),
                                     std::move(motion_generator_callback), limit_rate,
-                                    cutoff_frequency);
+                                    filter_configuration);
   loop();
 }
 
@@ -96,7 +195,7 @@ void Robot::control(
     std::function<Torques(const RobotState&, franka::Duration)> control_callback,
     std::function<CartesianPose(const RobotState&, franka::Duration)> motion_generator_callback,
     bool limit_rate,
-    double cutoff_frequency) {
+    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -106,7 +205,7 @@ void Robot::control(
 
   ControlLoop<CartesianPose> loop(*impl_, std::move(control_callback),
                                   std::move(motion_generator_callback), limit_rate,
-                                  cutoff_frequency);
+                                  filter_configuration);
   loop();
 }
 
@@ -114,7 +213,7 @@ void Robot::control(std::function<Torques(const RobotState&, franka::Duration)>
                     std::function<CartesianVelocities(const RobotState&, franka::Duration)>
                         motion_generator_callback,
                     bool limit_rate,
-                    double cutoff_frequency) {
+                    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -124,7 +223,7 @@ void Robot::control(std::function<Torques(const RobotState&, franka::Duration)>
 
   ControlLoop<CartesianVelocities> loop(*impl_, std::move(control_callback),
                                         std::move(motion_generator_callback), limit_rate,
-                                        cutoff_frequency);
+                                        filter_configuration);
   loop();
 }
 
@@ -132,7 +231,7 @@ void Robot::control(
     std::function<JointPositions(const RobotState&, franka::Duration)> motion_generator_callback,
     ControllerMode controller_mode,
     bool limit_rate,
-    double cutoff_frequency) {
+    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -141,7 +240,7 @@ void Robot::control(
   }
 
   ControlLoop<JointPositions> loop(*impl_, controller_mode, std::move(motion_generator_callback),
-                                   limit_rate, cutoff_frequency);
+                                   limit_rate, filter_configuration);
   loop();
 }
 
@@ -149,7 +248,7 @@ void Robot::control(
     std::function<JointVelocities(const RobotState&, franka::Duration)> motion_generator_callback,
     ControllerMode controller_mode,
     bool limit_rate,
-    double cutoff_frequency) {
+    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -158,7 +257,7 @@ void Robot::control(
   }
 
   ControlLoop<JointVelocities> loop(*impl_, controller_mode, std::move(motion_generator_callback),
-                                    limit_rate, cutoff_frequency);
+                                    limit_rate, filter_configuration);
   loop();
 }
 
@@ -166,7 +265,7 @@ void Robot::control(
     std::function<CartesianPose(const RobotState&, franka::Duration)> motion_generator_callback,
     ControllerMode controller_mode,
     bool limit_rate,
-    double cutoff_frequency) {
+    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -175,7 +274,7 @@ void Robot::control(
   }
 
   ControlLoop<CartesianPose> loop(*impl_, controller_mode, std::move(motion_generator_callback),
-                                  limit_rate, cutoff_frequency);
+                                  limit_rate, filter_configuration);
   loop();
 }
 
@@ -183,7 +282,7 @@ void Robot::control(std::function<CartesianVelocities(const RobotState&, franka:
                         motion_generator_callback,
                     ControllerMode controller_mode,
                     bool limit_rate,
-                    double cutoff_frequency) {
+                    const FilterConfiguration& filter_configuration) {
   std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
   if (!l.owns_lock()) {
     throw InvalidOperationException(
@@ -191,8 +290,9 @@ void Robot::control(std::function<CartesianVelocities(const RobotState&, franka:
         "is running.");
   }
 
-  ControlLoop<CartesianVelocities> loop(
-      *impl_, controller_mode, std::move(motion_generator_callback), limit_rate, cutoff_frequency);
+  ControlLoop<CartesianVelocities> loop(*impl_, controller_mode,
+                                        std::move(motion_generator_callback), limit_rate,
+                                        filter_configuration);
   loop();
 }
 
@@ -205,6 +305,7 @@ void Robot::read(std::function<bool(const RobotState&)> read_callback) {
         "is running.");
   }
 
+  impl_->beginStateSequence();
   while (true) {
     RobotState robot_state = impl_->update(nullptr, nullptr);
     if (!read_callback(robot_state)) {
@@ -303,8 +404,342 @@ void Robot::stop() {
   impl_->executeCommand<research_interface::robot::StopMove>();
 }
 
+std::vector<CommandResult> Robot::execute(const CommandBatch& batch) {
+  return impl_->execute(*batch.impl_);
+}
+
+void Robot::setControlStatisticsEnabled(bool enabled) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setControlStatisticsEnabled(enabled);
+}
+
+ControlStatistics Robot::controlStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  return impl_->controlStatistics();
+}
+
+void Robot::resetControlStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->resetControlStatistics();
+}
+
+void Robot::setLimitingStatisticsEnabled(bool enabled) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setLimitingStatisticsEnabled(enabled);
+}
+
+LimitingStatistics Robot::limitingStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  return impl_->limitingStatistics();
+}
+
+void Robot::resetLimitingStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->resetLimitingStatistics();
+}
+
+void Robot::setCommunicationStatisticsEnabled(bool enabled) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setCommunicationStatisticsEnabled(enabled);
+}
+
+CommunicationStatistics Robot::communicationStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  return impl_->communicationStatistics();
+}
+
+ClockEstimate Robot::clockEstimate() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  return impl_->clockEstimate();
+}
+
+void Robot::resetCommunicationStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->resetCommunicationStatistics();
+}
+
+void Robot::setCommunicationStatisticsCallback(CommunicationStatisticsCallback callback,
+                                               double success_rate_threshold) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+  if (!(success_rate_threshold >= 0.0 && success_rate_threshold <= 1.0)) {
+    throw std::invalid_argument(
+        "libfranka robot: Success rate threshold must be between 0 and 1.");
+  }
+
+  impl_->setCommunicationStatisticsCallback(std::move(callback), success_rate_threshold);
+}
+
+void Robot::setJointStateEstimation(bool enabled,
+                                    const JointStateEstimatorParameters& parameters) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setJointStateEstimation(enabled, parameters);
+}
+
+void Robot::setStatePrediction(const Model* model) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setStatePrediction(model);
+}
+
+void Robot::setMomentumObserver(MomentumObserver* observer, const Model* model) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setMomentumObserver(observer, model);
+}
+
+void Robot::setPassivityControl(bool enabled, const PassivityControllerParameters& parameters) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setPassivityControl(enabled, parameters);
+}
+
+PassivityStatistics Robot::passivityStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  return impl_->passivityStatistics();
+}
+
+void Robot::resetPassivityStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->resetPassivityStatistics();
+}
+
+void Robot::setOnlineTrajectoryGeneration(bool enabled) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setOnlineTrajectoryGeneration(enabled);
+}
+
+void Robot::setCallbackDeadline(bool enabled, const CallbackDeadline& deadline) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setCallbackDeadline(enabled, deadline);
+}
+
+DeadlineStatistics Robot::deadlineStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  return *impl_->deadlineStatistics();
+}
+
+void Robot::resetDeadlineStatistics() {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  *impl_->deadlineStatistics() = {};
+}
+
+void Robot::setValidationPolicy(ValidationPolicy policy) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setValidationPolicy(policy);
+}
+
+void Robot::setStreamingRecorder(std::shared_ptr<StreamingRecorder> recorder) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setStreamingRecorder(std::move(recorder));
+}
+
+void Robot::setDatagramRecorder(std::shared_ptr<DatagramRecorder> recorder) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->network().setDatagramRecorder(std::move(recorder));
+}
+
+void Robot::setStatePublisher(std::shared_ptr<StatePublisher> publisher) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setStatePublisher(std::move(publisher));
+}
+
+void Robot::setSharedMemoryMetrics(std::shared_ptr<SharedMemoryMetrics> metrics) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setSharedMemoryMetrics(std::move(metrics));
+}
+
+void Robot::setFlightRecorder(std::shared_ptr<FlightRecorder> recorder) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setFlightRecorder(std::move(recorder));
+}
+
+void Robot::setStateBroadcaster(std::shared_ptr<StateBroadcaster> broadcaster) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->setStateBroadcaster(std::move(broadcaster));
+}
+
 Model Robot::loadModel() {
   return impl_->loadModel();
 }
 
+Model Robot::loadModel(const std::string& cache_directory) {
+  return impl_->loadModel(cache_directory);
+}
+
+void Robot::reconnect(const std::string& franka_address) {
+  std::unique_lock<std::mutex> l(control_mutex_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    throw InvalidOperationException(
+        "libfranka robot: Cannot perform this operation while another control or read operation "
+        "is running.");
+  }
+
+  impl_->reconnect(
+      std::make_unique<Network>(franka_address, research_interface::robot::kCommandPort));
+}
+
 }  // namespace franka
@@ -4,13 +4,23 @@
 
 #include <cstdint>
 
+#include <franka/callback_deadline.h>
 #include <franka/control_types.h>
+#include <franka/joint_state_estimator.h>
+#include <franka/passivity_controller.h>
 #include <franka/robot_state.h>
+#include <franka/robot_state_view.h>
 #include <research_interface/robot/rbk_types.h>
 #include <research_interface/robot/service_types.h>
 
+#include "control_statistics_recorder.h"
+#include "limiting_statistics_recorder.h"
+
 namespace franka {
 
+class Model;
+class MomentumObserver;
+
 class RobotControl {
  public:
   virtual ~RobotControl() = default;
@@ -30,9 +40,77 @@ class RobotControl {
       const research_interface::robot::MotionGeneratorCommand* motion_command,
       const research_interface::robot::ControllerCommand* control_command) = 0;
 
+  virtual RobotStateView updateView(
+      const research_interface::robot::MotionGeneratorCommand* motion_command,
+      const research_interface::robot::ControllerCommand* control_command) = 0;
+
   virtual void throwOnMotionError(const RobotState& robot_state, uint32_t motion_id) = 0;
+  virtual void throwOnMotionError(const RobotStateView& robot_state, uint32_t motion_id) = 0;
 
   virtual RealtimeConfig realtimeConfig() const noexcept = 0;
+  virtual const RealtimeOptions& realtimeOptions() const noexcept = 0;
+
+  /**
+   * @return Recorder for control loop timings, or nullptr if timings should not be recorded.
+   */
+  virtual ControlStatisticsRecorder* controlStatisticsRecorder() noexcept = 0;
+
+  /**
+   * @return Recorder for rate limiting statistics, or nullptr if they should not be recorded.
+   */
+  virtual LimitingStatisticsRecorder* limitingStatisticsRecorder() noexcept = 0;
+
+  /**
+   * @return Parameters of the joint state estimator, or nullptr if joint states should not be
+   * estimated.
+   */
+  virtual const JointStateEstimatorParameters* jointStateEstimatorParameters() const noexcept = 0;
+
+  /**
+   * @return Model to predict joint states over lost packets and transport delays with, or nullptr
+   * if joint states should not be predicted.
+   */
+  virtual const Model* statePredictionModel() const noexcept = 0;
+
+  /**
+   * @return Momentum observer to update with every robot state, or nullptr if external torques
+   * should not be observed.
+   */
+  virtual MomentumObserver* momentumObserver() noexcept = 0;
+
+  /**
+   * @return Model for the momentum observer. Valid whenever momentumObserver() is not nullptr.
+   */
+  virtual const Model* momentumObserverModel() const noexcept = 0;
+
+  /**
+   * @return Passivity controller for torque commands, or nullptr if torque commands should not be
+   * made passive.
+   */
+  virtual PassivityController* passivityController() noexcept = 0;
+
+  /**
+   * @return True if rate limited joint position and joint velocity commands should be generated by
+   * a franka::OnlineTrajectoryGenerator instead of being clipped by limitRate().
+   */
+  virtual bool onlineTrajectoryGeneration() const noexcept = 0;
+
+  /**
+   * @return Deadline of the control callback of torque control loops, or of the motion generator
+   * callback of other control loops, or nullptr if callbacks should run without a deadline.
+   */
+  virtual const CallbackDeadline* callbackDeadline() const noexcept = 0;
+
+  /**
+   * @return Statistics to record deadline misses in. Valid whenever callbackDeadline() is not
+   * nullptr.
+   */
+  virtual DeadlineStatistics* deadlineStatistics() noexcept = 0;
+
+  /**
+   * @return How thoroughly control loops validate the commands they send.
+   */
+  virtual ValidationPolicy validationPolicy() const noexcept = 0;
 };
 
 }  // namespace franka
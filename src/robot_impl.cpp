@@ -2,9 +2,13 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include "robot_impl.h"
 
+#include <array>
 #include <sstream>
+#include <utility>
 
-#include "load_calculations.h"
+#include "command_batch.h"
+#include "metrics_writer.h"
+#include "tracing.h"
 
 namespace franka {
 
@@ -13,21 +17,23 @@ namespace {
 inline ControlException createControlException(const char* message,
                                                research_interface::robot::Move::Status move_status,
                                                const Errors& reflex_errors,
-                                               const std::vector<Record>& log) {
+                                               Logger* logger) {
   std::ostringstream message_stream;
   message_stream << message;
   if (move_status == decltype(move_status)::kReflexAborted) {
     message_stream << " " << reflex_errors;
 
-    if (log.size() >= 2) {
+    // Read the last two records from the ring, so that the flushed log stays unconverted.
+    std::array<Record, 2> last_records;
+    if (logger->snapshot(last_records.data(), last_records.size()) == last_records.size()) {
       // Count number of lost packets in the last and before last packets.
       uint64_t lost_packets =
-          log[log.size() - 1].state.time.toMSec() - log[log.size() - 2].state.time.toMSec() - 1;
+          last_records[1].state.time.toMSec() - last_records[0].state.time.toMSec() - 1;
       // Read second to last control_command_success_rate since the last one will always be zero and
       // consider in the success rate assumming all previous packets were lost.
       message_stream << std::endl
                      << "control_command_success_rate: "
-                     << (log[log.size() - 2].state.control_command_success_rate *
+                     << (last_records[0].state.control_command_success_rate *
                          (1 - static_cast<double>(lost_packets) / 100));
       // Packets lost in a row
       if (lost_packets > 0) {
@@ -35,13 +41,39 @@ inline ControlException createControlException(const char* message,
       }
     }
   }
-  return ControlException(message_stream.str(), log);
+  return ControlException(message_stream.str(), logger->flush());
 }
 
+const research_interface::robot::RobotCommand kNoRobotCommand{};
+
+// Releases the UDP socket ownership taken in startMotion() when leaving the scope.
+class UdpOwnershipRelease {
+ public:
+  explicit UdpOwnershipRelease(Network& network) : network_(network) {}
+  ~UdpOwnershipRelease() { network_.releaseUdpOwnership(); }
+
+  UdpOwnershipRelease(const UdpOwnershipRelease&) = delete;
+  UdpOwnershipRelease& operator=(const UdpOwnershipRelease&) = delete;
+
+ private:
+  Network& network_;
+};
+
 }  // anonymous namespace
 
-Robot::Impl::Impl(std::unique_ptr<Network> network, size_t log_size, RealtimeConfig realtime_config)
-    : network_{std::move(network)}, logger_{log_size}, realtime_config_{realtime_config} {
+constexpr uint8_t Robot::Impl::kMotionCommandPart;
+constexpr uint8_t Robot::Impl::kControlCommandPart;
+
+Robot::Impl::Impl(std::unique_ptr<Network> network,
+                  size_t log_size,
+                  RealtimeConfig realtime_config,
+                  const RealtimeOptions& realtime_options,
+                  LogFields log_fields,
+                  const LogCompression& log_compression)
+    : network_{std::move(network)},
+      logger_{log_size, log_fields, log_compression},
+      realtime_config_{realtime_config},
+      realtime_options_{realtime_options} {
   if (!network_) {
     throw std::invalid_argument("libfranka robot: Invalid argument");
   }
@@ -51,94 +83,254 @@ Robot::Impl::Impl(std::unique_ptr<Network> network, size_t log_size, RealtimeCon
   updateState(network_->udpBlockingReceive<research_interface::robot::RobotState>());
 }
 
+void Robot::Impl::reconnect(std::unique_ptr<Network> network) {
+  if (!network) {
+    throw std::invalid_argument("libfranka robot: Invalid argument");
+  }
+
+  uint16_t ri_version;
+  connect<research_interface::robot::Connect, research_interface::robot::kVersion>(*network,
+                                                                                   &ri_version);
+  auto robot_state = network->udpBlockingReceive<research_interface::robot::RobotState>();
+  network->setDatagramRecorder(network_->datagramRecorder());
+
+  network_ = std::move(network);
+  ri_version_ = ri_version;
+  resetMotionModes();
+  // States missed while the connection was down are not lost packets of the new connection.
+  beginStateSequence();
+  updateState(robot_state);
+}
+
 RobotState Robot::Impl::update(
     const research_interface::robot::MotionGeneratorCommand* motion_command,
     const research_interface::robot::ControllerCommand* control_command) {
+  TraceScope trace("Robot::Impl::update");
+  exchangeRobotState(motion_command, control_command);
+
+  RobotState state;
+  convertRobotState(robot_state_, &load_cache_, &state);
+  state.host_time = clock_estimator_.hostTime(state.time);
+  return state;
+}
+
+RobotStateView Robot::Impl::updateView(
+    const research_interface::robot::MotionGeneratorCommand* motion_command,
+    const research_interface::robot::ControllerCommand* control_command) {
+  TraceScope trace("Robot::Impl::update");
+  exchangeRobotState(motion_command, control_command);
+
+  return RobotStateView(robot_state_);
+}
+
+void Robot::Impl::exchangeRobotState(
+    const research_interface::robot::MotionGeneratorCommand* motion_command,
+    const research_interface::robot::ControllerCommand* control_command) {
   network_->tcpThrowIfConnectionClosed();
 
-  research_interface::robot::RobotCommand robot_command =
+  if (!statistics_.active()) {
+    const research_interface::robot::RobotCommand& robot_command =
+        sendRobotCommand(motion_command, control_command);
+    robot_state_ = receiveRobotState();
+    recordState(robot_command);
+    return;
+  }
+
+  using Clock = ControlStatisticsRecorder::Clock;
+  Clock::time_point send_start = Clock::now();
+  const research_interface::robot::RobotCommand& robot_command =
       sendRobotCommand(motion_command, control_command);
+  Clock::time_point send_end = Clock::now();
+  if (motion_command != nullptr || control_command != nullptr) {
+    statistics_.record(ControlStatisticsRecorder::Stage::kSendCommand, send_end - send_start);
+    if (state_received_time_ != Clock::time_point()) {
+      statistics_.recordCycle(send_end - state_received_time_);
+    }
+    recordKernelTimeSince(ControlStatisticsRecorder::Stage::kNetworkCycle);
+  }
 
-  RobotState state = convertRobotState(receiveRobotState());
-  logger_.log(state, robot_command);
+  robot_state_ = receiveRobotState();
+  state_received_time_ = Clock::now();
+  statistics_.record(ControlStatisticsRecorder::Stage::kReceiveState,
+                     state_received_time_ - send_end);
+  recordKernelTimeSince(ControlStatisticsRecorder::Stage::kReceiveWakeup);
+  recordState(robot_command);
+}
 
-  return state;
+void Robot::Impl::sendCommand(
+    const research_interface::robot::MotionGeneratorCommand* motion_command,
+    const research_interface::robot::ControllerCommand* control_command) {
+  network_->tcpThrowIfConnectionClosed();
+
+  if (!statistics_.active()) {
+    sent_command_ = sendRobotCommand(motion_command, control_command);
+    return;
+  }
+
+  using Clock = ControlStatisticsRecorder::Clock;
+  Clock::time_point send_start = Clock::now();
+  sent_command_ = sendRobotCommand(motion_command, control_command);
+  command_sent_time_ = Clock::now();
+  if (motion_command != nullptr || control_command != nullptr) {
+    statistics_.record(ControlStatisticsRecorder::Stage::kSendCommand,
+                       command_sent_time_ - send_start);
+    if (state_received_time_ != Clock::time_point()) {
+      statistics_.recordCycle(command_sent_time_ - state_received_time_);
+    }
+    recordKernelTimeSince(ControlStatisticsRecorder::Stage::kNetworkCycle);
+  }
 }
 
-void Robot::Impl::throwOnMotionError(const RobotState& robot_state, uint32_t motion_id) {
-  if (robot_state.robot_mode != RobotMode::kMove ||
-      motion_generator_mode_ != current_move_motion_generator_mode_ ||
-      controller_mode_ != current_move_controller_mode_) {
-    // We detect a move error by changes in the robot state and we will receive a TCP response to
-    // the Move command.
-    auto response =
-        network_->tcpBlockingReceiveResponse<research_interface::robot::Move>(motion_id);
-    try {
-      handleCommandResponse<research_interface::robot::Move>(response);
-    } catch (const CommandException& e) {
-      throw createControlException(e.what(), response.status, robot_state.last_motion_errors,
-                                   logger_.flush());
+bool Robot::Impl::receiveState(RobotState* robot_state) {
+  research_interface::robot::RobotState received_state{};
+  if (!network_->udpReceiveLatest(&received_state) || received_state.message_id <= message_id_) {
+    return false;
+  }
+
+  robot_state_ = received_state;
+  state_kernel_time_ = network_->udpReceiveTime();
+  updateState(robot_state_);
+  if (statistics_.active()) {
+    using Clock = ControlStatisticsRecorder::Clock;
+    state_received_time_ = Clock::now();
+    if (command_sent_time_ != Clock::time_point()) {
+      statistics_.record(ControlStatisticsRecorder::Stage::kReceiveState,
+                         state_received_time_ - command_sent_time_);
     }
-    throw ProtocolException("Unexpected reply to a Move command");
+    recordKernelTimeSince(ControlStatisticsRecorder::Stage::kReceiveWakeup);
+  }
+  recordState(sent_command_);
+  sent_command_ = {};
+
+  convertRobotState(robot_state_, &load_cache_, robot_state);
+  robot_state->host_time = clock_estimator_.hostTime(robot_state->time);
+  return true;
+}
+
+void Robot::Impl::recordKernelTimeSince(ControlStatisticsRecorder::Stage stage) noexcept {
+  // Not available if the platform does not report kernel receive timestamps.
+  if (state_kernel_time_ != std::chrono::system_clock::time_point()) {
+    statistics_.record(stage, std::chrono::system_clock::now() - state_kernel_time_);
+  }
+}
+
+void Robot::Impl::recordState(const research_interface::robot::RobotCommand& robot_command) {
+  logger_.log(robot_state_, robot_command);
+  if (recorder_) {
+    recordRawSample(*recorder_, robot_state_, robot_command);
+  }
+  if (flight_recorder_) {
+    recordRawFlightSample(*flight_recorder_, robot_state_, robot_command);
+  }
+  if (publisher_) {
+    publishRawState(*publisher_, robot_state_, robot_command);
+  }
+  if (broadcaster_) {
+    broadcastRawState(*broadcaster_, robot_state_, robot_command,
+                      clock_estimator_.hostTime(Duration(robot_state_.message_id)));
+  }
+}
+
+void Robot::Impl::throwOnMotionError(const RobotState& robot_state, uint32_t motion_id) {
+  if (motionErrorDetected(robot_state.robot_mode)) {
+    throwMotionError(motion_id, robot_state.last_motion_errors);
+  }
+}
+
+void Robot::Impl::throwOnMotionError(const RobotStateView& robot_state, uint32_t motion_id) {
+  if (motionErrorDetected(robot_state.robot_mode())) {
+    throwMotionError(motion_id, robot_state.last_motion_errors());
   }
 }
 
+bool Robot::Impl::motionErrorDetected(RobotMode robot_mode) const noexcept {
+  return robot_mode != RobotMode::kMove ||
+         motion_generator_mode_ != current_move_motion_generator_mode_ ||
+         controller_mode_ != current_move_controller_mode_;
+}
+
+void Robot::Impl::throwMotionError(uint32_t motion_id, const Errors& last_motion_errors) {
+  // We detect a move error by changes in the robot state and we will receive a TCP response to
+  // the Move command.
+  auto response = network_->tcpBlockingReceiveResponse<research_interface::robot::Move>(motion_id);
+  try {
+    handleCommandResponse<research_interface::robot::Move>(response);
+  } catch (const CommandException& e) {
+    throw createControlException(e.what(), response.status, last_motion_errors, &logger_);
+  }
+  throw ProtocolException("Unexpected reply to a Move command");
+}
+
 RobotState Robot::Impl::readOnce() {
+  beginStateSequence();
+
   // Delete old data from the UDP buffer.
   research_interface::robot::RobotState robot_state;
-  while (network_->udpReceive<decltype(robot_state)>(&robot_state)) {
-  }
+  network_->udpReceiveLatest(&robot_state);
 
-  return convertRobotState(receiveRobotState());
+  RobotState state;
+  convertRobotState(receiveRobotState(), &load_cache_, &state);
+  state.host_time = clock_estimator_.hostTime(state.time);
+  return state;
 }
 
-research_interface::robot::RobotCommand Robot::Impl::sendRobotCommand(
+const research_interface::robot::RobotCommand& Robot::Impl::sendRobotCommand(
     const research_interface::robot::MotionGeneratorCommand* motion_command,
-    const research_interface::robot::ControllerCommand* control_command) const {
-  research_interface::robot::RobotCommand robot_command{};
-  if (motion_command != nullptr || control_command != nullptr) {
-    robot_command.message_id = message_id_;
-    if (motion_command != nullptr) {
-      if (current_move_motion_generator_mode_ ==
-          research_interface::robot::MotionGeneratorMode::kIdle) {
-        throw ControlException(
-            "libfranka robot: Trying to send motion command, but no motion generator running!");
-      }
-      robot_command.motion = *motion_command;
-    }
-    if (control_command != nullptr) {
-      if (current_move_controller_mode_ !=
-          research_interface::robot::ControllerMode::kExternalController) {
-        throw ControlException(
-            "libfranka robot: Trying to send control command, but no controller running!");
-      }
-      robot_command.control = *control_command;
-    }
+    const research_interface::robot::ControllerCommand* control_command) {
+  uint8_t command_parts = (motion_command != nullptr ? kMotionCommandPart : 0) |
+                          (control_command != nullptr ? kControlCommandPart : 0);
+  if (command_parts == 0) {
+    return kNoRobotCommand;
+  }
+  if (command_parts != command_parts_) {
+    throwInvalidRobotCommand(motion_command, control_command);
+  }
 
-    if (current_move_motion_generator_mode_ !=
-            research_interface::robot::MotionGeneratorMode::kIdle &&
-        current_move_controller_mode_ ==
-            research_interface::robot::ControllerMode::kExternalController &&
-        (motion_command == nullptr || control_command == nullptr)) {
-      throw ControlException("libfranka robot: Trying to send partial robot command!");
-    }
+  command_buffer_.message_id = message_id_;
+  if (motion_command != nullptr) {
+    command_buffer_.motion = *motion_command;
+  }
+  if (control_command != nullptr) {
+    command_buffer_.control = *control_command;
+  }
+  network_->udpSend<research_interface::robot::RobotCommand>(command_buffer_);
+  if (communication_statistics_.enabled()) {
+    round_trip_start_ = ControlStatisticsRecorder::Clock::now();
+  }
+  return command_buffer_;
+}
 
-    network_->udpSend<research_interface::robot::RobotCommand>(robot_command);
+void Robot::Impl::throwInvalidRobotCommand(
+    const research_interface::robot::MotionGeneratorCommand* motion_command,
+    const research_interface::robot::ControllerCommand* control_command) const {
+  if (motion_command != nullptr && (command_parts_ & kMotionCommandPart) == 0) {
+    throw ControlException(
+        "libfranka robot: Trying to send motion command, but no motion generator running!");
+  }
+  if (control_command != nullptr && (command_parts_ & kControlCommandPart) == 0) {
+    throw ControlException(
+        "libfranka robot: Trying to send control command, but no controller running!");
   }
+  throw ControlException("libfranka robot: Trying to send partial robot command!");
+}
 
-  return robot_command;
+void Robot::Impl::resetMotionModes() noexcept {
+  current_move_motion_generator_mode_ = research_interface::robot::MotionGeneratorMode::kIdle;
+  current_move_controller_mode_ = research_interface::robot::ControllerMode::kOther;
+  command_parts_ = 0;
 }
 
 research_interface::robot::RobotState Robot::Impl::receiveRobotState() {
+  TraceScope trace("Robot::Impl::receiveRobotState");
   research_interface::robot::RobotState latest_accepted_state;
   latest_accepted_state.message_id = message_id_;
 
   // If states are already available on the socket, use the one with the most recent message ID.
   research_interface::robot::RobotState received_state{};
-  while (network_->udpReceive(&received_state)) {
-    if (received_state.message_id > latest_accepted_state.message_id) {
-      latest_accepted_state = received_state;
-    }
+  if (network_->udpReceiveLatest(&received_state) &&
+      received_state.message_id > latest_accepted_state.message_id) {
+    latest_accepted_state = received_state;
+    state_kernel_time_ = network_->udpReceiveTime();
   }
 
   // If there was no valid state on the socket, we need to wait.
@@ -146,6 +338,7 @@ research_interface::robot::RobotState Robot::Impl::receiveRobotState() {
     received_state = network_->udpBlockingReceive<decltype(received_state)>();
     if (received_state.message_id > latest_accepted_state.message_id) {
       latest_accepted_state = received_state;
+      state_kernel_time_ = network_->udpReceiveTime();
     }
   }
 
@@ -158,12 +351,38 @@ void Robot::Impl::updateState(const research_interface::robot::RobotState& robot
   motion_generator_mode_ = robot_state.motion_generator_mode;
   controller_mode_ = robot_state.controller_mode;
   message_id_ = robot_state.message_id;
+  clock_estimator_.update(Duration(robot_state.message_id), std::chrono::steady_clock::now());
+
+  if (metrics_) {
+    recordMetricsState(metrics_->segment(), robot_state.message_id,
+                       static_cast<uint64_t>(robot_state.robot_mode),
+                       robot_state.control_command_success_rate);
+  }
+  if (!communication_statistics_.enabled()) {
+    return;
+  }
+  if (round_trip_start_ != ControlStatisticsRecorder::Clock::time_point()) {
+    communication_statistics_.recordRoundTrip(ControlStatisticsRecorder::Clock::now() -
+                                              round_trip_start_);
+    round_trip_start_ = {};
+  }
+  bool degraded = communication_statistics_.record(
+      robot_state.message_id, robot_state.control_command_success_rate,
+      robot_state.robot_mode == research_interface::robot::RobotMode::kMove,
+      success_rate_threshold_);
+  if (degraded && communication_callback_) {
+    communication_callback_(communication_statistics_.statistics());
+  }
 }
 
 Robot::ServerVersion Robot::Impl::serverVersion() const noexcept {
   return ri_version_;
 }
 
+size_t Robot::Impl::logSnapshot(Record* records, size_t count) const noexcept {
+  return logger_.snapshot(records, count);
+}
+
 bool Robot::Impl::motionGeneratorRunning() const noexcept {
   return motion_generator_mode_ != research_interface::robot::MotionGeneratorMode::kIdle;
 }
@@ -176,11 +395,37 @@ RealtimeConfig Robot::Impl::realtimeConfig() const noexcept {
   return realtime_config_;
 }
 
+const RealtimeOptions& Robot::Impl::realtimeOptions() const noexcept {
+  return realtime_options_;
+}
+
 uint32_t Robot::Impl::startMotion(
     research_interface::robot::Move::ControllerMode controller_mode,
     research_interface::robot::Move::MotionGeneratorMode motion_generator_mode,
     const research_interface::robot::Move::Deviation& maximum_path_deviation,
     const research_interface::robot::Move::Deviation& maximum_goal_pose_deviation) {
+  beginStateSequence();
+  const uint32_t move_command_id = requestMotion(
+      controller_mode, motion_generator_mode, maximum_path_deviation, maximum_goal_pose_deviation);
+  try {
+    while (!motionStarted(move_command_id)) {
+      update(nullptr, nullptr);
+    }
+
+    logger_.clear();
+
+    return move_command_id;
+  } catch (...) {
+    network_->releaseUdpOwnership();
+    throw;
+  }
+}
+
+uint32_t Robot::Impl::requestMotion(
+    research_interface::robot::Move::ControllerMode controller_mode,
+    research_interface::robot::Move::MotionGeneratorMode motion_generator_mode,
+    const research_interface::robot::Move::Deviation& maximum_path_deviation,
+    const research_interface::robot::Move::Deviation& maximum_goal_pose_deviation) {
   if (motionGeneratorRunning() || controllerRunning()) {
     throw ControlException("libfranka robot: Attempted to start multiple motions!");
   }
@@ -220,38 +465,47 @@ uint32_t Robot::Impl::startMotion(
       throw std::invalid_argument("libfranka robot: Invalid controller mode given.");
   }
 
-  const uint32_t move_command_id = executeCommand<research_interface::robot::Move>(
-      controller_mode, motion_generator_mode, maximum_path_deviation, maximum_goal_pose_deviation);
-
-  RobotState robot_state{};
-  while (motion_generator_mode_ != current_move_motion_generator_mode_ ||
-         controller_mode_ != current_move_controller_mode_) {
-    try {
-      if (network_->tcpReceiveResponse<research_interface::robot::Move>(
-              move_command_id,
-              std::bind(&Robot::Impl::handleCommandResponse<research_interface::robot::Move>, this,
-                        std::placeholders::_1))) {
-        break;
-      }
-    } catch (const CommandException& e) {
-      throw ControlException(e.what());
-    }
-
-    robot_state = update(nullptr, nullptr);
+  command_parts_ = kMotionCommandPart;
+  if (current_move_controller_mode_ ==
+      research_interface::robot::ControllerMode::kExternalController) {
+    command_parts_ |= kControlCommandPart;
   }
+  command_buffer_ = {};
 
-  logger_.flush();
+  // Only the thread running the motion uses the UDP socket until the motion is finished or
+  // canceled, so it does not need to lock on every cycle.
+  network_->acquireUdpOwnership();
+  try {
+    return executeCommand<research_interface::robot::Move>(controller_mode, motion_generator_mode,
+                                                           maximum_path_deviation,
+                                                           maximum_goal_pose_deviation);
+  } catch (...) {
+    network_->releaseUdpOwnership();
+    throw;
+  }
+}
 
-  return move_command_id;
+bool Robot::Impl::motionStarted(uint32_t motion_id) {
+  if (motion_generator_mode_ == current_move_motion_generator_mode_ &&
+      controller_mode_ == current_move_controller_mode_) {
+    return true;
+  }
+  try {
+    return network_->tcpReceiveResponse<research_interface::robot::Move>(
+        motion_id, std::bind(&Robot::Impl::handleCommandResponse<research_interface::robot::Move>,
+                             this, std::placeholders::_1));
+  } catch (const CommandException& e) {
+    throw ControlException(e.what());
+  }
 }
 
 void Robot::Impl::finishMotion(
     uint32_t motion_id,
     const research_interface::robot::MotionGeneratorCommand* motion_command,
     const research_interface::robot::ControllerCommand* control_command) {
+  UdpOwnershipRelease udp_ownership_release(*network_);
   if (!motionGeneratorRunning() && !controllerRunning()) {
-    current_move_motion_generator_mode_ = research_interface::robot::MotionGeneratorMode::kIdle;
-    current_move_controller_mode_ = research_interface::robot::ControllerMode::kOther;
+    resetMotionModes();
     return;
   }
 
@@ -268,23 +522,30 @@ void Robot::Impl::finishMotion(
   while (motionGeneratorRunning() || controllerRunning()) {
     robot_state = update(&motion_finished_command, control_command);
   }
+  completeMotion(motion_id, robot_state.last_motion_errors);
+}
 
+bool Robot::Impl::motionRunning() const noexcept {
+  return motionGeneratorRunning() || controllerRunning();
+}
+
+void Robot::Impl::completeMotion(uint32_t motion_id, const Errors& last_motion_errors) {
+  UdpOwnershipRelease udp_ownership_release(*network_);
   auto response = network_->tcpBlockingReceiveResponse<research_interface::robot::Move>(motion_id);
   if (response.status == research_interface::robot::Move::Status::kReflexAborted) {
     throw createControlException("Motion finished commanded, but the robot is still moving!",
-                                 response.status, robot_state.last_motion_errors, logger_.flush());
+                                 response.status, last_motion_errors, &logger_);
   }
   try {
     handleCommandResponse<research_interface::robot::Move>(response);
   } catch (const CommandException& e) {
-    throw createControlException(e.what(), response.status, robot_state.last_motion_errors,
-                                 logger_.flush());
+    throw createControlException(e.what(), response.status, last_motion_errors, &logger_);
   }
-  current_move_motion_generator_mode_ = research_interface::robot::MotionGeneratorMode::kIdle;
-  current_move_controller_mode_ = research_interface::robot::ControllerMode::kOther;
+  resetMotionModes();
 }
 
 void Robot::Impl::cancelMotion(uint32_t motion_id) {
+  UdpOwnershipRelease udp_ownership_release(*network_);
   try {
     executeCommand<research_interface::robot::StopMove>();
   } catch (const CommandException& e) {
@@ -299,92 +560,238 @@ void Robot::Impl::cancelMotion(uint32_t motion_id) {
   // Ignore Move response.
   // TODO (FWA): It is not guaranteed that the Move response won't come later
   network_->tcpReceiveResponse<research_interface::robot::Move>(motion_id, [](auto) {});
-  current_move_motion_generator_mode_ = research_interface::robot::MotionGeneratorMode::kIdle;
-  current_move_controller_mode_ = research_interface::robot::ControllerMode::kOther;
+  resetMotionModes();
+}
+
+Network& Robot::Impl::network() noexcept {
+  return *network_;
+}
+
+std::vector<CommandResult> Robot::Impl::execute(const CommandBatch::Impl& batch) {
+  std::vector<uint32_t> command_ids;
+  command_ids.reserve(batch.commands.size());
+  for (const CommandBatch::Impl::Command& command : batch.commands) {
+    command_ids.push_back(command.send(*this));
+  }
+
+  // A rejected command only fails its own result. Network errors leave the remaining responses
+  // unreadable, so they are thrown for the whole batch.
+  std::vector<CommandResult> results;
+  results.reserve(batch.commands.size());
+  for (size_t i = 0; i < batch.commands.size(); i++) {
+    CommandResult result{batch.commands[i].name, true, {}};
+    try {
+      batch.commands[i].receive(*this, command_ids[i]);
+    } catch (const CommandException& exception) {
+      result.success = false;
+      result.error = exception.what();
+    } catch (const ProtocolException& exception) {
+      result.success = false;
+      result.error = exception.what();
+    }
+    results.push_back(std::move(result));
+  }
+  return results;
 }
 
 Model Robot::Impl::loadModel() const {
   return Model(*network_);
 }
 
-RobotState convertRobotState(const research_interface::robot::RobotState& robot_state) noexcept {
-  RobotState converted;
-  converted.O_T_EE = robot_state.O_T_EE;
-  converted.O_T_EE_d = robot_state.O_T_EE_d;
-  converted.F_T_NE = robot_state.F_T_NE;
-  converted.NE_T_EE = robot_state.NE_T_EE;
-  converted.F_T_EE = robot_state.F_T_EE;
-  converted.EE_T_K = robot_state.EE_T_K;
-  converted.m_ee = robot_state.m_ee;
-  converted.F_x_Cee = robot_state.F_x_Cee;
-  converted.I_ee = robot_state.I_ee;
-  converted.m_load = robot_state.m_load;
-  converted.F_x_Cload = robot_state.F_x_Cload;
-  converted.I_load = robot_state.I_load;
-  converted.m_total = robot_state.m_ee + robot_state.m_load;
-  converted.F_x_Ctotal = combineCenterOfMass(robot_state.m_ee, robot_state.F_x_Cee,
-                                             robot_state.m_load, robot_state.F_x_Cload);
-  converted.I_total = combineInertiaTensor(
-      robot_state.m_ee, robot_state.F_x_Cee, robot_state.I_ee, robot_state.m_load,
-      robot_state.F_x_Cload, robot_state.I_load, converted.m_total, converted.F_x_Ctotal);
-  converted.elbow = robot_state.elbow;
-  converted.elbow_d = robot_state.elbow_d;
-  converted.elbow_c = robot_state.elbow_c;
-  converted.delbow_c = robot_state.delbow_c;
-  converted.ddelbow_c = robot_state.ddelbow_c;
-  converted.tau_J = robot_state.tau_J;
-  converted.tau_J_d = robot_state.tau_J_d;
-  converted.dtau_J = robot_state.dtau_J;
-  converted.q = robot_state.q;
-  converted.dq = robot_state.dq;
-  converted.q_d = robot_state.q_d;
-  converted.dq_d = robot_state.dq_d;
-  converted.ddq_d = robot_state.ddq_d;
-  converted.joint_contact = robot_state.joint_contact;
-  converted.cartesian_contact = robot_state.cartesian_contact;
-  converted.joint_collision = robot_state.joint_collision;
-  converted.cartesian_collision = robot_state.cartesian_collision;
-  converted.tau_ext_hat_filtered = robot_state.tau_ext_hat_filtered;
-  converted.O_F_ext_hat_K = robot_state.O_F_ext_hat_K;
-  converted.K_F_ext_hat_K = robot_state.K_F_ext_hat_K;
-  converted.O_dP_EE_d = robot_state.O_dP_EE_d;
-  converted.O_ddP_O = robot_state.O_ddP_O;
-  converted.O_T_EE_c = robot_state.O_T_EE_c;
-  converted.O_dP_EE_c = robot_state.O_dP_EE_c;
-  converted.O_ddP_EE_c = robot_state.O_ddP_EE_c;
-  converted.theta = robot_state.theta;
-  converted.dtheta = robot_state.dtheta;
-  converted.current_errors = robot_state.errors;
-  converted.last_motion_errors = robot_state.reflex_reason;
-  converted.control_command_success_rate = robot_state.control_command_success_rate;
-  converted.time = Duration(robot_state.message_id);
-
-  converted.robot_mode = RobotMode::kOther;
-  switch (robot_state.robot_mode) {
-    case research_interface::robot::RobotMode::kOther:
-      converted.robot_mode = RobotMode::kOther;
-      break;
-    case research_interface::robot::RobotMode::kIdle:
-      converted.robot_mode = RobotMode::kIdle;
-      break;
-    case research_interface::robot::RobotMode::kMove:
-      converted.robot_mode = RobotMode::kMove;
-      break;
-    case research_interface::robot::RobotMode::kGuiding:
-      converted.robot_mode = RobotMode::kGuiding;
-      break;
-    case research_interface::robot::RobotMode::kReflex:
-      converted.robot_mode = RobotMode::kReflex;
-      break;
-    case research_interface::robot::RobotMode::kUserStopped:
-      converted.robot_mode = RobotMode::kUserStopped;
-      break;
-    case research_interface::robot::RobotMode::kAutomaticErrorRecovery:
-      converted.robot_mode = RobotMode::kAutomaticErrorRecovery;
-      break;
+Model Robot::Impl::loadModel(const std::string& cache_directory) const {
+  return Model(*network_, cache_directory, ri_version_);
+}
+
+ControlStatisticsRecorder* Robot::Impl::controlStatisticsRecorder() noexcept {
+  return statistics_.active() ? &statistics_ : nullptr;
+}
+
+void Robot::Impl::setControlStatisticsEnabled(bool enabled) noexcept {
+  statistics_.setEnabled(enabled);
+  state_received_time_ = {};
+}
+
+ControlStatistics Robot::Impl::controlStatistics() const noexcept {
+  return statistics_.statistics();
+}
+
+void Robot::Impl::resetControlStatistics() noexcept {
+  statistics_.reset();
+}
+
+LimitingStatisticsRecorder* Robot::Impl::limitingStatisticsRecorder() noexcept {
+  return limiting_statistics_.active() ? &limiting_statistics_ : nullptr;
+}
+
+void Robot::Impl::setLimitingStatisticsEnabled(bool enabled) noexcept {
+  limiting_statistics_.setEnabled(enabled);
+}
+
+LimitingStatistics Robot::Impl::limitingStatistics() const noexcept {
+  return limiting_statistics_.statistics();
+}
+
+void Robot::Impl::resetLimitingStatistics() noexcept {
+  limiting_statistics_.reset();
+}
+
+void Robot::Impl::setCommunicationStatisticsEnabled(bool enabled) noexcept {
+  communication_statistics_.setEnabled(enabled);
+  communication_statistics_.restart();
+  round_trip_start_ = {};
+}
+
+CommunicationStatistics Robot::Impl::communicationStatistics() const noexcept {
+  return communication_statistics_.statistics();
+}
+
+ClockEstimate Robot::Impl::clockEstimate() const noexcept {
+  return clock_estimator_.estimate();
+}
+
+void Robot::Impl::resetCommunicationStatistics() noexcept {
+  communication_statistics_.reset();
+}
+
+void Robot::Impl::setCommunicationStatisticsCallback(CommunicationStatisticsCallback callback,
+                                                     double success_rate_threshold) {
+  communication_callback_ = std::move(callback);
+  success_rate_threshold_ = success_rate_threshold;
+}
+
+void Robot::Impl::beginStateSequence() noexcept {
+  communication_statistics_.restart();
+  round_trip_start_ = {};
+}
+
+const JointStateEstimatorParameters* Robot::Impl::jointStateEstimatorParameters() const noexcept {
+  return joint_state_estimation_ ? &joint_state_estimator_parameters_ : nullptr;
+}
+
+void Robot::Impl::setJointStateEstimation(bool enabled,
+                                          const JointStateEstimatorParameters& parameters) {
+  if (enabled) {
+    // Throws if the parameters are invalid.
+    static_cast<void>(JointStateEstimator(parameters));
+  }
+  joint_state_estimation_ = enabled;
+  joint_state_estimator_parameters_ = parameters;
+}
+
+const Model* Robot::Impl::statePredictionModel() const noexcept {
+  return state_prediction_model_;
+}
+
+void Robot::Impl::setStatePrediction(const Model* model) noexcept {
+  state_prediction_model_ = model;
+}
+
+MomentumObserver* Robot::Impl::momentumObserver() noexcept {
+  return momentum_observer_;
+}
+
+const Model* Robot::Impl::momentumObserverModel() const noexcept {
+  return momentum_observer_model_;
+}
+
+void Robot::Impl::setMomentumObserver(MomentumObserver* observer, const Model* model) noexcept {
+  if (observer == nullptr || model == nullptr) {
+    observer = nullptr;
+    model = nullptr;
   }
+  momentum_observer_ = observer;
+  momentum_observer_model_ = model;
+}
+
+PassivityController* Robot::Impl::passivityController() noexcept {
+  return passivity_control_ ? &passivity_controller_ : nullptr;
+}
+
+void Robot::Impl::setPassivityControl(bool enabled,
+                                      const PassivityControllerParameters& parameters) {
+  if (enabled) {
+    passivity_controller_ = PassivityController(parameters);
+  }
+  passivity_control_ = enabled;
+}
+
+PassivityStatistics Robot::Impl::passivityStatistics() const noexcept {
+  return passivity_controller_.statistics();
+}
+
+void Robot::Impl::resetPassivityStatistics() noexcept {
+  passivity_controller_.resetStatistics();
+}
+
+bool Robot::Impl::onlineTrajectoryGeneration() const noexcept {
+  return online_trajectory_generation_;
+}
+
+void Robot::Impl::setOnlineTrajectoryGeneration(bool enabled) noexcept {
+  online_trajectory_generation_ = enabled;
+}
+
+const CallbackDeadline* Robot::Impl::callbackDeadline() const noexcept {
+  return callback_deadline_enabled_ ? &callback_deadline_ : nullptr;
+}
+
+DeadlineStatistics* Robot::Impl::deadlineStatistics() noexcept {
+  return &deadline_statistics_;
+}
+
+void Robot::Impl::setCallbackDeadline(bool enabled, const CallbackDeadline& deadline) {
+  if (enabled) {
+    if (deadline.budget <= std::chrono::microseconds::zero() ||
+        deadline.budget >= std::chrono::microseconds(1000)) {
+      throw std::invalid_argument(
+          "libfranka: Callback deadline budget must be positive and less than 1 ms.");
+    }
+    if (!(deadline.torque_decay >= 0.0 && deadline.torque_decay <= 1.0)) {
+      throw std::invalid_argument("libfranka: Torque decay must be within [0, 1].");
+    }
+    if (deadline.max_consecutive_misses == 0) {
+      throw std::invalid_argument("libfranka: Number of consecutive misses must be positive.");
+    }
+    callback_deadline_ = deadline;
+    deadline_statistics_ = {};
+  }
+  callback_deadline_enabled_ = enabled;
+}
+
+ValidationPolicy Robot::Impl::validationPolicy() const noexcept {
+  return validation_policy_;
+}
+
+void Robot::Impl::setValidationPolicy(ValidationPolicy policy) noexcept {
+  validation_policy_ = policy;
+}
+
+void Robot::Impl::setStreamingRecorder(std::shared_ptr<StreamingRecorder> recorder) noexcept {
+  recorder_ = std::move(recorder);
+}
+
+void Robot::Impl::setStatePublisher(std::shared_ptr<StatePublisher> publisher) noexcept {
+  publisher_ = std::move(publisher);
+}
+
+void Robot::Impl::setSharedMemoryMetrics(std::shared_ptr<SharedMemoryMetrics> metrics) noexcept {
+  metrics_ = std::move(metrics);
+  MetricsSegment* segment = metrics_ ? &metrics_->segment() : nullptr;
+  statistics_.setMetrics(segment);
+  limiting_statistics_.setMetrics(segment);
+  state_received_time_ = {};
+}
+
+void Robot::Impl::setFlightRecorder(std::shared_ptr<FlightRecorder> recorder) noexcept {
+  flight_recorder_ = std::move(recorder);
+}
+
+void Robot::Impl::setStateBroadcaster(std::shared_ptr<StateBroadcaster> broadcaster) noexcept {
+  broadcaster_ = std::move(broadcaster);
+}
 
-  return converted;
+size_t Robot::Impl::loadRecomputeCount() const noexcept {
+  return load_cache_.recomputeCount();
 }
 
 }  // namespace franka
@@ -6,36 +6,101 @@
 #include <memory>
 #include <sstream>
 #include <type_traits>
+#include <vector>
 
+#include <franka/command_types.h>
 #include <franka/model.h>
 #include <franka/robot.h>
+#include <franka/robot_state_view.h>
 #include <research_interface/robot/rbk_types.h>
 #include <research_interface/robot/service_traits.h>
 #include <research_interface/robot/service_types.h>
 
+#include "communication_statistics_recorder.h"
 #include "logger.h"
 #include "network.h"
 #include "robot_control.h"
+#include "robot_state_conversion.h"
 
 namespace franka {
 
-RobotState convertRobotState(const research_interface::robot::RobotState& robot_state) noexcept;
-
 class Robot::Impl : public RobotControl {
  public:
   explicit Impl(std::unique_ptr<Network> network,
                 size_t log_size,
-                RealtimeConfig realtime_config = RealtimeConfig::kEnforce);
+                RealtimeConfig realtime_config = RealtimeConfig::kEnforce,
+                const RealtimeOptions& realtime_options = RealtimeOptions(),
+                LogFields log_fields = LogFields::kAll,
+                const LogCompression& log_compression = LogCompression());
 
   RobotState update(const research_interface::robot::MotionGeneratorCommand* motion_command,
                     const research_interface::robot::ControllerCommand* control_command) override;
 
+  RobotStateView updateView(
+      const research_interface::robot::MotionGeneratorCommand* motion_command,
+      const research_interface::robot::ControllerCommand* control_command) override;
+
   void throwOnMotionError(const RobotState& robot_state, uint32_t motion_id) override;
+  void throwOnMotionError(const RobotStateView& robot_state, uint32_t motion_id) override;
 
   RobotState readOnce();
 
+  /**
+   * Connects over the given network and replaces the current connection with it. Keeps all
+   * settings and the datagram recorder of the current connection.
+   *
+   * @throw NetworkException if the connection is unsuccessful.
+   * @throw IncompatibleVersionException if this version of `libfranka` is not supported.
+   */
+  void reconnect(std::unique_ptr<Network> network);
+
   ServerVersion serverVersion() const noexcept;
+  size_t logSnapshot(Record* records, size_t count) const noexcept;
   RealtimeConfig realtimeConfig() const noexcept override;
+  const RealtimeOptions& realtimeOptions() const noexcept override;
+  ControlStatisticsRecorder* controlStatisticsRecorder() noexcept override;
+  LimitingStatisticsRecorder* limitingStatisticsRecorder() noexcept override;
+  const JointStateEstimatorParameters* jointStateEstimatorParameters() const noexcept override;
+  const Model* statePredictionModel() const noexcept override;
+  MomentumObserver* momentumObserver() noexcept override;
+  const Model* momentumObserverModel() const noexcept override;
+  PassivityController* passivityController() noexcept override;
+  bool onlineTrajectoryGeneration() const noexcept override;
+  const CallbackDeadline* callbackDeadline() const noexcept override;
+  DeadlineStatistics* deadlineStatistics() noexcept override;
+  ValidationPolicy validationPolicy() const noexcept override;
+
+  void setControlStatisticsEnabled(bool enabled) noexcept;
+  ControlStatistics controlStatistics() const noexcept;
+  void resetControlStatistics() noexcept;
+  void setLimitingStatisticsEnabled(bool enabled) noexcept;
+  LimitingStatistics limitingStatistics() const noexcept;
+  void resetLimitingStatistics() noexcept;
+  void setCommunicationStatisticsEnabled(bool enabled) noexcept;
+  CommunicationStatistics communicationStatistics() const noexcept;
+  ClockEstimate clockEstimate() const noexcept;
+  void resetCommunicationStatistics() noexcept;
+  void setCommunicationStatisticsCallback(CommunicationStatisticsCallback callback,
+                                          double success_rate_threshold);
+  /**
+   * Starts a new sequence of consecutive robot states for the communication statistics, so that
+   * states missed before it are not counted as lost.
+   */
+  void beginStateSequence() noexcept;
+  void setJointStateEstimation(bool enabled, const JointStateEstimatorParameters& parameters);
+  void setStatePrediction(const Model* model) noexcept;
+  void setMomentumObserver(MomentumObserver* observer, const Model* model) noexcept;
+  void setPassivityControl(bool enabled, const PassivityControllerParameters& parameters);
+  PassivityStatistics passivityStatistics() const noexcept;
+  void resetPassivityStatistics() noexcept;
+  void setOnlineTrajectoryGeneration(bool enabled) noexcept;
+  void setCallbackDeadline(bool enabled, const CallbackDeadline& deadline);
+  void setValidationPolicy(ValidationPolicy policy) noexcept;
+  void setStreamingRecorder(std::shared_ptr<StreamingRecorder> recorder) noexcept;
+  void setStatePublisher(std::shared_ptr<StatePublisher> publisher) noexcept;
+  void setSharedMemoryMetrics(std::shared_ptr<SharedMemoryMetrics> metrics) noexcept;
+  void setFlightRecorder(std::shared_ptr<FlightRecorder> recorder) noexcept;
+  void setStateBroadcaster(std::shared_ptr<StateBroadcaster> broadcaster) noexcept;
 
   uint32_t startMotion(
       research_interface::robot::Move::ControllerMode controller_mode,
@@ -47,10 +112,92 @@ class Robot::Impl : public RobotControl {
                     const research_interface::robot::MotionGeneratorCommand* motion_command,
                     const research_interface::robot::ControllerCommand* control_command) override;
 
+  /**
+   * Sends the Move command of a motion without waiting until the motion has started.
+   *
+   * Like startMotion(), makes the calling thread the owner of the UDP socket.
+   *
+   * @return ID of the Move command.
+   */
+  uint32_t requestMotion(
+      research_interface::robot::Move::ControllerMode controller_mode,
+      research_interface::robot::Move::MotionGeneratorMode motion_generator_mode,
+      const research_interface::robot::Move::Deviation& maximum_path_deviation,
+      const research_interface::robot::Move::Deviation& maximum_goal_pose_deviation);
+
+  /**
+   * @param[in] motion_id ID returned by requestMotion().
+   *
+   * @return True if the last robot state shows the requested motion, or if the Move command has
+   * already been answered.
+   */
+  bool motionStarted(uint32_t motion_id);
+
+  /**
+   * @return True if the last robot state shows a running motion generator or controller.
+   */
+  bool motionRunning() const noexcept;
+
+  /**
+   * Waits for the response to the Move command of a motion that the robot has stopped, and
+   * releases the UDP socket ownership.
+   *
+   * @param[in] motion_id ID of the Move command.
+   * @param[in] last_motion_errors Errors of the last robot state, reported if the motion failed.
+   */
+  void completeMotion(uint32_t motion_id, const Errors& last_motion_errors);
+
+  /**
+   * Sends a robot command without waiting for the next robot state.
+   */
+  void sendCommand(const research_interface::robot::MotionGeneratorCommand* motion_command,
+                   const research_interface::robot::ControllerCommand* control_command);
+
+  /**
+   * Receives the most recent robot state queued on the UDP socket without blocking.
+   *
+   * @param[out] robot_state Written with the received state if it is newer than the last one.
+   *
+   * @return True if a newer robot state has been received.
+   */
+  bool receiveState(RobotState* robot_state);
+
+  Network& network() noexcept;
+
   template <typename T, typename... TArgs>
   uint32_t executeCommand(TArgs... /* args */);
 
+  /**
+   * Sends a T::Request without waiting for the response.
+   *
+   * @return ID of the command, to be passed to receiveResponse().
+   */
+  template <typename T, typename... TArgs>
+  uint32_t sendRequest(TArgs... /* args */);
+
+  /**
+   * Waits for the response to a command sent with sendRequest().
+   *
+   * @throw CommandException if the Control rejected the command.
+   * @throw ProtocolException if the response is unexpected.
+   */
+  template <typename T>
+  void receiveResponse(uint32_t command_id);
+
+  /**
+   * Sends all commands of the batch, then waits for their responses.
+   *
+   * @return Result of every command, in the order of the batch.
+   */
+  std::vector<CommandResult> execute(const CommandBatch::Impl& batch);
+
   Model loadModel() const;
+  Model loadModel(const std::string& cache_directory) const;
+
+  /**
+   * @return Number of times the combined end effector and load parameters were recomputed.
+   */
+  size_t loadRecomputeCount() const noexcept;
 
  protected:
   bool motionGeneratorRunning() const noexcept;
@@ -108,17 +255,65 @@ class Robot::Impl : public RobotControl {
     }
   }
 
-  research_interface::robot::RobotCommand sendRobotCommand(
+  // Fills the command buffer of the current motion with the given commands and sends it. Returns
+  // the sent command, or an empty command if nothing has been sent.
+  const research_interface::robot::RobotCommand& sendRobotCommand(
+      const research_interface::robot::MotionGeneratorCommand* motion_command,
+      const research_interface::robot::ControllerCommand* control_command);
+  [[noreturn]] void throwInvalidRobotCommand(
       const research_interface::robot::MotionGeneratorCommand* motion_command,
       const research_interface::robot::ControllerCommand* control_command) const;
+  void resetMotionModes() noexcept;
   research_interface::robot::RobotState receiveRobotState();
+  void exchangeRobotState(const research_interface::robot::MotionGeneratorCommand* motion_command,
+                          const research_interface::robot::ControllerCommand* control_command);
   void updateState(const research_interface::robot::RobotState& robot_state);
+  void recordState(const research_interface::robot::RobotCommand& robot_command);
+  // Records the time since the kernel received the current robot state into the given stage.
+  void recordKernelTimeSince(ControlStatisticsRecorder::Stage stage) noexcept;
+
+  bool motionErrorDetected(RobotMode robot_mode) const noexcept;
+  [[noreturn]] void throwMotionError(uint32_t motion_id, const Errors& last_motion_errors);
 
   std::unique_ptr<Network> network_;
 
   Logger logger_;
-
-  const RealtimeConfig realtime_config_;  // NOLINT(readability-identifier-naming)
+  research_interface::robot::RobotState robot_state_{};
+  CombinedLoadCache load_cache_;
+
+  ControlStatisticsRecorder statistics_;
+  ControlStatisticsRecorder::Clock::time_point state_received_time_{};
+  ControlStatisticsRecorder::Clock::time_point command_sent_time_{};
+  // Kernel receive time of the current robot state, or the epoch if not reported.
+  std::chrono::system_clock::time_point state_kernel_time_{};
+  ClockEstimator clock_estimator_;
+  research_interface::robot::RobotCommand sent_command_{};
+  LimitingStatisticsRecorder limiting_statistics_;
+  CommunicationStatisticsRecorder communication_statistics_;
+  CommunicationStatisticsCallback communication_callback_;
+  double success_rate_threshold_{0.0};
+  ControlStatisticsRecorder::Clock::time_point round_trip_start_{};
+  bool joint_state_estimation_{false};
+  JointStateEstimatorParameters joint_state_estimator_parameters_;
+  const Model* state_prediction_model_{nullptr};
+  MomentumObserver* momentum_observer_{nullptr};
+  const Model* momentum_observer_model_{nullptr};
+  bool passivity_control_{false};
+  PassivityController passivity_controller_;
+  bool online_trajectory_generation_{false};
+  bool callback_deadline_enabled_{false};
+  CallbackDeadline callback_deadline_;
+  DeadlineStatistics deadline_statistics_;
+  ValidationPolicy validation_policy_{ValidationPolicy::kFull};
+
+  std::shared_ptr<StreamingRecorder> recorder_;
+  std::shared_ptr<StatePublisher> publisher_;
+  std::shared_ptr<SharedMemoryMetrics> metrics_;
+  std::shared_ptr<FlightRecorder> flight_recorder_;
+  std::shared_ptr<StateBroadcaster> broadcaster_;
+
+  const RealtimeConfig realtime_config_;    // NOLINT(readability-identifier-naming)
+  const RealtimeOptions realtime_options_;  // NOLINT(readability-identifier-naming)
   uint16_t ri_version_;
 
   research_interface::robot::RobotMode robot_mode_ = research_interface::robot::RobotMode::kOther;
@@ -129,6 +324,14 @@ class Robot::Impl : public RobotControl {
       research_interface::robot::ControllerMode::kOther;
   research_interface::robot::ControllerMode current_move_controller_mode_;
   uint64_t message_id_;
+
+  // Bits of the command parts (kMotionCommandPart, kControlCommandPart) that the current motion
+  // sends on every cycle, set once in requestMotion().
+  static constexpr uint8_t kMotionCommandPart = 1;
+  static constexpr uint8_t kControlCommandPart = 2;
+  uint8_t command_parts_{0};
+  // Reused for every command of a motion, so that it is neither zeroed nor validated per cycle.
+  research_interface::robot::RobotCommand command_buffer_{};
 };
 
 template <>
@@ -275,10 +478,20 @@ inline void Robot::Impl::handleCommandResponse<research_interface::robot::Automa
 
 template <typename T, typename... TArgs>
 uint32_t Robot::Impl::executeCommand(TArgs... args) {
-  uint32_t command_id = network_->tcpSendRequest<T>(args...);
+  uint32_t command_id = sendRequest<T>(args...);
+  receiveResponse<T>(command_id);
+  return command_id;
+}
+
+template <typename T, typename... TArgs>
+uint32_t Robot::Impl::sendRequest(TArgs... args) {
+  return network_->tcpSendRequest<T>(args...);
+}
+
+template <typename T>
+void Robot::Impl::receiveResponse(uint32_t command_id) {
   typename T::Response response = network_->tcpBlockingReceiveResponse<T>(command_id);
   handleCommandResponse<T>(response);
-  return command_id;
 }
 
 template <>
@@ -0,0 +1,54 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/robot_startup.h>
+
+#include <future>
+#include <memory>
+#include <utility>
+
+#include "network.h"
+#include "robot_impl.h"
+
+namespace franka {
+
+namespace {
+
+std::unique_ptr<Robot::Impl> connectRobot(const std::string& franka_address,
+                                          const StartupOptions& options) {
+  return std::make_unique<Robot::Impl>(
+      std::make_unique<Network>(franka_address, research_interface::robot::kCommandPort),
+      options.log_size, options.realtime_config, options.realtime_options);
+}
+
+}  // anonymous namespace
+
+RobotStartup startRobot(const std::string& franka_address,
+                        const CommandBatch& configuration,
+                        const StartupOptions& options) {
+  std::unique_ptr<Robot::Impl> impl = connectRobot(franka_address, options);
+  Network& network = impl->network();
+  const Robot::ServerVersion server_version = impl->serverVersion();
+  Robot robot(std::move(impl));
+
+  // The network supports concurrent requests and waiters, so the download and the configuration
+  // commands share the connection. The future is declared after the robot, so that it is waited
+  // for before the connection is closed, even if the configuration throws.
+  std::future<Model> model = std::async(std::launch::async, [&]() {
+    return options.model_cache_directory.empty()
+               ? Model(network)
+               : Model(network, options.model_cache_directory, server_version);
+  });
+  std::vector<CommandResult> results = robot.execute(configuration);
+  return RobotStartup{std::move(robot), model.get(), std::move(results)};
+}
+
+RobotStartup startRobot(const std::string& franka_address,
+                        Model&& model,
+                        const CommandBatch& configuration,
+                        const StartupOptions& options) {
+  Robot robot(connectRobot(franka_address, options));
+  std::vector<CommandResult> results = robot.execute(configuration);
+  return RobotStartup{std::move(robot), std::move(model), std::move(results)};
+}
+
+}  // namespace franka
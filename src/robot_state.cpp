@@ -66,7 +66,7 @@ std::ostream& operator<<(std::ostream& ostream, const franka::RobotState& robot_
           << ", \"tau_J_d\": " << robot_state.tau_J_d << ", \"dtau_J\": " << robot_state.dtau_J
           << ", \"q\": " << robot_state.q << ", \"dq\": " << robot_state.dq
           << ", \"q_d\": " << robot_state.q_d << ", \"dq_d\": " << robot_state.dq_d
-          << ", \"ddq_d\": " << robot_state.ddq_d
+          << ", \"ddq_d\": " << robot_state.ddq_d << ", \"ddq_hat\": " << robot_state.ddq_hat
           << ", \"joint_contact\": " << robot_state.joint_contact
           << ", \"cartesian_contact\": " << robot_state.cartesian_contact
           << ", \"joint_collision\": " << robot_state.joint_collision
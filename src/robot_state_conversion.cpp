@@ -0,0 +1,95 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "robot_state_conversion.h"
+
+namespace franka {
+
+RobotMode convertRobotMode(research_interface::robot::RobotMode robot_mode) noexcept {
+  switch (robot_mode) {
+    case research_interface::robot::RobotMode::kOther:
+      return RobotMode::kOther;
+    case research_interface::robot::RobotMode::kIdle:
+      return RobotMode::kIdle;
+    case research_interface::robot::RobotMode::kMove:
+      return RobotMode::kMove;
+    case research_interface::robot::RobotMode::kGuiding:
+      return RobotMode::kGuiding;
+    case research_interface::robot::RobotMode::kReflex:
+      return RobotMode::kReflex;
+    case research_interface::robot::RobotMode::kUserStopped:
+      return RobotMode::kUserStopped;
+    case research_interface::robot::RobotMode::kAutomaticErrorRecovery:
+      return RobotMode::kAutomaticErrorRecovery;
+  }
+
+  return RobotMode::kOther;
+}
+
+void convertRobotState(const research_interface::robot::RobotState& robot_state,
+                       RobotState* converted) noexcept {
+  CombinedLoadCache load_cache;
+  convertRobotState(robot_state, &load_cache, converted);
+}
+
+void convertRobotState(const research_interface::robot::RobotState& robot_state,
+                       CombinedLoadCache* load_cache,
+                       RobotState* converted) noexcept {
+  converted->O_T_EE = robot_state.O_T_EE;
+  converted->O_T_EE_d = robot_state.O_T_EE_d;
+  converted->F_T_NE = robot_state.F_T_NE;
+  converted->NE_T_EE = robot_state.NE_T_EE;
+  converted->F_T_EE = robot_state.F_T_EE;
+  converted->EE_T_K = robot_state.EE_T_K;
+  converted->m_ee = robot_state.m_ee;
+  converted->F_x_Cee = robot_state.F_x_Cee;
+  converted->I_ee = robot_state.I_ee;
+  converted->m_load = robot_state.m_load;
+  converted->F_x_Cload = robot_state.F_x_Cload;
+  converted->I_load = robot_state.I_load;
+  load_cache->update(robot_state.m_ee, robot_state.F_x_Cee, robot_state.I_ee, robot_state.m_load,
+                     robot_state.F_x_Cload, robot_state.I_load);
+  converted->m_total = load_cache->m_total();
+  converted->F_x_Ctotal = load_cache->F_x_Ctotal();
+  converted->I_total = load_cache->I_total();
+  converted->elbow = robot_state.elbow;
+  converted->elbow_d = robot_state.elbow_d;
+  converted->elbow_c = robot_state.elbow_c;
+  converted->delbow_c = robot_state.delbow_c;
+  converted->ddelbow_c = robot_state.ddelbow_c;
+  converted->tau_J = robot_state.tau_J;
+  converted->tau_J_d = robot_state.tau_J_d;
+  converted->dtau_J = robot_state.dtau_J;
+  converted->q = robot_state.q;
+  converted->dq = robot_state.dq;
+  converted->q_d = robot_state.q_d;
+  converted->dq_d = robot_state.dq_d;
+  converted->ddq_d = robot_state.ddq_d;
+  converted->joint_contact = robot_state.joint_contact;
+  converted->cartesian_contact = robot_state.cartesian_contact;
+  converted->joint_collision = robot_state.joint_collision;
+  converted->cartesian_collision = robot_state.cartesian_collision;
+  converted->tau_ext_hat_filtered = robot_state.tau_ext_hat_filtered;
+  converted->O_F_ext_hat_K = robot_state.O_F_ext_hat_K;
+  converted->K_F_ext_hat_K = robot_state.K_F_ext_hat_K;
+  converted->O_dP_EE_d = robot_state.O_dP_EE_d;
+  converted->O_ddP_O = robot_state.O_ddP_O;
+  converted->O_T_EE_c = robot_state.O_T_EE_c;
+  converted->O_dP_EE_c = robot_state.O_dP_EE_c;
+  converted->O_ddP_EE_c = robot_state.O_ddP_EE_c;
+  converted->theta = robot_state.theta;
+  converted->dtheta = robot_state.dtheta;
+  converted->current_errors = robot_state.errors;
+  converted->last_motion_errors = robot_state.reflex_reason;
+  converted->control_command_success_rate = robot_state.control_command_success_rate;
+  converted->time = Duration(robot_state.message_id);
+
+  converted->robot_mode = convertRobotMode(robot_state.robot_mode);
+}
+
+RobotState convertRobotState(const research_interface::robot::RobotState& robot_state) noexcept {
+  RobotState converted;
+  convertRobotState(robot_state, &converted);
+  return converted;
+}
+
+}  // namespace franka
@@ -0,0 +1,21 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <franka/robot_state.h>
+#include <research_interface/robot/rbk_types.h>
+
+#include "load_calculations.h"
+
+namespace franka {
+
+RobotMode convertRobotMode(research_interface::robot::RobotMode robot_mode) noexcept;
+
+void convertRobotState(const research_interface::robot::RobotState& robot_state,
+                       RobotState* converted) noexcept;
+void convertRobotState(const research_interface::robot::RobotState& robot_state,
+                       CombinedLoadCache* load_cache,
+                       RobotState* converted) noexcept;
+RobotState convertRobotState(const research_interface::robot::RobotState& robot_state) noexcept;
+
+}  // namespace franka
@@ -0,0 +1,210 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/robot_state_view.h>
+
+#include <research_interface/robot/rbk_types.h>
+
+#include "load_calculations.h"
+#include "robot_state_conversion.h"
+
+namespace franka {
+
+RobotStateView::RobotStateView(const research_interface::robot::RobotState& robot_state) noexcept
+    : robot_state_(&robot_state) {}
+
+RobotState RobotStateView::toRobotState() const noexcept {
+  return convertRobotState(*robot_state_);
+}
+
+const std::array<double, 16>& RobotStateView::O_T_EE() const noexcept {
+  return robot_state_->O_T_EE;
+}
+
+const std::array<double, 16>& RobotStateView::O_T_EE_d() const noexcept {
+  return robot_state_->O_T_EE_d;
+}
+
+const std::array<double, 16>& RobotStateView::F_T_EE() const noexcept {
+  return robot_state_->F_T_EE;
+}
+
+const std::array<double, 16>& RobotStateView::F_T_NE() const noexcept {
+  return robot_state_->F_T_NE;
+}
+
+const std::array<double, 16>& RobotStateView::NE_T_EE() const noexcept {
+  return robot_state_->NE_T_EE;
+}
+
+const std::array<double, 16>& RobotStateView::EE_T_K() const noexcept {
+  return robot_state_->EE_T_K;
+}
+
+double RobotStateView::m_ee() const noexcept {
+  return robot_state_->m_ee;
+}
+
+const std::array<double, 9>& RobotStateView::I_ee() const noexcept {
+  return robot_state_->I_ee;
+}
+
+const std::array<double, 3>& RobotStateView::F_x_Cee() const noexcept {
+  return robot_state_->F_x_Cee;
+}
+
+double RobotStateView::m_load() const noexcept {
+  return robot_state_->m_load;
+}
+
+const std::array<double, 9>& RobotStateView::I_load() const noexcept {
+  return robot_state_->I_load;
+}
+
+const std::array<double, 3>& RobotStateView::F_x_Cload() const noexcept {
+  return robot_state_->F_x_Cload;
+}
+
+double RobotStateView::m_total() const noexcept {
+  return robot_state_->m_ee + robot_state_->m_load;
+}
+
+std::array<double, 9> RobotStateView::I_total() const noexcept {
+  return combineInertiaTensor(robot_state_->m_ee, robot_state_->F_x_Cee, robot_state_->I_ee,
+                              robot_state_->m_load, robot_state_->F_x_Cload, robot_state_->I_load,
+                              m_total(), F_x_Ctotal());
+}
+
+std::array<double, 3> RobotStateView::F_x_Ctotal() const noexcept {
+  return combineCenterOfMass(robot_state_->m_ee, robot_state_->F_x_Cee, robot_state_->m_load,
+                             robot_state_->F_x_Cload);
+}
+
+const std::array<double, 2>& RobotStateView::elbow() const noexcept {
+  return robot_state_->elbow;
+}
+
+const std::array<double, 2>& RobotStateView::elbow_d() const noexcept {
+  return robot_state_->elbow_d;
+}
+
+const std::array<double, 2>& RobotStateView::elbow_c() const noexcept {
+  return robot_state_->elbow_c;
+}
+
+const std::array<double, 2>& RobotStateView::delbow_c() const noexcept {
+  return robot_state_->delbow_c;
+}
+
+const std::array<double, 2>& RobotStateView::ddelbow_c() const noexcept {
+  return robot_state_->ddelbow_c;
+}
+
+const std::array<double, 7>& RobotStateView::tau_J() const noexcept {
+  return robot_state_->tau_J;
+}
+
+const std::array<double, 7>& RobotStateView::tau_J_d() const noexcept {
+  return robot_state_->tau_J_d;
+}
+
+const std::array<double, 7>& RobotStateView::dtau_J() const noexcept {
+  return robot_state_->dtau_J;
+}
+
+const std::array<double, 7>& RobotStateView::q() const noexcept {
+  return robot_state_->q;
+}
+
+const std::array<double, 7>& RobotStateView::q_d() const noexcept {
+  return robot_state_->q_d;
+}
+
+const std::array<double, 7>& RobotStateView::dq() const noexcept {
+  return robot_state_->dq;
+}
+
+const std::array<double, 7>& RobotStateView::dq_d() const noexcept {
+  return robot_state_->dq_d;
+}
+
+const std::array<double, 7>& RobotStateView::ddq_d() const noexcept {
+  return robot_state_->ddq_d;
+}
+
+const std::array<double, 7>& RobotStateView::joint_contact() const noexcept {
+  return robot_state_->joint_contact;
+}
+
+const std::array<double, 6>& RobotStateView::cartesian_contact() const noexcept {
+  return robot_state_->cartesian_contact;
+}
+
+const std::array<double, 7>& RobotStateView::joint_collision() const noexcept {
+  return robot_state_->joint_collision;
+}
+
+const std::array<double, 6>& RobotStateView::cartesian_collision() const noexcept {
+  return robot_state_->cartesian_collision;
+}
+
+const std::array<double, 7>& RobotStateView::tau_ext_hat_filtered() const noexcept {
+  return robot_state_->tau_ext_hat_filtered;
+}
+
+const std::array<double, 6>& RobotStateView::O_F_ext_hat_K() const noexcept {
+  return robot_state_->O_F_ext_hat_K;
+}
+
+const std::array<double, 6>& RobotStateView::K_F_ext_hat_K() const noexcept {
+  return robot_state_->K_F_ext_hat_K;
+}
+
+const std::array<double, 6>& RobotStateView::O_dP_EE_d() const noexcept {
+  return robot_state_->O_dP_EE_d;
+}
+
+const std::array<double, 3>& RobotStateView::O_ddP_O() const noexcept {
+  return robot_state_->O_ddP_O;
+}
+
+const std::array<double, 16>& RobotStateView::O_T_EE_c() const noexcept {
+  return robot_state_->O_T_EE_c;
+}
+
+const std::array<double, 6>& RobotStateView::O_dP_EE_c() const noexcept {
+  return robot_state_->O_dP_EE_c;
+}
+
+const std::array<double, 6>& RobotStateView::O_ddP_EE_c() const noexcept {
+  return robot_state_->O_ddP_EE_c;
+}
+
+const std::array<double, 7>& RobotStateView::theta() const noexcept {
+  return robot_state_->theta;
+}
+
+const std::array<double, 7>& RobotStateView::dtheta() const noexcept {
+  return robot_state_->dtheta;
+}
+
+Errors RobotStateView::current_errors() const noexcept {
+  return Errors(robot_state_->errors);
+}
+
+Errors RobotStateView::last_motion_errors() const noexcept {
+  return Errors(robot_state_->reflex_reason);
+}
+
+double RobotStateView::control_command_success_rate() const noexcept {
+  return robot_state_->control_command_success_rate;
+}
+
+RobotMode RobotStateView::robot_mode() const noexcept {
+  return convertRobotMode(robot_state_->robot_mode);
+}
+
+Duration RobotStateView::time() const noexcept {
+  return Duration(robot_state_->message_id);
+}
+
+}  // namespace franka
@@ -0,0 +1,289 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/self_collision.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace franka {
+
+namespace {
+
+using Vector3d = Eigen::Vector3d;
+using Column = Eigen::Map<Eigen::ArrayXd>;
+
+// Columns of the pair buffer. Vectors take three consecutive columns.
+enum PairColumn : size_t {
+  kStartA = 0,
+  kDirectionA = 3,
+  kStartB = 6,
+  kDirectionB = 9,
+  kRadius = 12,
+  kDotAA,
+  kDotAB,
+  kDotAR,
+  kDotBB,
+  kDotBR,
+  kS,
+  kT,
+  kDistance,
+  kPairColumns
+};
+
+// Links that touch each other at a joint. The flange and the frames attached to it move with the
+// last link.
+size_t link(Frame frame) noexcept {
+  return std::min(static_cast<size_t>(frame), static_cast<size_t>(Frame::kJoint7));
+}
+
+bool isFinite(const std::array<double, 3>& vector) {
+  return std::all_of(vector.begin(), vector.end(), [](double d) { return std::isfinite(d); });
+}
+
+void checkCapsules(const std::vector<Capsule>& capsules, bool check_frames) {
+  for (const Capsule& capsule : capsules) {
+    if ((check_frames && static_cast<size_t>(capsule.frame) >= kFrameCount) ||
+        !isFinite(capsule.start) || !isFinite(capsule.end) || !(capsule.radius >= 0) ||
+        !std::isfinite(capsule.radius)) {
+      throw std::invalid_argument("libfranka: Collision capsule is invalid.");
+    }
+  }
+}
+
+Capsule capsule(Frame frame,
+                const std::array<double, 3>& start,
+                const std::array<double, 3>& end,
+                double radius) {
+  Capsule result;
+  result.frame = frame;
+  result.start = start;
+  result.end = end;
+  result.radius = radius;
+  return result;
+}
+
+}  // anonymous namespace
+
+std::vector<Capsule> SelfCollisionChecker::defaultCapsules() {
+  return {
+      capsule(Frame::kJoint1, {{0, 0, -0.2}}, {{0, 0, -0.06}}, 0.075),
+      capsule(Frame::kJoint2, {{0, 0, -0.07}}, {{0, 0, 0.07}}, 0.075),
+      capsule(Frame::kJoint2, {{0, -0.06, 0}}, {{0, -0.16, 0}}, 0.06),
+      capsule(Frame::kJoint3, {{0, 0, -0.16}}, {{0, 0, -0.04}}, 0.065),
+      capsule(Frame::kJoint4, {{0, 0, -0.06}}, {{0, 0, 0.06}}, 0.06),
+      capsule(Frame::kJoint5, {{0, 0, -0.3}}, {{0, 0, -0.17}}, 0.055),
+      capsule(Frame::kJoint6, {{0, 0, -0.03}}, {{0.08, 0, 0}}, 0.055),
+      capsule(Frame::kJoint7, {{0, 0, 0.02}}, {{0, 0, 0.08}}, 0.05),
+      capsule(Frame::kFlange, {{-0.065, -0.065, 0.065}}, {{0.065, 0.065, 0.065}}, 0.035),
+  };
+}
+
+SelfCollisionChecker::SelfCollisionChecker(std::vector<Capsule> capsules,
+                                           std::vector<Capsule> obstacles,
+                                           const SelfCollisionParameters& parameters)
+    : capsules_(std::move(capsules)), obstacles_(std::move(obstacles)), parameters_(parameters) {
+  if (!(parameters_.activation_distance >= 0) || !std::isfinite(parameters_.activation_distance) ||
+      !(parameters_.stiffness >= 0) || !std::isfinite(parameters_.stiffness) ||
+      !(parameters_.damping >= 0) || !std::isfinite(parameters_.damping)) {
+    throw std::invalid_argument("libfranka: Self-collision parameters must be non-negative.");
+  }
+  checkCapsules(capsules_, true);
+  checkCapsules(obstacles_, false);
+  buildPairs();
+}
+
+void SelfCollisionChecker::setObstacles(std::vector<Capsule> obstacles) {
+  checkCapsules(obstacles, false);
+  obstacles_ = std::move(obstacles);
+  buildPairs();
+}
+
+void SelfCollisionChecker::buildPairs() {
+  pairs_.clear();
+  for (size_t first = 0; first < capsules_.size(); first++) {
+    for (size_t second = first + 1; second < capsules_.size(); second++) {
+      size_t first_link = link(capsules_[first].frame);
+      size_t second_link = link(capsules_[second].frame);
+      if (std::max(first_link, second_link) - std::min(first_link, second_link) >= 2) {
+        pairs_.push_back({{first, second}});
+      }
+    }
+  }
+  for (size_t first = 0; first < capsules_.size(); first++) {
+    for (size_t second = 0; second < obstacles_.size(); second++) {
+      pairs_.push_back({{first, capsules_.size() + second}});
+    }
+  }
+
+  pair_buffer_.assign(kPairColumns * pairs_.size(), 0.0);
+  for (size_t pair = 0; pair < pairs_.size(); pair++) {
+    size_t second = pairs_[pair][1];
+    pair_buffer_[kRadius * pairs_.size() + pair] =
+        capsules_[pairs_[pair][0]].radius + (second < capsules_.size()
+                                                 ? capsules_[second].radius
+                                                 : obstacles_[second - capsules_.size()].radius);
+  }
+  segments_.resize(capsules_.size() + obstacles_.size());
+  for (size_t i = 0; i < obstacles_.size(); i++) {
+    std::array<double, 6>& segment = segments_[capsules_.size() + i];
+    std::copy(obstacles_[i].start.begin(), obstacles_[i].start.end(), segment.begin());
+    std::copy(obstacles_[i].end.begin(), obstacles_[i].end.end(), segment.begin() + 3);
+  }
+}
+
+SelfCollisionResult SelfCollisionChecker::check(const Model& model,
+                                                const RobotState& robot_state) noexcept {
+  model.poseAll(robot_state, &poses_, &zero_jacobians_);
+  return check(poses_, zero_jacobians_, robot_state.dq);
+}
+
+SelfCollisionResult SelfCollisionChecker::check(const FramePoses& poses,
+                                                const FrameJacobians& zero_jacobians,
+                                                const std::array<double, 7>& dq) noexcept {
+  using Jacobian = Eigen::Matrix<double, 6, 7>;
+  const Eigen::Index count = static_cast<Eigen::Index>(pairs_.size());
+  auto column = [this, count](size_t index) {
+    return Column(pair_buffer_.data() + index * pairs_.size(), count);
+  };
+
+  for (size_t i = 0; i < capsules_.size(); i++) {
+    const Capsule& capsule = capsules_[i];
+    Eigen::Map<const Eigen::Matrix4d> transform(poses[static_cast<size_t>(capsule.frame)].data());
+    Eigen::Map<Vector3d>(segments_[i].data()) =
+        transform.topLeftCorner<3, 3>() * Eigen::Map<const Vector3d>(capsule.start.data()) +
+        transform.topRightCorner<3, 1>();
+    Eigen::Map<Vector3d>(segments_[i].data() + 3) =
+        transform.topLeftCorner<3, 3>() * Eigen::Map<const Vector3d>(capsule.end.data()) +
+        transform.topRightCorner<3, 1>();
+  }
+
+  // Gather both segments of every pair into the columns of the kernel.
+  for (size_t pair = 0; pair < pairs_.size(); pair++) {
+    const std::array<double, 6>& a = segments_[pairs_[pair][0]];
+    const std::array<double, 6>& b = segments_[pairs_[pair][1]];
+    double* data = pair_buffer_.data() + pair;
+    for (size_t axis = 0; axis < 3; axis++) {
+      data[(kStartA + axis) * pairs_.size()] = a[axis];
+      data[(kDirectionA + axis) * pairs_.size()] = a[3 + axis] - a[axis];
+      data[(kStartB + axis) * pairs_.size()] = b[axis];
+      data[(kDirectionB + axis) * pairs_.size()] = b[3 + axis] - b[axis];
+    }
+  }
+
+  // Closest points of segments A(s) = a + s * u and B(t) = b + t * v with s, t in [0, 1]. The
+  // unconstrained solution for s is clamped, t is projected onto B and clamped, and s is projected
+  // back onto A and clamped, which yields the closest points without branches, also for parallel
+  // and degenerate segments.
+  if (count > 0) {
+    constexpr double kTiny = std::numeric_limits<double>::min();
+    Column aa = column(kDotAA), ab = column(kDotAB), ar = column(kDotAR);
+    Column bb = column(kDotBB), br = column(kDotBR);
+    Column s = column(kS), t = column(kT), distance = column(kDistance);
+    Column ux = column(kDirectionA), uy = column(kDirectionA + 1), uz = column(kDirectionA + 2);
+    Column vx = column(kDirectionB), vy = column(kDirectionB + 1), vz = column(kDirectionB + 2);
+    // Use the distance column as scratch for r = a - b, one axis at a time.
+    aa = ux.square() + uy.square() + uz.square();
+    bb = vx.square() + vy.square() + vz.square();
+    ab = ux * vx + uy * vy + uz * vz;
+    ar.setZero();
+    br.setZero();
+    for (size_t axis = 0; axis < 3; axis++) {
+      distance = column(kStartA + axis) - column(kStartB + axis);
+      ar += column(kDirectionA + axis) * distance;
+      br += column(kDirectionB + axis) * distance;
+    }
+    s = ((ab * br - ar * bb) / (aa * bb - ab.square()).max(kTiny)).max(0.0).min(1.0);
+    t = ((ab * s + br) / bb.max(kTiny)).max(0.0).min(1.0);
+    s = ((ab * t - ar) / aa.max(kTiny)).max(0.0).min(1.0);
+
+    // Reuse the dot product columns for the offset between the closest points.
+    ar = column(kStartA) + ux * s - column(kStartB) - vx * t;
+    br = column(kStartA + 1) + uy * s - column(kStartB + 1) - vy * t;
+    bb = column(kStartA + 2) + uz * s - column(kStartB + 2) - vz * t;
+    distance = (ar.square() + br.square() + bb.square()).sqrt() - column(kRadius);
+  }
+
+  SelfCollisionResult result;
+  result.min_distance = std::numeric_limits<double>::infinity();
+  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau(result.tau_J.data());
+  Eigen::Map<const Eigen::Matrix<double, 7, 1>> joint_velocities(dq.data());
+  const double* distances = pair_buffer_.data() + kDistance * pairs_.size();
+  for (size_t pair = 0; pair < pairs_.size(); pair++) {
+    size_t first = pairs_[pair][0];
+    size_t second = pairs_[pair][1];
+    bool obstacle = second >= capsules_.size();
+    if (distances[pair] < result.min_distance) {
+      result.min_distance = distances[pair];
+      result.nearest_link = first;
+      result.nearest_other = obstacle ? second - capsules_.size() : second;
+      result.nearest_is_obstacle = obstacle;
+    }
+    if (!(distances[pair] < parameters_.activation_distance)) {
+      continue;
+    }
+    result.active_pairs++;
+
+    const double* data = pair_buffer_.data() + pair;
+    Vector3d offset(data[kDotAR * pairs_.size()], data[kDotBR * pairs_.size()],
+                    data[kDotBB * pairs_.size()]);
+    double length = offset.norm();
+    if (!(length > 0)) {
+      continue;
+    }
+    Vector3d normal = offset / length;
+    Vector3d point_a(data[kStartA * pairs_.size()], data[(kStartA + 1) * pairs_.size()],
+                     data[(kStartA + 2) * pairs_.size()]);
+    point_a += data[kS * pairs_.size()] *
+               Vector3d(data[kDirectionA * pairs_.size()], data[(kDirectionA + 1) * pairs_.size()],
+                        data[(kDirectionA + 2) * pairs_.size()]);
+    Vector3d point_b = point_a - offset;
+
+    size_t frame_a = static_cast<size_t>(capsules_[first].frame);
+    Eigen::Map<const Jacobian> jacobian_a(zero_jacobians[frame_a].data());
+    Vector3d lever_a = point_a - Eigen::Map<const Vector3d>(&poses[frame_a][12]);
+    Vector3d velocity = jacobian_a.topRows<3>() * joint_velocities +
+                        (jacobian_a.bottomRows<3>() * joint_velocities).cross(lever_a);
+    Vector3d lever_b;
+    size_t frame_b = 0;
+    if (!obstacle) {
+      frame_b = static_cast<size_t>(capsules_[second].frame);
+      Eigen::Map<const Jacobian> jacobian_b(zero_jacobians[frame_b].data());
+      lever_b = point_b - Eigen::Map<const Vector3d>(&poses[frame_b][12]);
+      velocity -= jacobian_b.topRows<3>() * joint_velocities +
+                  (jacobian_b.bottomRows<3>() * joint_velocities).cross(lever_b);
+    }
+
+    // The normal points from B to A, so a positive force pushes A away from B and B away from A.
+    double normal_force =
+        parameters_.stiffness * (parameters_.activation_distance - distances[pair]) -
+        parameters_.damping * velocity.dot(normal);
+    Vector3d force = std::max(normal_force, 0.0) * normal;
+    tau += jacobian_a.topRows<3>().transpose() * force +
+           jacobian_a.bottomRows<3>().transpose() * lever_a.cross(force);
+    if (!obstacle) {
+      Eigen::Map<const Jacobian> jacobian_b(zero_jacobians[frame_b].data());
+      tau -= jacobian_b.topRows<3>().transpose() * force +
+             jacobian_b.bottomRows<3>().transpose() * lever_b.cross(force);
+    }
+  }
+  return result;
+}
+
+const std::vector<Capsule>& SelfCollisionChecker::capsules() const noexcept {
+  return capsules_;
+}
+
+const std::vector<Capsule>& SelfCollisionChecker::obstacles() const noexcept {
+  return obstacles_;
+}
+
+size_t SelfCollisionChecker::pairCount() const noexcept {
+  return pairs_.size();
+}
+
+}  // namespace franka
@@ -0,0 +1,97 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "shared_memory.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <franka/exception.h>
+
+#include "platform.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace franka {
+
+#ifdef LIBFRANKA_LINUX
+
+void* createSharedMemory(const std::string& name,
+                         size_t size,
+                         unsigned int permissions,
+                         bool replace_existing) {
+  int file = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, permissions);
+  if (file < 0 && replace_existing && errno == EEXIST) {
+    shm_unlink(name.c_str());
+    file = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, permissions);
+  }
+  if (file < 0) {
+    throw NetworkException("libfranka: Unable to create shared memory " + name + ": " +
+                           std::strerror(errno));
+  }
+  if (ftruncate(file, size) != 0) {
+    std::string error = std::strerror(errno);
+    close(file);
+    shm_unlink(name.c_str());
+    throw NetworkException("libfranka: Unable to resize shared memory " + name + ": " + error);
+  }
+  void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  close(file);
+  if (address == MAP_FAILED) {
+    std::string error = std::strerror(errno);
+    shm_unlink(name.c_str());
+    throw NetworkException("libfranka: Unable to map shared memory " + name + ": " + error);
+  }
+  return address;
+}
+
+void* openSharedMemory(const std::string& name, size_t size, bool writable) {
+  int file = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+  if (file < 0) {
+    throw NetworkException("libfranka: Unable to open shared memory " + name + ": " +
+                           std::strerror(errno));
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) < size) {
+    close(file);
+    throw NetworkException("libfranka: Shared memory " + name + " has not been initialized.");
+  }
+  void* address =
+      mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+  close(file);
+  if (address == MAP_FAILED) {
+    throw NetworkException("libfranka: Unable to map shared memory " + name + ": " +
+                           std::strerror(errno));
+  }
+  return address;
+}
+
+void unmapSharedMemory(void* address, size_t size) noexcept {
+  munmap(address, size);
+}
+
+void removeSharedMemory(const std::string& name) noexcept {
+  shm_unlink(name.c_str());
+}
+
+#else
+
+void* createSharedMemory(const std::string&, size_t, unsigned int, bool) {
+  throw NetworkException("libfranka: Shared memory is not supported on this platform.");
+}
+
+void* openSharedMemory(const std::string&, size_t, bool) {
+  throw NetworkException("libfranka: Shared memory is not supported on this platform.");
+}
+
+void unmapSharedMemory(void*, size_t) noexcept {}
+
+void removeSharedMemory(const std::string&) noexcept {}
+
+#endif
+
+}  // namespace franka
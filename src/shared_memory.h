@@ -0,0 +1,29 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace franka {
+
+// POSIX shared memory segments of SharedMemoryTransport, StateBroadcaster, StateSubscriber and
+// SharedMemoryMetrics. Only implemented on Linux. Errors are reported as NetworkException.
+
+// Creates a segment of the given size and maps it read-write. An existing segment with the same
+// name is an error, unless replace_existing is set.
+void* createSharedMemory(const std::string& name,
+                         size_t size,
+                         unsigned int permissions,
+                         bool replace_existing = false);
+
+// Maps an existing segment. Fails if the segment is smaller than the given size, e.g. because its
+// creator has not resized it yet, as accessing memory beyond its end would raise SIGBUS.
+void* openSharedMemory(const std::string& name, size_t size, bool writable);
+
+void unmapSharedMemory(void* address, size_t size) noexcept;
+
+// Removes the name of a segment. Existing mappings stay valid.
+void removeSharedMemory(const std::string& name) noexcept;
+
+}  // namespace franka
@@ -0,0 +1,84 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/shared_memory_metrics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+#include "metrics_writer.h"
+#include "shared_memory.h"
+
+namespace franka {
+
+constexpr uint64_t MetricsSegment::kMagic;
+constexpr uint64_t MetricsSegment::kVersion;
+
+SharedMemoryMetrics::SharedMemoryMetrics(const std::string& name) : name_(name) {
+  segment_ = new (createSharedMemory(name, sizeof(MetricsSegment), 0644)) MetricsSegment();
+  segment_->version = MetricsSegment::kVersion;
+  segment_->size = sizeof(MetricsSegment);
+  segment_->bucket_bounds_us = kMetricsBucketBounds;
+  segment_->magic.store(MetricsSegment::kMagic, std::memory_order_release);
+}
+
+SharedMemoryMetrics::~SharedMemoryMetrics() noexcept {
+  segment_->~MetricsSegment();
+  removeSharedMemory(name_);
+  unmapSharedMemory(segment_, sizeof(MetricsSegment));
+}
+
+const std::string& SharedMemoryMetrics::name() const noexcept {
+  return name_;
+}
+
+const MetricsSegment& SharedMemoryMetrics::segment() const noexcept {
+  return *segment_;
+}
+
+MetricsSegment& SharedMemoryMetrics::segment() noexcept {
+  return *segment_;
+}
+
+void recordMetricsLatency(MetricsSegment& segment,
+                          size_t stage,
+                          std::chrono::nanoseconds duration) noexcept {
+  uint64_t duration_ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+  // Bounds are inclusive, so a duration of exactly 1 ms falls into the 1000 us bucket.
+  uint64_t duration_us = (duration_ns + 999) / 1000;
+  size_t bucket = static_cast<size_t>(
+      std::lower_bound(kMetricsBucketBounds.begin(), kMetricsBucketBounds.end(), duration_us) -
+      kMetricsBucketBounds.begin());
+
+  MetricsHistogram& histogram = segment.stages[stage];
+  incrementMetric(histogram.buckets[bucket]);
+  incrementMetric(histogram.sum_ns, duration_ns);
+  incrementMetric(histogram.count);
+}
+
+void recordMetricsLimiting(MetricsSegment& segment, size_t stage, bool limited) noexcept {
+  MetricsLimitingStage& limiting = segment.limiting[stage];
+  incrementMetric(limiting.cycles);
+  if (limited) {
+    incrementMetric(limiting.limited_cycles);
+  }
+}
+
+void recordMetricsState(MetricsSegment& segment,
+                        uint64_t message_id,
+                        uint64_t robot_mode,
+                        double control_command_success_rate) noexcept {
+  uint64_t last_message_id = segment.message_id.load(std::memory_order_relaxed);
+  if (last_message_id != 0 && message_id > last_message_id + 1) {
+    incrementMetric(segment.lost_states, message_id - last_message_id - 1);
+  }
+  segment.message_id.store(message_id, std::memory_order_relaxed);
+  segment.robot_mode.store(robot_mode, std::memory_order_relaxed);
+  segment.success_rate_ppm.store(
+      static_cast<uint64_t>(std::lround(std::max(control_command_success_rate, 0.0) * 1e6)),
+      std::memory_order_relaxed);
+  segment.sequence.store(segment.sequence.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_release);
+}
+
+}  // namespace franka
@@ -0,0 +1,155 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "shared_memory_transport.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <franka/exception.h>
+
+#include "shared_memory.h"
+
+namespace franka {
+
+constexpr size_t SharedMemoryTransport::kSlotSize;
+constexpr size_t SharedMemoryTransport::kSlotCount;
+
+struct SharedMemorySlot {
+  uint64_t size;
+  std::array<uint8_t, SharedMemoryTransport::kSlotSize> data;
+};
+
+struct SharedMemoryRing {
+  // Number of datagrams written by the producer and read by the consumer. Kept on separate cache
+  // lines, so that both sides do not invalidate each other's line on every datagram.
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+  std::array<SharedMemorySlot, SharedMemoryTransport::kSlotCount> slots;
+};
+
+struct SharedMemorySegment {
+  static constexpr uint64_t kMagic = 0x6672616e6b61736dULL;  // "frankasm"
+
+  // Set by the device side once the rings have been initialized.
+  std::atomic<uint64_t> magic;
+  SharedMemoryRing states;
+  SharedMemoryRing commands;
+};
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string& name,
+                                             Endpoint endpoint,
+                                             std::chrono::milliseconds receive_timeout)
+    : name_(name), endpoint_(endpoint), receive_timeout_(receive_timeout) {
+  bool device = endpoint == Endpoint::kDevice;
+  if (device) {
+    // Replaces a segment left behind by a device that did not shut down cleanly.
+    segment_ = new (createSharedMemory(name, sizeof(SharedMemorySegment), 0600, true))
+        SharedMemorySegment();
+    segment_->magic.store(SharedMemorySegment::kMagic, std::memory_order_release);
+  } else {
+    segment_ = static_cast<SharedMemorySegment*>(
+        openSharedMemory(name, sizeof(SharedMemorySegment), true));
+    if (segment_->magic.load(std::memory_order_acquire) != SharedMemorySegment::kMagic) {
+      unmapSharedMemory(segment_, sizeof(SharedMemorySegment));
+      throw NetworkException("libfranka: Shared memory " + name + " has not been initialized.");
+    }
+  }
+  incoming_ = device ? &segment_->commands : &segment_->states;
+  outgoing_ = device ? &segment_->states : &segment_->commands;
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() noexcept {
+  if (endpoint_ == Endpoint::kDevice) {
+    segment_->~SharedMemorySegment();
+    removeSharedMemory(name_);
+  }
+  unmapSharedMemory(segment_, sizeof(SharedMemorySegment));
+}
+
+uint16_t SharedMemoryTransport::port() const noexcept {
+  return 0;
+}
+
+bool SharedMemoryTransport::available(size_t /* size */) {
+  return incoming_->tail.load(std::memory_order_relaxed) !=
+         incoming_->head.load(std::memory_order_acquire);
+}
+
+void SharedMemoryTransport::receive(uint8_t* buffer,
+                                    size_t size,
+                                    std::chrono::system_clock::time_point* receive_time) {
+  const auto deadline = std::chrono::steady_clock::now() + receive_timeout_;
+  while (!pop(buffer, size, receive_time)) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      throw NetworkException("libfranka: Shared memory receive: Timeout");
+    }
+    std::this_thread::yield();
+  }
+}
+
+size_t SharedMemoryTransport::receiveBatch(uint8_t* buffer,
+                                           size_t message_size,
+                                           size_t max_messages,
+                                           std::chrono::system_clock::time_point* receive_times) {
+  size_t received = 0;
+  while (received < max_messages &&
+         pop(buffer + received * message_size, message_size, &receive_times[received])) {
+    received++;
+  }
+  return received;
+}
+
+void SharedMemoryTransport::send(const uint8_t* data, size_t size) {
+  if (size > kSlotSize) {
+    throw NetworkException("libfranka: Datagram too large for shared memory transport.");
+  }
+  uint64_t head = outgoing_->head.load(std::memory_order_relaxed);
+  if (head - outgoing_->tail.load(std::memory_order_acquire) >= kSlotCount) {
+    // The receiver does not keep up. Drop the datagram, as UDP would.
+    return;
+  }
+
+  SharedMemorySlot& slot = outgoing_->slots[head % kSlotCount];
+  slot.size = size;
+  std::memcpy(slot.data.data(), data, size);
+  outgoing_->head.store(head + 1, std::memory_order_release);
+}
+
+bool SharedMemoryTransport::wait(std::chrono::microseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!available(0)) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+int SharedMemoryTransport::descriptor() const noexcept {
+  return -1;
+}
+
+bool SharedMemoryTransport::pop(uint8_t* buffer,
+                                size_t size,
+                                std::chrono::system_clock::time_point* receive_time) {
+  uint64_t tail = incoming_->tail.load(std::memory_order_relaxed);
+  if (tail == incoming_->head.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  const SharedMemorySlot& slot = incoming_->slots[tail % kSlotCount];
+  if (slot.size != size) {
+    incoming_->tail.store(tail + 1, std::memory_order_release);
+    throw ProtocolException("libfranka: incorrect object size");
+  }
+  std::memcpy(buffer, slot.data.data(), size);
+  *receive_time = std::chrono::system_clock::now();
+  incoming_->tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+}  // namespace franka
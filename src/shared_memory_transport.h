@@ -0,0 +1,89 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "datagram_transport.h"
+
+namespace franka {
+
+struct SharedMemorySegment;
+struct SharedMemoryRing;
+
+/**
+ * Exchanges datagrams with a process on the same host through a POSIX shared memory segment.
+ *
+ * The segment holds one single-producer, single-consumer ring per direction, so that a simulator
+ * or hardware-in-the-loop rig can drive the real control loop without the latency of the network
+ * stack. Waiting for datagrams spins on the ring, yielding the processor in between.
+ *
+ * Like UDP, datagrams are dropped if the receiver does not keep up and the ring is full. The
+ * receive time of a datagram is the time at which it is taken from the ring.
+ */
+class SharedMemoryTransport : public DatagramTransport {
+ public:
+  /**
+   * Side of the connection.
+   */
+  enum class Endpoint {
+    /// Side of the device or simulator, which creates the segment and sends states.
+    kDevice,
+    /// Side of libfranka, which opens the existing segment and sends commands.
+    kClient
+  };
+
+  /// Maximum size of a datagram.
+  static constexpr size_t kSlotSize = 8192;
+  /// Number of datagrams a ring can hold.
+  static constexpr size_t kSlotCount = 32;
+
+  /**
+   * Creates or opens the shared memory segment.
+   *
+   * @param[in] name Name of the segment, starting with a slash, e.g. "/franka_sim".
+   * @param[in] endpoint Side of the connection. The device side creates the segment and removes it
+   * on destruction. An existing segment with the same name, e.g. left behind by a crashed device,
+   * is replaced; clients still attached to it have to reconnect.
+   * @param[in] receive_timeout Timeout for blocking receives.
+   *
+   * @throw NetworkException if the segment cannot be created or opened, or if shared memory is not
+   * supported on this platform.
+   */
+  SharedMemoryTransport(const std::string& name,
+                        Endpoint endpoint,
+                        std::chrono::milliseconds receive_timeout = std::chrono::seconds(1));
+  ~SharedMemoryTransport() noexcept override;
+
+  uint16_t port() const noexcept override;
+  bool available(size_t size) override;
+  void receive(uint8_t* buffer,
+               size_t size,
+               std::chrono::system_clock::time_point* receive_time) override;
+  size_t receiveBatch(uint8_t* buffer,
+                      size_t message_size,
+                      size_t max_messages,
+                      std::chrono::system_clock::time_point* receive_times) override;
+  void send(const uint8_t* data, size_t size) override;
+  bool wait(std::chrono::microseconds timeout) override;
+  int descriptor() const noexcept override;
+
+  SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+  SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+ private:
+  // Pops the oldest datagram from the incoming ring. Returns false if the ring is empty.
+  bool pop(uint8_t* buffer, size_t size, std::chrono::system_clock::time_point* receive_time);
+
+  const std::string name_;  // NOLINT(readability-identifier-naming)
+  const Endpoint endpoint_;  // NOLINT(readability-identifier-naming)
+  const std::chrono::milliseconds receive_timeout_;  // NOLINT(readability-identifier-naming)
+  SharedMemorySegment* segment_{nullptr};
+  SharedMemoryRing* incoming_{nullptr};
+  SharedMemoryRing* outgoing_{nullptr};
+};
+
+}  // namespace franka
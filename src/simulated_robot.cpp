@@ -0,0 +1,578 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/simulated_robot.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/exception.h>
+#include <franka/model.h>
+#include <research_interface/robot/rbk_types.h>
+#include <research_interface/robot/service_types.h>
+
+#include "command_server.h"
+#include "datagram_transport.h"
+#include "load_calculations.h"
+#include "network.h"
+#include "robot_state_conversion.h"
+
+namespace franka {
+
+namespace {
+
+using Matrix4d = Eigen::Matrix4d;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Matrix7d = Eigen::Matrix<double, 7, 7>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+// Duration of one simulation step. Unit: [s]
+constexpr double kStepTime = 1e-3;
+
+// Number of cycles over which the control command success rate is computed, as on the robot.
+constexpr size_t kSuccessRateWindow = 100;
+
+// Number of states that have been produced, but not yet received. Older states are dropped, like
+// datagrams that do not fit into the receive buffer of a socket.
+constexpr size_t kStateQueueSize = 8;
+
+// Damping of the inverse Jacobian, which keeps Cartesian motions bounded near singularities.
+constexpr double kInverseJacobianDamping = 1e-6;
+
+Vector6d poseError(const std::array<double, 16>& target, const std::array<double, 16>& current) {
+  Eigen::Map<const Matrix4d> target_pose(target.data());
+  Eigen::Map<const Matrix4d> current_pose(current.data());
+  Vector6d error;
+  error.head<3>() = target_pose.topRightCorner<3, 1>() - current_pose.topRightCorner<3, 1>();
+  Eigen::AngleAxisd rotation(Eigen::Matrix3d(target_pose.topLeftCorner<3, 3>() *
+                                             current_pose.topLeftCorner<3, 3>().transpose()));
+  error.tail<3>() = rotation.angle() * rotation.axis();
+  return error;
+}
+
+}  // anonymous namespace
+
+class SimulatedRobot::Impl {
+ public:
+  Impl(const std::string& model_library_path, const SimulationParameters& parameters);
+
+  uint16_t port() const noexcept;
+  RobotState readOnce() const;
+  void setExternalTorque(const std::array<double, 7>& tau_ext) noexcept;
+  uint64_t steps() const noexcept;
+
+  // Datagram side of the simulated robot, used from the thread of the connected robot.
+
+  // Returns true if a produced state has not been received yet.
+  bool available() const noexcept;
+  // Takes the oldest produced state. Returns false if there is none.
+  bool pop(research_interface::robot::RobotState* robot_state) noexcept;
+  // Simulates one step, optionally with a newly received command, and produces a state.
+  void step(const research_interface::robot::RobotCommand* robot_command);
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+ private:
+  bool handleRequest(const research_interface::robot::CommandHeader& header,
+                     const std::vector<uint8_t>& message);
+  void handleDisconnect() noexcept;
+
+  research_interface::robot::Move::Status startMotionUnsafe(
+      uint32_t command_id,
+      const research_interface::robot::Move::Request& request);
+  void finishMotionUnsafe(research_interface::robot::Move::Status status) noexcept;
+  void generateMotionUnsafe();
+  void integrateDynamicsUnsafe();
+  void updateOutputsUnsafe();
+  void recordCommandUnsafe(bool received) noexcept;
+  Vector7d jointVelocityUnsafe(const Vector6d& twist) const;
+
+  const Model model_;
+  const std::vector<uint8_t> model_library_;
+  const SimulationParameters parameters_;
+
+  mutable std::mutex mutex_;
+  research_interface::robot::RobotState state_{};
+  CombinedLoadCache load_cache_;
+  std::array<double, 7> tau_ext_{};
+  research_interface::robot::RobotCommand command_{};
+  bool command_received_{false};
+  uint32_t move_command_id_{0};
+
+  std::array<bool, kSuccessRateWindow> command_window_{};
+  size_t command_window_index_{0};
+  size_t command_window_size_{0};
+  size_t command_window_received_{0};
+
+  std::array<research_interface::robot::RobotState, kStateQueueSize> queue_{};
+  size_t queue_head_{0};
+  size_t queue_size_{0};
+
+  // Declared last, so that the server thread stops before the state it accesses is destroyed.
+  std::unique_ptr<CommandServer> server_;
+};
+
+namespace {
+
+// Exchanges states and commands with a simulation in memory.
+class SimulationTransport : public DatagramTransport {
+ public:
+  explicit SimulationTransport(std::shared_ptr<SimulatedRobot::Impl> simulation)
+      : simulation_(std::move(simulation)) {}
+
+  uint16_t port() const noexcept override { return 0; }
+
+  bool available(size_t /* size */) override { return simulation_->available(); }
+
+  void receive(uint8_t* buffer,
+               size_t size,
+               std::chrono::system_clock::time_point* receive_time) override {
+    checkSize(size, sizeof(research_interface::robot::RobotState));
+    if (!simulation_->available()) {
+      simulation_->step(nullptr);
+    }
+    research_interface::robot::RobotState robot_state;
+    simulation_->pop(&robot_state);
+    std::memcpy(buffer, &robot_state, sizeof(robot_state));
+    *receive_time = {};
+  }
+
+  size_t receiveBatch(uint8_t* buffer,
+                      size_t message_size,
+                      size_t max_messages,
+                      std::chrono::system_clock::time_point* receive_times) override {
+    checkSize(message_size, sizeof(research_interface::robot::RobotState));
+    size_t received = 0;
+    research_interface::robot::RobotState robot_state;
+    while (received < max_messages && simulation_->pop(&robot_state)) {
+      std::memcpy(buffer + received * message_size, &robot_state, sizeof(robot_state));
+      receive_times[received] = {};
+      received++;
+    }
+    return received;
+  }
+
+  void send(const uint8_t* data, size_t size) override {
+    checkSize(size, sizeof(research_interface::robot::RobotCommand));
+    research_interface::robot::RobotCommand robot_command;
+    std::memcpy(&robot_command, data, sizeof(robot_command));
+    simulation_->step(&robot_command);
+  }
+
+  bool wait(std::chrono::microseconds /* timeout */) override {
+    // The simulation produces states on demand, so there is never a need to wait.
+    if (!simulation_->available()) {
+      simulation_->step(nullptr);
+    }
+    return true;
+  }
+
+  int descriptor() const noexcept override { return -1; }
+
+ private:
+  static void checkSize(size_t size, size_t expected_size) {
+    if (size != expected_size) {
+      throw ProtocolException("libfranka: incorrect object size");
+    }
+  }
+
+  std::shared_ptr<SimulatedRobot::Impl> simulation_;
+};
+
+std::vector<uint8_t> readLibrary(const std::string& path) {
+  std::ifstream stream(path, std::ios_base::in | std::ios_base::binary);
+  std::vector<uint8_t> library;
+  if (stream) {
+    library.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  if (library.empty()) {
+    throw ModelException("libfranka simulation: Cannot read model library " + path);
+  }
+  return library;
+}
+
+}  // anonymous namespace
+
+SimulatedRobot::Impl::Impl(const std::string& model_library_path,
+                           const SimulationParameters& parameters)
+    : model_(model_library_path),
+      model_library_(readLibrary(model_library_path)),
+      parameters_(parameters) {
+  constexpr std::array<double, 16> kIdentity{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  state_.q = parameters.q_start;
+  state_.q_d = parameters.q_start;
+  state_.F_T_NE = parameters.F_T_NE;
+  state_.NE_T_EE = kIdentity;
+  state_.F_T_EE = parameters.F_T_NE;
+  state_.EE_T_K = kIdentity;
+  state_.m_ee = parameters.m_ee;
+  state_.F_x_Cee = parameters.F_x_Cee;
+  state_.I_ee = parameters.I_ee;
+  state_.O_ddP_O = parameters.gravity_earth;
+  state_.robot_mode = research_interface::robot::RobotMode::kIdle;
+  state_.motion_generator_mode = research_interface::robot::MotionGeneratorMode::kIdle;
+  state_.controller_mode = research_interface::robot::ControllerMode::kJointImpedance;
+  updateOutputsUnsafe();
+  state_.O_T_EE_c = state_.O_T_EE;
+
+  server_ = std::make_unique<CommandServer>(
+      [this](const research_interface::robot::CommandHeader& header,
+             const std::vector<uint8_t>& message) { return handleRequest(header, message); },
+      [this]() { handleDisconnect(); });
+}
+
+uint16_t SimulatedRobot::Impl::port() const noexcept {
+  return server_->port();
+}
+
+RobotState SimulatedRobot::Impl::readOnce() const {
+  std::lock_guard<std::mutex> _(mutex_);
+  return convertRobotState(state_);
+}
+
+void SimulatedRobot::Impl::setExternalTorque(const std::array<double, 7>& tau_ext) noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  tau_ext_ = tau_ext;
+}
+
+uint64_t SimulatedRobot::Impl::steps() const noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  return state_.message_id;
+}
+
+bool SimulatedRobot::Impl::available() const noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  return queue_size_ > 0;
+}
+
+bool SimulatedRobot::Impl::pop(research_interface::robot::RobotState* robot_state) noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  if (queue_size_ == 0) {
+    return false;
+  }
+  *robot_state = queue_[queue_head_];
+  queue_head_ = (queue_head_ + 1) % kStateQueueSize;
+  queue_size_--;
+  return true;
+}
+
+void SimulatedRobot::Impl::step(const research_interface::robot::RobotCommand* robot_command) {
+  std::lock_guard<std::mutex> _(mutex_);
+  state_.message_id++;
+
+  if (state_.robot_mode == research_interface::robot::RobotMode::kMove) {
+    recordCommandUnsafe(robot_command != nullptr);
+    if (robot_command != nullptr) {
+      command_ = *robot_command;
+      command_received_ = true;
+    }
+    // Like the robot, keep the current position until the first command arrives, and reuse the
+    // last command if one is missing.
+    if (command_received_) {
+      generateMotionUnsafe();
+    }
+    if (robot_command != nullptr && robot_command->motion.motion_generation_finished) {
+      finishMotionUnsafe(research_interface::robot::Move::Status::kSuccess);
+    }
+  }
+  updateOutputsUnsafe();
+
+  if (queue_size_ == kStateQueueSize) {
+    queue_head_ = (queue_head_ + 1) % kStateQueueSize;
+    queue_size_--;
+  }
+  queue_[(queue_head_ + queue_size_) % kStateQueueSize] = state_;
+  queue_size_++;
+}
+
+void SimulatedRobot::Impl::generateMotionUnsafe() {
+  Eigen::Map<Vector7d> q(state_.q.data());
+  Eigen::Map<Vector7d> dq(state_.dq.data());
+  Eigen::Map<Vector7d> q_d(state_.q_d.data());
+  Eigen::Map<Vector7d> dq_d(state_.dq_d.data());
+  Eigen::Map<Vector7d> ddq_d(state_.ddq_d.data());
+  const Vector7d previous_dq_d = dq_d;
+  const research_interface::robot::MotionGeneratorCommand& motion = command_.motion;
+
+  switch (state_.motion_generator_mode) {
+    case research_interface::robot::MotionGeneratorMode::kJointPosition:
+      dq_d = (Eigen::Map<const Vector7d>(motion.q_c.data()) - q_d) / kStepTime;
+      q_d = Eigen::Map<const Vector7d>(motion.q_c.data());
+      break;
+    case research_interface::robot::MotionGeneratorMode::kJointVelocity:
+      dq_d = Eigen::Map<const Vector7d>(motion.dq_c.data());
+      q_d += kStepTime * dq_d;
+      break;
+    case research_interface::robot::MotionGeneratorMode::kCartesianPosition:
+      dq_d = jointVelocityUnsafe(poseError(motion.O_T_EE_c, state_.O_T_EE_d) / kStepTime);
+      q_d += kStepTime * dq_d;
+      state_.O_T_EE_c = motion.O_T_EE_c;
+      break;
+    case research_interface::robot::MotionGeneratorMode::kCartesianVelocity:
+      dq_d = jointVelocityUnsafe(Eigen::Map<const Vector6d>(motion.O_dP_EE_c.data()));
+      q_d += kStepTime * dq_d;
+      state_.O_dP_EE_c = motion.O_dP_EE_c;
+      break;
+    default:
+      break;
+  }
+  ddq_d = (dq_d - previous_dq_d) / kStepTime;
+
+  Eigen::Map<Vector7d> tau_J_d(state_.tau_J_d.data());  // NOLINT(readability-identifier-naming)
+  if (state_.controller_mode == research_interface::robot::ControllerMode::kExternalController) {
+    tau_J_d = Eigen::Map<const Vector7d>(command_.control.tau_J_d.data());
+    integrateDynamicsUnsafe();
+    return;
+  }
+
+  // The internal controllers track the motion exactly, compensating all external torques.
+  const CombinedLoadCache& load = load_cache_;
+  std::array<double, 49> mass =
+      model_.mass(state_.q_d, load.I_total(), load.m_total(), load.F_x_Ctotal());
+  std::array<double, 7> coriolis =
+      model_.coriolis(state_.q_d, state_.dq_d, load.I_total(), load.m_total(), load.F_x_Ctotal());
+  tau_J_d = Eigen::Map<const Matrix7d>(mass.data()) * ddq_d +
+            Eigen::Map<const Vector7d>(coriolis.data()) -
+            Eigen::Map<const Vector7d>(tau_ext_.data());
+  q = q_d;
+  dq = dq_d;
+}
+
+void SimulatedRobot::Impl::integrateDynamicsUnsafe() {
+  Eigen::Map<Vector7d> q(state_.q.data());
+  Eigen::Map<Vector7d> dq(state_.dq.data());
+  const CombinedLoadCache& load = load_cache_;
+  std::array<double, 49> mass =
+      model_.mass(state_.q, load.I_total(), load.m_total(), load.F_x_Ctotal());
+  std::array<double, 7> coriolis =
+      model_.coriolis(state_.q, state_.dq, load.I_total(), load.m_total(), load.F_x_Ctotal());
+
+  // Gravity is compensated by the robot, so it does not appear here.
+  Vector7d tau = Eigen::Map<const Vector7d>(state_.tau_J_d.data()) +
+                 Eigen::Map<const Vector7d>(tau_ext_.data()) -
+                 Eigen::Map<const Vector7d>(coriolis.data()) -
+                 Eigen::Map<const Vector7d>(parameters_.joint_damping.data()).cwiseProduct(dq);
+  Eigen::LLT<Matrix7d> mass_llt(Eigen::Map<const Matrix7d>(mass.data()));
+  if (mass_llt.info() != Eigen::Success) {
+    throw ModelException("libfranka simulation: Mass matrix is not positive definite.");
+  }
+  // Semi-implicit Euler integration, which keeps undamped oscillations bounded.
+  dq += kStepTime * mass_llt.solve(tau);
+  q += kStepTime * dq;
+}
+
+Vector7d SimulatedRobot::Impl::jointVelocityUnsafe(const Vector6d& twist) const {
+  std::array<double, 42> jacobian_array =
+      model_.zeroJacobian(Frame::kEndEffector, state_.q_d, state_.F_T_EE, state_.EE_T_K);
+  Eigen::Map<const Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
+  return jacobian.transpose() *
+         (jacobian * jacobian.transpose() + kInverseJacobianDamping * Matrix6d::Identity())
+             .ldlt()
+             .solve(twist);
+}
+
+void SimulatedRobot::Impl::updateOutputsUnsafe() {
+  load_cache_.update(state_.m_ee, state_.F_x_Cee, state_.I_ee, state_.m_load, state_.F_x_Cload,
+                     state_.I_load);
+  std::array<double, 7> gravity = model_.gravity(state_.q, load_cache_.m_total(),
+                                                 load_cache_.F_x_Ctotal(), state_.O_ddP_O);
+
+  Eigen::Map<Vector7d> tau_J(state_.tau_J.data());  // NOLINT(readability-identifier-naming)
+  const Vector7d previous_tau_J = tau_J;              // NOLINT(readability-identifier-naming)
+  tau_J = Eigen::Map<const Vector7d>(state_.tau_J_d.data()) +
+          Eigen::Map<const Vector7d>(gravity.data());
+  Eigen::Map<Vector7d>(state_.dtau_J.data()) = (tau_J - previous_tau_J) / kStepTime;
+
+  state_.theta = state_.q;
+  state_.dtheta = state_.dq;
+  state_.tau_ext_hat_filtered = tau_ext_;
+  state_.O_T_EE = model_.pose(Frame::kEndEffector, state_.q, state_.F_T_EE, state_.EE_T_K);
+  state_.O_T_EE_d = model_.pose(Frame::kEndEffector, state_.q_d, state_.F_T_EE, state_.EE_T_K);
+  if (command_window_size_ > 0) {
+    state_.control_command_success_rate =
+        static_cast<double>(command_window_received_) / static_cast<double>(command_window_size_);
+  }
+}
+
+void SimulatedRobot::Impl::recordCommandUnsafe(bool received) noexcept {
+  if (command_window_size_ == kSuccessRateWindow) {
+    command_window_received_ -= command_window_[command_window_index_] ? 1 : 0;
+  } else {
+    command_window_size_++;
+  }
+  command_window_[command_window_index_] = received;
+  command_window_received_ += received ? 1 : 0;
+  command_window_index_ = (command_window_index_ + 1) % kSuccessRateWindow;
+}
+
+research_interface::robot::Move::Status SimulatedRobot::Impl::startMotionUnsafe(
+    uint32_t command_id,
+    const research_interface::robot::Move::Request& request) {
+  using research_interface::robot::Move;
+
+  if (state_.robot_mode != research_interface::robot::RobotMode::kIdle) {
+    return Move::Status::kCommandNotPossibleRejected;
+  }
+
+  switch (request.motion_generator_mode) {
+    case Move::MotionGeneratorMode::kJointPosition:
+      state_.motion_generator_mode = research_interface::robot::MotionGeneratorMode::kJointPosition;
+      break;
+    case Move::MotionGeneratorMode::kJointVelocity:
+      state_.motion_generator_mode = research_interface::robot::MotionGeneratorMode::kJointVelocity;
+      break;
+    case Move::MotionGeneratorMode::kCartesianPosition:
+      state_.motion_generator_mode =
+          research_interface::robot::MotionGeneratorMode::kCartesianPosition;
+      break;
+    case Move::MotionGeneratorMode::kCartesianVelocity:
+      state_.motion_generator_mode =
+          research_interface::robot::MotionGeneratorMode::kCartesianVelocity;
+      break;
+    default:
+      return Move::Status::kInvalidArgumentRejected;
+  }
+
+  switch (request.controller_mode) {
+    case Move::ControllerMode::kJointImpedance:
+      state_.controller_mode = research_interface::robot::ControllerMode::kJointImpedance;
+      break;
+    case Move::ControllerMode::kCartesianImpedance:
+      state_.controller_mode = research_interface::robot::ControllerMode::kCartesianImpedance;
+      break;
+    case Move::ControllerMode::kExternalController:
+      state_.controller_mode = research_interface::robot::ControllerMode::kExternalController;
+      break;
+    default:
+      state_.motion_generator_mode = research_interface::robot::MotionGeneratorMode::kIdle;
+      return Move::Status::kInvalidArgumentRejected;
+  }
+
+  state_.robot_mode = research_interface::robot::RobotMode::kMove;
+  state_.q_d = state_.q;
+  state_.dq_d = {};
+  state_.ddq_d = {};
+  state_.O_T_EE_c = state_.O_T_EE;
+  state_.O_dP_EE_c = {};
+  move_command_id_ = command_id;
+  command_ = {};
+  command_received_ = false;
+  command_window_size_ = 0;
+  command_window_received_ = 0;
+  command_window_index_ = 0;
+  return Move::Status::kMotionStarted;
+}
+
+void SimulatedRobot::Impl::finishMotionUnsafe(
+    research_interface::robot::Move::Status status) noexcept {
+  state_.robot_mode = research_interface::robot::RobotMode::kIdle;
+  state_.motion_generator_mode = research_interface::robot::MotionGeneratorMode::kIdle;
+  state_.controller_mode = research_interface::robot::ControllerMode::kJointImpedance;
+  state_.q_d = state_.q;
+  state_.dq = {};
+  state_.dq_d = {};
+  state_.ddq_d = {};
+  state_.tau_J_d = {};
+  server_->sendResponse<research_interface::robot::Move>(
+      move_command_id_, research_interface::robot::Move::Response(status));
+}
+
+void SimulatedRobot::Impl::handleDisconnect() noexcept {
+  std::lock_guard<std::mutex> _(mutex_);
+  if (state_.robot_mode == research_interface::robot::RobotMode::kMove) {
+    finishMotionUnsafe(research_interface::robot::Move::Status::kAborted);
+  }
+}
+
+bool SimulatedRobot::Impl::handleRequest(const research_interface::robot::CommandHeader& header,
+                                         const std::vector<uint8_t>& message) {
+  namespace ri = research_interface::robot;
+
+  switch (header.command) {
+    case ri::Command::kMove: {
+      auto request = CommandServer::readRequest<ri::Move>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      // Respond under the lock, so that the response cannot overtake the one of a finished motion.
+      server_->sendResponse<ri::Move>(
+          header.command_id, ri::Move::Response(startMotionUnsafe(header.command_id, request)));
+      return true;
+    }
+    case ri::Command::kStopMove: {
+      CommandServer::readRequest<ri::StopMove>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      if (state_.robot_mode == ri::RobotMode::kMove) {
+        finishMotionUnsafe(ri::Move::Status::kPreempted);
+      }
+      server_->sendResponse<ri::StopMove>(header.command_id,
+                                          ri::StopMove::Response(ri::StopMove::Status::kSuccess));
+      return true;
+    }
+    case ri::Command::kSetEEToK: {
+      auto request = CommandServer::readRequest<ri::SetEEToK>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      state_.EE_T_K = request.EE_T_K;
+      break;
+    }
+    case ri::Command::kSetNEToEE: {
+      auto request = CommandServer::readRequest<ri::SetNEToEE>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      state_.NE_T_EE = request.NE_T_EE;
+      Eigen::Map<Matrix4d>(state_.F_T_EE.data()) =
+          Eigen::Map<const Matrix4d>(state_.F_T_NE.data()) *
+          Eigen::Map<const Matrix4d>(state_.NE_T_EE.data());
+      break;
+    }
+    case ri::Command::kSetLoad: {
+      auto request = CommandServer::readRequest<ri::SetLoad>(message);
+      std::lock_guard<std::mutex> _(mutex_);
+      state_.m_load = request.m_load;
+      state_.F_x_Cload = request.F_x_Cload;
+      state_.I_load = request.I_load;
+      break;
+    }
+    case ri::Command::kLoadModelLibrary:
+      CommandServer::readRequest<ri::LoadModelLibrary>(message);
+      server_->sendResponse<ri::LoadModelLibrary>(
+          header.command_id,
+          ri::LoadModelLibrary::Response(ri::LoadModelLibrary::Status::kSuccess), model_library_);
+      return true;
+    default:
+      break;
+  }
+  // Applied settings are acknowledged like all other settings. Virtual walls are not simulated.
+  return server_->acknowledge(header, message);
+}
+
+SimulatedRobot::SimulatedRobot(const std::string& model_library_path,
+                               const SimulationParameters& parameters)
+    : impl_(std::make_shared<Impl>(model_library_path, parameters)) {}
+
+// Has to be declared here, as the Impl type is incomplete in the header.
+SimulatedRobot::~SimulatedRobot() noexcept = default;
+
+RobotState SimulatedRobot::readOnce() const {
+  return impl_->readOnce();
+}
+
+void SimulatedRobot::setExternalTorque(const std::array<double, 7>& tau_ext) noexcept {
+  impl_->setExternalTorque(tau_ext);
+}
+
+uint64_t SimulatedRobot::steps() const noexcept {
+  return impl_->steps();
+}
+
+std::unique_ptr<Network> SimulatedRobot::connect() {
+  return std::make_unique<Network>("127.0.0.1", impl_->port(),
+                                   std::make_unique<SimulationTransport>(impl_));
+}
+
+}  // namespace franka
@@ -0,0 +1,361 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/spline_trajectory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/SparseCore>
+#include <Eigen/SparseLU>
+
+#include <franka/control_tools.h>
+
+namespace franka {
+
+namespace {
+
+// Dimensions are padded to a whole number of vector registers.
+constexpr size_t kLanes = 8;
+
+using Lanes = Eigen::Array<double, kLanes, 1>;
+using LanesMap = Eigen::Map<const Lanes>;
+using Knots = Eigen::Matrix<double, Eigen::Dynamic, 7>;
+
+template <size_t N>
+bool isFinite(const std::array<double, N>& values) noexcept {
+  return std::all_of(values.begin(), values.end(),
+                     [](double value) { return std::isfinite(value); });
+}
+
+constexpr size_t degree(SplineType type) noexcept {
+  return type == SplineType::kCubic ? 3 : 5;
+}
+
+// Solves for the derivatives at the inner points, given the coefficients of the equations of each
+// inner point for its previous, own and next unknowns.
+Knots solve(const std::vector<Eigen::Triplet<double>>& triplets, const Knots& rhs) {
+  Eigen::SparseMatrix<double> matrix(rhs.rows(), rhs.rows());
+  matrix.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
+  solver.compute(matrix);
+  if (solver.info() != Eigen::Success) {
+    throw std::invalid_argument("libfranka: Spline could not be fitted.");
+  }
+  return solver.solve(rhs);
+}
+
+// Velocities at all points of a cubic spline with continuous acceleration.
+Knots cubicVelocities(const std::vector<double>& times, const Knots& points) {
+  const Eigen::Index inner = points.rows() - 2;
+  Knots velocities = Knots::Zero(points.rows(), 7);
+  if (inner == 0) {
+    return velocities;
+  }
+  std::vector<Eigen::Triplet<double>> triplets;
+  Knots rhs(inner, 7);
+  for (Eigen::Index i = 1; i <= inner; i++) {
+    double h_l = times[i] - times[i - 1];
+    double h_r = times[i + 1] - times[i];
+    // Acceleration at the end of the left segment equals the one at the start of the right one.
+    if (i > 1) {
+      triplets.emplace_back(i - 1, i - 2, 2 / h_l);
+    }
+    triplets.emplace_back(i - 1, i - 1, 4 / h_l + 4 / h_r);
+    if (i < inner) {
+      triplets.emplace_back(i - 1, i, 2 / h_r);
+    }
+    rhs.row(i - 1) = 6 * (points.row(i) - points.row(i - 1)) / (h_l * h_l) +
+                     6 * (points.row(i + 1) - points.row(i)) / (h_r * h_r);
+  }
+  velocities.middleRows(1, inner) = solve(triplets, rhs);
+  return velocities;
+}
+
+// Velocities and accelerations at all points of a quintic spline with continuous jerk and snap.
+void quinticDerivatives(const std::vector<double>& times,
+                        const Knots& points,
+                        Knots* velocities,
+                        Knots* accelerations) {
+  const Eigen::Index inner = points.rows() - 2;
+  *velocities = Knots::Zero(points.rows(), 7);
+  *accelerations = Knots::Zero(points.rows(), 7);
+  if (inner == 0) {
+    return;
+  }
+  // Unknowns are ordered v_1, a_1, v_2, a_2, ...; rows 2(i-1) and 2(i-1)+1 equate jerk and snap
+  // at the end of the left segment and the start of the right segment of point i.
+  std::vector<Eigen::Triplet<double>> triplets;
+  Knots rhs(2 * inner, 7);
+  for (Eigen::Index i = 1; i <= inner; i++) {
+    double h_l = times[i] - times[i - 1];
+    double h_r = times[i + 1] - times[i];
+    Eigen::Index jerk = 2 * (i - 1);
+    Eigen::Index snap = jerk + 1;
+    Eigen::Index v = 2 * (i - 1);
+    Eigen::Index a = v + 1;
+    if (i > 1) {
+      triplets.emplace_back(jerk, v - 2, -24 / std::pow(h_l, 2));
+      triplets.emplace_back(jerk, a - 2, -3 / h_l);
+      triplets.emplace_back(snap, v - 2, -168 / std::pow(h_l, 3));
+      triplets.emplace_back(snap, a - 2, -24 / std::pow(h_l, 2));
+    }
+    triplets.emplace_back(jerk, v, 36 / std::pow(h_r, 2) - 36 / std::pow(h_l, 2));
+    triplets.emplace_back(jerk, a, 9 / h_l + 9 / h_r);
+    triplets.emplace_back(snap, v, -192 / std::pow(h_l, 3) - 192 / std::pow(h_r, 3));
+    triplets.emplace_back(snap, a, 36 / std::pow(h_l, 2) - 36 / std::pow(h_r, 2));
+    if (i < inner) {
+      triplets.emplace_back(jerk, v + 2, 24 / std::pow(h_r, 2));
+      triplets.emplace_back(jerk, a + 2, -3 / h_r);
+      triplets.emplace_back(snap, v + 2, -168 / std::pow(h_r, 3));
+      triplets.emplace_back(snap, a + 2, 24 / std::pow(h_r, 2));
+    }
+    auto delta_l = points.row(i) - points.row(i - 1);
+    auto delta_r = points.row(i + 1) - points.row(i);
+    rhs.row(jerk) = 60 * delta_r / std::pow(h_r, 3) - 60 * delta_l / std::pow(h_l, 3);
+    rhs.row(snap) = -360 * delta_l / std::pow(h_l, 4) - 360 * delta_r / std::pow(h_r, 4);
+  }
+  Knots solution = solve(triplets, rhs);
+  for (Eigen::Index i = 1; i <= inner; i++) {
+    velocities->row(i) = solution.row(2 * (i - 1));
+    accelerations->row(i) = solution.row(2 * (i - 1) + 1);
+  }
+}
+
+// Evaluates the polynomial with the given coefficients and its first two derivatives.
+template <size_t Degree>
+void evaluatePolynomial(const double* coefficients,
+                        double tau,
+                        Lanes* position,
+                        Lanes* velocity,
+                        Lanes* acceleration) noexcept {
+  auto c = [coefficients](size_t j) { return LanesMap(coefficients + j * kLanes); };
+  Lanes p = c(Degree);
+  for (size_t j = Degree; j-- > 0;) {
+    p = p * tau + c(j);
+  }
+  *position = p;
+  if (velocity != nullptr) {
+    Lanes v = static_cast<double>(Degree) * c(Degree);
+    for (size_t j = Degree - 1; j >= 1; j--) {
+      v = v * tau + static_cast<double>(j) * c(j);
+    }
+    *velocity = v;
+  }
+  if (acceleration != nullptr) {
+    Lanes a = static_cast<double>(Degree * (Degree - 1)) * c(Degree);
+    for (size_t j = Degree - 1; j >= 2; j--) {
+      a = a * tau + static_cast<double>(j * (j - 1)) * c(j);
+    }
+    *acceleration = a;
+  }
+}
+
+void copyLanes(const Lanes& lanes, std::array<double, 7>* values) noexcept {
+  if (values != nullptr) {
+    std::copy(lanes.data(), lanes.data() + 7, values->begin());
+  }
+}
+
+}  // anonymous namespace
+
+struct SplineTrajectory::Storage {
+  SplineType type;
+  std::vector<double> times;
+  // Per segment, the coefficients of the powers 0 to degree of the time since its start, each
+  // padded to kLanes values.
+  std::vector<double> coefficients;
+};
+
+SplineTrajectory::SplineTrajectory(const std::vector<double>& times,
+                                   const std::vector<std::array<double, 7>>& points,
+                                   SplineType type) {
+  if (points.size() < 2 || times.size() != points.size()) {
+    throw std::invalid_argument(
+        "libfranka: Spline needs at least two points and a time for every point.");
+  }
+  if (times.front() != 0.0 || !std::all_of(times.begin(), times.end(), [](double time) {
+        return std::isfinite(time);
+      })) {
+    throw std::invalid_argument("libfranka: Spline times must be finite and start at zero.");
+  }
+  if (std::adjacent_find(times.begin(), times.end(), std::greater_equal<double>()) !=
+      times.end()) {
+    throw std::invalid_argument("libfranka: Spline times must be strictly increasing.");
+  }
+  if (!std::all_of(points.begin(), points.end(), isFinite<7>)) {
+    throw std::invalid_argument("libfranka: Spline points must be finite.");
+  }
+
+  Knots knots(points.size(), 7);
+  for (size_t i = 0; i < points.size(); i++) {
+    knots.row(i) = Eigen::Map<const Eigen::Matrix<double, 1, 7>>(points[i].data());
+  }
+  Knots velocities;
+  Knots accelerations;
+  if (type == SplineType::kCubic) {
+    velocities = cubicVelocities(times, knots);
+  } else {
+    quinticDerivatives(times, knots, &velocities, &accelerations);
+  }
+
+  auto storage = std::make_shared<Storage>();
+  storage->type = type;
+  storage->times = times;
+  const size_t stride = (degree(type) + 1) * kLanes;
+  storage->coefficients.assign((points.size() - 1) * stride, 0.0);
+  for (size_t k = 0; k + 1 < points.size(); k++) {
+    double h = times[k + 1] - times[k];
+    Eigen::Matrix<double, 1, 7> delta = knots.row(k + 1) - knots.row(k);
+    Eigen::Matrix<double, 1, 7> v_0 = velocities.row(k);
+    Eigen::Matrix<double, 1, 7> v_1 = velocities.row(k + 1);
+    // Hermite interpolation between both points, in powers of the time since the segment start.
+    Eigen::Matrix<double, Eigen::Dynamic, 7> c(degree(type) + 1, 7);
+    c.row(0) = knots.row(k);
+    c.row(1) = v_0;
+    if (type == SplineType::kCubic) {
+      c.row(2) = (3 * delta / h - 2 * v_0 - v_1) / h;
+      c.row(3) = (-2 * delta / h + v_0 + v_1) / (h * h);
+    } else {
+      Eigen::Matrix<double, 1, 7> a_0 = accelerations.row(k);
+      Eigen::Matrix<double, 1, 7> a_1 = accelerations.row(k + 1);
+      c.row(2) = a_0 / 2;
+      c.row(3) = (20 * delta - (8 * v_1 + 12 * v_0) * h - (3 * a_0 - a_1) * h * h) /
+                 (2 * std::pow(h, 3));
+      c.row(4) = (-30 * delta + (14 * v_1 + 16 * v_0) * h + (3 * a_0 - 2 * a_1) * h * h) /
+                 (2 * std::pow(h, 4));
+      c.row(5) = (12 * delta - 6 * (v_1 + v_0) * h + (a_1 - a_0) * h * h) / (2 * std::pow(h, 5));
+    }
+    for (Eigen::Index j = 0; j < c.rows(); j++) {
+      Eigen::Map<Eigen::Matrix<double, 1, 7>>(&storage->coefficients[k * stride + j * kLanes]) =
+          c.row(j);
+    }
+  }
+  storage_ = std::move(storage);
+}
+
+SplineType SplineTrajectory::type() const noexcept {
+  return storage_->type;
+}
+
+size_t SplineTrajectory::segmentCount() const noexcept {
+  return storage_->times.size() - 1;
+}
+
+double SplineTrajectory::duration() const noexcept {
+  return storage_->times.back();
+}
+
+void SplineTrajectory::evaluate(double t,
+                                std::array<double, 7>* position,
+                                std::array<double, 7>* velocity,
+                                std::array<double, 7>* acceleration) const noexcept {
+  const std::vector<double>& times = storage_->times;
+  t = std::min(std::max(t, 0.0), times.back());
+  // Index of the last segment that starts at or before t.
+  size_t segment = std::upper_bound(times.begin() + 1, times.end() - 1, t) - (times.begin() + 1);
+  double tau = t - times[segment];
+
+  Lanes p;
+  Lanes v;
+  Lanes a;
+  Lanes* v_out = velocity != nullptr ? &v : nullptr;
+  Lanes* a_out = acceleration != nullptr ? &a : nullptr;
+  if (storage_->type == SplineType::kCubic) {
+    evaluatePolynomial<3>(&storage_->coefficients[segment * 4 * kLanes], tau, &p, v_out, a_out);
+  } else {
+    evaluatePolynomial<5>(&storage_->coefficients[segment * 6 * kLanes], tau, &p, v_out, a_out);
+  }
+  copyLanes(p, position);
+  if (velocity != nullptr) {
+    copyLanes(v, velocity);
+  }
+  if (acceleration != nullptr) {
+    copyLanes(a, acceleration);
+  }
+}
+
+JointPositions SplineTrajectory::jointPositions(double t) const noexcept {
+  std::array<double, 7> q;
+  evaluate(t, &q);
+  JointPositions output(q);
+  output.motion_finished = t >= duration();
+  return output;
+}
+
+namespace {
+
+// Converts poses to positions followed by quaternions (w, x, y, z) with consistent signs.
+std::vector<std::array<double, 7>> toSplinePoints(
+    const std::vector<std::array<double, 16>>& poses) {
+  std::vector<std::array<double, 7>> points;
+  points.reserve(poses.size());
+  Eigen::Quaterniond previous(1, 0, 0, 0);
+  for (const std::array<double, 16>& pose : poses) {
+    if (!isFinite(pose) || !isHomogeneousTransformation(pose)) {
+      throw std::invalid_argument(
+          "libfranka: Spline pose is not a valid homogeneous transformation.");
+    }
+    Eigen::Map<const Eigen::Matrix4d> transform(pose.data());
+    Eigen::Quaterniond orientation(transform.topLeftCorner<3, 3>());
+    if (!points.empty() && orientation.dot(previous) < 0) {
+      orientation.coeffs() = -orientation.coeffs();
+    }
+    previous = orientation;
+    points.push_back({{transform(0, 3), transform(1, 3), transform(2, 3), orientation.w(),
+                       orientation.x(), orientation.y(), orientation.z()}});
+  }
+  return points;
+}
+
+}  // anonymous namespace
+
+CartesianSplineTrajectory::CartesianSplineTrajectory(
+    const std::vector<double>& times,
+    const std::vector<std::array<double, 16>>& poses,
+    SplineType type)
+    : spline_(times, toSplinePoints(poses), type) {}
+
+double CartesianSplineTrajectory::duration() const noexcept {
+  return spline_.duration();
+}
+
+void CartesianSplineTrajectory::evaluate(double t,
+                                         std::array<double, 16>* pose,
+                                         std::array<double, 6>* twist) const noexcept {
+  std::array<double, 7> position;
+  std::array<double, 7> velocity;
+  spline_.evaluate(t, &position, twist != nullptr ? &velocity : nullptr);
+
+  Eigen::Quaterniond quaternion(position[3], position[4], position[5], position[6]);
+  double norm = quaternion.norm();
+  Eigen::Quaterniond orientation(quaternion.coeffs() / norm);
+  Eigen::Map<Eigen::Matrix4d> transform(pose->data());
+  transform.setIdentity();
+  transform.topLeftCorner<3, 3>() = orientation.toRotationMatrix();
+  transform.topRightCorner<3, 1>() << position[0], position[1], position[2];
+
+  if (twist != nullptr) {
+    // Derivative of the normalized quaternion, and angular velocity w = 2 * dq/dt * q^-1.
+    Eigen::Quaterniond derivative(velocity[3], velocity[4], velocity[5], velocity[6]);
+    Eigen::Quaterniond normalized_derivative(
+        (derivative.coeffs() - orientation.coeffs() * orientation.dot(derivative)) / norm);
+    Eigen::Vector3d angular_velocity =
+        2 * (normalized_derivative * orientation.conjugate()).vec();
+    *twist = {{velocity[0], velocity[1], velocity[2], angular_velocity.x(), angular_velocity.y(),
+               angular_velocity.z()}};
+  }
+}
+
+CartesianPose CartesianSplineTrajectory::cartesianPose(double t) const noexcept {
+  std::array<double, 16> pose;
+  evaluate(t, &pose);
+  CartesianPose output(pose);
+  output.motion_finished = t >= duration();
+  return output;
+}
+
+}  // namespace franka
@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace franka {
+
+/**
+ * Bounded, wait-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The capacity is rounded up to the next power of two. push() and pop() never block and never
+ * allocate.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) : buffer_(roundUpToPowerOfTwo(capacity)) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /**
+   * Enqueues a copy of the given value. May only be called by the producer thread.
+   *
+   * @return False if the queue is full.
+   */
+  bool push(const T& value) noexcept {
+    const size_t tail = tail_.value.load(std::memory_order_relaxed);
+    if (tail - head_.value.load(std::memory_order_acquire) == buffer_.size()) {
+      return false;
+    }
+    buffer_[tail & (buffer_.size() - 1)] = value;
+    tail_.value.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Dequeues the oldest value. May only be called by the consumer thread.
+   *
+   * @return False if the queue is empty.
+   */
+  bool pop(T* value) noexcept {
+    const size_t head = head_.value.load(std::memory_order_relaxed);
+    if (head == tail_.value.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *value = buffer_[head & (buffer_.size() - 1)];
+    head_.value.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const noexcept { return buffer_.size(); }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  static size_t roundUpToPowerOfTwo(size_t value) noexcept {
+    size_t result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // Keeps producer and consumer indices on separate cache lines.
+  struct PaddedIndex {
+    char padding[kCacheLineSize];
+    std::atomic<size_t> value{0};
+  };
+
+  std::vector<T> buffer_;
+  PaddedIndex head_;
+  PaddedIndex tail_;
+};
+
+}  // namespace franka
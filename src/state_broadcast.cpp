@@ -0,0 +1,231 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/state_broadcast.h>
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <franka/exception.h>
+#include <research_interface/robot/service_types.h>
+
+#include "load_calculations.h"
+#include "robot_state_conversion.h"
+#include "shared_memory.h"
+#include "state_broadcast_segment.h"
+
+namespace franka {
+
+constexpr uint64_t StateBroadcaster::kCapacity;
+
+constexpr uint64_t BroadcastSegment::kMagic;
+
+namespace {
+
+constexpr std::chrono::microseconds kPollInterval(20);
+
+enum class CopyResult { kCopied, kOverwritten, kTimeout };
+
+// Copies the sample with the given sequence. Gives up at the deadline if the slot is still being
+// written, e.g. because the broadcasting process died while writing it.
+CopyResult copySample(const BroadcastSegment& segment,
+                      uint64_t sequence,
+                      std::chrono::steady_clock::time_point deadline,
+                      BroadcastSample* sample) noexcept {
+  const BroadcastSlot& slot = segment.slots[sequence % StateBroadcaster::kCapacity];
+  while (true) {
+    uint64_t version = slot.version.load(std::memory_order_acquire);
+    if (version % 2 != 0) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return CopyResult::kTimeout;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    std::memcpy(sample, &slot.sample, sizeof(*sample));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.version.load(std::memory_order_relaxed) == version) {
+      return sample->sequence == sequence ? CopyResult::kCopied : CopyResult::kOverwritten;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+StateBroadcaster::StateBroadcaster(const std::string& name) : name_(name) {
+  segment_ = new (createSharedMemory(name, sizeof(BroadcastSegment), 0644)) BroadcastSegment();
+  segment_->protocol_version = research_interface::robot::kVersion;
+  segment_->size = sizeof(BroadcastSegment);
+  segment_->magic.store(BroadcastSegment::kMagic, std::memory_order_release);
+}
+
+StateBroadcaster::~StateBroadcaster() noexcept {
+  segment_->~BroadcastSegment();
+  removeSharedMemory(name_);
+  unmapSharedMemory(segment_, sizeof(BroadcastSegment));
+}
+
+const std::string& StateBroadcaster::name() const noexcept {
+  return name_;
+}
+
+uint64_t StateBroadcaster::publishedStates() const noexcept {
+  return segment_->published.load(std::memory_order_relaxed);
+}
+
+void broadcastRawState(StateBroadcaster& broadcaster,
+                       const research_interface::robot::RobotState& robot_state,
+                       const research_interface::robot::RobotCommand& robot_command,
+                       std::chrono::steady_clock::time_point host_time) noexcept {
+  BroadcastSegment& segment = *broadcaster.segment_;
+  uint64_t sequence = segment.published.load(std::memory_order_relaxed);
+  BroadcastSlot& slot = segment.slots[sequence % StateBroadcaster::kCapacity];
+
+  // The broadcaster is the only writer, so the version can be incremented without a locked
+  // read-modify-write.
+  uint64_t version = slot.version.load(std::memory_order_relaxed);
+  slot.version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.sample.sequence = sequence;
+  slot.sample.host_time =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(host_time.time_since_epoch()).count();
+  slot.sample.robot_state = robot_state;
+  slot.sample.robot_command = robot_command;
+  slot.version.store(version + 2, std::memory_order_release);
+
+  segment.published.store(sequence + 1, std::memory_order_release);
+}
+
+class StateSubscriber::Impl {
+ public:
+  explicit Impl(const std::string& name);
+  ~Impl() noexcept;
+
+  bool readLatest(PublishedState* state, std::chrono::microseconds timeout);
+  bool readNext(PublishedState* state, std::chrono::microseconds timeout);
+
+  uint64_t publishedStates() const noexcept {
+    return segment_->published.load(std::memory_order_acquire);
+  }
+
+  uint64_t lostStates() const noexcept { return lost_; }
+
+ private:
+  void convert(const BroadcastSample& sample, PublishedState* state);
+
+  const BroadcastSegment* segment_{nullptr};
+  uint64_t next_{0};
+  uint64_t lost_{0};
+  BroadcastSample sample_{};
+  CombinedLoadCache load_cache_;
+};
+
+StateSubscriber::Impl::Impl(const std::string& name)
+    : segment_(static_cast<const BroadcastSegment*>(
+          openSharedMemory(name, sizeof(BroadcastSegment), false))) {
+  if (segment_->magic.load(std::memory_order_acquire) != BroadcastSegment::kMagic) {
+    unmapSharedMemory(const_cast<BroadcastSegment*>(segment_), sizeof(BroadcastSegment));
+    throw NetworkException("libfranka: Shared memory " + name + " has not been initialized.");
+  }
+  if (segment_->protocol_version != research_interface::robot::kVersion ||
+      segment_->size != sizeof(BroadcastSegment)) {
+    unmapSharedMemory(const_cast<BroadcastSegment*>(segment_), sizeof(BroadcastSegment));
+    throw NetworkException("libfranka: Shared memory " + name +
+                           " was written by an incompatible version of libfranka.");
+  }
+  next_ = publishedStates();
+}
+
+StateSubscriber::Impl::~Impl() noexcept {
+  unmapSharedMemory(const_cast<BroadcastSegment*>(segment_), sizeof(BroadcastSegment));
+}
+
+bool StateSubscriber::Impl::readLatest(PublishedState* state, std::chrono::microseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  uint64_t published = publishedStates();
+  if (published == 0) {
+    return false;
+  }
+  while (true) {
+    CopyResult result = copySample(*segment_, published - 1, deadline, &sample_);
+    if (result == CopyResult::kCopied) {
+      break;
+    }
+    if (result == CopyResult::kTimeout) {
+      return false;
+    }
+    // Retry with the new latest state, as the broadcaster overwrote the slot while copying.
+    published = publishedStates();
+  }
+  next_ = published;
+  convert(sample_, state);
+  return true;
+}
+
+bool StateSubscriber::Impl::readNext(PublishedState* state, std::chrono::microseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    uint64_t published = publishedStates();
+    if (published == next_) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(kPollInterval);
+      continue;
+    }
+
+    if (published - next_ > StateBroadcaster::kCapacity) {
+      lost_ += published - StateBroadcaster::kCapacity - next_;
+      next_ = published - StateBroadcaster::kCapacity;
+    }
+    CopyResult result = copySample(*segment_, next_, deadline, &sample_);
+    if (result == CopyResult::kCopied) {
+      next_++;
+      convert(sample_, state);
+      return true;
+    }
+    if (result == CopyResult::kTimeout) {
+      return false;
+    }
+    // Overwritten while copying, so the subscriber is exactly one ring behind.
+    lost_++;
+    next_++;
+  }
+}
+
+void StateSubscriber::Impl::convert(const BroadcastSample& sample, PublishedState* state) {
+  convertRobotState(sample.robot_state, &load_cache_, &state->robot_state);
+  state->robot_state.host_time = std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::nanoseconds(sample.host_time)));
+  state->command.joint_positions = sample.robot_command.motion.q_c;
+  state->command.joint_velocities = sample.robot_command.motion.dq_c;
+  state->command.cartesian_pose.O_T_EE = sample.robot_command.motion.O_T_EE_c;
+  state->command.cartesian_velocities.O_dP_EE = sample.robot_command.motion.O_dP_EE_c;
+  state->command.torques.tau_J = sample.robot_command.control.tau_J_d;
+  state->controller_torques = {};
+  state->sequence = sample.sequence;
+}
+
+StateSubscriber::StateSubscriber(const std::string& name) : impl_(new Impl(name)) {}
+
+StateSubscriber::~StateSubscriber() noexcept = default;
+
+bool StateSubscriber::readLatest(PublishedState* state, std::chrono::microseconds timeout) {
+  return impl_->readLatest(state, timeout);
+}
+
+bool StateSubscriber::readNext(PublishedState* state, std::chrono::microseconds timeout) {
+  return impl_->readNext(state, timeout);
+}
+
+uint64_t StateSubscriber::publishedStates() const noexcept {
+  return impl_->publishedStates();
+}
+
+uint64_t StateSubscriber::lostStates() const noexcept {
+  return impl_->lostStates();
+}
+
+}  // namespace franka
@@ -0,0 +1,42 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <franka/state_broadcast.h>
+#include <research_interface/robot/rbk_types.h>
+
+namespace franka {
+
+// Layout of the shared memory segment written by StateBroadcaster and read by StateSubscriber.
+
+struct BroadcastSample {
+  uint64_t sequence;
+  // Nanoseconds since the epoch of std::chrono::steady_clock, which is shared by all processes.
+  int64_t host_time;
+  research_interface::robot::RobotState robot_state;
+  research_interface::robot::RobotCommand robot_command;
+};
+
+struct BroadcastSlot {
+  // Odd while the broadcaster writes the sample.
+  std::atomic<uint64_t> version;
+  BroadcastSample sample;
+};
+
+struct BroadcastSegment {
+  static constexpr uint64_t kMagic = 0x6672616e6b616273ULL;  // "frankabs"
+
+  // Set by the broadcaster once the segment has been initialized.
+  std::atomic<uint64_t> magic;
+  uint64_t protocol_version;
+  uint64_t size;
+  // Number of broadcast states. On its own cache line, as subscribers poll it.
+  alignas(64) std::atomic<uint64_t> published;
+  std::array<BroadcastSlot, StateBroadcaster::kCapacity> slots;
+};
+
+}  // namespace franka
@@ -0,0 +1,109 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/state_prediction.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+#include <franka/model.h>
+
+namespace franka {
+
+constexpr double TransportDelayEstimator::kMaxLossProbability;
+
+namespace {
+
+// Duration of one control cycle. Unit: [s]
+constexpr double kCycleTime = 1e-3;
+
+}  // anonymous namespace
+
+TransportDelayEstimator::TransportDelayEstimator(double smoothing) : smoothing_(smoothing) {
+  if (!(smoothing > 0 && smoothing <= 1)) {
+    throw std::invalid_argument("libfranka: Transport delay smoothing must be in (0, 1].");
+  }
+}
+
+void TransportDelayEstimator::update(const RobotState& robot_state, Duration time_step) noexcept {
+  // A success rate of zero is reported before the first command was received, so it does not say
+  // anything about lost commands.
+  if (robot_state.control_command_success_rate > 0) {
+    command_loss_ = 1 - robot_state.control_command_success_rate;
+  }
+  if (time_step.toMSec() == 0) {
+    last_gap_ = 0;
+    return;
+  }
+
+  last_gap_ = time_step.toMSec() - 1;
+  lost_states_ += last_gap_;
+  double lost_ratio = static_cast<double>(last_gap_) / static_cast<double>(time_step.toMSec());
+  lost_state_ratio_ += smoothing_ * (lost_ratio - lost_state_ratio_);
+}
+
+void TransportDelayEstimator::reset() noexcept {
+  lost_states_ = 0;
+  last_gap_ = 0;
+  lost_state_ratio_ = 0;
+  command_loss_ = 0;
+}
+
+uint64_t TransportDelayEstimator::lostStates() const noexcept {
+  return lost_states_;
+}
+
+uint64_t TransportDelayEstimator::lastGap() const noexcept {
+  return last_gap_;
+}
+
+double TransportDelayEstimator::lostStateRatio() const noexcept {
+  return lost_state_ratio_;
+}
+
+double TransportDelayEstimator::lossProbability() const noexcept {
+  return std::min(std::max(lost_state_ratio_, command_loss_), kMaxLossProbability);
+}
+
+double TransportDelayEstimator::predictedDelay() const noexcept {
+  double p = lossProbability();
+  return kCycleTime * p / (1 - p);
+}
+
+bool predictJointState(const std::array<double, 49>& mass,
+                       const std::array<double, 7>& coriolis,
+                       double horizon,
+                       RobotState* robot_state) noexcept {
+  using Matrix7d = Eigen::Matrix<double, 7, 7>;
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+  if (!(horizon > 0)) {
+    return false;
+  }
+  Eigen::LLT<Matrix7d> mass_llt(Eigen::Map<const Matrix7d>(mass.data()));
+  if (mass_llt.info() != Eigen::Success) {
+    return false;
+  }
+
+  Eigen::Map<Vector7d> q(robot_state->q.data());
+  Eigen::Map<Vector7d> dq(robot_state->dq.data());
+  Eigen::Map<Vector7d> ddq(robot_state->ddq_hat.data());
+  ddq = mass_llt.solve(Eigen::Map<const Vector7d>(robot_state->tau_J_d.data()) -
+                       Eigen::Map<const Vector7d>(coriolis.data()));
+  q += horizon * dq + 0.5 * horizon * horizon * ddq;
+  dq += horizon * ddq;
+  return true;
+}
+
+bool predictJointState(const Model& model, double horizon, RobotState* robot_state) noexcept {
+  if (!(horizon > 0)) {
+    return false;
+  }
+  return predictJointState(model.mass(*robot_state), model.coriolis(*robot_state), horizon,
+                           robot_state);
+}
+
+}  // namespace franka
@@ -0,0 +1,148 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/state_publisher.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+#include <research_interface/robot/rbk_types.h>
+
+#include "load_calculations.h"
+#include "robot_state_conversion.h"
+
+namespace franka {
+
+namespace {
+
+// The publisher never writes the latest slot, so readers may occupy all but two slots at the same
+// time without making the publisher drop samples.
+constexpr size_t kSlotCount = 8;
+constexpr uint32_t kWriting = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+}  // anonymous namespace
+
+class StatePublisher::Impl {
+ public:
+  // Claims a slot for writing. Returns nullptr if readers occupy all slots.
+  PublishedState* beginPublish() noexcept {
+    uint32_t latest = latest_.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < kSlotCount; i++) {
+      if (i == latest) {
+        continue;
+      }
+      // Acquire: the last reader of the slot is done copying it.
+      uint32_t readers = 0;
+      if (slots_[i].readers.compare_exchange_strong(readers, kWriting, std::memory_order_acquire,
+                                                    std::memory_order_relaxed)) {
+        writing_ = i;
+        slots_[i].state.sequence = published_.load(std::memory_order_relaxed);
+        return &slots_[i].state;
+      }
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  void endPublish() noexcept {
+    slots_[writing_].readers.store(0, std::memory_order_release);
+    latest_.store(writing_, std::memory_order_release);
+    published_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool read(PublishedState* state) const noexcept {
+    while (true) {
+      uint32_t index = latest_.load(std::memory_order_acquire);
+      if (index == kNoSlot) {
+        return false;
+      }
+
+      // The publisher may have reclaimed the slot since it was the latest one. Then try the new
+      // latest slot, which the publisher does not write.
+      const Slot& slot = slots_[index];
+      uint32_t readers = slot.readers.load(std::memory_order_relaxed);
+      while (readers != kWriting &&
+             !slot.readers.compare_exchange_weak(readers, readers + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+      }
+      if (readers == kWriting) {
+        continue;
+      }
+
+      *state = slot.state;
+      slot.readers.fetch_sub(1, std::memory_order_release);
+      return true;
+    }
+  }
+
+  uint64_t publishedStates() const noexcept { return published_.load(std::memory_order_relaxed); }
+
+  uint64_t droppedStates() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+  CombinedLoadCache& loadCache() noexcept { return load_cache_; }
+
+ private:
+  struct Slot {
+    // Number of readers copying the slot, or kWriting while the publisher writes it.
+    mutable std::atomic<uint32_t> readers{0};
+    PublishedState state;
+  };
+
+  std::array<Slot, kSlotCount> slots_;
+  std::atomic<uint32_t> latest_{kNoSlot};
+  std::atomic<uint64_t> published_{0};
+  std::atomic<uint64_t> dropped_{0};
+  uint32_t writing_{0};
+  CombinedLoadCache load_cache_;
+};
+
+StatePublisher::StatePublisher() : impl_(new Impl) {}
+
+StatePublisher::~StatePublisher() noexcept = default;
+
+bool StatePublisher::publish(const RobotState& robot_state,
+                             const RobotCommand& command,
+                             const ControllerTorques& controller_torques) noexcept {
+  PublishedState* state = impl_->beginPublish();
+  if (state == nullptr) {
+    return false;
+  }
+  state->robot_state = robot_state;
+  state->command = command;
+  state->controller_torques = controller_torques;
+  impl_->endPublish();
+  return true;
+}
+
+bool StatePublisher::read(PublishedState* state) const noexcept {
+  return impl_->read(state);
+}
+
+uint64_t StatePublisher::publishedStates() const noexcept {
+  return impl_->publishedStates();
+}
+
+uint64_t StatePublisher::droppedStates() const noexcept {
+  return impl_->droppedStates();
+}
+
+void publishRawState(StatePublisher& publisher,
+                     const research_interface::robot::RobotState& robot_state,
+                     const research_interface::robot::RobotCommand& robot_command) noexcept {
+  PublishedState* state = publisher.impl_->beginPublish();
+  if (state == nullptr) {
+    return;
+  }
+  convertRobotState(robot_state, &publisher.impl_->loadCache(), &state->robot_state);
+  state->command.joint_positions = robot_command.motion.q_c;
+  state->command.joint_velocities = robot_command.motion.dq_c;
+  state->command.cartesian_pose.O_T_EE = robot_command.motion.O_T_EE_c;
+  state->command.cartesian_velocities.O_dP_EE = robot_command.motion.O_dP_EE_c;
+  state->command.torques.tau_J = robot_command.control.tau_J_d;
+  state->controller_torques = {};
+  publisher.impl_->endPublish();
+}
+
+}  // namespace franka
@@ -0,0 +1,158 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/state_stream.h>
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/robot.h>
+
+namespace franka {
+
+namespace {
+
+struct Subscriber {
+  std::shared_ptr<StatePublisher> publisher;
+  uint64_t decimation;
+  uint64_t next_time;
+};
+
+}  // anonymous namespace
+
+class StateStream::Impl {
+ public:
+  explicit Impl(Robot& robot) : robot_(robot) {}
+
+  ~Impl() noexcept {
+    try {
+      stop();
+    } catch (...) {
+    }
+  }
+
+  void subscribe(std::shared_ptr<StatePublisher> publisher, uint32_t decimation) {
+    if (running_) {
+      throw InvalidOperationException(
+          "libfranka: Cannot add a subscriber while the state stream is running.");
+    }
+    if (!publisher || decimation == 0) {
+      throw std::invalid_argument(
+          "libfranka: State stream subscribers need a publisher and a positive decimation.");
+    }
+    subscribers_.push_back(Subscriber{std::move(publisher), decimation, 0});
+  }
+
+  void start() {
+    if (thread_.joinable()) {
+      if (running_) {
+        throw InvalidOperationException("libfranka: State stream is already running.");
+      }
+      // The read loop has failed; its error is dropped by restarting.
+      thread_.join();
+    }
+    for (Subscriber& subscriber : subscribers_) {
+      subscriber.next_time = 0;
+    }
+    error_ = nullptr;
+    stop_ = false;
+    running_ = true;
+
+    std::promise<void> started;
+    std::future<void> started_future = started.get_future();
+    thread_ = std::thread(&Impl::run, this, std::move(started));
+    try {
+      started_future.get();
+    } catch (...) {
+      thread_.join();
+      throw;
+    }
+  }
+
+  void stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+    stop_ = true;
+    thread_.join();
+    if (error_) {
+      std::exception_ptr error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  bool running() const noexcept { return running_; }
+
+  uint64_t receivedStates() const noexcept { return received_states_; }
+
+ private:
+  void run(std::promise<void> started) noexcept {
+    bool first = true;
+    try {
+      robot_.read([&](const RobotState& robot_state) {
+        if (first) {
+          started.set_value();
+          first = false;
+        }
+        received_states_.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t time = robot_state.time.toMSec();
+        for (Subscriber& subscriber : subscribers_) {
+          if (time >= subscriber.next_time) {
+            subscriber.publisher->publish(robot_state);
+            subscriber.next_time = time + subscriber.decimation;
+          }
+        }
+        return !stop_.load(std::memory_order_relaxed);
+      });
+    } catch (...) {
+      if (first) {
+        started.set_exception(std::current_exception());
+      } else {
+        error_ = std::current_exception();
+      }
+    }
+    running_ = false;
+  }
+
+  Robot& robot_;
+  std::vector<Subscriber> subscribers_;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> received_states_{0};
+  // Written by the read thread before it finishes, read after joining it.
+  std::exception_ptr error_;
+};
+
+StateStream::StateStream(Robot& robot) : impl_(std::make_unique<Impl>(robot)) {}
+
+StateStream::~StateStream() noexcept = default;
+
+void StateStream::subscribe(std::shared_ptr<StatePublisher> publisher, uint32_t decimation) {
+  impl_->subscribe(std::move(publisher), decimation);
+}
+
+void StateStream::start() {
+  impl_->start();
+}
+
+void StateStream::stop() {
+  impl_->stop();
+}
+
+bool StateStream::running() const noexcept {
+  return impl_->running();
+}
+
+uint64_t StateStream::receivedStates() const noexcept {
+  return impl_->receivedStates();
+}
+
+}  // namespace franka
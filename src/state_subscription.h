@@ -0,0 +1,169 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <franka/exception.h>
+
+#include "network.h"
+#include "triple_buffer.h"
+
+namespace franka {
+
+/**
+ * Receives the UDP states of a device in a background thread and keeps the latest one.
+ *
+ * The latest state is handed over through a franka::TripleBuffer, so latest() neither blocks nor
+ * makes system calls. The receiving thread sleeps on the UDP socket between states.
+ *
+ * @tparam TReceived State type sent by the device, with a `message_id` member.
+ * @tparam TState Converted state type.
+ */
+template <typename TReceived, typename TState>
+class StateSubscription {
+ public:
+  using Converter = TState (*)(const TReceived&);
+  using Callback = std::function<void(const TState&)>;
+
+  /**
+   * Time without a received state after which the subscription fails, same as the UDP receive
+   * timeout of the device connection.
+   */
+  static constexpr std::chrono::milliseconds kReceiveTimeout{1000};
+
+  /**
+   * Starts receiving states. The network must outlive the subscription, and no other thread may
+   * receive from its UDP socket meanwhile.
+   *
+   * @param[in] network Device connection.
+   * @param[in] convert Converts a received state.
+   * @param[in] callback Called from the receiving thread with every new state. May be empty.
+   */
+  StateSubscription(Network& network, Converter convert, Callback callback)
+      : network_(network),
+        convert_(convert),
+        callback_(std::move(callback)),
+        poller_({&network}),
+        thread_(&StateSubscription::run, this) {}
+
+  ~StateSubscription() noexcept {
+    {
+      std::lock_guard<std::mutex> _(mutex_);
+      running_ = false;
+    }
+    thread_.join();
+  }
+
+  /**
+   * Returns the latest state. May only be called from one thread at a time.
+   *
+   * @throw NetworkException if receiving failed, or the exception thrown by the callback.
+   */
+  const TState& latest() {
+    if (failed_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> _(mutex_);
+      std::rethrow_exception(error_);
+    }
+    states_.acquire();
+    return states_.front();
+  }
+
+  /**
+   * Waits for the next state and returns it.
+   *
+   * @throw NetworkException if receiving failed or timed out, or the exception thrown by the
+   * callback.
+   */
+  TState next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t sequence = sequence_;
+    if (!condition_.wait_for(lock, kReceiveTimeout,
+                             [&]() { return sequence_ != sequence || error_; })) {
+      throw NetworkException("libfranka: UDP receive: Timeout");
+    }
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return state_;
+  }
+
+  StateSubscription(const StateSubscription&) = delete;
+  StateSubscription& operator=(const StateSubscription&) = delete;
+
+ private:
+  // Upper bound for the time the receiving thread needs to notice that it has been stopped.
+  static constexpr std::chrono::milliseconds kPollInterval{50};
+
+  void run() noexcept {
+    TReceived received{};
+    auto last_received = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+      lock.unlock();
+      try {
+        if (network_.template udpReceiveLatest<TReceived>(&received)) {
+          TState state = convert_(received);
+          states_.write(state);
+          if (callback_) {
+            callback_(state);
+          }
+          last_received = std::chrono::steady_clock::now();
+
+          lock.lock();
+          state_ = state;
+          sequence_++;
+          lock.unlock();
+          condition_.notify_all();
+        } else if (std::chrono::steady_clock::now() - last_received >= kReceiveTimeout) {
+          throw NetworkException("libfranka: UDP receive: Timeout");
+        } else {
+          poller_.wait(kPollInterval);
+        }
+      } catch (...) {
+        lock.lock();
+        error_ = std::current_exception();
+        failed_.store(true, std::memory_order_release);
+        lock.unlock();
+        condition_.notify_all();
+        return;
+      }
+      lock.lock();
+    }
+  }
+
+  Network& network_;
+  const Converter convert_;
+  const Callback callback_;
+  UdpPoller poller_;
+
+  TripleBuffer<TState> states_;
+  std::atomic<bool> failed_{false};
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool running_{true};
+  uint64_t sequence_{0};
+  TState state_{};
+  std::exception_ptr error_;
+
+  // Declared last, so that the thread starts after all other members have been initialized.
+  std::thread thread_;
+};
+
+template <typename TReceived, typename TState>
+constexpr std::chrono::milliseconds StateSubscription<TReceived, TState>::kReceiveTimeout;
+
+template <typename TReceived, typename TState>
+constexpr std::chrono::milliseconds StateSubscription<TReceived, TState>::kPollInterval;
+
+}  // namespace franka
@@ -0,0 +1,264 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/streaming_recorder.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <franka/exception.h>
+#include <research_interface/robot/rbk_types.h>
+
+#include "arrow_writer.h"
+#include "memory_mapped_file.h"
+#include "platform.h"
+#include "record_format.h"
+#include "robot_state_conversion.h"
+#include "spsc_queue.h"
+
+#ifdef LIBFRANKA_LINUX
+#include <pthread.h>
+#endif
+
+namespace franka {
+
+namespace {
+
+constexpr auto kWriterPollInterval = std::chrono::milliseconds(1);
+
+// One record of the file. Only contains 8-byte members, so there is no padding.
+struct Sample {
+  uint64_t time;
+  uint64_t robot_mode;
+  double control_command_success_rate;
+  std::array<double, 7> q;
+  std::array<double, 7> q_d;
+  std::array<double, 7> dq;
+  std::array<double, 7> dq_d;
+  std::array<double, 7> ddq_d;
+  std::array<double, 7> tau_J;    // NOLINT(readability-identifier-naming)
+  std::array<double, 7> tau_J_d;  // NOLINT(readability-identifier-naming)
+  std::array<double, 7> dtau_J;   // NOLINT(readability-identifier-naming)
+  std::array<double, 7> tau_ext_hat_filtered;
+  std::array<double, 16> O_T_EE;        // NOLINT(readability-identifier-naming)
+  std::array<double, 16> O_T_EE_d;      // NOLINT(readability-identifier-naming)
+  std::array<double, 6> O_F_ext_hat_K;  // NOLINT(readability-identifier-naming)
+  std::array<double, 6> K_F_ext_hat_K;  // NOLINT(readability-identifier-naming)
+  std::array<double, 7> command_q;
+  std::array<double, 7> command_dq;
+  std::array<double, 16> command_O_T_EE;  // NOLINT(readability-identifier-naming)
+  std::array<double, 6> command_O_dP_EE;  // NOLINT(readability-identifier-naming)
+  std::array<double, 7> command_tau_J;    // NOLINT(readability-identifier-naming)
+};
+
+#define FRANKA_SAMPLE_FIELD(name, type)                                     \
+  FieldInfo {                                                               \
+    #name, type, static_cast<uint32_t>(offsetof(Sample, name)),             \
+        static_cast<uint32_t>(sizeof(Sample::name) / sizeof(uint64_t))      \
+  }
+
+const FieldInfo kFields[] = {
+    FRANKA_SAMPLE_FIELD(time, FieldType::kUInt64),
+    FRANKA_SAMPLE_FIELD(robot_mode, FieldType::kUInt64),
+    FRANKA_SAMPLE_FIELD(control_command_success_rate, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(q, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(q_d, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(dq, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(dq_d, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(ddq_d, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(tau_J, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(tau_J_d, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(dtau_J, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(tau_ext_hat_filtered, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(O_T_EE, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(O_T_EE_d, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(O_F_ext_hat_K, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(K_F_ext_hat_K, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(command_q, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(command_dq, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(command_O_T_EE, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(command_O_dP_EE, FieldType::kDouble),
+    FRANKA_SAMPLE_FIELD(command_tau_J, FieldType::kDouble),
+};
+
+#undef FRANKA_SAMPLE_FIELD
+
+template <typename TState>
+void fillState(const TState& robot_state, Sample* sample) noexcept {
+  sample->control_command_success_rate = robot_state.control_command_success_rate;
+  sample->q = robot_state.q;
+  sample->q_d = robot_state.q_d;
+  sample->dq = robot_state.dq;
+  sample->dq_d = robot_state.dq_d;
+  sample->ddq_d = robot_state.ddq_d;
+  sample->tau_J = robot_state.tau_J;
+  sample->tau_J_d = robot_state.tau_J_d;
+  sample->dtau_J = robot_state.dtau_J;
+  sample->tau_ext_hat_filtered = robot_state.tau_ext_hat_filtered;
+  sample->O_T_EE = robot_state.O_T_EE;
+  sample->O_T_EE_d = robot_state.O_T_EE_d;
+  sample->O_F_ext_hat_K = robot_state.O_F_ext_hat_K;
+  sample->K_F_ext_hat_K = robot_state.K_F_ext_hat_K;
+}
+
+}  // anonymous namespace
+
+class StreamingRecorder::Impl {
+ public:
+  Impl(const std::string& path, size_t queue_capacity)
+      : queue_(queue_capacity), file_(path, std::ios::binary | std::ios::trunc) {
+    if (!file_) {
+      throw Exception("libfranka: Unable to open recording file " + path);
+    }
+    std::vector<char> header =
+        createRecordHeader(kFields, sizeof(kFields) / sizeof(kFields[0]), sizeof(Sample));
+    file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    writer_ = std::thread(&Impl::write, this);
+  }
+
+  ~Impl() noexcept { stop(); }
+
+  bool push(const Sample& sample) noexcept {
+    // Announced before checking running_, so that stop() waits for pushes that saw it running.
+    active_pushes_.fetch_add(1);
+    bool pushed = running_.load() && queue_.push(sample);
+    active_pushes_.fetch_sub(1, std::memory_order_release);
+    if (!pushed) {
+      dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return pushed;
+  }
+
+  void stop() noexcept {
+    if (running_.exchange(false)) {
+      while (active_pushes_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+      writer_.join();
+      // Samples pushed while the writer was finishing its last pass.
+      writeQueued();
+      file_.close();
+    }
+  }
+
+  uint64_t writtenSamples() const noexcept {
+    return written_samples_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t droppedSamples() const noexcept {
+    return dropped_samples_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void write() noexcept {
+#ifdef LIBFRANKA_LINUX
+    // Do not inherit a realtime policy from the thread that created the recorder.
+    sched_param parameters{};
+    parameters.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &parameters);
+#endif
+    while (true) {
+      bool running = running_.load();
+      size_t written = writeQueued();
+      if (!running) {
+        break;
+      }
+      if (written == 0) {
+        file_.flush();
+        std::this_thread::sleep_for(kWriterPollInterval);
+      }
+    }
+    file_.flush();
+  }
+
+  // Writes all queued samples. Must only be called by the consumer of the queue.
+  size_t writeQueued() noexcept {
+    Sample sample;
+    size_t written = 0;
+    while (queue_.pop(&sample)) {
+      file_.write(reinterpret_cast<const char*>(&sample), sizeof(sample));
+      written++;
+    }
+    written_samples_.fetch_add(written, std::memory_order_relaxed);
+    return written;
+  }
+
+  SpscQueue<Sample> queue_;
+  std::ofstream file_;
+  std::thread writer_;
+  std::atomic<bool> running_{true};
+  std::atomic<uint32_t> active_pushes_{0};
+  std::atomic<uint64_t> written_samples_{0};
+  std::atomic<uint64_t> dropped_samples_{0};
+};
+
+constexpr uint32_t StreamingRecorder::kFormatVersion;
+static_assert(StreamingRecorder::kFormatVersion == kRecordFormatVersion,
+              "Format version of StreamingRecorder must match the record format");
+
+StreamingRecorder::StreamingRecorder(const std::string& path, size_t queue_capacity)
+    : impl_(new Impl(path, queue_capacity)) {}
+
+StreamingRecorder::~StreamingRecorder() noexcept = default;
+
+bool StreamingRecorder::record(const RobotState& robot_state,
+                               const RobotCommand& command) noexcept {
+  Sample sample;
+  sample.time = robot_state.time.toMSec();
+  sample.robot_mode = static_cast<uint64_t>(robot_state.robot_mode);
+  fillState(robot_state, &sample);
+  sample.command_q = command.joint_positions.q;
+  sample.command_dq = command.joint_velocities.dq;
+  sample.command_O_T_EE = command.cartesian_pose.O_T_EE;
+  sample.command_O_dP_EE = command.cartesian_velocities.O_dP_EE;
+  sample.command_tau_J = command.torques.tau_J;
+  return impl_->push(sample);
+}
+
+void StreamingRecorder::stop() noexcept {
+  impl_->stop();
+}
+
+uint64_t StreamingRecorder::writtenSamples() const noexcept {
+  return impl_->writtenSamples();
+}
+
+uint64_t StreamingRecorder::droppedSamples() const noexcept {
+  return impl_->droppedSamples();
+}
+
+bool recordRawSample(StreamingRecorder& recorder,
+                     const research_interface::robot::RobotState& robot_state,
+                     const research_interface::robot::RobotCommand& robot_command) noexcept {
+  Sample sample;
+  sample.time = robot_state.message_id;
+  sample.robot_mode = static_cast<uint64_t>(convertRobotMode(robot_state.robot_mode));
+  fillState(robot_state, &sample);
+  sample.command_q = robot_command.motion.q_c;
+  sample.command_dq = robot_command.motion.dq_c;
+  sample.command_O_T_EE = robot_command.motion.O_T_EE_c;
+  sample.command_O_dP_EE = robot_command.motion.O_dP_EE_c;
+  sample.command_tau_J = robot_command.control.tau_J_d;
+  return recorder.impl_->push(sample);
+}
+
+void recordingToArrow(const std::string& recording_path, const std::string& arrow_path) {
+  MemoryMappedFile recording(recording_path);
+  RecordFormatHeader header;
+  std::vector<FieldInfo> fields = readRecordHeader(recording.data(), recording.size(), &header);
+
+  std::ofstream file(arrow_path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw Exception("libfranka: Unable to open Arrow file " + arrow_path);
+  }
+  ArrowWriter writer(file, fields.data(), fields.size());
+  writer.writeBatch(recording.data() + header.header_size, header.record_size,
+                    (recording.size() - header.header_size) / header.record_size);
+  writer.finish();
+}
+
+}  // namespace franka
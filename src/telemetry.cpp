@@ -0,0 +1,655 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/telemetry.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <Poco/Net/DatagramSocket.h>
+#include <Poco/Net/NetException.h>
+#include <Poco/Timespan.h>
+
+#include <franka/exception.h>
+#include <franka/state_publisher.h>
+
+using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+
+namespace franka {
+
+constexpr uint8_t TelemetryEncoder::kVersion;
+constexpr size_t TelemetryEncoder::kMaxPacketSize;
+constexpr uint32_t TelemetryEncoder::kHistorySize;
+
+namespace {
+
+constexpr uint16_t kPacketMagic = 0xFE7D;
+constexpr uint8_t kKeyframe = 0x1;
+constexpr uint8_t kAcknowledgement = 0x2;
+
+// Time, five joint arrays, the pose, the wrench and the robot mode.
+constexpr size_t kMaxValues = 1 + 5 * 7 + 16 + 6 + 1;
+constexpr size_t kMaxVarintSize = 10;
+
+// Upper bound for the acknowledgements read per period, so a flood of packets cannot stall the
+// sender.
+constexpr int kMaxReceivesPerPeriod = 64;
+
+// Quantized values are clamped to the range in which doubles represent all integers.
+constexpr double kMaxQuantized = 9007199254740992.0;
+
+// All fields are naturally aligned, so the layout has no padding.
+struct Header {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint32_t fields;
+  // Random number of the encoder, so that decoders detect a restarted encoder.
+  uint32_t session;
+  uint32_t sequence;
+  // Sequence number of the packet the values are encoded against, if not a keyframe.
+  uint32_t reference;
+};
+
+// Sent after the header of keyframes.
+struct Resolutions {
+  double joint_position;
+  double joint_velocity;
+  double torque;
+  double pose;
+  double wrench;
+};
+
+static_assert(sizeof(Header) == 20, "Telemetry header must not contain padding.");
+static_assert(sizeof(Header) + sizeof(Resolutions) + kMaxValues * kMaxVarintSize <=
+                  TelemetryEncoder::kMaxPacketSize,
+              "Telemetry packets must fit into kMaxPacketSize.");
+
+using Values = std::array<int64_t, kMaxValues>;
+
+// Resolution of every value, in the order in which the values are sent.
+struct Layout {
+  Layout(TelemetryFields fields, const Resolutions& resolutions) noexcept : fields(fields) {
+    append(1, 1.0);
+    if (hasTelemetryFields(fields, TelemetryFields::kQ)) {
+      append(7, resolutions.joint_position);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kQD)) {
+      append(7, resolutions.joint_position);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kDq)) {
+      append(7, resolutions.joint_velocity);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kTauJ)) {
+      append(7, resolutions.torque);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kTauExtHatFiltered)) {
+      append(7, resolutions.torque);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kOTEE)) {
+      append(16, resolutions.pose);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kOFExtHatK)) {
+      append(6, resolutions.wrench);
+    }
+    if (hasTelemetryFields(fields, TelemetryFields::kRobotMode)) {
+      append(1, 1.0);
+    }
+  }
+
+  void append(size_t count, double resolution) noexcept {
+    std::fill_n(resolution_of.begin() + size, count, resolution);
+    size += count;
+  }
+
+  TelemetryFields fields;
+  size_t size{0};
+  std::array<double, kMaxValues> resolution_of{};
+};
+
+int64_t quantize(double value, double resolution) noexcept {
+  double scaled = std::round(value / resolution);
+  if (!std::isfinite(scaled)) {
+    return 0;
+  }
+  return static_cast<int64_t>(std::max(-kMaxQuantized, std::min(kMaxQuantized, scaled)));
+}
+
+template <size_t N>
+void gatherArray(const std::array<double, N>& array, double* values, size_t* count) noexcept {
+  std::copy(array.begin(), array.end(), values + *count);
+  *count += N;
+}
+
+template <size_t N>
+void scatterArray(const double* values, size_t* count, std::array<double, N>* array) noexcept {
+  std::copy(values + *count, values + *count + N, array->begin());
+  *count += N;
+}
+
+void quantize(const Layout& layout, const RobotState& robot_state, Values* quantized) noexcept {
+  std::array<double, kMaxValues> values;
+  size_t count = 0;
+  values[count++] = static_cast<double>(robot_state.time.toMSec());
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kQ)) {
+    gatherArray(robot_state.q, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kQD)) {
+    gatherArray(robot_state.q_d, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kDq)) {
+    gatherArray(robot_state.dq, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kTauJ)) {
+    gatherArray(robot_state.tau_J, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kTauExtHatFiltered)) {
+    gatherArray(robot_state.tau_ext_hat_filtered, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kOTEE)) {
+    gatherArray(robot_state.O_T_EE, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kOFExtHatK)) {
+    gatherArray(robot_state.O_F_ext_hat_K, values.data(), &count);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kRobotMode)) {
+    values[count++] = static_cast<double>(robot_state.robot_mode);
+  }
+  for (size_t i = 0; i < layout.size; i++) {
+    (*quantized)[i] = quantize(values[i], layout.resolution_of[i]);
+  }
+}
+
+void dequantize(const Layout& layout, const Values& quantized, RobotState* robot_state) noexcept {
+  std::array<double, kMaxValues> values;
+  for (size_t i = 0; i < layout.size; i++) {
+    values[i] = static_cast<double>(quantized[i]) * layout.resolution_of[i];
+  }
+  size_t count = 0;
+  robot_state->time = Duration(static_cast<uint64_t>(quantized[count++]));
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kQ)) {
+    scatterArray(values.data(), &count, &robot_state->q);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kQD)) {
+    scatterArray(values.data(), &count, &robot_state->q_d);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kDq)) {
+    scatterArray(values.data(), &count, &robot_state->dq);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kTauJ)) {
+    scatterArray(values.data(), &count, &robot_state->tau_J);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kTauExtHatFiltered)) {
+    scatterArray(values.data(), &count, &robot_state->tau_ext_hat_filtered);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kOTEE)) {
+    scatterArray(values.data(), &count, &robot_state->O_T_EE);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kOFExtHatK)) {
+    scatterArray(values.data(), &count, &robot_state->O_F_ext_hat_K);
+  }
+  if (hasTelemetryFields(layout.fields, TelemetryFields::kRobotMode)) {
+    int64_t mode = quantized[count++];
+    robot_state->robot_mode =
+        mode >= 0 && mode <= static_cast<int64_t>(RobotMode::kAutomaticErrorRecovery)
+            ? static_cast<RobotMode>(mode)
+            : RobotMode::kOther;
+  }
+}
+
+// Zigzag encoding maps small negative and positive differences to small unsigned integers.
+uint8_t* writeVarint(int64_t value, uint8_t* data) noexcept {
+  uint64_t bits = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  while (bits >= 0x80) {
+    *data++ = static_cast<uint8_t>(bits | 0x80);
+    bits >>= 7;
+  }
+  *data++ = static_cast<uint8_t>(bits);
+  return data;
+}
+
+const uint8_t* readVarint(const uint8_t* data, const uint8_t* end, int64_t* value) noexcept {
+  uint64_t bits = 0;
+  for (size_t shift = 0; shift < 64 && data < end; shift += 7) {
+    uint8_t byte = *data++;
+    bits |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = static_cast<int64_t>(bits >> 1) ^ -static_cast<int64_t>(bits & 1);
+      return data;
+    }
+  }
+  return nullptr;
+}
+
+bool isNewer(uint32_t sequence, uint32_t reference) noexcept {
+  return static_cast<int32_t>(sequence - reference) > 0;
+}
+
+bool validResolutions(const Resolutions& resolutions) noexcept {
+  for (double resolution :
+       {resolutions.joint_position, resolutions.joint_velocity, resolutions.torque,
+        resolutions.pose, resolutions.wrench}) {
+    if (!std::isfinite(resolution) || resolution <= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Poco::Net::SocketAddress resolve(const std::string& address, uint16_t port) try {
+  return Poco::Net::SocketAddress(address, port);
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: Invalid telemetry address "s + address + ": " + e.what());
+}
+
+}  // anonymous namespace
+
+class TelemetryEncoder::Impl {
+ public:
+  explicit Impl(const TelemetryOptions& options)
+      : resolutions_{options.joint_position_resolution, options.joint_velocity_resolution,
+                     options.torque_resolution, options.pose_resolution,
+                     options.wrench_resolution},
+        layout_(options.fields, resolutions_),
+        session_(std::random_device()()) {
+    if (!validResolutions(resolutions_)) {
+      throw std::invalid_argument("libfranka: Telemetry resolutions must be positive and finite.");
+    }
+  }
+
+  size_t encode(const RobotState& robot_state, uint8_t* packet) noexcept {
+    const uint32_t sequence = next_sequence_++;
+    Values& values = history_[sequence % kHistorySize];
+    quantize(layout_, robot_state, &values);
+
+    // The slot of the reference is only reused kHistorySize packets after it was sent.
+    const bool keyframe = !has_reference_ || sequence - reference_ >= kHistorySize;
+    Header header{kPacketMagic,
+                  kVersion,
+                  keyframe ? kKeyframe : uint8_t{0},
+                  static_cast<uint32_t>(layout_.fields),
+                  session_,
+                  sequence,
+                  keyframe ? 0 : reference_};
+    std::memcpy(packet, &header, sizeof(header));
+    uint8_t* data = packet + sizeof(header);
+    if (keyframe) {
+      std::memcpy(data, &resolutions_, sizeof(resolutions_));
+      data += sizeof(resolutions_);
+      for (size_t i = 0; i < layout_.size; i++) {
+        data = writeVarint(values[i], data);
+      }
+    } else {
+      const Values& reference = history_[reference_ % kHistorySize];
+      for (size_t i = 0; i < layout_.size; i++) {
+        data = writeVarint(values[i] - reference[i], data);
+      }
+    }
+    return static_cast<size_t>(data - packet);
+  }
+
+  bool acknowledge(const uint8_t* packet, size_t size) noexcept {
+    Header header;
+    if (size != sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, packet, sizeof(header));
+    if (header.magic != kPacketMagic || header.version != kVersion ||
+        header.flags != kAcknowledgement || header.session != session_) {
+      return false;
+    }
+
+    const uint32_t sequence = header.sequence;
+    if (isNewer(next_sequence_, sequence) && next_sequence_ - sequence <= kHistorySize &&
+        (!has_reference_ || isNewer(sequence, reference_))) {
+      has_reference_ = true;
+      reference_ = sequence;
+    }
+    return true;
+  }
+
+  void reset() noexcept { has_reference_ = false; }
+
+ private:
+  const Resolutions resolutions_;
+  const Layout layout_;
+  const uint32_t session_;
+  std::array<Values, kHistorySize> history_;
+  uint32_t next_sequence_{0};
+  bool has_reference_{false};
+  uint32_t reference_{0};
+};
+
+TelemetryEncoder::TelemetryEncoder(const TelemetryOptions& options)
+    : impl_(new Impl(options)) {}
+
+TelemetryEncoder::~TelemetryEncoder() noexcept = default;
+
+size_t TelemetryEncoder::encode(const RobotState& robot_state, uint8_t* packet) noexcept {
+  return impl_->encode(robot_state, packet);
+}
+
+bool TelemetryEncoder::acknowledge(const uint8_t* packet, size_t size) noexcept {
+  return impl_->acknowledge(packet, size);
+}
+
+void TelemetryEncoder::reset() noexcept {
+  impl_->reset();
+}
+
+class TelemetryDecoder::Impl {
+ public:
+  bool decode(const uint8_t* packet, size_t size, RobotState* robot_state) noexcept {
+    Header header;
+    if (size < sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, packet, sizeof(header));
+    const bool keyframe = header.flags == kKeyframe;
+    const bool new_session = !has_session_ || header.session != session_;
+    if (header.magic != kPacketMagic || header.version != TelemetryEncoder::kVersion ||
+        (header.flags != 0 && !keyframe) ||
+        (header.fields & ~static_cast<uint32_t>(TelemetryFields::kAll)) != 0 ||
+        (new_session ? !keyframe : !isNewer(header.sequence, last_sequence_))) {
+      return false;
+    }
+
+    const uint8_t* data = packet + sizeof(header);
+    const uint8_t* end = packet + size;
+    Resolutions resolutions = resolutions_;
+    const Values* reference = nullptr;
+    if (keyframe) {
+      if (static_cast<size_t>(end - data) < sizeof(resolutions)) {
+        return false;
+      }
+      std::memcpy(&resolutions, data, sizeof(resolutions));
+      data += sizeof(resolutions);
+      if (!validResolutions(resolutions)) {
+        return false;
+      }
+    } else {
+      const size_t slot = header.reference % TelemetryEncoder::kHistorySize;
+      if (header.fields != fields_ || !valid_[slot] || sequences_[slot] != header.reference) {
+        return false;
+      }
+      reference = &history_[slot];
+    }
+
+    Layout layout(static_cast<TelemetryFields>(header.fields), resolutions);
+    Values values;
+    for (size_t i = 0; i < layout.size; i++) {
+      int64_t value;
+      data = readVarint(data, end, &value);
+      if (data == nullptr) {
+        return false;
+      }
+      values[i] = reference != nullptr ? (*reference)[i] + value : value;
+    }
+    if (data != end) {
+      return false;
+    }
+
+    if (new_session) {
+      // References of the previous session cannot be used anymore.
+      valid_.fill(false);
+      has_session_ = true;
+      session_ = header.session;
+      fields_ = header.fields;
+      resolutions_ = resolutions;
+    }
+    const size_t slot = header.sequence % TelemetryEncoder::kHistorySize;
+    history_[slot] = values;
+    sequences_[slot] = header.sequence;
+    valid_[slot] = true;
+    last_sequence_ = header.sequence;
+    dequantize(layout, values, robot_state);
+    return true;
+  }
+
+  size_t acknowledgement(uint8_t* packet) const noexcept {
+    if (!has_session_) {
+      return 0;
+    }
+    Header header{kPacketMagic, TelemetryEncoder::kVersion, kAcknowledgement, 0, session_,
+                  last_sequence_, 0};
+    std::memcpy(packet, &header, sizeof(header));
+    return sizeof(header);
+  }
+
+ private:
+  bool has_session_{false};
+  uint32_t session_{0};
+  uint32_t fields_{0};
+  Resolutions resolutions_{};
+  uint32_t last_sequence_{0};
+  std::array<Values, TelemetryEncoder::kHistorySize> history_;
+  std::array<uint32_t, TelemetryEncoder::kHistorySize> sequences_{};
+  std::array<bool, TelemetryEncoder::kHistorySize> valid_{};
+};
+
+TelemetryDecoder::TelemetryDecoder() : impl_(new Impl) {}
+
+TelemetryDecoder::~TelemetryDecoder() noexcept = default;
+
+bool TelemetryDecoder::decode(const uint8_t* packet,
+                              size_t size,
+                              RobotState* robot_state) noexcept {
+  return impl_->decode(packet, size, robot_state);
+}
+
+size_t TelemetryDecoder::acknowledgement(uint8_t* packet) const noexcept {
+  return impl_->acknowledgement(packet);
+}
+
+class TelemetrySender::Impl {
+ public:
+  Impl(std::shared_ptr<StatePublisher> publisher,
+       const std::string& remote_address,
+       uint16_t remote_port,
+       std::chrono::microseconds period,
+       const TelemetryOptions& options)
+      : publisher_(std::move(publisher)),
+        remote_address_(resolve(remote_address, remote_port)),
+        period_(period),
+        encoder_(options) {
+    if (!publisher_) {
+      throw std::invalid_argument("libfranka: Telemetry publisher must not be null.");
+    }
+    if (period_.count() <= 0) {
+      throw std::invalid_argument("libfranka: Telemetry period must be positive.");
+    }
+    try {
+      socket_.bind({"0.0.0.0", 0});
+      socket_.setBlocking(false);
+    } catch (const Poco::Exception& e) {
+      throw NetworkException("libfranka: Unable to open telemetry socket: "s + e.what());
+    }
+    thread_ = std::thread(&Impl::run, this);
+  }
+
+  ~Impl() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+  }
+
+  TelemetryStatistics statistics() const noexcept {
+    TelemetryStatistics statistics;
+    statistics.sent = sent_.load(std::memory_order_relaxed);
+    statistics.keyframes = keyframes_.load(std::memory_order_relaxed);
+    statistics.bytes = bytes_.load(std::memory_order_relaxed);
+    statistics.send_errors = send_errors_.load(std::memory_order_relaxed);
+    statistics.acknowledgements = acknowledgements_.load(std::memory_order_relaxed);
+    return statistics;
+  }
+
+ private:
+  void run() noexcept {
+    uint64_t last_published = 0;
+    PublishedState sample;
+    std::array<uint8_t, TelemetryEncoder::kMaxPacketSize> packet;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (condition_.wait_for(lock, period_, [this]() { return stop_; })) {
+          return;
+        }
+      }
+
+      receiveAcknowledgements();
+      uint64_t published = publisher_->publishedStates();
+      if (published == last_published || !publisher_->read(&sample)) {
+        continue;
+      }
+      last_published = published;
+
+      size_t size = encoder_.encode(sample.robot_state, packet.data());
+      try {
+        if (socket_.sendTo(packet.data(), static_cast<int>(size), remote_address_) ==
+            static_cast<int>(size)) {
+          sent_.fetch_add(1, std::memory_order_relaxed);
+          bytes_.fetch_add(size, std::memory_order_relaxed);
+          if ((packet[offsetof(Header, flags)] & kKeyframe) != 0) {
+            keyframes_.fetch_add(1, std::memory_order_relaxed);
+          }
+          continue;
+        }
+      } catch (const Poco::Exception&) {
+      }
+      send_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void receiveAcknowledgements() noexcept {
+    std::array<uint8_t, TelemetryEncoder::kMaxPacketSize> packet;
+    Poco::Net::SocketAddress sender;
+    for (int i = 0; i < kMaxReceivesPerPeriod; i++) {
+      int size;
+      try {
+        if (socket_.available() <= 0) {
+          return;
+        }
+        size = socket_.receiveFrom(packet.data(), static_cast<int>(packet.size()), sender);
+      } catch (const Poco::Exception&) {
+        return;
+      }
+      if (size > 0 && encoder_.acknowledge(packet.data(), static_cast<size_t>(size))) {
+        acknowledgements_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  const std::shared_ptr<StatePublisher> publisher_;
+  const Poco::Net::SocketAddress remote_address_;
+  const std::chrono::microseconds period_;
+  Poco::Net::DatagramSocket socket_;
+  TelemetryEncoder encoder_;
+
+  std::atomic<uint64_t> sent_{0};
+  std::atomic<uint64_t> keyframes_{0};
+  std::atomic<uint64_t> bytes_{0};
+  std::atomic<uint64_t> send_errors_{0};
+  std::atomic<uint64_t> acknowledgements_{0};
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_{false};
+  std::thread thread_;
+};
+
+TelemetrySender::TelemetrySender(std::shared_ptr<StatePublisher> publisher,
+                                 const std::string& remote_address,
+                                 uint16_t remote_port,
+                                 std::chrono::microseconds period,
+                                 const TelemetryOptions& options)
+    : impl_(new Impl(std::move(publisher), remote_address, remote_port, period, options)) {}
+
+TelemetrySender::~TelemetrySender() noexcept = default;
+
+TelemetryStatistics TelemetrySender::statistics() const noexcept {
+  return impl_->statistics();
+}
+
+class TelemetryReceiver::Impl {
+ public:
+  explicit Impl(uint16_t local_port) {
+    try {
+      socket_.bind({"0.0.0.0", local_port});
+      local_port_ = socket_.address().port();
+    } catch (const Poco::Exception& e) {
+      throw NetworkException("libfranka: Unable to open telemetry socket: "s + e.what());
+    }
+  }
+
+  bool receive(RobotState* robot_state, std::chrono::microseconds timeout) noexcept {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    Poco::Net::SocketAddress sender;
+    while (true) {
+      auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+          deadline - std::chrono::steady_clock::now());
+      int size;
+      try {
+        if (remaining.count() < 0 ||
+            !socket_.poll(Poco::Timespan(remaining.count()), Poco::Net::Socket::SELECT_READ)) {
+          return false;
+        }
+        size = socket_.receiveFrom(packet_.data(), static_cast<int>(packet_.size()), sender);
+      } catch (const Poco::Exception&) {
+        return false;
+      }
+      if (size < 0 || !decoder_.decode(packet_.data(), static_cast<size_t>(size), robot_state)) {
+        invalid_++;
+        continue;
+      }
+
+      size_t acknowledgement_size = decoder_.acknowledgement(packet_.data());
+      try {
+        socket_.sendTo(packet_.data(), static_cast<int>(acknowledgement_size), sender);
+      } catch (const Poco::Exception&) {
+        // The sender keeps encoding against an older reference or sends keyframes.
+      }
+      return true;
+    }
+  }
+
+  uint16_t localPort() const noexcept { return local_port_; }
+
+  uint64_t invalidPackets() const noexcept { return invalid_; }
+
+ private:
+  Poco::Net::DatagramSocket socket_;
+  uint16_t local_port_{0};
+  TelemetryDecoder decoder_;
+  std::array<uint8_t, TelemetryEncoder::kMaxPacketSize> packet_;
+  uint64_t invalid_{0};
+};
+
+TelemetryReceiver::TelemetryReceiver(uint16_t local_port) : impl_(new Impl(local_port)) {}
+
+TelemetryReceiver::~TelemetryReceiver() noexcept = default;
+
+bool TelemetryReceiver::receive(RobotState* robot_state,
+                                std::chrono::microseconds timeout) noexcept {
+  return impl_->receive(robot_state, timeout);
+}
+
+uint16_t TelemetryReceiver::localPort() const noexcept {
+  return impl_->localPort();
+}
+
+uint64_t TelemetryReceiver::invalidPackets() const noexcept {
+  return impl_->invalidPackets();
+}
+
+}  // namespace franka
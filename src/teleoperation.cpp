@@ -0,0 +1,337 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/teleoperation.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Poco/Net/DatagramSocket.h>
+#include <Poco/Net/NetException.h>
+
+#include <franka/exception.h>
+
+#include "jitter_buffer.h"
+
+using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+
+namespace franka {
+
+namespace {
+
+constexpr uint16_t kPacketMagic = 0xFE7E;
+constexpr uint8_t kPacketVersion = 1;
+constexpr uint8_t kEchoValid = 0x1;
+
+// Upper bound for the datagrams read per cycle, so a flood of packets cannot stall the loop.
+constexpr int kMaxReceivesPerCycle = 64;
+
+// Smoothing factors of the round trip time (RFC 6298) and the interarrival jitter (RFC 3550).
+constexpr double kRoundTripTimeGain = 1.0 / 8.0;
+constexpr double kJitterGain = 1.0 / 16.0;
+
+// All fields are naturally aligned, so the layout has no padding.
+struct Packet {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint32_t sequence;
+  int64_t send_time;
+  int64_t echo_time;
+  int64_t echo_hold_time;
+  double position[3];
+  float orientation[4];
+  float twist[6];
+  float wrench[6];
+  float wave[6];
+};
+
+static_assert(sizeof(Packet) == 144, "Teleoperation packet must not contain padding.");
+
+int64_t nanoseconds(std::chrono::steady_clock::time_point time) noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+template <size_t N>
+void pack(const std::array<double, N>& source, float* destination) noexcept {
+  for (size_t i = 0; i < N; i++) {
+    destination[i] = static_cast<float>(source[i]);
+  }
+}
+
+template <size_t N>
+void unpack(const float* source, std::array<double, N>* destination) noexcept {
+  for (size_t i = 0; i < N; i++) {
+    (*destination)[i] = source[i];
+  }
+}
+
+void pack(const TeleoperationSample& sample, Packet* packet) noexcept {
+  Eigen::Map<const Eigen::Matrix4d> transform(sample.O_T_EE.data());
+  Eigen::Map<Eigen::Vector3d>(packet->position) = transform.topRightCorner<3, 1>();
+  Eigen::Quaterniond orientation(transform.topLeftCorner<3, 3>());
+  orientation.normalize();
+  Eigen::Map<Eigen::Vector4f>(packet->orientation) = orientation.coeffs().cast<float>();
+  pack(sample.O_dP_EE, packet->twist);
+  pack(sample.O_F, packet->wrench);
+  pack(sample.wave, packet->wave);
+}
+
+void unpack(const Packet& packet, TeleoperationSample* sample) noexcept {
+  Eigen::Quaterniond orientation(
+      Eigen::Map<const Eigen::Vector4f>(packet.orientation).cast<double>());
+  orientation.normalize();
+  Eigen::Map<Eigen::Matrix4d> transform(sample->O_T_EE.data());
+  transform.setIdentity();
+  transform.topLeftCorner<3, 3>() = orientation.toRotationMatrix();
+  transform.topRightCorner<3, 1>() = Eigen::Map<const Eigen::Vector3d>(packet.position);
+  unpack(packet.twist, &sample->O_dP_EE);
+  unpack(packet.wrench, &sample->O_F);
+  unpack(packet.wave, &sample->wave);
+}
+
+Poco::Net::SocketAddress resolve(const std::string& address, uint16_t port) try {
+  return Poco::Net::SocketAddress(address, port);
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: Invalid teleoperation address "s + address + ": " + e.what());
+}
+
+}  // anonymous namespace
+
+constexpr uint32_t TeleoperationChannel::kMaxJitterBufferDepth;
+
+class TeleoperationChannel::Impl {
+ public:
+  Impl(uint16_t local_port,
+       const std::string& remote_address,
+       uint16_t remote_port,
+       uint32_t jitter_buffer_depth)
+      : remote_address_(resolve(remote_address, remote_port)), buffer_(jitter_buffer_depth) {
+    try {
+      socket_.bind({"0.0.0.0", local_port});
+      socket_.setBlocking(false);
+      local_port_ = socket_.address().port();
+    } catch (const Poco::Exception& e) {
+      throw NetworkException("libfranka: Unable to open teleoperation channel: "s + e.what());
+    }
+  }
+
+  void setRemote(const std::string& remote_address, uint16_t remote_port) {
+    remote_address_ = resolve(remote_address, remote_port);
+  }
+
+  bool exchange(const TeleoperationSample& local, TeleoperationSample* remote) noexcept {
+    auto now = std::chrono::steady_clock::now();
+    receive(now);
+    send(local, now);
+
+    TeleoperationSample sample;
+    bool fresh = buffer_.pop(&sample, now);
+    if (fresh) {
+      remote_ = sample;
+    }
+    *remote = remote_;
+    return fresh;
+  }
+
+  TeleoperationStatistics statistics() const noexcept {
+    TeleoperationStatistics statistics;
+    statistics.sent = sent_;
+    statistics.send_errors = send_errors_;
+    statistics.received = buffer_.received();
+    statistics.invalid = invalid_;
+    statistics.lost = buffer_.lost();
+    statistics.late = buffer_.late();
+    statistics.underruns = buffer_.underruns();
+    statistics.skipped = buffer_.skipped();
+    statistics.buffered = buffer_.buffered();
+    statistics.round_trip_time = round_trip_time_;
+    statistics.one_way_delay = round_trip_time_ / 2;
+    statistics.jitter = jitter_;
+    statistics.playout_delay = buffer_.playoutDelay();
+    statistics.total_delay = statistics.one_way_delay + statistics.playout_delay;
+    return statistics;
+  }
+
+  uint16_t localPort() const noexcept { return local_port_; }
+
+ private:
+  void receive(std::chrono::steady_clock::time_point now) noexcept {
+    Packet packet;
+    Poco::Net::SocketAddress sender;
+    for (int i = 0; i < kMaxReceivesPerCycle; i++) {
+      int size;
+      try {
+        if (socket_.available() <= 0) {
+          return;
+        }
+        size = socket_.receiveFrom(&packet, sizeof(packet), sender);
+      } catch (const Poco::Exception&) {
+        return;
+      }
+      if (size < 0) {
+        return;
+      }
+      if (size != sizeof(packet) || packet.magic != kPacketMagic ||
+          packet.version != kPacketVersion) {
+        invalid_++;
+        continue;
+      }
+      process(packet, now);
+    }
+  }
+
+  void process(const Packet& packet, std::chrono::steady_clock::time_point now) noexcept {
+    int64_t now_ns = nanoseconds(now);
+    if ((packet.flags & kEchoValid) != 0) {
+      double round_trip_time = 1e-9 * (now_ns - packet.echo_time - packet.echo_hold_time);
+      if (round_trip_time >= 0) {
+        round_trip_time_ = measured_round_trip_
+                               ? round_trip_time_ +
+                                     kRoundTripTimeGain * (round_trip_time - round_trip_time_)
+                               : round_trip_time;
+        measured_round_trip_ = true;
+      }
+    }
+
+    // The transit time contains the unknown clock offset, which cancels in the difference.
+    int64_t transit = now_ns - packet.send_time;
+    if (has_transit_ && packet.sequence == last_sequence_ + 1) {
+      jitter_ += kJitterGain * (1e-9 * std::abs(transit - last_transit_) - jitter_);
+    }
+    has_transit_ = true;
+    last_transit_ = transit;
+    last_sequence_ = packet.sequence;
+
+    if (!has_echo_ || packet.send_time > echo_time_) {
+      has_echo_ = true;
+      echo_time_ = packet.send_time;
+      echo_received_ = now_ns;
+    }
+
+    TeleoperationSample sample;
+    unpack(packet, &sample);
+    buffer_.push(packet.sequence, sample, now);
+  }
+
+  void send(const TeleoperationSample& local, std::chrono::steady_clock::time_point now) noexcept {
+    Packet packet;
+    std::memset(&packet, 0, sizeof(packet));
+    packet.magic = kPacketMagic;
+    packet.version = kPacketVersion;
+    packet.sequence = sequence_++;
+    packet.send_time = nanoseconds(now);
+    if (has_echo_) {
+      packet.flags |= kEchoValid;
+      packet.echo_time = echo_time_;
+      packet.echo_hold_time = packet.send_time - echo_received_;
+    }
+    pack(local, &packet);
+
+    try {
+      if (socket_.sendTo(&packet, sizeof(packet), remote_address_) == sizeof(packet)) {
+        sent_++;
+        return;
+      }
+    } catch (const Poco::Exception&) {
+    }
+    send_errors_++;
+  }
+
+  Poco::Net::DatagramSocket socket_;
+  Poco::Net::SocketAddress remote_address_;
+  uint16_t local_port_{0};
+
+  JitterBuffer<TeleoperationSample> buffer_;
+  TeleoperationSample remote_;
+  uint32_t sequence_{0};
+
+  bool has_echo_{false};
+  int64_t echo_time_{0};
+  int64_t echo_received_{0};
+
+  bool measured_round_trip_{false};
+  double round_trip_time_{0};
+  bool has_transit_{false};
+  int64_t last_transit_{0};
+  uint32_t last_sequence_{0};
+  double jitter_{0};
+
+  uint64_t sent_{0};
+  uint64_t send_errors_{0};
+  uint64_t invalid_{0};
+};
+
+TeleoperationChannel::TeleoperationChannel(uint16_t local_port,
+                                           const std::string& remote_address,
+                                           uint16_t remote_port,
+                                           uint32_t jitter_buffer_depth) {
+  if (jitter_buffer_depth > kMaxJitterBufferDepth) {
+    throw std::invalid_argument("libfranka: Teleoperation jitter buffer depth must not exceed " +
+                                std::to_string(kMaxJitterBufferDepth) + ".");
+  }
+  impl_.reset(new Impl(local_port, remote_address, remote_port, jitter_buffer_depth));
+}
+
+TeleoperationChannel::~TeleoperationChannel() noexcept = default;
+
+void TeleoperationChannel::setRemote(const std::string& remote_address, uint16_t remote_port) {
+  impl_->setRemote(remote_address, remote_port);
+}
+
+bool TeleoperationChannel::exchange(const TeleoperationSample& local,
+                                    TeleoperationSample* remote) noexcept {
+  return impl_->exchange(local, remote);
+}
+
+TeleoperationStatistics TeleoperationChannel::statistics() const noexcept {
+  return impl_->statistics();
+}
+
+uint16_t TeleoperationChannel::localPort() const noexcept {
+  return impl_->localPort();
+}
+
+WaveVariables::WaveVariables(double translational_impedance, double rotational_impedance) {
+  if (!(translational_impedance > 0) || !(rotational_impedance > 0) ||
+      !std::isfinite(translational_impedance) || !std::isfinite(rotational_impedance)) {
+    throw std::invalid_argument("libfranka: Wave impedances must be positive.");
+  }
+  for (size_t i = 0; i < 3; i++) {
+    impedance_[i] = translational_impedance;
+    impedance_[i + 3] = rotational_impedance;
+  }
+}
+
+void WaveVariables::leader(const std::array<double, 6>& velocity,
+                           const std::array<double, 6>& received_wave,
+                           std::array<double, 6>* wrench,
+                           std::array<double, 6>* wave) const noexcept {
+  for (size_t i = 0; i < 6; i++) {
+    double b = impedance_[i];
+    double scale = std::sqrt(2 * b);
+    (*wrench)[i] = b * velocity[i] - scale * received_wave[i];
+    (*wave)[i] = scale * velocity[i] - received_wave[i];
+  }
+}
+
+void WaveVariables::follower(const std::array<double, 6>& wrench,
+                             const std::array<double, 6>& received_wave,
+                             std::array<double, 6>* velocity,
+                             std::array<double, 6>* wave) const noexcept {
+  for (size_t i = 0; i < 6; i++) {
+    double b = impedance_[i];
+    (*velocity)[i] = (std::sqrt(2 * b) * received_wave[i] - wrench[i]) / b;
+    (*wave)[i] = received_wave[i] - std::sqrt(2 / b) * wrench[i];
+  }
+}
+
+const std::array<double, 6>& WaveVariables::impedance() const noexcept {
+  return impedance_;
+}
+
+}  // namespace franka
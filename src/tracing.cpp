@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "tracing.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "platform.h"
+
+#if defined(LIBFRANKA_TRACING) && defined(LIBFRANKA_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace franka {
+
+size_t formatTraceEvent(char* buffer,
+                        size_t size,
+                        char type,
+                        int pid,
+                        const char* name,
+                        int64_t value) noexcept {
+  int length = 0;
+  if (type == 'E') {
+    length = std::snprintf(buffer, size, "E|%d", pid);
+  } else if (type == 'C') {
+    length = std::snprintf(buffer, size, "C|%d|%s|%" PRId64, pid, name, value);
+  } else {
+    length = std::snprintf(buffer, size, "%c|%d|%s", type, pid, name);
+  }
+  if (length < 0 || size == 0) {
+    return 0;
+  }
+  return static_cast<size_t>(length) < size ? static_cast<size_t>(length) : size - 1;
+}
+
+#if defined(LIBFRANKA_TRACING) && defined(LIBFRANKA_LINUX)
+
+namespace {
+
+constexpr size_t kMaxEventLength = 128;
+
+struct TraceMarker {
+  TraceMarker() noexcept : pid(getpid()) {
+    descriptor = open("/sys/kernel/tracing/trace_marker", O_WRONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+      descriptor = open("/sys/kernel/debug/tracing/trace_marker", O_WRONLY | O_CLOEXEC);
+    }
+  }
+  ~TraceMarker() noexcept {
+    if (descriptor >= 0) {
+      close(descriptor);
+    }
+  }
+
+  int descriptor;
+  int pid;
+};
+
+}  // anonymous namespace
+
+void Tracing::write(char type, const char* name, int64_t value) noexcept {
+  static const TraceMarker marker;
+  if (marker.descriptor < 0) {
+    return;
+  }
+  char buffer[kMaxEventLength];
+  size_t length = formatTraceEvent(buffer, sizeof(buffer), type, marker.pid, name, value);
+  // Nothing sensible can be done if the event is lost.
+  static_cast<void>(::write(marker.descriptor, buffer, length));
+}
+
+#else
+
+void Tracing::write(char /* type */, const char* /* name */, int64_t /* value */) noexcept {}
+
+#endif
+
+}  // namespace franka
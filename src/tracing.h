@@ -0,0 +1,95 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace franka {
+
+/**
+ * Formats a trace event in the text format of Android's atrace, which Perfetto and other trace
+ * viewers parse from the `print` events of the kernel's ftrace buffer:
+ *
+ * - `B|<pid>|<name>` begins a slice on the calling thread,
+ * - `E|<pid>` ends the innermost slice of the calling thread,
+ * - `C|<pid>|<name>|<value>` sets the value of a counter.
+ *
+ * @param[out] buffer Buffer for the event. The result is truncated to size - 1 characters and
+ * zero-terminated.
+ * @param[in] size Size of the buffer.
+ * @param[in] type One of 'B', 'E' and 'C'.
+ * @param[in] pid Process ID.
+ * @param[in] name Name of the slice or counter. Ignored for 'E'.
+ * @param[in] value Value of the counter. Ignored unless type is 'C'.
+ *
+ * @return Length of the event, without the terminating zero.
+ */
+size_t formatTraceEvent(char* buffer,
+                        size_t size,
+                        char type,
+                        int pid,
+                        const char* name,
+                        int64_t value) noexcept;
+
+#ifdef LIBFRANKA_TRACING
+constexpr bool kTracingEnabled = true;
+#else
+constexpr bool kTracingEnabled = false;
+#endif
+
+/**
+ * Writes trace events into the kernel's ftrace buffer through `trace_marker`, so that they appear
+ * on the same timeline as scheduler and interrupt events, e.g. when recording with Perfetto or
+ * `trace-cmd record -e sched -e irq`.
+ *
+ * Without the `TRACING` build option, all calls are compiled out. If `trace_marker` cannot be
+ * opened, e.g. for lack of permissions, events are discarded.
+ */
+class Tracing {
+ public:
+  static void begin(const char* name) noexcept {
+    if (kTracingEnabled) {
+      write('B', name, 0);
+    }
+  }
+  static void end() noexcept {
+    if (kTracingEnabled) {
+      write('E', "", 0);
+    }
+  }
+  static void counter(const char* name, int64_t value) noexcept {
+    if (kTracingEnabled) {
+      write('C', name, value);
+    }
+  }
+
+ private:
+  static void write(char type, const char* name, int64_t value) noexcept;
+};
+
+/**
+ * Traces a slice from construction until stop() is called or the scope is left.
+ */
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name) noexcept : active_(kTracingEnabled) {
+    Tracing::begin(name);
+  }
+  ~TraceScope() noexcept { stop(); }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  void stop() noexcept {
+    if (active_) {
+      Tracing::end();
+      active_ = false;
+    }
+  }
+
+ private:
+  bool active_;
+};
+
+}  // namespace franka
@@ -0,0 +1,332 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/trajectory_validation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+
+namespace franka {
+
+namespace {
+
+// Rates of a trajectory, checked in groups. A group is a single joint, or a translational or
+// rotational velocity vector, whose Euclidean norm is limited as in limitRate.
+struct Group {
+  size_t offset;
+  size_t size;
+  double max_velocity;
+  double max_acceleration;
+  double max_jerk;
+};
+
+template <size_t N>
+using Rates = std::array<double, N>;
+
+// Flags acceleration and jerk violations with the same bounds limitRate enforces: the jerk is
+// limited first, then the acceleration to the bound that still allows stopping at the velocity
+// limit. Accelerations and jerks are only checked if the previous rates are known.
+template <size_t N>
+void checkGroup(const Group& group,
+                const Rates<N>& rates,
+                const Rates<N>* last_rates,
+                const Rates<N>* second_last_rates,
+                TrajectoryViolation* violation) {
+  double velocity = 0;
+  for (size_t i = group.offset; i < group.offset + group.size; i++) {
+    velocity += rates[i] * rates[i];
+  }
+  violation->velocity |= std::sqrt(velocity) > group.max_velocity;
+  if (last_rates == nullptr || !std::isfinite(group.max_acceleration)) {
+    return;
+  }
+
+  double acceleration = 0;
+  double dot_product = 0;
+  double last_velocity = 0;
+  for (size_t i = group.offset; i < group.offset + group.size; i++) {
+    double component = (rates[i] - (*last_rates)[i]) / kDeltaT;
+    acceleration += component * component;
+    dot_product += component * (*last_rates)[i];
+    last_velocity += (*last_rates)[i] * (*last_rates)[i];
+  }
+  acceleration = std::sqrt(acceleration);
+  if (acceleration > kNormEps) {
+    // Distance to the velocity limit along the direction of the acceleration.
+    dot_product /= acceleration;
+    double distance_to_max_velocity =
+        -dot_product + std::sqrt(dot_product * dot_product - last_velocity +
+                                 group.max_velocity * group.max_velocity);
+    double safe_max_acceleration = std::min(
+        (group.max_jerk / group.max_acceleration) * distance_to_max_velocity,
+        group.max_acceleration);
+    violation->acceleration |= !(acceleration <= safe_max_acceleration);
+  }
+  if (second_last_rates == nullptr) {
+    return;
+  }
+
+  double jerk = 0;
+  for (size_t i = group.offset; i < group.offset + group.size; i++) {
+    double component = ((rates[i] - (*last_rates)[i]) -
+                        ((*last_rates)[i] - (*second_last_rates)[i])) /
+                       (kDeltaT * kDeltaT);
+    jerk += component * component;
+  }
+  violation->jerk |= std::sqrt(jerk) > group.max_jerk;
+}
+
+bool violates(const TrajectoryViolation& violation) {
+  return violation.not_finite || violation.invalid_pose || violation.position_limit ||
+         violation.velocity || violation.acceleration || violation.jerk;
+}
+
+/**
+ * Checks samples [0, size) in contiguous chunks, one per thread.
+ *
+ * `rates(i, &rates)` computes the rates at sample i, which may be negative, and returns false if
+ * they are unknown. `check_sample(i, &violation)` checks the values of sample i itself.
+ */
+template <size_t N, typename RateFunction, typename SampleFunction>
+std::vector<TrajectoryViolation> validate(size_t size,
+                                          const std::vector<Group>& groups,
+                                          const RateFunction& rates,
+                                          const SampleFunction& check_sample,
+                                          size_t thread_count) {
+  auto check = [&](size_t begin, size_t end, std::vector<TrajectoryViolation>* violations) {
+    // The rates of the two previous samples are needed for accelerations and jerks, so they are
+    // computed again at the start of each chunk.
+    Rates<N> second_last{};
+    Rates<N> last{};
+    Rates<N> current{};
+    bool has_second_last = rates(static_cast<ptrdiff_t>(begin) - 2, &second_last);
+    bool has_last = rates(static_cast<ptrdiff_t>(begin) - 1, &last);
+    for (size_t i = begin; i < end; i++) {
+      TrajectoryViolation violation;
+      violation.index = i;
+      check_sample(i, &violation);
+      bool has_current = rates(static_cast<ptrdiff_t>(i), &current);
+      if (has_current) {
+        for (const Group& group : groups) {
+          checkGroup(group, current, has_last ? &last : nullptr,
+                     has_last && has_second_last ? &second_last : nullptr, &violation);
+        }
+      }
+      if (violates(violation)) {
+        violations->push_back(violation);
+      }
+      second_last = last;
+      has_second_last = has_last;
+      last = current;
+      has_last = has_current;
+    }
+  };
+
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  // Chunks shorter than this are not worth a thread.
+  constexpr size_t kMinChunkSize = 4096;
+  thread_count = std::max<size_t>(std::min(thread_count, size / kMinChunkSize), 1);
+
+  std::vector<std::vector<TrajectoryViolation>> chunk_violations(thread_count);
+  size_t chunk_size = (size + thread_count - 1) / thread_count;
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t chunk = 1; chunk < thread_count; chunk++) {
+    size_t begin = std::min(chunk * chunk_size, size);
+    threads.emplace_back(check, begin, std::min(begin + chunk_size, size),
+                         &chunk_violations[chunk]);
+  }
+  check(0, std::min(chunk_size, size), &chunk_violations[0]);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<TrajectoryViolation> violations = std::move(chunk_violations[0]);
+  for (size_t chunk = 1; chunk < thread_count; chunk++) {
+    violations.insert(violations.end(), chunk_violations[chunk].begin(),
+                      chunk_violations[chunk].end());
+  }
+  return violations;
+}
+
+// Rates of trajectories given as positions, obtained by backward differences. Before the first
+// sample, the robot is at rest if start_at_rest is set.
+template <size_t N, typename Difference>
+bool differentiate(ptrdiff_t index,
+                   bool start_at_rest,
+                   const Difference& difference,
+                   Rates<N>* rates) {
+  if (index <= 0) {
+    rates->fill(0);
+    return start_at_rest;
+  }
+  difference(static_cast<size_t>(index), rates);
+  return true;
+}
+
+// Rates of trajectories given as velocities.
+template <size_t N, typename Sample>
+bool sampleRates(ptrdiff_t index, bool start_at_rest, const Sample& sample, Rates<N>* rates) {
+  if (index < 0) {
+    rates->fill(0);
+    return start_at_rest;
+  }
+  sample(static_cast<size_t>(index), rates);
+  return true;
+}
+
+std::vector<Group> jointGroups() {
+  std::vector<Group> groups;
+  for (size_t i = 0; i < 7; i++) {
+    groups.push_back({i, 1, kMaxJointVelocity[i], kMaxJointAcceleration[i], kMaxJointJerk[i]});
+  }
+  return groups;
+}
+
+std::vector<Group> cartesianGroups(double rotational_factor, bool elbow) {
+  std::vector<Group> groups{
+      {0, 3, kMaxTranslationalVelocity, kMaxTranslationalAcceleration, kMaxTranslationalJerk},
+      {3, 3, rotational_factor * kMaxRotationalVelocity,
+       rotational_factor * kMaxRotationalAcceleration, rotational_factor * kMaxRotationalJerk}};
+  if (elbow) {
+    groups.push_back({6, 1, kMaxElbowVelocity, kMaxElbowAcceleration, kMaxElbowJerk});
+  }
+  return groups;
+}
+
+template <typename T>
+void checkElbow(const T& sample,
+                bool elbow,
+                const TrajectoryValidationOptions& options,
+                TrajectoryViolation* violation) {
+  if (sample.hasElbow() != elbow || (elbow && !isValidElbow(sample.elbow))) {
+    violation->invalid_pose = true;
+  }
+  violation->not_finite |= !hasFiniteSum(sample.elbow);
+  violation->position_limit |= elbow && (sample.elbow[0] < options.min_joint_position[2] ||
+                                         sample.elbow[0] > options.max_joint_position[2]);
+}
+
+}  // anonymous namespace
+
+std::vector<TrajectoryViolation> validateTrajectory(const std::vector<JointPositions>& trajectory,
+                                                    const TrajectoryValidationOptions& options) {
+  auto rates = [&](ptrdiff_t index, Rates<7>* rates) {
+    return differentiate(index, options.start_at_rest,
+                         [&](size_t i, Rates<7>* result) {
+                           for (size_t j = 0; j < 7; j++) {
+                             (*result)[j] = (trajectory[i].q[j] - trajectory[i - 1].q[j]) / kDeltaT;
+                           }
+                         },
+                         rates);
+  };
+  auto check_sample = [&](size_t i, TrajectoryViolation* violation) {
+    const std::array<double, 7>& q = trajectory[i].q;
+    violation->not_finite = !hasFiniteSum(q);
+    for (size_t j = 0; j < 7; j++) {
+      violation->position_limit |=
+          q[j] < options.min_joint_position[j] || q[j] > options.max_joint_position[j];
+    }
+  };
+  return validate<7>(trajectory.size(), jointGroups(), rates, check_sample, options.thread_count);
+}
+
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<JointVelocities>& trajectory,
+    const TrajectoryValidationOptions& options) {
+  auto rates = [&](ptrdiff_t index, Rates<7>* rates) {
+    return sampleRates(index, options.start_at_rest,
+                       [&](size_t i, Rates<7>* result) { *result = trajectory[i].dq; }, rates);
+  };
+  auto check_sample = [&](size_t i, TrajectoryViolation* violation) {
+    violation->not_finite = !hasFiniteSum(trajectory[i].dq);
+  };
+  return validate<7>(trajectory.size(), jointGroups(), rates, check_sample, options.thread_count);
+}
+
+std::vector<TrajectoryViolation> validateTrajectory(const std::vector<CartesianPose>& trajectory,
+                                                    const TrajectoryValidationOptions& options) {
+  bool elbow = !trajectory.empty() && trajectory.front().hasElbow();
+  auto rates = [&](ptrdiff_t index, Rates<7>* rates) {
+    return differentiate(
+        index, options.start_at_rest,
+        [&](size_t i, Rates<7>* result) {
+          Eigen::Map<const Eigen::Matrix4d> pose(trajectory[i].O_T_EE.data());
+          Eigen::Map<const Eigen::Matrix4d> last_pose(trajectory[i - 1].O_T_EE.data());
+          Eigen::Map<Eigen::Vector3d>(result->data()) =
+              (pose.topRightCorner<3, 1>() - last_pose.topRightCorner<3, 1>()) / kDeltaT;
+          Eigen::AngleAxisd rotation(Eigen::Matrix3d(
+              pose.topLeftCorner<3, 3>() * last_pose.topLeftCorner<3, 3>().transpose()));
+          Eigen::Map<Eigen::Vector3d>(result->data() + 3) =
+              rotation.axis() * rotation.angle() / kDeltaT;
+          (*result)[6] = (trajectory[i].elbow[0] - trajectory[i - 1].elbow[0]) / kDeltaT;
+        },
+        rates);
+  };
+  auto check_sample = [&](size_t i, TrajectoryViolation* violation) {
+    violation->not_finite = !hasFiniteSum(trajectory[i].O_T_EE);
+    violation->invalid_pose = !isHomogeneousTransformation(trajectory[i].O_T_EE);
+    checkElbow(trajectory[i], elbow, options, violation);
+  };
+  return validate<7>(trajectory.size(),
+                     cartesianGroups(kFactorCartesianRotationPoseInterface, elbow), rates,
+                     check_sample, options.thread_count);
+}
+
+std::vector<TrajectoryViolation> validateTrajectory(
+    const std::vector<CartesianVelocities>& trajectory,
+    const TrajectoryValidationOptions& options) {
+  bool elbow = !trajectory.empty() && trajectory.front().hasElbow();
+  auto rates = [&](ptrdiff_t index, Rates<7>* rates) {
+    return sampleRates(index, options.start_at_rest,
+                       [&](size_t i, Rates<7>* result) {
+                         std::copy(trajectory[i].O_dP_EE.begin(), trajectory[i].O_dP_EE.end(),
+                                   result->begin());
+                         (*result)[6] = 0;
+                         if (i > 0) {
+                           (*result)[6] =
+                               (trajectory[i].elbow[0] - trajectory[i - 1].elbow[0]) / kDeltaT;
+                         }
+                       },
+                       rates);
+  };
+  auto check_sample = [&](size_t i, TrajectoryViolation* violation) {
+    violation->not_finite = !hasFiniteSum(trajectory[i].O_dP_EE);
+    checkElbow(trajectory[i], elbow, options, violation);
+  };
+  return validate<7>(trajectory.size(), cartesianGroups(1.0, elbow), rates, check_sample,
+                     options.thread_count);
+}
+
+std::vector<TrajectoryViolation> validateTrajectory(const std::vector<Torques>& trajectory,
+                                                    const TrajectoryValidationOptions& options) {
+  std::vector<Group> groups;
+  for (size_t i = 0; i < 7; i++) {
+    groups.push_back({i, 1, kMaxTorqueRate[i], std::numeric_limits<double>::infinity(),
+                      std::numeric_limits<double>::infinity()});
+  }
+  auto rates = [&](ptrdiff_t index, Rates<7>* rates) {
+    return differentiate(index, options.start_at_rest,
+                         [&](size_t i, Rates<7>* result) {
+                           for (size_t j = 0; j < 7; j++) {
+                             (*result)[j] =
+                                 (trajectory[i].tau_J[j] - trajectory[i - 1].tau_J[j]) / kDeltaT;
+                           }
+                         },
+                         rates);
+  };
+  auto check_sample = [&](size_t i, TrajectoryViolation* violation) {
+    violation->not_finite = !hasFiniteSum(trajectory[i].tau_J);
+  };
+  return validate<7>(trajectory.size(), groups, rates, check_sample, options.thread_count);
+}
+
+}  // namespace franka
@@ -0,0 +1,85 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace franka {
+
+/**
+ * Wait-free handoff of the latest value from exactly one producer thread to exactly one consumer
+ * thread.
+ *
+ * Producer and consumer each own one of three buffers, the third one holds the latest published
+ * value. Publishing and acquiring swap buffers with a single atomic exchange, so neither side ever
+ * blocks, allocates or sees a partially written value. Values that are overwritten before the
+ * consumer acquires them are skipped.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+  explicit TripleBuffer(const T& initial_value) { buffers_.fill(initial_value); }
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  /**
+   * Buffer to fill before calling publish(). May only be used by the producer thread.
+   */
+  T& back() noexcept { return buffers_[back_]; }
+
+  /**
+   * Makes the contents of back() the latest value. May only be called by the producer thread.
+   */
+  void publish() noexcept {
+    back_ = latest_.exchange(back_ | kFreshBit, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  /**
+   * Copies the value into back() and publishes it. May only be called by the producer thread.
+   */
+  void write(const T& value) noexcept {
+    back() = value;
+    publish();
+  }
+
+  /**
+   * Makes the latest published value available in front(). May only be called by the consumer
+   * thread.
+   *
+   * @return False if nothing was published since the last call, in which case front() is
+   * unchanged.
+   */
+  bool acquire() noexcept {
+    if ((latest_.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+      return false;
+    }
+    front_ = latest_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  /**
+   * Value acquired by the last call to acquire(). May only be used by the consumer thread.
+   */
+  const T& front() const noexcept { return buffers_[front_]; }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFreshBit = 0x4;
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Keeps the indices of producer and consumer on separate cache lines.
+  std::array<T, 3> buffers_{};
+  char padding0_[kCacheLineSize];
+  uint8_t back_{0};
+  char padding1_[kCacheLineSize];
+  std::atomic<uint8_t> latest_{1};
+  char padding2_[kCacheLineSize];
+  uint8_t front_{2};
+};
+
+}  // namespace franka
@@ -0,0 +1,203 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include "udp_transport.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <franka/exception.h>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <time.h>
+#endif
+
+using namespace std::string_literals;  // NOLINT(google-build-using-namespace)
+
+namespace franka {
+
+#ifdef __linux__
+namespace {
+
+// Control message buffer for a single SCM_TIMESTAMPNS receive timestamp.
+struct alignas(cmsghdr) TimestampControl {
+  std::array<uint8_t, CMSG_SPACE(sizeof(timespec))> data;
+};
+
+void prepareTimestampControl(msghdr* message, TimestampControl* control) noexcept {
+  message->msg_control = control->data.data();
+  message->msg_controllen = control->data.size();
+}
+
+std::chrono::system_clock::time_point readReceiveTimestamp(msghdr* message) noexcept {
+  for (cmsghdr* header = CMSG_FIRSTHDR(message); header != nullptr;
+       header = CMSG_NXTHDR(message, header)) {
+    if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_TIMESTAMPNS) {
+      timespec timestamp{};
+      std::memcpy(&timestamp, CMSG_DATA(header), sizeof(timestamp));
+      return std::chrono::system_clock::time_point(
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              std::chrono::seconds(timestamp.tv_sec) +
+              std::chrono::nanoseconds(timestamp.tv_nsec)));
+    }
+  }
+  return {};
+}
+
+}  // anonymous namespace
+#endif
+
+constexpr size_t UdpTransport::kBatchSize;
+
+UdpTransport::UdpTransport(std::chrono::milliseconds receive_timeout) try {
+  socket_.bind({"0.0.0.0", 0});
+  socket_.setReceiveTimeout(Poco::Timespan{1000l * receive_timeout.count()});
+#ifdef __linux__
+  try {
+    socket_.setOption(SOL_SOCKET, SO_TIMESTAMPNS, 1);
+  } catch (...) {
+  }
+#endif
+  port_ = socket_.address().port();
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: UDP socket: "s + e.what());
+}
+
+uint16_t UdpTransport::port() const noexcept {
+  return port_;
+}
+
+bool UdpTransport::available(size_t size) try {
+  return socket_.available() >= static_cast<int>(size);
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: UDP receive: "s + e.what());
+}
+
+void UdpTransport::receive(uint8_t* buffer,
+                           size_t size,
+                           std::chrono::system_clock::time_point* receive_time) try {
+#ifdef __linux__
+  iovec io_vector{buffer, size};
+  sockaddr_storage address{};
+  TimestampControl control;
+  msghdr message{};
+  message.msg_iov = &io_vector;
+  message.msg_iovlen = 1;
+  message.msg_name = &address;
+  message.msg_namelen = sizeof(address);
+  prepareTimestampControl(&message, &control);
+
+  // Blocks up to the receive timeout set on the socket.
+  ssize_t received;
+  do {
+    received = recvmsg(socket_.impl()->sockfd(), &message, 0);
+  } while (received < 0 && errno == EINTR);
+  if (received < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      throw NetworkException("libfranka: UDP receive: Timeout");
+    }
+    throw NetworkException("libfranka: UDP receive: "s + std::strerror(errno));
+  }
+  if (received != static_cast<ssize_t>(size) || (message.msg_flags & MSG_TRUNC) != 0) {
+    throw ProtocolException("libfranka: incorrect object size");
+  }
+
+  server_address_ =
+      Poco::Net::SocketAddress(reinterpret_cast<const sockaddr*>(&address), message.msg_namelen);
+  *receive_time = readReceiveTimestamp(&message);
+#else
+  int received = socket_.receiveFrom(buffer, static_cast<int>(size), server_address_);
+  if (received != static_cast<int>(size)) {
+    throw ProtocolException("libfranka: incorrect object size");
+  }
+  *receive_time = {};
+#endif
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: UDP receive: "s + e.what());
+}
+
+size_t UdpTransport::receiveBatch(uint8_t* buffer,
+                                  size_t message_size,
+                                  size_t max_messages,
+                                  std::chrono::system_clock::time_point* receive_times) try {
+#ifdef __linux__
+  std::array<mmsghdr, kBatchSize> messages{};
+  std::array<iovec, kBatchSize> iovecs{};
+  std::array<sockaddr_storage, kBatchSize> addresses{};
+  std::array<TimestampControl, kBatchSize> controls;
+  max_messages = std::min(max_messages, kBatchSize);
+  for (size_t i = 0; i < max_messages; i++) {
+    iovecs[i].iov_base = buffer + i * message_size;
+    iovecs[i].iov_len = message_size;
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_name = &addresses[i];
+    messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+    prepareTimestampControl(&messages[i].msg_hdr, &controls[i]);
+  }
+
+  int received = recvmmsg(socket_.impl()->sockfd(), messages.data(),
+                          static_cast<unsigned int>(max_messages), MSG_DONTWAIT, nullptr);
+  if (received < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return 0;
+    }
+    throw NetworkException("libfranka: UDP receive: "s + std::strerror(errno));
+  }
+
+  for (int i = 0; i < received; i++) {
+    if (messages[i].msg_len != message_size || (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+      throw ProtocolException("libfranka: incorrect object size");
+    }
+    receive_times[i] = readReceiveTimestamp(&messages[i].msg_hdr);
+  }
+  if (received > 0) {
+    const mmsghdr& last = messages[received - 1];
+    server_address_ = Poco::Net::SocketAddress(
+        reinterpret_cast<const sockaddr*>(last.msg_hdr.msg_name), last.msg_hdr.msg_namelen);
+  }
+  return static_cast<size_t>(received);
+#else
+  size_t received = 0;
+  while (received < max_messages && socket_.available() >= static_cast<int>(message_size)) {
+    int bytes_received = socket_.receiveFrom(buffer + received * message_size,
+                                             static_cast<int>(message_size), server_address_);
+    if (bytes_received != static_cast<int>(message_size)) {
+      throw ProtocolException("libfranka: incorrect object size");
+    }
+    receive_times[received] = {};
+    received++;
+  }
+  return received;
+#endif
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: UDP receive: "s + e.what());
+}
+
+void UdpTransport::send(const uint8_t* data, size_t size) try {
+  int bytes_sent = socket_.sendTo(data, static_cast<int>(size), server_address_);
+  if (bytes_sent != static_cast<int>(size)) {
+    throw NetworkException("libfranka: could not send UDP data");
+  }
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: UDP send: "s + e.what());
+}
+
+bool UdpTransport::wait(std::chrono::microseconds timeout) try {
+  return socket_.poll(Poco::Timespan(timeout.count()), Poco::Net::Socket::SELECT_READ);
+} catch (const Poco::Exception& e) {
+  throw NetworkException("libfranka: UDP poll: "s + e.what());
+}
+
+int UdpTransport::descriptor() const noexcept {
+#ifdef __linux__
+  return socket_.impl()->sockfd();
+#else
+  return -1;
+#endif
+}
+
+}  // namespace franka
@@ -0,0 +1,56 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <Poco/Net/DatagramSocket.h>
+#include <Poco/Net/SocketAddress.h>
+
+#include "datagram_transport.h"
+
+namespace franka {
+
+/**
+ * Default transport, which exchanges datagrams with the device over UDP.
+ *
+ * Datagrams are sent to the address that the last datagram has been received from. On Linux,
+ * queued datagrams are received in batches with `recvmmsg`, and kernel receive timestamps are
+ * enabled with `SO_TIMESTAMPNS`.
+ */
+class UdpTransport : public DatagramTransport {
+ public:
+  /**
+   * Binds a UDP socket to a free port.
+   *
+   * @param[in] receive_timeout Timeout for blocking receives.
+   *
+   * @throw NetworkException if the socket cannot be created.
+   */
+  explicit UdpTransport(std::chrono::milliseconds receive_timeout);
+
+  uint16_t port() const noexcept override;
+  bool available(size_t size) override;
+  void receive(uint8_t* buffer,
+               size_t size,
+               std::chrono::system_clock::time_point* receive_time) override;
+  size_t receiveBatch(uint8_t* buffer,
+                      size_t message_size,
+                      size_t max_messages,
+                      std::chrono::system_clock::time_point* receive_times) override;
+  void send(const uint8_t* data, size_t size) override;
+  bool wait(std::chrono::microseconds timeout) override;
+  int descriptor() const noexcept override;
+
+  /// Maximum number of datagrams received with a single system call.
+  static constexpr size_t kBatchSize = 8;
+
+ private:
+  Poco::Net::DatagramSocket socket_;
+  Poco::Net::SocketAddress server_address_;
+  uint16_t port_;
+};
+
+}  // namespace franka
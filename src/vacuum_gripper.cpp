@@ -7,17 +7,16 @@
 #include <franka/exception.h>
 #include <research_interface/vacuum_gripper/types.h>
 
+#include "async_command_executor.h"
 #include "network.h"
+#include "state_subscription.h"
 
 namespace franka {
 
 namespace {
 
-template <typename T, typename... TArgs>
-bool executeCommand(Network& network, TArgs&&... args) {
-  uint32_t command_id = network.tcpSendRequest<T>(std::forward<TArgs>(args)...);
-  typename T::Response response = network.tcpBlockingReceiveResponse<T>(command_id);
-
+template <typename T>
+bool handleCommandResponse(const typename T::Response& response) {
   switch (response.status) {
     case T::Status::kSuccess:
       return true;
@@ -33,6 +32,37 @@ bool executeCommand(Network& network, TArgs&&... args) {
   }
 }
 
+template <typename T, typename... TArgs>
+bool executeCommand(Network& network, TArgs&&... args) {
+  uint32_t command_id = network.tcpSendRequest<T>(std::forward<TArgs>(args)...);
+  return handleCommandResponse<T>(network.tcpBlockingReceiveResponse<T>(command_id));
+}
+
+// Waits for the response to a command that takes a timeout as its last argument, in addition to
+// the TCP timeout of the network.
+template <typename T, typename... TArgs>
+bool executeTimedCommand(Network& network, std::chrono::milliseconds timeout, TArgs&&... args) {
+  uint32_t command_id = network.tcpSendRequest<T>(std::forward<TArgs>(args)..., timeout);
+  return handleCommandResponse<T>(
+      network.tcpBlockingReceiveResponse<T>(command_id, nullptr, timeout));
+}
+
+research_interface::vacuum_gripper::Profile convertProfile(
+    VacuumGripper::ProductionSetupProfile profile) {
+  switch (profile) {
+    case VacuumGripper::ProductionSetupProfile::kP0:
+      return research_interface::vacuum_gripper::Profile::kP0;
+    case VacuumGripper::ProductionSetupProfile::kP1:
+      return research_interface::vacuum_gripper::Profile::kP1;
+    case VacuumGripper::ProductionSetupProfile::kP2:
+      return research_interface::vacuum_gripper::Profile::kP2;
+    case VacuumGripper::ProductionSetupProfile::kP3:
+      return research_interface::vacuum_gripper::Profile::kP3;
+    default:
+      throw CommandException("Vacuum Gripper: Vacuum profile not defined!");
+  }
+}
+
 VacuumGripperState convertVacuumGripperState(
     const research_interface::vacuum_gripper::VacuumGripperState& vacuum_gripper_state) noexcept {
   VacuumGripperState converted{};
@@ -61,16 +91,32 @@ VacuumGripperState convertVacuumGripperState(
 
 }  // anonymous namespace
 
+class VacuumGripper::Subscription
+    : public StateSubscription<research_interface::vacuum_gripper::VacuumGripperState,
+                               VacuumGripperState> {
+ public:
+  using StateSubscription::StateSubscription;
+};
+
 VacuumGripper::VacuumGripper(const std::string& franka_address)
     : network_{std::make_unique<Network>(franka_address,
                                          research_interface::vacuum_gripper::kCommandPort)} {
   connect<research_interface::vacuum_gripper::Connect,
           research_interface::vacuum_gripper::kVersion>(*network_, &ri_version_);
+  async_commands_ = std::make_unique<AsyncCommandExecutor>(*network_);
 }
 
 VacuumGripper::~VacuumGripper() noexcept = default;
 VacuumGripper::VacuumGripper(VacuumGripper&&) noexcept = default;
-VacuumGripper& VacuumGripper::operator=(VacuumGripper&&) noexcept = default;
+
+VacuumGripper& VacuumGripper::operator=(VacuumGripper&& vacuum_gripper) noexcept {
+  // Stop the background threads before the connection they use is closed.
+  subscription_ = std::move(vacuum_gripper.subscription_);
+  async_commands_ = std::move(vacuum_gripper.async_commands_);
+  network_ = std::move(vacuum_gripper.network_);
+  ri_version_ = vacuum_gripper.ri_version_;
+  return *this;
+}
 
 VacuumGripper::ServerVersion VacuumGripper::serverVersion() const noexcept {
   return ri_version_;
@@ -79,37 +125,41 @@ VacuumGripper::ServerVersion VacuumGripper::serverVersion() const noexcept {
 bool VacuumGripper::vacuum(uint8_t vacuum,
                            std::chrono::milliseconds timeout,
                            ProductionSetupProfile profile) const {
-  research_interface::vacuum_gripper::Profile converted_profile;
-  switch (profile) {
-    case ProductionSetupProfile::kP0:
-      converted_profile = research_interface::vacuum_gripper::Profile::kP0;
-      break;
-    case ProductionSetupProfile::kP1:
-      converted_profile = research_interface::vacuum_gripper::Profile::kP1;
-      break;
-    case ProductionSetupProfile::kP2:
-      converted_profile = research_interface::vacuum_gripper::Profile::kP2;
-      break;
-    case ProductionSetupProfile::kP3:
-      converted_profile = research_interface::vacuum_gripper::Profile::kP3;
-      break;
-    default:
-      throw CommandException("Vacuum Gripper: Vacuum profile not defined!");
-      break;
-  }
-  return executeCommand<research_interface::vacuum_gripper::Vacuum>(*network_, vacuum,
-                                                                    converted_profile, timeout);
+  return executeTimedCommand<research_interface::vacuum_gripper::Vacuum>(
+      *network_, timeout, vacuum, convertProfile(profile));
 }
 
 bool VacuumGripper::dropOff(std::chrono::milliseconds timeout) const {
-  return executeCommand<research_interface::vacuum_gripper::DropOff>(*network_, timeout);
+  return executeTimedCommand<research_interface::vacuum_gripper::DropOff>(*network_, timeout);
 }
 
 bool VacuumGripper::stop() const {
   return executeCommand<research_interface::vacuum_gripper::Stop>(*network_);
 }
 
+std::future<bool> VacuumGripper::vacuumAsync(uint8_t vacuum,
+                                             std::chrono::milliseconds timeout,
+                                             ProductionSetupProfile profile) const {
+  return async_commands_->execute<research_interface::vacuum_gripper::Vacuum>(
+      &handleCommandResponse<research_interface::vacuum_gripper::Vacuum>, vacuum,
+      convertProfile(profile), timeout);
+}
+
+std::future<bool> VacuumGripper::dropOffAsync(std::chrono::milliseconds timeout) const {
+  return async_commands_->execute<research_interface::vacuum_gripper::DropOff>(
+      &handleCommandResponse<research_interface::vacuum_gripper::DropOff>, timeout);
+}
+
+std::future<bool> VacuumGripper::stopAsync() const {
+  return async_commands_->execute<research_interface::vacuum_gripper::Stop>(
+      &handleCommandResponse<research_interface::vacuum_gripper::Stop>);
+}
+
 VacuumGripperState VacuumGripper::readOnce() const {
+  if (subscription_) {
+    return subscription_->next();
+  }
+
   research_interface::vacuum_gripper::VacuumGripperState vacuum_gripper_state{};
   // Delete old data from the UDP buffer.
   while (network_->udpReceive<decltype(vacuum_gripper_state)>(&vacuum_gripper_state)) {
@@ -119,4 +169,27 @@ VacuumGripperState VacuumGripper::readOnce() const {
   return convertVacuumGripperState(vacuum_gripper_state);
 }
 
+void VacuumGripper::subscribe(StateCallback callback) {
+  if (subscription_) {
+    throw InvalidOperationException(
+        "libfranka vacuum gripper: Already subscribed to the vacuum gripper state.");
+  }
+  auto subscription =
+      std::make_unique<Subscription>(*network_, &convertVacuumGripperState, std::move(callback));
+  subscription->next();
+  subscription_ = std::move(subscription);
+}
+
+void VacuumGripper::unsubscribe() noexcept {
+  subscription_.reset();
+}
+
+VacuumGripperState VacuumGripper::latestState() const {
+  if (!subscription_) {
+    throw InvalidOperationException(
+        "libfranka vacuum gripper: Not subscribed to the vacuum gripper state.");
+  }
+  return subscription_->latest();
+}
+
 }  // namespace franka
@@ -0,0 +1,307 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/virtual_fixtures.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+
+namespace franka {
+namespace fixtures {
+
+namespace {
+
+using Vector3d = Eigen::Vector3d;
+
+template <size_t N>
+bool isFinite(const std::array<double, N>& values) {
+  return std::all_of(values.begin(), values.end(), [](double d) { return std::isfinite(d); });
+}
+
+bool isGain(double gain) {
+  return gain >= 0 && std::isfinite(gain);
+}
+
+void checkGains(double stiffness, double damping) {
+  if (!isGain(stiffness) || !isGain(damping)) {
+    throw std::invalid_argument(
+        "libfranka: Virtual fixture stiffness and damping must be non-negative.");
+  }
+}
+
+void checkPoint(const std::array<double, 3>& point) {
+  if (!isFinite(point)) {
+    throw std::invalid_argument("libfranka: Virtual fixture point is infinite or NaN.");
+  }
+}
+
+std::array<double, 3> normalize(const std::array<double, 3>& vector, const char* name) {
+  double length = Eigen::Map<const Vector3d>(vector.data()).norm();
+  if (!(length > 0) || !std::isfinite(length)) {
+    throw std::invalid_argument(std::string("libfranka: Virtual fixture ") + name +
+                                " is zero, infinite or NaN.");
+  }
+  return {{vector[0] / length, vector[1] / length, vector[2] / length}};
+}
+
+// Adds a force along the given unit direction that pushes back a violation of the given depth,
+// damping only the velocity along the direction. The force never pulls towards the violation.
+void addRestoringForce(const Vector3d& outward,
+                       double violation,
+                       double stiffness,
+                       double damping,
+                       const FixtureState& state,
+                       std::array<double, 6>* wrench) noexcept {
+  double velocity = Eigen::Map<const Vector3d>(state.linear_velocity.data()).dot(outward);
+  double force = std::max(stiffness * violation + damping * velocity, 0.0);
+  Eigen::Map<Vector3d>(wrench->data()) -= force * outward;
+}
+
+}  // anonymous namespace
+
+FixtureState fixtureState(
+    const std::array<double, 16>& O_T_EE,             // NOLINT(readability-identifier-naming)
+    const std::array<double, 6>& O_dP_EE) noexcept {  // NOLINT(readability-identifier-naming)
+  FixtureState state;
+  for (size_t column = 0; column < 3; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      state.rotation[3 * column + row] = O_T_EE[4 * column + row];
+    }
+    state.position[column] = O_T_EE[12 + column];
+    state.linear_velocity[column] = O_dP_EE[column];
+    state.angular_velocity[column] = O_dP_EE[3 + column];
+  }
+  return state;
+}
+
+FixtureState fixtureState(const RobotState& robot_state,
+                          const std::array<double, 42>& zero_jacobian) noexcept {
+  std::array<double, 6> twist{};
+  Eigen::Map<Eigen::Matrix<double, 6, 1>>(twist.data()) =
+      Eigen::Map<const Eigen::Matrix<double, 6, 7>>(zero_jacobian.data()) *
+      Eigen::Map<const Eigen::Matrix<double, 7, 1>>(robot_state.dq.data());
+  return fixtureState(robot_state.O_T_EE, twist);
+}
+
+Plane::Plane(const std::array<double, 3>& point,
+             const std::array<double, 3>& normal,
+             double stiffness,
+             double damping,
+             Mode mode)
+    : point_(point),
+      normal_(normalize(normal, "plane normal")),
+      stiffness_(stiffness),
+      damping_(damping),
+      mode_(mode) {
+  checkPoint(point);
+  checkGains(stiffness, damping);
+}
+
+void Plane::operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept {
+  Eigen::Map<const Vector3d> normal(normal_.data());
+  double distance = normal.dot(Eigen::Map<const Vector3d>(state.position.data()) -
+                               Eigen::Map<const Vector3d>(point_.data()));
+  if (mode_ == Mode::kGuidance) {
+    double velocity = Eigen::Map<const Vector3d>(state.linear_velocity.data()).dot(normal);
+    Eigen::Map<Vector3d>(wrench->data()) -= (stiffness_ * distance + damping_ * velocity) * normal;
+  } else if (distance < 0) {
+    addRestoringForce(-normal, -distance, stiffness_, damping_, state, wrench);
+  }
+}
+
+Cone::Cone(const std::array<double, 3>& apex,
+           const std::array<double, 3>& axis,
+           double half_angle,
+           double stiffness,
+           double damping)
+    : apex_(apex),
+      axis_(normalize(axis, "cone axis")),
+      sin_half_angle_(std::sin(half_angle)),
+      cos_half_angle_(std::cos(half_angle)),
+      stiffness_(stiffness),
+      damping_(damping) {
+  checkPoint(apex);
+  checkGains(stiffness, damping);
+  if (!(half_angle > 0) || !(half_angle < M_PI / 2)) {
+    throw std::invalid_argument("libfranka: Virtual fixture cone half angle must be in (0, pi/2).");
+  }
+}
+
+void Cone::operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept {
+  Eigen::Map<const Vector3d> axis(axis_.data());
+  Vector3d offset =
+      Eigen::Map<const Vector3d>(state.position.data()) - Eigen::Map<const Vector3d>(apex_.data());
+  double height = offset.dot(axis);
+  Vector3d radial = offset - height * axis;
+  double radius = radial.norm();
+
+  // Distance from the cone surface and position along it, in the plane spanned by the axis and
+  // the end effector.
+  double outside = radius * cos_half_angle_ - height * sin_half_angle_;
+  double along = radius * sin_half_angle_ + height * cos_half_angle_;
+  if (along < 0) {
+    // Behind the apex, which is the closest point of the cone.
+    double distance = offset.norm();
+    if (distance > 0) {
+      addRestoringForce(offset / distance, distance, stiffness_, damping_, state, wrench);
+    }
+  } else if (outside > 0) {
+    Vector3d outward = cos_half_angle_ * radial / radius - sin_half_angle_ * axis;
+    addRestoringForce(outward, outside, stiffness_, damping_, state, wrench);
+  }
+}
+
+Tube::Tube(const std::vector<std::array<double, 3>>& control_points,
+           double radius,
+           double stiffness,
+           double damping,
+           size_t samples_per_segment)
+    : radius_(radius), stiffness_(stiffness), damping_(damping) {
+  if (control_points.size() < 2 || samples_per_segment == 0) {
+    throw std::invalid_argument(
+        "libfranka: Virtual fixture tube needs two control points and one sample per segment.");
+  }
+  for (const auto& point : control_points) {
+    checkPoint(point);
+  }
+  checkGains(stiffness, damping);
+  if (!isGain(radius)) {
+    throw std::invalid_argument("libfranka: Virtual fixture tube radius must be non-negative.");
+  }
+
+  // Uniform Catmull-Rom spline, with the end points repeated as outer control points.
+  samples_.reserve((control_points.size() - 1) * samples_per_segment + 1);
+  for (size_t segment = 0; segment + 1 < control_points.size(); segment++) {
+    Eigen::Map<const Vector3d> p0(control_points[segment > 0 ? segment - 1 : segment].data());
+    Eigen::Map<const Vector3d> p1(control_points[segment].data());
+    Eigen::Map<const Vector3d> p2(control_points[segment + 1].data());
+    Eigen::Map<const Vector3d> p3(
+        control_points[std::min(segment + 2, control_points.size() - 1)].data());
+    for (size_t sample = 0; sample < samples_per_segment; sample++) {
+      double t = static_cast<double>(sample) / samples_per_segment;
+      Vector3d point = 0.5 * (2 * p1 + (p2 - p0) * t + (2 * p0 - 5 * p1 + 4 * p2 - p3) * t * t +
+                              (3 * p1 - p0 - 3 * p2 + p3) * t * t * t);
+      samples_.push_back({{point.x(), point.y(), point.z()}});
+    }
+  }
+  samples_.push_back(control_points.back());
+}
+
+void Tube::operator()(const FixtureState& state, std::array<double, 6>* wrench) const noexcept {
+  Eigen::Map<const Vector3d> position(state.position.data());
+  Vector3d closest = Eigen::Map<const Vector3d>(samples_.front().data());
+  double closest_distance = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i + 1 < samples_.size(); i++) {
+    Eigen::Map<const Vector3d> start(samples_[i].data());
+    Vector3d segment = Eigen::Map<const Vector3d>(samples_[i + 1].data()) - start;
+    double length_squared = segment.squaredNorm();
+    double t = length_squared > 0
+                   ? std::min(std::max((position - start).dot(segment) / length_squared, 0.0), 1.0)
+                   : 0.0;
+    Vector3d point = start + t * segment;
+    double distance = (position - point).squaredNorm();
+    if (distance < closest_distance) {
+      closest_distance = distance;
+      closest = point;
+    }
+  }
+
+  Vector3d offset = position - closest;
+  double distance = offset.norm();
+  if (distance > radius_) {
+    addRestoringForce(offset / distance, distance - radius_, stiffness_, damping_, state, wrench);
+  }
+}
+
+const std::vector<std::array<double, 3>>& Tube::centerLine() const noexcept {
+  return samples_;
+}
+
+OrientationLock::OrientationLock(const std::array<double, 9>& rotation,
+                                 double stiffness,
+                                 double damping,
+                                 const std::array<double, 3>& free_axis)
+    : rotation_(rotation), stiffness_(stiffness), damping_(damping), free_axis_{} {
+  std::array<double, 16> transform{};
+  for (size_t column = 0; column < 3; column++) {
+    std::copy(&rotation[3 * column], &rotation[3 * column] + 3, &transform[4 * column]);
+  }
+  transform[15] = 1;
+  if (!isFinite(rotation) || !isHomogeneousTransformation(transform)) {
+    throw std::invalid_argument("libfranka: Virtual fixture orientation is not a rotation matrix.");
+  }
+  checkGains(stiffness, damping);
+  if (!isFinite(free_axis)) {
+    throw std::invalid_argument("libfranka: Virtual fixture free axis is infinite or NaN.");
+  }
+  if (Eigen::Map<const Vector3d>(free_axis.data()).norm() > 0) {
+    free_axis_ = normalize(free_axis, "free axis");
+  }
+}
+
+void OrientationLock::operator()(const FixtureState& state,
+                                 std::array<double, 6>* wrench) const noexcept {
+  Eigen::Quaterniond error(Eigen::Map<const Eigen::Matrix3d>(state.rotation.data()) *
+                           Eigen::Map<const Eigen::Matrix3d>(rotation_.data()).transpose());
+  if (error.w() < 0) {
+    error.coeffs() = -error.coeffs();
+  }
+  Eigen::Map<const Vector3d> free_axis(free_axis_.data());
+  Vector3d angular_velocity = Eigen::Map<const Vector3d>(state.angular_velocity.data());
+
+  // Remove the twist about the free axis from the error, leaving only the swing.
+  Vector3d twist_vector = error.vec().dot(free_axis) * free_axis;
+  Eigen::Quaterniond twist(error.w(), twist_vector.x(), twist_vector.y(), twist_vector.z());
+  double twist_norm = twist.norm();
+  if (free_axis.squaredNorm() > 0 && twist_norm > 0) {
+    twist.coeffs() /= twist_norm;
+    error = error * twist.conjugate();
+    angular_velocity -= angular_velocity.dot(free_axis) * free_axis;
+  }
+
+  Eigen::AngleAxisd angle_axis(error);
+  Eigen::Map<Vector3d>(wrench->data() + 3) -=
+      stiffness_ * angle_axis.angle() * angle_axis.axis() + damping_ * angular_velocity;
+}
+
+AnisotropicSpring::AnisotropicSpring(
+    const std::array<double, 16>& O_T_target,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& stiffness,
+    const std::array<double, 3>& damping)
+    : stiffness_(stiffness), damping_(damping) {
+  if (!isFinite(O_T_target) || !isHomogeneousTransformation(O_T_target)) {
+    throw std::invalid_argument(
+        "libfranka: Virtual fixture target is not a homogeneous transformation.");
+  }
+  for (size_t i = 0; i < 3; i++) {
+    checkGains(stiffness[i], damping[i]);
+  }
+  for (size_t column = 0; column < 3; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      rotation_[3 * column + row] = O_T_target[4 * column + row];
+    }
+    position_[column] = O_T_target[12 + column];
+  }
+}
+
+void AnisotropicSpring::operator()(const FixtureState& state,
+                                   std::array<double, 6>* wrench) const noexcept {
+  Eigen::Map<const Eigen::Matrix3d> rotation(rotation_.data());
+  Vector3d offset = rotation.transpose() * (Eigen::Map<const Vector3d>(state.position.data()) -
+                                            Eigen::Map<const Vector3d>(position_.data()));
+  Vector3d velocity =
+      rotation.transpose() * Eigen::Map<const Vector3d>(state.linear_velocity.data());
+  Eigen::Map<Vector3d>(wrench->data()) -=
+      rotation * (Eigen::Map<const Vector3d>(stiffness_.data()).cwiseProduct(offset) +
+                  Eigen::Map<const Vector3d>(damping_.data()).cwiseProduct(velocity));
+}
+
+}  // namespace fixtures
+}  // namespace franka
@@ -0,0 +1,123 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/virtual_walls.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+#include <franka/robot.h>
+
+#include "triple_buffer.h"
+
+namespace franka {
+
+VirtualWallDistance virtualWallDistance(const VirtualWallCuboid& wall,
+                                        const std::array<double, 3>& point) noexcept {
+  using Eigen::Vector3d;
+  Eigen::Map<const Eigen::Matrix4d> frame(wall.p_frame.data());
+  Vector3d local = frame.topLeftCorner<3, 3>().transpose() *
+                   (Eigen::Map<const Vector3d>(point.data()) - frame.topRightCorner<3, 1>());
+  Vector3d half_size = 0.5 * Eigen::Map<const Vector3d>(wall.object_world_size.data()).cwiseAbs();
+  Vector3d sign = local.unaryExpr([](double value) { return value < 0 ? -1.0 : 1.0; });
+
+  VirtualWallDistance result{};
+  result.id = wall.id;
+  Vector3d outside = (local.cwiseAbs() - half_size).cwiseMax(0.0);
+  Vector3d normal = Vector3d::Zero();
+  if (outside.squaredNorm() > 0) {
+    result.distance = -outside.norm();
+    normal = -sign.cwiseProduct(outside) / outside.norm();
+  } else {
+    Vector3d slack = half_size - local.cwiseAbs();
+    Eigen::Index axis = 0;
+    result.distance = slack.minCoeff(&axis);
+    normal[axis] = -sign[axis];
+  }
+  Eigen::Map<Vector3d>(result.normal.data()) = frame.topLeftCorner<3, 3>() * normal;
+  return result;
+}
+
+constexpr size_t VirtualWalls::kMaxWalls;
+
+class VirtualWalls::Impl {
+ public:
+  struct Table {
+    std::array<VirtualWallCuboid, kMaxWalls> walls{};
+    size_t count{0};
+  };
+
+  void publish(const std::vector<VirtualWallCuboid>& walls) noexcept {
+    Table& table = buffer_.back();
+    table.count = walls.size();
+    std::copy(walls.begin(), walls.end(), table.walls.begin());
+    buffer_.publish();
+  }
+
+  const Table& latest() noexcept {
+    buffer_.acquire();
+    return buffer_.front();
+  }
+
+ private:
+  TripleBuffer<Table> buffer_;
+};
+
+VirtualWalls::VirtualWalls() : impl_(std::make_unique<Impl>()) {}
+
+VirtualWalls::VirtualWalls(Robot& robot, const std::vector<int32_t>& ids) : VirtualWalls() {
+  refresh(robot, ids);
+}
+
+VirtualWalls::~VirtualWalls() noexcept = default;
+
+void VirtualWalls::refresh(Robot& robot, const std::vector<int32_t>& ids) {
+  if (ids.size() > kMaxWalls) {
+    throw std::invalid_argument("libfranka: Too many virtual walls requested.");
+  }
+  std::vector<VirtualWallCuboid> walls;
+  walls.reserve(ids.size());
+  for (int32_t id : ids) {
+    walls.push_back(robot.getVirtualWall(id));
+  }
+  impl_->publish(walls);
+}
+
+void VirtualWalls::set(const std::vector<VirtualWallCuboid>& walls) {
+  if (walls.size() > kMaxWalls) {
+    throw std::invalid_argument("libfranka: Too many virtual walls given.");
+  }
+  impl_->publish(walls);
+}
+
+VirtualWallDistance VirtualWalls::distance(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 3>& offset) noexcept {
+  Eigen::Map<const Eigen::Matrix4d> pose(O_T_EE.data());
+  std::array<double, 3> point;
+  Eigen::Map<Eigen::Vector3d>(point.data()) =
+      pose.topLeftCorner<3, 3>() * Eigen::Map<const Eigen::Vector3d>(offset.data()) +
+      pose.topRightCorner<3, 1>();
+
+  VirtualWallDistance nearest{std::numeric_limits<double>::infinity(), {}, -1};
+  const Impl::Table& table = impl_->latest();
+  for (size_t i = 0; i < table.count; i++) {
+    if (!table.walls[i].active) {
+      continue;
+    }
+    VirtualWallDistance candidate = virtualWallDistance(table.walls[i], point);
+    if (candidate.distance < nearest.distance) {
+      nearest = candidate;
+    }
+  }
+  return nearest;
+}
+
+std::vector<VirtualWallCuboid> VirtualWalls::walls() {
+  const Impl::Table& table = impl_->latest();
+  return std::vector<VirtualWallCuboid>(table.walls.begin(), table.walls.begin() + table.count);
+}
+
+}  // namespace franka
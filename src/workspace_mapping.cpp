@@ -0,0 +1,182 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <franka/workspace_mapping.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/control_tools.h>
+
+namespace franka {
+
+namespace {
+
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+bool isPositiveAndFinite(double value) {
+  return value > 0 && std::isfinite(value);
+}
+
+bool isNonNegativeAndFinite(double value) {
+  return value >= 0 && std::isfinite(value);
+}
+
+// Rotation of the given rotation about its axis by a fraction of its angle.
+Eigen::Matrix3d scaleRotation(const Eigen::Matrix3d& rotation, double scale) {
+  Eigen::AngleAxisd angle_axis(rotation);
+  return Eigen::AngleAxisd(scale * angle_axis.angle(), angle_axis.axis()).toRotationMatrix();
+}
+
+}  // anonymous namespace
+
+WorkspaceMapping::WorkspaceMapping(const WorkspaceMappingParameters& parameters)
+    : parameters_(parameters) {
+  if (!isHomogeneousTransformation(parameters.O_T_D) ||
+      !isPositiveAndFinite(parameters.position_scale) ||
+      !isNonNegativeAndFinite(parameters.rotation_scale) ||
+      !isPositiveAndFinite(parameters.rate_zone_radius) ||
+      !isNonNegativeAndFinite(parameters.rate_gain) ||
+      !isPositiveAndFinite(parameters.max_velocity) ||
+      !isPositiveAndFinite(parameters.max_angular_velocity) ||
+      !isNonNegativeAndFinite(parameters.force_scale) ||
+      !isNonNegativeAndFinite(parameters.torque_scale) ||
+      !isNonNegativeAndFinite(parameters.max_device_force) ||
+      !std::isfinite(parameters.device_center[0] + parameters.device_center[1] +
+                     parameters.device_center[2])) {
+    throw std::invalid_argument("libfranka: Invalid workspace mapping parameters.");
+  }
+  for (size_t i = 0; i < 2; i++) {
+    if (!isNonNegativeAndFinite(parameters.coupling_stiffness[i]) ||
+        !isNonNegativeAndFinite(parameters.coupling_damping[i])) {
+      throw std::invalid_argument("libfranka: Invalid workspace mapping parameters.");
+    }
+  }
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+void WorkspaceMapping::reset(const std::array<double, 16>& O_T_EE) noexcept {
+  target_ = O_T_EE;
+  engaged_ = false;
+}
+
+CartesianPose WorkspaceMapping::update(const std::array<double, 16>& device_pose,
+                                       bool clutch,
+                                       double time_step) noexcept {
+  if (!clutch) {
+    engaged_ = false;
+    return target_;
+  }
+  if (!engaged_) {
+    // Anchor at the current poses, so that engaging the clutch does not move the target.
+    device_anchor_ = device_pose;
+    robot_anchor_ = target_;
+    engaged_ = true;
+    return target_;
+  }
+
+  Eigen::Map<const Eigen::Matrix4d> device_to_robot(parameters_.O_T_D.data());
+  Eigen::Map<const Eigen::Matrix4d> device(device_pose.data());
+  Eigen::Map<const Eigen::Matrix4d> device_anchor(device_anchor_.data());
+  Eigen::Map<Eigen::Matrix4d> robot_anchor(robot_anchor_.data());
+  Eigen::Map<Eigen::Matrix4d> target(target_.data());
+  Eigen::Matrix3d rotation = device_to_robot.topLeftCorner<3, 3>();
+
+  // Rate control: move the anchor while the device is outside of the rate zone.
+  Eigen::Map<const Eigen::Vector3d> device_center(parameters_.device_center.data());
+  Eigen::Vector3d offset = device.topRightCorner<3, 1>() - device_center;
+  double distance = offset.norm();
+  if (parameters_.rate_gain > 0 && distance > parameters_.rate_zone_radius && time_step > 0) {
+    robot_anchor.topRightCorner<3, 1>() += rotation * offset *
+                                           (parameters_.rate_gain *
+                                            (distance - parameters_.rate_zone_radius) * time_step /
+                                            distance);
+  }
+
+  Eigen::Vector3d position =
+      robot_anchor.topRightCorner<3, 1>() +
+      parameters_.position_scale * rotation *
+          (device.topRightCorner<3, 1>() - device_anchor.topRightCorner<3, 1>());
+  Eigen::Matrix3d device_rotation =
+      device.topLeftCorner<3, 3>() * device_anchor.topLeftCorner<3, 3>().transpose();
+  Eigen::Matrix3d orientation =
+      scaleRotation(rotation * device_rotation * rotation.transpose(),
+                    parameters_.rotation_scale) *
+      robot_anchor.topLeftCorner<3, 3>();
+
+  // Limit the velocity of the target, e.g. when the device pose jumps.
+  if (time_step > 0) {
+    Eigen::Vector3d translation = position - target.topRightCorner<3, 1>();
+    double max_translation = parameters_.max_velocity * time_step;
+    if (translation.norm() > max_translation) {
+      position = target.topRightCorner<3, 1>() + translation.normalized() * max_translation;
+    }
+    Eigen::Quaterniond current(Eigen::Matrix3d(target.topLeftCorner<3, 3>()));
+    Eigen::Quaterniond desired(orientation);
+    double angle = current.angularDistance(desired);
+    double max_angle = parameters_.max_angular_velocity * time_step;
+    if (angle > max_angle) {
+      orientation = current.slerp(max_angle / angle, desired).normalized().toRotationMatrix();
+    }
+  }
+
+  target.topLeftCorner<3, 3>() = orientation;
+  target.topRightCorner<3, 1>() = position;
+  return target_;
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+std::array<double, 6> WorkspaceMapping::deviceWrench(const std::array<double, 6>& O_F) const
+    noexcept {
+  std::array<double, 6> device_wrench{};
+  if (!engaged_) {
+    return device_wrench;
+  }
+
+  Eigen::Map<const Eigen::Matrix4d> device_to_robot(parameters_.O_T_D.data());
+  Eigen::Matrix3d rotation = device_to_robot.topLeftCorner<3, 3>().transpose();
+  Eigen::Map<const Vector6d> wrench(O_F.data());
+  Eigen::Map<Vector6d> result(device_wrench.data());
+  result.head<3>() = parameters_.force_scale * rotation * wrench.head<3>();
+  result.tail<3>() = parameters_.torque_scale * rotation * wrench.tail<3>();
+  double force = result.head<3>().norm();
+  if (force > parameters_.max_device_force) {
+    result.head<3>() *= parameters_.max_device_force / force;
+  }
+  return device_wrench;
+}
+
+std::array<double, 6> WorkspaceMapping::couplingWrench(
+    const std::array<double, 16>& O_T_EE,  // NOLINT(readability-identifier-naming)
+    const std::array<double, 6>& O_dP_EE)  // NOLINT(readability-identifier-naming)
+    const noexcept {
+  Eigen::Map<const Eigen::Matrix4d> pose(O_T_EE.data());
+  Eigen::Map<const Eigen::Matrix4d> target(target_.data());
+  Eigen::Map<const Vector6d> twist(O_dP_EE.data());
+
+  Eigen::AngleAxisd rotation_error(
+      Eigen::Matrix3d(target.topLeftCorner<3, 3>() * pose.topLeftCorner<3, 3>().transpose()));
+
+  std::array<double, 6> wrench{};
+  Eigen::Map<Vector6d> result(wrench.data());
+  result.head<3>() =
+      parameters_.coupling_stiffness[0] *
+          (target.topRightCorner<3, 1>() - pose.topRightCorner<3, 1>()) -
+      parameters_.coupling_damping[0] * twist.head<3>();
+  result.tail<3>() =
+      parameters_.coupling_stiffness[1] * rotation_error.angle() * rotation_error.axis() -
+      parameters_.coupling_damping[1] * twist.tail<3>();
+  return wrench;
+}
+
+const std::array<double, 16>& WorkspaceMapping::target() const noexcept {
+  return target_;
+}
+
+bool WorkspaceMapping::engaged() const noexcept {
+  return engaged_;
+}
+
+}  // namespace franka
@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <franka/allocation_tracking.h>
+
+#include "allocation_tracker.h"
+
+namespace {
+
+// Keeps the compiler from eliding the allocations under test.
+void* volatile allocation_sink;
+
+void allocate() {
+  auto value = std::make_unique<int>(1);
+  allocation_sink = value.get();
+}
+
+}  // anonymous namespace
+
+TEST(AllocationTracker, CountsAllocationsPerCycle) {
+  if (!franka::allocationTrackingEnabled()) {
+    return;
+  }
+  franka::resetAllocationStatistics();
+
+  {
+    franka::AllocationTrackingScope allocation_tracking;
+    allocation_tracking.endCycle();
+    allocate();
+    allocate();
+    allocation_tracking.endCycle();
+  }
+
+  franka::AllocationStatistics statistics = franka::allocationStatistics();
+  EXPECT_EQ(2u, statistics.cycles);
+  EXPECT_EQ(1u, statistics.cycles_with_allocations);
+  EXPECT_EQ(2u, statistics.allocations);
+  EXPECT_EQ(2u, statistics.max_allocations_per_cycle);
+  EXPECT_FALSE(statistics.first_allocation_stack.empty());
+}
+
+TEST(AllocationTracker, IgnoresAllocationsOutsideOfScope) {
+  franka::resetAllocationStatistics();
+
+  allocate();
+
+  franka::AllocationStatistics statistics = franka::allocationStatistics();
+  EXPECT_EQ(0u, statistics.allocations);
+  EXPECT_TRUE(statistics.first_allocation_stack.empty());
+}
+
+TEST(AllocationTracker, ResetClearsStatistics) {
+  {
+    franka::AllocationTrackingScope allocation_tracking;
+    allocate();
+    allocation_tracking.endCycle();
+  }
+  franka::resetAllocationStatistics();
+
+  franka::AllocationStatistics statistics = franka::allocationStatistics();
+  EXPECT_EQ(0u, statistics.cycles);
+  EXPECT_EQ(0u, statistics.allocations);
+  EXPECT_TRUE(statistics.first_allocation_stack.empty());
+}
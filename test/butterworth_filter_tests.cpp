@@ -0,0 +1,82 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include <franka/butterworth_filter.h>
+
+using franka::ButterworthFilter;
+
+namespace {
+
+constexpr double kSampleTime = 0.001;
+
+// Returns the steady-state amplitude of the filter response to a unit sine wave.
+template <size_t Order>
+double amplitudeAt(double cutoff_frequency, double frequency) {
+  ButterworthFilter<1, Order> filter(kSampleTime, cutoff_frequency);
+  filter.reset({{0.0}});
+  double amplitude = 0;
+  for (size_t i = 0; i < 20000; i++) {
+    double output = filter.filter({{std::sin(2 * M_PI * frequency * i * kSampleTime)}})[0];
+    if (i >= 10000) {
+      amplitude = std::max(amplitude, std::abs(output));
+    }
+  }
+  return amplitude;
+}
+
+}  // anonymous namespace
+
+TEST(ButterworthFilter, StartsInSteadyState) {
+  ButterworthFilter<3, 4> filter(kSampleTime, 50.0);
+  std::array<double, 3> input{{1.0, -2.0, 0.5}};
+  for (size_t i = 0; i < 10; i++) {
+    std::array<double, 3> output = filter.filter(input);
+    for (size_t j = 0; j < input.size(); j++) {
+      EXPECT_NEAR(input[j], output[j], 1e-12);
+    }
+  }
+}
+
+TEST(ButterworthFilter, HasButterworthMagnitudeResponse) {
+  EXPECT_NEAR(amplitudeAt<2>(50.0, 1.0), 1.0, 1e-3);
+  EXPECT_NEAR(amplitudeAt<2>(50.0, 50.0), M_SQRT1_2, 1e-2);
+  EXPECT_NEAR(amplitudeAt<4>(50.0, 50.0), M_SQRT1_2, 1e-2);
+
+  // -40 dB/decade for a second-order and -80 dB/decade for a fourth-order filter. The bilinear
+  // transform attenuates high frequencies even more.
+  EXPECT_LT(amplitudeAt<2>(20.0, 200.0), 1.1e-2);
+  EXPECT_LT(amplitudeAt<4>(20.0, 200.0), 1.1e-4);
+}
+
+TEST(ButterworthFilter, FiltersChannelsIndependently) {
+  ButterworthFilter<2> filter(kSampleTime, 100.0);
+  ButterworthFilter<1> reference(kSampleTime, 100.0);
+  filter.reset({{0.0, 0.0}});
+  reference.reset({{0.0}});
+  for (size_t i = 0; i < 100; i++) {
+    std::array<double, 2> output = filter.filter({{1.0, 0.0}});
+    EXPECT_EQ(reference.filter({{1.0}})[0], output[0]);
+    EXPECT_EQ(0.0, output[1]);
+  }
+}
+
+TEST(ButterworthFilter, ThrowsOnInvalidArguments) {
+  constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW((ButterworthFilter<7>(0.0, 100.0)), std::invalid_argument);
+  EXPECT_THROW((ButterworthFilter<7>(kNaN, 100.0)), std::invalid_argument);
+  EXPECT_THROW((ButterworthFilter<7>(kSampleTime, 0.0)), std::invalid_argument);
+  EXPECT_THROW((ButterworthFilter<7>(kSampleTime, 500.0)), std::invalid_argument);
+  EXPECT_THROW(franka::butterworthSection(3, 0, kSampleTime, 100.0), std::invalid_argument);
+  EXPECT_THROW(franka::butterworthSection(4, 2, kSampleTime, 100.0), std::invalid_argument);
+
+  ButterworthFilter<2> filter(kSampleTime, 100.0);
+  filter.reset({{1.0, 1.0}});
+  EXPECT_THROW(filter.filter({{kNaN, 0.0}}), std::invalid_argument);
+  std::array<double, 2> output = filter.filter({{1.0, 1.0}});
+  EXPECT_NEAR(1.0, output[0], 1e-12);
+  EXPECT_NEAR(1.0, output[1], 1e-12);
+}
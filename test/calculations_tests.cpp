@@ -125,4 +125,49 @@ TEST(CalculationTest, CombineInertiaTensorEEWithLoad) {
   for (int i = 0; i < 3; i++) {
     EXPECT_NEAR(expected[i], I_total[i], 1e-14);
   }
-}
\ No newline at end of file
+}
+
+TEST(CalculationTest, CombinedLoadCacheMatchesDirectComputation) {
+  double m_ee = 0.73;
+  std::array<double, 3> F_x_Cee{-0.01, 0, -0.03};
+  std::array<double, 9> I_ee{0.001, 0.0, 0.0, 0.0, 0.0025, 0.0, 0.0, 0.0, 0.0017};
+  double m_load = 0.5;
+  std::array<double, 3> F_x_Cload{0.01, -0.2, 0.03};
+  std::array<double, 9> I_load{0.001, 0.0, 0.0, 0.0, 0.025, 0.0, 0.0, 0.0, 0.3};
+  double m_total = m_ee + m_load;
+  std::array<double, 3> F_x_Ctotal = franka::combineCenterOfMass(m_ee, F_x_Cee, m_load, F_x_Cload);
+  std::array<double, 9> I_total = franka::combineInertiaTensor(
+      m_ee, F_x_Cee, I_ee, m_load, F_x_Cload, I_load, m_total, F_x_Ctotal);
+
+  franka::CombinedLoadCache cache;
+  cache.update(m_ee, F_x_Cee, I_ee, m_load, F_x_Cload, I_load);
+
+  EXPECT_EQ(m_total, cache.m_total());
+  EXPECT_EQ(F_x_Ctotal, cache.F_x_Ctotal());
+  EXPECT_EQ(I_total, cache.I_total());
+}
+
+TEST(CalculationTest, CombinedLoadCacheOnlyRecomputesOnChange) {
+  double m_ee = 0.73;
+  std::array<double, 3> F_x_Cee{-0.01, 0, -0.03};
+  std::array<double, 9> I_ee{0.001, 0.0, 0.0, 0.0, 0.0025, 0.0, 0.0, 0.0, 0.0017};
+  std::array<double, 3> F_x_Cload{0.01, -0.2, 0.03};
+  std::array<double, 9> I_load{0.001, 0.0, 0.0, 0.0, 0.025, 0.0, 0.0, 0.0, 0.3};
+
+  franka::CombinedLoadCache cache;
+  EXPECT_EQ(0u, cache.recomputeCount());
+
+  for (int i = 0; i < 10; i++) {
+    cache.update(m_ee, F_x_Cee, I_ee, 0.5, F_x_Cload, I_load);
+  }
+  EXPECT_EQ(1u, cache.recomputeCount());
+  EXPECT_DOUBLE_EQ(1.23, cache.m_total());
+
+  cache.update(m_ee, F_x_Cee, I_ee, 1.0, F_x_Cload, I_load);
+  EXPECT_EQ(2u, cache.recomputeCount());
+  EXPECT_DOUBLE_EQ(1.73, cache.m_total());
+
+  F_x_Cee[2] = 0.03;
+  cache.update(m_ee, F_x_Cee, I_ee, 1.0, F_x_Cload, I_load);
+  EXPECT_EQ(3u, cache.recomputeCount());
+}
@@ -0,0 +1,170 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <franka/cartesian_impedance_controller.h>
+#include <franka/rate_limiting.h>
+
+#include "allocation_tracker.h"
+
+using franka::CartesianImpedanceController;
+using franka::DynamicsBundle;
+using franka::RobotState;
+
+namespace {
+
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+
+std::array<double, 16> pose(const Eigen::Vector3d& position, const Eigen::Matrix3d& rotation) {
+  Eigen::Affine3d transform = Eigen::Affine3d::Identity();
+  transform.translation() = position;
+  transform.linear() = rotation;
+  std::array<double, 16> result;
+  Eigen::Map<Eigen::Matrix4d>(result.data()) = transform.matrix();
+  return result;
+}
+
+// Dynamics with a Jacobian that maps the first six joints directly to the twist.
+DynamicsBundle identityDynamics() {
+  DynamicsBundle dynamics{};
+  Eigen::Map<Matrix6x7d>(dynamics.zero_jacobian.data()) = Matrix6x7d::Identity();
+  return dynamics;
+}
+
+RobotState stateAt(const std::array<double, 16>& O_T_EE) {  // NOLINT(readability-identifier-naming)
+  RobotState robot_state{};
+  robot_state.O_T_EE = O_T_EE;
+  return robot_state;
+}
+
+const Eigen::Vector3d kPosition(0.3, -0.1, 0.5);
+const Eigen::Matrix3d kRotation(Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitX()));
+
+}  // anonymous namespace
+
+TEST(CartesianImpedanceController, CommandsOnlyCoriolisAtEquilibrium) {
+  DynamicsBundle dynamics{};
+  Eigen::Map<Matrix6x7d>(dynamics.zero_jacobian.data()) = Matrix6x7d::Random();
+  dynamics.coriolis = {{0.1, -0.2, 0.3, -0.4, 0.5, -0.6, 0.7}};
+  RobotState robot_state = stateAt(pose(kPosition, kRotation));
+
+  CartesianImpedanceController controller;
+  controller.reset(robot_state);
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(dynamics.coriolis[i], tau_d[i], 1e-12);
+  }
+}
+
+TEST(CartesianImpedanceController, PullsTowardsEquilibrium) {
+  constexpr double kTranslationalStiffness = 200.0;
+  constexpr double kRotationalStiffness = 20.0;
+  constexpr double kAngle = 0.1;
+  DynamicsBundle dynamics = identityDynamics();
+  CartesianImpedanceController controller(kTranslationalStiffness, kRotationalStiffness);
+  controller.reset(stateAt(pose(kPosition, Eigen::Matrix3d::Identity())));
+
+  RobotState robot_state = stateAt(
+      pose(kPosition + Eigen::Vector3d(0.01, 0, 0),
+           Eigen::AngleAxisd(kAngle, Eigen::Vector3d::UnitZ()).toRotationMatrix()));
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics);
+  EXPECT_NEAR(-kTranslationalStiffness * 0.01, tau_d[0], 1e-9);
+  EXPECT_NEAR(0.0, tau_d[1], 1e-9);
+  EXPECT_NEAR(-kRotationalStiffness * std::sin(kAngle / 2), tau_d[5], 1e-9);
+  EXPECT_EQ(0.0, tau_d[6]);
+}
+
+TEST(CartesianImpedanceController, DampsEndEffectorVelocity) {
+  constexpr double kStiffness = 100.0;
+  DynamicsBundle dynamics = identityDynamics();
+  RobotState robot_state = stateAt(pose(kPosition, kRotation));
+  CartesianImpedanceController controller(kStiffness, kStiffness);
+  controller.reset(robot_state);
+
+  robot_state.dq = {{0.1, 0, 0, 0, -0.2, 0, 0}};
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics);
+  EXPECT_NEAR(-2.0 * std::sqrt(kStiffness) * 0.1, tau_d[0], 1e-9);
+  EXPECT_NEAR(2.0 * std::sqrt(kStiffness) * 0.2, tau_d[4], 1e-9);
+
+  controller.setDamping({{1, 1, 1, 1, 1, 1}});
+  for (size_t i = 0; i < 5000; i++) {
+    tau_d = controller.update(robot_state, dynamics);
+  }
+  EXPECT_NEAR(-0.1, tau_d[0], 1e-9);
+  EXPECT_NEAR(0.2, tau_d[4], 1e-9);
+}
+
+TEST(CartesianImpedanceController, FiltersTargetAndStiffness) {
+  DynamicsBundle dynamics = identityDynamics();
+  RobotState robot_state = stateAt(pose(kPosition, kRotation));
+  CartesianImpedanceController controller(150.0, 10.0, 1.0);
+  controller.reset(robot_state);
+
+  Eigen::Matrix3d target_rotation =
+      kRotation * Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitY()).toRotationMatrix();
+  std::array<double, 16> target = pose(kPosition + Eigen::Vector3d(0, 0.1, 0), target_rotation);
+  controller.setTarget(target);
+  controller.setStiffness({{300, 300, 300, 30, 30, 30}});
+
+  // The first step only moves a small part of the way.
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics);
+  double gain = franka::kDeltaT / (franka::kDeltaT + 1.0 / (2.0 * M_PI));
+  EXPECT_NEAR(kPosition.y() + 0.1 * gain, controller.equilibriumPose()[13], 1e-12);
+  EXPECT_NEAR(150.0 + 150.0 * gain, controller.stiffness()[0], 1e-9);
+  EXPECT_GT(tau_d[1], 0.0);
+  EXPECT_LT(tau_d[1], 0.1 * controller.stiffness()[1]);
+
+  for (size_t i = 0; i < 5000; i++) {
+    controller.update(robot_state, dynamics);
+  }
+  std::array<double, 16> equilibrium = controller.equilibriumPose();
+  for (size_t i = 0; i < 16; i++) {
+    EXPECT_NEAR(target[i], equilibrium[i], 1e-9);
+  }
+  EXPECT_NEAR(300.0, controller.stiffness()[0], 1e-9);
+  EXPECT_NEAR(2.0 * std::sqrt(30.0), controller.damping()[5], 1e-9);
+}
+
+TEST(CartesianImpedanceController, StartsAtFirstStateWithoutReset) {
+  DynamicsBundle dynamics = identityDynamics();
+  RobotState robot_state = stateAt(pose(kPosition, kRotation));
+  CartesianImpedanceController controller;
+
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics);
+  for (double tau : tau_d) {
+    EXPECT_NEAR(0.0, tau, 1e-12);
+  }
+  EXPECT_EQ(robot_state.O_T_EE[12], controller.equilibriumPose()[12]);
+}
+
+TEST(CartesianImpedanceController, UpdateDoesNotAllocate) {
+  DynamicsBundle dynamics = identityDynamics();
+  RobotState robot_state = stateAt(pose(kPosition, kRotation));
+  CartesianImpedanceController controller;
+  controller.reset(robot_state);
+
+  franka::AllocationTrackingScope allocation_tracking;
+  controller.setTarget(pose(kPosition + Eigen::Vector3d(0.1, 0, 0), kRotation));
+  controller.setStiffness({{100, 100, 100, 10, 10, 10}});
+  controller.update(robot_state, dynamics);
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(CartesianImpedanceController, ThrowsForInvalidParameters) {
+  EXPECT_THROW(CartesianImpedanceController(-1.0, 10.0), std::invalid_argument);
+  EXPECT_THROW(CartesianImpedanceController(150.0, NAN), std::invalid_argument);
+  EXPECT_THROW(CartesianImpedanceController(150.0, 10.0, 0.0), std::invalid_argument);
+
+  CartesianImpedanceController controller;
+  EXPECT_THROW(controller.setStiffness({{1, 1, 1, 1, 1, -1}}), std::invalid_argument);
+  EXPECT_THROW(controller.setDamping({{1, 1, INFINITY, 1, 1, 1}}), std::invalid_argument);
+  std::array<double, 16> target = pose(kPosition, kRotation);
+  target[13] = NAN;
+  EXPECT_THROW(controller.setTarget(target), std::invalid_argument);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/clock_estimator.h>
+
+using franka::ClockEstimate;
+using franka::ClockEstimator;
+using franka::Duration;
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+namespace {
+
+Clock::time_point hostTime(double seconds) {
+  return Clock::time_point(std::chrono::duration_cast<Clock::duration>(Seconds(seconds)));
+}
+
+double seconds(Clock::time_point time) {
+  return Seconds(time.time_since_epoch()).count();
+}
+
+}  // anonymous namespace
+
+TEST(ClockEstimator, ThrowsOnInvalidParameters) {
+  EXPECT_THROW(ClockEstimator(0.0), std::invalid_argument);
+  EXPECT_THROW(ClockEstimator(1.5), std::invalid_argument);
+  EXPECT_THROW(ClockEstimator(0.01, -1e-3), std::invalid_argument);
+}
+
+TEST(ClockEstimator, EstimatesOffsetDriftAndLatency) {
+  constexpr double kOffset = 1000.0;
+  constexpr double kDrift = 2e-5;
+  constexpr double kTransportLatency = 2e-4;
+  constexpr double kMeanJitter = 1e-4;
+
+  ClockEstimator estimator(1e-3, kTransportLatency);
+  EXPECT_FALSE(estimator.valid());
+  EXPECT_EQ(Clock::time_point(), estimator.hostTime(Duration(0)));
+
+  std::mt19937 generator(0);
+  std::exponential_distribution<double> jitter(1 / kMeanJitter);
+  const uint64_t start = 50000;
+  for (uint64_t t = start; t < start + 20000; t++) {
+    double taken = kOffset + (1 + kDrift) * static_cast<double>(t) * 1e-3;
+    estimator.update(Duration(t), hostTime(taken + kTransportLatency + jitter(generator)));
+  }
+  ASSERT_TRUE(estimator.valid());
+
+  ClockEstimate estimate = estimator.estimate();
+  EXPECT_EQ(20000u, estimate.samples);
+  EXPECT_NEAR(kDrift, estimate.drift, 5e-6);
+  EXPECT_NEAR(kTransportLatency + kMeanJitter, estimate.latency, 2e-5);
+
+  uint64_t last = start + 19999;
+  double taken = kOffset + (1 + kDrift) * static_cast<double>(last) * 1e-3;
+  EXPECT_NEAR(taken, seconds(estimator.hostTime(Duration(last))), 2e-5);
+  EXPECT_NEAR(taken, estimate.offset + (1 + estimate.drift) * static_cast<double>(last) * 1e-3,
+              2e-5);
+
+  estimator.reset();
+  EXPECT_FALSE(estimator.valid());
+  EXPECT_EQ(0u, estimator.estimate().samples);
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/command_pipeline.h>
+#include <franka/lowpass_filter.h>
+#include <franka/rate_limiting.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::CartesianPose;
+using franka::CartesianVelocities;
+using franka::Duration;
+using franka::JointPositions;
+using franka::JointVelocities;
+using franka::RobotState;
+using franka::Torques;
+
+namespace pipeline = franka::pipeline;
+
+TEST(CommandPipeline, MatchesFilterAndRateLimitFunctions) {
+  RobotState robot_state = generateValidRobotState();
+  auto command_pipeline = franka::makeCommandPipeline(pipeline::Lowpass(100.0),
+                                                      pipeline::RateLimit(),
+                                                      pipeline::CheckFinite());
+
+  Torques torques({10, -10, 20, -20, 5, 0, 1});
+  Torques processed = command_pipeline(torques, robot_state, Duration(1));
+  franka::LowpassFilter<7> filter(franka::kDeltaT, 100.0);
+  EXPECT_EQ(franka::limitRate(franka::kMaxTorqueRate,
+                              filter.filter(torques.tau_J, robot_state.tau_J_d),
+                              robot_state.tau_J_d),
+            processed.tau_J);
+
+  JointVelocities velocities({1, 1, 1, 1, 1, 1, 1});
+  JointVelocities processed_velocities = command_pipeline(velocities, robot_state, Duration(1));
+  EXPECT_EQ(franka::limitRate(franka::kMaxJointVelocity, franka::kMaxJointAcceleration,
+                              franka::kMaxJointJerk,
+                              filter.filter(velocities.dq, robot_state.dq_d), robot_state.dq_d,
+                              robot_state.ddq_d),
+            processed_velocities.dq);
+}
+
+TEST(CommandPipeline, CanProcessAllMotionGeneratorTypes) {
+  RobotState robot_state = generateValidRobotState();
+  auto command_pipeline =
+      franka::makeCommandPipeline(pipeline::Lowpass(), pipeline::RateLimit(),
+                                  pipeline::Passivity(), pipeline::CheckFinite());
+
+  JointPositions positions(robot_state.q_d);
+  EXPECT_NO_THROW(command_pipeline(positions, robot_state, Duration(1)));
+  robot_state.elbow_c = {{0.5, -1}};
+  CartesianPose pose(robot_state.O_T_EE_c, robot_state.elbow_c);
+  CartesianPose processed_pose = command_pipeline(pose, robot_state, Duration(1));
+  EXPECT_TRUE(processed_pose.hasElbow());
+  EXPECT_TRUE(franka::isHomogeneousTransformation(processed_pose.O_T_EE));
+  CartesianVelocities velocities(robot_state.O_dP_EE_c);
+  EXPECT_NO_THROW(command_pipeline(velocities, robot_state, Duration(1)));
+
+  // Only torque commands reach the passivity stage.
+  EXPECT_EQ(0u, command_pipeline.stage<2>().controller().statistics().cycles);
+  command_pipeline(Torques(robot_state.tau_J_d), robot_state, Duration(1));
+  EXPECT_EQ(1u, command_pipeline.stage<2>().controller().statistics().cycles);
+}
+
+TEST(CommandPipeline, RunsStagesInOrder) {
+  std::vector<std::string> calls;
+  auto command_pipeline = franka::makeCommandPipeline(
+      pipeline::custom([&](Torques* torques, const RobotState&, Duration) {
+        calls.emplace_back("first");
+        torques->tau_J[0] *= 2;
+      }),
+      pipeline::custom([&](auto* command, const RobotState&, Duration) {
+        calls.emplace_back("generic");
+        static_cast<void>(command);
+      }),
+      pipeline::custom([&](Torques* torques, const RobotState&, Duration) {
+        calls.emplace_back("last");
+        torques->tau_J[0] += 1;
+      }));
+
+  RobotState robot_state;
+  Torques torques = command_pipeline(Torques({1, 0, 0, 0, 0, 0, 0}), robot_state, Duration(1));
+  EXPECT_EQ(3.0, torques.tau_J[0]);
+  EXPECT_THAT(calls, ElementsAre("first", "generic", "last"));
+
+  calls.clear();
+  command_pipeline(JointVelocities({0, 0, 0, 0, 0, 0, 0}), robot_state, Duration(1));
+  EXPECT_THAT(calls, ElementsAre("generic"));
+}
+
+TEST(CommandPipeline, ClampsJointLevelCommands) {
+  std::array<double, 7> min{{-1, -2, -3, -4, -5, -6, -7}};
+  std::array<double, 7> max{{1, 2, 3, 4, 5, 6, 7}};
+  auto command_pipeline = franka::makeCommandPipeline(pipeline::Clamp(min, max));
+
+  RobotState robot_state;
+  Torques torques =
+      command_pipeline(Torques({-10, 10, 0.5, -0.5, 5, -6, 100}), robot_state, Duration(1));
+  EXPECT_THAT(torques.tau_J, ElementsAre(-1, 2, 0.5, -0.5, 5, -6, 7));
+
+  JointPositions positions =
+      command_pipeline(JointPositions({10, 10, 10, 10, 10, 10, 10}), robot_state, Duration(1));
+  EXPECT_EQ(max, positions.q);
+
+  EXPECT_THROW(pipeline::Clamp(max, min), std::invalid_argument);
+}
+
+TEST(CommandPipeline, CheckFiniteThrowsOnInvalidCommands) {
+  auto command_pipeline = franka::makeCommandPipeline(pipeline::CheckFinite());
+  RobotState robot_state;
+
+  Torques torques({0, 0, 0, 0, 0, 0, 0});
+  torques.tau_J[3] = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(command_pipeline(torques, robot_state, Duration(1)), std::invalid_argument);
+
+  CartesianPose pose({1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1});
+  EXPECT_NO_THROW(command_pipeline(pose, robot_state, Duration(1)));
+  pose.O_T_EE[1] = 1;
+  EXPECT_THROW(command_pipeline(pose, robot_state, Duration(1)), std::invalid_argument);
+}
+
+TEST(CommandPipeline, CanWrapCallbacks) {
+  auto command_pipeline =
+      franka::makeCommandPipeline(pipeline::custom([](Torques* torques, const RobotState&,
+                                                      Duration) { torques->tau_J.fill(1); }));
+  size_t count = 0;
+  auto callback = [&](const RobotState&, Duration) -> Torques {
+    count++;
+    return franka::MotionFinished(Torques({0, 0, 0, 0, 0, 0, 0}));
+  };
+  auto wrapped = command_pipeline.wrap(callback);
+
+  Torques torques = wrapped(RobotState(), Duration(1));
+  EXPECT_EQ(1u, count);
+  EXPECT_THAT(torques.tau_J, Each(1.0));
+  EXPECT_TRUE(torques.motion_finished);
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/communication_statistics.h>
+#include <franka/robot.h>
+
+#include "communication_statistics_recorder.h"
+#include "helpers.h"
+#include "mock_server.h"
+
+using namespace std::chrono_literals;  // NOLINT(google-build-using-namespace)
+
+using franka::CommunicationStatisticsRecorder;
+
+TEST(CommunicationStatisticsRecorder, IsEmptyByDefault) {
+  CommunicationStatisticsRecorder recorder;
+  franka::CommunicationStatistics statistics = recorder.statistics();
+
+  EXPECT_EQ(0u, statistics.received_states);
+  EXPECT_EQ(0u, statistics.lost_states);
+  EXPECT_EQ(0u, statistics.max_lost_in_a_row);
+  EXPECT_EQ(1.0, statistics.min_control_command_success_rate);
+  EXPECT_EQ(0u, statistics.round_trip.count);
+  EXPECT_FALSE(recorder.enabled());
+}
+
+TEST(CommunicationStatisticsRecorder, CountsLostStates) {
+  CommunicationStatisticsRecorder recorder;
+  EXPECT_FALSE(recorder.record(10, 1.0, true, 0.9));
+  EXPECT_FALSE(recorder.record(11, 1.0, true, 0.9));
+  EXPECT_TRUE(recorder.record(14, 1.0, true, 0.9));
+  EXPECT_FALSE(recorder.record(15, 1.0, true, 0.9));
+  EXPECT_TRUE(recorder.record(17, 1.0, true, 0.9));
+
+  franka::CommunicationStatistics statistics = recorder.statistics();
+  EXPECT_EQ(5u, statistics.received_states);
+  EXPECT_EQ(3u, statistics.lost_states);
+  EXPECT_EQ(1u, statistics.lost_in_a_row);
+  EXPECT_EQ(2u, statistics.max_lost_in_a_row);
+}
+
+TEST(CommunicationStatisticsRecorder, DoesNotCountStatesBeforeRestart) {
+  CommunicationStatisticsRecorder recorder;
+  recorder.record(10, 1.0, false, 0.9);
+  recorder.restart();
+  EXPECT_FALSE(recorder.record(500, 1.0, false, 0.9));
+
+  EXPECT_EQ(0u, recorder.statistics().lost_states);
+  EXPECT_EQ(2u, recorder.statistics().received_states);
+}
+
+TEST(CommunicationStatisticsRecorder, ReportsDropOfSuccessRateOnce) {
+  CommunicationStatisticsRecorder recorder;
+  EXPECT_FALSE(recorder.record(1, 0.5, false, 0.9));
+  EXPECT_FALSE(recorder.record(2, 0.95, true, 0.9));
+  EXPECT_TRUE(recorder.record(3, 0.85, true, 0.9));
+  EXPECT_FALSE(recorder.record(4, 0.8, true, 0.9));
+  EXPECT_FALSE(recorder.record(5, 0.95, true, 0.9));
+  EXPECT_TRUE(recorder.record(6, 0.85, true, 0.9));
+
+  franka::CommunicationStatistics statistics = recorder.statistics();
+  EXPECT_DOUBLE_EQ(0.85, statistics.control_command_success_rate);
+  EXPECT_DOUBLE_EQ(0.8, statistics.min_control_command_success_rate);
+}
+
+TEST(CommunicationStatisticsRecorder, RecordsRoundTrip) {
+  CommunicationStatisticsRecorder recorder;
+  recorder.recordRoundTrip(200us);
+  recorder.recordRoundTrip(400us);
+
+  franka::CommunicationStatistics statistics = recorder.statistics();
+  EXPECT_EQ(2u, statistics.round_trip.count);
+  EXPECT_DOUBLE_EQ(300.0, statistics.round_trip.mean);
+
+  recorder.reset();
+  EXPECT_EQ(0u, recorder.statistics().round_trip.count);
+}
+
+TEST(CommunicationStatistics, CanBeStreamed) {
+  franka::CommunicationStatistics statistics;
+
+  std::stringstream ss;
+  ss << statistics;
+  std::string output(ss.str());
+
+  EXPECT_PRED2(stringContains, output, "received_states");
+  EXPECT_PRED2(stringContains, output, "lost_states");
+  EXPECT_PRED2(stringContains, output, "max_lost_in_a_row");
+  EXPECT_PRED2(stringContains, output, "min_control_command_success_rate");
+  EXPECT_PRED2(stringContains, output, "round_trip");
+}
+
+TEST(Robot, RecordsCommunicationStatisticsWhileReading) {
+  RobotMockServer server;
+  franka::Robot robot("127.0.0.1");
+  robot.setCommunicationStatisticsEnabled(true);
+
+  server.sendEmptyState<research_interface::robot::RobotState>().spinOnce();
+  robot.read([](const franka::RobotState&) { return false; });
+
+  franka::CommunicationStatistics statistics = robot.communicationStatistics();
+  EXPECT_EQ(1u, statistics.received_states);
+  EXPECT_EQ(0u, statistics.lost_states);
+
+  robot.resetCommunicationStatistics();
+  EXPECT_EQ(0u, robot.communicationStatistics().received_states);
+}
+
+TEST(Robot, ThrowsOnInvalidSuccessRateThreshold) {
+  RobotMockServer server;
+  franka::Robot robot("127.0.0.1");
+
+  EXPECT_THROW(robot.setCommunicationStatisticsCallback({}, 1.5), std::invalid_argument);
+  EXPECT_NO_THROW(robot.setCommunicationStatisticsCallback({}, 0.9));
+}
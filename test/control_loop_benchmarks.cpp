@@ -0,0 +1,118 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+#include <franka/control_statistics.h>
+#include <franka/robot.h>
+#include <research_interface/robot/rbk_types.h>
+#include <research_interface/robot/service_types.h>
+
+#include "helpers.h"
+#include "logger.h"
+#include "mock_server.h"
+
+using namespace research_interface::robot;  // NOLINT(google-build-using-namespace)
+
+namespace {
+
+void sendState(RobotMockServer::Socket& udp_socket, uint32_t message_id, bool moving) {
+  RobotState robot_state{};
+  robot_state.message_id = message_id;
+  robot_state.controller_mode = ControllerMode::kJointImpedance;
+  if (moving) {
+    robot_state.motion_generator_mode = MotionGeneratorMode::kJointPosition;
+    robot_state.robot_mode = RobotMode::kMove;
+  } else {
+    robot_state.motion_generator_mode = MotionGeneratorMode::kIdle;
+    robot_state.robot_mode = RobotMode::kIdle;
+  }
+  udp_socket.sendBytes(&robot_state, sizeof(robot_state));
+}
+
+// Answers every command with the next state as soon as it arrives, so that the control loop runs
+// as fast as the library can process the states.
+void serveMotion(RobotMockServer& server, uint32_t& move_id) {
+  server
+      .waitForCommand<Move>(
+          [&](const Move::Request&) {
+            server.generic([&](RobotMockServer::Socket& tcp_socket,
+                               RobotMockServer::Socket& udp_socket) {
+              uint32_t message_id = server.sequenceNumber();
+              // Consumed by Robot::Impl::startMotion and the first update of the control loop.
+              sendState(udp_socket, ++message_id, true);
+              sendState(udp_socket, ++message_id, true);
+
+              RobotCommand robot_command{};
+              do {
+                udp_socket.receiveBytes(&robot_command, sizeof(robot_command));
+                sendState(udp_socket, ++message_id,
+                          !robot_command.motion.motion_generation_finished);
+              } while (!robot_command.motion.motion_generation_finished);
+
+              server.sendResponse<Move>(
+                  tcp_socket,
+                  CommandHeader(Command::kMove, move_id,
+                                sizeof(CommandMessage<Move::Response>)),
+                  Move::Response(Move::Status::kSuccess));
+            });
+            return Move::Response(Move::Status::kMotionStarted);
+          },
+          &move_id)
+      .spinOnce();
+}
+
+void setCounter(benchmark::State& state, const char* name, const franka::LatencyStatistics& stage) {
+  state.counters[name] = benchmark::Counter(stage.mean);
+}
+
+}  // anonymous namespace
+
+// Runs Robot::control against an in-process server, one control cycle per iteration. Besides the
+// sustained cycle rate, reports the mean time per stage in microseconds, as measured by the
+// control statistics: receive_state and send_command are the two halves of Robot::Impl::update,
+// which includes converting the robot state and logging it, and motion_command_processing is
+// ControlLoop::convertMotion.
+static void BM_ControlLoop(benchmark::State& state) {
+  RobotMockServer server;
+  franka::Robot robot("127.0.0.1", franka::RealtimeConfig::kIgnore);
+  robot.setControlStatisticsEnabled(true);
+  uint32_t move_id;
+  serveMotion(server, move_id);
+
+  franka::JointPositions joint_positions{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
+  robot.control(
+      [&](const franka::RobotState&, franka::Duration) -> franka::JointPositions {
+        if (state.KeepRunning()) {
+          return joint_positions;
+        }
+        return franka::MotionFinished(joint_positions);
+      },
+      franka::ControllerMode::kJointImpedance, state.range(0) != 0);
+
+  franka::ControlStatistics statistics = robot.controlStatistics();
+  state.counters["cycles_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+  setCounter(state, "receive_state_us", statistics.receive_state);
+  setCounter(state, "motion_callback_us", statistics.motion_callback);
+  setCounter(state, "motion_command_processing_us", statistics.motion_command_processing);
+  setCounter(state, "send_command_us", statistics.send_command);
+  setCounter(state, "cycle_us", statistics.cycle);
+}
+BENCHMARK(BM_ControlLoop)->ArgName("limit_rate")->Arg(0)->Arg(1)->UseRealTime();
+
+static void BM_LoggerLog(benchmark::State& state) {
+  RobotState robot_state;
+  randomRobotState(robot_state);
+  RobotCommand robot_command;
+  randomRobotCommand(robot_command);
+  franka::Logger logger(50, static_cast<franka::LogFields>(state.range(0)));
+  for (auto _ : state) {
+    logger.log(robot_state, robot_command);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_LoggerLog)
+    ->Arg(static_cast<int64_t>(franka::LogFields::kNone))
+    ->Arg(static_cast<int64_t>(franka::LogFields::kAll));
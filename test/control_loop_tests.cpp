@@ -1,11 +1,16 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <chrono>
 #include <exception>
 #include <functional>
+#include <thread>
 
 #include <gmock/gmock.h>
 
+#include <franka/exception.h>
 #include <franka/lowpass_filter.h>
+#include "allocation_tracker.h"
 #include "control_loop.h"
 #include "motion_generator_traits.h"
 
@@ -823,6 +828,21 @@ TYPED_TEST(ControlLoops, SpinOnceWithMotionCallbackAndControllerMode) {
   EXPECT_THAT(command.motion, this->getField(motion));
 }
 
+TYPED_TEST(ControlLoops, SpinMotionDoesNotAllocate) {
+  NiceMock<MockRobotControl> robot;
+  auto motion = this->createMotion();
+  typename TestFixture::Loop loop(
+      robot, ControllerMode::kJointImpedance,
+      [&](const RobotState&, Duration) { return motion; }, TestFixture::kLimitRate,
+      getCutoffFreq(TestFixture::kFilter));
+
+  RobotState robot_state = generateValidRobotState();
+  RobotCommand command{};
+  franka::AllocationTrackingScope allocation_tracking;
+  EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &command.motion));
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
 TYPED_TEST(ControlLoops, SpinOnceWithMotionAndControllerCallback) {
   StrictMock<MockRobotControl> robot;
   EXPECT_CALL(robot, startMotion(Move::ControllerMode::kExternalController,
@@ -1225,6 +1245,275 @@ TYPED_TEST(ControlLoops, GetsCorrectTimeStepWithMotionCallback) {
   loop();
 }
 
+TEST(ControlLoop, LoopWithViewCallbacks) {
+  NiceMock<MockRobotControl> robot;
+  EXPECT_CALL(robot, startMotion(Move::ControllerMode::kExternalController,
+                                 Move::MotionGeneratorMode::kJointVelocity, _, _))
+      .WillOnce(Return(200));
+
+  research_interface::robot::RobotState robot_state;
+  randomRobotState(robot_state);
+  robot_state.message_id = 10;
+  std::array<uint64_t, 3> ticks{{0, 1, 3}};
+
+  size_t robot_count = 0;
+  EXPECT_CALL(robot, updateView(_, _))
+      .Times(ticks.size())
+      .WillRepeatedly(Invoke([&](const MotionGeneratorCommand*, const ControllerCommand*) {
+        robot_state.message_id += ticks.at(robot_count);
+        robot_count++;
+        return franka::RobotStateView(robot_state);
+      }));
+  EXPECT_CALL(robot, update(_, _)).Times(0);
+  EXPECT_CALL(robot, finishMotion(200, _, _));
+
+  size_t control_count = 0;
+  ControlLoop<JointVelocities> loop(
+      robot,
+      [&](const franka::RobotStateView& view, Duration duration) -> Torques {
+        EXPECT_EQ(robot_state.q, view.q());
+        EXPECT_EQ(ticks.at(control_count), duration.toMSec());
+        Torques torques({0, 0, 0, 0, 0, 0, 0});
+        if (++control_count == ticks.size()) {
+          return MotionFinished(torques);
+        }
+        return torques;
+      },
+      [](const franka::RobotStateView&, Duration) {
+        return JointVelocities({0, 0, 0, 0, 0, 0, 0});
+      },
+      false, franka::kMaxCutoffFrequency);
+
+  loop();
+  EXPECT_EQ(ticks.size(), control_count);
+}
+
+TEST(ControlLoop, CanFilterTorquesWithButterworthFilter) {
+  NiceMock<MockRobotControl> robot;
+  EXPECT_CALL(robot, startMotion(Move::ControllerMode::kExternalController,
+                                 Move::MotionGeneratorMode::kJointVelocity, _, _))
+      .WillOnce(Return(200));
+
+  Torques torques({0, 1, 2, 3, 4, 5, 6});
+  ControlLoop<JointVelocities> loop(
+      robot, [&](const RobotState&, Duration) { return torques; },
+      [](const RobotState&, Duration) { return JointVelocities({0, 0, 0, 0, 0, 0, 0}); }, false,
+      franka::kMaxCutoffFrequency);
+  franka::ButterworthFilter<7> filter(0.001, 30.0);
+  loop.setTorqueFilter(filter);
+
+  RobotState robot_state = generateValidRobotState();
+  ControllerCommand command{};
+  EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &command));
+  EXPECT_EQ(filter.filter(torques.tau_J), command.tau_J_d);
+
+  torques = Torques({0, 0, 0, 0, 0, 0, 0});
+  for (size_t i = 0; i < 10; i++) {
+    EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &command));
+    EXPECT_EQ(filter.filter(torques.tau_J), command.tau_J_d);
+  }
+  EXPECT_GT(command.tau_J_d[6], 0.0);
+}
+
+TEST(ControlLoop, CanConfigureFiltersPerChannelAndJoint) {
+  NiceMock<MockRobotControl> robot;
+  EXPECT_CALL(robot, startMotion(Move::ControllerMode::kExternalController,
+                                 Move::MotionGeneratorMode::kJointVelocity, _, _))
+      .WillOnce(Return(200));
+
+  franka::FilterConfiguration filter_configuration(franka::kMaxCutoffFrequency);
+  filter_configuration.joints[2] = 10.0;
+  Torques torques({0, 1, 2, 3, 4, 5, 6});
+  JointVelocities velocities({0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1});
+  ControlLoop<JointVelocities> loop(
+      robot, [&](const RobotState&, Duration) { return torques; },
+      [&](const RobotState&, Duration) { return velocities; }, false, filter_configuration);
+
+  RobotState robot_state = generateValidRobotState();
+  robot_state.dq_d = {};
+  MotionGeneratorCommand motion_command{};
+  ControllerCommand control_command{};
+  EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &motion_command));
+  EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &control_command));
+
+  // Unfiltered channels and joints pass the commanded values through unchanged.
+  EXPECT_EQ(torques.tau_J, control_command.tau_J_d);
+  for (size_t i = 0; i < 7; i++) {
+    if (i == 2) {
+      EXPECT_DOUBLE_EQ(franka::lowpassFilter(0.001, 0.1, 0.0, 10.0), motion_command.dq_c[i]);
+    } else {
+      EXPECT_EQ(velocities.dq[i], motion_command.dq_c[i]);
+    }
+  }
+}
+
+TEST(ControlLoop, GeneratesJointPositionsOnlineIfEnabled) {
+  NiceMock<MockRobotControl> robot;
+  robot.online_trajectory_generation = true;
+  std::array<double, 7> target{{1, 1, 1, 1, 1, 1, 1}};
+  ControlLoop<JointPositions> loop(
+      robot, ControllerMode::kJointImpedance,
+      [&](const RobotState&, Duration) { return JointPositions(target); }, true,
+      franka::kMaxCutoffFrequency);
+
+  // The step to the target is spread over many cycles instead of being clipped to one.
+  RobotState robot_state = generateValidRobotState();
+  RobotCommand command{};
+  for (size_t k = 0; k < 3; k++) {
+    EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &command.motion));
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_GT(command.motion.q_c[i], robot_state.q_d[i]);
+      EXPECT_LT(command.motion.q_c[i] - robot_state.q_d[i], 1e-3);
+    }
+    robot_state.q_d = command.motion.q_c;
+  }
+
+  // Without rate limiting, the command is passed through.
+  ControlLoop<JointPositions> unlimited_loop(
+      robot, ControllerMode::kJointImpedance,
+      [&](const RobotState&, Duration) { return JointPositions(target); }, false,
+      franka::kMaxCutoffFrequency);
+  EXPECT_TRUE(unlimited_loop.spinMotion(robot_state, Duration(1), &command.motion));
+  EXPECT_EQ(target, command.motion.q_c);
+}
+
+TEST(ControlLoop, ChecksOnlyFinitenessWithChecksumValidation) {
+  NiceMock<MockRobotControl> robot;
+  robot.validation_policy = franka::ValidationPolicy::kChecksum;
+  std::array<double, 16> pose{{2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  ControlLoop<CartesianPose> loop(
+      robot, ControllerMode::kCartesianImpedance,
+      [&](const RobotState&, Duration) { return CartesianPose(pose); }, false,
+      franka::kMaxCutoffFrequency);
+
+  // Structural checks are skipped, but infinite or NaN values still reach the final command.
+  RobotState robot_state = generateValidRobotState();
+  MotionGeneratorCommand command{};
+  EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &command));
+
+  pose[5] = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(loop.spinMotion(robot_state, Duration(1), &command), std::invalid_argument);
+  pose[5] = std::numeric_limits<double>::infinity();
+  EXPECT_THROW(loop.spinMotion(robot_state, Duration(1), &command), std::invalid_argument);
+}
+
+TEST(ControlLoop, DecaysTorquesIfControlCallbackMissesDeadline) {
+  NiceMock<MockRobotControl> robot;
+  franka::CallbackDeadline deadline;
+  deadline.budget = std::chrono::milliseconds(50);
+  deadline.fallback = franka::DeadlineFallback::kDecayTorque;
+  deadline.torque_decay = 0.5;
+  deadline.max_consecutive_misses = 3;
+  robot.callback_deadline = &deadline;
+
+  std::atomic<bool> block{false};
+  std::atomic<bool> release{false};
+  Torques torques({0, 1, 2, 3, 4, 5, 6});
+  ControlLoop<JointVelocities> loop(
+      robot,
+      [&](const RobotState&, Duration) {
+        while (block && !release) {
+          std::this_thread::yield();
+        }
+        return torques;
+      },
+      [](const RobotState&, Duration) { return JointVelocities({0, 0, 0, 0, 0, 0, 0}); }, false,
+      franka::kMaxCutoffFrequency);
+
+  RobotState robot_state = generateValidRobotState();
+  robot_state.tau_J_d = {{2, 2, 2, 2, 2, 2, 2}};
+  ControllerCommand command{};
+  EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &command));
+  EXPECT_EQ(torques.tau_J, command.tau_J_d);
+
+  // The blocked callback misses its deadline, and is still busy in the next cycle.
+  block = true;
+  EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &command));
+  EXPECT_EQ((std::array<double, 7>{{1, 1, 1, 1, 1, 1, 1}}), command.tau_J_d);
+  EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &command));
+  EXPECT_THROW(loop.spinControl(robot_state, Duration(1), &command), franka::ControlException);
+  release = true;
+
+  EXPECT_EQ(4u, robot.deadline_statistics.cycles);
+  EXPECT_EQ(3u, robot.deadline_statistics.misses);
+  EXPECT_EQ(2u, robot.deadline_statistics.skipped_states);
+  EXPECT_EQ(3u, robot.deadline_statistics.max_consecutive_misses);
+}
+
+TEST(ControlLoop, HoldsJointPositionsIfMotionCallbackMissesDeadline) {
+  NiceMock<MockRobotControl> robot;
+  franka::CallbackDeadline deadline;
+  deadline.budget = std::chrono::milliseconds(50);
+  robot.callback_deadline = &deadline;
+
+  std::atomic<bool> block{false};
+  std::atomic<bool> release{false};
+  std::array<double, 7> target{{1, 1, 1, 1, 1, 1, 1}};
+  ControlLoop<JointPositions> loop(
+      robot, ControllerMode::kJointImpedance,
+      [&](const RobotState&, Duration) {
+        while (block && !release) {
+          std::this_thread::yield();
+        }
+        return JointPositions(target);
+      },
+      false, franka::kMaxCutoffFrequency);
+
+  RobotState robot_state = generateValidRobotState();
+  MotionGeneratorCommand command{};
+  EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &command));
+  EXPECT_EQ(target, command.q_c);
+
+  block = true;
+  EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &command));
+  EXPECT_EQ(robot_state.q_d, command.q_c);
+  release = true;
+  EXPECT_EQ(1u, robot.deadline_statistics.misses);
+}
+
+TEST(ControlLoop, RunsViewAndCombinedMotionCallbacksWithoutDeadline) {
+  NiceMock<MockRobotControl> robot;
+  franka::CallbackDeadline deadline;
+  deadline.budget = std::chrono::milliseconds(50);
+  robot.callback_deadline = &deadline;
+
+  std::thread::id control_thread = std::this_thread::get_id();
+  ControlLoop<JointVelocities> view_loop(
+      robot,
+      [&](const franka::RobotStateView&, Duration) {
+        EXPECT_EQ(control_thread, std::this_thread::get_id());
+        return Torques({0, 0, 0, 0, 0, 0, 0});
+      },
+      [&](const franka::RobotStateView&, Duration) {
+        EXPECT_EQ(control_thread, std::this_thread::get_id());
+        return JointVelocities({0, 0, 0, 0, 0, 0, 0});
+      },
+      false, franka::kMaxCutoffFrequency);
+
+  research_interface::robot::RobotState raw_robot_state;
+  randomRobotState(raw_robot_state);
+  franka::RobotStateView view(raw_robot_state);
+  MotionGeneratorCommand motion_command{};
+  ControllerCommand control_command{};
+  EXPECT_TRUE(view_loop.spinMotion(view, Duration(1), &motion_command));
+  EXPECT_TRUE(view_loop.spinControl(view, Duration(1), &control_command));
+  EXPECT_EQ(0u, robot.deadline_statistics.cycles);
+
+  ControlLoop<JointVelocities> loop(
+      robot, [](const RobotState&, Duration) { return Torques({0, 0, 0, 0, 0, 0, 0}); },
+      [&](const RobotState&, Duration) {
+        EXPECT_EQ(control_thread, std::this_thread::get_id());
+        return JointVelocities({0, 0, 0, 0, 0, 0, 0});
+      },
+      false, franka::kMaxCutoffFrequency);
+
+  RobotState robot_state = generateValidRobotState();
+  EXPECT_TRUE(loop.spinMotion(robot_state, Duration(1), &motion_command));
+  EXPECT_EQ(0u, robot.deadline_statistics.cycles);
+  EXPECT_TRUE(loop.spinControl(robot_state, Duration(1), &control_command));
+  EXPECT_EQ(1u, robot.deadline_statistics.cycles);
+}
+
 using CartesianPoseMotionTypes = ::testing::Types<CartesianPoseMotion<false, true>,
                                                   CartesianPoseMotionWithElbow<false, true>,
                                                   CartesianPoseMotion<true, true>,
@@ -0,0 +1,157 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <chrono>
+#include <sstream>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/control_statistics.h>
+#include <franka/lowpass_filter.h>
+
+#include "control_loop.h"
+#include "control_statistics_recorder.h"
+#include "helpers.h"
+#include "mock_robot_control.h"
+
+using namespace ::testing;
+using namespace std::chrono_literals;  // NOLINT(google-build-using-namespace)
+
+using franka::ControlStatisticsRecorder;
+using franka::Duration;
+using franka::JointVelocities;
+using franka::LatencyHistogram;
+using franka::RobotState;
+using franka::Torques;
+
+TEST(LatencyHistogram, IsEmptyByDefault) {
+  LatencyHistogram histogram;
+  franka::LatencyStatistics statistics = histogram.statistics();
+
+  EXPECT_EQ(0u, statistics.count);
+  EXPECT_EQ(0.0, statistics.min);
+  EXPECT_EQ(0.0, statistics.mean);
+  EXPECT_EQ(0.0, statistics.p50);
+  EXPECT_EQ(0.0, statistics.p99);
+  EXPECT_EQ(0.0, statistics.p999);
+  EXPECT_EQ(0.0, statistics.max);
+}
+
+TEST(LatencyHistogram, ComputesStatistics) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 100; i++) {
+    histogram.record(std::chrono::microseconds(i));
+  }
+  franka::LatencyStatistics statistics = histogram.statistics();
+
+  EXPECT_EQ(100u, statistics.count);
+  EXPECT_DOUBLE_EQ(1.0, statistics.min);
+  EXPECT_DOUBLE_EQ(50.5, statistics.mean);
+  EXPECT_DOUBLE_EQ(100.0, statistics.max);
+  EXPECT_NEAR(50.0, statistics.p50, 1.0);
+  EXPECT_NEAR(99.0, statistics.p99, 1.0);
+  EXPECT_DOUBLE_EQ(100.0, statistics.p999);
+}
+
+TEST(LatencyHistogram, HandlesDurationsOutOfRange) {
+  LatencyHistogram histogram;
+  histogram.record(10s);
+  histogram.record(-1us);
+  franka::LatencyStatistics statistics = histogram.statistics();
+
+  EXPECT_EQ(2u, statistics.count);
+  EXPECT_DOUBLE_EQ(0.0, statistics.min);
+  EXPECT_DOUBLE_EQ(10e6, statistics.max);
+  EXPECT_DOUBLE_EQ(1.0, statistics.p50);
+  EXPECT_DOUBLE_EQ(10e6, statistics.p99);
+}
+
+TEST(LatencyHistogram, CanBeReset) {
+  LatencyHistogram histogram;
+  histogram.record(5us);
+  histogram.reset();
+
+  EXPECT_EQ(0u, histogram.statistics().count);
+}
+
+TEST(ControlStatisticsRecorder, CountsDeadlineMisses) {
+  ControlStatisticsRecorder recorder;
+  recorder.recordCycle(200us);
+  recorder.recordCycle(1500us);
+  recorder.recordCycle(900us);
+  recorder.recordCycle(3ms);
+
+  franka::ControlStatistics statistics = recorder.statistics();
+  EXPECT_EQ(2u, statistics.deadline_misses);
+  EXPECT_EQ(4u, statistics.cycle.count);
+  EXPECT_EQ(0u, statistics.receive_state.count);
+
+  recorder.reset();
+  EXPECT_EQ(0u, recorder.statistics().deadline_misses);
+  EXPECT_EQ(0u, recorder.statistics().cycle.count);
+}
+
+TEST(ControlStatisticsRecorder, RecordsStagesSeparately) {
+  ControlStatisticsRecorder recorder;
+  recorder.record(ControlStatisticsRecorder::Stage::kReceiveState, 10us);
+  recorder.record(ControlStatisticsRecorder::Stage::kSendCommand, 20us);
+  recorder.record(ControlStatisticsRecorder::Stage::kSendCommand, 30us);
+
+  franka::ControlStatistics statistics = recorder.statistics();
+  EXPECT_EQ(1u, statistics.receive_state.count);
+  EXPECT_DOUBLE_EQ(10.0, statistics.receive_state.mean);
+  EXPECT_EQ(2u, statistics.send_command.count);
+  EXPECT_DOUBLE_EQ(25.0, statistics.send_command.mean);
+  EXPECT_EQ(0u, statistics.motion_callback.count);
+}
+
+TEST(ControlStatistics, CanBeStreamed) {
+  franka::ControlStatistics statistics;
+
+  std::stringstream ss;
+  ss << statistics;
+  std::string output(ss.str());
+
+  EXPECT_PRED2(stringContains, output, "receive_state");
+  EXPECT_PRED2(stringContains, output, "motion_callback");
+  EXPECT_PRED2(stringContains, output, "control_callback");
+  EXPECT_PRED2(stringContains, output, "motion_command_processing");
+  EXPECT_PRED2(stringContains, output, "control_command_processing");
+  EXPECT_PRED2(stringContains, output, "send_command");
+  EXPECT_PRED2(stringContains, output, "cycle");
+  EXPECT_PRED2(stringContains, output, "receive_wakeup");
+  EXPECT_PRED2(stringContains, output, "network_cycle");
+  EXPECT_PRED2(stringContains, output, "deadline_misses");
+  EXPECT_PRED2(stringContains, output, "p99");
+}
+
+TEST(ControlStatistics, ControlLoopRecordsCallbackTimings) {
+  ControlStatisticsRecorder recorder;
+  recorder.setEnabled(true);
+
+  NiceMock<MockRobotControl> robot;
+  robot.statistics_recorder = &recorder;
+
+  class Loop : public franka::ControlLoop<JointVelocities> {
+   public:
+    using franka::ControlLoop<JointVelocities>::ControlLoop;
+    using franka::ControlLoop<JointVelocities>::spinMotion;
+    using franka::ControlLoop<JointVelocities>::spinControl;
+  };
+  Loop loop(robot, [](const RobotState&, Duration) { return Torques({0, 0, 0, 0, 0, 0, 0}); },
+            [](const RobotState&, Duration) { return JointVelocities({0, 0, 0, 0, 0, 0, 0}); },
+            false, franka::kMaxCutoffFrequency);
+
+  RobotState robot_state;
+  research_interface::robot::RobotCommand command{};
+  for (int i = 0; i < 3; i++) {
+    loop.spinMotion(robot_state, Duration(1), &command.motion);
+    loop.spinControl(robot_state, Duration(1), &command.control);
+  }
+
+  franka::ControlStatistics statistics = recorder.statistics();
+  EXPECT_EQ(3u, statistics.motion_callback.count);
+  EXPECT_EQ(3u, statistics.control_callback.count);
+  EXPECT_EQ(3u, statistics.motion_command_processing.count);
+  EXPECT_EQ(3u, statistics.control_command_processing.count);
+}
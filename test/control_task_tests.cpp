@@ -0,0 +1,132 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/control_task.h>
+
+using franka::ControlArena;
+using franka::ControlPhase;
+using franka::ControlTask;
+using franka::Duration;
+using franka::RobotState;
+using franka::Torques;
+
+namespace {
+
+Torques constantTorques(double value) {
+  std::array<double, 7> tau_J{};
+  tau_J.fill(value);
+  return Torques(tau_J);
+}
+
+ControlPhase<Torques> hold(double value, int cycles) {
+  for (int i = 0; i < cycles; i++) {
+    co_yield constantTorques(value);
+  }
+}
+
+ControlPhase<Torques> nested(double value) {
+  co_await hold(value, 1);
+  co_await hold(value + 1, 1);
+}
+
+ControlPhase<Torques> failing() {
+  co_yield constantTorques(0);
+  throw std::runtime_error("phase failed");
+}
+
+ControlTask<Torques> phases(ControlArena& /* arena */, std::vector<double>& times) {
+  const RobotState* robot_state = &co_await franka::kCurrentRobotState;
+  while (robot_state->time.toMSec() < 2) {
+    times.push_back(robot_state->time.toSec());
+    robot_state = &(co_yield constantTorques(1));
+  }
+  co_await hold(2, 2);
+  co_await nested(3);
+  co_return constantTorques(5);
+}
+
+ControlTask<Torques> withFailingPhase(ControlArena& /* arena */) {
+  co_await failing();
+  co_return constantTorques(0);
+}
+
+ControlTask<Torques> onHeap() {
+  co_await hold(1, 1);
+  co_return constantTorques(2);
+}
+
+RobotState stateAt(uint64_t time_ms) {
+  RobotState robot_state;
+  robot_state.time = Duration(time_ms);
+  return robot_state;
+}
+
+}  // anonymous namespace
+
+TEST(ControlTask, RunsPhasesInOneMotion) {
+  ControlArena arena(16 * 1024);
+  std::vector<double> times;
+  times.reserve(2);
+  ControlTask<Torques> task = phases(arena, times);
+  EXPECT_GT(arena.used(), 0u);
+  size_t task_size = arena.used();
+
+  std::vector<double> expected{1, 1, 2, 2, 3, 4, 5};
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_FALSE(task.done());
+    Torques torques = task(stateAt(i), Duration(1));
+    EXPECT_EQ(expected[i], torques.tau_J[0]) << "cycle " << i;
+    EXPECT_EQ(i + 1 == expected.size(), torques.motion_finished) << "cycle " << i;
+    EXPECT_LE(task_size, arena.used());
+  }
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ(task_size, arena.used());
+  EXPECT_EQ((std::vector<double>{0.0, 0.001}), times);
+  EXPECT_THROW(task(stateAt(7), Duration(1)), std::logic_error);
+}
+
+TEST(ControlTask, PropagatesExceptionsFromPhases) {
+  ControlArena arena(16 * 1024);
+  ControlTask<Torques> task = withFailingPhase(arena);
+
+  EXPECT_EQ(0, task(stateAt(0), Duration(1)).tau_J[0]);
+  EXPECT_THROW(task(stateAt(1), Duration(1)), std::runtime_error);
+  EXPECT_TRUE(task.done());
+}
+
+TEST(ControlTask, ThrowsIfArenaIsExhausted) {
+  ControlArena arena(16);
+  std::vector<double> times;
+  EXPECT_THROW(phases(arena, times), std::bad_alloc);
+  EXPECT_EQ(0u, arena.used());
+}
+
+TEST(ControlTask, CanAllocateFromHeap) {
+  ControlTask<Torques> task = onHeap();
+  EXPECT_EQ(1, task(stateAt(0), Duration(1)).tau_J[0]);
+  Torques last = task(stateAt(1), Duration(1));
+  EXPECT_EQ(2, last.tau_J[0]);
+  EXPECT_TRUE(last.motion_finished);
+}
+
+TEST(ControlArena, ReusesMemoryInStackOrder) {
+  ControlArena arena(1024);
+  void* first = arena.allocate(10);
+  void* second = arena.allocate(10);
+  EXPECT_EQ(2 * ControlArena::kAlignment, arena.used());
+
+  arena.deallocate(first, 10);
+  EXPECT_EQ(2 * ControlArena::kAlignment, arena.used());
+  arena.deallocate(second, 10);
+  EXPECT_EQ(ControlArena::kAlignment, arena.used());
+  EXPECT_EQ(second, arena.allocate(10));
+
+  arena.reset();
+  EXPECT_EQ(0u, arena.used());
+  EXPECT_THROW(arena.allocate(2048), std::bad_alloc);
+}
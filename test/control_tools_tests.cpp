@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <franka/control_tools.h>
+
+using franka::applyRealtimeOptions;
+using franka::isolatedCpus;
+using franka::RealtimeOptions;
+using franka::RealtimeOptionsResult;
+
+TEST(RealtimeOptions, DefaultOptionsApplyNothing) {
+  RealtimeOptionsResult result;
+  std::string error_message;
+  EXPECT_TRUE(applyRealtimeOptions(RealtimeOptions(), &result, &error_message));
+  EXPECT_TRUE(error_message.empty());
+  EXPECT_FALSE(result.cpu_affinity_set);
+  EXPECT_FALSE(result.memory_locked);
+  EXPECT_FALSE(result.stack_prefaulted);
+  EXPECT_FALSE(result.heap_prefaulted);
+}
+
+TEST(RealtimeOptions, CanPrefaultStackAndHeap) {
+  RealtimeOptions options;
+  options.prefault_stack_size = 64 * 1024;
+  options.prefault_heap_size = 1024 * 1024;
+
+  RealtimeOptionsResult result;
+  std::string error_message;
+  EXPECT_TRUE(applyRealtimeOptions(options, &result, &error_message)) << error_message;
+  EXPECT_TRUE(result.stack_prefaulted);
+  EXPECT_TRUE(result.heap_prefaulted);
+  EXPECT_FALSE(result.cpu_affinity_set);
+  EXPECT_FALSE(result.memory_locked);
+}
+
+TEST(RealtimeOptions, ReportsStackPrefaultBeyondThreadStack) {
+  RealtimeOptions options;
+  options.prefault_stack_size = size_t{1} << 40;
+
+  RealtimeOptionsResult result;
+  std::string error_message;
+  EXPECT_FALSE(applyRealtimeOptions(options, &result, &error_message));
+  EXPECT_FALSE(result.stack_prefaulted);
+  EXPECT_FALSE(error_message.empty());
+}
+
+TEST(RealtimeOptions, ReportsInvalidCpuAffinity) {
+  RealtimeOptions options;
+  options.cpu_affinity = {-1};
+
+  RealtimeOptionsResult result;
+  std::string error_message;
+  EXPECT_FALSE(applyRealtimeOptions(options, &result, &error_message));
+  EXPECT_FALSE(result.cpu_affinity_set);
+  EXPECT_FALSE(error_message.empty());
+}
+
+TEST(IsolatedCpus, ReturnsSortedNonNegativeCpus) {
+  std::vector<int> cpus = isolatedCpus();
+  EXPECT_TRUE(std::is_sorted(cpus.begin(), cpus.end()));
+  EXPECT_TRUE(std::all_of(cpus.begin(), cpus.end(), [](int cpu) { return cpu >= 0; }));
+}
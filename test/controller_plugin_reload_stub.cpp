@@ -0,0 +1,24 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <string>
+
+#include <franka/controller_plugin.h>
+
+// Built twice with different CONTROLLER_PLUGIN_TORQUE values, standing in for a plugin that is
+// rebuilt while the application is running. The controller is deliberately at namespace scope, so
+// its inline functions have the same names in both builds.
+class ConstantController {
+ public:
+  explicit ConstantController(const std::string&) {}
+
+  void start(const franka::RobotState&) {}
+
+  franka::Torques update(const franka::RobotState&, franka::Duration) {
+    constexpr double kTorque = CONTROLLER_PLUGIN_TORQUE;
+    return franka::Torques(
+        std::array<double, 7>{{kTorque, kTorque, kTorque, kTorque, kTorque, kTorque, kTorque}});
+  }
+};
+
+FRANKA_CONTROLLER_PLUGIN(ConstantController, franka::Torques)
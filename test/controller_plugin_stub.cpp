@@ -0,0 +1,45 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <franka/controller_plugin.h>
+
+namespace {
+
+// Commands the torque given in the parameters plus the first joint position at start. A second
+// parameter "finish" finishes the motion, "fail" reports an error in every cycle.
+class OffsetController {
+ public:
+  explicit OffsetController(const std::string& parameters) {
+    std::istringstream stream(parameters);
+    if (!(stream >> offset_)) {
+      throw std::invalid_argument("Invalid offset");
+    }
+    stream >> mode_;
+  }
+
+  void start(const franka::RobotState& robot_state) { start_position_ = robot_state.q[0]; }
+
+  franka::Torques update(const franka::RobotState&, franka::Duration) {
+    if (mode_ == "fail") {
+      throw std::runtime_error("Failure requested");
+    }
+    double torque = offset_ + start_position_;
+    franka::Torques output(
+        std::array<double, 7>{{torque, torque, torque, torque, torque, torque, torque}});
+    output.motion_finished = mode_ == "finish";
+    return output;
+  }
+
+ private:
+  double offset_{0};
+  std::string mode_;
+  double start_position_{0};
+};
+
+}  // anonymous namespace
+
+FRANKA_CONTROLLER_PLUGIN(OffsetController, franka::Torques)
@@ -0,0 +1,128 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <franka/controller_plugin.h>
+#include <franka/exception.h>
+
+#include "allocation_tracker.h"
+
+using franka::Duration;
+using franka::PluginController;
+using franka::RobotState;
+using franka::Torques;
+
+namespace {
+
+std::string pluginPath() {
+  using namespace std::string_literals;
+  return FRANKA_TEST_BINARY_DIR + "/libcontroller_plugin_stub.so"s;
+}
+
+std::string reloadPluginPath(int version) {
+  using namespace std::string_literals;
+  return FRANKA_TEST_BINARY_DIR + "/libcontroller_plugin_reload_stub_v"s +
+         std::to_string(version) + ".so";
+}
+
+}  // anonymous namespace
+
+TEST(PluginController, RunsPluginController) {
+  PluginController<Torques> controller(pluginPath(), "2");
+  RobotState robot_state{};
+  robot_state.q[0] = 0.5;
+
+  Torques output = controller(robot_state, Duration(0));
+  EXPECT_EQ(2.5, output.tau_J[0]);
+  EXPECT_EQ(2.5, output.tau_J[6]);
+  EXPECT_FALSE(output.motion_finished);
+
+  // The start position is only taken over in the first cycle.
+  robot_state.q[0] = 1;
+  EXPECT_EQ(2.5, controller(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_EQ(0u, controller.swaps());
+}
+
+TEST(PluginController, SwapsInNextCycle) {
+  PluginController<Torques> controller(pluginPath(), "2");
+  RobotState robot_state{};
+  EXPECT_EQ(2, controller(robot_state, Duration(0)).tau_J[0]);
+
+  controller.load(pluginPath(), "3");
+  EXPECT_TRUE(controller.swapPending());
+  EXPECT_EQ(0u, controller.swaps());
+
+  // The new controller is started with the state of the cycle in which it takes over.
+  robot_state.q[0] = 1;
+  EXPECT_EQ(4, controller(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_FALSE(controller.swapPending());
+  EXPECT_EQ(1u, controller.swaps());
+
+  // Loading again collects the replaced controller.
+  controller.load(pluginPath(), "5");
+  EXPECT_EQ(6, controller(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_EQ(2u, controller.swaps());
+}
+
+TEST(PluginController, DiscardsControllerThatHasNotTakenOver) {
+  PluginController<Torques> controller(pluginPath(), "2");
+  RobotState robot_state{};
+  controller.load(pluginPath(), "3");
+  controller.load(pluginPath(), "4");
+  EXPECT_EQ(4, controller(robot_state, Duration(0)).tau_J[0]);
+  EXPECT_EQ(1u, controller.swaps());
+}
+
+TEST(PluginController, RunsRebuiltPluginAfterReload) {
+  PluginController<Torques> controller(reloadPluginPath(1));
+  RobotState robot_state{};
+  EXPECT_EQ(1, controller(robot_state, Duration(0)).tau_J[0]);
+
+  controller.load(reloadPluginPath(2));
+  EXPECT_EQ(2, controller(robot_state, Duration(1)).tau_J[0]);
+
+  // Loading again unloads the first library, which must not affect the controllers of the second.
+  controller.load(reloadPluginPath(2));
+  EXPECT_EQ(2, controller(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_EQ(2u, controller.swaps());
+}
+
+TEST(PluginController, SwapsWithoutAllocations) {
+  PluginController<Torques> controller(pluginPath(), "2");
+  RobotState robot_state{};
+  controller(robot_state, Duration(0));
+  controller.load(pluginPath(), "3");
+
+  franka::AllocationTrackingScope allocation_tracking;
+  for (size_t i = 0; i < 10; i++) {
+    controller(robot_state, Duration(1));
+  }
+  EXPECT_EQ(1u, controller.swaps());
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(PluginController, KeepsActiveControllerIfLoadingFails) {
+  PluginController<Torques> controller(pluginPath(), "2");
+  RobotState robot_state{};
+
+  EXPECT_THROW(controller.load(pluginPath(), "invalid"), franka::PluginException);
+  EXPECT_THROW(controller.load(pluginPath() + ".missing"), franka::PluginException);
+  EXPECT_FALSE(controller.swapPending());
+  EXPECT_EQ(2, controller(robot_state, Duration(0)).tau_J[0]);
+}
+
+TEST(PluginController, ForwardsMotionFinishedAndErrors) {
+  PluginController<Torques> controller(pluginPath(), "2 finish");
+  RobotState robot_state{};
+  EXPECT_TRUE(controller(robot_state, Duration(0)).motion_finished);
+
+  controller.load(pluginPath(), "2 fail");
+  EXPECT_THROW(controller(robot_state, Duration(1)), franka::PluginException);
+}
+
+TEST(PluginController, RejectsPluginWithOtherOutput) {
+  EXPECT_THROW(PluginController<franka::CartesianVelocities>(pluginPath(), "2"),
+               franka::PluginException);
+}
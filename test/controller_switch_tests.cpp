@@ -0,0 +1,102 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/controller_switch.h>
+
+#include "allocation_tracker.h"
+
+using franka::ControllerSwitch;
+using franka::Duration;
+using franka::RobotState;
+using franka::Torques;
+
+namespace {
+
+Torques constantTorques(double value) {
+  return Torques(std::array<double, 7>{{value, value, value, value, value, value, value}});
+}
+
+}  // anonymous namespace
+
+TEST(ControllerSwitch, SwitchesInNextCycle) {
+  ControllerSwitch<Torques> controllers;
+  std::vector<size_t> activations;
+  size_t first = controllers.add([](const RobotState&, Duration) { return constantTorques(1); },
+                                 [&](const RobotState&) { activations.push_back(0); });
+  size_t second = controllers.add([&](const RobotState&, Duration) {
+    // Switching from within a callback affects only the next cycle.
+    controllers.select(first);
+    return constantTorques(2);
+  });
+  ASSERT_EQ(0u, first);
+  ASSERT_EQ(1u, second);
+  ASSERT_EQ(2u, controllers.size());
+
+  RobotState robot_state{};
+  EXPECT_EQ(1, controllers(robot_state, Duration(0)).tau_J[0]);
+  EXPECT_EQ(1, controllers(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_EQ(std::vector<size_t>{0}, activations);
+
+  controllers.select(second);
+  EXPECT_EQ(second, controllers.selected());
+  EXPECT_EQ(first, controllers.active());
+  EXPECT_EQ(2, controllers(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_EQ(second, controllers.active());
+  EXPECT_EQ(first, controllers.selected());
+
+  EXPECT_EQ(1, controllers(robot_state, Duration(1)).tau_J[0]);
+  EXPECT_EQ((std::vector<size_t>{0, 0}), activations);
+}
+
+TEST(ControllerSwitch, ActivatesSelectedControllerInNewControlLoop) {
+  ControllerSwitch<franka::JointVelocities> controllers;
+  RobotState activation_state{};
+  size_t activations = 0;
+  controllers.add(
+      [](const RobotState&, Duration) { return franka::JointVelocities(std::array<double, 7>{}); },
+      [&](const RobotState& robot_state) {
+        activation_state = robot_state;
+        activations++;
+      });
+
+  RobotState robot_state{};
+  robot_state.q.fill(0.5);
+  controllers(robot_state, Duration(0));
+  controllers(robot_state, Duration(1));
+  EXPECT_EQ(1u, activations);
+  EXPECT_EQ(robot_state.q, activation_state.q);
+
+  controllers(robot_state, Duration(0));
+  EXPECT_EQ(2u, activations);
+}
+
+TEST(ControllerSwitch, SwitchingDoesNotAllocate) {
+  ControllerSwitch<Torques> controllers;
+  controllers.add([](const RobotState&, Duration) { return constantTorques(1); });
+  controllers.add([](const RobotState&, Duration) { return constantTorques(2); });
+  RobotState robot_state{};
+
+  franka::AllocationTrackingScope allocation_tracking;
+  for (size_t i = 0; i < 10; i++) {
+    controllers.select(i % 2);
+    controllers(robot_state, Duration(1));
+  }
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(ControllerSwitch, ThrowsForInvalidControllers) {
+  ControllerSwitch<Torques> controllers;
+  RobotState robot_state{};
+  EXPECT_THROW(controllers(robot_state, Duration(0)), std::invalid_argument);
+  EXPECT_THROW(controllers.add({}), std::invalid_argument);
+  EXPECT_THROW(controllers.select(0), std::invalid_argument);
+
+  controllers.add([](const RobotState&, Duration) { return constantTorques(1); });
+  EXPECT_NO_THROW(controllers.select(0));
+  EXPECT_THROW(controllers.select(1), std::invalid_argument);
+}
@@ -0,0 +1,207 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <franka/datagram_recorder.h>
+#include <franka/datagram_replay.h>
+#include <franka/exception.h>
+#include <franka/robot.h>
+#include <research_interface/robot/rbk_types.h>
+#include <research_interface/robot/service_types.h>
+
+#include "datagram_recording.h"
+
+using franka::DatagramRecorder;
+using franka::DatagramReplay;
+using franka::DatagramType;
+using franka::Duration;
+using franka::RobotState;
+
+namespace robot = research_interface::robot;
+
+namespace {
+
+class TemporaryFile {
+ public:
+  explicit TemporaryFile(const std::string& name)
+      : path_("/tmp/libfranka_" + name + "_" + std::to_string(getpid()) + ".bin") {}
+  ~TemporaryFile() { std::remove(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+std::vector<char> readFile(const std::string& path) {
+  std::ifstream stream(path, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(stream),
+                           std::istreambuf_iterator<char>());
+}
+
+robot::RobotState createState(uint64_t message_id, bool moving) {
+  robot::RobotState robot_state{};
+  robot_state.message_id = message_id;
+  robot_state.robot_mode = moving ? robot::RobotMode::kMove : robot::RobotMode::kIdle;
+  robot_state.motion_generator_mode =
+      moving ? robot::MotionGeneratorMode::kJointVelocity : robot::MotionGeneratorMode::kIdle;
+  robot_state.controller_mode =
+      moving ? robot::ControllerMode::kExternalController : robot::ControllerMode::kJointImpedance;
+  robot_state.q[0] = static_cast<double>(message_id);
+  return robot_state;
+}
+
+// Records two idle states, followed by a torque controlled motion over the given number of states
+// and another idle state.
+void recordMotion(const std::string& path, uint64_t motion_states) {
+  DatagramRecorder recorder(path);
+  auto time = std::chrono::system_clock::now();
+  for (uint64_t message_id = 1; message_id <= motion_states + 3; message_id++) {
+    bool moving = message_id > 2 && message_id < motion_states + 3;
+    robot::RobotState robot_state = createState(message_id, moving);
+    EXPECT_TRUE(recordRawDatagram(recorder, DatagramType::kRobotState,
+                                  reinterpret_cast<const uint8_t*>(&robot_state),
+                                  sizeof(robot_state), time));
+    time += std::chrono::milliseconds(1);
+  }
+}
+
+uint64_t runTorqueController(franka::Robot& robot, double torque) {
+  uint64_t cycles = 0;
+  robot.control([&](const RobotState&, Duration) -> franka::Torques {
+    franka::Torques torques{{torque, 0, 0, 0, 0, 0, 0}};
+    cycles++;
+    if (cycles == 3) {
+      return franka::MotionFinished(torques);
+    }
+    return torques;
+  });
+  return cycles;
+}
+
+}  // anonymous namespace
+
+TEST(DatagramRecorder, WritesHeaderAndRecords) {
+  TemporaryFile file("datagram_recorder");
+  auto time = std::chrono::system_clock::time_point(std::chrono::nanoseconds(123456789));
+  {
+    DatagramRecorder recorder(file.path());
+    robot::RobotState robot_state = createState(42, false);
+    robot::RobotCommand robot_command{};
+    robot_command.message_id = 42;
+    EXPECT_TRUE(recordRawDatagram(recorder, DatagramType::kRobotState,
+                                  reinterpret_cast<const uint8_t*>(&robot_state),
+                                  sizeof(robot_state), time));
+    EXPECT_TRUE(recordRawDatagram(recorder, DatagramType::kRobotCommand,
+                                  reinterpret_cast<const uint8_t*>(&robot_command),
+                                  sizeof(robot_command), time));
+    recorder.stop();
+    EXPECT_EQ(2u, recorder.writtenDatagrams());
+    EXPECT_EQ(0u, recorder.droppedDatagrams());
+
+    EXPECT_FALSE(recordRawDatagram(recorder, DatagramType::kRobotState,
+                                   reinterpret_cast<const uint8_t*>(&robot_state),
+                                   sizeof(robot_state), time));
+    EXPECT_EQ(1u, recorder.droppedDatagrams());
+  }
+
+  std::vector<char> data = readFile(file.path());
+  franka::DatagramRecordingHeader header;
+  franka::DatagramRecordHeader record;
+  ASSERT_EQ(sizeof(header) + 2 * sizeof(record) + sizeof(robot::RobotState) +
+                sizeof(robot::RobotCommand),
+            data.size());
+
+  std::memcpy(&header, data.data(), sizeof(header));
+  EXPECT_EQ(0, std::memcmp(header.magic, "FRANKUDP", sizeof(header.magic)));
+  EXPECT_EQ(DatagramRecorder::kFormatVersion, header.version);
+  EXPECT_EQ(robot::kVersion, header.protocol_version);
+  EXPECT_EQ(sizeof(robot::RobotState), header.state_size);
+  EXPECT_EQ(sizeof(robot::RobotCommand), header.command_size);
+
+  std::memcpy(&record, data.data() + sizeof(header), sizeof(record));
+  EXPECT_EQ(static_cast<uint32_t>(DatagramType::kRobotState), record.type);
+  EXPECT_EQ(sizeof(robot::RobotState), record.size);
+  EXPECT_EQ(123456789, record.time);
+  robot::RobotState robot_state;
+  std::memcpy(&robot_state, data.data() + sizeof(header) + sizeof(record), sizeof(robot_state));
+  EXPECT_EQ(42u, robot_state.message_id);
+
+  std::memcpy(&record, data.data() + sizeof(header) + sizeof(record) + sizeof(robot_state),
+              sizeof(record));
+  EXPECT_EQ(static_cast<uint32_t>(DatagramType::kRobotCommand), record.type);
+  EXPECT_EQ(sizeof(robot::RobotCommand), record.size);
+}
+
+TEST(DatagramReplay, ThrowsIfFileIsNoRecording) {
+  TemporaryFile file("datagram_replay_invalid");
+  {
+    std::ofstream stream(file.path(), std::ios::binary);
+    stream << "This is not a datagram recording, but long enough to contain a header.";
+  }
+  EXPECT_THROW(DatagramReplay replay(file.path()), franka::Exception);
+}
+
+TEST(DatagramReplay, PlaysBackRecordedStates) {
+  TemporaryFile file("datagram_replay_states");
+  recordMotion(file.path(), 0);
+
+  DatagramReplay replay(file.path());
+  EXPECT_EQ(3u, replay.recordedStates());
+
+  franka::Robot robot(replay);
+  EXPECT_EQ(1u, replay.replayedStates());
+  for (uint64_t message_id = 2; message_id <= 3; message_id++) {
+    RobotState robot_state = robot.readOnce();
+    EXPECT_EQ(message_id, robot_state.time.toMSec());
+    EXPECT_EQ(static_cast<double>(message_id), robot_state.q[0]);
+    EXPECT_EQ(message_id, replay.replayedStates());
+  }
+
+  EXPECT_THROW(robot.readOnce(), franka::NetworkException);
+}
+
+TEST(DatagramReplay, ReplaysMotionsDeterministically) {
+  TemporaryFile states_file("datagram_replay_motion_states");
+  TemporaryFile session_file("datagram_replay_motion_session");
+  recordMotion(states_file.path(), 4);
+
+  // Run a controller against the recorded states and record the session, including its commands.
+  {
+    DatagramReplay replay(states_file.path());
+    franka::Robot robot(replay);
+    auto recorder = std::make_shared<DatagramRecorder>(session_file.path());
+    robot.setDatagramRecorder(recorder);
+    EXPECT_EQ(3u, runTorqueController(robot, 1.0));
+    robot.setDatagramRecorder(nullptr);
+    recorder->stop();
+    EXPECT_EQ(0u, recorder->droppedDatagrams());
+    EXPECT_LT(0u, replay.divergentCommands());
+  }
+
+  // The same controller sends the same commands for the same states.
+  {
+    DatagramReplay replay(session_file.path());
+    franka::Robot robot(replay);
+    EXPECT_EQ(3u, runTorqueController(robot, 1.0));
+    EXPECT_EQ(0u, replay.divergentCommands());
+  }
+
+  // A changed controller is detected.
+  {
+    DatagramReplay replay(session_file.path());
+    franka::Robot robot(replay);
+    EXPECT_EQ(3u, runTorqueController(robot, 2.0));
+    EXPECT_LT(0u, replay.divergentCommands());
+  }
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "deadline_worker.h"
+
+using franka::DeadlineResult;
+using franka::DeadlineWorker;
+using franka::Duration;
+using franka::RobotState;
+
+namespace {
+
+// Long enough for a returning callback to be on time on a loaded machine.
+constexpr std::chrono::milliseconds kBudget{50};
+
+}  // anonymous namespace
+
+TEST(DeadlineWorker, ReturnsOutputWithinBudget) {
+  DeadlineWorker<uint64_t>::Callback callback = [](const RobotState& robot_state,
+                                                   Duration time_step) {
+    return robot_state.time.toMSec() + 10 * time_step.toMSec();
+  };
+  DeadlineWorker<uint64_t> worker(callback, kBudget);
+
+  RobotState robot_state;
+  robot_state.time = Duration(3);
+  uint64_t output = 0;
+  EXPECT_EQ(DeadlineResult::kOnTime, worker.call(robot_state, Duration(1), &output));
+  EXPECT_EQ(13u, output);
+}
+
+TEST(DeadlineWorker, SkipsStatesWhileCallbackIsLate) {
+  std::atomic<bool> block{true};
+  std::atomic<uint64_t> last_time_step{0};
+  DeadlineWorker<int>::Callback callback = [&](const RobotState&, Duration time_step) {
+    last_time_step = time_step.toMSec();
+    while (block) {
+      std::this_thread::yield();
+    }
+    return 1;
+  };
+  DeadlineWorker<int> worker(callback, kBudget);
+
+  int output = 0;
+  EXPECT_EQ(DeadlineResult::kLate, worker.call(RobotState(), Duration(1), &output));
+  EXPECT_EQ(DeadlineResult::kBusy, worker.call(RobotState(), Duration(1), &output));
+  EXPECT_EQ(DeadlineResult::kBusy, worker.call(RobotState(), Duration(1), &output));
+  EXPECT_EQ(0, output);
+  EXPECT_EQ(1u, last_time_step);
+
+  // The late output is discarded, and the next state carries the time of the skipped ones.
+  block = false;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  DeadlineResult result;
+  while ((result = worker.call(RobotState(), Duration(1), &output)) == DeadlineResult::kBusy) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  EXPECT_EQ(DeadlineResult::kOnTime, result);
+  EXPECT_EQ(1, output);
+  EXPECT_GE(last_time_step, 3u);
+}
+
+TEST(DeadlineWorker, RethrowsErrorsOfLateCalls) {
+  std::atomic<bool> block{true};
+  DeadlineWorker<int>::Callback callback = [&](const RobotState&, Duration) -> int {
+    while (block) {
+      std::this_thread::yield();
+    }
+    throw std::runtime_error("callback failed");
+  };
+  DeadlineWorker<int> worker(callback, kBudget);
+
+  int output = 0;
+  EXPECT_EQ(DeadlineResult::kLate, worker.call(RobotState(), Duration(1), &output));
+  block = false;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  EXPECT_THROW(
+      while (worker.call(RobotState(), Duration(1), &output) == DeadlineResult::kBusy) {
+        ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      },
+      std::runtime_error);
+}
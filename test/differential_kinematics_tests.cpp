@@ -0,0 +1,156 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+#include <franka/differential_kinematics.h>
+#include <franka/kinematics.h>
+
+#include "allocation_tracker.h"
+
+using franka::DifferentialKinematics;
+using franka::DifferentialKinematicsOptions;
+using franka::Frame;
+using franka::JointVelocities;
+using franka::PandaKinematics;
+
+namespace {
+
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+constexpr std::array<double, 7> kReady{{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+
+Vector6d taskVelocity(const std::array<double, 42>& jacobian, const JointVelocities& output) {
+  return Eigen::Map<const Matrix6x7d>(jacobian.data()) *
+         Eigen::Map<const Vector7d>(output.dq.data());
+}
+
+}  // anonymous namespace
+
+TEST(DifferentialKinematics, TracksVelocityAwayFromSingularities) {
+  std::array<double, 7> q{{0.3, -0.5, 0.2, -2.0, 0.1, 1.8, 0.5}};
+  std::array<double, 42> jacobian = PandaKinematics::zeroJacobian(Frame::kFlange, q);
+  std::array<double, 6> velocity{{0.05, -0.02, 0.03, 0.1, 0, -0.05}};
+
+  DifferentialKinematics kinematics;
+  JointVelocities output = kinematics.compute(jacobian, q, velocity);
+
+  EXPECT_GT(kinematics.manipulability(), DifferentialKinematicsOptions().manipulability_threshold);
+  EXPECT_EQ(0, kinematics.damping());
+  EXPECT_EQ(1, kinematics.velocityScaling());
+  // The posture term runs in the null space and does not disturb the end effector.
+  EXPECT_TRUE(taskVelocity(jacobian, output).isApprox(Vector6d(velocity.data()), 1e-9));
+}
+
+TEST(DifferentialKinematics, MovesTowardsPostureInNullSpace) {
+  std::array<double, 7> q{{0.3, -0.5, 0.2, -2.0, 0.1, 1.8, 0.5}};
+  std::array<double, 42> jacobian = PandaKinematics::zeroJacobian(Frame::kFlange, q);
+
+  DifferentialKinematicsOptions options;
+  options.posture = kReady;
+  DifferentialKinematics kinematics(options);
+  JointVelocities output = kinematics.compute(jacobian, q, {});
+
+  Vector7d dq(output.dq.data());
+  Vector7d to_posture = Vector7d(kReady.data()) - Vector7d(q.data());
+  EXPECT_GT(dq.norm(), 0);
+  EXPECT_GT(dq.dot(to_posture), 0);
+  EXPECT_LT(taskVelocity(jacobian, output).norm(), 1e-9);
+}
+
+TEST(DifferentialKinematics, DampsNearSingularities) {
+  // Almost stretched arm with almost aligned wrist.
+  std::array<double, 7> q{{0, 0, 0, -0.2, 0, 0.2, 0}};
+  std::array<double, 42> jacobian = PandaKinematics::zeroJacobian(Frame::kFlange, q);
+  std::array<double, 6> velocity{{0, 0, 0.1, 0, 0, 0}};
+
+  DifferentialKinematicsOptions options;
+  options.posture_gain = 0;
+  options.joint_limit_gain = 0;
+  options.max_joint_velocity.fill(1e9);
+  DifferentialKinematics kinematics(options);
+  JointVelocities output = kinematics.compute(jacobian, q, velocity);
+
+  EXPECT_LT(kinematics.manipulability(), options.manipulability_threshold);
+  EXPECT_GT(kinematics.damping(), 0);
+  EXPECT_LE(kinematics.damping(), options.max_damping);
+
+  // The undamped pseudoinverse needs more than twice the joint velocities.
+  Matrix6x7d J(jacobian.data());
+  Vector7d undamped =
+      J.transpose() * (J * J.transpose()).fullPivLu().solve(Vector6d(velocity.data()));
+  Vector7d dq(output.dq.data());
+  EXPECT_TRUE(dq.allFinite());
+  EXPECT_LT(dq.norm(), 0.5 * undamped.norm());
+}
+
+TEST(DifferentialKinematics, AvoidsJointLimits) {
+  std::array<double, 7> q{{0.3, -0.5, 0.2, -2.0, 0.1, 1.8, 0.5}};
+  q[0] = franka::kMaxJointPosition[0] - 0.05;
+  std::array<double, 42> jacobian = PandaKinematics::zeroJacobian(Frame::kFlange, q);
+
+  DifferentialKinematicsOptions options;
+  options.posture_gain = 0;
+  DifferentialKinematics kinematics(options);
+  JointVelocities output = kinematics.compute(jacobian, q, {});
+  EXPECT_LT(output.dq[0], 0);
+  EXPECT_LT(taskVelocity(jacobian, output).norm(), 1e-9);
+
+  q[0] = 0.3;
+  output = kinematics.compute(PandaKinematics::zeroJacobian(Frame::kFlange, q), q, {});
+  EXPECT_EQ(0, Vector7d(output.dq.data()).norm());
+}
+
+TEST(DifferentialKinematics, ScalesToVelocityLimits) {
+  std::array<double, 7> q{{0.3, -0.5, 0.2, -2.0, 0.1, 1.8, 0.5}};
+  std::array<double, 42> jacobian = PandaKinematics::zeroJacobian(Frame::kFlange, q);
+  std::array<double, 6> velocity{{5, 0, 0, 0, 0, 0}};
+
+  DifferentialKinematicsOptions options;
+  options.posture_gain = 0;
+  DifferentialKinematics kinematics(options);
+  JointVelocities output = kinematics.compute(jacobian, q, velocity);
+
+  EXPECT_LT(kinematics.velocityScaling(), 1);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_LE(std::abs(output.dq[i]), options.max_joint_velocity[i] + 1e-12);
+  }
+  // The direction of the end effector motion is kept.
+  Vector6d expected = kinematics.velocityScaling() * Vector6d(velocity.data());
+  EXPECT_TRUE(taskVelocity(jacobian, output).isApprox(expected, 1e-9));
+}
+
+TEST(DifferentialKinematics, ComputeDoesNotAllocate) {
+  std::array<double, 7> q{{0, 0, 0, -0.07, 0, 0.07, 0}};
+  std::array<double, 42> jacobian = PandaKinematics::zeroJacobian(Frame::kFlange, q);
+  DifferentialKinematics kinematics;
+
+  franka::AllocationTrackingScope allocation_tracking;
+  kinematics.compute(jacobian, q, {{0.1, 0, 0, 0, 0, 0}});
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(DifferentialKinematics, ThrowsOnInvalidParameters) {
+  DifferentialKinematicsOptions negative_damping;
+  negative_damping.max_damping = -1;
+  EXPECT_THROW(DifferentialKinematics{negative_damping}, std::invalid_argument);
+
+  DifferentialKinematicsOptions zero_threshold;
+  zero_threshold.manipulability_threshold = 0;
+  EXPECT_THROW(DifferentialKinematics{zero_threshold}, std::invalid_argument);
+
+  DifferentialKinematicsOptions swapped_limits;
+  swapped_limits.min_joint_position[2] = 3;
+  EXPECT_THROW(DifferentialKinematics{swapped_limits}, std::invalid_argument);
+
+  DifferentialKinematicsOptions negative_velocity;
+  negative_velocity.max_joint_velocity[6] = -1;
+  EXPECT_THROW(DifferentialKinematics{negative_velocity}, std::invalid_argument);
+}
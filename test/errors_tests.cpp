@@ -1,5 +1,7 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <franka/errors.h>
@@ -47,3 +49,64 @@ TEST(Errors, CanBeStreamed) {
 
   EXPECT_EQ("[]", output);
 }
+
+TEST(Errors, PacksFlagsIntoBits) {
+  std::array<bool, sizeof(research_interface::robot::RobotState::errors)> error_flags{};
+  error_flags[static_cast<size_t>(research_interface::robot::Error::kJointReflex)] = true;
+  error_flags[static_cast<size_t>(
+      research_interface::robot::Error::kBaseAccelerationInvalidReading)] = true;
+
+  franka::Errors errors(error_flags);
+
+  EXPECT_TRUE(errors.any());
+  EXPECT_EQ(
+      (uint64_t{1} << static_cast<size_t>(research_interface::robot::Error::kJointReflex)) |
+          (uint64_t{1} << static_cast<size_t>(
+               research_interface::robot::Error::kBaseAccelerationInvalidReading)),
+      errors.bits());
+  EXPECT_FALSE(franka::Errors().any());
+  EXPECT_EQ(0u, franka::Errors().bits());
+}
+
+TEST(Errors, CanBeCreatedFromBits) {
+  franka::Errors errors(uint64_t{1} << static_cast<size_t>(
+                            research_interface::robot::Error::kSelfcollisionAvoidanceViolation));
+
+  EXPECT_TRUE(errors.self_collision_avoidance_violation);
+  EXPECT_FALSE(errors.joint_position_limits_violation);
+  EXPECT_EQ(R"(["self_collision_avoidance_violation"])", static_cast<std::string>(errors));
+
+  franka::Errors all(~uint64_t{0});
+  EXPECT_EQ((uint64_t{1} << franka::Errors::kCount) - 1, all.bits());
+}
+
+TEST(Errors, KeepsBitsOnCopyAndAssignment) {
+  franka::Errors errors(uint64_t{0b1010});
+  franka::Errors copy(errors);
+  franka::Errors assigned;
+  assigned = errors;
+
+  EXPECT_EQ(errors, copy);
+  EXPECT_EQ(errors, assigned);
+  EXPECT_TRUE(assigned.self_collision_avoidance_violation);
+  EXPECT_TRUE(assigned.cartesian_position_limits_violation);
+}
+
+TEST(Errors, ReportsChangedFlags) {
+  franka::Errors before(uint64_t{0b0110});
+  franka::Errors after(uint64_t{0b0011});
+
+  EXPECT_EQ(0b0101u, before.changed(after));
+  EXPECT_EQ(0u, before.changed(before));
+  EXPECT_NE(before, after);
+}
+
+TEST(Errors, IteratesOverSetFlags) {
+  franka::Errors errors((uint64_t{1} << 2) | (uint64_t{1} << 17) | (uint64_t{1} << 40));
+
+  std::vector<size_t> indices;
+  errors.forEach([&indices](size_t index) { indices.push_back(index); });
+
+  EXPECT_EQ((std::vector<size_t>{2, 17, 40}), indices);
+  EXPECT_STREQ("self_collision_avoidance_violation", franka::Errors::name(2));
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <future>
+#include <memory>
+
+#include <gmock/gmock.h>
+
+#include <franka/event_loop.h>
+#include <franka/exception.h>
+#include <franka/gripper.h>
+#include <research_interface/gripper/types.h>
+
+#include "helpers.h"
+#include "mock_server.h"
+
+using franka::EventLoop;
+using franka::Gripper;
+using franka::InvalidOperationException;
+using franka::RealtimeConfig;
+
+using research_interface::gripper::Homing;
+using research_interface::gripper::Move;
+
+TEST(EventLoop, CanAttachAndDetachGripper) {
+  EventLoop event_loop(RealtimeConfig::kIgnore);
+  EXPECT_EQ(0u, event_loop.size());
+
+  {
+    GripperMockServer server;
+    Gripper gripper("127.0.0.1");
+    event_loop.attach(gripper);
+    EXPECT_EQ(1u, event_loop.size());
+
+    // Attaching twice to the same event loop has no effect.
+    event_loop.attach(gripper);
+    EXPECT_EQ(1u, event_loop.size());
+
+    EventLoop other_event_loop(RealtimeConfig::kIgnore);
+    EXPECT_THROW(other_event_loop.attach(gripper), InvalidOperationException);
+  }
+  EXPECT_EQ(0u, event_loop.size());
+}
+
+TEST(EventLoop, CanReceiveResponsesOfAttachedGripper) {
+  GripperMockServer server;
+  Gripper gripper("127.0.0.1");
+  EventLoop event_loop(RealtimeConfig::kIgnore);
+  event_loop.attach(gripper);
+
+  server
+      .waitForCommand<Homing>(
+          [](const Homing::Request&) { return Homing::Response(Homing::Status::kSuccess); })
+      .spinOnce();
+  EXPECT_TRUE(gripper.homing());
+
+  server
+      .waitForCommand<Move>(
+          [](const Move::Request&) { return Move::Response(Move::Status::kUnsuccessful); })
+      .spinOnce();
+  std::future<bool> result = gripper.moveAsync(0.05, 0.1);
+  EXPECT_FALSE(result.get());
+}
+
+TEST(EventLoop, GripperOutlivesEventLoop) {
+  GripperMockServer server;
+  Gripper gripper("127.0.0.1");
+  {
+    EventLoop event_loop(RealtimeConfig::kIgnore);
+    event_loop.attach(gripper);
+  }
+
+  server
+      .waitForCommand<Homing>(
+          [](const Homing::Request&) { return Homing::Response(Homing::Status::kSuccess); })
+      .spinOnce();
+  EXPECT_TRUE(gripper.homing());
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <franka/exception.h>
+#include <franka/flight_recorder.h>
+#include <research_interface/robot/rbk_types.h>
+
+using franka::FlightRecorder;
+using franka::Record;
+
+namespace robot = research_interface::robot;
+
+namespace {
+
+class TemporaryFile {
+ public:
+  explicit TemporaryFile(const std::string& name)
+      : path_("/tmp/libfranka_" + name + "_" + std::to_string(getpid()) + ".bin") {}
+  ~TemporaryFile() { std::remove(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+void recordSamples(FlightRecorder& recorder, uint64_t first, uint64_t count) {
+  for (uint64_t message_id = first; message_id < first + count; message_id++) {
+    robot::RobotState robot_state{};
+    robot_state.message_id = message_id;
+    robot_state.q[0] = static_cast<double>(message_id);
+    robot::RobotCommand robot_command{};
+    robot_command.message_id = message_id;
+    robot_command.control.tau_J_d[1] = static_cast<double>(message_id) / 2;
+    franka::recordRawFlightSample(recorder, robot_state, robot_command);
+  }
+}
+
+}  // anonymous namespace
+
+TEST(FlightRecorder, RecoversSamplesInOrder) {
+  TemporaryFile file("flight_recorder_order");
+  FlightRecorder recorder(file.path(), 16);
+  EXPECT_EQ(16u, recorder.capacity());
+  EXPECT_TRUE(franka::readFlightRecording(file.path()).empty());
+
+  recordSamples(recorder, 1, 5);
+  EXPECT_EQ(5u, recorder.committedSamples());
+  std::vector<Record> records = franka::readFlightRecording(file.path());
+  ASSERT_EQ(5u, records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(i + 1, records[i].state.time.toMSec());
+    EXPECT_EQ(static_cast<double>(i + 1), records[i].state.q[0]);
+    EXPECT_EQ(static_cast<double>(i + 1) / 2, records[i].command.torques.tau_J[1]);
+  }
+}
+
+TEST(FlightRecorder, KeepsLastSamplesWhenFull) {
+  TemporaryFile file("flight_recorder_full");
+  FlightRecorder recorder(file.path(), 16);
+  recordSamples(recorder, 1, 40);
+
+  std::vector<Record> records = franka::readFlightRecording(file.path());
+  ASSERT_EQ(15u, records.size());
+  EXPECT_EQ(26u, records.front().state.time.toMSec());
+  EXPECT_EQ(40u, records.back().state.time.toMSec());
+}
+
+TEST(FlightRecorder, SurvivesKilledProcess) {
+  TemporaryFile file("flight_recorder_killed");
+  pid_t child = fork();
+  ASSERT_LE(0, child);
+  if (child == 0) {
+    FlightRecorder recorder(file.path(), 100);
+    recordSamples(recorder, 1, 42);
+    // Neither destructors nor exit handlers run.
+    std::raise(SIGKILL);
+  }
+  int status = 0;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  ASSERT_TRUE(WIFSIGNALED(status));
+
+  std::vector<Record> records = franka::readFlightRecording(file.path());
+  ASSERT_EQ(42u, records.size());
+  EXPECT_EQ(42u, records.back().state.time.toMSec());
+}
+
+TEST(FlightRecorder, ThrowsForInvalidCapacity) {
+  TemporaryFile file("flight_recorder_capacity");
+  EXPECT_THROW(FlightRecorder(file.path(), 1), franka::Exception);
+}
+
+TEST(FlightRecorder, ThrowsIfFileIsNoRecording) {
+  TemporaryFile file("flight_recorder_invalid");
+  {
+    std::ofstream stream(file.path(), std::ios::binary);
+    stream << "This is not a flight recording, but long enough to contain a header........";
+  }
+  EXPECT_THROW(franka::readFlightRecording(file.path()), franka::Exception);
+  EXPECT_THROW(franka::readFlightRecording(file.path() + ".missing"), franka::Exception);
+}
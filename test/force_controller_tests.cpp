@@ -0,0 +1,161 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <Eigen/Core>
+
+#include <franka/force_controller.h>
+#include <franka/rate_limiting.h>
+
+#include "allocation_tracker.h"
+
+using franka::ForceController;
+using franka::ForceControllerParameters;
+using franka::ForceMeasurement;
+using franka::RobotState;
+
+namespace {
+
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+
+std::array<double, 42> identityJacobian() {
+  std::array<double, 42> jacobian;
+  Eigen::Map<Matrix6x7d>(jacobian.data()) = Matrix6x7d::Identity();
+  return jacobian;
+}
+
+std::array<double, 42> randomJacobian() {
+  std::array<double, 42> jacobian;
+  Eigen::Map<Matrix6x7d>(jacobian.data()) = Matrix6x7d::Random();
+  return jacobian;
+}
+
+}  // anonymous namespace
+
+TEST(ForceController, CommandsFeedForwardWithoutError) {
+  ForceController controller;
+  controller.setTarget({{0, 0, -9.81, 0, 0, 0}});
+  RobotState robot_state{};
+  robot_state.O_F_ext_hat_K = {{0, 0, 9.81, 0, 0, 0}};
+
+  std::array<double, 7> tau_d = controller.update(robot_state, identityJacobian());
+  EXPECT_NEAR(-9.81, controller.measuredWrench()[2], 1e-12);
+  EXPECT_NEAR(-9.81, controller.commandedWrench()[2], 1e-12);
+  EXPECT_NEAR(-9.81, tau_d[2], 1e-12);
+  EXPECT_EQ(0.0, tau_d[6]);
+}
+
+TEST(ForceController, IntegratesErrorWithClamping) {
+  ForceControllerParameters parameters;
+  parameters.proportional_gain.fill(0.5);
+  parameters.integral_gain.fill(10.0);
+  parameters.max_integral_wrench = {{1, 1, 1, 0.1, 0.1, 0.1}};
+  ForceController controller(parameters);
+  controller.setTarget({{0, 0, -5, 0, 0, 0}});
+
+  // Without contact, the measured wrench stays zero.
+  RobotState robot_state{};
+  std::array<double, 7> tau_d = controller.update(robot_state, identityJacobian());
+  EXPECT_NEAR(-5 - 0.5 * 5 - 10 * 5 * franka::kDeltaT, tau_d[2], 1e-12);
+
+  for (size_t i = 0; i < 1000; i++) {
+    tau_d = controller.update(robot_state, identityJacobian());
+  }
+  EXPECT_NEAR(-5 - 0.5 * 5 - 1, tau_d[2], 1e-12);
+
+  // The integrator unwinds as soon as the error changes its sign.
+  robot_state.O_F_ext_hat_K[2] = 6.0;
+  tau_d = controller.update(robot_state, identityJacobian());
+  EXPECT_NEAR(-5 + 0.5 - 1 + 10 * franka::kDeltaT, tau_d[2], 1e-12);
+
+  controller.resetIntegrator();
+  tau_d = controller.update(robot_state, identityJacobian());
+  EXPECT_NEAR(-5 + 0.5 + 10 * franka::kDeltaT, tau_d[2], 1e-12);
+}
+
+TEST(ForceController, ControlsOnlySelectedAxes) {
+  ForceControllerParameters parameters;
+  parameters.selection = {{false, false, true, false, false, false}};
+  ForceController controller(parameters);
+  controller.setTarget({{3, 3, -3, 1, 1, 1}});
+  RobotState robot_state{};
+  robot_state.O_F_ext_hat_K = {{1, 1, 1, 1, 1, 1}};
+
+  controller.update(robot_state, identityJacobian());
+  const std::array<double, 6>& wrench = controller.commandedWrench();
+  for (size_t i = 0; i < 6; i++) {
+    if (i == 2) {
+      EXPECT_LT(wrench[i], -3.0);
+    } else {
+      EXPECT_EQ(0.0, wrench[i]);
+    }
+  }
+}
+
+TEST(ForceController, RemovesCalibratedBias) {
+  ForceController controller;
+  RobotState robot_state{};
+  for (double offset : {0.9, 1.1, 1.0}) {
+    robot_state.O_F_ext_hat_K = {{offset, 0, -2 * offset, 0, 0, 0.1}};
+    controller.calibrateBias(robot_state, identityJacobian());
+  }
+  EXPECT_NEAR(1.0, controller.bias()[0], 1e-12);
+  EXPECT_NEAR(-2.0, controller.bias()[2], 1e-12);
+
+  robot_state.O_F_ext_hat_K = {{1, 0, -2, 0, 0, 0.1}};
+  std::array<double, 7> tau_d = controller.update(robot_state, identityJacobian());
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_NEAR(0.0, controller.measuredWrench()[i], 1e-12);
+    EXPECT_NEAR(0.0, tau_d[i], 1e-12);
+  }
+
+  controller.resetBias();
+  EXPECT_EQ(0.0, controller.bias()[0]);
+}
+
+TEST(ForceController, MeasuresWrenchFromExternalTorques) {
+  ForceControllerParameters parameters;
+  parameters.measurement = ForceMeasurement::kExternalTorques;
+  ForceController controller(parameters);
+  std::array<double, 42> jacobian = randomJacobian();
+  Eigen::Map<const Matrix6x7d> J(jacobian.data());  // NOLINT(readability-identifier-naming)
+  Eigen::Matrix<double, 6, 1> external_wrench;
+  external_wrench << 1, -2, 3, 0.1, -0.2, 0.3;
+
+  RobotState robot_state{};
+  Eigen::Map<Eigen::Matrix<double, 7, 1>>(robot_state.tau_ext_hat_filtered.data()) =
+      J.transpose() * external_wrench;
+  controller.update(robot_state, jacobian);
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_NEAR(-external_wrench[i], controller.measuredWrench()[i], 1e-9);
+  }
+}
+
+TEST(ForceController, UpdateDoesNotAllocate) {
+  ForceControllerParameters parameters;
+  parameters.measurement = ForceMeasurement::kExternalTorques;
+  ForceController controller(parameters);
+  RobotState robot_state{};
+  robot_state.tau_ext_hat_filtered.fill(0.5);
+  std::array<double, 42> jacobian = randomJacobian();
+
+  franka::AllocationTrackingScope allocation_tracking;
+  controller.calibrateBias(robot_state, jacobian);
+  controller.update(robot_state, jacobian);
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(ForceController, ThrowsForInvalidParameters) {
+  ForceControllerParameters parameters;
+  parameters.integral_gain[1] = -1.0;
+  EXPECT_THROW(ForceController{parameters}, std::invalid_argument);
+  parameters = {};
+  parameters.max_integral_wrench[5] = NAN;
+  EXPECT_THROW(ForceController{parameters}, std::invalid_argument);
+
+  ForceController controller;
+  EXPECT_THROW(controller.setTarget({{0, 0, INFINITY, 0, 0, 0}}), std::invalid_argument);
+}
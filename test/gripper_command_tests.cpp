@@ -1,5 +1,9 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <chrono>
+#include <future>
+#include <thread>
+
 #include <gmock/gmock.h>
 
 #include <franka/exception.h>
@@ -22,6 +26,7 @@ class GripperCommand : public ::testing::Test {
   using TCommand = T;
 
   bool executeCommand(Gripper& gripper);
+  std::future<bool> executeAsyncCommand(Gripper& gripper);
   typename T::Request getExpected();
   typename T::Status getSuccess();
   bool compare(const typename T::Request& request_one, const typename T::Request& request_two);
@@ -103,6 +108,33 @@ bool GripperCommand<Homing>::executeCommand(Gripper& gripper) {
   return gripper.homing();
 }
 
+template <>
+std::future<bool> GripperCommand<Move>::executeAsyncCommand(Gripper& gripper) {
+  double width = 0.05;
+  double speed = 0.1;
+  return gripper.moveAsync(width, speed);
+}
+
+template <>
+std::future<bool> GripperCommand<Grasp>::executeAsyncCommand(Gripper& gripper) {
+  double width = 0.05;
+  double epsilon_inner = 0.004;
+  double epsilon_outer = 0.005;
+  double speed = 0.1;
+  double force = 400.0;
+  return gripper.graspAsync(width, speed, force, epsilon_inner, epsilon_outer);
+}
+
+template <>
+std::future<bool> GripperCommand<Stop>::executeAsyncCommand(Gripper& gripper) {
+  return gripper.stopAsync();
+}
+
+template <>
+std::future<bool> GripperCommand<Homing>::executeAsyncCommand(Gripper& gripper) {
+  return gripper.homingAsync();
+}
+
 template <typename T>
 typename T::Response GripperCommand<T>::createResponse(const typename T::Request&,
                                                        const typename T::Status status) {
@@ -129,6 +161,23 @@ TYPED_TEST(GripperCommand, CanSendAndReceiveSuccess) {
   EXPECT_NO_THROW(TestFixture::executeCommand(gripper));
 }
 
+TYPED_TEST(GripperCommand, CanReceiveDelayedResponse) {
+  GripperMockServer server;
+  Gripper gripper("127.0.0.1");
+
+  server
+      .waitForCommand<typename TestFixture::TCommand>(
+          [this](const typename TestFixture::TCommand::Request& request) ->
+          typename TestFixture::TCommand::Response {
+            // Gripper motions are answered only once they have finished.
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            return this->createResponse(request, this->getSuccess());
+          })
+      .spinOnce();
+
+  EXPECT_TRUE(TestFixture::executeCommand(gripper));
+}
+
 TYPED_TEST(GripperCommand, CanSendAndReceiveFail) {
   GripperMockServer server;
   Gripper gripper("127.0.0.1");
@@ -176,3 +225,37 @@ TYPED_TEST(GripperCommand, CanSendAndReceiveAborted) {
 
   EXPECT_THROW(TestFixture::executeCommand(gripper), CommandException);
 }
+
+TYPED_TEST(GripperCommand, CanSendAndReceiveAsyncSuccess) {
+  GripperMockServer server;
+  Gripper gripper("127.0.0.1");
+
+  server
+      .waitForCommand<typename TestFixture::TCommand>(
+          [this](const typename TestFixture::TCommand::Request& request) ->
+          typename TestFixture::TCommand::Response {
+            EXPECT_TRUE(this->compare(request, this->getExpected()));
+            return this->createResponse(request, this->getSuccess());
+          })
+      .spinOnce();
+
+  std::future<bool> result = TestFixture::executeAsyncCommand(gripper);
+  EXPECT_TRUE(result.get());
+}
+
+TYPED_TEST(GripperCommand, CanSendAndReceiveAsyncFail) {
+  GripperMockServer server;
+  Gripper gripper("127.0.0.1");
+
+  server
+      .waitForCommand<typename TestFixture::TCommand>(
+          [this](const typename TestFixture::TCommand::Request& request) ->
+          typename TestFixture::TCommand::Response {
+            EXPECT_TRUE(this->compare(request, this->getExpected()));
+            return this->createResponse(request, TestFixture::TCommand::Status::kFail);
+          })
+      .spinOnce();
+
+  std::future<bool> result = TestFixture::executeAsyncCommand(gripper);
+  EXPECT_THROW(result.get(), CommandException);
+}
@@ -1,7 +1,9 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <thread>
 
 #include <gmock/gmock.h>
 
@@ -17,6 +19,7 @@ using ::testing::Return;
 
 using franka::Gripper;
 using franka::IncompatibleVersionException;
+using franka::InvalidOperationException;
 using franka::NetworkException;
 
 using research_interface::gripper::Connect;
@@ -41,3 +44,43 @@ TEST(Gripper, ThrowsOnIncompatibleLibraryVersion) {
 
   EXPECT_THROW(Gripper("127.0.0.1"), IncompatibleVersionException);
 }
+
+TEST(Gripper, CanSubscribeToState) {
+  GripperMockServer server;
+  Gripper gripper("127.0.0.1");
+
+  std::atomic_flag send = ATOMIC_FLAG_INIT;
+  send.test_and_set();
+  server
+      .doForever([&]() {
+        bool continue_sending = send.test_and_set();
+        if (continue_sending) {
+          server.onSendUDP<GripperState>([](GripperState& gripper_state) {
+            gripper_state.width = 0.05;
+            gripper_state.max_width = 0.08;
+          });
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return continue_sending;
+      })
+      .spinOnce();
+
+  EXPECT_THROW(gripper.latestState(), InvalidOperationException);
+
+  std::atomic<int> callbacks{0};
+  gripper.subscribe([&](const franka::GripperState& gripper_state) {
+    EXPECT_EQ(0.05, gripper_state.width);
+    callbacks++;
+  });
+  EXPECT_THROW(gripper.subscribe(), InvalidOperationException);
+  EXPECT_LT(0, callbacks.load());
+
+  franka::GripperState latest_state = gripper.latestState();
+  EXPECT_EQ(0.05, latest_state.width);
+  EXPECT_EQ(0.08, latest_state.max_width);
+  EXPECT_EQ(0.05, gripper.readOnce().width);
+
+  gripper.unsubscribe();
+  EXPECT_THROW(gripper.latestState(), InvalidOperationException);
+  send.clear();
+}
@@ -0,0 +1,451 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <franka/allocation_tracking.h>
+#include <franka/datagram_replay.h>
+#include <franka/haptic_distance_field.h>
+#include <franka/haptic_mesh.h>
+#include <franka/haptic_point_cloud.h>
+#include <franka/haptic_scene.h>
+#include <franka/kinematics.h>
+#include <franka/robot.h>
+#include <franka/virtual_fixtures.h>
+
+#include "allocation_tracker.h"
+
+// Renders standard haptic scenes along a robot state trajectory, one tick per iteration. Besides
+// the mean, every benchmark reports the worst ticks, which decide whether a scene fits into the
+// 1 ms budget of a Robot::control callback:
+//
+// - p999_us, max_us: 99.9th percentile and maximum time per tick in microseconds,
+// - budget_share: maximum time per tick as fraction of 1 ms,
+// - cache_misses_per_tick: hardware cache misses per tick, if perf events are available,
+// - allocations, max_allocations_per_tick: heap allocations while rendering, if the library is
+//   built with the TRACK_ALLOCATIONS option.
+//
+// Set FRANKA_BENCHMARK_TRAJECTORY to the path of a franka::DatagramRecorder recording to replay
+// recorded robot states. Otherwise, a synthetic 10 s trajectory around the ready pose is used.
+// Scenes are placed around the end effector positions of the trajectory, so that it runs through
+// them.
+
+namespace {
+
+constexpr std::array<double, 16> kIdentity{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+
+std::vector<franka::RobotState> recordedTrajectory(const std::string& path) {
+  franka::DatagramReplay replay(path);
+  franka::Robot robot(replay);
+  std::vector<franka::RobotState> states;
+  states.reserve(replay.recordedStates());
+  while (replay.replayedStates() < replay.recordedStates()) {
+    states.push_back(robot.readOnce());
+  }
+  return states;
+}
+
+// Sinusoids of different frequencies around the ready pose, sampled at 1 kHz.
+std::vector<franka::RobotState> syntheticTrajectory() {
+  const std::array<double, 7> ready{{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+  const std::array<double, 7> amplitude{{0.4, 0.3, 0.3, 0.4, 0.3, 0.3, 0.5}};
+  const std::array<double, 7> frequency{{0.2, 0.3, 0.25, 0.35, 0.4, 0.45, 0.5}};
+  std::vector<franka::RobotState> states(10000);
+  for (size_t tick = 0; tick < states.size(); tick++) {
+    franka::RobotState& robot_state = states[tick];
+    double time = tick * 1e-3;
+    for (size_t joint = 0; joint < 7; joint++) {
+      double omega = 2 * M_PI * frequency[joint];
+      robot_state.q[joint] = ready[joint] + amplitude[joint] * std::sin(omega * time);
+      robot_state.dq[joint] = amplitude[joint] * omega * std::cos(omega * time);
+    }
+    robot_state.q_d = robot_state.q;
+    robot_state.F_T_EE = kIdentity;
+    robot_state.EE_T_K = kIdentity;
+    robot_state.time = franka::Duration(tick);
+
+    franka::FramePoses poses;
+    franka::FrameJacobians jacobians;
+    franka::PandaKinematics::poseAll(robot_state.q, franka::EndEffectorFrames(), &poses,
+                                     &jacobians);
+    const size_t end_effector = static_cast<size_t>(franka::Frame::kEndEffector);
+    robot_state.O_T_EE = poses[end_effector];
+    for (size_t row = 0; row < 6; row++) {
+      robot_state.O_dP_EE_c[row] = 0;
+      for (size_t joint = 0; joint < 7; joint++) {
+        robot_state.O_dP_EE_c[row] +=
+            jacobians[end_effector][joint * 6 + row] * robot_state.dq[joint];
+      }
+    }
+  }
+  return states;
+}
+
+const std::vector<franka::RobotState>& trajectory() {
+  static const std::vector<franka::RobotState> states = [] {
+    const char* path = std::getenv("FRANKA_BENCHMARK_TRAJECTORY");
+    return path != nullptr ? recordedTrajectory(path) : syntheticTrajectory();
+  }();
+  return states;
+}
+
+// Center and largest half extent of the end effector positions of the trajectory.
+struct Workspace {
+  std::array<double, 3> center;
+  double extent;
+};
+
+const Workspace& workspace() {
+  static const Workspace result = [] {
+    std::array<double, 3> min{{INFINITY, INFINITY, INFINITY}};
+    std::array<double, 3> max{{-INFINITY, -INFINITY, -INFINITY}};
+    for (const franka::RobotState& robot_state : trajectory()) {
+      for (size_t i = 0; i < 3; i++) {
+        min[i] = std::min(min[i], robot_state.O_T_EE[12 + i]);
+        max[i] = std::max(max[i], robot_state.O_T_EE[12 + i]);
+      }
+    }
+    Workspace workspace{{}, 0.05};
+    for (size_t i = 0; i < 3; i++) {
+      workspace.center[i] = (min[i] + max[i]) / 2;
+      workspace.extent = std::max(workspace.extent, (max[i] - min[i]) / 2);
+    }
+    return workspace;
+  }();
+  return result;
+}
+
+std::array<double, 3> endEffectorVelocity(const franka::RobotState& robot_state) {
+  return {{robot_state.O_dP_EE_c[0], robot_state.O_dP_EE_c[1], robot_state.O_dP_EE_c[2]}};
+}
+
+// Counts hardware cache misses of the calling thread while enabled.
+class CacheMissCounter {
+ public:
+  CacheMissCounter() {
+#ifdef __linux__
+    perf_event_attr attributes{};
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    descriptor_ = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+  }
+
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (descriptor_ >= 0) {
+      close(descriptor_);
+    }
+#endif
+  }
+
+  CacheMissCounter(const CacheMissCounter&) = delete;
+  CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+  bool available() const noexcept { return descriptor_ >= 0; }
+
+  void start() noexcept {
+#ifdef __linux__
+    if (available()) {
+      ioctl(descriptor_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(descriptor_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t stop() noexcept {
+    uint64_t count = 0;
+#ifdef __linux__
+    if (available()) {
+      ioctl(descriptor_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(descriptor_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int descriptor_{-1};
+};
+
+// Renders one tick per iteration, cycling through the trajectory, and reports the tail of the
+// per-tick times. The times are collected in a histogram with a resolution of 0.1 us, so that
+// arbitrarily long runs neither allocate nor lose the rare slow ticks.
+template <typename Render>
+void runTicks(benchmark::State& state, Render&& render) {
+  using Clock = std::chrono::steady_clock;
+  constexpr double kBucketWidth = 0.1;
+  const std::vector<franka::RobotState>& states = trajectory();
+  std::vector<uint64_t> histogram(20000);
+  double max_time = 0;
+  double total_time = 0;
+  size_t tick = 0;
+
+  CacheMissCounter cache_misses;
+  franka::resetAllocationStatistics();
+  {
+    franka::AllocationTrackingScope allocation_tracking;
+    cache_misses.start();
+    for (auto _ : state) {
+      const franka::RobotState& robot_state = states[tick];
+      tick = tick + 1 < states.size() ? tick + 1 : 0;
+
+      Clock::time_point start = Clock::now();
+      render(robot_state);
+      double time = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+      allocation_tracking.endCycle();
+      histogram[std::min(static_cast<size_t>(time / kBucketWidth), histogram.size() - 1)]++;
+      max_time = std::max(max_time, time);
+      total_time += time;
+    }
+    state.counters["cache_misses_per_tick"] =
+        benchmark::Counter(static_cast<double>(cache_misses.stop()),
+                           benchmark::Counter::kAvgIterations);
+  }
+  if (!cache_misses.available()) {
+    state.counters.erase("cache_misses_per_tick");
+  }
+
+  const uint64_t ticks = static_cast<uint64_t>(state.iterations());
+  uint64_t tail = ticks - ticks * 999 / 1000;
+  double p999 = max_time;
+  for (size_t bucket = histogram.size(); bucket-- > 0 && tail > 0;) {
+    p999 = std::min(max_time, (bucket + 1) * kBucketWidth);
+    tail -= std::min(tail, histogram[bucket]);
+  }
+
+  state.counters["mean_us"] = benchmark::Counter(ticks > 0 ? total_time / ticks : 0);
+  state.counters["p999_us"] = benchmark::Counter(p999);
+  state.counters["max_us"] = benchmark::Counter(max_time);
+  state.counters["budget_share"] = benchmark::Counter(max_time / 1000);
+  if (franka::allocationTrackingEnabled()) {
+    franka::AllocationStatistics allocations = franka::allocationStatistics();
+    state.counters["allocations"] =
+        benchmark::Counter(static_cast<double>(allocations.allocations));
+    state.counters["max_allocations_per_tick"] =
+        benchmark::Counter(static_cast<double>(allocations.max_allocations_per_cycle));
+  }
+}
+
+// UV sphere with about the given number of triangles.
+franka::haptics::TriangleMesh sphereMesh(const std::array<double, 3>& center,
+                                         double radius,
+                                         size_t triangle_count) {
+  const size_t rings = std::max<size_t>(2, static_cast<size_t>(std::sqrt(triangle_count / 4.0)));
+  const size_t segments = 2 * rings;
+  std::vector<std::array<double, 3>> vertices;
+  vertices.push_back({{center[0], center[1], center[2] + radius}});
+  for (size_t ring = 1; ring < rings; ring++) {
+    double theta = M_PI * ring / rings;
+    for (size_t segment = 0; segment < segments; segment++) {
+      double phi = 2 * M_PI * segment / segments;
+      vertices.push_back({{center[0] + radius * std::sin(theta) * std::cos(phi),
+                           center[1] + radius * std::sin(theta) * std::sin(phi),
+                           center[2] + radius * std::cos(theta)}});
+    }
+  }
+  vertices.push_back({{center[0], center[1], center[2] - radius}});
+
+  const uint32_t bottom = static_cast<uint32_t>(vertices.size() - 1);
+  auto index = [&](size_t ring, size_t segment) {
+    return static_cast<uint32_t>(1 + (ring - 1) * segments + segment % segments);
+  };
+  std::vector<std::array<uint32_t, 3>> triangles;
+  for (size_t segment = 0; segment < segments; segment++) {
+    triangles.push_back({{0, index(1, segment), index(1, segment + 1)}});
+    for (size_t ring = 1; ring + 1 < rings; ring++) {
+      triangles.push_back({{index(ring, segment), index(ring + 1, segment),
+                            index(ring + 1, segment + 1)}});
+      triangles.push_back({{index(ring, segment), index(ring + 1, segment + 1),
+                            index(ring, segment + 1)}});
+    }
+    triangles.push_back({{index(rings - 1, segment), bottom, index(rings - 1, segment + 1)}});
+  }
+  return franka::haptics::TriangleMesh(vertices, triangles);
+}
+
+}  // anonymous namespace
+
+// Planes, spheres, boxes, capsules and cylinders scattered through the workspace, queried through
+// the bounding volume hierarchy of haptics::Scene.
+static void BM_HapticPrimitiveScene(benchmark::State& state) {
+  const Workspace& space = workspace();
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> offset(-space.extent, space.extent);
+  auto randomPoint = [&]() {
+    return std::array<double, 3>{{space.center[0] + offset(generator),
+                                  space.center[1] + offset(generator),
+                                  space.center[2] + offset(generator)}};
+  };
+  const double size = space.extent / 8;
+
+  franka::haptics::Scene scene;
+  scene.addPlane({{0, 0, space.center[2] - space.extent}}, {{0, 0, 1}});
+  for (int64_t i = 0; i < state.range(0); i++) {
+    std::array<double, 3> point = randomPoint();
+    switch (i % 4) {
+      case 0:
+        scene.addSphere(point, size);
+        break;
+      case 1: {
+        std::array<double, 16> pose = kIdentity;
+        std::copy(point.begin(), point.end(), pose.begin() + 12);
+        scene.addBox(pose, {{size, size / 2, size}});
+        break;
+      }
+      case 2:
+        scene.addCapsule(point, randomPoint(), size / 2);
+        break;
+      default:
+        scene.addCylinder(point, randomPoint(), size / 2);
+        break;
+    }
+  }
+
+  runTicks(state, [&](const franka::RobotState& robot_state) {
+    benchmark::DoNotOptimize(scene.query(robot_state.O_T_EE, endEffectorVelocity(robot_state)));
+  });
+}
+BENCHMARK(BM_HapticPrimitiveScene)->ArgName("primitives")->Arg(16)->Arg(256)->Arg(4096);
+
+// Proxy-based rendering of a sphere mesh that the trajectory passes through.
+static void BM_HapticMesh(benchmark::State& state) {
+  const Workspace& space = workspace();
+  franka::haptics::MeshRenderer renderer(
+      sphereMesh(space.center, 0.6 * space.extent, static_cast<size_t>(state.range(0))));
+
+  runTicks(state, [&](const franka::RobotState& robot_state) {
+    benchmark::DoNotOptimize(renderer.render(robot_state.O_T_EE, endEffectorVelocity(robot_state)));
+  });
+}
+BENCHMARK(BM_HapticMesh)->ArgName("triangles")->Arg(1000)->Arg(100000)->Arg(1000000);
+
+// Signed distance field of a sphere, probed at four points along the arm. Each tick includes the
+// poses and Jacobians of all frames from the built-in kinematics.
+static void BM_HapticDistanceField(benchmark::State& state) {
+  const Workspace& space = workspace();
+  const uint32_t size = static_cast<uint32_t>(state.range(0));
+  const double voxel_size = 3 * space.extent / size;
+  const double radius = 0.6 * space.extent;
+  std::array<double, 3> origin;
+  for (size_t i = 0; i < 3; i++) {
+    origin[i] = space.center[i] - 1.5 * space.extent;
+  }
+  std::vector<float> distances(static_cast<size_t>(size) * size * size);
+  for (uint32_t z = 0; z < size; z++) {
+    for (uint32_t y = 0; y < size; y++) {
+      for (uint32_t x = 0; x < size; x++) {
+        double dx = origin[0] + x * voxel_size - space.center[0];
+        double dy = origin[1] + y * voxel_size - space.center[1];
+        double dz = origin[2] + z * voxel_size - space.center[2];
+        distances[(static_cast<size_t>(z) * size + y) * size + x] =
+            static_cast<float>(std::sqrt(dx * dx + dy * dy + dz * dz) - radius);
+      }
+    }
+  }
+
+  std::vector<franka::haptics::ProbePoint> probes{
+      {franka::Frame::kEndEffector, {}, 0.02},
+      {franka::Frame::kFlange, {}, 0.04},
+      {franka::Frame::kJoint6, {}, 0.06},
+      {franka::Frame::kJoint4, {}, 0.06},
+  };
+  franka::haptics::DistanceFieldRenderer renderer(
+      franka::haptics::DistanceField({{size, size, size}}, origin, voxel_size, distances),
+      probes);
+
+  franka::EndEffectorFrames frames;
+  franka::FramePoses poses;
+  franka::FrameJacobians jacobians;
+  runTicks(state, [&](const franka::RobotState& robot_state) {
+    frames.set(robot_state);
+    franka::PandaKinematics::poseAll(robot_state.q, frames, &poses, &jacobians);
+    benchmark::DoNotOptimize(renderer.render(poses, jacobians, robot_state.dq));
+  });
+}
+BENCHMARK(BM_HapticDistanceField)->ArgName("voxels_per_axis")->Arg(32)->Arg(128)->Arg(256);
+
+// Point cloud sampled from a sphere surface, indexed once before the ticks.
+static void BM_HapticPointCloud(benchmark::State& state) {
+  const Workspace& space = workspace();
+  std::mt19937 generator(42);
+  std::normal_distribution<double> normal;
+  std::vector<std::array<double, 3>> points(static_cast<size_t>(state.range(0)));
+  for (std::array<double, 3>& point : points) {
+    std::array<double, 3> direction{{normal(generator), normal(generator), normal(generator)}};
+    double length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                              direction[2] * direction[2]);
+    for (size_t i = 0; i < 3; i++) {
+      point[i] = space.center[i] + 0.6 * space.extent * direction[i] / length;
+    }
+  }
+
+  franka::haptics::PointCloudRenderer renderer;
+  renderer.update(points);
+  while (renderer.builds() == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // Hands the finished index over to the rendering thread.
+  renderer.render(trajectory().front().O_T_EE);
+
+  runTicks(state, [&](const franka::RobotState& robot_state) {
+    benchmark::DoNotOptimize(renderer.render(robot_state.O_T_EE, endEffectorVelocity(robot_state)));
+  });
+}
+BENCHMARK(BM_HapticPointCloud)->ArgName("points")->Arg(10000)->Arg(100000)->Arg(1000000);
+
+// Forbidden plane, guidance cone, tube along a helix, orientation lock and spring, evaluated with
+// the end effector state of the trajectory.
+static void BM_HapticVirtualFixtures(benchmark::State& state) {
+  namespace fixtures = franka::fixtures;
+  const Workspace& space = workspace();
+  std::vector<std::array<double, 3>> helix;
+  for (size_t i = 0; i < 16; i++) {
+    double angle = 0.5 * M_PI * i;
+    helix.push_back({{space.center[0] + 0.5 * space.extent * std::cos(angle),
+                      space.center[1] + 0.5 * space.extent * std::sin(angle),
+                      space.center[2] - space.extent + i * space.extent / 8}});
+  }
+  std::array<double, 16> target = kIdentity;
+  std::copy(space.center.begin(), space.center.end(), target.begin() + 12);
+
+  fixtures::FixtureSet<fixtures::Plane, fixtures::Cone, fixtures::Tube, fixtures::OrientationLock,
+                       fixtures::AnisotropicSpring>
+      fixture_set(
+          fixtures::Plane({{0, 0, space.center[2] - 0.5 * space.extent}}, {{0, 0, 1}}, 3000, 10),
+          fixtures::Cone({{space.center[0], space.center[1], space.center[2] + 2 * space.extent}},
+                         {{0, 0, -1}}, M_PI / 6, 1000, 10),
+          fixtures::Tube(helix, 0.2 * space.extent, 2000, 10),
+          fixtures::OrientationLock({{1, 0, 0, 0, -1, 0, 0, 0, -1}}, 50, 1, {{0, 0, 1}}),
+          fixtures::AnisotropicSpring(target, {{100, 100, 500}}, {{5, 5, 10}}));
+
+  runTicks(state, [&](const franka::RobotState& robot_state) {
+    benchmark::DoNotOptimize(
+        fixture_set.wrench(fixtures::fixtureState(robot_state.O_T_EE, robot_state.O_dP_EE_c)));
+  });
+}
+BENCHMARK(BM_HapticVirtualFixtures);
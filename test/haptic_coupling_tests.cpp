@@ -0,0 +1,155 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/haptic_coupling.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::Duration;
+using franka::RobotState;
+using franka::haptics::LocalModel;
+using franka::haptics::MultiRateCoupling;
+using franka::haptics::SceneWrench;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+franka::haptics::Material stiffMaterial() {
+  franka::haptics::Material material;
+  material.stiffness = 1000;
+  material.damping = 0;
+  return material;
+}
+
+// Calls render once per millisecond of robot time until the predicate holds.
+template <typename Predicate>
+SceneWrench renderUntil(MultiRateCoupling& coupling, RobotState* robot_state, Predicate predicate) {
+  SceneWrench wrench;
+  for (int i = 0; i < 5000 && !predicate(); i++) {
+    robot_state->time += Duration(1);
+    wrench = coupling.render(*robot_state);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return wrench;
+}
+
+}  // anonymous namespace
+
+TEST(LocalModel, CanAddPlanes) {
+  LocalModel model;
+  EXPECT_TRUE(model.addPlane({{0, 0, 1}}, {{0, 0, 2}}));
+  EXPECT_EQ(1u, model.plane_count);
+  EXPECT_THAT(model.planes[0].normal, ElementsAre(0, 0, 1));
+  EXPECT_FALSE(model.addPlane({{0, 0, 1}}, {{0, 0, 0}}));
+
+  for (size_t i = 1; i < LocalModel::kMaxPlanes; i++) {
+    EXPECT_TRUE(model.addPlane({{0, 0, 0}}, {{1, 0, 0}}));
+  }
+  EXPECT_FALSE(model.addPlane({{0, 0, 0}}, {{1, 0, 0}}));
+  EXPECT_EQ(LocalModel::kMaxPlanes, model.plane_count);
+}
+
+TEST(LocalModel, CanBeRendered) {
+  LocalModel model;
+  model.addPlane({{0, 0, 0.5}}, {{0, 0, 1}}, stiffMaterial());
+  model.O_F_feedforward = {{1, 0, 0, 0, 0, 0}};
+
+  SceneWrench free = franka::haptics::renderLocalModel(model, translation(0, 0, 0.6));
+  EXPECT_EQ(0u, free.contacts);
+  EXPECT_THAT(free.O_F, ElementsAre(1, 0, 0, 0, 0, 0));
+
+  SceneWrench contact =
+      franka::haptics::renderLocalModel(model, translation(0, 0, 0.6), {}, {{0.1, 0, -0.11}});
+  EXPECT_EQ(1u, contact.contacts);
+  EXPECT_NEAR(0.01, contact.max_penetration, 1e-12);
+  EXPECT_NEAR(1, contact.O_F[0], 1e-9);
+  EXPECT_NEAR(10, contact.O_F[2], 1e-9);
+  // r = (0.1, 0, -0.11), F = (0, 0, 10) => r x F = (0, -1, 0)
+  EXPECT_NEAR(-1, contact.O_F[4], 1e-9);
+}
+
+TEST(MultiRateCoupling, RendersModelsOfBackgroundUpdates) {
+  std::mutex mutex;
+  std::vector<Duration> elapsed_times;
+  MultiRateCoupling coupling(
+      [&](const RobotState& robot_state, Duration elapsed, LocalModel* model) {
+        // Place a plane 1 cm above the end effector the control loop reported last.
+        model->plane_count = 0;
+        model->addPlane({{0, 0, robot_state.O_T_EE[14] + 0.01}}, {{0, 0, 1}}, stiffMaterial());
+        std::lock_guard<std::mutex> lock(mutex);
+        elapsed_times.push_back(elapsed);
+      },
+      300);
+  EXPECT_EQ(0u, coupling.updates());
+
+  RobotState robot_state;
+  robot_state.O_T_EE = translation(0, 0, 0.3);
+  robot_state.time = Duration(1000);
+  SceneWrench wrench = renderUntil(coupling, &robot_state, [&]() {
+    return coupling.updates() >= 3 && coupling.model().plane_count > 0;
+  });
+  ASSERT_GE(coupling.updates(), 3u);
+
+  EXPECT_EQ(1u, wrench.contacts);
+  EXPECT_NEAR(10, wrench.O_F[2], 1e-9);
+  EXPECT_LE(coupling.model().time, robot_state.time);
+  EXPECT_EQ(robot_state.time - coupling.model().time, coupling.modelAge());
+  EXPECT_EQ(nullptr, coupling.error());
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_GE(elapsed_times.size(), 3u);
+  EXPECT_EQ(Duration(), elapsed_times[0]);
+  EXPECT_GT(elapsed_times[1], Duration());
+}
+
+TEST(MultiRateCoupling, DoesNotUpdateWithoutRobotStates) {
+  std::atomic<int> calls{0};
+  MultiRateCoupling coupling([&](const RobotState&, Duration, LocalModel*) { calls++; }, 1000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(0, calls);
+  EXPECT_EQ(0u, coupling.updates());
+}
+
+TEST(MultiRateCoupling, StopsRenderingWhenUpdateThrows) {
+  std::atomic<int> calls{0};
+  MultiRateCoupling coupling(
+      [&](const RobotState&, Duration, LocalModel* model) {
+        if (calls++ > 0) {
+          throw std::runtime_error("Simulation failed");
+        }
+        model->addPlane({{0, 0, 1}}, {{0, 0, 1}}, stiffMaterial());
+      },
+      1000);
+
+  RobotState robot_state;
+  robot_state.O_T_EE = translation(0, 0, 0.99);
+  renderUntil(coupling, &robot_state, [&]() { return coupling.error() != nullptr; });
+  ASSERT_NE(nullptr, coupling.error());
+  EXPECT_THROW(std::rethrow_exception(coupling.error()), std::runtime_error);
+
+  robot_state.time += Duration(1);
+  SceneWrench wrench = coupling.render(robot_state);
+  EXPECT_EQ(0u, wrench.contacts);
+  EXPECT_THAT(wrench.O_F, Each(0.0));
+}
+
+TEST(MultiRateCoupling, ThrowsOnInvalidArguments) {
+  EXPECT_THROW(MultiRateCoupling(nullptr), std::invalid_argument);
+  auto update = [](const RobotState&, Duration, LocalModel*) {};
+  EXPECT_THROW(MultiRateCoupling(update, 0), std::invalid_argument);
+  EXPECT_THROW(MultiRateCoupling(update, 2000), std::invalid_argument);
+}
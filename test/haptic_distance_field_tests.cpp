@@ -0,0 +1,272 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/exception.h>
+#include <franka/haptic_distance_field.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::Frame;
+using franka::FrameJacobians;
+using franka::FramePoses;
+using franka::haptics::DistanceField;
+using franka::haptics::DistanceFieldRenderer;
+using franka::haptics::Material;
+using franka::haptics::ProbePoint;
+using franka::haptics::ProbeTorques;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+Material stiffMaterial() {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 0;
+  return material;
+}
+
+// Samples d(x, y, z) = a * x + b * y + c * z + offset on a grid around the origin.
+DistanceField linearField(double a, double b, double c, double offset) {
+  const std::array<uint32_t, 3> dimensions{{5, 6, 7}};
+  const std::array<double, 3> origin{{-0.2, -0.25, -0.3}};
+  const double voxel_size = 0.1;
+  std::vector<float> distances;
+  for (uint32_t z = 0; z < dimensions[2]; z++) {
+    for (uint32_t y = 0; y < dimensions[1]; y++) {
+      for (uint32_t x = 0; x < dimensions[0]; x++) {
+        distances.push_back(static_cast<float>(
+            a * (origin[0] + x * voxel_size) + b * (origin[1] + y * voxel_size) +
+            c * (origin[2] + z * voxel_size) + offset));
+      }
+    }
+  }
+  return DistanceField(dimensions, origin, voxel_size, distances);
+}
+
+// Solid below z = 0.
+DistanceField floorField() {
+  return linearField(0, 0, 1, 0);
+}
+
+// All frames at the origin. The first three joints move every frame along x, y and z, the last
+// three rotate every frame about x, y and z.
+void identityKinematics(FramePoses* poses, FrameJacobians* jacobians) {
+  for (auto& pose : *poses) {
+    pose = translation(0, 0, 0);
+  }
+  for (auto& jacobian : *jacobians) {
+    jacobian.fill(0);
+    for (size_t i = 0; i < 3; i++) {
+      jacobian[6 * i + i] = 1;
+      jacobian[6 * (i + 3) + i + 3] = 1;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(DistanceField, InterpolatesLinearFieldsExactly) {
+  DistanceField field = linearField(0.6, 0, -0.8, 0.05);
+
+  EXPECT_THAT(field.dimensions(), ElementsAre(5, 6, 7));
+  EXPECT_THAT(field.origin(), ElementsAre(-0.2, -0.25, -0.3));
+  EXPECT_DOUBLE_EQ(0.1, field.voxelSize());
+
+  for (const std::array<double, 3>& point : std::vector<std::array<double, 3>>{
+           {{0, 0, 0}}, {{-0.2, -0.25, -0.3}}, {{0.13, 0.21, 0.27}}, {{-0.07, 0.03, 0.11}}}) {
+    std::array<double, 3> gradient{};
+    EXPECT_NEAR(0.6 * point[0] - 0.8 * point[2] + 0.05, field.distance(point, &gradient), 1e-6);
+    EXPECT_NEAR(0.6, gradient[0], 1e-6);
+    EXPECT_NEAR(0, gradient[1], 1e-6);
+    EXPECT_NEAR(-0.8, gradient[2], 1e-6);
+  }
+}
+
+TEST(DistanceField, ExtendsDistanceOutsideOfGrid) {
+  DistanceField field = floorField();
+
+  // The grid ends at x = 0.2 and z = 0.3.
+  std::array<double, 3> gradient{};
+  EXPECT_NEAR(0.1 + 0.3, field.distance({{0.5, 0, 0.1}}, &gradient), 1e-6);
+  EXPECT_NEAR(1, gradient[2], 1e-6);
+  EXPECT_NEAR(0.3 + std::sqrt(0.1 * 0.1 + 0.2 * 0.2), field.distance({{0.3, 0, 0.5}}), 1e-6);
+  EXPECT_TRUE(std::isnan(field.distance({{std::nan(""), 0, 0}})));
+}
+
+TEST(DistanceField, ThrowsOnInvalidInput) {
+  std::vector<float> distances(8, 1.0f);
+  EXPECT_NO_THROW(DistanceField({{2, 2, 2}}, {}, 0.1, distances));
+  EXPECT_THROW(DistanceField({{2, 2, 1}}, {}, 0.1, std::vector<float>(4)), std::invalid_argument);
+  EXPECT_THROW(DistanceField({{2, 2, 3}}, {}, 0.1, distances), std::invalid_argument);
+  EXPECT_THROW(DistanceField({{2, 2, 2}}, {}, 0, distances), std::invalid_argument);
+  EXPECT_THROW(DistanceField({{2, 2, 2}}, {{std::numeric_limits<double>::infinity(), 0, 0}}, 0.1,
+                             distances),
+               std::invalid_argument);
+  distances[3] = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_THROW(DistanceField({{2, 2, 2}}, {}, 0.1, distances), std::invalid_argument);
+}
+
+TEST(DistanceField, CanBeSavedAndLoaded) {
+  const std::string path = "haptic_distance_field_test.bin";
+  DistanceField field = linearField(0.6, 0, -0.8, 0.05);
+  field.save(path);
+
+  DistanceField loaded = DistanceField::load(path);
+  std::remove(path.c_str());
+
+  EXPECT_EQ(field.dimensions(), loaded.dimensions());
+  EXPECT_EQ(field.origin(), loaded.origin());
+  EXPECT_EQ(field.voxelSize(), loaded.voxelSize());
+  std::array<double, 3> gradient{}, loaded_gradient{};
+  EXPECT_EQ(field.distance({{0.13, 0.21, 0.27}}, &gradient),
+            loaded.distance({{0.13, 0.21, 0.27}}, &loaded_gradient));
+  EXPECT_EQ(gradient, loaded_gradient);
+}
+
+TEST(DistanceField, ThrowsOnInvalidFiles) {
+  EXPECT_THROW(DistanceField::load("does_not_exist.bin"), franka::Exception);
+
+  const std::string path = "haptic_distance_field_test_invalid.bin";
+  floorField().save(path);
+  std::string contents;
+  {
+    std::ifstream input(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+  }
+  auto write = [&](const std::string& data) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(data.data(), data.size());
+  };
+
+  write(contents.substr(0, contents.size() - 4));
+  EXPECT_THROW(DistanceField::load(path), franka::Exception);
+
+  std::string wrong_magic = contents;
+  wrong_magic[0] = 'X';
+  write(wrong_magic);
+  EXPECT_THROW(DistanceField::load(path), franka::Exception);
+
+  std::string not_a_number = contents;
+  float nan = std::numeric_limits<float>::quiet_NaN();
+  not_a_number.replace(64 + 16 * 3 + 4, sizeof(nan), reinterpret_cast<const char*>(&nan),
+                       sizeof(nan));
+  write(not_a_number);
+  EXPECT_THROW(DistanceField::load(path), franka::Exception);
+
+  write(contents);
+  EXPECT_NO_THROW(DistanceField::load(path));
+  std::remove(path.c_str());
+}
+
+TEST(DistanceFieldRenderer, PushesProbeOutOfSolid) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+
+  ProbePoint probe;
+  probe.position = {{0, 0, 0.01}};
+  probe.radius = 0.03;
+  DistanceFieldRenderer renderer(floorField(), {probe}, stiffMaterial());
+
+  ProbeTorques torques = renderer.render(poses, jacobians, {});
+  EXPECT_EQ(1u, torques.contacts);
+  EXPECT_NEAR(0.02, torques.max_penetration, 1e-6);
+  EXPECT_THAT(torques.tau_J, ElementsAre(DoubleNear(0, 1e-6), DoubleNear(0, 1e-6),
+                                         DoubleNear(20, 1e-3), DoubleNear(0, 1e-6),
+                                         DoubleNear(0, 1e-6), DoubleNear(0, 1e-6), 0));
+
+  poses[static_cast<size_t>(Frame::kEndEffector)] = translation(0, 0, 0.1);
+  torques = renderer.render(poses, jacobians, {});
+  EXPECT_EQ(0u, torques.contacts);
+  EXPECT_THAT(torques.tau_J, Each(0.0));
+}
+
+TEST(DistanceFieldRenderer, MapsForcesOfAllProbesToJointTorques) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+  // Rotate the flange by 90 degrees about z; its probe at x = 0.1 then lies at y = 0.1.
+  poses[static_cast<size_t>(Frame::kFlange)] = {{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+
+  ProbePoint flange_probe;
+  flange_probe.frame = Frame::kFlange;
+  flange_probe.position = {{0.1, 0, -0.01}};
+  ProbePoint link_probe;
+  link_probe.frame = Frame::kJoint4;
+  link_probe.position = {{0, 0, 0.1}};
+  DistanceFieldRenderer renderer(floorField(), {flange_probe, link_probe}, stiffMaterial());
+
+  // Force of 10 N along z at the lever (0, 0.1, 0) yields the torque (1, 0, 0).
+  ProbeTorques torques = renderer.render(poses, jacobians, {});
+  EXPECT_EQ(1u, torques.contacts);
+  EXPECT_THAT(torques.tau_J, ElementsAre(DoubleNear(0, 1e-6), DoubleNear(0, 1e-6),
+                                         DoubleNear(10, 1e-3), DoubleNear(1, 1e-4),
+                                         DoubleNear(0, 1e-6), DoubleNear(0, 1e-6), 0));
+}
+
+TEST(DistanceFieldRenderer, DampingOpposesApproach) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+
+  ProbePoint probe;
+  probe.position = {{0, 0, -0.01}};
+  Material material = stiffMaterial();
+  material.damping = 20;
+  DistanceFieldRenderer renderer(floorField(), {probe}, material);
+
+  EXPECT_NEAR(10 + 20 * 0.1, renderer.render(poses, jacobians, {{0, 0, -0.1}}).tau_J[2], 1e-3);
+  // Rotating about y moves the probe tangentially to the surface, which is not damped.
+  EXPECT_NEAR(10, renderer.render(poses, jacobians, {{0, 0, 0, 0, 1, 0, 0}}).tau_J[2], 1e-3);
+  // Fast retraction does not pull the probe into the solid.
+  EXPECT_THAT(renderer.render(poses, jacobians, {{0, 0, 1}}).tau_J, Each(DoubleNear(0, 1e-9)));
+}
+
+TEST(DistanceFieldRenderer, UsesFieldPoseAndSwapsFields) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+
+  ProbePoint probe;
+  DistanceFieldRenderer renderer(floorField(), {probe}, stiffMaterial(), translation(0, 0, 0.01));
+  EXPECT_NEAR(10, renderer.render(poses, jacobians, {}).tau_J[2], 1e-3);
+
+  // Wall facing -x at x = 0.02 in field frame.
+  renderer.setField(linearField(-1, 0, 0, 0.02));
+  renderer.setFieldPose(translation(-0.03, 0, 0));
+  EXPECT_THAT(renderer.render(poses, jacobians, {}).tau_J,
+              ElementsAre(DoubleNear(-10, 1e-3), DoubleNear(0, 1e-6), DoubleNear(0, 1e-6),
+                          DoubleNear(0, 1e-6), DoubleNear(0, 1e-6), DoubleNear(0, 1e-6), 0));
+  EXPECT_EQ(0.02f, renderer.field().distance({}));
+  EXPECT_EQ(1u, renderer.probes().size());
+}
+
+TEST(DistanceFieldRenderer, ThrowsOnInvalidArguments) {
+  ProbePoint probe;
+  EXPECT_NO_THROW(DistanceFieldRenderer(floorField(), {probe}));
+
+  Material material;
+  material.damping = -1;
+  EXPECT_THROW(DistanceFieldRenderer(floorField(), {probe}, material), std::invalid_argument);
+
+  ProbePoint invalid_probe;
+  invalid_probe.radius = -0.1;
+  EXPECT_THROW(DistanceFieldRenderer(floorField(), {invalid_probe}), std::invalid_argument);
+
+  EXPECT_THROW(DistanceFieldRenderer(floorField(), {probe}, {}, {}), std::invalid_argument);
+  DistanceFieldRenderer renderer(floorField(), {probe});
+  EXPECT_THROW(renderer.setFieldPose({}), std::invalid_argument);
+}
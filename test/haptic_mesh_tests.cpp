@@ -0,0 +1,297 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/exception.h>
+#include <franka/haptic_mesh.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::haptics::Material;
+using franka::haptics::MeshRenderer;
+using franka::haptics::SceneWrench;
+using franka::haptics::TriangleMesh;
+
+namespace {
+
+// Tolerance for forces, covering the distance the proxy keeps from the surface.
+constexpr double kForceTolerance = 1e-2;
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+Material stiffMaterial() {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 0;
+  return material;
+}
+
+// Cube with an edge length of 0.2 m centered at the origin.
+TriangleMesh cube() {
+  std::vector<std::array<double, 3>> vertices;
+  for (double x : {-0.1, 0.1}) {
+    for (double y : {-0.1, 0.1}) {
+      for (double z : {-0.1, 0.1}) {
+        vertices.push_back({{x, y, z}});
+      }
+    }
+  }
+  // Vertex index bits are (x, y, z); triangles are counter-clockwise seen from outside.
+  std::vector<std::array<uint32_t, 3>> triangles{
+      {{0, 1, 3}}, {{0, 3, 2}}, {{4, 6, 7}}, {{4, 7, 5}}, {{0, 4, 5}}, {{0, 5, 1}},
+      {{2, 3, 7}}, {{2, 7, 6}}, {{0, 2, 6}}, {{0, 6, 4}}, {{1, 5, 7}}, {{1, 7, 3}}};
+  return TriangleMesh(vertices, triangles);
+}
+
+// Floor at z = 0 and wall at x = 0, both facing the quadrant x > 0, z > 0.
+TriangleMesh corner() {
+  std::vector<std::array<double, 3>> vertices{{{0, -1, 0}}, {{1, -1, 0}}, {{1, 1, 0}},
+                                              {{0, 1, 0}},  {{0, -1, 1}}, {{0, 1, 1}}};
+  std::vector<std::array<uint32_t, 3>> triangles{
+      {{0, 1, 2}}, {{0, 2, 3}}, {{0, 3, 5}}, {{0, 5, 4}}};
+  return TriangleMesh(vertices, triangles);
+}
+
+// Latitude-longitude tessellation of a sphere around the origin.
+TriangleMesh sphere(double radius, uint32_t segments) {
+  std::vector<std::array<double, 3>> vertices;
+  for (uint32_t i = 0; i <= segments; i++) {
+    double polar = M_PI * i / segments;
+    for (uint32_t j = 0; j < 2 * segments; j++) {
+      double azimuth = M_PI * j / segments;
+      vertices.push_back({{radius * std::sin(polar) * std::cos(azimuth),
+                           radius * std::sin(polar) * std::sin(azimuth),
+                           radius * std::cos(polar)}});
+    }
+  }
+  std::vector<std::array<uint32_t, 3>> triangles;
+  for (uint32_t i = 0; i < segments; i++) {
+    for (uint32_t j = 0; j < 2 * segments; j++) {
+      uint32_t next = (j + 1) % (2 * segments);
+      uint32_t a = i * 2 * segments + j;
+      uint32_t b = i * 2 * segments + next;
+      uint32_t c = (i + 1) * 2 * segments + j;
+      uint32_t d = (i + 1) * 2 * segments + next;
+      triangles.push_back({{a, c, d}});
+      triangles.push_back({{a, d, b}});
+    }
+  }
+  return TriangleMesh(vertices, triangles);
+}
+
+}  // anonymous namespace
+
+TEST(TriangleMesh, CanBeCreated) {
+  TriangleMesh mesh = cube();
+  EXPECT_EQ(8u, mesh.vertexCount());
+  EXPECT_EQ(12u, mesh.triangleCount());
+  EXPECT_THAT(mesh.vertex(7), ElementsAre(0.1, 0.1, 0.1));
+  for (size_t i = 0; i < mesh.triangleCount(); i++) {
+    EXPECT_THAT(mesh.triangle(i), Each(Lt(8u)));
+  }
+}
+
+TEST(TriangleMesh, ThrowsOnInvalidInput) {
+  std::vector<std::array<double, 3>> vertices{{{0, 0, 0}}, {{1, 0, 0}}, {{0, 1, 0}}};
+  EXPECT_THROW(TriangleMesh(vertices, {}), std::invalid_argument);
+  EXPECT_THROW(TriangleMesh(vertices, {{{0, 1, 3}}}), std::invalid_argument);
+  vertices[1][2] = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(TriangleMesh(vertices, {{{0, 1, 2}}}), std::invalid_argument);
+}
+
+TEST(TriangleMesh, CanBeSavedAndLoaded) {
+  const std::string path = "haptic_mesh_test.bin";
+  TriangleMesh mesh = sphere(0.1, 20);
+  mesh.save(path);
+
+  TriangleMesh loaded = TriangleMesh::load(path);
+  std::remove(path.c_str());
+
+  ASSERT_EQ(mesh.vertexCount(), loaded.vertexCount());
+  ASSERT_EQ(mesh.triangleCount(), loaded.triangleCount());
+  for (size_t i = 0; i < mesh.vertexCount(); i++) {
+    EXPECT_EQ(mesh.vertex(i), loaded.vertex(i));
+  }
+  for (size_t i = 0; i < mesh.triangleCount(); i++) {
+    EXPECT_EQ(mesh.triangle(i), loaded.triangle(i));
+  }
+
+  MeshRenderer renderer(mesh, stiffMaterial());
+  MeshRenderer loaded_renderer(loaded, stiffMaterial());
+  for (double z : {0.2, 0.12, 0.095, 0.09}) {
+    SceneWrench wrench = renderer.render(translation(0.01, 0.02, z));
+    SceneWrench loaded_wrench = loaded_renderer.render(translation(0.01, 0.02, z));
+    EXPECT_EQ(wrench.contacts, loaded_wrench.contacts);
+    EXPECT_EQ(wrench.O_F, loaded_wrench.O_F);
+  }
+}
+
+TEST(TriangleMesh, ThrowsOnInvalidFiles) {
+  EXPECT_THROW(TriangleMesh::load("haptic_mesh_test_missing.bin"), franka::Exception);
+
+  const std::string path = "haptic_mesh_test_invalid.bin";
+  cube().save(path);
+  {
+    // Truncate the node data.
+    std::ifstream input(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(input)),
+                           std::istreambuf_iterator<char>());
+    input.close();
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(data.data(), static_cast<std::streamsize>(data.size() - 8));
+  }
+  EXPECT_THROW(TriangleMesh::load(path), franka::Exception);
+
+  {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << "This is not a mesh, but long enough to contain a header.";
+  }
+  EXPECT_THROW(TriangleMesh::load(path), franka::Exception);
+  std::remove(path.c_str());
+}
+
+TEST(MeshRenderer, PushesProbeOutOfFace) {
+  MeshRenderer renderer(cube(), stiffMaterial());
+
+  SceneWrench free = renderer.render(translation(0, 0, 0.2));
+  EXPECT_EQ(0u, free.contacts);
+  EXPECT_THAT(free.O_F, Each(0.0));
+
+  SceneWrench contact = renderer.render(translation(0, 0, 0.095));
+  EXPECT_EQ(1u, contact.contacts);
+  EXPECT_NEAR(0.005, contact.max_penetration, 1e-5);
+  EXPECT_NEAR(0, contact.O_F[0], 1e-9);
+  EXPECT_NEAR(0, contact.O_F[1], 1e-9);
+  EXPECT_NEAR(5, contact.O_F[2], kForceTolerance);
+  EXPECT_NEAR(0.1, renderer.proxy()[2], 1e-5);
+}
+
+TEST(MeshRenderer, ProxySlidesAlongFace) {
+  MeshRenderer renderer(cube(), stiffMaterial());
+  renderer.render(translation(0, 0, 0.2));
+  renderer.render(translation(0, 0, 0.095));
+
+  SceneWrench wrench = renderer.render(translation(0.05, -0.03, 0.09));
+  EXPECT_EQ(1u, wrench.contacts);
+  EXPECT_NEAR(0, wrench.O_F[0], 1e-9);
+  EXPECT_NEAR(0, wrench.O_F[1], 1e-9);
+  EXPECT_NEAR(10, wrench.O_F[2], kForceTolerance);
+  EXPECT_THAT(renderer.proxy(), ElementsAre(DoubleNear(0.05, 1e-9), DoubleNear(-0.03, 1e-9),
+                                            DoubleNear(0.1, 1e-5)));
+
+  // Beyond the edge, the proxy leaves the face and follows the probe again.
+  renderer.render(translation(0.15, 0, 0.09));
+  SceneWrench released = renderer.render(translation(0.15, 0, 0.09));
+  EXPECT_EQ(0u, released.contacts);
+  EXPECT_THAT(released.O_F, Each(0.0));
+}
+
+TEST(MeshRenderer, DoesNotPopThroughThinObjects) {
+  MeshRenderer renderer(cube(), stiffMaterial());
+  renderer.render(translation(0, 0, 0.2));
+
+  // Even past the center of the cube, the probe is pushed back through the top face.
+  for (double z = 0.1; z > -0.09; z -= 0.01) {
+    SceneWrench wrench = renderer.render(translation(0, 0, z));
+    EXPECT_EQ(1u, wrench.contacts);
+    EXPECT_NEAR(1000 * (0.1 - z), wrench.O_F[2], kForceTolerance);
+  }
+}
+
+TEST(MeshRenderer, ProxyStaysInConcaveCorner) {
+  MeshRenderer renderer(corner(), stiffMaterial());
+  renderer.render(translation(0.5, 0, 0.5));
+
+  SceneWrench wrench = renderer.render(translation(-0.01, 0.2, -0.02));
+  EXPECT_EQ(2u, wrench.contacts);
+  EXPECT_NEAR(10, wrench.O_F[0], kForceTolerance);
+  EXPECT_NEAR(0, wrench.O_F[1], 1e-6);
+  EXPECT_NEAR(20, wrench.O_F[2], kForceTolerance);
+  EXPECT_THAT(renderer.proxy(), ElementsAre(DoubleNear(0, 1e-5), DoubleNear(0.2, 1e-6),
+                                            DoubleNear(0, 1e-5)));
+
+  // Moving the probe away from the wall only keeps the floor as constraint.
+  SceneWrench floor = renderer.render(translation(0.1, 0.2, -0.02));
+  EXPECT_EQ(1u, floor.contacts);
+  EXPECT_NEAR(0, floor.O_F[0], 1e-6);
+  EXPECT_NEAR(20, floor.O_F[2], kForceTolerance);
+}
+
+TEST(MeshRenderer, RendersTessellatedSphere) {
+  const double kRadius = 0.2;
+  MeshRenderer renderer(sphere(kRadius, 64), stiffMaterial(), translation(0.4, 0, 0.3));
+  ASSERT_EQ(2u * 64 * 128, renderer.mesh().triangleCount());
+
+  renderer.render(translation(0.4, 0, 0.6));
+  for (double angle = 0; angle < 1; angle += 0.01) {
+    // Press 1 cm into the sphere while moving around it.
+    double distance = kRadius - 0.01;
+    SceneWrench wrench =
+        renderer.render(translation(0.4 + distance * std::sin(angle), 0.1 * distance * angle,
+                                    0.3 + distance * std::cos(angle)));
+    ASSERT_GE(wrench.contacts, 1u);
+    double force = std::sqrt(wrench.O_F[0] * wrench.O_F[0] + wrench.O_F[1] * wrench.O_F[1] +
+                             wrench.O_F[2] * wrench.O_F[2]);
+    double penetration = kRadius - distance * std::sqrt(1 + 0.01 * angle * angle);
+    EXPECT_NEAR(1000 * penetration, force, 0.5);
+    // The force points away from the center.
+    EXPECT_GT(wrench.O_F[0] * std::sin(angle) + wrench.O_F[2] * std::cos(angle), 0.95 * force);
+  }
+}
+
+TEST(MeshRenderer, UsesMeshPoseAndProbeOffset) {
+  std::array<double, 16> pose = translation(0.5, 0, 0.2);
+  MeshRenderer renderer(cube(), stiffMaterial(), pose, {{0, 0, 0.1}});
+  renderer.render(translation(0.5, 0, 0.5));
+
+  SceneWrench wrench = renderer.render(translation(0.5, 0, 0.195));
+  EXPECT_EQ(1u, wrench.contacts);
+  EXPECT_NEAR(5, wrench.O_F[2], kForceTolerance);
+  EXPECT_THAT(renderer.proxy(), ElementsAre(DoubleNear(0.5, 1e-9), DoubleNear(0, 1e-9),
+                                            DoubleNear(0.3, 1e-5)));
+
+  franka::RobotState robot_state;
+  robot_state.O_T_EE = translation(0.5, 0, 0.19);
+  EXPECT_NEAR(10, renderer.render(robot_state).O_F[2], kForceTolerance);
+
+  // A probe that starts inside the mesh after a reset is not pushed out.
+  renderer.reset();
+  EXPECT_EQ(0u, renderer.render(translation(0.5, 0, 0.1)).contacts);
+
+  EXPECT_THROW(renderer.setMeshPose(std::array<double, 16>{}), std::invalid_argument);
+}
+
+TEST(MeshRenderer, DampingOpposesApproach) {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 100;
+  MeshRenderer renderer(cube(), material);
+  renderer.render(translation(0, 0, 0.2));
+
+  SceneWrench approaching = renderer.render(translation(0, 0, 0.095), {{0, 0, -0.01}});
+  EXPECT_NEAR(6, approaching.O_F[2], kForceTolerance);
+  SceneWrench retracting = renderer.render(translation(0, 0, 0.095), {{0, 0, 0.01}});
+  EXPECT_NEAR(4, retracting.O_F[2], kForceTolerance);
+}
+
+TEST(MeshRenderer, ThrowsOnInvalidArguments) {
+  Material material;
+  material.damping = -1;
+  EXPECT_THROW(MeshRenderer(cube(), material), std::invalid_argument);
+  EXPECT_THROW(MeshRenderer(cube(), {}, translation(0, 0, std::numeric_limits<double>::infinity())),
+               std::invalid_argument);
+  EXPECT_THROW(
+      MeshRenderer(cube(), {}, translation(0, 0, 0), {{std::numeric_limits<double>::quiet_NaN()}}),
+      std::invalid_argument);
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/haptic_point_cloud.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::haptics::Material;
+using franka::haptics::PointCloudRenderer;
+using franka::haptics::SceneWrench;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+Material stiffMaterial() {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 0;
+  return material;
+}
+
+// Square grid of points in the plane z = 0.
+std::vector<std::array<double, 3>> floorCloud(double spacing) {
+  std::vector<std::array<double, 3>> points;
+  for (double x = -0.1; x <= 0.1; x += spacing) {
+    for (double y = -0.1; y <= 0.1; y += spacing) {
+      points.push_back({{x, y, 0}});
+    }
+  }
+  return points;
+}
+
+bool waitForBuilds(const PointCloudRenderer& renderer, uint64_t builds) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (renderer.builds() < builds) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+TEST(PointCloudRenderer, RendersNothingWithoutCloud) {
+  PointCloudRenderer renderer(0.01, stiffMaterial());
+
+  SceneWrench wrench = renderer.render(translation(0, 0, 0));
+  EXPECT_EQ(0u, wrench.contacts);
+  EXPECT_THAT(wrench.O_F, Each(0.0));
+  EXPECT_EQ(0u, renderer.pointCount());
+  EXPECT_EQ(0u, renderer.builds());
+}
+
+TEST(PointCloudRenderer, PushesProbeOutOfCloud) {
+  PointCloudRenderer renderer(0.02, stiffMaterial());
+  std::vector<std::array<double, 3>> cloud = floorCloud(0.005);
+  renderer.update(cloud);
+  ASSERT_TRUE(waitForBuilds(renderer, 1));
+
+  SceneWrench wrench = renderer.render(translation(0.001, 0.002, 0.015));
+  // Voxels have an edge length of 0.01 m and contain four points each.
+  EXPECT_EQ(cloud.size() / 4, renderer.pointCount());
+  EXPECT_GT(wrench.contacts, 1u);
+  EXPECT_NEAR(0.005, wrench.max_penetration, 1e-9);
+  // The grid is symmetric enough about the probe for the normal to point up.
+  EXPECT_NEAR(0, wrench.O_F[0], 0.1);
+  EXPECT_NEAR(0, wrench.O_F[1], 0.1);
+  EXPECT_NEAR(5, wrench.O_F[2], 0.01);
+
+  wrench = renderer.render(translation(0, 0, 0.03));
+  EXPECT_EQ(0u, wrench.contacts);
+  EXPECT_THAT(wrench.O_F, Each(0.0));
+}
+
+TEST(PointCloudRenderer, ForceDoesNotDependOnPointDensity) {
+  PointCloudRenderer sparse(0.02, stiffMaterial());
+  PointCloudRenderer dense(0.02, stiffMaterial());
+  sparse.update(floorCloud(0.01));
+  dense.update(floorCloud(0.0025));
+  ASSERT_TRUE(waitForBuilds(sparse, 1));
+  ASSERT_TRUE(waitForBuilds(dense, 1));
+
+  SceneWrench sparse_wrench = sparse.render(translation(0, 0, 0.01));
+  SceneWrench dense_wrench = dense.render(translation(0, 0, 0.01));
+  EXPECT_LT(sparse_wrench.contacts, dense_wrench.contacts);
+  EXPECT_NEAR(sparse_wrench.O_F[2], dense_wrench.O_F[2], 0.01 * sparse_wrench.O_F[2]);
+}
+
+TEST(PointCloudRenderer, UsesCameraPoseAndProbeOffset) {
+  PointCloudRenderer renderer(0.02, stiffMaterial(), {{0, 0, 0.1}});
+  // The camera z axis is the base -x axis, so the cloud becomes a wall at x = 0.5.
+  std::array<double, 16> O_T_C{  // NOLINT(readability-identifier-naming)
+      {0, 0, 1, 0, 0, 1, 0, 0, -1, 0, 0, 0, 0.5, 0, 0, 1}};
+  renderer.update(floorCloud(0.005), O_T_C);
+  ASSERT_TRUE(waitForBuilds(renderer, 1));
+
+  SceneWrench wrench = renderer.render(translation(0.49, 0, -0.1));
+  EXPECT_NEAR(-10, wrench.O_F[0], 0.01);
+  EXPECT_NEAR(0, wrench.O_F[2], 0.1);
+  // Torque of the force at the probe offset about the end effector origin.
+  EXPECT_NEAR(-1, wrench.O_F[4], 0.01);
+}
+
+TEST(PointCloudRenderer, ReplacesCloudAndSkipsInvalidPoints) {
+  PointCloudRenderer renderer(0.02, stiffMaterial());
+  std::vector<std::array<double, 3>> cloud = floorCloud(0.005);
+  renderer.update(cloud);
+  ASSERT_TRUE(waitForBuilds(renderer, 1));
+  EXPECT_GT(renderer.render(translation(0, 0, 0.01)).contacts, 0u);
+
+  std::vector<std::array<double, 3>> moved{{{0, 0, 1}},
+                                           {{std::numeric_limits<double>::quiet_NaN(), 0, 0}},
+                                           {{0, std::numeric_limits<double>::infinity(), 0}}};
+  renderer.update(moved);
+  ASSERT_TRUE(waitForBuilds(renderer, 2));
+  EXPECT_EQ(0u, renderer.render(translation(0, 0, 0.01)).contacts);
+  EXPECT_EQ(1u, renderer.pointCount());
+  EXPECT_EQ(1u, renderer.render(translation(0, 0, 0.99)).contacts);
+}
+
+TEST(PointCloudRenderer, MergesPointsPerVoxel) {
+  PointCloudRenderer renderer(0.02, stiffMaterial());
+  std::vector<std::array<double, 3>> cloud(1000, {{0.001, 0.001, 0.001}});
+  cloud.push_back({{0.001, 0.001, 0.003}});
+  renderer.update(cloud);
+  ASSERT_TRUE(waitForBuilds(renderer, 1));
+
+  SceneWrench wrench = renderer.render(translation(0.001, 0.001, 0.011));
+  EXPECT_EQ(1u, renderer.pointCount());
+  EXPECT_EQ(1u, wrench.contacts);
+  EXPECT_NEAR(0.02 - (0.01 - 0.002 / 1001), wrench.max_penetration, 1e-9);
+}
+
+TEST(PointCloudRenderer, UpdatesWhileRendering) {
+  PointCloudRenderer renderer(0.02, stiffMaterial());
+  std::vector<std::array<double, 3>> cloud = floorCloud(0.002);
+
+  std::thread camera([&]() {
+    for (int i = 0; i < 20; i++) {
+      renderer.update(cloud, translation(0, 0, i % 2 == 0 ? 0 : -0.005));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  for (int i = 0; i < 2000; i++) {
+    SceneWrench wrench = renderer.render(translation(0, 0, 0.01));
+    ASSERT_TRUE(wrench.contacts == 0 || std::abs(wrench.O_F[2] - 10) < 0.01 ||
+                std::abs(wrench.O_F[2] - 5) < 0.01);
+  }
+  camera.join();
+  EXPECT_TRUE(waitForBuilds(renderer, 1));
+}
+
+TEST(PointCloudRenderer, ThrowsOnInvalidArguments) {
+  EXPECT_THROW(PointCloudRenderer(0), std::invalid_argument);
+  EXPECT_THROW(PointCloudRenderer(std::numeric_limits<double>::infinity()),
+               std::invalid_argument);
+  Material material;
+  material.stiffness = -1;
+  EXPECT_THROW(PointCloudRenderer(0.01, material), std::invalid_argument);
+  EXPECT_THROW(PointCloudRenderer(0.01, {}, {{std::nan(""), 0, 0}}), std::invalid_argument);
+
+  PointCloudRenderer renderer;
+  EXPECT_THROW(renderer.update({}, {}), std::invalid_argument);
+}
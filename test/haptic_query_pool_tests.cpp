@@ -0,0 +1,156 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/control_tools.h>
+#include <franka/haptic_query_pool.h>
+#include <franka/haptic_scene.h>
+
+#include "allocation_tracker.h"
+
+using franka::RealtimeConfig;
+using franka::haptics::ProbeQuery;
+using franka::haptics::QueryPool;
+using franka::haptics::QueryPoolOptions;
+using franka::haptics::QueryPoolStatistics;
+using franka::haptics::Scene;
+using franka::haptics::SceneWrench;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+// Pinning and prioritizing the workers may fail in tests, e.g. on machines with fewer CPUs.
+QueryPoolOptions testOptions(size_t workers) {
+  QueryPoolOptions options;
+  options.realtime_config = RealtimeConfig::kIgnore;
+  // Generous, so that workers on a loaded machine are not late.
+  options.join_timeout = std::chrono::milliseconds(100);
+  for (size_t i = 0; i < workers; i++) {
+    options.cpus.push_back(static_cast<int>(i));
+  }
+  return options;
+}
+
+// Probes spread over a scene with a floor and a sphere, some of them in contact.
+std::vector<ProbeQuery> probes(const Scene& scene, size_t count) {
+  std::vector<ProbeQuery> queries(count);
+  for (size_t i = 0; i < count; i++) {
+    queries[i].scene = &scene;
+    queries[i].O_T_EE = translation(0.01 * i, 0.3, 0.005 * (i % 5) - 0.01);
+    queries[i].velocity = {0, 0, -0.1};
+  }
+  return queries;
+}
+
+void expectEqual(const SceneWrench& expected, const SceneWrench& actual) {
+  EXPECT_EQ(expected.O_F, actual.O_F);
+  EXPECT_EQ(expected.contacts, actual.contacts);
+  EXPECT_EQ(expected.max_penetration, actual.max_penetration);
+}
+
+}  // anonymous namespace
+
+TEST(HapticQueryPool, RejectsInvalidOptions) {
+  QueryPoolOptions options;
+  options.cpus = {-1};
+  EXPECT_THROW(QueryPool{options}, std::invalid_argument);
+  options.cpus = {0, 0};
+  EXPECT_THROW(QueryPool{options}, std::invalid_argument);
+  options.cpus = {};
+  options.join_timeout = std::chrono::microseconds(-1);
+  EXPECT_THROW(QueryPool{options}, std::invalid_argument);
+}
+
+TEST(HapticQueryPool, MatchesSequentialQueries) {
+  Scene scene(0.01);
+  scene.addPlane({0, 0, 0}, {0, 0, 1});
+  scene.addSphere({0.5, 0.3, 0}, 0.1);
+  Scene other_scene(0.02);
+  other_scene.addPlane({0, 0, 0.01}, {0, 0, 1});
+
+  // Larger than kMaxQueries, so that the batch is run in chunks.
+  std::vector<ProbeQuery> queries = probes(scene, QueryPool::kMaxQueries + 40);
+  for (size_t i = 0; i < queries.size(); i += 3) {
+    queries[i].scene = &other_scene;
+  }
+  queries[1].scene = nullptr;
+
+  QueryPool pool(testOptions(2));
+  EXPECT_EQ(2u, pool.workers());
+  std::vector<SceneWrench> results(queries.size());
+  for (int repetition = 0; repetition < 10; repetition++) {
+    pool.run(queries.data(), queries.size(), results.data());
+    for (size_t i = 0; i < queries.size(); i++) {
+      SceneWrench expected = queries[i].scene != nullptr
+                                 ? queries[i].scene->query(queries[i].O_T_EE, queries[i].velocity)
+                                 : SceneWrench();
+      expectEqual(expected, results[i]);
+    }
+  }
+  EXPECT_EQ(0u, results[1].contacts);
+
+  QueryPoolStatistics statistics = pool.statistics();
+  EXPECT_EQ(20u, statistics.batches + statistics.serial_batches);
+}
+
+TEST(HapticQueryPool, RunsOnCallingThreadWithoutWorkers) {
+  Scene scene;
+  scene.addPlane({0, 0, 0}, {0, 0, 1});
+  std::vector<ProbeQuery> queries = probes(scene, 8);
+
+  QueryPool pool(testOptions(0));
+  EXPECT_EQ(0u, pool.workers());
+  std::vector<SceneWrench> results(queries.size());
+  pool.run(queries.data(), queries.size(), results.data());
+  for (size_t i = 0; i < queries.size(); i++) {
+    expectEqual(scene.query(queries[i].O_T_EE, queries[i].velocity), results[i]);
+  }
+  EXPECT_EQ(0u, pool.statistics().batches);
+}
+
+TEST(HapticQueryPool, RecomputesQueriesOfLateWorkers) {
+  Scene scene;
+  scene.addPlane({0, 0, 0}, {0, 0, 1});
+  std::vector<ProbeQuery> queries = probes(scene, 64);
+
+  // Without a join timeout and with a single CPU, workers rarely finish before the calling thread
+  // gives up on them. The results are complete nevertheless.
+  QueryPoolOptions options = testOptions(2);
+  options.join_timeout = std::chrono::microseconds(0);
+  QueryPool pool(options);
+  std::vector<SceneWrench> results(queries.size());
+  for (int repetition = 0; repetition < 100; repetition++) {
+    pool.run(queries.data(), queries.size(), results.data());
+    for (size_t i = 0; i < queries.size(); i++) {
+      expectEqual(scene.query(queries[i].O_T_EE, queries[i].velocity), results[i]);
+    }
+  }
+  QueryPoolStatistics statistics = pool.statistics();
+  EXPECT_EQ(100u, statistics.batches + statistics.serial_batches);
+  EXPECT_LE(statistics.recomputed_queries, statistics.batches * queries.size());
+}
+
+TEST(HapticQueryPool, RunDoesNotAllocate) {
+  Scene scene;
+  scene.addPlane({0, 0, 0}, {0, 0, 1});
+  scene.addSphere({0.2, 0.3, 0}, 0.05);
+  std::vector<ProbeQuery> queries = probes(scene, 32);
+  std::vector<SceneWrench> results(queries.size());
+
+  QueryPool pool(testOptions(1));
+  pool.run(queries.data(), queries.size(), results.data());
+
+  franka::AllocationTrackingScope allocation_tracking;
+  for (int repetition = 0; repetition < 10; repetition++) {
+    pool.run(queries.data(), queries.size(), results.data());
+  }
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
@@ -0,0 +1,319 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/haptic_scene.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::haptics::Material;
+using franka::haptics::Scene;
+using franka::haptics::SceneWrench;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+Material stiffMaterial() {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 0;
+  return material;
+}
+
+}  // anonymous namespace
+
+TEST(HapticScene, EmptySceneProducesNoForce) {
+  Scene scene;
+  EXPECT_EQ(0u, scene.size());
+
+  SceneWrench wrench = scene.query(translation(0.3, 0, 0.5));
+  EXPECT_THAT(wrench.O_F, Each(0.0));
+  EXPECT_EQ(0u, wrench.contacts);
+  EXPECT_EQ(0.0, wrench.max_penetration);
+}
+
+TEST(HapticScene, PlanePushesProbeOut) {
+  Scene scene(0.01);
+  EXPECT_EQ(0u, scene.addPlane({{0, 0, 0.5}}, {{0, 0, 2}}, stiffMaterial()));
+
+  SceneWrench free = scene.query(translation(0.3, 0, 0.52));
+  EXPECT_EQ(0u, free.contacts);
+  EXPECT_THAT(free.O_F, Each(0.0));
+
+  SceneWrench contact = scene.query(translation(0.3, 0, 0.505));
+  EXPECT_EQ(1u, contact.contacts);
+  EXPECT_NEAR(0.005, contact.max_penetration, 1e-12);
+  EXPECT_NEAR(0, contact.O_F[0], 1e-12);
+  EXPECT_NEAR(0, contact.O_F[1], 1e-12);
+  EXPECT_NEAR(5, contact.O_F[2], 1e-9);
+  // The contact point lies on the probe surface directly below the end effector.
+  EXPECT_NEAR(0, contact.O_F[3], 1e-12);
+  EXPECT_NEAR(0, contact.O_F[4], 1e-12);
+  EXPECT_NEAR(0, contact.O_F[5], 1e-12);
+}
+
+TEST(HapticScene, ProbeOffsetCreatesTorque) {
+  Scene scene(0, {{0.1, 0, 0}});
+  scene.addPlane({{0, 0, 0}}, {{0, 0, 1}}, stiffMaterial());
+
+  SceneWrench wrench = scene.query(translation(0, 0, -0.01));
+  EXPECT_EQ(1u, wrench.contacts);
+  EXPECT_NEAR(10, wrench.O_F[2], 1e-9);
+  // r = (0.1, 0, 0), F = (0, 0, 10) => r x F = (0, -1, 0)
+  EXPECT_NEAR(0, wrench.O_F[3], 1e-12);
+  EXPECT_NEAR(-1, wrench.O_F[4], 1e-9);
+  EXPECT_NEAR(0, wrench.O_F[5], 1e-12);
+}
+
+TEST(HapticScene, SphereContact) {
+  Scene scene(0.01);
+  scene.addSphere({{0.5, 0, 0.3}}, 0.1, stiffMaterial());
+
+  EXPECT_EQ(0u, scene.query(translation(0.5, 0, 0.45)).contacts);
+
+  SceneWrench wrench = scene.query(translation(0.5, 0, 0.405));
+  EXPECT_EQ(1u, wrench.contacts);
+  EXPECT_NEAR(0.005, wrench.max_penetration, 1e-12);
+  EXPECT_NEAR(5, wrench.O_F[2], 1e-9);
+  EXPECT_NEAR(0, wrench.O_F[0], 1e-12);
+}
+
+TEST(HapticScene, BoxContact) {
+  Scene scene(0.01);
+  // Box rotated by 90 degrees around z.
+  std::array<double, 16> pose{{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.5, 0, 0.2, 1}};
+  scene.addBox(pose, {{0.2, 0.05, 0.1}}, stiffMaterial());
+
+  // The short extent now points along x of the base frame.
+  SceneWrench side = scene.query(translation(0.557, 0, 0.2));
+  EXPECT_EQ(1u, side.contacts);
+  EXPECT_NEAR(3, side.O_F[0], 1e-9);
+  EXPECT_NEAR(0, side.O_F[1], 1e-9);
+
+  EXPECT_EQ(0u, scene.query(translation(0.5, 0.22, 0.31)).contacts);
+
+  SceneWrench top = scene.query(translation(0.5, 0.1, 0.308));
+  EXPECT_EQ(1u, top.contacts);
+  EXPECT_NEAR(2, top.O_F[2], 1e-9);
+
+  // Inside the box, the probe is pushed out through the closest face.
+  SceneWrench inside = scene.query(translation(0.5, 0.16, 0.2));
+  EXPECT_EQ(1u, inside.contacts);
+  EXPECT_NEAR(0.05, inside.max_penetration, 1e-12);
+  EXPECT_NEAR(50, inside.O_F[1], 1e-9);
+}
+
+TEST(HapticScene, CapsuleContact) {
+  Scene scene(0.01);
+  scene.addCapsule({{0, 0, 0}}, {{0, 0, 0.4}}, 0.05, stiffMaterial());
+
+  SceneWrench side = scene.query(translation(0.058, 0, 0.2));
+  EXPECT_EQ(1u, side.contacts);
+  EXPECT_NEAR(2, side.O_F[0], 1e-9);
+
+  // The cap is rounded.
+  SceneWrench cap = scene.query(translation(0, 0, 0.455));
+  EXPECT_EQ(1u, cap.contacts);
+  EXPECT_NEAR(5, cap.O_F[2], 1e-9);
+
+  EXPECT_EQ(0u, scene.query(translation(0.05, 0, 0.45)).contacts);
+}
+
+TEST(HapticScene, CylinderContact) {
+  Scene scene(0.01);
+  scene.addCylinder({{0, 0, 0}}, {{0, 0, 0.4}}, 0.05, stiffMaterial());
+
+  SceneWrench side = scene.query(translation(0.058, 0, 0.2));
+  EXPECT_EQ(1u, side.contacts);
+  EXPECT_NEAR(2, side.O_F[0], 1e-9);
+
+  // The cap is flat.
+  SceneWrench cap = scene.query(translation(0.04, 0, 0.405));
+  EXPECT_EQ(1u, cap.contacts);
+  EXPECT_NEAR(5, cap.O_F[2], 1e-9);
+  EXPECT_NEAR(0, cap.O_F[0], 1e-9);
+
+  // Next to the rim, the probe is pushed away diagonally.
+  SceneWrench rim = scene.query(translation(0.055, 0, 0.405));
+  EXPECT_EQ(1u, rim.contacts);
+  EXPECT_NEAR(rim.O_F[0], rim.O_F[2], 1e-9);
+  EXPECT_GT(rim.O_F[0], 0);
+}
+
+TEST(HapticScene, DampingOpposesApproach) {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 100;
+  Scene scene(0.01);
+  scene.addPlane({{0, 0, 0}}, {{0, 0, 1}}, material);
+
+  SceneWrench approaching = scene.query(translation(0, 0, 0.005), {{0, 0, -0.01}});
+  EXPECT_NEAR(6, approaching.O_F[2], 1e-9);
+
+  SceneWrench retracting = scene.query(translation(0, 0, 0.005), {{0, 0, 0.01}});
+  EXPECT_NEAR(4, retracting.O_F[2], 1e-9);
+
+  // Contacts never pull the probe.
+  SceneWrench fast = scene.query(translation(0, 0, 0.005), {{0, 0, 1}});
+  EXPECT_EQ(0.0, fast.O_F[2]);
+}
+
+TEST(HapticScene, ForcesOfMultipleContactsAdd) {
+  Scene scene(0.01);
+  scene.addPlane({{0, 0, 0}}, {{0, 0, 1}}, stiffMaterial());
+  scene.addPlane({{0, 0, 0}}, {{1, 0, 0}}, stiffMaterial());
+
+  SceneWrench wrench = scene.query(translation(0.005, 0, 0.008));
+  EXPECT_EQ(2u, wrench.contacts);
+  EXPECT_NEAR(5, wrench.O_F[0], 1e-9);
+  EXPECT_NEAR(2, wrench.O_F[2], 1e-9);
+  EXPECT_NEAR(0.005, wrench.max_penetration, 1e-12);
+}
+
+TEST(HapticScene, HierarchyMatchesSeparateScenes) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> position(-1, 1);
+  std::uniform_real_distribution<double> size(0.02, 0.2);
+
+  Scene scene(0.05);
+  std::vector<Scene> separate_scenes;
+  for (size_t i = 0; i < 200; i++) {
+    std::array<double, 3> a{{position(generator), position(generator), position(generator)}};
+    std::array<double, 3> b{{a[0] + size(generator), a[1] - size(generator), a[2]}};
+    double radius = size(generator);
+    separate_scenes.emplace_back(0.05);
+    switch (i % 4) {
+      case 0:
+        EXPECT_EQ(i, scene.addSphere(a, radius));
+        separate_scenes.back().addSphere(a, radius);
+        break;
+      case 1:
+        EXPECT_EQ(i, scene.addBox(translation(a[0], a[1], a[2]), {{radius, radius / 2, 0.1}}));
+        separate_scenes.back().addBox(translation(a[0], a[1], a[2]), {{radius, radius / 2, 0.1}});
+        break;
+      case 2:
+        EXPECT_EQ(i, scene.addCapsule(a, b, radius));
+        separate_scenes.back().addCapsule(a, b, radius);
+        break;
+      case 3:
+        EXPECT_EQ(i, scene.addCylinder(a, b, radius));
+        separate_scenes.back().addCylinder(a, b, radius);
+        break;
+    }
+  }
+  EXPECT_EQ(200u, scene.size());
+
+  size_t total_contacts = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    std::array<double, 16> pose =
+        translation(position(generator), position(generator), position(generator));
+    SceneWrench wrench = scene.query(pose);
+
+    std::array<double, 6> expected_wrench{};
+    size_t expected_contacts = 0;
+    for (const Scene& separate_scene : separate_scenes) {
+      SceneWrench single_wrench = separate_scene.query(pose);
+      expected_contacts += single_wrench.contacts;
+      for (size_t j = 0; j < 6; j++) {
+        expected_wrench[j] += single_wrench.O_F[j];
+      }
+    }
+    ASSERT_EQ(expected_contacts, wrench.contacts);
+    for (size_t j = 0; j < 6; j++) {
+      EXPECT_NEAR(expected_wrench[j], wrench.O_F[j], 1e-9);
+    }
+    total_contacts += wrench.contacts;
+  }
+  EXPECT_GT(total_contacts, 0u);
+
+  scene.clear();
+  EXPECT_EQ(0u, scene.size());
+  EXPECT_EQ(0u, scene.query(translation(0, 0, 0)).contacts);
+}
+
+TEST(HapticScene, UsesEndEffectorPoseOfRobotState) {
+  Scene scene(0.01);
+  scene.addPlane({{0, 0, 0.5}}, {{0, 0, 1}}, stiffMaterial());
+
+  franka::RobotState robot_state;
+  robot_state.O_T_EE = translation(0.3, 0, 0.505);
+  EXPECT_NEAR(5, scene.query(robot_state).O_F[2], 1e-9);
+}
+
+TEST(HapticScene, ThrowsOnInvalidArguments) {
+  const double kNaN = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(Scene(-0.01), std::invalid_argument);
+  EXPECT_THROW(Scene(0.01, {{kNaN, 0, 0}}), std::invalid_argument);
+
+  Scene scene;
+  EXPECT_THROW(scene.addPlane({{0, 0, 0}}, {{0, 0, 0}}), std::invalid_argument);
+  EXPECT_THROW(scene.addPlane({{kNaN, 0, 0}}, {{0, 0, 1}}), std::invalid_argument);
+  EXPECT_THROW(scene.addSphere({{0, 0, 0}}, 0), std::invalid_argument);
+  EXPECT_THROW(scene.addSphere({{0, 0, 0}}, kNaN), std::invalid_argument);
+  EXPECT_THROW(scene.addBox(translation(0, 0, 0), {{0.1, 0, 0.1}}), std::invalid_argument);
+  std::array<double, 16> invalid_pose = translation(0, 0, 0);
+  invalid_pose[0] = 2;
+  EXPECT_THROW(scene.addBox(invalid_pose, {{0.1, 0.1, 0.1}}), std::invalid_argument);
+  EXPECT_THROW(scene.addCapsule({{0, 0, 0}}, {{0, 0, 1}}, -1), std::invalid_argument);
+  EXPECT_THROW(scene.addCylinder({{0, 0, 0}}, {{0, 0, 0}}, 0.1), std::invalid_argument);
+
+  Material material;
+  material.stiffness = -1;
+  EXPECT_THROW(scene.addSphere({{0, 0, 0}}, 0.1, material), std::invalid_argument);
+
+  EXPECT_EQ(0u, scene.size());
+}
+
+TEST(HapticScene, ReportsContacts) {
+  Scene scene(0.01);
+  scene.addPlane({{0, 0, 0}}, {{0, 0, 1}}, stiffMaterial());
+  EXPECT_EQ(1u, scene.addSphere({{0.5, 0, 0}}, 0.1, stiffMaterial()));
+  EXPECT_EQ(2u, scene.addSphere({{0.3, 0, 0.105}}, 0.1, stiffMaterial()));
+
+  franka::haptics::ContactSet contacts;
+  contacts.size = 5;
+  SceneWrench wrench = scene.query(translation(0.3, 0, 0.005), {}, &contacts);
+  ASSERT_EQ(2u, contacts.size);
+  EXPECT_EQ(wrench.contacts, contacts.size);
+  EXPECT_THAT(wrench.O_F, Pointwise(DoubleNear(1e-9), scene.query(translation(0.3, 0, 0.005)).O_F));
+
+  const franka::haptics::Contact& plane = contacts.contacts[0];
+  EXPECT_EQ(0u, plane.primitive);
+  EXPECT_NEAR(0.005, plane.penetration, 1e-12);
+  EXPECT_NEAR(5, plane.normal_force, 1e-9);
+  EXPECT_NEAR(-0.005, plane.point[2], 1e-12);
+  EXPECT_NEAR(1, plane.normal[2], 1e-12);
+
+  const franka::haptics::Contact& sphere = contacts.contacts[1];
+  EXPECT_EQ(2u, sphere.primitive);
+  EXPECT_NEAR(0.01, sphere.penetration, 1e-12);
+  EXPECT_NEAR(-1, sphere.normal[2], 1e-12);
+  EXPECT_DOUBLE_EQ(1000, sphere.material.stiffness);
+
+  scene.query(translation(0.3, 0, 0.5), {}, &contacts);
+  EXPECT_EQ(0u, contacts.size);
+}
+
+TEST(HapticScene, MapsWrenchToJointTorques) {
+  std::array<double, 42> zero_jacobian{};
+  for (size_t i = 0; i < zero_jacobian.size(); i++) {
+    zero_jacobian[i] = static_cast<double>(i);
+  }
+  std::array<double, 6> wrench{{1, 0, 0, 0, 0, 2}};
+
+  std::array<double, 7> tau = franka::haptics::wrenchToJointTorques(zero_jacobian, wrench);
+  for (size_t joint = 0; joint < 7; joint++) {
+    EXPECT_DOUBLE_EQ(6.0 * joint + 2 * (6.0 * joint + 5), tau[joint]);
+  }
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/haptic_surface.h>
+
+using namespace ::testing;
+
+using franka::haptics::ContactSet;
+using franka::haptics::FrictionState;
+using franka::haptics::Material;
+using franka::haptics::Scene;
+using franka::haptics::SceneWrench;
+using franka::haptics::SurfaceMaterial;
+using franka::haptics::SurfaceRenderer;
+using franka::haptics::SurfaceTexture;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+// Floor at z = 0 with a probe of 1 cm, so a probe at z = 0.005 is pressed with 5 N.
+Scene floorScene() {
+  Material material;
+  material.stiffness = 1000;
+  material.damping = 0;
+  Scene scene(0.01);
+  scene.addPlane({{0, 0, 0}}, {{0, 0, 1}}, material);
+  return scene;
+}
+
+SurfaceMaterial frictionMaterial() {
+  SurfaceMaterial material;
+  material.static_friction = 0.5;
+  material.kinetic_friction = 0.4;
+  material.tangential_stiffness = 1000;
+  material.tangential_damping = 0;
+  return material;
+}
+
+}  // anonymous namespace
+
+TEST(HapticSurface, TextureInterpolatesHeightAndGradient) {
+  SurfaceTexture texture = SurfaceTexture::grating(0.01, 0.001, 64);
+  EXPECT_EQ(0.01, texture.period());
+  EXPECT_EQ(64u, texture.resolution());
+
+  for (double u : {0.0, 0.0013, 0.0025, 0.0071, -0.0032, 0.0413}) {
+    std::array<double, 2> gradient;
+    double height = texture.height(u, 0.003, &gradient);
+    double phase = 2 * M_PI * u / 0.01;
+    EXPECT_NEAR(0.001 * std::sin(phase), height, 2e-6) << u;
+    EXPECT_NEAR(0.001 * 2 * M_PI / 0.01 * std::cos(phase), gradient[0], 0.02) << u;
+    EXPECT_NEAR(0, gradient[1], 1e-9) << u;
+  }
+  EXPECT_DOUBLE_EQ(texture.height(0.0037, 0), texture.height(0.0037 + 3 * 0.01, 0.02));
+}
+
+TEST(HapticSurface, NoiseTextureStaysWithinAmplitude) {
+  SurfaceTexture texture = SurfaceTexture::noise(0.005, 0.0002, 7);
+  EXPECT_EQ(0.02, texture.period());
+  double lowest = 0;
+  double highest = 0;
+  for (double u = 0; u < 0.04; u += 0.0007) {
+    for (double v = 0; v < 0.04; v += 0.0009) {
+      double height = texture.height(u, v);
+      lowest = std::min(lowest, height);
+      highest = std::max(highest, height);
+    }
+  }
+  EXPECT_GE(lowest, -0.0002 - 1e-9);
+  EXPECT_LE(highest, 0.0002 + 1e-9);
+  EXPECT_LT(lowest, -0.00002);
+  EXPECT_GT(highest, 0.00002);
+
+  SurfaceTexture same = SurfaceTexture::noise(0.005, 0.0002, 7);
+  SurfaceTexture other = SurfaceTexture::noise(0.005, 0.0002, 8);
+  EXPECT_EQ(texture.height(0.0031, 0.0077), same.height(0.0031, 0.0077));
+  EXPECT_NE(texture.height(0.0031, 0.0077), other.height(0.0031, 0.0077));
+}
+
+TEST(HapticSurface, RejectsInvalidParameters) {
+  constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(SurfaceTexture(nullptr, 0.01), std::invalid_argument);
+  EXPECT_THROW(SurfaceTexture([](double, double) { return 0.0; }, 0), std::invalid_argument);
+  EXPECT_THROW(SurfaceTexture([](double, double) { return 0.0; }, 0.01, 48),
+               std::invalid_argument);
+  EXPECT_THROW(SurfaceTexture([](double, double) { return 0.0; }, 0.01, 512),
+               std::invalid_argument);
+  EXPECT_THROW(SurfaceTexture([](double, double) { return kNaN; }, 0.01), std::invalid_argument);
+  EXPECT_THROW(SurfaceTexture::grating(-0.01, 0.001), std::invalid_argument);
+
+  SurfaceRenderer renderer;
+  SurfaceMaterial material;
+  material.kinetic_friction = 0.6;
+  EXPECT_THROW(renderer.addMaterial(material), std::invalid_argument);
+  material.kinetic_friction = 0.4;
+  material.tangential_stiffness = kNaN;
+  EXPECT_THROW(renderer.addMaterial(material), std::invalid_argument);
+  EXPECT_THROW(renderer.assign(0, 0), std::invalid_argument);
+}
+
+TEST(HapticSurface, UnassignedPrimitivesKeepSceneWrench) {
+  Scene scene = floorScene();
+  SurfaceRenderer renderer;
+  renderer.addMaterial(frictionMaterial());
+
+  SceneWrench expected = scene.query(translation(0.3, 0, 0.005));
+  SceneWrench wrench = renderer.render(scene, translation(0.3, 0, 0.005));
+  EXPECT_EQ(expected.O_F, wrench.O_F);
+  EXPECT_EQ(FrictionState::kNone, renderer.frictionState(0));
+}
+
+TEST(HapticSurface, FrictionSticksThenSlips) {
+  Scene scene = floorScene();
+  SurfaceRenderer renderer;
+  renderer.assign(0, renderer.addMaterial(frictionMaterial()));
+
+  SceneWrench wrench = renderer.render(scene, translation(0.3, 0, 0.005));
+  EXPECT_EQ(FrictionState::kStick, renderer.frictionState(0));
+  EXPECT_NEAR(0, wrench.O_F[0], 1e-12);
+  EXPECT_NEAR(5, wrench.O_F[2], 1e-9);
+
+  // 2 mm of stretch need 2 N, which is inside the static friction cone of 2.5 N.
+  wrench = renderer.render(scene, translation(0.302, 0, 0.005));
+  EXPECT_EQ(FrictionState::kStick, renderer.frictionState(0));
+  EXPECT_NEAR(-2, wrench.O_F[0], 1e-9);
+  EXPECT_NEAR(0, wrench.O_F[1], 1e-9);
+  // The friction force acts at the contact point 1 cm below the end effector.
+  EXPECT_NEAR(0.02, wrench.O_F[4], 1e-9);
+
+  // 3 mm would need 3 N, so the contact slips and is held by kinetic friction of 2 N.
+  wrench = renderer.render(scene, translation(0.303, 0, 0.005));
+  EXPECT_EQ(FrictionState::kSlip, renderer.frictionState(0));
+  EXPECT_NEAR(-2, wrench.O_F[0], 1e-9);
+
+  wrench = renderer.render(scene, translation(0.31, 0, 0.005));
+  EXPECT_EQ(FrictionState::kSlip, renderer.frictionState(0));
+  EXPECT_NEAR(-2, wrench.O_F[0], 1e-9);
+
+  // Moving back relaxes the spring below the kinetic limit, so the contact sticks again.
+  wrench = renderer.render(scene, translation(0.3095, 0, 0.005));
+  EXPECT_EQ(FrictionState::kStick, renderer.frictionState(0));
+  EXPECT_NEAR(-1.5, wrench.O_F[0], 1e-9);
+
+  // Lifting off releases the contact, and the next touch anchors at the new point.
+  renderer.render(scene, translation(0.3, 0, 0.05));
+  EXPECT_EQ(FrictionState::kNone, renderer.frictionState(0));
+  wrench = renderer.render(scene, translation(0.35, 0, 0.005));
+  EXPECT_EQ(FrictionState::kStick, renderer.frictionState(0));
+  EXPECT_NEAR(0, wrench.O_F[0], 1e-12);
+
+  renderer.render(scene, translation(0.351, 0, 0.005));
+  renderer.reset();
+  wrench = renderer.render(scene, translation(0.352, 0, 0.005));
+  EXPECT_NEAR(0, wrench.O_F[0], 1e-12);
+}
+
+TEST(HapticSurface, TextureModulatesNormalForce) {
+  Scene scene = floorScene();
+  SurfaceMaterial material;
+  material.texture = std::make_shared<SurfaceTexture>(SurfaceTexture::grating(0.008, 0.001));
+  material.static_friction = 0;
+  material.kinetic_friction = 0;
+  material.tangential_stiffness = 0;
+  SurfaceRenderer renderer;
+  renderer.assign(0, renderer.addMaterial(material));
+
+  // The tangent basis of the floor has u along y and v along -x.
+  ContactSet contacts;
+  SceneWrench wrench = scene.query(translation(0.3, 0.002, 0.005), {}, &contacts);
+  ASSERT_EQ(1u, contacts.size);
+  SceneWrench ridge = renderer.render(wrench, contacts, translation(0.3, 0.002, 0.005));
+  EXPECT_NEAR(6, ridge.O_F[2], 1e-3);
+  EXPECT_NEAR(0, ridge.O_F[1], 1e-3);
+
+  SceneWrench valley = renderer.render(scene, translation(0.3, -0.002, 0.005));
+  EXPECT_NEAR(4, valley.O_F[2], 1e-3);
+
+  // On the rising flank, the tilted normal pushes the probe down the slope towards -y.
+  SceneWrench flank = renderer.render(scene, translation(0.3, 0, 0.005));
+  double slope = 0.001 * 2 * M_PI / 0.008;
+  EXPECT_NEAR(5, std::hypot(flank.O_F[1], flank.O_F[2]), 0.05);
+  EXPECT_NEAR(-slope, flank.O_F[1] / flank.O_F[2], 0.02);
+  EXPECT_EQ(FrictionState::kStick, renderer.frictionState(0));
+}
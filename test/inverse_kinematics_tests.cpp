@@ -0,0 +1,208 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/inverse_kinematics.h>
+
+using namespace ::testing;
+
+using franka::InverseKinematics;
+using franka::InverseKinematicsSolutions;
+
+namespace {
+
+constexpr std::array<double, 7> kReady{{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+
+// Franka Hand, rotated about the flange axis and offset along it.
+const std::array<double, 16> kFrankaHand{{M_SQRT1_2, -M_SQRT1_2, 0, 0, M_SQRT1_2, M_SQRT1_2, 0, 0,
+                                          0, 0, 1, 0, 0, 0, 0.1034, 1}};
+
+// Forward kinematics from the modified Denavit-Hartenberg parameters of the Panda.
+std::array<double, 16> forwardKinematics(const std::array<double, 7>& q,
+                                         const std::array<double, 16>& F_T_EE) {
+  const std::array<double, 8> a{{0, 0, 0, 0.0825, -0.0825, 0, 0.088, 0}};
+  const std::array<double, 8> d{{0.333, 0, 0.316, 0, 0.384, 0, 0, 0.107}};
+  const std::array<double, 8> alpha{{0, -M_PI_2, M_PI_2, M_PI_2, -M_PI_2, M_PI_2, M_PI_2, 0}};
+  Eigen::Affine3d transform = Eigen::Affine3d::Identity();
+  for (size_t i = 0; i < a.size(); i++) {
+    transform = transform * Eigen::AngleAxisd(alpha[i], Eigen::Vector3d::UnitX()) *
+                Eigen::Translation3d(a[i], 0, 0) *
+                Eigen::AngleAxisd(i < q.size() ? q[i] : 0, Eigen::Vector3d::UnitZ()) *
+                Eigen::Translation3d(0, 0, d[i]);
+  }
+  std::array<double, 16> O_T_EE{};  // NOLINT(readability-identifier-naming)
+  Eigen::Map<Eigen::Matrix4d>(O_T_EE.data()) =
+      transform.matrix() * Eigen::Matrix4d::Map(F_T_EE.data());
+  return O_T_EE;
+}
+
+std::array<double, 16> forwardKinematics(const std::array<double, 7>& q) {
+  return forwardKinematics(q, {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}});
+}
+
+double maxDifference(const std::array<double, 7>& a, const std::array<double, 7>& b) {
+  double result = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    result = std::max(result, std::abs(a[i] - b[i]));
+  }
+  return result;
+}
+
+std::array<double, 7> randomJointPositions(std::mt19937* generator) {
+  // Stay clear of the limits, where a solution may be discarded due to rounding.
+  const double margin = 0.01;
+  std::array<double, 7> q{};
+  for (size_t i = 0; i < q.size(); i++) {
+    std::uniform_real_distribution<double> distribution(franka::kMinJointPosition[i] + margin,
+                                                        franka::kMaxJointPosition[i] - margin);
+    q[i] = distribution(*generator);
+  }
+  return q;
+}
+
+}  // anonymous namespace
+
+TEST(InverseKinematics, FindsAllConfigurationsOfRandomPoses) {
+  std::mt19937 generator(42);
+  for (bool hand : {false, true}) {
+    InverseKinematics inverse_kinematics =
+        hand ? InverseKinematics(kFrankaHand) : InverseKinematics();
+    for (size_t i = 0; i < 500; i++) {
+      std::array<double, 7> q = randomJointPositions(&generator);
+      std::array<double, 16> pose =
+          hand ? forwardKinematics(q, kFrankaHand) : forwardKinematics(q);
+
+      InverseKinematicsSolutions solutions = inverse_kinematics.solve(pose, q[6], kReady);
+      ASSERT_GE(solutions.size, 1u);
+      ASSERT_LE(solutions.size, InverseKinematicsSolutions::kMaxSolutions);
+
+      bool found = false;
+      for (size_t j = 0; j < solutions.size; j++) {
+        const std::array<double, 7>& solution = solutions.q[j];
+        found = found || maxDifference(solution, q) < 1e-6;
+        std::array<double, 16> solution_pose =
+            hand ? forwardKinematics(solution, kFrankaHand) : forwardKinematics(solution);
+        for (size_t k = 0; k < pose.size(); k++) {
+          EXPECT_NEAR(pose[k], solution_pose[k], 1e-9);
+        }
+        for (size_t k = 0; k < solution.size(); k++) {
+          EXPECT_GE(solution[k], franka::kMinJointPosition[k]);
+          EXPECT_LE(solution[k], franka::kMaxJointPosition[k]);
+        }
+        EXPECT_DOUBLE_EQ(q[6], solution[6]);
+      }
+      EXPECT_TRUE(found) << "Configuration " << i << " not found.";
+    }
+  }
+}
+
+TEST(InverseKinematics, OrdersSolutionsByDistanceToReference) {
+  InverseKinematics inverse_kinematics;
+  std::array<double, 7> q{{0.5, 0.3, -0.4, -1.8, 0.6, 1.9, 0.2}};
+  std::array<double, 16> pose = forwardKinematics(q);
+
+  InverseKinematicsSolutions solutions = inverse_kinematics.solve(pose, q[6], q);
+  ASSERT_GE(solutions.size, 2u);
+  EXPECT_LT(maxDifference(solutions.q[0], q), 1e-9);
+  for (size_t i = 0; i < solutions.size; i++) {
+    InverseKinematicsSolutions reordered = inverse_kinematics.solve(pose, q[6], solutions.q[i]);
+    ASSERT_EQ(solutions.size, reordered.size);
+    EXPECT_LT(maxDifference(solutions.q[i], reordered.q[0]), 1e-9);
+  }
+}
+
+TEST(InverseKinematics, SolveClosestFollowsCurrentConfiguration) {
+  InverseKinematics inverse_kinematics(kFrankaHand);
+  std::array<double, 7> q_current = kReady;
+  for (size_t i = 1; i <= 100; i++) {
+    std::array<double, 7> q_target = kReady;
+    q_target[0] += 0.005 * i;
+    q_target[3] += 0.003 * i;
+    std::array<double, 16> pose = forwardKinematics(q_target, kFrankaHand);
+
+    std::array<double, 7> q{};
+    ASSERT_TRUE(inverse_kinematics.solveClosest(pose, q_current[6], q_current, &q));
+    EXPECT_LT(maxDifference(q, q_target), 1e-9);
+    q_current = q;
+  }
+}
+
+TEST(InverseKinematics, RejectsUnreachablePoses) {
+  InverseKinematics inverse_kinematics;
+  std::array<double, 16> pose = forwardKinematics(kReady);
+  std::array<double, 16> far_away = pose;
+  far_away[12] = 2.0;
+
+  EXPECT_EQ(0u, inverse_kinematics.solve(far_away, kReady[6], kReady).size);
+  EXPECT_EQ(0u, inverse_kinematics.solve(pose, 3.0, kReady).size);
+  pose[0] = NAN;
+  EXPECT_EQ(0u, inverse_kinematics.solve(pose, kReady[6], kReady).size);
+
+  std::array<double, 7> q = kReady;
+  q[0] = 1.0;
+  EXPECT_FALSE(inverse_kinematics.solveClosest(far_away, kReady[6], kReady, &q));
+  EXPECT_EQ(1.0, q[0]);
+}
+
+TEST(InverseKinematics, RespectsGivenJointLimits) {
+  std::array<double, 7> min_joint_position = franka::kMinJointPosition;
+  std::array<double, 7> max_joint_position = franka::kMaxJointPosition;
+  min_joint_position[0] = -0.1;
+  max_joint_position[0] = 0.1;
+  InverseKinematics inverse_kinematics(kFrankaHand, min_joint_position, max_joint_position);
+
+  InverseKinematicsSolutions solutions =
+      inverse_kinematics.solve(forwardKinematics(kReady, kFrankaHand), kReady[6], kReady);
+  ASSERT_GE(solutions.size, 1u);
+  for (size_t i = 0; i < solutions.size; i++) {
+    EXPECT_GE(solutions.q[i][0], -0.1);
+    EXPECT_LE(solutions.q[i][0], 0.1);
+  }
+}
+
+TEST(InverseKinematics, SolveBatchMatchesSingleQueries) {
+  InverseKinematics inverse_kinematics(kFrankaHand);
+  std::mt19937 generator(7);
+  std::vector<std::array<double, 16>> poses;
+  std::vector<double> q7;
+  for (size_t i = 0; i < 100; i++) {
+    std::array<double, 7> q = randomJointPositions(&generator);
+    poses.push_back(forwardKinematics(q, kFrankaHand));
+    q7.push_back(q[6]);
+  }
+
+  for (size_t thread_count : {1u, 3u}) {
+    std::vector<InverseKinematicsSolutions> solutions =
+        inverse_kinematics.solveBatch(poses, q7, kReady, thread_count);
+    ASSERT_EQ(poses.size(), solutions.size());
+    for (size_t i = 0; i < poses.size(); i++) {
+      InverseKinematicsSolutions expected = inverse_kinematics.solve(poses[i], q7[i], kReady);
+      ASSERT_EQ(expected.size, solutions[i].size);
+      for (size_t j = 0; j < expected.size; j++) {
+        EXPECT_EQ(expected.q[j], solutions[i].q[j]);
+      }
+    }
+  }
+
+  q7.pop_back();
+  EXPECT_THROW(inverse_kinematics.solveBatch(poses, q7, kReady), std::invalid_argument);
+}
+
+TEST(InverseKinematics, ThrowsOnInvalidParameters) {
+  std::array<double, 16> invalid_pose = kFrankaHand;
+  invalid_pose[3] = 1;
+  EXPECT_THROW(InverseKinematics{invalid_pose}, std::invalid_argument);
+
+  std::array<double, 7> min_joint_position = franka::kMinJointPosition;
+  min_joint_position[2] = 3;
+  EXPECT_THROW(InverseKinematics(kFrankaHand, min_joint_position, franka::kMaxJointPosition),
+               std::invalid_argument);
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "jitter_buffer.h"
+
+using franka::JitterBuffer;
+
+namespace {
+
+const std::chrono::steady_clock::time_point kNow{};
+
+}  // anonymous namespace
+
+TEST(JitterBuffer, StartsPlayoutAfterDepthSamples) {
+  JitterBuffer<int> buffer(2);
+  int sample = -1;
+  EXPECT_FALSE(buffer.pop(&sample, kNow));
+
+  buffer.push(10, 10, kNow);
+  EXPECT_FALSE(buffer.pop(&sample, kNow));
+  buffer.push(11, 11, kNow);
+  EXPECT_FALSE(buffer.pop(&sample, kNow));
+  buffer.push(12, 12, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(10, sample);
+  EXPECT_EQ(2u, buffer.buffered());
+  EXPECT_EQ(0u, buffer.underruns());
+
+  buffer.push(13, 13, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(11, sample);
+}
+
+TEST(JitterBuffer, ReordersSamples) {
+  JitterBuffer<int> buffer(2);
+  buffer.push(1, 1, kNow);
+  buffer.push(3, 3, kNow);
+  buffer.push(2, 2, kNow);
+
+  int sample = 0;
+  for (int expected = 1; expected <= 3; expected++) {
+    EXPECT_TRUE(buffer.pop(&sample, kNow));
+    EXPECT_EQ(expected, sample);
+  }
+  EXPECT_EQ(3u, buffer.received());
+  EXPECT_EQ(0u, buffer.lost());
+}
+
+TEST(JitterBuffer, HoldsPositionOnUnderrun) {
+  JitterBuffer<int> buffer(0);
+  int sample = 0;
+  buffer.push(0, 0, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+
+  EXPECT_FALSE(buffer.pop(&sample, kNow));
+  EXPECT_FALSE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(2u, buffer.underruns());
+  EXPECT_EQ(0, sample);
+
+  buffer.push(1, 1, kNow);
+  buffer.push(2, 2, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(1, sample);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(2, sample);
+  EXPECT_EQ(0u, buffer.lost());
+}
+
+TEST(JitterBuffer, WaitsForMissingSampleWithinDepth) {
+  JitterBuffer<int> buffer(2);
+  int sample = 0;
+  for (int i = 0; i < 3; i++) {
+    buffer.push(i, i, kNow);
+  }
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  buffer.push(4, 4, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(2, sample);
+
+  EXPECT_FALSE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(1u, buffer.underruns());
+  EXPECT_TRUE(buffer.push(3, 3, kNow));
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(3, sample);
+  EXPECT_EQ(0u, buffer.lost());
+}
+
+TEST(JitterBuffer, CountsLostAndLateSamples) {
+  JitterBuffer<int> buffer(1);
+  int sample = 0;
+  buffer.push(0, 0, kNow);
+  buffer.push(1, 1, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(1, sample);
+
+  buffer.push(3, 3, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(3, sample);
+  EXPECT_EQ(1u, buffer.lost());
+
+  EXPECT_FALSE(buffer.push(2, 2, kNow));
+  EXPECT_EQ(1u, buffer.late());
+  buffer.push(4, 4, kNow);
+  EXPECT_FALSE(buffer.push(4, 4, kNow));
+  EXPECT_EQ(4u, buffer.received());
+}
+
+TEST(JitterBuffer, SkipsAheadWhenTooFarBehind) {
+  JitterBuffer<int, 16> buffer(2);
+  int sample = 0;
+  for (int i = 0; i < 10; i++) {
+    buffer.push(i, i, kNow);
+  }
+  EXPECT_TRUE(buffer.pop(&sample, kNow));
+  EXPECT_EQ(7, sample);
+  EXPECT_EQ(7u, buffer.skipped());
+  EXPECT_EQ(2u, buffer.buffered());
+}
+
+TEST(JitterBuffer, HandlesSequenceWraparound) {
+  JitterBuffer<uint32_t> buffer(1);
+  uint32_t sample = 0;
+  for (uint32_t i = 0; i < 6; i++) {
+    uint32_t sequence = UINT32_MAX - 2 + i;
+    buffer.push(sequence, sequence, kNow);
+    if (i > 0) {
+      EXPECT_TRUE(buffer.pop(&sample, kNow));
+      EXPECT_EQ(sequence - 1, sample);
+    }
+  }
+  EXPECT_EQ(0u, buffer.lost());
+  EXPECT_EQ(0u, buffer.late());
+}
+
+TEST(JitterBuffer, MeasuresPlayoutDelay) {
+  JitterBuffer<int> buffer(0);
+  int sample = 0;
+  buffer.push(0, 0, kNow);
+  EXPECT_TRUE(buffer.pop(&sample, kNow + std::chrono::milliseconds(3)));
+  EXPECT_DOUBLE_EQ(0.003, buffer.playoutDelay());
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/joint_impedance_controller.h>
+#include <franka/rate_limiting.h>
+
+#include "allocation_tracker.h"
+
+using franka::DynamicsBundle;
+using franka::JointImpedanceController;
+using franka::RobotState;
+
+namespace {
+
+const std::array<double, 7> kStiffness{{600, 600, 600, 600, 250, 150, 50}};
+const std::array<double, 7> kDamping{{50, 50, 50, 50, 30, 25, 15}};
+
+DynamicsBundle dynamics() {
+  DynamicsBundle dynamics{};
+  dynamics.coriolis = {{0.1, -0.2, 0.3, -0.4, 0.5, -0.6, 0.7}};
+  dynamics.gravity = {{0, -20, 1, 15, 0.5, 2, 0}};
+  return dynamics;
+}
+
+}  // anonymous namespace
+
+TEST(JointImpedanceController, ComputesImpedanceTorques) {
+  RobotState robot_state{};
+  robot_state.q = {{0, -0.8, 0, -2.4, 0, 1.6, 0.8}};
+  robot_state.dq = {{0.01, 0, -0.01, 0, 0.02, 0, 0}};
+  std::array<double, 7> q_d = robot_state.q;
+  q_d[1] += 0.001;
+  q_d[6] -= 0.002;
+
+  JointImpedanceController controller(kStiffness, kDamping, false);
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics(), q_d);
+  for (size_t i = 0; i < 7; i++) {
+    double expected = kStiffness[i] * (q_d[i] - robot_state.q[i]) -
+                      kDamping[i] * robot_state.dq[i] + dynamics().coriolis[i];
+    EXPECT_NEAR(expected, tau_d[i], 1e-12);
+  }
+  EXPECT_EQ(tau_d, controller.torques().tau_d_commanded);
+  EXPECT_EQ(tau_d, controller.torques().tau_d_limited);
+  EXPECT_EQ(dynamics().gravity, controller.torques().gravity);
+}
+
+TEST(JointImpedanceController, LimitsTorqueRate) {
+  RobotState robot_state{};
+  std::array<double, 7> q_d{{0.1, 0, 0, 0, 0, 0, -0.1}};
+
+  JointImpedanceController controller(kStiffness, kDamping);
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics(), q_d);
+  const franka::ControllerTorques& torques = controller.torques();
+  EXPECT_NEAR(kStiffness[0] * 0.1 + dynamics().coriolis[0], torques.tau_d_commanded[0], 1e-12);
+  EXPECT_EQ(tau_d, torques.tau_d_limited);
+  EXPECT_NEAR(franka::kMaxTorqueRate[0] * franka::kDeltaT, tau_d[0], 1e-9);
+  EXPECT_NEAR(-franka::kMaxTorqueRate[6] * franka::kDeltaT, tau_d[6], 1e-9);
+  EXPECT_NEAR(dynamics().coriolis[2], tau_d[2], 1e-12);
+}
+
+TEST(JointImpedanceController, PublishesTorques) {
+  auto publisher = std::make_shared<franka::StatePublisher>();
+  RobotState robot_state{};
+  robot_state.q.fill(0.5);
+  robot_state.tau_J_d.fill(1.0);
+  std::array<double, 7> q_d;
+  q_d.fill(0.6);
+
+  JointImpedanceController controller(kStiffness, kDamping);
+  controller.setStatePublisher(publisher);
+  std::array<double, 7> tau_d = controller.update(robot_state, dynamics(), q_d);
+
+  franka::PublishedState state;
+  ASSERT_TRUE(publisher->read(&state));
+  EXPECT_EQ(robot_state.q, state.robot_state.q);
+  EXPECT_EQ(tau_d, state.command.torques.tau_J);
+  EXPECT_EQ(controller.torques().tau_d_commanded, state.controller_torques.tau_d_commanded);
+  EXPECT_EQ(tau_d, state.controller_torques.tau_d_limited);
+  EXPECT_EQ(dynamics().gravity, state.controller_torques.gravity);
+
+  controller.setStatePublisher(nullptr);
+  controller.update(robot_state, dynamics(), q_d);
+  EXPECT_EQ(1u, publisher->publishedStates());
+}
+
+TEST(JointImpedanceController, UpdateDoesNotAllocate) {
+  auto publisher = std::make_shared<franka::StatePublisher>();
+  JointImpedanceController controller(kStiffness, kDamping);
+  controller.setStatePublisher(publisher);
+  RobotState robot_state{};
+  DynamicsBundle bundle = dynamics();
+
+  franka::AllocationTrackingScope allocation_tracking;
+  controller.update(robot_state, bundle, robot_state.q);
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(JointImpedanceController, ThrowsForInvalidGains) {
+  std::array<double, 7> invalid = kStiffness;
+  invalid[3] = -1.0;
+  EXPECT_THROW(JointImpedanceController(invalid, kDamping), std::invalid_argument);
+  invalid[3] = NAN;
+  EXPECT_THROW(JointImpedanceController(kStiffness, invalid), std::invalid_argument);
+
+  JointImpedanceController controller(kStiffness, kDamping);
+  EXPECT_THROW(controller.setGains(kStiffness, invalid), std::invalid_argument);
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/joint_state_estimator.h>
+#include <franka/lowpass_filter.h>
+
+#include "control_loop.h"
+#include "helpers.h"
+#include "mock_robot_control.h"
+
+using namespace ::testing;
+
+using franka::Duration;
+using franka::JointStateEstimator;
+using franka::JointStateEstimatorParameters;
+using franka::JointVelocities;
+using franka::RobotState;
+using franka::Torques;
+
+using research_interface::robot::ControllerCommand;
+using research_interface::robot::MotionGeneratorCommand;
+using research_interface::robot::Move;
+
+TEST(JointStateEstimator, InitializesFromFirstMeasurement) {
+  JointStateEstimator estimator;
+  std::array<double, 7> q{{0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7}};
+  std::array<double, 7> dq{{-1, -2, -3, -4, -5, -6, -7}};
+  estimator.update(q, dq, 0.001);
+
+  EXPECT_EQ(q, estimator.q());
+  EXPECT_EQ(dq, estimator.dq());
+  EXPECT_THAT(estimator.ddq(), Each(0.0));
+
+  estimator.update(q, {}, 0.001);
+  estimator.reset();
+  estimator.update(q, dq, 0.001);
+  EXPECT_EQ(dq, estimator.dq());
+}
+
+TEST(JointStateEstimator, EstimatesConstantAccelerationWithVaryingTimeSteps) {
+  JointStateEstimator estimator;
+  std::array<double, 7> acceleration{{1, -1, 2, -2, 0.5, -0.5, 0}};
+  double time = 0;
+  double last_time = 0;
+  for (size_t i = 0; i < 2000; i++) {
+    // Skip some samples as if packets were lost.
+    time += (i % 10 == 0) ? 0.003 : 0.001;
+    std::array<double, 7> q{};
+    std::array<double, 7> dq{};
+    for (size_t j = 0; j < 7; j++) {
+      q[j] = 0.5 * acceleration[j] * time * time;
+      dq[j] = acceleration[j] * time;
+    }
+    estimator.update(q, dq, i == 0 ? 0.0 : time - last_time);
+    last_time = time;
+  }
+  for (size_t j = 0; j < 7; j++) {
+    EXPECT_NEAR(acceleration[j], estimator.ddq()[j], 1e-3);
+    EXPECT_NEAR(acceleration[j] * time, estimator.dq()[j], 1e-6);
+  }
+}
+
+TEST(JointStateEstimator, ReducesVelocityNoise) {
+  constexpr double kTimeStep = 0.001;
+  constexpr double kVelocityNoise = 0.01;
+  constexpr double kOmega = 2 * M_PI;
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> position_noise(0.0, 1e-5);
+  std::normal_distribution<double> velocity_noise(0.0, kVelocityNoise);
+
+  JointStateEstimator estimator;
+  double velocity_error = 0;
+  double acceleration_error = 0;
+  size_t count = 0;
+  for (size_t i = 0; i < 5000; i++) {
+    double t = i * kTimeStep;
+    std::array<double, 7> q{};
+    std::array<double, 7> dq{};
+    q.fill(std::sin(kOmega * t) + position_noise(generator));
+    dq.fill(kOmega * std::cos(kOmega * t) + velocity_noise(generator));
+    estimator.update(q, dq, i == 0 ? 0.0 : kTimeStep);
+
+    if (i >= 1000) {
+      velocity_error += std::pow(estimator.dq()[0] - kOmega * std::cos(kOmega * t), 2);
+      acceleration_error +=
+          std::pow(estimator.ddq()[0] + kOmega * kOmega * std::sin(kOmega * t), 2);
+      count++;
+    }
+  }
+  EXPECT_LT(std::sqrt(velocity_error / count), 0.5 * kVelocityNoise);
+  EXPECT_LT(std::sqrt(acceleration_error / count), 0.1 * kOmega * kOmega);
+}
+
+TEST(JointStateEstimator, ThrowsOnInvalidParameters) {
+  JointStateEstimatorParameters parameters;
+  parameters.jerk_noise = 0;
+  EXPECT_THROW(JointStateEstimator{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.position_noise = -1;
+  EXPECT_THROW(JointStateEstimator{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.velocity_noise = std::numeric_limits<double>::infinity();
+  EXPECT_THROW(JointStateEstimator{parameters}, std::invalid_argument);
+}
+
+TEST(JointStateEstimator, ControlLoopPassesEstimatesToCallbacks) {
+  JointStateEstimatorParameters parameters;
+  NiceMock<MockRobotControl> robot;
+  robot.joint_state_estimator_parameters = &parameters;
+  EXPECT_CALL(robot, startMotion(Move::ControllerMode::kExternalController,
+                                 Move::MotionGeneratorMode::kJointVelocity, _, _))
+      .WillOnce(Return(200));
+
+  RobotState robot_state;
+  std::array<double, 7> acceleration{{1, 2, 3, 4, 5, 6, 7}};
+  EXPECT_CALL(robot, update(_, _))
+      .WillRepeatedly(Invoke([&](const MotionGeneratorCommand*, const ControllerCommand*) {
+        robot_state.time += Duration(1);
+        double t = robot_state.time.toSec();
+        for (size_t i = 0; i < 7; i++) {
+          robot_state.q[i] = 0.5 * acceleration[i] * t * t;
+          robot_state.dq[i] = acceleration[i] * t;
+        }
+        return robot_state;
+      }));
+
+  JointStateEstimator expected(parameters);
+  size_t count = 0;
+  franka::ControlLoop<JointVelocities> loop(
+      robot,
+      [&](const RobotState& state, Duration time_step) -> Torques {
+        RobotState expected_state = state;
+        expected_state.dq = robot_state.dq;
+        expected.update(&expected_state, time_step);
+        EXPECT_EQ(expected_state.dq, state.dq);
+        EXPECT_EQ(expected_state.ddq_hat, state.ddq_hat);
+
+        Torques torques({0, 0, 0, 0, 0, 0, 0});
+        if (++count == 500) {
+          EXPECT_NEAR(7.0, state.ddq_hat[6], 1e-2);
+          return franka::MotionFinished(torques);
+        }
+        return torques;
+      },
+      [](const RobotState&, Duration) { return JointVelocities({0, 0, 0, 0, 0, 0, 0}); }, false,
+      franka::kMaxCutoffFrequency);
+  loop();
+  EXPECT_EQ(500u, count);
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/joint_trajectory.h>
+#include <franka/rate_limiting.h>
+
+using franka::Duration;
+using franka::JointMotionGenerator;
+using franka::JointPositions;
+using franka::JointTrajectory;
+using franka::JointTrajectoryLimits;
+using franka::RobotState;
+
+namespace {
+
+const std::array<double, 7> kStart{{0.0, -0.785, 0.0, -2.356, 0.0, 1.571, 0.785}};
+const std::array<double, 7> kGoal{{0.5, -0.3, 0.0, -2.0, -1.2, 1.571, 0.7}};
+
+}  // anonymous namespace
+
+TEST(JointTrajectory, StartsAndEndsAtGivenPositions) {
+  JointTrajectory trajectory(kStart, kGoal, JointTrajectoryLimits::fromSpeedFactor(0.5));
+  ASSERT_GT(trajectory.duration(), 0.0);
+
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_DOUBLE_EQ(kStart[i], trajectory.position(-1.0)[i]);
+    EXPECT_DOUBLE_EQ(kStart[i], trajectory.position(0.0)[i]);
+    EXPECT_NEAR(kGoal[i], trajectory.position(trajectory.duration())[i], 1e-9);
+    EXPECT_DOUBLE_EQ(kGoal[i], trajectory.position(trajectory.duration() + 1.0)[i]);
+    EXPECT_EQ(0.0, trajectory.velocity(0.0)[i]);
+    EXPECT_EQ(0.0, trajectory.velocity(trajectory.duration() + 1.0)[i]);
+  }
+}
+
+TEST(JointTrajectory, SynchronizesJoints) {
+  JointTrajectory trajectory(kStart, kGoal, JointTrajectoryLimits::fromSpeedFactor(1.0));
+
+  // Every moving joint is still on its way shortly before the end.
+  double t = trajectory.duration() - 0.01;
+  std::array<double, 7> dq = trajectory.velocity(t);
+  for (size_t i = 0; i < 7; i++) {
+    if (kStart[i] == kGoal[i]) {
+      EXPECT_EQ(0.0, dq[i]);
+    } else {
+      EXPECT_GT(std::abs(dq[i]), 0.0) << "joint " << i;
+      EXPECT_GT(std::abs(kGoal[i] - trajectory.position(t)[i]), 0.0) << "joint " << i;
+    }
+  }
+}
+
+TEST(JointTrajectory, IsContinuousAndRespectsLimits) {
+  JointTrajectoryLimits limits = JointTrajectoryLimits::fromSpeedFactor(0.8);
+  JointTrajectory trajectory(kStart, kGoal, limits);
+
+  constexpr double kDeltaT = 0.001;
+  std::array<double, 7> q_previous = trajectory.position(0.0);
+  std::array<double, 7> dq_previous = trajectory.velocity(0.0);
+  for (double t = kDeltaT; t < trajectory.duration() + 0.1; t += kDeltaT) {
+    std::array<double, 7> q = trajectory.position(t);
+    std::array<double, 7> dq = trajectory.velocity(t);
+    for (size_t i = 0; i < 7; i++) {
+      double dq_numeric = (q[i] - q_previous[i]) / kDeltaT;
+      EXPECT_LE(std::abs(dq[i]), limits.max_velocity[i] + 1e-9) << "t = " << t;
+      EXPECT_NEAR(0.5 * (dq[i] + dq_previous[i]), dq_numeric, 1e-3) << "t = " << t;
+      EXPECT_LE(std::abs(dq[i] - dq_previous[i]) / kDeltaT, limits.max_acceleration[i] + 1e-3)
+          << "t = " << t;
+    }
+    q_previous = q;
+    dq_previous = dq;
+  }
+}
+
+TEST(JointTrajectory, HandlesStationaryJoints) {
+  JointTrajectory trajectory(kStart, kStart, JointTrajectoryLimits::fromSpeedFactor(0.5));
+  EXPECT_EQ(0.0, trajectory.duration());
+  EXPECT_EQ(kStart, trajectory.position(0.5));
+  for (double dq : trajectory.velocity(0.5)) {
+    EXPECT_EQ(0.0, dq);
+  }
+}
+
+TEST(JointTrajectory, ThrowsForInvalidLimits) {
+  EXPECT_THROW(JointTrajectoryLimits::fromSpeedFactor(0.0), std::invalid_argument);
+  EXPECT_THROW(JointTrajectoryLimits::fromSpeedFactor(1.5), std::invalid_argument);
+  EXPECT_THROW(JointTrajectoryLimits::fromSpeedFactor(NAN), std::invalid_argument);
+
+  JointTrajectoryLimits limits = JointTrajectoryLimits::fromSpeedFactor(0.5);
+  limits.max_deceleration[3] = 0.0;
+  EXPECT_THROW(JointTrajectory(kStart, kGoal, limits), std::invalid_argument);
+}
+
+TEST(JointMotionGenerator, StartsFromDesiredPositionsOfFirstState) {
+  JointMotionGenerator generator(0.5, kGoal);
+  RobotState robot_state;
+  robot_state.q_d = kStart;
+
+  JointPositions output = generator(robot_state, Duration(0));
+  EXPECT_EQ(kStart, output.q);
+  EXPECT_FALSE(output.motion_finished);
+
+  JointTrajectory trajectory(kStart, kGoal, JointTrajectoryLimits::fromSpeedFactor(0.5));
+  uint64_t cycles = 0;
+  while (!output.motion_finished) {
+    robot_state.q_d = output.q;
+    output = generator(robot_state, Duration(1));
+    cycles++;
+    ASSERT_LE(cycles, 100000u);
+  }
+  EXPECT_NEAR(trajectory.duration(), cycles * 1e-3, 1e-3);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(kGoal[i], output.q[i], 1e-9);
+  }
+}
+
+TEST(JointMotionGenerator, FollowsPrecomputedTrajectory) {
+  JointTrajectory trajectory(kStart, kGoal, JointTrajectoryLimits::fromSpeedFactor(0.5));
+  JointMotionGenerator generator(trajectory);
+  RobotState robot_state;
+  robot_state.q_d = kGoal;
+
+  EXPECT_EQ(kStart, generator(robot_state, Duration(0)).q);
+  EXPECT_EQ(trajectory.position(0.002), generator(robot_state, Duration(2)).q);
+}
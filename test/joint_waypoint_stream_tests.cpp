@@ -0,0 +1,168 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/joint_waypoint_stream.h>
+
+using franka::Duration;
+using franka::JointPositions;
+using franka::JointTrajectory;
+using franka::JointTrajectoryLimits;
+using franka::JointWaypointStream;
+using franka::RobotState;
+
+namespace {
+
+const std::array<double, 7> kStart{{0.0, -0.785, 0.0, -2.356, 0.0, 1.571, 0.785}};
+const std::vector<std::array<double, 7>> kWaypoints{
+    {{0.2, -0.6, 0.1, -2.2, 0.1, 1.6, 0.9}},
+    {{0.5, -0.4, 0.15, -2.0, 0.3, 1.7, 1.0}},
+    {{0.7, -0.3, 0.3, -1.9, 0.4, 1.9, 1.2}},
+    {{0.5, -0.5, 0.2, -2.1, 0.2, 1.7, 1.0}},
+};
+
+// Runs the stream like a control loop with 1 ms cycles and checks the limits along the way.
+std::vector<std::array<double, 7>> run(JointWaypointStream& stream,
+                                       const JointTrajectoryLimits& limits) {
+  RobotState robot_state;
+  robot_state.q_d = kStart;
+  JointPositions output = stream(robot_state, Duration(0));
+  std::vector<std::array<double, 7>> positions{output.q};
+  while (!output.motion_finished) {
+    robot_state.q_d = output.q;
+    output = stream(robot_state, Duration(1));
+    positions.push_back(output.q);
+    if (positions.size() > 100000) {
+      ADD_FAILURE() << "Motion did not finish.";
+      break;
+    }
+  }
+
+  constexpr double kDeltaT = 0.001;
+  for (size_t k = 2; k < positions.size(); k++) {
+    for (size_t i = 0; i < 7; i++) {
+      double dq = (positions[k][i] - positions[k - 1][i]) / kDeltaT;
+      double dq_previous = (positions[k - 1][i] - positions[k - 2][i]) / kDeltaT;
+      EXPECT_LE(std::abs(dq), limits.max_velocity[i] + 1e-6) << "cycle " << k;
+      EXPECT_LE(std::abs(dq - dq_previous) / kDeltaT, limits.max_acceleration[i] + 0.05)
+          << "cycle " << k;
+    }
+  }
+  return positions;
+}
+
+}  // anonymous namespace
+
+TEST(JointWaypointStream, BlendsSegmentsWithinLimits) {
+  JointTrajectoryLimits limits = JointTrajectoryLimits::fromSpeedFactor(0.5);
+  JointWaypointStream stream(limits);
+  for (const auto& waypoint : kWaypoints) {
+    ASSERT_TRUE(stream.push(waypoint));
+  }
+  stream.finish();
+
+  std::vector<std::array<double, 7>> positions = run(stream, limits);
+  EXPECT_EQ(kWaypoints.size(), stream.reachedWaypoints());
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(kWaypoints.back()[i], positions.back()[i], 1e-9);
+  }
+
+  // Blending makes the motion faster than stopping at every waypoint.
+  double stop_and_go_duration = 0.0;
+  std::array<double, 7> q_start = kStart;
+  for (const auto& waypoint : kWaypoints) {
+    stop_and_go_duration += JointTrajectory(q_start, waypoint, limits).duration();
+    q_start = waypoint;
+  }
+  EXPECT_LT((positions.size() - 1) * 1e-3, stop_and_go_duration - 0.1);
+}
+
+TEST(JointWaypointStream, WaitsForWaypoints) {
+  JointTrajectoryLimits limits = JointTrajectoryLimits::fromSpeedFactor(0.5);
+  JointWaypointStream stream(limits);
+  RobotState robot_state;
+  robot_state.q_d = kStart;
+
+  JointPositions output = stream(robot_state, Duration(0));
+  for (int i = 0; i < 10; i++) {
+    output = stream(robot_state, Duration(1));
+    EXPECT_EQ(kStart, output.q);
+    EXPECT_FALSE(output.motion_finished);
+  }
+
+  ASSERT_TRUE(stream.push(kWaypoints[0]));
+  while (stream.reachedWaypoints() == 0) {
+    robot_state.q_d = output.q;
+    output = stream(robot_state, Duration(1));
+    ASSERT_FALSE(output.motion_finished);
+  }
+  EXPECT_EQ(kWaypoints[0], output.q);
+
+  output = stream(robot_state, Duration(1));
+  EXPECT_FALSE(output.motion_finished);
+  stream.finish();
+  output = stream(robot_state, Duration(1));
+  EXPECT_TRUE(output.motion_finished);
+  EXPECT_EQ(kWaypoints[0], output.q);
+}
+
+TEST(JointWaypointStream, SkipsWaypointsWithoutMotion) {
+  JointTrajectoryLimits limits = JointTrajectoryLimits::fromSpeedFactor(0.5);
+  JointWaypointStream stream(limits);
+  ASSERT_TRUE(stream.push(kStart));
+  ASSERT_TRUE(stream.push(kWaypoints[0]));
+  ASSERT_TRUE(stream.push(kWaypoints[0]));
+  stream.finish();
+
+  std::vector<std::array<double, 7>> positions = run(stream, limits);
+  EXPECT_EQ(3u, stream.reachedWaypoints());
+  EXPECT_EQ(kWaypoints[0], positions.back());
+}
+
+TEST(JointWaypointStream, ReportsFullQueue) {
+  JointWaypointStream stream(JointTrajectoryLimits::fromSpeedFactor(0.5), 2);
+  EXPECT_TRUE(stream.push(kWaypoints[0]));
+  EXPECT_TRUE(stream.push(kWaypoints[1]));
+  EXPECT_FALSE(stream.push(kWaypoints[2]));
+}
+
+TEST(JointWaypointStream, ThrowsForInvalidLimits) {
+  JointTrajectoryLimits limits = JointTrajectoryLimits::fromSpeedFactor(0.5);
+  JointWaypointStream stream(limits);
+  limits.max_velocity[2] = 0.0;
+  EXPECT_THROW(stream.push(kWaypoints[0], limits), std::invalid_argument);
+  EXPECT_THROW(JointWaypointStream{limits}, std::invalid_argument);
+}
+
+TEST(JointWaypointStream, ReceivesWaypointsFromOtherThread) {
+  JointWaypointStream stream(JointTrajectoryLimits::fromSpeedFactor(1.0), 2);
+  std::thread planner([&stream] {
+    for (size_t i = 0; i < 20; i++) {
+      while (!stream.push(kWaypoints[i % kWaypoints.size()])) {
+        std::this_thread::yield();
+      }
+    }
+    stream.finish();
+  });
+
+  RobotState robot_state;
+  robot_state.q_d = kStart;
+  JointPositions output = stream(robot_state, Duration(0));
+  while (!output.motion_finished) {
+    robot_state.q_d = output.q;
+    output = stream(robot_state, Duration(1));
+    std::this_thread::yield();
+  }
+  planner.join();
+
+  EXPECT_EQ(20u, stream.reachedWaypoints());
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(kWaypoints[19 % kWaypoints.size()][i], output.q[i], 1e-9);
+  }
+}
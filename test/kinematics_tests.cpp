@@ -0,0 +1,139 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <random>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/inverse_kinematics.h>
+#include <franka/kinematics.h>
+
+using namespace ::testing;
+
+using franka::EndEffectorFrames;
+using franka::Frame;
+using franka::FrameJacobians;
+using franka::FramePoses;
+using franka::PandaKinematics;
+
+namespace {
+
+// Franka Hand and a stiffness frame in its fingertips.
+const std::array<double, 16> kFrankaHand{{M_SQRT1_2, -M_SQRT1_2, 0, 0, M_SQRT1_2, M_SQRT1_2, 0, 0,
+                                          0, 0, 1, 0, 0, 0, 0.1034, 1}};
+const std::array<double, 16> kFingertips{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.01, 0, 0.05, 1}};
+
+// Poses of the seven joint frames and the flange from the modified Denavit-Hartenberg parameters
+// of the Panda.
+std::array<Eigen::Affine3d, 8> jointFrames(const std::array<double, 7>& q) {
+  const std::array<double, 8> a{{0, 0, 0, 0.0825, -0.0825, 0, 0.088, 0}};
+  const std::array<double, 8> d{{0.333, 0, 0.316, 0, 0.384, 0, 0, 0.107}};
+  const std::array<double, 8> alpha{{0, -M_PI_2, M_PI_2, M_PI_2, -M_PI_2, M_PI_2, M_PI_2, 0}};
+  std::array<Eigen::Affine3d, 8> frames;
+  Eigen::Affine3d transform = Eigen::Affine3d::Identity();
+  for (size_t i = 0; i < a.size(); i++) {
+    transform = transform * Eigen::AngleAxisd(alpha[i], Eigen::Vector3d::UnitX()) *
+                Eigen::Translation3d(a[i], 0, 0) *
+                Eigen::AngleAxisd(i < q.size() ? q[i] : 0, Eigen::Vector3d::UnitZ()) *
+                Eigen::Translation3d(0, 0, d[i]);
+    frames[i] = transform;
+  }
+  return frames;
+}
+
+std::array<double, 7> randomJointPositions(std::mt19937* generator) {
+  std::array<double, 7> q{};
+  for (size_t i = 0; i < q.size(); i++) {
+    std::uniform_real_distribution<double> distribution(franka::kMinJointPosition[i],
+                                                        franka::kMaxJointPosition[i]);
+    q[i] = distribution(*generator);
+  }
+  return q;
+}
+
+}  // anonymous namespace
+
+TEST(Kinematics, PosesMatchDenavitHartenbergChain) {
+  std::mt19937 generator(1);
+  EndEffectorFrames frames(kFrankaHand, kFingertips);
+  for (size_t sample = 0; sample < 100; sample++) {
+    std::array<double, 7> q = randomJointPositions(&generator);
+    FramePoses poses;
+    PandaKinematics::poseAll(q, frames, &poses);
+
+    std::array<Eigen::Affine3d, 8> expected = jointFrames(q);
+    for (size_t i = 0; i < expected.size(); i++) {
+      EXPECT_TRUE(Eigen::Matrix4d::Map(poses[i].data()).isApprox(expected[i].matrix(), 1e-12))
+          << "Frame " << i;
+    }
+    Eigen::Matrix4d end_effector = expected[7].matrix() * Eigen::Matrix4d::Map(kFrankaHand.data());
+    EXPECT_TRUE(Eigen::Matrix4d::Map(poses[static_cast<size_t>(Frame::kEndEffector)].data())
+                    .isApprox(end_effector, 1e-12));
+    Eigen::Matrix4d stiffness = end_effector * Eigen::Matrix4d::Map(kFingertips.data());
+    EXPECT_TRUE(Eigen::Matrix4d::Map(poses[static_cast<size_t>(Frame::kStiffness)].data())
+                    .isApprox(stiffness, 1e-12));
+
+    EXPECT_EQ(poses[static_cast<size_t>(Frame::kJoint4)],
+              PandaKinematics::pose(Frame::kJoint4, q, frames));
+  }
+}
+
+TEST(Kinematics, JacobiansMatchFiniteDifferences) {
+  std::mt19937 generator(2);
+  EndEffectorFrames frames(kFrankaHand, kFingertips);
+  constexpr double kStep = 1e-7;
+  for (size_t sample = 0; sample < 20; sample++) {
+    std::array<double, 7> q = randomJointPositions(&generator);
+    FramePoses poses;
+    FrameJacobians jacobians;
+    PandaKinematics::poseAll(q, frames, &poses, &jacobians);
+
+    for (size_t joint = 0; joint < q.size(); joint++) {
+      std::array<double, 7> q_step = q;
+      q_step[joint] += kStep;
+      FramePoses poses_step;
+      PandaKinematics::poseAll(q_step, frames, &poses_step);
+
+      for (size_t frame = 0; frame < franka::kFrameCount; frame++) {
+        Eigen::Affine3d pose(Eigen::Matrix4d::Map(poses[frame].data()));
+        Eigen::Affine3d pose_step(Eigen::Matrix4d::Map(poses_step[frame].data()));
+        Eigen::Vector3d velocity = (pose_step.translation() - pose.translation()) / kStep;
+        Eigen::AngleAxisd rotation(pose_step.linear() * pose.linear().transpose());
+        Eigen::Vector3d angular_velocity = rotation.angle() * rotation.axis() / kStep;
+
+        Eigen::Map<const Eigen::Matrix<double, 6, 1>> column(&jacobians[frame][6 * joint]);
+        EXPECT_TRUE(column.head<3>().isApprox(velocity, 1e-5) ||
+                    (column.head<3>().norm() < 1e-12 && velocity.norm() < 1e-5))
+            << "Frame " << frame << ", joint " << joint;
+        if (column.tail<3>().norm() > 0) {
+          EXPECT_TRUE(column.tail<3>().isApprox(angular_velocity, 1e-5))
+              << "Frame " << frame << ", joint " << joint;
+        } else {
+          EXPECT_LT(angular_velocity.norm(), 1e-9);
+        }
+      }
+    }
+
+    EXPECT_EQ(jacobians[static_cast<size_t>(Frame::kEndEffector)],
+              PandaKinematics::zeroJacobian(Frame::kEndEffector, q, frames));
+  }
+}
+
+TEST(Kinematics, AgreesWithInverseKinematics) {
+  std::mt19937 generator(3);
+  franka::InverseKinematics inverse_kinematics(kFrankaHand);
+  EndEffectorFrames frames(kFrankaHand, kFingertips);
+  for (size_t sample = 0; sample < 20; sample++) {
+    std::array<double, 7> q = randomJointPositions(&generator);
+    std::array<double, 16> pose = PandaKinematics::pose(Frame::kEndEffector, q, frames);
+
+    franka::InverseKinematicsSolutions solutions = inverse_kinematics.solve(pose, q[6], q);
+    ASSERT_GE(solutions.size, 1u);
+    for (size_t i = 0; i < q.size(); i++) {
+      EXPECT_NEAR(q[i], solutions.q[0][i], 1e-6);
+    }
+  }
+}
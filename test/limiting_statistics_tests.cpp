@@ -0,0 +1,128 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <sstream>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/limiting_statistics.h>
+#include <franka/lowpass_filter.h>
+
+#include "control_loop.h"
+#include "helpers.h"
+#include "limiting_statistics_recorder.h"
+#include "mock_robot_control.h"
+
+using namespace ::testing;
+
+using franka::Duration;
+using franka::JointVelocities;
+using franka::LimitingStatisticsRecorder;
+using franka::RobotState;
+using franka::Torques;
+
+TEST(LimitingStatisticsRecorder, IsEmptyByDefault) {
+  LimitingStatisticsRecorder recorder;
+  franka::LimitingStatistics statistics = recorder.statistics();
+
+  EXPECT_EQ(0u, statistics.torque_rate.cycles);
+  EXPECT_EQ(0u, statistics.joint_motion.count[0]);
+  EXPECT_EQ(0.0, statistics.cartesian_motion.max_correction[0]);
+  EXPECT_FALSE(recorder.enabled());
+}
+
+TEST(LimitingStatisticsRecorder, CountsCorrectionsPerElement) {
+  LimitingStatisticsRecorder recorder;
+  recorder.record<3>(LimitingStatisticsRecorder::Stage::kJointMotion, {{1.0, 2.0, 3.0}},
+                     {{1.0, 1.5, 3.0 + 1e-12}});
+  recorder.record<3>(LimitingStatisticsRecorder::Stage::kJointMotion, {{1.0, 2.0, 3.0}},
+                     {{0.75, 1.75, 3.0}});
+  recorder.record(LimitingStatisticsRecorder::Stage::kElbow, 1.0, 0.5);
+
+  franka::LimitingStatistics statistics = recorder.statistics();
+  EXPECT_EQ(2u, statistics.joint_motion.cycles);
+  EXPECT_EQ(1u, statistics.joint_motion.count[0]);
+  EXPECT_EQ(2u, statistics.joint_motion.count[1]);
+  EXPECT_EQ(0u, statistics.joint_motion.count[2]);
+  EXPECT_EQ(0u, statistics.joint_motion.count[3]);
+  EXPECT_DOUBLE_EQ(0.25, statistics.joint_motion.max_correction[0]);
+  EXPECT_DOUBLE_EQ(0.5, statistics.joint_motion.max_correction[1]);
+  EXPECT_NEAR(1e-12, statistics.joint_motion.max_correction[2], 1e-15);
+  EXPECT_EQ(1u, statistics.elbow.cycles);
+  EXPECT_EQ(1u, statistics.elbow.count[0]);
+  EXPECT_EQ(0u, statistics.torque_rate.cycles);
+
+  recorder.reset();
+  EXPECT_EQ(0u, recorder.statistics().joint_motion.cycles);
+  EXPECT_EQ(0.0, recorder.statistics().joint_motion.max_correction[1]);
+}
+
+TEST(LimitingStatisticsRecorder, RecordsPoseCorrections) {
+  std::array<double, 16> commanded{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.5, 0.1, 0.3, 1}};
+  std::array<double, 16> limited = commanded;
+  double angle = 0.01;
+  limited[0] = std::cos(angle);
+  limited[1] = std::sin(angle);
+  limited[4] = -std::sin(angle);
+  limited[5] = std::cos(angle);
+  limited[13] = 0.125;
+
+  LimitingStatisticsRecorder recorder;
+  recorder.recordPose(commanded, limited);
+
+  franka::LimitingStageStatistics statistics = recorder.statistics().cartesian_motion;
+  EXPECT_EQ(1u, statistics.cycles);
+  EXPECT_THAT(statistics.count, ElementsAre(0u, 1u, 0u, 0u, 0u, 1u, 0u));
+  EXPECT_NEAR(0.025, statistics.max_correction[1], 1e-12);
+  EXPECT_NEAR(std::sin(angle), statistics.max_correction[5], 1e-12);
+}
+
+TEST(LimitingStatistics, CanBeStreamed) {
+  franka::LimitingStatistics statistics;
+
+  std::stringstream ss;
+  ss << statistics;
+  std::string output(ss.str());
+
+  EXPECT_PRED2(stringContains, output, "torque_rate");
+  EXPECT_PRED2(stringContains, output, "joint_motion");
+  EXPECT_PRED2(stringContains, output, "cartesian_motion");
+  EXPECT_PRED2(stringContains, output, "elbow");
+  EXPECT_PRED2(stringContains, output, "max_correction");
+}
+
+TEST(LimitingStatistics, ControlLoopRecordsTorqueRateLimiting) {
+  LimitingStatisticsRecorder recorder;
+  recorder.setEnabled(true);
+
+  NiceMock<MockRobotControl> robot;
+  robot.limiting_statistics_recorder = &recorder;
+
+  class Loop : public franka::ControlLoop<JointVelocities> {
+   public:
+    using franka::ControlLoop<JointVelocities>::ControlLoop;
+    using franka::ControlLoop<JointVelocities>::spinMotion;
+    using franka::ControlLoop<JointVelocities>::spinControl;
+  };
+  Loop loop(robot, [](const RobotState&, Duration) { return Torques({0, 1, 2, 3, 4, 5, 6}); },
+            [](const RobotState&, Duration) { return JointVelocities({0, 0, 0, 0, 0, 0, 0}); },
+            true, franka::kMaxCutoffFrequency);
+
+  RobotState robot_state;
+  research_interface::robot::RobotCommand command{};
+  for (int i = 0; i < 3; i++) {
+    loop.spinMotion(robot_state, Duration(1), &command.motion);
+    loop.spinControl(robot_state, Duration(1), &command.control);
+  }
+
+  franka::LimitingStatistics statistics = recorder.statistics();
+  EXPECT_EQ(3u, statistics.torque_rate.cycles);
+  EXPECT_EQ(0u, statistics.torque_rate.count[0]);
+  for (size_t i = 2; i < 7; i++) {
+    EXPECT_EQ(3u, statistics.torque_rate.count[i]);
+  }
+  EXPECT_NEAR(5.0, statistics.torque_rate.max_correction[6], 1e-2);
+  EXPECT_EQ(3u, statistics.joint_motion.cycles);
+  EXPECT_EQ(0u, statistics.joint_motion.count[0]);
+}
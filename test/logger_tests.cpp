@@ -1,13 +1,24 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <thread>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <franka/exception.h>
 #include <franka/log.h>
 
+#include "allocation_tracker.h"
+#include "compressed_log_ring.h"
 #include "helpers.h"
 #include "logger.h"
 
@@ -18,11 +29,11 @@ TEST(Logger, LogIsFIFO) {
   size_t log_count = 5;
   franka::Logger logger(log_count);
 
-  std::vector<franka::RobotState> states;
+  std::vector<research_interface::robot::RobotState> states;
   std::vector<research_interface::robot::RobotCommand> commands;
 
   for (size_t i = 0; i < log_count; i++) {
-    franka::RobotState state;
+    research_interface::robot::RobotState state;
     randomRobotState(state);
     states.push_back(state);
 
@@ -44,12 +55,12 @@ TEST(Logger, LogIsAFixedSizeRing) {
   size_t ring = 5;
   franka::Logger logger(ring);
 
-  std::vector<franka::RobotState> states;
+  std::vector<research_interface::robot::RobotState> states;
   std::vector<research_interface::robot::RobotCommand> commands;
 
   size_t logs = ring * 2;
   for (size_t i = 0; i < logs; i++) {
-    franka::RobotState state;
+    research_interface::robot::RobotState state;
     randomRobotState(state);
     states.push_back(state);
 
@@ -69,12 +80,220 @@ TEST(Logger, LogIsAFixedSizeRing) {
   EXPECT_EQ(ring, log.size());
 }
 
+TEST(Logger, LogDoesNotAllocate) {
+  size_t ring = 5;
+  franka::Logger logger(ring);
+
+  research_interface::robot::RobotState state;
+  randomRobotState(state);
+  research_interface::robot::RobotCommand command;
+  randomRobotCommand(command);
+
+  franka::AllocationTrackingScope allocation_tracking;
+  for (size_t i = 0; i < ring * 2; i++) {
+    logger.log(state, command);
+  }
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(Logger, CompactLogKeepsSelectedFields) {
+  size_t ring = 5;
+  franka::Logger logger(ring, franka::LogFields::kCSV);
+
+  std::vector<research_interface::robot::RobotState> states;
+  std::vector<research_interface::robot::RobotCommand> commands;
+
+  size_t logs = ring * 2 + 1;
+  for (size_t i = 0; i < logs; i++) {
+    research_interface::robot::RobotState state;
+    randomRobotState(state);
+    states.push_back(state);
+
+    research_interface::robot::RobotCommand command;
+    randomRobotCommand(command);
+    commands.push_back(command);
+
+    logger.log(state, command);
+  }
+
+  size_t expected_offset = logs - ring;
+  std::vector<franka::Record> log = logger.flush();
+  ASSERT_EQ(ring, log.size());
+  for (size_t i = 0; i < ring; i++) {
+    const auto& state = states[i + expected_offset];
+    const auto& command = commands[i + expected_offset];
+    EXPECT_EQ(state.message_id, log[i].state.time.toMSec());
+    EXPECT_EQ(state.control_command_success_rate, log[i].state.control_command_success_rate);
+    EXPECT_EQ(state.q, log[i].state.q);
+    EXPECT_EQ(state.q_d, log[i].state.q_d);
+    EXPECT_EQ(state.dq, log[i].state.dq);
+    EXPECT_EQ(state.dq_d, log[i].state.dq_d);
+    EXPECT_EQ(state.tau_J, log[i].state.tau_J);
+    EXPECT_EQ(state.tau_ext_hat_filtered, log[i].state.tau_ext_hat_filtered);
+    EXPECT_EQ(franka::RobotState().O_T_EE, log[i].state.O_T_EE);
+    testRobotCommandsAreEqual(command, log[i].command);
+  }
+}
+
+TEST(Logger, CompactLogSkipsUnselectedFields) {
+  franka::Logger logger(2, franka::LogFields::kQ | franka::LogFields::kControlCommand);
+  EXPECT_TRUE(franka::hasLogFields(logger.fields(), franka::LogFields::kQ));
+  EXPECT_FALSE(franka::hasLogFields(logger.fields(), franka::LogFields::kDq));
+
+  research_interface::robot::RobotState state;
+  randomRobotState(state);
+  research_interface::robot::RobotCommand command;
+  randomRobotCommand(command);
+  logger.log(state, command);
+
+  std::vector<franka::Record> log = logger.flush();
+  ASSERT_EQ(1u, log.size());
+  EXPECT_EQ(state.q, log[0].state.q);
+  EXPECT_EQ(command.control.tau_J_d, log[0].command.torques.tau_J);
+  EXPECT_EQ(franka::RobotState().dq, log[0].state.dq);
+  EXPECT_EQ(franka::RobotCommand().joint_positions.q, log[0].command.joint_positions.q);
+}
+
+TEST(Logger, FullStateLogStoresStateOnce) {
+  franka::LogRing ring(3, franka::LogFields::kAll);
+  EXPECT_EQ(3u, ring.states.size());
+  EXPECT_TRUE(ring.message_ids.empty());
+  EXPECT_TRUE(ring.success_rates.empty());
+  EXPECT_TRUE(ring.q.empty());
+  EXPECT_TRUE(ring.tau_ext_hat_filtered.empty());
+  EXPECT_EQ(3u, ring.q_c.size());
+  EXPECT_EQ(3u, ring.tau_J_d.size());
+}
+
+TEST(Logger, SnapshotKeepsLog) {
+  size_t ring = 5;
+  franka::Logger logger(ring);
+
+  std::vector<research_interface::robot::RobotState> states;
+  for (size_t i = 0; i < ring + 2; i++) {
+    research_interface::robot::RobotState state;
+    randomRobotState(state);
+    states.push_back(state);
+    logger.log(state, research_interface::robot::RobotCommand{});
+  }
+
+  std::vector<franka::Record> snapshot(3);
+  ASSERT_EQ(3u, logger.snapshot(snapshot.data(), snapshot.size()));
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    testRobotStatesAreEqual(states[states.size() - 3 + i], snapshot[i].state);
+  }
+
+  snapshot.resize(2 * ring);
+  EXPECT_EQ(ring, logger.snapshot(snapshot.data(), snapshot.size()));
+  EXPECT_EQ(ring, logger.flush().size());
+  EXPECT_EQ(0u, logger.snapshot(snapshot.data(), snapshot.size()));
+}
+
+TEST(Logger, SnapshotResetsUnloggedFields) {
+  franka::Logger logger(2, franka::LogFields::kQ);
+  research_interface::robot::RobotState state;
+  randomRobotState(state);
+  logger.log(state, research_interface::robot::RobotCommand{});
+
+  franka::Record record;
+  record.state.dq = {{1, 2, 3, 4, 5, 6, 7}};
+  ASSERT_EQ(1u, logger.snapshot(&record, 1));
+  EXPECT_EQ(state.q, record.state.q);
+  EXPECT_EQ(franka::RobotState().dq, record.state.dq);
+}
+
+TEST(Logger, SnapshotAndFlushDoNotAllocate) {
+  size_t ring = 5;
+  franka::Logger logger(ring);
+  research_interface::robot::RobotState state;
+  randomRobotState(state);
+  research_interface::robot::RobotCommand command;
+  randomRobotCommand(command);
+  for (size_t i = 0; i < ring; i++) {
+    logger.log(state, command);
+  }
+  std::vector<franka::Record> snapshot(ring);
+
+  franka::ExceptionLog log;
+  {
+    franka::AllocationTrackingScope allocation_tracking;
+    logger.snapshot(snapshot.data(), snapshot.size());
+    log = logger.flush();
+    EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+  }
+  EXPECT_EQ(ring, log.size());
+
+  logger.clear();
+  logger.log(state, command);
+  franka::AllocationTrackingScope allocation_tracking;
+  EXPECT_EQ(1u, logger.flush().size());
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(Logger, FlushedLogIsConvertedOnceWhenRead) {
+  franka::Logger logger(3, franka::LogFields::kQ);
+  std::vector<research_interface::robot::RobotState> states;
+  for (size_t i = 0; i < 4; i++) {
+    research_interface::robot::RobotState state;
+    randomRobotState(state);
+    states.push_back(state);
+    logger.log(state, research_interface::robot::RobotCommand{});
+  }
+
+  franka::ExceptionLog log = logger.flush();
+  franka::ExceptionLog copy = log;
+  EXPECT_EQ(3u, log.size());
+  EXPECT_FALSE(log.empty());
+
+  // Logging again does not change the flushed log.
+  logger.log(states[0], research_interface::robot::RobotCommand{});
+  ASSERT_EQ(3u, copy.records().size());
+  EXPECT_EQ(&log.records(), &copy.records());
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_EQ(states[i + 1].q, log[i].state.q);
+    EXPECT_EQ(franka::Duration(states[i + 1].message_id), log[i].state.time);
+  }
+  EXPECT_EQ(states[3].q, log.back().state.q);
+}
+
+TEST(Logger, SnapshotIsConsistentWhileLogging) {
+  size_t ring = 10;
+  franka::Logger logger(ring, franka::LogFields::kQ);
+  std::atomic<bool> running{true};
+
+  std::thread writer([&]() {
+    research_interface::robot::RobotState state{};
+    for (uint64_t message_id = 1; running; message_id++) {
+      state.message_id = message_id;
+      state.q.fill(static_cast<double>(message_id));
+      logger.log(state, research_interface::robot::RobotCommand{});
+    }
+  });
+
+  std::vector<franka::Record> snapshot(ring);
+  for (size_t i = 0; i < 1000; i++) {
+    size_t size = logger.snapshot(snapshot.data(), snapshot.size());
+    for (size_t j = 0; j < size; j++) {
+      const franka::Record& record = snapshot[j];
+      double expected = static_cast<double>(record.state.time.toMSec());
+      ASSERT_EQ(record.state.q.size(),
+                std::count(record.state.q.begin(), record.state.q.end(), expected));
+      if (j > 0) {
+        ASSERT_EQ(snapshot[j - 1].state.time.toMSec() + 1, record.state.time.toMSec());
+      }
+    }
+  }
+  running = false;
+  writer.join();
+}
+
 TEST(Logger, LoggerEmptyAfterFlush) {
   size_t log_count = 5;
   franka::Logger logger(log_count);
 
   for (size_t i = 0; i < log_count; i++) {
-    logger.log(franka::RobotState{}, research_interface::robot::RobotCommand{});
+    logger.log(research_interface::robot::RobotState{},
+               research_interface::robot::RobotCommand{});
   }
 
   std::vector<franka::Record> log = logger.flush();
@@ -90,7 +309,8 @@ TEST(Logger, NoLogWhenLogSizeZero) {
 
   size_t log_count = 50;
   for (size_t i = 0; i < log_count; i++) {
-    logger.log(franka::RobotState{}, research_interface::robot::RobotCommand{});
+    logger.log(research_interface::robot::RobotState{},
+               research_interface::robot::RobotCommand{});
   }
 
   std::vector<franka::Record> log = logger.flush();
@@ -102,7 +322,8 @@ TEST(Logger, WellFormattedString) {
   franka::Logger logger(log_count);
 
   for (size_t i = 0; i < log_count; i++) {
-    logger.log(franka::RobotState{}, research_interface::robot::RobotCommand{});
+    logger.log(research_interface::robot::RobotState{},
+               research_interface::robot::RobotCommand{});
   }
 
   std::string log = franka::logToCSV(logger.flush());
@@ -127,7 +348,8 @@ TEST(Logger, WellFormattedString) {
 
 TEST(Logger, NoDuplicateColumns) {
   franka::Logger logger(1);
-  logger.log(franka::RobotState{}, research_interface::robot::RobotCommand{});
+  logger.log(research_interface::robot::RobotState{},
+             research_interface::robot::RobotCommand{});
 
   std::string log = franka::logToCSV(logger.flush());
 
@@ -144,3 +366,277 @@ TEST(Logger, EmptyLogEmptyString) {
 
   EXPECT_STREQ("", csv_string.c_str());
 }
+
+TEST(Logger, CSVContainsAllFields) {
+  franka::Logger logger(2, franka::LogFields::kAll);
+  research_interface::robot::RobotState state;
+  randomRobotState(state);
+  research_interface::robot::RobotCommand command;
+  randomRobotCommand(command);
+  logger.log(state, command);
+  logger.log(state, command);
+  std::vector<franka::Record> log = logger.flush();
+
+  std::string csv = franka::logToCSV(log, franka::LogFields::kAll);
+  std::vector<std::string> lines = splitAt(csv, '\n');
+  ASSERT_EQ(3u, lines.size());
+  std::vector<std::string> titles = splitAt(lines[0], ',');
+  std::vector<std::string> values = splitAt(lines[1], ',');
+  EXPECT_THAT(findDuplicates(titles), ElementsAre());
+  ASSERT_EQ(titles.size(), values.size());
+
+  auto value = [&](const std::string& title) {
+    auto it = std::find(titles.begin(), titles.end(), title);
+    EXPECT_NE(titles.end(), it) << title;
+    return values.at(static_cast<size_t>(it - titles.begin()));
+  };
+  EXPECT_EQ(std::to_string(log[0].state.time.toMSec()), value("time"));
+  EXPECT_EQ(log[0].state.O_T_EE_c[15], std::strtod(value("state.O_T_EE_c[15]").c_str(), nullptr));
+  EXPECT_EQ(log[0].state.m_total, std::strtod(value("state.m_total").c_str(), nullptr));
+  EXPECT_EQ(log[0].state.dtheta[6], std::strtod(value("state.dtheta[6]").c_str(), nullptr));
+  EXPECT_EQ(std::to_string(static_cast<uint64_t>(log[0].state.robot_mode)),
+            value("state.robot_mode"));
+  EXPECT_EQ(log[0].command.cartesian_pose.O_T_EE[3],
+            std::strtod(value("cmd.O_T_EE_d[3]").c_str(), nullptr));
+}
+
+TEST(Logger, CSVWritesSelectedFields) {
+  franka::Logger logger(1);
+  logger.log(research_interface::robot::RobotState{},
+             research_interface::robot::RobotCommand{});
+
+  std::string csv = franka::logToCSV(logger.flush(), franka::LogFields::kTauJ);
+  std::string header = splitAt(csv, '\n').at(0);
+  EXPECT_EQ(9u, splitAt(header, ',').size());
+  EXPECT_PRED2(stringContains, header, "state.tau_J[6]");
+  EXPECT_FALSE(stringContains(header, "state.q"));
+}
+
+TEST(Logger, BinaryLogHasRecordFormat) {
+  franka::Logger logger(3, franka::LogFields::kAll);
+  research_interface::robot::RobotState state;
+  randomRobotState(state);
+  research_interface::robot::RobotCommand command;
+  randomRobotCommand(command);
+  for (size_t i = 0; i < 3; i++) {
+    logger.log(state, command);
+  }
+  std::vector<franka::Record> log = logger.flush();
+
+  std::vector<char> data = franka::logToBinary(log, franka::LogFields::kQ);
+  ASSERT_GE(data.size(), 24u);
+  EXPECT_EQ(0, std::memcmp(data.data(), "FRANKREC", 8));
+  uint32_t header_size, record_size, field_count;
+  std::memcpy(&header_size, data.data() + 12, sizeof(header_size));
+  std::memcpy(&record_size, data.data() + 16, sizeof(record_size));
+  std::memcpy(&field_count, data.data() + 20, sizeof(field_count));
+  EXPECT_EQ(0u, header_size % 64);
+  EXPECT_EQ(3u, field_count);
+  EXPECT_EQ((1 + 1 + 7) * sizeof(double), record_size);
+  ASSERT_EQ(header_size + 3 * record_size, data.size());
+
+  std::array<double, 7> q;
+  std::memcpy(q.data(), data.data() + header_size + 2 * record_size + 2 * sizeof(double),
+              sizeof(q));
+  EXPECT_EQ(log[2].state.q, q);
+
+  EXPECT_TRUE(franka::logToBinary({}).empty());
+}
+
+TEST(Logger, ArrowLogHasOneColumnPerValue) {
+  std::vector<franka::Record> log(5);
+  for (size_t i = 0; i < log.size(); i++) {
+    log[i].state.q[3] = 0.5 * static_cast<double>(i);
+  }
+  const std::string path = "logger_arrow_test.arrow";
+  franka::logToArrow(log, path, franka::LogFields::kQ);
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::remove(path.c_str());
+
+  ASSERT_LT(16u, data.size());
+  EXPECT_EQ(0, std::memcmp(data.data(), "ARROW1\0\0", 8));
+  EXPECT_EQ(0, std::memcmp(data.data() + data.size() - 6, "ARROW1", 6));
+  EXPECT_PRED2(stringContains, std::string(data.begin(), data.end()), "state.q[3]");
+
+  std::vector<double> column;
+  for (const franka::Record& record : log) {
+    column.push_back(record.state.q[3]);
+  }
+  const char* column_data = reinterpret_cast<const char*>(column.data());
+  EXPECT_NE(data.end(), std::search(data.begin(), data.end(), column_data,
+                                    column_data + column.size() * sizeof(double)));
+}
+
+TEST(Logger, ArrowLogThrowsIfFileCannotBeOpened) {
+  EXPECT_THROW(franka::logToArrow({}, "/nonexistent/directory/log.arrow"), franka::Exception);
+}
+
+namespace {
+
+// Samples of a smooth motion at 1 kHz, with a torque step after one second.
+void smoothSample(uint64_t time_ms,
+                  research_interface::robot::RobotState* state,
+                  research_interface::robot::RobotCommand* command) {
+  *state = research_interface::robot::RobotState{};
+  *command = research_interface::robot::RobotCommand{};
+  double t = 0.001 * static_cast<double>(time_ms);
+  state->message_id = 1000 + time_ms;
+  state->control_command_success_rate = 0.5 + 0.01 * static_cast<double>(time_ms % 50);
+  for (size_t i = 0; i < 7; i++) {
+    double phase = static_cast<double>(i);
+    state->q[i] = 0.5 * std::sin(t + phase);
+    state->q_d[i] = state->q[i] + 1e-4;
+    state->dq[i] = 0.5 * std::cos(t + phase);
+    state->dq_d[i] = state->dq[i];
+    state->tau_J[i] = 2 * std::sin(3 * t + phase) + (time_ms > 1000 ? 5.0 : 0.0);
+    state->tau_ext_hat_filtered[i] = 0.1 * std::sin(t);
+    command->motion.q_c[i] = state->q[i];
+    command->motion.dq_c[i] = state->dq[i];
+    command->control.tau_J_d[i] = state->tau_J[i] - 1;
+  }
+  command->motion.O_T_EE_c = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3 * std::sin(t), 0, 0.5, 1}};
+  command->motion.O_dP_EE_c = {{0.3 * std::cos(t), 0, 0, 0, 0, 0.1}};
+}
+
+void expectArraysNear(const std::array<double, 7>& expected,
+                      const std::array<double, 7>& actual,
+                      double resolution) {
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_NEAR(expected[i], actual[i], 0.5 * resolution * (1 + 1e-6));
+  }
+}
+
+}  // anonymous namespace
+
+TEST(Logger, CompressedLogKeepsValuesWithinResolution) {
+  franka::LogCompression compression;
+  compression.enabled = true;
+  compression.keyframe_interval = 64;
+  franka::Logger logger(1500, franka::LogFields::kCSV, compression);
+
+  std::vector<research_interface::robot::RobotState> states(2000);
+  std::vector<research_interface::robot::RobotCommand> commands(2000);
+  for (size_t i = 0; i < states.size(); i++) {
+    smoothSample(i, &states[i], &commands[i]);
+    logger.log(states[i], commands[i]);
+  }
+
+  franka::ExceptionLog log = logger.flush();
+  ASSERT_EQ(1500u, log.size());
+  for (size_t i = 0; i < log.size(); i++) {
+    const research_interface::robot::RobotState& state = states[500 + i];
+    const research_interface::robot::RobotCommand& command = commands[500 + i];
+    const franka::Record& record = log[i];
+    EXPECT_EQ(franka::Duration(state.message_id), record.state.time);
+    EXPECT_FLOAT_EQ(state.control_command_success_rate, record.state.control_command_success_rate);
+    expectArraysNear(state.q, record.state.q, compression.joint_position_resolution);
+    expectArraysNear(state.q_d, record.state.q_d, compression.joint_position_resolution);
+    expectArraysNear(state.dq, record.state.dq, compression.joint_velocity_resolution);
+    expectArraysNear(state.dq_d, record.state.dq_d, compression.joint_velocity_resolution);
+    expectArraysNear(state.tau_J, record.state.tau_J, compression.torque_resolution);
+    expectArraysNear(state.tau_ext_hat_filtered, record.state.tau_ext_hat_filtered,
+                     compression.torque_resolution);
+    expectArraysNear(command.motion.q_c, record.command.joint_positions.q,
+                     compression.joint_position_resolution);
+    expectArraysNear(command.motion.dq_c, record.command.joint_velocities.dq,
+                     compression.joint_velocity_resolution);
+    expectArraysNear(command.control.tau_J_d, record.command.torques.tau_J,
+                     compression.torque_resolution);
+    EXPECT_NEAR(command.motion.O_T_EE_c[12], record.command.cartesian_pose.O_T_EE[12],
+                compression.cartesian_resolution);
+    EXPECT_NEAR(command.motion.O_dP_EE_c[0], record.command.cartesian_velocities.O_dP_EE[0],
+                compression.cartesian_resolution);
+    EXPECT_EQ(franka::RobotState().theta, record.state.theta);
+  }
+  EXPECT_EQ(0u, logger.flush().size());
+}
+
+TEST(Logger, CompressedLogSnapshotDoesNotAllocate) {
+  franka::LogCompression compression;
+  compression.enabled = true;
+  compression.keyframe_interval = 16;
+  franka::Logger logger(100, franka::LogFields::kQ | franka::LogFields::kTauJ, compression);
+
+  research_interface::robot::RobotState state;
+  research_interface::robot::RobotCommand command;
+  std::vector<franka::Record> snapshot(3);
+  franka::ExceptionLog log;
+  {
+    franka::AllocationTrackingScope allocation_tracking;
+    for (uint64_t i = 0; i < 250; i++) {
+      smoothSample(i, &state, &command);
+      logger.log(state, command);
+    }
+    EXPECT_EQ(3u, logger.snapshot(snapshot.data(), snapshot.size()));
+    log = logger.flush();
+    EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+  }
+
+  ASSERT_EQ(100u, log.size());
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    EXPECT_EQ(log[97 + i].state.time, snapshot[i].state.time);
+    EXPECT_EQ(log[97 + i].state.q, snapshot[i].state.q);
+    EXPECT_EQ(log[97 + i].state.tau_J, snapshot[i].state.tau_J);
+  }
+  EXPECT_EQ(franka::Duration(1000 + 249), log.back().state.time);
+}
+
+TEST(Logger, CompressedLogDropsSamplesWhoseOverflowValuesWereOverwritten) {
+  franka::LogCompression compression;
+  compression.enabled = true;
+  compression.keyframe_interval = 10;
+  franka::Logger logger(100, franka::LogFields::kQ, compression);
+
+  // Every value changes by far more than a residual byte can hold.
+  std::vector<research_interface::robot::RobotState> states(300);
+  for (size_t i = 0; i < states.size(); i++) {
+    randomRobotState(states[i]);
+    states[i].message_id = i;
+    for (double& q : states[i].q) {
+      q = std::fmod(q, 3.0);
+    }
+    logger.log(states[i], research_interface::robot::RobotCommand{});
+  }
+
+  franka::ExceptionLog log = logger.flush();
+  ASSERT_GT(log.size(), 0u);
+  EXPECT_LT(log.size(), 100u);
+  for (size_t i = 0; i < log.size(); i++) {
+    const research_interface::robot::RobotState& state = states[states.size() - log.size() + i];
+    EXPECT_EQ(franka::Duration(state.message_id), log[i].state.time);
+    expectArraysNear(state.q, log[i].state.q, compression.joint_position_resolution);
+  }
+}
+
+TEST(Logger, CompressedLogUsesAFractionOfTheRawMemory) {
+  const size_t log_size = 60000;
+  franka::LogCompression compression;
+  compression.enabled = true;
+  franka::CompressedLogRing ring(
+      log_size, franka::LogFields::kQ | franka::LogFields::kDq | franka::LogFields::kTauJ,
+      compression);
+
+  // Time, success rate and three joint arrays.
+  size_t raw_size = log_size * (sizeof(uint64_t) + sizeof(double) + 3 * 7 * sizeof(double));
+  EXPECT_LT(5 * ring.capacityBytes(), raw_size);
+}
+
+TEST(Logger, CompressedLogThrowsOnInvalidParameters) {
+  franka::LogCompression compression;
+  compression.enabled = true;
+  EXPECT_THROW(franka::Logger(10, franka::LogFields::kAll, compression), std::invalid_argument);
+  EXPECT_NO_THROW(franka::Logger(10, franka::LogFields::kCSV, compression));
+
+  franka::LogCompression zero_interval = compression;
+  zero_interval.keyframe_interval = 0;
+  EXPECT_THROW(franka::Logger(10, franka::LogFields::kQ, zero_interval), std::invalid_argument);
+
+  franka::LogCompression zero_resolution = compression;
+  zero_resolution.torque_resolution = 0;
+  EXPECT_THROW(franka::Logger(10, franka::LogFields::kQ, zero_resolution), std::invalid_argument);
+
+  // Disabled compression does not check the parameters.
+  zero_resolution.enabled = false;
+  EXPECT_NO_THROW(franka::Logger(10, franka::LogFields::kAll, zero_resolution));
+}
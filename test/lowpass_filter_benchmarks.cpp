@@ -0,0 +1,81 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+#include <franka/butterworth_filter.h>
+#include <franka/lowpass_filter.h>
+
+using namespace franka;  // NOLINT(google-build-using-namespace)
+
+static void BM_LowpassFilter(benchmark::State& state) {
+  double y = 1.0;
+  double y_last = 0.5;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lowpassFilter(1e-3, y, y_last, kDefaultCutoffFrequency));
+  }
+}
+BENCHMARK(BM_LowpassFilter);
+
+static void BM_LowpassFilterJoints(benchmark::State& state) {
+  std::array<double, 7> y{{0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7}};
+  std::array<double, 7> y_last{};
+  for (auto _ : state) {
+    for (size_t i = 0; i < y.size(); i++) {
+      y_last[i] = lowpassFilter(1e-3, y[i], y_last[i], kDefaultCutoffFrequency);
+    }
+    benchmark::DoNotOptimize(y_last);
+  }
+}
+BENCHMARK(BM_LowpassFilterJoints);
+
+static void BM_LowpassFilterArray(benchmark::State& state) {
+  LowpassFilter<7> filter(1e-3, kDefaultCutoffFrequency);
+  std::array<double, 7> y{{0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7}};
+  std::array<double, 7> y_last{};
+  for (auto _ : state) {
+    y_last = filter.filter(y, y_last);
+    benchmark::DoNotOptimize(y_last);
+  }
+}
+BENCHMARK(BM_LowpassFilterArray);
+
+static void BM_CartesianLowpassFilter(benchmark::State& state) {
+  std::array<double, 16> y{{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.3, 0.1, 0.5, 1}};
+  std::array<double, 16> y_last{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3, 0, 0.5, 1}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cartesianLowpassFilter(1e-3, y, y_last, kDefaultCutoffFrequency));
+  }
+}
+BENCHMARK(BM_CartesianLowpassFilter);
+
+static void BM_CartesianPoseLowpassFilter(benchmark::State& state) {
+  CartesianPoseLowpassFilter filter(1e-3, kDefaultCutoffFrequency);
+  std::array<double, 16> y{{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.3, 0.1, 0.5, 1}};
+  std::array<double, 16> y_last{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3, 0, 0.5, 1}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter.filter(y, y_last));
+  }
+}
+BENCHMARK(BM_CartesianPoseLowpassFilter);
+
+static void BM_CartesianPoseLowpassFilterReusingOutput(benchmark::State& state) {
+  CartesianPoseLowpassFilter filter(1e-3, kDefaultCutoffFrequency);
+  std::array<double, 16> y{{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.3, 0.1, 0.5, 1}};
+  std::array<double, 16> y_last{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3, 0, 0.5, 1}};
+  for (auto _ : state) {
+    y_last = filter.filter(y, y_last);
+    benchmark::DoNotOptimize(y_last);
+  }
+}
+BENCHMARK(BM_CartesianPoseLowpassFilterReusingOutput);
+
+static void BM_ButterworthFilterJoints(benchmark::State& state) {
+  ButterworthFilter<7, 4> filter(1e-3, kDefaultCutoffFrequency);
+  std::array<double, 7> y{{0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter.filter(y));
+  }
+}
+BENCHMARK(BM_ButterworthFilterJoints);
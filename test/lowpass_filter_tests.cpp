@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 #include <Eigen/Dense>
 
+#include <franka/control_tools.h>
 #include <franka/lowpass_filter.h>
 
 #include "helpers.h"
@@ -24,6 +25,77 @@ TEST(LowpassFilter, DoesFilter) {
   EXPECT_NEAR(lowpassFilter(0.001, 1.0, 0.0, 900.0), 0.8497, 1e-4);
 }
 
+TEST(LowpassFilter, ArrayFilterMatchesScalarFunction) {
+  std::array<double, 7> y{{1.0, -0.5, 0.25, 3.0, -2.0, 0.0, 1e-3}};
+  std::array<double, 7> y_last{{0.0, 0.5, 0.25, -3.0, 2.0, 1.0, 0.0}};
+  for (double cutoff_frequency : {10.0, 100.0, 500.0, 1000.0}) {
+    LowpassFilter<7> filter(0.001, cutoff_frequency);
+    std::array<double, 7> filtered = filter.filter(y, y_last);
+    for (size_t i = 0; i < y.size(); i++) {
+      EXPECT_EQ(lowpassFilter(0.001, y[i], y_last[i], cutoff_frequency), filtered[i]);
+    }
+  }
+}
+
+TEST(LowpassFilter, ArrayFilterCanUseCutoffFrequencyPerChannel) {
+  std::array<double, 3> cutoff_frequencies{{10.0, kMaxCutoffFrequency, 500.0}};
+  LowpassFilter<3> filter(0.001, cutoff_frequencies);
+  std::array<double, 3> filtered = filter.filter({{1.0, 1.0, 1.0}}, {{0.0, 0.0, 0.0}});
+
+  EXPECT_EQ(lowpassFilter(0.001, 1.0, 0.0, 10.0), filtered[0]);
+  EXPECT_EQ(1.0, filtered[1]);
+  EXPECT_EQ(1.0, filter.gain(1));
+  EXPECT_EQ(lowpassFilter(0.001, 1.0, 0.0, 500.0), filtered[2]);
+
+  cutoff_frequencies[0] = 0.0;
+  EXPECT_THROW((LowpassFilter<3>(0.001, cutoff_frequencies)), std::invalid_argument);
+}
+
+TEST(LowpassFilter, ArrayFilterThrowsOnInvalidArguments) {
+  constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+  constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  EXPECT_THROW(LowpassFilter<3>(-0.001, 100.0), std::invalid_argument);
+  EXPECT_THROW(LowpassFilter<3>(kNaN, 100.0), std::invalid_argument);
+  EXPECT_THROW(LowpassFilter<3>(0.001, 0.0), std::invalid_argument);
+  EXPECT_THROW(LowpassFilter<3>(0.001, kInfinity), std::invalid_argument);
+
+  LowpassFilter<3> filter(0.001, 100.0);
+  EXPECT_THROW(filter.filter({{0, kNaN, 0}}, {{0, 0, 0}}), std::invalid_argument);
+  EXPECT_THROW(filter.filter({{0, 0, 0}}, {{0, 0, kInfinity}}), std::invalid_argument);
+}
+
+TEST(LowpassFilter, UncheckedFilterPropagatesInvalidInputs) {
+  constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+  LowpassFilter<3> filter(0.001, 100.0);
+  std::array<double, 3> filtered = filter.filterUnchecked({{0, kNaN, 0}}, {{1, 1, 1}});
+  EXPECT_EQ(filter.filter({{0, 0, 0}}, {{1, 1, 1}})[0], filtered[0]);
+  EXPECT_TRUE(std::isnan(filtered[1]));
+  EXPECT_FALSE(franka::hasFiniteSum(filtered));
+
+  std::array<double, 16> pose{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  std::array<double, 16> invalid_pose = pose;
+  invalid_pose[12] = kNaN;
+  CartesianPoseLowpassFilter pose_filter(0.001, 100.0);
+  EXPECT_FALSE(franka::hasFiniteSum(pose_filter.filterUnchecked(invalid_pose, pose)));
+  EXPECT_TRUE(franka::hasFiniteSum(pose_filter.filterUnchecked(pose, pose)));
+}
+
+double rotationalJerk(const std::array<double, 16>& input1,
+                      const std::array<double, 16>& input2,
+                      const std::array<double, 16>& output1,
+                      const std::array<double, 16>& output2) {
+  auto velocity1 = differentiateOneSample(output1, input1, 0.001);
+  auto velocity2 = differentiateOneSample(output2, input2, 0.001);
+
+  std::array<double, 6> jerk;
+  for (int i = 0; i < 6; i++) {
+    double acceleration1 = velocity1[i] / 0.001;
+    double acceleration2 = (velocity2[i] - velocity1[i]) / 0.001;
+    jerk[i] = (acceleration2 - acceleration1) / 0.001;
+  }
+  return std::sqrt(std::pow(jerk[3], 2) + std::pow(jerk[4], 2) + std::pow(jerk[5], 2));
+}
+
 TEST(CartesianLowpassFilter, CanFixNonOrthonormalRotation) {
   // These three poses are all only barely orthonormal, such that the cartesianLowpassFilter will
   // generate a jerky movement when it does not orthonormalize these first before applying the
@@ -54,15 +126,64 @@ TEST(CartesianLowpassFilter, CanFixNonOrthonormalRotation) {
 
   auto output_array1 = cartesianLowpassFilter(0.001, pose_array2, pose_array1, 100.);
   auto output_array2 = cartesianLowpassFilter(0.001, pose_array3, pose_array2, 100.);
-  auto velocity1 = differentiateOneSample(output_array1, pose_array1, 0.001);
-  auto velocity2 = differentiateOneSample(output_array2, pose_array2, 0.001);
+  EXPECT_LT(rotationalJerk(pose_array1, pose_array2, output_array1, output_array2), 1000);
 
-  std::array<double, 6> jerk;
-  for (int i = 0; i < 6; i++) {
-    double acceleration1 = velocity1[i] / 0.001;
-    double acceleration2 = (velocity2[i] - velocity1[i]) / 0.001;
-    jerk[i] = (acceleration2 - acceleration1) / 0.001;
+  CartesianPoseLowpassFilter filter(0.001, 100.);
+  output_array1 = filter.filter(pose_array2, pose_array1);
+  output_array2 = filter.filter(pose_array3, pose_array2);
+  EXPECT_LT(rotationalJerk(pose_array1, pose_array2, output_array1, output_array2), 1000);
+}
+
+TEST(CartesianPoseLowpassFilter, StaysCloseToSlerp) {
+  Eigen::Vector3d axis = Eigen::Vector3d(0.3, -0.5, 0.8).normalized();
+  for (double angle : {1e-3, 1e-2, 0.1, 0.5}) {
+    Eigen::Affine3d pose_last(Eigen::AngleAxisd(0.7, Eigen::Vector3d::UnitZ()));
+    pose_last.translation() << 0.3, -0.1, 0.5;
+    Eigen::Affine3d pose(Eigen::AngleAxisd(angle, axis) * pose_last.linear());
+    pose.translation() << 0.31, -0.12, 0.49;
+    std::array<double, 16> y{};
+    std::array<double, 16> y_last{};
+    Eigen::Map<Eigen::Matrix4d>(y.data()) = pose.matrix();
+    Eigen::Map<Eigen::Matrix4d>(y_last.data()) = pose_last.matrix();
+
+    for (double cutoff_frequency : {10.0, 100.0, 500.0}) {
+      CartesianPoseLowpassFilter filter(0.001, cutoff_frequency);
+      Eigen::Affine3d expected(
+          Eigen::Matrix4d::Map(cartesianLowpassFilter(0.001, y, y_last, cutoff_frequency).data()));
+      Eigen::Affine3d actual(Eigen::Matrix4d::Map(filter.filter(y, y_last).data()));
+
+      Eigen::AngleAxisd difference(expected.linear().transpose() * actual.linear());
+      EXPECT_LT(std::abs(difference.angle()), std::pow(angle, 3) / 200 + 1e-12);
+      EXPECT_TRUE(expected.translation().isApprox(actual.translation(), 1e-12));
+      EXPECT_TRUE(actual.linear().isUnitary(1e-12));
+    }
   }
-  double total_jerk = std::sqrt(std::pow(jerk[3], 2) + std::pow(jerk[4], 2) + std::pow(jerk[5], 2));
-  EXPECT_LT(total_jerk, 1000);
+}
+
+TEST(CartesianPoseLowpassFilter, ReusesLastOutput) {
+  std::array<double, 16> y{{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.3, 0.1, 0.5, 1}};
+  std::array<double, 16> y_last{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3, 0, 0.5, 1}};
+  CartesianPoseLowpassFilter filter(0.001, 100.0);
+  for (int i = 0; i < 100; i++) {
+    std::array<double, 16> output = filter.filter(y, y_last);
+    std::array<double, 16> expected = CartesianPoseLowpassFilter(0.001, 100.0).filter(y, y_last);
+    for (size_t j = 0; j < output.size(); j++) {
+      EXPECT_NEAR(expected[j], output[j], 1e-12);
+    }
+    y_last = output;
+  }
+  EXPECT_NEAR(y_last[1], 1.0, 1e-6);
+  EXPECT_NEAR(y_last[4], -1.0, 1e-6);
+}
+
+TEST(CartesianPoseLowpassFilter, ThrowsOnInvalidArguments) {
+  EXPECT_THROW(CartesianPoseLowpassFilter(-0.001, 100.0), std::invalid_argument);
+  EXPECT_THROW(CartesianPoseLowpassFilter(0.001, 0.0), std::invalid_argument);
+
+  std::array<double, 16> y{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  std::array<double, 16> y_invalid = y;
+  y_invalid[12] = std::numeric_limits<double>::quiet_NaN();
+  CartesianPoseLowpassFilter filter(0.001, 100.0);
+  EXPECT_THROW(filter.filter(y_invalid, y), std::invalid_argument);
+  EXPECT_THROW(filter.filter(y, y_invalid), std::invalid_argument);
 }
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <franka/robot_state.h>
+#include <franka/robot_state_view.h>
 
 #include "robot_control.h"
 
@@ -25,9 +26,72 @@ class MockRobotControl : public franka::RobotControl {
       franka::RobotState(const research_interface::robot::MotionGeneratorCommand* motion_command,
                          const research_interface::robot::ControllerCommand* control_command));
 
+  MOCK_METHOD2(updateView,
+               franka::RobotStateView(
+                   const research_interface::robot::MotionGeneratorCommand* motion_command,
+                   const research_interface::robot::ControllerCommand* control_command));
+
   MOCK_METHOD2(throwOnMotionError, void(const franka::RobotState& robot_state, uint32_t motion_id));
+  MOCK_METHOD2(throwOnMotionError,
+               void(const franka::RobotStateView& robot_state, uint32_t motion_id));
 
   franka::RealtimeConfig realtimeConfig() const noexcept override {
     return franka::RealtimeConfig::kIgnore;
   }
+
+  const franka::RealtimeOptions& realtimeOptions() const noexcept override {
+    return realtime_options;
+  }
+
+  franka::ControlStatisticsRecorder* controlStatisticsRecorder() noexcept override {
+    return statistics_recorder;
+  }
+
+  franka::LimitingStatisticsRecorder* limitingStatisticsRecorder() noexcept override {
+    return limiting_statistics_recorder;
+  }
+
+  const franka::JointStateEstimatorParameters* jointStateEstimatorParameters() const
+      noexcept override {
+    return joint_state_estimator_parameters;
+  }
+
+  const franka::Model* statePredictionModel() const noexcept override {
+    return state_prediction_model;
+  }
+
+  franka::MomentumObserver* momentumObserver() noexcept override { return momentum_observer; }
+
+  const franka::Model* momentumObserverModel() const noexcept override {
+    return momentum_observer_model;
+  }
+
+  franka::PassivityController* passivityController() noexcept override {
+    return passivity_controller;
+  }
+
+  bool onlineTrajectoryGeneration() const noexcept override { return online_trajectory_generation; }
+
+  const franka::CallbackDeadline* callbackDeadline() const noexcept override {
+    return callback_deadline;
+  }
+
+  franka::DeadlineStatistics* deadlineStatistics() noexcept override {
+    return &deadline_statistics;
+  }
+
+  franka::ValidationPolicy validationPolicy() const noexcept override { return validation_policy; }
+
+  franka::ControlStatisticsRecorder* statistics_recorder = nullptr;
+  franka::LimitingStatisticsRecorder* limiting_statistics_recorder = nullptr;
+  const franka::JointStateEstimatorParameters* joint_state_estimator_parameters = nullptr;
+  const franka::Model* state_prediction_model = nullptr;
+  franka::MomentumObserver* momentum_observer = nullptr;
+  const franka::Model* momentum_observer_model = nullptr;
+  franka::PassivityController* passivity_controller = nullptr;
+  bool online_trajectory_generation = false;
+  const franka::CallbackDeadline* callback_deadline = nullptr;
+  franka::DeadlineStatistics deadline_statistics{};
+  franka::ValidationPolicy validation_policy = franka::ValidationPolicy::kFull;
+  franka::RealtimeOptions realtime_options{};
 };
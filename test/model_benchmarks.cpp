@@ -0,0 +1,206 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <franka/model.h>
+#include <franka/operational_space.h>
+#include <franka/robot.h>
+#include <research_interface/robot/service_types.h>
+
+#include "helpers.h"
+#include "mock_server.h"
+
+using namespace research_interface::robot;  // NOLINT(google-build-using-namespace)
+
+namespace {
+
+// Serves FRANKA_BENCHMARK_MODEL_LIBRARY if set, or the stub model library otherwise. The stub
+// does not compute anything, so only the overhead of libfranka is measured with it.
+std::vector<char> readModelLibrary() {
+  const char* path = std::getenv("FRANKA_BENCHMARK_MODEL_LIBRARY");
+  std::string library_path = path != nullptr ? path : FRANKA_TEST_BINARY_DIR "/libfcimodels.so";
+  std::ifstream stream(library_path,
+                       std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+  std::vector<char> buffer(static_cast<size_t>(stream.tellg()));
+  stream.seekg(0, std::ios::beg);
+  if (!stream.read(buffer.data(), buffer.size())) {
+    throw std::runtime_error("Model benchmark: Cannot read " + library_path);
+  }
+  return buffer;
+}
+
+franka::Model& model() {
+  static RobotMockServer server;
+  static franka::Robot robot("127.0.0.1");
+  static std::unique_ptr<franka::Model> model = [] {
+    std::vector<char> buffer = readModelLibrary();
+    server
+        .generic([=](RobotMockServer::Socket& tcp_socket, RobotMockServer::Socket&) {
+          CommandHeader header;
+          server.receiveRequest<LoadModelLibrary>(tcp_socket, &header);
+          server.sendResponse<LoadModelLibrary>(
+              tcp_socket,
+              CommandHeader(Command::kLoadModelLibrary, header.command_id,
+                            sizeof(CommandMessage<LoadModelLibrary::Response>) + buffer.size()),
+              LoadModelLibrary::Response(LoadModelLibrary::Status::kSuccess));
+          tcp_socket.sendBytes(buffer.data(), buffer.size());
+        })
+        .spinOnce();
+    return std::make_unique<franka::Model>(robot.loadModel());
+  }();
+  return *model;
+}
+
+franka::RobotState robotState() {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+  return robot_state;
+}
+
+}  // anonymous namespace
+
+static void BM_ModelPose(benchmark::State& state) {
+  franka::Frame frame = static_cast<franka::Frame>(state.range(0));
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().pose(frame, robot_state));
+  }
+}
+BENCHMARK(BM_ModelPose)->DenseRange(0, franka::kFrameCount - 1);
+
+static void BM_ModelPoseWithEndEffectorFrames(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  franka::EndEffectorFrames frames(robot_state.F_T_EE, robot_state.EE_T_K);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().pose(franka::Frame::kStiffness, robot_state.q, frames));
+  }
+}
+BENCHMARK(BM_ModelPoseWithEndEffectorFrames);
+
+static void BM_ModelPoseAll(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  franka::FramePoses poses;
+  franka::FrameJacobians zero_jacobians;
+  bool with_jacobians = state.range(0) != 0;
+  for (auto _ : state) {
+    model().poseAll(robot_state, &poses, with_jacobians ? &zero_jacobians : nullptr);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_ModelPoseAll)->Arg(0)->Arg(1);
+
+static void BM_ModelZeroJacobianAll(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  franka::FrameJacobians zero_jacobians;
+  for (auto _ : state) {
+    model().zeroJacobianAll(robot_state, &zero_jacobians);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_ModelZeroJacobianAll);
+
+static void BM_ModelBodyJacobian(benchmark::State& state) {
+  franka::Frame frame = static_cast<franka::Frame>(state.range(0));
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().bodyJacobian(frame, robot_state));
+  }
+}
+BENCHMARK(BM_ModelBodyJacobian)->DenseRange(0, franka::kFrameCount - 1);
+
+static void BM_ModelZeroJacobian(benchmark::State& state) {
+  franka::Frame frame = static_cast<franka::Frame>(state.range(0));
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().zeroJacobian(frame, robot_state));
+  }
+}
+BENCHMARK(BM_ModelZeroJacobian)->DenseRange(0, franka::kFrameCount - 1);
+
+static void BM_ModelZeroJacobianDerivative(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        model().zeroJacobianDerivative(franka::Frame::kEndEffector, robot_state));
+  }
+}
+BENCHMARK(BM_ModelZeroJacobianDerivative);
+
+static void BM_ModelMass(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().mass(robot_state));
+  }
+}
+BENCHMARK(BM_ModelMass);
+
+static void BM_ModelCoriolis(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().coriolis(robot_state));
+  }
+}
+BENCHMARK(BM_ModelCoriolis);
+
+static void BM_ModelGravity(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(model().gravity(robot_state));
+  }
+}
+BENCHMARK(BM_ModelGravity);
+
+static void BM_ModelDynamics(benchmark::State& state) {
+  franka::RobotState robot_state = robotState();
+  franka::DynamicsBundle dynamics{};
+  bool operational_space = state.range(0) != 0;
+  for (auto _ : state) {
+    model().dynamics(robot_state, &dynamics, franka::Frame::kEndEffector, operational_space);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_ModelDynamics)->Arg(0)->Arg(1);
+
+static void BM_ModelEvaluateBatch(benchmark::State& state) {
+  size_t size = static_cast<size_t>(state.range(0));
+  std::vector<double> q(7 * size, 0.1);
+  std::vector<double> poses(16 * size);
+  std::vector<double> zero_jacobians(42 * size);
+  std::vector<double> gravity(7 * size);
+
+  franka::ModelBatch batch;
+  batch.size = size;
+  batch.q = q.data();
+  batch.poses = poses.data();
+  batch.zero_jacobians = zero_jacobians.data();
+  batch.gravity = gravity.data();
+  for (auto _ : state) {
+    model().evaluateBatch(batch);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelEvaluateBatch)->Arg(1000)->Arg(100000)->UseRealTime();
+
+static void BM_OperationalSpaceUpdate(benchmark::State& state) {
+  // Well-conditioned inputs, as the stub model library does not write any outputs.
+  franka::DynamicsBundle dynamics{};
+  for (size_t i = 0; i < 7; i++) {
+    dynamics.mass[i * 8] = 1.0;
+  }
+  for (size_t i = 0; i < 6; i++) {
+    dynamics.zero_jacobian[i * 7] = 1.0;
+  }
+  franka::OperationalSpace operational_space;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(operational_space.update(dynamics));
+  }
+}
+BENCHMARK(BM_OperationalSpaceUpdate);
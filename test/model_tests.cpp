@@ -1,12 +1,22 @@
 // Copyright (c) 2017 Franka Emika GmbH
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/TemporaryFile.h>
 
+#include <franka/cached_model.h>
 #include <franka/exception.h>
+#include <franka/kinematics.h>
 #include <franka/model.h>
 #include <franka/robot.h>
 #include <research_interface/robot/service_types.h>
@@ -17,6 +27,7 @@
 
 using ::testing::_;
 using ::testing::Invoke;
+using ::testing::NiceMock;
 using ::testing::WithArgs;
 using namespace research_interface::robot;
 
@@ -65,15 +76,21 @@ struct Model : public ::testing::Test {
     std::ifstream model_library_stream(
         FRANKA_TEST_BINARY_DIR + "/libfcimodels.so"s,
         std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
-    std::vector<char> buffer;
-    buffer.resize(model_library_stream.tellg());
+    model_library.resize(model_library_stream.tellg());
     model_library_stream.seekg(0, std::ios::beg);
-    if (!model_library_stream.read(buffer.data(), buffer.size())) {
+    if (!model_library_stream.read(model_library.data(), model_library.size())) {
       throw std::runtime_error("Model test: Cannot load mock libfcimodels.so");
     }
 
+    serveModelLibrary();
+    model_library_interface = nullptr;
+  }
+
+  // Answers one LoadModelLibrary request with the mock model library.
+  void serveModelLibrary() {
     server
-        .generic([=](decltype(server)::Socket& tcp_socket, decltype(server)::Socket&) {
+        .generic([buffer = model_library, this](decltype(server)::Socket& tcp_socket,
+                                                decltype(server)::Socket&) {
           CommandHeader header;
           server.receiveRequest<LoadModelLibrary>(tcp_socket, &header);
           server.sendResponse<LoadModelLibrary>(
@@ -84,10 +101,9 @@ struct Model : public ::testing::Test {
           tcp_socket.sendBytes(buffer.data(), buffer.size());
         })
         .spinOnce();
-
-    model_library_interface = nullptr;
   }
 
+  std::vector<char> model_library;
   RobotMockServer server{};
   franka::Robot robot{"127.0.0.1"};
 };
@@ -130,6 +146,50 @@ TEST_F(Model, CanCreateModel) {
   EXPECT_NO_THROW(robot.loadModel());
 }
 
+TEST_F(Model, CanLoadModelFromCache) {
+  Poco::TemporaryFile cache_directory;
+
+  EXPECT_NO_THROW(robot.loadModel(cache_directory.path()));
+  EXPECT_TRUE(cache_directory.isDirectory());
+
+  // The server only answers one LoadModelLibrary request, so this one has to be served from the
+  // cache.
+  EXPECT_NO_THROW(robot.loadModel(cache_directory.path()));
+}
+
+TEST_F(Model, ReplacesCorruptLibraryInCache) {
+  Poco::TemporaryFile cache_directory;
+  robot.loadModel(cache_directory.path());
+
+  std::vector<Poco::File> files;
+  Poco::File(cache_directory.path()).list(files);
+  auto library = std::find_if(files.begin(), files.end(), [](const Poco::File& file) {
+    return Poco::Path(file.path()).getExtension() != "index";
+  });
+  ASSERT_NE(files.end(), library);
+  std::ofstream(library->path(), std::ios_base::out | std::ios_base::trunc) << "corrupt";
+
+  serveModelLibrary();
+  EXPECT_NO_THROW(robot.loadModel(cache_directory.path()));
+
+  std::ifstream library_stream(library->path(), std::ios_base::in | std::ios_base::binary);
+  std::vector<char> contents{std::istreambuf_iterator<char>(library_stream),
+                             std::istreambuf_iterator<char>()};
+  EXPECT_EQ(model_library, contents);
+
+  // Served from the repaired cache.
+  EXPECT_NO_THROW(robot.loadModel(cache_directory.path()));
+}
+
+TEST_F(Model, FallsBackToTemporaryFileIfCacheIsNotWritable) {
+  // A path below a regular file cannot be created, even with root permissions.
+  Poco::TemporaryFile file;
+  file.createFile();
+
+  EXPECT_NO_THROW(robot.loadModel(file.path() + "/cache"));
+  EXPECT_TRUE(file.isFile());
+}
+
 TEST_F(Model, CanGetMassMatrix) {
   franka::RobotState robot_state;
   randomRobotState(robot_state);
@@ -390,6 +450,407 @@ TEST_F(Model, CanGetZeroJacobian) {
   }
 }
 
+TEST_F(Model, CanGetAllPosesAndZeroJacobians) {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  auto fill = [](double value, size_t size) {
+    return [=](double* output) { std::fill(output, output + size, value); };
+  };
+
+  MockModel mock;
+  EXPECT_CALL(mock, O_T_J1(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(0, 16))));
+  EXPECT_CALL(mock, O_T_J2(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(1, 16))));
+  EXPECT_CALL(mock, O_T_J3(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(2, 16))));
+  EXPECT_CALL(mock, O_T_J4(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(3, 16))));
+  EXPECT_CALL(mock, O_T_J5(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(4, 16))));
+  EXPECT_CALL(mock, O_T_J6(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(5, 16))));
+  EXPECT_CALL(mock, O_T_J7(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(6, 16))));
+  EXPECT_CALL(mock, O_T_J8(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(7, 16))));
+  EXPECT_CALL(mock, O_T_J9(robot_state.q.data(), _, _))
+      .WillOnce(WithArgs<1, 2>(Invoke([=](const double* input, double* output) {
+        std::array<double, 16> expected;
+        Eigen::Map<Eigen::Matrix4d>(expected.data(), 4, 4) =
+            Eigen::Matrix4d(robot_state.F_T_EE.data()) * Eigen::Matrix4d(robot_state.EE_T_K.data());
+        std::array<double, 16> input_array;
+        std::copy(&input[0], &input[16], input_array.data());
+        EXPECT_EQ(expected, input_array);
+        std::fill(output, output + 16, 9);
+      })));
+  EXPECT_CALL(mock, O_T_J9(robot_state.q.data(), robot_state.F_T_EE.data(), _))
+      .WillOnce(WithArgs<2>(Invoke(fill(8, 16))));
+
+  EXPECT_CALL(mock, O_J_J1(_)).WillOnce(WithArgs<0>(Invoke(fill(10, 42))));
+  EXPECT_CALL(mock, O_J_J2(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(11, 42))));
+  EXPECT_CALL(mock, O_J_J3(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(12, 42))));
+  EXPECT_CALL(mock, O_J_J4(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(13, 42))));
+  EXPECT_CALL(mock, O_J_J5(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(14, 42))));
+  EXPECT_CALL(mock, O_J_J6(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(15, 42))));
+  EXPECT_CALL(mock, O_J_J7(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(16, 42))));
+  EXPECT_CALL(mock, O_J_J8(robot_state.q.data(), _)).WillOnce(WithArgs<1>(Invoke(fill(17, 42))));
+  EXPECT_CALL(mock, O_J_J9(robot_state.q.data(), _, _)).WillOnce(WithArgs<2>(Invoke(fill(19, 42))));
+  EXPECT_CALL(mock, O_J_J9(robot_state.q.data(), robot_state.F_T_EE.data(), _))
+      .WillOnce(WithArgs<2>(Invoke(fill(18, 42))));
+
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+  franka::FramePoses poses;
+  franka::FrameJacobians jacobians;
+  model.poseAll(robot_state, &poses, &jacobians);
+  for (size_t i = 0; i < franka::kFrameCount; i++) {
+    std::array<double, 16> expected_pose;
+    expected_pose.fill(i);
+    EXPECT_EQ(expected_pose, poses[i]);
+
+    std::array<double, 42> expected_jacobian;
+    expected_jacobian.fill(10 + i);
+    EXPECT_EQ(expected_jacobian, jacobians[i]);
+  }
+}
+
+TEST_F(Model, BuiltInKinematicsMatchModelLibrary) {
+  using franka::Frame;
+  using franka::PandaKinematics;
+
+  // Serves the model library from the built-in kinematics, optionally with a displaced flange.
+  double flange_offset = 0;
+  auto copyJoints = [](const double* input) {
+    std::array<double, 7> q;
+    std::copy(input, input + q.size(), q.begin());
+    return q;
+  };
+  auto pose = [&](Frame frame) {
+    return [&, frame](const double* q, double* output) {
+      std::array<double, 16> result = PandaKinematics::pose(frame, copyJoints(q));
+      if (frame == Frame::kFlange) {
+        result[14] += flange_offset;
+      }
+      std::copy(result.begin(), result.end(), output);
+    };
+  };
+  auto jacobian = [&](Frame frame) {
+    return [&, frame](const double* q, double* output) {
+      std::array<double, 42> result = PandaKinematics::zeroJacobian(frame, copyJoints(q));
+      std::copy(result.begin(), result.end(), output);
+    };
+  };
+  auto flangeFrames = [](const double* F_T_EE) {  // NOLINT(readability-identifier-naming)
+    std::array<double, 16> end_effector;
+    std::copy(F_T_EE, F_T_EE + end_effector.size(), end_effector.begin());
+    return franka::EndEffectorFrames(end_effector,
+                                     {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}});
+  };
+  auto endEffector = [&](const double* q, const double* F_T_EE, double* output) {
+    std::array<double, 16> result =
+        PandaKinematics::pose(Frame::kEndEffector, copyJoints(q), flangeFrames(F_T_EE));
+    std::copy(result.begin(), result.end(), output);
+  };
+  auto endEffectorJacobian = [&](const double* q, const double* F_T_EE, double* output) {
+    std::array<double, 42> result =
+        PandaKinematics::zeroJacobian(Frame::kEndEffector, copyJoints(q), flangeFrames(F_T_EE));
+    std::copy(result.begin(), result.end(), output);
+  };
+
+  NiceMock<MockModel> mock;
+  ON_CALL(mock, O_T_J1(_, _)).WillByDefault(Invoke(pose(Frame::kJoint1)));
+  ON_CALL(mock, O_T_J2(_, _)).WillByDefault(Invoke(pose(Frame::kJoint2)));
+  ON_CALL(mock, O_T_J3(_, _)).WillByDefault(Invoke(pose(Frame::kJoint3)));
+  ON_CALL(mock, O_T_J4(_, _)).WillByDefault(Invoke(pose(Frame::kJoint4)));
+  ON_CALL(mock, O_T_J5(_, _)).WillByDefault(Invoke(pose(Frame::kJoint5)));
+  ON_CALL(mock, O_T_J6(_, _)).WillByDefault(Invoke(pose(Frame::kJoint6)));
+  ON_CALL(mock, O_T_J7(_, _)).WillByDefault(Invoke(pose(Frame::kJoint7)));
+  ON_CALL(mock, O_T_J8(_, _)).WillByDefault(Invoke(pose(Frame::kFlange)));
+  ON_CALL(mock, O_T_J9(_, _, _)).WillByDefault(Invoke(endEffector));
+  ON_CALL(mock, O_J_J1(_)).WillByDefault(Invoke([&](double* output) {
+    jacobian(Frame::kJoint1)(std::array<double, 7>{}.data(), output);
+  }));
+  ON_CALL(mock, O_J_J2(_, _)).WillByDefault(Invoke(jacobian(Frame::kJoint2)));
+  ON_CALL(mock, O_J_J3(_, _)).WillByDefault(Invoke(jacobian(Frame::kJoint3)));
+  ON_CALL(mock, O_J_J4(_, _)).WillByDefault(Invoke(jacobian(Frame::kJoint4)));
+  ON_CALL(mock, O_J_J5(_, _)).WillByDefault(Invoke(jacobian(Frame::kJoint5)));
+  ON_CALL(mock, O_J_J6(_, _)).WillByDefault(Invoke(jacobian(Frame::kJoint6)));
+  ON_CALL(mock, O_J_J7(_, _)).WillByDefault(Invoke(jacobian(Frame::kJoint7)));
+  ON_CALL(mock, O_J_J8(_, _)).WillByDefault(Invoke(jacobian(Frame::kFlange)));
+  ON_CALL(mock, O_J_J9(_, _, _)).WillByDefault(Invoke(endEffectorJacobian));
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+  franka::EndEffectorFrames frames(
+      {{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0.1, 1}},
+      {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0.05, 1}});
+  EXPECT_TRUE(PandaKinematics::matches(model, frames));
+
+  flange_offset = 1e-3;
+  EXPECT_FALSE(PandaKinematics::matches(model, frames));
+  EXPECT_TRUE(PandaKinematics::matches(model, frames, 1e-2));
+}
+
+TEST_F(Model, CachedModelEvaluatesOncePerRobotState) {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  MockModel mock;
+  EXPECT_CALL(mock, c_NE(_, _, _, _, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          WithArgs<5>(Invoke([](double* output) { std::fill(output, output + 7, 1); })));
+  EXPECT_CALL(mock, M_NE(_, _, _, _, _))
+      .WillOnce(WithArgs<4>(Invoke([](double* output) { std::fill(output, output + 49, 2); })));
+  EXPECT_CALL(mock, g_NE(_, _, _, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          WithArgs<4>(Invoke([](double* output) { std::fill(output, output + 7, 3); })));
+  EXPECT_CALL(mock, O_J_J8(_, _))
+      .WillOnce(WithArgs<1>(Invoke([](double* output) { std::fill(output, output + 42, 4); })));
+
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+  franka::CachedModel cached_model(model);
+
+  std::array<double, 7> expected_coriolis;
+  expected_coriolis.fill(1);
+  EXPECT_EQ(expected_coriolis, cached_model.coriolis(robot_state));
+  EXPECT_EQ(expected_coriolis, cached_model.coriolis(robot_state));
+
+  std::array<double, 49> expected_mass;
+  expected_mass.fill(2);
+  EXPECT_EQ(expected_mass, cached_model.mass(robot_state));
+  EXPECT_EQ(expected_mass, cached_model.mass(robot_state));
+
+  std::array<double, 7> expected_gravity;
+  expected_gravity.fill(3);
+  EXPECT_EQ(expected_gravity, cached_model.gravity(robot_state));
+  EXPECT_EQ(expected_gravity, cached_model.gravity(robot_state));
+  // A different gravity vector has to be evaluated again.
+  EXPECT_EQ(expected_gravity, cached_model.gravity(robot_state, {{0, 0, -1}}));
+
+  std::array<double, 42> expected_jacobian;
+  expected_jacobian.fill(4);
+  EXPECT_EQ(expected_jacobian, cached_model.zeroJacobian(franka::Frame::kFlange, robot_state));
+  EXPECT_EQ(expected_jacobian, cached_model.zeroJacobian(franka::Frame::kFlange, robot_state));
+
+  // A new robot state invalidates all results.
+  robot_state.dq[0] += 1;
+  EXPECT_EQ(expected_coriolis, cached_model.coriolis(robot_state));
+}
+
+TEST_F(Model, CanGetZeroJacobianDerivative) {
+  // Planar arm with unit links, where all joints rotate about the base z axis.
+  auto planar_pose = [](size_t joint, const double* q, double* output) {
+    double angle = 0;
+    Eigen::Vector3d position = Eigen::Vector3d::Zero();
+    for (size_t i = 0; i < joint; i++) {
+      angle += q[i];
+      position += Eigen::Vector3d(std::cos(angle), std::sin(angle), 0);
+    }
+    if (joint < 7) {
+      angle += q[joint];
+    }
+    Eigen::Affine3d transform(Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ()));
+    transform.translation() = position;
+    Eigen::Map<Eigen::Matrix4d>(output) = transform.matrix();
+  };
+  auto planar_jacobian = [&](const std::array<double, 7>& q) {
+    Eigen::Matrix<double, 6, 7> jacobian = Eigen::Matrix<double, 6, 7>::Zero();
+    Eigen::Matrix4d flange;
+    planar_pose(7, q.data(), flange.data());
+    for (size_t i = 0; i < 7; i++) {
+      Eigen::Matrix4d joint;
+      planar_pose(i, q.data(), joint.data());
+      jacobian.col(i).head<3>() = Eigen::Vector3d::UnitZ().cross(
+          Eigen::Vector3d(flange.block<3, 1>(0, 3) - joint.block<3, 1>(0, 3)));
+      jacobian.col(i).tail<3>() = Eigen::Vector3d::UnitZ();
+    }
+    return jacobian;
+  };
+
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  MockModel mock;
+  EXPECT_CALL(mock, O_T_J1(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(0, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J2(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(1, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J3(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(2, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J4(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(3, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J5(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(4, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J6(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(5, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J7(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(6, q, output);
+  }));
+  EXPECT_CALL(mock, O_T_J8(_, _)).WillRepeatedly(Invoke([&](const double* q, double* output) {
+    planar_pose(7, q, output);
+  }));
+
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+  std::array<double, 42> derivative =
+      model.zeroJacobianDerivative(franka::Frame::kFlange, robot_state);
+
+  // Compare with the central difference quotient along the joint velocity.
+  constexpr double kStep = 1e-6;
+  std::array<double, 7> q_plus = robot_state.q;
+  std::array<double, 7> q_minus = robot_state.q;
+  for (size_t i = 0; i < 7; i++) {
+    q_plus[i] += kStep * robot_state.dq[i];
+    q_minus[i] -= kStep * robot_state.dq[i];
+  }
+  Eigen::Matrix<double, 6, 7> expected =
+      (planar_jacobian(q_plus) - planar_jacobian(q_minus)) / (2 * kStep);
+  EXPECT_TRUE(Eigen::Matrix<double, 6, 7>(derivative.data()).isApprox(expected, 1e-6));
+}
+
+TEST_F(Model, CanGetDynamicsBundle) {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  MockModel mock;
+  EXPECT_CALL(mock, M_NE(robot_state.q.data(), robot_state.I_total.data(), robot_state.m_total,
+                         robot_state.F_x_Ctotal.data(), _))
+      .WillOnce(WithArgs<4>(Invoke([](double* output) {
+        Eigen::Map<Eigen::Matrix<double, 7, 7>>(output) =
+            2 * Eigen::Matrix<double, 7, 7>::Identity();
+      })));
+  EXPECT_CALL(mock, c_NE(robot_state.q.data(), robot_state.dq.data(), robot_state.I_total.data(),
+                         robot_state.m_total, robot_state.F_x_Ctotal.data(), _))
+      .WillOnce(WithArgs<5>(Invoke([](double* output) { std::fill(output, output + 7, 1); })));
+  EXPECT_CALL(mock, g_NE(robot_state.q.data(), robot_state.O_ddP_O.data(), robot_state.m_total,
+                         robot_state.F_x_Ctotal.data(), _))
+      .WillOnce(WithArgs<4>(Invoke([](double* output) { std::fill(output, output + 7, 3); })));
+  EXPECT_CALL(mock, O_J_J9(robot_state.q.data(), robot_state.F_T_EE.data(), _))
+      .WillOnce(WithArgs<2>(Invoke([](double* output) {
+        Eigen::Map<Eigen::Matrix<double, 6, 7>>(output) = Eigen::Matrix<double, 6, 7>::Identity();
+      })));
+
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+  franka::DynamicsBundle dynamics;
+  EXPECT_TRUE(model.dynamics(robot_state, &dynamics, franka::Frame::kEndEffector, true));
+
+  std::array<double, 7> expected_coriolis;
+  expected_coriolis.fill(1);
+  std::array<double, 7> expected_gravity;
+  expected_gravity.fill(3);
+  EXPECT_EQ(expected_coriolis, dynamics.coriolis);
+  EXPECT_EQ(expected_gravity, dynamics.gravity);
+  EXPECT_EQ(2, dynamics.mass[0]);
+  EXPECT_EQ(1, dynamics.zero_jacobian[0]);
+
+  // With M = 2 I and J = [I 0], Lambda = 2 I and the pseudoinverse is J^T.
+  Eigen::Matrix<double, 6, 6> lambda(dynamics.lambda.data());
+  Eigen::Matrix<double, 7, 6> jacobian_pseudoinverse(dynamics.jacobian_pseudoinverse.data());
+  EXPECT_TRUE(lambda.isApprox(2 * Eigen::Matrix<double, 6, 6>::Identity()));
+  EXPECT_TRUE(jacobian_pseudoinverse.isApprox(Eigen::Matrix<double, 7, 6>::Identity()));
+}
+
+TEST_F(Model, CanEvaluateBatch) {
+  constexpr size_t kSamples = 5;
+
+  // Outputs only depend on the first joint, which is the sample index.
+  MockModel mock;
+  EXPECT_CALL(mock, O_T_J8(_, _))
+      .Times(kSamples)
+      .WillRepeatedly(Invoke(
+          [](const double* q, double* output) { std::fill(output, output + 16, q[0]); }));
+  EXPECT_CALL(mock, O_J_J8(_, _))
+      .Times(kSamples)
+      .WillRepeatedly(Invoke(
+          [](const double* q, double* output) { std::fill(output, output + 42, q[0]); }));
+  EXPECT_CALL(mock, g_NE(_, _, _, _, _))
+      .Times(kSamples)
+      .WillRepeatedly(Invoke([](const double* q, const double*, double, const double*,
+                                double* output) { std::fill(output, output + 7, q[0]); }));
+
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+
+  std::vector<double> q(7 * kSamples);
+  for (size_t i = 0; i < kSamples; i++) {
+    q[i] = i;
+  }
+  std::vector<double> poses(16 * kSamples);
+  std::vector<double> zero_jacobians(42 * kSamples);
+  std::vector<double> gravity(7 * kSamples);
+
+  franka::ModelBatch batch;
+  batch.size = kSamples;
+  batch.q = q.data();
+  batch.frame = franka::Frame::kFlange;
+  batch.poses = poses.data();
+  batch.zero_jacobians = zero_jacobians.data();
+  batch.gravity = gravity.data();
+  model.evaluateBatch(batch, 2);
+
+  for (size_t i = 0; i < kSamples; i++) {
+    for (size_t k = 0; k < 16; k++) {
+      EXPECT_EQ(i, poses[k * kSamples + i]);
+    }
+    for (size_t k = 0; k < 42; k++) {
+      EXPECT_EQ(i, zero_jacobians[k * kSamples + i]);
+    }
+    for (size_t k = 0; k < 7; k++) {
+      EXPECT_EQ(i, gravity[k * kSamples + i]);
+    }
+  }
+}
+
+TEST_F(Model, CanUsePrecomputedStiffnessFrame) {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+  franka::EndEffectorFrames frames(robot_state.F_T_EE, robot_state.EE_T_K);
+
+  // The precomputed F_T_K has to be passed to the model library as is.
+  MockModel mock;
+  EXPECT_CALL(mock, O_T_J9(robot_state.q.data(), frames.F_T_K().data(), _)).Times(1);
+  EXPECT_CALL(mock, Ji_J_J9(robot_state.q.data(), frames.F_T_K().data(), _)).Times(1);
+  EXPECT_CALL(mock, O_J_J9(robot_state.q.data(), frames.F_T_K().data(), _)).Times(1);
+
+  model_library_interface = &mock;
+
+  franka::Model model(robot.loadModel());
+  model.pose(franka::Frame::kStiffness, robot_state.q, frames);
+  model.bodyJacobian(franka::Frame::kStiffness, robot_state.q, frames);
+  model.zeroJacobian(franka::Frame::kStiffness, robot_state.q, frames);
+}
+
+TEST(EndEffectorFrames, RecomputesStiffnessFrameOnlyIfChanged) {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  franka::EndEffectorFrames frames;
+  EXPECT_TRUE(frames.set(robot_state));
+  EXPECT_FALSE(frames.set(robot_state));
+
+  std::array<double, 16> expected;
+  Eigen::Map<Eigen::Matrix4d>(expected.data()) =
+      Eigen::Matrix4d(robot_state.F_T_EE.data()) * Eigen::Matrix4d(robot_state.EE_T_K.data());
+  EXPECT_EQ(robot_state.F_T_EE, frames.F_T_EE());
+  EXPECT_EQ(robot_state.EE_T_K, frames.EE_T_K());
+  EXPECT_EQ(expected, frames.F_T_K());
+
+  robot_state.EE_T_K[12] += 1;
+  EXPECT_TRUE(frames.set(robot_state));
+  Eigen::Map<Eigen::Matrix4d>(expected.data()) =
+      Eigen::Matrix4d(robot_state.F_T_EE.data()) * Eigen::Matrix4d(robot_state.EE_T_K.data());
+  EXPECT_EQ(expected, frames.F_T_K());
+}
+
 TEST(Frame, CanIncrement) {
   franka::Frame frame = franka::Frame::kJoint3;
   EXPECT_EQ(franka::Frame::kJoint3, frame++);
@@ -0,0 +1,161 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/momentum_observer.h>
+
+using franka::DynamicsBundle;
+using franka::MomentumObserver;
+using franka::MomentumObserverParameters;
+using franka::RobotState;
+
+namespace {
+
+constexpr double kTimeStep = 0.001;
+
+DynamicsBundle makeDynamics(double scale) {
+  DynamicsBundle dynamics{};
+  for (size_t i = 0; i < 7; i++) {
+    dynamics.mass[i * 7 + i] = scale * (1.0 + 0.1 * i);
+    dynamics.coriolis[i] = 0.01 * i;
+    dynamics.gravity[i] = 1.0 + i;
+  }
+  dynamics.mass[1] = dynamics.mass[7] = 0.2 * scale;
+  for (size_t i = 0; i < 6; i++) {
+    dynamics.zero_jacobian[i * 6 + i] = 1.0;
+    dynamics.zero_jacobian[6 * 6 + i] = 0.1 * (i + 1);
+  }
+  return dynamics;
+}
+
+// Joint torques that accelerate the robot with ddq while the robot applies tau_ext to the
+// environment: M ddq + c + g = tau_J - tau_ext.
+std::array<double, 7> jointTorques(const DynamicsBundle& dynamics,
+                                   const std::array<double, 7>& ddq,
+                                   const std::array<double, 7>& tau_ext) {
+  std::array<double, 7> tau_J{};  // NOLINT(readability-identifier-naming)
+  for (size_t i = 0; i < 7; i++) {
+    tau_J[i] = dynamics.coriolis[i] + dynamics.gravity[i] + tau_ext[i];
+    for (size_t j = 0; j < 7; j++) {
+      tau_J[i] += dynamics.mass[j * 7 + i] * ddq[j];
+    }
+  }
+  return tau_J;
+}
+
+}  // anonymous namespace
+
+TEST(MomentumObserver, RejectsInvalidParameters) {
+  MomentumObserverParameters parameters;
+  parameters.cutoff_frequency = 0;
+  EXPECT_THROW(MomentumObserver{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.wrench_damping = -1;
+  EXPECT_THROW(MomentumObserver{parameters}, std::invalid_argument);
+}
+
+TEST(MomentumObserver, EstimatesExternalTorquesDuringAcceleration) {
+  MomentumObserverParameters parameters;
+  parameters.cutoff_frequency = std::numeric_limits<double>::infinity();
+  MomentumObserver observer(parameters);
+
+  std::array<double, 7> ddq{{1, -2, 0.5, 0, 3, -1, 2}};
+  std::array<double, 7> tau_ext{{0.5, -1, 2, 0, 0.1, -0.3, 1}};
+  RobotState robot_state;
+  for (size_t k = 0; k < 100; k++) {
+    DynamicsBundle dynamics = makeDynamics(1.0 + 0.001 * k);
+    robot_state.tau_J = jointTorques(dynamics, ddq, k == 0 ? std::array<double, 7>{} : tau_ext);
+    observer.update(robot_state, dynamics, k == 0 ? 0.0 : kTimeStep);
+    for (size_t i = 0; i < 7; i++) {
+      robot_state.dq[i] += ddq[i] * kTimeStep;
+    }
+  }
+
+  // The observer uses the mass matrix of the previous step, which differs slightly.
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(tau_ext[i], observer.tau_ext()[i], 1e-2);
+    EXPECT_EQ(observer.tau_ext()[i], observer.tau_ext_filtered()[i]);
+  }
+}
+
+TEST(MomentumObserver, FiltersWithConfiguredBandwidth) {
+  MomentumObserverParameters parameters;
+  parameters.cutoff_frequency = 10;
+  MomentumObserver observer(parameters);
+
+  DynamicsBundle dynamics = makeDynamics(1.0);
+  RobotState robot_state;
+  robot_state.tau_J = jointTorques(dynamics, {}, {});
+  observer.update(robot_state, dynamics, 0.0);
+
+  std::array<double, 7> tau_ext{{1, 1, 1, 1, 1, 1, 1}};
+  robot_state.tau_J = jointTorques(dynamics, {}, tau_ext);
+  double time_constant = 1 / (2 * M_PI * parameters.cutoff_frequency);
+  size_t steps = static_cast<size_t>(std::round(time_constant / kTimeStep));
+  for (size_t k = 0; k < steps; k++) {
+    observer.update(robot_state, dynamics, kTimeStep);
+  }
+
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(1.0, observer.tau_ext()[i], 1e-9);
+    EXPECT_NEAR(1 - std::exp(-1), observer.tau_ext_filtered()[i], 2e-2);
+  }
+
+  for (size_t k = 0; k < 1000; k++) {
+    observer.update(robot_state, dynamics, kTimeStep);
+  }
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(1.0, observer.tau_ext_filtered()[i], 1e-9);
+  }
+}
+
+TEST(MomentumObserver, MapsTorquesToWrench) {
+  MomentumObserverParameters parameters;
+  parameters.wrench_damping = 0;
+  MomentumObserver observer(parameters);
+
+  DynamicsBundle dynamics = makeDynamics(1.0);
+  std::array<double, 6> wrench{{1, -2, 3, 0.1, -0.2, 0.3}};
+  std::array<double, 7> tau_ext{};
+  for (size_t i = 0; i < 7; i++) {
+    for (size_t j = 0; j < 6; j++) {
+      tau_ext[i] += dynamics.zero_jacobian[i * 6 + j] * wrench[j];
+    }
+  }
+  RobotState robot_state;
+  robot_state.tau_J = jointTorques(dynamics, {}, tau_ext);
+  observer.update(robot_state, dynamics, 0.0);
+
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_NEAR(wrench[i], observer.O_F_ext()[i], 1e-9);
+    EXPECT_NEAR(wrench[i], observer.O_F_ext_filtered()[i], 1e-9);
+  }
+}
+
+TEST(MomentumObserver, ReinitializesAfterReset) {
+  MomentumObserverParameters parameters;
+  parameters.cutoff_frequency = 1;
+  MomentumObserver observer(parameters);
+
+  DynamicsBundle dynamics = makeDynamics(1.0);
+  RobotState robot_state;
+  robot_state.tau_J = jointTorques(dynamics, {}, {});
+  observer.update(robot_state, dynamics, 0.0);
+
+  std::array<double, 7> tau_ext{{2, 2, 2, 2, 2, 2, 2}};
+  robot_state.tau_J = jointTorques(dynamics, {}, tau_ext);
+  observer.update(robot_state, dynamics, kTimeStep);
+  EXPECT_LT(observer.tau_ext_filtered()[0], 0.1);
+
+  observer.reset();
+  observer.update(robot_state, dynamics, kTimeStep);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(tau_ext[i], observer.tau_ext_filtered()[i], 1e-9);
+  }
+}
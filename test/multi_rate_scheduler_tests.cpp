@@ -0,0 +1,175 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "multi_rate_scheduler.h"
+
+using franka::Duration;
+using franka::MultiRateHold;
+using franka::MultiRateOptions;
+using franka::MultiRateScheduler;
+using franka::RobotState;
+
+namespace {
+
+RobotState stateAt(uint64_t time_ms) {
+  RobotState robot_state;
+  robot_state.time = Duration(time_ms);
+  return robot_state;
+}
+
+// Waits until the condition holds, or fails after a second.
+template <typename Condition>
+void waitFor(Condition condition) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (!condition()) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+}  // anonymous namespace
+
+TEST(MultiRateScheduler, ThrowsOnInvalidParameters) {
+  MultiRateOptions options;
+  EXPECT_THROW(MultiRateScheduler(nullptr, options, stateAt(0)), std::invalid_argument);
+
+  options.divisor = 0;
+  EXPECT_THROW(MultiRateScheduler([](const RobotState&, Duration) { return std::vector<double>(); },
+                                  options, stateAt(0)),
+               std::invalid_argument);
+}
+
+TEST(MultiRateScheduler, CallsSlowCallbackWithInitialState) {
+  std::vector<Duration> periods;
+  MultiRateScheduler scheduler(
+      [&](const RobotState& robot_state, Duration period) {
+        periods.push_back(period);
+        return std::vector<double>{static_cast<double>(robot_state.time.toMSec())};
+      },
+      MultiRateOptions(), stateAt(3));
+
+  ASSERT_EQ(1u, periods.size());
+  EXPECT_EQ(0u, periods[0].toMSec());
+  EXPECT_EQ(std::vector<double>{3}, scheduler.step(stateAt(3)));
+  EXPECT_EQ(std::vector<double>{3}, scheduler.step(stateAt(4)));
+}
+
+TEST(MultiRateScheduler, HoldsOutputUntilNextUpdate) {
+  std::atomic<size_t> calls{0};
+  std::atomic<uint64_t> last_period{0};
+  MultiRateOptions options;
+  options.divisor = 5;
+  MultiRateScheduler scheduler(
+      [&](const RobotState& robot_state, Duration period) {
+        last_period = period.toMSec();
+        calls++;
+        return std::vector<double>{static_cast<double>(robot_state.time.toMSec()), -1};
+      },
+      options, stateAt(0));
+
+  for (uint64_t time = 1; time < 5; time++) {
+    EXPECT_EQ((std::vector<double>{0, -1}), scheduler.step(stateAt(time)));
+  }
+  EXPECT_EQ(1u, calls);
+
+  scheduler.step(stateAt(5));
+  waitFor([&]() { return scheduler.step(stateAt(5))[0] == 5; });
+  EXPECT_EQ(2u, calls);
+  EXPECT_EQ(5u, last_period);
+  EXPECT_EQ((std::vector<double>{5, -1}), scheduler.step(stateAt(6)));
+  EXPECT_EQ(0u, scheduler.skippedUpdates());
+}
+
+TEST(MultiRateScheduler, InterpolatesBetweenUpdates) {
+  std::atomic<size_t> calls{0};
+  MultiRateOptions options;
+  options.divisor = 4;
+  options.hold = MultiRateHold::kLinearInterpolation;
+  MultiRateScheduler scheduler(
+      [&](const RobotState& robot_state, Duration) {
+        calls++;
+        return std::vector<double>{static_cast<double>(robot_state.time.toMSec())};
+      },
+      options, stateAt(0));
+
+  EXPECT_EQ(std::vector<double>{0}, scheduler.step(stateAt(4)));
+  waitFor([&]() { return calls == 2; });
+  // The output is published right after the callback returns.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // The segment starts when the output arrives, at 5 ms.
+  EXPECT_DOUBLE_EQ(0, scheduler.step(stateAt(5))[0]);
+  EXPECT_DOUBLE_EQ(1, scheduler.step(stateAt(6))[0]);
+  EXPECT_DOUBLE_EQ(2, scheduler.step(stateAt(7))[0]);
+  EXPECT_DOUBLE_EQ(4, scheduler.step(stateAt(9))[0]);
+  EXPECT_DOUBLE_EQ(4, scheduler.step(stateAt(9))[0]);
+}
+
+TEST(MultiRateScheduler, CountsSkippedUpdates) {
+  std::atomic<size_t> calls{0};
+  std::atomic<bool> release{false};
+  MultiRateOptions options;
+  options.divisor = 1;
+  MultiRateScheduler scheduler(
+      [&](const RobotState&, Duration) {
+        if (++calls == 2) {
+          while (!release) {
+            std::this_thread::yield();
+          }
+        }
+        return std::vector<double>{0};
+      },
+      options, stateAt(0));
+
+  scheduler.step(stateAt(1));
+  waitFor([&]() { return calls == 2; });
+  scheduler.step(stateAt(2));
+  scheduler.step(stateAt(3));
+  scheduler.step(stateAt(4));
+  EXPECT_EQ(2u, scheduler.skippedUpdates());
+  release = true;
+}
+
+TEST(MultiRateScheduler, RethrowsErrorsOfSlowCallback) {
+  size_t calls = 0;
+  MultiRateOptions options;
+  options.divisor = 1;
+  MultiRateScheduler scheduler(
+      [&](const RobotState&, Duration) -> std::vector<double> {
+        if (calls++ > 0) {
+          throw std::runtime_error("slow callback failed");
+        }
+        return {0};
+      },
+      options, stateAt(0));
+
+  scheduler.step(stateAt(1));
+  EXPECT_THROW(waitFor([&]() {
+                 scheduler.step(stateAt(1));
+                 return false;
+               }),
+               std::runtime_error);
+}
+
+TEST(MultiRateScheduler, ThrowsIfOutputChangesInSize) {
+  size_t calls = 0;
+  MultiRateOptions options;
+  options.divisor = 1;
+  MultiRateScheduler scheduler(
+      [&](const RobotState&, Duration) { return std::vector<double>(++calls, 0.0); }, options,
+      stateAt(0));
+
+  scheduler.step(stateAt(1));
+  EXPECT_THROW(waitFor([&]() {
+                 scheduler.step(stateAt(1));
+                 return false;
+               }),
+               std::invalid_argument);
+}
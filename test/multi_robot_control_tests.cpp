@@ -0,0 +1,139 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/lowpass_filter.h>
+#include <franka/multi_robot_control.h>
+#include <franka/robot.h>
+
+#include "helpers.h"
+#include "mock_server.h"
+
+using research_interface::robot::Move;
+using namespace research_interface;
+
+using namespace franka;
+
+TEST(MultiRobotControl, RejectsInvalidArguments) {
+  EXPECT_THROW(MultiRobotControl(std::vector<Robot*>()), std::invalid_argument);
+  EXPECT_THROW(MultiRobotControl(std::vector<Robot*>{nullptr}), std::invalid_argument);
+
+  RobotMockServer server;
+  Robot robot("127.0.0.1", RealtimeConfig::kIgnore);
+  EXPECT_THROW(MultiRobotControl(std::vector<Robot*>{&robot, &robot}), std::invalid_argument);
+  EXPECT_THROW(MultiRobotControl(std::vector<Robot*>{&robot}, std::chrono::microseconds(1000)),
+               std::invalid_argument);
+  EXPECT_THROW(MultiRobotControl(std::vector<Robot*>{&robot}, std::chrono::microseconds(-1)),
+               std::invalid_argument);
+
+  MultiRobotControl control(std::vector<Robot*>{&robot});
+  EXPECT_EQ(1u, control.size());
+  EXPECT_THROW(control.control(MultiRobotControl::ControlCallback()), std::invalid_argument);
+}
+
+TEST(MultiRobotControl, CanControlRobot) {
+  RobotMockServer server;
+  Robot robot("127.0.0.1", RealtimeConfig::kIgnore);
+  MultiRobotControl control(std::vector<Robot*>{&robot});
+
+  uint32_t move_id;
+
+  std::atomic_flag send = ATOMIC_FLAG_INIT;
+  send.test_and_set();
+
+  uint32_t stopped_message_id = 0;
+  server
+      .onSendUDP<robot::RobotState>([](robot::RobotState& robot_state) {
+        robot_state.motion_generator_mode = robot::MotionGeneratorMode::kIdle;
+        robot_state.controller_mode = robot::ControllerMode::kOther;
+        robot_state.robot_mode = robot::RobotMode::kIdle;
+      })
+      .spinOnce()
+      .waitForCommand<Move>(
+          [&](const Move::Request&) {
+            server
+                .doForever([&]() {
+                  bool continue_sending = send.test_and_set();
+                  if (continue_sending) {
+                    server.onSendUDP<robot::RobotState>([](robot::RobotState& robot_state) {
+                      robot_state.motion_generator_mode =
+                          robot::MotionGeneratorMode::kJointVelocity;
+                      robot_state.controller_mode = robot::ControllerMode::kExternalController;
+                      robot_state.robot_mode = robot::RobotMode::kMove;
+                    });
+                    std::this_thread::yield();
+                  }
+                  return continue_sending;
+                })
+                .onSendUDP<robot::RobotState>([&](robot::RobotState& robot_state) {
+                  robot_state.motion_generator_mode = robot::MotionGeneratorMode::kIdle;
+                  robot_state.controller_mode = robot::ControllerMode::kOther;
+                  robot_state.robot_mode = robot::RobotMode::kIdle;
+                  stopped_message_id = robot_state.message_id;
+                })
+                .sendResponse<Move>(move_id,
+                                    []() { return Move::Response(Move::Status::kSuccess); });
+            return Move::Response(Move::Status::kMotionStarted);
+          },
+          &move_id)
+      .spinOnce();
+
+  Torques torques{{1, 2, 3, 4, 5, 6, 7}};
+  int count = 0;
+  control.control(
+      [&](const std::vector<MultiRobotState>& states, std::vector<Torques>* commands) {
+        ASSERT_EQ(1u, states.size());
+        ASSERT_EQ(1u, commands->size());
+        EXPECT_TRUE(states[0].updated);
+        EXPECT_EQ(0.0, states[0].arrival_offset);
+        if (count == 0) {
+          EXPECT_EQ(0u, states[0].time_step.toMSec());
+        } else {
+          EXPECT_GE(states[0].time_step.toMSec(), 1u);
+        }
+        if (++count < 5) {
+          (*commands)[0] = torques;
+          return;
+        }
+        send.clear();
+        (*commands)[0] = MotionFinished(torques);
+      },
+      false, franka::kMaxCutoffFrequency);
+
+  ASSERT_NE(0u, stopped_message_id);
+  ASSERT_EQ(5, count);
+
+  // Receive the robot commands sent in the control loop.
+  for (int i = 0; i < count - 1; i++) {
+    server
+        .onReceiveRobotCommand([=](const robot::RobotCommand& robot_command) {
+          EXPECT_EQ(torques.tau_J, robot_command.control.tau_J_d);
+          EXPECT_FALSE(robot_command.motion.motion_generation_finished);
+          EXPECT_LT(robot_command.message_id, stopped_message_id);
+        })
+        .spinOnce();
+  }
+
+  // Receive the robot commands sent after the motion has been finished.
+  server
+      .onReceiveRobotCommand([=](const robot::RobotCommand& robot_command) {
+        EXPECT_TRUE(robot_command.motion.motion_generation_finished);
+        EXPECT_LT(robot_command.message_id, stopped_message_id);
+      })
+      .spinOnce();
+
+  // Ignore remaining RobotCommands that might have been sent to the server.
+  server.ignoreUdpBuffer();
+
+  std::vector<MultiRobotStatistics> statistics = control.statistics();
+  ASSERT_EQ(1u, statistics.size());
+  EXPECT_EQ(0u, statistics[0].missed_states);
+  EXPECT_EQ(static_cast<uint64_t>(count - 1), statistics[0].arrival_offset.count);
+}
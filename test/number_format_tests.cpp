@@ -0,0 +1,70 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "number_format.h"
+
+namespace {
+
+std::string format(double value) {
+  char buffer[franka::kMaxDoubleLength];
+  return std::string(buffer, franka::formatDouble(value, buffer));
+}
+
+std::string format(uint64_t value) {
+  char buffer[franka::kMaxUInt64Length];
+  return std::string(buffer, franka::formatUInt64(value, buffer));
+}
+
+}  // anonymous namespace
+
+TEST(NumberFormat, WritesShortestDoubles) {
+  EXPECT_EQ("0", format(0.0));
+  EXPECT_EQ("-0", format(-0.0));
+  EXPECT_EQ("1", format(1.0));
+  EXPECT_EQ("-1.5", format(-1.5));
+  EXPECT_EQ("0.1", format(0.1));
+  EXPECT_EQ("0.30000000000000004", format(0.1 + 0.2));
+  EXPECT_EQ("3.141592653589793", format(3.141592653589793));
+  EXPECT_EQ("123400000", format(1.234e8));
+  EXPECT_EQ("0.000001", format(1e-6));
+  EXPECT_EQ("1e-7", format(1e-7));
+  EXPECT_EQ("1.5e22", format(1.5e22));
+  EXPECT_EQ("5e-324", format(std::numeric_limits<double>::denorm_min()));
+  EXPECT_EQ("1.7976931348623157e308", format(std::numeric_limits<double>::max()));
+}
+
+TEST(NumberFormat, WritesNonFiniteDoubles) {
+  EXPECT_EQ("nan", format(std::numeric_limits<double>::quiet_NaN()));
+  EXPECT_EQ("inf", format(std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("-inf", format(-std::numeric_limits<double>::infinity()));
+}
+
+TEST(NumberFormat, DoublesRoundTrip) {
+  std::mt19937_64 generator(42);
+  for (size_t i = 0; i < 100000; i++) {
+    uint64_t bits = generator();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    if (std::isnan(value)) {
+      continue;
+    }
+    std::string text = format(value);
+    ASSERT_LE(text.size(), franka::kMaxDoubleLength);
+    ASSERT_EQ(value, std::strtod(text.c_str(), nullptr)) << text;
+  }
+}
+
+TEST(NumberFormat, WritesUnsignedIntegers) {
+  EXPECT_EQ("0", format(uint64_t{0}));
+  EXPECT_EQ("42", format(uint64_t{42}));
+  EXPECT_EQ("18446744073709551615", format(std::numeric_limits<uint64_t>::max()));
+}
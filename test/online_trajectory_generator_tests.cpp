@@ -0,0 +1,174 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/online_trajectory_generator.h>
+
+using franka::kDeltaT;
+using franka::kMaxJointAcceleration;
+using franka::kMaxJointJerk;
+using franka::kMaxJointVelocity;
+using franka::OnlineTrajectoryGenerator;
+
+namespace {
+
+const std::array<double, 7> kStart{{0.0, -0.785, 0.0, -2.356, 0.0, 1.571, 0.785}};
+
+// Desired values as the robot derives them from the commanded positions.
+struct DesiredState {
+  std::array<double, 7> q_d;
+  std::array<double, 7> dq_d{};
+  std::array<double, 7> ddq_d{};
+
+  // Applies a command and returns the resulting jerk.
+  std::array<double, 7> command(const std::array<double, 7>& q_c) {
+    std::array<double, 7> jerk;
+    for (size_t i = 0; i < 7; i++) {
+      double dq_c = (q_c[i] - q_d[i]) / kDeltaT;
+      double ddq_c = (dq_c - dq_d[i]) / kDeltaT;
+      jerk[i] = (ddq_c - ddq_d[i]) / kDeltaT;
+      q_d[i] = q_c[i];
+      dq_d[i] = dq_c;
+      ddq_d[i] = ddq_c;
+    }
+    return jerk;
+  }
+};
+
+// Moves towards the target for the given number of cycles and checks the limits along the way.
+void move(OnlineTrajectoryGenerator& generator,
+          const std::array<double, 7>& target,
+          size_t cycles,
+          DesiredState* state) {
+  for (size_t k = 0; k < cycles; k++) {
+    std::array<double, 7> jerk =
+        state->command(generator.nextPosition(target, state->q_d, state->dq_d, state->ddq_d));
+    for (size_t i = 0; i < 7; i++) {
+      ASSERT_LE(std::abs(state->dq_d[i]), kMaxJointVelocity[i] + 1e-9) << "cycle " << k;
+      ASSERT_LE(std::abs(state->ddq_d[i]), kMaxJointAcceleration[i] + 1e-6) << "cycle " << k;
+      ASSERT_LE(std::abs(jerk[i]), kMaxJointJerk[i] + 0.1) << "cycle " << k;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(OnlineTrajectoryGenerator, ReachesStepTargetWithoutOvershoot) {
+  std::array<double, 7> target{{1.0, -1.2, 0.02, -1.0, -0.5, 2.5, 0.785}};
+  OnlineTrajectoryGenerator generator;
+  DesiredState state{kStart};
+
+  // Every joint approaches its target monotonically.
+  for (size_t k = 0; k < 3000; k++) {
+    std::array<double, 7> q_previous = state.q_d;
+    move(generator, target, 1, &state);
+    for (size_t i = 0; i < 7; i++) {
+      double remaining = target[i] - state.q_d[i];
+      double step = state.q_d[i] - q_previous[i];
+      ASSERT_GE(remaining * (target[i] - kStart[i]), -1e-9) << "joint " << i << ", cycle " << k;
+      ASSERT_GE(step * (target[i] - kStart[i]), -1e-12) << "joint " << i << ", cycle " << k;
+    }
+  }
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(target[i], state.q_d[i], 1e-9);
+    EXPECT_NEAR(0.0, state.dq_d[i], 1e-6);
+  }
+}
+
+TEST(OnlineTrajectoryGenerator, ReachesTargetNearTimeOptimally) {
+  // A joint that starts at rest needs at least the time of the bang-bang jerk profile through
+  // the acceleration and velocity limits.
+  constexpr double kDistance = 2.0;
+  std::array<double, 7> target = kStart;
+  target[3] += kDistance;
+  OnlineTrajectoryGenerator generator;
+  DesiredState state{kStart};
+
+  double v = kMaxJointVelocity[3];
+  double a = kMaxJointAcceleration[3];
+  double j = kMaxJointJerk[3];
+  double minimum_time = kDistance / v + v / a + a / j;
+
+  size_t cycles = 0;
+  while (std::abs(target[3] - state.q_d[3]) > 1e-6 && cycles < 10000) {
+    move(generator, target, 1, &state);
+    cycles++;
+  }
+  EXPECT_GE(cycles * kDeltaT, minimum_time - kDeltaT);
+  EXPECT_LE(cycles * kDeltaT, minimum_time + 2 * kDeltaT);
+}
+
+TEST(OnlineTrajectoryGenerator, FollowsChangingTargetsWithinLimits) {
+  OnlineTrajectoryGenerator generator;
+  DesiredState state{kStart};
+  std::array<double, 7> target = kStart;
+  for (double& q : target) {
+    q += 0.8;
+  }
+  move(generator, target, 300, &state);
+
+  // Reverse while moving fast, then jump to the start.
+  for (double& q : target) {
+    q -= 1.6;
+  }
+  move(generator, target, 250, &state);
+  move(generator, kStart, 3000, &state);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(kStart[i], state.q_d[i], 1e-9);
+  }
+}
+
+TEST(OnlineTrajectoryGenerator, RestartsFromDesiredValues) {
+  std::array<double, 7> target = kStart;
+  target[0] += 0.5;
+  OnlineTrajectoryGenerator generator;
+  DesiredState state{kStart};
+  move(generator, target, 100, &state);
+
+  // Lost commands: the robot kept an earlier position.
+  DesiredState restarted{kStart};
+  restarted.q_d[0] += 0.01;
+  std::array<double, 7> q_c =
+      generator.nextPosition(target, restarted.q_d, restarted.dq_d, restarted.ddq_d);
+  std::array<double, 7> jerk = restarted.command(q_c);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_LE(std::abs(jerk[i]), kMaxJointJerk[i] + 0.1);
+  }
+  EXPECT_GT(q_c[0], kStart[0] + 0.01);
+}
+
+TEST(OnlineTrajectoryGenerator, ReachesTargetVelocity) {
+  OnlineTrajectoryGenerator generator;
+  std::array<double, 7> target{{1.0, -0.5, 5.0, 0.0, -5.0, 0.2, -1.0}};
+  std::array<double, 7> dq_d{}, ddq_d{};
+  for (size_t k = 0; k < 2000; k++) {
+    std::array<double, 7> dq_c = generator.nextVelocity(target, dq_d, ddq_d);
+    for (size_t i = 0; i < 7; i++) {
+      double ddq_c = (dq_c[i] - dq_d[i]) / kDeltaT;
+      ASSERT_LE(std::abs(dq_c[i]), kMaxJointVelocity[i] + 1e-9) << "cycle " << k;
+      ASSERT_LE(std::abs(ddq_c), kMaxJointAcceleration[i] + 1e-6) << "cycle " << k;
+      ASSERT_LE(std::abs(ddq_c - ddq_d[i]) / kDeltaT, kMaxJointJerk[i] + 0.1) << "cycle " << k;
+      ddq_d[i] = ddq_c;
+    }
+    dq_d = dq_c;
+  }
+  for (size_t i = 0; i < 7; i++) {
+    double expected = std::max(-kMaxJointVelocity[i], std::min(target[i], kMaxJointVelocity[i]));
+    EXPECT_NEAR(expected, dq_d[i], 1e-6);
+  }
+}
+
+TEST(OnlineTrajectoryGenerator, ThrowsForInvalidLimits) {
+  std::array<double, 7> limits = kMaxJointJerk;
+  limits[4] = 0.0;
+  EXPECT_THROW(OnlineTrajectoryGenerator(kMaxJointVelocity, kMaxJointAcceleration, limits),
+               std::invalid_argument);
+  EXPECT_THROW(
+      OnlineTrajectoryGenerator(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, 0.0),
+      std::invalid_argument);
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+
+#include <gtest/gtest.h>
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+#include <franka/operational_space.h>
+
+#include "allocation_tracker.h"
+
+namespace {
+
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Matrix7d = Eigen::Matrix<double, 7, 7>;
+using Matrix6x7d = Eigen::Matrix<double, 6, 7>;
+using Matrix7x6d = Eigen::Matrix<double, 7, 6>;
+
+std::array<double, 49> randomMass() {
+  Matrix7d random = Matrix7d::Random();
+  std::array<double, 49> mass;
+  Eigen::Map<Matrix7d>(mass.data()) = random * random.transpose() + Matrix7d::Identity();
+  return mass;
+}
+
+std::array<double, 42> randomJacobian() {
+  std::array<double, 42> jacobian;
+  Eigen::Map<Matrix6x7d>(jacobian.data()) = Matrix6x7d::Random();
+  return jacobian;
+}
+
+}  // anonymous namespace
+
+TEST(OperationalSpace, ComputesOperationalSpaceQuantities) {
+  std::array<double, 49> mass = randomMass();
+  std::array<double, 42> jacobian = randomJacobian();
+
+  franka::OperationalSpace operational_space;
+  ASSERT_TRUE(operational_space.update(mass, jacobian));
+
+  Matrix7d M(mass.data());
+  Matrix6x7d J(jacobian.data());
+  Matrix7d expected_mass_inverse = M.inverse();
+  Matrix6d expected_lambda = (J * expected_mass_inverse * J.transpose()).inverse();
+  Matrix7x6d expected_pseudoinverse = expected_mass_inverse * J.transpose() * expected_lambda;
+  Matrix7d expected_projector =
+      Matrix7d::Identity() - J.transpose() * expected_pseudoinverse.transpose();
+
+  EXPECT_TRUE(Matrix7d(operational_space.massInverse().data()).isApprox(expected_mass_inverse));
+  EXPECT_TRUE(Matrix6d(operational_space.lambda().data()).isApprox(expected_lambda));
+  EXPECT_TRUE(Matrix7x6d(operational_space.jacobianPseudoinverse().data())
+                  .isApprox(expected_pseudoinverse));
+  EXPECT_TRUE(
+      Matrix7d(operational_space.nullspaceProjector().data()).isApprox(expected_projector));
+
+  // The pseudoinverse is a right inverse of the Jacobian.
+  EXPECT_TRUE((J * Matrix7x6d(operational_space.jacobianPseudoinverse().data()))
+                  .isApprox(Matrix6d::Identity()));
+}
+
+TEST(OperationalSpace, ProjectedTorquesDoNotCauseTaskAccelerations) {
+  std::array<double, 49> mass = randomMass();
+  std::array<double, 42> jacobian = randomJacobian();
+
+  franka::OperationalSpace operational_space;
+  ASSERT_TRUE(operational_space.update(mass, jacobian));
+
+  std::array<double, 7> tau{{1, -2, 3, -4, 5, -6, 7}};
+  std::array<double, 7> projected = operational_space.projectToNullspace(tau);
+
+  Eigen::Matrix<double, 6, 1> task_acceleration =
+      Matrix6x7d(jacobian.data()) * Matrix7d(mass.data()).inverse() *
+      Eigen::Matrix<double, 7, 1>(projected.data());
+  EXPECT_NEAR(0, task_acceleration.norm(), 1e-9);
+
+  std::array<double, 6> wrench{{1, 2, 3, 4, 5, 6}};
+  std::array<double, 7> expected_tau;
+  Eigen::Map<Eigen::Matrix<double, 7, 1>>(expected_tau.data()) =
+      Matrix6x7d(jacobian.data()).transpose() * Eigen::Matrix<double, 6, 1>(wrench.data());
+  std::array<double, 7> actual_tau = operational_space.jacobianTransposeTimes(wrench);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(expected_tau[i], actual_tau[i], 1e-12);
+  }
+}
+
+TEST(OperationalSpace, RejectsSingularJacobian) {
+  std::array<double, 42> jacobian = randomJacobian();
+  franka::OperationalSpace operational_space;
+  ASSERT_TRUE(operational_space.update(randomMass(), jacobian));
+  std::array<double, 36> lambda = operational_space.lambda();
+
+  std::array<double, 42> singular_jacobian = jacobian;
+  Eigen::Map<Matrix6x7d>(singular_jacobian.data()).row(5).setZero();
+  EXPECT_FALSE(operational_space.update(randomMass(), singular_jacobian));
+  EXPECT_EQ(lambda, operational_space.lambda());
+}
+
+TEST(OperationalSpace, UpdateDoesNotAllocate) {
+  std::array<double, 49> mass = randomMass();
+  std::array<double, 42> jacobian = randomJacobian();
+  franka::OperationalSpace operational_space;
+
+  franka::AllocationTrackingScope allocation_tracking;
+  EXPECT_TRUE(operational_space.update(mass, jacobian));
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/lowpass_filter.h>
+#include <franka/passivity_controller.h>
+
+#include "control_loop.h"
+#include "helpers.h"
+#include "mock_robot_control.h"
+
+using namespace ::testing;
+
+using franka::Duration;
+using franka::JointVelocities;
+using franka::PassivityController;
+using franka::PassivityControllerParameters;
+using franka::RobotState;
+using franka::Torques;
+
+TEST(PassivityController, KeepsPassiveCommands) {
+  PassivityController controller;
+  std::array<double, 7> dq{{1, -1, 0.5, -0.5, 0.1, -0.1, 0}};
+  std::array<double, 7> tau_J_d{};
+  for (int i = 0; i < 100; i++) {
+    // A damper only absorbs energy.
+    std::array<double, 7> tau{};
+    for (size_t j = 0; j < 7; j++) {
+      tau[j] = -2 * dq[j];
+    }
+    std::array<double, 7> output = controller.control(tau, tau_J_d, dq, Duration(1));
+    EXPECT_EQ(tau, output);
+    tau_J_d = output;
+  }
+
+  const franka::PassivityStatistics& statistics = controller.statistics();
+  EXPECT_EQ(100u, statistics.cycles);
+  EXPECT_THAT(statistics.active_cycles, Each(0u));
+  EXPECT_THAT(statistics.dissipated_energy, Each(0.0));
+  EXPECT_NEAR(99 * 2e-3, statistics.observed_energy[0], 1e-12);
+}
+
+TEST(PassivityController, DampsActiveCommands) {
+  PassivityControllerParameters parameters;
+  parameters.max_damping.fill(100);
+  PassivityController controller(parameters);
+
+  std::array<double, 7> dq{};
+  dq.fill(1);
+  std::array<double, 7> tau_J_d{};
+  for (int i = 0; i < 100; i++) {
+    // A negative damper generates energy.
+    std::array<double, 7> tau{};
+    tau.fill(5);
+    std::array<double, 7> output = controller.control(tau, tau_J_d, dq, Duration(1));
+    EXPECT_THAT(output, Each(Le(5.0)));
+    EXPECT_THAT(controller.statistics().observed_energy, Each(Ge(-1e-12)));
+    tau_J_d = output;
+  }
+
+  const franka::PassivityStatistics& statistics = controller.statistics();
+  EXPECT_THAT(statistics.active_cycles, Each(100u));
+  EXPECT_NEAR(0.5, statistics.dissipated_energy[0], 1e-9);
+  EXPECT_NEAR(0.0, tau_J_d[0], 1e-9);
+
+  controller.reset();
+  EXPECT_THAT(controller.statistics().observed_energy, Each(0.0));
+  EXPECT_EQ(100u, controller.statistics().active_cycles[0]);
+  controller.resetStatistics();
+  EXPECT_EQ(0u, controller.statistics().cycles);
+  EXPECT_EQ(0.0, controller.statistics().dissipated_energy[0]);
+}
+
+TEST(PassivityController, LimitsDamping) {
+  PassivityControllerParameters parameters;
+  parameters.max_damping = {{1, 2, 3, 4, 5, 6, 7}};
+  parameters.min_velocity = 0.5;
+  PassivityController controller(parameters);
+
+  std::array<double, 7> tau{};
+  tau.fill(100);
+  std::array<double, 7> dq{{1, 1, 1, 1, 1, 1, 0.25}};
+  std::array<double, 7> output = controller.control(tau, {}, dq, Duration(1));
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_DOUBLE_EQ(tau[i] - parameters.max_damping[i] * dq[i], output[i]);
+  }
+  // No damping is injected below the minimum velocity.
+  EXPECT_EQ(tau[6], output[6]);
+  EXPECT_EQ(0u, controller.statistics().active_cycles[6]);
+}
+
+TEST(PassivityController, ThrowsOnInvalidParameters) {
+  PassivityControllerParameters parameters;
+  parameters.max_damping[3] = -1;
+  EXPECT_THROW(PassivityController{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.min_velocity = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(PassivityController{parameters}, std::invalid_argument);
+}
+
+TEST(PassivityStatistics, CanBeStreamed) {
+  franka::PassivityStatistics statistics;
+
+  std::stringstream ss;
+  ss << statistics;
+  std::string output(ss.str());
+
+  EXPECT_PRED2(stringContains, output, "cycles");
+  EXPECT_PRED2(stringContains, output, "observed_energy");
+  EXPECT_PRED2(stringContains, output, "dissipated_energy");
+  EXPECT_PRED2(stringContains, output, "active_cycles");
+}
+
+TEST(PassivityController, ControlLoopMakesTorquesPassive) {
+  PassivityController controller;
+  controller.control({{1, 1, 1, 1, 1, 1, 1}}, {{-1, -1, -1, -1, -1, -1, -1}},
+                     {{1, 1, 1, 1, 1, 1, 1}}, Duration(1));
+  ASSERT_THAT(controller.statistics().observed_energy, Each(Gt(0.0)));
+
+  NiceMock<MockRobotControl> robot;
+  robot.passivity_controller = &controller;
+
+  class Loop : public franka::ControlLoop<JointVelocities> {
+   public:
+    using franka::ControlLoop<JointVelocities>::ControlLoop;
+    using franka::ControlLoop<JointVelocities>::spinControl;
+  };
+  Loop loop(robot, [](const RobotState&, Duration) { return Torques({1, 1, 1, 1, 1, 1, 1}); },
+            [](const RobotState&, Duration) { return JointVelocities({0, 0, 0, 0, 0, 0, 0}); },
+            false, franka::kMaxCutoffFrequency);
+  // Starting a control loop clears the observed energy.
+  EXPECT_THAT(controller.statistics().observed_energy, Each(0.0));
+
+  RobotState robot_state;
+  robot_state.dq.fill(0.1);
+  research_interface::robot::ControllerCommand command{};
+  for (int i = 0; i < 10; i++) {
+    loop.spinControl(robot_state, Duration(1), &command);
+    robot_state.tau_J_d = command.tau_J_d;
+    EXPECT_THAT(command.tau_J_d, Each(Lt(1.0)));
+  }
+  EXPECT_EQ(11u, controller.statistics().cycles);
+  EXPECT_THAT(controller.statistics().observed_energy, Each(Ge(-1e-12)));
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/payload_estimator.h>
+
+using franka::PayloadEstimator;
+using franka::PayloadEstimatorParameters;
+
+namespace {
+
+constexpr std::array<double, 3> kGravity{{0, 0, -9.81}};
+
+struct Sample {
+  std::array<double, 16> O_T_F;  // NOLINT(readability-identifier-naming)
+  std::array<double, 42> O_J_F;  // NOLINT(readability-identifier-naming)
+};
+
+Sample randomSample(std::mt19937& generator) {
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::uniform_real_distribution<double> entry(-1, 1);
+
+  // Rotation about z, then about x.
+  double a = angle(generator);
+  double b = angle(generator);
+  std::array<double, 9> rotation{{std::cos(a), std::sin(a), 0, -std::sin(a) * std::cos(b),
+                                  std::cos(a) * std::cos(b), std::sin(b), std::sin(a) * std::sin(b),
+                                  -std::cos(a) * std::sin(b), std::cos(b)}};
+  Sample sample{};
+  for (size_t column = 0; column < 3; column++) {
+    for (size_t row = 0; row < 3; row++) {
+      sample.O_T_F[column * 4 + row] = rotation[column * 3 + row];
+    }
+  }
+  sample.O_T_F[15] = 1;
+  for (double& value : sample.O_J_F) {
+    value = entry(generator);
+  }
+  return sample;
+}
+
+// Torques which compensate the gravity of a point mass, computed as -J^T [F; x × F].
+std::array<double, 7> loadTorques(
+    const Sample& sample,
+    double mass,
+    const std::array<double, 3>& F_x_Cload) {  // NOLINT(readability-identifier-naming)
+  std::array<double, 3> force{{mass * kGravity[0], mass * kGravity[1], mass * kGravity[2]}};
+  std::array<double, 3> lever{};
+  for (size_t row = 0; row < 3; row++) {
+    for (size_t column = 0; column < 3; column++) {
+      lever[row] += sample.O_T_F[column * 4 + row] * F_x_Cload[column];
+    }
+  }
+  std::array<double, 6> wrench{{force[0], force[1], force[2],
+                                lever[1] * force[2] - lever[2] * force[1],
+                                lever[2] * force[0] - lever[0] * force[2],
+                                lever[0] * force[1] - lever[1] * force[0]}};
+  std::array<double, 7> tau{};
+  for (size_t joint = 0; joint < 7; joint++) {
+    for (size_t i = 0; i < 6; i++) {
+      tau[joint] -= sample.O_J_F[joint * 6 + i] * wrench[i];
+    }
+  }
+  return tau;
+}
+
+}  // anonymous namespace
+
+TEST(PayloadEstimator, StartsWithoutLoad) {
+  PayloadEstimator estimator;
+
+  EXPECT_EQ(0.0, estimator.mass());
+  EXPECT_EQ((std::array<double, 3>{}), estimator.F_x_Cload());
+  EXPECT_EQ(PayloadEstimatorParameters().initial_variance, estimator.massVariance());
+  EXPECT_EQ(0u, estimator.sampleCount());
+}
+
+TEST(PayloadEstimator, RejectsInvalidParameters) {
+  PayloadEstimatorParameters parameters;
+  parameters.forgetting_factor = 1.5;
+  EXPECT_THROW(PayloadEstimator{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.initial_variance = 0;
+  EXPECT_THROW(PayloadEstimator{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.max_joint_velocity = NAN;
+  EXPECT_THROW(PayloadEstimator{parameters}, std::invalid_argument);
+}
+
+TEST(PayloadEstimator, IdentifiesMassAndCenterOfMass) {
+  constexpr double kMass = 1.2;
+  constexpr std::array<double, 3> kCenterOfMass{{0.01, -0.02, 0.08}};
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(0.0, 0.05);
+  PayloadEstimator estimator;
+  for (size_t i = 0; i < 2000; i++) {
+    Sample sample = randomSample(generator);
+    std::array<double, 7> tau = loadTorques(sample, kMass, kCenterOfMass);
+    for (double& value : tau) {
+      value += noise(generator);
+    }
+    estimator.update(tau, sample.O_T_F, sample.O_J_F, kGravity);
+  }
+
+  EXPECT_NEAR(kMass, estimator.mass(), 1e-2);
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_NEAR(kCenterOfMass[i], estimator.F_x_Cload()[i], 2e-3);
+  }
+  EXPECT_LT(estimator.massVariance(), 1e-3);
+  EXPECT_EQ(2000u, estimator.sampleCount());
+}
+
+TEST(PayloadEstimator, FollowsChangedLoad) {
+  std::mt19937 generator(7);
+  PayloadEstimatorParameters parameters;
+  parameters.forgetting_factor = 0.99;
+  PayloadEstimator estimator(parameters);
+  for (size_t i = 0; i < 1000; i++) {
+    Sample sample = randomSample(generator);
+    estimator.update(loadTorques(sample, 2.0, {{0, 0, 0.1}}), sample.O_T_F, sample.O_J_F,
+                     kGravity);
+  }
+  EXPECT_NEAR(2.0, estimator.mass(), 1e-6);
+
+  for (size_t i = 0; i < 1000; i++) {
+    Sample sample = randomSample(generator);
+    estimator.update(loadTorques(sample, 0.5, {{0.05, 0, 0}}), sample.O_T_F, sample.O_J_F,
+                     kGravity);
+  }
+  EXPECT_NEAR(0.5, estimator.mass(), 1e-3);
+  EXPECT_NEAR(0.05, estimator.F_x_Cload()[0], 1e-3);
+}
+
+TEST(PayloadEstimator, BoundsVarianceWithoutExcitation) {
+  std::mt19937 generator(3);
+  Sample sample = randomSample(generator);
+  PayloadEstimatorParameters parameters;
+  parameters.forgetting_factor = 0.9;
+  PayloadEstimator estimator(parameters);
+  for (size_t i = 0; i < 10000; i++) {
+    estimator.update(loadTorques(sample, 1.0, {{0, 0, 0.05}}), sample.O_T_F, sample.O_J_F,
+                     kGravity);
+  }
+
+  EXPECT_TRUE(std::isfinite(estimator.mass()));
+  EXPECT_LE(estimator.massVariance(), parameters.initial_variance / parameters.forgetting_factor);
+
+  estimator.reset();
+  EXPECT_EQ(0.0, estimator.mass());
+  EXPECT_EQ(0u, estimator.sampleCount());
+}
+
+TEST(PayloadEstimator, ReportsNoCenterOfMassForSmallMass) {
+  std::mt19937 generator(5);
+  PayloadEstimator estimator;
+  for (size_t i = 0; i < 100; i++) {
+    Sample sample = randomSample(generator);
+    estimator.update(loadTorques(sample, 0.01, {{0, 0, 0.1}}), sample.O_T_F, sample.O_J_F,
+                     kGravity);
+  }
+
+  EXPECT_NEAR(0.01, estimator.mass(), 1e-3);
+  EXPECT_EQ((std::array<double, 3>{}), estimator.F_x_Cload());
+}
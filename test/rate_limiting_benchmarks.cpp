@@ -0,0 +1,144 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+#include <franka/online_trajectory_generator.h>
+#include <franka/rate_limiting.h>
+
+using namespace franka;  // NOLINT(google-build-using-namespace)
+
+namespace {
+
+constexpr std::array<double, 7> kLastValues{{0.1, -0.2, 0.3, -0.4, 0.5, -0.6, 0.7}};
+constexpr std::array<double, 7> kLastDerivatives{{0.01, -0.02, 0.03, -0.04, 0.05, -0.06, 0.07}};
+constexpr std::array<double, 7> kLastSecondDerivatives{{1, -2, 3, -4, 5, -6, 7}};
+
+// Commands that violate the limits, so that every limiting branch is taken.
+std::array<double, 7> violatingCommand(const std::array<double, 7>& last, double offset) {
+  std::array<double, 7> command;
+  for (size_t i = 0; i < command.size(); i++) {
+    command[i] = last[i] + (i % 2 == 0 ? offset : -offset);
+  }
+  return command;
+}
+
+}  // anonymous namespace
+
+static void BM_LimitRateTorques(benchmark::State& state) {
+  std::array<double, 7> commanded = violatingCommand(kLastValues, 1.0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxTorqueRate, commanded, kLastValues));
+  }
+}
+BENCHMARK(BM_LimitRateTorques);
+
+static void BM_LimitRateJointVelocity(benchmark::State& state) {
+  double commanded = kLastDerivatives[0] + 1.0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxJointVelocity[0], kMaxJointAcceleration[0],
+                                       kMaxJointJerk[0], commanded, kLastDerivatives[0],
+                                       kLastSecondDerivatives[0]));
+  }
+}
+BENCHMARK(BM_LimitRateJointVelocity);
+
+static void BM_LimitRateJointPosition(benchmark::State& state) {
+  double commanded = kLastValues[0] + 1e-2;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxJointVelocity[0], kMaxJointAcceleration[0],
+                                       kMaxJointJerk[0], commanded, kLastValues[0],
+                                       kLastDerivatives[0], kLastSecondDerivatives[0]));
+  }
+}
+BENCHMARK(BM_LimitRateJointPosition);
+
+static void BM_LimitRateJointVelocities(benchmark::State& state) {
+  std::array<double, 7> commanded = violatingCommand(kLastDerivatives, 1.0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk,
+                                       commanded, kLastDerivatives, kLastSecondDerivatives));
+  }
+}
+BENCHMARK(BM_LimitRateJointVelocities);
+
+// Baseline for BM_LimitRateJointVelocities, limiting one joint at a time.
+static void BM_LimitRateJointVelocitiesScalar(benchmark::State& state) {
+  std::array<double, 7> commanded = violatingCommand(kLastDerivatives, 1.0);
+  std::array<double, 7> limited;
+  for (auto _ : state) {
+    for (size_t i = 0; i < limited.size(); i++) {
+      limited[i] = limitRate(kMaxJointVelocity[i], kMaxJointAcceleration[i], kMaxJointJerk[i],
+                             commanded[i], kLastDerivatives[i], kLastSecondDerivatives[i]);
+    }
+    benchmark::DoNotOptimize(limited);
+  }
+}
+BENCHMARK(BM_LimitRateJointVelocitiesScalar);
+
+static void BM_LimitRateJointPositions(benchmark::State& state) {
+  std::array<double, 7> commanded = violatingCommand(kLastValues, 1e-2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk,
+                                       commanded, kLastValues, kLastDerivatives,
+                                       kLastSecondDerivatives));
+  }
+}
+BENCHMARK(BM_LimitRateJointPositions);
+
+// Baseline for BM_LimitRateJointPositions, limiting one joint at a time.
+static void BM_LimitRateJointPositionsScalar(benchmark::State& state) {
+  std::array<double, 7> commanded = violatingCommand(kLastValues, 1e-2);
+  std::array<double, 7> limited;
+  for (auto _ : state) {
+    for (size_t i = 0; i < limited.size(); i++) {
+      limited[i] = limitRate(kMaxJointVelocity[i], kMaxJointAcceleration[i], kMaxJointJerk[i],
+                             commanded[i], kLastValues[i], kLastDerivatives[i],
+                             kLastSecondDerivatives[i]);
+    }
+    benchmark::DoNotOptimize(limited);
+  }
+}
+BENCHMARK(BM_LimitRateJointPositionsScalar);
+
+static void BM_LimitRateCartesianVelocity(benchmark::State& state) {
+  std::array<double, 6> last_velocity{{0.01, -0.02, 0.03, 0.01, -0.02, 0.03}};
+  std::array<double, 6> last_acceleration{{1, -1, 1, -1, 1, -1}};
+  std::array<double, 6> commanded{{0.5, -0.5, 0.5, 0.5, -0.5, 0.5}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxTranslationalVelocity, kMaxTranslationalAcceleration,
+                                       kMaxTranslationalJerk, kMaxRotationalVelocity,
+                                       kMaxRotationalAcceleration, kMaxRotationalJerk, commanded,
+                                       last_velocity, last_acceleration));
+  }
+}
+BENCHMARK(BM_LimitRateCartesianVelocity);
+
+static void BM_LimitRateCartesianPose(benchmark::State& state) {
+  std::array<double, 16> last_pose{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3, 0, 0.5, 1}};
+  std::array<double, 16> commanded = last_pose;
+  commanded[12] += 1e-2;
+  commanded[14] -= 1e-2;
+  std::array<double, 6> last_velocity{{0.01, -0.02, 0.03, 0.01, -0.02, 0.03}};
+  std::array<double, 6> last_acceleration{{1, -1, 1, -1, 1, -1}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limitRate(kMaxTranslationalVelocity, kMaxTranslationalAcceleration,
+                                       kMaxTranslationalJerk, kMaxRotationalVelocity,
+                                       kMaxRotationalAcceleration, kMaxRotationalJerk, commanded,
+                                       last_pose, last_velocity, last_acceleration));
+  }
+}
+BENCHMARK(BM_LimitRateCartesianPose);
+
+// Planning towards a distant target, for comparison with BM_LimitRateJointPositions. The desired
+// values differ from the last command in every iteration, so that every step replans.
+static void BM_OnlineTrajectoryGeneratorJointPositions(benchmark::State& state) {
+  OnlineTrajectoryGenerator generator;
+  std::array<double, 7> target = violatingCommand(kLastValues, 1.0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        generator.nextPosition(target, kLastValues, kLastDerivatives, kLastSecondDerivatives));
+  }
+}
+BENCHMARK(BM_OnlineTrajectoryGeneratorJointPositions);
@@ -334,6 +334,38 @@ TEST(RateLimiting, JointPosition) {
       last_cmd_velocity, last_cmd_acceleration, kDeltaT));
 }
 
+TEST(RateLimiting, JointArraysMatchScalarLimitRate) {
+  std::array<double, 7> last_cmd_position{{0.1, -0.2, 0.3, -0.4, 0.5, -0.6, 0.7}};
+  std::array<double, 7> last_cmd_velocity{{0.5, -0.5, 1.0, -1.0, 2.0, -2.0, 0.0}};
+  std::array<double, 7> last_cmd_acceleration{{5.0, -5.0, 0.0, 10.0, -10.0, 1.0, -1.0}};
+
+  // Cover commands within the limits as well as violations of each limit in both directions.
+  for (double offset : {0.0, 1e-7, -1e-7, 1e-5, -1e-5, 1e-3, -1e-3, 1e-1, -1e-1}) {
+    std::array<double, 7> commanded_position;
+    std::array<double, 7> commanded_velocity;
+    for (size_t i = 0; i < 7; i++) {
+      commanded_position[i] = last_cmd_position[i] + last_cmd_velocity[i] * kDeltaT + offset;
+      commanded_velocity[i] = last_cmd_velocity[i] + offset * 1e3;
+    }
+
+    std::array<double, 7> limited_position =
+        limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, commanded_position,
+                  last_cmd_position, last_cmd_velocity, last_cmd_acceleration);
+    std::array<double, 7> limited_velocity =
+        limitRate(kMaxJointVelocity, kMaxJointAcceleration, kMaxJointJerk, commanded_velocity,
+                  last_cmd_velocity, last_cmd_acceleration);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_EQ(limitRate(kMaxJointVelocity[i], kMaxJointAcceleration[i], kMaxJointJerk[i],
+                          commanded_position[i], last_cmd_position[i], last_cmd_velocity[i],
+                          last_cmd_acceleration[i]),
+                limited_position[i]);
+      EXPECT_EQ(limitRate(kMaxJointVelocity[i], kMaxJointAcceleration[i], kMaxJointJerk[i],
+                          commanded_velocity[i], last_cmd_velocity[i], last_cmd_acceleration[i]),
+                limited_velocity[i]);
+    }
+  }
+}
+
 TEST(RateLimiting, CartesianVelocity) {
   std::array<double, 6> last_cmd_velocity{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
   std::array<double, 6> last_cmd_acceleration{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};
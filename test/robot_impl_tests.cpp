@@ -5,7 +5,9 @@
 #include <atomic>
 #include <cstring>
 #include <limits>
+#include <thread>
 
+#include <allocation_tracker.h>
 #include <logger.h>
 #include <robot_impl.h>
 
@@ -84,6 +86,43 @@ TEST(RobotImpl, StopsIfControlConnectionClosed) {
   EXPECT_THROW(robot->update(nullptr, nullptr), NetworkException);
 }
 
+TEST(RobotImpl, CanReceiveRobotStateView) {
+  RobotMockServer server;
+  Robot::Impl robot(std::make_unique<franka::Network>("127.0.0.1", kCommandPort), 0);
+
+  RobotState robot_state;
+  server.sendRandomState<RobotState>([](auto s) { randomRobotState(s); }, &robot_state)
+      .spinOnce();
+
+  franka::RobotStateView view = robot.updateView(nullptr, nullptr);
+  testRobotStatesAreEqual(robot_state, view.toRobotState());
+  EXPECT_EQ(robot_state.q, view.q());
+}
+
+TEST(RobotImpl, OnlyRecomputesCombinedLoadOnChange) {
+  RobotMockServer server;
+  Robot::Impl robot(std::make_unique<franka::Network>("127.0.0.1", kCommandPort), 0);
+
+  for (uint64_t i = 1; i <= 3; i++) {
+    server.onSendUDP<RobotState>([=](RobotState& robot_state) {
+      robot_state.message_id = i;
+      robot_state.m_load = 0.5;
+    })
+        .spinOnce();
+    robot.update(nullptr, nullptr);
+  }
+  EXPECT_EQ(1u, robot.loadRecomputeCount());
+
+  server.onSendUDP<RobotState>([](RobotState& robot_state) {
+    robot_state.message_id = 4;
+    robot_state.m_load = 1.0;
+  })
+      .spinOnce();
+  franka::RobotState received_robot_state = robot.update(nullptr, nullptr);
+  EXPECT_EQ(2u, robot.loadRecomputeCount());
+  EXPECT_DOUBLE_EQ(1.0, received_robot_state.m_total);
+}
+
 TEST(RobotImpl, CanStartMotion) {
   RobotMockServer server;
   Move::Deviation maximum_path_deviation{0, 1, 2};
@@ -728,6 +767,50 @@ TEST(RobotImpl, CanStopMotionWithController) {
       .spinOnce();
 }
 
+TEST(RobotImpl, ThrowOnMotionErrorDoesNotAllocateWithoutError) {
+  RobotMockServer server;
+  Move::Deviation maximum_path_deviation{0, 1, 2};
+  Move::Deviation maximum_goal_pose_deviation{3, 4, 5};
+
+  Robot::Impl robot(std::make_unique<franka::Network>("127.0.0.1", kCommandPort), 0);
+
+  server
+      .onSendUDP<RobotState>([](RobotState& robot_state) {
+        robot_state.motion_generator_mode = MotionGeneratorMode::kJointPosition;
+        robot_state.controller_mode = ControllerMode::kJointImpedance;
+        robot_state.robot_mode = RobotMode::kMove;
+      })
+      .spinOnce()
+      .waitForCommand<Move>(
+          [&](const Move::Request&) { return Move::Response(Move::Status::kMotionStarted); })
+      .spinOnce();
+
+  auto id = robot.startMotion(Move::ControllerMode::kJointImpedance,
+                              Move::MotionGeneratorMode::kJointPosition, maximum_path_deviation,
+                              maximum_goal_pose_deviation);
+
+  MotionGeneratorCommand motion_command{};
+  server
+      .onSendUDP<RobotState>([](RobotState& robot_state) {
+        robot_state.motion_generator_mode = MotionGeneratorMode::kJointPosition;
+        robot_state.controller_mode = ControllerMode::kJointImpedance;
+        robot_state.robot_mode = RobotMode::kMove;
+      })
+      .spinOnce()
+      .onReceiveRobotCommand([](const RobotCommand&) {})
+      .spinOnce();
+
+  auto robot_state = robot.update(&motion_command, nullptr);
+  RobotState raw_robot_state{};
+  raw_robot_state.robot_mode = RobotMode::kMove;
+  franka::RobotStateView robot_state_view(raw_robot_state);
+
+  franka::AllocationTrackingScope allocation_tracking;
+  robot.throwOnMotionError(robot_state, id);
+  robot.throwOnMotionError(robot_state_view, id);
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
 TEST(RobotImpl, ThrowsDuringMotionIfErrorReceived) {
   RobotMockServer server;
   Move::Deviation maximum_path_deviation{0, 1, 2};
@@ -1268,4 +1351,79 @@ TEST(RobotImpl, CanStartConsecutiveControlAfterError) {
                     maximum_goal_pose_deviation);
   EXPECT_TRUE(robot.motionGeneratorRunning());
   EXPECT_TRUE(robot.controllerRunning());
-}
\ No newline at end of file
+}
+
+TEST(RobotImpl, ThrowsTimeoutIfCommandResponseIsMissing) {
+  RobotMockServer server;
+  Robot::Impl robot(std::make_unique<franka::Network>("127.0.0.1", kCommandPort, 200ms), 0);
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_THROW(robot.executeCommand<AutomaticErrorRecovery>(), NetworkException);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 200ms);
+}
+
+TEST(RobotImpl, ConcurrentWaitersReceiveTheirOwnResponses) {
+  RobotMockServer server;
+  Robot::Impl robot(std::make_unique<franka::Network>("127.0.0.1", kCommandPort), 0);
+
+  uint32_t first_id = robot.sendRequest<AutomaticErrorRecovery>();
+  uint32_t second_id = robot.sendRequest<AutomaticErrorRecovery>();
+  std::atomic<bool> first_aborted{false};
+  std::atomic<bool> second_succeeded{false};
+  std::thread first_waiter([&]() {
+    EXPECT_THROW(robot.receiveResponse<AutomaticErrorRecovery>(first_id),
+                 franka::CommandException);
+    first_aborted = true;
+  });
+  std::thread second_waiter([&]() {
+    EXPECT_NO_THROW(robot.receiveResponse<AutomaticErrorRecovery>(second_id));
+    second_succeeded = true;
+  });
+
+  // Answer in reverse order while both callers are waiting.
+  server
+      .generic([&](RobotMockServer::Socket& tcp_socket, RobotMockServer::Socket&) {
+        CommandHeader first_header;
+        CommandHeader second_header;
+        server.receiveRequest<AutomaticErrorRecovery>(tcp_socket, &first_header);
+        server.receiveRequest<AutomaticErrorRecovery>(tcp_socket, &second_header);
+        std::this_thread::sleep_for(50ms);
+        server.sendResponse<AutomaticErrorRecovery>(
+            tcp_socket,
+            CommandHeader(Command::kAutomaticErrorRecovery, second_header.command_id,
+                          sizeof(CommandMessage<AutomaticErrorRecovery::Response>)),
+            AutomaticErrorRecovery::Response(AutomaticErrorRecovery::Status::kSuccess));
+        std::this_thread::sleep_for(50ms);
+        server.sendResponse<AutomaticErrorRecovery>(
+            tcp_socket,
+            CommandHeader(Command::kAutomaticErrorRecovery, first_header.command_id,
+                          sizeof(CommandMessage<AutomaticErrorRecovery::Response>)),
+            AutomaticErrorRecovery::Response(AutomaticErrorRecovery::Status::kReflexAborted));
+      })
+      .spinOnce();
+
+  first_waiter.join();
+  second_waiter.join();
+  EXPECT_TRUE(first_aborted);
+  EXPECT_TRUE(second_succeeded);
+}
+
+TEST(RobotImpl, ReceivesCommandResponsesWithoutAllocating) {
+  RobotMockServer server;
+  Robot::Impl robot(std::make_unique<franka::Network>("127.0.0.1", kCommandPort), 0);
+
+  constexpr size_t kCommands = 4;
+  for (size_t i = 0; i < kCommands; i++) {
+    server.waitForCommand<AutomaticErrorRecovery>([](const AutomaticErrorRecovery::Request&) {
+      return AutomaticErrorRecovery::Response(AutomaticErrorRecovery::Status::kSuccess);
+    });
+  }
+  server.spinOnce();
+
+  // Response buffers come from the pool of the network, and go back to it once received.
+  franka::AllocationTrackingScope allocation_tracking;
+  for (size_t i = 0; i < kCommands; i++) {
+    robot.executeCommand<AutomaticErrorRecovery>();
+  }
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <franka/exception.h>
+#include <franka/robot_startup.h>
+#include <research_interface/robot/service_types.h>
+
+#include "helpers.h"
+#include "mock_server.h"
+
+using namespace research_interface::robot;
+
+namespace {
+
+std::vector<char> readModelLibrary() {
+  using namespace std::string_literals;
+
+  std::ifstream model_library_stream(
+      FRANKA_TEST_BINARY_DIR + "/libfcimodels.so"s,
+      std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+  std::vector<char> buffer;
+  buffer.resize(model_library_stream.tellg());
+  model_library_stream.seekg(0, std::ios::beg);
+  if (!model_library_stream.read(buffer.data(), buffer.size())) {
+    throw std::runtime_error("Robot startup test: Cannot load mock libfcimodels.so");
+  }
+  return buffer;
+}
+
+void serveModelLibrary(RobotMockServer& server, const std::vector<char>& buffer) {
+  server
+      .generic([&server, buffer](RobotMockServer::Socket& tcp_socket, RobotMockServer::Socket&) {
+        CommandHeader header;
+        server.receiveRequest<LoadModelLibrary>(tcp_socket, &header);
+        server.sendResponse<LoadModelLibrary>(
+            tcp_socket,
+            CommandHeader(Command::kLoadModelLibrary, header.command_id,
+                          sizeof(CommandMessage<LoadModelLibrary::Response>) + buffer.size()),
+            LoadModelLibrary::Response(LoadModelLibrary::Status::kSuccess));
+        tcp_socket.sendBytes(buffer.data(), buffer.size());
+      })
+      .spinOnce();
+}
+
+franka::StartupOptions testOptions() {
+  franka::StartupOptions options;
+  options.realtime_config = franka::RealtimeConfig::kIgnore;
+  return options;
+}
+
+}  // anonymous namespace
+
+TEST(RobotStartup, ConnectsAndLoadsModel) {
+  RobotMockServer server;
+  std::vector<char> buffer = readModelLibrary();
+  serveModelLibrary(server, buffer);
+
+  franka::RobotStartup startup =
+      franka::startRobot("127.0.0.1", franka::CommandBatch(), testOptions());
+  EXPECT_EQ(kVersion, startup.robot.serverVersion());
+  EXPECT_TRUE(startup.configuration.empty());
+}
+
+TEST(RobotStartup, LoadsModelWhileExecutingConfiguration) {
+  RobotMockServer server;
+  std::vector<char> buffer = readModelLibrary();
+  bool received_model_request = false;
+  bool received_configuration = false;
+  // The download runs on its own thread, so the requests can arrive in any order. Both are
+  // received before either is answered, and the configuration is answered first.
+  server
+      .generic([&](RobotMockServer::Socket& tcp_socket, RobotMockServer::Socket&) {
+        CommandHeader model_header;
+        CommandHeader configuration_header;
+        for (int i = 0; i < 2; i++) {
+          CommandHeader header;
+          tcp_socket.receiveBytes(&header, sizeof(header));
+          std::vector<uint8_t> request(header.size - sizeof(header));
+          tcp_socket.receiveBytes(request.data(), request.size());
+          if (header.command == Command::kLoadModelLibrary) {
+            received_model_request = true;
+            model_header = header;
+          } else if (header.command == Command::kSetLoad) {
+            received_configuration = true;
+            configuration_header = header;
+          }
+        }
+        server.sendResponse<SetLoad>(
+            tcp_socket,
+            CommandHeader(Command::kSetLoad, configuration_header.command_id,
+                          sizeof(CommandMessage<SetLoad::Response>)),
+            SetLoad::Response(SetLoad::Status::kSuccess));
+        server.sendResponse<LoadModelLibrary>(
+            tcp_socket,
+            CommandHeader(Command::kLoadModelLibrary, model_header.command_id,
+                          sizeof(CommandMessage<LoadModelLibrary::Response>) + buffer.size()),
+            LoadModelLibrary::Response(LoadModelLibrary::Status::kSuccess));
+        tcp_socket.sendBytes(buffer.data(), buffer.size());
+      })
+      .spinOnce();
+
+  franka::CommandBatch configuration;
+  configuration.setLoad(0.5, {{0, 0, 0}}, {{0.01, 0, 0, 0, 0.01, 0, 0, 0, 0.01}});
+  franka::RobotStartup startup = franka::startRobot("127.0.0.1", configuration, testOptions());
+  EXPECT_TRUE(received_model_request);
+  EXPECT_TRUE(received_configuration);
+  ASSERT_EQ(1u, startup.configuration.size());
+  EXPECT_TRUE(startup.configuration[0].success);
+  EXPECT_EQ(kVersion, startup.robot.serverVersion());
+}
+
+TEST(RobotStartup, ThrowsIfModelCannotBeLoaded) {
+  RobotMockServer server;
+  server
+      .waitForCommand<LoadModelLibrary>([](const LoadModelLibrary::Request&) {
+        return LoadModelLibrary::Response(LoadModelLibrary::Status::kError);
+      })
+      .spinOnce();
+
+  EXPECT_THROW(franka::startRobot("127.0.0.1", franka::CommandBatch(), testOptions()),
+               franka::ModelException);
+}
+
+TEST(RobotStartup, ReusesModelAndExecutesConfiguration) {
+  std::vector<char> buffer = readModelLibrary();
+  std::unique_ptr<RobotMockServer> server = std::make_unique<RobotMockServer>();
+  serveModelLibrary(*server, buffer);
+  franka::RobotStartup first =
+      franka::startRobot("127.0.0.1", franka::CommandBatch(), testOptions());
+
+  server.reset();
+  server = std::make_unique<RobotMockServer>();
+  server
+      ->waitForCommand<SetLoad>([](const SetLoad::Request& request) {
+        EXPECT_EQ(0.5, request.m_load);
+        return SetLoad::Response(SetLoad::Status::kSuccess);
+      })
+      .spinOnce();
+
+  franka::CommandBatch configuration;
+  configuration.setLoad(0.5, {{0, 0, 0}}, {{0.01, 0, 0, 0, 0.01, 0, 0, 0, 0.01}});
+  franka::RobotStartup second = franka::startRobot("127.0.0.1", std::move(first.model),
+                                                   configuration, testOptions());
+  ASSERT_EQ(1u, second.configuration.size());
+  EXPECT_TRUE(second.configuration[0].success);
+}
+
+TEST(Robot, CanReconnect) {
+  std::unique_ptr<RobotMockServer> server = std::make_unique<RobotMockServer>();
+  franka::Robot robot("127.0.0.1", franka::RealtimeConfig::kIgnore);
+
+  server.reset();
+  server = std::make_unique<RobotMockServer>();
+  robot.reconnect("127.0.0.1");
+  EXPECT_EQ(kVersion, robot.serverVersion());
+
+  server->sendEmptyState<RobotState>().spinOnce();
+  EXPECT_NO_THROW(robot.readOnce());
+}
+
+TEST(Robot, ReconnectThrowsIfServerIsUnreachable) {
+  std::unique_ptr<RobotMockServer> server = std::make_unique<RobotMockServer>();
+  franka::Robot robot("127.0.0.1", franka::RealtimeConfig::kIgnore);
+
+  server.reset();
+  EXPECT_THROW(robot.reconnect("127.0.0.1"), franka::NetworkException);
+}
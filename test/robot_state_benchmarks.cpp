@@ -0,0 +1,45 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <benchmark/benchmark.h>
+
+#include <franka/joint_state_estimator.h>
+
+#include <research_interface/robot/rbk_types.h>
+
+#include "helpers.h"
+#include "robot_state_conversion.h"
+
+static void BM_ConvertRobotState(benchmark::State& state) {
+  research_interface::robot::RobotState robot_state;
+  randomRobotState(robot_state);
+  franka::RobotState converted;
+  for (auto _ : state) {
+    franka::convertRobotState(robot_state, &converted);
+    benchmark::DoNotOptimize(converted);
+  }
+}
+BENCHMARK(BM_ConvertRobotState);
+
+static void BM_ConvertRobotStateWithLoadCache(benchmark::State& state) {
+  research_interface::robot::RobotState robot_state;
+  randomRobotState(robot_state);
+  franka::CombinedLoadCache load_cache;
+  franka::RobotState converted;
+  for (auto _ : state) {
+    franka::convertRobotState(robot_state, &load_cache, &converted);
+    benchmark::DoNotOptimize(converted);
+  }
+}
+BENCHMARK(BM_ConvertRobotStateWithLoadCache);
+
+static void BM_JointStateEstimator(benchmark::State& state) {
+  franka::RobotState robot_state;
+  randomRobotState(robot_state);
+  franka::JointStateEstimator estimator;
+  estimator.update(&robot_state, franka::Duration());
+  for (auto _ : state) {
+    estimator.update(&robot_state, franka::Duration(1));
+    benchmark::DoNotOptimize(robot_state);
+  }
+}
+BENCHMARK(BM_JointStateEstimator);
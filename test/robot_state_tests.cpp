@@ -53,6 +53,7 @@ TEST(RobotState, CanBeStreamed) {
   EXPECT_PRED2(stringContains, output, "q_d");
   EXPECT_PRED2(stringContains, output, "dq_d");
   EXPECT_PRED2(stringContains, output, "ddq_d");
+  EXPECT_PRED2(stringContains, output, "ddq_hat");
   EXPECT_PRED2(stringContains, output, "joint_contact");
   EXPECT_PRED2(stringContains, output, "cartesian_contact");
   EXPECT_PRED2(stringContains, output, "joint_collision");
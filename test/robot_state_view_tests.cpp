@@ -0,0 +1,54 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <franka/robot_state_view.h>
+
+#include "helpers.h"
+#include "robot_state_conversion.h"
+
+using namespace franka;
+
+TEST(RobotStateView, CanBeConvertedToRobotState) {
+  research_interface::robot::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  RobotStateView view(robot_state);
+
+  testRobotStatesAreEqual(robot_state, view.toRobotState());
+}
+
+TEST(RobotStateView, AccessorsMatchConvertedState) {
+  research_interface::robot::RobotState robot_state;
+  randomRobotState(robot_state);
+
+  RobotStateView view(robot_state);
+  RobotState converted = convertRobotState(robot_state);
+
+  EXPECT_EQ(converted.O_T_EE, view.O_T_EE());
+  EXPECT_EQ(converted.O_T_EE_c, view.O_T_EE_c());
+  EXPECT_EQ(converted.q, view.q());
+  EXPECT_EQ(converted.dq, view.dq());
+  EXPECT_EQ(converted.tau_J, view.tau_J());
+  EXPECT_EQ(converted.tau_J_d, view.tau_J_d());
+  EXPECT_EQ(converted.O_F_ext_hat_K, view.O_F_ext_hat_K());
+  EXPECT_EQ(converted.m_total, view.m_total());
+  EXPECT_EQ(converted.F_x_Ctotal, view.F_x_Ctotal());
+  EXPECT_EQ(converted.I_total, view.I_total());
+  EXPECT_EQ(static_cast<bool>(converted.current_errors),
+            static_cast<bool>(view.current_errors()));
+  EXPECT_EQ(converted.control_command_success_rate, view.control_command_success_rate());
+  EXPECT_EQ(converted.robot_mode, view.robot_mode());
+  EXPECT_EQ(converted.time, view.time());
+}
+
+TEST(RobotStateView, ReadsFromReferencedPacket) {
+  research_interface::robot::RobotState robot_state{};
+  RobotStateView view(robot_state);
+
+  robot_state.q[3] = 1.5;
+  robot_state.message_id = 42;
+
+  EXPECT_EQ(1.5, view.q()[3]);
+  EXPECT_EQ(Duration(42), view.time());
+}
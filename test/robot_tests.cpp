@@ -2,10 +2,12 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #include <gmock/gmock.h>
 
+#include <array>
 #include <atomic>
 #include <functional>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <franka/exception.h>
 #include <franka/lowpass_filter.h>
@@ -24,6 +26,109 @@ using namespace research_interface;
 
 using namespace franka;
 
+namespace {
+
+void sendMotionState(RobotMockServer::Socket& udp_socket, uint32_t message_id, bool moving) {
+  robot::RobotState robot_state{};
+  robot_state.message_id = message_id;
+  robot_state.controller_mode = robot::ControllerMode::kJointImpedance;
+  if (moving) {
+    robot_state.motion_generator_mode = robot::MotionGeneratorMode::kJointPosition;
+    robot_state.robot_mode = robot::RobotMode::kMove;
+  } else {
+    robot_state.motion_generator_mode = robot::MotionGeneratorMode::kIdle;
+    robot_state.robot_mode = robot::RobotMode::kIdle;
+  }
+  udp_socket.sendBytes(&robot_state, sizeof(robot_state));
+}
+
+// Serves one joint position motion, answering every command with the next state until the
+// motion is finished.
+void serveMotion(RobotMockServer& server, uint32_t& move_id) {
+  server
+      .waitForCommand<Move>(
+          [&](const Move::Request&) {
+            server.generic([&](RobotMockServer::Socket& tcp_socket,
+                               RobotMockServer::Socket& udp_socket) {
+              uint32_t message_id = server.sequenceNumber();
+              // Consumed by Robot::Impl::startMotion and the first update of the control loop.
+              sendMotionState(udp_socket, ++message_id, true);
+              sendMotionState(udp_socket, ++message_id, true);
+
+              robot::RobotCommand robot_command{};
+              do {
+                udp_socket.receiveBytes(&robot_command, sizeof(robot_command));
+                sendMotionState(udp_socket, ++message_id,
+                                !robot_command.motion.motion_generation_finished);
+              } while (!robot_command.motion.motion_generation_finished);
+
+              server.sendResponse<Move>(
+                  tcp_socket,
+                  robot::CommandHeader(robot::Command::kMove, move_id,
+                                       sizeof(robot::CommandMessage<Move::Response>)),
+                  Move::Response(Move::Status::kSuccess));
+            });
+            return Move::Response(Move::Status::kMotionStarted);
+          },
+          &move_id)
+      .spinOnce();
+}
+
+}  // anonymous namespace
+
+struct NonCopyableController {
+  NonCopyableController() = default;
+  NonCopyableController(const NonCopyableController&) = delete;
+  NonCopyableController& operator=(const NonCopyableController&) = delete;
+
+  Torques operator()(const RobotState&, Duration) { return Torques({0, 0, 0, 0, 0, 0, 0}); }
+};
+
+TEST(Robot, DetectsTemplateCallbackTypes) {
+  auto torques = [](const RobotState&, Duration) { return Torques({0, 0, 0, 0, 0, 0, 0}); };
+  auto joint_velocities = [](const RobotState&, Duration) {
+    return JointVelocities({0, 0, 0, 0, 0, 0, 0});
+  };
+  auto view = [](const RobotStateView&, Duration) { return Torques({0, 0, 0, 0, 0, 0, 0}); };
+
+  static_assert(detail::IsTorqueCallback<decltype(torques)>::value, "");
+  static_assert(detail::IsTorqueCallback<NonCopyableController&>::value, "");
+  static_assert(!detail::IsTorqueCallback<decltype(joint_velocities)>::value, "");
+  static_assert(!detail::IsTorqueCallback<decltype(view)>::value, "");
+  static_assert(
+      !detail::IsTorqueCallback<std::function<Torques(const RobotState&, Duration)>>::value, "");
+  static_assert(detail::IsMotionGeneratorCallback<decltype(joint_velocities)>::value, "");
+  static_assert(!detail::IsMotionGeneratorCallback<decltype(torques)>::value, "");
+}
+
+TEST(Robot, CopiesLvalueCallbackForEveryMotion) {
+  RobotMockServer server;
+  Robot robot("127.0.0.1", RealtimeConfig::kIgnore);
+  uint32_t move_id;
+
+  std::vector<int> cycles;
+  auto motion_generator = [cycle = 0, &cycles](const RobotState&,
+                                               Duration) mutable -> JointPositions {
+    JointPositions joint_positions{{0, 0, 0, 0, 0, 0, 0}};
+    cycles.push_back(cycle);
+    if (++cycle >= 3) {
+      return MotionFinished(joint_positions);
+    }
+    return joint_positions;
+  };
+
+  // Each motion starts from the state of the given lambda, like with the std::function overloads.
+  serveMotion(server, move_id);
+  robot.control(motion_generator, ControllerMode::kJointImpedance, false,
+                franka::kMaxCutoffFrequency);
+  serveMotion(server, move_id);
+  robot.control(motion_generator, ControllerMode::kJointImpedance, false,
+                franka::kMaxCutoffFrequency);
+
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 0, 1, 2}), cycles);
+  server.ignoreUdpBuffer();
+}
+
 TEST(Robot, CannotConnectIfNoServerRunning) {
   EXPECT_THROW(Robot robot("127.0.0.1"), NetworkException)
       << "Shut down local robot service to run tests.";
@@ -456,3 +561,53 @@ TEST(Robot, ThrowsIfConflictingOperationIsRunning) {
     thread.join();
   }
 }
+
+TEST(Robot, ExecutesCommandBatch) {
+  using research_interface::robot::SetCartesianImpedance;
+  using research_interface::robot::SetJointImpedance;
+  using research_interface::robot::SetLoad;
+
+  RobotMockServer server;
+  Robot robot("127.0.0.1", RealtimeConfig::kIgnore);
+
+  std::array<double, 7> joint_stiffness{{3000, 3000, 3000, 2500, 2500, 2000, 2000}};
+  std::array<double, 6> cartesian_stiffness{{3000, 3000, 3000, 300, 300, 300}};
+  std::array<double, 3> load_center{{0.01, 0, 0.03}};
+  std::array<double, 9> load_inertia{{0.01, 0, 0, 0, 0.01, 0, 0, 0, 0.01}};
+
+  server
+      .waitForCommand<SetJointImpedance>([&](const SetJointImpedance::Request& request) {
+        EXPECT_EQ(joint_stiffness, request.K_theta);
+        return SetJointImpedance::Response(SetJointImpedance::Status::kSuccess);
+      })
+      .waitForCommand<SetCartesianImpedance>([&](const SetCartesianImpedance::Request& request) {
+        EXPECT_EQ(cartesian_stiffness, request.K_x);
+        return SetCartesianImpedance::Response(
+            SetCartesianImpedance::Status::kInvalidArgumentRejected);
+      })
+      .waitForCommand<SetLoad>([&](const SetLoad::Request& request) {
+        EXPECT_EQ(0.5, request.m_load);
+        return SetLoad::Response(SetLoad::Status::kSuccess);
+      })
+      .spinOnce();
+
+  CommandBatch batch;
+  batch.setJointImpedance(joint_stiffness)
+      .setCartesianImpedance(cartesian_stiffness)
+      .setLoad(0.5, load_center, load_inertia);
+  ASSERT_EQ(3u, batch.size());
+
+  std::vector<CommandResult> results = robot.execute(batch);
+  ASSERT_EQ(3u, results.size());
+  EXPECT_EQ("SetJointImpedance", results[0].command);
+  EXPECT_TRUE(results[0].success);
+  EXPECT_TRUE(results[0].error.empty());
+  EXPECT_EQ("SetCartesianImpedance", results[1].command);
+  EXPECT_FALSE(results[1].success);
+  EXPECT_THAT(results[1].error, ::testing::HasSubstr("invalid argument"));
+  EXPECT_EQ("SetLoad", results[2].command);
+  EXPECT_TRUE(results[2].success);
+
+  batch.clear();
+  EXPECT_EQ(0u, batch.size());
+}
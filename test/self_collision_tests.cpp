@@ -0,0 +1,224 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/self_collision.h>
+
+using namespace ::testing;
+
+using franka::Capsule;
+using franka::Frame;
+using franka::FrameJacobians;
+using franka::FramePoses;
+using franka::SelfCollisionChecker;
+using franka::SelfCollisionParameters;
+using franka::SelfCollisionResult;
+
+namespace {
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+// Joints 1 to 3 translate all frames along x, y and z, joints 4 to 6 rotate them about x, y and z.
+void identityKinematics(FramePoses* poses, FrameJacobians* jacobians) {
+  for (auto& pose : *poses) {
+    pose = translation(0, 0, 0);
+  }
+  for (auto& jacobian : *jacobians) {
+    jacobian.fill(0);
+    for (size_t i = 0; i < 3; i++) {
+      jacobian[6 * i + i] = 1;
+      jacobian[6 * (i + 3) + i + 3] = 1;
+    }
+  }
+}
+
+Capsule capsule(Frame frame,
+                const std::array<double, 3>& start,
+                const std::array<double, 3>& end,
+                double radius) {
+  Capsule result;
+  result.frame = frame;
+  result.start = start;
+  result.end = end;
+  result.radius = radius;
+  return result;
+}
+
+SelfCollisionParameters stiffParameters() {
+  SelfCollisionParameters parameters;
+  parameters.activation_distance = 0.05;
+  parameters.stiffness = 1000;
+  parameters.damping = 0;
+  return parameters;
+}
+
+}  // anonymous namespace
+
+TEST(SelfCollisionChecker, SkipsNeighboringLinks) {
+  Capsule capsule_1 = capsule(Frame::kJoint1, {}, {}, 0.1);
+  Capsule capsule_2 = capsule(Frame::kJoint2, {}, {}, 0.1);
+  Capsule capsule_3 = capsule(Frame::kJoint3, {}, {}, 0.1);
+  Capsule capsule_5 = capsule(Frame::kJoint5, {}, {}, 0.1);
+  Capsule capsule_6 = capsule(Frame::kJoint6, {}, {}, 0.1);
+  Capsule hand = capsule(Frame::kEndEffector, {}, {}, 0.1);
+
+  EXPECT_EQ(0u, SelfCollisionChecker({capsule_1, capsule_2}).pairCount());
+  EXPECT_EQ(0u, SelfCollisionChecker({capsule_2, capsule_2}).pairCount());
+  EXPECT_EQ(1u, SelfCollisionChecker({capsule_1, capsule_3}).pairCount());
+  EXPECT_EQ(0u, SelfCollisionChecker({capsule_6, hand}).pairCount());
+  EXPECT_EQ(1u, SelfCollisionChecker({capsule_5, hand}).pairCount());
+  EXPECT_EQ(3u, SelfCollisionChecker({capsule_1, capsule_3, capsule_5}).pairCount());
+  EXPECT_EQ(5u, SelfCollisionChecker({capsule_1, capsule_3}, {capsule_1, capsule_2}).pairCount());
+
+  SelfCollisionChecker checker;
+  EXPECT_EQ(SelfCollisionChecker::defaultCapsules().size(), checker.capsules().size());
+  EXPECT_GT(checker.pairCount(), 0u);
+}
+
+TEST(SelfCollisionChecker, ComputesSegmentDistances) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+  Capsule link = capsule(Frame::kJoint1, {{-1, 0, 0}}, {{1, 0, 0}}, 0.1);
+
+  struct Case {
+    Capsule obstacle;
+    double distance;
+  };
+  for (const Case& test_case : std::vector<Case>{
+           // Crossing segments.
+           {capsule(Frame::kJoint1, {{0.5, -1, 0.5}}, {{0.5, 1, 0.5}}, 0.2), 0.2},
+           // Parallel segments, overlapping and beyond the end.
+           {capsule(Frame::kJoint1, {{-3, 0.4, 0}}, {{0.5, 0.4, 0}}, 0.1), 0.2},
+           {capsule(Frame::kJoint1, {{2, 0, 0}}, {{4, 0, 0}}, 0.1), 0.8},
+           // Sphere next to the segment and beyond its start.
+           {capsule(Frame::kJoint1, {{0.3, 0, -0.6}}, {{0.3, 0, -0.6}}, 0.2), 0.3},
+           {capsule(Frame::kJoint1, {{-1.3, 0.4, 0}}, {{-1.3, 0.4, 0}}, 0), 0.4},
+           // Overlapping capsules.
+           {capsule(Frame::kJoint1, {{0, 0, 0.15}}, {{0, 0, 1}}, 0.1), -0.05},
+       }) {
+    SelfCollisionChecker checker({link}, {test_case.obstacle}, stiffParameters());
+    SelfCollisionResult result = checker.check(poses, jacobians, {});
+    EXPECT_NEAR(test_case.distance, result.min_distance, 1e-12);
+    EXPECT_TRUE(result.nearest_is_obstacle);
+  }
+
+  // A degenerate link capsule is a sphere around the frame origin.
+  poses[static_cast<size_t>(Frame::kJoint3)] = translation(0, 0, 1);
+  SelfCollisionChecker checker({link, capsule(Frame::kJoint3, {}, {}, 0.2)}, {}, stiffParameters());
+  SelfCollisionResult result = checker.check(poses, jacobians, {});
+  EXPECT_NEAR(0.7, result.min_distance, 1e-12);
+  EXPECT_EQ(0u, result.nearest_link);
+  EXPECT_EQ(1u, result.nearest_other);
+  EXPECT_FALSE(result.nearest_is_obstacle);
+}
+
+TEST(SelfCollisionChecker, ReportsNearestPair) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+  poses[static_cast<size_t>(Frame::kJoint4)] = translation(0, 0, 0.6);
+  poses[static_cast<size_t>(Frame::kFlange)] = translation(0, 0, 1);
+
+  std::vector<Capsule> capsules{capsule(Frame::kJoint1, {}, {}, 0.1),
+                                capsule(Frame::kJoint4, {}, {}, 0.1),
+                                capsule(Frame::kFlange, {}, {}, 0.1)};
+  std::vector<Capsule> obstacles{capsule(Frame::kJoint1, {{2, 0, 1}}, {{2, 0, 1}}, 0.5),
+                                 capsule(Frame::kJoint1, {{0, 0, 1.3}}, {{1, 0, 1.3}}, 0.05)};
+  SelfCollisionChecker checker(capsules, obstacles, stiffParameters());
+  EXPECT_EQ(9u, checker.pairCount());
+
+  SelfCollisionResult result = checker.check(poses, jacobians, {});
+  EXPECT_NEAR(0.15, result.min_distance, 1e-12);
+  EXPECT_EQ(2u, result.nearest_link);
+  EXPECT_EQ(1u, result.nearest_other);
+  EXPECT_TRUE(result.nearest_is_obstacle);
+  EXPECT_EQ(0u, result.active_pairs);
+  EXPECT_THAT(result.tau_J, Each(0.0));
+
+  checker.setObstacles({});
+  EXPECT_EQ(3u, checker.pairCount());
+  result = checker.check(poses, jacobians, {});
+  EXPECT_NEAR(0.2, result.min_distance, 1e-12);
+  EXPECT_EQ(1u, result.nearest_link);
+  EXPECT_EQ(2u, result.nearest_other);
+  EXPECT_FALSE(result.nearest_is_obstacle);
+
+  EXPECT_TRUE(std::isinf(SelfCollisionChecker({}, {}).check(poses, jacobians, {}).min_distance));
+}
+
+TEST(SelfCollisionChecker, RepelsCapsulesAlongDistanceGradient) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+  // Only the flange moves with the translational joints.
+  jacobians[static_cast<size_t>(Frame::kJoint1)].fill(0);
+
+  Capsule link = capsule(Frame::kJoint1, {{0, 0, 0}}, {{1, 0, 0}}, 0.05);
+  Capsule hand = capsule(Frame::kFlange, {{0.5, 0.5, 0.1}}, {{0.5, -0.5, 0.1}}, 0.03);
+  SelfCollisionChecker checker({link, hand}, {}, stiffParameters());
+
+  // 30 mm below the activation distance, the hand is pushed up by 30 N, with a lever of
+  // (0.5, 0, 0.1) about the flange origin.
+  SelfCollisionResult result = checker.check(poses, jacobians, {});
+  EXPECT_NEAR(0.02, result.min_distance, 1e-12);
+  EXPECT_EQ(1u, result.active_pairs);
+  EXPECT_THAT(result.tau_J, ElementsAre(DoubleNear(0, 1e-9), DoubleNear(0, 1e-9),
+                                        DoubleNear(30, 1e-9), DoubleNear(0, 1e-9),
+                                        DoubleNear(-15, 1e-9), DoubleNear(0, 1e-9), 0));
+
+  // Joints that move both capsules alike do not change their distance, so the torques cancel.
+  identityKinematics(&poses, &jacobians);
+  result = checker.check(poses, jacobians, {});
+  EXPECT_EQ(1u, result.active_pairs);
+  EXPECT_THAT(result.tau_J, Each(DoubleNear(0, 1e-9)));
+}
+
+TEST(SelfCollisionChecker, DampingOpposesApproach) {
+  FramePoses poses;
+  FrameJacobians jacobians;
+  identityKinematics(&poses, &jacobians);
+
+  SelfCollisionParameters parameters = stiffParameters();
+  parameters.damping = 20;
+  SelfCollisionChecker checker({capsule(Frame::kFlange, {}, {}, 0.05)},
+                               {capsule(Frame::kJoint1, {{0, 0, -0.1}}, {{0, 0, -0.1}}, 0.03)},
+                               parameters);
+
+  EXPECT_NEAR(30 + 20 * 0.1, checker.check(poses, jacobians, {{0, 0, -0.1}}).tau_J[2], 1e-9);
+  EXPECT_NEAR(30, checker.check(poses, jacobians, {{0.1, 0, 0}}).tau_J[2], 1e-9);
+  // Fast retraction does not pull the capsules together.
+  EXPECT_THAT(checker.check(poses, jacobians, {{0, 0, 2}}).tau_J, Each(DoubleNear(0, 1e-9)));
+}
+
+TEST(SelfCollisionChecker, ThrowsOnInvalidArguments) {
+  Capsule valid = capsule(Frame::kJoint1, {}, {}, 0.1);
+  Capsule negative_radius = capsule(Frame::kJoint1, {}, {}, -0.1);
+  Capsule infinite_point =
+      capsule(Frame::kJoint1, {{std::numeric_limits<double>::infinity(), 0, 0}}, {}, 0.1);
+  Capsule invalid_frame = capsule(static_cast<Frame>(franka::kFrameCount), {}, {}, 0.1);
+
+  EXPECT_THROW(SelfCollisionChecker({negative_radius}), std::invalid_argument);
+  EXPECT_THROW(SelfCollisionChecker({infinite_point}), std::invalid_argument);
+  EXPECT_THROW(SelfCollisionChecker({invalid_frame}), std::invalid_argument);
+  EXPECT_NO_THROW(SelfCollisionChecker({valid}, {invalid_frame}));
+  EXPECT_THROW(SelfCollisionChecker({valid}, {negative_radius}), std::invalid_argument);
+
+  SelfCollisionParameters parameters;
+  parameters.stiffness = -1;
+  EXPECT_THROW(SelfCollisionChecker({valid}, {}, parameters), std::invalid_argument);
+  parameters = {};
+  parameters.activation_distance = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(SelfCollisionChecker({valid}, {}, parameters), std::invalid_argument);
+
+  SelfCollisionChecker checker({valid});
+  EXPECT_THROW(checker.setObstacles({negative_radius}), std::invalid_argument);
+  EXPECT_TRUE(checker.obstacles().empty());
+}
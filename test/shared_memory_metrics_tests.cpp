@@ -0,0 +1,138 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <franka/exception.h>
+#include <franka/shared_memory_metrics.h>
+
+#include "control_statistics_recorder.h"
+#include "limiting_statistics_recorder.h"
+#include "metrics_writer.h"
+
+using franka::ControlStatisticsRecorder;
+using franka::LimitingStatisticsRecorder;
+using franka::MetricsSegment;
+using franka::SharedMemoryMetrics;
+
+using namespace std::chrono_literals;  // NOLINT(google-build-using-namespace)
+
+namespace {
+
+std::string segmentName() {
+  return "/libfranka_metrics_test_" + std::to_string(getpid());
+}
+
+}  // anonymous namespace
+
+TEST(SharedMemoryMetrics, CreatesSegmentReadableByOtherProcesses) {
+  SharedMemoryMetrics metrics(segmentName());
+  EXPECT_EQ(segmentName(), metrics.name());
+
+  // Map the segment read-only, as an external monitor would.
+  int file = shm_open(segmentName().c_str(), O_RDONLY, 0);
+  ASSERT_LE(0, file);
+  void* address = mmap(nullptr, sizeof(MetricsSegment), PROT_READ, MAP_SHARED, file, 0);
+  close(file);
+  ASSERT_NE(MAP_FAILED, address);
+
+  const auto* segment = static_cast<const MetricsSegment*>(address);
+  EXPECT_EQ(MetricsSegment::kMagic, segment->magic.load());
+  EXPECT_EQ(MetricsSegment::kVersion, segment->version);
+  EXPECT_EQ(sizeof(MetricsSegment), segment->size);
+  EXPECT_EQ(franka::kMetricsBucketBounds, segment->bucket_bounds_us);
+  EXPECT_EQ(0u, segment->sequence.load());
+
+  franka::recordMetricsState(metrics.segment(), 5, 2, 0.95);
+  EXPECT_EQ(1u, segment->sequence.load());
+  EXPECT_EQ(5u, segment->message_id.load());
+  EXPECT_EQ(2u, segment->robot_mode.load());
+  EXPECT_EQ(950000u, segment->success_rate_ppm.load());
+  munmap(address, sizeof(MetricsSegment));
+}
+
+TEST(SharedMemoryMetrics, RemovesSegmentOnDestruction) {
+  { SharedMemoryMetrics metrics(segmentName()); }
+  EXPECT_GT(0, shm_open(segmentName().c_str(), O_RDONLY, 0));
+  SharedMemoryMetrics metrics(segmentName());
+}
+
+TEST(SharedMemoryMetrics, ThrowsIfSegmentExists) {
+  SharedMemoryMetrics metrics(segmentName());
+  EXPECT_THROW(SharedMemoryMetrics duplicate(segmentName()), franka::NetworkException);
+}
+
+TEST(SharedMemoryMetrics, CountsLostStates) {
+  SharedMemoryMetrics metrics(segmentName());
+  MetricsSegment& segment = metrics.segment();
+  franka::recordMetricsState(segment, 10, 0, 1.0);
+  franka::recordMetricsState(segment, 11, 0, 1.0);
+  franka::recordMetricsState(segment, 14, 0, 1.0);
+  franka::recordMetricsState(segment, 16, 0, 1.0);
+  EXPECT_EQ(3u, segment.lost_states.load());
+  EXPECT_EQ(4u, segment.sequence.load());
+}
+
+TEST(SharedMemoryMetrics, ReceivesTimingsOfDisabledRecorder) {
+  SharedMemoryMetrics metrics(segmentName());
+  ControlStatisticsRecorder recorder;
+  EXPECT_FALSE(recorder.active());
+  recorder.setMetrics(&metrics.segment());
+  EXPECT_TRUE(recorder.active());
+
+  recorder.record(ControlStatisticsRecorder::Stage::kReceiveState, 10us);
+  recorder.recordCycle(1000us);
+  recorder.recordCycle(1001us);
+  recorder.recordCycle(10ms);
+
+  const MetricsSegment& segment = metrics.segment();
+  const franka::MetricsHistogram& receive_state = segment.stages[0];
+  EXPECT_EQ(1u, receive_state.count.load());
+  EXPECT_EQ(10000u, receive_state.sum_ns.load());
+  EXPECT_EQ(1u, receive_state.buckets[0].load());
+
+  const franka::MetricsHistogram& cycle =
+      segment.stages[static_cast<size_t>(ControlStatisticsRecorder::Stage::kCycle)];
+  EXPECT_EQ(3u, cycle.count.load());
+  EXPECT_EQ(1u, cycle.buckets[11].load());
+  EXPECT_EQ(1u, cycle.buckets[12].load());
+  EXPECT_EQ(1u, cycle.buckets[franka::kMetricsBuckets - 1].load());
+  EXPECT_EQ(2u, segment.deadline_misses.load());
+
+  // The disabled recorder does not collect statistics itself.
+  EXPECT_EQ(0u, recorder.statistics().cycle.count);
+  EXPECT_EQ(0u, recorder.statistics().deadline_misses);
+
+  recorder.setEnabled(true);
+  recorder.recordCycle(100us);
+  EXPECT_EQ(1u, recorder.statistics().cycle.count);
+  EXPECT_EQ(4u, cycle.count.load());
+}
+
+TEST(SharedMemoryMetrics, CountsLimitedCommands) {
+  SharedMemoryMetrics metrics(segmentName());
+  LimitingStatisticsRecorder recorder;
+  recorder.setMetrics(&metrics.segment());
+
+  std::array<double, 7> commanded{{1, 2, 3, 4, 5, 6, 7}};
+  std::array<double, 7> limited = commanded;
+  recorder.record(LimitingStatisticsRecorder::Stage::kJointMotion, commanded, limited);
+  limited[3] = 3.5;
+  recorder.record(LimitingStatisticsRecorder::Stage::kJointMotion, commanded, limited);
+  recorder.record(LimitingStatisticsRecorder::Stage::kElbow, 1.0, 1.0);
+
+  const franka::MetricsLimitingStage& joint_motion = metrics.segment().limiting[1];
+  EXPECT_EQ(2u, joint_motion.cycles.load());
+  EXPECT_EQ(1u, joint_motion.limited_cycles.load());
+  const franka::MetricsLimitingStage& elbow = metrics.segment().limiting[3];
+  EXPECT_EQ(1u, elbow.cycles.load());
+  EXPECT_EQ(0u, elbow.limited_cycles.load());
+  EXPECT_EQ(0u, recorder.statistics().joint_motion.cycles);
+}
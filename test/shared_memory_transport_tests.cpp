@@ -0,0 +1,134 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <franka/exception.h>
+
+#include "shared_memory_transport.h"
+
+using franka::SharedMemoryTransport;
+using Endpoint = franka::SharedMemoryTransport::Endpoint;
+
+namespace {
+
+std::string segmentName() {
+  return "/libfranka_test_" + std::to_string(getpid());
+}
+
+}  // anonymous namespace
+
+TEST(SharedMemoryTransport, ClientCannotOpenMissingSegment) {
+  EXPECT_THROW(SharedMemoryTransport(segmentName(), Endpoint::kClient), franka::NetworkException);
+}
+
+TEST(SharedMemoryTransport, ClientCannotOpenSegmentBeforeItIsResized) {
+  // State between shm_open and ftruncate on the device side.
+  int file = shm_open(segmentName().c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  ASSERT_GE(file, 0);
+  EXPECT_THROW(SharedMemoryTransport(segmentName(), Endpoint::kClient), franka::NetworkException);
+
+  ASSERT_EQ(0, ftruncate(file, 64));
+  EXPECT_THROW(SharedMemoryTransport(segmentName(), Endpoint::kClient), franka::NetworkException);
+  close(file);
+  shm_unlink(segmentName().c_str());
+}
+
+TEST(SharedMemoryTransport, DeviceReplacesStaleSegment) {
+  int file = shm_open(segmentName().c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  ASSERT_GE(file, 0);
+  close(file);
+
+  SharedMemoryTransport device(segmentName(), Endpoint::kDevice);
+  SharedMemoryTransport client(segmentName(), Endpoint::kClient);
+  uint32_t state = 42;
+  device.send(reinterpret_cast<const uint8_t*>(&state), sizeof(state));
+  EXPECT_TRUE(client.available(sizeof(state)));
+}
+
+TEST(SharedMemoryTransport, ExchangesDatagramsInBothDirections) {
+  SharedMemoryTransport device(segmentName(), Endpoint::kDevice);
+  SharedMemoryTransport client(segmentName(), Endpoint::kClient);
+  EXPECT_EQ(0u, client.port());
+  EXPECT_EQ(-1, client.descriptor());
+
+  uint32_t state = 42;
+  EXPECT_FALSE(client.available(sizeof(state)));
+  device.send(reinterpret_cast<const uint8_t*>(&state), sizeof(state));
+  EXPECT_TRUE(client.available(sizeof(state)));
+
+  uint32_t received_state = 0;
+  std::chrono::system_clock::time_point receive_time;
+  auto before_receive = std::chrono::system_clock::now();
+  client.receive(reinterpret_cast<uint8_t*>(&received_state), sizeof(received_state),
+                 &receive_time);
+  EXPECT_EQ(state, received_state);
+  EXPECT_LE(before_receive, receive_time);
+  EXPECT_GE(std::chrono::system_clock::now(), receive_time);
+
+  uint64_t command = 7;
+  client.send(reinterpret_cast<const uint8_t*>(&command), sizeof(command));
+  EXPECT_TRUE(device.wait(std::chrono::microseconds(0)));
+  uint64_t received_command = 0;
+  device.receive(reinterpret_cast<uint8_t*>(&received_command), sizeof(received_command),
+                 &receive_time);
+  EXPECT_EQ(command, received_command);
+}
+
+TEST(SharedMemoryTransport, ReceivesBatches) {
+  SharedMemoryTransport device(segmentName(), Endpoint::kDevice);
+  SharedMemoryTransport client(segmentName(), Endpoint::kClient);
+
+  for (uint32_t i = 0; i < 3; i++) {
+    device.send(reinterpret_cast<const uint8_t*>(&i), sizeof(i));
+  }
+
+  std::array<uint32_t, 4> states{};
+  std::array<std::chrono::system_clock::time_point, 4> receive_times{};
+  ASSERT_EQ(3u, client.receiveBatch(reinterpret_cast<uint8_t*>(states.data()), sizeof(uint32_t),
+                                    states.size(), receive_times.data()));
+  EXPECT_EQ(0u, states[0]);
+  EXPECT_EQ(1u, states[1]);
+  EXPECT_EQ(2u, states[2]);
+  EXPECT_EQ(0u, client.receiveBatch(reinterpret_cast<uint8_t*>(states.data()), sizeof(uint32_t),
+                                    states.size(), receive_times.data()));
+}
+
+TEST(SharedMemoryTransport, DropsDatagramsIfRingIsFull) {
+  SharedMemoryTransport device(segmentName(), Endpoint::kDevice);
+  SharedMemoryTransport client(segmentName(), Endpoint::kClient);
+
+  for (uint32_t i = 0; i < SharedMemoryTransport::kSlotCount + 1; i++) {
+    device.send(reinterpret_cast<const uint8_t*>(&i), sizeof(i));
+  }
+
+  uint32_t state;
+  std::chrono::system_clock::time_point receive_time;
+  for (uint32_t i = 0; i < SharedMemoryTransport::kSlotCount; i++) {
+    client.receive(reinterpret_cast<uint8_t*>(&state), sizeof(state), &receive_time);
+    EXPECT_EQ(i, state);
+  }
+  EXPECT_FALSE(client.available(sizeof(state)));
+}
+
+TEST(SharedMemoryTransport, ThrowsOnTimeoutAndWrongSize) {
+  SharedMemoryTransport device(segmentName(), Endpoint::kDevice);
+  SharedMemoryTransport client(segmentName(), Endpoint::kClient, std::chrono::milliseconds(10));
+
+  uint32_t state = 0;
+  std::chrono::system_clock::time_point receive_time;
+  EXPECT_FALSE(client.wait(std::chrono::microseconds(100)));
+  EXPECT_THROW(client.receive(reinterpret_cast<uint8_t*>(&state), sizeof(state), &receive_time),
+               franka::NetworkException);
+
+  uint64_t large_state = 0;
+  device.send(reinterpret_cast<const uint8_t*>(&large_state), sizeof(large_state));
+  EXPECT_THROW(client.receive(reinterpret_cast<uint8_t*>(&state), sizeof(state), &receive_time),
+               franka::ProtocolException);
+}
@@ -0,0 +1,199 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+#include <franka/exception.h>
+#include <franka/model.h>
+#include <franka/robot.h>
+#include <franka/simulated_robot.h>
+
+#include "model_library_interface.h"
+
+using franka::Duration;
+using franka::RobotState;
+
+namespace {
+
+// Arm with unit mass matrix, without Coriolis forces and gravity, whose end effector is at the
+// origin.
+struct UnitMassModel : public ModelLibraryInterface {
+  void Ji_J_J1(double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J2(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J3(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J4(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J5(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J6(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J7(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J8(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void Ji_J_J9(const double*, const double*, double* output) override {
+    std::fill_n(output, 42, 0);
+  }
+
+  void M_NE(const double*, const double*, double, const double*, double* output) override {
+    std::fill_n(output, 49, 0);
+    for (size_t i = 0; i < 7; i++) {
+      output[i * 8] = 1;
+    }
+  }
+
+  void O_J_J1(double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J2(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J3(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J4(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J5(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J6(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J7(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J8(const double*, double* output) override { std::fill_n(output, 42, 0); }
+  void O_J_J9(const double*, const double*, double* output) override {
+    std::fill_n(output, 42, 0);
+  }
+
+  void O_T_J1(const double*, double* output) override { identity(output); }
+  void O_T_J2(const double*, double* output) override { identity(output); }
+  void O_T_J3(const double*, double* output) override { identity(output); }
+  void O_T_J4(const double*, double* output) override { identity(output); }
+  void O_T_J5(const double*, double* output) override { identity(output); }
+  void O_T_J6(const double*, double* output) override { identity(output); }
+  void O_T_J7(const double*, double* output) override { identity(output); }
+  void O_T_J8(const double*, double* output) override { identity(output); }
+  void O_T_J9(const double*, const double*, double* output) override { identity(output); }
+
+  void c_NE(const double*, const double*, const double*, double, const double*, double* output)
+      override {
+    std::fill_n(output, 7, 0);
+  }
+
+  void g_NE(const double*, const double*, double, const double*, double* output) override {
+    std::fill_n(output, 7, 0);
+  }
+
+  static void identity(double* output) {
+    std::fill_n(output, 16, 0);
+    output[0] = output[5] = output[10] = output[15] = 1;
+  }
+};
+
+struct SimulatedRobot : public ::testing::Test {
+  SimulatedRobot() { model_library_interface = &model; }
+  ~SimulatedRobot() override { model_library_interface = nullptr; }
+
+  UnitMassModel model;
+  franka::SimulatedRobot simulation{FRANKA_TEST_BINARY_DIR "/libfcimodels.so"};
+};
+
+}  // anonymous namespace
+
+TEST(SimulatedRobotConstruction, ThrowsIfModelLibraryIsMissing) {
+  EXPECT_THROW(franka::SimulatedRobot("/nonexistent/libfcimodels.so"), franka::ModelException);
+}
+
+TEST_F(SimulatedRobot, CanReadRobotState) {
+  franka::Robot robot(simulation);
+  franka::SimulationParameters parameters;
+
+  RobotState first_state = robot.readOnce();
+  RobotState second_state = robot.readOnce();
+  EXPECT_EQ(franka::RobotMode::kIdle, first_state.robot_mode);
+  EXPECT_EQ(parameters.q_start, first_state.q);
+  EXPECT_EQ(first_state.time.toMSec() + 1, second_state.time.toMSec());
+  EXPECT_EQ(second_state.time.toMSec(), simulation.steps());
+}
+
+TEST_F(SimulatedRobot, AcceleratesArmWithCommandedTorques) {
+  franka::Robot robot(simulation);
+  franka::SimulationParameters parameters;
+
+  constexpr uint64_t kCycles = 1000;
+  uint64_t cycles = 0;
+  robot.control([&](const RobotState& robot_state, Duration) -> franka::Torques {
+    EXPECT_EQ(franka::RobotMode::kMove, robot_state.robot_mode);
+    franka::Torques torques{{1, 0, 0, 0, 0, 0, 0}};
+    if (++cycles == kCycles) {
+      return franka::MotionFinished(torques);
+    }
+    return torques;
+  });
+
+  // With unit mass, the joint accelerates with 1 rad/s^2 for about one second.
+  RobotState state = simulation.readOnce();
+  EXPECT_EQ(franka::RobotMode::kIdle, state.robot_mode);
+  EXPECT_NEAR(parameters.q_start[0] + 0.5, state.q[0], 0.01);
+  for (size_t i = 1; i < state.q.size(); i++) {
+    EXPECT_DOUBLE_EQ(parameters.q_start[i], state.q[i]);
+  }
+}
+
+TEST_F(SimulatedRobot, AppliesExternalTorques) {
+  franka::Robot robot(simulation);
+  simulation.setExternalTorque({{0, 0, 2, 0, 0, 0, 0}});
+
+  uint64_t cycles = 0;
+  double tau_ext = 0;
+  robot.control([&](const RobotState& robot_state, Duration) -> franka::Torques {
+    tau_ext = robot_state.tau_ext_hat_filtered[2];
+    franka::Torques torques{{0, 0, 0, 0, 0, 0, 0}};
+    if (++cycles == 100) {
+      return franka::MotionFinished(torques);
+    }
+    return torques;
+  });
+
+  EXPECT_EQ(2, tau_ext);
+  EXPECT_GT(simulation.readOnce().q[2], franka::SimulationParameters().q_start[2]);
+}
+
+TEST_F(SimulatedRobot, FollowsJointPositionMotion) {
+  franka::Robot robot(simulation);
+
+  std::array<double, 7> q_goal{};
+  robot.control([&](const RobotState& robot_state, Duration duration) -> franka::JointPositions {
+    static double time = 0;
+    static std::array<double, 7> q_start;
+    if (duration.toMSec() == 0) {
+      time = 0;
+      q_start = robot_state.q_d;
+    }
+    time += duration.toSec();
+
+    franka::JointPositions positions(q_start);
+    positions.q[6] += 0.1 * (1 - std::cos(M_PI * std::min(time, 1.0))) / 2;
+    q_goal = positions.q;
+    if (time >= 1.0) {
+      return franka::MotionFinished(positions);
+    }
+    return positions;
+  });
+
+  RobotState state = simulation.readOnce();
+  for (size_t i = 0; i < state.q.size(); i++) {
+    EXPECT_NEAR(q_goal[i], state.q[i], 1e-9);
+  }
+}
+
+TEST_F(SimulatedRobot, RunsFasterThanRealTime) {
+  franka::Robot robot(simulation);
+
+  constexpr uint64_t kCycles = 10000;
+  uint64_t cycles = 0;
+  auto start = std::chrono::steady_clock::now();
+  robot.control([&](const RobotState&, Duration) -> franka::Torques {
+    franka::Torques torques{{0, 0, 0, 0, 0, 0, 0}};
+    if (++cycles == kCycles) {
+      return franka::MotionFinished(torques);
+    }
+    return torques;
+  });
+
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+  EXPECT_GE(simulation.steps(), kCycles);
+}
+
+TEST_F(SimulatedRobot, ServesModelLibrary) {
+  franka::Robot robot(simulation);
+  EXPECT_NO_THROW(robot.loadModel());
+}
@@ -0,0 +1,199 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/spline_trajectory.h>
+
+using franka::CartesianSplineTrajectory;
+using franka::SplineTrajectory;
+using franka::SplineType;
+
+namespace {
+
+const std::vector<double> kTimes{0.0, 0.4, 1.0, 1.3, 2.0};
+const std::vector<std::array<double, 7>> kPoints{
+    {{0.0, -0.785, 0.0, -2.356, 0.0, 1.571, 0.785}},
+    {{0.2, -0.6, 0.1, -2.2, 0.1, 1.6, 0.9}},
+    {{0.5, -0.7, 0.15, -2.0, 0.3, 1.4, 1.0}},
+    {{0.4, -0.5, 0.3, -1.9, 0.4, 1.5, 1.2}},
+    {{0.1, -0.6, 0.2, -2.1, 0.2, 1.7, 1.0}},
+};
+
+std::array<double, 16> pose(double angle, double x, double y, double z) {
+  return {{std::cos(angle), std::sin(angle), 0, 0, -std::sin(angle), std::cos(angle), 0, 0, 0, 0, 1,
+           0, x, y, z, 1}};
+}
+
+class SplineTrajectoryTest : public ::testing::TestWithParam<SplineType> {};
+
+}  // anonymous namespace
+
+TEST_P(SplineTrajectoryTest, PassesThroughPointsAndStartsAndEndsAtRest) {
+  SplineTrajectory spline(kTimes, kPoints, GetParam());
+  EXPECT_EQ(GetParam(), spline.type());
+  EXPECT_EQ(4u, spline.segmentCount());
+  EXPECT_EQ(2.0, spline.duration());
+
+  for (size_t k = 0; k < kTimes.size(); k++) {
+    std::array<double, 7> q;
+    spline.evaluate(kTimes[k], &q);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_NEAR(kPoints[k][i], q[i], 1e-12) << "point " << k;
+    }
+  }
+
+  std::array<double, 7> q, dq, ddq;
+  for (double t : {0.0, 2.0}) {
+    spline.evaluate(t, &q, &dq, &ddq);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_NEAR(0.0, dq[i], 1e-12);
+      if (GetParam() == SplineType::kQuintic) {
+        EXPECT_NEAR(0.0, ddq[i], 1e-12);
+      }
+    }
+  }
+}
+
+TEST_P(SplineTrajectoryTest, HasContinuousDerivatives) {
+  SplineTrajectory spline(kTimes, kPoints, GetParam());
+  constexpr double kEpsilon = 1e-7;
+  for (size_t k = 1; k + 1 < kTimes.size(); k++) {
+    std::array<double, 7> q_before, dq_before, ddq_before;
+    std::array<double, 7> q_after, dq_after, ddq_after;
+    spline.evaluate(kTimes[k] - kEpsilon, &q_before, &dq_before, &ddq_before);
+    spline.evaluate(kTimes[k] + kEpsilon, &q_after, &dq_after, &ddq_after);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_NEAR(dq_before[i], dq_after[i], 1e-5) << "point " << k;
+      EXPECT_NEAR(ddq_before[i], ddq_after[i], 1e-4) << "point " << k;
+    }
+
+    if (GetParam() == SplineType::kQuintic) {
+      // Jerk from one-sided differences of the acceleration.
+      constexpr double kDeltaT = 1e-5;
+      std::array<double, 7> ddq, ddq_left, ddq_right;
+      spline.evaluate(kTimes[k], &q_before, &dq_before, &ddq);
+      spline.evaluate(kTimes[k] - kDeltaT, &q_before, &dq_before, &ddq_left);
+      spline.evaluate(kTimes[k] + kDeltaT, &q_after, &dq_after, &ddq_right);
+      for (size_t i = 0; i < 7; i++) {
+        EXPECT_NEAR((ddq[i] - ddq_left[i]) / kDeltaT, (ddq_right[i] - ddq[i]) / kDeltaT, 1e-2)
+            << "point " << k;
+      }
+    }
+  }
+}
+
+TEST_P(SplineTrajectoryTest, DerivativesMatchFiniteDifferences) {
+  SplineTrajectory spline(kTimes, kPoints, GetParam());
+  constexpr double kDeltaT = 1e-6;
+  for (double t = 0.05; t < 2.0; t += 0.1) {
+    std::array<double, 7> q_minus, dq_minus, q_plus, dq_plus, q, dq, ddq;
+    spline.evaluate(t - kDeltaT, &q_minus, &dq_minus);
+    spline.evaluate(t + kDeltaT, &q_plus, &dq_plus);
+    spline.evaluate(t, &q, &dq, &ddq);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_NEAR((q_plus[i] - q_minus[i]) / (2 * kDeltaT), dq[i], 1e-6) << "t = " << t;
+      EXPECT_NEAR((dq_plus[i] - dq_minus[i]) / (2 * kDeltaT), ddq[i], 1e-5) << "t = " << t;
+    }
+  }
+}
+
+TEST_P(SplineTrajectoryTest, ClampsTimeAndFinishesMotion) {
+  SplineTrajectory spline(kTimes, kPoints, GetParam());
+  EXPECT_EQ(kPoints.front(), spline.jointPositions(-1.0).q);
+  EXPECT_FALSE(spline.jointPositions(1.0).motion_finished);
+
+  franka::JointPositions end = spline.jointPositions(3.0);
+  EXPECT_TRUE(end.motion_finished);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(kPoints.back()[i], end.q[i], 1e-12);
+  }
+}
+
+TEST_P(SplineTrajectoryTest, FitsManyPoints) {
+  std::vector<double> times;
+  std::vector<std::array<double, 7>> points;
+  for (size_t k = 0; k < 1000; k++) {
+    times.push_back(0.01 * k);
+    std::array<double, 7> point;
+    for (size_t i = 0; i < 7; i++) {
+      point[i] = std::sin(0.01 * k * (i + 1));
+    }
+    points.push_back(point);
+  }
+  SplineTrajectory spline(times, points, GetParam());
+  EXPECT_EQ(999u, spline.segmentCount());
+
+  std::array<double, 7> q;
+  spline.evaluate(5.005, &q);
+  for (size_t i = 0; i < 7; i++) {
+    EXPECT_NEAR(std::sin(5.005 * (i + 1)), q[i], 1e-5);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(SplineTypes,
+                        SplineTrajectoryTest,
+                        ::testing::Values(SplineType::kCubic, SplineType::kQuintic));
+
+TEST(SplineTrajectory, ThrowsForInvalidInput) {
+  EXPECT_THROW(SplineTrajectory({0.0}, {kPoints[0]}), std::invalid_argument);
+  EXPECT_THROW(SplineTrajectory({0.0, 1.0}, kPoints), std::invalid_argument);
+  EXPECT_THROW(SplineTrajectory({0.1, 1.0}, {kPoints[0], kPoints[1]}), std::invalid_argument);
+  EXPECT_THROW(SplineTrajectory({0.0, 0.0}, {kPoints[0], kPoints[1]}), std::invalid_argument);
+  EXPECT_THROW(SplineTrajectory({0.0, NAN}, {kPoints[0], kPoints[1]}), std::invalid_argument);
+  std::array<double, 7> infinite = kPoints[1];
+  infinite[3] = INFINITY;
+  EXPECT_THROW(SplineTrajectory({0.0, 1.0}, {kPoints[0], infinite}), std::invalid_argument);
+
+  std::array<double, 16> scaled = pose(0.0, 0.3, 0.0, 0.5);
+  scaled[0] = 2.0;
+  EXPECT_THROW(CartesianSplineTrajectory({0.0, 1.0}, {pose(0.0, 0.3, 0.0, 0.5), scaled}),
+               std::invalid_argument);
+}
+
+TEST(CartesianSplineTrajectory, InterpolatesPosesAndTwists) {
+  std::vector<double> times{0.0, 1.0, 2.5};
+  // The quaternion of the last rotation has the opposite sign of the one before.
+  std::vector<std::array<double, 16>> poses{pose(0.0, 0.3, 0.0, 0.5), pose(2.5, 0.4, 0.1, 0.5),
+                                            pose(4.5, 0.4, 0.2, 0.4)};
+  CartesianSplineTrajectory spline(times, poses);
+  EXPECT_EQ(2.5, spline.duration());
+
+  for (size_t k = 0; k < times.size(); k++) {
+    std::array<double, 16> O_T_EE;
+    spline.evaluate(times[k], &O_T_EE);
+    for (size_t i = 0; i < 16; i++) {
+      EXPECT_NEAR(poses[k][i], O_T_EE[i], 1e-12) << "pose " << k;
+    }
+  }
+
+  constexpr double kDeltaT = 1e-6;
+  for (double t = 0.1; t < 2.5; t += 0.2) {
+    std::array<double, 16> before, after, O_T_EE;
+    std::array<double, 6> twist;
+    spline.evaluate(t - kDeltaT, &before);
+    spline.evaluate(t + kDeltaT, &after);
+    spline.evaluate(t, &O_T_EE, &twist);
+    for (size_t i = 0; i < 3; i++) {
+      EXPECT_NEAR((after[12 + i] - before[12 + i]) / (2 * kDeltaT), twist[i], 1e-6);
+    }
+    // Rotations are about z only.
+    double angle_rate = std::remainder(std::atan2(after[1], after[0]) -
+                                           std::atan2(before[1], before[0]),
+                                       2 * M_PI) /
+                        (2 * kDeltaT);
+    EXPECT_GT(angle_rate, 0.0);
+    EXPECT_NEAR(0.0, twist[3], 1e-9);
+    EXPECT_NEAR(0.0, twist[4], 1e-9);
+    EXPECT_NEAR(angle_rate, twist[5], 1e-6);
+
+    // The pose is a valid transformation and accepted as command.
+    franka::CartesianPose command = spline.cartesianPose(t);
+    EXPECT_FALSE(command.motion_finished);
+  }
+  EXPECT_TRUE(spline.cartesianPose(2.5).motion_finished);
+}
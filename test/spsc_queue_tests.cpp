@@ -0,0 +1,63 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "spsc_queue.h"
+
+using franka::SpscQueue;
+
+TEST(SpscQueue, RoundsCapacityUpToPowerOfTwo) {
+  SpscQueue<int> queue(5);
+  EXPECT_EQ(8u, queue.capacity());
+}
+
+TEST(SpscQueue, IsFIFO) {
+  SpscQueue<int> queue(4);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+
+  int value = 0;
+  EXPECT_TRUE(queue.pop(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(queue.pop(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(queue.pop(&value));
+}
+
+TEST(SpscQueue, RejectsPushWhenFull) {
+  SpscQueue<int> queue(2);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(3));
+
+  int value = 0;
+  EXPECT_TRUE(queue.pop(&value));
+  EXPECT_TRUE(queue.push(3));
+}
+
+TEST(SpscQueue, TransfersAllValuesBetweenThreads) {
+  constexpr int kCount = 10000;
+  SpscQueue<int> queue(64);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < kCount; i++) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  int value = 0;
+  while (expected < kCount) {
+    if (queue.pop(&value)) {
+      ASSERT_EQ(expected, value);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
@@ -0,0 +1,175 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <franka/exception.h>
+#include <franka/state_broadcast.h>
+#include <research_interface/robot/rbk_types.h>
+
+#include "helpers.h"
+#include "state_broadcast_segment.h"
+
+using namespace ::testing;             // NOLINT(google-build-using-namespace)
+using namespace std::chrono_literals;  // NOLINT(google-build-using-namespace)
+
+using franka::PublishedState;
+using franka::StateBroadcaster;
+using franka::StateSubscriber;
+
+namespace {
+
+std::string segmentName() {
+  return "/libfranka_state_broadcast_test_" + std::to_string(getpid());
+}
+
+void broadcast(StateBroadcaster& broadcaster, uint32_t message_id) {
+  research_interface::robot::RobotState robot_state{};
+  robot_state.message_id = message_id;
+  robot_state.q.fill(static_cast<double>(message_id));
+  franka::broadcastRawState(broadcaster, robot_state, research_interface::robot::RobotCommand{},
+                            std::chrono::steady_clock::time_point());
+}
+
+}  // anonymous namespace
+
+TEST(StateBroadcast, ThrowsIfSegmentDoesNotExist) {
+  EXPECT_THROW(StateSubscriber{segmentName()}, franka::NetworkException);
+}
+
+TEST(StateBroadcast, ThrowsIfSegmentIsNotResized) {
+  // State between shm_open and ftruncate on the broadcaster side.
+  int file = shm_open(segmentName().c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  ASSERT_GE(file, 0);
+  EXPECT_THROW(StateSubscriber{segmentName()}, franka::NetworkException);
+  close(file);
+  shm_unlink(segmentName().c_str());
+}
+
+TEST(StateBroadcast, ReadsTimeOutIfBroadcasterStopsWhileWriting) {
+  StateBroadcaster broadcaster(segmentName());
+  StateSubscriber subscriber(segmentName());
+  broadcast(broadcaster, 1);
+
+  // Leaves the slot of the broadcast state in the state of a write in progress.
+  int file = shm_open(segmentName().c_str(), O_RDWR, 0);
+  ASSERT_GE(file, 0);
+  void* address = mmap(nullptr, sizeof(franka::BroadcastSegment), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, file, 0);
+  close(file);
+  ASSERT_NE(MAP_FAILED, address);
+  static_cast<franka::BroadcastSegment*>(address)->slots[0].version++;
+
+  PublishedState state;
+  EXPECT_FALSE(subscriber.readLatest(&state, 1ms));
+  EXPECT_FALSE(subscriber.readNext(&state, 1ms));
+
+  static_cast<franka::BroadcastSegment*>(address)->slots[0].version++;
+  EXPECT_TRUE(subscriber.readNext(&state, 1ms));
+  EXPECT_EQ(0u, state.sequence);
+  munmap(address, sizeof(franka::BroadcastSegment));
+}
+
+TEST(StateBroadcast, BroadcastsRawStates) {
+  StateBroadcaster broadcaster(segmentName());
+  EXPECT_EQ(segmentName(), broadcaster.name());
+  StateSubscriber subscriber(segmentName());
+
+  PublishedState state;
+  EXPECT_FALSE(subscriber.readLatest(&state));
+  EXPECT_EQ(0u, subscriber.publishedStates());
+
+  research_interface::robot::RobotState raw_state;
+  randomRobotState(raw_state);
+  research_interface::robot::RobotCommand raw_command;
+  randomRobotCommand(raw_command);
+  auto host_time = std::chrono::steady_clock::time_point(123456789ns);
+  franka::broadcastRawState(broadcaster, raw_state, raw_command, host_time);
+  EXPECT_EQ(1u, broadcaster.publishedStates());
+  EXPECT_EQ(1u, subscriber.publishedStates());
+
+  ASSERT_TRUE(subscriber.readLatest(&state));
+  EXPECT_EQ(0u, state.sequence);
+  testRobotStatesAreEqual(raw_state, state.robot_state);
+  EXPECT_EQ(host_time, state.robot_state.host_time);
+  EXPECT_EQ(raw_command.motion.q_c, state.command.joint_positions.q);
+  EXPECT_EQ(raw_command.motion.O_T_EE_c, state.command.cartesian_pose.O_T_EE);
+  EXPECT_EQ(raw_command.control.tau_J_d, state.command.torques.tau_J);
+}
+
+TEST(StateBroadcast, ReadsEveryStateAndCountsLostStates) {
+  StateBroadcaster broadcaster(segmentName());
+  broadcast(broadcaster, 1);
+  // Only states broadcast after subscribing are read.
+  StateSubscriber subscriber(segmentName());
+
+  PublishedState state;
+  EXPECT_FALSE(subscriber.readNext(&state, 0us));
+  for (uint32_t i = 2; i <= 4; i++) {
+    broadcast(broadcaster, i);
+  }
+  for (uint64_t i = 1; i <= 3; i++) {
+    ASSERT_TRUE(subscriber.readNext(&state, 0us));
+    EXPECT_EQ(i, state.sequence);
+    EXPECT_THAT(state.robot_state.q, Each(static_cast<double>(i + 1)));
+  }
+  EXPECT_FALSE(subscriber.readNext(&state, 0us));
+  EXPECT_EQ(0u, subscriber.lostStates());
+
+  for (uint32_t i = 5; i < 5 + StateBroadcaster::kCapacity + 10; i++) {
+    broadcast(broadcaster, i);
+  }
+  ASSERT_TRUE(subscriber.readNext(&state, 0us));
+  EXPECT_EQ(14u, state.sequence);
+  EXPECT_EQ(10u, subscriber.lostStates());
+
+  ASSERT_TRUE(subscriber.readLatest(&state));
+  EXPECT_EQ(StateBroadcaster::kCapacity + 13, state.sequence);
+  EXPECT_FALSE(subscriber.readNext(&state, 0us));
+}
+
+TEST(StateBroadcast, SubscribersAlwaysSeeConsistentStates) {
+  constexpr uint32_t kCount = 20000;
+  StateBroadcaster broadcaster(segmentName());
+  StateSubscriber subscriber(segmentName());
+  std::atomic<bool> done{false};
+
+  std::thread writer([&] {
+    for (uint32_t i = 1; i <= kCount; i++) {
+      broadcast(broadcaster, i);
+    }
+    done = true;
+  });
+
+  PublishedState state;
+  uint64_t last_sequence = 0;
+  uint64_t read = 0;
+  while (true) {
+    bool finished = done;
+    if (!subscriber.readNext(&state, 1ms)) {
+      if (finished) {
+        break;
+      }
+      continue;
+    }
+    EXPECT_THAT(state.robot_state.q, Each(static_cast<double>(state.sequence + 1)));
+    EXPECT_EQ(state.sequence + 1, state.robot_state.time.toMSec());
+    if (read > 0) {
+      EXPECT_LT(last_sequence, state.sequence);
+    }
+    last_sequence = state.sequence;
+    read++;
+  }
+  writer.join();
+
+  EXPECT_EQ(kCount, read + subscriber.lostStates());
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/state_prediction.h>
+
+using namespace ::testing;
+
+using franka::Duration;
+using franka::RobotState;
+using franka::TransportDelayEstimator;
+
+namespace {
+
+std::array<double, 49> diagonalMass(double value) {
+  std::array<double, 49> mass{};
+  for (size_t i = 0; i < 7; i++) {
+    mass[8 * i] = value;
+  }
+  return mass;
+}
+
+}  // anonymous namespace
+
+TEST(TransportDelayEstimator, CountsLostStates) {
+  TransportDelayEstimator estimator(0.5);
+  RobotState robot_state;
+
+  estimator.update(robot_state, Duration());
+  EXPECT_EQ(0u, estimator.lostStates());
+  EXPECT_EQ(0.0, estimator.predictedDelay());
+
+  estimator.update(robot_state, Duration(1));
+  EXPECT_EQ(0u, estimator.lastGap());
+  estimator.update(robot_state, Duration(3));
+  EXPECT_EQ(2u, estimator.lastGap());
+  EXPECT_EQ(2u, estimator.lostStates());
+  EXPECT_NEAR(1.0 / 3.0, estimator.lostStateRatio(), 1e-12);
+  EXPECT_NEAR(1e-3 * 0.5, estimator.predictedDelay(), 1e-12);
+
+  estimator.update(robot_state, Duration(1));
+  EXPECT_EQ(0u, estimator.lastGap());
+  EXPECT_EQ(2u, estimator.lostStates());
+  EXPECT_NEAR(1.0 / 6.0, estimator.lostStateRatio(), 1e-12);
+
+  estimator.reset();
+  EXPECT_EQ(0u, estimator.lostStates());
+  EXPECT_EQ(0.0, estimator.lostStateRatio());
+}
+
+TEST(TransportDelayEstimator, UsesControlCommandSuccessRate) {
+  TransportDelayEstimator estimator;
+  RobotState robot_state;
+
+  robot_state.control_command_success_rate = 0.8;
+  estimator.update(robot_state, Duration(1));
+  EXPECT_NEAR(0.2, estimator.lossProbability(), 1e-12);
+  EXPECT_NEAR(1e-3 * 0.25, estimator.predictedDelay(), 1e-12);
+
+  // A success rate of zero is not known yet and keeps the previous value.
+  robot_state.control_command_success_rate = 0;
+  estimator.update(robot_state, Duration(1));
+  EXPECT_NEAR(0.2, estimator.lossProbability(), 1e-12);
+
+  robot_state.control_command_success_rate = 0.01;
+  estimator.update(robot_state, Duration(1));
+  EXPECT_EQ(TransportDelayEstimator::kMaxLossProbability, estimator.lossProbability());
+  EXPECT_NEAR(9e-3, estimator.predictedDelay(), 1e-12);
+}
+
+TEST(TransportDelayEstimator, ThrowsOnInvalidSmoothing) {
+  EXPECT_THROW(TransportDelayEstimator(0), std::invalid_argument);
+  EXPECT_THROW(TransportDelayEstimator(1.5), std::invalid_argument);
+  EXPECT_NO_THROW(TransportDelayEstimator(1));
+}
+
+TEST(PredictJointState, IntegratesAccelerationFromCommandedTorque) {
+  RobotState robot_state;
+  robot_state.q = {{0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6}};
+  robot_state.dq = {{1, 1, 1, 1, 1, 1, 1}};
+  robot_state.tau_J_d = {{2, 4, 6, 8, 10, 12, 14}};
+  std::array<double, 7> coriolis{{2, 2, 2, 2, 2, 2, 2}};
+
+  constexpr double kHorizon = 0.002;
+  RobotState predicted = robot_state;
+  ASSERT_TRUE(franka::predictJointState(diagonalMass(2), coriolis, kHorizon, &predicted));
+  for (size_t i = 0; i < 7; i++) {
+    double ddq = (robot_state.tau_J_d[i] - coriolis[i]) / 2;
+    EXPECT_NEAR(ddq, predicted.ddq_hat[i], 1e-12);
+    EXPECT_NEAR(robot_state.dq[i] + ddq * kHorizon, predicted.dq[i], 1e-12);
+    EXPECT_NEAR(robot_state.q[i] + robot_state.dq[i] * kHorizon + 0.5 * ddq * kHorizon * kHorizon,
+                predicted.q[i], 1e-12);
+  }
+  EXPECT_EQ(robot_state.tau_J_d, predicted.tau_J_d);
+}
+
+TEST(PredictJointState, KeepsStateForInvalidInput) {
+  RobotState robot_state;
+  robot_state.q = {{1, 2, 3, 4, 5, 6, 7}};
+  robot_state.dq = {{1, 1, 1, 1, 1, 1, 1}};
+
+  RobotState predicted = robot_state;
+  EXPECT_FALSE(franka::predictJointState(diagonalMass(1), {}, 0.0, &predicted));
+  EXPECT_FALSE(franka::predictJointState(diagonalMass(-1), {}, 0.001, &predicted));
+  EXPECT_EQ(robot_state.q, predicted.q);
+  EXPECT_EQ(robot_state.dq, predicted.dq);
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/state_publisher.h>
+#include <research_interface/robot/rbk_types.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::PublishedState;
+using franka::RobotCommand;
+using franka::RobotState;
+using franka::StatePublisher;
+
+TEST(StatePublisher, HasNoStateInitially) {
+  StatePublisher publisher;
+  PublishedState state;
+  state.sequence = 42;
+  EXPECT_FALSE(publisher.read(&state));
+  EXPECT_EQ(42u, state.sequence);
+  EXPECT_EQ(0u, publisher.publishedStates());
+}
+
+TEST(StatePublisher, ReadsLatestState) {
+  StatePublisher publisher;
+  for (uint64_t i = 0; i < 20; i++) {
+    RobotState robot_state;
+    robot_state.time = franka::Duration(i);
+    robot_state.q.fill(static_cast<double>(i));
+    RobotCommand command;
+    command.torques.tau_J.fill(static_cast<double>(2 * i));
+    EXPECT_TRUE(publisher.publish(robot_state, command));
+  }
+  EXPECT_EQ(20u, publisher.publishedStates());
+  EXPECT_EQ(0u, publisher.droppedStates());
+
+  PublishedState state;
+  ASSERT_TRUE(publisher.read(&state));
+  EXPECT_EQ(19u, state.sequence);
+  EXPECT_EQ(franka::Duration(19), state.robot_state.time);
+  EXPECT_THAT(state.robot_state.q, Each(19.0));
+  EXPECT_THAT(state.command.torques.tau_J, Each(38.0));
+
+  // Reading does not consume the state.
+  PublishedState again;
+  ASSERT_TRUE(publisher.read(&again));
+  EXPECT_EQ(19u, again.sequence);
+}
+
+TEST(StatePublisher, PublishesRawStates) {
+  StatePublisher publisher;
+  research_interface::robot::RobotState raw_state;
+  randomRobotState(raw_state);
+  research_interface::robot::RobotCommand raw_command;
+  randomRobotCommand(raw_command);
+
+  franka::publishRawState(publisher, raw_state, raw_command);
+
+  PublishedState state;
+  ASSERT_TRUE(publisher.read(&state));
+  testRobotStatesAreEqual(raw_state, state.robot_state);
+  EXPECT_EQ(raw_command.motion.q_c, state.command.joint_positions.q);
+  EXPECT_EQ(raw_command.motion.O_T_EE_c, state.command.cartesian_pose.O_T_EE);
+  EXPECT_EQ(raw_command.control.tau_J_d, state.command.torques.tau_J);
+}
+
+TEST(StatePublisher, ReadersAlwaysSeeConsistentStates) {
+  constexpr uint64_t kCount = 20000;
+  StatePublisher publisher;
+  std::atomic<bool> done{false};
+  std::atomic<bool> consistent{true};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&]() {
+      PublishedState state;
+      uint64_t last_sequence = 0;
+      while (!done) {
+        if (!publisher.read(&state)) {
+          continue;
+        }
+        double expected = static_cast<double>(state.sequence);
+        for (size_t j = 0; j < 7; j++) {
+          if (state.robot_state.q[j] != expected || state.robot_state.tau_J[j] != expected ||
+              state.command.torques.tau_J[j] != expected) {
+            consistent = false;
+          }
+        }
+        if (state.sequence < last_sequence ||
+            state.robot_state.time != franka::Duration(state.sequence)) {
+          consistent = false;
+        }
+        last_sequence = state.sequence;
+      }
+    });
+  }
+
+  RobotState robot_state;
+  RobotCommand command;
+  uint64_t published = 0;
+  while (published < kCount) {
+    // Dropped states keep their sequence number.
+    double value = static_cast<double>(published);
+    robot_state.time = franka::Duration(published);
+    robot_state.q.fill(value);
+    robot_state.tau_J.fill(value);
+    command.torques.tau_J.fill(value);
+    if (publisher.publish(robot_state, command)) {
+      published++;
+    }
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_TRUE(consistent);
+  EXPECT_EQ(kCount, publisher.publishedStates());
+}
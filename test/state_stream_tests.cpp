@@ -0,0 +1,70 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <franka/exception.h>
+#include <franka/robot.h>
+#include <franka/state_stream.h>
+
+#include "helpers.h"
+#include "mock_server.h"
+
+using franka::InvalidOperationException;
+using franka::PublishedState;
+using franka::RealtimeConfig;
+using franka::Robot;
+using franka::StatePublisher;
+using franka::StateStream;
+
+TEST(StateStream, PublishesDecimatedStatesToSubscribers) {
+  RobotMockServer server;
+  Robot robot("127.0.0.1", RealtimeConfig::kIgnore);
+
+  std::atomic_bool send(true);
+  server
+      .doForever([&]() {
+        if (send) {
+          server.sendEmptyState<research_interface::robot::RobotState>();
+          std::this_thread::yield();
+        }
+        return send.load();
+      })
+      .spinOnce();
+
+  auto every_state = std::make_shared<StatePublisher>();
+  auto decimated = std::make_shared<StatePublisher>();
+  StateStream stream(robot);
+  stream.subscribe(every_state);
+  stream.subscribe(decimated, 10);
+  EXPECT_THROW(stream.subscribe(nullptr), std::invalid_argument);
+  EXPECT_THROW(stream.subscribe(decimated, 0), std::invalid_argument);
+
+  stream.start();
+  EXPECT_TRUE(stream.running());
+  EXPECT_THROW(stream.start(), InvalidOperationException);
+  EXPECT_THROW(stream.subscribe(decimated), InvalidOperationException);
+  EXPECT_THROW(robot.readOnce(), InvalidOperationException);
+
+  while (stream.receivedStates() < 50) {
+    std::this_thread::yield();
+  }
+  stream.stop();
+  send = false;
+  EXPECT_FALSE(stream.running());
+
+  EXPECT_EQ(stream.receivedStates(), every_state->publishedStates());
+  EXPECT_GT(decimated->publishedStates(), 0u);
+  EXPECT_LT(decimated->publishedStates(), every_state->publishedStates());
+
+  PublishedState latest;
+  PublishedState latest_decimated;
+  ASSERT_TRUE(every_state->read(&latest));
+  ASSERT_TRUE(decimated->read(&latest_decimated));
+  EXPECT_GE(latest.robot_state.time.toMSec(), latest_decimated.robot_state.time.toMSec());
+  EXPECT_LT(latest.robot_state.time.toMSec(), latest_decimated.robot_state.time.toMSec() + 10);
+}
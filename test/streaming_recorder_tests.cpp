@@ -0,0 +1,209 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/streaming_recorder.h>
+
+#include "helpers.h"
+
+using franka::StreamingRecorder;
+
+namespace {
+
+struct Field {
+  std::string name;
+  uint32_t type;
+  uint32_t offset;
+  uint32_t count;
+};
+
+struct Recording {
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t record_size;
+  std::vector<Field> fields;
+  std::vector<char> data;
+
+  size_t records() const { return (data.size() - header_size) / record_size; }
+
+  const Field* field(const std::string& name) const {
+    for (const Field& field : fields) {
+      if (field.name == name) {
+        return &field;
+      }
+    }
+    return nullptr;
+  }
+
+  template <size_t N>
+  std::array<double, N> doubles(size_t record, const std::string& name) const {
+    std::array<double, N> values;
+    const Field* descriptor = field(name);
+    EXPECT_NE(nullptr, descriptor);
+    EXPECT_EQ(N, descriptor->count);
+    std::memcpy(values.data(), data.data() + header_size + record * record_size + descriptor->offset,
+                sizeof(values));
+    return values;
+  }
+
+  uint64_t uint64(size_t record, const std::string& name) const {
+    uint64_t value;
+    std::memcpy(&value, data.data() + header_size + record * record_size + field(name)->offset,
+                sizeof(value));
+    return value;
+  }
+};
+
+Recording readRecording(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  Recording recording{};
+  recording.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  EXPECT_EQ(0, std::memcmp(recording.data.data(), "FRANKREC", 8));
+
+  uint32_t field_count;
+  std::memcpy(&recording.version, recording.data.data() + 8, sizeof(uint32_t));
+  std::memcpy(&recording.header_size, recording.data.data() + 12, sizeof(uint32_t));
+  std::memcpy(&recording.record_size, recording.data.data() + 16, sizeof(uint32_t));
+  std::memcpy(&field_count, recording.data.data() + 20, sizeof(uint32_t));
+  for (uint32_t i = 0; i < field_count; i++) {
+    const char* descriptor = recording.data.data() + 24 + i * 64;
+    Field field;
+    field.name = std::string(descriptor);
+    std::memcpy(&field.type, descriptor + 48, sizeof(uint32_t));
+    std::memcpy(&field.offset, descriptor + 52, sizeof(uint32_t));
+    std::memcpy(&field.count, descriptor + 56, sizeof(uint32_t));
+    recording.fields.push_back(field);
+  }
+  return recording;
+}
+
+}  // anonymous namespace
+
+TEST(StreamingRecorder, WritesHeaderAndRecords) {
+  const std::string path = "streaming_recorder_test.bin";
+  std::vector<franka::RobotState> states(10);
+  std::vector<franka::RobotCommand> commands(10);
+  {
+    StreamingRecorder recorder(path);
+    for (size_t i = 0; i < states.size(); i++) {
+      randomRobotState(states[i]);
+      commands[i].torques.tau_J = std::array<double, 7>{{1, 2, 3, 4, 5, 6, static_cast<double>(i)}};
+      EXPECT_TRUE(recorder.record(states[i], commands[i]));
+    }
+    recorder.stop();
+    EXPECT_EQ(states.size(), recorder.writtenSamples());
+    EXPECT_EQ(0u, recorder.droppedSamples());
+  }
+
+  Recording recording = readRecording(path);
+  std::remove(path.c_str());
+
+  EXPECT_EQ(StreamingRecorder::kFormatVersion, recording.version);
+  EXPECT_EQ(0u, recording.header_size % 64);
+  ASSERT_EQ(states.size(), recording.records());
+  ASSERT_NE(nullptr, recording.field("q"));
+  EXPECT_EQ(1u, recording.field("q")->type);
+  ASSERT_NE(nullptr, recording.field("time"));
+  EXPECT_EQ(0u, recording.field("time")->type);
+
+  for (size_t i = 0; i < states.size(); i++) {
+    EXPECT_EQ(states[i].time.toMSec(), recording.uint64(i, "time"));
+    EXPECT_EQ(states[i].q, recording.doubles<7>(i, "q"));
+    EXPECT_EQ(states[i].O_T_EE, recording.doubles<16>(i, "O_T_EE"));
+    EXPECT_EQ(commands[i].torques.tau_J, recording.doubles<7>(i, "command_tau_J"));
+    EXPECT_EQ(commands[i].cartesian_pose.O_T_EE, recording.doubles<16>(i, "command_O_T_EE"));
+  }
+}
+
+TEST(StreamingRecorder, DropsSamplesAfterStop) {
+  const std::string path = "streaming_recorder_stop_test.bin";
+  StreamingRecorder recorder(path);
+  recorder.stop();
+
+  EXPECT_FALSE(recorder.record(franka::RobotState(), franka::RobotCommand()));
+  EXPECT_EQ(1u, recorder.droppedSamples());
+  EXPECT_EQ(0u, recorder.writtenSamples());
+  std::remove(path.c_str());
+}
+
+TEST(StreamingRecorder, CountsEverySampleRecordedWhileStopping) {
+  const std::string path = "streaming_recorder_concurrent_stop_test.bin";
+  StreamingRecorder recorder(path);
+  std::atomic<bool> started{false};
+  uint64_t recorded = 0;
+  std::thread producer([&]() {
+    franka::RobotState state;
+    franka::RobotCommand command;
+    do {
+      recorder.record(state, command);
+      recorded++;
+      started = true;
+    } while (recorder.droppedSamples() == 0 || recorded < 1000);
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  recorder.stop();
+  producer.join();
+
+  EXPECT_EQ(recorded, recorder.writtenSamples() + recorder.droppedSamples());
+  EXPECT_EQ(recorder.writtenSamples(), readRecording(path).records());
+  std::remove(path.c_str());
+}
+
+TEST(StreamingRecorder, ThrowsIfFileCannotBeOpened) {
+  EXPECT_THROW(StreamingRecorder("/nonexistent/directory/recording.bin"), franka::Exception);
+}
+
+TEST(StreamingRecorder, ConvertsRecordingToArrow) {
+  const std::string path = "streaming_recorder_arrow_test.bin";
+  const std::string arrow_path = "streaming_recorder_arrow_test.arrow";
+  std::vector<franka::RobotState> states(10);
+  {
+    StreamingRecorder recorder(path);
+    for (size_t i = 0; i < states.size(); i++) {
+      states[i].time = franka::Duration(1000 + i);
+      EXPECT_TRUE(recorder.record(states[i], franka::RobotCommand()));
+    }
+  }
+  franka::recordingToArrow(path, arrow_path);
+  std::ifstream file(arrow_path, std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::remove(path.c_str());
+  std::remove(arrow_path.c_str());
+
+  ASSERT_LT(16u, data.size());
+  EXPECT_EQ(0, std::memcmp(data.data(), "ARROW1\0\0", 8));
+  EXPECT_EQ(0, std::memcmp(data.data() + data.size() - 6, "ARROW1", 6));
+
+  // The time column is stored contiguously.
+  std::vector<uint64_t> times;
+  for (const franka::RobotState& state : states) {
+    times.push_back(state.time.toMSec());
+  }
+  const char* times_data = reinterpret_cast<const char*>(times.data());
+  EXPECT_NE(data.end(), std::search(data.begin(), data.end(), times_data,
+                                    times_data + times.size() * sizeof(uint64_t)));
+}
+
+TEST(StreamingRecorder, ThrowsIfConvertedFileIsNoRecording) {
+  const std::string path = "streaming_recorder_invalid_test.bin";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "This is not a recording, but long enough to contain a header.";
+  }
+  EXPECT_THROW(franka::recordingToArrow(path, "streaming_recorder_invalid_test.arrow"),
+               franka::Exception);
+  std::remove(path.c_str());
+}
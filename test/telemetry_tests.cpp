@@ -0,0 +1,289 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/exception.h>
+#include <franka/state_publisher.h>
+#include <franka/telemetry.h>
+
+#include "allocation_tracker.h"
+
+using franka::Duration;
+using franka::RobotMode;
+using franka::RobotState;
+using franka::StatePublisher;
+using franka::TelemetryDecoder;
+using franka::TelemetryEncoder;
+using franka::TelemetryFields;
+using franka::TelemetryOptions;
+using franka::TelemetryReceiver;
+using franka::TelemetrySender;
+
+namespace {
+
+using Packet = std::array<uint8_t, TelemetryEncoder::kMaxPacketSize>;
+
+RobotState state(uint64_t time) {
+  RobotState robot_state;
+  robot_state.time = Duration(time);
+  double t = 0.001 * time;
+  for (size_t i = 0; i < 7; i++) {
+    robot_state.q[i] = 0.1 * i + 0.2 * std::sin(t + i);
+    robot_state.q_d[i] = robot_state.q[i] + 1e-4;
+    robot_state.dq[i] = 0.2 * std::cos(t + i);
+    robot_state.tau_J[i] = 5.0 * std::sin(2 * t + i);
+    robot_state.tau_ext_hat_filtered[i] = 0.5 * std::cos(t - i);
+  }
+  robot_state.O_T_EE = {1, 0, 0, 0, 0, -1, 0, 0, 0, 0, -1, 0, 0.3 + 0.1 * std::sin(t), 0, 0.5, 1};
+  robot_state.O_F_ext_hat_K = {1.5, -2.25, 3, 0.1, 0.2, -0.3};
+  robot_state.robot_mode = RobotMode::kMove;
+  return robot_state;
+}
+
+template <size_t N>
+void expectNear(const std::array<double, N>& expected,
+                const std::array<double, N>& actual,
+                double resolution) {
+  for (size_t i = 0; i < N; i++) {
+    EXPECT_NEAR(expected[i], actual[i], resolution / 2 + 1e-12) << "at index " << i;
+  }
+}
+
+// Only keyframes can be decoded without earlier packets.
+bool isKeyframe(const Packet& packet, size_t size) {
+  RobotState robot_state;
+  return TelemetryDecoder().decode(packet.data(), size, &robot_state);
+}
+
+void acknowledge(const TelemetryDecoder& decoder, TelemetryEncoder* encoder) {
+  Packet acknowledgement;
+  size_t size = decoder.acknowledgement(acknowledgement.data());
+  ASSERT_NE(0u, size);
+  EXPECT_TRUE(encoder->acknowledge(acknowledgement.data(), size));
+}
+
+}  // anonymous namespace
+
+TEST(TelemetryEncoder, RoundTripsSelectedFieldsWithinResolution) {
+  TelemetryOptions options;
+  options.fields = TelemetryFields::kAll;
+  TelemetryEncoder encoder(options);
+  TelemetryDecoder decoder;
+
+  Packet packet;
+  for (uint64_t time = 0; time < 100; time++) {
+    RobotState expected = state(time);
+    RobotState decoded;
+    size_t size = encoder.encode(expected, packet.data());
+    ASSERT_TRUE(decoder.decode(packet.data(), size, &decoded));
+    acknowledge(decoder, &encoder);
+
+    EXPECT_EQ(expected.time, decoded.time);
+    expectNear(expected.q, decoded.q, options.joint_position_resolution);
+    expectNear(expected.q_d, decoded.q_d, options.joint_position_resolution);
+    expectNear(expected.dq, decoded.dq, options.joint_velocity_resolution);
+    expectNear(expected.tau_J, decoded.tau_J, options.torque_resolution);
+    expectNear(expected.tau_ext_hat_filtered, decoded.tau_ext_hat_filtered,
+               options.torque_resolution);
+    expectNear(expected.O_T_EE, decoded.O_T_EE, options.pose_resolution);
+    expectNear(expected.O_F_ext_hat_K, decoded.O_F_ext_hat_K, options.wrench_resolution);
+    EXPECT_EQ(RobotMode::kMove, decoded.robot_mode);
+  }
+}
+
+TEST(TelemetryEncoder, LeavesUnselectedFieldsUnchanged) {
+  TelemetryOptions options;
+  options.fields = TelemetryFields::kQ;
+  TelemetryEncoder encoder(options);
+  TelemetryDecoder decoder;
+
+  Packet packet;
+  RobotState decoded;
+  decoded.dq = {1, 2, 3, 4, 5, 6, 7};
+  size_t size = encoder.encode(state(5), packet.data());
+  ASSERT_TRUE(decoder.decode(packet.data(), size, &decoded));
+  expectNear(state(5).q, decoded.q, options.joint_position_resolution);
+  EXPECT_EQ((std::array<double, 7>{1, 2, 3, 4, 5, 6, 7}), decoded.dq);
+  EXPECT_EQ(RobotMode::kUserStopped, decoded.robot_mode);
+}
+
+TEST(TelemetryEncoder, SendsDeltasAgainstAcknowledgedPackets) {
+  TelemetryEncoder encoder;
+  TelemetryDecoder decoder;
+  Packet packet;
+  RobotState decoded;
+
+  size_t keyframe_size = encoder.encode(state(0), packet.data());
+  EXPECT_TRUE(isKeyframe(packet, keyframe_size));
+  ASSERT_TRUE(decoder.decode(packet.data(), keyframe_size, &decoded));
+
+  // Without an acknowledgement, the encoder keeps sending keyframes.
+  keyframe_size = encoder.encode(state(1), packet.data());
+  EXPECT_TRUE(isKeyframe(packet, keyframe_size));
+  ASSERT_TRUE(decoder.decode(packet.data(), keyframe_size, &decoded));
+
+  acknowledge(decoder, &encoder);
+  size_t delta_size = encoder.encode(state(2), packet.data());
+  EXPECT_FALSE(isKeyframe(packet, delta_size));
+  EXPECT_LT(2 * delta_size, keyframe_size);
+  ASSERT_TRUE(decoder.decode(packet.data(), delta_size, &decoded));
+  expectNear(state(2).q, decoded.q, TelemetryOptions().joint_position_resolution);
+
+  // Lost packets do not prevent decoding later ones.
+  encoder.encode(state(3), packet.data());
+  size_t size = encoder.encode(state(4), packet.data());
+  ASSERT_TRUE(decoder.decode(packet.data(), size, &decoded));
+  expectNear(state(4).O_T_EE, decoded.O_T_EE, TelemetryOptions().pose_resolution);
+
+  encoder.reset();
+  size = encoder.encode(state(5), packet.data());
+  EXPECT_TRUE(isKeyframe(packet, size));
+}
+
+TEST(TelemetryEncoder, SendsKeyframesIfAcknowledgementsStop) {
+  TelemetryEncoder encoder;
+  TelemetryDecoder decoder;
+  Packet packet;
+  RobotState decoded;
+
+  size_t keyframe_size = encoder.encode(state(0), packet.data());
+  ASSERT_TRUE(decoder.decode(packet.data(), keyframe_size, &decoded));
+  acknowledge(decoder, &encoder);
+
+  for (uint32_t i = 1; i < TelemetryEncoder::kHistorySize; i++) {
+    size_t size = encoder.encode(state(i), packet.data());
+    EXPECT_FALSE(isKeyframe(packet, size));
+  }
+  size_t size = encoder.encode(state(100), packet.data());
+  EXPECT_TRUE(isKeyframe(packet, size));
+}
+
+TEST(TelemetryDecoder, RejectsInvalidPackets) {
+  TelemetryEncoder encoder;
+  TelemetryDecoder decoder;
+  Packet packet;
+  RobotState decoded;
+
+  EXPECT_EQ(0u, decoder.acknowledgement(packet.data()));
+
+  // Deltas cannot be decoded before the keyframe they refer to.
+  size_t size = encoder.encode(state(0), packet.data());
+  Packet keyframe = packet;
+  size_t keyframe_size = size;
+  TelemetryDecoder other_decoder;
+  ASSERT_TRUE(other_decoder.decode(packet.data(), size, &decoded));
+  acknowledge(other_decoder, &encoder);
+  size = encoder.encode(state(1), packet.data());
+  EXPECT_FALSE(decoder.decode(packet.data(), size, &decoded));
+
+  ASSERT_TRUE(decoder.decode(keyframe.data(), keyframe_size, &decoded));
+  EXPECT_FALSE(decoder.decode(keyframe.data(), keyframe_size, &decoded)) << "Replayed packet";
+  EXPECT_FALSE(decoder.decode(keyframe.data(), 10, &decoded)) << "Truncated header";
+  EXPECT_FALSE(decoder.decode(packet.data(), size - 1, &decoded)) << "Truncated values";
+
+  Packet corrupted = packet;
+  corrupted[0] ^= 0xFF;
+  EXPECT_FALSE(decoder.decode(corrupted.data(), size, &decoded)) << "Wrong magic";
+  corrupted = packet;
+  corrupted[2] = TelemetryEncoder::kVersion + 1;
+  EXPECT_FALSE(decoder.decode(corrupted.data(), size, &decoded)) << "Wrong version";
+
+  EXPECT_TRUE(decoder.decode(packet.data(), size, &decoded));
+}
+
+TEST(TelemetryDecoder, ResynchronizesWithRestartedEncoder) {
+  Packet packet;
+  RobotState decoded;
+  TelemetryDecoder decoder;
+  auto encoder = std::make_unique<TelemetryEncoder>();
+  for (uint64_t time = 0; time < 10; time++) {
+    size_t size = encoder->encode(state(time), packet.data());
+    ASSERT_TRUE(decoder.decode(packet.data(), size, &decoded));
+    acknowledge(decoder, encoder.get());
+  }
+
+  // The restarted encoder starts with lower sequence numbers, which are accepted in its session.
+  encoder = std::make_unique<TelemetryEncoder>();
+  size_t size = encoder->encode(state(20), packet.data());
+  ASSERT_TRUE(decoder.decode(packet.data(), size, &decoded));
+  EXPECT_EQ(20u, decoded.time.toMSec());
+
+  // Acknowledgements of another session are ignored.
+  TelemetryEncoder other_encoder;
+  Packet acknowledgement;
+  size = decoder.acknowledgement(acknowledgement.data());
+  EXPECT_FALSE(other_encoder.acknowledge(acknowledgement.data(), size));
+  EXPECT_TRUE(encoder->acknowledge(acknowledgement.data(), size));
+}
+
+TEST(TelemetryEncoder, EncodeAndDecodeDoNotAllocate) {
+  TelemetryOptions options;
+  options.fields = TelemetryFields::kAll;
+  TelemetryEncoder encoder(options);
+  TelemetryDecoder decoder;
+  Packet packet;
+  Packet acknowledgement;
+  RobotState robot_state = state(0);
+  RobotState decoded;
+
+  franka::AllocationTrackingScope allocation_tracking;
+  for (uint64_t time = 0; time < 10; time++) {
+    robot_state.time = Duration(time);
+    size_t size = encoder.encode(robot_state, packet.data());
+    decoder.decode(packet.data(), size, &decoded);
+    size = decoder.acknowledgement(acknowledgement.data());
+    encoder.acknowledge(acknowledgement.data(), size);
+  }
+  EXPECT_EQ(0u, allocation_tracking.cycleAllocations());
+}
+
+TEST(TelemetryEncoder, RejectsInvalidResolutions) {
+  TelemetryOptions options;
+  options.torque_resolution = 0;
+  EXPECT_THROW(TelemetryEncoder{options}, std::invalid_argument);
+  options.torque_resolution = 1e-3;
+  options.pose_resolution = NAN;
+  EXPECT_THROW(TelemetryEncoder{options}, std::invalid_argument);
+}
+
+TEST(TelemetrySender, SendsPublishedStatesOverLoopback) {
+  auto publisher = std::make_shared<StatePublisher>();
+  TelemetryReceiver receiver(0);
+  EXPECT_NE(0u, receiver.localPort());
+  TelemetrySender sender(publisher, "127.0.0.1", receiver.localPort(),
+                         std::chrono::milliseconds(1));
+
+  RobotState received;
+  bool decoded = false;
+  for (uint64_t time = 1; time <= 2000 && !(decoded && sender.statistics().acknowledgements > 1);
+       time++) {
+    publisher->publish(state(time));
+    decoded = receiver.receive(&received, std::chrono::milliseconds(5)) || decoded;
+  }
+  ASSERT_TRUE(decoded);
+  EXPECT_NE(0u, received.time.toMSec());
+  expectNear(state(received.time.toMSec()).q, received.q,
+             TelemetryOptions().joint_position_resolution);
+
+  franka::TelemetryStatistics statistics = sender.statistics();
+  EXPECT_GT(statistics.sent, 0u);
+  EXPECT_GE(statistics.sent, statistics.keyframes);
+  EXPECT_GT(statistics.acknowledgements, 1u);
+  EXPECT_EQ(0u, statistics.send_errors);
+  EXPECT_EQ(0u, receiver.invalidPackets());
+}
+
+TEST(TelemetrySender, RejectsInvalidArguments) {
+  auto publisher = std::make_shared<StatePublisher>();
+  EXPECT_THROW(TelemetrySender(nullptr, "127.0.0.1", 1), std::invalid_argument);
+  EXPECT_THROW(TelemetrySender(publisher, "127.0.0.1", 1, std::chrono::microseconds(0)),
+               std::invalid_argument);
+  EXPECT_THROW(TelemetrySender(publisher, "not an address", 1), franka::NetworkException);
+}
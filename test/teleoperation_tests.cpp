@@ -0,0 +1,151 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <franka/exception.h>
+#include <franka/teleoperation.h>
+
+using franka::TeleoperationChannel;
+using franka::TeleoperationSample;
+using franka::TeleoperationStatistics;
+using franka::WaveVariables;
+
+namespace {
+
+TeleoperationSample sample(double offset) {
+  TeleoperationSample sample;
+  // Rotation of 90 degrees about z.
+  sample.O_T_EE = {0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.3 + offset, -0.2, 0.5, 1};
+  sample.O_dP_EE = {0.1, 0, 0, 0, 0, 0.2};
+  sample.O_F = {1, 2, 3, 0.1, 0.2, 0.3};
+  sample.wave = {0.5, 0, 0, 0, 0, -0.5};
+  return sample;
+}
+
+// Exchanges samples until the follower receives a new one.
+bool exchangeUntilReceived(TeleoperationChannel& leader,
+                           TeleoperationChannel& follower,
+                           TeleoperationSample* received) {
+  TeleoperationSample ignored;
+  for (int i = 0; i < 1000; i++) {
+    leader.exchange(sample(0), &ignored);
+    if (follower.exchange(TeleoperationSample(), received)) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+}  // anonymous namespace
+
+TEST(TeleoperationChannel, RejectsInvalidArguments) {
+  EXPECT_THROW(
+      TeleoperationChannel(0, "127.0.0.1", 1, TeleoperationChannel::kMaxJitterBufferDepth + 1),
+      std::invalid_argument);
+}
+
+TEST(TeleoperationChannel, ExchangesSamplesOverLoopback) {
+  TeleoperationChannel leader(0, "127.0.0.1", 0, 0);
+  TeleoperationChannel follower(0, "127.0.0.1", leader.localPort(), 0);
+  leader.setRemote("127.0.0.1", follower.localPort());
+  EXPECT_NE(0u, leader.localPort());
+
+  TeleoperationSample received;
+  EXPECT_FALSE(follower.exchange(TeleoperationSample(), &received));
+  EXPECT_EQ(TeleoperationSample().O_T_EE, received.O_T_EE);
+
+  ASSERT_TRUE(exchangeUntilReceived(leader, follower, &received));
+  TeleoperationSample expected = sample(0);
+  for (size_t i = 0; i < 16; i++) {
+    EXPECT_NEAR(expected.O_T_EE[i], received.O_T_EE[i], 1e-6);
+  }
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_FLOAT_EQ(expected.O_dP_EE[i], received.O_dP_EE[i]);
+    EXPECT_FLOAT_EQ(expected.O_F[i], received.O_F[i]);
+    EXPECT_FLOAT_EQ(expected.wave[i], received.wave[i]);
+  }
+
+  TeleoperationStatistics statistics = follower.statistics();
+  EXPECT_GE(statistics.received, 1u);
+  EXPECT_EQ(0u, statistics.invalid);
+  EXPECT_EQ(0u, statistics.send_errors);
+}
+
+TEST(TeleoperationChannel, EstimatesRoundTripTime) {
+  TeleoperationChannel leader(0, "127.0.0.1", 0, 1);
+  TeleoperationChannel follower(0, "127.0.0.1", leader.localPort(), 1);
+  leader.setRemote("127.0.0.1", follower.localPort());
+
+  TeleoperationSample received;
+  for (int i = 0; i < 50; i++) {
+    leader.exchange(sample(0), &received);
+    follower.exchange(sample(1), &received);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  TeleoperationStatistics statistics = leader.statistics();
+  EXPECT_GT(statistics.received, 40u);
+  EXPECT_GT(statistics.round_trip_time, 0);
+  EXPECT_LT(statistics.round_trip_time, 0.1);
+  EXPECT_DOUBLE_EQ(statistics.round_trip_time / 2, statistics.one_way_delay);
+  EXPECT_DOUBLE_EQ(statistics.one_way_delay + statistics.playout_delay, statistics.total_delay);
+  EXPECT_GE(statistics.jitter, 0);
+  EXPECT_EQ(statistics.sent, 50u);
+}
+
+TEST(TeleoperationChannel, HoldsLastSampleWithoutNewPackets) {
+  TeleoperationChannel leader(0, "127.0.0.1", 0, 0);
+  TeleoperationChannel follower(0, "127.0.0.1", leader.localPort(), 0);
+  leader.setRemote("127.0.0.1", follower.localPort());
+
+  TeleoperationSample received;
+  ASSERT_TRUE(exchangeUntilReceived(leader, follower, &received));
+  TeleoperationSample held;
+  while (follower.exchange(TeleoperationSample(), &held)) {
+  }
+  EXPECT_EQ(received.O_F, held.O_F);
+  EXPECT_GE(follower.statistics().underruns, 1u);
+}
+
+TEST(WaveVariables, RejectsInvalidImpedance) {
+  EXPECT_THROW(WaveVariables(0, 1), std::invalid_argument);
+  EXPECT_THROW(WaveVariables(1, -1), std::invalid_argument);
+  EXPECT_THROW(WaveVariables(NAN, 1), std::invalid_argument);
+}
+
+TEST(WaveVariables, EncodesAndDecodesWithoutDelay) {
+  WaveVariables waves(50, 5);
+  std::array<double, 6> velocity{{0.1, -0.2, 0.05, 0.3, 0, -0.1}};
+  std::array<double, 6> force{{2, 1, -3, 0.2, 0.1, 0}};
+
+  // Wave the follower sends if it moves with the velocity against the force.
+  std::array<double, 6> v;
+  for (size_t i = 0; i < 6; i++) {
+    double b = waves.impedance()[i];
+    v[i] = (b * velocity[i] - force[i]) / std::sqrt(2 * b);
+  }
+
+  std::array<double, 6> leader_force;
+  std::array<double, 6> u;
+  waves.leader(velocity, v, &leader_force, &u);
+  std::array<double, 6> follower_velocity;
+  std::array<double, 6> follower_wave;
+  waves.follower(force, u, &follower_velocity, &follower_wave);
+
+  for (size_t i = 0; i < 6; i++) {
+    double b = waves.impedance()[i];
+    EXPECT_NEAR(force[i], leader_force[i], 1e-12);
+    EXPECT_NEAR((b * velocity[i] + force[i]) / std::sqrt(2 * b), u[i], 1e-12);
+    EXPECT_NEAR(velocity[i], follower_velocity[i], 1e-12);
+    EXPECT_NEAR(v[i], follower_wave[i], 1e-12);
+    // The power entering the channel equals the wave power.
+    EXPECT_NEAR(leader_force[i] * velocity[i], (u[i] * u[i] - v[i] * v[i]) / 2, 1e-12);
+  }
+}
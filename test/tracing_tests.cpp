@@ -0,0 +1,36 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "tracing.h"
+
+using franka::formatTraceEvent;
+
+TEST(Tracing, FormatsEventsInAtraceFormat) {
+  char buffer[64];
+  size_t length = formatTraceEvent(buffer, sizeof(buffer), 'B', 42, "Network::udpSend", 0);
+  EXPECT_EQ("B|42|Network::udpSend", std::string(buffer, length));
+
+  length = formatTraceEvent(buffer, sizeof(buffer), 'E', 42, "", 0);
+  EXPECT_EQ("E|42", std::string(buffer, length));
+
+  length = formatTraceEvent(buffer, sizeof(buffer), 'C', 42, "ControlLoop::cycle", -17);
+  EXPECT_EQ("C|42|ControlLoop::cycle|-17", std::string(buffer, length));
+}
+
+TEST(Tracing, TruncatesLongEvents) {
+  char buffer[8];
+  size_t length = formatTraceEvent(buffer, sizeof(buffer), 'B', 12345, "Robot::Impl::update", 0);
+  EXPECT_EQ(sizeof(buffer) - 1, length);
+  EXPECT_EQ("B|12345", std::string(buffer));
+  EXPECT_EQ(0u, formatTraceEvent(buffer, 0, 'E', 1, "", 0));
+}
+
+TEST(Tracing, ScopesCanBeStoppedEarly) {
+  franka::TraceScope scope("test");
+  scope.stop();
+  scope.stop();
+  franka::Tracing::counter("test", 1);
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <franka/trajectory_validation.h>
+
+using namespace ::testing;
+
+using franka::CartesianPose;
+using franka::CartesianVelocities;
+using franka::JointPositions;
+using franka::JointVelocities;
+using franka::Torques;
+using franka::TrajectoryValidationOptions;
+using franka::TrajectoryViolation;
+
+namespace {
+
+constexpr std::array<double, 7> kStart{{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+
+// Moves every joint by the given amplitude with a smooth cosine profile and stops again.
+std::vector<JointPositions> cosineTrajectory(double amplitude, double duration) {
+  std::vector<JointPositions> trajectory;
+  size_t samples = static_cast<size_t>(duration / franka::kDeltaT);
+  for (size_t i = 0; i <= samples; i++) {
+    double progress = 0.5 * (1 - std::cos(M_PI * i / samples));
+    std::array<double, 7> q = kStart;
+    for (double& joint : q) {
+      joint += amplitude * progress;
+    }
+    trajectory.emplace_back(q);
+  }
+  return trajectory;
+}
+
+std::vector<size_t> indices(const std::vector<TrajectoryViolation>& violations) {
+  std::vector<size_t> result;
+  for (const TrajectoryViolation& violation : violations) {
+    result.push_back(violation.index);
+  }
+  return result;
+}
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+}  // anonymous namespace
+
+TEST(TrajectoryValidation, AcceptsSmoothJointTrajectory) {
+  EXPECT_THAT(franka::validateTrajectory(cosineTrajectory(0.3, 2.0)), IsEmpty());
+  EXPECT_THAT(franka::validateTrajectory(std::vector<JointPositions>{}), IsEmpty());
+}
+
+TEST(TrajectoryValidation, ReportsJointRateViolations) {
+  std::vector<JointPositions> trajectory = cosineTrajectory(0.3, 2.0);
+  trajectory[1000].q[1] += 1e-4;
+
+  // Offsetting a single sample changes the velocity by 0.1 rad/s at 1000 and 1001, the
+  // acceleration at 1000 to 1002, and the jerk at 1000 to 1003.
+  std::vector<TrajectoryViolation> violations = franka::validateTrajectory(trajectory);
+  EXPECT_THAT(indices(violations), ElementsAre(1000, 1001, 1002, 1003));
+  EXPECT_FALSE(violations[0].velocity);
+  EXPECT_TRUE(violations[0].acceleration);
+  EXPECT_TRUE(violations[0].jerk);
+  EXPECT_FALSE(violations[0].position_limit);
+
+  // A jump is also a velocity violation.
+  trajectory[1000].q[1] += 0.01;
+  violations = franka::validateTrajectory(trajectory);
+  ASSERT_FALSE(violations.empty());
+  EXPECT_TRUE(violations[0].velocity);
+}
+
+TEST(TrajectoryValidation, ReportsJointLimitsAndInvalidValues) {
+  std::vector<JointPositions> trajectory(10, JointPositions(kStart));
+  trajectory[3].q[3] = 0;
+  trajectory[5].q[6] = std::numeric_limits<double>::quiet_NaN();
+
+  TrajectoryValidationOptions options;
+  options.start_at_rest = true;
+  std::vector<TrajectoryViolation> violations = franka::validateTrajectory(trajectory, options);
+  ASSERT_THAT(indices(violations), Contains(3));
+  EXPECT_TRUE(violations[0].position_limit);
+  auto invalid = std::find_if(violations.begin(), violations.end(),
+                              [](const TrajectoryViolation& v) { return v.index == 5; });
+  ASSERT_NE(violations.end(), invalid);
+  EXPECT_TRUE(invalid->not_finite);
+  EXPECT_FALSE(invalid->position_limit);
+
+  options.max_joint_position[3] = 0.1;
+  trajectory[5].q[6] = kStart[6];
+  trajectory[3].q[3] = kStart[3];
+  EXPECT_THAT(franka::validateTrajectory(trajectory, options), IsEmpty());
+}
+
+TEST(TrajectoryValidation, HonorsInitialState) {
+  // Constant velocity of 0.5 rad/s on the first joint.
+  std::vector<JointVelocities> trajectory(100, JointVelocities(std::array<double, 7>{{0.5, 0, 0, 0, 0, 0, 0}}));
+
+  std::vector<TrajectoryViolation> violations = franka::validateTrajectory(trajectory);
+  ASSERT_THAT(indices(violations), ElementsAre(0, 1));
+  EXPECT_TRUE(violations[0].acceleration);
+  EXPECT_TRUE(violations[0].jerk);
+  EXPECT_FALSE(violations[1].acceleration);
+  EXPECT_TRUE(violations[1].jerk);
+
+  TrajectoryValidationOptions options;
+  options.start_at_rest = false;
+  EXPECT_THAT(franka::validateTrajectory(trajectory, options), IsEmpty());
+
+  trajectory[50].dq[6] = 3;
+  violations = franka::validateTrajectory(trajectory, options);
+  ASSERT_FALSE(violations.empty());
+  EXPECT_EQ(50u, violations[0].index);
+  EXPECT_TRUE(violations[0].velocity);
+}
+
+TEST(TrajectoryValidation, GivesSameResultsForAnyThreadCount) {
+  std::vector<JointPositions> trajectory = cosineTrajectory(1.0, 30.0);
+  for (size_t index : {1u, 4095u, 4096u, 4097u, 15000u, 29999u}) {
+    trajectory[index].q[index % 7] += 1e-3;
+  }
+
+  TrajectoryValidationOptions options;
+  options.thread_count = 1;
+  std::vector<size_t> expected = indices(franka::validateTrajectory(trajectory, options));
+  ASSERT_FALSE(expected.empty());
+  EXPECT_TRUE(std::is_sorted(expected.begin(), expected.end()));
+  for (size_t thread_count : {0u, 2u, 3u, 7u}) {
+    options.thread_count = thread_count;
+    EXPECT_EQ(expected, indices(franka::validateTrajectory(trajectory, options)));
+  }
+}
+
+TEST(TrajectoryValidation, ChecksCartesianTrajectories) {
+  std::vector<CartesianPose> poses;
+  for (size_t i = 0; i < 1000; i++) {
+    double progress = 0.5 * (1 - std::cos(M_PI * i / 999.0));
+    poses.emplace_back(translation(0.3 + 0.1 * progress, 0, 0.5));
+  }
+  EXPECT_THAT(franka::validateTrajectory(poses), IsEmpty());
+
+  poses[500].O_T_EE[0] = 2;
+  std::vector<TrajectoryViolation> violations = franka::validateTrajectory(poses);
+  ASSERT_FALSE(violations.empty());
+  EXPECT_EQ(500u, violations[0].index);
+  EXPECT_TRUE(violations[0].invalid_pose);
+
+  // Rotating about z with 3 rad/s exceeds the rotational velocity limit.
+  std::vector<CartesianVelocities> twists(10, CartesianVelocities(std::array<double, 6>{{0, 0, 0, 0, 0, 3}}));
+  TrajectoryValidationOptions options;
+  options.start_at_rest = false;
+  violations = franka::validateTrajectory(twists, options);
+  EXPECT_THAT(indices(violations), ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+  EXPECT_TRUE(violations[0].velocity);
+  EXPECT_FALSE(violations[0].acceleration);
+
+  // The elbow is checked against the third joint.
+  std::vector<CartesianPose> elbow_poses(
+      3, CartesianPose(translation(0.3, 0, 0.5), {{0, 1}}));
+  elbow_poses[2].elbow[0] = 3;
+  violations = franka::validateTrajectory(elbow_poses);
+  ASSERT_THAT(indices(violations), Contains(2));
+  EXPECT_TRUE(violations.back().position_limit);
+}
+
+TEST(TrajectoryValidation, ChecksTorqueRate) {
+  std::vector<Torques> trajectory(10, Torques(std::array<double, 7>{}));
+  for (size_t i = 5; i < trajectory.size(); i++) {
+    trajectory[i].tau_J[2] = 0.5 + 1.2 * (i - 5);
+  }
+
+  std::vector<TrajectoryViolation> violations = franka::validateTrajectory(trajectory);
+  ASSERT_THAT(indices(violations), ElementsAre(6, 7, 8, 9));
+  EXPECT_TRUE(violations[0].velocity);
+  EXPECT_FALSE(violations[0].acceleration);
+  EXPECT_FALSE(violations[0].jerk);
+}
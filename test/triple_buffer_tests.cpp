@@ -0,0 +1,59 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <gtest/gtest.h>
+
+#include <array>
+#include <thread>
+
+#include "triple_buffer.h"
+
+using franka::TripleBuffer;
+
+TEST(TripleBuffer, StartsWithInitialValue) {
+  TripleBuffer<int> buffer(7);
+  EXPECT_EQ(7, buffer.front());
+  EXPECT_FALSE(buffer.acquire());
+  EXPECT_EQ(7, buffer.front());
+}
+
+TEST(TripleBuffer, AcquiresLatestValue) {
+  TripleBuffer<int> buffer;
+  buffer.write(1);
+  buffer.write(2);
+  EXPECT_TRUE(buffer.acquire());
+  EXPECT_EQ(2, buffer.front());
+  EXPECT_FALSE(buffer.acquire());
+  EXPECT_EQ(2, buffer.front());
+
+  buffer.back() = 3;
+  buffer.publish();
+  EXPECT_TRUE(buffer.acquire());
+  EXPECT_EQ(3, buffer.front());
+}
+
+TEST(TripleBuffer, NeverExposesPartialValuesBetweenThreads) {
+  constexpr int kCount = 100000;
+  TripleBuffer<std::array<int, 16>> buffer;
+
+  std::thread producer([&]() {
+    for (int i = 1; i <= kCount; i++) {
+      buffer.back().fill(i);
+      buffer.publish();
+    }
+  });
+
+  int last = 0;
+  while (last < kCount) {
+    if (!buffer.acquire()) {
+      std::this_thread::yield();
+      continue;
+    }
+    const std::array<int, 16>& value = buffer.front();
+    for (int element : value) {
+      ASSERT_EQ(value[0], element);
+    }
+    ASSERT_GT(value[0], last);
+    last = value[0];
+  }
+  producer.join();
+}
@@ -6,6 +6,7 @@
 #include <franka/vacuum_gripper.h>
 
 #include <chrono>
+#include <future>
 
 #include "helpers.h"
 #include "mock_server.h"
@@ -24,6 +25,7 @@ class VacuumGripperCommand : public ::testing::Test {
   using TCommand = T;
 
   bool executeCommand(VacuumGripper& vacuum_gripper);
+  std::future<bool> executeAsyncCommand(VacuumGripper& vacuum_gripper);
   typename T::Request getExpected();
   typename T::Status getSuccess();
   bool compare(const typename T::Request& request_one, const typename T::Request& request_two);
@@ -93,6 +95,28 @@ bool VacuumGripperCommand<Stop>::executeCommand(VacuumGripper& vacuum_gripper) {
   return vacuum_gripper.stop();
 }
 
+template <>
+std::future<bool> VacuumGripperCommand<Vacuum>::executeAsyncCommand(
+    VacuumGripper& vacuum_gripper) {
+  uint8_t vacuum = 100;
+  franka::VacuumGripper::ProductionSetupProfile profile =
+      franka::VacuumGripper::ProductionSetupProfile::kP0;
+  std::chrono::milliseconds timeout = std::chrono::milliseconds(1000);
+  return vacuum_gripper.vacuumAsync(vacuum, timeout, profile);
+}
+
+template <>
+std::future<bool> VacuumGripperCommand<DropOff>::executeAsyncCommand(
+    VacuumGripper& vacuum_gripper) {
+  std::chrono::milliseconds timeout = std::chrono::milliseconds(1000);
+  return vacuum_gripper.dropOffAsync(timeout);
+}
+
+template <>
+std::future<bool> VacuumGripperCommand<Stop>::executeAsyncCommand(VacuumGripper& vacuum_gripper) {
+  return vacuum_gripper.stopAsync();
+}
+
 template <typename T>
 typename T::Response VacuumGripperCommand<T>::createResponse(const typename T::Request&,
                                                              const typename T::Status status) {
@@ -166,3 +190,54 @@ TYPED_TEST(VacuumGripperCommand, CanSendAndReceiveAborted) {
 
   EXPECT_THROW(TestFixture::executeCommand(vacuum_gripper), CommandException);
 }
+
+TYPED_TEST(VacuumGripperCommand, CanSendAndReceiveAsyncSuccess) {
+  VacuumGripperMockServer server;
+  VacuumGripper vacuum_gripper("127.0.0.1");
+
+  server
+      .waitForCommand<typename TestFixture::TCommand>(
+          [this](const typename TestFixture::TCommand::Request& request) ->
+          typename TestFixture::TCommand::Response {
+            EXPECT_TRUE(this->compare(request, this->getExpected()));
+            return this->createResponse(request, this->getSuccess());
+          })
+      .spinOnce();
+
+  std::future<bool> result = TestFixture::executeAsyncCommand(vacuum_gripper);
+  EXPECT_TRUE(result.get());
+}
+
+TYPED_TEST(VacuumGripperCommand, CanSendAndReceiveAsyncAborted) {
+  VacuumGripperMockServer server;
+  VacuumGripper vacuum_gripper("127.0.0.1");
+
+  server
+      .waitForCommand<typename TestFixture::TCommand>(
+          [this](const typename TestFixture::TCommand::Request& request) ->
+          typename TestFixture::TCommand::Response {
+            EXPECT_TRUE(this->compare(request, this->getExpected()));
+            return this->createResponse(request, TestFixture::TCommand::Status::kAborted);
+          })
+      .spinOnce();
+
+  std::future<bool> result = TestFixture::executeAsyncCommand(vacuum_gripper);
+  EXPECT_THROW(result.get(), CommandException);
+}
+
+TEST(VacuumGripperCommand, CanPipelineAsyncCommands) {
+  VacuumGripperMockServer server;
+  VacuumGripper vacuum_gripper("127.0.0.1");
+
+  server
+      .waitForCommand<Vacuum>(
+          [](const Vacuum::Request&) { return Vacuum::Response(Vacuum::Status::kSuccess); })
+      .waitForCommand<DropOff>(
+          [](const DropOff::Request&) { return DropOff::Response(DropOff::Status::kSuccess); })
+      .spinOnce();
+
+  std::future<bool> vacuum = vacuum_gripper.vacuumAsync(100, std::chrono::milliseconds(1000));
+  std::future<bool> drop_off = vacuum_gripper.dropOffAsync(std::chrono::milliseconds(1000));
+  EXPECT_TRUE(vacuum.get());
+  EXPECT_TRUE(drop_off.get());
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <Eigen/Core>
+
+#include <franka/virtual_fixtures.h>
+
+#include "helpers.h"
+
+using namespace ::testing;
+
+using franka::fixtures::AnisotropicSpring;
+using franka::fixtures::Cone;
+using franka::fixtures::fixtureState;
+using franka::fixtures::FixtureState;
+using franka::fixtures::makeFixtureSet;
+using franka::fixtures::OrientationLock;
+using franka::fixtures::Plane;
+using franka::fixtures::Tube;
+
+namespace {
+
+FixtureState stateAt(double x, double y, double z, const std::array<double, 3>& velocity = {}) {
+  std::array<double, 16> pose{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+  std::array<double, 6> twist{{velocity[0], velocity[1], velocity[2], 0, 0, 0}};
+  return fixtureState(pose, twist);
+}
+
+// Rotation about z by the given angle, column-major.
+std::array<double, 9> rotationZ(double angle) {
+  return {{std::cos(angle), std::sin(angle), 0, -std::sin(angle), std::cos(angle), 0, 0, 0, 1}};
+}
+
+// Rotation about x by the given angle, column-major.
+std::array<double, 9> rotationX(double angle) {
+  return {{1, 0, 0, 0, std::cos(angle), std::sin(angle), 0, -std::sin(angle), std::cos(angle)}};
+}
+
+template <typename Fixture>
+std::array<double, 6> evaluate(const Fixture& fixture, const FixtureState& state) {
+  std::array<double, 6> wrench{};
+  fixture(state, &wrench);
+  return wrench;
+}
+
+}  // anonymous namespace
+
+TEST(VirtualFixtures, CreatesStateFromRobotState) {
+  franka::RobotState robot_state;
+  robot_state.O_T_EE = {{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.1, 0.2, 0.3, 1}};
+  robot_state.dq = {{1, 2, 0, 0, 0, 0, 0}};
+  std::array<double, 42> jacobian{};
+  jacobian[0] = 1;   // Joint 1 moves along x.
+  jacobian[11] = 3;  // Joint 2 rotates about z.
+
+  FixtureState state = fixtureState(robot_state, jacobian);
+  EXPECT_THAT(state.position, ElementsAre(0.1, 0.2, 0.3));
+  EXPECT_THAT(state.rotation, ElementsAre(0, 1, 0, -1, 0, 0, 0, 0, 1));
+  EXPECT_THAT(state.linear_velocity, ElementsAre(1, 0, 0));
+  EXPECT_THAT(state.angular_velocity, ElementsAre(0, 0, 6));
+}
+
+TEST(VirtualFixtures, ForbiddenPlanePushesBack) {
+  Plane plane({{0, 0, 0.1}}, {{0, 0, 2}}, 1000, 10);
+
+  EXPECT_THAT(evaluate(plane, stateAt(0, 0, 0.2)), Each(0.0));
+  EXPECT_THAT(evaluate(plane, stateAt(0.5, 0, 0.09)),
+              ElementsAre(0, 0, DoubleNear(10, 1e-9), 0, 0, 0));
+  // Damping only resists motion into the forbidden region.
+  EXPECT_NEAR(11, evaluate(plane, stateAt(0, 0, 0.09, {{0, 0, -0.1}}))[2], 1e-9);
+  EXPECT_NEAR(0, evaluate(plane, stateAt(0, 0, 0.09, {{0, 0, 2}}))[2], 1e-9);
+}
+
+TEST(VirtualFixtures, GuidancePlanePullsFromBothSides) {
+  Plane plane({{0, 0, 0.1}}, {{0, 0, 1}}, 1000, 10, Plane::Mode::kGuidance);
+
+  EXPECT_NEAR(-10, evaluate(plane, stateAt(0, 0, 0.11))[2], 1e-9);
+  EXPECT_NEAR(10, evaluate(plane, stateAt(0, 0, 0.09))[2], 1e-9);
+  EXPECT_NEAR(-1, evaluate(plane, stateAt(0, 0, 0.1, {{0.5, 0, 0.1}}))[2], 1e-9);
+  EXPECT_NEAR(0, evaluate(plane, stateAt(0, 0, 0.1, {{0.5, 0, 0.1}}))[0], 1e-9);
+}
+
+TEST(VirtualFixtures, ConeKeepsEndEffectorInside) {
+  // Cone opening upwards from the origin with 45 degrees.
+  Cone cone({{0, 0, 0}}, {{0, 0, 1}}, M_PI / 4, 1000);
+
+  EXPECT_THAT(evaluate(cone, stateAt(0.05, 0, 0.1)), Each(0.0));
+  EXPECT_THAT(evaluate(cone, stateAt(0, 0, 0.1)), Each(0.0));
+
+  // 0.1 m outside of the radius at this height, i.e. 0.1 / sqrt(2) from the surface.
+  std::array<double, 6> wrench = evaluate(cone, stateAt(0.2, 0, 0.1));
+  double force = 1000 * 0.1 / std::sqrt(2);
+  EXPECT_NEAR(-force / std::sqrt(2), wrench[0], 1e-9);
+  EXPECT_NEAR(0, wrench[1], 1e-9);
+  EXPECT_NEAR(force / std::sqrt(2), wrench[2], 1e-9);
+
+  // Behind the apex, the end effector is pulled to the apex.
+  wrench = evaluate(cone, stateAt(0, 0.03, -0.04));
+  EXPECT_NEAR(-30, wrench[1], 1e-9);
+  EXPECT_NEAR(40, wrench[2], 1e-9);
+}
+
+TEST(VirtualFixtures, TubeKeepsEndEffectorNearPath) {
+  Tube tube({{{0, 0, 0}}, {{0.1, 0, 0}}, {{0.2, 0.1, 0}}}, 0.01, 1000, 0, 8);
+  ASSERT_EQ(17u, tube.centerLine().size());
+  EXPECT_THAT(tube.centerLine().front(), ElementsAre(0, 0, 0));
+  EXPECT_THAT(tube.centerLine()[8], ElementsAre(0.1, 0, 0));
+  EXPECT_THAT(tube.centerLine().back(), ElementsAre(0.2, 0.1, 0));
+
+  EXPECT_THAT(evaluate(tube, stateAt(0.2, 0.1, 0.005)), Each(0.0));
+  EXPECT_THAT(evaluate(tube, stateAt(0.2, 0.1, 0.03)),
+              ElementsAre(0, 0, DoubleNear(-20, 1e-9), 0, 0, 0));
+  // Beyond the start, the end effector is pulled back to the start point.
+  std::array<double, 6> wrench = evaluate(tube, stateAt(-0.05, 0, 0));
+  EXPECT_NEAR(40, wrench[0], 1e-9);
+}
+
+TEST(VirtualFixtures, OrientationLockResistsRotation) {
+  OrientationLock lock(rotationZ(0), 10, 2);
+  FixtureState state = stateAt(0, 0, 0);
+
+  EXPECT_THAT(evaluate(lock, state), Each(DoubleNear(0, 1e-12)));
+  state.rotation = rotationZ(0.2);
+  state.angular_velocity = {{0, 0, 0.5}};
+  EXPECT_THAT(evaluate(lock, state), ElementsAre(0, 0, 0, DoubleNear(0, 1e-9),
+                                                 DoubleNear(0, 1e-9), DoubleNear(-3, 1e-9)));
+}
+
+TEST(VirtualFixtures, OrientationLockLeavesFreeAxis) {
+  OrientationLock lock(rotationZ(0), 10, 2, {{0, 0, 3}});
+  FixtureState state = stateAt(0, 0, 0);
+
+  state.rotation = rotationZ(1.0);
+  state.angular_velocity = {{0, 0, 0.5}};
+  EXPECT_THAT(evaluate(lock, state), Each(DoubleNear(0, 1e-9)));
+
+  // Tilting about x is still resisted, also when combined with a rotation about the free axis.
+  Eigen::Matrix3d tilted = Eigen::Map<const Eigen::Matrix3d>(rotationZ(1.0).data()) *
+                           Eigen::Map<const Eigen::Matrix3d>(rotationX(0.1).data());
+  Eigen::Map<Eigen::Matrix3d>(state.rotation.data()) = tilted;
+  std::array<double, 6> wrench = evaluate(lock, state);
+  EXPECT_NEAR(1, std::hypot(wrench[3], wrench[4]), 1e-9);
+  EXPECT_NEAR(0, wrench[5], 1e-9);
+}
+
+TEST(VirtualFixtures, AnisotropicSpringUsesTargetFrame) {
+  // Target frame rotated by 90 degrees about z: its x axis is the base y axis.
+  std::array<double, 16> target{{0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0.1, 0, 0, 1}};
+  AnisotropicSpring spring(target, {{1000, 100, 10}}, {{0, 0, 5}});
+
+  EXPECT_THAT(evaluate(spring, stateAt(0.1, 0, 0)), Each(DoubleNear(0, 1e-12)));
+  EXPECT_THAT(evaluate(spring, stateAt(0.11, 0.01, 0.01, {{0, 0, 1}})),
+              ElementsAre(DoubleNear(-1, 1e-9), DoubleNear(-10, 1e-9), DoubleNear(-0.1 - 5, 1e-9),
+                          0, 0, 0));
+}
+
+TEST(VirtualFixtures, FixtureSetSumsAllFixtures) {
+  auto fixtures = makeFixtureSet(Plane({{0, 0, 0}}, {{0, 0, 1}}, 1000),
+                                 Plane({{0, 0, 0}}, {{1, 0, 0}}, 500),
+                                 OrientationLock(rotationZ(0), 10));
+  FixtureState state = stateAt(-0.02, 0, -0.01);
+  state.rotation = rotationZ(0.1);
+
+  std::array<double, 6> wrench = fixtures.wrench(state);
+  EXPECT_THAT(wrench, ElementsAre(DoubleNear(10, 1e-9), DoubleNear(0, 1e-9), DoubleNear(10, 1e-9),
+                                  DoubleNear(0, 1e-9), DoubleNear(0, 1e-9), DoubleNear(-1, 1e-9)));
+
+  std::array<double, 42> jacobian{};
+  for (size_t i = 0; i < 6; i++) {
+    jacobian[6 * i + i] = 1;
+  }
+  EXPECT_THAT(fixtures.torques(state, jacobian),
+              ElementsAre(DoubleNear(10, 1e-9), DoubleNear(0, 1e-9), DoubleNear(10, 1e-9),
+                          DoubleNear(0, 1e-9), DoubleNear(0, 1e-9), DoubleNear(-1, 1e-9), 0));
+
+  fixtures.fixture<1>() = Plane({{-0.05, 0, 0}}, {{1, 0, 0}}, 500);
+  EXPECT_NEAR(0, fixtures.wrench(state)[0], 1e-9);
+}
+
+TEST(VirtualFixtures, ThrowsOnInvalidArguments) {
+  const double kNaN = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(Plane({{0, 0, 0}}, {{0, 0, 0}}, 1000), std::invalid_argument);
+  EXPECT_THROW(Plane({{kNaN, 0, 0}}, {{0, 0, 1}}, 1000), std::invalid_argument);
+  EXPECT_THROW(Plane({{0, 0, 0}}, {{0, 0, 1}}, -1), std::invalid_argument);
+  EXPECT_THROW(Cone({{0, 0, 0}}, {{0, 0, 1}}, M_PI / 2, 1000), std::invalid_argument);
+  EXPECT_THROW(Cone({{0, 0, 0}}, {{0, 0, 1}}, 0, 1000), std::invalid_argument);
+  EXPECT_THROW(Tube({{{0, 0, 0}}}, 0.01, 1000), std::invalid_argument);
+  EXPECT_THROW(Tube({{{0, 0, 0}}, {{1, 0, 0}}}, -0.01, 1000), std::invalid_argument);
+  EXPECT_THROW(Tube({{{0, 0, 0}}, {{1, 0, 0}}}, 0.01, 1000, 0, 0), std::invalid_argument);
+  EXPECT_THROW(OrientationLock({{1, 0, 0, 0, 2, 0, 0, 0, 1}}, 10), std::invalid_argument);
+  EXPECT_THROW(OrientationLock(rotationZ(0), 10, 0, {{kNaN, 0, 0}}), std::invalid_argument);
+  EXPECT_THROW(AnisotropicSpring({}, {{1, 1, 1}}), std::invalid_argument);
+  EXPECT_THROW(AnisotropicSpring({{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}}, {{1, -1, 1}}),
+               std::invalid_argument);
+}
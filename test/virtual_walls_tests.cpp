@@ -0,0 +1,113 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <franka/virtual_walls.h>
+
+using franka::VirtualWallCuboid;
+using franka::VirtualWallDistance;
+using franka::VirtualWalls;
+
+namespace {
+
+VirtualWallCuboid makeWall(int32_t id,
+                           const std::array<double, 3>& center,
+                           const std::array<double, 3>& size,
+                           bool active = true) {
+  VirtualWallCuboid wall{};
+  wall.id = id;
+  wall.object_world_size = size;
+  wall.p_frame = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, center[0], center[1], center[2], 1}};
+  wall.active = active;
+  return wall;
+}
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+}  // anonymous namespace
+
+TEST(VirtualWalls, ComputesDistanceInsideCuboid) {
+  VirtualWallCuboid wall = makeWall(3, {{0.5, 0, 0.5}}, {{0.6, 1.0, 0.8}});
+
+  VirtualWallDistance result = franka::virtualWallDistance(wall, {{0.7, 0.1, 0.5}});
+
+  EXPECT_EQ(3, result.id);
+  EXPECT_NEAR(0.1, result.distance, 1e-12);
+  EXPECT_EQ((std::array<double, 3>{{-1, 0, 0}}), result.normal);
+}
+
+TEST(VirtualWalls, ComputesDistanceOutsideCuboid) {
+  VirtualWallCuboid wall = makeWall(0, {{0, 0, 0}}, {{2, 2, 2}});
+
+  VirtualWallDistance result = franka::virtualWallDistance(wall, {{1.3, -1.4, 0}});
+
+  EXPECT_NEAR(-0.5, result.distance, 1e-12);
+  EXPECT_NEAR(-0.6, result.normal[0], 1e-12);
+  EXPECT_NEAR(0.8, result.normal[1], 1e-12);
+  EXPECT_NEAR(0, result.normal[2], 1e-12);
+}
+
+TEST(VirtualWalls, RespectsWallOrientation) {
+  VirtualWallCuboid wall = makeWall(0, {{0, 0, 0}}, {{2, 0.2, 2}});
+  // Rotated by 90 degrees about z, so the thin side lies along the x axis of the base frame.
+  wall.p_frame[0] = 0;
+  wall.p_frame[1] = 1;
+  wall.p_frame[4] = -1;
+  wall.p_frame[5] = 0;
+
+  VirtualWallDistance result = franka::virtualWallDistance(wall, {{0.05, 0.5, 0}});
+
+  EXPECT_NEAR(0.05, result.distance, 1e-12);
+  EXPECT_NEAR(-1, result.normal[0], 1e-12);
+  EXPECT_NEAR(0, result.normal[1], 1e-12);
+}
+
+TEST(VirtualWalls, StartsEmpty) {
+  VirtualWalls walls;
+
+  VirtualWallDistance result = walls.distance(translation(0, 0, 0));
+
+  EXPECT_TRUE(std::isinf(result.distance));
+  EXPECT_EQ(-1, result.id);
+  EXPECT_TRUE(walls.walls().empty());
+}
+
+TEST(VirtualWalls, ReturnsNearestActiveWall) {
+  VirtualWalls walls;
+  walls.set({makeWall(0, {{0, 0, 0}}, {{2, 2, 2}}), makeWall(1, {{0, 0, 0.5}}, {{2, 2, 1.2}}),
+             makeWall(2, {{0, 0, 0}}, {{0.1, 0.1, 0.1}}, false)});
+
+  VirtualWallDistance result = walls.distance(translation(0, 0, 0.9));
+  EXPECT_EQ(0, result.id);
+  EXPECT_NEAR(0.1, result.distance, 1e-12);
+  EXPECT_NEAR(-1, result.normal[2], 1e-12);
+
+  // The offset is given in end effector frame.
+  result = walls.distance(translation(0, 0, 0.9), {{0, 0, -0.5}});
+  EXPECT_EQ(1, result.id);
+  EXPECT_NEAR(0.5, result.distance, 1e-12);
+  EXPECT_NEAR(1, result.normal[2], 1e-12);
+
+  EXPECT_EQ(3u, walls.walls().size());
+}
+
+TEST(VirtualWalls, ReplacesCachedWalls) {
+  VirtualWalls walls;
+  walls.set({makeWall(0, {{0, 0, 0}}, {{2, 2, 2}})});
+  EXPECT_EQ(0, walls.distance(translation(0, 0, 0)).id);
+
+  walls.set({makeWall(5, {{0, 0, 0}}, {{1, 1, 1}})});
+  VirtualWallDistance result = walls.distance(translation(0, 0, 0));
+  EXPECT_EQ(5, result.id);
+  EXPECT_NEAR(0.5, result.distance, 1e-12);
+
+  EXPECT_THROW(walls.set(std::vector<VirtualWallCuboid>(VirtualWalls::kMaxWalls + 1)),
+               std::invalid_argument);
+}
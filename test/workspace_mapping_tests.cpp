@@ -0,0 +1,166 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <franka/workspace_mapping.h>
+
+using franka::WorkspaceMapping;
+using franka::WorkspaceMappingParameters;
+
+namespace {
+
+constexpr double kTimeStep = 0.001;
+
+std::array<double, 16> translation(double x, double y, double z) {
+  return {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1}};
+}
+
+std::array<double, 16> rotationZ(double angle) {
+  return {{std::cos(angle), std::sin(angle), 0, 0, -std::sin(angle), std::cos(angle), 0, 0, 0, 0,
+           1, 0, 0, 0, 0, 1}};
+}
+
+WorkspaceMappingParameters unlimitedParameters() {
+  WorkspaceMappingParameters parameters;
+  parameters.max_velocity = 1e6;
+  parameters.max_angular_velocity = 1e6;
+  return parameters;
+}
+
+}  // anonymous namespace
+
+TEST(WorkspaceMapping, RejectsInvalidParameters) {
+  WorkspaceMappingParameters parameters;
+  parameters.position_scale = 0;
+  EXPECT_THROW(WorkspaceMapping{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.O_T_D[0] = 2;
+  EXPECT_THROW(WorkspaceMapping{parameters}, std::invalid_argument);
+
+  parameters = {};
+  parameters.coupling_damping[1] = NAN;
+  EXPECT_THROW(WorkspaceMapping{parameters}, std::invalid_argument);
+}
+
+TEST(WorkspaceMapping, ScalesAndRotatesDeviceMotion) {
+  WorkspaceMappingParameters parameters = unlimitedParameters();
+  parameters.position_scale = 2;
+  parameters.rotation_scale = 0.5;
+  parameters.O_T_D = rotationZ(M_PI / 2);
+  WorkspaceMapping mapping(parameters);
+  mapping.reset(translation(0.5, 0, 0.4));
+
+  mapping.update(translation(0, 0, 0), true, kTimeStep);
+  EXPECT_TRUE(mapping.engaged());
+
+  std::array<double, 16> device = rotationZ(0.4);
+  device[12] = 0.01;
+  std::array<double, 16> target = mapping.update(device, true, kTimeStep).O_T_EE;
+
+  // Device x maps onto robot y.
+  EXPECT_NEAR(0.5, target[12], 1e-12);
+  EXPECT_NEAR(0.02, target[13], 1e-12);
+  EXPECT_NEAR(0.4, target[14], 1e-12);
+  std::array<double, 16> expected_rotation = rotationZ(0.2);
+  for (size_t i = 0; i < 12; i++) {
+    EXPECT_NEAR(expected_rotation[i], target[i], 1e-12);
+  }
+}
+
+TEST(WorkspaceMapping, KeepsTargetWhileIndexing) {
+  WorkspaceMapping mapping(unlimitedParameters());
+  mapping.reset(translation(0.5, 0, 0.4));
+
+  mapping.update(translation(0, 0, 0), true, kTimeStep);
+  mapping.update(translation(0.05, 0, 0), true, kTimeStep);
+  EXPECT_NEAR(0.55, mapping.target()[12], 1e-12);
+
+  // Move the device back with the clutch released.
+  std::array<double, 16> target =
+      mapping.update(translation(-0.05, 0, 0), false, kTimeStep).O_T_EE;
+  EXPECT_FALSE(mapping.engaged());
+  EXPECT_NEAR(0.55, target[12], 1e-12);
+
+  // Engaging again does not move the target, and further motion continues from there.
+  target = mapping.update(translation(-0.05, 0, 0), true, kTimeStep).O_T_EE;
+  EXPECT_NEAR(0.55, target[12], 1e-12);
+  target = mapping.update(translation(0, 0, 0), true, kTimeStep).O_T_EE;
+  EXPECT_NEAR(0.6, target[12], 1e-12);
+}
+
+TEST(WorkspaceMapping, DriftsInRateZone) {
+  WorkspaceMappingParameters parameters = unlimitedParameters();
+  parameters.rate_zone_radius = 0.05;
+  parameters.rate_gain = 2;
+  WorkspaceMapping mapping(parameters);
+  mapping.reset(translation(0, 0, 0));
+
+  mapping.update(translation(0, 0, 0), true, kTimeStep);
+  mapping.update(translation(0.04, 0, 0), true, kTimeStep);
+  EXPECT_NEAR(0.04, mapping.target()[12], 1e-12);
+
+  // 0.01 m beyond the zone drifts with 0.02 m/s.
+  for (size_t i = 0; i < 1000; i++) {
+    mapping.update(translation(0.06, 0, 0), true, kTimeStep);
+  }
+  EXPECT_NEAR(0.06 + 0.02, mapping.target()[12], 1e-9);
+}
+
+TEST(WorkspaceMapping, LimitsTargetVelocity) {
+  WorkspaceMappingParameters parameters;
+  parameters.max_velocity = 0.5;
+  parameters.max_angular_velocity = 1.0;
+  WorkspaceMapping mapping(parameters);
+  mapping.reset(translation(0, 0, 0));
+
+  mapping.update(translation(0, 0, 0), true, kTimeStep);
+  std::array<double, 16> device = rotationZ(1.0);
+  device[13] = 0.1;
+  std::array<double, 16> target = mapping.update(device, true, kTimeStep).O_T_EE;
+
+  EXPECT_NEAR(0.0005, target[13], 1e-12);
+  EXPECT_NEAR(std::cos(0.001), target[0], 1e-9);
+  EXPECT_NEAR(std::sin(0.001), target[1], 1e-9);
+}
+
+TEST(WorkspaceMapping, ScalesAndSaturatesForceFeedback) {
+  WorkspaceMappingParameters parameters;
+  parameters.O_T_D = rotationZ(M_PI / 2);
+  parameters.force_scale = 0.1;
+  parameters.torque_scale = 0.5;
+  parameters.max_device_force = 2;
+  WorkspaceMapping mapping(parameters);
+  mapping.reset(translation(0, 0, 0));
+
+  EXPECT_EQ((std::array<double, 6>{}), mapping.deviceWrench({{0, 10, 0, 0, 0, 1}}));
+
+  mapping.update(translation(0, 0, 0), true, kTimeStep);
+  std::array<double, 6> wrench = mapping.deviceWrench({{0, 10, 0, 0, 0, 1}});
+  EXPECT_NEAR(1, wrench[0], 1e-12);
+  EXPECT_NEAR(0, wrench[1], 1e-12);
+  EXPECT_NEAR(0.5, wrench[5], 1e-12);
+
+  wrench = mapping.deviceWrench({{0, 0, -100, 0, 0, 0}});
+  EXPECT_NEAR(-2, wrench[2], 1e-12);
+}
+
+TEST(WorkspaceMapping, PullsTowardsTarget) {
+  WorkspaceMappingParameters parameters = unlimitedParameters();
+  WorkspaceMapping mapping(parameters);
+  mapping.reset(translation(0, 0, 0));
+  mapping.update(translation(0, 0, 0), true, kTimeStep);
+  std::array<double, 16> device = rotationZ(0.1);
+  device[12] = 0.01;
+  mapping.update(device, true, kTimeStep);
+
+  std::array<double, 6> wrench =
+      mapping.couplingWrench(translation(0, 0, 0), {{0, 0.1, 0, 0, 0, 0}});
+  EXPECT_NEAR(parameters.coupling_stiffness[0] * 0.01, wrench[0], 1e-9);
+  EXPECT_NEAR(-parameters.coupling_damping[0] * 0.1, wrench[1], 1e-9);
+  EXPECT_NEAR(parameters.coupling_stiffness[1] * 0.1, wrench[5], 1e-9);
+}